@@ -3,16 +3,21 @@
 
 #include "precomp.h"
 #include "AttrRow.hpp"
+#include "BufferMemoryUsage.hpp"
 
 // Routine Description:
 // - constructor
 // Arguments:
 // - cchRowWidth - the length of the default text attribute
 // - attr - the default text attribute
+// - table - the attribute table of the buffer the row belongs to
 // Return Value:
 // - constructed object
-ATTR_ROW::ATTR_ROW(const uint16_t width, const TextAttribute attr) :
-    _data(width, attr) {}
+ATTR_ROW::ATTR_ROW(const uint16_t width, const TextAttribute attr, AttributeTable& table, ModificationClock& clock) :
+    _table{ &table },
+    _data(width, table.Intern(attr)),
+    _clock{ &clock },
+    _hasBlinking{ attr.IsBlinking() } {}
 
 // Routine Description:
 // - Sets all properties of the ATTR_ROW to default values
@@ -20,7 +25,9 @@ ATTR_ROW::ATTR_ROW(const uint16_t width, const TextAttribute attr) :
 // - attr - The default text attributes to use on text in this row.
 void ATTR_ROW::Reset(const TextAttribute attr)
 {
-    _data.replace(0, _data.size(), attr);
+    _data.replace(0, _data.size(), _table->Intern(attr));
+    _hasBlinking = attr.IsBlinking();
+    _Touch();
 }
 
 // Routine Description:
@@ -35,6 +42,9 @@ void ATTR_ROW::Reset(const TextAttribute attr)
 void ATTR_ROW::Resize(const uint16_t newWidth)
 {
     _data.resize_trailing_extent(newWidth);
+    // The runs that were cut off may have been the blinking ones.
+    _UpdateBlinking({});
+    _Touch();
 }
 
 // Routine Description:
@@ -47,7 +57,7 @@ void ATTR_ROW::Resize(const uint16_t newWidth)
 // - will throw on error
 TextAttribute ATTR_ROW::GetAttrByColumn(const uint16_t column) const
 {
-    return _data.at(column);
+    return _table->Get(_data.at(column));
 }
 
 // Routine Description:
@@ -59,9 +69,10 @@ std::vector<uint16_t> ATTR_ROW::GetHyperlinks() const
     std::vector<uint16_t> ids;
     for (const auto& run : _data.runs())
     {
-        if (run.value.IsHyperlink())
+        const auto& attr = _table->Get(run.value);
+        if (attr.IsHyperlink())
         {
-            ids.emplace_back(run.value.GetHyperlinkId());
+            ids.emplace_back(attr.GetHyperlinkId());
         }
     }
     return ids;
@@ -76,7 +87,9 @@ std::vector<uint16_t> ATTR_ROW::GetHyperlinks() const
 // - <none>
 bool ATTR_ROW::SetAttrToEnd(const uint16_t beginIndex, const TextAttribute attr)
 {
-    _data.replace(gsl::narrow<uint16_t>(beginIndex), _data.size(), attr);
+    _data.replace(gsl::narrow<uint16_t>(beginIndex), _data.size(), _table->Intern(attr));
+    _UpdateBlinking(attr);
+    _Touch();
     return true;
 }
 
@@ -90,7 +103,13 @@ bool ATTR_ROW::SetAttrToEnd(const uint16_t beginIndex, const TextAttribute attr)
 // - <none>
 void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith)
 {
-    _data.replace_values(toBeReplacedAttr, replaceWith);
+    // If the attribute isn't in the table, no row can be using it.
+    if (const auto id = _table->Find(toBeReplacedAttr))
+    {
+        _data.replace_values(*id, _table->Intern(replaceWith));
+        _UpdateBlinking(replaceWith);
+        _Touch();
+    }
 }
 
 // Routine Description:
@@ -105,30 +124,171 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
 // - <none>
 void ATTR_ROW::Replace(const uint16_t beginIndex, const uint16_t endIndex, const TextAttribute& newAttr)
 {
-    _data.replace(beginIndex, endIndex, newAttr);
+    _data.replace(beginIndex, endIndex, _table->Intern(newAttr));
+    _UpdateBlinking(newAttr);
+    _Touch();
+}
+
+// Routine Description:
+// - Copies the attributes of another row, which may belong to another buffer.
+//   The row keeps its attribute table.
+// Arguments:
+// - other - the row to copy the attributes of
+// Return Value:
+// - <none>, throws exceptions on failures.
+void ATTR_ROW::CopyFrom(const ATTR_ROW& other)
+{
+    _Touch();
+    _hasBlinking = other._hasBlinking;
+
+    if (_table == other._table)
+    {
+        _data = other._data;
+        return;
+    }
+
+    // Copy the runs at once and translate their IDs in place.
+    _data = other._data;
+    _data.transform_values([&](const AttributeTable::id_type id) {
+        return _table->Intern(other._table->Get(id));
+    });
+}
+
+// Routine Description:
+// - Flags the IDs of the attributes this row uses, see AttributeTable::Compact.
+// Arguments:
+// - used - a flag for every ID of the attribute table
+// Return Value:
+// - <none>
+void ATTR_ROW::MarkUsedIds(std::vector<bool>& used) const
+{
+    for (const auto& run : _data.runs())
+    {
+        used.at(run.value) = true;
+    }
+}
+
+// Routine Description:
+// - Replaces the IDs of the attributes after the attribute table was compacted.
+// Arguments:
+// - newIds - the new ID of every old ID, as returned by AttributeTable::Compact
+// Return Value:
+// - <none>
+void ATTR_ROW::RemapIds(const std::vector<AttributeTable::id_type>& newIds)
+{
+    _data.transform_values([&](const AttributeTable::id_type id) {
+        return newIds.at(id);
+    });
+}
+
+// Routine Description:
+// - Gets the generation of the buffer's ModificationClock in which the attributes
+//   of this row may have been modified last.
+// - Remapping the IDs after a compaction doesn't change the attributes.
+// Arguments:
+// - <none>
+// Return Value:
+// - the current generation of the row's attributes
+uint64_t ATTR_ROW::GetGeneration() const noexcept
+{
+    return _generation;
+}
+
+// Routine Description:
+// - Estimates the heap memory used by the attribute runs. A single run is stored inline.
+// Return Value:
+// - the size in bytes
+size_t ATTR_ROW::GetMemoryUsage() const noexcept
+{
+    const auto& runs = _data.runs();
+    return runs.capacity() > 1 ? runs.capacity() * sizeof(rle_vector::rle_type) : 0;
+}
+
+// Routine Description:
+// - Gives back the capacity of the runs that isn't used anymore. A row that
+//   is back to a single color moves its run back into the row itself.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ATTR_ROW::Trim()
+{
+    _data.shrink_to_fit();
+}
+
+// Routine Description:
+// - Stamps the row with a new generation, as its attributes are being changed.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ATTR_ROW::_Touch() noexcept
+{
+    _generation = _clock->Tick();
+}
+
+// Routine Description:
+// - Gets whether any of the attributes of this row are blinking. It's kept
+//   up to date as the row is written to, rather than looked up when it's asked
+//   for, so that finding the blinking rows of a viewport is cheap.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if the row has blinking text.
+bool ATTR_ROW::HasBlinking() const noexcept
+{
+    return _hasBlinking;
+}
+
+// Routine Description:
+// - Updates whether the row is blinking after attr was written to some of it.
+//   The runs only need to be looked at again when a blinking row was written
+//   to without blinking, which may have overwritten the last blinking run.
+// Arguments:
+// - attr - the attribute that was written
+// Return Value:
+// - <none>
+void ATTR_ROW::_UpdateBlinking(const TextAttribute& attr) noexcept
+{
+    if (attr.IsBlinking())
+    {
+        _hasBlinking = true;
+    }
+    else if (_hasBlinking)
+    {
+        const auto& runs = _data.runs();
+        _hasBlinking = std::any_of(runs.begin(), runs.end(), [&](const auto& run) {
+            return _table->Get(run.value).IsBlinking();
+        });
+    }
 }
 
 ATTR_ROW::const_iterator ATTR_ROW::begin() const noexcept
 {
-    return _data.begin();
+    return { _data.begin(), _table };
 }
 
 ATTR_ROW::const_iterator ATTR_ROW::end() const noexcept
 {
-    return _data.end();
+    return { _data.end(), _table };
 }
 
 ATTR_ROW::const_iterator ATTR_ROW::cbegin() const noexcept
 {
-    return _data.cbegin();
+    return { _data.cbegin(), _table };
 }
 
 ATTR_ROW::const_iterator ATTR_ROW::cend() const noexcept
 {
-    return _data.cend();
+    return { _data.cend(), _table };
 }
 
 bool operator==(const ATTR_ROW& a, const ATTR_ROW& b) noexcept
 {
-    return a._data == b._data;
+    // IDs can only be compared within the same buffer.
+    if (a._table == b._table)
+    {
+        return a._data == b._data;
+    }
+    return a._data.size() == b._data.size() && std::equal(a.begin(), a.end(), b.begin());
 }
@@ -22,15 +22,136 @@ Revision History:
 
 #include "til/rle.h"
 #include "TextAttribute.hpp"
+#include "AttributeTable.hpp"
+#include "ModificationClock.hpp"
 
 class ATTR_ROW final
 {
-    using rle_vector = til::small_rle<TextAttribute, uint16_t, 1>;
+    using rle_vector = til::small_rle<AttributeTable::id_type, uint16_t, 1>;
 
 public:
-    using const_iterator = rle_vector::const_iterator;
-
-    ATTR_ROW(uint16_t width, TextAttribute attr);
+    // Iterates over the attributes of the columns of the row.
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = TextAttribute;
+        using pointer = const TextAttribute*;
+        using reference = const TextAttribute&;
+        using difference_type = rle_vector::const_iterator::difference_type;
+
+        const_iterator(rle_vector::const_iterator it, const AttributeTable* table) noexcept :
+            _it{ it },
+            _table{ table }
+        {
+        }
+
+        [[nodiscard]] reference operator*() const noexcept
+        {
+            return _table->Get(*_it);
+        }
+
+        [[nodiscard]] pointer operator->() const noexcept
+        {
+            return &operator*();
+        }
+
+        const_iterator& operator++() noexcept
+        {
+            ++_it;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept
+        {
+            auto tmp = *this;
+            ++_it;
+            return tmp;
+        }
+
+        const_iterator& operator--() noexcept
+        {
+            --_it;
+            return *this;
+        }
+
+        const_iterator operator--(int) noexcept
+        {
+            auto tmp = *this;
+            --_it;
+            return tmp;
+        }
+
+        const_iterator& operator+=(const difference_type offset) noexcept
+        {
+            _it += offset;
+            return *this;
+        }
+
+        const_iterator& operator-=(const difference_type offset) noexcept
+        {
+            _it -= offset;
+            return *this;
+        }
+
+        [[nodiscard]] const_iterator operator+(const difference_type offset) const noexcept
+        {
+            auto tmp = *this;
+            return tmp += offset;
+        }
+
+        [[nodiscard]] const_iterator operator-(const difference_type offset) const noexcept
+        {
+            auto tmp = *this;
+            return tmp -= offset;
+        }
+
+        [[nodiscard]] difference_type operator-(const const_iterator& right) const noexcept
+        {
+            return _it - right._it;
+        }
+
+        [[nodiscard]] reference operator[](const difference_type offset) const noexcept
+        {
+            return *(*this + offset);
+        }
+
+        [[nodiscard]] bool operator==(const const_iterator& right) const noexcept
+        {
+            return _it == right._it;
+        }
+
+        [[nodiscard]] bool operator!=(const const_iterator& right) const noexcept
+        {
+            return !(*this == right);
+        }
+
+        [[nodiscard]] bool operator<(const const_iterator& right) const noexcept
+        {
+            return _it < right._it;
+        }
+
+        [[nodiscard]] bool operator>(const const_iterator& right) const noexcept
+        {
+            return right < *this;
+        }
+
+        [[nodiscard]] bool operator<=(const const_iterator& right) const noexcept
+        {
+            return !(right < *this);
+        }
+
+        [[nodiscard]] bool operator>=(const const_iterator& right) const noexcept
+        {
+            return !(*this < right);
+        }
+
+    private:
+        rle_vector::const_iterator _it;
+        const AttributeTable* _table;
+    };
+
+    ATTR_ROW(uint16_t width, TextAttribute attr, AttributeTable& table, ModificationClock& clock);
 
     ~ATTR_ROW() = default;
 
@@ -47,6 +168,15 @@ public:
     void ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith);
     void Resize(uint16_t newWidth);
     void Replace(uint16_t beginIndex, uint16_t endIndex, const TextAttribute& newAttr);
+    void CopyFrom(const ATTR_ROW& other);
+
+    void MarkUsedIds(std::vector<bool>& used) const;
+    void RemapIds(const std::vector<AttributeTable::id_type>& newIds);
+
+    uint64_t GetGeneration() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+    void Trim();
+    bool HasBlinking() const noexcept;
 
     const_iterator begin() const noexcept;
     const_iterator end() const noexcept;
@@ -59,9 +189,20 @@ public:
 
 private:
     void Reset(const TextAttribute attr);
+    void _Touch() noexcept;
+    void _UpdateBlinking(const TextAttribute& attr) noexcept;
 
+    // the table of the buffer this row belongs to, which the IDs in _data refer to
+    AttributeTable* _table;
     rle_vector _data;
 
+    // the clock of the buffer this row belongs to, and the generation of the last change
+    ModificationClock* _clock;
+    uint64_t _generation{ 0 };
+
+    // whether any of the runs is blinking, so that BlinkingState can redraw only the rows that are
+    bool _hasBlinking{ false };
+
 #ifdef UNIT_TESTING
     friend class CommonState;
 #endif
@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "AttributeTable.hpp"
+#include "BufferMemoryUsage.hpp"
+
+// Routine Description:
+// - Returns the ID of the given attribute, adding it to the table if it's new.
+// Arguments:
+// - attr - the attribute to intern
+// Return Value:
+// - the ID of the attribute
+AttributeTable::id_type AttributeTable::Intern(const TextAttribute& attr)
+{
+    if (_lastId < _attributes.size() && til::at(_attributes, _lastId) == attr)
+    {
+        return _lastId;
+    }
+
+    const auto [it, inserted] = _ids.try_emplace(attr, gsl::narrow<id_type>(_attributes.size()));
+    if (inserted)
+    {
+        try
+        {
+            _attributes.emplace_back(attr);
+        }
+        catch (...)
+        {
+            _ids.erase(it);
+            throw;
+        }
+    }
+    _lastId = it->second;
+    return _lastId;
+}
+
+// Routine Description:
+// - Returns the ID of the given attribute, without adding it to the table.
+// Arguments:
+// - attr - the attribute to look for
+// Return Value:
+// - the ID of the attribute, if it's in the table
+std::optional<AttributeTable::id_type> AttributeTable::Find(const TextAttribute& attr) const noexcept
+{
+    const auto it = _ids.find(attr);
+    if (it == _ids.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+// Routine Description:
+// - Returns the attribute with the given ID.
+// Arguments:
+// - id - an ID returned by Intern() (or Compact())
+// Return Value:
+// - the attribute. The reference stays valid until the next Compact().
+const TextAttribute& AttributeTable::Get(const id_type id) const noexcept
+{
+    return til::at(_attributes, id);
+}
+
+size_t AttributeTable::size() const noexcept
+{
+    return _attributes.size();
+}
+
+// Routine Description:
+// - Estimates the heap memory used by the table.
+// Return Value:
+// - the size in bytes
+size_t AttributeTable::GetMemoryUsage() const noexcept
+{
+    return _attributes.size() * sizeof(TextAttribute) + BufferMemoryUsage::OfMap(_ids);
+}
+
+// Routine Description:
+// - Returns whether the table grew enough since the last Compact() to be worth compacting.
+//   Programs cycling through lots of colors would make it grow forever otherwise.
+bool AttributeTable::ShouldCompact() const noexcept
+{
+    return _attributes.size() >= std::max(s_MinCompactionSize, 2 * _sizeAfterCompaction);
+}
+
+// Routine Description:
+// - Drops the attributes which aren't in use anymore. The remaining ones get new IDs.
+// Arguments:
+// - used - whether the attribute with the ID at that index is still in use
+// Return Value:
+// - the new ID of each of the old IDs in use, indexed by the old ID
+std::vector<AttributeTable::id_type> AttributeTable::Compact(const std::vector<bool>& used)
+{
+    std::vector<id_type> newIds(_attributes.size());
+    std::deque<TextAttribute> attributes;
+    std::unordered_map<TextAttribute, id_type> ids;
+    for (id_type id = 0; id < _attributes.size(); ++id)
+    {
+        if (id < used.size() && used.at(id))
+        {
+            const auto& attr = til::at(_attributes, id);
+            const auto newId = gsl::narrow_cast<id_type>(attributes.size());
+            attributes.emplace_back(attr);
+            ids.emplace(attr, newId);
+            til::at(newIds, id) = newId;
+        }
+    }
+
+    _attributes = std::move(attributes);
+    _ids = std::move(ids);
+    _lastId = 0;
+    _sizeAfterCompaction = _attributes.size();
+    return newIds;
+}
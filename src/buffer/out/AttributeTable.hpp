@@ -0,0 +1,46 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- AttributeTable.hpp
+
+Abstract:
+- Interns the text attributes of a TextBuffer, so that its rows only need to
+  store small IDs instead of whole TextAttributes. Equal attributes always get
+  the same ID, which turns comparing attributes into comparing integers.
+- IDs stay valid until Compact() is called, which drops the attributes that
+  aren't in use anymore and hands out new IDs for the remaining ones.
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class AttributeTable final
+{
+public:
+    using id_type = uint32_t;
+
+    AttributeTable() = default;
+
+    id_type Intern(const TextAttribute& attr);
+    std::optional<id_type> Find(const TextAttribute& attr) const noexcept;
+    const TextAttribute& Get(const id_type id) const noexcept;
+    size_t size() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+    bool ShouldCompact() const noexcept;
+    std::vector<id_type> Compact(const std::vector<bool>& used);
+
+private:
+    // Compact() isn't worth it for tables smaller than this.
+    static constexpr size_t s_MinCompactionSize = 4096;
+
+    // A deque keeps references to the attributes valid while new ones are added.
+    std::deque<TextAttribute> _attributes;
+    std::unordered_map<TextAttribute, id_type> _ids;
+    // Attributes tend to be interned many times in a row.
+    id_type _lastId{ 0 };
+    size_t _sizeAfterCompaction{ 0 };
+};
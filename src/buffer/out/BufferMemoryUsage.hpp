@@ -0,0 +1,70 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- BufferMemoryUsage.hpp
+
+Abstract:
+- A breakdown of the memory used by a TextBuffer (and the Terminal around it), in bytes.
+- The numbers are estimates: they account for the elements and capacity of
+  every container, but not for the bookkeeping of the heap itself.
+
+--*/
+
+#pragma once
+
+struct BufferMemoryUsage
+{
+    size_t rows{ 0 }; // the ROW objects themselves, and the prompt marks of the rows
+    size_t cells{ 0 }; // the glyphs of the rows in the cell arena
+    size_t packedCells{ 0 }; // the glyphs of the rows packed into cold storage
+    size_t attributes{ 0 }; // the attribute runs of the rows and the attribute table
+    size_t unicodeStorage{ 0 }; // the glyphs that don't fit into a single cell
+    size_t hyperlinks{ 0 }; // the URIs and custom IDs of hyperlinks, and their reference counts
+    size_t patterns{ 0 }; // the compiled patterns, their cached matches and the Terminal's pattern tree
+    size_t searchIndex{ 0 };
+    size_t delimiterClasses{ 0 }; // the cached delimiter classes of rows, for word navigation
+    size_t rowTexts{ 0 }; // the cached text of rows, for accessibility
+    size_t images{ 0 }; // the pixels of the sixel images in the buffer
+    size_t scrollbackArchive{ 0 }; // the part of the scrollback archive that's kept in memory
+    uint64_t scrollbackArchiveFile{ 0 }; // the rows in the scrollback archive, which live on disk
+
+    // The memory used in total. The scrollback archive file isn't memory and isn't included.
+    size_t Total() const noexcept
+    {
+        return rows + cells + packedCells + attributes + unicodeStorage + hyperlinks + patterns + searchIndex + delimiterClasses + rowTexts + images + scrollbackArchive;
+    }
+
+    BufferMemoryUsage& operator+=(const BufferMemoryUsage& other) noexcept
+    {
+        rows += other.rows;
+        cells += other.cells;
+        packedCells += other.packedCells;
+        attributes += other.attributes;
+        unicodeStorage += other.unicodeStorage;
+        hyperlinks += other.hyperlinks;
+        patterns += other.patterns;
+        searchIndex += other.searchIndex;
+        delimiterClasses += other.delimiterClasses;
+        rowTexts += other.rowTexts;
+        images += other.images;
+        scrollbackArchive += other.scrollbackArchive;
+        scrollbackArchiveFile += other.scrollbackArchiveFile;
+        return *this;
+    }
+
+    template<typename T>
+    static size_t Of(const std::vector<T>& vector) noexcept
+    {
+        return vector.capacity() * sizeof(T);
+    }
+
+    // Every node of an unordered map is allocated separately and holds
+    // a pointer to the next one, next to the table of buckets.
+    template<typename Map>
+    static size_t OfMap(const Map& map) noexcept
+    {
+        return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*));
+    }
+};
@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "CellArena.hpp"
+
+static size_t _GetPageSize() noexcept
+{
+    SYSTEM_INFO info{};
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+// Routine Description:
+// - Allocates and commits the cells for a buffer of the given dimensions
+//   and initializes all of them to their default (space) value.
+// Arguments:
+// - width - the width of every row, in cells
+// - height - the number of rows
+// Return Value:
+// - constructed object
+// Note: will throw exception if unable to allocate the cells
+CellArena::CellArena(const size_t width, const size_t height) :
+    _width{ width },
+    _height{ height }
+{
+    size_t count = 0;
+    THROW_IF_FAILED(SizeTMult(width, height, &count));
+    if (count == 0)
+    {
+        return;
+    }
+
+    size_t bytes = 0;
+    THROW_IF_FAILED(SizeTMult(count, sizeof(CharRowCell), &bytes));
+    const auto cells = static_cast<CharRowCell*>(VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    THROW_LAST_ERROR_IF_NULL(cells);
+    _cells.reset(cells);
+
+    std::uninitialized_fill_n(cells, count, CharRowCell{});
+}
+
+// Routine Description:
+// - Retrieves the cells of the given row slot.
+// Arguments:
+// - index - the row slot to retrieve
+// Return Value:
+// - the cells belonging to the given row slot
+// Note: will throw exception if index is out of bounds
+gsl::span<CharRowCell> CellArena::GetRow(const size_t index) const
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _height);
+    return { _cells.get() + index * _width, _width };
+}
+
+// Routine Description:
+// - Calculates which row slot the given cells belong to.
+// Arguments:
+// - cells - the first cell of a row slot previously retrieved with GetRow()
+// Return Value:
+// - the index of the row slot
+size_t CellArena::GetRowIndex(const CharRowCell* const cells) const noexcept
+{
+    return _width ? gsl::narrow_cast<size_t>(cells - _cells.get()) / _width : 0;
+}
+
+// Routine Description:
+// - Ensures that the memory backing the given cells is committed.
+// - Pages that were previously decommitted are zero filled afterwards,
+//   so the caller is expected to overwrite all given cells.
+// Arguments:
+// - cells - the cells that are about to be written to
+// Note: will throw exception if unable to commit the memory
+void CellArena::Commit(const gsl::span<CharRowCell> cells)
+{
+    if (!cells.empty())
+    {
+        THROW_LAST_ERROR_IF_NULL(VirtualAlloc(cells.data(), cells.size_bytes(), MEM_COMMIT, PAGE_READWRITE));
+    }
+}
+
+// Routine Description:
+// - Returns the pages that are entirely covered by the given range of row slots to the OS.
+// - Pages shared with row slots outside of the range remain committed.
+// - The caller must not read from any of these row slots until they've been committed again.
+// Arguments:
+// - firstRow - the first row slot of the range
+// - lastRowExclusive - one past the last row slot of the range
+void CellArena::Decommit(const size_t firstRow, const size_t lastRowExclusive) noexcept
+{
+    static const auto pageSize = _GetPageSize();
+
+    const auto base = reinterpret_cast<uintptr_t>(_cells.get());
+    const auto stride = _width * sizeof(CharRowCell);
+    const auto begin = (base + firstRow * stride + pageSize - 1) / pageSize * pageSize;
+    const auto end = (base + lastRowExclusive * stride) / pageSize * pageSize;
+
+    if (begin < end)
+    {
+#pragma warning(suppress : 6250) // Decommitting without releasing is the whole point.
+        LOG_IF_WIN32_BOOL_FALSE(VirtualFree(reinterpret_cast<void*>(begin), end - begin, MEM_DECOMMIT));
+    }
+}
@@ -0,0 +1,44 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- CellArena.hpp
+
+Abstract:
+- A single contiguous allocation holding the glyph cells of every row in a
+  TextBuffer, laid out back to back with a fixed stride of one row width.
+- The memory is reserved with VirtualAlloc so that the pages backing rows
+  which have been packed into cold storage can be returned to the OS and
+  committed again once those rows are needed.
+--*/
+
+#pragma once
+
+#include "CharRowCell.hpp"
+
+class CellArena final
+{
+public:
+    CellArena() noexcept = default;
+    CellArena(const size_t width, const size_t height);
+
+    gsl::span<CharRowCell> GetRow(const size_t index) const;
+    size_t GetRowIndex(const CharRowCell* const cells) const noexcept;
+
+    void Commit(const gsl::span<CharRowCell> cells);
+    void Decommit(const size_t firstRow, const size_t lastRowExclusive) noexcept;
+
+private:
+    struct VirtualFreeDeleter
+    {
+        void operator()(CharRowCell* const cells) const noexcept
+        {
+            LOG_IF_WIN32_BOOL_FALSE(VirtualFree(cells, 0, MEM_RELEASE));
+        }
+    };
+
+    std::unique_ptr<CharRowCell[], VirtualFreeDeleter> _cells;
+    size_t _width = 0;
+    size_t _height = 0;
+};
@@ -10,19 +10,19 @@
 // Routine Description:
 // - constructor
 // Arguments:
-// - rowWidth - the size (in wchar_t) of the char and attribute rows
-// - pParent - the parent ROW
+// - buffer - the cells backing this row, owned by the TextBuffer's cell arena
+// - clock - the clock of the TextBuffer, which stamps the generations of the row
 // Return Value:
 // - instantiated object
-// Note: will through if unable to allocate char/attribute buffers
-#pragma warning(push)
-#pragma warning(disable : 26447) // small_vector's constructor says it can throw but it should not given how we use it.  This suppresses this error for the AuditMode build.
-CharRow::CharRow(size_t rowWidth, ROW* const pParent) noexcept :
-    _data(rowWidth, value_type()),
-    _pParent{ FAIL_FAST_IF_NULL(pParent) }
+CharRow::CharRow(gsl::span<value_type> buffer, ModificationClock& clock) noexcept :
+    _data{ buffer },
+    _cells{ buffer },
+    _unicodeStorage{},
+    _clock{ &clock },
+    _generation{ 0 },
+    _right{}
 {
 }
-#pragma warning(pop)
 
 // Routine Description:
 // - gets the size of the row, in glyph cells
@@ -47,44 +47,82 @@ void CharRow::Reset() noexcept
     {
         cell.Reset();
     }
+    _cells = _data;
+    _unicodeStorage.Clear();
+    _Touch();
 }
 
 // Routine Description:
-// - resizes the width of the CharRowBase
+// - Replaces the contents of this row with those of another row
+// - If the other row is wider, the cells past the width of this row are cut off.
+//   If it's narrower, the remaining cells are set to their default value.
 // Arguments:
-// - newSize - the new width of the character and attributes rows
+// - other - the row to copy from
 // Return Value:
-// - S_OK on success, otherwise relevant error code
-[[nodiscard]] HRESULT CharRow::Resize(const size_t newSize) noexcept
+// - <none>
+void CharRow::CopyFrom(const CharRow& other)
 {
-    try
+    const auto copyable = std::min(other.size(), size());
+    const auto it = std::copy_n(other.cbegin(), std::min(copyable, other._cells.size()), _data.data());
+    std::fill(it, _data.data() + size(), value_type{});
+    _unicodeStorage = other._unicodeStorage;
+    if (copyable < other.size())
     {
-        const value_type insertVals;
-        _data.resize(newSize, insertVals);
+        _unicodeStorage.Truncate(GetStorageKey(copyable));
+
+        // Don't leave half of a wide glyph behind.
+        auto& last = _cellAt(copyable - 1);
+        if (last.DbcsAttr().IsLeading())
+        {
+            last.Reset();
+            _unicodeStorage.Erase(GetStorageKey(copyable - 1));
+        }
     }
-    CATCH_RETURN();
+    _Touch();
+}
 
-    return S_OK;
+// Routine Description:
+// - moves the row into a new slice of cells, resizing it to the width of that slice
+// - existing cells are copied over (truncating if the new slice is narrower) and any
+//   additional cells are set to their default value.
+// Arguments:
+// - buffer - the cells that will back this row from now on
+// Return Value:
+// - <none>
+void CharRow::Resize(gsl::span<value_type> buffer) noexcept
+{
+    const auto copyable = std::min(_cells.size(), buffer.size());
+    const auto it = std::copy_n(cbegin(), copyable, buffer.data());
+    std::fill(it, buffer.data() + buffer.size(), value_type{});
+    _data = buffer;
+    _cells = buffer;
+    _unicodeStorage.Truncate(gsl::narrow_cast<UnicodeStorage::key_type>(buffer.size()));
+    _Touch();
 }
 
 typename CharRow::iterator CharRow::begin() noexcept
 {
-    return _data.begin();
+    // mutable iterators are how ROW::WriteCells overwrites the row
+    _Touch();
+    return _data.data();
 }
 
+// Routine Description:
+// - gets the beginning of the cells as they're read, which may end before size()
+//   cells for a packed or lazily cleared row. The cells past cend() are default cells.
 typename CharRow::const_iterator CharRow::cbegin() const noexcept
 {
-    return _data.cbegin();
+    return _cells.data();
 }
 
 typename CharRow::iterator CharRow::end() noexcept
 {
-    return _data.end();
+    return _data.data() + _data.size();
 }
 
 typename CharRow::const_iterator CharRow::cend() const noexcept
 {
-    return _data.cend();
+    return _cells.data() + _cells.size();
 }
 
 // Routine Description:
@@ -95,33 +133,171 @@ typename CharRow::const_iterator CharRow::cend() const noexcept
 // - The calculated left boundary of the internal string.
 size_t CharRow::MeasureLeft() const noexcept
 {
-    const_iterator it = _data.cbegin();
-    while (it != _data.cend() && it->IsSpace())
+    const_iterator it = cbegin();
+    while (it != cend() && it->IsSpace())
     {
         ++it;
     }
-    return it - _data.cbegin();
+    return it == cend() ? size() : it - cbegin();
 }
 
 // Routine Description:
 // - Inspects the current internal string to find the right edge of it
+// - The result is kept until the text of the row changes, so that asking
+//   again (like GetLastNonSpaceCharacter does for every row) doesn't scan it again.
 // Arguments:
 // - <none>
 // Return Value:
 // - The calculated right boundary of the internal string.
 size_t CharRow::MeasureRight() const
 {
-    const_reverse_iterator it = _data.crbegin();
-    while (it != _data.crend() && it->IsSpace())
+    // Rows are at most 0xFFFF wide (see ROW::Resize) and only the low 48 bits of the generation are kept.
+    constexpr auto generationMask = std::numeric_limits<uint64_t>::max() >> 16;
+    const auto generation = _generation & generationMask;
+    const auto measured = _right.value.load(std::memory_order_relaxed);
+    if ((measured >> 16) == generation)
+    {
+        return gsl::narrow_cast<size_t>(measured & 0xFFFF);
+    }
+
+    const_reverse_iterator it{ cend() };
+    const const_reverse_iterator rend{ cbegin() };
+    while (it != rend && it->IsSpace())
     {
         ++it;
     }
-    return _data.crend() - it;
+    const auto right = gsl::narrow_cast<size_t>(rend - it);
+    _right.value.store((generation << 16) | right, std::memory_order_relaxed);
+    return right;
+}
+
+// Routine Description:
+// - bounds checked access to the cell at the given column
+// Arguments:
+// - column - the column to retrieve
+// Return Value:
+// - the cell at column
+// Note: will throw exception if column is out of bounds
+typename CharRow::value_type& CharRow::_cellAt(const size_t column)
+{
+    THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    return til::at(_data, column);
+}
+
+const CharRow::value_type& CharRow::_cellAt(const size_t column) const
+{
+    static const value_type blank{};
+
+    THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    return column < _cells.size() ? til::at(_cells, column) : blank;
 }
 
 void CharRow::ClearCell(const size_t column)
 {
-    _data.at(column).Reset();
+    _cellAt(column).Reset();
+    _unicodeStorage.Erase(GetStorageKey(column));
+    _Touch();
+}
+
+// Routine Description:
+// - Writes one narrow character per cell, starting at the given column.
+// - This is the same as assigning each character through GlyphAt() and resetting
+//   DbcsAttrAt() to single width, without the per cell bookkeeping.
+// Arguments:
+// - column - 0-indexed column of the first cell to write
+// - text - characters which fit into a single cell each
+// Return Value:
+// - <none>
+void CharRow::WriteNarrowText(const size_t column, const std::wstring_view text)
+{
+    THROW_HR_IF(E_INVALIDARG, column > size() || text.size() > size() - column);
+
+    _EraseStoredGlyphs(column, text.size());
+
+    auto cell = _data.begin() + column;
+    for (const auto wch : text)
+    {
+        *cell = value_type{ wch, DbcsAttribute{} };
+        ++cell;
+    }
+    _Touch();
+}
+
+// Routine Description:
+// - Fills cells with the same narrow character, starting at the given column.
+// Arguments:
+// - column - 0-indexed column of the first cell to write
+// - count - the number of cells to fill
+// - wch - a character which fits into a single cell
+// Return Value:
+// - <none>
+void CharRow::FillNarrowGlyph(const size_t column, const size_t count, const wchar_t wch)
+{
+    THROW_HR_IF(E_INVALIDARG, column > size() || count > size() - column);
+
+    _EraseStoredGlyphs(column, count);
+
+    const auto begin = _data.begin() + column;
+    std::fill(begin, begin + count, value_type{ wch, DbcsAttribute{} });
+    _Touch();
+}
+
+// Routine Description:
+// - Writes the characters and the leading/trailing byte flags of legacy cells, one per cell,
+//   starting at the given column. The colors of the cells are left to the caller.
+// Arguments:
+// - column - 0-indexed column of the first cell to write
+// - cells - the legacy cells to take the characters from
+// Return Value:
+// - <none>
+void CharRow::WriteLegacyGlyphs(const size_t column, const gsl::span<const CHAR_INFO> cells)
+{
+    THROW_HR_IF(E_INVALIDARG, column > size() || cells.size() > size() - column);
+
+    _EraseStoredGlyphs(column, cells.size());
+
+    auto cell = _data.begin() + column;
+    for (const auto& charInfo : cells)
+    {
+        // A cell claiming to be both halves is taken as the leading one, like OutputCellIterator does.
+        DbcsAttribute dbcsAttr;
+        if (WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_LEADING_BYTE))
+        {
+            dbcsAttr.SetLeading();
+        }
+        else if (WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_TRAILING_BYTE))
+        {
+            dbcsAttr.SetTrailing();
+        }
+
+        *cell = value_type{ charInfo.Char.UnicodeChar, dbcsAttr };
+        ++cell;
+    }
+    _Touch();
+}
+
+// Routine Description:
+// - Forgets the glyphs kept in the unicode storage for the given cells, before they're overwritten.
+// Arguments:
+// - column - 0-indexed column of the first cell
+// - count - the number of cells
+// Return Value:
+// - <none>
+void CharRow::_EraseStoredGlyphs(const size_t column, const size_t count) noexcept
+{
+    // Only cells which had a glyph too large to fit into them have anything to erase.
+    if (_unicodeStorage.empty())
+    {
+        return;
+    }
+
+    for (auto i = column; i < column + count; ++i)
+    {
+        if (_data[i].DbcsAttr().IsGlyphStored())
+        {
+            _unicodeStorage.Erase(GetStorageKey(i));
+        }
+    }
 }
 
 // Routine Description:
@@ -132,7 +308,7 @@ void CharRow::ClearCell(const size_t column)
 // - True if there is valid text in this row. False otherwise.
 bool CharRow::ContainsText() const noexcept
 {
-    for (const value_type& cell : _data)
+    for (const value_type& cell : _cells)
     {
         if (!cell.IsSpace())
         {
@@ -151,7 +327,7 @@ bool CharRow::ContainsText() const noexcept
 // Note: will throw exception if column is out of bounds
 const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 {
-    return _data.at(column).DbcsAttr();
+    return _cellAt(column).DbcsAttr();
 }
 
 // Routine Description:
@@ -163,7 +339,9 @@ const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 // Note: will throw exception if column is out of bounds
 DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 {
-    return _data.at(column).DbcsAttr();
+    // leading/trailing flags decide which cells make it into GetText
+    _Touch();
+    return _cellAt(column).DbcsAttr();
 }
 
 // Routine Description:
@@ -175,7 +353,9 @@ DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 // Note: will throw exception if column is out of bounds
 void CharRow::ClearGlyph(const size_t column)
 {
-    _data.at(column).EraseChars();
+    _cellAt(column).EraseChars();
+    _unicodeStorage.Erase(GetStorageKey(column));
+    _Touch();
 }
 
 // Routine Description:
@@ -252,12 +432,12 @@ const DelimiterClass CharRow::DelimiterClassAt(const size_t column, const std::w
 
 UnicodeStorage& CharRow::GetUnicodeStorage() noexcept
 {
-    return _pParent->GetUnicodeStorage();
+    return _unicodeStorage;
 }
 
 const UnicodeStorage& CharRow::GetUnicodeStorage() const noexcept
 {
-    return _pParent->GetUnicodeStorage();
+    return _unicodeStorage;
 }
 
 // Routine Description:
@@ -265,17 +445,45 @@ const UnicodeStorage& CharRow::GetUnicodeStorage() const noexcept
 // Arguments:
 // - column - the column to generate the key for
 // Return Value:
-// - the COORD key for data access from UnicodeStorage for the column
-COORD CharRow::GetStorageKey(const size_t column) const noexcept
+// - the key for data access from UnicodeStorage for the column
+UnicodeStorage::key_type CharRow::GetStorageKey(const size_t column) const noexcept
 {
-    return { gsl::narrow<SHORT>(column), _pParent->GetId() };
+    return gsl::narrow_cast<UnicodeStorage::key_type>(column);
 }
 
 // Routine Description:
-// - Updates the pointer to the parent row (which might change if we shuffle the rows around)
+// - gets the generation of the buffer's ModificationClock in which the text of this row
+//   may have been modified last
+// - consumers can cache results derived from the row text (e.g. pattern matches)
+//   and revalidate them by comparing generations instead of the text itself
 // Arguments:
-// - pParent - Pointer to the parent row
-void CharRow::UpdateParent(ROW* const pParent)
+// - <none>
+// Return Value:
+// - the current generation of the row
+uint64_t CharRow::GetGeneration() const noexcept
+{
+    return _generation;
+}
+
+// Routine Description:
+// - gets the slice of the TextBuffer's cell arena backing this row, which
+//   unlike cbegin() doesn't depend on whether the row is packed
+// Arguments:
+// - <none>
+// Return Value:
+// - the first cell of the row in the arena
+const CharRow::value_type* CharRow::GetArenaCells() const noexcept
+{
+    return _data.data();
+}
+
+// Routine Description:
+// - stamps the row with a new generation, as its text is being changed
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void CharRow::_Touch() noexcept
 {
-    _pParent = FAIL_FAST_IF_NULL(pParent);
+    _generation = _clock->Tick();
 }
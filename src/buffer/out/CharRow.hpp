@@ -24,6 +24,7 @@ Revision History:
 #include "CharRowCellReference.hpp"
 #include "CharRowCell.hpp"
 #include "UnicodeStorage.hpp"
+#include "ModificationClock.hpp"
 
 class ROW;
 
@@ -44,20 +45,24 @@ enum class DelimiterClass
 //       ^    ^                  ^                     ^
 //       |    |                  |                     |
 //     Chars Left               Right                end of Chars buffer
+//
+// The cells themselves are not owned by the CharRow. The TextBuffer allocates a single
+// contiguous, fixed-stride arena for every row in the buffer and each CharRow only
+// views its slice of it. This keeps the whole buffer in linear memory.
 class CharRow final
 {
 public:
     using glyph_type = typename wchar_t;
     using value_type = typename CharRowCell;
-    using iterator = typename boost::container::small_vector_base<value_type>::iterator;
-    using const_iterator = typename boost::container::small_vector_base<value_type>::const_iterator;
-    using const_reverse_iterator = typename boost::container::small_vector_base<value_type>::const_reverse_iterator;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
     using reference = typename CharRowCellReference;
 
-    CharRow(size_t rowWidth, ROW* const pParent) noexcept;
+    CharRow(gsl::span<value_type> buffer, ModificationClock& clock) noexcept;
 
     size_t size() const noexcept;
-    [[nodiscard]] HRESULT Resize(const size_t newSize) noexcept;
+    void Resize(gsl::span<value_type> buffer) noexcept;
     size_t MeasureLeft() const noexcept;
     size_t MeasureRight() const;
     bool ContainsText() const noexcept;
@@ -82,24 +87,66 @@ public:
 
     UnicodeStorage& GetUnicodeStorage() noexcept;
     const UnicodeStorage& GetUnicodeStorage() const noexcept;
-    COORD GetStorageKey(const size_t column) const noexcept;
+    UnicodeStorage::key_type GetStorageKey(const size_t column) const noexcept;
 
-    void UpdateParent(ROW* const pParent);
+    uint64_t GetGeneration() const noexcept;
+    const value_type* GetArenaCells() const noexcept;
 
     friend CharRowCellReference;
     friend class ROW;
 
 private:
     void Reset() noexcept;
+    void CopyFrom(const CharRow& other);
     void ClearCell(const size_t column);
+    void WriteNarrowText(const size_t column, const std::wstring_view text);
+    void FillNarrowGlyph(const size_t column, const size_t count, const wchar_t wch);
+    void WriteLegacyGlyphs(const size_t column, const gsl::span<const CHAR_INFO> cells);
     std::wstring GetText() const;
 
-protected:
-    // storage for glyph data and dbcs attributes
-    boost::container::small_vector<value_type, 120> _data;
+    void _Touch() noexcept;
+    void _EraseStoredGlyphs(const size_t column, const size_t count) noexcept;
 
-    // ROW that this CharRow belongs to
-    ROW* _pParent;
+    value_type& _cellAt(const size_t column);
+    const value_type& _cellAt(const size_t column) const;
+
+protected:
+    // storage for glyph data and dbcs attributes (a slice of the TextBuffer's cell arena)
+    gsl::span<value_type> _data;
+
+    // the cells that are read through the const methods: _data, unless the ROW is packed
+    // or was cleared lazily. The cells past the end of _cells are all default cells then,
+    // so that reading such a row never has to change it.
+    gsl::span<const value_type> _cells;
+
+    // storage location for the glyphs of this row that can't fit into a cell normally
+    UnicodeStorage _unicodeStorage;
+
+    // the clock of the TextBuffer, which stamps _generation
+    ModificationClock* _clock;
+
+    // the generation in which the text of this row last changed, see GetGeneration
+    uint64_t _generation;
+
+    // The result of MeasureRight and the generation it was measured in, as generation << 16 | right.
+    // Readers holding the lock shared measure rows at the same time, so the two are kept together
+    // in one atomic rather than in two fields another reader could see half updated.
+    struct MeasuredRight
+    {
+        MeasuredRight() = default;
+        MeasuredRight(const MeasuredRight& other) noexcept :
+            value{ other.value.load(std::memory_order_relaxed) }
+        {
+        }
+        MeasuredRight& operator=(const MeasuredRight& other) noexcept
+        {
+            value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+
+        std::atomic<uint64_t> value{ std::numeric_limits<uint64_t>::max() };
+    };
+    mutable MeasuredRight _right;
 };
 
 template<typename InputIt1, typename InputIt2>
@@ -12,8 +12,13 @@
 void CharRowCellReference::operator=(const std::wstring_view chars)
 {
     THROW_HR_IF(E_INVALIDARG, chars.empty());
+    _parent._Touch();
     if (chars.size() == 1)
     {
+        if (_cellData().DbcsAttr().IsGlyphStored())
+        {
+            _parent.GetUnicodeStorage().Erase(_parent.GetStorageKey(_index));
+        }
         _cellData().Char() = chars.front();
         _cellData().DbcsAttr().SetGlyphStored(false);
     }
@@ -41,7 +46,7 @@ CharRowCellReference::operator std::wstring_view() const
 // - ref to the CharRowCell
 CharRowCell& CharRowCellReference::_cellData()
 {
-    return _parent._data.at(_index);
+    return _parent._cellAt(_index);
 }
 
 // Routine Description:
@@ -50,7 +55,7 @@ CharRowCell& CharRowCellReference::_cellData()
 // - ref to the CharRowCell
 const CharRowCell& CharRowCellReference::_cellData() const
 {
-    return _parent._data.at(_index);
+    return std::as_const(_parent)._cellAt(_index);
 }
 
 // Routine Description:
@@ -0,0 +1,303 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "HyperlinkTable.hpp"
+#include "BufferMemoryUsage.hpp"
+
+// Routine Description:
+// - Adds a hyperlink without a custom ID. Each call gets a new ID.
+// Arguments:
+// - uri - the URI of the hyperlink
+// Return Value:
+// - the ID of the new hyperlink, or 0 if all IDs are in use
+HyperlinkTable::id_type HyperlinkTable::Add(const std::wstring_view uri)
+{
+    const auto uriSpan = _Store(uri);
+    try
+    {
+        const auto id = _NewId();
+        if (id != 0)
+        {
+            til::at(_entries, id) = Entry{ uriSpan, {}, 0, true };
+            ++_size;
+            return id;
+        }
+    }
+    CATCH_LOG();
+
+    _Release(uriSpan);
+    return 0;
+}
+
+// Routine Description:
+// - Adds a hyperlink with a custom ID, unless one with the same custom ID already exists.
+// Arguments:
+// - uri - the URI of the hyperlink
+// - customId - the custom ID of the hyperlink
+// Return Value:
+// - the ID of the existing or new hyperlink, or 0 if all IDs are in use
+HyperlinkTable::id_type HyperlinkTable::AddWithCustomId(const std::wstring_view uri, const std::wstring_view customId)
+{
+    if (const auto existing = FindCustomId(customId))
+    {
+        return *existing;
+    }
+
+    const auto uriSpan = _Store(uri);
+    const auto customIdSpan = _Store(customId);
+    try
+    {
+        const auto id = _NewId();
+        if (id != 0)
+        {
+            _customIds.emplace(std::hash<std::wstring_view>{}(customId), id);
+            til::at(_entries, id) = Entry{ uriSpan, customIdSpan, 0, true };
+            ++_size;
+            return id;
+        }
+    }
+    CATCH_LOG();
+
+    _Release(uriSpan);
+    _Release(customIdSpan);
+    return 0;
+}
+
+// Routine Description:
+// - Replaces the URI of a hyperlink. Unknown IDs are ignored.
+// Arguments:
+// - id - the ID of the hyperlink
+// - uri - the new URI
+void HyperlinkTable::SetUri(const id_type id, const std::wstring_view uri)
+{
+    if (!Contains(id) || GetUri(id) == uri)
+    {
+        return;
+    }
+
+    const auto uriSpan = _Store(uri);
+    auto& entry = til::at(_entries, id);
+    _Release(entry.uri);
+    entry.uri = uriSpan;
+}
+
+// Routine Description:
+// - Removes a hyperlink along with its custom ID. Its ID may be handed out again afterwards.
+// Arguments:
+// - id - the ID of the hyperlink
+void HyperlinkTable::Remove(const id_type id) noexcept
+{
+    if (!Contains(id))
+    {
+        return;
+    }
+
+    auto& entry = til::at(_entries, id);
+    if (entry.customId.length != 0)
+    {
+        auto [it, end] = _customIds.equal_range(std::hash<std::wstring_view>{}(_View(entry.customId)));
+        for (; it != end; ++it)
+        {
+            if (it->second == id)
+            {
+                _customIds.erase(it);
+                break;
+            }
+        }
+    }
+    _Release(entry.uri);
+    _Release(entry.customId);
+    entry = Entry{};
+    --_size;
+
+    try
+    {
+        _freeIds.push_back(id);
+    }
+    CATCH_LOG();
+}
+
+bool HyperlinkTable::Contains(const id_type id) const noexcept
+{
+    return id < _entries.size() && til::at(_entries, id).used;
+}
+
+// Routine Description:
+// - Returns the URI of a hyperlink. Throws for unknown IDs.
+// Arguments:
+// - id - the ID of the hyperlink
+// Return Value:
+// - the URI. It's only valid until the table is modified.
+std::wstring_view HyperlinkTable::GetUri(const id_type id) const
+{
+    THROW_HR_IF(E_INVALIDARG, !Contains(id));
+    return _View(til::at(_entries, id).uri);
+}
+
+// Routine Description:
+// - Returns the custom ID of a hyperlink.
+// Arguments:
+// - id - the ID of the hyperlink
+// Return Value:
+// - the custom ID, which is empty if it has none or is unknown. It's only valid until the table is modified.
+std::wstring_view HyperlinkTable::GetCustomId(const id_type id) const noexcept
+{
+    return Contains(id) ? _View(til::at(_entries, id).customId) : std::wstring_view{};
+}
+
+// Routine Description:
+// - Finds the hyperlink with the given custom ID.
+// Arguments:
+// - customId - the custom ID to look for
+// Return Value:
+// - the ID of the hyperlink, if there is one
+std::optional<HyperlinkTable::id_type> HyperlinkTable::FindCustomId(const std::wstring_view customId) const noexcept
+{
+    auto [it, end] = _customIds.equal_range(std::hash<std::wstring_view>{}(customId));
+    for (; it != end; ++it)
+    {
+        if (_View(til::at(_entries, it->second).customId) == customId)
+        {
+            return it->second;
+        }
+    }
+    return std::nullopt;
+}
+
+bool HyperlinkTable::empty() const noexcept
+{
+    return _size == 0;
+}
+
+size_t HyperlinkTable::size() const noexcept
+{
+    return _size;
+}
+
+// Routine Description:
+// - Estimates the heap memory used by the table.
+// Return Value:
+// - the size in bytes
+size_t HyperlinkTable::GetMemoryUsage() const noexcept
+{
+    return BufferMemoryUsage::Of(_entries) +
+           BufferMemoryUsage::Of(_freeIds) +
+           _strings.capacity() * sizeof(wchar_t) +
+           BufferMemoryUsage::OfMap(_customIds);
+}
+
+void HyperlinkTable::AddReference(const id_type id) noexcept
+{
+    if (Contains(id))
+    {
+        ++til::at(_entries, id).references;
+    }
+}
+
+// Routine Description:
+// - Drops a reference to a hyperlink. The hyperlink isn't removed, even if that was the last one.
+// Arguments:
+// - id - the ID of the hyperlink
+// Return Value:
+// - the number of references left
+uint32_t HyperlinkTable::RemoveReference(const id_type id) noexcept
+{
+    if (!Contains(id))
+    {
+        return 0;
+    }
+
+    auto& references = til::at(_entries, id).references;
+    if (references != 0)
+    {
+        --references;
+    }
+    return references;
+}
+
+void HyperlinkTable::ClearReferences() noexcept
+{
+    for (auto& entry : _entries)
+    {
+        entry.references = 0;
+    }
+}
+
+// Routine Description:
+// - Picks the ID for a new hyperlink, preferring the ones of removed hyperlinks.
+// Return Value:
+// - the ID, or 0 if all of them are in use
+HyperlinkTable::id_type HyperlinkTable::_NewId()
+{
+    if (!_freeIds.empty())
+    {
+        const auto id = _freeIds.back();
+        _freeIds.pop_back();
+        return id;
+    }
+    if (_entries.size() > std::numeric_limits<id_type>::max())
+    {
+        return 0;
+    }
+    _entries.emplace_back();
+    return gsl::narrow_cast<id_type>(_entries.size() - 1);
+}
+
+// Routine Description:
+// - Appends a string to _strings, compacting them first if most of them were removed.
+// Arguments:
+// - text - the string to store
+// Return Value:
+// - where the string was stored
+HyperlinkTable::Span HyperlinkTable::_Store(const std::wstring_view text)
+{
+    if (text.empty())
+    {
+        return {};
+    }
+    if (_garbage >= s_MinCompactionSize && _garbage * 2 >= _strings.size())
+    {
+        _CompactStrings();
+    }
+
+    const Span span{ gsl::narrow<uint32_t>(_strings.size()), gsl::narrow<uint32_t>(text.size()) };
+    _strings.append(text);
+    return span;
+}
+
+void HyperlinkTable::_Release(const Span span) noexcept
+{
+    _garbage += span.length;
+}
+
+std::wstring_view HyperlinkTable::_View(const Span span) const noexcept
+{
+    return std::wstring_view{ _strings }.substr(span.offset, span.length);
+}
+
+// Routine Description:
+// - Moves the strings of the hyperlinks in use together, dropping the removed ones.
+void HyperlinkTable::_CompactStrings()
+{
+    std::wstring strings;
+    strings.reserve(_strings.size() - _garbage);
+    const auto move = [&](Span& span) {
+        if (span.length != 0)
+        {
+            const auto offset = gsl::narrow_cast<uint32_t>(strings.size());
+            strings.append(_View(span));
+            span.offset = offset;
+        }
+    };
+    for (auto& entry : _entries)
+    {
+        if (entry.used)
+        {
+            move(entry.uri);
+            move(entry.customId);
+        }
+    }
+    _strings = std::move(strings);
+    _garbage = 0;
+}
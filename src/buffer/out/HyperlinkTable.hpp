@@ -0,0 +1,82 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- HyperlinkTable.hpp
+
+Abstract:
+- Holds the URIs and custom IDs of the hyperlinks (OSC 8) of a TextBuffer,
+  which the attributes of its cells refer to by a 16-bit ID.
+- The strings are stored back to back in a single allocation. The space of
+  removed hyperlinks is reclaimed once it makes up most of that allocation.
+- The IDs of removed hyperlinks are handed out again, so the ID space only
+  runs out if that many hyperlinks are in use at the same time.
+- Every hyperlink also has a reference count, which the TextBuffer maintains
+  as the number of rows referring to it.
+--*/
+
+#pragma once
+
+class HyperlinkTable final
+{
+public:
+    using id_type = uint16_t;
+
+    HyperlinkTable() = default;
+
+    id_type Add(const std::wstring_view uri);
+    id_type AddWithCustomId(const std::wstring_view uri, const std::wstring_view customId);
+    void SetUri(const id_type id, const std::wstring_view uri);
+    void Remove(const id_type id) noexcept;
+
+    bool Contains(const id_type id) const noexcept;
+    std::wstring_view GetUri(const id_type id) const;
+    std::wstring_view GetCustomId(const id_type id) const noexcept;
+    std::optional<id_type> FindCustomId(const std::wstring_view customId) const noexcept;
+    bool empty() const noexcept;
+    size_t size() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+    void AddReference(const id_type id) noexcept;
+    uint32_t RemoveReference(const id_type id) noexcept;
+    void ClearReferences() noexcept;
+
+private:
+    // A string within _strings.
+    struct Span
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct Entry
+    {
+        Span uri;
+        Span customId;
+        uint32_t references;
+        bool used;
+    };
+
+    // Reclaiming the space of removed strings isn't worth it below this many characters.
+    static constexpr size_t s_MinCompactionSize = 4096;
+
+    id_type _NewId();
+    Span _Store(const std::wstring_view text);
+    void _Release(const Span span) noexcept;
+    std::wstring_view _View(const Span span) const noexcept;
+    void _CompactStrings();
+
+    // Indexed by ID. 0 isn't a valid hyperlink ID, so that entry is never used.
+    std::vector<Entry> _entries{ 1 };
+    std::vector<id_type> _freeIds;
+    std::wstring _strings;
+    size_t _garbage{ 0 };
+    // The hash of each custom ID, to find the hyperlink it belongs to.
+    std::unordered_multimap<size_t, id_type> _customIds;
+    size_t _size{ 0 };
+
+#ifdef UNIT_TESTING
+    friend class TextBufferTests;
+#endif
+};
@@ -0,0 +1,145 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ImageStore.hpp
+
+Abstract:
+- The images (sixels) that were drawn into a TextBuffer, and where they are.
+- Every image is decoded once and shared between its placement and the
+  renderers, which keep the textures they made for it by its ID. Like the
+  prompt marks, placements are kept sorted by row, and their rows count every
+  row the buffer ever held, so that they stay put while the buffer circles.
+
+--*/
+
+#pragma once
+
+class ImageStore final
+{
+public:
+    // The size of a cell the images are drawn in, in pixels. Sixel images are
+    // laid out as if the cells were those of a VT340, and are scaled from
+    // there to the actual size of the cells when they are drawn.
+    static constexpr til::size VirtualCellSize{ 10, 20 };
+
+    struct Image
+    {
+        uint64_t id;
+        til::size size;
+        // premultiplied BGRA, row by row
+        std::vector<uint32_t> pixels;
+
+        // The number of cells that the image covers.
+        til::size CellSize() const noexcept
+        {
+            return { (size.width() + VirtualCellSize.width() - 1) / VirtualCellSize.width(),
+                     (size.height() + VirtualCellSize.height() - 1) / VirtualCellSize.height() };
+        }
+    };
+
+    struct Placement
+    {
+        uint64_t row;
+        SHORT column;
+        std::shared_ptr<const Image> image;
+    };
+
+    // Images are told apart by renderers by their IDs, which are never reused,
+    // not even by different buffers.
+    static uint64_t NextImageId() noexcept
+    {
+        static std::atomic<uint64_t> nextId{ 1 };
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool empty() const noexcept
+    {
+        return _placements.empty();
+    }
+
+    void clear() noexcept
+    {
+        _placements.clear();
+        _tallest = 0;
+    }
+
+    // Adds an image, with its top left corner at the given row and column.
+    // Images that were placed at the same spot before are drawn over,
+    // so they are dropped.
+    void Add(const uint64_t row, const SHORT column, std::shared_ptr<const Image> image)
+    {
+        _tallest = std::max(_tallest, gsl::narrow_cast<uint64_t>(image->CellSize().height()));
+        const auto begin = _placements.begin() + (_LowerBound(row) - _placements.cbegin());
+        const auto end = _placements.begin() + (_LowerBound(row + 1) - _placements.cbegin());
+        const auto kept = std::remove_if(begin, end, [&](const Placement& placement) {
+            return placement.column == column && placement.image->size.width() <= image->size.width() && placement.image->size.height() <= image->size.height();
+        });
+        _placements.insert(_placements.erase(kept, end), Placement{ row, column, std::move(image) });
+    }
+
+    // Drops the images above the given row, which left the buffer.
+    void DropBefore(const uint64_t row) noexcept
+    {
+        while (!_placements.empty() && _placements.front().row < row)
+        {
+            _placements.pop_front();
+        }
+    }
+
+    // Drops the images that start in the rows [begin, end).
+    void Erase(const uint64_t begin, const uint64_t end)
+    {
+        _placements.erase(_LowerBound(begin), _LowerBound(end));
+    }
+
+    // Moves every image down by the given number of rows, like PromptMarks::MoveDown.
+    void MoveDown(const uint64_t rows) noexcept
+    {
+        for (auto& placement : _placements)
+        {
+            placement.row += rows;
+        }
+    }
+
+    // Calls func with every image that covers any of the rows [begin, end),
+    // from the oldest to the newest, so that newer ones are drawn on top.
+    template<typename T>
+    void ForEach(const uint64_t begin, const uint64_t end, T&& func) const
+    {
+        const auto first = _LowerBound(begin > _tallest ? begin - _tallest : 0);
+        const auto last = _LowerBound(end);
+        for (auto it = first; it != last; ++it)
+        {
+            if (it->row + it->image->CellSize().height() > begin)
+            {
+                func(*it);
+            }
+        }
+    }
+
+    size_t GetMemoryUsage() const noexcept
+    {
+        size_t usage = _placements.size() * sizeof(Placement);
+        for (const auto& placement : _placements)
+        {
+            // Images are only shared with renderers, so every one is counted where it's placed.
+            usage += sizeof(Image) + placement.image->pixels.capacity() * sizeof(uint32_t);
+        }
+        return usage;
+    }
+
+private:
+    std::deque<Placement>::const_iterator _LowerBound(const uint64_t row) const
+    {
+        return std::lower_bound(_placements.begin(), _placements.end(), row, [](const Placement& placement, const uint64_t row) {
+            return placement.row < row;
+        });
+    }
+
+    std::deque<Placement> _placements;
+    // the height of the tallest image placed so far, in rows, so that
+    // ForEach knows how far up to look for images reaching into its rows
+    uint64_t _tallest{ 0 };
+};
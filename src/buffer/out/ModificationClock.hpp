@@ -0,0 +1,35 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ModificationClock.hpp
+
+Abstract:
+- Hands out the generations in which the rows of a TextBuffer are modified.
+- Every modification of a row stamps it with a new generation of the buffer's
+  clock, so generations increase monotonically across all rows of the buffer and
+  "has this row changed since generation X" is a single comparison.
+
+--*/
+
+#pragma once
+
+class ModificationClock final
+{
+public:
+    // The generation of the most recent modification.
+    uint64_t Now() const noexcept
+    {
+        return _now;
+    }
+
+    // Returns a new generation for a modification that is being made.
+    uint64_t Tick() noexcept
+    {
+        return ++_now;
+    }
+
+private:
+    uint64_t _now{ 0 };
+};
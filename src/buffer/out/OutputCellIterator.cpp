@@ -7,6 +7,7 @@
 
 #include "../../types/inc/convert.hpp"
 #include "../../types/inc/Utf16Parser.hpp"
+#include "../../types/inc/GraphemeSegmenter.hpp"
 #include "../../types/inc/GlyphWidth.hpp"
 #include "../../inc/conattrs.hpp"
 
@@ -307,6 +308,100 @@ OutputCellIterator OutputCellIterator::operator++(int)
     return temp;
 }
 
+// Routine Description:
+// - Finds the run of cells ahead of the iterator that can be consumed as a whole, see Run.
+// - Text given with a single attribute (or none at all) runs up to the first surrogate or wide glyph,
+//   or the first character that might join those around it into a grapheme cluster.
+//   Fills of a narrow glyph run up to their limit. Any other source yields single cells,
+//   since every one of them may carry an attribute of its own.
+// Arguments:
+// - maxLength - the longest run the caller is interested in
+// Return Value:
+// - The run, of length 0 if the next cell has to be consumed on its own.
+OutputCellIterator::Run OutputCellIterator::PeekRun(const size_t maxLength) const
+{
+    if (!operator bool() || !_currentView.DbcsAttr().IsSingle())
+    {
+        return {};
+    }
+
+    switch (_mode)
+    {
+    case Mode::Loose:
+    case Mode::LooseTextOnly:
+    {
+        const auto text = std::get<std::wstring_view>(_run).substr(_pos, maxLength);
+        const auto end = std::find_if(text.begin(), text.end(), [](const wchar_t wch) {
+            if (wch < 0x80)
+            {
+                return false;
+            }
+            return Utf16Parser::IsLeadingSurrogate(wch) || Utf16Parser::IsTrailingSurrogate(wch) || IsGlyphFullWidth(wch) ||
+                   GraphemeSegmenter::GetProperty(wch) != GraphemeSegmenter::Property::Other;
+        });
+        auto length = gsl::narrow_cast<size_t>(end - text.begin());
+
+        // What stopped the run might be a combining mark (or the like) which
+        // belongs in the same cell as the character before it.
+        if (length != 0 && end != text.end() && GraphemeSegmenter::ParseNext(text.substr(length - 1)).size() != 1)
+        {
+            --length;
+        }
+        return { length, text.substr(0, length) };
+    }
+    case Mode::Fill:
+    {
+        // A fill that only stores the attribute doesn't care about the glyph.
+        if (_currentView.TextAttrBehavior() != TextAttributeBehavior::StoredOnly && _currentView.Chars().size() != 1)
+        {
+            return {};
+        }
+        return { _fillLimit > 0 ? std::min(maxLength, _fillLimit - _pos) : maxLength, {} };
+    }
+    default:
+        return {};
+    }
+}
+
+// Routine Description:
+// - Advances the iterator over a run previously returned by PeekRun().
+// - This is equivalent to calling operator++ length times.
+// Arguments:
+// - length - the number of cells to skip, at most the length of the run
+// Return Value:
+// - <none>
+void OutputCellIterator::AdvanceRun(const size_t length)
+{
+    switch (_mode)
+    {
+    case Mode::Loose:
+    case Mode::LooseTextOnly:
+    {
+        _distance += length;
+        _pos += length;
+        if (operator bool())
+        {
+            const auto text = std::get<std::wstring_view>(_run).substr(_pos);
+            _currentView = _mode == Mode::Loose ? s_GenerateView(text, _attr) : s_GenerateView(text);
+        }
+        break;
+    }
+    case Mode::Fill:
+    {
+        // The view of a narrow fill never changes, only its limit is counted down.
+        _distance += length;
+        if (_fillLimit > 0)
+        {
+            _pos += length;
+        }
+        break;
+    }
+    default:
+        // PeekRun() doesn't return runs for any other mode.
+        THROW_HR_IF(E_INVALIDARG, length > 0);
+    }
+}
+
 // Routine Description:
 // - Reference the view to fully-formed output cell data representing the underlying data source.
 // Return Value:
@@ -398,7 +493,15 @@ OutputCellView OutputCellIterator::s_GenerateView(const std::wstring_view view,
                                                   const TextAttribute attr,
                                                   const TextAttributeBehavior behavior)
 {
-    const auto glyph = Utf16Parser::ParseNext(view);
+    // A whole grapheme cluster goes into a single cell (or two, if it's wide), so that combining
+    // marks, emoji sequences and flags stay with what they belong to.
+    // An unpaired surrogate is skipped over, the way Utf16Parser always did.
+    auto glyph = GraphemeSegmenter::ParseNext(view);
+    if (glyph.size() == 1 && (Utf16Parser::IsLeadingSurrogate(glyph.front()) || Utf16Parser::IsTrailingSurrogate(glyph.front())))
+    {
+        glyph = Utf16Parser::ParseNext(view);
+    }
+
     DbcsAttribute dbcsAttr;
     if (IsGlyphFullWidth(glyph))
     {
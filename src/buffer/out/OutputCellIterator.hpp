@@ -55,6 +55,17 @@ public:
     OutputCellIterator& operator++();
     OutputCellIterator operator++(int);
 
+    // A run of narrow cells ahead of the iterator, which all share the
+    // TextAttr(), TextAttrBehavior() and single DbcsAttr() of the current view.
+    struct Run
+    {
+        size_t length; // the number of cells in the run
+        std::wstring_view text; // one character per cell, or empty if every cell repeats the current view's glyph
+    };
+
+    Run PeekRun(const size_t maxLength) const;
+    void AdvanceRun(const size_t length);
+
     const OutputCellView& operator*() const noexcept;
     const OutputCellView* operator->() const noexcept;
 
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "PackedRowStore.hpp"
+#include "BufferMemoryUsage.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Finds the payload holding the given cells, or creates one if there's none yet.
+// Arguments:
+// - cells - the cells of the row to pack
+// Return Value:
+// - the payload, which may be shared with other rows
+std::shared_ptr<const PackedRowStore::Cells> PackedRowStore::Intern(const gsl::span<const CharRowCell> cells)
+{
+    const auto hash = _Hash(cells);
+    const auto [begin, end] = _cells.equal_range(hash);
+    for (auto it = begin; it != end; ++it)
+    {
+        if (auto payload = it->second.lock(); payload && _Equal(cells, *payload))
+        {
+            return payload;
+        }
+    }
+
+    auto payload = std::make_shared<const Cells>(cells.begin(), cells.end());
+    _cells.emplace(hash, payload);
+    return payload;
+}
+
+// Routine Description:
+// - Drops the entries of the payloads which aren't used by any row anymore.
+void PackedRowStore::Prune() noexcept
+{
+    for (auto it = _cells.begin(); it != _cells.end();)
+    {
+        it = it->second.expired() ? _cells.erase(it) : std::next(it);
+    }
+}
+
+// Routine Description:
+// - Gets the number of payloads in the store, including the ones that wait for Prune().
+size_t PackedRowStore::size() const noexcept
+{
+    return _cells.size();
+}
+
+// Routine Description:
+// - Estimates the memory used by the store itself. The payloads are accounted
+//   for by the rows which share them, see ROW::AddMemoryUsage.
+size_t PackedRowStore::GetMemoryUsage() const noexcept
+{
+    return BufferMemoryUsage::OfMap(_cells);
+}
+
+size_t PackedRowStore::_Hash(const gsl::span<const CharRowCell> cells) noexcept
+{
+    // FNV-1a over the glyph and the DBCS attribute of every cell.
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto& cell : cells)
+    {
+        const auto& attr = cell.DbcsAttr();
+        const uint32_t value = cell.Char() |
+                               (attr.IsLeading() ? 1u << 16 : 0) |
+                               (attr.IsTrailing() ? 1u << 17 : 0) |
+                               (attr.IsGlyphStored() ? 1u << 18 : 0);
+        hash = (hash ^ value) * 1099511628211ull;
+    }
+    return gsl::narrow_cast<size_t>(hash);
+}
+
+bool PackedRowStore::_Equal(const gsl::span<const CharRowCell> a, const Cells& b) noexcept
+{
+    // Unlike operator== of the cells, this tells apart whether the glyph of a cell is stored
+    // in the UnicodeStorage of the row, as rows which share cells only share that flag.
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const CharRowCell& x, const CharRowCell& y) noexcept {
+        return x == y && x.DbcsAttr().IsGlyphStored() == y.DbcsAttr().IsGlyphStored();
+    });
+}
@@ -0,0 +1,39 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PackedRowStore.hpp
+
+Abstract:
+- Shares the cells of packed rows (see ROW::Pack) between all the rows with
+  the same glyphs, so that repetitive scrollback, like separators or the same
+  warning over and over, only keeps its cells once.
+- The cells are handed out as immutable, reference counted payloads, found by
+  their hash. A row is always unpacked before it's changed, which copies its
+  cells back into the row and lets go of the payload, so a shared payload is
+  never written to. Payloads nobody refers to anymore are dropped by Prune().
+--*/
+
+#pragma once
+
+#include "CharRowCell.hpp"
+
+class PackedRowStore final
+{
+public:
+    using Cells = std::vector<CharRowCell>;
+
+    std::shared_ptr<const Cells> Intern(const gsl::span<const CharRowCell> cells);
+    void Prune() noexcept;
+    size_t size() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    static size_t _Hash(const gsl::span<const CharRowCell> cells) noexcept;
+    static bool _Equal(const gsl::span<const CharRowCell> a, const Cells& b) noexcept;
+
+    // The payloads by their hash. The rows own them, so that a payload goes away
+    // along with its last row, and only its entry in here is left for Prune().
+    std::unordered_multimap<size_t, std::weak_ptr<const Cells>> _cells;
+};
@@ -0,0 +1,1033 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "PatternMatcher.hpp"
+#include "BufferMemoryUsage.hpp"
+
+#pragma hdrstop
+
+static constexpr bool s_IsWordChar(const wchar_t wch) noexcept
+{
+    return (wch >= L'0' && wch <= L'9') || (wch >= L'A' && wch <= L'Z') || (wch >= L'a' && wch <= L'z') || wch == L'_';
+}
+
+static constexpr std::pair<wchar_t, wchar_t> s_WordRanges[]{
+    { L'0', L'9' },
+    { L'A', L'Z' },
+    { L'_', L'_' },
+    { L'a', L'z' },
+};
+
+// The characters matched by \s, as defined by ECMAScript.
+static constexpr std::pair<wchar_t, wchar_t> s_SpaceRanges[]{
+    { L'\t', L'\r' },
+    { L' ', L' ' },
+    { 0x00A0, 0x00A0 },
+    { 0x1680, 0x1680 },
+    { 0x2000, 0x200A },
+    { 0x2028, 0x2029 },
+    { 0x202F, 0x202F },
+    { 0x205F, 0x205F },
+    { 0x3000, 0x3000 },
+    { 0xFEFF, 0xFEFF },
+};
+
+// The characters that aren't matched by ".", as defined by ECMAScript.
+static constexpr std::pair<wchar_t, wchar_t> s_LineTerminatorRanges[]{
+    { L'\n', L'\n' },
+    { L'\r', L'\r' },
+    { 0x2028, 0x2029 },
+};
+
+// Routine Description:
+// - Sorts the given ranges and merges the ones that overlap or touch
+static void s_Normalize(std::vector<std::pair<wchar_t, wchar_t>>& ranges)
+{
+    std::sort(ranges.begin(), ranges.end());
+
+    size_t count = 0;
+    for (const auto& range : ranges)
+    {
+        if (count != 0 && static_cast<uint32_t>(range.first) <= static_cast<uint32_t>(til::at(ranges, count - 1).second) + 1)
+        {
+            auto& last = til::at(ranges, count - 1);
+            last.second = std::max(last.second, range.second);
+        }
+        else
+        {
+            til::at(ranges, count++) = range;
+        }
+    }
+    ranges.resize(count);
+}
+
+// Routine Description:
+// - Turns normalized ranges into the ranges of every character they don't contain
+static std::vector<std::pair<wchar_t, wchar_t>> s_Complement(const std::vector<std::pair<wchar_t, wchar_t>>& ranges)
+{
+    std::vector<std::pair<wchar_t, wchar_t>> result;
+    uint32_t next = 0;
+    for (const auto& range : ranges)
+    {
+        if (static_cast<uint32_t>(range.first) > next)
+        {
+            result.emplace_back(gsl::narrow_cast<wchar_t>(next), gsl::narrow_cast<wchar_t>(range.first - 1));
+        }
+        next = static_cast<uint32_t>(range.second) + 1;
+    }
+    if (next <= 0xFFFF)
+    {
+        result.emplace_back(gsl::narrow_cast<wchar_t>(next), gsl::narrow_cast<wchar_t>(0xFFFF));
+    }
+    return result;
+}
+
+static bool s_Contains(const std::vector<std::pair<wchar_t, wchar_t>>& ranges, const wchar_t wch) noexcept
+{
+    const auto it = std::upper_bound(ranges.cbegin(), ranges.cend(), wch, [](const wchar_t value, const auto& range) noexcept {
+        return value < range.first;
+    });
+    return it != ranges.cbegin() && wch <= (it - 1)->second;
+}
+
+// Routine Description:
+// - Adds the other case of every character in the ranges to them, so that a
+//   pattern that ignores case doesn't need the text to be folded first.
+static void s_FoldCase(std::vector<std::pair<wchar_t, wchar_t>>& ranges)
+{
+    const auto count = ranges.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto [first, last] = til::at(ranges, i);
+        for (auto wch = static_cast<uint32_t>(first); wch <= static_cast<uint32_t>(last); ++wch)
+        {
+            const auto lower = ::towlower(static_cast<wint_t>(wch));
+            const auto upper = ::towupper(static_cast<wint_t>(wch));
+            if (lower != wch)
+            {
+                ranges.emplace_back(gsl::narrow_cast<wchar_t>(lower), gsl::narrow_cast<wchar_t>(lower));
+            }
+            if (upper != wch)
+            {
+                ranges.emplace_back(gsl::narrow_cast<wchar_t>(upper), gsl::narrow_cast<wchar_t>(upper));
+            }
+        }
+    }
+    s_Normalize(ranges);
+}
+
+// Recursive descent parser turning a pattern into a tree of Nodes.
+class PatternMatcher::Parser final
+{
+public:
+    Parser(PatternMatcher& matcher, const std::wstring_view pattern, const bool ignoreCase) noexcept :
+        _matcher{ matcher },
+        _pattern{ pattern },
+        _pos{ 0 },
+        _ignoreCase{ ignoreCase }
+    {
+    }
+
+    Node Parse()
+    {
+        auto node = _ParseAlternation();
+        // the only way to stop early is an unbalanced ")"
+        THROW_HR_IF(E_INVALIDARG, _pos != _pattern.size());
+        return node;
+    }
+
+private:
+    PatternMatcher& _matcher;
+    const std::wstring_view _pattern;
+    size_t _pos;
+    const bool _ignoreCase;
+
+    bool _AtEnd() const noexcept
+    {
+        return _pos >= _pattern.size();
+    }
+
+    wchar_t _Peek() const noexcept
+    {
+        return _AtEnd() ? L'\0' : til::at(_pattern, _pos);
+    }
+
+    wchar_t _Next()
+    {
+        THROW_HR_IF(E_INVALIDARG, _AtEnd());
+        return til::at(_pattern, _pos++);
+    }
+
+    bool _Eat(const wchar_t wch) noexcept
+    {
+        if (!_AtEnd() && _Peek() == wch)
+        {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    static Node _MakeNode(const Node::Kind kind) noexcept
+    {
+        Node node;
+        node.kind = kind;
+        return node;
+    }
+
+    Node _MakeSet(CharRanges ranges)
+    {
+        auto node = _MakeNode(Node::Kind::Set);
+        node.arg = _matcher._AddSet(std::move(ranges));
+        return node;
+    }
+
+    Node _ParseAlternation()
+    {
+        auto node = _MakeNode(Node::Kind::Alternate);
+        node.children.push_back(_ParseConcat());
+        while (_Eat(L'|'))
+        {
+            node.children.push_back(_ParseConcat());
+        }
+
+        if (node.children.size() == 1)
+        {
+            return std::move(node.children.front());
+        }
+        return node;
+    }
+
+    Node _ParseConcat()
+    {
+        auto node = _MakeNode(Node::Kind::Concat);
+        while (!_AtEnd() && _Peek() != L'|' && _Peek() != L')')
+        {
+            node.children.push_back(_ParseRepeat());
+        }
+
+        if (node.children.empty())
+        {
+            return _MakeNode(Node::Kind::Empty);
+        }
+        if (node.children.size() == 1)
+        {
+            return std::move(node.children.front());
+        }
+        return node;
+    }
+
+    Node _ParseRepeat()
+    {
+        auto atom = _ParseAtom();
+
+        uint32_t min = 0;
+        uint32_t max = 0;
+        if (_Eat(L'*'))
+        {
+            min = 0;
+            max = s_None;
+        }
+        else if (_Eat(L'+'))
+        {
+            min = 1;
+            max = s_None;
+        }
+        else if (_Eat(L'?'))
+        {
+            min = 0;
+            max = 1;
+        }
+        else if (_Eat(L'{'))
+        {
+            min = _ParseNumber();
+            max = min;
+            if (_Eat(L','))
+            {
+                max = _Peek() == L'}' ? s_None : _ParseNumber();
+            }
+            THROW_HR_IF(E_INVALIDARG, !_Eat(L'}'));
+            THROW_HR_IF(E_INVALIDARG, max < min);
+        }
+        else
+        {
+            return atom;
+        }
+
+        // Lazy quantifiers ("*?") only make sense for backtracking engines
+        // and repeated quantifiers ("a**") aren't valid ECMAScript either.
+        const auto next = _Peek();
+        THROW_HR_IF(E_INVALIDARG, next == L'?' || next == L'*' || next == L'+' || next == L'{');
+
+        auto node = _MakeNode(Node::Kind::Repeat);
+        node.min = min;
+        node.max = max;
+        node.children.push_back(std::move(atom));
+        return node;
+    }
+
+    uint32_t _ParseNumber()
+    {
+        uint32_t value = 0;
+        auto digits = 0;
+        while (_Peek() >= L'0' && _Peek() <= L'9')
+        {
+            value = value * 10 + static_cast<uint32_t>(_Next() - L'0');
+            THROW_HR_IF(E_INVALIDARG, value > s_MaxRepeat);
+            ++digits;
+        }
+        THROW_HR_IF(E_INVALIDARG, digits == 0);
+        return value;
+    }
+
+    Node _ParseAtom()
+    {
+        const auto wch = _Next();
+        switch (wch)
+        {
+        case L'(':
+        {
+            if (_Eat(L'?'))
+            {
+                // only non-capturing groups, no lookarounds
+                THROW_HR_IF(E_INVALIDARG, !_Eat(L':'));
+            }
+            auto node = _ParseAlternation();
+            THROW_HR_IF(E_INVALIDARG, !_Eat(L')'));
+            return node;
+        }
+        case L'[':
+            return _MakeSet(_ParseClass());
+        case L'.':
+        {
+            CharRanges ranges{ std::begin(s_LineTerminatorRanges), std::end(s_LineTerminatorRanges) };
+            return _MakeSet(s_Complement(ranges));
+        }
+        case L'\\':
+        {
+            const auto escaped = _Next();
+            if (escaped == L'b' || escaped == L'B')
+            {
+                auto node = _MakeNode(Node::Kind::WordBoundary);
+                node.arg = escaped == L'b' ? 1 : 0;
+                return node;
+            }
+
+            CharRanges ranges;
+            if (!_AppendClassEscape(escaped, ranges))
+            {
+                const auto literal = _ParseSingleEscape(escaped);
+                ranges.emplace_back(literal, literal);
+            }
+            return _MakeLiteralSet(std::move(ranges));
+        }
+        case L'^':
+        case L'$':
+        case L')':
+        case L'*':
+        case L'+':
+        case L'?':
+        case L'{':
+            THROW_HR(E_INVALIDARG);
+        default:
+            return _MakeLiteralSet({ { wch, wch } });
+        }
+    }
+
+    // Makes a set of the given literal characters, along with their other case if it's to be ignored.
+    Node _MakeLiteralSet(CharRanges ranges)
+    {
+        if (_ignoreCase)
+        {
+            s_FoldCase(ranges);
+        }
+        return _MakeSet(std::move(ranges));
+    }
+
+    CharRanges _ParseClass()
+    {
+        const auto negate = _Eat(L'^');
+
+        CharRanges ranges;
+        while (!_Eat(L']'))
+        {
+            const auto low = _ParseClassAtom(ranges);
+            if (low.has_value() && _Peek() == L'-' && _pos + 1 < _pattern.size() && til::at(_pattern, _pos + 1) != L']')
+            {
+                ++_pos;
+                const auto high = _ParseClassAtom(ranges);
+                THROW_HR_IF(E_INVALIDARG, !high.has_value() || high.value() < low.value());
+                ranges.emplace_back(low.value(), high.value());
+            }
+            else if (low.has_value())
+            {
+                ranges.emplace_back(low.value(), low.value());
+            }
+        }
+
+        s_Normalize(ranges);
+        // The case is folded before the class is negated, so that [^a] rejects "A" too.
+        if (_ignoreCase)
+        {
+            s_FoldCase(ranges);
+        }
+        return negate ? s_Complement(ranges) : ranges;
+    }
+
+    // Return Value:
+    // - the character, or nothing if the atom was a class escape (like \d) that was added to ranges
+    std::optional<wchar_t> _ParseClassAtom(CharRanges& ranges)
+    {
+        const auto wch = _Next();
+        if (wch != L'\\')
+        {
+            return wch;
+        }
+
+        const auto escaped = _Next();
+        if (_AppendClassEscape(escaped, ranges))
+        {
+            return std::nullopt;
+        }
+        // within a class \b stands for a backspace
+        return escaped == L'b' ? L'\b' : _ParseSingleEscape(escaped);
+    }
+
+    static bool _AppendClassEscape(const wchar_t escaped, CharRanges& ranges)
+    {
+        CharRanges escapeRanges;
+        switch (escaped)
+        {
+        case L'd':
+        case L'D':
+            escapeRanges.emplace_back(L'0', L'9');
+            break;
+        case L'w':
+        case L'W':
+            escapeRanges.assign(std::begin(s_WordRanges), std::end(s_WordRanges));
+            break;
+        case L's':
+        case L'S':
+            escapeRanges.assign(std::begin(s_SpaceRanges), std::end(s_SpaceRanges));
+            break;
+        default:
+            return false;
+        }
+
+        if (escaped == L'D' || escaped == L'W' || escaped == L'S')
+        {
+            escapeRanges = s_Complement(escapeRanges);
+        }
+        ranges.insert(ranges.end(), escapeRanges.cbegin(), escapeRanges.cend());
+        return true;
+    }
+
+    wchar_t _ParseSingleEscape(const wchar_t escaped)
+    {
+        switch (escaped)
+        {
+        case L't':
+            return L'\t';
+        case L'n':
+            return L'\n';
+        case L'r':
+            return L'\r';
+        case L'f':
+            return L'\f';
+        case L'v':
+            return L'\v';
+        case L'0':
+            // \01 and the like would be octal or a backreference
+            THROW_HR_IF(E_INVALIDARG, _Peek() >= L'0' && _Peek() <= L'9');
+            return L'\0';
+        case L'x':
+            return _ParseHex(2);
+        case L'u':
+            return _ParseHex(4);
+        default:
+            // backreferences and unknown escapes like \q
+            THROW_HR_IF(E_INVALIDARG, s_IsWordChar(escaped));
+            return escaped;
+        }
+    }
+
+    wchar_t _ParseHex(const size_t digits)
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < digits; ++i)
+        {
+            const auto wch = _Next();
+            uint32_t digit = 0;
+            if (wch >= L'0' && wch <= L'9')
+            {
+                digit = wch - L'0';
+            }
+            else if (wch >= L'a' && wch <= L'f')
+            {
+                digit = wch - L'a' + 10;
+            }
+            else if (wch >= L'A' && wch <= L'F')
+            {
+                digit = wch - L'A' + 10;
+            }
+            else
+            {
+                THROW_HR(E_INVALIDARG);
+            }
+            value = value * 16 + digit;
+        }
+        return gsl::narrow_cast<wchar_t>(value);
+    }
+};
+
+// Routine Description:
+// - Compiles a pattern and adds it to the set of patterns to search for
+// Arguments:
+// - id - the value to report with the matches of this pattern
+// - pattern - the regular expression, see PatternMatcher.hpp for the supported syntax
+// Return Value:
+// - <none>
+// Note: throws E_INVALIDARG if the pattern can't be parsed, leaving the matcher unchanged
+void PatternMatcher::AddPattern(const size_t id, const std::wstring_view pattern, const bool ignoreCase)
+{
+    const auto nfaSize = _nfa.size();
+    const auto setsSize = _sets.size();
+    try
+    {
+        _ids.reserve(_ids.size() + 1);
+        _starts.reserve(_starts.size() + 1);
+
+        Parser parser{ *this, pattern, ignoreCase };
+        const auto root = parser.Parse();
+        const auto match = _AddState(NfaType::Match, gsl::narrow<uint32_t>(_ids.size()), s_None, s_None);
+        const auto start = _Compile(root, match);
+
+        _starts.push_back(start);
+        _ids.push_back(id);
+
+        _BuildAlphabet();
+    }
+    catch (...)
+    {
+        _nfa.resize(nfaSize);
+        _sets.resize(setsSize);
+        _starts.resize(_ids.size());
+        throw;
+    }
+}
+
+// Routine Description:
+// - Removes all patterns
+void PatternMatcher::Clear() noexcept
+{
+    _ids.clear();
+    _starts.clear();
+    _nfa.clear();
+    _sets.clear();
+    _boundaries.clear();
+    _asciiSymbols.fill(0);
+    _symbolIsWord.clear();
+    _setContains.clear();
+    _combined = {};
+    _unanchored.clear();
+    _anchored.clear();
+    _acceptSets.clear();
+    _acceptSetIndex.clear();
+}
+
+bool PatternMatcher::empty() const noexcept
+{
+    return _ids.empty();
+}
+
+// Routine Description:
+// - Estimates the heap memory used by the compiled patterns and the DFAs built so far.
+// Return Value:
+// - the size in bytes
+size_t PatternMatcher::GetMemoryUsage() const noexcept
+{
+    // Every node of a std::map holds three pointers and a color next to its value.
+    static constexpr size_t mapNodeOverhead = 4 * sizeof(void*);
+
+    const auto ofDfa = [](const Dfa& dfa) noexcept {
+        auto bytes = BufferMemoryUsage::Of(dfa.starts) + BufferMemoryUsage::Of(dfa.states);
+        for (const auto& state : dfa.states)
+        {
+            // The index holds a copy of every kernel.
+            bytes += 2 * BufferMemoryUsage::Of(state.kernel) + BufferMemoryUsage::Of(state.transitions);
+        }
+        return bytes + dfa.index.size() * (sizeof(decltype(dfa.index)::value_type) + mapNodeOverhead);
+    };
+
+    auto bytes = BufferMemoryUsage::Of(_ids) +
+                 BufferMemoryUsage::Of(_starts) +
+                 BufferMemoryUsage::Of(_nfa) +
+                 BufferMemoryUsage::Of(_sets) +
+                 BufferMemoryUsage::Of(_boundaries) +
+                 _symbolIsWord.capacity() / 8 +
+                 _setContains.capacity() / 8 +
+                 ofDfa(_combined) +
+                 BufferMemoryUsage::Of(_unanchored) +
+                 BufferMemoryUsage::Of(_anchored) +
+                 BufferMemoryUsage::Of(_acceptSets);
+    for (const auto& set : _sets)
+    {
+        bytes += BufferMemoryUsage::Of(set);
+    }
+    for (const auto& dfa : _unanchored)
+    {
+        bytes += ofDfa(dfa);
+    }
+    for (const auto& dfa : _anchored)
+    {
+        bytes += ofDfa(dfa);
+    }
+    for (const auto& acceptSet : _acceptSets)
+    {
+        // The index holds a copy of every accept set.
+        bytes += 2 * BufferMemoryUsage::Of(acceptSet);
+    }
+    return bytes + _acceptSetIndex.size() * (sizeof(decltype(_acceptSetIndex)::value_type) + mapNodeOverhead);
+}
+
+// Routine Description:
+// - Finds the matches of all patterns in the given text
+// Arguments:
+// - text - the text to search
+// Return Value:
+// - the matches sorted by their start
+std::vector<PatternMatcher::Match> PatternMatcher::FindAll(const std::wstring_view text) const
+{
+    std::vector<Match> matches;
+    if (_ids.empty())
+    {
+        return matches;
+    }
+
+    // First, a single pass with all patterns combined to find out which of them match at all.
+    std::vector<bool> found(_ids.size());
+    auto markFound = [&](const uint32_t acceptSet) {
+        for (const auto pattern : til::at(_acceptSets, acceptSet))
+        {
+            found.at(pattern) = true;
+        }
+    };
+
+    auto state = _StartState(_combined, false);
+    uint32_t lastAcceptSet = 0;
+    for (const auto wch : text)
+    {
+        const auto acceptSet = _Step(_combined, state, _SymbolOf(wch));
+        if (acceptSet != 0 && acceptSet != lastAcceptSet)
+        {
+            markFound(acceptSet);
+            lastAcceptSet = acceptSet;
+        }
+    }
+    markFound(_Step(_combined, state, _EndSymbol()));
+
+    // Then locate the matches of the patterns that were found, one pattern at a time.
+    for (size_t pattern = 0; pattern < _ids.size(); ++pattern)
+    {
+        if (!found.at(pattern))
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        while (offset <= text.size())
+        {
+            // The leftmost match doesn't necessarily end first, but it has to start
+            // no later than the end of the match that ends first.
+            const auto earliestEnd = _FindEarliestEnd(pattern, text, offset);
+            if (earliestEnd == std::wstring_view::npos)
+            {
+                break;
+            }
+
+            auto matched = false;
+            for (auto start = offset; start <= earliestEnd; ++start)
+            {
+                const auto end = _FindLongestAt(pattern, text, start);
+                // empty matches aren't of any use to us
+                if (end != std::wstring_view::npos && end > start)
+                {
+                    matches.push_back({ start, end, _ids.at(pattern) });
+                    offset = end;
+                    matched = true;
+                    break;
+                }
+            }
+
+            if (!matched)
+            {
+                offset = earliestEnd + 1;
+            }
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const Match& lhs, const Match& rhs) noexcept {
+        return lhs.start < rhs.start || (lhs.start == rhs.start && lhs.id < rhs.id);
+    });
+    return matches;
+}
+
+uint32_t PatternMatcher::_AddSet(CharRanges ranges)
+{
+    s_Normalize(ranges);
+    _sets.push_back(std::move(ranges));
+    return gsl::narrow<uint32_t>(_sets.size() - 1);
+}
+
+uint32_t PatternMatcher::_AddState(const NfaType type, const uint32_t arg, const uint32_t out, const uint32_t out1)
+{
+    // bounded repetition copies its operand, so "(a{1000}){1000}" would get out of hand
+    THROW_HR_IF(E_INVALIDARG, _nfa.size() >= s_MaxNfaStates);
+    _nfa.push_back({ type, arg, out, out1 });
+    return gsl::narrow<uint32_t>(_nfa.size() - 1);
+}
+
+// Routine Description:
+// - Turns a node into NFA states, back to front
+// Arguments:
+// - node - the node to compile
+// - next - the state to continue at once the node matched
+// Return Value:
+// - the state at which the node starts
+uint32_t PatternMatcher::_Compile(const Node& node, const uint32_t next)
+{
+    switch (node.kind)
+    {
+    case Node::Kind::Empty:
+        return next;
+    case Node::Kind::Set:
+        return _AddState(NfaType::Char, node.arg, next, s_None);
+    case Node::Kind::WordBoundary:
+        return _AddState(NfaType::WordBoundary, node.arg, next, s_None);
+    case Node::Kind::Concat:
+    {
+        auto current = next;
+        for (auto it = node.children.crbegin(); it != node.children.crend(); ++it)
+        {
+            current = _Compile(*it, current);
+        }
+        return current;
+    }
+    case Node::Kind::Alternate:
+    {
+        auto current = _Compile(node.children.back(), next);
+        for (auto it = node.children.crbegin() + 1; it != node.children.crend(); ++it)
+        {
+            current = _AddState(NfaType::Split, 0, _Compile(*it, next), current);
+        }
+        return current;
+    }
+    case Node::Kind::Repeat:
+    {
+        const auto& child = node.children.front();
+        auto current = next;
+        if (node.max == s_None)
+        {
+            const auto loop = _AddState(NfaType::Split, 0, s_None, next);
+            const auto body = _Compile(child, loop);
+            til::at(_nfa, loop).out = body;
+            current = loop;
+        }
+        else
+        {
+            // each optional copy may be skipped straight to next
+            for (auto i = node.min; i < node.max; ++i)
+            {
+                current = _AddState(NfaType::Split, 0, _Compile(child, current), next);
+            }
+        }
+        for (uint32_t i = 0; i < node.min; ++i)
+        {
+            current = _Compile(child, current);
+        }
+        return current;
+    }
+    default:
+        THROW_HR(E_UNEXPECTED);
+    }
+}
+
+// Routine Description:
+// - Splits the characters into the classes of characters that no pattern can tell apart
+//   and drops all DFAs built so far, since their transitions are in terms of those classes.
+void PatternMatcher::_BuildAlphabet()
+{
+    std::vector<wchar_t> boundaries;
+    auto addRange = [&](const std::pair<wchar_t, wchar_t>& range) {
+        boundaries.push_back(range.first);
+        if (range.second < 0xFFFF)
+        {
+            boundaries.push_back(gsl::narrow_cast<wchar_t>(range.second + 1));
+        }
+    };
+    for (const auto& set : _sets)
+    {
+        std::for_each(set.cbegin(), set.cend(), addRange);
+    }
+    // \b needs to tell word characters apart
+    std::for_each(std::begin(s_WordRanges), std::end(s_WordRanges), addRange);
+
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+    if (!boundaries.empty() && boundaries.front() == 0)
+    {
+        boundaries.erase(boundaries.begin());
+    }
+    // the symbols are 16 bit and one more is needed for the end of the text
+    THROW_HR_IF(E_INVALIDARG, boundaries.size() + 2 > std::numeric_limits<symbol_type>::max());
+    _boundaries = std::move(boundaries);
+
+    for (size_t i = 0; i < _asciiSymbols.size(); ++i)
+    {
+        const auto it = std::upper_bound(_boundaries.cbegin(), _boundaries.cend(), gsl::narrow_cast<wchar_t>(i));
+        til::at(_asciiSymbols, i) = gsl::narrow_cast<symbol_type>(it - _boundaries.cbegin());
+    }
+
+    const size_t symbols = _EndSymbol();
+    _symbolIsWord.assign(symbols, false);
+    _setContains.assign(_sets.size() * symbols, false);
+    for (size_t symbol = 0; symbol < symbols; ++symbol)
+    {
+        // every character of a symbol behaves the same, so its first one stands in for all of them
+        const auto representative = symbol == 0 ? L'\0' : til::at(_boundaries, symbol - 1);
+        _symbolIsWord.at(symbol) = s_IsWordChar(representative);
+        for (size_t set = 0; set < _sets.size(); ++set)
+        {
+            _setContains.at(set * symbols + symbol) = s_Contains(til::at(_sets, set), representative);
+        }
+    }
+
+    _combined = _NewDfa(_starts, true);
+    _unanchored.clear();
+    _unanchored.resize(_ids.size());
+    _anchored.clear();
+    _anchored.resize(_ids.size());
+    _acceptSets.assign(1, {});
+    _acceptSetIndex.clear();
+    _acceptSetIndex.emplace(std::vector<uint32_t>{}, 0);
+}
+
+PatternMatcher::symbol_type PatternMatcher::_SymbolOf(const wchar_t wch) const noexcept
+{
+    if (static_cast<size_t>(wch) < _asciiSymbols.size())
+    {
+        return til::at(_asciiSymbols, wch);
+    }
+    const auto it = std::upper_bound(_boundaries.cbegin(), _boundaries.cend(), wch);
+    return gsl::narrow_cast<symbol_type>(it - _boundaries.cbegin());
+}
+
+PatternMatcher::symbol_type PatternMatcher::_EndSymbol() const noexcept
+{
+    return gsl::narrow_cast<symbol_type>(_boundaries.size() + 1);
+}
+
+PatternMatcher::Dfa PatternMatcher::_NewDfa(std::vector<uint32_t> starts, const bool unanchored) const
+{
+    Dfa dfa;
+    dfa.starts = std::move(starts);
+    dfa.unanchored = unanchored;
+    return dfa;
+}
+
+uint32_t PatternMatcher::_StartState(Dfa& dfa, const bool prevWord) const
+{
+    return _FindState(dfa, {}, prevWord, true);
+}
+
+// Routine Description:
+// - Finds the DFA state for the given set of NFA states, creating it if needed
+uint32_t PatternMatcher::_FindState(Dfa& dfa, std::vector<uint32_t> kernel, const bool prevWord, const bool inject) const
+{
+    auto key = std::make_tuple(std::move(kernel), prevWord, inject);
+    const auto it = dfa.index.find(key);
+    if (it != dfa.index.end())
+    {
+        return it->second;
+    }
+
+    DfaState state;
+    state.kernel = std::get<0>(key);
+    state.prevWord = prevWord;
+    state.inject = inject;
+    state.dead = state.kernel.empty() && !inject && !dfa.unanchored;
+    state.transitions.assign(static_cast<size_t>(_EndSymbol()) + 1, { s_None, 0 });
+
+    const auto index = gsl::narrow<uint32_t>(dfa.states.size());
+    dfa.states.push_back(std::move(state));
+    dfa.index.emplace(std::move(key), index);
+    return index;
+}
+
+// Routine Description:
+// - Advances a DFA by one symbol, computing the transition if it isn't known yet
+// Arguments:
+// - dfa - the DFA to advance
+// - state - the current state, updated to the next one
+// - symbol - the symbol of the next character, or _EndSymbol() at the end of the text
+// Return Value:
+// - the id of the set of patterns with a match ending right before the symbol (0 if none)
+uint32_t PatternMatcher::_Step(Dfa& dfa, uint32_t& state, const symbol_type symbol) const
+{
+    {
+        const auto& cached = til::at(til::at(dfa.states, state).transitions, symbol);
+        if (cached.first != s_None)
+        {
+            state = cached.first;
+            return cached.second;
+        }
+    }
+
+    const auto symbols = static_cast<size_t>(_EndSymbol());
+    const auto atEnd = symbol == symbols;
+    const auto nextWord = !atEnd && _symbolIsWord.at(symbol);
+
+    std::vector<uint32_t> pending{ dfa.states.at(state).kernel };
+    if (dfa.unanchored || dfa.states.at(state).inject)
+    {
+        pending.insert(pending.end(), dfa.starts.cbegin(), dfa.starts.cend());
+    }
+    const auto prevWord = dfa.states.at(state).prevWord;
+
+    // Follow everything that doesn't consume a character, now that we know the characters
+    // on both sides, and collect the states that consume the next one.
+    std::vector<bool> visited(_nfa.size());
+    std::vector<uint32_t> kernel;
+    std::vector<uint32_t> accepted;
+    while (!pending.empty())
+    {
+        const auto index = pending.back();
+        pending.pop_back();
+        if (visited.at(index))
+        {
+            continue;
+        }
+        visited.at(index) = true;
+
+        const auto& nfaState = _nfa.at(index);
+        switch (nfaState.type)
+        {
+        case NfaType::Char:
+            if (!atEnd && _setContains.at(nfaState.arg * symbols + symbol))
+            {
+                kernel.push_back(nfaState.out);
+            }
+            break;
+        case NfaType::Split:
+            pending.push_back(nfaState.out1);
+            pending.push_back(nfaState.out);
+            break;
+        case NfaType::WordBoundary:
+            if ((prevWord != nextWord) == (nfaState.arg == 1))
+            {
+                pending.push_back(nfaState.out);
+            }
+            break;
+        case NfaType::Match:
+            accepted.push_back(nfaState.arg);
+            break;
+        }
+    }
+
+    std::sort(kernel.begin(), kernel.end());
+    kernel.erase(std::unique(kernel.begin(), kernel.end()), kernel.end());
+    std::sort(accepted.begin(), accepted.end());
+    accepted.erase(std::unique(accepted.begin(), accepted.end()), accepted.end());
+    const auto acceptSet = _AcceptSetId(std::move(accepted));
+
+    // Keep the memory bounded for pathological patterns by starting over,
+    // keeping only the state we're currently in.
+    if (dfa.states.size() >= s_MaxDfaStates)
+    {
+        auto current = std::move(dfa.states.at(state));
+        dfa.states.clear();
+        dfa.index.clear();
+        state = _FindState(dfa, std::move(current.kernel), current.prevWord, current.inject);
+    }
+
+    const auto next = _FindState(dfa, std::move(kernel), nextWord, false);
+    til::at(dfa.states.at(state).transitions, symbol) = { next, acceptSet };
+    state = next;
+    return acceptSet;
+}
+
+uint32_t PatternMatcher::_AcceptSetId(std::vector<uint32_t> patterns) const
+{
+    const auto it = _acceptSetIndex.find(patterns);
+    if (it != _acceptSetIndex.end())
+    {
+        return it->second;
+    }
+
+    const auto id = gsl::narrow<uint32_t>(_acceptSets.size());
+    _acceptSets.push_back(patterns);
+    _acceptSetIndex.emplace(std::move(patterns), id);
+    return id;
+}
+
+// Routine Description:
+// - Finds where the first match of a pattern that starts at or after offset ends
+// Return Value:
+// - the end of the match, or npos if there is none
+size_t PatternMatcher::_FindEarliestEnd(const size_t pattern, const std::wstring_view text, const size_t offset) const
+{
+    auto& dfa = _unanchored.at(pattern);
+    if (dfa.starts.empty())
+    {
+        dfa = _NewDfa({ _starts.at(pattern) }, true);
+    }
+
+    auto state = _StartState(dfa, offset != 0 && _IsWordAt(text, offset - 1));
+    for (auto i = offset; i < text.size(); ++i)
+    {
+        if (_Step(dfa, state, _SymbolOf(til::at(text, i))) != 0)
+        {
+            return i;
+        }
+    }
+    return _Step(dfa, state, _EndSymbol()) != 0 ? text.size() : std::wstring_view::npos;
+}
+
+// Routine Description:
+// - Finds the end of the longest match of a pattern that starts exactly at offset
+// Return Value:
+// - the end of the match, or npos if there is none
+size_t PatternMatcher::_FindLongestAt(const size_t pattern, const std::wstring_view text, const size_t offset) const
+{
+    auto& dfa = _anchored.at(pattern);
+    if (dfa.starts.empty())
+    {
+        dfa = _NewDfa({ _starts.at(pattern) }, false);
+    }
+
+    auto longest = std::wstring_view::npos;
+    auto state = _StartState(dfa, offset != 0 && _IsWordAt(text, offset - 1));
+    for (auto i = offset; i < text.size(); ++i)
+    {
+        if (_Step(dfa, state, _SymbolOf(til::at(text, i))) != 0)
+        {
+            longest = i;
+        }
+        if (til::at(dfa.states, state).dead)
+        {
+            return longest;
+        }
+    }
+    if (_Step(dfa, state, _EndSymbol()) != 0)
+    {
+        longest = text.size();
+    }
+    return longest;
+}
+
+bool PatternMatcher::_IsWordAt(const std::wstring_view text, const size_t offset) const noexcept
+{
+    return offset < text.size() && s_IsWordChar(til::at(text, offset));
+}
@@ -0,0 +1,156 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PatternMatcher.hpp
+
+Abstract:
+- Finds the matches of any number of regular expressions in a piece of text
+  in linear time, without the backtracking of std::regex.
+- The patterns are compiled into a single NFA, which is turned into a DFA
+  lazily (one state at a time, as the text requires it). A single pass of the
+  combined DFA over the text tells which patterns match at all, so the cost of
+  text without any matches doesn't depend on the number of patterns.
+  Only the patterns that do match are then located with their own DFAs.
+- Matching is leftmost-longest and the matches of a single pattern don't
+  overlap. Matches of different patterns may overlap.
+- A pattern that ignores case has the other case of its literals added to
+  their character sets when it's compiled, so the text is matched as it is.
+- Supported syntax (a subset of ECMAScript):
+    literals, ., [...], [^...], \d \D \w \W \s \S, \b \B,
+    \t \n \r \f \v \0 \xHH \uHHHH, escaped punctuation,
+    (...), (?:...), |, *, +, ?, {n}, {n,}, {n,m}
+  Anything else (anchors, backreferences, lookarounds, lazy quantifiers)
+  is rejected with E_INVALIDARG.
+--*/
+
+#pragma once
+
+class PatternMatcher final
+{
+public:
+    struct Match
+    {
+        size_t start; // offset of the first character of the match
+        size_t end; // offset past the last character of the match
+        size_t id;
+    };
+
+    PatternMatcher() noexcept = default;
+
+    void AddPattern(const size_t id, const std::wstring_view pattern, const bool ignoreCase = false);
+    void Clear() noexcept;
+    bool empty() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+    std::vector<Match> FindAll(const std::wstring_view text) const;
+
+private:
+    // The text is looked at in terms of character classes: ranges of characters
+    // which no pattern can tell apart. The class past the last one stands for the end of the text.
+    using symbol_type = uint16_t;
+
+    static constexpr uint32_t s_None = std::numeric_limits<uint32_t>::max();
+    static constexpr size_t s_MaxDfaStates = 4096;
+    static constexpr size_t s_MaxNfaStates = 65536;
+    static constexpr uint32_t s_MaxRepeat = 1000;
+
+    using CharRanges = std::vector<std::pair<wchar_t, wchar_t>>;
+
+    enum class NfaType : uint8_t
+    {
+        Char, // consumes a character of _sets[arg], continues at out
+        Split, // continues at both out and out1
+        WordBoundary, // continues at out if arg == 1 ? \b : \B holds
+        Match, // pattern arg matched
+    };
+
+    struct NfaState
+    {
+        NfaType type;
+        uint32_t arg;
+        uint32_t out;
+        uint32_t out1;
+    };
+
+    struct Node
+    {
+        enum class Kind : uint8_t
+        {
+            Empty,
+            Set,
+            Concat,
+            Alternate,
+            Repeat,
+            WordBoundary,
+        };
+
+        Kind kind{ Kind::Empty };
+        uint32_t arg{ 0 }; // set index; 1 for \b and 0 for \B
+        uint32_t min{ 0 };
+        uint32_t max{ 0 };
+        std::vector<Node> children;
+    };
+
+    struct DfaState
+    {
+        std::vector<uint32_t> kernel; // sorted NFA states reached by the last character
+        bool prevWord; // whether the last character was a word character
+        bool inject; // whether the pattern starts are added before the next character
+        bool dead;
+        std::vector<std::pair<uint32_t, uint32_t>> transitions; // per symbol: next state, accept set
+    };
+
+    struct Dfa
+    {
+        std::vector<uint32_t> starts;
+        bool unanchored{ false };
+        std::vector<DfaState> states;
+        std::map<std::tuple<std::vector<uint32_t>, bool, bool>, uint32_t> index;
+    };
+
+    class Parser;
+
+    uint32_t _AddSet(CharRanges ranges);
+    uint32_t _AddState(const NfaType type, const uint32_t arg, const uint32_t out, const uint32_t out1);
+    uint32_t _Compile(const Node& node, const uint32_t next);
+    void _BuildAlphabet();
+
+    symbol_type _SymbolOf(const wchar_t wch) const noexcept;
+    symbol_type _EndSymbol() const noexcept;
+
+    Dfa _NewDfa(std::vector<uint32_t> starts, const bool unanchored) const;
+    uint32_t _StartState(Dfa& dfa, const bool prevWord) const;
+    uint32_t _FindState(Dfa& dfa, std::vector<uint32_t> kernel, const bool prevWord, const bool inject) const;
+    uint32_t _Step(Dfa& dfa, uint32_t& state, const symbol_type symbol) const;
+    uint32_t _AcceptSetId(std::vector<uint32_t> patterns) const;
+
+    size_t _FindEarliestEnd(const size_t pattern, const std::wstring_view text, const size_t offset) const;
+    size_t _FindLongestAt(const size_t pattern, const std::wstring_view text, const size_t offset) const;
+
+    bool _IsWordAt(const std::wstring_view text, const size_t offset) const noexcept;
+
+    // the compiled patterns
+    std::vector<size_t> _ids;
+    std::vector<uint32_t> _starts;
+    std::vector<NfaState> _nfa;
+    std::vector<CharRanges> _sets;
+
+    // the alphabet: _boundaries[i] is the first character of symbol i + 1
+    std::vector<wchar_t> _boundaries;
+    std::array<symbol_type, 128> _asciiSymbols{};
+    std::vector<bool> _symbolIsWord;
+    std::vector<bool> _setContains; // [set * symbols + symbol]
+
+    // lazily built DFAs, invalidated whenever a pattern is added
+    mutable Dfa _combined;
+    mutable std::vector<Dfa> _unanchored;
+    mutable std::vector<Dfa> _anchored;
+    mutable std::vector<std::vector<uint32_t>> _acceptSets;
+    mutable std::map<std::vector<uint32_t>, uint32_t> _acceptSetIndex;
+
+#ifdef UNIT_TESTING
+    friend class PatternMatcherTests;
+#endif
+};
@@ -0,0 +1,181 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PatternSpans.hpp
+
+Abstract:
+- The pattern matches in a region of a TextBuffer (usually the viewport),
+  kept in a small sorted vector per row of the region.
+- Looking up the matches at a position only searches the row it's on, two sets
+  of matches can be compared a row at a time, and when the text scrolls, the
+  rows are shifted along with it instead of the matches being searched again.
+- A match that spans several (wrapped) rows is stored in each of them.
+  Coordinates are relative to the top of the region.
+
+--*/
+
+#pragma once
+
+class PatternSpans final
+{
+public:
+    using interval = interval_tree::IntervalTree<til::point, size_t>::interval;
+    using interval_vector = interval_tree::IntervalTree<til::point, size_t>::interval_vector;
+
+    PatternSpans() = default;
+
+    explicit PatternSpans(const interval_vector& intervals)
+    {
+        for (const auto& interval : intervals)
+        {
+            const auto first = _FirstRow(interval);
+            const auto last = gsl::narrow_cast<size_t>(std::max(interval.stop.y(), ptrdiff_t{ 0 }));
+            if (_rows.size() <= last)
+            {
+                _rows.resize(last + 1);
+            }
+            for (auto y = first; y <= last; ++y)
+            {
+                til::at(_rows, y).push_back(interval);
+            }
+        }
+
+        for (auto& row : _rows)
+        {
+            std::sort(row.begin(), row.end(), _StartsBefore);
+        }
+    }
+
+    bool empty() const noexcept
+    {
+        return _rows.empty();
+    }
+
+    // The number of rows that hold matches, counting from the top of the region.
+    size_t RowCount() const noexcept
+    {
+        return _rows.size();
+    }
+
+    size_t GetMemoryUsage() const noexcept
+    {
+        auto usage = _rows.capacity() * sizeof(std::vector<interval>);
+        for (const auto& row : _rows)
+        {
+            usage += row.capacity() * sizeof(interval);
+        }
+        return usage;
+    }
+
+    // The matches overlapping the given row, sorted by where they start.
+    gsl::span<const interval> GetRow(const size_t y) const noexcept
+    {
+        if (y >= _rows.size())
+        {
+            return {};
+        }
+        return til::at(_rows, y);
+    }
+
+    // Finds all of the matches overlapping [start, stop], the same way IntervalTree does.
+    interval_vector findOverlapping(const til::point start, const til::point stop) const
+    {
+        interval_vector result;
+        const auto first = std::max(std::min(start.y(), stop.y()), ptrdiff_t{ 0 });
+        const auto last = std::max(start.y(), stop.y());
+        for (auto y = first; y <= last && gsl::narrow_cast<size_t>(y) < _rows.size(); ++y)
+        {
+            const auto& row = til::at(_rows, gsl::narrow_cast<size_t>(y));
+            // Nothing that starts after stop can overlap.
+            const auto end = std::upper_bound(row.begin(), row.end(), stop, [](const til::point& point, const interval& interval) {
+                return point < interval.start;
+            });
+            for (auto it = row.begin(); it != end; ++it)
+            {
+                // A match spanning several rows is reported on the first of them we look at.
+                if (it->stop >= start && std::max(it->start.y(), first) == y)
+                {
+                    result.push_back(*it);
+                }
+            }
+        }
+        return result;
+    }
+
+    // Calls f once for every match.
+    template<typename UnaryFunction>
+    void visit_all(UnaryFunction f) const
+    {
+        for (size_t y = 0; y < _rows.size(); ++y)
+        {
+            for (const auto& interval : til::at(_rows, y))
+            {
+                if (_FirstRow(interval) == y)
+                {
+                    f(interval);
+                }
+            }
+        }
+    }
+
+    // Moves the matches up (or down, if negative) by the given number of rows,
+    // the way the text moves when the region scrolls. The matches of rows that
+    // move out of the region are dropped, except for the parts of them that are
+    // still in it. The rows that move into the region have no matches.
+    // Arguments:
+    // - rows - the number of rows to move the matches up by
+    // - height - the number of rows in the region
+    void Shift(const ptrdiff_t rows, const size_t height)
+    {
+        const auto shift = [=](interval& interval) {
+            interval.start = til::point{ interval.start.x(), interval.start.y() - rows };
+            interval.stop = til::point{ interval.stop.x(), interval.stop.y() - rows };
+        };
+
+        if (rows >= 0)
+        {
+            // The matches stay on the rows they're stored in, only fewer of them.
+            _rows.erase(_rows.begin(), _rows.begin() + std::min(gsl::narrow_cast<size_t>(rows), _rows.size()));
+            for (auto& row : _rows)
+            {
+                std::for_each(row.begin(), row.end(), shift);
+            }
+        }
+        else
+        {
+            // A match that was cut off at the top comes back into the region
+            // with the rows above it, so it's stored in more rows than before.
+            interval_vector intervals;
+            visit_all([&](const interval& interval) {
+                if (interval.start.y() - rows < gsl::narrow_cast<ptrdiff_t>(height))
+                {
+                    intervals.push_back(interval);
+                    shift(intervals.back());
+                }
+            });
+            *this = PatternSpans{ intervals };
+        }
+
+        _rows.resize(std::min(_rows.size(), height));
+        while (!_rows.empty() && _rows.back().empty())
+        {
+            _rows.pop_back();
+        }
+    }
+
+private:
+    // The first row of the region the match overlaps.
+    static size_t _FirstRow(const interval& interval) noexcept
+    {
+        return gsl::narrow_cast<size_t>(std::max(interval.start.y(), ptrdiff_t{ 0 }));
+    }
+
+    static bool _StartsBefore(const interval& lhs, const interval& rhs) noexcept
+    {
+        return std::tie(lhs.start, lhs.stop, lhs.value) < std::tie(rhs.start, rhs.stop, rhs.value);
+    }
+
+    std::vector<std::vector<interval>> _rows;
+};
@@ -0,0 +1,158 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- PromptMarks.hpp
+
+Abstract:
+- The shell integration marks (FTCS, OSC 133) of a TextBuffer, which tell where
+  the prompts, the commands and their output are.
+- The marks are kept sorted by row, so that finding the prompt before or after
+  a row is a binary search, no matter how long the scrollback is. Their rows
+  count every row the buffer ever held, so they stay the same while the buffer
+  circles, and marks are only dropped once their row scrolls out of the buffer.
+
+--*/
+
+#pragma once
+
+enum class PromptMarkKind : uint8_t
+{
+    Prompt, // FTCS_PROMPT, OSC 133;A
+    Command, // FTCS_COMMAND_START, OSC 133;B
+    Output, // FTCS_COMMAND_EXECUTED, OSC 133;C
+    Finished, // FTCS_COMMAND_FINISHED, OSC 133;D
+};
+
+class PromptMarks final
+{
+public:
+    struct Mark
+    {
+        uint64_t row : 62;
+        uint64_t kind : 2;
+
+        PromptMarkKind Kind() const noexcept
+        {
+            return static_cast<PromptMarkKind>(kind);
+        }
+    };
+
+    bool empty() const noexcept
+    {
+        return _marks.empty();
+    }
+
+    size_t size() const noexcept
+    {
+        return _marks.size();
+    }
+
+    const Mark& at(const size_t index) const
+    {
+        return _marks.at(index);
+    }
+
+    void clear() noexcept
+    {
+        _marks.clear();
+    }
+
+    // Adds a mark. Marks are almost always added at the bottom, but the cursor
+    // might have moved up since the last one, so it's inserted in order.
+    void Add(const uint64_t row, const PromptMarkKind kind)
+    {
+        Mark mark{};
+        mark.row = row;
+        mark.kind = static_cast<uint64_t>(kind);
+        const auto it = std::upper_bound(_marks.begin(), _marks.end(), row, [](const uint64_t row, const Mark& mark) {
+            return row < mark.row;
+        });
+        // The same mark twice on a row (a prompt redrawn in place) is kept once.
+        if (it != _marks.begin() && (it - 1)->row == row && (it - 1)->kind == mark.kind)
+        {
+            return;
+        }
+        _marks.insert(it, mark);
+    }
+
+    // Drops the marks above the given row, which left the buffer.
+    void DropBefore(const uint64_t row) noexcept
+    {
+        while (!_marks.empty() && _marks.front().row < row)
+        {
+            _marks.pop_front();
+        }
+    }
+
+    // Drops the marks in the rows [begin, end).
+    void Erase(const uint64_t begin, const uint64_t end)
+    {
+        _marks.erase(_LowerBound(begin), _LowerBound(end));
+    }
+
+    // Moves every mark down by the given number of rows, for rows that are counted above them now.
+    void MoveDown(const uint64_t rows) noexcept
+    {
+        for (auto& mark : _marks)
+        {
+            mark.row += rows;
+        }
+    }
+
+    // Finds the last mark of the given kind above the given row.
+    std::optional<Mark> FindBefore(const uint64_t row, const PromptMarkKind kind) const
+    {
+        for (auto it = _LowerBound(row); it != _marks.begin();)
+        {
+            --it;
+            if (it->Kind() == kind)
+            {
+                return *it;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Finds the first mark of the given kind below the given row.
+    std::optional<Mark> FindAfter(const uint64_t row, const PromptMarkKind kind) const
+    {
+        for (auto it = _LowerBound(row + 1); it != _marks.end(); ++it)
+        {
+            if (it->Kind() == kind)
+            {
+                return *it;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Whether there's a mark of the given kind in the rows [begin, end).
+    bool Contains(const uint64_t begin, const uint64_t end, const PromptMarkKind kind) const
+    {
+        for (auto it = _LowerBound(begin); it != _marks.end() && it->row < end; ++it)
+        {
+            if (it->Kind() == kind)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t GetMemoryUsage() const noexcept
+    {
+        return _marks.size() * sizeof(Mark);
+    }
+
+private:
+    std::deque<Mark>::const_iterator _LowerBound(const uint64_t row) const
+    {
+        return std::lower_bound(_marks.begin(), _marks.end(), row, [](const Mark& mark, const uint64_t row) {
+            return mark.row < row;
+        });
+    }
+
+    std::deque<Mark> _marks;
+};
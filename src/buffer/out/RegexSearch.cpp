@@ -0,0 +1,211 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "RegexSearch.hpp"
+
+#include "textBuffer.hpp"
+
+#pragma hdrstop
+
+using namespace Microsoft::Console::Types;
+
+// Routine Description:
+// - Constructs a RegexSearch object. Call .FindNext() to go through all of the
+//   matches, or .FindAround() to find the one next to the selection.
+// - Patterns are rejected with E_INVALIDARG, see PatternMatcher.
+// Arguments:
+// - uiaData - The IUiaData type reference, it is for providing selection methods
+// - pattern - The regular expression to search for
+// - sensitivity - Whether or not you care about case
+RegexSearch::RegexSearch(IUiaData& uiaData,
+                         const std::wstring_view pattern,
+                         const Search::Sensitivity sensitivity) :
+    _uiaData(uiaData)
+{
+    _matcher.AddPattern(0, pattern, sensitivity == Search::Sensitivity::CaseInsensitive);
+}
+
+// Routine Description
+// - Locates the next match, going from the top of the buffer to the end of its text.
+// Return Value:
+// - True if we found another match. False if we've reached the end of the buffer.
+bool RegexSearch::FindNext()
+{
+    while (_nextMatch >= _matches.size())
+    {
+        if (!_LoadNextLine())
+        {
+            return false;
+        }
+    }
+
+    const auto& match = til::at(_matches, _nextMatch++);
+    _coordSelStart = til::at(_glyphStarts, match.start);
+    _coordSelEnd = til::at(_glyphEnds, match.end - 1);
+    return true;
+}
+
+// Routine Description
+// - Locates the match that follows the selection (or precedes it), wrapping around
+//   the ends of the buffer like Search does. Without a selection, it's the first
+//   (or the last) match of the buffer.
+// - Goes through all of the matches of the buffer, since the ones before the
+//   selection can't be found without the ones before them.
+// Arguments:
+// - direction - The direction to search (upward or downward)
+// Return Value:
+// - True if there's any match at all.
+bool RegexSearch::FindAround(const Search::Direction direction)
+{
+    const auto isBefore = [](const COORD a, const COORD b) noexcept {
+        return a.Y < b.Y || (a.Y == b.Y && a.X < b.X);
+    };
+
+    const auto selected = _uiaData.IsSelectionActive();
+    const auto anchor = selected ? _uiaData.GetTextBuffer().ScreenToBufferPosition(_uiaData.GetSelectionAnchor()) : COORD{ 0 };
+
+    std::optional<std::pair<COORD, COORD>> first;
+    std::optional<std::pair<COORD, COORD>> last;
+    std::optional<std::pair<COORD, COORD>> found;
+    while (FindNext())
+    {
+        const auto location = GetFoundLocation();
+        if (!first)
+        {
+            first = location;
+        }
+        last = location;
+
+        if (direction == Search::Direction::Forward)
+        {
+            if (!found && (!selected || isBefore(anchor, location.first)))
+            {
+                found = location;
+            }
+        }
+        else if (selected && isBefore(location.first, anchor))
+        {
+            found = location;
+        }
+    }
+
+    if (!found)
+    {
+        found = direction == Search::Direction::Forward ? first : last;
+    }
+    if (!found)
+    {
+        return false;
+    }
+
+    std::tie(_coordSelStart, _coordSelEnd) = *found;
+    return true;
+}
+
+// Routine Description:
+// - Takes the found match and selects it in the screen buffer
+void RegexSearch::Select() const
+{
+    const auto& textBuffer = _uiaData.GetTextBuffer();
+    const auto selStart = textBuffer.BufferToScreenPosition(_coordSelStart);
+    const auto selEnd = textBuffer.BufferToScreenPosition(_coordSelEnd);
+    _uiaData.SelectNewRegion(selStart, selEnd);
+}
+
+// Routine Description:
+// - gets start and end position of the match found last. only guaranteed to have valid data if
+//   FindNext or FindAround has been called and returned true.
+// Return Value:
+// - pair containing [start, end] coord positions of the match, both inclusive
+std::pair<COORD, COORD> RegexSearch::GetFoundLocation() const noexcept
+{
+    return { _coordSelStart, _coordSelEnd };
+}
+
+// Routine Description:
+// - Moves the search along with the text after the given number of rows circled out
+//   of the top of the buffer, so that FindNext goes on where it left off in the text.
+//   The matches of the current line that started in those rows are gone with them.
+// Arguments:
+// - rows - the number of rows that circled out since the search was last used
+void RegexSearch::MoveUp(const size_t rows) noexcept
+{
+    _nextRow = _nextRow > rows ? _nextRow - rows : 0;
+
+    // Glyphs that went away are moved to row -1.
+    const auto gone = [rows](const COORD glyph) noexcept {
+        return glyph.Y < 0 || gsl::narrow_cast<size_t>(glyph.Y) < rows;
+    };
+
+    while (_nextMatch < _matches.size() && gone(til::at(_glyphStarts, til::at(_matches, _nextMatch).start)))
+    {
+        ++_nextMatch;
+    }
+
+    // The glyphs of the matches that are left are all below the rows that went away.
+    for (auto glyphs : { &_glyphStarts, &_glyphEnds })
+    {
+        for (auto& glyph : *glyphs)
+        {
+            glyph.Y = gone(glyph) ? -1 : gsl::narrow_cast<SHORT>(glyph.Y - rows);
+        }
+    }
+}
+
+// Routine Description:
+// - Joins the next row and the ones it was wrapped into into a line of text,
+//   and finds all of the matches on it.
+// Return Value:
+// - True if there was another line. False if the end of the text was reached.
+bool RegexSearch::_LoadNextLine()
+{
+    const auto& textBuffer = _uiaData.GetTextBuffer();
+    const auto lastRow = gsl::narrow_cast<size_t>(std::max<SHORT>(_uiaData.GetTextBufferEndPosition().Y, 0));
+    if (_nextRow > lastRow)
+    {
+        return false;
+    }
+
+    _lineText.clear();
+    _glyphStarts.clear();
+    _glyphEnds.clear();
+
+    for (auto row = _nextRow;; ++row)
+    {
+        const auto& bufferRow = textBuffer.GetRowByOffset(row);
+        const auto& charRow = bufferRow.GetCharRow();
+        const auto wrapped = bufferRow.WasWrapForced() && row < lastRow;
+        const auto width = wrapped ? charRow.size() : charRow.MeasureRight();
+        const auto y = gsl::narrow_cast<SHORT>(row);
+
+        for (size_t column = 0; column < width; ++column)
+        {
+            const auto& dbcsAttr = charRow.DbcsAttrAt(column);
+            if (dbcsAttr.IsTrailing())
+            {
+                continue;
+            }
+
+            const COORD start{ gsl::narrow_cast<SHORT>(column), y };
+            const COORD end{ gsl::narrow_cast<SHORT>(dbcsAttr.IsLeading() && column + 1 < charRow.size() ? column + 1 : column), y };
+            for (const auto wch : charRow.GlyphAt(column))
+            {
+                _lineText.push_back(wch);
+                _glyphStarts.push_back(start);
+                _glyphEnds.push_back(end);
+            }
+        }
+
+        if (!wrapped)
+        {
+            _nextRow = row + 1;
+            break;
+        }
+    }
+
+    _matches = _matcher.FindAll(_lineText);
+    _nextMatch = 0;
+    return true;
+}
@@ -0,0 +1,61 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- RegexSearch.hpp
+
+Abstract:
+- Searches the screen for the matches of a regular expression, using the
+  linear-time PatternMatcher, so that the time a search takes only depends on
+  the amount of text and not on the pattern.
+- The text is matched a line at a time: the rows that were wrapped into each
+  other (see ROW::WasWrapForced) are joined, so that a match can continue onto
+  the next row, just like the text does. The blanks at the end of a line that
+  wasn't wrapped aren't part of it.
+- Unlike Search, the matches are always found front to back, since that's
+  the only way to find the leftmost-longest ones. FindAround picks the one
+  next to the selection, in either direction.
+--*/
+
+#pragma once
+
+#include "PatternMatcher.hpp"
+#include "search.h"
+
+class RegexSearch final
+{
+public:
+    RegexSearch(Microsoft::Console::Types::IUiaData& uiaData,
+                const std::wstring_view pattern,
+                const Search::Sensitivity sensitivity);
+
+    bool FindNext();
+    bool FindAround(const Search::Direction direction);
+    void Select() const;
+
+    std::pair<COORD, COORD> GetFoundLocation() const noexcept;
+
+    void MoveUp(const size_t rows) noexcept;
+
+private:
+    bool _LoadNextLine();
+
+    Microsoft::Console::Types::IUiaData& _uiaData;
+    PatternMatcher _matcher;
+
+    // the row the next line starts at
+    size_t _nextRow = 0;
+
+    // The text of the current line, and for each of its characters the
+    // first and the last cell of the glyph it belongs to.
+    std::wstring _lineText;
+    std::vector<COORD> _glyphStarts;
+    std::vector<COORD> _glyphEnds;
+
+    std::vector<PatternMatcher::Match> _matches;
+    size_t _nextMatch = 0;
+
+    COORD _coordSelStart = { 0 };
+    COORD _coordSelEnd = { 0 };
+};
@@ -0,0 +1,276 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "RichTextWriter.hpp"
+
+#include "../types/inc/utils.hpp"
+#include "../types/inc/convert.hpp"
+
+#pragma hdrstop
+
+using namespace Microsoft::Console;
+
+// once filled with values, there will be exactly 157 bytes in the CF_HTML clipboard header
+static constexpr size_t s_ClipboardHeaderSize = 157;
+static constexpr std::string_view s_HtmlHeader = "<!DOCTYPE><HTML><HEAD></HEAD><BODY>";
+static constexpr std::string_view s_HtmlFooter = "</BODY></HTML>";
+
+// Routine Description:
+// - Starts a CF_HTML document at the end of the given string.
+// - The clipboard header is only a placeholder until Finish() fills in its offsets.
+// Arguments:
+// - out - the string to append the document to
+// - fontHeightPoints - the unscaled font height
+// - fontFaceName - the name of the font used
+// - backgroundColor - default background color for characters, also used in padding
+HtmlWriter::HtmlWriter(std::string& out,
+                       const int fontHeightPoints,
+                       const std::wstring_view fontFaceName,
+                       const COLORREF backgroundColor) :
+    _out{ out },
+    _start{ out.size() }
+{
+    _out.append(s_ClipboardHeaderSize, ' ');
+
+    // First we have to add some standard
+    // HTML boiler plate required for CF_HTML
+    // as part of the HTML Clipboard format
+    _out.append(s_HtmlHeader);
+    _fragmentStart = _out.size() - _start;
+
+    _out.append("<!--StartFragment -->");
+
+    // apply global style in div element
+    _out.append("<DIV STYLE=\"");
+    _out.append("display:inline-block;");
+    _out.append("white-space:pre;");
+    _out.append("background-color:").append(Utils::ColorToHexString(backgroundColor)).append(";");
+    // even with different font, add monospace as fallback
+    _out.append("font-family:'").append(ConvertToA(CP_UTF8, fontFaceName)).append("',monospace;");
+    _out.append("font-size:").append(std::to_string(fontHeightPoints)).append("pt;");
+    // note: MS Word doesn't support padding (in this way at least)
+    _out.append("padding:4px;"); // todo: customizable padding
+    _out.append("\">");
+}
+
+// Routine Description:
+// - Starts a new line of text.
+void HtmlWriter::NewLine()
+{
+    _out.append("<BR>");
+}
+
+// Routine Description:
+// - Appends text in the given colors.
+// Arguments:
+// - text - the text to append. \r and \n aren't HTML friendly and should be passed as NewLine() instead.
+// - foreground - the color of the text
+// - background - the color behind the text
+void HtmlWriter::Write(const std::wstring_view text, const COLORREF foreground, const COLORREF background)
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    if (foreground != _foreground || background != _background)
+    {
+        _foreground = foreground;
+        _background = background;
+
+        if (_hasWrittenAnyText)
+        {
+            _out.append("</SPAN>");
+        }
+
+        _out.append("<SPAN STYLE=\"");
+        _out.append("color:").append(Utils::ColorToHexString(foreground)).append(";");
+        _out.append("background-color:").append(Utils::ColorToHexString(background)).append(";");
+        _out.append("\">");
+    }
+
+    _hasWrittenAnyText = true;
+
+    for (const auto c : ConvertToA(CP_UTF8, text))
+    {
+        switch (c)
+        {
+        case '<':
+            _out.append("&lt;");
+            break;
+        case '>':
+            _out.append("&gt;");
+            break;
+        case '&':
+            _out.append("&amp;");
+            break;
+        default:
+            _out.push_back(c);
+        }
+    }
+}
+
+// Routine Description:
+// - Closes the document and fills in the clipboard header.
+void HtmlWriter::Finish()
+{
+    if (_hasWrittenAnyText)
+    {
+        // last opened span wasn't closed yet, so close it now
+        _out.append("</SPAN>");
+    }
+
+    _out.append("</DIV>");
+    _out.append("<!--EndFragment -->");
+    _out.append(s_HtmlFooter);
+
+    // these values are byte offsets from start of clipboard
+    const auto htmlStartPos = s_ClipboardHeaderSize;
+    const auto htmlEndPos = _out.size() - _start;
+    const auto fragStartPos = _fragmentStart;
+    const auto fragEndPos = htmlEndPos - s_HtmlFooter.size();
+
+    // header required by HTML 0.9 format
+    const auto header = fmt::format("Version:0.9\r\n"
+                                    "StartHTML:{:010}\r\n"
+                                    "EndHTML:{:010}\r\n"
+                                    "StartFragment:{:010}\r\n"
+                                    "EndFragment:{:010}\r\n"
+                                    "StartSelection:{:010}\r\n"
+                                    "EndSelection:{:010}\r\n",
+                                    htmlStartPos,
+                                    htmlEndPos,
+                                    fragStartPos,
+                                    fragEndPos,
+                                    fragStartPos,
+                                    fragEndPos);
+    THROW_HR_IF(E_UNEXPECTED, header.size() != s_ClipboardHeaderSize);
+    _out.replace(_start, s_ClipboardHeaderSize, header);
+}
+
+// Routine Description:
+// - Starts an RTF document at the end of the given string.
+//   RTF 1.5 Spec: https://www.biblioscape.com/rtf15_spec.htm
+// - The color table has to precede the content, but isn't known until all of the
+//   text has been written. It's inserted in front of the content by Finish().
+// Arguments:
+// - out - the string to append the document to
+// - fontHeightPoints - the unscaled font height
+// - fontFaceName - the name of the font used
+// - backgroundColor - default background color for characters
+RtfWriter::RtfWriter(std::string& out,
+                     const int fontHeightPoints,
+                     const std::wstring_view fontFaceName,
+                     const COLORREF backgroundColor) :
+    _out{ out },
+    _start{ out.size() }
+{
+    // start rtf
+    _header.append("{");
+
+    // Standard RTF header.
+    // This is similar to the header generated by WordPad.
+    // \ansi - specifies that the ANSI char set is used in the current doc
+    // \ansicpg1252 - represents the ANSI code page which is used to perform the Unicode to ANSI conversion when writing RTF text
+    // \deff0 - specifies that the default font for the document is the one at index 0 in the font table
+    // \nouicompat - ?
+    _header.append("\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat");
+
+    // font table
+    _header.append("{\\fonttbl{\\f0\\fmodern\\fcharset0 ").append(ConvertToA(CP_UTF8, fontFaceName)).append(";}}");
+
+    // RTF color table
+    _header.append("{\\colortbl ;");
+    _ColorIndex(backgroundColor);
+
+    // content
+    _out.append("\\viewkind4\\uc4");
+
+    // paragraph styles
+    // \fs specifies font size in half-points i.e. \fs20 results in a font size
+    // of 10 pts. That's why, font size is multiplied by 2 here.
+    _out.append("\\pard\\slmult1\\f0\\fs").append(std::to_string(2 * fontHeightPoints)).append("\\highlight1 ");
+}
+
+// Routine Description:
+// - Starts a new line of text.
+void RtfWriter::NewLine()
+{
+    _out.append("\\line "); // new line
+}
+
+// Routine Description:
+// - Appends text in the given colors.
+// Arguments:
+// - text - the text to append. \r and \n should be passed as NewLine() instead.
+// - foreground - the color of the text
+// - background - the color behind the text
+void RtfWriter::Write(const std::wstring_view text, const COLORREF foreground, const COLORREF background)
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    if (foreground != _foreground || background != _background)
+    {
+        _foreground = foreground;
+        _background = background;
+
+        const auto bkColorIndex = _ColorIndex(background);
+        const auto fgColorIndex = _ColorIndex(foreground);
+        _out.append("\\highlight").append(std::to_string(bkColorIndex));
+        _out.append("\\cf").append(std::to_string(fgColorIndex)).append(" ");
+    }
+
+    for (const auto c : ConvertToA(CP_UTF8, text))
+    {
+        switch (c)
+        {
+        case '\\':
+        case '{':
+        case '}':
+            _out.push_back('\\');
+            _out.push_back(c);
+            break;
+        default:
+            _out.push_back(c);
+        }
+    }
+}
+
+// Routine Description:
+// - Closes the document and puts the headers with the color table in front of the content.
+void RtfWriter::Finish()
+{
+    // end colortbl
+    _header.append("}");
+
+    // end rtf
+    _out.append("}");
+
+    _out.insert(_start, _header);
+}
+
+// Routine Description:
+// - Looks up the index of a color in the color table, adding the color if it isn't in there yet.
+// Arguments:
+// - color - the color to look up
+// Return Value:
+// - The index of the color in the color table.
+int RtfWriter::_ColorIndex(const COLORREF color)
+{
+    const auto [it, inserted] = _colorMap.emplace(color, _nextColorIndex);
+    if (inserted)
+    {
+        // color not present in the map, so add it
+        _header.append("\\red").append(std::to_string(GetRValue(color)));
+        _header.append("\\green").append(std::to_string(GetGValue(color)));
+        _header.append("\\blue").append(std::to_string(GetBValue(color)));
+        _header.append(";");
+        ++_nextColorIndex;
+    }
+    return it->second;
+}
@@ -0,0 +1,60 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- RichTextWriter.hpp
+
+Abstract:
+- Writers which format colored text as CF_HTML or RTF while it's being produced.
+- The text is appended to a caller provided string in runs of a single color,
+  so no per character color data has to be collected for the whole text first.
+- Call NewLine() between rows, Write() for each run and Finish() once at the end.
+--*/
+
+#pragma once
+
+class HtmlWriter final
+{
+public:
+    HtmlWriter(std::string& out,
+               const int fontHeightPoints,
+               const std::wstring_view fontFaceName,
+               const COLORREF backgroundColor);
+
+    void NewLine();
+    void Write(const std::wstring_view text, const COLORREF foreground, const COLORREF background);
+    void Finish();
+
+private:
+    std::string& _out;
+    size_t _start;
+    size_t _fragmentStart;
+    bool _hasWrittenAnyText{ false };
+    std::optional<COLORREF> _foreground;
+    std::optional<COLORREF> _background;
+};
+
+class RtfWriter final
+{
+public:
+    RtfWriter(std::string& out,
+              const int fontHeightPoints,
+              const std::wstring_view fontFaceName,
+              const COLORREF backgroundColor);
+
+    void NewLine();
+    void Write(const std::wstring_view text, const COLORREF foreground, const COLORREF background);
+    void Finish();
+
+private:
+    int _ColorIndex(const COLORREF color);
+
+    std::string& _out;
+    size_t _start;
+    std::string _header;
+    std::unordered_map<COLORREF, int> _colorMap;
+    int _nextColorIndex{ 1 }; // leave 0 for the default color and start from 1.
+    std::optional<COLORREF> _foreground;
+    std::optional<COLORREF> _background;
+};
@@ -11,20 +11,27 @@
 // - constructor
 // Arguments:
 // - rowId - the row index in the text buffer
-// - rowWidth - the width of the row, cell elements
+// - buffer - the cells backing this row, its size is the width of the row
 // - fillAttribute - the default text attribute
+// - attributes - the attribute table of the text buffer that this row belongs to
+// - clock - the clock of the text buffer, which stamps the generations of the row
 // - pParent - the text buffer that this row belongs to
 // Return Value:
 // - constructed object
-ROW::ROW(const SHORT rowId, const unsigned short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent) :
+ROW::ROW(const size_t rowId, gsl::span<CharRowCell> buffer, const TextAttribute fillAttribute, AttributeTable& attributes, ModificationClock& clock, TextBuffer* const pParent) :
     _id{ rowId },
-    _rowWidth{ rowWidth },
-    _charRow{ rowWidth, this },
-    _attrRow{ rowWidth, fillAttribute },
+    _rowWidth{ gsl::narrow<unsigned short>(buffer.size()) },
+    _charRow{ buffer, clock },
+    _attrRow{ gsl::narrow<unsigned short>(buffer.size()), fillAttribute, attributes, clock },
     _lineRendition{ LineRendition::SingleWidth },
     _wrapForced{ false },
     _doubleBytePadded{ false },
-    _pParent{ pParent }
+    _pParent{ pParent },
+    _packedCells{},
+    _packed{ false },
+    _clearPending{ false },
+    _clock{ &clock },
+    _generation{ 0 }
 {
 }
 
@@ -39,7 +46,9 @@ bool ROW::Reset(const TextAttribute Attr)
     _lineRendition = LineRendition::SingleWidth;
     _wrapForced = false;
     _doubleBytePadded = false;
+    _generation = _clock->Tick();
     _charRow.Reset();
+    _clearPending = false;
     try
     {
         _attrRow.Reset(Attr);
@@ -52,26 +61,77 @@ bool ROW::Reset(const TextAttribute Attr)
     return true;
 }
 
+// Routine Description:
+// - Replaces the contents of this row with those of another row, which may belong
+//   to another text buffer. The row keeps its own ID and width, cutting off or
+//   padding the contents of the other row as necessary.
+// Arguments:
+// - other - the row to copy from
+// Return Value:
+// - <none>
+void ROW::CopyFrom(const ROW& other)
+{
+    _charRow.CopyFrom(other._charRow);
+    _attrRow.CopyFrom(other._attrRow);
+    _attrRow.Resize(_rowWidth);
+    _lineRendition = other._lineRendition;
+    _wrapForced = other._wrapForced;
+    _doubleBytePadded = other._doubleBytePadded;
+    _generation = _clock->Tick();
+}
+
 // Routine Description:
 // - resizes ROW to new width
 // Arguments:
-// - width - the new width, in cells
+// - buffer - the new cells backing this row, its size is the new width
 // Return Value:
 // - S_OK if successful, otherwise relevant error
-[[nodiscard]] HRESULT ROW::Resize(const unsigned short width)
+[[nodiscard]] HRESULT ROW::Resize(gsl::span<CharRowCell> buffer)
 {
-    RETURN_IF_FAILED(_charRow.Resize(width));
+    unsigned short width = 0;
     try
     {
+        width = gsl::narrow<unsigned short>(buffer.size());
         _attrRow.Resize(width);
     }
     CATCH_RETURN();
 
+    _charRow.Resize(buffer);
+
     _rowWidth = width;
 
     return S_OK;
 }
 
+// Routine Description:
+// - Makes a copy of the attributes of this row, resized to the given width. This is
+//   the part of resizing a row that can fail, so that callers that move many rows
+//   can do it for all of them before they touch any (see the other Resize overload).
+// Arguments:
+// - width - the new width of the row
+// Return Value:
+// - the attributes to pass to Resize along with the new cells
+ATTR_ROW ROW::GetResizedAttrRow(const size_t width) const
+{
+    auto attrRow{ _attrRow };
+    attrRow.Resize(gsl::narrow<unsigned short>(width));
+    return attrRow;
+}
+
+// Routine Description:
+// - resizes ROW to new width, with the attributes previously prepared by GetResizedAttrRow
+// Arguments:
+// - buffer - the new cells backing this row, its size is the new width
+// - attrRow - the attributes returned by GetResizedAttrRow for the size of buffer
+// Return Value:
+// - <none>
+void ROW::Resize(gsl::span<CharRowCell> buffer, ATTR_ROW&& attrRow) noexcept
+{
+    _attrRow = std::move(attrRow);
+    _charRow.Resize(buffer);
+    _rowWidth = gsl::narrow_cast<unsigned short>(buffer.size());
+}
+
 // Routine Description:
 // - clears char data in column in row
 // Arguments:
@@ -86,12 +146,12 @@ void ROW::ClearColumn(const size_t column)
 
 UnicodeStorage& ROW::GetUnicodeStorage() noexcept
 {
-    return _pParent->GetUnicodeStorage();
+    return _charRow.GetUnicodeStorage();
 }
 
 const UnicodeStorage& ROW::GetUnicodeStorage() const noexcept
 {
-    return _pParent->GetUnicodeStorage();
+    return _charRow.GetUnicodeStorage();
 }
 
 // Routine Description:
@@ -118,6 +178,50 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
 
     while (it && currentIndex <= finalColumnInRow)
     {
+        // Runs of narrow cells share a single attribute, so they can be
+        // written in bulk instead of going through the per cell logic below.
+        if (const auto run = it.PeekRun(finalColumnInRow + 1u - currentIndex); run.length > 1)
+        {
+            const auto runLength = gsl::narrow_cast<uint16_t>(run.length);
+
+            if (it->TextAttrBehavior() != TextAttributeBehavior::Current)
+            {
+                if (currentColor == it->TextAttr())
+                {
+                    colorUses += runLength;
+                }
+                else
+                {
+                    _attrRow.Replace(colorStarts, currentIndex, currentColor);
+                    currentColor = it->TextAttr();
+                    colorUses = runLength;
+                    colorStarts = currentIndex;
+                }
+            }
+
+            if (it->TextAttrBehavior() != TextAttributeBehavior::StoredOnly)
+            {
+                if (run.text.empty())
+                {
+                    _charRow.FillNarrowGlyph(currentIndex, run.length, it->Chars().front());
+                }
+                else
+                {
+                    _charRow.WriteNarrowText(currentIndex, run.text);
+                }
+
+                // Same as below: a run filling the last column (un)sets the wrap status.
+                if (wrap.has_value() && currentIndex + runLength == finalColumnInRow + 1u)
+                {
+                    SetWrapForced(*wrap);
+                }
+            }
+
+            it.AdvanceRun(run.length);
+            currentIndex += runLength;
+            continue;
+        }
+
         // Fill the color if the behavior isn't set to keeping the current color.
         if (it->TextAttrBehavior() != TextAttributeBehavior::Current)
         {
@@ -196,3 +300,273 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
 
     return it;
 }
+
+// Routine Description:
+// - Reads cells of the row out as legacy cells, the way CONSOLE_INFORMATION::AsCharInfo
+//   converts them one at a time.
+// - The legacy attributes are worked out once per run of the attribute row, so a row
+//   in a single color costs one conversion no matter how wide it is.
+// Arguments:
+// - index - column in row to start reading at
+// - cells - receives one legacy cell per column
+// Return Value:
+// - <none>
+void ROW::ReadCharInfos(const size_t index, const gsl::span<CHAR_INFO> cells) const
+{
+    THROW_HR_IF(E_INVALIDARG, index > size() || cells.size() > size() - index);
+
+    const auto end = index + cells.size();
+    size_t runStart = 0;
+    for (const auto& run : _attrRow._data.runs())
+    {
+        const size_t runEnd = runStart + run.length;
+        if (runEnd > index)
+        {
+            const auto legacyAttributes = _attrRow._table->Get(run.value).GetLegacyAttributes();
+            for (auto column = std::max(runStart, index); column < std::min(runEnd, end); ++column)
+            {
+                til::at(cells, column - index).Attributes = legacyAttributes;
+            }
+        }
+
+        runStart = runEnd;
+        if (runStart >= end)
+        {
+            break;
+        }
+    }
+
+    auto charInfo = cells.begin();
+    for (auto column = index; column < end; ++column, ++charInfo)
+    {
+        const auto& cell = _charRow._cellAt(column);
+        charInfo->Char.UnicodeChar = cell.DbcsAttr().IsGlyphStored() ? Utf16ToUcs2(_charRow.GlyphAt(column)) : cell.Char();
+        charInfo->Attributes |= cell.DbcsAttr().GeneratePublicApiAttributeFormat();
+    }
+}
+
+// Routine Description:
+// - Writes legacy cells to the row, one per column, the same way WriteCells does
+//   with an OutputCellIterator over them but without a view per cell.
+// - Runs of cells with the same colors are committed to the attribute row together.
+// Arguments:
+// - index - column in row to start writing at
+// - cells - the legacy cells to write, which have to fit into the row
+// Return Value:
+// - True if the cells were written.
+// - False if nothing was written, because WriteCells would pad a trailing half in the first
+//   column or a leading half in the last one and shift the remaining cells. Use WriteCells then.
+bool ROW::WriteCharInfos(const size_t index, const gsl::span<const CHAR_INFO> cells)
+{
+    THROW_HR_IF(E_INVALIDARG, index > size() || cells.size() > size() - index);
+
+    if (cells.empty())
+    {
+        return true;
+    }
+
+    const auto isLeading = [](const CHAR_INFO& charInfo) noexcept {
+        return WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_LEADING_BYTE);
+    };
+    const auto isTrailing = [&](const CHAR_INFO& charInfo) noexcept {
+        return !isLeading(charInfo) && WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_TRAILING_BYTE);
+    };
+    if ((index == 0 && isTrailing(cells.front())) || (index + cells.size() == size() && isLeading(cells.back())))
+    {
+        return false;
+    }
+
+    _charRow.WriteLegacyGlyphs(index, cells);
+
+    const auto colorOf = [](const CHAR_INFO& charInfo) noexcept {
+        return gsl::narrow_cast<WORD>(charInfo.Attributes & ~COMMON_LVB_SBCSDBCS);
+    };
+    size_t runStart = 0;
+    for (size_t i = 1; i <= cells.size(); ++i)
+    {
+        if (i == cells.size() || colorOf(til::at(cells, i)) != colorOf(til::at(cells, runStart)))
+        {
+            _attrRow.Replace(gsl::narrow_cast<uint16_t>(index + runStart),
+                             gsl::narrow_cast<uint16_t>(index + i),
+                             TextAttribute{ til::at(cells, runStart).Attributes });
+            runStart = i;
+        }
+    }
+
+    return true;
+}
+
+// Routine Description:
+// - Moves the glyph cells of this row into a compact copy sized to its contents.
+// - Trailing cells in their default state aren't retained. The attributes are
+//   already run length encoded and remain in place.
+// - Afterwards the memory of the row's CharRow may be released by the TextBuffer,
+//   which calls Unpack() before the row is changed again. Until then the const
+//   methods of the CharRow read the packed cells, without changing the row.
+// Arguments:
+// - store - the store to share the cells with other rows through, or nullptr
+//   to keep a copy of the cells that belongs to this row alone
+// Return Value:
+// - <none>
+void ROW::Pack(PackedRowStore* const store)
+{
+    if (_packed)
+    {
+        return;
+    }
+
+    FinishClear();
+
+    auto end = _charRow.cend();
+    while (end != _charRow.cbegin() && *(end - 1) == CharRowCell{})
+    {
+        --end;
+    }
+
+    const gsl::span<const CharRowCell> cells{ _charRow.cbegin(), end };
+    _packedCells = store ? store->Intern(cells) : std::make_shared<const PackedRowStore::Cells>(cells.begin(), cells.end());
+    _packed = true;
+    _charRow._cells = *_packedCells;
+}
+
+// Routine Description:
+// - Restores the glyph cells previously saved by Pack() into the row's CharRow.
+// - The row lets go of the packed cells, so that changing the row afterwards
+//   doesn't affect the other rows that the cells might be shared with.
+// - The memory of the CharRow must be committed again before calling this.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ROW::Unpack() noexcept
+{
+    if (!_packed)
+    {
+        return;
+    }
+
+    // This writes to the cells directly rather than through CharRow::begin(),
+    // as restoring the cells doesn't change the text and shouldn't bump its generation.
+    // A packed row that was reset lazily has no cells left to restore.
+    const auto cells = _charRow._data;
+    auto it = cells.data();
+    if (_packedCells)
+    {
+        it = std::copy(_packedCells->cbegin(), _packedCells->cend(), it);
+    }
+    std::fill(it, cells.data() + cells.size(), CharRowCell{});
+    _charRow._cells = cells;
+
+    _packedCells = {};
+    _packed = false;
+}
+
+// Routine Description:
+// - Finds the right edge of the text of the row, like CharRow::MeasureRight.
+// Arguments:
+// - <none>
+// Return Value:
+// - The column past the last one that isn't a space.
+size_t ROW::MeasureRight() const
+{
+    return _charRow.MeasureRight();
+}
+
+// Routine Description:
+// - Gets the generation of the buffer's ModificationClock in which anything about
+//   this row (its text, attributes or properties like the wrap flag) changed last.
+// Arguments:
+// - <none>
+// Return Value:
+// - the current generation of the row
+uint64_t ROW::GetGeneration() const noexcept
+{
+    return std::max({ _generation, _charRow.GetGeneration(), _attrRow.GetGeneration() });
+}
+
+// Routine Description:
+// - Adds the heap memory used by the row to the given breakdown.
+//   The cells in the arena of the TextBuffer are accounted for by the TextBuffer.
+// Arguments:
+// - usage - the breakdown to add to
+void ROW::AddMemoryUsage(BufferMemoryUsage& usage) const noexcept
+{
+    // Cells shared with other rows are split between them.
+    if (_packedCells)
+    {
+        usage.packedCells += BufferMemoryUsage::Of(*_packedCells) / gsl::narrow_cast<size_t>(_packedCells.use_count());
+    }
+    usage.attributes += _attrRow.GetMemoryUsage();
+    usage.unicodeStorage += _charRow.GetUnicodeStorage().GetMemoryUsage();
+}
+
+// Routine Description:
+// - Gives back the heap memory that the attributes and glyphs of the row
+//   grew to hold at some point, but don't need anymore.
+void ROW::Trim()
+{
+    _attrRow.Trim();
+    _charRow.GetUnicodeStorage().Trim();
+}
+
+// Routine Description:
+// - Like Reset, but leaves clearing the cells to FinishClear, which the TextBuffer
+//   calls before the row gets changed again. Until then the row reads as blank.
+// - Recycling a row for a new line thus doesn't depend on the width of the row.
+//   The generation of the text is bumped right away, as the old text is logically gone.
+// Arguments:
+// - Attr - The default attribute (color) to fill
+// Return Value:
+// - true if the attributes were reset successfully.
+bool ROW::ResetLazily(const TextAttribute Attr)
+{
+    _lineRendition = LineRendition::SingleWidth;
+    _wrapForced = false;
+    _doubleBytePadded = false;
+    _generation = _clock->Tick();
+
+    if (_packed)
+    {
+        // Unpack() fills the cells past the packed ones with default cells,
+        // so a packed row is cleared by dropping what it saved.
+        _packedCells = {};
+        _charRow._cells = {};
+        _charRow._unicodeStorage.Clear();
+        _charRow._Touch();
+    }
+    else if (!_clearPending)
+    {
+        // The cells are only read through _cells, so emptying it makes
+        // the row read as blank right away, without touching the cells.
+        _clearPending = true;
+        _charRow._cells = {};
+        _charRow._unicodeStorage.Clear();
+        _charRow._Touch();
+    }
+
+    try
+    {
+        _attrRow.Reset(Attr);
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        return false;
+    }
+    return true;
+}
+
+// Routine Description:
+// - Clears the cells of a row that was reset by ResetLazily.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ROW::FinishClear() noexcept
+{
+    if (_clearPending)
+    {
+        _charRow.Reset();
+        _clearPending = false;
+    }
+}
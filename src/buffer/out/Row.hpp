@@ -21,9 +21,11 @@ Revision History:
 #pragma once
 
 #include "AttrRow.hpp"
+#include "BufferMemoryUsage.hpp"
 #include "LineRendition.hpp"
 #include "OutputCell.hpp"
 #include "OutputCellIterator.hpp"
+#include "PackedRowStore.hpp"
 #include "CharRow.hpp"
 #include "UnicodeStorage.hpp"
 
@@ -32,14 +34,14 @@ class TextBuffer;
 class ROW final
 {
 public:
-    ROW(const SHORT rowId, const unsigned short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent);
+    ROW(const size_t rowId, gsl::span<CharRowCell> buffer, const TextAttribute fillAttribute, AttributeTable& attributes, ModificationClock& clock, TextBuffer* const pParent);
 
     size_t size() const noexcept { return _rowWidth; }
 
-    void SetWrapForced(const bool wrap) noexcept { _wrapForced = wrap; }
+    void SetWrapForced(const bool wrap) noexcept { _SetProperty(_wrapForced, wrap); }
     bool WasWrapForced() const noexcept { return _wrapForced; }
 
-    void SetDoubleBytePadded(const bool doubleBytePadded) noexcept { _doubleBytePadded = doubleBytePadded; }
+    void SetDoubleBytePadded(const bool doubleBytePadded) noexcept { _SetProperty(_doubleBytePadded, doubleBytePadded); }
     bool WasDoubleBytePadded() const noexcept { return _doubleBytePadded; }
 
     const CharRow& GetCharRow() const noexcept { return _charRow; }
@@ -49,13 +51,16 @@ public:
     ATTR_ROW& GetAttrRow() noexcept { return _attrRow; }
 
     LineRendition GetLineRendition() const noexcept { return _lineRendition; }
-    void SetLineRendition(const LineRendition lineRendition) noexcept { _lineRendition = lineRendition; }
+    void SetLineRendition(const LineRendition lineRendition) noexcept { _SetProperty(_lineRendition, lineRendition); }
 
-    SHORT GetId() const noexcept { return _id; }
-    void SetId(const SHORT id) noexcept { _id = id; }
+    size_t GetId() const noexcept { return _id; }
+    void SetId(const size_t id) noexcept { _id = id; }
 
     bool Reset(const TextAttribute Attr);
-    [[nodiscard]] HRESULT Resize(const unsigned short width);
+    void CopyFrom(const ROW& other);
+    [[nodiscard]] HRESULT Resize(gsl::span<CharRowCell> buffer);
+    ATTR_ROW GetResizedAttrRow(const size_t width) const;
+    void Resize(gsl::span<CharRowCell> buffer, ATTR_ROW&& attrRow) noexcept;
 
     void ClearColumn(const size_t column);
     std::wstring GetText() const { return _charRow.GetText(); }
@@ -64,23 +69,64 @@ public:
     const UnicodeStorage& GetUnicodeStorage() const noexcept;
 
     OutputCellIterator WriteCells(OutputCellIterator it, const size_t index, const std::optional<bool> wrap = std::nullopt, std::optional<size_t> limitRight = std::nullopt);
+    void ReadCharInfos(const size_t index, const gsl::span<CHAR_INFO> cells) const;
+    bool WriteCharInfos(const size_t index, const gsl::span<const CHAR_INFO> cells);
+
+    bool IsPacked() const noexcept { return _packed; }
+    void Pack(PackedRowStore* const store = nullptr);
+    void Unpack() noexcept;
+    size_t MeasureRight() const;
+
+    uint64_t GetGeneration() const noexcept;
+    void AddMemoryUsage(BufferMemoryUsage& usage) const noexcept;
+    void Trim();
+    void MarkModified() noexcept { _generation = _clock->Tick(); }
+
+    bool ResetLazily(const TextAttribute Attr);
+    bool IsClearPending() const noexcept { return _clearPending; }
+    void FinishClear() noexcept;
 
 #ifdef UNIT_TESTING
     friend constexpr bool operator==(const ROW& a, const ROW& b) noexcept;
     friend class RowTests;
+    friend class TextBufferTests;
 #endif
 
 private:
+    // Changes one of the properties of the row, stamping the row if it really changed.
+    template<typename T>
+    void _SetProperty(T& property, const T value) noexcept
+    {
+        if (property != value)
+        {
+            property = value;
+            _generation = _clock->Tick();
+        }
+    }
+
     CharRow _charRow;
     ATTR_ROW _attrRow;
     LineRendition _lineRendition;
-    SHORT _id;
+    size_t _id;
     unsigned short _rowWidth;
     // Occurs when the user runs out of text in a given row and we're forced to wrap the cursor to the next line
     bool _wrapForced;
     // Occurs when the user runs out of text to support a double byte character and we're forced to the next line
     bool _doubleBytePadded;
     TextBuffer* _pParent; // non ownership pointer
+    // While the row is packed into cold storage, this holds its cells (minus trailing
+    // default cells), which the CharRow reads from, and the cells of its arena slot are
+    // invalid. Rows with the same cells may share them, see PackedRowStore, so they're never modified.
+    std::shared_ptr<const PackedRowStore::Cells> _packedCells;
+    bool _packed;
+    // Set by ResetLazily while the cells of the arena slot still hold the old text,
+    // which is logically gone since the generation was bumped and isn't read
+    // anymore, as the CharRow reads the row as blank. See FinishClear.
+    bool _clearPending;
+    // the clock of the TextBuffer, and the generation in which the properties
+    // of this row (rather than its text or attributes) last changed
+    ModificationClock* _clock;
+    uint64_t _generation;
 };
 
 #ifdef UNIT_TESTING
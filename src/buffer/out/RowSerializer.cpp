@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "RowSerializer.hpp"
+#include "Row.hpp"
+
+#include "../../types/inc/GlyphWidth.hpp"
+#include "../../inc/conattrs.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Appends the SGR parameters which select the given color, if it isn't the default one.
+// Arguments:
+// - out - the string to append the parameters to
+// - color - the color to select
+// - isForeground - whether it's the color of the text or the one behind it
+static void _AppendColor(std::wstring& out, const TextColor color, const bool isForeground)
+{
+    if (color.IsIndex16())
+    {
+        // The legacy index has the bits of the Windows console colors, in another order than VT's.
+        const auto index = color.GetIndex();
+        const auto vtIndex = (isForeground ? 30 : 40) +
+                             (WI_IsFlagSet(index, FOREGROUND_INTENSITY) ? 60 : 0) +
+                             (WI_IsFlagSet(index, FOREGROUND_RED) ? 1 : 0) +
+                             (WI_IsFlagSet(index, FOREGROUND_GREEN) ? 2 : 0) +
+                             (WI_IsFlagSet(index, FOREGROUND_BLUE) ? 4 : 0);
+        out.append(fmt::format(L";{}", vtIndex));
+    }
+    else if (color.IsIndex256())
+    {
+        out.append(fmt::format(L";{};5;{}", isForeground ? 38 : 48, ::Xterm256ToWindowsIndex(color.GetIndex())));
+    }
+    else if (color.IsRgb())
+    {
+        const auto rgb = color.GetRGB();
+        out.append(fmt::format(L";{};2;{};{};{}", isForeground ? 38 : 48, GetRValue(rgb), GetGValue(rgb), GetBValue(rgb)));
+    }
+}
+
+// Routine Description:
+// - Creates a serializer which appends the rows it's given to out.
+// Arguments:
+// - out - the string to append the text of the rows to
+// - includeAttributes - whether to write the SGR sequences and line renditions of the text as well
+RowSerializer::RowSerializer(std::wstring& out, const bool includeAttributes) noexcept :
+    _out{ out },
+    _includeAttributes{ includeAttributes }
+{
+}
+
+// Routine Description:
+// - Appends the text of a row of a TextBuffer.
+// - Blanks at the end of a row that didn't wrap are left out, unless
+//   attributes are written and they aren't in the default attributes.
+// Arguments:
+// - row - the row to append
+void RowSerializer::Write(const ROW& row)
+{
+    const auto& charRow = row.GetCharRow();
+    const auto& attrRow = row.GetAttrRow();
+    const auto wrapForced = row.WasWrapForced();
+
+    if (_includeAttributes)
+    {
+        switch (row.GetLineRendition())
+        {
+        case LineRendition::DoubleWidth:
+            _out.append(L"\x1b#6");
+            break;
+        case LineRendition::DoubleHeightTop:
+            _out.append(L"\x1b#3");
+            break;
+        case LineRendition::DoubleHeightBottom:
+            _out.append(L"\x1b#4");
+            break;
+        default:
+            break;
+        }
+    }
+
+    auto end = charRow.size();
+    if (!wrapForced)
+    {
+        while (end > 0 &&
+               std::wstring_view{ charRow.GlyphAt(end - 1) } == L" " &&
+               (!_includeAttributes || *(attrRow.begin() + (end - 1)) == TextAttribute{}))
+        {
+            --end;
+        }
+    }
+
+    auto attr = attrRow.begin();
+    for (size_t column = 0; column < end; ++column, ++attr)
+    {
+        // The trailing half of a wide glyph was already written with its leading half.
+        if (charRow.DbcsAttrAt(column).IsTrailing())
+        {
+            continue;
+        }
+
+        if (_includeAttributes)
+        {
+            _SetAttributes(*attr);
+        }
+        _out.append(std::wstring_view{ charRow.GlyphAt(column) });
+    }
+
+    _EndRow(wrapForced);
+}
+
+// Routine Description:
+// - Appends the text of a row of a ScrollbackArchive.
+// - The archive doesn't keep the blanks at the end of a row, nor its line rendition.
+// Arguments:
+// - row - the row to append
+void RowSerializer::Write(const ScrollbackArchive::Row& row)
+{
+    if (_includeAttributes && !row.attributes.empty())
+    {
+        // The runs of attributes span columns, rather than characters,
+        // so the width of every character is needed to find its run.
+        _columns.resize(row.text.size());
+        GetGlyphColumns(row.text, _columns);
+
+        auto run = row.attributes.begin();
+        size_t runEnd = run->length;
+        size_t column = 0;
+        for (size_t i = 0; i < row.text.size(); ++i)
+        {
+            while (column >= runEnd && run + 1 != row.attributes.end())
+            {
+                ++run;
+                runEnd += run->length;
+            }
+
+            _SetAttributes(run->attr);
+            _out.push_back(til::at(row.text, i));
+            column += til::at(_columns, i);
+        }
+    }
+    else
+    {
+        _out.append(row.text);
+    }
+
+    _EndRow(row.wrapForced);
+}
+
+// Routine Description:
+// - Appends the SGR sequence which changes from the attributes that were written last to the given
+//   ones. The sequence starts with a reset, so that it doesn't depend on what came before it.
+// Arguments:
+// - attributes - the attributes of the text that's appended next
+void RowSerializer::_SetAttributes(const TextAttribute& attributes)
+{
+    if (attributes == _attributes)
+    {
+        return;
+    }
+    _attributes = attributes;
+
+    _out.append(L"\x1b[0");
+    if (attributes.IsBold())
+    {
+        _out.append(L";1");
+    }
+    if (attributes.IsFaint())
+    {
+        _out.append(L";2");
+    }
+    if (attributes.IsItalic())
+    {
+        _out.append(L";3");
+    }
+    if (attributes.IsDoublyUnderlined())
+    {
+        _out.append(L";21");
+    }
+    else if (attributes.IsUnderlined())
+    {
+        _out.append(L";4");
+    }
+    if (attributes.IsBlinking())
+    {
+        _out.append(L";5");
+    }
+    if (attributes.IsReverseVideo())
+    {
+        _out.append(L";7");
+    }
+    if (attributes.IsInvisible())
+    {
+        _out.append(L";8");
+    }
+    if (attributes.IsCrossedOut())
+    {
+        _out.append(L";9");
+    }
+    if (attributes.IsOverlined())
+    {
+        _out.append(L";53");
+    }
+    _AppendColor(_out, attributes.GetForeground(), true);
+    _AppendColor(_out, attributes.GetBackground(), false);
+    _out.push_back(L'm');
+}
+
+// Routine Description:
+// - Ends the row that was just written, with a line break unless it wrapped into the next one.
+// - The attributes are reset before the line break, so that the background color
+//   of the row doesn't bleed into the next one when the output is replayed.
+// Arguments:
+// - wrapForced - whether the row wrapped into the next one
+void RowSerializer::_EndRow(const bool wrapForced)
+{
+    if (wrapForced)
+    {
+        return;
+    }
+
+    if (_includeAttributes && _attributes != TextAttribute{})
+    {
+        _attributes = {};
+        _out.append(L"\x1b[0m");
+    }
+    _out.append(L"\r\n");
+}
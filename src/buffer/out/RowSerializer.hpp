@@ -0,0 +1,40 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- RowSerializer.hpp
+
+Abstract:
+- Formats the rows of a TextBuffer (or of its ScrollbackArchive) as text, one
+  row at a time, so that a buffer can be written out without holding all of
+  its text at once.
+- Rows which wrapped into the next one aren't followed by a line break. With
+  attributes, the text is preceded by the SGR sequences (and line renditions)
+  which reproduce how it looked, so that the output can be replayed as VT.
+--*/
+
+#pragma once
+
+#include "ScrollbackArchive.hpp"
+
+class ROW;
+
+class RowSerializer final
+{
+public:
+    RowSerializer(std::wstring& out, const bool includeAttributes) noexcept;
+
+    void Write(const ROW& row);
+    void Write(const ScrollbackArchive::Row& row);
+
+private:
+    void _SetAttributes(const TextAttribute& attributes);
+    void _EndRow(const bool wrapForced);
+
+    std::wstring& _out;
+    bool _includeAttributes;
+    // the attributes of the text that was written last
+    TextAttribute _attributes;
+    std::vector<uint8_t> _columns;
+};
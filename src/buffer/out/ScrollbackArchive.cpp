@@ -0,0 +1,278 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "ScrollbackArchive.hpp"
+#include "BufferMemoryUsage.hpp"
+#include "Row.hpp"
+
+// The archive is memory mapped in its entirety and grows in steps of this size.
+static constexpr uint64_t s_growthStep = 16 * 1024 * 1024;
+
+static_assert(std::is_trivially_copyable_v<TextAttribute>, "TextAttribute is stored verbatim in the archive");
+
+// Routine Description:
+// - Creates a new, empty archive backed by a temporary file,
+//   which is deleted by the OS as soon as the archive is destroyed.
+// Arguments:
+// - maximumSize - the number of bytes of rows the file holds, before the oldest rows are dropped
+// Return Value:
+// - constructed object
+// Note: will throw exception if unable to create the backing file
+ScrollbackArchive::ScrollbackArchive(const uint64_t maximumSize) :
+    _maximumSize{ maximumSize }
+{
+    wchar_t directory[MAX_PATH + 1];
+    THROW_LAST_ERROR_IF(GetTempPathW(ARRAYSIZE(directory), directory) == 0);
+
+    wchar_t path[MAX_PATH + 1];
+    THROW_LAST_ERROR_IF(GetTempFileNameW(directory, L"csb", 0, path) == 0);
+
+    _file.reset(CreateFileW(path,
+                            GENERIC_READ | GENERIC_WRITE,
+                            0,
+                            nullptr,
+                            CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                            nullptr));
+    THROW_LAST_ERROR_IF(!_file);
+}
+
+// Routine Description:
+// - gets the number of rows stored in the archive
+// Arguments:
+// - <none>
+// Return Value:
+// - the number of rows
+size_t ScrollbackArchive::size() const noexcept
+{
+    return _offsets.size();
+}
+
+// Routine Description:
+// - Estimates the heap memory used by the archive. The archived rows themselves are
+//   mapped from the file and paged in and out by the OS, see GetFileSize.
+// Return Value:
+// - the size in bytes
+size_t ScrollbackArchive::GetMemoryUsage() const noexcept
+{
+    return BufferMemoryUsage::Of(_offsets) + BufferMemoryUsage::Of(_textScratch) + BufferMemoryUsage::Of(_runScratch);
+}
+
+// Routine Description:
+// - Gets the number of bytes of archived rows in the file backing the archive.
+// Return Value:
+// - the size in bytes
+uint64_t ScrollbackArchive::GetFileSize() const noexcept
+{
+    return _size;
+}
+
+// Routine Description:
+// - Gets the number of rows that were dropped from the front of the archive
+//   to keep the file within its maximum size. The index of every remaining
+//   row went down by as many.
+// Return Value:
+// - the number of rows dropped since the archive was created
+uint64_t ScrollbackArchive::GetDroppedRowCount() const noexcept
+{
+    return _droppedRows;
+}
+
+// Routine Description:
+// - appends the given row to the end of the archive
+// - trailing spaces are trimmed and the attributes are run length encoded.
+// Arguments:
+// - row - the row to store
+// Return Value:
+// - <none>
+// Note: will throw exception if unable to grow the backing file
+void ScrollbackArchive::Append(const ROW& row)
+{
+    const auto& charRow = row.GetCharRow();
+    const auto width = charRow.MeasureRight();
+
+    _textScratch.clear();
+    for (size_t i = 0; i < width; ++i)
+    {
+        if (!charRow.DbcsAttrAt(i).IsTrailing())
+        {
+            const std::wstring_view glyph = charRow.GlyphAt(i);
+            _textScratch.insert(_textScratch.end(), glyph.begin(), glyph.end());
+        }
+    }
+
+    _runScratch.clear();
+    for (const auto& attr : row.GetAttrRow())
+    {
+        if (!_runScratch.empty() && _runScratch.back().attr == attr)
+        {
+            ++_runScratch.back().length;
+        }
+        else
+        {
+            _runScratch.push_back({ attr, 1 });
+        }
+    }
+
+    const RowHeader header{
+        gsl::narrow<uint32_t>(_textScratch.size()),
+        gsl::narrow<uint16_t>(_runScratch.size()),
+        row.WasWrapForced() ? WrapForcedFlag : uint16_t{}
+    };
+
+    // Runs follow the text, so we align them to keep the reads of TextAttribute aligned.
+    const auto textBytes = _textScratch.size() * sizeof(wchar_t);
+    const auto runOffset = (sizeof(header) + textBytes + alignof(Run) - 1) / alignof(Run) * alignof(Run);
+    const auto entryBytes = runOffset + _runScratch.size() * sizeof(Run);
+    if (_size + entryBytes > _maximumSize)
+    {
+        _DropOldest();
+    }
+    const auto offset = (_size + alignof(RowHeader) - 1) / alignof(RowHeader) * alignof(RowHeader);
+
+    _EnsureCapacity(offset + entryBytes);
+
+    const auto entry = _view.get() + offset;
+    memcpy(entry, &header, sizeof(header));
+    memcpy(entry + sizeof(header), _textScratch.data(), textBytes);
+    memcpy(entry + runOffset, _runScratch.data(), _runScratch.size() * sizeof(Run));
+
+    _offsets.emplace_back(offset);
+    _size = offset + entryBytes;
+}
+
+// Routine Description:
+// - retrieves a previously archived row.
+// - The returned views point into the mapped file and stay valid until the next call to Append().
+// Arguments:
+// - index - the row to retrieve, 0 being the oldest row in the archive
+// Return Value:
+// - the row's text and attributes
+// Note: will throw exception if index is out of bounds
+ScrollbackArchive::Row ScrollbackArchive::GetRow(const size_t index) const
+{
+    const auto entry = _view.get() + _offsets.at(index);
+
+    RowHeader header;
+    memcpy(&header, entry, sizeof(header));
+
+    const auto textBytes = static_cast<size_t>(header.textLength) * sizeof(wchar_t);
+    const auto runOffset = (sizeof(header) + textBytes + alignof(Run) - 1) / alignof(Run) * alignof(Run);
+
+#pragma warning(push)
+#pragma warning(disable : 26490) // The archive stores these types verbatim, see Append().
+    return {
+        { reinterpret_cast<const wchar_t*>(entry + sizeof(header)), header.textLength },
+        { reinterpret_cast<const Run*>(entry + runOffset), header.runCount },
+        WI_IsFlagSet(header.flags, WrapForcedFlag)
+    };
+#pragma warning(pop)
+}
+
+// Routine Description:
+// - Removes the given number of rows from the end of the archive, after they
+//   were moved back into the buffer. Their space is reused by the next rows.
+// Arguments:
+// - count - the number of rows to remove
+// Return Value:
+// - <none>
+void ScrollbackArchive::DropNewest(const size_t count) noexcept
+{
+    const auto kept = _offsets.size() - std::min(count, _offsets.size());
+    if (kept < _offsets.size())
+    {
+        _size = til::at(_offsets, kept);
+        _offsets.erase(_offsets.begin() + kept, _offsets.end());
+    }
+}
+
+// Routine Description:
+// - Finds the newest row whose text contains the needle, for a search going up
+//   past the top of the buffer.
+// - Rows are searched one by one, so text that wraps into the next row isn't found.
+// Arguments:
+// - needle - the text to find
+// - caseSensitive - whether the case of the text has to match
+// - first - the oldest row to look at
+// Return Value:
+// - the index of the row, if the text was found
+std::optional<size_t> ScrollbackArchive::FindBackward(const std::wstring_view needle, const bool caseSensitive, const size_t first) const
+{
+    const auto equals = [caseSensitive](const wchar_t a, const wchar_t b) noexcept {
+        return caseSensitive ? a == b : ::towlower(a) == ::towlower(b);
+    };
+
+    for (auto index = _offsets.size(); index > first;)
+    {
+        --index;
+        const auto text = GetRow(index).text;
+        if (std::search(text.begin(), text.end(), needle.begin(), needle.end(), equals) != text.end())
+        {
+            return index;
+        }
+    }
+    return std::nullopt;
+}
+
+// Routine Description:
+// - grows the backing file and its mapping so that it can hold at least the given number of bytes
+// Arguments:
+// - size - the number of bytes that need to fit into the file
+// Return Value:
+// - <none>
+void ScrollbackArchive::_EnsureCapacity(const uint64_t size)
+{
+    if (size <= _capacity)
+    {
+        return;
+    }
+
+    const auto capacity = (size + s_growthStep - 1) / s_growthStep * s_growthStep;
+
+    // The view has to go before the mapping can be recreated with a larger size.
+    _view.reset();
+    _mapping.reset(CreateFileMappingW(_file.get(),
+                                      nullptr,
+                                      PAGE_READWRITE,
+                                      gsl::narrow_cast<DWORD>(capacity >> 32),
+                                      gsl::narrow_cast<DWORD>(capacity),
+                                      nullptr));
+    THROW_LAST_ERROR_IF(!_mapping);
+
+    _view.reset(static_cast<std::byte*>(MapViewOfFile(_mapping.get(), FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0)));
+    THROW_LAST_ERROR_IF(!_view);
+
+    _capacity = capacity;
+}
+
+// Routine Description:
+// - Makes room for new rows once the file has reached its maximum size, by
+//   dropping the oldest rows until at most half of the maximum size is left,
+//   and moving the remaining rows to the front of the file.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ScrollbackArchive::_DropOldest()
+{
+    const auto keep = _maximumSize / 2;
+    const auto it = std::lower_bound(_offsets.begin(), _offsets.end(), _size > keep ? _size - keep : 0);
+    const auto dropped = gsl::narrow_cast<size_t>(it - _offsets.begin());
+    if (dropped == 0)
+    {
+        return;
+    }
+
+    // The offsets are aligned, so the rows that move to the front stay aligned as well.
+    const auto base = it != _offsets.end() ? *it : _size;
+    memmove(_view.get(), _view.get() + base, gsl::narrow_cast<size_t>(_size - base));
+
+    _offsets.erase(_offsets.begin(), it);
+    for (auto& offset : _offsets)
+    {
+        offset -= base;
+    }
+    _size -= base;
+    _droppedRows += dropped;
+}
@@ -0,0 +1,75 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ScrollbackArchive.hpp
+
+Abstract:
+- Disk backed storage for rows that have scrolled out of the top of a TextBuffer.
+- Rows are appended to a temporary, memory mapped file in a compact format
+  (the text without trailing spaces, followed by the run length encoded
+  attributes). Only an offset per row is kept in memory, the row contents are
+  paged in by the OS when they're read back.
+- The file is capped in size. Once it's full, the oldest half of the rows is
+  dropped to make room for new ones.
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class ROW;
+
+class ScrollbackArchive final
+{
+public:
+    struct Run
+    {
+        TextAttribute attr;
+        uint16_t length;
+    };
+
+    struct Row
+    {
+        std::wstring_view text;
+        gsl::span<const Run> attributes;
+        bool wrapForced;
+    };
+
+    static constexpr uint64_t DefaultMaximumSize = 1024 * 1024 * 1024;
+
+    ScrollbackArchive(const uint64_t maximumSize = DefaultMaximumSize);
+
+    size_t size() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+    uint64_t GetFileSize() const noexcept;
+    uint64_t GetDroppedRowCount() const noexcept;
+    void Append(const ROW& row);
+    Row GetRow(const size_t index) const;
+    void DropNewest(const size_t count) noexcept;
+    std::optional<size_t> FindBackward(const std::wstring_view needle, const bool caseSensitive, const size_t first) const;
+
+private:
+    struct RowHeader
+    {
+        uint32_t textLength;
+        uint16_t runCount;
+        uint16_t flags;
+    };
+    static constexpr uint16_t WrapForcedFlag = 0x1;
+
+    void _EnsureCapacity(const uint64_t size);
+    void _DropOldest();
+
+    wil::unique_hfile _file;
+    wil::unique_handle _mapping;
+    wil::unique_mapview_ptr<std::byte> _view;
+    uint64_t _capacity = 0;
+    uint64_t _size = 0;
+    uint64_t _maximumSize;
+    uint64_t _droppedRows = 0;
+    std::vector<uint64_t> _offsets;
+    std::vector<wchar_t> _textScratch;
+    std::vector<Run> _runScratch;
+};
@@ -0,0 +1,140 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "SearchIndex.hpp"
+#include "BufferMemoryUsage.hpp"
+
+#include "Row.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Computes the trigrams of a search term, as created by Search::s_CreateNeedleFromString
+// Arguments:
+// - cells - the text of the search term, cell by cell
+// Return Value:
+// - the trigrams, empty if the search term is too short to make use of the index
+SearchIndex::Needle SearchIndex::s_HashNeedle(const std::vector<std::vector<wchar_t>>& cells)
+{
+    Needle needle;
+    for (size_t i = 2; i < cells.size(); ++i)
+    {
+        needle.push_back(s_Hash(til::at(cells, i - 2).front(), til::at(cells, i - 1).front(), til::at(cells, i).front()));
+    }
+    std::sort(needle.begin(), needle.end());
+    needle.erase(std::unique(needle.begin(), needle.end()), needle.end());
+    return needle;
+}
+
+// Routine Description:
+// - Forgets all blocks. This needs to happen whenever rows move within the storage of the TextBuffer.
+void SearchIndex::Clear() noexcept
+{
+    _blocks.clear();
+}
+
+// Routine Description:
+// - Estimates the heap memory used by the index.
+// Return Value:
+// - the size in bytes
+size_t SearchIndex::GetMemoryUsage() const noexcept
+{
+    auto bytes = BufferMemoryUsage::Of(_blocks);
+    for (const auto& block : _blocks)
+    {
+        if (block)
+        {
+            bytes += sizeof(Block) + BufferMemoryUsage::Of(block->generations);
+        }
+    }
+    return bytes;
+}
+
+// Routine Description:
+// - Checks whether the given block was indexed with the rows in their current state
+// Arguments:
+// - block - the index of the block
+// - generations - the current generations of the rows of the block, see Update
+// Return Value:
+// - True if the bitmap of the block can be used as is.
+bool SearchIndex::IsCurrent(const size_t block, const std::vector<uint64_t>& generations) const noexcept
+{
+    return block < _blocks.size() && til::at(_blocks, block) && til::at(_blocks, block)->generations == generations;
+}
+
+// Routine Description:
+// - Indexes the text of a block
+// Arguments:
+// - block - the index of the block
+// - generations - the generations of the rows, see CharRow::GetGeneration
+// - rows - the rows of the block followed by the row after it, since a match
+//   starting within the block may continue into the next row
+void SearchIndex::Update(const size_t block, std::vector<uint64_t> generations, const std::vector<const ROW*>& rows)
+{
+    if (block >= _blocks.size())
+    {
+        _blocks.resize(block + 1);
+    }
+
+    auto& entry = til::at(_blocks, block);
+    if (!entry)
+    {
+        entry = std::make_unique<Block>();
+    }
+    entry->generations = std::move(generations);
+    entry->trigrams.reset();
+
+    // a sliding window over the first characters of the last 3 cells
+    wchar_t first = L'\0';
+    wchar_t second = L'\0';
+    size_t cells = 0;
+    for (const auto row : rows)
+    {
+        const auto& charRow = row->GetCharRow();
+        for (size_t column = 0; column < charRow.size(); ++column)
+        {
+            const auto third = *charRow.GlyphAt(column).begin();
+            if (++cells >= 3)
+            {
+                entry->trigrams.set(s_Hash(first, second, third));
+            }
+            first = second;
+            second = third;
+        }
+    }
+}
+
+// Routine Description:
+// - Checks whether a match of the search term could start in the given block
+// Arguments:
+// - block - the index of the block, which has to be current, see IsCurrent
+// - needle - the trigrams of the search term
+// Return Value:
+// - False if the block can't contain a match. True if it might.
+bool SearchIndex::MayContain(const size_t block, const Needle& needle) const noexcept
+{
+    if (block >= _blocks.size() || !til::at(_blocks, block))
+    {
+        return true;
+    }
+
+    const auto& trigrams = til::at(_blocks, block)->trigrams;
+    return std::all_of(needle.cbegin(), needle.cend(), [&](const uint16_t trigram) noexcept {
+        return trigrams[trigram];
+    });
+}
+
+wchar_t SearchIndex::s_Fold(const wchar_t wch) noexcept
+{
+    return ::towlower(wch);
+}
+
+uint16_t SearchIndex::s_Hash(const wchar_t first, const wchar_t second, const wchar_t third) noexcept
+{
+    const auto hash = static_cast<uint32_t>(s_Fold(first)) * 0x9E3779B1u ^
+                      static_cast<uint32_t>(s_Fold(second)) * 0x85EBCA77u ^
+                      static_cast<uint32_t>(s_Fold(third)) * 0xC2B2AE3Du;
+    return gsl::narrow_cast<uint16_t>((hash >> 16) % s_Bits);
+}
@@ -0,0 +1,59 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SearchIndex.hpp
+
+Abstract:
+- An index over the text of a TextBuffer that lets Search skip over rows
+  which can't possibly contain the text it's looking for.
+- The rows are grouped into blocks of BlockHeight rows (by their position in
+  the TextBuffer's storage, so that blocks stay put as the buffer circles).
+  For each block a bitmap of the (hashed) trigrams of its text is kept, along
+  with the generations of its rows at the time the bitmap was built. A block
+  is only reindexed once one of its rows changed.
+- Case is folded, so the index works for both case sensitive and insensitive searches.
+--*/
+
+#pragma once
+
+#include <bitset>
+
+class ROW;
+
+class SearchIndex final
+{
+public:
+    static constexpr size_t BlockHeight = 32;
+
+    // the trigrams of a search term, in terms of bits of the block bitmaps
+    using Needle = std::vector<uint16_t>;
+
+    static Needle s_HashNeedle(const std::vector<std::vector<wchar_t>>& cells);
+
+    void Clear() noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+    bool IsCurrent(const size_t block, const std::vector<uint64_t>& generations) const noexcept;
+    void Update(const size_t block, std::vector<uint64_t> generations, const std::vector<const ROW*>& rows);
+    bool MayContain(const size_t block, const Needle& needle) const noexcept;
+
+private:
+    static constexpr size_t s_Bits = 8192;
+
+    static wchar_t s_Fold(const wchar_t wch) noexcept;
+    static uint16_t s_Hash(const wchar_t first, const wchar_t second, const wchar_t third) noexcept;
+
+    struct Block
+    {
+        std::vector<uint64_t> generations;
+        std::bitset<s_Bits> trigrams;
+    };
+
+    std::vector<std::unique_ptr<Block>> _blocks;
+
+#ifdef UNIT_TESTING
+    friend class SearchTests;
+#endif
+};
@@ -0,0 +1,326 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "SixelDecoder.hpp"
+
+#pragma hdrstop
+
+static constexpr uint32_t s_Rgb(const ptrdiff_t r, const ptrdiff_t g, const ptrdiff_t b) noexcept
+{
+    // Colors come in percent, and are opaque, so they're premultiplied as they are.
+    const auto scale = [](const ptrdiff_t percent) noexcept {
+        return gsl::narrow_cast<uint32_t>((std::clamp<ptrdiff_t>(percent, 0, 100) * 255 + 50) / 100);
+    };
+    return 0xff000000 | scale(r) << 16 | scale(g) << 8 | scale(b);
+}
+
+// The 16 colors the registers of a VT340 start with.
+static constexpr std::array<uint32_t, 16> s_DefaultColors{
+    s_Rgb(0, 0, 0),
+    s_Rgb(20, 20, 80),
+    s_Rgb(80, 13, 13),
+    s_Rgb(20, 80, 20),
+    s_Rgb(80, 20, 80),
+    s_Rgb(20, 80, 80),
+    s_Rgb(80, 80, 20),
+    s_Rgb(53, 53, 53),
+    s_Rgb(26, 26, 26),
+    s_Rgb(33, 33, 60),
+    s_Rgb(60, 26, 26),
+    s_Rgb(33, 60, 33),
+    s_Rgb(60, 33, 60),
+    s_Rgb(33, 60, 60),
+    s_Rgb(60, 60, 33),
+    s_Rgb(80, 80, 80),
+};
+
+// Routine Description:
+// - Converts a color given in the HLS notation of sixels to RGB.
+// Arguments:
+// - hue - the angle of the hue in degrees, where 0 is blue (and not red)
+// - lightness - the lightness in percent
+// - saturation - the saturation in percent
+// Return Value:
+// - the color, as an opaque BGRA pixel
+static uint32_t s_Hls(const ptrdiff_t hue, const ptrdiff_t lightness, const ptrdiff_t saturation) noexcept
+{
+    const auto h = static_cast<double>((hue + 240) % 360) / 60.0;
+    const auto l = std::clamp<ptrdiff_t>(lightness, 0, 100) / 100.0;
+    const auto s = std::clamp<ptrdiff_t>(saturation, 0, 100) / 100.0;
+
+    const auto chroma = (1.0 - std::abs(2.0 * l - 1.0)) * s;
+    const auto x = chroma * (1.0 - std::abs(std::fmod(h, 2.0) - 1.0));
+    const auto m = l - chroma / 2.0;
+
+    double r = 0, g = 0, b = 0;
+    switch (static_cast<int>(h))
+    {
+    case 0:
+        r = chroma, g = x;
+        break;
+    case 1:
+        r = x, g = chroma;
+        break;
+    case 2:
+        g = chroma, b = x;
+        break;
+    case 3:
+        g = x, b = chroma;
+        break;
+    case 4:
+        r = x, b = chroma;
+        break;
+    default:
+        r = chroma, b = x;
+        break;
+    }
+
+    const auto percent = [m](const double value) noexcept {
+        return gsl::narrow_cast<ptrdiff_t>(std::lround((value + m) * 100.0));
+    };
+    return s_Rgb(percent(r), percent(g), percent(b));
+}
+
+// Routine Description:
+// - Creates a decoder for a single image.
+// Arguments:
+// - transparentBackground - whether the pixels that no sixel is drawn on are
+//   left transparent (P2 = 1), or filled with the color of register 0
+SixelDecoder::SixelDecoder(const bool transparentBackground) noexcept :
+    _transparentBackground{ transparentBackground }
+{
+    for (size_t i = 0; i < _colors.size(); ++i)
+    {
+        til::at(_colors, i) = til::at(s_DefaultColors, i % s_DefaultColors.size());
+    }
+    // Sixels are drawn with the color of register 1 until another is selected, as on a VT340.
+    _color = til::at(_colors, 1);
+}
+
+// Routine Description:
+// - Decodes the next character of the data of the image.
+// Arguments:
+// - wch - the character
+void SixelDecoder::Put(const wchar_t wch)
+{
+    if (wch >= L'0' && wch <= L'9')
+    {
+        auto& parameter = til::at(_parameters, _parameterCount);
+        // Anything above the size of the largest image doesn't mean anything else.
+        parameter = std::min<ptrdiff_t>(parameter * 10 + (wch - L'0'), MaxImageSize * 10);
+        return;
+    }
+    if (wch == L';')
+    {
+        _parameterCount = std::min(_parameterCount + 1, MaxParameters - 1);
+        return;
+    }
+
+    if (_state != State::Data)
+    {
+        _EndControlFunction();
+    }
+
+    switch (wch)
+    {
+    case L'!':
+        _state = State::Repeat;
+        break;
+    case L'"':
+        _state = State::Raster;
+        break;
+    case L'#':
+        _state = State::Color;
+        break;
+    case L'$':
+        // DECGCR: back to the start of the line of sixels.
+        _x = 0;
+        break;
+    case L'-':
+        // DECGNL: down to the next line of sixels.
+        _x = 0;
+        _y += 6;
+        break;
+    default:
+        if (wch >= L'?' && wch <= L'~')
+        {
+            _WriteSixel(gsl::narrow_cast<uint8_t>(wch - L'?'));
+        }
+        // Anything else (like line breaks) is ignored.
+        break;
+    }
+}
+
+// Routine Description:
+// - Applies the repeat, raster attributes or color that were introduced
+//   with their parameters, now that the parameters are complete.
+void SixelDecoder::_EndControlFunction() noexcept
+{
+    switch (_state)
+    {
+    case State::Repeat:
+        _repeat = std::max<ptrdiff_t>(til::at(_parameters, 0), 1);
+        break;
+    case State::Raster:
+        _declaredWidth = std::min(til::at(_parameters, 2), MaxImageSize);
+        _declaredHeight = std::min(til::at(_parameters, 3), MaxImageSize);
+        break;
+    case State::Color:
+        _DefineColor();
+        break;
+    default:
+        break;
+    }
+
+    _state = State::Data;
+    _parameters = {};
+    _parameterCount = 0;
+}
+
+// Routine Description:
+// - Selects the color register given by DECGCI, and defines its color first,
+//   if the color was given as well.
+void SixelDecoder::_DefineColor() noexcept
+{
+    auto& color = til::at(_colors, gsl::narrow_cast<size_t>(til::at(_parameters, 0)) % MaxColors);
+    if (_parameterCount >= 4)
+    {
+        const auto x = til::at(_parameters, 2);
+        const auto y = til::at(_parameters, 3);
+        const auto z = til::at(_parameters, 4);
+        switch (til::at(_parameters, 1))
+        {
+        case 1:
+            color = s_Hls(x, y, z);
+            break;
+        case 2:
+            color = s_Rgb(x, y, z);
+            break;
+        default:
+            break;
+        }
+    }
+    _color = color;
+}
+
+// Routine Description:
+// - Draws the given sixel at the current position, as many times as it's
+//   repeated, and moves past it.
+// Arguments:
+// - bits - the pixels of the sixel, from the top one in the lowest bit
+void SixelDecoder::_WriteSixel(const uint8_t bits)
+{
+    const auto begin = _x;
+    const auto end = std::min(_x + _repeat, MaxImageSize);
+    _x += _repeat;
+    _repeat = 1;
+
+    if (bits == 0 || begin >= end || _y >= MaxImageSize)
+    {
+        return;
+    }
+
+    // Only the rows up to the lowest pixel that's set count toward the height of the image.
+    ptrdiff_t height = 0;
+    for (auto bit = 0; bit < 6; ++bit)
+    {
+        if ((bits & (1 << bit)) != 0)
+        {
+            height = bit + 1;
+        }
+    }
+    height = std::min(_y + height, MaxImageSize) - _y;
+
+    _Reserve(end, _y + height);
+    _width = std::max(_width, end);
+    _height = std::max(_height, _y + height);
+
+    for (ptrdiff_t bit = 0; bit < height; ++bit)
+    {
+        if ((bits & (1 << bit)) != 0)
+        {
+            const auto row = _pixels.begin() + (_y + bit) * _stride;
+            std::fill(row + begin, row + end, _color);
+        }
+    }
+}
+
+// Routine Description:
+// - Makes room for at least the given number of pixels. The room grows
+//   geometrically, so that an image that grows a sixel at a time is only
+//   copied a few times.
+// Arguments:
+// - width - the number of columns of pixels that are needed
+// - height - the number of rows of pixels that are needed
+void SixelDecoder::_Reserve(const ptrdiff_t width, const ptrdiff_t height)
+{
+    if (width <= _stride && height <= _rows)
+    {
+        return;
+    }
+
+    const auto stride = width <= _stride ? _stride : std::min(std::max<ptrdiff_t>({ width, _stride * 2, 64 }), MaxImageSize);
+    const auto rows = height <= _rows ? _rows : std::min(std::max<ptrdiff_t>({ height, _rows * 2, 6 }), MaxImageSize);
+
+    if (stride == _stride)
+    {
+        // The rows are laid out the same, so the new ones just go below the others.
+        _pixels.resize(gsl::narrow_cast<size_t>(stride * rows));
+    }
+    else
+    {
+        std::vector<uint32_t> pixels(gsl::narrow_cast<size_t>(stride * rows));
+        for (ptrdiff_t y = 0; y < _height; ++y)
+        {
+            const auto row = _pixels.begin() + y * _stride;
+            std::copy(row, row + _width, pixels.begin() + y * stride);
+        }
+        _pixels = std::move(pixels);
+    }
+
+    _stride = stride;
+    _rows = rows;
+}
+
+// Routine Description:
+// - Completes the image, once all of its data was put into the decoder.
+// - The image is as large as all of its sixels, or the size its raster attributes
+//   gave, whichever is larger. The decoder can't be used anymore afterwards.
+// Return Value:
+// - The image, or nullptr if it's empty.
+std::shared_ptr<const ImageStore::Image> SixelDecoder::Finish()
+{
+    if (_state != State::Data)
+    {
+        _EndControlFunction();
+    }
+
+    const auto width = std::max(_width, _declaredWidth);
+    const auto height = std::max(_height, _declaredHeight);
+    if (width <= 0 || height <= 0)
+    {
+        return nullptr;
+    }
+
+    _Reserve(width, height);
+
+    auto image = std::make_shared<ImageStore::Image>();
+    image->id = ImageStore::NextImageId();
+    image->size = { width, height };
+    image->pixels.resize(gsl::narrow_cast<size_t>(width * height));
+
+    const auto background = _transparentBackground ? 0 : til::at(_colors, 0);
+    auto out = image->pixels.begin();
+    for (ptrdiff_t y = 0; y < height; ++y)
+    {
+        const auto row = _pixels.begin() + y * _stride;
+        out = std::transform(row, row + width, out, [=](const uint32_t pixel) noexcept {
+            return pixel ? pixel : background;
+        });
+    }
+
+    _pixels = {};
+    return image;
+}
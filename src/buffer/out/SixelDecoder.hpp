@@ -0,0 +1,74 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SixelDecoder.hpp
+
+Abstract:
+- Decodes the data of a sixel image (DECSIXEL, DCS q) into the pixels of an
+  ImageStore::Image.
+- The data is decoded one character at a time, as it arrives from the state
+  machine, so that an image doesn't have to be buffered as text before it's
+  decoded, and the cost of a character is the same no matter how large the
+  image gets. The decoded pixels grow along with the image.
+- The pixel aspect ratio of the raster attributes is ignored, like modern
+  terminals do: every sixel is a square pixel of the VT340's 10x20 cells.
+--*/
+
+#pragma once
+
+#include "ImageStore.hpp"
+
+class SixelDecoder final
+{
+public:
+    // Images are clipped to this many pixels in either direction.
+    static constexpr ptrdiff_t MaxImageSize = 2048;
+
+    explicit SixelDecoder(const bool transparentBackground) noexcept;
+
+    void Put(const wchar_t wch);
+    std::shared_ptr<const ImageStore::Image> Finish();
+
+private:
+    enum class State : uint8_t
+    {
+        Data,
+        Repeat, // DECGRI
+        Raster, // DECGRA
+        Color, // DECGCI
+    };
+
+    void _EndControlFunction() noexcept;
+    void _DefineColor() noexcept;
+    void _WriteSixel(const uint8_t bits);
+    void _Reserve(const ptrdiff_t width, const ptrdiff_t height);
+
+    static constexpr size_t MaxParameters = 5;
+    static constexpr size_t MaxColors = 256;
+
+    State _state{ State::Data };
+    std::array<ptrdiff_t, MaxParameters> _parameters{};
+    size_t _parameterCount{ 0 };
+
+    std::array<uint32_t, MaxColors> _colors;
+    uint32_t _color;
+    ptrdiff_t _repeat{ 1 };
+    bool _transparentBackground;
+
+    // the position of the next sixel
+    ptrdiff_t _x{ 0 };
+    ptrdiff_t _y{ 0 };
+
+    // the extent of the sixels drawn so far, and the size given by the raster attributes
+    ptrdiff_t _width{ 0 };
+    ptrdiff_t _height{ 0 };
+    ptrdiff_t _declaredWidth{ 0 };
+    ptrdiff_t _declaredHeight{ 0 };
+
+    // The pixels drawn so far, with room for more. Unset pixels are 0.
+    std::vector<uint32_t> _pixels;
+    ptrdiff_t _stride{ 0 };
+    ptrdiff_t _rows{ 0 };
+};
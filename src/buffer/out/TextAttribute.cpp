@@ -352,6 +352,24 @@ void TextAttribute::SetReverseVideo(bool isReversed) noexcept
     WI_UpdateFlag(_wAttrLegacy, COMMON_LVB_REVERSE_VIDEO, isReversed);
 }
 
+// Method Description:
+// - Clears and then sets any number of the meta attributes at once.
+// Arguments:
+// - setExtended - the extended attributes to set
+// - clearExtended - the extended attributes to clear
+// - setLegacy - the legacy meta attributes (like COMMON_LVB_REVERSE_VIDEO) to set
+// - clearLegacy - the legacy meta attributes to clear
+// Return Value:
+// - <none>
+void TextAttribute::UpdateMetaAttrs(const ExtendedAttributes setExtended,
+                                    const ExtendedAttributes clearExtended,
+                                    const WORD setLegacy,
+                                    const WORD clearLegacy) noexcept
+{
+    _extendedAttrs = (_extendedAttrs & ~clearExtended) | setExtended;
+    _wAttrLegacy = gsl::narrow_cast<uint16_t>((_wAttrLegacy & ~clearLegacy) | setLegacy);
+}
+
 ExtendedAttributes TextAttribute::GetExtendedAttributes() const noexcept
 {
     return _extendedAttrs;
@@ -111,6 +111,10 @@ public:
     void SetDoublyUnderlined(bool isDoublyUnderlined) noexcept;
     void SetOverlined(bool isOverlined) noexcept;
     void SetReverseVideo(bool isReversed) noexcept;
+    void UpdateMetaAttrs(const ExtendedAttributes setExtended,
+                         const ExtendedAttributes clearExtended,
+                         const WORD setLegacy,
+                         const WORD clearLegacy) noexcept;
 
     ExtendedAttributes GetExtendedAttributes() const noexcept;
 
@@ -180,6 +184,8 @@ private:
     TextColor _background; // sizeof: 4, alignof: 1
     ExtendedAttributes _extendedAttrs; // sizeof: 1, alignof: 1
 
+    friend struct std::hash<TextAttribute>;
+
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     friend class TextAttributeTests;
@@ -209,6 +215,33 @@ constexpr bool operator!=(const TextAttribute& a, const TextAttribute& b) noexce
     return !(a == b);
 }
 
+namespace std
+{
+    template<>
+    struct hash<TextAttribute>
+    {
+        size_t operator()(const TextAttribute& attr) const noexcept
+        {
+            // TextColors are compared member by member, all of which are
+            // always initialized, so their bytes can be hashed as they are.
+            static_assert(sizeof(TextColor) == sizeof(uint32_t));
+            uint32_t fg;
+            uint32_t bg;
+            memcpy(&fg, &attr._foreground, sizeof(fg));
+            memcpy(&bg, &attr._background, sizeof(bg));
+
+            const auto colors = (uint64_t{ fg } << 32) | bg;
+            const auto rest = (uint64_t{ attr._wAttrLegacy } << 24) |
+                              (uint64_t{ attr._hyperlinkId } << 8) |
+                              static_cast<uint64_t>(attr._extendedAttrs);
+
+            const size_t h1 = std::hash<uint64_t>{}(colors);
+            const size_t h2 = std::hash<uint64_t>{}(rest);
+            return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+        }
+    };
+}
+
 #ifdef UNIT_TESTING
 
 #define LOG_ATTR(attr) (Log::Comment(NoThrowString().Format( \
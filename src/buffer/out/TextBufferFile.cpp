@@ -0,0 +1,376 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "TextBufferFile.hpp"
+#include "textBuffer.hpp"
+
+#pragma hdrstop
+
+static_assert(std::is_trivially_copyable_v<TextAttribute>, "TextAttribute is stored verbatim in the file");
+static_assert(std::is_trivially_copyable_v<CharRowCell>, "CharRowCell is stored verbatim in the file");
+
+// Routine Description:
+// - Appends the bytes of the given values to the end of out.
+template<typename T>
+static void _Append(std::vector<std::byte>& out, const T* values, const size_t count)
+{
+    const auto bytes = reinterpret_cast<const std::byte*>(values);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+template<typename T>
+static void _Append(std::vector<std::byte>& out, const T& value)
+{
+    _Append(out, &value, 1);
+}
+
+// Routine Description:
+// - Writes the rows, attributes, hyperlinks and the cursor of the given buffer into a file.
+// - The file is written under a temporary name first, and only replaces the file at
+//   the given path once it's complete, so that a crash can't leave half a file behind.
+// Arguments:
+// - buffer - the buffer to save
+// - path - the file to save it to
+// Return Value:
+// - <none>
+// Note: will throw exception if unable to write the file
+void TextBufferFile::Save(const TextBuffer& buffer, const std::wstring& path)
+{
+    const auto contents = _Serialize(buffer);
+
+    const auto temporaryPath = path + L".tmp";
+    {
+        wil::unique_hfile file{ CreateFileW(temporaryPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        THROW_LAST_ERROR_IF(!file);
+
+        const auto write = [&](const void* data, const size_t bytes) {
+            DWORD written = 0;
+            THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), data, gsl::narrow<DWORD>(bytes), &written, nullptr));
+        };
+        write(&contents.header, sizeof(contents.header));
+        write(contents.attributes.data(), contents.attributes.size() * sizeof(TextAttribute));
+        write(contents.hyperlinks.data(), contents.hyperlinks.size());
+        write(contents.rows.data(), contents.rows.size());
+    }
+    THROW_IF_WIN32_BOOL_FALSE(MoveFileExW(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING));
+}
+
+// Routine Description:
+// - Writes the buffer just like Save does, but into shared memory instead of a file.
+//   The section can be duplicated into another process and restored there, which
+//   hands over a buffer without turning it into VT and parsing it again.
+// Arguments:
+// - buffer - the buffer to share
+// Return Value:
+// - a handle to the pagefile-backed section holding the buffer's contents
+// Note: will throw exception if unable to create the section
+wil::unique_handle TextBufferFile::Share(const TextBuffer& buffer)
+{
+    const auto contents = _Serialize(buffer);
+    const auto attributeBytes = contents.attributes.size() * sizeof(TextAttribute);
+    const uint64_t total = sizeof(contents.header) + attributeBytes + contents.hyperlinks.size() + contents.rows.size();
+
+    wil::unique_handle section{ CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, gsl::narrow_cast<DWORD>(total >> 32), gsl::narrow_cast<DWORD>(total), nullptr) };
+    THROW_LAST_ERROR_IF(!section);
+
+    const wil::unique_mapview_ptr<std::byte> view{ static_cast<std::byte*>(MapViewOfFile(section.get(), FILE_MAP_WRITE, 0, 0, 0)) };
+    THROW_LAST_ERROR_IF(!view);
+
+    auto out = view.get();
+    const auto write = [&](const void* data, const size_t bytes) noexcept {
+        memcpy(out, data, bytes);
+        out += bytes;
+    };
+    write(&contents.header, sizeof(contents.header));
+    write(contents.attributes.data(), attributeBytes);
+    write(contents.hyperlinks.data(), contents.hyperlinks.size());
+    write(contents.rows.data(), contents.rows.size());
+    return section;
+}
+
+// Routine Description:
+// - Turns the given buffer into the contents of a file: the header, the table of
+//   attributes, the hyperlinks and the rows.
+TextBufferFile::Contents TextBufferFile::_Serialize(const TextBuffer& buffer)
+{
+    const auto size = buffer.GetSize().Dimensions();
+    const auto& cursor = buffer.GetCursor();
+
+    std::unordered_map<TextAttribute, uint32_t> attributeIds;
+    std::vector<TextAttribute> attributes;
+    std::vector<std::byte> rows;
+    std::vector<Run> runs;
+    std::vector<Glyph> glyphs;
+    std::wstring glyphText;
+
+    for (UINT y = 0; y < buffer.TotalRowCount(); ++y)
+    {
+        const auto& row = buffer.GetRowByOffset(y);
+        const auto& charRow = row.GetCharRow();
+
+        // Like ROW::Pack, the default cells at the end of a row aren't worth keeping.
+        auto end = charRow.cend();
+        while (end != charRow.cbegin() && *(end - 1) == CharRowCell{})
+        {
+            --end;
+        }
+        const auto cellCount = gsl::narrow_cast<size_t>(end - charRow.cbegin());
+
+        glyphs.clear();
+        glyphText.clear();
+        for (size_t column = 0; column < cellCount; ++column)
+        {
+            if (charRow.DbcsAttrAt(column).IsGlyphStored())
+            {
+                const std::wstring_view glyph = charRow.GlyphAt(column);
+                glyphs.push_back({ gsl::narrow<uint16_t>(column), gsl::narrow<uint16_t>(glyph.size()) });
+                glyphText.append(glyph);
+            }
+        }
+
+        runs.clear();
+        for (const auto& attr : row.GetAttrRow())
+        {
+            const auto [it, inserted] = attributeIds.emplace(attr, gsl::narrow<uint32_t>(attributes.size()));
+            if (inserted)
+            {
+                attributes.push_back(attr);
+            }
+            if (!runs.empty() && runs.back().attribute == it->second)
+            {
+                ++runs.back().length;
+            }
+            else
+            {
+                runs.push_back({ it->second, 1 });
+            }
+        }
+
+        const RowHeader header{
+            gsl::narrow<uint16_t>(cellCount),
+            gsl::narrow<uint16_t>(runs.size()),
+            gsl::narrow<uint16_t>(glyphs.size()),
+            gsl::narrow_cast<uint8_t>((row.WasWrapForced() ? WrapForcedFlag : 0) | (row.WasDoubleBytePadded() ? DoubleBytePaddedFlag : 0)),
+            gsl::narrow_cast<uint8_t>(row.GetLineRendition()),
+        };
+        _Append(rows, header);
+        _Append(rows, charRow.cbegin(), cellCount);
+        _Append(rows, runs.data(), runs.size());
+        _Append(rows, glyphs.data(), glyphs.size());
+        _Append(rows, glyphText.data(), glyphText.size());
+    }
+
+    // Only the hyperlinks that the attributes refer to are saved.
+    std::vector<std::byte> hyperlinks;
+    std::vector<uint16_t> hyperlinkIds;
+    for (const auto& attr : attributes)
+    {
+        const auto id = attr.GetHyperlinkId();
+        if (id != 0 && buffer._hyperlinks.Contains(id) && std::find(hyperlinkIds.begin(), hyperlinkIds.end(), id) == hyperlinkIds.end())
+        {
+            hyperlinkIds.push_back(id);
+            const auto uri = buffer._hyperlinks.GetUri(id);
+            const auto customId = buffer._hyperlinks.GetCustomId(id);
+            _Append(hyperlinks, HyperlinkHeader{ id, gsl::narrow<uint32_t>(uri.size()), gsl::narrow<uint32_t>(customId.size()) });
+            _Append(hyperlinks, uri.data(), uri.size());
+            _Append(hyperlinks, customId.data(), customId.size());
+        }
+    }
+
+    Contents contents;
+    auto& header = contents.header;
+    header.magic = Magic;
+    header.version = Version;
+    header.size = size;
+    header.cursorPosition = cursor.GetPosition();
+    header.cursorDelayedAt = cursor.IsDelayedEOLWrap() ? cursor.GetDelayedAtPosition() : COORD{ -1, -1 };
+    header.cursorSize = cursor.GetSize();
+    header.cursorFlags = (cursor.IsVisible() ? CursorVisibleFlag : 0) | (cursor.IsBlinkingAllowed() ? CursorBlinkingFlag : 0);
+    header.cursorType = gsl::narrow_cast<uint16_t>(cursor.GetType());
+    header.currentAttributes = buffer.GetCurrentAttributes();
+    header.attributeCount = gsl::narrow<uint32_t>(attributes.size());
+    header.hyperlinkCount = gsl::narrow<uint32_t>(hyperlinkIds.size());
+
+    contents.attributes = std::move(attributes);
+    contents.hyperlinks = std::move(hyperlinks);
+    contents.rows = std::move(rows);
+    return contents;
+}
+
+// Routine Description:
+// - Maps a file written by Save, and validates its header.
+// Arguments:
+// - path - the file to restore from
+// Return Value:
+// - constructed object
+// Note: will throw exception if the file can't be mapped or isn't one written by Save
+TextBufferFile::TextBufferFile(const std::wstring& path)
+{
+    _file.reset(CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+    THROW_LAST_ERROR_IF(!_file);
+
+    LARGE_INTEGER fileSize{};
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(_file.get(), &fileSize));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader)));
+    _viewSize = gsl::narrow<size_t>(fileSize.QuadPart);
+
+    _mapping.reset(CreateFileMappingW(_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+    THROW_LAST_ERROR_IF(!_mapping);
+
+    _MapAndValidate();
+}
+
+// Routine Description:
+// - Maps a section created by Share (or a duplicate of its handle), and validates its header.
+// Arguments:
+// - section - the section to restore from. It's kept open for as long as this object lives.
+// Return Value:
+// - constructed object
+// Note: will throw exception if the section can't be mapped or wasn't created by Share
+TextBufferFile::TextBufferFile(wil::unique_handle section) :
+    _mapping{ std::move(section) }
+{
+    THROW_HR_IF(E_INVALIDARG, !_mapping);
+    _MapAndValidate();
+}
+
+// Routine Description:
+// - Maps all of _mapping and reads its header. Unless it's a file, _viewSize is
+//   set to the size of the view, which is rounded up to the next page.
+void TextBufferFile::_MapAndValidate()
+{
+    _view.reset(static_cast<std::byte*>(MapViewOfFile(_mapping.get(), FILE_MAP_READ, 0, 0, 0)));
+    THROW_LAST_ERROR_IF(!_view);
+
+    if (!_file)
+    {
+        MEMORY_BASIC_INFORMATION info{};
+        THROW_LAST_ERROR_IF(VirtualQuery(_view.get(), &info, sizeof(info)) == 0);
+        _viewSize = info.RegionSize;
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), _viewSize < sizeof(FileHeader));
+    }
+
+    memcpy(&_header, _view.get(), sizeof(_header));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), _header.magic != Magic || _header.version != Version);
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), _header.size.X <= 0 || _header.size.Y <= 0);
+}
+
+// Routine Description:
+// - Gets the size of the buffer that was saved, which the buffer it's restored into needs to have.
+// Return Value:
+// - the width and height (including the scrollback) of the buffer
+COORD TextBufferFile::GetSize() const noexcept
+{
+    return _header.size;
+}
+
+// Routine Description:
+// - Replaces the contents of the given buffer with the ones in the file.
+// - The hyperlinks of the file are added to the buffer with new IDs.
+// Arguments:
+// - buffer - the buffer to restore, as large as GetSize
+// Return Value:
+// - <none>
+// Note: will throw exception if the buffer has another size, or if the file is damaged
+void TextBufferFile::Restore(TextBuffer& buffer) const
+{
+    THROW_HR_IF(E_INVALIDARG, buffer.GetSize().Dimensions() != _header.size);
+
+    Reader reader{ _view.get() + sizeof(FileHeader), _viewSize - sizeof(FileHeader) };
+
+    std::vector<TextAttribute> attributes(_header.attributeCount);
+    reader.Read(attributes.data(), attributes.size());
+
+    std::vector<std::pair<uint16_t, uint16_t>> hyperlinkIds;
+    for (uint32_t i = 0; i < _header.hyperlinkCount; ++i)
+    {
+        const auto hyperlink = reader.Read<HyperlinkHeader>();
+        std::wstring uri(hyperlink.uriLength, L'\0');
+        reader.Read(uri.data(), uri.size());
+        std::wstring customId(hyperlink.customIdLength, L'\0');
+        reader.Read(customId.data(), customId.size());
+        // The custom IDs were stored the way GetHyperlinkId makes them, with the hash of the URI already appended.
+        const auto id = customId.empty() ? buffer._hyperlinks.Add(uri) : buffer._hyperlinks.AddWithCustomId(uri, customId);
+        hyperlinkIds.emplace_back(hyperlink.id, id);
+    }
+    for (auto& attr : attributes)
+    {
+        if (const auto oldId = attr.GetHyperlinkId(); oldId != 0)
+        {
+            const auto it = std::find_if(hyperlinkIds.begin(), hyperlinkIds.end(), [&](const auto& ids) { return ids.first == oldId; });
+            attr.SetHyperlinkId(it != hyperlinkIds.end() ? it->second : 0);
+        }
+    }
+
+    const auto width = gsl::narrow_cast<size_t>(_header.size.X);
+    std::vector<Glyph> glyphs;
+    for (SHORT y = 0; y < _header.size.Y; ++y)
+    {
+        const auto header = reader.Read<RowHeader>();
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), header.cellCount > width);
+
+        auto& row = buffer.GetRowByOffset(y);
+        row.Reset(TextAttribute{});
+        row.SetWrapForced(WI_IsFlagSet(header.flags, WrapForcedFlag));
+        row.SetDoubleBytePadded(WI_IsFlagSet(header.flags, DoubleBytePaddedFlag));
+        row.SetLineRendition(static_cast<LineRendition>(header.lineRendition));
+
+        auto& charRow = row.GetCharRow();
+        reader.Read(charRow.begin(), header.cellCount);
+
+        auto& attrRow = row.GetAttrRow();
+        uint16_t column = 0;
+        for (uint16_t i = 0; i < header.runCount; ++i)
+        {
+            const auto run = reader.Read<Run>();
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), run.attribute >= attributes.size() || column + run.length > width);
+            const auto end = gsl::narrow_cast<uint16_t>(column + run.length);
+            attrRow.Replace(column, end, til::at(attributes, run.attribute));
+            column = end;
+        }
+
+        // The text of all the glyphs follows all of their headers.
+        glyphs.resize(header.glyphCount);
+        reader.Read(glyphs.data(), glyphs.size());
+        for (const auto& glyph : glyphs)
+        {
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), glyph.column >= header.cellCount);
+            UnicodeStorage::mapped_type text(glyph.length);
+            reader.Read(text.data(), text.size());
+            charRow.GetUnicodeStorage().StoreGlyph(charRow.GetStorageKey(glyph.column), text);
+        }
+    }
+
+    // The references of the hyperlinks are counted again from the rows, like after CopyHyperlinkMaps.
+    buffer._hyperlinks.ClearReferences();
+    buffer._rowHyperlinks.clear();
+
+    buffer.SetCurrentAttributes(_header.currentAttributes);
+
+    auto& cursor = buffer.GetCursor();
+    cursor.SetSize(_header.cursorSize);
+    cursor.SetType(static_cast<CursorType>(_header.cursorType));
+    cursor.SetIsVisible(WI_IsFlagSet(_header.cursorFlags, CursorVisibleFlag));
+    cursor.SetBlinkingAllowed(WI_IsFlagSet(_header.cursorFlags, CursorBlinkingFlag));
+    cursor.SetPosition(_header.cursorPosition);
+    if (_header.cursorDelayedAt.X >= 0)
+    {
+        cursor.DelayEOLWrap(_header.cursorDelayedAt);
+    }
+}
+
+TextBufferFile::Reader::Reader(const std::byte* data, const size_t size) noexcept :
+    _data{ data },
+    _remaining{ size }
+{
+}
+
+const std::byte* TextBufferFile::Reader::_Take(const size_t size)
+{
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), size > _remaining);
+    const auto data = _data;
+    _data += size;
+    _remaining -= size;
+    return data;
+}
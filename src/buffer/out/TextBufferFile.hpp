@@ -0,0 +1,134 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextBufferFile.hpp
+
+Abstract:
+- Saves the contents of a TextBuffer into a file, and restores a TextBuffer from
+  one, so that scrollback survives a restart without replaying it as VT.
+- The file holds the rows in order, each as its glyph cells (without the default
+  cells at the end), the glyphs that don't fit into a cell and the runs of its
+  attributes. The attributes are interned into a table, like in the buffer, and
+  stored verbatim along with the hyperlinks they refer to, and the cursor.
+- Restoring maps the file and copies the cells of every row straight into the
+  buffer. Nothing is parsed apart from the headers, which are validated.
+- The same contents can be written into shared memory instead (see Share), to
+  hand a buffer to another process.
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class TextBuffer;
+
+class TextBufferFile final
+{
+public:
+    static void Save(const TextBuffer& buffer, const std::wstring& path);
+    static wil::unique_handle Share(const TextBuffer& buffer);
+
+    explicit TextBufferFile(const std::wstring& path);
+    explicit TextBufferFile(wil::unique_handle section);
+
+    COORD GetSize() const noexcept;
+    void Restore(TextBuffer& buffer) const;
+
+private:
+    static constexpr uint32_t Magic = 0x53425443; // "CTBS"
+    static constexpr uint32_t Version = 1;
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        COORD size;
+        COORD cursorPosition;
+        COORD cursorDelayedAt; // { -1, -1 } unless the wrap at the end of the line is delayed
+        uint32_t cursorSize;
+        uint16_t cursorFlags;
+        uint16_t cursorType;
+        TextAttribute currentAttributes;
+        uint32_t attributeCount;
+        uint32_t hyperlinkCount;
+    };
+    static constexpr uint16_t CursorVisibleFlag = 0x1;
+    static constexpr uint16_t CursorBlinkingFlag = 0x2;
+
+    struct HyperlinkHeader
+    {
+        uint16_t id;
+        uint32_t uriLength;
+        uint32_t customIdLength;
+    };
+
+    struct RowHeader
+    {
+        uint16_t cellCount;
+        uint16_t runCount;
+        uint16_t glyphCount;
+        uint8_t flags;
+        uint8_t lineRendition;
+    };
+    static constexpr uint8_t WrapForcedFlag = 0x1;
+    static constexpr uint8_t DoubleBytePaddedFlag = 0x2;
+
+    struct Run
+    {
+        uint32_t attribute; // the index into the table of attributes
+        uint16_t length;
+    };
+
+    struct Glyph
+    {
+        uint16_t column;
+        uint16_t length;
+    };
+
+    // Reads the mapped file front to back, and throws once it runs past the end.
+    class Reader
+    {
+    public:
+        Reader(const std::byte* data, const size_t size) noexcept;
+
+        // The values are copied out, as they aren't necessarily aligned in the file.
+        template<typename T>
+        void Read(T* values, const size_t count)
+        {
+            memcpy(values, _Take(count * sizeof(T)), count * sizeof(T));
+        }
+
+        template<typename T>
+        T Read()
+        {
+            T value;
+            Read(&value, 1);
+            return value;
+        }
+
+    private:
+        const std::byte* _Take(const size_t size);
+
+        const std::byte* _data;
+        size_t _remaining;
+    };
+
+    struct Contents
+    {
+        FileHeader header{};
+        std::vector<TextAttribute> attributes;
+        std::vector<std::byte> hyperlinks;
+        std::vector<std::byte> rows;
+    };
+
+    static Contents _Serialize(const TextBuffer& buffer);
+    void _MapAndValidate();
+
+    wil::unique_hfile _file;
+    wil::unique_handle _mapping;
+    wil::unique_mapview_ptr<std::byte> _view;
+    size_t _viewSize{ 0 };
+    FileHeader _header;
+};
@@ -0,0 +1,38 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TextBufferSnapshot.hpp"
+#include "textBuffer.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Creates an empty snapshot. It's filled by TextBuffer::TakeSnapshot.
+// Arguments:
+// - size - the width of the source buffer and the number of rows to hold
+// - defaultAttributes - the attributes to initialize the rows with
+TextBufferSnapshot::TextBufferSnapshot(const COORD size, const TextAttribute defaultAttributes) :
+    _buffer{ std::make_unique<TextBuffer>(size, defaultAttributes, 0, _renderTarget) },
+    _sources(gsl::narrow_cast<size_t>(size.Y))
+{
+}
+
+// The TextBuffer is only complete in here.
+TextBufferSnapshot::~TextBufferSnapshot() = default;
+
+const TextBuffer& TextBufferSnapshot::GetBuffer() const noexcept
+{
+    return *_buffer;
+}
+
+SHORT TextBufferSnapshot::GetFirstRow() const noexcept
+{
+    return _firstRow;
+}
+
+uint64_t TextBufferSnapshot::GetGeneration() const noexcept
+{
+    return _generation;
+}
@@ -0,0 +1,71 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextBufferSnapshot.hpp
+
+Abstract:
+- An immutable copy of a range of rows of a TextBuffer, taken with TextBuffer::TakeSnapshot.
+- The rows are held by a TextBuffer of their own, so everything that reads a
+  TextBuffer (like its cell iterators) can read a snapshot, without holding the
+  lock of the buffer the snapshot was taken from.
+- Snapshots are handed out as reference counted pointers. When the previous snapshot
+  is passed to TakeSnapshot and nobody else holds on to it anymore, it's refreshed
+  in place and only the rows which changed since it was taken are copied again.
+  Otherwise a new snapshot is made, so a snapshot never changes while it's being read.
+- The export of the buffer reads its batches of rows through snapshots. The renderer
+  doesn't, as it can't paint without the lock anyway: the engines' state is changed by
+  the UI thread under that lock, and they resolve colors through IRenderData while
+  painting. It copies the text of the dirty rows into its run cache instead.
+
+--*/
+
+#pragma once
+
+#include "../renderer/inc/DummyRenderTarget.hpp"
+
+class TextBuffer;
+
+class TextBufferSnapshot final
+{
+public:
+    TextBufferSnapshot(const COORD size, const TextAttribute defaultAttributes);
+    ~TextBufferSnapshot();
+
+    // The rows of the snapshot. Row 0 is the first row the snapshot was taken of.
+    const TextBuffer& GetBuffer() const noexcept;
+
+    // The offset of the first row of the snapshot in the buffer it was taken from.
+    SHORT GetFirstRow() const noexcept;
+
+    // The generation of the buffer the snapshot was taken from, when it was taken.
+    uint64_t GetGeneration() const noexcept;
+
+private:
+    // Where a row of the snapshot was copied from: the index of the row within
+    // the storage of the source buffer, and the generation of that row.
+    struct RowSource
+    {
+        size_t index;
+        uint64_t generation;
+
+        bool operator==(const RowSource& other) const noexcept
+        {
+            return index == other.index && generation == other.generation;
+        }
+        bool operator!=(const RowSource& other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+
+    DummyRenderTarget _renderTarget;
+    std::unique_ptr<TextBuffer> _buffer;
+    uint64_t _sourceEpoch{ 0 };
+    SHORT _firstRow{ 0 };
+    uint64_t _generation{ 0 };
+    std::vector<std::optional<RowSource>> _sources;
+
+    friend class TextBuffer;
+};
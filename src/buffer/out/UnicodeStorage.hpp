@@ -7,6 +7,9 @@ Module Name:
 
 Abstract:
 - dynamic storage location for glyphs that can't normally fit in the output buffer
+- Every CharRow owns one of these for the glyphs in its columns, so the stored
+  glyphs move along with their row and don't need to be re-keyed when rows are
+  rotated around the buffer.
 
 Author(s):
 - Austin Diviness (AustDi) 02-May-2018
@@ -15,36 +18,11 @@ Author(s):
 #pragma once
 
 #include <vector>
-#include <unordered_map>
-#include <climits>
-
-// std::unordered_map needs help to know how to hash a COORD
-namespace std
-{
-    template<>
-    struct hash<COORD>
-    {
-        // Routine Description:
-        // - hashes a coord. coord will be hashed by storing the x and y values consecutively in the lower
-        // bits of a size_t.
-        // Arguments:
-        // - coord - the coord to hash
-        // Return Value:
-        // - the hashed coord
-        constexpr size_t operator()(const COORD& coord) const noexcept
-        {
-            size_t retVal = coord.Y;
-            const size_t xCoord = coord.X;
-            retVal |= xCoord << (sizeof(coord.Y) * CHAR_BIT);
-            return retVal;
-        }
-    };
-}
 
 class UnicodeStorage final
 {
 public:
-    using key_type = typename COORD;
+    using key_type = typename uint16_t;
     using mapped_type = typename std::vector<wchar_t>;
 
     UnicodeStorage() noexcept;
@@ -55,10 +33,23 @@ public:
 
     void Erase(const key_type key) noexcept;
 
-    void Remap(const std::unordered_map<SHORT, SHORT>& rowMap, const std::optional<SHORT> width);
+    void Truncate(const key_type width) noexcept;
+
+    void Clear() noexcept;
+
+    bool empty() const noexcept;
+
+    size_t GetMemoryUsage() const noexcept;
+    void Trim();
 
 private:
-    std::unordered_map<key_type, mapped_type> _map;
+    using value_type = typename std::pair<key_type, mapped_type>;
+
+    std::vector<value_type>::const_iterator _Find(const key_type key) const noexcept;
+
+    // The glyphs of a row, sorted by their column. Rows tend to hold none or only a
+    // few of these, which makes a sorted vector cheaper than any kind of hash map.
+    std::vector<value_type> _map;
 
 #ifdef UNIT_TESTING
     friend class UnicodeStorageTests;
@@ -288,6 +288,33 @@ void Cursor::CopyProperties(const Cursor& OtherCursor) noexcept
     _color = OtherCursor._color;
 }
 
+// Routine Description:
+// - Puts the cursor back in the state it was constructed in, for a buffer that's being reused.
+// Arguments:
+// - ulSize - The new size of the cursor.
+// Return Value:
+// - <none>
+void Cursor::Reset(const ULONG ulSize) noexcept
+{
+    _cPosition = { 0 };
+    _fHasMoved = false;
+    _fIsVisible = true;
+    _fIsOn = true;
+    _fIsDouble = false;
+    _fBlinkingAllowed = true;
+    _fDelay = false;
+    _fIsConversionArea = false;
+    _fIsPopupShown = false;
+    _fDelayedEolWrap = false;
+    _coordDelayedAt = { 0 };
+    _fDeferCursorRedraw = false;
+    _fHaveDeferredCursorRedraw = false;
+    _ulSize = ulSize;
+    _cursorType = CursorType::Legacy;
+    _fUseColor = false;
+    _color = s_InvertCursorColor;
+}
+
 void Cursor::DelayEOLWrap(const COORD coordDelayedAt) noexcept
 {
     _coordDelayedAt = coordDelayedAt;
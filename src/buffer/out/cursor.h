@@ -77,6 +77,7 @@ public:
     void DecrementYPosition(const int DeltaY) noexcept;
 
     void CopyProperties(const Cursor& OtherCursor) noexcept;
+    void Reset(const ULONG ulSize) noexcept;
 
     void DelayEOLWrap(const COORD coordDelayedAt) noexcept;
     void ResetDelayEOLWrap() noexcept;
@@ -91,7 +92,7 @@ private:
 
     //TODO: separate the rendering and text placement
 
-    // NOTE: If you are adding a property here, go add it to CopyProperties.
+    // NOTE: If you are adding a property here, go add it to CopyProperties and Reset.
 
     COORD _cPosition; // current position on screen (in screen buffer coords).
 
@@ -10,6 +10,10 @@
 #include "../types/inc/Utf16Parser.hpp"
 #include "../types/inc/GlyphWidth.hpp"
 
+#if defined(_M_IX86) || defined(_M_AMD64)
+#include <emmintrin.h>
+#endif
+
 using namespace Microsoft::Console::Types;
 
 // Routine Description:
@@ -29,6 +33,8 @@ Search::Search(IUiaData& uiaData,
     _direction(direction),
     _sensitivity(sensitivity),
     _needle(s_CreateNeedleFromString(str)),
+    _needleTrigrams(SearchIndex::s_HashNeedle(_needle)),
+    _needleText(s_CreateNeedleText(_needle)),
     _uiaData(uiaData),
     _coordAnchor(s_GetInitialAnchor(uiaData, direction))
 {
@@ -54,6 +60,8 @@ Search::Search(IUiaData& uiaData,
     _direction(direction),
     _sensitivity(sensitivity),
     _needle(s_CreateNeedleFromString(str)),
+    _needleTrigrams(SearchIndex::s_HashNeedle(_needle)),
+    _needleText(s_CreateNeedleText(_needle)),
     _coordAnchor(anchor),
     _uiaData(uiaData)
 {
@@ -75,8 +83,39 @@ bool Search::FindNext()
         return false;
     }
 
+    // The search index can rule out entire blocks of rows at once,
+    // as long as the needle is long enough to have trigrams and fits in a row.
+    const auto& textBuffer = _uiaData.GetTextBuffer();
+    const auto useIndex = !_needleTrigrams.empty() &&
+                          _needle.size() <= gsl::narrow_cast<size_t>(textBuffer.GetSize().Width());
+
+    // The rows last checked against the index. The buffer can't change while we're searching.
+    size_t checkedFirstRow = 1;
+    size_t checkedLastRow = 0;
+    auto checkedMayContain = true;
+    _rowTextRow = std::numeric_limits<size_t>::max();
+
     do
     {
+        if (useIndex)
+        {
+            const auto row = gsl::narrow_cast<size_t>(_coordNext.Y);
+            if (row < checkedFirstRow || row > checkedLastRow)
+            {
+                checkedMayContain = textBuffer.MayContainSearchText(row, _needleTrigrams, checkedFirstRow, checkedLastRow);
+            }
+            if (!checkedMayContain)
+            {
+                _SkipRows(checkedFirstRow, checkedLastRow);
+                continue;
+            }
+        }
+
+        if (_SkipToCandidateInRow())
+        {
+            continue;
+        }
+
         if (_FindNeedleInHaystackAt(_coordNext, _coordSelStart, _coordSelEnd))
         {
             _UpdateNextPosition();
@@ -129,6 +168,38 @@ std::pair<COORD, COORD> Search::GetFoundLocation() const noexcept
     return { _coordSelStart, _coordSelEnd };
 }
 
+// Routine Description:
+// - tells whether the search went around the end of the buffer (or its start, going
+//   backward) to find the text, so that it was found on the other side of the anchor.
+//   only guaranteed to be valid if FindNext has been called and returned true.
+// Return Value:
+// - true if the search wrapped around
+bool Search::WrappedAround() const noexcept
+{
+    const auto compared = _uiaData.GetTextBuffer().GetSize().CompareInBounds(_coordSelStart, _coordAnchor);
+    return _direction == Direction::Forward ? compared < 0 : compared > 0;
+}
+
+// Routine Description:
+// - Moves the search along with the text after the given number of rows circled out
+//   of the top of the buffer, so that it goes on where it left off in the text.
+//   If the position it would have gone on at circled out too, it goes on at the top.
+// - Only a forward search anchored at the top of the buffer can be moved, since
+//   everything above where it goes on must have been searched already.
+// Arguments:
+// - rows - the number of rows that circled out since the search was last used
+void Search::MoveUp(const size_t rows) noexcept
+{
+    if (gsl::narrow_cast<size_t>(_coordNext.Y) < rows)
+    {
+        _coordNext = _coordAnchor;
+    }
+    else
+    {
+        _coordNext.Y -= gsl::narrow_cast<SHORT>(rows);
+    }
+}
+
 // Routine Description:
 // - Finds the anchor position where we will start searches from.
 // - This position will represent the "wrap around" point in the buffer or where
@@ -323,6 +394,275 @@ void Search::_UpdateNextPosition()
     }
 }
 
+// Routine Description:
+// - Moves the next position past the given rows, which are known not to contain the needle.
+// - If the anchor is among them, we only move one position so that we still stop at the anchor.
+// Arguments:
+// - firstRow - the first row to skip
+// - lastRow - the last row to skip
+void Search::_SkipRows(const size_t firstRow, const size_t lastRow)
+{
+    const auto anchorRow = gsl::narrow_cast<size_t>(_coordAnchor.Y);
+    if (anchorRow >= firstRow && anchorRow <= lastRow)
+    {
+        _UpdateNextPosition();
+        return;
+    }
+
+    if (_direction == Direction::Forward)
+    {
+        _coordNext = { _uiaData.GetTextBuffer().GetSize().RightInclusive(), gsl::narrow<SHORT>(lastRow) };
+    }
+    else
+    {
+        _coordNext = { 0, gsl::narrow<SHORT>(firstRow) };
+    }
+    _UpdateNextPosition();
+}
+
+// Routine Description:
+// - Scans the rest of the current row for the needle in one go, instead of comparing
+//   it glyph by glyph at every position.
+// - This only works if the needle is plain text and the row holds nothing but
+//   single-width BMP characters either, so that a column is the same as an offset in its text.
+// - Positions where the needle would continue on the next row are left to the per-glyph comparison.
+// - If the needle was found, the next position is moved to it and the per-glyph
+//   comparison is left to confirm it.
+// Return Value:
+// - True if the next position was moved past positions that don't match. False if the
+//   caller should compare the needle at the (possibly updated) next position.
+bool Search::_SkipToCandidateInRow()
+{
+    const auto& textBuffer = _uiaData.GetTextBuffer();
+    const auto width = gsl::narrow_cast<size_t>(textBuffer.GetSize().Width());
+    if (_needleText.empty() || _needleText.size() > width)
+    {
+        return false;
+    }
+
+    const auto row = gsl::narrow_cast<size_t>(_coordNext.Y);
+    if (!_LoadRowText(row))
+    {
+        return false;
+    }
+
+    // The last position at which the needle fits into the row.
+    const auto lastStart = width - _needleText.size();
+    const auto column = gsl::narrow_cast<size_t>(_coordNext.X);
+    const auto anchorColumn = gsl::narrow_cast<size_t>(_coordAnchor.X);
+    const auto anchorInRow = gsl::narrow_cast<size_t>(_coordAnchor.Y) == row;
+
+    if (_direction == Direction::Forward)
+    {
+        if (column > lastStart)
+        {
+            return false;
+        }
+
+        // Don't scan past the anchor or past the end of the text. Both end the search.
+        auto last = lastStart;
+        if (anchorInRow && anchorColumn > column)
+        {
+            last = std::min(last, anchorColumn - 1);
+        }
+        const auto bufferEnd = _uiaData.GetTextBufferEndPosition();
+        if (bufferEnd.Y == _coordNext.Y)
+        {
+            last = std::min(last, gsl::narrow_cast<size_t>(std::max<SHORT>(bufferEnd.X, 0)));
+        }
+        if (last < column)
+        {
+            return false;
+        }
+
+        const auto found = _FindCandidate(column, last);
+        if (found != std::wstring::npos)
+        {
+            _coordNext.X = gsl::narrow_cast<SHORT>(found);
+            return false;
+        }
+        _coordNext.X = gsl::narrow_cast<SHORT>(last);
+    }
+    else
+    {
+        if (column > lastStart)
+        {
+            return false;
+        }
+
+        size_t first = 0;
+        if (anchorInRow && anchorColumn < column)
+        {
+            first = anchorColumn + 1;
+        }
+
+        const auto found = _FindCandidate(column, first);
+        if (found != std::wstring::npos)
+        {
+            _coordNext.X = gsl::narrow_cast<SHORT>(found);
+            return false;
+        }
+        _coordNext.X = gsl::narrow_cast<SHORT>(first);
+    }
+
+    _UpdateNextPosition();
+    return true;
+}
+
+// Routine Description:
+// - Copies the text of the given row into _rowText, unless the row holds anything
+//   other than single-width BMP characters.
+// Arguments:
+// - row - the row to load
+// Return Value:
+// - True if _rowText now holds the text of the row, one character per column.
+bool Search::_LoadRowText(const size_t row)
+{
+    if (row == _rowTextRow)
+    {
+        return _rowTextValid;
+    }
+
+    _rowTextRow = row;
+    _rowTextValid = false;
+
+    const auto& charRow = _uiaData.GetTextBuffer().GetRowByOffset(row).GetCharRow();
+    if (!charRow.GetUnicodeStorage().empty())
+    {
+        return false;
+    }
+
+    _rowText.resize(charRow.size());
+    auto out = _rowText.begin();
+    for (const auto& cell : charRow)
+    {
+        if (!cell.DbcsAttr().IsSingle())
+        {
+            return false;
+        }
+        *out++ = cell.Char();
+    }
+
+    _rowTextValid = true;
+    return true;
+}
+
+// Routine Description:
+// - Finds the first position in _rowText between the given columns (inclusive) at which
+//   the needle matches, in search direction.
+// - The first character of the needle is looked for 8 characters at a time.
+//   When ignoring case, only ASCII is folded that way. Anything outside of ASCII is
+//   always a candidate and left to the exact comparison.
+// Arguments:
+// - first - the column to start at
+// - last - the column to stop at. Smaller than first when searching backward.
+// Return Value:
+// - The column at which the needle matches, or npos.
+size_t Search::_FindCandidate(const size_t first, const size_t last) const noexcept
+{
+    const auto foldCase = _sensitivity == Sensitivity::CaseInsensitive;
+    const auto head = _ApplySensitivity(_needleText.front());
+
+    const auto isCandidate = [&](const size_t column) noexcept {
+        const auto wch = til::at(_rowText, column);
+        if (foldCase)
+        {
+            return wch >= 0x80 || _ApplySensitivity(wch) == head;
+        }
+        return wch == head;
+    };
+
+#if defined(_M_IX86) || defined(_M_AMD64)
+    const auto needle = _mm_set1_epi16(gsl::narrow_cast<short>(head));
+    const auto upperFirst = _mm_set1_epi16(L'A' - 1);
+    const auto upperLast = _mm_set1_epi16(L'Z' + 1);
+    const auto caseBit = _mm_set1_epi16(0x20);
+    const auto nonAscii = _mm_set1_epi16(gsl::narrow_cast<short>(0xFF80));
+    const auto zero = _mm_setzero_si128();
+
+    // Returns one bit per candidate among the 8 characters at the given column.
+    const auto candidates = [&](const size_t column) noexcept {
+        auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_rowText.data() + column));
+        auto mask = zero;
+        if (foldCase)
+        {
+            const auto upper = _mm_and_si128(_mm_cmpgt_epi16(chars, upperFirst), _mm_cmplt_epi16(chars, upperLast));
+            chars = _mm_or_si128(chars, _mm_and_si128(upper, caseBit));
+            mask = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(chars, nonAscii), zero), _mm_cmpeq_epi16(zero, zero));
+        }
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi16(chars, needle));
+        return gsl::narrow_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(mask, zero)));
+    };
+#endif
+
+    if (first <= last)
+    {
+        auto column = first;
+#if defined(_M_IX86) || defined(_M_AMD64)
+        for (; column + 8 <= last + 1; column += 8)
+        {
+            for (auto bits = candidates(column); bits != 0; bits &= bits - 1)
+            {
+                unsigned long bit;
+                _BitScanForward(&bit, bits);
+                if (_MatchesRowTextAt(column + bit))
+                {
+                    return column + bit;
+                }
+            }
+        }
+#endif
+        for (; column <= last; ++column)
+        {
+            if (isCandidate(column) && _MatchesRowTextAt(column))
+            {
+                return column;
+            }
+        }
+    }
+    else
+    {
+        // Scanning backward, column is one past the next column to look at.
+        auto column = first + 1;
+#if defined(_M_IX86) || defined(_M_AMD64)
+        for (; column >= last + 8; column -= 8)
+        {
+            for (auto bits = candidates(column - 8); bits != 0;)
+            {
+                unsigned long bit;
+                _BitScanReverse(&bit, bits);
+                bits &= ~(1u << bit);
+                if (_MatchesRowTextAt(column - 8 + bit))
+                {
+                    return column - 8 + bit;
+                }
+            }
+        }
+#endif
+        for (; column > last; --column)
+        {
+            if (isCandidate(column - 1) && _MatchesRowTextAt(column - 1))
+            {
+                return column - 1;
+            }
+        }
+    }
+
+    return std::wstring::npos;
+}
+
+// Routine Description:
+// - Compares the needle to _rowText at the given column.
+// Arguments:
+// - column - the column to compare at. The needle has to fit into the row from there.
+// Return Value:
+// - True if the needle matches there.
+bool Search::_MatchesRowTextAt(const size_t column) const noexcept
+{
+    const auto hay = std::wstring_view{ _rowText }.substr(column, _needleText.size());
+    return _CompareChars(hay, _needleText);
+}
+
 // Routine Description:
 // - Creates a "needle" of the correct format for comparison to the screen buffer text data
 //   that we can use for our search
@@ -344,3 +684,25 @@ std::vector<std::vector<wchar_t>> Search::s_CreateNeedleFromString(const std::ws
     }
     return cells;
 }
+
+// Routine Description:
+// - Turns the needle into plain text for the row scan of _SkipToCandidateInRow.
+// Arguments:
+// - needle - the needle as created by s_CreateNeedleFromString
+// Return Value:
+// - The text of the needle, with one character per column. Empty if the needle has
+//   characters that don't fit into a single column or need more than one code unit.
+std::wstring Search::s_CreateNeedleText(const std::vector<std::vector<wchar_t>>& needle)
+{
+    std::wstring text;
+    text.reserve(needle.size());
+    for (const auto& cell : needle)
+    {
+        if (cell.size() != 1 || IsGlyphFullWidth(cell.front()))
+        {
+            return {};
+        }
+        text.push_back(cell.front());
+    }
+    return text;
+}
@@ -56,12 +56,20 @@ public:
     void Color(const TextAttribute attr) const;
 
     std::pair<COORD, COORD> GetFoundLocation() const noexcept;
+    bool WrappedAround() const noexcept;
+
+    void MoveUp(const size_t rows) noexcept;
 
 private:
     wchar_t _ApplySensitivity(const wchar_t wch) const noexcept;
     bool _FindNeedleInHaystackAt(const COORD pos, COORD& start, COORD& end) const;
     bool _CompareChars(const std::wstring_view one, const std::wstring_view two) const noexcept;
     void _UpdateNextPosition();
+    void _SkipRows(const size_t firstRow, const size_t lastRow);
+    bool _SkipToCandidateInRow();
+    bool _LoadRowText(const size_t row);
+    size_t _FindCandidate(const size_t first, const size_t last) const noexcept;
+    bool _MatchesRowTextAt(const size_t column) const noexcept;
 
     void _IncrementCoord(COORD& coord) const noexcept;
     void _DecrementCoord(COORD& coord) const noexcept;
@@ -69,6 +77,7 @@ private:
     static COORD s_GetInitialAnchor(Microsoft::Console::Types::IUiaData& uiaData, const Direction dir);
 
     static std::vector<std::vector<wchar_t>> s_CreateNeedleFromString(const std::wstring& wstr);
+    static std::wstring s_CreateNeedleText(const std::vector<std::vector<wchar_t>>& needle);
 
     bool _reachedEnd = false;
     COORD _coordNext = { 0 };
@@ -77,10 +86,17 @@ private:
 
     const COORD _coordAnchor;
     const std::vector<std::vector<wchar_t>> _needle;
+    const SearchIndex::Needle _needleTrigrams;
+    const std::wstring _needleText; // the needle as plain UTF-16, if all of it is single-width BMP text
     const Direction _direction;
     const Sensitivity _sensitivity;
     Microsoft::Console::Types::IUiaData& _uiaData;
 
+    // The text of the row that _SkipToCandidateInRow last looked at.
+    size_t _rowTextRow = std::numeric_limits<size_t>::max();
+    bool _rowTextValid = false;
+    std::wstring _rowText;
+
 #ifdef UNIT_TESTING
     friend class SearchTests;
 #endif
@@ -6,6 +6,7 @@
 #include "textBuffer.hpp"
 #include "CharRow.hpp"
 
+#include "../renderer/inc/DummyRenderTarget.hpp"
 #include "../types/inc/utils.hpp"
 #include "../types/inc/convert.hpp"
 #include "../../types/inc/GlyphWidth.hpp"
@@ -17,6 +18,8 @@ using namespace Microsoft::Console::Types;
 
 using PointTree = interval_tree::IntervalTree<til::point, size_t>;
 
+std::atomic<uint64_t> TextBuffer::s_nextSnapshotEpoch{ 0 };
+
 // Routine Description:
 // - Creates a new instance of TextBuffer
 // Arguments:
@@ -34,18 +37,25 @@ TextBuffer::TextBuffer(const COORD screenBufferSize,
     _firstRow{ 0 },
     _currentAttributes{ defaultAttributes },
     _cursor{ cursorSize, *this },
+    _charBuffer{},
     _storage{},
-    _unicodeStorage{},
-    _renderTarget{ renderTarget },
+    _renderTarget{ &renderTarget },
     _size{},
-    _currentHyperlinkId{ 1 },
-    _currentPatternId{ 0 }
+    _hyperlinksCountedAt{ 0 },
+    _currentPatternId{ 0 },
+    _hotRowCount{ 0 },
+    _circlesSinceCompaction{ 0 },
+    _snapshotEpoch{ ++s_nextSnapshotEpoch },
+    _pagedInRows{ 0 },
+    _circledRows{ 0 }
 {
-    // initialize ROWs
-    _storage.reserve(static_cast<size_t>(screenBufferSize.Y));
-    for (size_t i = 0; i < static_cast<size_t>(screenBufferSize.Y); ++i)
+    // initialize the cell arena, followed by the ROWs viewing into it
+    const auto height = static_cast<size_t>(screenBufferSize.Y);
+    _charBuffer = CellArena{ static_cast<size_t>(screenBufferSize.X), height };
+    _storage.reserve(height);
+    for (size_t i = 0; i < height; ++i)
     {
-        _storage.emplace_back(static_cast<SHORT>(i), screenBufferSize.X, _currentAttributes, this);
+        _storage.emplace_back(i, _charBuffer.GetRow(i), _currentAttributes, _attributes, _clock, this);
     }
 
     _UpdateSize();
@@ -87,6 +97,7 @@ const ROW& TextBuffer::GetRowByOffset(const size_t index) const
 
     // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
     const size_t offsetIndex = (_firstRow + index) % totalRows;
+    // A packed or lazily cleared row is read as it is, see CharRow::_cells.
     return _storage.at(offsetIndex);
 }
 
@@ -103,7 +114,32 @@ ROW& TextBuffer::GetRowByOffset(const size_t index)
 
     // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
     const size_t offsetIndex = (_firstRow + index) % totalRows;
-    return _storage.at(offsetIndex);
+    return _GetRow(offsetIndex);
+}
+
+// Routine Description:
+// - Retrieves a row by its index in the underlying storage.
+// - If the row was packed into cold storage, it's expanded again first.
+//   Likewise, the cells of a row that was reset lazily are cleared first.
+// - This is only for changing rows, which callers do under the exclusive lock.
+//   Readers go through the const GetRowByOffset, which never expands a row.
+// Arguments:
+// - index - the index of the row within _storage
+// Return Value:
+// - reference to the requested row. Throws if out of bounds.
+ROW& TextBuffer::_GetRow(const size_t index)
+{
+    auto& row = _storage.at(index);
+    if (row.IsPacked())
+    {
+        // Going through the arena slot rather than CharRow::begin() keeps the
+        // row's generation, as expanding it doesn't change its contents.
+        const auto slot = _charBuffer.GetRowIndex(row.GetCharRow().GetArenaCells());
+        _charBuffer.Commit(_charBuffer.GetRow(slot));
+        row.Unpack();
+    }
+    row.FinishClear();
+    return row;
 }
 
 // Routine Description:
@@ -335,6 +371,12 @@ OutputCellIterator TextBuffer::Write(const OutputCellIterator givenIt,
                                      const COORD target,
                                      const std::optional<bool> wrap)
 {
+    // Nothing refers into the attribute table in between two writes.
+    if (_attributes.ShouldCompact())
+    {
+        _CompactAttributes();
+    }
+
     // Make mutable copy so we can walk.
     auto it = givenIt;
 
@@ -344,18 +386,48 @@ OutputCellIterator TextBuffer::Write(const OutputCellIterator givenIt,
     // Get size of the text buffer so we can stay in bounds.
     const auto size = GetSize();
 
+    // Rows that were written from one end to the other are invalidated together,
+    // so that a fill of the whole buffer (like cls) doesn't invalidate it one row at a time.
+    SHORT fullRowsTop = 0;
+    SHORT fullRowsCount = 0;
+    const auto notifyFullRows = [&]() {
+        if (fullRowsCount > 0)
+        {
+            _NotifyPaint(Viewport::FromDimensions({ 0, fullRowsTop }, { size.Width(), fullRowsCount }));
+            fullRowsCount = 0;
+        }
+    };
+
     // While there's still data in the iterator and we're still targeting in bounds...
     while (it && size.IsInBounds(lineTarget))
     {
         // Attempt to write as much data as possible onto this line.
         // NOTE: if wrap = true/false, we want to set the line's wrap to true/false (respectively) if we reach the end of the line
-        it = WriteLine(it, lineTarget, wrap);
+        const auto newIt = GetRowByOffset(lineTarget.Y).WriteCells(it, lineTarget.X, wrap, std::nullopt);
+        const auto written = gsl::narrow<SHORT>(newIt.GetCellDistance(it));
+        it = newIt;
+
+        if (lineTarget.X == 0 && written == size.Width())
+        {
+            if (fullRowsCount == 0)
+            {
+                fullRowsTop = lineTarget.Y;
+            }
+            ++fullRowsCount;
+        }
+        else
+        {
+            notifyFullRows();
+            _NotifyPaint(Viewport::FromDimensions(lineTarget, { written, 1 }));
+        }
 
         // Move to the next line down.
         lineTarget.X = 0;
         ++lineTarget.Y;
     }
 
+    notifyFullRows();
+
     return it;
 }
 
@@ -379,6 +451,12 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
         return givenIt;
     }
 
+    // Nothing refers into the attribute table in between two writes.
+    if (_attributes.ShouldCompact())
+    {
+        _CompactAttributes();
+    }
+
     //  Get the row and write the cells
     ROW& row = GetRowByOffset(target.Y);
     const auto newIt = row.WriteCells(givenIt, target.X, wrap, limitRight);
@@ -391,6 +469,52 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
     return newIt;
 }
 
+// Routine Description:
+// - Reads one line of the output buffer out as legacy cells.
+// Arguments:
+// - target - the row/column to start reading at
+// - cells - receives one legacy cell per column, which have to fit into the row
+// Return Value:
+// - <none>
+void TextBuffer::ReadCharInfos(const COORD target, const gsl::span<CHAR_INFO> cells) const
+{
+    THROW_HR_IF(E_INVALIDARG, !GetSize().IsInBounds(target));
+
+    GetRowByOffset(target.Y).ReadCharInfos(target.X, cells);
+}
+
+// Routine Description:
+// - Writes legacy cells to one line of the output buffer.
+// - This is the same as writing them with Write() through an OutputCellIterator,
+//   but converts them a row at a time instead of a cell at a time.
+// Arguments:
+// - target - the row/column to start writing the cells to
+// - cells - the legacy cells to write, which have to fit into the row
+// Return Value:
+// - <none>
+void TextBuffer::WriteCharInfos(const COORD target, const gsl::span<const CHAR_INFO> cells)
+{
+    if (cells.empty() || !GetSize().IsInBounds(target))
+    {
+        return;
+    }
+
+    // Nothing refers into the attribute table in between two writes.
+    if (_attributes.ShouldCompact())
+    {
+        _CompactAttributes();
+    }
+
+    if (!GetRowByOffset(target.Y).WriteCharInfos(target.X, cells))
+    {
+        // The row couldn't take the cells in bulk, so let the per cell logic pad them.
+        Write(OutputCellIterator{ cells }, target);
+        return;
+    }
+
+    _NotifyPaint(Viewport::FromDimensions(target, { gsl::narrow<SHORT>(cells.size()), 1 }));
+}
+
 //Routine Description:
 // - Inserts one codepoint into the buffer at the current cursor position and advances the cursor as appropriate.
 //Arguments:
@@ -556,11 +680,23 @@ bool TextBuffer::IncrementCircularBuffer(const bool inVtMode)
 {
     // FirstRow is at any given point in time the array index in the circular buffer that corresponds
     // to the logical position 0 in the window (cursor coordinates and all other coordinates).
-    _renderTarget.TriggerCircling();
+    _FlushDeferredPaint();
+    _renderTarget->TriggerCircling();
 
     // Prune hyperlinks to delete obsolete references
     _PruneHyperlinks();
 
+    // Rows that fall off the top of the buffer are kept on disk if an archive was enabled.
+    if (_scrollbackArchive)
+    {
+        try
+        {
+            // Reading the row doesn't require a packed or lazily cleared row to be expanded.
+            _scrollbackArchive->Append(std::as_const(_storage).at(_firstRow));
+        }
+        CATCH_LOG();
+    }
+
     // Second, clean out the old "first row" as it will become the "last row" of the buffer after the circle is performed.
     auto fillAttributes = _currentAttributes;
     if (inVtMode)
@@ -569,7 +705,9 @@ bool TextBuffer::IncrementCircularBuffer(const bool inVtMode)
         // the current background color, but with no meta attributes set.
         fillAttributes.SetStandardErase();
     }
-    const bool fSuccess = _storage.at(_firstRow).Reset(fillAttributes);
+    // The row isn't cleared until it's accessed again, which keeps a
+    // newline at the bottom of the buffer independent of the row width.
+    const bool fSuccess = _storage.at(_firstRow).ResetLazily(fillAttributes);
     if (fSuccess)
     {
         // Now proceed to increment.
@@ -577,871 +715,2058 @@ bool TextBuffer::IncrementCircularBuffer(const bool inVtMode)
         _firstRow++;
 
         // If we pass up the height of the buffer, loop back to 0.
-        if (_firstRow >= GetSize().Height())
+        if (_firstRow >= _storage.size())
         {
             _firstRow = 0;
         }
-    }
-    return fSuccess;
-}
-
-//Routine Description:
-// - Retrieves the position of the last non-space character in the given
-//   viewport
-// - By default, we search the entire buffer to find the last non-space
-//   character.
-// - If we know the last character is within the given viewport (so we don't
-//   need to check the entire buffer), we can provide a value in viewOptional
-//   that we'll use to search for the last character in.
-//Arguments:
-// - The viewport
-//Return value:
-// - Coordinate position (relative to the text buffer)
-COORD TextBuffer::GetLastNonSpaceCharacter(std::optional<const Microsoft::Console::Types::Viewport> viewOptional) const
-{
-    const auto viewport = viewOptional.has_value() ? viewOptional.value() : GetSize();
 
-    COORD coordEndOfText = { 0 };
-    // Search the given viewport by starting at the bottom.
-    coordEndOfText.Y = viewport.BottomInclusive();
+        ++_circledRows;
+        _promptMarks.DropBefore(_circledRows);
+        _images.DropBefore(_circledRows);
 
-    const auto& currRow = GetRowByOffset(coordEndOfText.Y);
-    // The X position of the end of the valid text is the Right draw boundary (which is one beyond the final valid character)
-    coordEndOfText.X = gsl::narrow<short>(currRow.GetCharRow().MeasureRight()) - 1;
+        // The row that went away might have been the topmost placeholder of a deferred reflow.
+        if (_pendingReflow && ++_pendingReflow->firstRow >= _pendingReflow->endRow)
+        {
+            _pendingReflow.reset();
+        }
 
-    // If the X coordinate turns out to be -1, the row was empty, we need to search backwards for the real end of text.
-    const auto viewportTop = viewport.Top();
-    bool fDoBackUp = (coordEndOfText.X < 0 && coordEndOfText.Y > viewportTop); // this row is empty, and we're not at the top
-    while (fDoBackUp)
-    {
-        coordEndOfText.Y--;
-        const auto& backupRow = GetRowByOffset(coordEndOfText.Y);
-        // We need to back up to the previous row if this line is empty, AND there are more rows
+        if (_hotRowCount != 0 && ++_circlesSinceCompaction >= s_CompactionInterval)
+        {
+            _circlesSinceCompaction = 0;
+            _PackColdRows();
+        }
 
-        coordEndOfText.X = gsl::narrow<short>(backupRow.GetCharRow().MeasureRight()) - 1;
-        fDoBackUp = (coordEndOfText.X < 0 && coordEndOfText.Y > viewportTop);
+        if (_attributes.ShouldCompact())
+        {
+            try
+            {
+                _CompactAttributes();
+            }
+            CATCH_LOG();
+        }
     }
-
-    // don't allow negative results
-    coordEndOfText.Y = std::max(coordEndOfText.Y, 0i16);
-    coordEndOfText.X = std::max(coordEndOfText.X, 0i16);
-
-    return coordEndOfText;
+    return fSuccess;
 }
 
 // Routine Description:
-// - Retrieves the position of the previous character relative to the current cursor position
+// - Drops the attributes which no row uses anymore from the attribute table.
+// - Must only be called while nothing holds on to attributes of the table,
+//   like an iterator over the attributes of a row.
 // Arguments:
 // - <none>
 // Return Value:
-// - Coordinate position in screen coordinates of the character just before the cursor.
-// - NOTE: Will return 0,0 if already in the top left corner
-COORD TextBuffer::_GetPreviousFromCursor() const
+// - <none>
+void TextBuffer::_CompactAttributes()
 {
-    COORD coordPosition = GetCursor().GetPosition();
-
-    // If we're not at the left edge, simply move the cursor to the left by one
-    if (coordPosition.X > 0)
+    std::vector<bool> used(_attributes.size());
+    for (const auto& row : _storage)
     {
-        coordPosition.X--;
+        row.GetAttrRow().MarkUsedIds(used);
     }
-    else
-    {
-        // Otherwise, only if we're not on the top row (e.g. we don't move anywhere in the top left corner. there is no previous)
-        if (coordPosition.Y > 0)
-        {
-            // move the cursor up one line
-            coordPosition.Y--;
 
-            // and to the right edge
-            coordPosition.X = GetLineWidth(coordPosition.Y) - 1;
-        }
+    const auto newIds = _attributes.Compact(used);
+    for (auto& row : _storage)
+    {
+        row.GetAttrRow().RemapIds(newIds);
     }
-
-    return coordPosition;
 }
 
-const SHORT TextBuffer::GetFirstRowIndex() const noexcept
+// Routine Description:
+// - Enables packing scrollback rows into a compact cold storage representation.
+// - Every row further than the given number of rows above the cursor is packed
+//   and the memory backing its cells is returned to the OS. Such rows are
+//   transparently expanded again when they're retrieved (e.g. by the renderer,
+//   search or selection).
+// Arguments:
+// - hotRowCount - the number of rows above the cursor to always keep expanded.
+//   0 disables cold storage.
+// Return Value:
+// - <none>
+void TextBuffer::SetHotRowCount(const size_t hotRowCount) noexcept
 {
-    return _firstRow;
+    _hotRowCount = hotRowCount;
+    _circlesSinceCompaction = 0;
 }
 
-const Viewport TextBuffer::GetSize() const noexcept
+// Routine Description:
+// - Makes rows that are packed into cold storage share their cells with the other
+//   packed rows that hold the same glyphs, like the lines of repetitive output.
+//   Packing a row then costs a hash of its cells. See PackedRowStore.
+// - Rows that were packed already keep their cells either way.
+// Arguments:
+// - share - whether to share the cells of the rows packed from now on
+// Return Value:
+// - <none>
+void TextBuffer::ShareColdRows(const bool share)
 {
-    return _size;
+    if (!share)
+    {
+        _packedRowStore.reset();
+    }
+    else if (!_packedRowStore)
+    {
+        _packedRowStore = std::make_unique<PackedRowStore>();
+    }
 }
 
-void TextBuffer::_UpdateSize()
+// Routine Description:
+// - Like SetHotRowCount, but packs the rows outside of the new hot region
+//   right away instead of on one of the next scrolls.
+// - Used to give memory back while the buffer isn't written to.
+// Arguments:
+// - hotRowCount - the number of rows above the cursor to keep expanded.
+//   Must not be 0.
+// Return Value:
+// - <none>
+void TextBuffer::CompactScrollback(const size_t hotRowCount) noexcept
 {
-    _size = Viewport::FromDimensions({ 0, 0 }, { gsl::narrow<SHORT>(_storage.at(0).size()), gsl::narrow<SHORT>(_storage.size()) });
+    SetHotRowCount(hotRowCount);
+    _PackColdRows();
 }
 
-void TextBuffer::_SetFirstRowIndex(const SHORT FirstRowIndex) noexcept
+// Routine Description:
+// - Packs the rows outside of the hot region again, which reading them expanded.
+// - Used by readers that go over the whole scrollback, so that it doesn't stay
+//   expanded until the next time the buffer circles, see _PackColdRows.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void TextBuffer::PackColdRows() noexcept
 {
-    _firstRow = FirstRowIndex;
+    _PackColdRows();
 }
 
-void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT delta)
+// Routine Description:
+// - Enables a disk backed scrollback, limited only by the size of its file.
+//   Every row that scrolls off the top of this buffer is appended to a memory
+//   mapped ScrollbackArchive instead of being discarded. Scrolling up into the archive moves its rows back into
+//   the buffer, see PageInArchivedRows.
+// Arguments:
+// - maximumSize - the size of the archive's file, before its oldest rows are dropped
+// Return Value:
+// - <none>
+// Note: will throw exception if unable to create the archive
+void TextBuffer::EnableScrollbackArchive(const uint64_t maximumSize)
 {
-    // If we don't have to move anything, leave early.
-    if (delta == 0)
+    if (!_scrollbackArchive)
     {
-        return;
+        _scrollbackArchive = std::make_unique<ScrollbackArchive>(maximumSize);
     }
+}
 
-    // OK. We're about to play games by moving rows around within the deque to
-    // scroll a massive region in a faster way than copying things.
-    // To make this easier, first correct the circular buffer to have the first row be 0 again.
-    if (_firstRow != 0)
-    {
-        // Rotate the buffer to put the first row at the front.
-        std::rotate(_storage.begin(), _storage.begin() + _firstRow, _storage.end());
-
-        // The first row is now at the top.
-        _firstRow = 0;
-    }
-
-    // Rotate just the subsection specified
-    if (delta < 0)
-    {
-        // The layout is like this:
-        // delta is -2, size is 3, firstRow is 5
-        // We want 3 rows from 5 (5, 6, and 7) to move up 2 spots.
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 3 A. begin + firstRow + delta (because delta is negative)
-        // | 4
-        // | 5 B. begin + firstRow
-        // | 6
-        // | 7
-        // | 8 C. begin + firstRow + size
-        // | 9
-        // | 10
-        // | 11
-        // - end
-        // We want B to slide up to A (the negative delta) and everything from [B,C) to slide up with it.
-        // So the final layout will be
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 5
-        // | 6
-        // | 7
-        // | 3
-        // | 4
-        // | 8
-        // | 9
-        // | 10
-        // | 11
-        // - end
-        std::rotate(_storage.begin() + firstRow + delta, _storage.begin() + firstRow, _storage.begin() + firstRow + size);
-    }
-    else
+// Routine Description:
+// - Takes over the scrollback archive of another buffer, if it has one.
+// - Used when a buffer is replaced by a resized copy of itself.
+// Arguments:
+// - OtherBuffer - The text buffer to take the archive from
+// Return Value:
+// - <none>
+void TextBuffer::TakeScrollbackArchive(TextBuffer& OtherBuffer) noexcept
+{
+    _scrollbackArchive = std::move(OtherBuffer._scrollbackArchive);
+
+    // The archived rows are the ones that circled out of this buffer now, so that
+    // their marks (and those of the rows below) stay put when they're paged in.
+    const auto archived = _scrollbackArchive ? gsl::narrow_cast<uint64_t>(_scrollbackArchive->size()) : 0;
+    if (_circledRows < archived)
     {
-        // The layout is like this:
-        // delta is 2, size is 3, firstRow is 5
-        // We want 3 rows from 5 (5, 6, and 7) to move down 2 spots.
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 3
-        // | 4
-        // | 5 A. begin + firstRow
-        // | 6
-        // | 7
-        // | 8 B. begin + firstRow + size
-        // | 9
-        // | 10 C. begin + firstRow + size + delta
-        // | 11
-        // - end
-        // We want B-1 to slide down to C-1 (the positive delta) and everything from [A, B) to slide down with it.
-        // So the final layout will be
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 3
-        // | 4
-        // | 8
-        // | 9
-        // | 5
-        // | 6
-        // | 7
-        // | 10
-        // | 11
-        // - end
-        std::rotate(_storage.begin() + firstRow, _storage.begin() + firstRow + size, _storage.begin() + firstRow + size + delta);
-    }
-
-    // Renumber the IDs now that we've rearranged where the rows sit within the buffer.
-    // Refreshing should also delegate to the UnicodeStorage to re-key all the stored unicode sequences (where applicable).
-    _RefreshRowIDs(std::nullopt);
+        _promptMarks.MoveDown(archived - _circledRows);
+        _images.MoveDown(archived - _circledRows);
+        _circledRows = archived;
+    }
 }
 
-Cursor& TextBuffer::GetCursor() noexcept
+// Routine Description:
+// - Retrieves the archive of rows that scrolled off the top of this buffer.
+// Arguments:
+// - <none>
+// Return Value:
+// - The archive, or nullptr if EnableScrollbackArchive wasn't called.
+const ScrollbackArchive* TextBuffer::GetScrollbackArchive() const noexcept
 {
-    return _cursor;
+    return _scrollbackArchive.get();
 }
 
-const Cursor& TextBuffer::GetCursor() const noexcept
+// Routine Description:
+// - Drops every row of the scrollback archive, for when the scrollback is erased.
+// - The rows that were paged into the buffer are part of the scrollback now,
+//   which the caller erases along with the rest.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void TextBuffer::ClearScrollbackArchive() noexcept
 {
-    return _cursor;
+    if (_scrollbackArchive)
+    {
+        _scrollbackArchive->DropNewest(_scrollbackArchive->size());
+    }
+    _pagedInRows = 0;
 }
 
-[[nodiscard]] TextAttribute TextBuffer::GetCurrentAttributes() const noexcept
+// Routine Description:
+// - Gets the number of rows in the scrollback archive that PageInArchivedRows
+//   can move back into the buffer. The buffer can't grow taller than SHRT_MAX
+//   rows, so the older rows can only be exported, see ScrollbackArchive::GetRow.
+// Arguments:
+// - <none>
+// Return Value:
+// - the number of rows
+size_t TextBuffer::GetArchivedRowCount() const noexcept
 {
-    return _currentAttributes;
+    if (!_scrollbackArchive)
+    {
+        return 0;
+    }
+    const auto room = gsl::narrow_cast<size_t>(SHRT_MAX) - std::min<size_t>(_storage.size(), SHRT_MAX);
+    return std::min(_scrollbackArchive->size(), room);
 }
 
-void TextBuffer::SetCurrentAttributes(const TextAttribute& currentAttributes) noexcept
+// Routine Description:
+// - Gets the number of rows the buffer grew by to hold rows of the archive,
+//   which PageOutRows moves back into it.
+// Arguments:
+// - <none>
+// Return Value:
+// - the number of rows
+size_t TextBuffer::GetPagedInRowCount() const noexcept
 {
-    _currentAttributes = currentAttributes;
+    return _pagedInRows;
 }
 
-void TextBuffer::SetCurrentLineRendition(const LineRendition lineRendition)
+// Routine Description:
+// - Moves the newest rows of the scrollback archive back into the buffer, so
+//   that they can be scrolled to, searched and selected like any other row.
+// - The buffer grows by the rows above its first row, so every row already in
+//   the buffer (and the cursor) moves down by as many rows.
+// - Rows that a resize left as they were have to be reflowed first.
+// Arguments:
+// - count - the number of rows to move into the buffer
+// Return Value:
+// - the number of rows that were moved, which the caller has to move the viewport down by
+// Note: will throw exception if unable to allocate the rows
+size_t TextBuffer::PageInArchivedRows(const size_t count)
 {
-    const auto cursorPosition = GetCursor().GetPosition();
-    const auto rowIndex = cursorPosition.Y;
-    auto& row = GetRowByOffset(rowIndex);
-    if (row.GetLineRendition() != lineRendition)
+    const auto rows = std::min(count, GetArchivedRowCount());
+    if (rows == 0 || _pendingReflow)
     {
-        row.SetLineRendition(lineRendition);
-        // If the line rendition has changed, the row can no longer be wrapped.
-        row.SetWrapForced(false);
-        // And if it's no longer single width, the right half of the row should be erased.
-        if (lineRendition != LineRendition::SingleWidth)
+        return 0;
+    }
+
+    _FlushDeferredPaint();
+
+    const auto height = _storage.size() + rows;
+    CellArena newCharBuffer{ static_cast<size_t>(GetSize().Width()), height };
+    std::vector<ROW> storage;
+    storage.reserve(height);
+
+    const auto attributes = GetCurrentAttributes();
+    const auto first = _scrollbackArchive->size() - rows;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        auto& row = storage.emplace_back(i, newCharBuffer.GetRow(i), attributes, _attributes, _clock, this);
+        const auto archived = _scrollbackArchive->GetRow(first + i);
+
+        // The text was stored without its trailing spaces, and the attributes as runs.
+        row.WriteCells(OutputCellIterator{ archived.text }, 0, std::nullopt);
+        row.SetWrapForced(archived.wrapForced);
+
+        auto& attrRow = row.GetAttrRow();
+        const auto width = gsl::narrow_cast<uint16_t>(row.size());
+        uint16_t column = 0;
+        for (const auto& run : archived.attributes)
         {
-            const auto fillChar = L' ';
-            auto fillAttrs = GetCurrentAttributes();
-            fillAttrs.SetStandardErase();
-            const size_t fillOffset = GetLineWidth(rowIndex);
-            const size_t fillLength = GetSize().Width() - fillOffset;
-            const auto fillData = OutputCellIterator{ fillChar, fillAttrs, fillLength };
-            row.WriteCells(fillData, fillOffset, false);
-            // We also need to make sure the cursor is clamped within the new width.
-            GetCursor().SetPosition(ClampPositionWithinLine(cursorPosition));
+            if (column >= width)
+            {
+                break;
+            }
+            // The hyperlinks the rows referred to were pruned when they left the buffer.
+            auto attr = run.attr;
+            attr.SetHyperlinkId(0);
+            const auto end = gsl::narrow_cast<uint16_t>(std::min<size_t>(column + run.length, width));
+            attrRow.Replace(column, end, attr);
+            column = end;
         }
-        _NotifyPaint(Viewport::FromDimensions({ 0, rowIndex }, { GetSize().Width(), 1 }));
     }
-}
 
-void TextBuffer::ResetLineRenditionRange(const size_t startRow, const size_t endRow)
-{
-    for (auto row = startRow; row < endRow; row++)
+    _MoveRowsInto(newCharBuffer, storage, 0, _storage.size());
+    _storage = std::move(storage);
+    _charBuffer = std::move(newCharBuffer);
+    _SetFirstRowIndex(0);
+    _scrollbackArchive->DropNewest(rows);
+    _pagedInRows += rows;
+
+    // The rows circle back into the buffer, so the marks stay with their rows.
+    _circledRows -= std::min<uint64_t>(_circledRows, rows);
+
+    _RefreshRowIDs();
+    _UpdateSize();
+
+    auto position = _cursor.GetPosition();
+    position.Y += gsl::narrow_cast<SHORT>(rows);
+    _cursor.SetPosition(position);
+    if (_hotRowCount != 0)
     {
-        GetRowByOffset(row).SetLineRendition(LineRendition::SingleWidth);
+        _PackColdRows();
     }
+    return rows;
 }
 
-LineRendition TextBuffer::GetLineRendition(const size_t row) const
+// Routine Description:
+// - Moves rows paged in by PageInArchivedRows back into the scrollback archive,
+//   once they're not looked at anymore. The oldest rows of the buffer go, which
+//   shrinks back by as many rows, and every other row (and the cursor) moves up.
+// Arguments:
+// - count - the greatest number of rows to move out of the buffer
+// Return Value:
+// - the number of rows that were moved, which the caller has to move the viewport up by
+// Note: will throw exception if unable to allocate the rows
+size_t TextBuffer::PageOutRows(const size_t count)
 {
-    return GetRowByOffset(row).GetLineRendition();
-}
+    const auto cursorRow = gsl::narrow_cast<size_t>(std::max<SHORT>(_cursor.GetPosition().Y, 0));
+    const auto rows = std::min({ count, _pagedInRows, cursorRow });
+    if (!_scrollbackArchive || rows == 0 || _pendingReflow)
+    {
+        return 0;
+    }
 
-bool TextBuffer::IsDoubleWidthLine(const size_t row) const
-{
-    return GetLineRendition(row) != LineRendition::SingleWidth;
-}
+    _FlushDeferredPaint();
 
-SHORT TextBuffer::GetLineWidth(const size_t row) const
-{
-    // Use shift right to quickly divide the width by 2 for double width lines.
-    const SHORT scale = IsDoubleWidthLine(row) ? 1 : 0;
-    return GetSize().Width() >> scale;
-}
+    for (size_t i = 0; i < rows; ++i)
+    {
+        _scrollbackArchive->Append(GetRowByOffset(i));
+    }
 
-COORD TextBuffer::ClampPositionWithinLine(const COORD position) const
-{
-    const SHORT rightmostColumn = GetLineWidth(position.Y) - 1;
-    return { std::min(position.X, rightmostColumn), position.Y };
-}
+    const auto height = _storage.size() - rows;
+    CellArena newCharBuffer{ static_cast<size_t>(GetSize().Width()), height };
+    std::vector<ROW> storage;
+    storage.reserve(height);
 
-COORD TextBuffer::ScreenToBufferPosition(const COORD position) const
-{
-    // Use shift right to quickly divide the X pos by 2 for double width lines.
-    const SHORT scale = IsDoubleWidthLine(position.Y) ? 1 : 0;
-    return { position.X >> scale, position.Y };
-}
+    _MoveRowsInto(newCharBuffer, storage, rows, _storage.size());
+    _storage = std::move(storage);
+    _charBuffer = std::move(newCharBuffer);
+    _SetFirstRowIndex(0);
+    _pagedInRows -= rows;
 
-COORD TextBuffer::BufferToScreenPosition(const COORD position) const
-{
-    // Use shift left to quickly multiply the X pos by 2 for double width lines.
-    const SHORT scale = IsDoubleWidthLine(position.Y) ? 1 : 0;
-    return { position.X << scale, position.Y };
-}
+    _circledRows += rows;
+    _promptMarks.DropBefore(_circledRows);
+    _images.DropBefore(_circledRows);
 
-// Routine Description:
-// - Resets the text contents of this buffer with the default character
-//   and the default current color attributes
-void TextBuffer::Reset()
-{
-    const auto attr = GetCurrentAttributes();
+    _RefreshRowIDs();
+    _UpdateSize();
 
-    for (auto& row : _storage)
+    auto position = _cursor.GetPosition();
+    position.Y -= gsl::narrow_cast<SHORT>(rows);
+    _cursor.SetPosition(position);
+    if (_hotRowCount != 0)
     {
-        row.Reset(attr);
+        _PackColdRows();
     }
+    return rows;
 }
 
 // Routine Description:
-// - This is the legacy screen resize with minimal changes
+// - Moves the rows at the given offsets from the first row into the next slots
+//   of the given arena, appending them to the given storage in order.
+// - Used by PageInArchivedRows and PageOutRows, which grow and shrink the buffer
+//   at its top, where ResizeTraditional only ever changes it at the bottom.
 // Arguments:
-// - newSize - new size of screen.
+// - arena - the arena of the new storage
+// - storage - the new storage to append the rows to
+// - firstRow - the offset of the first row to move
+// - endRow - the offset past the last row to move
 // Return Value:
-// - Success if successful. Invalid parameter if screen buffer size is unexpected. No memory if allocation failed.
-[[nodiscard]] NTSTATUS TextBuffer::ResizeTraditional(const COORD newSize) noexcept
+// - <none>
+void TextBuffer::_MoveRowsInto(const CellArena& arena, std::vector<ROW>& storage, const size_t firstRow, const size_t endRow)
 {
-    RETURN_HR_IF(E_INVALIDARG, newSize.X < 0 || newSize.Y < 0);
-
-    try
+    for (auto i = firstRow; i < endRow; ++i)
     {
-        const auto currentSize = GetSize().Dimensions();
-        const auto attributes = GetCurrentAttributes();
-
-        SHORT TopRow = 0; // new top row of the screen buffer
-        if (newSize.Y <= GetCursor().GetPosition().Y)
-        {
-            TopRow = GetCursor().GetPosition().Y - newSize.Y + 1;
-        }
-        const SHORT TopRowIndex = (GetFirstRowIndex() + TopRow) % currentSize.Y;
-
-        // rotate rows until the top row is at index 0
-        for (int i = 0; i < TopRowIndex; i++)
-        {
-            _storage.emplace_back(std::move(_storage.front()));
-            _storage.erase(_storage.begin());
-        }
-
-        _SetFirstRowIndex(0);
-
-        // realloc in the Y direction
-        // remove rows if we're shrinking
-        while (_storage.size() > static_cast<size_t>(newSize.Y))
-        {
-            _storage.pop_back();
-        }
-        // add rows if we're growing
-        while (_storage.size() < static_cast<size_t>(newSize.Y))
-        {
-            _storage.emplace_back(static_cast<short>(_storage.size()), newSize.X, attributes, this);
-        }
-
-        // Now that we've tampered with the row placement, refresh all the row IDs.
-        // Also take advantage of the row ID refresh loop to resize the rows in the X dimension
-        // and cleanup the UnicodeStorage characters that might fall outside the resized buffer.
-        _RefreshRowIDs(newSize.X);
-
-        // Update the cached size value
-        _UpdateSize();
+        // Packed and lazily cleared rows are expanded first, as they're copied cell by cell.
+        auto& row = _GetRow((_firstRow + i) % _storage.size());
+        THROW_IF_FAILED(row.Resize(arena.GetRow(storage.size())));
+        storage.emplace_back(std::move(row));
     }
-    CATCH_RETURN();
-
-    return S_OK;
 }
 
-const UnicodeStorage& TextBuffer::GetUnicodeStorage() const noexcept
+// Routine Description:
+// - Marks the row of the cursor as the start of a prompt, a command or its
+//   output, as told by the shell with FTCS (OSC 133) sequences.
+// - The marks move along with their rows as the buffer circles and reflows.
+// Arguments:
+// - kind - what starts at the cursor
+// Return Value:
+// - <none>
+void TextBuffer::AddPromptMark(const PromptMarkKind kind)
 {
-    return _unicodeStorage;
+    const auto row = gsl::narrow_cast<uint64_t>(std::max<short>(GetCursor().GetPosition().Y, 0));
+    _promptMarks.Add(_circledRows + row, kind);
 }
 
-UnicodeStorage& TextBuffer::GetUnicodeStorage() noexcept
+// Routine Description:
+// - Finds the closest mark of the given kind above the given row.
+// Arguments:
+// - row - the row to search from. Its own marks aren't considered.
+// - kind - the kind of mark to look for
+// Return Value:
+// - The row of the mark, if there is one.
+std::optional<short> TextBuffer::FindPromptMarkBefore(const short row, const PromptMarkKind kind) const
 {
-    return _unicodeStorage;
+    const auto mark = _promptMarks.FindBefore(_circledRows + std::max<short>(row, 0), kind);
+    return mark ? _FromMarkRow(mark->row) : std::nullopt;
 }
 
 // Routine Description:
-// - Method to help refresh all the Row IDs after manipulating the row
-//   by shuffling pointers around.
-// - This will also update parent pointers that are stored in depth within the buffer
-//   (e.g. it will update CharRow parents pointing at Rows that might have been moved around)
-// - Optionally takes a new row width if we're resizing to perform a resize operation and cleanup
-//   any high unicode (UnicodeStorage) runs while we're already looping through the rows.
+// - Finds the closest mark of the given kind below the given row.
 // Arguments:
-// - newRowWidth - Optional new value for the row width.
-void TextBuffer::_RefreshRowIDs(std::optional<SHORT> newRowWidth)
+// - row - the row to search from. Its own marks aren't considered.
+// - kind - the kind of mark to look for
+// Return Value:
+// - The row of the mark, if there is one.
+std::optional<short> TextBuffer::FindPromptMarkAfter(const short row, const PromptMarkKind kind) const
 {
-    std::unordered_map<SHORT, SHORT> rowMap;
-    SHORT i = 0;
-    for (auto& it : _storage)
-    {
-        // Build a map so we can update Unicode Storage
-        rowMap.emplace(it.GetId(), i);
-
-        // Update the IDs
-        it.SetId(i++);
-
-        // Also update the char row parent pointers as they can get shuffled up in the rotates.
-        it.GetCharRow().UpdateParent(&it);
-
-        // Resize the rows in the X dimension if we have a new width
-        if (newRowWidth.has_value())
-        {
-            // Realloc in the X direction
-            THROW_IF_FAILED(it.Resize(newRowWidth.value()));
-        }
-    }
-
-    // Give the new mapping to Unicode Storage
-    _unicodeStorage.Remap(rowMap, newRowWidth);
+    const auto mark = _promptMarks.FindAfter(_circledRows + std::max<short>(row, 0), kind);
+    return mark ? _FromMarkRow(mark->row) : std::nullopt;
 }
 
-void TextBuffer::_NotifyPaint(const Viewport& viewport) const
+const PromptMarks& TextBuffer::GetPromptMarks() const noexcept
 {
-    _renderTarget.TriggerRedraw(viewport);
+    return _promptMarks;
 }
 
 // Routine Description:
-// - Retrieves the first row from the underlying buffer.
+// - Places an image with its top left corner at the cursor.
+// - The image is kept until its row scrolls out of the buffer or is erased, and
+//   is drawn over the text of the rows it covers. Images don't survive a reflow.
 // Arguments:
-// - <none>
+// - image - the decoded image
 // Return Value:
-//  - reference to the first row.
-ROW& TextBuffer::_GetFirstRow()
+// - <none>
+void TextBuffer::AddImage(std::shared_ptr<const ImageStore::Image> image)
 {
-    return GetRowByOffset(0);
+    const auto position = GetCursor().GetPosition();
+    const auto row = gsl::narrow_cast<uint64_t>(std::max<short>(position.Y, 0));
+    const auto height = gsl::narrow_cast<SHORT>(std::min<ptrdiff_t>(image->CellSize().height(), SHRT_MAX));
+    _images.Add(_circledRows + row, std::max<short>(position.X, 0), std::move(image));
+
+    _NotifyPaint(Viewport::FromDimensions({ 0, gsl::narrow_cast<SHORT>(row) }, GetSize().Width(), height));
 }
 
-// Routine Description:
-// - Retrieves the row that comes before the given row.
-// - Does not wrap around the screen buffer.
-// Arguments:
-// - The current row.
-// Return Value:
-// - reference to the previous row
-// Note:
-// - will throw exception if called with the first row of the text buffer
-ROW& TextBuffer::_GetPrevRowNoWrap(const ROW& Row)
+const ImageStore& TextBuffer::GetImages() const noexcept
 {
-    int prevRowIndex = Row.GetId() - 1;
-    if (prevRowIndex < 0)
-    {
-        prevRowIndex = TotalRowCount() - 1;
-    }
-
-    THROW_HR_IF(E_FAIL, Row.GetId() == _firstRow);
-    return _storage.at(prevRowIndex);
+    return _images;
 }
 
-// Method Description:
-// - Retrieves this buffer's current render target.
-// Arguments:
-// - <none>
+// Routine Description:
+// - Gets the number of rows that scrolled off the top of the buffer so far.
+//   Adding it to a row gives a number that stays the same for the text on
+//   that row while the buffer circles.
 // Return Value:
-// - This buffer's current render target.
-Microsoft::Console::Render::IRenderTarget& TextBuffer::GetRenderTarget() noexcept
+// - The number of rows that scrolled off the top
+uint64_t TextBuffer::GetCircledRows() const noexcept
 {
-    return _renderTarget;
+    return _circledRows;
 }
 
-// Method Description:
-// - get delimiter class for buffer cell position
-// - used for double click selection and uia word navigation
+// Routine Description:
+// - Converts the row of a mark into a row of the buffer.
 // Arguments:
-// - pos: the buffer cell under observation
-// - wordDelimiters: the delimiters defined as a part of the DelimiterClass::DelimiterChar
+// - row - the row of the mark
 // Return Value:
-// - the delimiter class for the given char
-const DelimiterClass TextBuffer::_GetDelimiterClassAt(const COORD pos, const std::wstring_view wordDelimiters) const
+// - The row of the buffer, unless it's not within the buffer.
+std::optional<short> TextBuffer::_FromMarkRow(const uint64_t row) const noexcept
 {
-    return GetRowByOffset(pos.Y).GetCharRow().DelimiterClassAt(pos.X, wordDelimiters);
+    if (row < _circledRows || row - _circledRows >= gsl::narrow_cast<uint64_t>(GetSize().Height()))
+    {
+        return std::nullopt;
+    }
+    return gsl::narrow_cast<short>(row - _circledRows);
 }
 
-// Method Description:
-// - Get the COORD for the beginning of the word you are on
+// Routine Description:
+// - Carries the marks of the old buffer over to this one, after it was reflowed from it.
+// - Rows are split and joined by a reflow, but the lines they make up stay the
+//   same, and so does the number of lines between any row and the cursor. Each
+//   mark is moved to the first row of its line. Marks below the cursor and of
+//   lines which didn't fit into this buffer are dropped.
 // Arguments:
-// - target - a COORD on the word you are currently on
-// - wordDelimiters - what characters are we considering for the separation of words
-// - accessibilityMode - when enabled, we continue expanding left until we are at the beginning of a readable word.
-//                        Otherwise, expand left until a character of a new delimiter class is found
-//                        (or a row boundary is encountered)
+// - oldBuffer - the buffer this one was reflowed from
 // Return Value:
-// - The COORD for the first character on the "word" (inclusive)
-const COORD TextBuffer::GetWordStart(const COORD target, const std::wstring_view wordDelimiters, bool accessibilityMode) const
+// - <none>
+void TextBuffer::_ReflowPromptMarks(const TextBuffer& oldBuffer)
 {
-    // Consider a buffer with this text in it:
-    // "  word   other  "
-    // In selection (accessibilityMode = false),
-    //  a "word" is defined as the range between two delimiters
-    //  so the words in the example include ["  ", "word", "   ", "other", "  "]
-    // In accessibility (accessibilityMode = true),
-    //  a "word" includes the delimiters after a range of readable characters
-    //  so the words in the example include ["word   ", "other  "]
-    // NOTE: the start anchor (this one) is inclusive, whereas the end anchor (GetWordEnd) is exclusive
-
-#pragma warning(suppress : 26496)
-    // GH#7664: Treat EndExclusive as EndInclusive so
-    // that it actually points to a space in the buffer
-    auto copy{ target };
-    const auto bufferSize{ GetSize() };
-    if (target == bufferSize.Origin())
-    {
-        // can't expand left
-        return target;
-    }
-    else if (target == bufferSize.EndExclusive())
+    _promptMarks.clear();
+    if (oldBuffer._promptMarks.empty())
     {
-        // treat EndExclusive as EndInclusive
-        copy = { bufferSize.RightInclusive(), bufferSize.BottomInclusive() };
+        return;
     }
 
-    if (accessibilityMode)
+    // Count the lines from the old cursor upwards, and note the line of every mark we pass.
+    std::vector<std::pair<size_t, PromptMarkKind>> markLines;
     {
-        return _GetWordStartForAccessibility(copy, wordDelimiters);
+        const auto& marks = oldBuffer._promptMarks;
+        auto lines = size_t{ 0 };
+        auto row = std::max<short>(oldBuffer.GetCursor().GetPosition().Y, 0);
+        for (auto i = marks.size(); i-- > 0;)
+        {
+            const auto markRow = oldBuffer._FromMarkRow(marks.at(i).row);
+            if (!markRow || *markRow > row)
+            {
+                continue;
+            }
+            for (; row > *markRow; --row)
+            {
+                lines += oldBuffer.GetRowByOffset(row - 1).WasWrapForced() ? 0 : 1;
+            }
+            markLines.emplace_back(lines, marks.at(i).Kind());
+        }
     }
-    else
+
+    // Walk up the same number of lines from the new cursor, to the first row of each of them.
+    auto lines = size_t{ 0 };
+    auto row = std::max<short>(GetCursor().GetPosition().Y, 0);
+    for (const auto& [markLine, kind] : markLines)
     {
-        return _GetWordStartForSelection(copy, wordDelimiters);
+        while (lines < markLine && row > 0)
+        {
+            --row;
+            lines += GetRowByOffset(row).WasWrapForced() ? 0 : 1;
+        }
+        if (lines < markLine)
+        {
+            break;
+        }
+        auto lineStart = row;
+        while (lineStart > 0 && GetRowByOffset(lineStart - 1).WasWrapForced())
+        {
+            --lineStart;
+        }
+        _promptMarks.Add(_circledRows + lineStart, kind);
     }
 }
 
-// Method Description:
-// - Helper method for GetWordStart(). Get the COORD for the beginning of the word (accessibility definition) you are on
+// Routine Description:
+// - Packs all rows that are outside of the hot region above the cursor (see SetHotRowCount)
+//   and decommits the parts of the cell arena that only hold packed rows.
 // Arguments:
-// - target - a COORD on the word you are currently on
-// - wordDelimiters - what characters are we considering for the separation of words
+// - <none>
 // Return Value:
-// - The COORD for the first character on the current/previous READABLE "word" (inclusive)
-const COORD TextBuffer::_GetWordStartForAccessibility(const COORD target, const std::wstring_view wordDelimiters) const
+// - <none>
+void TextBuffer::_PackColdRows() noexcept
+try
 {
-    COORD result = target;
-    const auto bufferSize = GetSize();
-    bool stayAtOrigin = false;
+    const auto cursorRow = gsl::narrow_cast<size_t>(GetCursor().GetPosition().Y);
+    if (cursorRow <= _hotRowCount)
+    {
+        return;
+    }
 
-    // ignore left boundary. Continue until readable text found
-    while (_GetDelimiterClassAt(result, wordDelimiters) != DelimiterClass::RegularChar)
+    const auto coldRows = cursorRow - _hotRowCount;
+    for (size_t i = 0; i < coldRows; ++i)
     {
-        if (!bufferSize.DecrementInBounds(result))
-        {
-            // first char in buffer is a DelimiterChar or ControlChar
-            // we can't move any further back
-            stayAtOrigin = true;
-            break;
-        }
+        const auto offsetIndex = (_firstRow + i) % _storage.size();
+        til::at(_storage, offsetIndex).Pack(_packedRowStore.get());
+    }
+    if (_packedRowStore)
+    {
+        // The rows recycled since the last time let go of their cells.
+        _packedRowStore->Prune();
     }
 
-    // make sure we expand to the left boundary or the beginning of the word
-    while (_GetDelimiterClassAt(result, wordDelimiters) == DelimiterClass::RegularChar)
+    // Rows don't necessarily sit in the arena slot matching their position in
+    // _storage (ScrollRows rotates them), so look up which slots are packed.
+    std::vector<bool> packedSlots(_storage.size());
+    for (const auto& row : _storage)
     {
-        if (!bufferSize.DecrementInBounds(result))
+        if (row.IsPacked())
         {
-            // first char in buffer is a RegularChar
-            // we can't move any further back
-            break;
+            packedSlots.at(_charBuffer.GetRowIndex(row.GetCharRow().GetArenaCells())) = true;
         }
     }
 
-    // move off of delimiter and onto word start
-    if (!stayAtOrigin && _GetDelimiterClassAt(result, wordDelimiters) != DelimiterClass::RegularChar)
+    // Decommit every consecutive run of packed slots.
+    for (size_t begin = 0; begin < packedSlots.size();)
     {
-        bufferSize.IncrementInBounds(result);
-    }
+        if (!packedSlots.at(begin))
+        {
+            ++begin;
+            continue;
+        }
 
-    return result;
+        auto end = begin + 1;
+        while (end < packedSlots.size() && packedSlots.at(end))
+        {
+            ++end;
+        }
+
+        _charBuffer.Decommit(begin, end);
+        begin = end;
+    }
 }
+CATCH_LOG()
 
-// Method Description:
-// - Helper method for GetWordStart(). Get the COORD for the beginning of the word (selection definition) you are on
-// Arguments:
-// - target - a COORD on the word you are currently on
-// - wordDelimiters - what characters are we considering for the separation of words
-// Return Value:
-// - The COORD for the first character on the current word or delimiter run (stopped by the left margin)
-const COORD TextBuffer::_GetWordStartForSelection(const COORD target, const std::wstring_view wordDelimiters) const
+//Routine Description:
+// - Retrieves the position of the last non-space character in the given
+//   viewport
+// - By default, we search the entire buffer to find the last non-space
+//   character.
+// - If we know the last character is within the given viewport (so we don't
+//   need to check the entire buffer), we can provide a value in viewOptional
+//   that we'll use to search for the last character in.
+//Arguments:
+// - The viewport
+//Return value:
+// - Coordinate position (relative to the text buffer)
+COORD TextBuffer::GetLastNonSpaceCharacter(std::optional<const Microsoft::Console::Types::Viewport> viewOptional) const
 {
-    COORD result = target;
-    const auto bufferSize = GetSize();
-
-    const auto initialDelimiter = _GetDelimiterClassAt(result, wordDelimiters);
+    const auto viewport = viewOptional.has_value() ? viewOptional.value() : GetSize();
 
-    // expand left until we hit the left boundary or a different delimiter class
-    while (result.X > bufferSize.Left() && (_GetDelimiterClassAt(result, wordDelimiters) == initialDelimiter))
+    const auto generation = _clock.Now();
+    const auto rect = viewport.ToInclusive();
     {
-        bufferSize.DecrementInBounds(result);
+        const std::lock_guard lock{ _lastNonSpaceLock };
+        if (_lastNonSpace.generation == generation && _lastNonSpace.firstRow == _firstRow && _lastNonSpace.viewport == rect)
+        {
+            return _lastNonSpace.position;
+        }
     }
 
-    if (_GetDelimiterClassAt(result, wordDelimiters) != initialDelimiter)
-    {
-        // move off of delimiter
-        bufferSize.IncrementInBounds(result);
-    }
+    const auto measureRight = [this](const SHORT y) {
+        return gsl::narrow<short>(GetRowByOffset(y).MeasureRight());
+    };
 
-    return result;
-}
+    COORD coordEndOfText = { 0 };
+    // Search the given viewport by starting at the bottom.
+    coordEndOfText.Y = viewport.BottomInclusive();
 
-// Method Description:
-// - Get the COORD for the beginning of the NEXT word
-// Arguments:
-// - target - a COORD on the word you are currently on
-// - wordDelimiters - what characters are we considering for the separation of words
-// - accessibilityMode - when enabled, we continue expanding right until we are at the beginning of the next READABLE word
-//                        Otherwise, expand right until a character of a new delimiter class is found
-//                        (or a row boundary is encountered)
-// Return Value:
-// - The COORD for the last character on the "word" (inclusive)
-const COORD TextBuffer::GetWordEnd(const COORD target, const std::wstring_view wordDelimiters, bool accessibilityMode) const
-{
-    // Consider a buffer with this text in it:
-    // "  word   other  "
-    // In selection (accessibilityMode = false),
-    //  a "word" is defined as the range between two delimiters
-    //  so the words in the example include ["  ", "word", "   ", "other", "  "]
-    // In accessibility (accessibilityMode = true),
-    //  a "word" includes the delimiters after a range of readable characters
-    //  so the words in the example include ["word   ", "other  "]
-    // NOTE: the end anchor (this one) is exclusive, whereas the start anchor (GetWordStart) is inclusive
+    // The X position of the end of the valid text is the Right draw boundary (which is one beyond the final valid character)
+    coordEndOfText.X = measureRight(coordEndOfText.Y) - 1;
 
-    // Already at the end. Can't move forward.
-    if (target == GetSize().EndExclusive())
+    // If the X coordinate turns out to be -1, the row was empty, we need to search backwards for the real end of text.
+    const auto viewportTop = viewport.Top();
+    bool fDoBackUp = (coordEndOfText.X < 0 && coordEndOfText.Y > viewportTop); // this row is empty, and we're not at the top
+    while (fDoBackUp)
     {
-        return target;
+        coordEndOfText.Y--;
+        // We need to back up to the previous row if this line is empty, AND there are more rows
+        coordEndOfText.X = measureRight(coordEndOfText.Y) - 1;
+        fDoBackUp = (coordEndOfText.X < 0 && coordEndOfText.Y > viewportTop);
     }
 
-    if (accessibilityMode)
-    {
-        const auto lastCharPos{ GetLastNonSpaceCharacter() };
-        return _GetWordEndForAccessibility(target, wordDelimiters, lastCharPos);
-    }
-    else
-    {
-        return _GetWordEndForSelection(target, wordDelimiters);
-    }
+    // don't allow negative results
+    coordEndOfText.Y = std::max(coordEndOfText.Y, 0i16);
+    coordEndOfText.X = std::max(coordEndOfText.X, 0i16);
+
+    // Concurrent callers measure the same rows, so it doesn't matter whose result is kept.
+    const std::lock_guard lock{ _lastNonSpaceLock };
+    _lastNonSpace = { generation, _firstRow, rect, coordEndOfText };
+    return coordEndOfText;
 }
 
-// Method Description:
-// - Helper method for GetWordEnd(). Get the COORD for the beginning of the next READABLE word
+// Routine Description:
+// - Retrieves the position of the previous character relative to the current cursor position
 // Arguments:
-// - target - a COORD on the word you are currently on
-// - wordDelimiters - what characters are we considering for the separation of words
-// - lastCharPos - the position of the last nonspace character in the text buffer (to improve performance)
+// - <none>
 // Return Value:
-// - The COORD for the first character of the next readable "word". If no next word, return one past the end of the buffer
-const COORD TextBuffer::_GetWordEndForAccessibility(const COORD target, const std::wstring_view wordDelimiters, const COORD lastCharPos) const
+// - Coordinate position in screen coordinates of the character just before the cursor.
+// - NOTE: Will return 0,0 if already in the top left corner
+COORD TextBuffer::_GetPreviousFromCursor() const
 {
-    const auto bufferSize = GetSize();
-    COORD result = target;
+    COORD coordPosition = GetCursor().GetPosition();
 
-    // Check if we're already on/past the last RegularChar
-    if (bufferSize.CompareInBounds(result, lastCharPos, true) >= 0)
+    // If we're not at the left edge, simply move the cursor to the left by one
+    if (coordPosition.X > 0)
     {
-        return bufferSize.EndExclusive();
+        coordPosition.X--;
     }
-
-    // ignore right boundary. Continue through readable text found
-    while (_GetDelimiterClassAt(result, wordDelimiters) == DelimiterClass::RegularChar)
+    else
     {
-        if (!bufferSize.IncrementInBounds(result, true))
+        // Otherwise, only if we're not on the top row (e.g. we don't move anywhere in the top left corner. there is no previous)
+        if (coordPosition.Y > 0)
         {
-            break;
+            // move the cursor up one line
+            coordPosition.Y--;
+
+            // and to the right edge
+            coordPosition.X = GetLineWidth(coordPosition.Y) - 1;
         }
     }
 
-    // we are already on/past the last RegularChar
-    if (bufferSize.CompareInBounds(result, lastCharPos, true) >= 0)
-    {
-        return bufferSize.EndExclusive();
-    }
+    return coordPosition;
+}
 
-    // make sure we expand to the beginning of the NEXT word
-    while (_GetDelimiterClassAt(result, wordDelimiters) != DelimiterClass::RegularChar)
-    {
-        if (!bufferSize.IncrementInBounds(result, true))
-        {
-            // we are at the EndInclusive COORD
-            // this signifies that we must include the last char in the buffer
-            // but the position of the COORD points to nothing
-            break;
-        }
-    }
+size_t TextBuffer::GetFirstRowIndex() const noexcept
+{
+    return _firstRow;
+}
 
-    return result;
+const Viewport TextBuffer::GetSize() const noexcept
+{
+    return _size;
 }
 
-// Method Description:
-// - Helper method for GetWordEnd(). Get the COORD for the beginning of the NEXT word
+void TextBuffer::_UpdateSize()
+{
+    _size = Viewport::FromDimensions({ 0, 0 }, { gsl::narrow<SHORT>(_storage.at(0).size()), gsl::narrow<SHORT>(_storage.size()) });
+}
+
+void TextBuffer::_SetFirstRowIndex(const size_t FirstRowIndex) noexcept
+{
+    _firstRow = FirstRowIndex;
+}
+
+// Routine Description:
+// - Gets the generation of the most recent modification of any row of the buffer.
+// - Remember it to find the rows modified since then with GetRowsChangedSince.
 // Arguments:
-// - target - a COORD on the word you are currently on
-// - wordDelimiters - what characters are we considering for the separation of words
+// - <none>
 // Return Value:
-// - The COORD for the last character of the current word or delimiter run (stopped by right margin)
-const COORD TextBuffer::_GetWordEndForSelection(const COORD target, const std::wstring_view wordDelimiters) const
+// - the current generation of the buffer
+uint64_t TextBuffer::GetGeneration() const noexcept
 {
-    const auto bufferSize = GetSize();
+    return _clock.Now();
+}
 
-    // can't expand right
-    if (target.X == bufferSize.RightInclusive())
+// Routine Description:
+// - Gets the generation in which a row was last modified, without expanding
+//   the row if it's packed or was reset lazily.
+// Arguments:
+// - row - the offset of the row
+// Return Value:
+// - the generation of the row
+uint64_t TextBuffer::GetRowGeneration(const size_t row) const
+{
+    return _storage.at((_firstRow + row) % _storage.size()).GetGeneration();
+}
+
+// Routine Description:
+// - Estimates the memory used by the buffer, broken down by what it's used for.
+// Arguments:
+// - <none>
+// Return Value:
+// - the breakdown, in bytes
+BufferMemoryUsage TextBuffer::GetMemoryUsage() const noexcept
+{
+    BufferMemoryUsage usage;
+    usage.rows = BufferMemoryUsage::Of(_storage) + BufferMemoryUsage::Of(_rowHyperlinks) + _promptMarks.GetMemoryUsage();
+    usage.images = _images.GetMemoryUsage();
+    const auto rowSize = gsl::narrow_cast<size_t>(GetSize().Width()) * sizeof(CharRowCell);
+    for (const auto& row : _storage)
     {
-        return target;
+        // The arena slots of packed rows are decommitted.
+        if (!row.IsPacked())
+        {
+            usage.cells += rowSize;
+        }
+        row.AddMemoryUsage(usage);
     }
-
-    COORD result = target;
-    const auto initialDelimiter = _GetDelimiterClassAt(result, wordDelimiters);
-
-    // expand right until we hit the right boundary or a different delimiter class
-    while (result.X < bufferSize.RightInclusive() && (_GetDelimiterClassAt(result, wordDelimiters) == initialDelimiter))
+    for (const auto& rowHyperlinks : _rowHyperlinks)
     {
-        bufferSize.IncrementInBounds(result);
+        usage.hyperlinks += BufferMemoryUsage::Of(rowHyperlinks.ids);
     }
 
-    if (_GetDelimiterClassAt(result, wordDelimiters) != initialDelimiter)
+    if (_packedRowStore)
     {
-        // move off of delimiter
-        bufferSize.DecrementInBounds(result);
+        usage.packedCells += sizeof(PackedRowStore) + _packedRowStore->GetMemoryUsage();
     }
-
-    return result;
-}
-
-void TextBuffer::_PruneHyperlinks()
-{
-    // Check the old first row for hyperlink references
-    // If there are any, search the entire buffer for the same reference
-    // If the buffer does not contain the same reference, we can remove that hyperlink from our map
-    // This way, obsolete hyperlink references are cleared from our hyperlink map instead of hanging around
-    // Get all the hyperlink references in the row we're erasing
-    const auto hyperlinks = _storage.at(_firstRow).GetAttrRow().GetHyperlinks();
-
-    if (!hyperlinks.empty())
-    {
-        // Move to unordered set so we can use hashed lookup of IDs instead of linear search.
-        // Only make it an unordered set now because set always heap allocates but vector
-        // doesn't when the set is empty (saving an allocation in the common case of no links.)
-        std::unordered_set<uint16_t> firstRowRefs{ hyperlinks.cbegin(), hyperlinks.cend() };
-
-        const auto total = TotalRowCount();
-        // Loop through all the rows in the buffer except the first row -
-        // we have found all hyperlink references in the first row and put them in refs,
-        // now we need to search the rest of the buffer (i.e. all the rows except the first)
-        // to see if those references are anywhere else
-        for (size_t i = 1; i != total; ++i)
-        {
-            const auto nextRowRefs = GetRowByOffset(i).GetAttrRow().GetHyperlinks();
-            for (auto id : nextRowRefs)
-            {
-                if (firstRowRefs.find(id) != firstRowRefs.end())
-                {
-                    firstRowRefs.erase(id);
-                }
-            }
-            if (firstRowRefs.empty())
+    usage.attributes += _attributes.GetMemoryUsage();
+    usage.hyperlinks += _hyperlinks.GetMemoryUsage();
+    usage.patterns = _patternMatcher.GetMemoryUsage() + BufferMemoryUsage::OfMap(_patternCache);
+    for (const auto& [id, entry] : _patternCache)
+    {
+        usage.patterns += BufferMemoryUsage::Of(entry.generations) + BufferMemoryUsage::Of(entry.matches);
+    }
+    usage.searchIndex = _searchIndex.GetMemoryUsage();
+    {
+        const std::lock_guard lock{ _delimiterClassesLock };
+        usage.delimiterClasses = BufferMemoryUsage::Of(_delimiterClasses) + _delimiterClassesFor.capacity() * sizeof(wchar_t);
+        for (const auto& classes : _delimiterClasses)
+        {
+            if (classes)
             {
-                // No more hyperlink references left to search for, terminate early
-                break;
+                usage.delimiterClasses += sizeof(DelimiterClasses) + BufferMemoryUsage::Of(classes->regular) + BufferMemoryUsage::Of(classes->delimiter);
             }
         }
-
-        // Now delete obsolete references from our map
-        for (auto hyperlinkReference : firstRowRefs)
+    }
+    {
+        const std::lock_guard lock{ _rowTextsLock };
+        usage.rowTexts = BufferMemoryUsage::Of(_rowTexts);
+        for (const auto& rowText : _rowTexts)
         {
-            RemoveHyperlinkFromMap(hyperlinkReference);
+            usage.rowTexts += rowText.text.capacity() * sizeof(wchar_t) + BufferMemoryUsage::Of(rowText.offsets);
         }
     }
+    if (_scrollbackArchive)
+    {
+        usage.scrollbackArchive = sizeof(ScrollbackArchive) + _scrollbackArchive->GetMemoryUsage();
+        usage.scrollbackArchiveFile = _scrollbackArchive->GetFileSize();
+    }
+    return usage;
 }
 
-// Method Description:
-// - Update pos to be the position of the first character of the next word. This is used for accessibility
+// Routine Description:
+// - Gives back the memory the buffer doesn't need while it's idle: the caches
+//   that are built on demand (the texts, delimiter classes and patterns of the
+//   rows and the search index) are dropped, and the rows give back the capacity
+//   their attributes and glyphs don't use anymore.
 // Arguments:
-// - pos - a COORD on the word you are currently on
-// - wordDelimiters - what characters are we considering for the separation of words
-// - lastCharPos - the position of the last nonspace character in the text buffer (to improve performance)
+// - <none>
 // Return Value:
-// - true, if successfully updated pos. False, if we are unable to move (usually due to a buffer boundary)
-// - pos - The COORD for the first character on the "word" (inclusive)
-bool TextBuffer::MoveToNextWord(COORD& pos, const std::wstring_view wordDelimiters, COORD lastCharPos) const
+// - <none>
+void TextBuffer::Trim() noexcept
+try
 {
-    // move to the beginning of the next word
-    // NOTE: _GetWordEnd...() returns the exclusive position of the "end of the word"
-    //       This is also the inclusive start of the next word.
-    auto copy{ _GetWordEndForAccessibility(pos, wordDelimiters, lastCharPos) };
-
-    if (copy == GetSize().EndExclusive())
     {
-        return false;
+        const std::lock_guard lock{ _rowTextsLock };
+        _rowTexts = {};
+    }
+    {
+        const std::lock_guard lock{ _delimiterClassesLock };
+        _delimiterClasses = {};
+    }
+    _patternCache = {};
+    _searchIndex = {};
+    if (_packedRowStore)
+    {
+        _packedRowStore->Prune();
     }
 
-    pos = copy;
-    return true;
+    for (auto& row : _storage)
+    {
+        row.Trim();
+    }
 }
+CATCH_LOG()
 
-// Method Description:
-// - Update pos to be the position of the first character of the previous word. This is used for accessibility
+// Routine Description:
+// - Finds the rows whose text, attributes or properties changed after the given generation.
+// - Note that circling the buffer moves every row up by one without modifying it,
+//   apart from the recycled row. Consumers remembering row offsets have to account
+//   for that, just like they do for the scrolling they're notified about.
 // Arguments:
-// - pos - a COORD on the word you are currently on
-// - wordDelimiters - what characters are we considering for the separation of words
+// - generation - a generation previously returned by GetGeneration
+// - firstRow - the offset of the first row to check
+// - lastRow - the offset of the last row to check (inclusive)
 // Return Value:
-// - true, if successfully updated pos. False, if we are unable to move (usually due to a buffer boundary)
-// - pos - The COORD for the first character on the "word" (inclusive)
-bool TextBuffer::MoveToPreviousWord(COORD& pos, std::wstring_view wordDelimiters) const
+// - the offsets of the changed rows, in ascending order
+std::vector<size_t> TextBuffer::GetRowsChangedSince(const uint64_t generation, const size_t firstRow, const size_t lastRow) const
 {
-    // move to the beginning of the current word
-    auto copy{ GetWordStart(pos, wordDelimiters, true) };
-
-    if (!GetSize().DecrementInBounds(copy, true))
+    std::vector<size_t> rows;
+    const auto height = _storage.size();
+    for (auto row = firstRow; row <= lastRow && row < height; ++row)
     {
-        // can't move behind current word
-        return false;
+        // Looking at the stamp doesn't require a packed or lazily cleared row to be expanded.
+        if (til::at(_storage, (_firstRow + row) % height).GetGeneration() > generation)
+        {
+            rows.push_back(row);
+        }
     }
-
-    // move to the beginning of the previous word
-    pos = GetWordStart(copy, wordDelimiters, true);
-    return true;
+    return rows;
 }
 
-// Method Description:
-// - Update pos to be the beginning of the current glyph/character. This is used for accessibility
+// Routine Description:
+// - Takes a snapshot of a range of rows, which can be read without holding the
+//   console lock once this returns. See TextBufferSnapshot.
+// - If nobody but the caller holds on to the previous snapshot anymore, it's
+//   refreshed in place, copying only the rows that changed since it was taken.
+//   Rows which moved, like after circling the buffer, are copied again as well.
 // Arguments:
-// - pos - a COORD on the word you are currently on
+// - firstRow - the offset of the first row to take
+// - height - the number of rows to take. Clamped to the rows of the buffer.
+// - previous - the snapshot taken the last time, if any
 // Return Value:
-// - pos - The COORD for the first cell of the current glyph (inclusive)
-const til::point TextBuffer::GetGlyphStart(const til::point pos) const
+// - the snapshot of the rows. It's the same object as previous, if that was reused.
+std::shared_ptr<const TextBufferSnapshot> TextBuffer::TakeSnapshot(const SHORT firstRow,
+                                                                   const SHORT height,
+                                                                   std::shared_ptr<const TextBufferSnapshot> previous) const
 {
-    COORD resultPos = pos;
-    const auto bufferSize = GetSize();
-
-    if (resultPos == bufferSize.EndExclusive())
+    const auto totalRows = gsl::narrow<SHORT>(_storage.size());
+    const auto first = std::clamp<SHORT>(firstRow, 0, totalRows);
+    const auto rows = std::clamp<SHORT>(height, 0, totalRows - first);
+    const COORD size{ GetSize().Width(), rows };
+
+    std::shared_ptr<TextBufferSnapshot> snapshot;
+    if (previous && previous.use_count() == 1 && previous->_sourceEpoch == _snapshotEpoch &&
+        previous->GetBuffer().GetSize().Dimensions() == size)
     {
-        bufferSize.DecrementInBounds(resultPos, true);
+        // Nobody is reading the previous snapshot anymore, so it's ours to change.
+        snapshot = std::const_pointer_cast<TextBufferSnapshot>(std::move(previous));
+    }
+    else
+    {
+        snapshot = std::make_shared<TextBufferSnapshot>(size, _currentAttributes);
+        snapshot->_sourceEpoch = _snapshotEpoch;
     }
 
-    if (resultPos != bufferSize.EndExclusive() && GetCellDataAt(resultPos)->DbcsAttr().IsTrailing())
+    for (SHORT row = 0; row < rows; ++row)
     {
-        bufferSize.DecrementInBounds(resultPos, true);
+        const auto index = gsl::narrow_cast<size_t>((_firstRow + first + row) % totalRows);
+        auto& copied = til::at(snapshot->_sources, row);
+        if (copied != TextBufferSnapshot::RowSource{ index, til::at(_storage, index).GetGeneration() })
+        {
+            // Expanding a lazily cleared row stamps it, so the generation is looked at once more afterwards.
+            const auto& source = GetRowByOffset(first + row);
+            snapshot->_buffer->GetRowByOffset(row).CopyFrom(source);
+            copied = TextBufferSnapshot::RowSource{ index, source.GetGeneration() };
+        }
     }
 
-    return resultPos;
+    snapshot->_firstRow = first;
+    snapshot->_generation = GetGeneration();
+    return snapshot;
 }
 
-// Method Description:
-// - Update pos to be the end of the current glyph/character. This is used for accessibility
+// Routine Description:
+// - Moves the given rows up or down by delta rows.
+//   The rows they land on move into the space they vacated.
+// - The rows are swapped between their slots in the circular storage rather
+//   than copied, so this takes time proportional to the number of rows moved
+//   and doesn't depend on the width of the buffer or the size of the scrollback.
 // Arguments:
-// - pos - a COORD on the word you are currently on
-// Return Value:
-// - pos - The COORD for the last cell of the current glyph (exclusive)
-const til::point TextBuffer::GetGlyphEnd(const til::point pos) const
+// - firstRow - the offset of the first row to move
+// - size - the number of rows to move
+// - delta - how far to move them (negative to move them up)
+void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT delta)
 {
-    COORD resultPos = pos;
+    // If we don't have to move anything, leave early.
+    if (delta == 0)
+    {
+        return;
+    }
 
-    const auto bufferSize = GetSize();
-    if (resultPos != bufferSize.EndExclusive() && GetCellDataAt(resultPos)->DbcsAttr().IsLeading())
+    _FlushDeferredPaint();
+
+    // The moved rows and the ones they land on form a band, and the whole
+    // operation is a rotation of the band. For instance with size 3 and delta -2:
+    //   before: 3 4 [5 6 7]     after: [5 6 7] 3 4
+    // and with size 3 and delta 2:
+    //   before: [5 6 7] 8 9     after: 8 9 [5 6 7]
+    // The band may wrap around the end of _storage, so it's rotated by
+    // reversing both of its parts and then all of it, which works on offsets.
+    const auto bandTop = gsl::narrow_cast<size_t>(delta < 0 ? firstRow + delta : firstRow);
+    const auto bandHeight = gsl::narrow_cast<size_t>(size + std::abs(delta));
+    const auto newTop = gsl::narrow_cast<size_t>(delta < 0 ? -delta : size);
+
+    _ReverseRows(bandTop, bandTop + newTop);
+    _ReverseRows(bandTop + newTop, bandTop + bandHeight);
+    _ReverseRows(bandTop, bandTop + bandHeight);
+
+    // The rows were swapped without their IDs, which are the index of their slot, so put those back.
+    // The stored unicode sequences live within their rows, so they move along without re-keying.
+    const auto totalRows = _storage.size();
+    const auto movedTop = gsl::narrow_cast<size_t>(firstRow + delta);
+    for (auto i = bandTop; i < bandTop + bandHeight; ++i)
     {
-        bufferSize.IncrementInBounds(resultPos, true);
+        const auto slot = (_firstRow + i) % totalRows;
+        auto& row = til::at(_storage, slot);
+        row.SetId(slot);
+
+        // Only the moved rows are stamped. The others are about to be filled.
+        if (i >= movedTop && i < movedTop + size)
+        {
+            row.MarkModified();
+        }
     }
 
-    // increment one more time to become exclusive
-    bufferSize.IncrementInBounds(resultPos, true);
-    return resultPos;
-}
+    // The pattern cache is keyed by row ID and the search index by the
+    // position of rows in the storage, both of which changed for the band.
+    _patternCache.clear();
+    _searchIndex.Clear();
 
-// Method Description:
-// - Update pos to be the beginning of the next glyph/character. This is used for accessibility
-// Arguments:
-// - pos - a COORD on the word you are currently on
-// - allowBottomExclusive - allow the nonexistent end-of-buffer cell to be encountered
-// Return Value:
-// - true, if successfully updated pos. False, if we are unable to move (usually due to a buffer boundary)
+    // Images aren't split along the edges of the band, so the ones that start in it are dropped.
+    _images.Erase(_circledRows + bandTop, _circledRows + bandTop + bandHeight);
+
+    // The marks of the band are rotated along with their rows.
+    if (!_promptMarks.empty())
+    {
+        const auto bandBegin = _circledRows + bandTop;
+        const auto bandEnd = bandBegin + bandHeight;
+        const auto movedBegin = _circledRows + firstRow;
+        const auto movedEnd = movedBegin + size;
+
+        std::vector<PromptMarks::Mark> marks;
+        for (size_t i = 0; i < _promptMarks.size(); ++i)
+        {
+            const auto& mark = _promptMarks.at(i);
+            if (mark.row >= bandBegin && mark.row < bandEnd)
+            {
+                marks.push_back(mark);
+            }
+        }
+
+        _promptMarks.Erase(bandBegin, bandEnd);
+        for (const auto& mark : marks)
+        {
+            const auto moved = mark.row >= movedBegin && mark.row < movedEnd;
+            const auto row = moved ? mark.row + delta : delta < 0 ? mark.row + size : mark.row - size;
+            _promptMarks.Add(row, mark.Kind());
+        }
+    }
+}
+
+// Routine Description:
+// - Reverses the order of the given rows by swapping them between their slots.
+// Arguments:
+// - begin - the offset of the first row
+// - end - the offset past the last row
+void TextBuffer::_ReverseRows(size_t begin, size_t end)
+{
+    const auto totalRows = _storage.size();
+    while (begin + 1 < end)
+    {
+        --end;
+        std::swap(til::at(_storage, (_firstRow + begin) % totalRows), til::at(_storage, (_firstRow + end) % totalRows));
+        ++begin;
+    }
+}
+
+Cursor& TextBuffer::GetCursor() noexcept
+{
+    return _cursor;
+}
+
+const Cursor& TextBuffer::GetCursor() const noexcept
+{
+    return _cursor;
+}
+
+[[nodiscard]] TextAttribute TextBuffer::GetCurrentAttributes() const noexcept
+{
+    return _currentAttributes;
+}
+
+void TextBuffer::SetCurrentAttributes(const TextAttribute& currentAttributes) noexcept
+{
+    _currentAttributes = currentAttributes;
+}
+
+void TextBuffer::SetCurrentLineRendition(const LineRendition lineRendition)
+{
+    const auto cursorPosition = GetCursor().GetPosition();
+    const auto rowIndex = cursorPosition.Y;
+    auto& row = GetRowByOffset(rowIndex);
+    if (row.GetLineRendition() != lineRendition)
+    {
+        row.SetLineRendition(lineRendition);
+        // If the line rendition has changed, the row can no longer be wrapped.
+        row.SetWrapForced(false);
+        // And if it's no longer single width, the right half of the row should be erased.
+        if (lineRendition != LineRendition::SingleWidth)
+        {
+            const auto fillChar = L' ';
+            auto fillAttrs = GetCurrentAttributes();
+            fillAttrs.SetStandardErase();
+            const size_t fillOffset = GetLineWidth(rowIndex);
+            const size_t fillLength = GetSize().Width() - fillOffset;
+            const auto fillData = OutputCellIterator{ fillChar, fillAttrs, fillLength };
+            row.WriteCells(fillData, fillOffset, false);
+            // We also need to make sure the cursor is clamped within the new width.
+            GetCursor().SetPosition(ClampPositionWithinLine(cursorPosition));
+        }
+        _NotifyPaint(Viewport::FromDimensions({ 0, rowIndex }, { GetSize().Width(), 1 }));
+    }
+}
+
+void TextBuffer::ResetLineRenditionRange(const size_t startRow, const size_t endRow)
+{
+    // The rows are looked up directly, so rows that were erased by EraseRows stay lazily cleared.
+    const auto totalRows = _storage.size();
+    for (auto row = startRow; row < endRow; row++)
+    {
+        til::at(_storage, (_firstRow + row) % totalRows).SetLineRendition(LineRendition::SingleWidth);
+    }
+}
+
+LineRendition TextBuffer::GetLineRendition(const size_t row) const
+{
+    return GetRowByOffset(row).GetLineRendition();
+}
+
+bool TextBuffer::IsDoubleWidthLine(const size_t row) const
+{
+    return GetLineRendition(row) != LineRendition::SingleWidth;
+}
+
+SHORT TextBuffer::GetLineWidth(const size_t row) const
+{
+    // Use shift right to quickly divide the width by 2 for double width lines.
+    const SHORT scale = IsDoubleWidthLine(row) ? 1 : 0;
+    return GetSize().Width() >> scale;
+}
+
+COORD TextBuffer::ClampPositionWithinLine(const COORD position) const
+{
+    const SHORT rightmostColumn = GetLineWidth(position.Y) - 1;
+    return { std::min(position.X, rightmostColumn), position.Y };
+}
+
+COORD TextBuffer::ScreenToBufferPosition(const COORD position) const
+{
+    // Use shift right to quickly divide the X pos by 2 for double width lines.
+    const SHORT scale = IsDoubleWidthLine(position.Y) ? 1 : 0;
+    return { position.X >> scale, position.Y };
+}
+
+COORD TextBuffer::BufferToScreenPosition(const COORD position) const
+{
+    // Use shift left to quickly multiply the X pos by 2 for double width lines.
+    const SHORT scale = IsDoubleWidthLine(position.Y) ? 1 : 0;
+    return { position.X << scale, position.Y };
+}
+
+// Routine Description:
+// - Resets the text contents of this buffer with the default character
+//   and the default current color attributes
+void TextBuffer::Reset()
+{
+    const auto attr = GetCurrentAttributes();
+
+    for (auto& row : _storage)
+    {
+        row.ResetLazily(attr);
+    }
+
+    _promptMarks.clear();
+    _images.clear();
+}
+
+// Routine Description:
+// - Prepares a buffer that's no longer in use to be used again, by another
+//   screen buffer, as if it had just been constructed with the same size.
+// - The rows are only cleared lazily, so this is much cheaper than allocating
+//   a new buffer.
+// Arguments:
+// - defaultAttributes - the attributes to fill the buffer with
+// - cursorSize - the size of the cursor, in percent of the cell height
+// - renderTarget - where the buffer sends its redraw requests from now on
+// Return Value:
+// - <none>
+void TextBuffer::Recycle(const TextAttribute defaultAttributes,
+                         const UINT cursorSize,
+                         Microsoft::Console::Render::IRenderTarget& renderTarget)
+{
+    _FlushDeferredPaint();
+    _renderTarget = &renderTarget;
+    _currentAttributes = defaultAttributes;
+    _SetFirstRowIndex(0);
+    Reset();
+    _cursor.Reset(cursorSize);
+
+    // The generations of the rows keep counting up, but a snapshot of this buffer
+    // taken for its previous owner must not be mistaken for one of ours.
+    _snapshotEpoch = ++s_nextSnapshotEpoch;
+}
+
+// Routine Description:
+// - Erases the given rows, as if they were filled with spaces of the given attributes.
+// - The cells are only cleared once a row is accessed again, so erasing
+//   doesn't depend on the width of the buffer, and a row that is erased
+//   repeatedly without being looked at in between is only cleared once.
+// - The line rendition of the rows is kept, as only their contents are erased.
+// Arguments:
+// - startRow - the offset of the first row to erase
+// - endRow - the offset past the last row to erase
+// - fillAttributes - the attributes to fill the rows with
+// Return Value:
+// - true if all of the rows were erased.
+bool TextBuffer::EraseRows(const size_t startRow, const size_t endRow, const TextAttribute fillAttributes)
+{
+    const auto totalRows = _storage.size();
+    const auto end = std::min(endRow, totalRows);
+    bool success = true;
+
+    // The rows are looked up directly, since going through _GetRow would clear them right away.
+    for (auto row = startRow; row < end; ++row)
+    {
+        auto& target = til::at(_storage, (_firstRow + row) % totalRows);
+        const auto lineRendition = target.GetLineRendition();
+        success = target.ResetLazily(fillAttributes) && success;
+        target.SetLineRendition(lineRendition);
+    }
+
+    if (startRow < end)
+    {
+        _images.Erase(_circledRows + startRow, _circledRows + end);
+        const auto paint = Viewport::FromExclusive({ 0, gsl::narrow<SHORT>(startRow), GetSize().Width(), gsl::narrow<SHORT>(end) });
+        _NotifyPaint(paint);
+    }
+
+    return success;
+}
+
+// Routine Description:
+// - This is the legacy screen resize with minimal changes
+// Arguments:
+// - newSize - new size of screen.
+// Return Value:
+// - Success if successful. Invalid parameter if screen buffer size is unexpected. No memory if allocation failed.
+[[nodiscard]] NTSTATUS TextBuffer::ResizeTraditional(const COORD newSize) noexcept
+{
+    RETURN_HR_IF(E_INVALIDARG, newSize.X < 0 || newSize.Y < 0);
+
+    try
+    {
+        _FlushDeferredPaint();
+
+        const auto attributes = GetCurrentAttributes();
+
+        SHORT TopRow = 0; // new top row of the screen buffer
+        if (newSize.Y <= GetCursor().GetPosition().Y)
+        {
+            TopRow = GetCursor().GetPosition().Y - newSize.Y + 1;
+        }
+        const auto TopRowIndex = (GetFirstRowIndex() + TopRow) % _storage.size();
+
+        // rotate rows until the top row is at index 0
+        for (size_t i = 0; i < TopRowIndex; i++)
+        {
+            _storage.emplace_back(std::move(_storage.front()));
+            _storage.erase(_storage.begin());
+        }
+
+        _SetFirstRowIndex(0);
+
+        // realloc in the Y direction
+        // remove rows if we're shrinking
+        while (_storage.size() > static_cast<size_t>(newSize.Y))
+        {
+            _storage.pop_back();
+        }
+
+        // All rows move into a freshly allocated arena of the new dimensions.
+        // Existing rows copy their cells over (realloc in the X direction)
+        // and rows we add while growing start out as default cells.
+        // The arena is freed again if we throw, so everything that can fail happens
+        // before the existing rows are pointed at it.
+        const auto newWidth = static_cast<size_t>(newSize.X);
+        const auto newHeight = static_cast<size_t>(newSize.Y);
+        CellArena newCharBuffer{ newWidth, newHeight };
+
+        struct ResizedRow
+        {
+            gsl::span<CharRowCell> cells;
+            ATTR_ROW attrRow;
+        };
+        std::vector<ResizedRow> resizedRows;
+        resizedRows.reserve(_storage.size());
+        for (size_t i = 0; i < _storage.size(); ++i)
+        {
+            // Packed and lazily cleared rows are expanded first, as they're copied cell by cell.
+            const auto& row = _GetRow(i);
+            resizedRows.push_back({ newCharBuffer.GetRow(i), row.GetResizedAttrRow(newWidth) });
+        }
+
+        // add rows if we're growing, and drop them again if that fails, as they live in the new arena
+        const auto oldHeight = _storage.size();
+        try
+        {
+            while (_storage.size() < newHeight)
+            {
+                const auto i = _storage.size();
+                _storage.emplace_back(i, newCharBuffer.GetRow(i), attributes, _attributes, _clock, this);
+            }
+        }
+        catch (...)
+        {
+            _storage.erase(_storage.begin() + oldHeight, _storage.end());
+            throw;
+        }
+
+        // Nothing below can fail until the rows are all in the new arena.
+        for (size_t i = 0; i < resizedRows.size(); ++i)
+        {
+            auto& resized = til::at(resizedRows, i);
+            til::at(_storage, i).Resize(resized.cells, std::move(resized.attrRow));
+        }
+
+        _charBuffer = std::move(newCharBuffer);
+
+        // Now that we've tampered with the row placement, refresh all the row IDs.
+        _RefreshRowIDs();
+
+        // Update the cached size value
+        _UpdateSize();
+
+        // The rows above the new top row are gone, like rows that circle out of the buffer.
+        _circledRows += TopRow;
+        _promptMarks.DropBefore(_circledRows);
+        _promptMarks.Erase(_circledRows + newSize.Y, std::numeric_limits<uint64_t>::max());
+        _images.DropBefore(_circledRows);
+        _images.Erase(_circledRows + newSize.Y, std::numeric_limits<uint64_t>::max());
+    }
+    CATCH_RETURN();
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Method to help refresh all the Row IDs after manipulating the row
+//   by shuffling pointers around.
+// Arguments:
+// - <none>
+void TextBuffer::_RefreshRowIDs() noexcept
+{
+    size_t i = 0;
+    for (auto& it : _storage)
+    {
+        it.SetId(i++);
+    }
+
+    // The pattern cache is keyed by row ID, which we just reassigned,
+    // and the search index by the position of rows in the storage.
+    _patternCache.clear();
+    _searchIndex.Clear();
+}
+
+// Routine Description:
+// - Tells the render target that the given region of the buffer needs to be
+//   redrawn. While the drawing is deferred (see StartDeferDrawing), the region
+//   is only merged into the ones collected so far.
+// Arguments:
+// - viewport - the region to redraw
+void TextBuffer::_NotifyPaint(const Viewport& viewport) const
+{
+    if (_deferDrawing == 0)
+    {
+        _renderTarget->TriggerRedraw(viewport);
+        return;
+    }
+
+    const auto size = GetSize();
+    auto rect = viewport.ToExclusive();
+    rect.Left = std::max<SHORT>(rect.Left, 0);
+    rect.Top = std::max<SHORT>(rect.Top, 0);
+    rect.Right = std::min(rect.Right, size.Width());
+    rect.Bottom = std::min(rect.Bottom, size.Height());
+    if (rect.Left >= rect.Right || rect.Top >= rect.Bottom)
+    {
+        return;
+    }
+
+    _deferredColumns.resize(_storage.size());
+    if (_deferredTop >= _deferredBottom)
+    {
+        _deferredTop = rect.Top;
+        _deferredBottom = rect.Bottom;
+    }
+    else
+    {
+        _deferredTop = std::min(_deferredTop, rect.Top);
+        _deferredBottom = std::max(_deferredBottom, rect.Bottom);
+    }
+
+    for (auto row = rect.Top; row < rect.Bottom; ++row)
+    {
+        auto& columns = til::at(_deferredColumns, row);
+        if (columns.first >= columns.second)
+        {
+            columns = { rect.Left, rect.Right };
+        }
+        else
+        {
+            columns.first = std::min(columns.first, rect.Left);
+            columns.second = std::max(columns.second, rect.Right);
+        }
+    }
+}
+
+// Routine Description:
+// - Sends the regions collected while the drawing was deferred to the render target.
+// - The consecutive rows with the same columns are sent as one region, which is
+//   most of them, as the output usually fills or clears whole rows.
+// - Must be called before the rows move around within the buffer, since the
+//   collected regions refer to where the text was when it changed.
+void TextBuffer::_FlushDeferredPaint() const
+{
+    auto row = std::exchange(_deferredTop, SHORT{ 0 });
+    const auto bottom = std::exchange(_deferredBottom, SHORT{ 0 });
+    while (row < bottom)
+    {
+        const auto columns = std::exchange(til::at(_deferredColumns, row), {});
+        auto end = gsl::narrow_cast<SHORT>(row + 1);
+        while (end < bottom && til::at(_deferredColumns, end) == columns)
+        {
+            til::at(_deferredColumns, end) = {};
+            ++end;
+        }
+
+        if (columns.first < columns.second)
+        {
+            _renderTarget->TriggerRedraw(Viewport::FromExclusive({ columns.first, row, columns.second, end }));
+        }
+        row = end;
+    }
+}
+
+// Routine Description:
+// - Retrieves the first row from the underlying buffer.
+// Arguments:
+// - <none>
+// Return Value:
+//  - reference to the first row.
+ROW& TextBuffer::_GetFirstRow()
+{
+    return GetRowByOffset(0);
+}
+
+// Routine Description:
+// - Retrieves the row that comes before the given row.
+// - Does not wrap around the screen buffer.
+// Arguments:
+// - The current row.
+// Return Value:
+// - reference to the previous row
+// Note:
+// - will throw exception if called with the first row of the text buffer
+ROW& TextBuffer::_GetPrevRowNoWrap(const ROW& Row)
+{
+    const auto prevRowIndex = (Row.GetId() == 0 ? _storage.size() : Row.GetId()) - 1;
+
+    THROW_HR_IF(E_FAIL, Row.GetId() == _firstRow);
+    return _GetRow(prevRowIndex);
+}
+
+// Method Description:
+// - Retrieves this buffer's current render target.
+// Arguments:
+// - <none>
+// Return Value:
+// - This buffer's current render target.
+Microsoft::Console::Render::IRenderTarget& TextBuffer::GetRenderTarget() noexcept
+{
+    return *_renderTarget;
+}
+
+// Routine Description:
+// - Defers sending the regions that were changed to the render target until
+//   the matching call to EndDeferDrawing, so that a burst of output results in
+//   a few merged regions instead of one for every change.
+// - Calls can be nested. Other notifications, like the ones for the cursor or
+//   for scrolling, aren't deferred.
+void TextBuffer::StartDeferDrawing() noexcept
+{
+    ++_deferDrawing;
+}
+
+// Routine Description:
+// - Ends deferring what StartDeferDrawing started, and sends the regions that
+//   were changed in the meantime to the render target once the outermost call ends.
+void TextBuffer::EndDeferDrawing() noexcept
+{
+    if (_deferDrawing > 0 && --_deferDrawing == 0)
+    {
+        try
+        {
+            _FlushDeferredPaint();
+        }
+        CATCH_LOG();
+    }
+}
+
+// Method Description:
+// - get delimiter class for buffer cell position
+// - used for double click selection and uia word navigation
+// Arguments:
+// - pos: the buffer cell under observation
+// - wordDelimiters: the delimiters defined as a part of the DelimiterClass::DelimiterChar
+// Return Value:
+// - the delimiter class for the given char
+const DelimiterClass TextBuffer::_GetDelimiterClassAt(const COORD pos, const std::wstring_view wordDelimiters) const
+{
+    const auto classes = _GetDelimiterClasses(pos.Y, wordDelimiters);
+    const auto word = gsl::narrow_cast<size_t>(pos.X) / 32;
+    const auto bit = 1u << (pos.X % 32);
+    THROW_HR_IF(E_INVALIDARG, pos.X < 0 || word >= classes->regular.size());
+    if (til::at(classes->regular, word) & bit)
+    {
+        return DelimiterClass::RegularChar;
+    }
+    return (til::at(classes->delimiter, word) & bit) ? DelimiterClass::DelimiterChar : DelimiterClass::ControlChar;
+}
+
+// Method Description:
+// - Gets the delimiter classes of a row, building them if the row changed since they were last built.
+// Arguments:
+// - row - the offset of the row
+// - wordDelimiters: the delimiters defined as a part of the DelimiterClass::DelimiterChar
+// Return Value:
+// - the delimiter classes of the row
+std::shared_ptr<const TextBuffer::DelimiterClasses> TextBuffer::_GetDelimiterClasses(const SHORT row, const std::wstring_view wordDelimiters) const
+{
+    const auto& charRow = GetRowByOffset(row).GetCharRow();
+    const auto width = charRow.size();
+    const auto words = (width + 31) / 32;
+
+    const std::lock_guard lock{ _delimiterClassesLock };
+    if (wordDelimiters != _delimiterClassesFor)
+    {
+        _delimiterClassesFor = wordDelimiters;
+        _delimiterClasses.clear();
+        _asciiDelimiters.reset();
+        for (const auto wch : wordDelimiters)
+        {
+            if (wch < _asciiDelimiters.size())
+            {
+                _asciiDelimiters.set(wch);
+            }
+        }
+    }
+    if (_delimiterClasses.size() != _storage.size())
+    {
+        _delimiterClasses.clear();
+        _delimiterClasses.resize(_storage.size());
+    }
+
+    auto& cached = til::at(_delimiterClasses, (_firstRow + row) % _storage.size());
+    if (cached && cached->generation == charRow.GetGeneration() && cached->regular.size() == words)
+    {
+        return cached;
+    }
+
+    auto classes = std::make_shared<DelimiterClasses>();
+    classes->regular.assign(words, 0);
+    classes->delimiter.assign(words, 0);
+    for (size_t column = 0; column < width; ++column)
+    {
+        const auto glyph = *charRow.GlyphAt(column).begin();
+        if (glyph <= UNICODE_SPACE)
+        {
+            continue;
+        }
+
+        const auto isDelimiter = glyph < _asciiDelimiters.size() ? _asciiDelimiters.test(glyph) : wordDelimiters.find(glyph) != std::wstring_view::npos;
+        auto& bitmap = isDelimiter ? classes->delimiter : classes->regular;
+        til::at(bitmap, column / 32) |= 1u << (column % 32);
+    }
+    classes->generation = charRow.GetGeneration();
+    cached = std::move(classes);
+    return cached;
+}
+
+// Method Description:
+// - Gets 32 columns of a row, with the bits set for the columns that are (or aren't) of the given class.
+// Arguments:
+// - word - the index of the 32 columns
+// - delimiterClass - the class to look for
+// - match - whether to look for columns of the class, or columns of any other class
+// Return Value:
+// - the bits of the columns. Bits past the end of the row are set for ControlChar.
+uint32_t TextBuffer::DelimiterClasses::Mask(const size_t word, const DelimiterClass delimiterClass, const bool match) const noexcept
+{
+    uint32_t bits;
+    switch (delimiterClass)
+    {
+    case DelimiterClass::RegularChar:
+        bits = til::at(regular, word);
+        break;
+    case DelimiterClass::DelimiterChar:
+        bits = til::at(delimiter, word);
+        break;
+    default:
+        bits = ~(til::at(regular, word) | til::at(delimiter, word));
+        break;
+    }
+    return match ? bits : ~bits;
+}
+
+// Method Description:
+// - Finds the first column in [first, last] that is (or isn't) of the given class.
+// Return Value:
+// - the column, or npos if there is none
+size_t TextBuffer::DelimiterClasses::FindForward(const size_t first, const size_t last, const DelimiterClass delimiterClass, const bool match) const noexcept
+{
+    for (auto word = first / 32; word <= last / 32; ++word)
+    {
+        auto bits = Mask(word, delimiterClass, match);
+        if (word == first / 32)
+        {
+            bits &= ~0u << (first % 32);
+        }
+        if (word == last / 32 && last % 32 != 31)
+        {
+            bits &= (1u << (last % 32 + 1)) - 1;
+        }
+        if (bits != 0)
+        {
+            unsigned long bit;
+            _BitScanForward(&bit, bits);
+            return word * 32 + bit;
+        }
+    }
+    return std::wstring_view::npos;
+}
+
+// Method Description:
+// - Finds the last column in [0, first] that is (or isn't) of the given class.
+// Return Value:
+// - the column, or npos if there is none
+size_t TextBuffer::DelimiterClasses::FindBackward(const size_t first, const DelimiterClass delimiterClass, const bool match) const noexcept
+{
+    for (auto word = first / 32 + 1; word-- > 0;)
+    {
+        auto bits = Mask(word, delimiterClass, match);
+        if (word == first / 32 && first % 32 != 31)
+        {
+            bits &= (1u << (first % 32 + 1)) - 1;
+        }
+        if (bits != 0)
+        {
+            unsigned long bit;
+            _BitScanReverse(&bit, bits);
+            return word * 32 + bit;
+        }
+    }
+    return std::wstring_view::npos;
+}
+
+// Method Description:
+// - Finds the first cell at or after pos (reading left to right, top to bottom)
+//   that is (or isn't) of the given delimiter class.
+// Arguments:
+// - pos - where to start. Set to the cell that was found, or EndExclusive if there is none.
+// - delimiterClass - the class to look for
+// - match - whether to look for a cell of the class, or a cell of any other class
+// - wordDelimiters: the delimiters defined as a part of the DelimiterClass::DelimiterChar
+// Return Value:
+// - true if a cell was found
+bool TextBuffer::_FindDelimiterClassForward(COORD& pos, const DelimiterClass delimiterClass, const bool match, const std::wstring_view wordDelimiters) const
+{
+    const auto bufferSize = GetSize();
+    auto column = gsl::narrow_cast<size_t>(pos.X);
+    for (auto row = pos.Y; row < bufferSize.BottomExclusive(); ++row, column = 0)
+    {
+        const auto classes = _GetDelimiterClasses(row, wordDelimiters);
+        const auto found = classes->FindForward(column, gsl::narrow_cast<size_t>(bufferSize.RightInclusive()), delimiterClass, match);
+        if (found != std::wstring_view::npos)
+        {
+            pos = { gsl::narrow_cast<SHORT>(found), row };
+            return true;
+        }
+    }
+    pos = bufferSize.EndExclusive();
+    return false;
+}
+
+// Method Description:
+// - Finds the last cell at or before pos (reading left to right, top to bottom)
+//   that is (or isn't) of the given delimiter class.
+// Arguments:
+// - pos - where to start. Set to the cell that was found, or the origin if there is none.
+// - delimiterClass - the class to look for
+// - match - whether to look for a cell of the class, or a cell of any other class
+// - wordDelimiters: the delimiters defined as a part of the DelimiterClass::DelimiterChar
+// Return Value:
+// - true if a cell was found
+bool TextBuffer::_FindDelimiterClassBackward(COORD& pos, const DelimiterClass delimiterClass, const bool match, const std::wstring_view wordDelimiters) const
+{
+    const auto bufferSize = GetSize();
+    auto column = gsl::narrow_cast<size_t>(pos.X);
+    for (auto row = pos.Y; row >= bufferSize.Top(); --row, column = gsl::narrow_cast<size_t>(bufferSize.RightInclusive()))
+    {
+        const auto classes = _GetDelimiterClasses(row, wordDelimiters);
+        const auto found = classes->FindBackward(column, delimiterClass, match);
+        if (found != std::wstring_view::npos)
+        {
+            pos = { gsl::narrow_cast<SHORT>(found), row };
+            return true;
+        }
+    }
+    pos = bufferSize.Origin();
+    return false;
+}
+
+// Method Description:
+// - Get the COORD for the beginning of the word you are on
+// Arguments:
+// - target - a COORD on the word you are currently on
+// - wordDelimiters - what characters are we considering for the separation of words
+// - accessibilityMode - when enabled, we continue expanding left until we are at the beginning of a readable word.
+//                        Otherwise, expand left until a character of a new delimiter class is found
+//                        (or a row boundary is encountered)
+// Return Value:
+// - The COORD for the first character on the "word" (inclusive)
+const COORD TextBuffer::GetWordStart(const COORD target, const std::wstring_view wordDelimiters, bool accessibilityMode) const
+{
+    // Consider a buffer with this text in it:
+    // "  word   other  "
+    // In selection (accessibilityMode = false),
+    //  a "word" is defined as the range between two delimiters
+    //  so the words in the example include ["  ", "word", "   ", "other", "  "]
+    // In accessibility (accessibilityMode = true),
+    //  a "word" includes the delimiters after a range of readable characters
+    //  so the words in the example include ["word   ", "other  "]
+    // NOTE: the start anchor (this one) is inclusive, whereas the end anchor (GetWordEnd) is exclusive
+
+#pragma warning(suppress : 26496)
+    // GH#7664: Treat EndExclusive as EndInclusive so
+    // that it actually points to a space in the buffer
+    auto copy{ target };
+    const auto bufferSize{ GetSize() };
+    if (target == bufferSize.Origin())
+    {
+        // can't expand left
+        return target;
+    }
+    else if (target == bufferSize.EndExclusive())
+    {
+        // treat EndExclusive as EndInclusive
+        copy = { bufferSize.RightInclusive(), bufferSize.BottomInclusive() };
+    }
+
+    if (accessibilityMode)
+    {
+        return _GetWordStartForAccessibility(copy, wordDelimiters);
+    }
+    else
+    {
+        return _GetWordStartForSelection(copy, wordDelimiters);
+    }
+}
+
+// Method Description:
+// - Helper method for GetWordStart(). Get the COORD for the beginning of the word (accessibility definition) you are on
+// Arguments:
+// - target - a COORD on the word you are currently on
+// - wordDelimiters - what characters are we considering for the separation of words
+// Return Value:
+// - The COORD for the first character on the current/previous READABLE "word" (inclusive)
+const COORD TextBuffer::_GetWordStartForAccessibility(const COORD target, const std::wstring_view wordDelimiters) const
+{
+    COORD result = target;
+    const auto bufferSize = GetSize();
+
+    // ignore left boundary. Continue until readable text found
+    if (!_FindDelimiterClassBackward(result, DelimiterClass::RegularChar, true, wordDelimiters))
+    {
+        // there's no readable text before the target
+        // we can't move any further back
+        return result;
+    }
+
+    // make sure we expand to the left boundary or the beginning of the word
+    if (_FindDelimiterClassBackward(result, DelimiterClass::RegularChar, false, wordDelimiters))
+    {
+        // move off of delimiter and onto word start
+        bufferSize.IncrementInBounds(result);
+    }
+
+    return result;
+}
+
+// Method Description:
+// - Helper method for GetWordStart(). Get the COORD for the beginning of the word (selection definition) you are on
+// Arguments:
+// - target - a COORD on the word you are currently on
+// - wordDelimiters - what characters are we considering for the separation of words
+// Return Value:
+// - The COORD for the first character on the current word or delimiter run (stopped by the left margin)
+const COORD TextBuffer::_GetWordStartForSelection(const COORD target, const std::wstring_view wordDelimiters) const
+{
+    COORD result = target;
+    const auto bufferSize = GetSize();
+
+    const auto initialDelimiter = _GetDelimiterClassAt(result, wordDelimiters);
+
+    // expand left until we hit the left boundary or a different delimiter class
+    const auto classes = _GetDelimiterClasses(result.Y, wordDelimiters);
+    const auto found = classes->FindBackward(gsl::narrow_cast<size_t>(result.X), initialDelimiter, false);
+    // move off of delimiter
+    result.X = found == std::wstring_view::npos ? bufferSize.Left() : gsl::narrow_cast<SHORT>(found + 1);
+
+    return result;
+}
+
+// Method Description:
+// - Get the COORD for the beginning of the NEXT word
+// Arguments:
+// - target - a COORD on the word you are currently on
+// - wordDelimiters - what characters are we considering for the separation of words
+// - accessibilityMode - when enabled, we continue expanding right until we are at the beginning of the next READABLE word
+//                        Otherwise, expand right until a character of a new delimiter class is found
+//                        (or a row boundary is encountered)
+// Return Value:
+// - The COORD for the last character on the "word" (inclusive)
+const COORD TextBuffer::GetWordEnd(const COORD target, const std::wstring_view wordDelimiters, bool accessibilityMode) const
+{
+    // Consider a buffer with this text in it:
+    // "  word   other  "
+    // In selection (accessibilityMode = false),
+    //  a "word" is defined as the range between two delimiters
+    //  so the words in the example include ["  ", "word", "   ", "other", "  "]
+    // In accessibility (accessibilityMode = true),
+    //  a "word" includes the delimiters after a range of readable characters
+    //  so the words in the example include ["word   ", "other  "]
+    // NOTE: the end anchor (this one) is exclusive, whereas the start anchor (GetWordStart) is inclusive
+
+    // Already at the end. Can't move forward.
+    if (target == GetSize().EndExclusive())
+    {
+        return target;
+    }
+
+    if (accessibilityMode)
+    {
+        const auto lastCharPos{ GetLastNonSpaceCharacter() };
+        return _GetWordEndForAccessibility(target, wordDelimiters, lastCharPos);
+    }
+    else
+    {
+        return _GetWordEndForSelection(target, wordDelimiters);
+    }
+}
+
+// Method Description:
+// - Helper method for GetWordEnd(). Get the COORD for the beginning of the next READABLE word
+// Arguments:
+// - target - a COORD on the word you are currently on
+// - wordDelimiters - what characters are we considering for the separation of words
+// - lastCharPos - the position of the last nonspace character in the text buffer (to improve performance)
+// Return Value:
+// - The COORD for the first character of the next readable "word". If no next word, return one past the end of the buffer
+const COORD TextBuffer::_GetWordEndForAccessibility(const COORD target, const std::wstring_view wordDelimiters, const COORD lastCharPos) const
+{
+    const auto bufferSize = GetSize();
+    COORD result = target;
+
+    // Check if we're already on/past the last RegularChar
+    if (bufferSize.CompareInBounds(result, lastCharPos, true) >= 0)
+    {
+        return bufferSize.EndExclusive();
+    }
+
+    // ignore right boundary. Continue through readable text found
+    _FindDelimiterClassForward(result, DelimiterClass::RegularChar, false, wordDelimiters);
+
+    // we are already on/past the last RegularChar
+    if (bufferSize.CompareInBounds(result, lastCharPos, true) >= 0)
+    {
+        return bufferSize.EndExclusive();
+    }
+
+    // make sure we expand to the beginning of the NEXT word
+    // if there's none, we end up at the EndExclusive COORD
+    // this signifies that we must include the last char in the buffer
+    // but the position of the COORD points to nothing
+    _FindDelimiterClassForward(result, DelimiterClass::RegularChar, true, wordDelimiters);
+
+    return result;
+}
+
+// Method Description:
+// - Helper method for GetWordEnd(). Get the COORD for the beginning of the NEXT word
+// Arguments:
+// - target - a COORD on the word you are currently on
+// - wordDelimiters - what characters are we considering for the separation of words
+// Return Value:
+// - The COORD for the last character of the current word or delimiter run (stopped by right margin)
+const COORD TextBuffer::_GetWordEndForSelection(const COORD target, const std::wstring_view wordDelimiters) const
+{
+    const auto bufferSize = GetSize();
+
+    // can't expand right
+    if (target.X == bufferSize.RightInclusive())
+    {
+        return target;
+    }
+
+    COORD result = target;
+    const auto initialDelimiter = _GetDelimiterClassAt(result, wordDelimiters);
+
+    // expand right until we hit the right boundary or a different delimiter class
+    const auto classes = _GetDelimiterClasses(result.Y, wordDelimiters);
+    const auto found = classes->FindForward(gsl::narrow_cast<size_t>(result.X), gsl::narrow_cast<size_t>(bufferSize.RightInclusive()), initialDelimiter, false);
+    // move off of delimiter
+    result.X = found == std::wstring_view::npos ? bufferSize.RightInclusive() : gsl::narrow_cast<SHORT>(found - 1);
+
+    return result;
+}
+
+// Routine Description:
+// - Drops the references of the row about to be recycled by IncrementCircularBuffer
+//   and removes the hyperlinks which no row refers to anymore.
+// - The references are counted per row, so this doesn't need to search the
+//   rest of the buffer for other references to the hyperlinks of the row.
+void TextBuffer::_PruneHyperlinks()
+{
+    if (_hyperlinks.empty())
+    {
+        return;
+    }
+
+    _CountHyperlinkReferences();
+
+    // The recycled row is counted again once it's been written to.
+    auto& recycled = til::at(_rowHyperlinks, _firstRow);
+    for (const auto id : recycled.ids)
+    {
+        _ReleaseHyperlinkReference(id);
+    }
+    recycled = RowHyperlinks{};
+}
+
+// Routine Description:
+// - Brings the number of rows referring to each hyperlink up to date.
+// - Only the rows whose attributes changed since they were last counted are
+//   looked at, which the generation of their attributes tells.
+//   Rows moved around by ScrollRows have a different generation than the row
+//   previously at their index, since every modification gets its own generation.
+void TextBuffer::_CountHyperlinkReferences()
+{
+    if (_rowHyperlinks.size() != _storage.size())
+    {
+        // The buffer was resized. Count every row again.
+        _hyperlinks.ClearReferences();
+        _rowHyperlinks.clear();
+        _rowHyperlinks.resize(_storage.size());
+    }
+    else if (_hyperlinksCountedAt == _clock.Now())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < _storage.size(); ++i)
+    {
+        // Looking at the attributes doesn't require a packed or lazily cleared row to be expanded.
+        const auto& attrRow = til::at(_storage, i).GetAttrRow();
+        auto& counted = til::at(_rowHyperlinks, i);
+        if (counted.generation == attrRow.GetGeneration())
+        {
+            continue;
+        }
+
+        auto ids = attrRow.GetHyperlinks();
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        // Adding the new references first keeps hyperlinks that the row still refers to.
+        for (const auto id : ids)
+        {
+            _hyperlinks.AddReference(id);
+        }
+        for (const auto id : counted.ids)
+        {
+            _ReleaseHyperlinkReference(id);
+        }
+        counted.generation = attrRow.GetGeneration();
+        counted.ids = std::move(ids);
+    }
+    _hyperlinksCountedAt = _clock.Now();
+}
+
+// Routine Description:
+// - Drops a reference to a hyperlink and removes it if that was the last one.
+//   The hyperlink of the current attributes is kept, as text might still be written with it.
+// Arguments:
+// - id - the ID of the hyperlink
+void TextBuffer::_ReleaseHyperlinkReference(const uint16_t id) noexcept
+{
+    if (_hyperlinks.RemoveReference(id) == 0 && id != _currentAttributes.GetHyperlinkId())
+    {
+        _hyperlinks.Remove(id);
+    }
+}
+
+// Method Description:
+// - Update pos to be the position of the first character of the next word. This is used for accessibility
+// Arguments:
+// - pos - a COORD on the word you are currently on
+// - wordDelimiters - what characters are we considering for the separation of words
+// - lastCharPos - the position of the last nonspace character in the text buffer (to improve performance)
+// Return Value:
+// - true, if successfully updated pos. False, if we are unable to move (usually due to a buffer boundary)
+// - pos - The COORD for the first character on the "word" (inclusive)
+bool TextBuffer::MoveToNextWord(COORD& pos, const std::wstring_view wordDelimiters, COORD lastCharPos) const
+{
+    // move to the beginning of the next word
+    // NOTE: _GetWordEnd...() returns the exclusive position of the "end of the word"
+    //       This is also the inclusive start of the next word.
+    auto copy{ _GetWordEndForAccessibility(pos, wordDelimiters, lastCharPos) };
+
+    if (copy == GetSize().EndExclusive())
+    {
+        return false;
+    }
+
+    pos = copy;
+    return true;
+}
+
+// Method Description:
+// - Update pos to be the position of the first character of the previous word. This is used for accessibility
+// Arguments:
+// - pos - a COORD on the word you are currently on
+// - wordDelimiters - what characters are we considering for the separation of words
+// Return Value:
+// - true, if successfully updated pos. False, if we are unable to move (usually due to a buffer boundary)
+// - pos - The COORD for the first character on the "word" (inclusive)
+bool TextBuffer::MoveToPreviousWord(COORD& pos, std::wstring_view wordDelimiters) const
+{
+    // move to the beginning of the current word
+    auto copy{ GetWordStart(pos, wordDelimiters, true) };
+
+    if (!GetSize().DecrementInBounds(copy, true))
+    {
+        // can't move behind current word
+        return false;
+    }
+
+    // move to the beginning of the previous word
+    pos = GetWordStart(copy, wordDelimiters, true);
+    return true;
+}
+
+// Method Description:
+// - Update pos to be the beginning of the current glyph/character. This is used for accessibility
+// Arguments:
+// - pos - a COORD on the word you are currently on
+// Return Value:
+// - pos - The COORD for the first cell of the current glyph (inclusive)
+const til::point TextBuffer::GetGlyphStart(const til::point pos) const
+{
+    COORD resultPos = pos;
+    const auto bufferSize = GetSize();
+
+    if (resultPos == bufferSize.EndExclusive())
+    {
+        bufferSize.DecrementInBounds(resultPos, true);
+    }
+
+    if (resultPos != bufferSize.EndExclusive() && GetCellDataAt(resultPos)->DbcsAttr().IsTrailing())
+    {
+        bufferSize.DecrementInBounds(resultPos, true);
+    }
+
+    return resultPos;
+}
+
+// Method Description:
+// - Update pos to be the end of the current glyph/character. This is used for accessibility
+// Arguments:
+// - pos - a COORD on the word you are currently on
+// Return Value:
+// - pos - The COORD for the last cell of the current glyph (exclusive)
+const til::point TextBuffer::GetGlyphEnd(const til::point pos) const
+{
+    COORD resultPos = pos;
+
+    const auto bufferSize = GetSize();
+    if (resultPos != bufferSize.EndExclusive() && GetCellDataAt(resultPos)->DbcsAttr().IsLeading())
+    {
+        bufferSize.IncrementInBounds(resultPos, true);
+    }
+
+    // increment one more time to become exclusive
+    bufferSize.IncrementInBounds(resultPos, true);
+    return resultPos;
+}
+
+// Method Description:
+// - Update pos to be the beginning of the next glyph/character. This is used for accessibility
+// Arguments:
+// - pos - a COORD on the word you are currently on
+// - allowBottomExclusive - allow the nonexistent end-of-buffer cell to be encountered
+// Return Value:
+// - true, if successfully updated pos. False, if we are unable to move (usually due to a buffer boundary)
 // - pos - The COORD for the first cell of the current glyph (inclusive)
 bool TextBuffer::MoveToNextGlyph(til::point& pos, bool allowBottomExclusive) const
 {
@@ -1688,37 +3013,345 @@ const TextBuffer::TextAndColor TextBuffer::GetText(const bool includeCRLF,
             }
         }
 
-        // apply CR/LF to the end of the final string, unless we're the last line.
-        // a.k.a if we're earlier than the bottom, then apply CR/LF.
-        if (includeCRLF && i < selectionRects.size() - 1)
-        {
-            if (shouldFormatRow)
-            {
-                // then we can assume a CR/LF is proper
-                selectionText.push_back(UNICODE_CARRIAGERETURN);
-                selectionText.push_back(UNICODE_LINEFEED);
+        // apply CR/LF to the end of the final string, unless we're the last line.
+        // a.k.a if we're earlier than the bottom, then apply CR/LF.
+        if (includeCRLF && i < selectionRects.size() - 1)
+        {
+            if (shouldFormatRow)
+            {
+                // then we can assume a CR/LF is proper
+                selectionText.push_back(UNICODE_CARRIAGERETURN);
+                selectionText.push_back(UNICODE_LINEFEED);
+
+                if (copyTextColor)
+                {
+                    // cant see CR/LF so just use black FG & BK
+                    COLORREF const Blackness = RGB(0x00, 0x00, 0x00);
+                    selectionFgAttr.push_back(Blackness);
+                    selectionFgAttr.push_back(Blackness);
+                    selectionBkAttr.push_back(Blackness);
+                    selectionBkAttr.push_back(Blackness);
+                }
+            }
+        }
+
+        data.text.emplace_back(std::move(selectionText));
+        if (copyTextColor)
+        {
+            data.FgAttr.emplace_back(std::move(selectionFgAttr));
+            data.BkAttr.emplace_back(std::move(selectionBkAttr));
+        }
+    }
+
+    return data;
+}
+
+// Routine Description:
+// - Retrieves the text of the given columns of a row, the way GetText would
+//   without trimming or line breaks. The text of every row is cached until the
+//   row changes, so that accessibility clients can ask for the text of large
+//   ranges over and over without it being gathered from the cells every time.
+// Arguments:
+// - row - the offset of the row
+// - left - the first column (inclusive)
+// - right - the last column (inclusive)
+// Return Value:
+// - The text. It's valid until the buffer is changed.
+std::wstring_view TextBuffer::GetRowText(const SHORT row, const SHORT left, const SHORT right) const
+{
+    const auto& rowText = _GetRowText(row);
+    const auto width = gsl::narrow_cast<size_t>(GetSize().Width());
+    const auto first = std::min(gsl::narrow_cast<size_t>(std::max<SHORT>(left, 0)), width);
+    const auto last = std::clamp(gsl::narrow_cast<size_t>(std::max<SHORT>(right, -1) + 1), first, width);
+
+    const std::wstring_view text{ rowText.text };
+    if (rowText.offsets.empty())
+    {
+        return text.substr(first, last - first);
+    }
+    const auto begin = til::at(rowText.offsets, first);
+    return text.substr(begin, til::at(rowText.offsets, last) - begin);
+}
+
+// Method Description:
+// - Gets the text of a row, gathering it if the row changed since it was last gathered.
+// Arguments:
+// - row - the offset of the row
+// Return Value:
+// - the text of the row. It's valid until the buffer is changed.
+const TextBuffer::RowText& TextBuffer::_GetRowText(const SHORT row) const
+{
+    const std::lock_guard lock{ _rowTextsLock };
+    if (_rowTexts.size() != _storage.size())
+    {
+        _rowTexts.clear();
+        _rowTexts.resize(_storage.size());
+    }
+
+    const auto& charRow = GetRowByOffset(row).GetCharRow();
+    auto& rowText = til::at(_rowTexts, (_firstRow + row) % _storage.size());
+    const auto width = charRow.size();
+    if (rowText.generation == charRow.GetGeneration())
+    {
+        return rowText;
+    }
+
+    rowText.text.clear();
+    rowText.offsets.clear();
+    rowText.text.reserve(width);
+    for (size_t column = 0; column < width; ++column)
+    {
+        const auto isTrailing = charRow.DbcsAttrAt(column).IsTrailing();
+        const std::wstring_view glyph{ charRow.GlyphAt(column) };
+        if (rowText.offsets.empty() && (isTrailing || glyph.size() != 1))
+        {
+            // Only now that the offsets differ from the columns do they need to be stored.
+            rowText.offsets.reserve(width + 1);
+            for (size_t previous = 0; previous < column; ++previous)
+            {
+                rowText.offsets.push_back(gsl::narrow_cast<uint32_t>(previous));
+            }
+        }
+        if (!rowText.offsets.empty())
+        {
+            rowText.offsets.push_back(gsl::narrow<uint32_t>(rowText.text.size()));
+        }
+        if (!isTrailing)
+        {
+            rowText.text.append(glyph);
+        }
+    }
+    if (!rowText.offsets.empty())
+    {
+        rowText.offsets.push_back(gsl::narrow<uint32_t>(rowText.text.size()));
+    }
+    rowText.generation = charRow.GetGeneration();
+    return rowText;
+}
+
+// Routine Description:
+// - Retrieves the selected region as plain text and, if requested, its colors.
+// - Unlike GetText followed by GenHTML and GenRTF, the selection is walked only once.
+//   Only a single row is held at a time and colors are only computed for rich text
+//   formats, once per run of attributes. HTML and RTF are generated from the
+//   RichText afterwards, only if and when they're needed (see RichText::GenHTML).
+// Arguments:
+// - includeCRLF - inject CRLF pairs to the end of each line
+// - trimTrailingWhitespace - remove the trailing whitespace at the end of each line
+// - selectionRects - the rectangular regions from which the data will be extracted from the buffer
+// - richText - whether to keep the colors for rich text formats, and how. Ignored without GetAttributeColors.
+// - formatWrappedRows - if set we will apply formatting (CRLF inclusion and whitespace trimming) on wrapped rows
+// Return Value:
+// - The text of the selected region, and its colors if requested.
+TextBuffer::ExportedText TextBuffer::ExportText(const bool includeCRLF,
+                                                const bool trimTrailingWhitespace,
+                                                const std::vector<SMALL_RECT>& selectionRects,
+                                                const RichTextFormats& richText,
+                                                const bool formatWrappedRows) const
+{
+    ExportedText data;
+
+    const auto copyTextColor = richText.GetAttributeColors != nullptr && (richText.html || richText.rtf);
+    auto& rich = data.richText;
+    if (copyTextColor)
+    {
+        rich.fontHeightPoints = richText.fontHeightPoints;
+        rich.fontFaceName = richText.fontFaceName;
+        rich.backgroundColor = richText.backgroundColor;
+        rich.rowStarts.reserve(selectionRects.size());
+    }
+
+    // the text of the current row, and where each run of its attributes ends
+    std::wstring rowText;
+    std::vector<std::pair<size_t, TextAttribute>> rowAttrs;
+
+    for (size_t i = 0; i < selectionRects.size(); i++)
+    {
+        const auto iRow = selectionRects.at(i).Top;
+        const auto highlight = Viewport::FromInclusive(selectionRects.at(i));
+
+        rowText.clear();
+        rowAttrs.clear();
+
+        // copy char data into the row, skipping trailing bytes
+        for (auto it = GetCellDataAt(highlight.Origin(), highlight); it; ++it)
+        {
+            const auto& cell = *it;
+            if (cell.DbcsAttr().IsTrailing())
+            {
+                continue;
+            }
+
+            rowText.append(cell.Chars());
+            if (copyTextColor)
+            {
+                if (rowAttrs.empty() || rowAttrs.back().second != cell.TextAttr())
+                {
+                    rowAttrs.emplace_back(rowText.size(), cell.TextAttr());
+                }
+                rowAttrs.back().first = rowText.size();
+            }
+        }
+
+        // We apply formatting to rows if the row was NOT wrapped or formatting of wrapped rows is allowed
+        const auto shouldFormatRow = formatWrappedRows || !GetRowByOffset(iRow).WasWrapForced();
+
+        // remove the spaces at the end (aka trim the trailing whitespace)
+        auto length = rowText.size();
+        if (trimTrailingWhitespace && shouldFormatRow)
+        {
+            while (length > 0 && rowText.at(length - 1) == UNICODE_SPACE)
+            {
+                --length;
+            }
+        }
+
+        data.text.append(rowText, 0, length);
+
+        // apply CR/LF to the end of the row, unless we're the last line.
+        if (includeCRLF && i < selectionRects.size() - 1 && shouldFormatRow)
+        {
+            data.text.push_back(UNICODE_CARRIAGERETURN);
+            data.text.push_back(UNICODE_LINEFEED);
+        }
+
+        if (copyTextColor)
+        {
+            rich.rowStarts.push_back(rich.runs.size());
+
+            // \r and \n aren't written as text, so the row ends at the first one of them.
+            length = std::min(length, rowText.find_first_of(L"\r\n"));
+
+            size_t start = 0;
+            for (const auto& [end, attr] : rowAttrs)
+            {
+                if (start >= length)
+                {
+                    break;
+                }
+
+                rich.text.append(rowText, start, std::min(end, length) - start);
+                const auto [fg, bk] = richText.GetAttributeColors(attr);
+                rich.runs.push_back({ rich.text.size(), fg, bk });
+                start = end;
+            }
+        }
+    }
+
+    return data;
+}
+
+// Routine Description:
+// - Writes the rows of a RichText to a rich text writer.
+// Arguments:
+// - rich - the text and colors to write
+// - writer - the HtmlWriter or RtfWriter to write to
+// Return Value:
+// - <none>
+template<typename Writer>
+static void s_WriteRichText(const TextBuffer::RichText& rich, Writer& writer)
+{
+    const std::wstring_view text{ rich.text };
+    size_t start = 0;
+    for (size_t row = 0; row < rich.rowStarts.size(); row++)
+    {
+        if (row != 0)
+        {
+            writer.NewLine();
+        }
+
+        const auto runsEnd = row + 1 < rich.rowStarts.size() ? rich.rowStarts.at(row + 1) : rich.runs.size();
+        for (auto run = rich.rowStarts.at(row); run < runsEnd; run++)
+        {
+            const auto& [end, fg, bk] = rich.runs.at(run);
+            writer.Write(text.substr(start, end - start), fg, bk);
+            start = end;
+        }
+    }
+}
+
+// Routine Description:
+// - Generates a CF_HTML compliant structure from the text and colors.
+// Arguments:
+// - <none>
+// Return Value:
+// - string containing the generated HTML
+std::string TextBuffer::RichText::GenHTML() const
+{
+    try
+    {
+        std::string html;
+        HtmlWriter writer{ html, fontHeightPoints, fontFaceName, backgroundColor };
+        s_WriteRichText(*this, writer);
+        writer.Finish();
+        return html;
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return {};
+    }
+}
+
+// Routine Description:
+// - Generates an RTF document from the text and colors.
+// Arguments:
+// - <none>
+// Return Value:
+// - string containing the generated RTF
+std::string TextBuffer::RichText::GenRTF() const
+{
+    try
+    {
+        std::string rtf;
+        RtfWriter writer{ rtf, fontHeightPoints, fontFaceName, backgroundColor };
+        s_WriteRichText(*this, writer);
+        writer.Finish();
+        return rtf;
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return {};
+    }
+}
+
+// Routine Description:
+// - Writes the text and color data of TextAndColor rows to a rich text writer.
+// Arguments:
+// - rows - the text and color data to write
+// - writer - the HtmlWriter or RtfWriter to write to
+// Return Value:
+// - <none>
+template<typename Writer>
+static void s_WriteRichText(const TextBuffer::TextAndColor& rows, Writer& writer)
+{
+    for (size_t row = 0; row < rows.text.size(); row++)
+    {
+        if (row != 0)
+        {
+            writer.NewLine();
+        }
+
+        const std::wstring_view text{ rows.text.at(row) };
+        const auto& fgAttr = rows.FgAttr.at(row);
+        const auto& bkAttr = rows.BkAttr.at(row);
 
-                if (copyTextColor)
-                {
-                    // cant see CR/LF so just use black FG & BK
-                    COLORREF const Blackness = RGB(0x00, 0x00, 0x00);
-                    selectionFgAttr.push_back(Blackness);
-                    selectionFgAttr.push_back(Blackness);
-                    selectionBkAttr.push_back(Blackness);
-                    selectionBkAttr.push_back(Blackness);
-                }
-            }
-        }
+        // do not include \r nor \n as they don't have color attributes.
+        // The writer starts a new line for us instead.
+        const auto end = std::min(text.find_first_of(L"\r\n"), text.size());
 
-        data.text.emplace_back(std::move(selectionText));
-        if (copyTextColor)
+        // write the text in runs of the same color
+        size_t startOffset = 0;
+        for (size_t col = 1; col <= end; col++)
         {
-            data.FgAttr.emplace_back(std::move(selectionFgAttr));
-            data.BkAttr.emplace_back(std::move(selectionBkAttr));
+            if (col == end || fgAttr.at(col) != fgAttr.at(startOffset) || bkAttr.at(col) != bkAttr.at(startOffset))
+            {
+                writer.Write(text.substr(startOffset, col - startOffset), fgAttr.at(startOffset), bkAttr.at(startOffset));
+                startOffset = col;
+            }
         }
     }
-
-    return data;
 }
 
 // Routine Description:
@@ -1737,409 +3370,443 @@ std::string TextBuffer::GenHTML(const TextAndColor& rows,
 {
     try
     {
-        std::ostringstream htmlBuilder;
-
-        // First we have to add some standard
-        // HTML boiler plate required for CF_HTML
-        // as part of the HTML Clipboard format
-        const std::string htmlHeader =
-            "<!DOCTYPE><HTML><HEAD></HEAD><BODY>";
-        htmlBuilder << htmlHeader;
+        std::string html;
+        HtmlWriter writer{ html, fontHeightPoints, fontFaceName, backgroundColor };
+        s_WriteRichText(rows, writer);
+        writer.Finish();
+        return html;
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return {};
+    }
+}
 
-        htmlBuilder << "<!--StartFragment -->";
+// Routine Description:
+// - Generates an RTF document based on the passed in text and color data
+//   RTF 1.5 Spec: https://www.biblioscape.com/rtf15_spec.htm
+// Arguments:
+// - rows - the text and color data we will format & encapsulate
+// - backgroundColor - default background color for characters, also used in padding
+// - fontHeightPoints - the unscaled font height
+// - fontFaceName - the name of the font used
+// Return Value:
+// - string containing the generated RTF
+std::string TextBuffer::GenRTF(const TextAndColor& rows, const int fontHeightPoints, const std::wstring_view fontFaceName, const COLORREF backgroundColor)
+{
+    try
+    {
+        std::string rtf;
+        RtfWriter writer{ rtf, fontHeightPoints, fontFaceName, backgroundColor };
+        s_WriteRichText(rows, writer);
+        writer.Finish();
+        return rtf;
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return {};
+    }
+}
 
-        // apply global style in div element
-        {
-            htmlBuilder << "<DIV STYLE=\"";
-            htmlBuilder << "display:inline-block;";
-            htmlBuilder << "white-space:pre;";
+// Function Description:
+// - Reflow the contents from the old buffer into the new buffer. The new buffer
+//   can have different dimensions than the old buffer. If it does, then this
+//   function will attempt to maintain the logical contents of the old buffer,
+//   by continuing wrapped lines onto the next line in the new buffer.
+// Arguments:
+// - oldBuffer - the text buffer to copy the contents FROM
+// - newBuffer - the text buffer to copy the contents TO
+// - lastCharacterViewport - Optional. If the caller knows that the last
+//   nonspace character is in a particular Viewport, the caller can provide this
+//   parameter as an optimization, as opposed to searching the entire buffer.
+// - positionInfo - Optional. The caller can provide a pair of rows in this
+//   parameter and we'll calculate the position of the _end_ of those rows in
+//   the new buffer. The rows's new value is placed back into this parameter.
+// Return Value:
+// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
+HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
+                           TextBuffer& newBuffer,
+                           const std::optional<Viewport> lastCharacterViewport,
+                           std::optional<std::reference_wrapper<PositionInformation>> positionInfo)
+{
+    return _Reflow(oldBuffer, newBuffer, lastCharacterViewport, positionInfo, true, 0);
+}
 
-            htmlBuilder << "background-color:";
-            htmlBuilder << Utils::ColorToHexString(backgroundColor);
-            htmlBuilder << ";";
+// Function Description:
+// - Like Reflow, but only reflows the rows starting at the line that holds the given row.
+//   The rows above it are copied into the new buffer as they are (cut off at the new
+//   width) and marked as pending. They're reflowed once FinishReflow is called.
+// - This keeps resizing a buffer with a lot of scrollback cheap while the size keeps changing.
+// - If the new buffer ends up with a pending reflow, the caller has to hand the old buffer
+//   over with AdoptPendingReflowSource, because the pending rows are reflowed from it.
+// Arguments:
+// - oldBuffer - the text buffer to copy the contents FROM
+// - newBuffer - the text buffer to copy the contents TO
+// - firstNeededRow - the first row of the old buffer which has to be reflowed right away.
+//   Ignored if the old buffer has a pending reflow itself, whose rows stay pending.
+// - lastCharacterViewport - Optional. See Reflow.
+// - positionInfo - Optional. See Reflow.
+// Return Value:
+// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
+HRESULT TextBuffer::ReflowDeferred(TextBuffer& oldBuffer,
+                                   TextBuffer& newBuffer,
+                                   const short firstNeededRow,
+                                   const std::optional<Viewport> lastCharacterViewport,
+                                   std::optional<std::reference_wrapper<PositionInformation>> positionInfo)
+{
+    return _Reflow(oldBuffer, newBuffer, lastCharacterViewport, positionInfo, true, firstNeededRow);
+}
 
-            htmlBuilder << "font-family:";
-            htmlBuilder << "'";
-            htmlBuilder << ConvertToA(CP_UTF8, fontFaceName);
-            htmlBuilder << "',";
-            // even with different font, add monospace as fallback
-            htmlBuilder << "monospace;";
+// Function Description:
+// - Reflows the pending rows of a buffer created by ReflowDeferred into a new buffer
+//   of the same size and copies all the other rows along as they are.
+// Arguments:
+// - buffer - the text buffer with the pending reflow
+// - newBuffer - the freshly created text buffer to copy the contents TO. It has to be
+//   as large as the given buffer.
+// - positionInfo - Optional. The rows of the given buffer in this parameter are
+//   replaced with their position in the new buffer.
+// Return Value:
+// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
+HRESULT TextBuffer::FinishReflow(const TextBuffer& buffer,
+                                 TextBuffer& newBuffer,
+                                 std::optional<std::reference_wrapper<PositionInformation>> positionInfo)
+try
+{
+    RETURN_HR_IF(E_INVALIDARG, buffer.GetSize() != newBuffer.GetSize());
 
-            htmlBuilder << "font-size:";
-            htmlBuilder << fontHeightPoints;
-            htmlBuilder << "pt;";
+    Cursor& newCursor = newBuffer.GetCursor();
+    const auto newBottom = newBuffer.GetSize().BottomInclusive();
 
-            // note: MS Word doesn't support padding (in this way at least)
-            htmlBuilder << "padding:";
-            htmlBuilder << 4; // todo: customizable padding
-            htmlBuilder << "px;";
+    // Without a source, the pending rows are simply kept as they are.
+    const auto& pending = buffer._pendingReflow;
+    const short firstRow = pending && pending->source ? buffer.GetPendingReflowRowCount() : 0;
+    std::vector<short> rowEnds(gsl::narrow_cast<size_t>(firstRow));
+    if (firstRow != 0)
+    {
+        // The last pending row ends a line, so there's always a newline after it
+        // and oldRowsTotal doesn't need to be known.
+        std::optional<COORD> unusedCursorPos;
+        RETURN_IF_FAILED(_ReflowRows(*pending->source, newBuffer, pending->firstRow, pending->endRow, SHRT_MAX, COORD{ -1, -1 }, unusedCursorPos, rowEnds));
+    }
 
-            htmlBuilder << "\">";
+    // Copy the remaining rows one by one, remembering where each of them
+    // went and how often the new buffer circled up to that point.
+    const auto oldCursorPos = buffer.GetCursor().GetPosition();
+    const auto lastRow = std::max({ buffer.GetLastNonSpaceCharacter().Y, oldCursorPos.Y, firstRow });
+    std::vector<std::pair<short, size_t>> newRows;
+    size_t circles = 0;
+    for (auto row = firstRow; row <= lastRow; ++row)
+    {
+        if (row != firstRow)
+        {
+            circles += newCursor.GetPosition().Y == newBottom ? 1 : 0;
+            RETURN_HR_IF(E_OUTOFMEMORY, !newBuffer.NewlineCursor());
         }
+        const auto newRow = newCursor.GetPosition().Y;
+        newBuffer.GetRowByOffset(newRow).CopyFrom(buffer.GetRowByOffset(row));
+        newRows.emplace_back(newRow, circles);
+    }
 
-        // copy text and info color from buffer
-        bool hasWrittenAnyText = false;
-        std::optional<COLORREF> fgColor = std::nullopt;
-        std::optional<COLORREF> bkColor = std::nullopt;
-        for (size_t row = 0; row < rows.text.size(); row++)
+    // Every later circle moved the rows up by one more.
+    const auto toNewRow = [&](const short row) {
+        if (row < firstRow)
         {
-            size_t startOffset = 0;
-
-            if (row != 0)
-            {
-                htmlBuilder << "<BR>";
-            }
-
-            for (size_t col = 0; col < rows.text.at(row).length(); col++)
-            {
-                const auto writeAccumulatedChars = [&](bool includeCurrent) {
-                    if (col >= startOffset)
-                    {
-                        const auto unescapedText = ConvertToA(CP_UTF8, std::wstring_view(rows.text.at(row)).substr(startOffset, col - startOffset + includeCurrent));
-                        for (const auto c : unescapedText)
-                        {
-                            switch (c)
-                            {
-                            case '<':
-                                htmlBuilder << "&lt;";
-                                break;
-                            case '>':
-                                htmlBuilder << "&gt;";
-                                break;
-                            case '&':
-                                htmlBuilder << "&amp;";
-                                break;
-                            default:
-                                htmlBuilder << c;
-                            }
-                        }
+            return gsl::narrow_cast<short>(std::max<ptrdiff_t>(til::at(rowEnds, row) - gsl::narrow_cast<ptrdiff_t>(circles), 0));
+        }
+        const auto& [newRow, circlesBefore] = til::at(newRows, std::min(row, lastRow) - firstRow);
+        const auto offset = row - std::min(row, lastRow);
+        return gsl::narrow_cast<short>(std::clamp<ptrdiff_t>(newRow + offset - gsl::narrow_cast<ptrdiff_t>(circles - circlesBefore), 0, newBottom));
+    };
 
-                        startOffset = col;
-                    }
-                };
+    newCursor.SetPosition({ oldCursorPos.X, toNewRow(std::max<short>(oldCursorPos.Y, 0)) });
+    if (positionInfo.has_value())
+    {
+        auto& rows = positionInfo.value().get();
+        rows.mutableViewportTop = toNewRow(std::max<short>(rows.mutableViewportTop, 0));
+        rows.visibleViewportTop = toNewRow(std::max<short>(rows.visibleViewportTop, 0));
+    }
 
-                if (rows.text.at(row).at(col) == '\r' || rows.text.at(row).at(col) == '\n')
-                {
-                    // do not include \r nor \n as they don't have color attributes
-                    // and are not HTML friendly. For line break use '<BR>' instead.
-                    writeAccumulatedChars(false);
-                    break;
-                }
+    newBuffer.CopyProperties(buffer);
+    newBuffer.CopyHyperlinkMaps(buffer);
+    newBuffer.CopyPatterns(buffer);
+    newBuffer._ReflowPromptMarks(buffer);
+    newCursor.SetSize(buffer.GetCursor().GetSize());
+    return S_OK;
+}
+CATCH_RETURN();
 
-                bool colorChanged = false;
-                if (!fgColor.has_value() || rows.FgAttr.at(row).at(col) != fgColor.value())
-                {
-                    fgColor = rows.FgAttr.at(row).at(col);
-                    colorChanged = true;
-                }
+// Routine Description:
+// - Returns whether rows at the top of the buffer still await being reflowed, see ReflowDeferred.
+bool TextBuffer::HasPendingReflow() const noexcept
+{
+    return _pendingReflow.has_value();
+}
 
-                if (!bkColor.has_value() || rows.BkAttr.at(row).at(col) != bkColor.value())
-                {
-                    bkColor = rows.BkAttr.at(row).at(col);
-                    colorChanged = true;
-                }
+// Routine Description:
+// - Returns the number of rows at the top of the buffer which still await being reflowed.
+short TextBuffer::GetPendingReflowRowCount() const noexcept
+{
+    return _pendingReflow ? gsl::narrow_cast<short>(_pendingReflow->endRow - _pendingReflow->firstRow) : 0;
+}
 
-                if (colorChanged)
-                {
-                    writeAccumulatedChars(false);
+// Routine Description:
+// - Hands over the buffer that ReflowDeferred reflowed this buffer from.
+//   The pending rows are reflowed from it in FinishReflow.
+// Arguments:
+// - source - the old buffer. Ignored if this buffer already has a source.
+// Return Value:
+// - <none>
+void TextBuffer::AdoptPendingReflowSource(std::unique_ptr<TextBuffer> source) noexcept
+{
+    if (_pendingReflow && !_pendingReflow->source)
+    {
+        _pendingReflow->source = std::move(source);
+    }
+}
 
-                    if (hasWrittenAnyText)
-                    {
-                        htmlBuilder << "</SPAN>";
-                    }
+// Routine Description:
+// - Gives up on reflowing the pending rows, which stay as they are.
+//   Used when the scrollback is erased anyways.
+void TextBuffer::DiscardPendingReflow() noexcept
+{
+    _pendingReflow.reset();
+}
 
-                    htmlBuilder << "<SPAN STYLE=\"";
-                    htmlBuilder << "color:";
-                    htmlBuilder << Utils::ColorToHexString(fgColor.value());
-                    htmlBuilder << ";";
-                    htmlBuilder << "background-color:";
-                    htmlBuilder << Utils::ColorToHexString(bkColor.value());
-                    htmlBuilder << ";";
-                    htmlBuilder << "\">";
-                }
+// Function Description:
+// - Implements Reflow.
+// - Lines which end in a non-wrapped row can be reflowed independent of each other, because
+//   the next line always starts at the beginning of a new row. Large buffers are therefore
+//   split at the ends of lines into a few segments, which are reflowed on the thread pool
+//   into scratch buffers and then copied into the new buffer one after the other.
+// Arguments:
+// - oldBuffer - the text buffer to copy the contents FROM
+// - newBuffer - the text buffer to copy the contents TO
+// - lastCharacterViewport - Optional. See Reflow.
+// - positionInfo - Optional. See Reflow.
+// - allowParallel - whether the rows may be reflowed in parallel. Gives the same results either way.
+// - firstNeededRow - the rows of the lines above this row are deferred, see ReflowDeferred. 0 to reflow all rows.
+// Return Value:
+// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
+HRESULT TextBuffer::_Reflow(TextBuffer& oldBuffer,
+                            TextBuffer& newBuffer,
+                            const std::optional<Viewport> lastCharacterViewport,
+                            std::optional<std::reference_wrapper<PositionInformation>> positionInfo,
+                            const bool allowParallel,
+                            const short firstNeededRow)
+{
+    const Cursor& oldCursor = oldBuffer.GetCursor();
+    Cursor& newCursor = newBuffer.GetCursor();
 
-                hasWrittenAnyText = true;
+    // We need to save the old cursor position so that we can
+    // place the new cursor back on the equivalent character in
+    // the new buffer.
+    const COORD cOldCursorPos = oldCursor.GetPosition();
+    const COORD cOldLastChar = oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport);
 
-                // if this is the last character in the row, flush the whole row
-                if (col == rows.text.at(row).length() - 1)
-                {
-                    writeAccumulatedChars(true);
-                }
-            }
-        }
+    const short cOldRowsTotal = cOldLastChar.Y + 1;
 
-        if (hasWrittenAnyText)
+    // Find the row at which the reflow starts. The rows above it are deferred.
+    // Rows which are pending already always stay pending, because they don't
+    // hold all of their text anymore.
+    short splitRow = 0;
+    if (oldBuffer._pendingReflow)
+    {
+        splitRow = oldBuffer.GetPendingReflowRowCount();
+    }
+    else if (firstNeededRow > 0)
+    {
+        // The split has to be at the start of a line, above the cursor.
+        splitRow = std::min({ firstNeededRow, cOldRowsTotal, cOldCursorPos.Y });
+        while (splitRow > 0 && !_IsReflowLineEnd(oldBuffer, splitRow - 1))
         {
-            // last opened span wasn't closed in loop above, so close it now
-            htmlBuilder << "</SPAN>";
+            splitRow--;
         }
+    }
 
-        htmlBuilder << "</DIV>";
-
-        htmlBuilder << "<!--EndFragment -->";
-
-        constexpr std::string_view HtmlFooter = "</BODY></HTML>";
-        htmlBuilder << HtmlFooter;
+    // The new position of the cursor, if we came across it, and the new row
+    // of the _end_ of every old row.
+    std::optional<COORD> newCursorPos;
+    std::vector<short> rowEnds;
+    try
+    {
+        rowEnds.resize(gsl::narrow_cast<size_t>(std::max({ cOldRowsTotal, splitRow, short{ 0 } })));
+    }
+    CATCH_RETURN();
 
-        // once filled with values, there will be exactly 157 bytes in the clipboard header
-        constexpr size_t ClipboardHeaderSize = 157;
+    HRESULT hr = S_OK;
+    if (splitRow > 0)
+    {
+        try
+        {
+            // Copy the deferred rows as placeholders, dropping the topmost
+            // ones if they don't fit, while leaving room for at least one more row.
+            const auto placeholders = std::min<short>(splitRow, newBuffer.GetSize().Height() - 1);
+            const auto dropped = gsl::narrow_cast<short>(splitRow - placeholders);
+            for (short row = 0; row < placeholders; ++row)
+            {
+                newBuffer.GetRowByOffset(row).CopyFrom(oldBuffer.GetRowByOffset(dropped + row));
+            }
+            for (short row = 0; row < splitRow; ++row)
+            {
+                til::at(rowEnds, row) = std::max<short>(row - dropped, 0);
+            }
 
-        // these values are byte offsets from start of clipboard
-        const size_t htmlStartPos = ClipboardHeaderSize;
-        const size_t htmlEndPos = ClipboardHeaderSize + gsl::narrow<size_t>(htmlBuilder.tellp());
-        const size_t fragStartPos = ClipboardHeaderSize + gsl::narrow<size_t>(htmlHeader.length());
-        const size_t fragEndPos = htmlEndPos - HtmlFooter.length();
+            // The rows of the source are the rows of the old buffer, unless it has a source itself.
+            const auto sourceRow = oldBuffer._pendingReflow ? oldBuffer._pendingReflow->firstRow : short{ 0 };
+            if (placeholders > 0)
+            {
+                newBuffer._pendingReflow = PendingReflow{ nullptr, gsl::narrow_cast<short>(sourceRow + dropped), gsl::narrow_cast<short>(sourceRow + splitRow) };
+            }
+            newBuffer.GetCursor().SetPosition({ 0, placeholders });
+        }
+        CATCH_RETURN();
 
-        // header required by HTML 0.9 format
-        std::ostringstream clipHeaderBuilder;
-        clipHeaderBuilder << "Version:0.9\r\n";
-        clipHeaderBuilder << std::setfill('0');
-        clipHeaderBuilder << "StartHTML:" << std::setw(10) << htmlStartPos << "\r\n";
-        clipHeaderBuilder << "EndHTML:" << std::setw(10) << htmlEndPos << "\r\n";
-        clipHeaderBuilder << "StartFragment:" << std::setw(10) << fragStartPos << "\r\n";
-        clipHeaderBuilder << "EndFragment:" << std::setw(10) << fragEndPos << "\r\n";
-        clipHeaderBuilder << "StartSelection:" << std::setw(10) << fragStartPos << "\r\n";
-        clipHeaderBuilder << "EndSelection:" << std::setw(10) << fragEndPos << "\r\n";
+        // The rows starting at the split are reflowed as usual. The buffer may circle
+        // while doing so, which drops placeholders just like any other row.
+        hr = _ReflowRows(oldBuffer, newBuffer, splitRow, cOldRowsTotal, cOldRowsTotal, cOldCursorPos, newCursorPos, gsl::span<short>{ rowEnds }.subspan(gsl::narrow_cast<size_t>(splitRow)));
 
-        return clipHeaderBuilder.str() + htmlBuilder.str();
+        // Hand the source of the old buffer over, if the new buffer still has any placeholders.
+        if (SUCCEEDED(hr) && oldBuffer._pendingReflow)
+        {
+            if (newBuffer._pendingReflow)
+            {
+                newBuffer._pendingReflow->source = std::move(oldBuffer._pendingReflow->source);
+            }
+            oldBuffer._pendingReflow.reset();
+        }
     }
-    catch (...)
+    else
     {
-        LOG_HR(wil::ResultFromCaughtException());
-        return {};
+        hr = allowParallel ? _ReflowRowsInParallel(oldBuffer, newBuffer, cOldRowsTotal, cOldCursorPos, newCursorPos, rowEnds) : S_FALSE;
+        if (hr == S_FALSE)
+        {
+            hr = _ReflowRows(oldBuffer, newBuffer, 0, cOldRowsTotal, cOldRowsTotal, cOldCursorPos, newCursorPos, rowEnds);
+        }
     }
-}
 
-// Routine Description:
-// - Generates an RTF document based on the passed in text and color data
-//   RTF 1.5 Spec: https://www.biblioscape.com/rtf15_spec.htm
-// Arguments:
-// - rows - the text and color data we will format & encapsulate
-// - backgroundColor - default background color for characters, also used in padding
-// - fontHeightPoints - the unscaled font height
-// - fontFaceName - the name of the font used
-// - htmlTitle - value used in title tag of html header. Used to name the application
-// Return Value:
-// - string containing the generated RTF
-std::string TextBuffer::GenRTF(const TextAndColor& rows, const int fontHeightPoints, const std::wstring_view fontFaceName, const COLORREF backgroundColor)
-{
-    try
+    // If we found the old rows that the caller was interested in, set the
+    // out value of that parameter to the new location of the _end_ of that row in the buffer.
+    if (SUCCEEDED(hr) && positionInfo.has_value())
     {
-        std::ostringstream rtfBuilder;
-
-        // start rtf
-        rtfBuilder << "{";
-
-        // Standard RTF header.
-        // This is similar to the header generated by WordPad.
-        // \ansi - specifies that the ANSI char set is used in the current doc
-        // \ansicpg1252 - represents the ANSI code page which is used to perform the Unicode to ANSI conversion when writing RTF text
-        // \deff0 - specifies that the default font for the document is the one at index 0 in the font table
-        // \nouicompat - ?
-        rtfBuilder << "\\rtf1\\ansi\\ansicpg1252\\deff0\\nouicompat";
-
-        // font table
-        rtfBuilder << "{\\fonttbl{\\f0\\fmodern\\fcharset0 " << ConvertToA(CP_UTF8, fontFaceName) << ";}}";
-
-        // map to keep track of colors:
-        // keys are colors represented by COLORREF
-        // values are indices of the corresponding colors in the color table
-        std::unordered_map<COLORREF, int> colorMap;
-        int nextColorIndex = 1; // leave 0 for the default color and start from 1.
-
-        // RTF color table
-        std::ostringstream colorTableBuilder;
-        colorTableBuilder << "{\\colortbl ;";
-        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(backgroundColor))
-                          << "\\green" << static_cast<int>(GetGValue(backgroundColor))
-                          << "\\blue" << static_cast<int>(GetBValue(backgroundColor))
-                          << ";";
-        colorMap[backgroundColor] = nextColorIndex++;
-
-        // content
-        std::ostringstream contentBuilder;
-        contentBuilder << "\\viewkind4\\uc4";
-
-        // paragraph styles
-        // \fs specifies font size in half-points i.e. \fs20 results in a font size
-        // of 10 pts. That's why, font size is multiplied by 2 here.
-        contentBuilder << "\\pard\\slmult1\\f0\\fs" << std::to_string(2 * fontHeightPoints)
-                       << "\\highlight1"
-                       << " ";
-
-        std::optional<COLORREF> fgColor = std::nullopt;
-        std::optional<COLORREF> bkColor = std::nullopt;
-        for (size_t row = 0; row < rows.text.size(); ++row)
-        {
-            size_t startOffset = 0;
-
-            if (row != 0)
+        const auto findNewRow = [&](short& row) {
+            const auto oldRow = std::max<short>(row, 0);
+            if (oldRow < cOldRowsTotal)
             {
-                contentBuilder << "\\line "; // new line
+                row = til::at(rowEnds, oldRow);
             }
+        };
+        findNewRow(positionInfo.value().get().mutableViewportTop);
+        findNewRow(positionInfo.value().get().visibleViewportTop);
+    }
 
-            for (size_t col = 0; col < rows.text.at(row).length(); ++col)
-            {
-                const auto writeAccumulatedChars = [&](bool includeCurrent) {
-                    if (col >= startOffset)
-                    {
-                        const auto unescapedText = ConvertToA(CP_UTF8, std::wstring_view(rows.text.at(row)).substr(startOffset, col - startOffset + includeCurrent));
-                        for (const auto c : unescapedText)
-                        {
-                            switch (c)
-                            {
-                            case '\\':
-                            case '{':
-                            case '}':
-                                contentBuilder << "\\" << c;
-                                break;
-                            default:
-                                contentBuilder << c;
-                            }
-                        }
-
-                        startOffset = col;
-                    }
-                };
+    if (SUCCEEDED(hr))
+    {
+        // Finish copying remaining parameters from the old text buffer to the new one
+        newBuffer.CopyProperties(oldBuffer);
+        newBuffer.CopyHyperlinkMaps(oldBuffer);
+        newBuffer.CopyPatterns(oldBuffer);
 
-                if (rows.text.at(row).at(col) == '\r' || rows.text.at(row).at(col) == '\n')
-                {
-                    // do not include \r nor \n as they don't have color attributes.
-                    // For line break use \line instead.
-                    writeAccumulatedChars(false);
-                    break;
-                }
+        // If we found where to put the cursor while placing characters into the buffer,
+        //   just put the cursor there. Otherwise we have to advance manually.
+        if (newCursorPos.has_value())
+        {
+            newCursor.SetPosition(newCursorPos.value());
+        }
+        else
+        {
+            // Advance the cursor to the same offset as before
+            // get the number of newlines and spaces between the old end of text and the old cursor,
+            //   then advance that many newlines and chars
+            int iNewlines = cOldCursorPos.Y - cOldLastChar.Y;
+            const int iIncrements = cOldCursorPos.X - cOldLastChar.X;
+            const COORD cNewLastChar = newBuffer.GetLastNonSpaceCharacter();
 
-                bool colorChanged = false;
-                if (!fgColor.has_value() || rows.FgAttr.at(row).at(col) != fgColor.value())
+            // If the last row of the new buffer wrapped, there's going to be one less newline needed,
+            //   because the cursor is already on the next line
+            if (newBuffer.GetRowByOffset(cNewLastChar.Y).WasWrapForced())
+            {
+                iNewlines = std::max(iNewlines - 1, 0);
+            }
+            else
+            {
+                // if this buffer didn't wrap, but the old one DID, then the d(columns) of the
+                //   old buffer will be one more than in this buffer, so new need one LESS.
+                if (oldBuffer.GetRowByOffset(cOldLastChar.Y).WasWrapForced())
                 {
-                    fgColor = rows.FgAttr.at(row).at(col);
-                    colorChanged = true;
+                    iNewlines = std::max(iNewlines - 1, 0);
                 }
+            }
 
-                if (!bkColor.has_value() || rows.BkAttr.at(row).at(col) != bkColor.value())
+            for (int r = 0; r < iNewlines; r++)
+            {
+                if (!newBuffer.NewlineCursor())
                 {
-                    bkColor = rows.BkAttr.at(row).at(col);
-                    colorChanged = true;
+                    hr = E_OUTOFMEMORY;
+                    break;
                 }
-
-                if (colorChanged)
+            }
+            if (SUCCEEDED(hr))
+            {
+                for (int c = 0; c < iIncrements - 1; c++)
                 {
-                    writeAccumulatedChars(false);
-
-                    int bkColorIndex = 0;
-                    if (colorMap.find(bkColor.value()) != colorMap.end())
-                    {
-                        // color already exists in the map, just retrieve the index
-                        bkColorIndex = colorMap[bkColor.value()];
-                    }
-                    else
-                    {
-                        // color not present in the map, so add it
-                        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(bkColor.value()))
-                                          << "\\green" << static_cast<int>(GetGValue(bkColor.value()))
-                                          << "\\blue" << static_cast<int>(GetBValue(bkColor.value()))
-                                          << ";";
-                        colorMap[bkColor.value()] = nextColorIndex;
-                        bkColorIndex = nextColorIndex++;
-                    }
-
-                    int fgColorIndex = 0;
-                    if (colorMap.find(fgColor.value()) != colorMap.end())
-                    {
-                        // color already exists in the map, just retrieve the index
-                        fgColorIndex = colorMap[fgColor.value()];
-                    }
-                    else
+                    if (!newBuffer.IncrementCursor())
                     {
-                        // color not present in the map, so add it
-                        colorTableBuilder << "\\red" << static_cast<int>(GetRValue(fgColor.value()))
-                                          << "\\green" << static_cast<int>(GetGValue(fgColor.value()))
-                                          << "\\blue" << static_cast<int>(GetBValue(fgColor.value()))
-                                          << ";";
-                        colorMap[fgColor.value()] = nextColorIndex;
-                        fgColorIndex = nextColorIndex++;
+                        hr = E_OUTOFMEMORY;
+                        break;
                     }
-
-                    contentBuilder << "\\highlight" << bkColorIndex
-                                   << "\\cf" << fgColorIndex
-                                   << " ";
-                }
-
-                // if this is the last character in the row, flush the whole row
-                if (col == rows.text.at(row).length() - 1)
-                {
-                    writeAccumulatedChars(true);
                 }
             }
         }
+    }
 
-        // end colortbl
-        colorTableBuilder << "}";
-
-        // add color table to the final RTF
-        rtfBuilder << colorTableBuilder.str();
-
-        // add the text content to the final RTF
-        rtfBuilder << contentBuilder.str();
+    if (SUCCEEDED(hr))
+    {
+        // Save old cursor size before we delete it
+        ULONG const ulSize = oldCursor.GetSize();
 
-        // end rtf
-        rtfBuilder << "}";
+        // Set size back to real size as it will be taking over the rendering duties.
+        newCursor.SetSize(ulSize);
 
-        return rtfBuilder.str();
-    }
-    catch (...)
-    {
-        LOG_HR(wil::ResultFromCaughtException());
-        return {};
+        newBuffer._ReflowPromptMarks(oldBuffer);
     }
+
+    return hr;
 }
 
 // Function Description:
-// - Reflow the contents from the old buffer into the new buffer. The new buffer
-//   can have different dimensions than the old buffer. If it does, then this
-//   function will attempt to maintain the logical contents of the old buffer,
-//   by continuing wrapped lines onto the next line in the new buffer.
+// - Reflows the given rows of the old buffer into the new buffer, starting at its cursor.
 // Arguments:
 // - oldBuffer - the text buffer to copy the contents FROM
 // - newBuffer - the text buffer to copy the contents TO
-// - lastCharacterViewport - Optional. If the caller knows that the last
-//   nonspace character is in a particular Viewport, the caller can provide this
-//   parameter as an optimization, as opposed to searching the entire buffer.
-// - positionInfo - Optional. The caller can provide a pair of rows in this
-//   parameter and we'll calculate the position of the _end_ of those rows in
-//   the new buffer. The rows's new value is placed back into this parameter.
+// - firstRow - the first row to copy
+// - endRow - the row past the last row to copy
+// - oldRowsTotal - the number of rows in the old buffer which hold any text
+// - oldCursorPos - the position of the cursor in the old buffer
+// - newCursorPos - receives the new position of the cursor, if it's within the copied rows
+// - rowEnds - receives the row of the new buffer holding the _end_ of each copied row
 // Return Value:
-// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
-HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
-                           TextBuffer& newBuffer,
-                           const std::optional<Viewport> lastCharacterViewport,
-                           std::optional<std::reference_wrapper<PositionInformation>> positionInfo)
+// - S_OK if we successfully copied the rows to the new buffer, otherwise an appropriate HRESULT.
+HRESULT TextBuffer::_ReflowRows(const TextBuffer& oldBuffer,
+                                TextBuffer& newBuffer,
+                                const short firstRow,
+                                const short endRow,
+                                const short oldRowsTotal,
+                                const COORD oldCursorPos,
+                                std::optional<COORD>& newCursorPos,
+                                gsl::span<short> rowEnds)
 {
-    const Cursor& oldCursor = oldBuffer.GetCursor();
     Cursor& newCursor = newBuffer.GetCursor();
-
-    // We need to save the old cursor position so that we can
-    // place the new cursor back on the equivalent character in
-    // the new buffer.
-    const COORD cOldCursorPos = oldCursor.GetPosition();
-    const COORD cOldLastChar = oldBuffer.GetLastNonSpaceCharacter(lastCharacterViewport);
-
-    const short cOldRowsTotal = cOldLastChar.Y + 1;
-
-    COORD cNewCursorPos = { 0 };
-    bool fFoundCursorPos = false;
-    bool foundOldMutable = false;
-    bool foundOldVisible = false;
     HRESULT hr = S_OK;
     // Loop through all the rows of the old buffer and reprint them into the new buffer
-    for (short iOldRow = 0; iOldRow < cOldRowsTotal; iOldRow++)
+    for (short iOldRow = firstRow; iOldRow < endRow; iOldRow++)
     {
         // Fetch the row and its "right" which is the last printable character.
         const ROW& row = oldBuffer.GetRowByOffset(iOldRow);
         const short cOldColsTotal = oldBuffer.GetLineWidth(iOldRow);
-        const CharRow& charRow = row.GetCharRow();
-        short iRight = gsl::narrow_cast<short>(charRow.MeasureRight());
+        const short iRight = _GetReflowRight(row, cOldColsTotal);
 
         // If we're starting a new row, try and preserve the line rendition
         // from the row in the original buffer.
@@ -2150,39 +3817,16 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
             newRow.SetLineRendition(row.GetLineRendition());
         }
 
-        // There is a special case here. If the row has a "wrap"
-        // flag on it, but the right isn't equal to the width (one
-        // index past the final valid index in the row) then there
-        // were a bunch trailing of spaces in the row.
-        // (But the measuring functions for each row Left/Right do
-        // not count spaces as "displayable" so they're not
-        // included.)
-        // As such, adjust the "right" to be the width of the row
-        // to capture all these spaces
-        if (row.WasWrapForced())
-        {
-            iRight = cOldColsTotal;
-
-            // And a combined special case.
-            // If we wrapped off the end of the row by adding a
-            // piece of padding because of a double byte LEADING
-            // character, then remove one from the "right" to
-            // leave this padding out of the copy process.
-            if (row.WasDoubleBytePadded())
-            {
-                iRight--;
-            }
-        }
-
         // Loop through every character in the current row (up to
         // the "right" boundary, which is one past the final valid
-        // character)
-        for (short iOldCol = 0; iOldCol < iRight; iOldCol++)
+        // character). The attributes are walked alongside, instead
+        // of looking up the run of every column from the start.
+        auto attrIt = row.GetAttrRow().cbegin();
+        for (short iOldCol = 0; iOldCol < iRight; iOldCol++, ++attrIt)
         {
-            if (iOldCol == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
+            if (iOldCol == oldCursorPos.X && iOldRow == oldCursorPos.Y)
             {
-                cNewCursorPos = newCursor.GetPosition();
-                fFoundCursorPos = true;
+                newCursorPos = newCursor.GetPosition();
             }
 
             try
@@ -2190,7 +3834,7 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
                 // TODO: MSFT: 19446208 - this should just use an iterator and the inserter...
                 const auto glyph = row.GetCharRow().GlyphAt(iOldCol);
                 const auto dbcsAttr = row.GetCharRow().DbcsAttrAt(iOldCol);
-                const auto textAttr = row.GetAttrRow().GetAttrByColumn(iOldCol);
+                const auto& textAttr = *attrIt;
 
                 if (!newBuffer.InsertCharacter(glyph, dbcsAttr, textAttr))
                 {
@@ -2201,29 +3845,8 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
             CATCH_RETURN();
         }
 
-        // If we found the old row that the caller was interested in, set the
-        // out value of that parameter to the cursor's current Y position (the
-        // new location of the _end_ of that row in the buffer).
-        if (positionInfo.has_value())
-        {
-            if (!foundOldMutable)
-            {
-                if (iOldRow >= positionInfo.value().get().mutableViewportTop)
-                {
-                    positionInfo.value().get().mutableViewportTop = newCursor.GetPosition().Y;
-                    foundOldMutable = true;
-                }
-            }
-
-            if (!foundOldVisible)
-            {
-                if (iOldRow >= positionInfo.value().get().visibleViewportTop)
-                {
-                    positionInfo.value().get().visibleViewportTop = newCursor.GetPosition().Y;
-                    foundOldVisible = true;
-                }
-            }
-        }
+        // Remember the cursor's current Y position (the new location of the _end_ of that row in the buffer).
+        til::at(rowEnds, gsl::narrow_cast<size_t>(iOldRow) - firstRow) = newCursor.GetPosition().Y;
 
         if (SUCCEEDED(hr))
         {
@@ -2234,16 +3857,15 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
             // only because we ran out of space.
             if (iRight < cOldColsTotal && !row.WasWrapForced())
             {
-                if (iRight == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
+                if (iRight == oldCursorPos.X && iOldRow == oldCursorPos.Y)
                 {
-                    cNewCursorPos = newCursor.GetPosition();
-                    fFoundCursorPos = true;
+                    newCursorPos = newCursor.GetPosition();
                 }
                 // Only do this if it's not the final line in the buffer.
                 // On the final line, we want the cursor to sit
                 // where it is done printing for the cursor
                 // adjustment to follow.
-                if (iOldRow < cOldRowsTotal - 1)
+                if (iOldRow < oldRowsTotal - 1)
                 {
                     hr = newBuffer.NewlineCursor() ? hr : E_OUTOFMEMORY;
                 }
@@ -2285,85 +3907,244 @@ HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer,
             }
         }
     }
-    if (SUCCEEDED(hr))
+    return hr;
+}
+
+// Function Description:
+// - Reflows the rows of the old buffer in parallel, if there are enough of them.
+// - The rows are split into segments at the ends of lines (rows for which
+//   _ReflowRows moves the new cursor onto a new row). Each segment is reflowed on
+//   the thread pool into a scratch buffer of the new width that's large enough to
+//   never circle. The scratch rows are then copied into the new buffer, advancing its
+//   cursor like _ReflowRows would, which gives the exact same results.
+// Arguments:
+// - oldBuffer - the text buffer to copy the contents FROM
+// - newBuffer - the freshly created text buffer to copy the contents TO
+// - oldRowsTotal - the number of rows in the old buffer which hold any text
+// - oldCursorPos - the position of the cursor in the old buffer
+// - newCursorPos - receives the new position of the cursor, if it's within the copied rows
+// - rowEnds - receives the row of the new buffer holding the _end_ of each old row
+// Return Value:
+// - S_OK if we successfully copied the rows to the new buffer.
+// - S_FALSE if the rows aren't worth splitting up. Nothing was copied then.
+// - Otherwise an appropriate HRESULT.
+HRESULT TextBuffer::_ReflowRowsInParallel(TextBuffer& oldBuffer,
+                                          TextBuffer& newBuffer,
+                                          const short oldRowsTotal,
+                                          const COORD oldCursorPos,
+                                          std::optional<COORD>& newCursorPos,
+                                          gsl::span<short> rowEnds)
+try
+{
+    const auto newWidth = newBuffer.GetSize().Width();
+    const auto taskCount = std::min<size_t>(std::thread::hardware_concurrency(), gsl::narrow_cast<size_t>(oldRowsTotal) / s_MinReflowRowsPerTask);
+    // The segments are stitched together assuming that the first one starts at the beginning of a row.
+    if (taskCount < 2 || newWidth < 4 || newBuffer.GetCursor().GetPosition().X != 0)
     {
-        // Finish copying remaining parameters from the old text buffer to the new one
-        newBuffer.CopyProperties(oldBuffer);
-        newBuffer.CopyHyperlinkMaps(oldBuffer);
-        newBuffer.CopyPatterns(oldBuffer);
+        return S_FALSE;
+    }
 
-        // If we found where to put the cursor while placing characters into the buffer,
-        //   just put the cursor there. Otherwise we have to advance manually.
-        if (fFoundCursorPos)
+    struct Segment
+    {
+        short firstRow;
+        short endRow;
+        size_t cells; // the number of cells that will be copied
+        size_t lines; // the number of lines that end within the segment
+        bool doubleWidth; // whether any of the rows is a double width row
+    };
+
+    // Split the rows into segments of roughly the same size, at the ends of lines.
+    // This also expands all rows which are packed into cold storage, so
+    // that the old buffer is only read from the worker threads.
+    std::vector<Segment> segments;
+    const auto rowsPerTask = (gsl::narrow_cast<size_t>(oldRowsTotal) + taskCount - 1) / taskCount;
+    Segment segment{};
+    for (short iOldRow = 0; iOldRow < oldRowsTotal; iOldRow++)
+    {
+        const ROW& row = oldBuffer.GetRowByOffset(iOldRow);
+        const short cOldColsTotal = oldBuffer.GetLineWidth(iOldRow);
+        const short iRight = _GetReflowRight(row, cOldColsTotal);
+        const auto lineEnds = iRight < cOldColsTotal && !row.WasWrapForced();
+
+        segment.endRow = gsl::narrow_cast<short>(iOldRow + 1);
+        segment.cells += gsl::narrow_cast<size_t>(iRight);
+        segment.lines += lineEnds ? 1 : 0;
+        segment.doubleWidth = segment.doubleWidth || row.GetLineRendition() != LineRendition::SingleWidth;
+
+        if ((lineEnds && gsl::narrow_cast<size_t>(segment.endRow - segment.firstRow) >= rowsPerTask) || segment.endRow == oldRowsTotal)
         {
-            newCursor.SetPosition(cNewCursorPos);
+            segments.emplace_back(segment);
+            segment = { segment.endRow };
         }
-        else
+    }
+    if (segments.size() < 2)
+    {
+        return S_FALSE;
+    }
+
+    // Every new row but the last of each line holds at least one cell less than the line width.
+    // On top of that there may be an empty row after the last line and one more for the newline
+    // which _ReflowRows may add to preserve the end of the final line.
+    std::vector<SHORT> heights;
+    for (const auto& s : segments)
+    {
+        const auto lineWidth = gsl::narrow_cast<size_t>(s.doubleWidth ? newWidth / 2 : newWidth);
+        const auto height = s.cells / (lineWidth - 1) + s.lines + 2;
+        if (height > SHRT_MAX)
         {
-            // Advance the cursor to the same offset as before
-            // get the number of newlines and spaces between the old end of text and the old cursor,
-            //   then advance that many newlines and chars
-            int iNewlines = cOldCursorPos.Y - cOldLastChar.Y;
-            const int iIncrements = cOldCursorPos.X - cOldLastChar.X;
-            const COORD cNewLastChar = newBuffer.GetLastNonSpaceCharacter();
+            return S_FALSE;
+        }
+        heights.emplace_back(gsl::narrow_cast<SHORT>(height));
+    }
 
-            // If the last row of the new buffer wrapped, there's going to be one less newline needed,
-            //   because the cursor is already on the next line
-            if (newBuffer.GetRowByOffset(cNewLastChar.Y).WasWrapForced())
+    struct SegmentResult
+    {
+        DummyRenderTarget renderTarget;
+        std::unique_ptr<TextBuffer> buffer;
+        std::optional<COORD> cursorPos;
+        HRESULT hr{ S_OK };
+    };
+
+    const auto attributes = newBuffer.GetCurrentAttributes();
+    const auto cursorSize = newBuffer.GetCursor().GetSize();
+
+    // The results have to outlive the tasks, whose futures wait for them to finish.
+    std::vector<SegmentResult> results(segments.size());
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        tasks.emplace_back(std::async(std::launch::async, [&, i]() noexcept {
+            const auto& s = til::at(segments, i);
+            auto& result = til::at(results, i);
+            try
             {
-                iNewlines = std::max(iNewlines - 1, 0);
+                result.buffer = std::make_unique<TextBuffer>(COORD{ newWidth, til::at(heights, i) }, attributes, cursorSize, result.renderTarget);
+                result.hr = _ReflowRows(oldBuffer,
+                                        *result.buffer,
+                                        s.firstRow,
+                                        s.endRow,
+                                        oldRowsTotal,
+                                        oldCursorPos,
+                                        result.cursorPos,
+                                        rowEnds.subspan(gsl::narrow_cast<size_t>(s.firstRow), gsl::narrow_cast<size_t>(s.endRow - s.firstRow)));
             }
-            else
+            catch (...)
             {
-                // if this buffer didn't wrap, but the old one DID, then the d(columns) of the
-                //   old buffer will be one more than in this buffer, so new need one LESS.
-                if (oldBuffer.GetRowByOffset(cOldLastChar.Y).WasWrapForced())
-                {
-                    iNewlines = std::max(iNewlines - 1, 0);
-                }
+                result.hr = wil::ResultFromCaughtException();
             }
+        }));
+    }
+    for (auto& task : tasks)
+    {
+        task.wait();
+    }
 
-            for (int r = 0; r < iNewlines; r++)
-            {
-                if (!newBuffer.NewlineCursor())
-                {
-                    hr = E_OUTOFMEMORY;
-                    break;
-                }
-            }
-            if (SUCCEEDED(hr))
+    // Stitch the segments together. Each segment but the last one ends with
+    // the cursor at the start of an untouched row, where the next one begins.
+    Cursor& newCursor = newBuffer.GetCursor();
+    const auto newBottom = newBuffer.GetSize().BottomInclusive();
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        const auto& s = til::at(segments, i);
+        const auto& result = til::at(results, i);
+        RETURN_IF_FAILED(result.hr);
+
+        // Once the cursor reaches the bottom of the new buffer it stays there,
+        // while the buffer circles underneath it.
+        const auto baseRow = newCursor.GetPosition().Y;
+        const auto toNewRow = [&](const short row) noexcept {
+            return gsl::narrow_cast<short>(std::min<int>(baseRow + row, newBottom));
+        };
+
+        const auto isLast = i == segments.size() - 1;
+        const auto endPos = result.buffer->GetCursor().GetPosition();
+        const auto rowCount = isLast ? endPos.Y + 1 : endPos.Y;
+        for (short row = 0; row < rowCount; ++row)
+        {
+            if (row != 0)
             {
-                for (int c = 0; c < iIncrements - 1; c++)
-                {
-                    if (!newBuffer.IncrementCursor())
-                    {
-                        hr = E_OUTOFMEMORY;
-                        break;
-                    }
-                }
+                RETURN_HR_IF(E_OUTOFMEMORY, !newBuffer.NewlineCursor());
             }
+            newBuffer.GetRowByOffset(newCursor.GetPosition().Y).CopyFrom(result.buffer->GetRowByOffset(row));
+        }
+
+        if (isLast)
+        {
+            newCursor.SetXPosition(endPos.X);
+        }
+        else
+        {
+            RETURN_HR_IF(E_OUTOFMEMORY, !newBuffer.NewlineCursor());
+        }
+
+        for (auto row = s.firstRow; row < s.endRow; ++row)
+        {
+            auto& rowEnd = til::at(rowEnds, row);
+            rowEnd = toNewRow(rowEnd);
+        }
+        if (result.cursorPos.has_value())
+        {
+            newCursorPos = COORD{ result.cursorPos.value().X, toNewRow(result.cursorPos.value().Y) };
         }
     }
 
-    if (SUCCEEDED(hr))
-    {
-        // Save old cursor size before we delete it
-        ULONG const ulSize = oldCursor.GetSize();
+    return S_OK;
+}
+CATCH_RETURN();
 
-        // Set size back to real size as it will be taking over the rendering duties.
-        newCursor.SetSize(ulSize);
+// Function Description:
+// - Finds the "right" of a row for Reflow, which is one past the last cell that gets copied.
+// Arguments:
+// - row - the row in the old buffer
+// - width - the width of that row
+// Return Value:
+// - The number of cells of the row to copy into the new buffer.
+short TextBuffer::_GetReflowRight(const ROW& row, const short width)
+{
+    // There is a special case here. If the row has a "wrap"
+    // flag on it, but the right isn't equal to the width (one
+    // index past the final valid index in the row) then there
+    // were a bunch trailing of spaces in the row.
+    // (But the measuring functions for each row Left/Right do
+    // not count spaces as "displayable" so they're not
+    // included.)
+    // As such, adjust the "right" to be the width of the row
+    // to capture all these spaces
+    if (row.WasWrapForced())
+    {
+        // And a combined special case.
+        // If we wrapped off the end of the row by adding a
+        // piece of padding because of a double byte LEADING
+        // character, then remove one from the "right" to
+        // leave this padding out of the copy process.
+        return row.WasDoubleBytePadded() ? width - 1 : width;
     }
 
-    return hr;
+    return gsl::narrow_cast<short>(row.GetCharRow().MeasureRight());
+}
+
+// Function Description:
+// - Returns whether the given row ends a line, meaning that Reflow starts a new row after it.
+// Arguments:
+// - buffer - the buffer holding the row
+// - row - the row to check
+// Return Value:
+// - true if the next row starts a new line.
+bool TextBuffer::_IsReflowLineEnd(const TextBuffer& buffer, const short row)
+{
+    const ROW& r = buffer.GetRowByOffset(row);
+    const short width = buffer.GetLineWidth(row);
+    return _GetReflowRight(r, width) < width && !r.WasWrapForced();
 }
 
 // Method Description:
-// - Adds or updates a hyperlink in our hyperlink table
+// - Updates the URI of a hyperlink in our hyperlink table
 // Arguments:
-// - The hyperlink URI, the hyperlink id (could be new or old)
+// - The hyperlink URI, the hyperlink id (as returned by GetHyperlinkId)
 void TextBuffer::AddHyperlinkToMap(std::wstring_view uri, uint16_t id)
 {
-    _hyperlinkMap[id] = uri;
+    _hyperlinks.SetUri(id, uri);
 }
 
 // Method Description:
@@ -2374,44 +4155,30 @@ void TextBuffer::AddHyperlinkToMap(std::wstring_view uri, uint16_t id)
 // - The URI
 std::wstring TextBuffer::GetHyperlinkUriFromId(uint16_t id) const
 {
-    return _hyperlinkMap.at(id);
+    return std::wstring{ _hyperlinks.GetUri(id) };
 }
 
 // Method description:
 // - Provides the hyperlink ID to be assigned as a text attribute, based on the optional custom id provided
+// - IDs of hyperlinks that scrolled out of the buffer are handed out again. If all of them
+//   are in use, 0 is returned, which leaves the text without a hyperlink.
 // Arguments:
-// - The user-defined id
+// - The hyperlink URI, the user-defined id
 // Return value:
 // - The internal hyperlink ID
 uint16_t TextBuffer::GetHyperlinkId(std::wstring_view uri, std::wstring_view id)
 {
-    uint16_t numericId = 0;
     if (id.empty())
     {
-        // no custom id specified, return our internal count
-        numericId = _currentHyperlinkId;
-        ++_currentHyperlinkId;
-    }
-    else
-    {
-        // assign _currentHyperlinkId if the custom id does not already exist
-        std::wstring newId{ id };
-        // hash the URL and add it to the custom ID - GH#7698
-        newId += L"%" + std::to_wstring(std::hash<std::wstring_view>{}(uri));
-        const auto result = _hyperlinkCustomIdMap.emplace(newId, _currentHyperlinkId);
-        if (result.second)
-        {
-            // the custom id did not already exist
-            ++_currentHyperlinkId;
-        }
-        numericId = (*(result.first)).second;
-    }
-    // _currentHyperlinkId could overflow, make sure its not 0
-    if (_currentHyperlinkId == 0)
-    {
-        ++_currentHyperlinkId;
+        // no custom id specified, each hyperlink gets its own ID
+        return _hyperlinks.Add(uri);
     }
-    return numericId;
+
+    // reuse the hyperlink of the custom id if it already exists
+    std::wstring newId{ id };
+    // hash the URL and add it to the custom ID - GH#7698
+    newId += L"%" + std::to_wstring(std::hash<std::wstring_view>{}(uri));
+    return _hyperlinks.AddWithCustomId(uri, newId);
 }
 
 // Method Description:
@@ -2421,15 +4188,7 @@ uint16_t TextBuffer::GetHyperlinkId(std::wstring_view uri, std::wstring_view id)
 // - The ID of the hyperlink to be removed
 void TextBuffer::RemoveHyperlinkFromMap(uint16_t id) noexcept
 {
-    _hyperlinkMap.erase(id);
-    for (const auto& customIdPair : _hyperlinkCustomIdMap)
-    {
-        if (customIdPair.second == id)
-        {
-            _hyperlinkCustomIdMap.erase(customIdPair.first);
-            break;
-        }
-    }
+    _hyperlinks.Remove(id);
 }
 
 // Method Description:
@@ -2441,30 +4200,24 @@ void TextBuffer::RemoveHyperlinkFromMap(uint16_t id) noexcept
 // - The custom ID if there was one, empty string otherwise
 std::wstring TextBuffer::GetCustomIdFromId(uint16_t id) const
 {
-    for (auto customIdPair : _hyperlinkCustomIdMap)
-    {
-        if (customIdPair.second == id)
-        {
-            return customIdPair.first;
-        }
-    }
-    return {};
+    return std::wstring{ _hyperlinks.GetCustomId(id) };
 }
 
 // Method Description:
-// - Copies the hyperlink/customID maps of the old buffer into this one,
-//   also copies currentHyperlinkId
+// - Copies the hyperlink table of the old buffer into this one.
+//   The references are counted again from the rows of this buffer.
 // Arguments:
 // - The other buffer
 void TextBuffer::CopyHyperlinkMaps(const TextBuffer& other)
 {
-    _hyperlinkMap = other._hyperlinkMap;
-    _hyperlinkCustomIdMap = other._hyperlinkCustomIdMap;
-    _currentHyperlinkId = other._currentHyperlinkId;
+    _hyperlinks = other._hyperlinks;
+    _hyperlinks.ClearReferences();
+    _rowHyperlinks.clear();
 }
 
 // Method Description:
 // - Adds a regex pattern we should search for
+// - See PatternMatcher for the supported syntax. Throws E_INVALIDARG for anything else.
 // - The searching does not happen here, we only search when asked to by TerminalCore
 // Arguments:
 // - The regex pattern
@@ -2472,8 +4225,10 @@ void TextBuffer::CopyHyperlinkMaps(const TextBuffer& other)
 // - An ID that the caller should associate with the given pattern
 const size_t TextBuffer::AddPatternRecognizer(const std::wstring_view regexString)
 {
+    _patternMatcher.AddPattern(_currentPatternId + 1, regexString);
+
     ++_currentPatternId;
-    _idsAndPatterns.emplace(std::make_pair(_currentPatternId, regexString));
+    _patternCache.clear();
     return _currentPatternId;
 }
 
@@ -2481,7 +4236,8 @@ const size_t TextBuffer::AddPatternRecognizer(const std::wstring_view regexStrin
 // - Clears the patterns we know of and resets the pattern ID counter
 void TextBuffer::ClearPatternRecognizers() noexcept
 {
-    _idsAndPatterns.clear();
+    _patternMatcher.Clear();
+    _patternCache.clear();
     _currentPatternId = 0;
 }
 
@@ -2491,20 +4247,98 @@ void TextBuffer::ClearPatternRecognizers() noexcept
 // - The other buffer
 void TextBuffer::CopyPatterns(const TextBuffer& OtherBuffer)
 {
-    _idsAndPatterns = OtherBuffer._idsAndPatterns;
+    _patternMatcher = OtherBuffer._patternMatcher;
+    _patternCache.clear();
     _currentPatternId = OtherBuffer._currentPatternId;
 }
 
 // Method Description:
 // - Finds patterns within the requested region of the text buffer
+// - Text that spans multiple rows is matched across them as long as the rows
+//   were wrapped, so the region is searched one (wrapped) line at a time.
+// - The matches of every line are cached along with the generations of the rows
+//   that make up the line. Lines whose rows haven't changed since the last call
+//   aren't searched again.
 // Arguments:
 // - The firstRow to start searching from
 // - The lastRow to search
 // Return value:
-// - An interval tree containing the patterns found
-PointTree TextBuffer::GetPatterns(const size_t firstRow, const size_t lastRow) const
+// - The patterns found, by the row they're on
+PatternSpans TextBuffer::GetPatterns(const size_t firstRow, const size_t lastRow) const
 {
     PointTree::interval_vector intervals;
+    if (_patternMatcher.empty())
+    {
+        return {};
+    }
+
+    std::unordered_map<size_t, PatternCacheEntry> nextCache;
+
+    const auto rowSize = GetRowByOffset(0).size();
+
+    auto lineStart = firstRow;
+    while (lineStart <= lastRow)
+    {
+        // gather the rows of this line along with their generations
+        auto lineEnd = lineStart;
+        std::vector<uint64_t> generations;
+        for (;; ++lineEnd)
+        {
+            const auto& row = GetRowByOffset(lineEnd);
+            generations.push_back(row.GetCharRow().GetGeneration());
+            if (lineEnd >= lastRow || !row.WasWrapForced())
+            {
+                break;
+            }
+        }
+
+        // Rows stay in their slot of _storage unless _RefreshRowIDs or ScrollRows
+        // is called (which drop the cache), so the ID of the first row identifies the line.
+        const auto key = GetRowByOffset(lineStart).GetId();
+        PatternCacheEntry entry;
+        const auto cached = _patternCache.find(key);
+        if (cached != _patternCache.end() && cached->second.generations == generations)
+        {
+            entry = std::move(cached->second);
+        }
+        else
+        {
+            entry.generations = std::move(generations);
+            entry.matches = _FindPatternsInLine(lineStart, lineEnd);
+        }
+
+        // NOTE: these intervals are relative to the VIEWPORT not the buffer
+        // Keeping these relative to the viewport for now because its the renderer
+        // that actually uses these locations and the renderer works relative to
+        // the viewport
+        const auto lineTop = lineStart - firstRow;
+        for (const auto& match : entry.matches)
+        {
+            // The matches lie within the lines of the buffer, so their coordinates fit its SHORT size.
+            const til::point startCoord{ gsl::narrow_cast<ptrdiff_t>(match.start % rowSize), gsl::narrow_cast<ptrdiff_t>(lineTop + match.start / rowSize) };
+            const til::point endCoord{ gsl::narrow_cast<ptrdiff_t>(match.end % rowSize), gsl::narrow_cast<ptrdiff_t>(lineTop + match.end / rowSize) };
+            intervals.push_back(PointTree::interval(startCoord, endCoord, match.id));
+        }
+
+        nextCache.emplace(key, std::move(entry));
+        lineStart = lineEnd + 1;
+    }
+
+    // Only keep the lines we looked at this time, so the cache doesn't grow with the scrollback.
+    _patternCache = std::move(nextCache);
+
+    return PatternSpans{ intervals };
+}
+
+// Method Description:
+// - Runs all the pattern recognizers over a single (wrapped) line
+// Arguments:
+// - The first and last row (inclusive) of the line
+// Return value:
+// - The matches, as cell offsets from the beginning of the line
+std::vector<TextBuffer::PatternMatch> TextBuffer::_FindPatternsInLine(const size_t firstRow, const size_t lastRow) const
+{
+    std::vector<PatternMatch> matches;
 
     std::wstring concatAll;
     const auto rowSize = GetRowByOffset(0).size();
@@ -2518,48 +4352,79 @@ PointTree TextBuffer::GetPatterns(const size_t firstRow, const size_t lastRow) c
         concatAll += row.GetText();
     }
 
-    // for each pattern we know of, iterate through the string
-    for (const auto& idAndPattern : _idsAndPatterns)
+    // all patterns are matched in a single pass, see PatternMatcher
+    const auto found = _patternMatcher.FindAll(concatAll);
+    if (found.empty())
     {
-        std::wregex regexObj{ idAndPattern.second };
+        return matches;
+    }
 
-        // search through the run with our regex object
-        auto words_begin = std::wsregex_iterator(concatAll.begin(), concatAll.end(), regexObj);
-        auto words_end = std::wsregex_iterator();
+    // the matches are in terms of characters, which we turn into cells
+    std::vector<uint8_t> widths(concatAll.size());
+    GetGlyphColumns(concatAll, widths);
 
-        size_t lenUpToThis = 0;
-        for (auto i = words_begin; i != words_end; ++i)
-        {
-            // record the locations -
-            // when we find a match, the prefix is text that is between this
-            // match and the previous match, so we use the size of the prefix
-            // along with the size of the match to determine the locations
-            size_t prefixSize = 0;
+    std::vector<size_t> columns;
+    columns.reserve(concatAll.size() + 1);
+    size_t column = 0;
+    for (const auto width : widths)
+    {
+        columns.push_back(column);
+        column += width;
+    }
+    columns.push_back(column);
 
-            for (const auto ch : i->prefix().str())
-            {
-                prefixSize += IsGlyphFullWidth(ch) ? 2 : 1;
-            }
-            const auto start = lenUpToThis + prefixSize;
-            size_t matchSize = 0;
-            for (const auto ch : i->str())
-            {
-                matchSize += IsGlyphFullWidth(ch) ? 2 : 1;
-            }
-            const auto end = start + matchSize;
-            lenUpToThis = end;
+    matches.reserve(found.size());
+    for (const auto& match : found)
+    {
+        matches.push_back({ columns.at(match.start), columns.at(match.end), match.id });
+    }
+    return matches;
+}
 
-            const til::point startCoord{ gsl::narrow<SHORT>(start % rowSize), gsl::narrow<SHORT>(start / rowSize) };
-            const til::point endCoord{ gsl::narrow<SHORT>(end % rowSize), gsl::narrow<SHORT>(end / rowSize) };
+// Method Description:
+// - Checks whether the search term could start anywhere near the given row
+// - The rows are checked in blocks, see SearchIndex. Blocks whose rows changed
+//   since they were last looked at are indexed again first.
+// Arguments:
+// - row - the row (as an offset from the first row) to check
+// - needle - the trigrams of the search term, see SearchIndex::s_HashNeedle.
+//   The search term may not be wider than a row.
+// - firstRow - receives the first row that shares the answer with the given row
+// - lastRow - receives the last row that shares the answer with the given row
+// Return value:
+// - False if none of the rows from firstRow to lastRow can contain the start of
+//   the search term. True if they might.
+bool TextBuffer::MayContainSearchText(const size_t row, const SearchIndex::Needle& needle, size_t& firstRow, size_t& lastRow) const
+{
+    const auto height = _storage.size();
+    const auto storageRow = (_firstRow + row) % height;
+    const auto block = storageRow / SearchIndex::BlockHeight;
+    const auto blockStart = block * SearchIndex::BlockHeight;
+    const auto blockEnd = std::min(blockStart + SearchIndex::BlockHeight, height);
+
+    // The block is contiguous within the storage, but the offsets of its rows wrap
+    // around if it contains the first row. Only report the part that contains row.
+    firstRow = row - std::min(storageRow - blockStart, row);
+    lastRow = row + std::min(blockEnd - 1 - storageRow, height - 1 - row);
+
+    // Look at the row after the block too, since a match may continue into it.
+    std::vector<uint64_t> generations;
+    generations.reserve(blockEnd - blockStart + 1);
+    for (auto i = blockStart; i <= blockEnd; ++i)
+    {
+        generations.push_back(_storage.at(i % height).GetCharRow().GetGeneration());
+    }
 
-            // store the intervals
-            // NOTE: these intervals are relative to the VIEWPORT not the buffer
-            // Keeping these relative to the viewport for now because its the renderer
-            // that actually uses these locations and the renderer works relative to
-            // the viewport
-            intervals.push_back(PointTree::interval(startCoord, endCoord, idAndPattern.first));
+    if (!_searchIndex.IsCurrent(block, generations))
+    {
+        std::vector<const ROW*> rows;
+        rows.reserve(generations.size());
+        for (auto i = blockStart; i <= blockEnd; ++i)
+        {
+            rows.push_back(&_storage.at(i % height));
         }
+        _searchIndex.Update(block, std::move(generations), rows);
     }
-    PointTree result(std::move(intervals));
-    return result;
+
+    return _searchIndex.MayContain(block, needle);
 }
@@ -22,9 +22,10 @@ ScreenBuffer data structure overview:
 
 each screen buffer has an array of ROW structures.  each ROW structure
 contains the data for one row of text.  the data stored for one row of
-text is a character array and an attribute array.  the character array
-is allocated the full length of the row from the heap, regardless of the
-non-space length. we also maintain the non-space length.  the character
+text is a character array and an attribute array.  the character arrays
+of all rows are carved out of a single contiguous allocation owned by the
+text buffer (one fixed-stride slot per row), regardless of the non-space
+length. we also maintain the non-space length.  the character
 array is initialized to spaces.  the attribute
 array is run length encoded (i.e 5 BLUE, 3 RED). if there is only one
 attribute for the whole row (the normal case), it is stored in the ATTR_ROW
@@ -51,9 +52,19 @@ filling in the last row, and updating the screen.
 
 #include <vector>
 
+#include "CellArena.hpp"
 #include "cursor.h"
+#include "HyperlinkTable.hpp"
+#include "ImageStore.hpp"
+#include "PatternMatcher.hpp"
+#include "PatternSpans.hpp"
+#include "PromptMarks.hpp"
+#include "RichTextWriter.hpp"
 #include "Row.hpp"
+#include "ScrollbackArchive.hpp"
+#include "SearchIndex.hpp"
 #include "TextAttribute.hpp"
+#include "TextBufferSnapshot.hpp"
 #include "UnicodeStorage.hpp"
 #include "../types/inc/Viewport.hpp"
 
@@ -78,6 +89,15 @@ public:
     const ROW& GetRowByOffset(const size_t index) const;
     ROW& GetRowByOffset(const size_t index);
 
+    uint64_t GetGeneration() const noexcept;
+    uint64_t GetRowGeneration(const size_t row) const;
+    BufferMemoryUsage GetMemoryUsage() const noexcept;
+    void Trim() noexcept;
+    std::vector<size_t> GetRowsChangedSince(const uint64_t generation, const size_t firstRow, const size_t lastRow) const;
+    std::shared_ptr<const TextBufferSnapshot> TakeSnapshot(const SHORT firstRow,
+                                                           const SHORT height,
+                                                           std::shared_ptr<const TextBufferSnapshot> previous) const;
+
     TextBufferCellIterator GetCellDataAt(const COORD at) const;
     TextBufferCellIterator GetCellLineDataAt(const COORD at) const;
     TextBufferCellIterator GetCellDataAt(const COORD at, const Microsoft::Console::Types::Viewport limit) const;
@@ -97,6 +117,9 @@ public:
                                  const std::optional<bool> setWrap = std::nullopt,
                                  const std::optional<size_t> limitRight = std::nullopt);
 
+    void ReadCharInfos(const COORD target, const gsl::span<CHAR_INFO> cells) const;
+    void WriteCharInfos(const COORD target, const gsl::span<const CHAR_INFO> cells);
+
     bool InsertCharacter(const wchar_t wch, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool InsertCharacter(const std::wstring_view chars, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool IncrementCursor();
@@ -105,12 +128,34 @@ public:
     // Scroll needs access to this to quickly rotate around the buffer.
     bool IncrementCircularBuffer(const bool inVtMode = false);
 
+    void SetHotRowCount(const size_t hotRowCount) noexcept;
+    void ShareColdRows(const bool share);
+    void CompactScrollback(const size_t hotRowCount) noexcept;
+    void PackColdRows() noexcept;
+
+    void AddPromptMark(const PromptMarkKind kind);
+    std::optional<short> FindPromptMarkBefore(const short row, const PromptMarkKind kind) const;
+    std::optional<short> FindPromptMarkAfter(const short row, const PromptMarkKind kind) const;
+    const PromptMarks& GetPromptMarks() const noexcept;
+    void AddImage(std::shared_ptr<const ImageStore::Image> image);
+    const ImageStore& GetImages() const noexcept;
+    uint64_t GetCircledRows() const noexcept;
+
+    void EnableScrollbackArchive(const uint64_t maximumSize = ScrollbackArchive::DefaultMaximumSize);
+    void TakeScrollbackArchive(TextBuffer& OtherBuffer) noexcept;
+    const ScrollbackArchive* GetScrollbackArchive() const noexcept;
+    void ClearScrollbackArchive() noexcept;
+    size_t GetArchivedRowCount() const noexcept;
+    size_t GetPagedInRowCount() const noexcept;
+    size_t PageInArchivedRows(const size_t count);
+    size_t PageOutRows(const size_t count);
+
     COORD GetLastNonSpaceCharacter(std::optional<const Microsoft::Console::Types::Viewport> viewOptional = std::nullopt) const;
 
     Cursor& GetCursor() noexcept;
     const Cursor& GetCursor() const noexcept;
 
-    const SHORT GetFirstRowIndex() const noexcept;
+    size_t GetFirstRowIndex() const noexcept;
 
     const Microsoft::Console::Types::Viewport GetSize() const noexcept;
 
@@ -133,14 +178,18 @@ public:
     COORD BufferToScreenPosition(const COORD position) const;
 
     void Reset();
+    void Recycle(const TextAttribute defaultAttributes,
+                 const UINT cursorSize,
+                 Microsoft::Console::Render::IRenderTarget& renderTarget);
+    bool EraseRows(const size_t startRow, const size_t endRow, const TextAttribute fillAttributes);
 
     [[nodiscard]] HRESULT ResizeTraditional(const COORD newSize) noexcept;
 
-    const UnicodeStorage& GetUnicodeStorage() const noexcept;
-    UnicodeStorage& GetUnicodeStorage() noexcept;
-
     Microsoft::Console::Render::IRenderTarget& GetRenderTarget() noexcept;
 
+    void StartDeferDrawing() noexcept;
+    void EndDeferDrawing() noexcept;
+
     const COORD GetWordStart(const COORD target, const std::wstring_view wordDelimiters, bool accessibilityMode = false) const;
     const COORD GetWordEnd(const COORD target, const std::wstring_view wordDelimiters, bool accessibilityMode = false) const;
     bool MoveToNextWord(COORD& pos, const std::wstring_view wordDelimiters, COORD lastCharPos) const;
@@ -174,6 +223,53 @@ public:
                                std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)> GetAttributeColors = nullptr,
                                const bool formatWrappedRows = false) const;
 
+    std::wstring_view GetRowText(const SHORT row, const SHORT left, const SHORT right) const;
+
+    struct RichTextFormats
+    {
+        bool html{ false };
+        bool rtf{ false };
+        int fontHeightPoints{ 0 };
+        std::wstring_view fontFaceName;
+        COLORREF backgroundColor{ 0 };
+        std::function<std::pair<COLORREF, COLORREF>(const TextAttribute&)> GetAttributeColors;
+    };
+
+    // The colors of a selection, taken while the buffer is locked, so
+    // that HTML and RTF can be generated later on, once they're asked for.
+    struct RichText
+    {
+        struct Run
+        {
+            size_t end; // where the run ends in the text
+            COLORREF foreground;
+            COLORREF background;
+        };
+
+        std::wstring text; // the rows back to back, without line breaks
+        std::vector<Run> runs;
+        std::vector<size_t> rowStarts; // the index of the first run of each row
+        int fontHeightPoints{ 0 };
+        std::wstring fontFaceName;
+        COLORREF backgroundColor{ 0 };
+
+        bool empty() const noexcept { return rowStarts.empty(); }
+        std::string GenHTML() const;
+        std::string GenRTF() const;
+    };
+
+    struct ExportedText
+    {
+        std::wstring text;
+        RichText richText; // empty unless requested by RichTextFormats::html or ::rtf
+    };
+
+    ExportedText ExportText(const bool includeCRLF,
+                            const bool trimTrailingWhitespace,
+                            const std::vector<SMALL_RECT>& selectionRects,
+                            const RichTextFormats& richText = {},
+                            const bool formatWrappedRows = false) const;
+
     static std::string GenHTML(const TextAndColor& rows,
                                const int fontHeightPoints,
                                const std::wstring_view fontFaceName,
@@ -194,34 +290,61 @@ public:
                           TextBuffer& newBuffer,
                           const std::optional<Microsoft::Console::Types::Viewport> lastCharacterViewport,
                           std::optional<std::reference_wrapper<PositionInformation>> positionInfo);
+    static HRESULT ReflowDeferred(TextBuffer& oldBuffer,
+                                  TextBuffer& newBuffer,
+                                  const short firstNeededRow,
+                                  const std::optional<Microsoft::Console::Types::Viewport> lastCharacterViewport,
+                                  std::optional<std::reference_wrapper<PositionInformation>> positionInfo);
+    static HRESULT FinishReflow(const TextBuffer& buffer,
+                                TextBuffer& newBuffer,
+                                std::optional<std::reference_wrapper<PositionInformation>> positionInfo);
+
+    bool HasPendingReflow() const noexcept;
+    short GetPendingReflowRowCount() const noexcept;
+    void AdoptPendingReflowSource(std::unique_ptr<TextBuffer> source) noexcept;
+    void DiscardPendingReflow() noexcept;
 
     const size_t AddPatternRecognizer(const std::wstring_view regexString);
     void ClearPatternRecognizers() noexcept;
     void CopyPatterns(const TextBuffer& OtherBuffer);
-    interval_tree::IntervalTree<til::point, size_t> GetPatterns(const size_t firstRow, const size_t lastRow) const;
+    PatternSpans GetPatterns(const size_t firstRow, const size_t lastRow) const;
+
+    bool MayContainSearchText(const size_t row, const SearchIndex::Needle& needle, size_t& firstRow, size_t& lastRow) const;
 
 private:
     void _UpdateSize();
     Microsoft::Console::Types::Viewport _size;
+    // the glyph cells of every row, in one contiguous allocation with a stride of the buffer width
+    CellArena _charBuffer;
+    // the attributes used by the rows, which only store their IDs
+    AttributeTable _attributes;
+    ModificationClock _clock;
     std::vector<ROW> _storage;
     Cursor _cursor;
 
-    SHORT _firstRow; // indexes top row (not necessarily 0)
+    // indexes top row (not necessarily 0). It's a size_t only to spare the sign extension on every
+    // lookup: the height of the buffer is still bounded by the SHORTs of _size, so are the row IDs.
+    size_t _firstRow;
 
     TextAttribute _currentAttributes;
 
-    // storage location for glyphs that can't fit into the buffer normally
-    UnicodeStorage _unicodeStorage;
-
-    std::unordered_map<uint16_t, std::wstring> _hyperlinkMap;
-    std::unordered_map<std::wstring, uint16_t> _hyperlinkCustomIdMap;
-    uint16_t _currentHyperlinkId;
+    HyperlinkTable _hyperlinks;
+    // The hyperlinks each row of _storage referred to when they were last counted,
+    // along with the generation of the row's attributes at the time.
+    struct RowHyperlinks
+    {
+        uint64_t generation{ std::numeric_limits<uint64_t>::max() };
+        std::vector<uint16_t> ids;
+    };
+    std::vector<RowHyperlinks> _rowHyperlinks;
+    uint64_t _hyperlinksCountedAt;
 
-    void _RefreshRowIDs(std::optional<SHORT> newRowWidth);
+    void _RefreshRowIDs() noexcept;
+    void _ReverseRows(size_t begin, size_t end);
 
-    Microsoft::Console::Render::IRenderTarget& _renderTarget;
+    Microsoft::Console::Render::IRenderTarget* _renderTarget;
 
-    void _SetFirstRowIndex(const SHORT FirstRowIndex) noexcept;
+    void _SetFirstRowIndex(const size_t FirstRowIndex) noexcept;
 
     COORD _GetPreviousFromCursor() const;
 
@@ -229,29 +352,183 @@ private:
     void _AdjustWrapOnCurrentRow(const bool fSet);
 
     void _NotifyPaint(const Microsoft::Console::Types::Viewport& viewport) const;
+    void _FlushDeferredPaint() const;
+
+    // The regions to redraw that were collected between StartDeferDrawing and
+    // EndDeferDrawing: the columns [first, second) of each of the rows [top, bottom).
+    size_t _deferDrawing{ 0 };
+    mutable std::vector<std::pair<SHORT, SHORT>> _deferredColumns;
+    mutable SHORT _deferredTop{ 0 };
+    mutable SHORT _deferredBottom{ 0 };
 
     // Assist with maintaining proper buffer state for Double Byte character sequences
     bool _PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute);
     bool _AssertValidDoubleByteSequence(const DbcsAttribute dbcsAttribute);
 
+    ROW& _GetRow(const size_t index);
     ROW& _GetFirstRow();
     ROW& _GetPrevRowNoWrap(const ROW& row);
 
     void _ExpandTextRow(SMALL_RECT& selectionRow) const;
 
     const DelimiterClass _GetDelimiterClassAt(const COORD pos, const std::wstring_view wordDelimiters) const;
+    bool _FindDelimiterClassForward(COORD& pos, const DelimiterClass delimiterClass, const bool match, const std::wstring_view wordDelimiters) const;
+    bool _FindDelimiterClassBackward(COORD& pos, const DelimiterClass delimiterClass, const bool match, const std::wstring_view wordDelimiters) const;
+
+    // The delimiter classes of a row as bitmaps over its columns, with one bit per
+    // column in each. Columns which are in neither bitmap are ControlChars.
+    struct DelimiterClasses
+    {
+        uint64_t generation{ std::numeric_limits<uint64_t>::max() };
+        std::vector<uint32_t> regular;
+        std::vector<uint32_t> delimiter;
+
+        uint32_t Mask(const size_t word, const DelimiterClass delimiterClass, const bool match) const noexcept;
+        size_t FindForward(const size_t first, const size_t last, const DelimiterClass delimiterClass, const bool match) const noexcept;
+        size_t FindBackward(const size_t first, const DelimiterClass delimiterClass, const bool match) const noexcept;
+    };
+    std::shared_ptr<const DelimiterClasses> _GetDelimiterClasses(const SHORT row, const std::wstring_view wordDelimiters) const;
+    // Built on demand for each row of _storage, for the word delimiters in _delimiterClassesFor.
+    // A row's bitmaps are built again once the generation of its text changed. Readers holding
+    // the lock shared build them at the same time, so they're guarded by _delimiterClassesLock
+    // and handed out as immutable copies that stay valid after another reader replaced them.
+    mutable std::mutex _delimiterClassesLock;
+    mutable std::vector<std::shared_ptr<const DelimiterClasses>> _delimiterClasses;
+    mutable std::wstring _delimiterClassesFor;
+    mutable std::bitset<128> _asciiDelimiters;
+
+    // The text of a row the way GetText retrieves it, without the trailing halves of wide glyphs.
+    struct RowText
+    {
+        uint64_t generation{ std::numeric_limits<uint64_t>::max() };
+        std::wstring text;
+        // The offset into text of the glyph in every column, and of the end of the row.
+        // Empty while every column holds a single wchar_t, so that the offset is the column.
+        std::vector<uint32_t> offsets;
+    };
+    const RowText& _GetRowText(const SHORT row) const;
+    // Built on demand for each row of _storage, like _delimiterClasses, see GetRowText.
+    // Readers holding the lock shared gather texts at the same time, so they're guarded by
+    // _rowTextsLock. A text is only gathered again once its row changed, which takes the
+    // exclusive lock, so the texts handed out stay valid until the buffer is changed.
+    mutable std::mutex _rowTextsLock;
+    mutable std::vector<RowText> _rowTexts;
     const COORD _GetWordStartForAccessibility(const COORD target, const std::wstring_view wordDelimiters) const;
     const COORD _GetWordStartForSelection(const COORD target, const std::wstring_view wordDelimiters) const;
     const COORD _GetWordEndForAccessibility(const COORD target, const std::wstring_view wordDelimiters, const COORD lastCharPos) const;
     const COORD _GetWordEndForSelection(const COORD target, const std::wstring_view wordDelimiters) const;
 
     void _PruneHyperlinks();
+    void _CountHyperlinkReferences();
+    void _ReleaseHyperlinkReference(const uint16_t id) noexcept;
 
-    std::unordered_map<size_t, std::wstring> _idsAndPatterns;
+    PatternMatcher _patternMatcher;
     size_t _currentPatternId;
 
+    // The matches of a single (wrapped) line, as cell offsets from the start of the line.
+    struct PatternMatch
+    {
+        size_t start;
+        size_t end;
+        size_t id;
+    };
+    struct PatternCacheEntry
+    {
+        std::vector<uint64_t> generations;
+        std::vector<PatternMatch> matches;
+    };
+    // Keyed by the row ID of the first row of the line, see GetPatterns.
+    mutable std::unordered_map<size_t, PatternCacheEntry> _patternCache;
+
+    // The last result of GetLastNonSpaceCharacter, which a caller like the UIA provider
+    // asks for over and over while nothing was written. Readers holding the lock shared
+    // (like UIA and the export of the buffer) ask at the same time, see _lastNonSpaceLock.
+    struct LastNonSpace
+    {
+        uint64_t generation{ std::numeric_limits<uint64_t>::max() };
+        size_t firstRow{ 0 };
+        SMALL_RECT viewport{};
+        COORD position{};
+    };
+    mutable LastNonSpace _lastNonSpace;
+    mutable std::mutex _lastNonSpaceLock;
+
+    // Lets Search skip rows which can't contain the search term, see MayContainSearchText.
+    mutable SearchIndex _searchIndex;
+    std::vector<PatternMatch> _FindPatternsInLine(const size_t firstRow, const size_t lastRow) const;
+
+    // Cold storage for scrollback, see SetHotRowCount.
+    // Packing happens in batches, every s_CompactionInterval calls to IncrementCircularBuffer.
+    static constexpr size_t s_CompactionInterval = 256;
+    void _PackColdRows() noexcept;
+    void _CompactAttributes();
+    size_t _hotRowCount;
+    size_t _circlesSinceCompaction;
+    // Lets packed rows with the same cells share them, see ShareColdRows.
+    std::unique_ptr<PackedRowStore> _packedRowStore;
+
+    // Tells snapshots of different buffers apart, as the generations of each buffer start at 0.
+    static std::atomic<uint64_t> s_nextSnapshotEpoch;
+    uint64_t _snapshotEpoch;
+
+    // Rows that scrolled off the top of the buffer, see EnableScrollbackArchive.
+    std::unique_ptr<ScrollbackArchive> _scrollbackArchive;
+    // The rows the buffer grew by to hold rows of the archive, see PageInArchivedRows.
+    size_t _pagedInRows;
+    void _MoveRowsInto(const CellArena& arena, std::vector<ROW>& storage, const size_t firstRow, const size_t endRow);
+
+    // The shell integration marks, by the number of rows that scrolled off the
+    // top of the buffer before theirs, plus its offset. See AddPromptMark.
+    PromptMarks _promptMarks;
+    // The sixel images, kept by their rows the same way as the marks. See AddImage.
+    ImageStore _images;
+    uint64_t _circledRows;
+    std::optional<short> _FromMarkRow(const uint64_t row) const noexcept;
+    void _ReflowPromptMarks(const TextBuffer& oldBuffer);
+
+    // Reflow splits buffers with at least twice this many rows across the thread pool.
+    static constexpr size_t s_MinReflowRowsPerTask = 512;
+    static HRESULT _Reflow(TextBuffer& oldBuffer,
+                           TextBuffer& newBuffer,
+                           const std::optional<Microsoft::Console::Types::Viewport> lastCharacterViewport,
+                           std::optional<std::reference_wrapper<PositionInformation>> positionInfo,
+                           const bool allowParallel,
+                           const short firstNeededRow);
+    static HRESULT _ReflowRows(const TextBuffer& oldBuffer,
+                               TextBuffer& newBuffer,
+                               const short firstRow,
+                               const short endRow,
+                               const short oldRowsTotal,
+                               const COORD oldCursorPos,
+                               std::optional<COORD>& newCursorPos,
+                               gsl::span<short> rowEnds);
+    static HRESULT _ReflowRowsInParallel(TextBuffer& oldBuffer,
+                                         TextBuffer& newBuffer,
+                                         const short oldRowsTotal,
+                                         const COORD oldCursorPos,
+                                         std::optional<COORD>& newCursorPos,
+                                         gsl::span<short> rowEnds);
+    static short _GetReflowRight(const ROW& row, const short width);
+    static bool _IsReflowLineEnd(const TextBuffer& buffer, const short row);
+
+    // Rows at the top of the buffer that haven't been reflowed yet, see ReflowDeferred.
+    // Rows [0, endRow - firstRow) of this buffer are placeholders: truncated copies
+    // of the rows [firstRow, endRow) of the source, which still has the old width.
+    struct PendingReflow
+    {
+        std::unique_ptr<TextBuffer> source;
+        short firstRow;
+        short endRow;
+    };
+    std::optional<PendingReflow> _pendingReflow;
+
+    // Saves and restores the hyperlinks along with their custom IDs.
+    friend class TextBufferFile;
+
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     friend class UiaTextRangeTests;
+    friend class ReflowTests;
+    friend class AttributeTableTests;
 #endif
 };
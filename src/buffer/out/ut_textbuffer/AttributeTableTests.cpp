@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../textBuffer.hpp"
+#include "../../renderer/inc/DummyRenderTarget.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class AttributeTableTests
+{
+    TEST_CLASS(AttributeTableTests);
+
+    TEST_METHOD(InternsEqualAttributesOnce)
+    {
+        AttributeTable table;
+        const TextAttribute red{ RGB(255, 0, 0), RGB(0, 0, 0) };
+        const TextAttribute blue{ RGB(0, 0, 255), RGB(0, 0, 0) };
+
+        const auto redId = table.Intern(red);
+        const auto blueId = table.Intern(blue);
+        VERIFY_ARE_NOT_EQUAL(redId, blueId);
+        VERIFY_ARE_EQUAL(redId, table.Intern(TextAttribute{ RGB(255, 0, 0), RGB(0, 0, 0) }));
+        VERIFY_ARE_EQUAL(2u, table.size());
+
+        VERIFY_ARE_EQUAL(red, table.Get(redId));
+        VERIFY_ARE_EQUAL(blue, table.Get(blueId));
+        VERIFY_ARE_EQUAL(blueId, table.Find(blue).value());
+        VERIFY_IS_FALSE(table.Find(TextAttribute{ 0x7 }).has_value());
+    }
+
+    TEST_METHOD(CompactDropsUnusedAttributes)
+    {
+        AttributeTable table;
+        const TextAttribute first{ 0x1 };
+        const TextAttribute second{ 0x2 };
+        const TextAttribute third{ 0x3 };
+        const auto firstId = table.Intern(first);
+        table.Intern(second);
+        const auto thirdId = table.Intern(third);
+
+        const auto newIds = table.Compact({ true, false, true });
+        VERIFY_ARE_EQUAL(2u, table.size());
+        VERIFY_ARE_EQUAL(first, table.Get(newIds.at(firstId)));
+        VERIFY_ARE_EQUAL(third, table.Get(newIds.at(thirdId)));
+        VERIFY_IS_FALSE(table.Find(second).has_value());
+        VERIFY_ARE_EQUAL(newIds.at(thirdId), table.Intern(third));
+    }
+
+    TEST_METHOD(CopiesRowsBetweenTables)
+    {
+        AttributeTable source;
+        AttributeTable target;
+        ModificationClock clock;
+        const TextAttribute green{ RGB(0, 255, 0), RGB(0, 0, 0) };
+
+        ATTR_ROW sourceRow{ 10, TextAttribute{ 0x7 }, source, clock };
+        sourceRow.Replace(2, 5, green);
+
+        // Give the tables different IDs for the same attributes.
+        target.Intern(TextAttribute{ 0x4 });
+        ATTR_ROW targetRow{ 10, TextAttribute{ 0x4 }, target, clock };
+        targetRow.CopyFrom(sourceRow);
+
+        VERIFY_IS_TRUE(sourceRow == targetRow);
+        VERIFY_ARE_EQUAL(green, targetRow.GetAttrByColumn(3));
+        VERIFY_ARE_EQUAL(TextAttribute{ 0x7 }, targetRow.GetAttrByColumn(5));
+        VERIFY_IS_TRUE(target.Find(green).has_value());
+    }
+
+    TEST_METHOD(RowsTrackBlinking)
+    {
+        AttributeTable table;
+        ModificationClock clock;
+        TextAttribute blinking{ 0x7 };
+        blinking.SetBlinking(true);
+
+        ATTR_ROW row{ 10, TextAttribute{ 0x7 }, table, clock };
+        VERIFY_IS_FALSE(row.HasBlinking());
+
+        row.Replace(2, 5, blinking);
+        row.Replace(8, 9, blinking);
+        VERIFY_IS_TRUE(row.HasBlinking());
+
+        Log::Comment(L"The row blinks until the last of its blinking runs is overwritten.");
+        row.Replace(2, 5, TextAttribute{ 0x4 });
+        VERIFY_IS_TRUE(row.HasBlinking());
+        row.Resize(8);
+        VERIFY_IS_FALSE(row.HasBlinking());
+
+        row.SetAttrToEnd(6, blinking);
+        VERIFY_IS_TRUE(row.HasBlinking());
+        row.ReplaceAttrs(blinking, TextAttribute{ 0x7 });
+        VERIFY_IS_FALSE(row.HasBlinking());
+    }
+
+    TEST_METHOD(BufferCompactsTableWhileWriting)
+    {
+        DummyRenderTarget renderTarget;
+        TextBuffer buffer{ { 80, 10 }, TextAttribute{ 0x7 }, 0, renderTarget };
+
+        Log::Comment(L"Overwrite the same cells with thousands of different colors.");
+        TextAttribute last;
+        for (int i = 0; i < 20000; ++i)
+        {
+            last = TextAttribute{ RGB(i & 0xff, (i >> 8) & 0xff, 0), RGB(0, 0, 0) };
+            buffer.Write(OutputCellIterator{ L"x", last }, { gsl::narrow_cast<SHORT>(i % 40), 3 });
+        }
+
+        VERIFY_IS_LESS_THAN(buffer._attributes.size(), size_t{ 10000 });
+        VERIFY_ARE_EQUAL(last, buffer.GetRowByOffset(3).GetAttrRow().GetAttrByColumn(gsl::narrow_cast<uint16_t>(19999 % 40)));
+        VERIFY_ARE_EQUAL(TextAttribute{ 0x7 }, buffer.GetRowByOffset(3).GetAttrRow().GetAttrByColumn(79));
+        VERIFY_ARE_EQUAL(TextAttribute{ 0x7 }, buffer.GetRowByOffset(9).GetAttrRow().GetAttrByColumn(0));
+    }
+};
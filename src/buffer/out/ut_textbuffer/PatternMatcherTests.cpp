@@ -0,0 +1,127 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../PatternMatcher.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class PatternMatcherTests
+{
+    TEST_CLASS(PatternMatcherTests);
+
+    TEST_METHOD(FindsLinks);
+    TEST_METHOD(FindsAllPatternsInOnePass);
+    TEST_METHOD(PrefersLeftmostLongest);
+    TEST_METHOD(RejectsUnsupportedSyntax);
+    TEST_METHOD(IgnoresCase);
+
+    static std::vector<std::wstring_view> _MatchedText(const std::vector<PatternMatcher::Match>& matches, const std::wstring_view text)
+    {
+        std::vector<std::wstring_view> result;
+        for (const auto& match : matches)
+        {
+            result.push_back(text.substr(match.start, match.end - match.start));
+        }
+        return result;
+    }
+};
+
+void PatternMatcherTests::FindsLinks()
+{
+    PatternMatcher matcher;
+    matcher.AddPattern(1, LR"(\b(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|$!:,.;]*[A-Za-z0-9+&@#/%=~_|$])");
+
+    const std::wstring_view text{ L"see https://example.com/a?b=1. or ftp://host, not xhttp://nope" };
+    const auto matches = matcher.FindAll(text);
+    const auto matched = _MatchedText(matches, text);
+
+    VERIFY_ARE_EQUAL(2u, matched.size());
+    VERIFY_ARE_EQUAL(L"https://example.com/a?b=1", matched.at(0));
+    VERIFY_ARE_EQUAL(L"ftp://host", matched.at(1));
+    VERIFY_ARE_EQUAL(1u, matches.at(0).id);
+}
+
+void PatternMatcherTests::FindsAllPatternsInOnePass()
+{
+    PatternMatcher matcher;
+    matcher.AddPattern(1, LR"(\b[0-9a-f]{7,40}\b)");
+    matcher.AddPattern(2, LR"(\b[A-Z]+-\d+\b)");
+    matcher.AddPattern(3, LR"([\w.]+:\d+)");
+
+    const std::wstring_view text{ L"commit deadbeef fixes TASK-42 in main.cpp:123" };
+    const auto matches = matcher.FindAll(text);
+    const auto matched = _MatchedText(matches, text);
+
+    Log::Comment(L"Matches are sorted by their start, regardless of which pattern found them.");
+    VERIFY_ARE_EQUAL(3u, matched.size());
+    VERIFY_ARE_EQUAL(L"deadbeef", matched.at(0));
+    VERIFY_ARE_EQUAL(1u, matches.at(0).id);
+    VERIFY_ARE_EQUAL(L"TASK-42", matched.at(1));
+    VERIFY_ARE_EQUAL(2u, matches.at(1).id);
+    VERIFY_ARE_EQUAL(L"main.cpp:123", matched.at(2));
+    VERIFY_ARE_EQUAL(3u, matches.at(2).id);
+
+    VERIFY_IS_TRUE(matcher.FindAll(L"nothing to see here").empty());
+}
+
+void PatternMatcherTests::PrefersLeftmostLongest()
+{
+    PatternMatcher matcher;
+    matcher.AddPattern(1, L"ab*c|b");
+
+    const std::wstring_view text{ L"abbc b" };
+    const auto matched = _MatchedText(matcher.FindAll(text), text);
+
+    Log::Comment(L"The match starting first wins, even though \"b\" ends first.");
+    VERIFY_ARE_EQUAL(2u, matched.size());
+    VERIFY_ARE_EQUAL(L"abbc", matched.at(0));
+    VERIFY_ARE_EQUAL(L"b", matched.at(1));
+
+    Log::Comment(L"Empty matches aren't reported.");
+    matcher.Clear();
+    matcher.AddPattern(1, L"a*");
+    VERIFY_ARE_EQUAL(1u, matcher.FindAll(L"baab").size());
+}
+
+void PatternMatcherTests::RejectsUnsupportedSyntax()
+{
+    PatternMatcher matcher;
+    matcher.AddPattern(1, L"a+");
+
+    for (const auto pattern : { L"(a", L"a)", L"a*?", L"^a", L"a$", L"(?=a)", L"\\1", L"a{2,1}", L"[b-a]" })
+    {
+        Log::Comment(NoThrowString().Format(L"Pattern: %s", pattern));
+        VERIFY_THROWS_SPECIFIC(matcher.AddPattern(2, pattern), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+    }
+
+    Log::Comment(L"A rejected pattern shouldn't affect the ones added before.");
+    VERIFY_ARE_EQUAL(1u, matcher.FindAll(L"xaax").size());
+}
+
+void PatternMatcherTests::IgnoresCase()
+{
+    PatternMatcher matcher;
+    matcher.AddPattern(1, L"err[a-z]r|\\u00e9t\\u00e9", true);
+
+    const std::wstring_view text{ L"ERROR, Error, error, \u00c9T\u00c9" };
+    const auto matched = _MatchedText(matcher.FindAll(text), text);
+    VERIFY_ARE_EQUAL(4u, matched.size());
+    VERIFY_ARE_EQUAL(L"ERROR", matched.at(0));
+    VERIFY_ARE_EQUAL(L"\u00c9T\u00c9", matched.at(3));
+
+    Log::Comment(L"The case is folded before a class is negated.");
+    matcher.Clear();
+    matcher.AddPattern(1, L"[^e]+", true);
+    VERIFY_ARE_EQUAL(2u, matcher.FindAll(L"abEcd").size());
+
+    Log::Comment(L"Without it, the case has to match.");
+    matcher.Clear();
+    matcher.AddPattern(1, L"error");
+    VERIFY_ARE_EQUAL(1u, matcher.FindAll(text).size());
+}
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../PatternSpans.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class PatternSpansTests
+{
+    TEST_CLASS(PatternSpansTests);
+
+    TEST_METHOD(FindsMatchesAtPosition);
+    TEST_METHOD(ReportsWrappedMatchesOnce);
+    TEST_METHOD(ShiftsWithTheText);
+};
+
+void PatternSpansTests::FindsMatchesAtPosition()
+{
+    const PatternSpans spans{ {
+        { til::point{ 2, 1 }, til::point{ 6, 1 }, 1 },
+        { til::point{ 10, 1 }, til::point{ 20, 1 }, 2 },
+        { til::point{ 0, 3 }, til::point{ 4, 3 }, 3 },
+    } };
+
+    VERIFY_ARE_EQUAL(4u, spans.RowCount());
+    VERIFY_ARE_EQUAL(2u, spans.GetRow(1).size());
+    VERIFY_ARE_EQUAL(0u, spans.GetRow(2).size());
+
+    Log::Comment(L"A position is looked up the way the terminal asks the interval tree.");
+    const auto at = [&](const til::point position) {
+        return spans.findOverlapping(til::point{ position.x() + 1, position.y() }, position);
+    };
+    VERIFY_ARE_EQUAL(1u, at({ 3, 1 }).size());
+    VERIFY_ARE_EQUAL(1u, at({ 3, 1 }).at(0).value);
+    VERIFY_ARE_EQUAL(2u, at({ 15, 1 }).at(0).value);
+    VERIFY_ARE_EQUAL(0u, at({ 8, 1 }).size());
+    VERIFY_ARE_EQUAL(3u, at({ 0, 3 }).at(0).value);
+    VERIFY_ARE_EQUAL(0u, at({ 0, 7 }).size());
+}
+
+void PatternSpansTests::ReportsWrappedMatchesOnce()
+{
+    const PatternSpans spans{ {
+        { til::point{ 70, 0 }, til::point{ 10, 2 }, 1 },
+    } };
+
+    VERIFY_ARE_EQUAL(1u, spans.GetRow(1).size());
+    VERIFY_ARE_EQUAL(1u, spans.findOverlapping(til::point{ 0, 0 }, til::point{ 79, 2 }).size());
+    VERIFY_ARE_EQUAL(1u, spans.findOverlapping(til::point{ 5, 1 }, til::point{ 4, 1 }).size());
+
+    size_t visited = 0;
+    spans.visit_all([&](const auto&) { ++visited; });
+    VERIFY_ARE_EQUAL(1u, visited);
+}
+
+void PatternSpansTests::ShiftsWithTheText()
+{
+    PatternSpans spans{ {
+        { til::point{ 0, 0 }, til::point{ 4, 0 }, 1 },
+        { til::point{ 70, 1 }, til::point{ 10, 2 }, 2 },
+        { til::point{ 0, 4 }, til::point{ 4, 4 }, 3 },
+    } };
+
+    Log::Comment(L"Scrolling up drops the rows that left the region, but not the rest of a match on them.");
+    spans.Shift(2, 5);
+    VERIFY_ARE_EQUAL(3u, spans.RowCount());
+    const auto wrapped = spans.GetRow(0);
+    VERIFY_ARE_EQUAL(1u, wrapped.size());
+    VERIFY_ARE_EQUAL(til::point(70, -1), wrapped[0].start);
+    VERIFY_ARE_EQUAL(til::point(10, 0), wrapped[0].stop);
+    VERIFY_ARE_EQUAL(3u, spans.GetRow(2)[0].value);
+
+    Log::Comment(L"Scrolling down moves the matches down and drops those below the region.");
+    spans.Shift(-3, 5);
+    VERIFY_ARE_EQUAL(4u, spans.RowCount());
+    VERIFY_ARE_EQUAL(0u, spans.GetRow(1).size());
+    VERIFY_ARE_EQUAL(2u, spans.GetRow(2)[0].value);
+    VERIFY_ARE_EQUAL(2u, spans.GetRow(3)[0].value);
+    VERIFY_ARE_EQUAL(til::point(70, 2), spans.GetRow(3)[0].start);
+}
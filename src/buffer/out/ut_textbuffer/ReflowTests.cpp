@@ -851,6 +851,110 @@ class ReflowTests
             _compareTextBufferAgainstTestBuffer(*textBuffer, testBuffer);
         }
     }
+
+    TEST_METHOD(ParallelReflowMatchesSerialReflow)
+    {
+        WEX::TestExecution::DisableVerifyExceptions disableVerifyExceptions{};
+        WEX::TestExecution::SetVerifyOutput verifyOutputScope{ WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures };
+
+        Log::Comment(L"Fill a buffer that's large enough to be reflowed in parallel, with lines of all lengths, "
+                     L"wide glyphs, double width rows and colors.");
+        const auto oldBuffer = _CreateLargeBuffer();
+
+        for (const auto newSize : { COORD{ 37, 3000 }, COORD{ 200, 4500 } })
+        {
+            Log::Comment(NoThrowString().Format(L"Resizing to %dx%d", newSize.X, newSize.Y));
+
+            TextBuffer::PositionInformation expectedPositions{ 1200, 3990 };
+            auto expected = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, target);
+            VERIFY_SUCCEEDED(TextBuffer::_Reflow(*oldBuffer, *expected, std::nullopt, expectedPositions, false, 0));
+
+            TextBuffer::PositionInformation actualPositions{ 1200, 3990 };
+            auto actual = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, target);
+            VERIFY_SUCCEEDED(TextBuffer::_Reflow(*oldBuffer, *actual, std::nullopt, actualPositions, true, 0));
+
+            _VerifyBuffersMatch(*expected, expectedPositions, *actual, actualPositions);
+        }
+    }
+
+    TEST_METHOD(DeferredReflowMatchesFullReflow)
+    {
+        WEX::TestExecution::DisableVerifyExceptions disableVerifyExceptions{};
+        WEX::TestExecution::SetVerifyOutput verifyOutputScope{ WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures };
+
+        // Both sizes are large enough for the new buffer to never circle.
+        for (const auto newSize : { COORD{ 100, 6000 }, COORD{ 200, 4500 } })
+        {
+            Log::Comment(NoThrowString().Format(L"Resizing to %dx%d", newSize.X, newSize.Y));
+            auto oldBuffer = _CreateLargeBuffer();
+
+            TextBuffer::PositionInformation expectedPositions{ 1200, 3990 };
+            auto expected = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, target);
+            VERIFY_SUCCEEDED(TextBuffer::Reflow(*oldBuffer, *expected, std::nullopt, expectedPositions));
+
+            Log::Comment(L"Reflow only the rows starting around row 2000, then the rest.");
+            TextBuffer::PositionInformation actualPositions{ 1200, 3990 };
+            auto deferred = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, target);
+            VERIFY_SUCCEEDED(TextBuffer::ReflowDeferred(*oldBuffer, *deferred, 2000, std::nullopt, actualPositions));
+            VERIFY_IS_TRUE(deferred->HasPendingReflow());
+            VERIFY_IS_GREATER_THAN(deferred->GetPendingReflowRowCount(), short{ 1900 });
+            VERIFY_IS_LESS_THAN_OR_EQUAL(deferred->GetPendingReflowRowCount(), short{ 2000 });
+            deferred->AdoptPendingReflowSource(std::move(oldBuffer));
+
+            auto actual = std::make_unique<TextBuffer>(newSize, TextAttribute{ 0x7 }, 0, target);
+            VERIFY_SUCCEEDED(TextBuffer::FinishReflow(*deferred, *actual, actualPositions));
+            VERIFY_IS_FALSE(actual->HasPendingReflow());
+
+            _VerifyBuffersMatch(*expected, expectedPositions, *actual, actualPositions);
+        }
+    }
+
+    static std::unique_ptr<TextBuffer> _CreateLargeBuffer()
+    {
+        auto buffer = std::make_unique<TextBuffer>(COORD{ 120, 4000 }, TextAttribute{ 0x7 }, 0, target);
+        for (SHORT y = 0; y < 4000; ++y)
+        {
+            std::wstring text;
+            const auto length = (y * 37) % 121;
+            for (auto x = 0; x < length; ++x)
+            {
+                text.push_back((y + x) % 23 == 0 ? L'\x304b' : gsl::narrow_cast<wchar_t>(L'a' + (y + x) % 26));
+            }
+            buffer->WriteLine(OutputCellIterator{ text, TextAttribute{ gsl::narrow_cast<WORD>(1 + y % 15) } }, { 0, y });
+
+            auto& row = buffer->GetRowByOffset(y);
+            row.SetWrapForced(y % 5 == 0);
+            if (y % 97 == 0)
+            {
+                row.SetLineRendition(LineRendition::DoubleWidth);
+            }
+        }
+        buffer->GetCursor().SetPosition({ 17, 2500 });
+        return buffer;
+    }
+
+    static void _VerifyBuffersMatch(const TextBuffer& expected,
+                                    const TextBuffer::PositionInformation& expectedPositions,
+                                    const TextBuffer& actual,
+                                    const TextBuffer::PositionInformation& actualPositions)
+    {
+        VERIFY_ARE_EQUAL(expected.GetCursor().GetPosition(), actual.GetCursor().GetPosition());
+        VERIFY_ARE_EQUAL(expectedPositions.mutableViewportTop, actualPositions.mutableViewportTop);
+        VERIFY_ARE_EQUAL(expectedPositions.visibleViewportTop, actualPositions.visibleViewportTop);
+
+        for (size_t i = 0; i < expected.TotalRowCount(); ++i)
+        {
+            const auto& expectedRow = expected.GetRowByOffset(i);
+            const auto& actualRow = actual.GetRowByOffset(i);
+            const auto indexString = NoThrowString().Format(L"[Row %zu]", i);
+
+            VERIFY_IS_TRUE(expectedRow.GetText() == actualRow.GetText(), indexString);
+            VERIFY_IS_TRUE(expectedRow.GetAttrRow() == actualRow.GetAttrRow(), indexString);
+            VERIFY_ARE_EQUAL(expectedRow.WasWrapForced(), actualRow.WasWrapForced(), indexString);
+            VERIFY_ARE_EQUAL(expectedRow.WasDoubleBytePadded(), actualRow.WasDoubleBytePadded(), indexString);
+            VERIFY_IS_TRUE(expectedRow.GetLineRendition() == actualRow.GetLineRendition(), indexString);
+        }
+    }
 };
 
 DummyRenderTarget ReflowTests::target{};
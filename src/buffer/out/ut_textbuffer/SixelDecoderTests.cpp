@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../SixelDecoder.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class SixelDecoderTests
+{
+    TEST_CLASS(SixelDecoderTests);
+
+    TEST_METHOD(DecodesSixels);
+    TEST_METHOD(RepeatsAndNewLines);
+    TEST_METHOD(FillsTheBackground);
+};
+
+static std::shared_ptr<const ImageStore::Image> _Decode(const std::wstring_view data, const bool transparentBackground = true)
+{
+    SixelDecoder decoder{ transparentBackground };
+    for (const auto wch : data)
+    {
+        decoder.Put(wch);
+    }
+    return decoder.Finish();
+}
+
+void SixelDecoderTests::DecodesSixels()
+{
+    Log::Comment(L"'A' is the sixel with only the second pixel from the top set, drawn in the RGB color defined for register 1.");
+    const auto image = _Decode(L"#1;2;100;0;0#1?A");
+    VERIFY_IS_NOT_NULL(image);
+    VERIFY_ARE_EQUAL(til::size(2, 2), image->size);
+
+    const uint32_t red = 0xffff0000;
+    VERIFY_ARE_EQUAL(0u, image->pixels.at(0));
+    VERIFY_ARE_EQUAL(0u, image->pixels.at(1));
+    VERIFY_ARE_EQUAL(0u, image->pixels.at(2));
+    VERIFY_ARE_EQUAL(red, image->pixels.at(3));
+
+    Log::Comment(L"The image covers the VT340 cells of its pixels.");
+    VERIFY_ARE_EQUAL(til::size(1, 1), image->CellSize());
+
+    Log::Comment(L"An image without pixels or a size isn't an image.");
+    VERIFY_IS_NULL(_Decode(L"#1;2;100;0;0"));
+
+    Log::Comment(L"Images get new IDs.");
+    VERIFY_ARE_NOT_EQUAL(image->id, _Decode(L"~")->id);
+}
+
+void SixelDecoderTests::RepeatsAndNewLines()
+{
+    const auto image = _Decode(L"!25~-$~");
+    VERIFY_IS_NOT_NULL(image);
+    VERIFY_ARE_EQUAL(til::size(25, 12), image->size);
+    VERIFY_ARE_EQUAL(til::size(3, 1), image->CellSize());
+
+    const auto pixel = [&](const ptrdiff_t x, const ptrdiff_t y) {
+        return image->pixels.at(gsl::narrow_cast<size_t>(y * image->size.width() + x));
+    };
+    VERIFY_ARE_NOT_EQUAL(0u, pixel(24, 5));
+    VERIFY_ARE_NOT_EQUAL(0u, pixel(0, 11));
+    VERIFY_ARE_EQUAL(0u, pixel(1, 11));
+
+    Log::Comment(L"The raster attributes make an image larger than its sixels.");
+    VERIFY_ARE_EQUAL(til::size(30, 40), _Decode(L"\"1;1;30;40~")->size);
+}
+
+void SixelDecoderTests::FillsTheBackground()
+{
+    Log::Comment(L"Unless it's transparent, the background has the color of register 0.");
+    const auto image = _Decode(L"#0;2;0;0;100#1A", false);
+    VERIFY_IS_NOT_NULL(image);
+    VERIFY_ARE_EQUAL(til::size(1, 2), image->size);
+    VERIFY_ARE_EQUAL(0xff0000ffu, image->pixels.at(0));
+    VERIFY_ARE_NOT_EQUAL(0xff0000ffu, image->pixels.at(1));
+}
@@ -0,0 +1,143 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../textBuffer.hpp"
+#include "../TextBufferFile.hpp"
+#include "../../renderer/inc/DummyRenderTarget.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class TextBufferFileTests
+{
+    TEST_CLASS(TextBufferFileTests);
+
+    TEST_METHOD(RestoresWhatWasSaved);
+    TEST_METHOD(RejectsOtherFiles);
+    TEST_METHOD(RestoresWhatWasShared);
+};
+
+static std::wstring _TemporaryPath()
+{
+    wchar_t directory[MAX_PATH + 1];
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempPathW(ARRAYSIZE(directory), directory));
+    wchar_t path[MAX_PATH + 1];
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempFileNameW(directory, L"tbf", 0, path));
+    return path;
+}
+
+void TextBufferFileTests::RestoresWhatWasSaved()
+{
+    DummyRenderTarget target;
+    const COORD size{ 20, 5 };
+    TextBuffer buffer{ size, TextAttribute{ 0x7 }, 25, target };
+
+    TextAttribute red{ 0x7 };
+    red.SetForeground(RGB(255, 0, 0));
+    red.SetBold(true);
+    TextAttribute link{ 0x7 };
+    link.SetHyperlinkId(buffer.GetHyperlinkId(L"https://example.com", L"custom"));
+
+    buffer.Write(OutputCellIterator(L"plain ", TextAttribute{ 0x7 }), { 0, 0 });
+    buffer.Write(OutputCellIterator(L"red", red), { 6, 0 });
+    buffer.Write(OutputCellIterator(L"\xD83D\xDE00 link", link), { 0, 2 });
+    buffer.GetRowByOffset(1).SetWrapForced(true);
+    buffer.GetRowByOffset(3).SetLineRendition(LineRendition::DoubleWidth);
+    buffer.GetCursor().SetPosition({ 4, 3 });
+    buffer.SetCurrentAttributes(red);
+
+    const auto path = _TemporaryPath();
+    auto removeFile = wil::scope_exit([&]() { DeleteFileW(path.c_str()); });
+    TextBufferFile::Save(buffer, path);
+
+    const TextBufferFile file{ path };
+    VERIFY_ARE_EQUAL(size, file.GetSize());
+
+    TextBuffer restored{ file.GetSize(), TextAttribute{ 0x7 }, 25, target };
+    file.Restore(restored);
+
+    Log::Comment(L"Hyperlinks get new IDs, so they're compared by their URI instead.");
+    for (SHORT y = 0; y < size.Y; ++y)
+    {
+        const auto& expected = buffer.GetRowByOffset(y);
+        const auto& actual = restored.GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(expected.GetText(), actual.GetText());
+        VERIFY_ARE_EQUAL(expected.WasWrapForced(), actual.WasWrapForced());
+        VERIFY_ARE_EQUAL(static_cast<int>(expected.GetLineRendition()), static_cast<int>(actual.GetLineRendition()));
+        for (SHORT x = 0; x < size.X; ++x)
+        {
+            auto expectedAttr = expected.GetAttrRow().GetAttrByColumn(x);
+            auto actualAttr = actual.GetAttrRow().GetAttrByColumn(x);
+            VERIFY_ARE_EQUAL(buffer.GetHyperlinkUriFromId(expectedAttr.GetHyperlinkId()), restored.GetHyperlinkUriFromId(actualAttr.GetHyperlinkId()));
+            expectedAttr.SetHyperlinkId(0);
+            actualAttr.SetHyperlinkId(0);
+            VERIFY_ARE_EQUAL(expectedAttr, actualAttr);
+        }
+    }
+
+    Log::Comment(L"The glyph that doesn't fit into a cell is restored along with the cells.");
+    VERIFY_ARE_EQUAL(std::wstring_view{ L"\xD83D\xDE00" }, std::wstring_view{ restored.GetRowByOffset(2).GetCharRow().GlyphAt(0) });
+
+    Log::Comment(L"Text with the same custom ID after restoring shares the restored hyperlink.");
+    const auto linkId = restored.GetRowByOffset(2).GetAttrRow().GetAttrByColumn(3).GetHyperlinkId();
+    VERIFY_ARE_EQUAL(linkId, restored.GetHyperlinkId(L"https://example.com", L"custom"));
+
+    VERIFY_ARE_EQUAL((COORD{ 4, 3 }), restored.GetCursor().GetPosition());
+    VERIFY_ARE_EQUAL(red, restored.GetCurrentAttributes());
+}
+
+void TextBufferFileTests::RejectsOtherFiles()
+{
+    const auto path = _TemporaryPath();
+    auto removeFile = wil::scope_exit([&]() { DeleteFileW(path.c_str()); });
+
+    {
+        wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        VERIFY_IS_TRUE(bool{ file });
+        const std::string text(256, 'x');
+        DWORD written = 0;
+        VERIFY_WIN32_BOOL_SUCCEEDED(WriteFile(file.get(), text.data(), gsl::narrow<DWORD>(text.size()), &written, nullptr));
+    }
+
+    VERIFY_THROWS_SPECIFIC(TextBufferFile{ path }, wil::ResultException, [](const wil::ResultException& e) {
+        return e.GetErrorCode() == HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    });
+}
+
+void TextBufferFileTests::RestoresWhatWasShared()
+{
+    DummyRenderTarget target;
+    const COORD size{ 20, 5 };
+    TextBuffer buffer{ size, TextAttribute{ 0x7 }, 25, target };
+
+    TextAttribute red{ 0x7 };
+    red.SetForeground(RGB(255, 0, 0));
+    buffer.Write(OutputCellIterator(L"shared", red), { 0, 1 });
+    buffer.GetCursor().SetPosition({ 6, 1 });
+
+    auto section = TextBufferFile::Share(buffer);
+    VERIFY_IS_TRUE(bool{ section });
+
+    Log::Comment(L"The receiving process gets its own handle. Here, that's a duplicate in the same one.");
+    wil::unique_handle duplicate;
+    VERIFY_WIN32_BOOL_SUCCEEDED(DuplicateHandle(GetCurrentProcess(), section.get(), GetCurrentProcess(), duplicate.addressof(), FILE_MAP_READ, FALSE, 0));
+    section.reset();
+
+    const TextBufferFile file{ std::move(duplicate) };
+    VERIFY_ARE_EQUAL(size, file.GetSize());
+
+    TextBuffer restored{ file.GetSize(), TextAttribute{ 0x7 }, 25, target };
+    file.Restore(restored);
+
+    for (SHORT y = 0; y < size.Y; ++y)
+    {
+        VERIFY_ARE_EQUAL(buffer.GetRowByOffset(y).GetText(), restored.GetRowByOffset(y).GetText());
+    }
+    VERIFY_ARE_EQUAL(red, restored.GetRowByOffset(1).GetAttrRow().GetAttrByColumn(0));
+    VERIFY_ARE_EQUAL((COORD{ 6, 1 }), restored.GetCursor().GetPosition());
+}
@@ -37,6 +37,7 @@ namespace SettingsModelLocalTests
         TEST_METHOD(LayerProfileIcon);
         TEST_METHOD(LayerProfilesOnArray);
         TEST_METHOD(DuplicateProfileTest);
+        TEST_METHOD(ResolvedSettingsFollowParents);
 
         TEST_CLASS_SETUP(ClassSetup)
         {
@@ -326,4 +327,39 @@ namespace SettingsModelLocalTests
         const auto duplicatedJson = winrt::get_self<implementation::Profile>(duplicatedProfile)->ToJson();
         VERIFY_ARE_EQUAL(profile0Json, duplicatedJson);
     }
+
+    void ProfileTests::ResolvedSettingsFollowParents()
+    {
+        Log::Comment(L"The resolved values are remembered, so make sure they're forgotten whenever a parent changes.");
+
+        const std::string profile0String{ R"({
+            "name" : "profile0",
+            "historySize" : 1
+        })" };
+        const std::string profile1String{ R"({
+            "historySize" : 3
+        })" };
+
+        const auto profile0Json = VerifyParseSucceeded(profile0String);
+        const auto profile1Json = VerifyParseSucceeded(profile1String);
+
+        auto parent = implementation::Profile::FromJson(profile0Json);
+        auto child = parent->CreateChild();
+        VERIFY_ARE_EQUAL(L"profile0", child->Name());
+        VERIFY_ARE_EQUAL(1, child->HistorySize());
+
+        parent->Name(L"profile1");
+        VERIFY_ARE_EQUAL(L"profile1", child->Name());
+
+        parent->LayerJson(profile1Json);
+        VERIFY_ARE_EQUAL(3, child->HistorySize());
+
+        child->HistorySize(2);
+        VERIFY_ARE_EQUAL(2, child->HistorySize());
+        child->ClearHistorySize();
+        VERIFY_ARE_EQUAL(3, child->HistorySize());
+
+        child->ClearParents();
+        VERIFY_ARE_EQUAL(DEFAULT_HISTORY_SIZE, child->HistorySize());
+    }
 }
@@ -5,6 +5,7 @@
 
 #include "../TerminalSettingsModel/ColorScheme.h"
 #include "../TerminalSettingsModel/CascadiaSettings.h"
+#include "../TerminalSettingsModel/JsonCache.h"
 #include "JsonTestClass.h"
 #include "TestUtils.h"
 #include <defaults.h>
@@ -41,6 +42,7 @@ namespace SettingsModelLocalTests
         TEST_METHOD(ColorScheme);
         TEST_METHOD(Actions);
         TEST_METHOD(CascadiaSettings);
+        TEST_METHOD(JsonCache);
 
         TEST_CLASS_SETUP(ClassSetup)
         {
@@ -464,4 +466,48 @@ namespace SettingsModelLocalTests
         const auto result{ settings->ToJson() };
         VERIFY_ARE_EQUAL(toString(settings->_userSettings), toString(result));
     }
+
+    void SerializationTests::JsonCache()
+    {
+        const auto path{ std::filesystem::temp_directory_path() / L"SerializationTests.JsonCache.cache" };
+        std::filesystem::remove(path);
+        auto removeCache = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+        const std::string settingsString{ R"({
+                                                "defaultProfile": "{61c54bbd-1111-5271-96e7-009a87ff44bf}",
+                                                "initialRows": -30,
+                                                "copyFormatting": true,
+                                                "profiles": [
+                                                    {
+                                                        "name": "Profile \"with\" quotes",
+                                                        "guid": "{61c54bbd-1111-5271-96e7-009a87ff44bf}",
+                                                        "opacity": 0.5,
+                                                        "padding": null
+                                                    }
+                                                ]
+                                            })" };
+        const auto json{ VerifyParseSucceeded(settingsString) };
+
+        {
+            ::Microsoft::Terminal::Settings::Model::JsonCache cache{ path };
+            VERIFY_IS_FALSE(cache.Find(settingsString).has_value());
+            cache.Store(settingsString, json);
+            cache.Save();
+        }
+
+        {
+            ::Microsoft::Terminal::Settings::Model::JsonCache cache{ path };
+            VERIFY_IS_FALSE(cache.Find(settingsString + " ").has_value());
+
+            const auto cached{ cache.Find(settingsString) };
+            VERIFY_IS_TRUE(cached.has_value());
+            VERIFY_ARE_EQUAL(toString(json), toString(*cached));
+
+            // The offsets are used to patch the settings file, so they have to survive.
+            const auto& profile{ json["profiles"][0] };
+            const auto& cachedProfile{ (*cached)["profiles"][0] };
+            VERIFY_ARE_EQUAL(profile.getOffsetStart(), cachedProfile.getOffsetStart());
+            VERIFY_ARE_EQUAL(profile.getOffsetLimit(), cachedProfile.getOffsetLimit());
+        }
+    }
 }
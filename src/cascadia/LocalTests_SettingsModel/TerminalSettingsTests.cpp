@@ -42,6 +42,8 @@ namespace SettingsModelLocalTests
 
         TEST_METHOD(TestLayerProfileOnColorScheme);
 
+        TEST_METHOD(TestHasSameSettings);
+
         TEST_CLASS_SETUP(ClassSetup)
         {
             return true;
@@ -554,4 +556,83 @@ namespace SettingsModelLocalTests
         VERIFY_ARE_EQUAL(ARGB(0, 0x45, 0x67, 0x89), terminalSettings4->CursorColor()); // from profile (no color scheme)
         VERIFY_ARE_EQUAL(DEFAULT_CURSOR_COLOR, terminalSettings5->CursorColor()); // default
     }
+
+    void TerminalSettingsTests::TestHasSameSettings()
+    {
+        Log::Comment(NoThrowString().Format(
+            L"Ensure that only the settings that matter to an existing terminal are compared."));
+
+        const std::string settings0String{ R"(
+        {
+            "defaultProfile": "profile0",
+            "profiles": [
+                {
+                    "name" : "profile0",
+                    "guid": "{6239a42c-0000-49a3-80bd-e8fdd045185c}",
+                    "colorScheme": "scheme0",
+                    "commandline": "cmd.exe"
+                }
+            ],
+            "schemes": [
+                {
+                    "name": "scheme0",
+                    "red": "#123456"
+                }
+            ]
+        })" };
+        const std::string settings1String{ R"(
+        {
+            "defaultProfile": "profile0",
+            "profiles": [
+                {
+                    "name" : "profile0",
+                    "guid": "{6239a42c-0000-49a3-80bd-e8fdd045185c}",
+                    "colorScheme": "scheme0",
+                    "commandline": "pwsh.exe"
+                }
+            ],
+            "schemes": [
+                {
+                    "name": "scheme0",
+                    "red": "#123456"
+                }
+            ]
+        })" };
+        const std::string settings2String{ R"(
+        {
+            "defaultProfile": "profile0",
+            "profiles": [
+                {
+                    "name" : "profile0",
+                    "guid": "{6239a42c-0000-49a3-80bd-e8fdd045185c}",
+                    "colorScheme": "scheme0",
+                    "commandline": "cmd.exe"
+                }
+            ],
+            "schemes": [
+                {
+                    "name": "scheme0",
+                    "red": "#654321"
+                }
+            ]
+        })" };
+
+        const winrt::guid guid0{ ::Microsoft::Console::Utils::GuidFromString(L"{6239a42c-0000-49a3-80bd-e8fdd045185c}") };
+        CascadiaSettings settings0{ til::u8u16(settings0String) };
+        CascadiaSettings settings1{ til::u8u16(settings1String) };
+        CascadiaSettings settings2{ til::u8u16(settings2String) };
+
+        const auto terminalSettings0{ TerminalSettings::CreateWithProfileByID(settings0, guid0, nullptr).DefaultSettings() };
+        const auto terminalSettings1{ TerminalSettings::CreateWithProfileByID(settings1, guid0, nullptr).DefaultSettings() };
+        const auto terminalSettings2{ TerminalSettings::CreateWithProfileByID(settings2, guid0, nullptr).DefaultSettings() };
+
+        VERIFY_IS_TRUE(terminalSettings0.HasSameSettings(terminalSettings0));
+        VERIFY_IS_FALSE(terminalSettings0.HasSameSettings(nullptr));
+
+        Log::Comment(L"The commandline is only used when a terminal is created");
+        VERIFY_IS_TRUE(terminalSettings0.HasSameSettings(terminalSettings1));
+
+        Log::Comment(L"The colors of the color scheme are used by the terminal");
+        VERIFY_IS_FALSE(terminalSettings0.HasSameSettings(terminalSettings2));
+    }
 }
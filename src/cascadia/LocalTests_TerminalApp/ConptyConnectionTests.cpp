@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+using namespace WEX::Common;
+using namespace winrt::Microsoft::Terminal::TerminalConnection;
+
+namespace TerminalAppLocalTests
+{
+    class ConptyConnectionTests
+    {
+        BEGIN_TEST_CLASS(ConptyConnectionTests)
+            TEST_CLASS_PROPERTY(L"RunAs", L"UAP")
+            TEST_CLASS_PROPERTY(L"UAP:AppXManifest", L"TestHostAppXManifest.xml")
+        END_TEST_CLASS()
+
+        TEST_METHOD(ReadFromPooledConsole);
+
+    private:
+        void _RunEcho(const std::wstring_view marker);
+    };
+
+    // Starts a connection that echoes the given marker, and waits for the
+    // marker to come out of the output pipe of the pseudoconsole, both as
+    // UTF-16 and as the UTF-8 it was read as.
+    void ConptyConnectionTests::_RunEcho(const std::wstring_view marker)
+    {
+        const auto environment = winrt::single_threaded_map<winrt::hstring, winrt::hstring>();
+        ConptyConnection connection{ winrt::hstring{ fmt::format(L"cmd.exe /c echo {}", marker) },
+                                     winrt::hstring{ wil::GetCurrentDirectoryW<std::wstring>() },
+                                     L"",
+                                     environment.GetView(),
+                                     25,
+                                     80,
+                                     winrt::guid{} };
+
+        const auto markerUtf8 = til::u16u8(marker);
+
+        std::mutex lock;
+        std::wstring output;
+        std::string outputUtf8;
+        wil::slim_event found;
+        wil::slim_event foundUtf8;
+        connection.TerminalOutput([&](const winrt::hstring& text) {
+            const std::lock_guard guard{ lock };
+            output.append(text);
+            if (output.find(marker) != std::wstring::npos)
+            {
+                found.SetEvent();
+            }
+        });
+        connection.TerminalOutputUtf8([&](const winrt::array_view<const uint8_t>& text) {
+            const std::lock_guard guard{ lock };
+            outputUtf8.append(reinterpret_cast<const char*>(text.data()), text.size());
+            if (outputUtf8.find(markerUtf8) != std::string::npos)
+            {
+                foundUtf8.SetEvent();
+            }
+        });
+
+        connection.Start();
+        const auto succeeded = found.wait(30000);
+        const auto succeededUtf8 = foundUtf8.wait(30000);
+        connection.Close();
+
+        const std::lock_guard guard{ lock };
+        Log::Comment(NoThrowString().Format(L"Output: \"%s\"", output.c_str()));
+        VERIFY_IS_TRUE(succeeded, L"The marker should be read from the pseudoconsole.");
+        VERIFY_IS_TRUE(succeededUtf8, L"The marker should be raised as UTF-8 too.");
+    }
+
+    void ConptyConnectionTests::ReadFromPooledConsole()
+    {
+        Log::Comment(L"The first connection creates the pool's pseudoconsoles.");
+        _RunEcho(L"PooledConsoleFirst");
+
+        Log::Comment(L"The second one gets an idle pseudoconsole from the pool.");
+        _RunEcho(L"PooledConsoleSecond");
+    }
+}
@@ -20,6 +20,11 @@ static LPCWSTR term_window_class = L"HwndTerminalClass";
 // "If the high-order bit is 1, the key is down; otherwise, it is up."
 static constexpr short KeyPressed{ gsl::narrow_cast<short>(0x8000) };
 
+// How much output (in code units) may be queued before EnqueueOutput() waits for the
+// ingestion thread. This keeps a host producing output faster than we can parse it
+// from growing the queue without bounds.
+static constexpr size_t MaxPendingOutput{ 4 * 1024 * 1024 };
+
 static constexpr bool _IsMouseMessage(UINT uMsg)
 {
     return uMsg == WM_LBUTTONDOWN || uMsg == WM_LBUTTONUP || uMsg == WM_LBUTTONDBLCLK ||
@@ -175,6 +180,7 @@ HwndTerminal::HwndTerminal(HWND parentHwnd) :
     _uiaProviderInitialized{ false },
     _currentDpi{ USER_DEFAULT_SCREEN_DPI },
     _pfnWriteCallback{ nullptr },
+    _pfnWriteCallbackEx{ nullptr },
     _multiClickTime{ 500 } // this will be overwritten by the windows system double-click time
 {
     _EnsureStaticInitialization();
@@ -245,6 +251,8 @@ HRESULT HwndTerminal::Initialize()
     _terminal->SetWriteInputCallback([=](std::wstring& input) noexcept { _WriteTextToConnection(input); });
     localPointerToThread->EnablePainting();
 
+    _ingestionThread = std::thread([this]() { _IngestOutput(); });
+
     _multiClickTime = std::chrono::milliseconds{ GetDoubleClickTime() };
 
     return S_OK;
@@ -256,6 +264,9 @@ try
     // As a rule, detach resources from the Terminal before shutting them down.
     // This ensures that teardown is reentrant.
 
+    // The ingestion thread writes into the terminal (and thus notifies the renderer).
+    _StopIngestion();
+
     // Shut down the renderer (and therefore the thread) before we implode
     if (auto localRenderEngine{ std::exchange(_renderEngine, nullptr) })
     {
@@ -284,15 +295,19 @@ void HwndTerminal::RegisterScrollCallback(std::function<void(int, int, int)> cal
 
 void HwndTerminal::_WriteTextToConnection(const std::wstring& input) noexcept
 {
-    if (!_pfnWriteCallback)
-    {
-        return;
-    }
-
     try
     {
-        auto callingText{ wil::make_cotaskmem_string(input.data(), input.size()) };
-        _pfnWriteCallback(callingText.release());
+        // The length-delimited callback borrows our string for the duration
+        // of the call, so there's nothing to allocate (or for the host to free).
+        if (_pfnWriteCallbackEx)
+        {
+            _pfnWriteCallbackEx(input.data(), input.size());
+        }
+        else if (_pfnWriteCallback)
+        {
+            auto callingText{ wil::make_cotaskmem_string(input.data(), input.size()) };
+            _pfnWriteCallback(callingText.release());
+        }
     }
     CATCH_LOG();
 }
@@ -302,6 +317,11 @@ void HwndTerminal::RegisterWriteCallback(const void _stdcall callback(wchar_t*))
     _pfnWriteCallback = callback;
 }
 
+void HwndTerminal::RegisterWriteCallbackEx(void _stdcall callback(const wchar_t*, size_t))
+{
+    _pfnWriteCallbackEx = callback;
+}
+
 ::Microsoft::Console::Types::IUiaData* HwndTerminal::GetUiaData() const noexcept
 {
     return _terminal.get();
@@ -326,7 +346,7 @@ IRawElementProviderSimple* HwndTerminal::_GetUiaProvider() noexcept
 {
     if (nullptr == _uiaProvider && !_uiaProviderInitialized)
     {
-        std::unique_lock<std::shared_mutex> lock;
+        std::unique_lock<til::fair_shared_mutex> lock;
         try
         {
 #pragma warning(suppress : 26441) // The lock is named, this appears to be a false positive
@@ -385,6 +405,110 @@ void HwndTerminal::SendOutput(std::wstring_view data)
     _terminal->Write(data);
 }
 
+void HwndTerminal::SendOutput(std::string_view utf8)
+{
+    _terminal->Write(utf8);
+}
+
+// Method Description:
+// - Queues output for the ingestion thread, which writes it into the terminal.
+//   Unlike SendOutput(), this can be called from any thread and doesn't wait
+//   for the output to be parsed, so hosts don't parse on their UI thread.
+// - Blocks only if the ingestion thread is too far behind.
+// Arguments:
+// - data: the output, which is copied
+void HwndTerminal::EnqueueOutput(std::wstring_view data)
+{
+    _EnqueueOutput(data);
+}
+
+void HwndTerminal::EnqueueOutput(std::string_view utf8)
+{
+    _EnqueueOutput(utf8);
+}
+
+template<typename T>
+void HwndTerminal::_EnqueueOutput(T data)
+{
+    if (data.empty())
+    {
+        return;
+    }
+
+    {
+        std::unique_lock lock{ _ingestionMutex };
+        _ingestionCondition.wait(lock, [this]() { return _ingestionStopped || _pendingOutputSize < MaxPendingOutput; });
+        if (_ingestionStopped)
+        {
+            return;
+        }
+
+        using String = std::basic_string<typename T::value_type>;
+        if (auto last = _pendingOutput.empty() ? nullptr : std::get_if<String>(&_pendingOutput.back()))
+        {
+            last->append(data);
+        }
+        else
+        {
+            _pendingOutput.emplace_back(String{ data });
+        }
+        _pendingOutputSize += data.size();
+    }
+    _ingestionCondition.notify_all();
+}
+
+// Method Description:
+// - The body of the ingestion thread. Takes all of the queued output at
+//   once and writes it into the terminal, until the ingestion is stopped.
+void HwndTerminal::_IngestOutput() noexcept
+{
+    std::deque<std::variant<std::wstring, std::string>> output;
+    for (;;)
+    {
+        {
+            std::unique_lock lock{ _ingestionMutex };
+            _ingestionCondition.wait(lock, [this]() { return _ingestionStopped || !_pendingOutput.empty(); });
+            if (_ingestionStopped)
+            {
+                return;
+            }
+            output.swap(_pendingOutput);
+            _pendingOutputSize = 0;
+        }
+        // Wake up the hosts waiting for room in the queue.
+        _ingestionCondition.notify_all();
+
+        for (const auto& chunk : output)
+        {
+            try
+            {
+                std::visit([this](const auto& string) { _terminal->Write(string); }, chunk);
+            }
+            CATCH_LOG();
+        }
+        output.clear();
+    }
+}
+
+// Method Description:
+// - Stops the ingestion thread and waits for it to exit. Output that's still
+//   queued is dropped, since it's only called when the terminal goes away.
+void HwndTerminal::_StopIngestion() noexcept
+{
+    {
+        const std::lock_guard lock{ _ingestionMutex };
+        _ingestionStopped = true;
+        _pendingOutput.clear();
+        _pendingOutputSize = 0;
+    }
+    _ingestionCondition.notify_all();
+
+    if (_ingestionThread.joinable())
+    {
+        _ingestionThread.join();
+    }
+}
+
 HRESULT _stdcall CreateTerminal(HWND parentHwnd, _Out_ void** hwnd, _Out_ void** terminal)
 {
     // In order for UIA to hook up properly there needs to be a "static" window hosting the
@@ -427,12 +551,72 @@ void _stdcall TerminalRegisterWriteCallback(void* terminal, const void __stdcall
     publicTerminal->RegisterWriteCallback(callback);
 }
 
+void _stdcall TerminalRegisterWriteCallbackEx(void* terminal, void __stdcall callback(const wchar_t*, size_t))
+{
+    const auto publicTerminal = static_cast<HwndTerminal*>(terminal);
+    publicTerminal->RegisterWriteCallbackEx(callback);
+}
+
 void _stdcall TerminalSendOutput(void* terminal, LPCWSTR data)
 {
     const auto publicTerminal = static_cast<HwndTerminal*>(terminal);
     publicTerminal->SendOutput(data);
 }
 
+/// <summary>
+/// Writes output to the terminal, without it having to be null-terminated or
+/// copied first. UTF-8 is parsed as is, without being converted to UTF-16.
+/// A code point (or sequence) may be split across calls.
+/// </summary>
+/// <param name="terminal">Terminal pointer.</param>
+/// <param name="data">The output, which doesn't need to be null-terminated.</param>
+/// <param name="length">The length of the output in code units (bytes for UTF-8, wchar_ts for UTF-16).</param>
+/// <param name="encoding">The encoding of the output.</param>
+void _stdcall TerminalSendOutputEx(void* terminal, const void* data, size_t length, TerminalOutputEncoding encoding)
+try
+{
+    const auto publicTerminal = static_cast<HwndTerminal*>(terminal);
+    switch (encoding)
+    {
+    case TerminalOutputEncodingUtf8:
+        publicTerminal->SendOutput(std::string_view{ static_cast<const char*>(data), length });
+        break;
+    case TerminalOutputEncodingUtf16:
+        publicTerminal->SendOutput(std::wstring_view{ static_cast<const wchar_t*>(data), length });
+        break;
+    default:
+        THROW_HR(E_INVALIDARG);
+    }
+}
+CATCH_LOG();
+
+/// <summary>
+/// Queues output for the terminal's ingestion thread and returns without waiting
+/// for it to be parsed, so that the output doesn't hold up the calling (UI) thread.
+/// Safe to call from any thread. The output is copied.
+/// </summary>
+/// <param name="terminal">Terminal pointer.</param>
+/// <param name="data">The output, which doesn't need to be null-terminated.</param>
+/// <param name="length">The length of the output in code units (bytes for UTF-8, wchar_ts for UTF-16).</param>
+/// <param name="encoding">The encoding of the output.</param>
+void _stdcall TerminalEnqueueOutput(void* terminal, const void* data, size_t length, TerminalOutputEncoding encoding)
+try
+{
+    const auto publicTerminal = static_cast<HwndTerminal*>(terminal);
+    switch (encoding)
+    {
+    case TerminalOutputEncodingUtf8:
+        publicTerminal->EnqueueOutput(std::string_view{ static_cast<const char*>(data), length });
+        break;
+    case TerminalOutputEncodingUtf16:
+        publicTerminal->EnqueueOutput(std::wstring_view{ static_cast<const wchar_t*>(data), length });
+        break;
+    default:
+        THROW_HR(E_INVALIDARG);
+    }
+}
+CATCH_LOG();
+
 /// <summary>
 /// Triggers a terminal resize using the new width and height in pixel.
 /// </summary>
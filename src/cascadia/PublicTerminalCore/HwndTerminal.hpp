@@ -10,6 +10,9 @@
 #include "../../types/IControlAccessibilityInfo.h"
 #include "../../types/TermControlUiaProvider.hpp"
 
+#include <condition_variable>
+#include <variant>
+
 using namespace Microsoft::Console::VirtualTerminal;
 
 // Keep in sync with TerminalTheme.cs
@@ -23,9 +26,18 @@ typedef struct _TerminalTheme
     COLORREF ColorTable[16];
 } TerminalTheme, *LPTerminalTheme;
 
+// Keep in sync with NativeMethods.cs
+typedef enum _TerminalOutputEncoding : uint32_t
+{
+    TerminalOutputEncodingUtf16 = 0,
+    TerminalOutputEncodingUtf8 = 1,
+} TerminalOutputEncoding;
+
 extern "C" {
 __declspec(dllexport) HRESULT _stdcall CreateTerminal(HWND parentHwnd, _Out_ void** hwnd, _Out_ void** terminal);
 __declspec(dllexport) void _stdcall TerminalSendOutput(void* terminal, LPCWSTR data);
+__declspec(dllexport) void _stdcall TerminalSendOutputEx(void* terminal, const void* data, size_t length, TerminalOutputEncoding encoding);
+__declspec(dllexport) void _stdcall TerminalEnqueueOutput(void* terminal, const void* data, size_t length, TerminalOutputEncoding encoding);
 __declspec(dllexport) void _stdcall TerminalRegisterScrollCallback(void* terminal, void __stdcall callback(int, int, int));
 __declspec(dllexport) HRESULT _stdcall TerminalTriggerResize(_In_ void* terminal, _In_ short width, _In_ short height, _Out_ COORD* dimensions);
 __declspec(dllexport) HRESULT _stdcall TerminalTriggerResizeWithDimension(_In_ void* terminal, _In_ COORD dimensions, _Out_ SIZE* dimensionsInPixels);
@@ -38,6 +50,7 @@ __declspec(dllexport) bool _stdcall TerminalIsSelectionActive(void* terminal);
 __declspec(dllexport) void _stdcall DestroyTerminal(void* terminal);
 __declspec(dllexport) void _stdcall TerminalSetTheme(void* terminal, TerminalTheme theme, LPCWSTR fontFamily, short fontSize, int newDpi);
 __declspec(dllexport) void _stdcall TerminalRegisterWriteCallback(void* terminal, const void __stdcall callback(wchar_t*));
+__declspec(dllexport) void _stdcall TerminalRegisterWriteCallbackEx(void* terminal, void __stdcall callback(const wchar_t*, size_t));
 __declspec(dllexport) void _stdcall TerminalSendKeyEvent(void* terminal, WORD vkey, WORD scanCode, WORD flags, bool keyDown);
 __declspec(dllexport) void _stdcall TerminalSendCharEvent(void* terminal, wchar_t ch, WORD flags, WORD scanCode);
 __declspec(dllexport) void _stdcall TerminalBlinkCursor(void* terminal);
@@ -60,9 +73,13 @@ public:
     HRESULT Initialize();
     void Teardown() noexcept;
     void SendOutput(std::wstring_view data);
+    void SendOutput(std::string_view utf8);
+    void EnqueueOutput(std::wstring_view data);
+    void EnqueueOutput(std::string_view utf8);
     HRESULT Refresh(const SIZE windowSize, _Out_ COORD* dimensions);
     void RegisterScrollCallback(std::function<void(int, int, int)> callback);
     void RegisterWriteCallback(const void _stdcall callback(wchar_t*));
+    void RegisterWriteCallbackEx(void _stdcall callback(const wchar_t*, size_t));
     ::Microsoft::Console::Types::IUiaData* GetUiaData() const noexcept;
     HWND GetHwnd() const noexcept;
 
@@ -75,6 +92,7 @@ private:
     int _currentDpi;
     bool _uiaProviderInitialized;
     std::function<void(wchar_t*)> _pfnWriteCallback;
+    std::function<void(const wchar_t*, size_t)> _pfnWriteCallbackEx;
     ::Microsoft::WRL::ComPtr<::Microsoft::Terminal::TermControlUiaProvider> _uiaProvider;
 
     std::unique_ptr<::Microsoft::Terminal::Core::Terminal> _terminal;
@@ -84,6 +102,15 @@ private:
 
     bool _focused{ false };
 
+    // Output queued by EnqueueOutput(), in the order it was received. Adjacent
+    // chunks of the same encoding are merged, so this stays short.
+    std::deque<std::variant<std::wstring, std::string>> _pendingOutput;
+    size_t _pendingOutputSize{ 0 };
+    bool _ingestionStopped{ false };
+    std::mutex _ingestionMutex;
+    std::condition_variable _ingestionCondition;
+    std::thread _ingestionThread;
+
     std::chrono::milliseconds _multiClickTime;
     unsigned int _multiClickCounter{};
     std::chrono::steady_clock::time_point _lastMouseClickTimestamp{};
@@ -108,6 +135,10 @@ private:
     friend void _stdcall TerminalKillFocus(void* terminal);
 
     void _UpdateFont(int newDpi);
+    void _IngestOutput() noexcept;
+    void _StopIngestion() noexcept;
+    template<typename T>
+    void _EnqueueOutput(T data);
     void _WriteTextToConnection(const std::wstring& text) noexcept;
     HRESULT _CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, bool const fAlsoCopyFormatting);
     HRESULT _CopyToSystemClipboard(std::string stringToCopy, LPCWSTR lpszFormat);
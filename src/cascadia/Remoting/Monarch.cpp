@@ -6,6 +6,7 @@
 #include "Monarch.h"
 #include "CommandlineArgs.h"
 #include "FindTargetWindowArgs.h"
+#include "WindowRequestedArgs.h"
 #include "ProposeCommandlineResult.h"
 
 #include "Monarch.g.cpp"
@@ -77,8 +78,10 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
             peasant.WindowActivated({ this, &Monarch::_peasantWindowActivated });
             peasant.IdentifyWindowsRequested({ this, &Monarch::_identifyWindows });
             peasant.RenameRequested({ this, &Monarch::_renameRequested });
+            peasant.WindowNameChanged({ this, &Monarch::_peasantWindowNameChanged });
 
             _peasants[newPeasantsId] = peasant;
+            _peasantNames[newPeasantsId] = peasant.WindowName();
 
             TraceLoggingWrite(g_hRemotingProvider,
                               "Monarch_AddPeasant",
@@ -117,6 +120,67 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         HandleActivatePeasant(args);
     }
 
+    // Method Description:
+    // - Event handler for the Peasant::WindowNameChanged event. Used to keep
+    //   our copy of the peasant's name up to date.
+    // Arguments:
+    // - sender: the Peasant that raised this event. This might be out-of-proc!
+    // Return Value:
+    // - <none>
+    void Monarch::_peasantWindowNameChanged(const winrt::Windows::Foundation::IInspectable& sender,
+                                            const winrt::Windows::Foundation::IInspectable& /*args*/)
+    {
+        try
+        {
+            if (const auto peasant{ sender.try_as<Remoting::IPeasant>() })
+            {
+                const auto peasantID = peasant.GetID();
+                // Don't resurrect the name of a peasant we already removed.
+                if (_peasants.find(peasantID) != _peasants.end())
+                {
+                    _peasantNames[peasantID] = peasant.WindowName();
+                }
+            }
+        }
+        CATCH_LOG();
+    }
+
+    // Method Description:
+    // - Stop tracking the given peasant, because it died.
+    // Arguments:
+    // - peasantID: The ID of the peasant to remove
+    // Return Value:
+    // - <none>
+    void Monarch::_removePeasant(const uint64_t peasantID)
+    {
+        // Remove the peasant from the list of peasants
+        _peasants.erase(peasantID);
+        _peasantNames.erase(peasantID);
+
+        // Remove the peasant from the list of MRU windows. They're dead.
+        // They can't be the MRU anymore.
+        _clearOldMruEntries(peasantID);
+    }
+
+    // Method Description:
+    // - Stop tracking the given peasant, because its window closed while its
+    //   process lives on. This only happens for the windows the monarch hosts
+    //   in its own process, since their peasants never die on their own.
+    // Arguments:
+    // - peasantID: The ID of the peasant to remove
+    // Return Value:
+    // - <none>
+    void Monarch::RemovePeasant(const uint64_t peasantID)
+    {
+        TraceLoggingWrite(g_hRemotingProvider,
+                          "Monarch_RemovePeasant",
+                          TraceLoggingUInt64(peasantID, "peasantID", "the ID of the peasant to remove"),
+                          TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                          TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+
+        _removePeasant(peasantID);
+    }
+
     // Method Description:
     // - Lookup a peasant by its ID. If the peasant has died, this will also
     //   remove the peasant from our list of peasants.
@@ -141,20 +205,17 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         catch (...)
         {
             LOG_CAUGHT_EXCEPTION();
-            // Remove the peasant from the list of peasants
-            _peasants.erase(peasantID);
-
-            // Remove the peasant from the list of MRU windows. They're dead.
-            // They can't be the MRU anymore.
-            _clearOldMruEntries(peasantID);
+            _removePeasant(peasantID);
             return nullptr;
         }
     }
 
     // Method Description:
     // - Find the ID of the peasant with the given name. If no such peasant
-    //   exists, then we'll return 0. If we encounter any peasants who have died
-    //   during this process, then we'll remove them from the set of _peasants
+    //   exists, then we'll return 0.
+    // - The names come from our cache, so this only needs to talk to the
+    //   peasant we found, to make sure it's still alive. If it died, then we'll
+    //   remove it from the set of _peasants.
     // Arguments:
     // - name: The window name to look for
     // Return Value:
@@ -167,41 +228,26 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
             return 0;
         }
 
-        std::vector<uint64_t> peasantsToErase{};
-        uint64_t result = 0;
-        for (const auto& [id, p] : _peasants)
+        // A window that died might still have the same name as a live one,
+        // until we notice that it died.
+        std::vector<uint64_t> candidates;
+        for (const auto& [id, otherName] : _peasantNames)
         {
-            try
+            if (otherName == name)
             {
-                auto otherName = p.WindowName();
-                if (otherName == name)
-                {
-                    result = id;
-                    break;
-                }
-            }
-            catch (...)
-            {
-                LOG_CAUGHT_EXCEPTION();
-                // Normally, we'd just erase the peasant here. However, we can't
-                // erase from the map while we're iterating over it like this.
-                // Instead, pull a good ole Java and collect this id for removal
-                // later.
-                peasantsToErase.push_back(id);
+                candidates.push_back(id);
             }
         }
 
-        // Remove the dead peasants we came across while iterating.
-        for (const auto& id : peasantsToErase)
+        for (const auto id : candidates)
         {
-            // Remove the peasant from the list of peasants
-            _peasants.erase(id);
-            // Remove the peasant from the list of MRU windows. They're dead.
-            // They can't be the MRU anymore.
-            _clearOldMruEntries(id);
+            if (_getPeasant(id))
+            {
+                return id;
+            }
         }
 
-        return result;
+        return 0;
     }
 
     // Method Description:
@@ -387,7 +433,8 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
                 continue;
             }
 
-            if (ignoreQuakeWindow && peasant.WindowName() == QuakeWindowName)
+            const auto name{ _peasantNames.find(mruWindowArgs.PeasantID()) };
+            if (ignoreQuakeWindow && name != _peasantNames.end() && name->second == QuakeWindowName)
             {
                 // The _quake window should never be treated as the MRU window.
                 // Skip it if we see it. Users can still target it with `wt -w
@@ -585,6 +632,10 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
                 auto result{ winrt::make_self<Remoting::implementation::ProposeCommandlineResult>(true) };
                 result->Id(windowID);
                 result->WindowName(targetWindowName);
+                if (_requestWindow(args, windowID, targetWindowName))
+                {
+                    result->ShouldCreateWindow(false);
+                }
                 return *result;
             }
         }
@@ -599,9 +650,47 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         // In this case, no usable ID was provided. Return { true, nullopt }
         auto result = winrt::make_self<Remoting::implementation::ProposeCommandlineResult>(true);
         result->WindowName(targetWindowName);
+        if (_requestWindow(args, std::nullopt, targetWindowName))
+        {
+            result->ShouldCreateWindow(false);
+        }
         return *result;
     }
 
+    // Method Description:
+    // - Offer the creation of a new window for the given commandline to our
+    //   own process. If the host opted into hosting more windows in-process,
+    //   it'll create the window and mark the request as handled. Then the
+    //   process that proposed the commandline doesn't need to become a window.
+    // Arguments:
+    // - args: the commandline that needs a new window
+    // - id: the ID the new window should have, if any
+    // - windowName: the name the new window should have, if any
+    // Return Value:
+    // - true iff a window was created in our process for this commandline
+    bool Monarch::_requestWindow(const Remoting::CommandlineArgs& args,
+                                 const std::optional<uint64_t> id,
+                                 const winrt::hstring& windowName)
+    {
+        auto requestArgs{ winrt::make_self<Remoting::implementation::WindowRequestedArgs>(args) };
+        if (id)
+        {
+            requestArgs->Id(id.value());
+        }
+        requestArgs->WindowName(windowName);
+
+        // This is handled by some handler in-proc
+        _WindowRequestedHandlers(*this, *requestArgs);
+
+        TraceLoggingWrite(g_hRemotingProvider,
+                          "Monarch_RequestWindow",
+                          TraceLoggingBoolean(requestArgs->Handled(), "handled", "true if our process created the window"),
+                          TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                          TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+
+        return requestArgs->Handled();
+    }
+
     // Method Description:
     // - Helper for doing something on each and every peasant, with no regard
     //   for if the peasant is living or dead.
@@ -50,8 +50,10 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         winrt::Microsoft::Terminal::Remoting::ProposeCommandlineResult ProposeCommandline(const winrt::Microsoft::Terminal::Remoting::CommandlineArgs& args);
         void HandleActivatePeasant(const winrt::Microsoft::Terminal::Remoting::WindowActivatedArgs& args);
         void SummonWindow(const Remoting::SummonWindowSelectionArgs& args);
+        void RemovePeasant(const uint64_t peasantID);
 
         TYPED_EVENT(FindTargetWindowRequested, winrt::Windows::Foundation::IInspectable, winrt::Microsoft::Terminal::Remoting::FindTargetWindowArgs);
+        TYPED_EVENT(WindowRequested, winrt::Windows::Foundation::IInspectable, winrt::Microsoft::Terminal::Remoting::WindowRequestedArgs);
 
     private:
         Monarch(const uint64_t testPID);
@@ -63,17 +65,26 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         winrt::com_ptr<IVirtualDesktopManager> _desktopManager{ nullptr };
 
         std::unordered_map<uint64_t, winrt::Microsoft::Terminal::Remoting::IPeasant> _peasants;
+        // The names of the peasants, kept up to date by their WindowNameChanged
+        // events, so that finding a window by name doesn't need to ask each one.
+        std::unordered_map<uint64_t, winrt::hstring> _peasantNames;
 
         std::vector<Remoting::WindowActivatedArgs> _mruPeasants;
 
         winrt::Microsoft::Terminal::Remoting::IPeasant _getPeasant(uint64_t peasantID);
         uint64_t _getMostRecentPeasantID(bool limitToCurrentDesktop, const bool ignoreQuakeWindow);
         uint64_t _lookupPeasantIdForName(std::wstring_view name);
+        void _removePeasant(const uint64_t peasantID);
 
         void _peasantWindowActivated(const winrt::Windows::Foundation::IInspectable& sender,
                                      const winrt::Microsoft::Terminal::Remoting::WindowActivatedArgs& args);
+        void _peasantWindowNameChanged(const winrt::Windows::Foundation::IInspectable& sender,
+                                       const winrt::Windows::Foundation::IInspectable& args);
         void _doHandleActivatePeasant(const winrt::com_ptr<winrt::Microsoft::Terminal::Remoting::implementation::WindowActivatedArgs>& args);
         void _clearOldMruEntries(const uint64_t peasantID);
+        bool _requestWindow(const winrt::Microsoft::Terminal::Remoting::CommandlineArgs& args,
+                            const std::optional<uint64_t> id,
+                            const winrt::hstring& windowName);
 
         void _forAllPeasantsIgnoringTheDead(std::function<void(const winrt::Microsoft::Terminal::Remoting::IPeasant&, const uint64_t)> callback,
                                             std::function<void(const uint64_t)> errorCallback);
@@ -191,6 +191,36 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
                           TraceLoggingKeyword(TIL_KEYWORD_TRACE));
     }
 
+    winrt::hstring Peasant::WindowName()
+    {
+        return _WindowName;
+    }
+
+    // Method Description:
+    // - Sets our name, and lets the monarch know about it. The monarch keeps
+    //   the names of all the windows, so that it doesn't have to ask each of
+    //   them for it when it looks a window up by name.
+    // Arguments:
+    // - name: our new name
+    // Return Value:
+    // - <none>
+    void Peasant::WindowName(const winrt::hstring& name)
+    {
+        if (_WindowName == name)
+        {
+            return;
+        }
+        _WindowName = name;
+
+        try
+        {
+            // The monarch might have died. If it did, the new one will ask us
+            // for our name when we're added to it.
+            _WindowNameChangedHandlers(*this, nullptr);
+        }
+        CATCH_LOG();
+    }
+
     void Peasant::RequestRename(const winrt::Microsoft::Terminal::Remoting::RenameRequestArgs& args)
     {
         bool successfullyNotified = false;
@@ -204,7 +234,7 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
             _RenameRequestedHandlers(*this, args);
             if (args.Succeeded())
             {
-                _WindowName = args.NewName();
+                WindowName(args.NewName());
             }
             successfullyNotified = true;
         }
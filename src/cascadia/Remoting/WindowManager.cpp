@@ -254,6 +254,7 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         // window, and when the current monarch dies.
 
         _monarch.FindTargetWindowRequested({ this, &WindowManager::_raiseFindTargetWindowRequested });
+        _monarch.WindowRequested({ this, &WindowManager::_raiseWindowRequested });
 
         _BecameMonarchHandlers(*this, nullptr);
     }
@@ -496,6 +497,12 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         _FindTargetWindowRequestedHandlers(sender, args);
     }
 
+    void WindowManager::_raiseWindowRequested(const winrt::Windows::Foundation::IInspectable& sender,
+                                              const winrt::Microsoft::Terminal::Remoting::WindowRequestedArgs& args)
+    {
+        _WindowRequestedHandlers(sender, args);
+    }
+
     bool WindowManager::IsMonarch()
     {
         return _isKing;
@@ -509,4 +516,56 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         _monarch.SummonWindow(args);
     }
 
+    // Method Description:
+    // - Create a peasant for a window that the monarch hosts in our process,
+    //   and add it to the monarch. Unlike _createOurPeasant, this doesn't
+    //   replace our own peasant, and there's no need for an election thread:
+    //   the window can't outlive the monarch, since it's in the same process.
+    // - We should only ever get called when we are the monarch, from a
+    //   WindowRequested handler.
+    // Arguments:
+    // - args: the request for the new window, with its commandline, ID and name.
+    // Return Value:
+    // - the new peasant. Its InitialArgs are the requested commandline.
+    Remoting::Peasant WindowManager::CreatePeasant(const Remoting::WindowRequestedArgs& args)
+    {
+        auto p = winrt::make_self<Remoting::implementation::Peasant>();
+        if (const auto id{ args.Id() })
+        {
+            p->AssignID(id.Value());
+        }
+
+        // If the name wasn't specified, this will be an empty string.
+        p->WindowName(args.WindowName());
+        _monarch.AddPeasant(*p);
+
+        // Nothing is listening to this peasant yet, so this only stashes the
+        // commandline away as its InitialArgs.
+        p->ExecuteCommandline(args.Args());
+
+        TraceLoggingWrite(g_hRemotingProvider,
+                          "WindowManager_CreatePeasant",
+                          TraceLoggingUInt64(p->GetID(), "peasantID", "The ID of the new peasant"),
+                          TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                          TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+
+        return *p;
+    }
+
+    // Method Description:
+    // - Tell the monarch to forget about a peasant we created with
+    //   CreatePeasant, because its window closed.
+    // Arguments:
+    // - peasant: the peasant of the window that closed.
+    // Return Value:
+    // - <none>
+    void WindowManager::RemovePeasant(const Remoting::IPeasant& peasant)
+    {
+        try
+        {
+            _monarch.RemovePeasant(peasant.GetID());
+        }
+        CATCH_LOG();
+    }
+
 }
@@ -39,9 +39,12 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         winrt::Microsoft::Terminal::Remoting::Peasant CurrentWindow();
         bool IsMonarch();
         void SummonWindow(const Remoting::SummonWindowSelectionArgs& args);
+        winrt::Microsoft::Terminal::Remoting::Peasant CreatePeasant(const Remoting::WindowRequestedArgs& args);
+        void RemovePeasant(const Remoting::IPeasant& peasant);
 
         TYPED_EVENT(FindTargetWindowRequested, winrt::Windows::Foundation::IInspectable, winrt::Microsoft::Terminal::Remoting::FindTargetWindowArgs);
         TYPED_EVENT(BecameMonarch, winrt::Windows::Foundation::IInspectable, winrt::Windows::Foundation::IInspectable);
+        TYPED_EVENT(WindowRequested, winrt::Windows::Foundation::IInspectable, winrt::Microsoft::Terminal::Remoting::WindowRequestedArgs);
 
     private:
         bool _shouldCreateWindow{ false };
@@ -65,6 +68,8 @@ namespace winrt::Microsoft::Terminal::Remoting::implementation
         void _waitOnMonarchThread();
         void _raiseFindTargetWindowRequested(const winrt::Windows::Foundation::IInspectable& sender,
                                              const winrt::Microsoft::Terminal::Remoting::FindTargetWindowArgs& args);
+        void _raiseWindowRequested(const winrt::Windows::Foundation::IInspectable& sender,
+                                   const winrt::Microsoft::Terminal::Remoting::WindowRequestedArgs& args);
     };
 }
 
@@ -0,0 +1,5 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "pch.h"
+#include "WindowRequestedArgs.h"
+#include "WindowRequestedArgs.g.cpp"
@@ -0,0 +1,36 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Class Name:
+- WindowRequestedArgs.h
+
+Abstract:
+- This is a helper class for letting the monarch's own process create a window
+  for a commandline, instead of telling the process that proposed it to become
+  that window. The Monarch will create one of these whenever a commandline
+  needs a new window, then toss it over to the WindowsTerminal host. If the host
+  created the window itself, it sets Handled, and the monarch tells the caller
+  that it doesn't need to create a window.
+
+--*/
+
+#pragma once
+
+#include "WindowRequestedArgs.g.h"
+#include "../cascadia/inc/cppwinrt_utils.h"
+
+namespace winrt::Microsoft::Terminal::Remoting::implementation
+{
+    struct WindowRequestedArgs : public WindowRequestedArgsT<WindowRequestedArgs>
+    {
+        WINRT_PROPERTY(winrt::Microsoft::Terminal::Remoting::CommandlineArgs, Args, nullptr);
+        WINRT_PROPERTY(Windows::Foundation::IReference<uint64_t>, Id);
+        WINRT_PROPERTY(winrt::hstring, WindowName);
+        WINRT_PROPERTY(bool, Handled, false);
+
+    public:
+        WindowRequestedArgs(winrt::Microsoft::Terminal::Remoting::CommandlineArgs args) :
+            _Args{ args } {};
+    };
+}
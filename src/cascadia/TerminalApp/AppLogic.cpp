@@ -9,6 +9,7 @@
 #include <winrt/Microsoft.UI.Xaml.XamlTypeInfo.h>
 
 #include <LibraryResources.h>
+#include <StartupTracing.h>
 #include <WtExeUtils.h>
 
 using namespace winrt::Windows::ApplicationModel;
@@ -202,6 +203,7 @@ namespace winrt::TerminalApp::implementation
         // The TerminalPage has to be constructed during our construction, to
         // make sure that there's a terminal page for callers of
         // SetTitleBarContent
+        TRACE_STARTUP_PHASE(g_hTerminalAppProvider, "AppLogic");
         _isElevated = _isUserAdmin();
         _root = winrt::make_self<TerminalPage>();
     }
@@ -262,6 +264,7 @@ namespace winrt::TerminalApp::implementation
         // this as a MTA, before the app is Create()'d
         WINRT_ASSERT(_loadedInitialSettings);
 
+        TRACE_STARTUP_PHASE(g_hTerminalAppProvider, "CreateUI");
         _root->DialogPresenter(*this);
 
         // In UWP mode, we cannot handle taking over the title bar for tabs,
@@ -304,6 +307,10 @@ namespace winrt::TerminalApp::implementation
             {
                 _root->ToggleFocusMode();
             }
+
+            // Now that the first frame is out of the way, bring the jumplist
+            // up to date. It's updated in the background, at a low priority.
+            Jumplist::UpdateJumplist(_settings);
         });
         _root->Create();
 
@@ -724,6 +731,17 @@ namespace winrt::TerminalApp::implementation
         return _settings.GlobalSettings().AlwaysOnTop();
     }
 
+    bool AppLogic::GetInProcessWindows()
+    {
+        if (!_loadedInitialSettings)
+        {
+            // Load settings if we haven't already
+            LoadSettings();
+        }
+
+        return _settings.GlobalSettings().InProcessWindows();
+    }
+
     // Method Description:
     // - See Pane::CalcSnappedDimension
     float AppLogic::CalcSnappedDimension(const bool widthOrHeight, const float dimension) const
@@ -733,15 +751,22 @@ namespace winrt::TerminalApp::implementation
 
     // Method Description:
     // - Attempt to load the settings. If we fail for any reason, returns an error.
+    // Arguments:
+    // - loadedSettings: if provided, settings that were already loaded, which
+    //   we'll use instead of reading the settings files again.
     // Return Value:
     // - S_OK if we successfully parsed the settings, otherwise an appropriate HRESULT.
-    [[nodiscard]] HRESULT AppLogic::_TryLoadSettings() noexcept
+    [[nodiscard]] HRESULT AppLogic::_TryLoadSettings(const CascadiaSettings& loadedSettings) noexcept
     {
         HRESULT hr = E_FAIL;
 
         try
         {
-            auto newSettings = _isUwp ? CascadiaSettings::LoadUniversal() : CascadiaSettings::LoadAll();
+            auto newSettings = loadedSettings;
+            if (!newSettings)
+            {
+                newSettings = _isUwp ? CascadiaSettings::LoadUniversal() : CascadiaSettings::LoadAll();
+            }
             _settings = newSettings;
 
             if (_settings.GetLoadingError())
@@ -847,7 +872,34 @@ namespace winrt::TerminalApp::implementation
         // Register for directory change notification.
         _RegisterSettingsChange();
 
-        Jumplist::UpdateJumplist(_settings);
+        // The jumplist is updated once the page is initialized, instead of
+        // here, so that it doesn't compete with the first frame.
+    }
+
+    // Method Description:
+    // - Use the settings another AppLogic in this process already loaded,
+    //   instead of loading them again. The windows the monarch hosts in its
+    //   own process share its settings this way. Like LoadSettings, this must
+    //   be called before Create.
+    // Arguments:
+    // - other: the AppLogic whose settings we should use.
+    // Return Value:
+    // - <none>
+    void AppLogic::UseSettingsFrom(const TerminalApp::AppLogic& other)
+    {
+        const auto otherSettings = winrt::get_self<AppLogic>(other)->GetSettings();
+
+        _settingsLoadedResult = _TryLoadSettings(otherSettings);
+
+        if (FAILED(_settingsLoadedResult))
+        {
+            _settings = CascadiaSettings::LoadDefaults();
+        }
+
+        _loadedInitialSettings = true;
+
+        // Register for directory change notification.
+        _RegisterSettingsChange();
     }
 
     // Method Description:
@@ -861,12 +913,13 @@ namespace winrt::TerminalApp::implementation
     {
         // Get the containing folder.
         const std::filesystem::path settingsPath{ std::wstring_view{ CascadiaSettings::SettingsPath() } };
+        const std::filesystem::path dynamicProfilesCachePath{ std::wstring_view{ CascadiaSettings::DynamicProfilesCachePath() } };
         const auto folder = settingsPath.parent_path();
 
         _reader.create(folder.c_str(),
                        false,
                        wil::FolderChangeEvents::All,
-                       [this, settingsPath](wil::FolderChangeEvent event, PCWSTR fileModified) {
+                       [this, settingsPath, dynamicProfilesCachePath](wil::FolderChangeEvent event, PCWSTR fileModified) {
                            // We want file modifications, AND when files are renamed to be
                            // settings.json. This second case will oftentimes happen with text
                            // editors, who will write a temp file, then rename it to be the
@@ -884,7 +937,10 @@ namespace winrt::TerminalApp::implementation
                            const auto settingsBasename = settingsPath.filename();
                            const auto modifiedBasename = modifiedFilePath.filename();
 
-                           if (settingsBasename == modifiedBasename)
+                           // The dynamic profiles cache is updated when the
+                           // dynamic profile generators find different profiles
+                           // after the settings were loaded with the cached ones.
+                           if (settingsBasename == modifiedBasename || dynamicProfilesCachePath.filename() == modifiedBasename)
                            {
                                this->_DispatchReloadSettings();
                            }
@@ -1091,6 +1147,27 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Called when the window is minimized or restored.
+    // - The terminals trim their caches as they're hidden. If the settings ask
+    //   for it, the working set of the process is emptied after that as well.
+    // Arguments:
+    // - visible: whether the window can be seen
+    // Return Value:
+    // - <none>
+    void AppLogic::WindowVisibilityChanged(const bool visible)
+    {
+        if (_root)
+        {
+            _root->WindowVisibilityChanged(visible);
+        }
+
+        if (!visible && _settings && _settings.GlobalSettings().TrimWorkingSetWhenMinimized())
+        {
+            LOG_IF_WIN32_BOOL_FALSE(SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1)));
+        }
+    }
+
     // Method Description:
     // - Implements the F7 handler (per GH#638)
     // - Implements the Alt handler (per GH#6421)
@@ -1216,6 +1293,18 @@ namespace winrt::TerminalApp::implementation
         return result;
     }
 
+    // Method Description:
+    // - Sets the directory the startup commandline should be run in, when
+    //   it's not our own current directory.
+    // Arguments:
+    // - cwd: the directory the commandline was run in.
+    // Return Value:
+    // - <none>
+    void AppLogic::SetStartupDirectory(const winrt::hstring& cwd)
+    {
+        _root->SetStartupDirectory(cwd);
+    }
+
     // Method Description:
     // - Triggers the setup of the listener for incoming console connections
     //   from the operating system.
@@ -48,9 +48,11 @@ namespace winrt::TerminalApp::implementation
         void RunAsUwp();
         bool IsElevated() const noexcept;
         void LoadSettings();
+        void UseSettingsFrom(const TerminalApp::AppLogic& other);
         [[nodiscard]] Microsoft::Terminal::Settings::Model::CascadiaSettings GetSettings() const noexcept;
 
         int32_t SetStartupCommandline(array_view<const winrt::hstring> actions);
+        void SetStartupDirectory(const winrt::hstring& cwd);
         int32_t ExecuteCommandline(array_view<const winrt::hstring> actions, const winrt::hstring& cwd);
         TerminalApp::FindTargetWindowResult FindTargetWindow(array_view<const winrt::hstring> actions);
         winrt::hstring ParseCommandlineMessage();
@@ -75,6 +77,7 @@ namespace winrt::TerminalApp::implementation
         Microsoft::Terminal::Settings::Model::LaunchMode GetLaunchMode();
         bool GetShowTabsInTitlebar();
         bool GetInitialAlwaysOnTop();
+        bool GetInProcessWindows();
         float CalcSnappedDimension(const bool widthOrHeight, const float dimension) const;
 
         Windows::UI::Xaml::UIElement GetRoot() noexcept;
@@ -86,6 +89,7 @@ namespace winrt::TerminalApp::implementation
         bool OnDirectKeyEvent(const uint32_t vkey, const uint8_t scanCode, const bool down);
 
         void WindowCloseButtonClicked();
+        void WindowVisibilityChanged(const bool visible);
 
         size_t GetLastActiveControlTaskbarState();
         size_t GetLastActiveControlTaskbarProgress();
@@ -137,7 +141,7 @@ namespace winrt::TerminalApp::implementation
 
         void _OnLoaded(const IInspectable& sender, const Windows::UI::Xaml::RoutedEventArgs& eventArgs);
 
-        [[nodiscard]] HRESULT _TryLoadSettings() noexcept;
+        [[nodiscard]] HRESULT _TryLoadSettings(const Microsoft::Terminal::Settings::Model::CascadiaSettings& loadedSettings = nullptr) noexcept;
         void _RegisterSettingsChange();
         fire_and_forget _DispatchReloadSettings();
         void _ReloadSettings();
@@ -794,30 +794,18 @@ namespace winrt::TerminalApp::implementation
         // here will ensure that we can check this case appropriately.
         _lastFilterTextWasEmpty = _searchBox().Text().empty();
 
-        _updateFilteredActions();
-
-        // In the command line mode we want the user to explicitly select the command
-        _filteredActionsView().SelectedIndex(_currentMode == CommandPaletteMode::CommandlineMode ? -1 : 0);
-
-        if (_currentMode == CommandPaletteMode::TabSearchMode || _currentMode == CommandPaletteMode::ActionMode)
+        // Matching the filter against every command can take a while with a
+        // lot of them, so it's done in the background, and the list is updated
+        // once it's done. An empty filter matches everything, and the tab
+        // switcher doesn't filter at all, so they're updated right away.
+        if (_currentMode == CommandPaletteMode::TabSwitchMode || _getTrimmedInput().empty())
         {
-            const auto currentNeedleHasResults{ _filteredActions.Size() > 0 };
-            _noMatchesText().Visibility(currentNeedleHasResults ? Visibility::Collapsed : Visibility::Visible);
-            if (!currentNeedleHasResults)
-            {
-                if (auto automationPeer{ Automation::Peers::FrameworkElementAutomationPeer::FromElement(_searchBox()) })
-                {
-                    automationPeer.RaiseNotificationEvent(
-                        Automation::Peers::AutomationNotificationKind::ActionCompleted,
-                        Automation::Peers::AutomationNotificationProcessing::ImportantMostRecent,
-                        NoMatchesText(), // NoMatchesText contains the right text for the current mode
-                        L"CommandPaletteResultAnnouncement" /* unique name for this notification */);
-                }
-            }
+            _updateFilteredActions();
+            _filteredActionsChanged();
         }
         else
         {
-            _noMatchesText().Visibility(Visibility::Collapsed);
+            _updateFilteredActionsAsync();
         }
 
         if (_currentMode == CommandPaletteMode::CommandlineMode)
@@ -1029,8 +1017,8 @@ namespace winrt::TerminalApp::implementation
             for (const auto& action : commandsToFilter)
             {
                 // Update filter for all commands
-                // This will modify the highlighting but will also lead to re-computation of weight (and consequently sorting).
-                // Pay attention that it already updates the highlighting in the UI
+                // This will lead to re-computation of weight (and consequently sorting).
+                // The highlighting is only recomputed for the items the UI shows.
                 action.UpdateFilter(searchText);
 
                 // if there is active search we skip commands with 0 weight
@@ -1059,8 +1047,103 @@ namespace winrt::TerminalApp::implementation
     // - <none>
     void CommandPalette::_updateFilteredActions()
     {
-        auto actions = _collectFilteredActions();
+        // This overtakes any update still running in the background.
+        ++_filterGeneration;
+        _applyFilteredActions(_collectFilteredActions());
+    }
+
+    // Method Description:
+    // - Update our list of filtered actions to reflect the current contents of
+    //   the input box, matching the commands against it on a background thread.
+    // - Only the names are matched in the background. The FilteredCommands are
+    //   only touched back on the UI thread, and a match that was overtaken by
+    //   another update (a newer keystroke) is abandoned.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    winrt::fire_and_forget CommandPalette::_updateFilteredActionsAsync()
+    {
+        const auto generation = ++_filterGeneration;
+        const winrt::hstring searchText{ _getTrimmedInput() };
+        const auto sort = _currentMode == CommandPaletteMode::ActionMode;
+
+        std::vector<winrt::TerminalApp::FilteredCommand> commands;
+        for (const auto& command : _commandsToFilter())
+        {
+            commands.push_back(command);
+        }
+        std::vector<winrt::hstring> names;
+        names.reserve(commands.size());
+        for (const auto& command : commands)
+        {
+            names.push_back(command.Item().Name());
+        }
+
+        auto strongThis{ get_strong() };
+        const auto dispatcher = Dispatcher();
+
+        co_await winrt::resume_background();
+
+        std::vector<int> weights(names.size());
+        std::vector<size_t> matches;
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            // Check every now and then whether a newer update took over.
+            if (i % 256 == 0 && _filterGeneration.load() != generation)
+            {
+                co_return;
+            }
+            weights[i] = FilteredCommand::ComputeWeight(names[i], searchText);
+            if (weights[i] > 0)
+            {
+                matches.push_back(i);
+            }
+        }
+
+        // The same order FilteredCommand::Compare gives.
+        if (sort)
+        {
+            std::stable_sort(matches.begin(), matches.end(), [&](const size_t first, const size_t second) {
+                if (weights[first] == weights[second])
+                {
+                    return lstrcmpi(names[first].c_str(), names[second].c_str()) < 0;
+                }
+                return weights[first] > weights[second];
+            });
+        }
 
+        co_await winrt::resume_foreground(dispatcher);
+
+        if (_filterGeneration.load() != generation)
+        {
+            co_return;
+        }
+
+        for (size_t i = 0; i < commands.size(); ++i)
+        {
+            winrt::get_self<FilteredCommand>(commands[i])->UpdateFilter(searchText, weights[i]);
+        }
+
+        std::vector<winrt::TerminalApp::FilteredCommand> actions;
+        actions.reserve(matches.size());
+        for (const auto i : matches)
+        {
+            actions.push_back(commands[i]);
+        }
+
+        _applyFilteredActions(actions);
+        _filteredActionsChanged();
+    }
+
+    // Method Description:
+    // - Makes the list of filtered actions look identical to the given ones.
+    // Arguments:
+    // - actions: the actions the list should have, in order
+    // Return Value:
+    // - <none>
+    void CommandPalette::_applyFilteredActions(const std::vector<winrt::TerminalApp::FilteredCommand>& actions)
+    {
         // Make _filteredActions look identical to actions, using only Insert and Remove.
         // This allows WinUI to nicely animate the ListView as it changes.
         for (uint32_t i = 0; i < _filteredActions.Size() && i < actions.size(); i++)
@@ -1096,6 +1179,40 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Selects the first of the filtered actions after they were updated for
+    //   a new filter, and announces when there are none.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void CommandPalette::_filteredActionsChanged()
+    {
+        // In the command line mode we want the user to explicitly select the command
+        _filteredActionsView().SelectedIndex(_currentMode == CommandPaletteMode::CommandlineMode ? -1 : 0);
+
+        if (_currentMode == CommandPaletteMode::TabSearchMode || _currentMode == CommandPaletteMode::ActionMode)
+        {
+            const auto currentNeedleHasResults{ _filteredActions.Size() > 0 };
+            _noMatchesText().Visibility(currentNeedleHasResults ? Visibility::Collapsed : Visibility::Visible);
+            if (!currentNeedleHasResults)
+            {
+                if (auto automationPeer{ Automation::Peers::FrameworkElementAutomationPeer::FromElement(_searchBox()) })
+                {
+                    automationPeer.RaiseNotificationEvent(
+                        Automation::Peers::AutomationNotificationKind::ActionCompleted,
+                        Automation::Peers::AutomationNotificationProcessing::ImportantMostRecent,
+                        NoMatchesText(), // NoMatchesText contains the right text for the current mode
+                        L"CommandPaletteResultAnnouncement" /* unique name for this notification */);
+                }
+            }
+        }
+        else
+        {
+            _noMatchesText().Visibility(Visibility::Collapsed);
+        }
+    }
+
     // Method Description:
     // - Dismiss the command palette. This will:
     //   * select all the current text in the input box
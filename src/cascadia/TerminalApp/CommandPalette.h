@@ -96,9 +96,16 @@ namespace winrt::TerminalApp::implementation
         void _moveBackButtonClicked(Windows::Foundation::IInspectable const& sender, Windows::UI::Xaml::RoutedEventArgs const&);
 
         void _updateFilteredActions();
+        winrt::fire_and_forget _updateFilteredActionsAsync();
+        void _applyFilteredActions(const std::vector<winrt::TerminalApp::FilteredCommand>& actions);
+        void _filteredActionsChanged();
 
         std::vector<winrt::TerminalApp::FilteredCommand> _collectFilteredActions();
 
+        // Bumped every time the filtered actions are updated, so that a
+        // background update that was overtaken by another one is dropped.
+        std::atomic<uint64_t> _filterGeneration{ 0 };
+
         void _close();
 
         CommandPaletteMode _currentMode;
@@ -26,14 +26,12 @@ namespace winrt::TerminalApp::implementation
         _Filter(L""),
         _Weight(0)
     {
-        _HighlightedName = _computeHighlightedName();
-
         // Recompute the highlighted name if the item name changes
         _itemChangedRevoker = _Item.PropertyChanged(winrt::auto_revoke, [weakThis{ get_weak() }](auto& /*sender*/, auto& e) {
             auto filteredCommand{ weakThis.get() };
             if (filteredCommand && e.PropertyName() == L"Name")
             {
-                filteredCommand->HighlightedName(filteredCommand->_computeHighlightedName());
+                filteredCommand->_invalidateHighlightedName();
                 filteredCommand->Weight(filteredCommand->_computeWeight());
             }
         });
@@ -43,12 +41,38 @@ namespace winrt::TerminalApp::implementation
     {
         // If the filter was not changed we want to prevent the re-computation of matching
         // that might result in triggering a notification event
+        if (filter != _Filter)
+        {
+            UpdateFilter(filter, ComputeWeight(_Item.Name(), filter));
+        }
+    }
+
+    // Method Description:
+    // - Updates the filter with a weight that was already computed for it,
+    //   by ComputeWeight on a background thread for instance.
+    void FilteredCommand::UpdateFilter(winrt::hstring const& filter, const int weight)
+    {
         if (filter != _Filter)
         {
             Filter(filter);
-            HighlightedName(_computeHighlightedName());
-            Weight(_computeWeight());
+            _invalidateHighlightedName();
         }
+        Weight(weight);
+    }
+
+    winrt::TerminalApp::HighlightedText FilteredCommand::HighlightedName()
+    {
+        if (!_HighlightedName)
+        {
+            _HighlightedName = _computeHighlightedName();
+        }
+        return _HighlightedName;
+    }
+
+    void FilteredCommand::_invalidateHighlightedName()
+    {
+        _HighlightedName = nullptr;
+        _PropertyChangedHandlers(*this, Windows::UI::Xaml::Data::PropertyChangedEventArgs{ L"HighlightedName" });
     }
 
     // Method Description:
@@ -184,22 +208,55 @@ namespace winrt::TerminalApp::implementation
     //     Controls".
     //   * "sv" would return "[ | ] Split Vertical" (by matching the **S** in
     //     "Split", then the **V** in "Vertical").
+    // - The characters are matched the same way _computeHighlightedName does,
+    //   but without creating any of the segments, so that it can be called
+    //   for all of the commands (and on a background thread).
     // Arguments:
-    // - searchText: the string of text to search for in `name`
     // - name: the name to check
+    // - filter: the string of text to search for in `name`
     // Return Value:
     // - the relative weight of this match
-    int FilteredCommand::_computeWeight()
+    int FilteredCommand::ComputeWeight(const std::wstring_view name, const std::wstring_view filter)
     {
+        if (filter.empty())
+        {
+            return 0;
+        }
+
+        // The matched characters, the ones that _computeHighlightedName highlights.
+        std::vector<bool> matched(name.size());
+        size_t offset = 0;
+        for (const auto searchChar : filter)
+        {
+            const WCHAR searchCharAsString[] = { searchChar, L'\0' };
+            for (;; ++offset)
+            {
+                if (offset == name.size())
+                {
+                    return 0;
+                }
+                const WCHAR currentCharAsString[] = { til::at(name, offset), L'\0' };
+                if (lstrcmpi(searchCharAsString, currentCharAsString) == 0)
+                {
+                    matched[offset++] = true;
+                    break;
+                }
+            }
+        }
+
         int result = 0;
         bool isNextSegmentWordBeginning = true;
 
-        for (const auto& segment : _HighlightedName.Segments())
+        for (size_t begin = 0; begin < name.size();)
         {
-            const auto& segmentText = segment.TextSegment();
-            const auto segmentSize = segmentText.size();
+            auto end = begin + 1;
+            while (end < name.size() && matched[end] == matched[begin])
+            {
+                ++end;
+            }
+            const auto segmentSize = gsl::narrow_cast<int>(end - begin);
 
-            if (segment.IsHighlighted())
+            if (matched[begin])
             {
                 // Give extra point for each consecutive match
                 result += (segmentSize <= 1) ? segmentSize : 1 + 2 * (segmentSize - 1);
@@ -211,12 +268,18 @@ namespace winrt::TerminalApp::implementation
                 }
             }
 
-            isNextSegmentWordBeginning = segmentSize > 0 && segmentText[segmentSize - 1] == L' ';
+            isNextSegmentWordBeginning = til::at(name, end - 1) == L' ';
+            begin = end;
         }
 
         return result;
     }
 
+    int FilteredCommand::_computeWeight()
+    {
+        return ComputeWeight(_Item.Name(), _Filter);
+    }
+
     // Function Description:
     // - Implementation of Compare for FilteredCommand interface.
     // Compares first instance of the interface with the second instance, first by weight, then by name.
@@ -21,16 +21,24 @@ namespace winrt::TerminalApp::implementation
         FilteredCommand(winrt::TerminalApp::PaletteItem const& item);
 
         void UpdateFilter(winrt::hstring const& filter);
+        void UpdateFilter(winrt::hstring const& filter, const int weight);
+
+        winrt::TerminalApp::HighlightedText HighlightedName();
 
         static int Compare(winrt::TerminalApp::FilteredCommand const& first, winrt::TerminalApp::FilteredCommand const& second);
+        static int ComputeWeight(const std::wstring_view name, const std::wstring_view filter);
 
         WINRT_CALLBACK(PropertyChanged, Windows::UI::Xaml::Data::PropertyChangedEventHandler);
         WINRT_OBSERVABLE_PROPERTY(winrt::TerminalApp::PaletteItem, Item, _PropertyChangedHandlers, nullptr);
         WINRT_OBSERVABLE_PROPERTY(winrt::hstring, Filter, _PropertyChangedHandlers);
-        WINRT_OBSERVABLE_PROPERTY(winrt::TerminalApp::HighlightedText, HighlightedName, _PropertyChangedHandlers);
         WINRT_OBSERVABLE_PROPERTY(int, Weight, _PropertyChangedHandlers);
 
     private:
+        // The highlighted name is only computed once it's asked for, by the
+        // list items that are realized on screen.
+        winrt::TerminalApp::HighlightedText _HighlightedName{ nullptr };
+        void _invalidateHighlightedName();
+
         winrt::TerminalApp::HighlightedText _computeHighlightedName();
         int _computeWeight();
         Windows::UI::Xaml::Data::INotifyPropertyChanged::PropertyChanged_revoker _itemChangedRevoker;
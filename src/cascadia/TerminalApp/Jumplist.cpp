@@ -19,6 +19,9 @@ DEFINE_PROPERTYKEY(PKEY_AppUserModel_DestListLogoUri, 0x9F4C2855, 0x9F79, 0x4B39
         { 0x9F4C2855, 0x9F79, 0x4B39, 0xA8, 0xD0, 0xE1, 0xD4, 0x2D, 0xE1, 0xD5, 0xF3 }, 29 \
     }
 
+// The hash of the profiles the jumplist was last made of lives next to the settings file.
+static constexpr std::wstring_view JumplistHashFilename{ L"jumplist.cache" };
+
 // Function Description:
 // - This function guesses whether a string is a file path.
 static constexpr bool _isProbableFilePath(std::wstring_view path)
@@ -67,8 +70,28 @@ winrt::fire_and_forget Jumplist::UpdateJumplist(const CascadiaSettings& settings
 
     co_await winrt::resume_background();
 
+    // Nobody waits for the jumplist, so it's updated with a low CPU and I/O
+    // priority, to stay out of the way of the terminals that are starting up.
+    const auto backgroundMode = SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+    const auto restorePriority = wil::scope_exit([&]() noexcept {
+        if (backgroundMode)
+        {
+            SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+        }
+    });
+
     try
     {
+        const auto profiles = strongSettings.ActiveProfiles().GetView();
+
+        // The shell keeps the jumplist between launches, so there's nothing
+        // to do if the profiles look the same as the last time we made it.
+        const auto hash = _hashProfiles(profiles);
+        if (hash == _loadLastHash())
+        {
+            co_return;
+        }
+
         auto jumplistInstance = winrt::create_instance<ICustomDestinationList>(CLSID_DestinationList, CLSCTX_ALL);
 
         // Start the Jumplist edit transaction
@@ -81,7 +104,7 @@ winrt::fire_and_forget Jumplist::UpdateJumplist(const CascadiaSettings& settings
         THROW_IF_FAILED(jumplistItems->Clear());
 
         // Update the list of profiles.
-        THROW_IF_FAILED(_updateProfiles(jumplistItems.get(), strongSettings.ActiveProfiles().GetView()));
+        THROW_IF_FAILED(_updateProfiles(jumplistItems.get(), profiles));
 
         // TODO GH#1571: Add items from the future customizable new tab dropdown as well.
         // This could either replace the default profiles, or be added alongside them.
@@ -92,10 +115,91 @@ winrt::fire_and_forget Jumplist::UpdateJumplist(const CascadiaSettings& settings
         THROW_IF_FAILED(jumplistInstance->AddUserTasks(jumplistItems.get()));
 
         THROW_IF_FAILED(jumplistInstance->CommitList());
+
+        _storeLastHash(hash);
     }
     CATCH_LOG();
 }
 
+// Method Description:
+// - Hashes everything about the profiles that ends up in the jumplist, along
+//   with the path of wt.exe, which changes when the package is updated.
+// - This uses FNV-1a, instead of std::hash, since the hash is compared with
+//   one that a different build of the Terminal may have stored.
+// Arguments:
+// - profiles - The profiles the jumplist is made of
+// Return Value:
+// - The hash of the profiles
+[[nodiscard]] uint64_t Jumplist::_hashProfiles(winrt::Windows::Foundation::Collections::IVectorView<Profile> profiles)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    const auto hashBytes = [&](const void* data, const size_t size) noexcept {
+        for (const auto b : gsl::span{ static_cast<const uint8_t*>(data), size })
+        {
+            hash = (hash ^ b) * 0x100000001b3;
+        }
+    };
+    const auto hashString = [&](const std::wstring_view str) noexcept {
+        hashBytes(str.data(), str.size() * sizeof(wchar_t));
+        // Terminate every string, so that "ab" + "c" and "a" + "bc" don't hash the same.
+        hashBytes(L"", sizeof(wchar_t));
+    };
+
+    hashString(GetWtExePath());
+    for (const auto& profile : profiles)
+    {
+        const auto guid = profile.Guid();
+        hashBytes(&guid, sizeof(guid));
+        hashString(profile.Name());
+        hashString(profile.Icon());
+    }
+    return hash;
+}
+
+// Method Description:
+// - Reads the hash of the profiles that the jumplist was last updated with.
+// Return Value:
+// - The hash, or 0 if there is none.
+[[nodiscard]] uint64_t Jumplist::_loadLastHash() noexcept
+try
+{
+    const auto path = std::filesystem::path{ std::wstring_view{ CascadiaSettings::SettingsPath() } }.replace_filename(JumplistHashFilename);
+    wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    if (!file)
+    {
+        return 0;
+    }
+
+    uint64_t hash = 0;
+    DWORD read = 0;
+    if (!ReadFile(file.get(), &hash, sizeof(hash), &read, nullptr) || read != sizeof(hash))
+    {
+        return 0;
+    }
+    return hash;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return 0;
+}
+
+// Method Description:
+// - Remembers the hash of the profiles that the jumplist was updated with.
+// Arguments:
+// - hash - The hash of the profiles
+void Jumplist::_storeLastHash(const uint64_t hash) noexcept
+try
+{
+    const auto path = std::filesystem::path{ std::wstring_view{ CascadiaSettings::SettingsPath() } }.replace_filename(JumplistHashFilename);
+    wil::unique_hfile file{ CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+
+    DWORD written = 0;
+    THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), &hash, sizeof(hash), &written, nullptr));
+}
+CATCH_LOG()
+
 // Method Description:
 // - Creates and adds a ShellLink object to the Jumplist for each profile.
 // Arguments:
@@ -21,6 +21,7 @@ using namespace TerminalApp;
 
 static const int PaneBorderSize = 2;
 static const int CombinedPaneBorderSize = 2 * PaneBorderSize;
+static const size_t LayoutCacheEntries = 32;
 
 // WARNING: Don't do this! This won't work
 //   Duration duration{ std::chrono::milliseconds{ 200 } };
@@ -33,6 +34,32 @@ static const Duration AnimationDuration = DurationHelper::FromTimeSpan(winrt::Wi
 
 winrt::Windows::UI::Xaml::Media::SolidColorBrush Pane::s_focusedBorderBrush = { nullptr };
 winrt::Windows::UI::Xaml::Media::SolidColorBrush Pane::s_unfocusedBorderBrush = { nullptr };
+std::atomic<uint64_t> Pane::s_layoutGeneration{ 1 };
+
+// Function Description:
+// - Looks up the result of a layout calculation for the given size in one of
+//   the lists of a LayoutCache, and calculates (and adds) it if it isn't there.
+// - The lists only hold the sizes that were asked about lately: a resize asks
+//   about the same few sizes over and over, for every level of the tree.
+template<typename T, typename F>
+static T _LookupOrCompute(std::vector<std::pair<float, T>>& entries, const float size, F&& compute)
+{
+    for (const auto& [cachedSize, result] : entries)
+    {
+        if (cachedSize == size)
+        {
+            return result;
+        }
+    }
+
+    const auto result = compute();
+    if (entries.size() >= LayoutCacheEntries)
+    {
+        entries.erase(entries.begin());
+    }
+    entries.emplace_back(size, result);
+    return result;
+}
 
 Pane::Pane(const GUID& profile, const TermControl& control, const bool lastFocused) :
     _control{ control },
@@ -61,6 +88,9 @@ Pane::Pane(const GUID& profile, const TermControl& control, const bool lastFocus
     _gotFocusRevoker = control.GotFocus(winrt::auto_revoke, { this, &Pane::_ControlGotFocusHandler });
     _lostFocusRevoker = control.LostFocus(winrt::auto_revoke, { this, &Pane::_ControlLostFocusHandler });
 
+    // The cell size of the control is cached along with the layout.
+    _fontSizeChangedRevoker = control.FontSizeChanged(winrt::auto_revoke, [](auto&&...) { _InvalidateLayout(); });
+
     // When our border is tapped, make sure to transfer focus to our control.
     // LOAD-BEARING: This will NOT work if the border's BorderBrush is set to
     // Colors::Transparent! The border won't get Tapped events, and they'll fall
@@ -153,6 +183,7 @@ bool Pane::_Resize(const ResizeDirection& direction)
     const auto actualDimension = changeWidth ? actualSize.Width : actualSize.Height;
 
     _desiredSplitPosition = _ClampSplitPosition(changeWidth, _desiredSplitPosition - amount, actualDimension);
+    _InvalidateLayout();
 
     // Resize our columns to match the new percentages.
     ResizeContent(actualSize);
@@ -453,6 +484,21 @@ void Pane::Shutdown()
     }
 }
 
+// Method Description:
+// - Tells the controls beneath this pane whether the window can be seen.
+void Pane::WindowVisibilityChanged(const bool visible)
+{
+    if (_IsLeaf())
+    {
+        _control.WindowVisibilityChanged(visible);
+    }
+    else
+    {
+        _firstChild->WindowVisibilityChanged(visible);
+        _secondChild->WindowVisibilityChanged(visible);
+    }
+}
+
 // Method Description:
 // - Get the root UIElement of this pane. There may be a single TermControl as a
 //   child, or an entire tree of grids and panes as children of this element.
@@ -661,6 +707,9 @@ void Pane::UpdateSettings(const TerminalSettingsCreateResult& settings, const GU
         if (profile == _profile)
         {
             auto controlSettings = _control.Settings().as<TerminalSettings>();
+            const auto oldSettings{ controlSettings.GetParent() };
+            const auto oldUnfocusedSettings{ _control.UnfocusedAppearance().try_as<TerminalSettings>() };
+
             // Update the parent of the control's settings object (and not the object itself) so
             // that any overrides made by the control don't get affected by the reload
             controlSettings.SetParent(settings.DefaultSettings());
@@ -674,7 +723,21 @@ void Pane::UpdateSettings(const TerminalSettingsCreateResult& settings, const GU
                 unfocusedSettings.SetParent(controlSettings);
             }
             _control.UnfocusedAppearance(unfocusedSettings);
+
+            // Most reloads only change a few profiles (or nothing at all, when the
+            // file was just saved again). Updating a control reloads its font and
+            // renderer settings, so the ones whose settings are the same are skipped.
+            const auto sameSettings = oldSettings && oldSettings.HasSameSettings(settings.DefaultSettings());
+            const auto sameUnfocusedSettings = oldUnfocusedSettings ? oldUnfocusedSettings.HasSameSettings(unfocusedSettings) : !unfocusedSettings;
+            if (sameSettings && sameUnfocusedSettings)
+            {
+                return;
+            }
+
             _control.UpdateSettings();
+
+            // The padding and the scrollbar might have changed.
+            _InvalidateLayout();
         }
     }
 }
@@ -725,6 +788,7 @@ void Pane::_CloseChild(const bool closeFirst)
         // Add our new event handler before revoking the old one.
         _connectionStateChangedToken = _control.ConnectionStateChanged({ this, &Pane::_ControlConnectionStateChangedHandler });
         _warningBellToken = _control.WarningBell({ this, &Pane::_ControlWarningBellHandler });
+        _fontSizeChangedRevoker = _control.FontSizeChanged(winrt::auto_revoke, [](auto&&...) { _InvalidateLayout(); });
 
         // Revoke the old event handlers. Remove both the handlers for the panes
         // themselves closing, and remove their handlers for their controls
@@ -1116,6 +1180,9 @@ void Pane::_UpdateBorders()
         }
     }
     _border.BorderThickness(ThicknessHelper::FromLengths(left, top, right, bottom));
+
+    // The borders are part of the size of the pane.
+    _InvalidateLayout();
 }
 
 // Method Description:
@@ -1489,6 +1556,7 @@ std::pair<std::shared_ptr<Pane>, std::shared_ptr<Pane>> Pane::_Split(SplitState
     _firstChild->_connectionState = std::exchange(_connectionState, ConnectionState::NotConnected);
     _profile = std::nullopt;
     _control = { nullptr };
+    _fontSizeChangedRevoker.revoke();
     _secondChild = std::make_shared<Pane>(profile, control);
 
     _CreateRowColDefinitions();
@@ -1674,6 +1742,21 @@ Pane::SnapChildrenSizeResult Pane::_CalcSnappedChildrenSizes(const bool widthOrH
         THROW_HR(E_FAIL);
     }
 
+    auto& cache = _GetLayoutCache().snappedChildrenSizes[widthOrHeight];
+    return _LookupOrCompute(cache, fullSize, [&]() { return _ComputeSnappedChildrenSizes(widthOrHeight, fullSize); });
+}
+
+// Method Description:
+// - Calculates the sizes _CalcSnappedChildrenSizes returns, without its cache.
+// Arguments:
+// - widthOrHeight: if true, operates on width, otherwise on height.
+// - fullSize: the amount of space in pixels that should be filled by our children and
+//   their separator. Can be arbitrarily low.
+// Return Value:
+// - See _CalcSnappedChildrenSizes.
+Pane::SnapChildrenSizeResult Pane::_ComputeSnappedChildrenSizes(const bool widthOrHeight, const float fullSize) const
+{
+
     //   First we build a tree of nodes corresponding to the tree of our descendant panes.
     // Each node represents a size of given pane. At the beginning, each node has the minimum
     // size that the corresponding pane can have; so has the our (root) node. We then gradually
@@ -1742,6 +1825,19 @@ float Pane::CalcSnappedDimension(const bool widthOrHeight, const float dimension
 //   requested size) and second is the size snapped upward (not lower than requested size).
 //   If requested size is already snapped, then both returned values equal this value.
 Pane::SnapSizeResult Pane::_CalcSnappedDimension(const bool widthOrHeight, const float dimension) const
+{
+    auto& cache = _GetLayoutCache().snappedDimensions[widthOrHeight];
+    return _LookupOrCompute(cache, dimension, [&]() { return _ComputeSnappedDimension(widthOrHeight, dimension); });
+}
+
+// Method Description:
+// - Calculates the sizes _CalcSnappedDimension returns, without its cache.
+// Arguments:
+// - widthOrHeight: if true operates on width, otherwise on height
+// - dimension: a dimension (width or height) to be snapped
+// Return Value:
+// - See _CalcSnappedDimension.
+Pane::SnapSizeResult Pane::_ComputeSnappedDimension(const bool widthOrHeight, const float dimension) const
 {
     if (_IsLeaf())
     {
@@ -1775,7 +1871,7 @@ Pane::SnapSizeResult Pane::_CalcSnappedDimension(const bool widthOrHeight, const
         }
         else
         {
-            const auto cellSize = _control.CharacterDimensions();
+            const auto cellSize = _GetCellSize();
             const auto higher = lower + (widthOrHeight ? cellSize.Width : cellSize.Height);
             return { lower, higher };
         }
@@ -1835,7 +1931,7 @@ void Pane::_AdvanceSnappedDimension(const bool widthOrHeight, LayoutSizeNode& si
         }
         else
         {
-            const auto cellSize = _control.CharacterDimensions();
+            const auto cellSize = _GetCellSize();
             sizeNode.size += widthOrHeight ? cellSize.Width : cellSize.Height;
         }
     }
@@ -1938,6 +2034,22 @@ void Pane::_AdvanceSnappedDimension(const bool widthOrHeight, LayoutSizeNode& si
 // - The minimum size that this pane can be resized to and still have a visible
 //   character.
 Size Pane::_GetMinSize() const
+{
+    auto& cache = _GetLayoutCache();
+    if (!cache.minSize)
+    {
+        cache.minSize = _ComputeMinSize();
+    }
+    return *cache.minSize;
+}
+
+// Method Description:
+// - Calculates the size _GetMinSize returns, without its cache.
+// Arguments:
+// - <none>
+// Return Value:
+// - See _GetMinSize.
+Size Pane::_ComputeMinSize() const
 {
     if (_IsLeaf())
     {
@@ -1968,6 +2080,65 @@ Size Pane::_GetMinSize() const
     }
 }
 
+// Method Description:
+// - Get the size of a character cell of our control. Only valid for leaves.
+// Arguments:
+// - <none>
+// Return Value:
+// - The size of a character cell, in pixels.
+Size Pane::_GetCellSize() const
+{
+    auto& cache = _GetLayoutCache();
+    if (!cache.cellSize)
+    {
+        cache.cellSize = _control.CharacterDimensions();
+    }
+    return *cache.cellSize;
+}
+
+// Method Description:
+// - Get the layout cache of this pane, after discarding its contents if any
+//   pane changed since they were calculated.
+// Arguments:
+// - <none>
+// Return Value:
+// - The layout cache of this pane.
+Pane::LayoutCache& Pane::_GetLayoutCache() const noexcept
+{
+    const auto generation = s_layoutGeneration.load(std::memory_order_relaxed);
+    if (_layoutCache.generation != generation)
+    {
+        _layoutCache.generation = generation;
+        _layoutCache.minSize.reset();
+        _layoutCache.cellSize.reset();
+        for (auto& entries : _layoutCache.snappedDimensions)
+        {
+            entries.clear();
+        }
+        for (auto& entries : _layoutCache.snappedChildrenSizes)
+        {
+            entries.clear();
+        }
+    }
+    return _layoutCache;
+}
+
+// Method Description:
+// - Discards the layout caches of all panes. This has to be called whenever
+//   anything that the layout depends on changes: the tree of panes, their
+//   borders or split positions, or the font, padding or scrollbar of a control.
+// - Since panes don't know their parents, this discards the caches of every
+//   pane, not just the ancestors of the one that changed. These things all
+//   change rarely compared to how often the layout is calculated.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Pane::_InvalidateLayout() noexcept
+{
+    s_layoutGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
 // Method Description:
 // - Builds a tree of LayoutSizeNode that matches the tree of panes. Each node
 //   has minimum size that the corresponding pane can have.
@@ -2133,6 +2304,21 @@ bool Pane::ContainsReadOnly() const
     return _IsLeaf() ? _control.ReadOnly() : (_firstChild->ContainsReadOnly() || _secondChild->ContainsReadOnly());
 }
 
+// Method Description:
+// - Appends the controls of this pane and all of its descendants to controls.
+void Pane::CollectTerminalControls(std::vector<TermControl>& controls) const
+{
+    if (_IsLeaf())
+    {
+        controls.push_back(_control);
+    }
+    else
+    {
+        _firstChild->CollectTerminalControls(controls);
+        _secondChild->CollectTerminalControls(controls);
+    }
+}
+
 DEFINE_EVENT(Pane, GotFocus, _GotFocusHandlers, winrt::delegate<std::shared_ptr<Pane>>);
 DEFINE_EVENT(Pane, LostFocus, _LostFocusHandlers, winrt::delegate<std::shared_ptr<Pane>>);
 DEFINE_EVENT(Pane, PaneRaiseBell, _PaneRaiseBellHandlers, winrt::Windows::Foundation::EventHandler<bool>);
@@ -70,6 +70,7 @@ public:
                                              const winrt::Windows::Foundation::Size availableSpace) const;
     void Shutdown();
     void Close();
+    void WindowVisibilityChanged(const bool visible);
 
     int GetLeafPaneCount() const noexcept;
 
@@ -81,6 +82,7 @@ public:
     bool FocusPane(const uint32_t id);
 
     bool ContainsReadOnly() const;
+    void CollectTerminalControls(std::vector<winrt::Microsoft::Terminal::Control::TermControl>& controls) const;
 
     WINRT_CALLBACK(Closed, winrt::Windows::Foundation::EventHandler<winrt::Windows::Foundation::IInspectable>);
     DECLARE_EVENT(GotFocus, _GotFocusHandlers, winrt::delegate<std::shared_ptr<Pane>>);
@@ -115,6 +117,7 @@ private:
 
     winrt::Windows::UI::Xaml::UIElement::GotFocus_revoker _gotFocusRevoker;
     winrt::Windows::UI::Xaml::UIElement::LostFocus_revoker _lostFocusRevoker;
+    winrt::Microsoft::Terminal::Control::TermControl::FontSizeChanged_revoker _fontSizeChangedRevoker;
 
     std::shared_mutex _createCloseLock{};
 
@@ -153,10 +156,14 @@ private:
 
     std::pair<float, float> _CalcChildrenSizes(const float fullSize) const;
     SnapChildrenSizeResult _CalcSnappedChildrenSizes(const bool widthOrHeight, const float fullSize) const;
+    SnapChildrenSizeResult _ComputeSnappedChildrenSizes(const bool widthOrHeight, const float fullSize) const;
     SnapSizeResult _CalcSnappedDimension(const bool widthOrHeight, const float dimension) const;
+    SnapSizeResult _ComputeSnappedDimension(const bool widthOrHeight, const float dimension) const;
     void _AdvanceSnappedDimension(const bool widthOrHeight, LayoutSizeNode& sizeNode) const;
 
     winrt::Windows::Foundation::Size _GetMinSize() const;
+    winrt::Windows::Foundation::Size _ComputeMinSize() const;
+    winrt::Windows::Foundation::Size _GetCellSize() const;
     LayoutSizeNode _CreateMinSizeTree(const bool widthOrHeight) const;
     float _ClampSplitPosition(const bool widthOrHeight, const float requestedValue, const float totalSize) const;
 
@@ -200,6 +207,8 @@ private:
 
     static void _SetupResources();
 
+    static void _InvalidateLayout() noexcept;
+
     struct SnapSizeResult
     {
         float lower;
@@ -236,4 +245,22 @@ private:
     private:
         void _AssignChildNode(std::unique_ptr<LayoutSizeNode>& nodeField, const LayoutSizeNode* const newNode);
     };
+
+    // The results of the layout calculations of a pane, for the sizes it was
+    // asked about lately. They're only valid for as long as no pane changes
+    // in a way that affects the layout: _InvalidateLayout then bumps
+    // s_layoutGeneration, which discards all of them.
+    struct LayoutCache
+    {
+        uint64_t generation{ 0 };
+        std::optional<winrt::Windows::Foundation::Size> minSize;
+        std::optional<winrt::Windows::Foundation::Size> cellSize;
+        // Indexed by widthOrHeight.
+        std::vector<std::pair<float, SnapSizeResult>> snappedDimensions[2];
+        std::vector<std::pair<float, SnapChildrenSizeResult>> snappedChildrenSizes[2];
+    };
+
+    static std::atomic<uint64_t> s_layoutGeneration;
+    mutable LayoutCache _layoutCache;
+    LayoutCache& _GetLayoutCache() const noexcept;
 };
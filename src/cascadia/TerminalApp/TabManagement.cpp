@@ -405,6 +405,18 @@ namespace winrt::TerminalApp::implementation
         // To close the window here, we need to close the hosting window.
         if (_tabs.Size() == 0)
         {
+            // What was copied last might have formats that weren't generated yet.
+            // They have to be, or they're gone from the clipboard once we exit.
+            if (_clipboardNeedsFlush)
+            {
+                _clipboardNeedsFlush = false;
+                try
+                {
+                    Clipboard::Flush();
+                }
+                CATCH_LOG();
+            }
+
             _LastTabClosedHandlers(*this, nullptr);
         }
         else if (focusedTabIndex.has_value() && focusedTabIndex.value() == gsl::narrow_cast<uint32_t>(tabIndex))
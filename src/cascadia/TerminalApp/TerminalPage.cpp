@@ -7,6 +7,7 @@
 #include "../../types/inc/utils.hpp"
 
 #include <LibraryResources.h>
+#include <StartupTracing.h>
 
 #include "TerminalPage.g.cpp"
 #include <winrt/Windows.Storage.h>
@@ -116,6 +117,8 @@ namespace winrt::TerminalApp::implementation
 
     void TerminalPage::Create()
     {
+        TRACE_STARTUP_PHASE(g_hTerminalAppProvider, "TerminalPage");
+
         // Hookup the key bindings
         _HookupKeyBindings(_settings.ActionMap());
 
@@ -313,7 +316,7 @@ namespace winrt::TerminalApp::implementation
         if (_startupState == StartupState::NotInitialized)
         {
             _startupState = StartupState::InStartup;
-            ProcessStartupActions(_startupActions, true);
+            ProcessStartupActions(_startupActions, true, _startupDirectory);
 
             // If we were told that the COM server needs to be started to listen for incoming
             // default application connections, start it now.
@@ -987,6 +990,8 @@ namespace winrt::TerminalApp::implementation
     {
         term.RaiseNotice({ this, &TerminalPage::_ControlNoticeRaisedHandler });
 
+        term.ExportProgressChanged({ get_weak(), &TerminalPage::_ControlExportProgressHandler });
+
         // Add an event handler when the terminal's selection wants to be copied.
         // When the text buffer data is retrieved, we'll copy the data into the Clipboard
         term.CopyToClipboard({ this, &TerminalPage::_CopyToClipboardHandler });
@@ -1456,30 +1461,42 @@ namespace winrt::TerminalApp::implementation
         // copy text to dataPack
         dataPack.SetText(copiedData.Text());
 
+        // The HTML and RTF are only generated once an application asks for
+        // them, which most don't: they only paste text. The args hold on to
+        // the colors of the selection until then.
+        bool deferred = false;
         if (WI_IsFlagSet(copyFormats, CopyFormat::HTML))
         {
-            // copy html to dataPack
-            const auto htmlData = copiedData.Html();
-            if (!htmlData.empty())
-            {
-                dataPack.SetHtmlFormat(htmlData);
-            }
+            dataPack.SetDataProvider(StandardDataFormats::Html(), [copiedData](const DataProviderRequest& request) {
+                request.SetData(winrt::box_value(copiedData.Html()));
+            });
+            deferred = true;
         }
 
         if (WI_IsFlagSet(copyFormats, CopyFormat::RTF))
         {
-            // copy rtf data to dataPack
-            const auto rtfData = copiedData.Rtf();
-            if (!rtfData.empty())
-            {
-                dataPack.SetRtf(rtfData);
-            }
+            dataPack.SetDataProvider(StandardDataFormats::Rtf(), [copiedData](const DataProviderRequest& request) {
+                request.SetData(winrt::box_value(copiedData.Rtf()));
+            });
+            deferred = true;
         }
 
         try
         {
             Clipboard::SetContent(dataPack);
-            Clipboard::Flush();
+
+            // Flushing would generate the deferred formats right away. They're
+            // generated when the last tab is closed instead (see _RemoveTab),
+            // so that they're still on the clipboard after we've exited.
+            if (deferred)
+            {
+                _clipboardNeedsFlush = true;
+            }
+            else
+            {
+                Clipboard::Flush();
+                _clipboardNeedsFlush = false;
+            }
         }
         CATCH_LOG();
     }
@@ -1701,6 +1718,124 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Function Description:
+    // - Presents a File Save "common dialog" for the file to export a buffer to.
+    // Arguments:
+    // - parentHwnd: the window that owns the dialog
+    // Return Value:
+    // - the path that was picked, or an empty string if the dialog was cancelled
+    static winrt::hstring _PickExportPath(const HWND parentHwnd)
+    {
+        static constexpr COMDLG_FILTERSPEC fileTypes[] = {
+            { L"Text (*.txt)", L"*.txt" },
+            { L"All Files (*.*)", L"*.*" }
+        };
+
+        auto fileDialog{ winrt::create_instance<IFileDialog>(CLSID_FileSaveDialog) };
+        DWORD flags{};
+        THROW_IF_FAILED(fileDialog->GetOptions(&flags));
+        THROW_IF_FAILED(fileDialog->SetOptions(flags | FOS_FORCEFILESYSTEM | FOS_NOCHANGEDIR | FOS_OVERWRITEPROMPT));
+        THROW_IF_FAILED(fileDialog->SetFileTypes(ARRAYSIZE(fileTypes), fileTypes));
+        THROW_IF_FAILED(fileDialog->SetDefaultExtension(L"txt"));
+
+        const auto hr{ fileDialog->Show(parentHwnd) };
+        if (hr == HRESULT_FROM_WIN32(ERROR_CANCELLED))
+        {
+            return {};
+        }
+        THROW_IF_FAILED(hr);
+
+        winrt::com_ptr<IShellItem> result;
+        THROW_IF_FAILED(fileDialog->GetResult(result.put()));
+
+        wil::unique_cotaskmem_string filePath;
+        THROW_IF_FAILED(result->GetDisplayName(SIGDN_FILESYSPATH, &filePath));
+        return winrt::hstring{ filePath.get() };
+    }
+
+    // Method Description:
+    // - Writes the buffer of the given control to a file, see TermControl::ExportBuffer.
+    //   Without a path, the user is asked for one with a save dialog first.
+    // - The progress is shown by _ControlExportProgressHandler.
+    // Arguments:
+    // - control: the control to export the buffer of
+    // - path: the file to write, or empty to ask for one
+    // - includeAttributes: whether to write the attributes of the text as VT sequences
+    // Return Value:
+    // - <none>
+    void TerminalPage::_ExportBuffer(const TermControl& control, winrt::hstring path, const bool includeAttributes)
+    {
+        if (path.empty())
+        {
+            try
+            {
+                path = _PickExportPath(_hostingHwnd.value_or(nullptr));
+            }
+            CATCH_LOG();
+
+            if (path.empty())
+            {
+                return;
+            }
+        }
+
+        control.ExportBuffer(path, includeAttributes);
+    }
+
+    // Method Description:
+    // - Shows the progress of exporting the buffer of a control in the
+    //   ExportBufferToast, and once it's done, where it was exported to.
+    // - This will load the ExportBufferToast TeachingTip the first time it's called.
+    // Arguments:
+    // - sender (not used)
+    // - eventArgs: how many rows were written, and whether that's all of them
+    // Return Value:
+    // - <none>
+    winrt::fire_and_forget TerminalPage::_ControlExportProgressHandler(const IInspectable /*sender*/,
+                                                                       const Microsoft::Terminal::Control::ExportProgressEventArgs eventArgs)
+    {
+        auto weakThis{ get_weak() };
+        co_await winrt::resume_foreground(Dispatcher());
+        if (auto page{ weakThis.get() })
+        {
+            if (page->_exportBufferToast == nullptr)
+            {
+                if (MUX::Controls::TeachingTip tip{ page->FindName(L"ExportBufferToast").try_as<MUX::Controls::TeachingTip>() })
+                {
+                    page->_exportBufferToast = std::make_shared<Toast>(tip);
+                    tip.Closed({ page->get_weak(), &TerminalPage::_FocusActiveControl });
+                }
+            }
+            if (page->_exportBufferToast == nullptr)
+            {
+                co_return;
+            }
+            _UpdateTeachingTipTheme(ExportBufferToast().try_as<winrt::Windows::UI::Xaml::FrameworkElement>());
+
+            const auto tip{ ExportBufferToast() };
+            const auto progress{ ExportBufferProgress() };
+            const auto total = std::max<uint64_t>(eventArgs.TotalRows(), 1);
+            progress.Value(100.0 * eventArgs.RowsWritten() / total);
+
+            if (!eventArgs.Complete())
+            {
+                tip.Title(RS_(L"ExportBufferProgressTitle"));
+                tip.Subtitle(winrt::hstring{ fmt::format(std::wstring_view{ RS_(L"ExportBufferProgressText") },
+                                                         eventArgs.RowsWritten(),
+                                                         eventArgs.TotalRows()) });
+                progress.Visibility(Visibility::Visible);
+                tip.IsOpen(true);
+            }
+            else
+            {
+                tip.Title(SUCCEEDED(static_cast<HRESULT>(eventArgs.Result())) ? RS_(L"ExportBufferCompleteTitle") : RS_(L"ExportBufferFailedTitle"));
+                tip.Subtitle(eventArgs.Path());
+                progress.Visibility(Visibility::Collapsed);
+                page->_exportBufferToast->Open();
+            }
+        }
+    }
+
     // Method Description:
     // - Copy text from the focused terminal to the Windows Clipboard
     // Arguments:
@@ -1987,6 +2122,20 @@ namespace winrt::TerminalApp::implementation
         _startupActions = winrt::single_threaded_vector<ActionAndArgs>(std::move(listCopy));
     }
 
+    // Method Description:
+    // - Sets the directory to process the startup actions in. This is only
+    //   needed when the commandline came from another process, whose current
+    //   directory isn't ours.
+    // - This function will have no effective result after Create() is called.
+    // Arguments:
+    // - cwd: the directory the commandline was run in.
+    // Return Value:
+    // - <none>
+    void TerminalPage::SetStartupDirectory(const winrt::hstring& cwd)
+    {
+        _startupDirectory = cwd;
+    }
+
     // Routine Description:
     // - Notifies this Terminal Page that it should start the incoming connection
     //   listener for command-line tools attempting to join this Terminal
@@ -2060,6 +2209,24 @@ namespace winrt::TerminalApp::implementation
         _DismissTabContextMenus();
     }
 
+    // Method Description:
+    // - Tells the controls of all tabs whether the window can be seen, so
+    //   that they don't paint anything while it's minimized.
+    // Arguments:
+    // - visible: whether the window can be seen
+    // Return Value:
+    // - <none>
+    void TerminalPage::WindowVisibilityChanged(const bool visible)
+    {
+        for (auto tab : _tabs)
+        {
+            if (auto terminalTab = _GetTerminalTabImpl(tab))
+            {
+                terminalTab->WindowVisibilityChanged(visible);
+            }
+        }
+    }
+
     // Method Description:
     // - Called when the user tries to do a search using keybindings.
     //   This will tell the current focused terminal control to create
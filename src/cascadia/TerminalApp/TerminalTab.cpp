@@ -23,6 +23,32 @@ namespace winrt
     namespace WUX = Windows::UI::Xaml;
 }
 
+// Title and progress changes of the controls are applied to the tab at most this often.
+// Background sessions with chatty titles (like builds that put every file into it)
+// would otherwise lay out the tab strip again for every single change.
+constexpr const auto TabUpdateInterval = std::chrono::milliseconds(100);
+
+// Method Description:
+// - Gets the icon source for the given icon path, creating it only the first time the
+//   path is used. Tabs of the same profile then share their icon, instead of every
+//   one of them parsing the path and loading the image again.
+// - Icon sources belong to the UI thread they were created on, so every thread
+//   (that is, every window) has a cache of its own.
+// Arguments:
+// - iconPath: the unprocessed path of the icon
+// Return Value:
+// - The icon source
+static winrt::MUX::Controls::IconSource _GetCachedIconSource(const winrt::hstring& iconPath)
+{
+    thread_local std::unordered_map<winrt::hstring, winrt::MUX::Controls::IconSource> cache;
+    auto& iconSource = cache[iconPath];
+    if (!iconSource)
+    {
+        iconSource = IconPathConverter::IconSourceMUX(iconPath);
+    }
+    return iconSource;
+}
+
 namespace winrt::TerminalApp::implementation
 {
     TerminalTab::TerminalTab(const GUID& profile, const TermControl& control)
@@ -43,6 +69,26 @@ namespace winrt::TerminalApp::implementation
         _MakeTabViewItem();
         _CreateContextMenu();
 
+        const auto dispatcher = TabViewItem().Dispatcher();
+        _updateTitle = std::make_shared<ThrottledFuncTrailing<>>(
+            dispatcher,
+            TabUpdateInterval,
+            [weakThis = get_weak()]() {
+                if (auto tab{ weakThis.get() })
+                {
+                    tab->UpdateTitle();
+                }
+            });
+        _updateProgressState = std::make_shared<ThrottledFuncTrailing<>>(
+            dispatcher,
+            TabUpdateInterval,
+            [weakThis = get_weak()]() {
+                if (auto tab{ weakThis.get() })
+                {
+                    tab->_UpdateProgressState();
+                }
+            });
+
         _headerControl.TabStatus(_tabStatus);
 
         // Add an event handler for the header control to tell us when they want their title to change
@@ -263,7 +309,7 @@ namespace winrt::TerminalApp::implementation
         {
             // The TabViewItem Icon needs MUX while the IconSourceElement in the CommandPalette needs WUX...
             Icon(_lastIconPath);
-            TabViewItem().IconSource(IconPathConverter::IconSourceMUX(_lastIconPath));
+            TabViewItem().IconSource(_GetCachedIconSource(_lastIconPath));
         }
     }
 
@@ -285,12 +331,12 @@ namespace winrt::TerminalApp::implementation
                 if (hide)
                 {
                     Icon({});
-                    TabViewItem().IconSource(IconPathConverter::IconSourceMUX({}));
+                    TabViewItem().IconSource(_GetCachedIconSource({}));
                 }
                 else
                 {
                     Icon(_lastIconPath);
-                    TabViewItem().IconSource(IconPathConverter::IconSourceMUX(_lastIconPath));
+                    TabViewItem().IconSource(_GetCachedIconSource(_lastIconPath));
                 }
                 tab->_iconHidden = hide;
             }
@@ -367,6 +413,12 @@ namespace winrt::TerminalApp::implementation
         if (auto tab{ weakThis.get() })
         {
             const auto activeTitle = _GetActiveTitle();
+            // Nothing needs to be laid out again if the title stayed the same.
+            if (activeTitle == Title() && activeTitle == _headerControl.Title())
+            {
+                co_return;
+            }
+
             // Bubble our current tab text to anyone who's listening for changes.
             Title(activeTitle);
 
@@ -509,6 +561,13 @@ namespace winrt::TerminalApp::implementation
         _rootPane->Shutdown();
     }
 
+    // Method Description:
+    // - Tells the controls of all panes of this tab whether the window can be seen.
+    void TerminalTab::WindowVisibilityChanged(const bool visible)
+    {
+        _rootPane->WindowVisibilityChanged(visible);
+    }
+
     // Method Description:
     // - Closes the currently focused pane in this tab. If it's the last pane in
     //   this tab, our Closed event will be fired (at a later time) for anyone
@@ -564,15 +623,14 @@ namespace winrt::TerminalApp::implementation
     void TerminalTab::_AttachEventHandlersToControl(const TermControl& control)
     {
         auto weakThis{ get_weak() };
-        auto dispatcher = TabViewItem().Dispatcher();
 
         control.TitleChanged([weakThis](auto&&, auto&&) {
             // Check if Tab's lifetime has expired
             if (auto tab{ weakThis.get() })
             {
                 // The title of the control changed, but not necessarily the title of the tab.
-                // Set the tab's text to the active panes' text.
-                tab->UpdateTitle();
+                // Set the tab's text to the active panes' text, once the titles settled down.
+                tab->_updateTitle->Run();
             }
         });
 
@@ -600,12 +658,11 @@ namespace winrt::TerminalApp::implementation
             }
         });
 
-        control.SetTaskbarProgress([dispatcher, weakThis](auto&&, auto &&) -> winrt::fire_and_forget {
-            co_await winrt::resume_foreground(dispatcher);
+        control.SetTaskbarProgress([weakThis](auto&&, auto&&) {
             // Check if Tab's lifetime has expired
             if (auto tab{ weakThis.get() })
             {
-                tab->_UpdateProgressState();
+                tab->_updateProgressState->Run();
             }
         });
 
@@ -616,6 +673,17 @@ namespace winrt::TerminalApp::implementation
             }
         });
 
+        // The keys typed into any of the panes are broadcast to all of them, while it's on.
+        control.BroadcastInput(_broadcastInput);
+        control.InputSent([weakThis, weakControl{ winrt::make_weak(control) }](auto&&, const InputSentEventArgs& args) {
+            const auto tab{ weakThis.get() };
+            const auto source{ weakControl.get() };
+            if (tab && source)
+            {
+                tab->_BroadcastInput(source, args);
+            }
+        });
+
         control.FocusFollowMouseRequested([weakThis](auto&& sender, auto&&) {
             if (const auto tab{ weakThis.get() })
             {
@@ -1221,6 +1289,59 @@ namespace winrt::TerminalApp::implementation
         }
     }
 
+    // Method Description:
+    // - Toggles broadcasting the input of every pane in this tab to all the
+    //   others, and the icon in the tab header that shows it.
+    void TerminalTab::ToggleBroadcastInput()
+    {
+        _broadcastInput = !_broadcastInput;
+        _tabStatus.IsBroadcastingInput(_broadcastInput);
+
+        std::vector<TermControl> controls;
+        _rootPane->CollectTerminalControls(controls);
+        for (const auto& control : controls)
+        {
+            control.BroadcastInput(_broadcastInput);
+        }
+    }
+
+    // Method Description:
+    // - Writes the keys that were typed into one pane to all the others.
+    // - The keys are encoded only once for each distinct set of input modes
+    //   (win32-input-mode, application cursor keys, ...) that the panes are in,
+    //   rather than by every pane. Only their connections are written to, in the
+    //   background, so that nothing else about the other panes changes.
+    // Arguments:
+    // - source: the control the keys were typed into, which already sent them
+    // - args: the keys that were typed
+    void TerminalTab::_BroadcastInput(const TermControl& source, const InputSentEventArgs& args)
+    {
+        if (!_broadcastInput)
+        {
+            return;
+        }
+
+        std::vector<TermControl> controls;
+        _rootPane->CollectTerminalControls(controls);
+
+        std::vector<std::pair<InputModes, winrt::hstring>> encoded;
+        for (const auto& control : controls)
+        {
+            if (control == source)
+            {
+                continue;
+            }
+
+            const auto modes = control.InputModes();
+            auto it = std::find_if(encoded.begin(), encoded.end(), [&](const auto& pair) { return pair.first == modes; });
+            if (it == encoded.end())
+            {
+                it = encoded.emplace(encoded.end(), modes, args.Encode(modes));
+            }
+            control.SendBroadcastInput(it->second);
+        }
+    }
+
     // Method Description:
     // - Calculates if the tab is read-only.
     // The tab is considered read-only if one of the panes is read-only.
@@ -6,6 +6,7 @@
 #include "ColorPickupFlyout.h"
 #include "TabBase.h"
 #include "TerminalTab.g.h"
+#include "ThrottledFunc.h"
 
 static constexpr double HeaderRenameBoxWidthDefault{ 165 };
 static constexpr double HeaderRenameBoxWidthTitleLength{ std::numeric_limits<double>::infinity() };
@@ -59,6 +60,7 @@ namespace winrt::TerminalApp::implementation
         winrt::fire_and_forget UpdateTitle();
 
         void Shutdown() override;
+        void WindowVisibilityChanged(const bool visible);
         void ClosePane();
 
         void SetTabText(winrt::hstring title);
@@ -80,6 +82,7 @@ namespace winrt::TerminalApp::implementation
         int GetLeafPaneCount() const noexcept;
 
         void TogglePaneReadOnly();
+        void ToggleBroadcastInput();
         std::shared_ptr<Pane> GetActivePane() const;
 
         winrt::TerminalApp::TerminalTabStatus TabStatus()
@@ -105,10 +108,14 @@ namespace winrt::TerminalApp::implementation
         winrt::TerminalApp::TabHeaderControl _headerControl{};
         winrt::TerminalApp::TerminalTabStatus _tabStatus{};
 
+        std::shared_ptr<ThrottledFuncTrailing<>> _updateTitle;
+        std::shared_ptr<ThrottledFuncTrailing<>> _updateProgressState;
+
         std::vector<uint32_t> _mruPanes;
         uint32_t _nextPaneId{ 0 };
 
         bool _receivedKeyDown{ false };
+        bool _broadcastInput{ false };
         bool _iconHidden{ false };
 
         winrt::hstring _runtimeTabText{};
@@ -144,6 +151,9 @@ namespace winrt::TerminalApp::implementation
 
         void _RecalculateAndApplyReadOnly();
 
+        void _BroadcastInput(const winrt::Microsoft::Terminal::Control::TermControl& source,
+                             const winrt::Microsoft::Terminal::Control::InputSentEventArgs& args);
+
         void _UpdateProgressState();
 
         void _DuplicateTab();
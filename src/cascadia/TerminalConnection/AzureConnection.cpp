@@ -182,11 +182,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         if (_state == AzureState::TermConnected)
         {
             // If we're connected, we don't need to do any fun input shenanigans.
-            websocket_outgoing_message msg;
-            const auto str = winrt::to_string(data);
-            msg.set_utf8_message(str);
-
-            _cloudShellSocket.send(msg).get();
+            _SendInput(winrt::to_string(data));
             return;
         }
 
@@ -221,6 +217,49 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         }
     }
 
+    // Method description:
+    // - sends the input to the websocket, right away if nothing else is being
+    //   sent, or else along with the other input written in the meantime
+    // Arguments:
+    // - input - the UTF-8 input
+    void AzureConnection::_SendInput(const std::string_view input)
+    {
+        std::lock_guard<std::mutex> lock{ _sendMutex };
+        _pendingInput.append(input);
+        if (!_sending)
+        {
+            _sending = true;
+            _SendPendingInput();
+        }
+    }
+
+    // Method description:
+    // - sends all of the pending input as one message, and once it's on its
+    //   way, whatever was written in the meantime
+    // - _sendMutex must be held
+    void AzureConnection::_SendPendingInput()
+    {
+        websocket_outgoing_message msg;
+        msg.set_utf8_message(std::move(_pendingInput));
+        _pendingInput.clear();
+
+        _cloudShellSocket.send(msg).then([this, strongThis{ get_strong() }](pplx::task<void> sent) {
+            try
+            {
+                sent.get();
+            }
+            CATCH_LOG();
+
+            std::lock_guard<std::mutex> lock{ _sendMutex };
+            if (_pendingInput.empty() || _isStateAtOrBeyond(ConnectionState::Closing))
+            {
+                _sending = false;
+                return;
+            }
+            _SendPendingInput();
+        });
+    }
+
     // Method description:
     // - ascribes to the ITerminalConnection interface
     // - resizes the terminal
@@ -380,14 +419,20 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                 case AzureState::TermConnected:
                 {
                     _transitionToState(ConnectionState::Connected);
+                    // The next frame is always being received while the previous ones are delivered.
+                    auto msgT = _cloudShellSocket.receive();
                     while (true)
                     {
-                        // Read from websocket
-                        pplx::task<websocket_incoming_message> msgT;
+                        // Read from websocket, along with the frames that arrived already
+                        _u8Output.clear();
                         try
                         {
-                            msgT = _cloudShellSocket.receive();
-                            msgT.wait();
+                            do
+                            {
+                                auto msg = msgT.get();
+                                _u8Output.append(msg.extract_string().get());
+                                msgT = _cloudShellSocket.receive();
+                            } while (msgT.is_done() && _u8Output.size() < _maxOutputBatch);
                         }
                         catch (...)
                         {
@@ -398,17 +443,17 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                                 // End the output thread.
                                 return S_FALSE;
                             }
+                            throw;
                         }
 
-                        auto msg = msgT.get();
-                        auto msgStringTask = msg.extract_string();
-                        auto msgString = msgStringTask.get();
-
-                        // Convert to hstring
-                        const auto hstr = winrt::to_hstring(msgString);
+                        // A frame may end in the middle of a character, which is completed by the next one.
+                        THROW_IF_FAILED(til::u8u16(_u8Output, _u16Output, _u8State));
 
                         // Pass the output to our registered event handlers
-                        _TerminalOutputHandlers(hstr);
+                        if (!_u16Output.empty())
+                        {
+                            _TerminalOutputHandlers(_u16Output);
+                        }
                     }
                     return S_OK;
                 }
@@ -96,6 +96,23 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         web::websockets::client::websocket_client _cloudShellSocket;
 
+        // The frames that arrived while the previous ones were being delivered
+        // are converted and passed on together, see _OutputThread. The buffers
+        // are kept between the frames.
+        static constexpr size_t _maxOutputBatch = 64 * 1024;
+        std::string _u8Output;
+        til::u8state _u8State;
+        std::wstring _u16Output;
+
+        // A single input message is sent at a time. The input written while
+        // it's on its way is collected and sent as the next one, so that
+        // typing doesn't wait for a round trip per key.
+        std::mutex _sendMutex;
+        std::string _pendingInput;
+        bool _sending{ false };
+        void _SendInput(const std::string_view input);
+        void _SendPendingInput();
+
         static std::optional<utility::string_t> _ParsePreferredShellType(const web::json::value& settingsResponse);
     };
 }
@@ -14,6 +14,7 @@
 #include "../../types/inc/utils.hpp"
 #include "../../types/inc/Environment.hpp"
 #include "LibraryResources.h"
+#include "StartupTracing.h"
 
 using namespace ::Microsoft::Console;
 
@@ -34,29 +35,6 @@ using namespace ::Microsoft::Console;
 
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
-    // Function Description:
-    // - creates some basic anonymous pipes and passes them to CreatePseudoConsole
-    // Arguments:
-    // - size: The size of the conpty to create, in characters.
-    // - phInput: Receives the handle to the newly-created anonymous pipe for writing input to the conpty.
-    // - phOutput: Receives the handle to the newly-created anonymous pipe for reading the output of the conpty.
-    // - phPc: Receives a token value to identify this conpty
-#pragma warning(suppress : 26430) // This statement sufficiently checks the out parameters. Analyzer cannot find this.
-    static HRESULT _CreatePseudoConsoleAndPipes(const COORD size, const DWORD dwFlags, HANDLE* phInput, HANDLE* phOutput, HPCON* phPC) noexcept
-    {
-        RETURN_HR_IF(E_INVALIDARG, phPC == nullptr || phInput == nullptr || phOutput == nullptr);
-
-        wil::unique_hfile outPipeOurSide, outPipePseudoConsoleSide;
-        wil::unique_hfile inPipeOurSide, inPipePseudoConsoleSide;
-
-        RETURN_IF_WIN32_BOOL_FALSE(CreatePipe(&inPipePseudoConsoleSide, &inPipeOurSide, nullptr, 0));
-        RETURN_IF_WIN32_BOOL_FALSE(CreatePipe(&outPipeOurSide, &outPipePseudoConsoleSide, nullptr, 0));
-        RETURN_IF_FAILED(ConptyCreatePseudoConsole(size, inPipePseudoConsoleSide.get(), outPipePseudoConsoleSide.get(), dwFlags, phPC));
-        *phInput = inPipeOurSide.release();
-        *phOutput = outPipeOurSide.release();
-        return S_OK;
-    }
-
     // Function Description:
     // - launches the client application attached to the new pseudoconsole
     HRESULT ConptyConnection::_LaunchAttachedClient() noexcept
@@ -253,36 +231,68 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
     {
         _transitionToState(ConnectionState::Connecting);
 
+        // Only the pipes of the pseudoconsoles we create ourselves can be read with
+        // overlapped I/O. The ones handed off to us are read by a thread of their own.
+        auto overlappedOutput = false;
         if (!_inPipe)
         {
+            TRACE_STARTUP_PHASE(g_hTerminalConnectionProvider, "ConptySpawn");
             const COORD dimensions{ gsl::narrow_cast<SHORT>(_initialCols), gsl::narrow_cast<SHORT>(_initialRows) };
-            THROW_IF_FAILED(_CreatePseudoConsoleAndPipes(dimensions, PSEUDOCONSOLE_RESIZE_QUIRK | PSEUDOCONSOLE_WIN32_INPUT_MODE, &_inPipe, &_outPipe, &_hPC));
+            // The pseudoconsole usually comes out of the pool, already started, so only the client is launched here.
+            ConptyPool::PseudoConsole console;
+            THROW_IF_FAILED(ConptyPool::Instance().Acquire(dimensions, console));
+            _inPipe = std::move(console.inPipe);
+            _outPipe = std::move(console.outPipe);
+            _hPC = std::move(console.hPC);
+            overlappedOutput = true;
             THROW_IF_FAILED(_LaunchAttachedClient());
         }
 
         _startTime = std::chrono::high_resolution_clock::now();
 
-        // Create our own output handling thread
         // This must be done after the pipes are populated.
         // Each connection needs to make sure to drain the output from its backing host.
-        _hOutputThread.reset(CreateThread(
-            nullptr,
-            0,
-            [](LPVOID lpParameter) noexcept {
-                ConptyConnection* const pInstance = static_cast<ConptyConnection*>(lpParameter);
-                if (pInstance)
-                {
-                    return pInstance->_OutputThread();
-                }
-                return gsl::narrow_cast<DWORD>(E_INVALIDARG);
-            },
-            this,
-            0,
-            nullptr));
+        if (overlappedOutput)
+        {
+            // The reads of all connections complete on the process' threadpool, so
+            // that idle connections don't each keep a thread (and its stack) around.
+            _buffer.resize(_minReadSize);
+            _outputDrained.create(wil::EventOptions::ManualReset);
+            _outputIo.reset(CreateThreadpoolIo(
+                _outPipe.get(),
+                [](PTP_CALLBACK_INSTANCE /*callbackInstance*/, PVOID context, PVOID /*overlapped*/, ULONG ioResult, ULONG_PTR bytesTransferred, PTP_IO /*io*/) noexcept {
+                    static_cast<ConptyConnection*>(context)->_OutputReadCompleted(ioResult, bytesTransferred);
+                },
+                this,
+                nullptr));
+            THROW_LAST_ERROR_IF_NULL(_outputIo);
+
+            // Like the output thread, the reads keep us alive until the output ends.
+            _outputKeepAlive = get_strong();
+            _StartOutputRead();
+        }
+        else
+        {
+            // Create our own output handling thread
+            _hOutputThread.reset(CreateThread(
+                nullptr,
+                0,
+                [](LPVOID lpParameter) noexcept {
+                    ConptyConnection* const pInstance = static_cast<ConptyConnection*>(lpParameter);
+                    if (pInstance)
+                    {
+                        return pInstance->_OutputThread();
+                    }
+                    return gsl::narrow_cast<DWORD>(E_INVALIDARG);
+                },
+                this,
+                0,
+                nullptr));
 
-        THROW_LAST_ERROR_IF_NULL(_hOutputThread);
+            THROW_LAST_ERROR_IF_NULL(_hOutputThread);
 
-        LOG_IF_FAILED(SetThreadDescription(_hOutputThread.get(), L"ConptyConnection Output Thread"));
+            LOG_IF_FAILED(SetThreadDescription(_hOutputThread.get(), L"ConptyConnection Output Thread"));
+        }
 
         _clientExitWait.reset(CreateThreadpoolWait(
             [](PTP_CALLBACK_INSTANCE /*callbackInstance*/, PVOID context, PTP_WAIT /*wait*/, TP_WAIT_RESULT /*waitResult*/) noexcept {
@@ -307,15 +317,15 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         winrt::hstring failureText{ fmt::format(std::wstring_view{ RS_(L"ProcessFailedToLaunch") },
                                                 gsl::narrow_cast<unsigned long>(hr),
                                                 _commandline) };
-        _TerminalOutputHandlers(failureText);
+        _raiseMessage(failureText);
 
         // If the path was invalid, let's present an informative message to the user
         if (hr == HRESULT_FROM_WIN32(ERROR_DIRECTORY))
         {
             winrt::hstring badPathText{ fmt::format(std::wstring_view{ RS_(L"BadPathText") },
                                                     _startingDirectory) };
-            _TerminalOutputHandlers(L"\r\n");
-            _TerminalOutputHandlers(badPathText);
+            _raiseMessage(L"\r\n");
+            _raiseMessage(badPathText);
         }
 
         _transitionToState(ConnectionState::Failed);
@@ -333,12 +343,26 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         try
         {
             winrt::hstring exitText{ fmt::format(std::wstring_view{ RS_(L"ProcessExited") }, status) };
-            _TerminalOutputHandlers(L"\r\n");
-            _TerminalOutputHandlers(exitText);
+            _raiseMessage(L"\r\n");
+            _raiseMessage(exitText);
         }
         CATCH_LOG();
     }
 
+    // Method Description:
+    // - Prints a message of our own, through both output events.
+    // Arguments:
+    // - message: the text to print.
+    void ConptyConnection::_raiseMessage(const std::wstring_view message)
+    {
+        _TerminalOutputHandlers(winrt::hstring{ message });
+        if (_TerminalOutputUtf8Handlers)
+        {
+            const auto utf8 = til::u16u8(message);
+            _TerminalOutputUtf8Handlers({ reinterpret_cast<const uint8_t*>(utf8.data()), gsl::narrow<uint32_t>(utf8.size()) });
+        }
+    }
+
     // Method Description:
     // - called when the client application (not necessarily its pty) exits for any reason
     void ConptyConnection::_ClientTerminated() noexcept
@@ -361,10 +385,7 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         // Close the pseudoconsole and wait for all output to drain.
         _hPC.reset();
-        if (auto localOutputThreadHandle = std::move(_hOutputThread))
-        {
-            LOG_LAST_ERROR_IF(WAIT_FAILED == WaitForSingleObject(localOutputThreadHandle.get(), INFINITE));
-        }
+        _WaitForOutputToDrain();
 
         _indicateExitWithStatus(exitCode);
 
@@ -411,13 +432,9 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
             _inPipe.reset(); // break the pipes
             _outPipe.reset();
 
-            if (_hOutputThread)
-            {
-                // Tear down our output thread -- now that the output pipe was closed on the
-                // far side, we can run down our local reader.
-                LOG_LAST_ERROR_IF(WAIT_FAILED == WaitForSingleObject(_hOutputThread.get(), INFINITE));
-                _hOutputThread.reset();
-            }
+            // Tear down our output reader -- now that the output pipe was closed on the
+            // far side, we can run down our local reader.
+            _WaitForOutputToDrain();
 
             if (_piClient.hProcess)
             {
@@ -431,72 +448,182 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
     }
     CATCH_LOG()
 
+    // Method Description:
+    // - Waits until the output was read to its end, by the output thread or the
+    //   overlapped reads, whichever this connection uses.
+    void ConptyConnection::_WaitForOutputToDrain() noexcept
+    {
+        if (_outputIo)
+        {
+            LOG_LAST_ERROR_IF(WAIT_FAILED == WaitForSingleObject(_outputDrained.get(), INFINITE));
+        }
+        else if (auto localOutputThreadHandle = std::move(_hOutputThread))
+        {
+            LOG_LAST_ERROR_IF(WAIT_FAILED == WaitForSingleObject(localOutputThreadHandle.get(), INFINITE));
+        }
+    }
+
     DWORD ConptyConnection::_OutputThread()
     {
         // Keep us alive until the output thread terminates; the destructor
         // won't wait for us, and the known exit points _do_.
         auto strongThis{ get_strong() };
 
+        _buffer.resize(_minReadSize);
+
         // process the data of the output pipe in a loop
         while (true)
         {
             DWORD read{};
 
             const auto readFail{ !ReadFile(_outPipe.get(), _buffer.data(), gsl::narrow_cast<DWORD>(_buffer.size()), &read, nullptr) };
-            if (readFail) // reading failed (we must check this first, because read will also be 0.)
+            const auto result = _HandleOutput(readFail ? GetLastError() : ERROR_SUCCESS, read);
+            if (result != S_OK)
             {
-                const auto lastError = GetLastError();
-                if (lastError != ERROR_BROKEN_PIPE && !_isStateAtOrBeyond(ConnectionState::Closing))
-                {
-                    // EXIT POINT
-                    _indicateExitWithStatus(HRESULT_FROM_WIN32(lastError)); // print a message
-                    _transitionToState(ConnectionState::Failed);
-                    return gsl::narrow_cast<DWORD>(HRESULT_FROM_WIN32(lastError));
-                }
-                // else we call convertUTF8ChunkToUTF16 with an empty string_view to convert possible remaining partials to U+FFFD
+                return FAILED(result) ? gsl::narrow_cast<DWORD>(result) : 0;
             }
+        }
 
-            const HRESULT result{ til::u8u16(std::string_view{ _buffer.data(), read }, _u16Str, _u8State) };
+        return 0;
+    }
+
+    // Method Description:
+    // - Starts the next overlapped read from the output pipe. It completes in
+    //   _OutputReadCompleted, on the threadpool.
+    void ConptyConnection::_StartOutputRead() noexcept
+    {
+        StartThreadpoolIo(_outputIo.get());
+        _outputOverlapped = {};
+        if (!ReadFile(_outPipe.get(), _buffer.data(), gsl::narrow_cast<DWORD>(_buffer.size()), nullptr, &_outputOverlapped))
+        {
+            const auto lastError = GetLastError();
+            if (lastError != ERROR_IO_PENDING)
+            {
+                // Nothing was queued to the threadpool, so it's completed right here.
+                CancelThreadpoolIo(_outputIo.get());
+                _OutputReadCompleted(lastError, 0);
+            }
+        }
+    }
+
+    // Method Description:
+    // - Handles an overlapped read of the output pipe like the output thread
+    //   does, and starts the next one. Once the output ended, it signals
+    //   _outputDrained and stops keeping us alive.
+    // Arguments:
+    // - ioResult: NO_ERROR, or the error the read failed with.
+    // - bytesTransferred: How much was read.
+    void ConptyConnection::_OutputReadCompleted(const ULONG ioResult, const ULONG_PTR bytesTransferred) noexcept
+    {
+        auto result = S_FALSE;
+        try
+        {
+            result = _HandleOutput(ioResult, gsl::narrow_cast<DWORD>(bytesTransferred));
+        }
+        CATCH_LOG();
+
+        // After a failed read, the remaining partials were just flushed out.
+        if (result == S_OK && ioResult == NO_ERROR)
+        {
+            _StartOutputRead();
+            return;
+        }
+
+        // This must be the last thing that touches us: the destructor might run once it's released.
+        const auto strongThis = std::move(_outputKeepAlive);
+        _outputDrained.SetEvent();
+    }
+
+    // Method Description:
+    // - Passes on what was read from the output pipe, converted to UTF-16 only
+    //   if anyone listens to TerminalOutput.
+    // Arguments:
+    // - lastError: ERROR_SUCCESS, or the error the read failed with. What's
+    //   left of a partial character is flushed out then.
+    // - read: How much was read into _buffer.
+    // Return Value:
+    // - S_OK to go on reading, S_FALSE once the output (expectedly) ended, or
+    //   the error it ended with.
+    HRESULT ConptyConnection::_HandleOutput(const DWORD lastError, DWORD read)
+    {
+        if (lastError != ERROR_SUCCESS) // reading failed (we must check this first, because read will also be 0.)
+        {
+            if (lastError != ERROR_BROKEN_PIPE && !_isStateAtOrBeyond(ConnectionState::Closing))
+            {
+                // EXIT POINT
+                _indicateExitWithStatus(HRESULT_FROM_WIN32(lastError)); // print a message
+                _transitionToState(ConnectionState::Failed);
+                return HRESULT_FROM_WIN32(lastError);
+            }
+            // else we call convertUTF8ChunkToUTF16 with an empty string_view to convert possible remaining partials to U+FFFD
+            read = 0;
+        }
+
+        const std::string_view output{ _buffer.data(), read };
+
+        _u16Str.clear();
+        if (_TerminalOutputHandlers)
+        {
+            const HRESULT result{ til::u8u16(output, _u16Str, _u8State) };
             if (FAILED(result))
             {
                 if (_isStateAtOrBeyond(ConnectionState::Closing))
                 {
                     // This termination was expected.
-                    return 0;
+                    return S_FALSE;
                 }
 
                 // EXIT POINT
                 _indicateExitWithStatus(result); // print a message
                 _transitionToState(ConnectionState::Failed);
-                return gsl::narrow_cast<DWORD>(result);
+                return result;
             }
+        }
 
-            if (_u16Str.empty())
-            {
-                return 0;
-            }
+        // A read that filled the buffer most likely left more in the pipe,
+        // so the next one asks for more. One that used only a fraction of
+        // it means that the output slowed down again.
+        if (read == _buffer.size() && _buffer.size() < _maxReadSize)
+        {
+            _buffer.resize(_buffer.size() * 2);
+        }
+        else if (read < _buffer.size() / 8 && _buffer.size() > _minReadSize)
+        {
+            _buffer.resize(_buffer.size() / 2);
+            _buffer.shrink_to_fit();
+        }
 
-            if (!_receivedFirstByte)
-            {
-                const auto now = std::chrono::high_resolution_clock::now();
-                const std::chrono::duration<double> delta = now - _startTime;
+        if (output.empty() && _u16Str.empty())
+        {
+            return S_FALSE;
+        }
+
+        if (!_receivedFirstByte)
+        {
+            const auto now = std::chrono::high_resolution_clock::now();
+            const std::chrono::duration<double> delta = now - _startTime;
 
 #pragma warning(suppress : 26477 26485 26494 26482 26446) // We don't control TraceLoggingWrite
-                TraceLoggingWrite(g_hTerminalConnectionProvider,
-                                  "ReceivedFirstByte",
-                                  TraceLoggingDescription("An event emitted when the connection receives the first byte"),
-                                  TraceLoggingGuid(_guid, "SessionGuid", "The WT_SESSION's GUID"),
-                                  TraceLoggingFloat64(delta.count(), "Duration"),
-                                  TraceLoggingKeyword(MICROSOFT_KEYWORD_MEASURES),
-                                  TelemetryPrivacyDataTag(PDT_ProductAndServicePerformance));
-                _receivedFirstByte = true;
-            }
+            TraceLoggingWrite(g_hTerminalConnectionProvider,
+                              "ReceivedFirstByte",
+                              TraceLoggingDescription("An event emitted when the connection receives the first byte"),
+                              TraceLoggingGuid(_guid, "SessionGuid", "The WT_SESSION's GUID"),
+                              TraceLoggingFloat64(delta.count(), "Duration"),
+                              TraceLoggingKeyword(MICROSOFT_KEYWORD_MEASURES),
+                              TelemetryPrivacyDataTag(PDT_ProductAndServicePerformance));
+            _receivedFirstByte = true;
+        }
 
-            // Pass the output to our registered event handlers
+        // Pass the output to our registered event handlers
+        if (!output.empty())
+        {
+            _TerminalOutputUtf8Handlers({ reinterpret_cast<const uint8_t*>(output.data()), gsl::narrow_cast<uint32_t>(output.size()) });
+        }
+        if (!_u16Str.empty())
+        {
             _TerminalOutputHandlers(_u16Str);
         }
-
-        return 0;
+        return S_OK;
     }
 
     static winrt::event<NewConnectionHandler> _newConnectionHandlers;
@@ -7,13 +7,7 @@
 #include "ConnectionStateHolder.h"
 #include "../inc/cppwinrt_utils.h"
 
-#include <conpty-static.h>
-
-namespace wil
-{
-    // These belong in WIL upstream, so when we reingest the change that has them we'll get rid of ours.
-    using unique_static_pseudoconsole_handle = wil::unique_any<HPCON, decltype(&::ConptyClosePseudoConsole), ::ConptyClosePseudoConsole>;
-}
+#include "ConptyPool.h"
 
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
@@ -50,10 +44,12 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         static void NewConnection(winrt::event_token const& token);
 
         WINRT_CALLBACK(TerminalOutput, TerminalOutputHandler);
+        WINRT_CALLBACK(TerminalOutputUtf8, TerminalOutputUtf8Handler);
 
     private:
         HRESULT _LaunchAttachedClient() noexcept;
         void _indicateExitWithStatus(unsigned int status) noexcept;
+        void _raiseMessage(const std::wstring_view message);
         void _ClientTerminated() noexcept;
 
         static HRESULT NewHandoff(HANDLE in, HANDLE out, HANDLE signal, HANDLE ref, HANDLE server, HANDLE client) noexcept;
@@ -72,16 +68,28 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
         wil::unique_hfile _inPipe; // The pipe for writing input to
         wil::unique_hfile _outPipe; // The pipe for reading output from
-        wil::unique_handle _hOutputThread;
+        wil::unique_handle _hOutputThread; // Reads _outPipe, unless it's read with overlapped I/O
+        wil::unique_threadpool_io _outputIo; // Completes the overlapped reads of _outPipe, if it's read that way
+        wil::unique_event _outputDrained; // Signaled once the overlapped reads reached the end of the output
+        OVERLAPPED _outputOverlapped{};
+        winrt::com_ptr<ConptyConnection> _outputKeepAlive;
         wil::unique_process_information _piClient;
         wil::unique_static_pseudoconsole_handle _hPC;
         wil::unique_threadpool_wait _clientExitWait;
 
         til::u8state _u8State;
         std::wstring _u16Str;
-        std::array<char, 4096> _buffer;
+        // The read buffer grows while the pipe stays full, so that bulk output
+        // is read in fewer, larger chunks, and shrinks again once it's idle.
+        static constexpr size_t _minReadSize = 4 * 1024;
+        static constexpr size_t _maxReadSize = 1024 * 1024;
+        std::vector<char> _buffer;
 
         DWORD _OutputThread();
+        void _StartOutputRead() noexcept;
+        void _OutputReadCompleted(const ULONG ioResult, const ULONG_PTR bytesTransferred) noexcept;
+        HRESULT _HandleOutput(const DWORD lastError, DWORD read);
+        void _WaitForOutputToDrain() noexcept;
     };
 }
 
@@ -0,0 +1,199 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+
+#include "ConptyPool.h"
+
+namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
+{
+    // Function Description:
+    // - Gets the pool that all connections share.
+    // - It's never destroyed, since closing its pseudoconsoles during the
+    //   teardown of the process would wait on conhosts that exit anyways.
+    ConptyPool& ConptyPool::Instance()
+    {
+        static auto* const pool = new ConptyPool{};
+        return *pool;
+    }
+
+    ConptyPool::ConptyPool()
+    {
+        // The notification stays signaled for as long as the memory is low.
+        _lowMemory.reset(CreateMemoryResourceNotification(LowMemoryResourceNotification));
+        LOG_LAST_ERROR_IF_NULL(_lowMemory);
+
+        _lowMemoryWait.reset(CreateThreadpoolWait(
+            [](PTP_CALLBACK_INSTANCE /*callbackInstance*/, PVOID context, PTP_WAIT /*wait*/, TP_WAIT_RESULT /*waitResult*/) noexcept {
+                static_cast<ConptyPool*>(context)->_Clear();
+            },
+            this,
+            nullptr));
+        LOG_LAST_ERROR_IF_NULL(_lowMemoryWait);
+    }
+
+    // Function Description:
+    // - Creates a pipe like CreatePipe does, except that the end that's read from
+    //   is opened for overlapped I/O. Anonymous pipes can't be, so this is a named
+    //   pipe with a name that's unique to this process, which only ever has the
+    //   one client that's opened right here.
+    // Arguments:
+    // - readPipe: Receives the end to read from, with FILE_FLAG_OVERLAPPED.
+    // - writePipe: Receives the end to write to, for synchronous I/O.
+    HRESULT ConptyPool::_CreateOverlappedPipe(wil::unique_hfile& readPipe, wil::unique_hfile& writePipe) noexcept
+    try
+    {
+        static std::atomic<uint32_t> serial{ 0 };
+        const auto name = fmt::format(LR"(\\.\pipe\Local\ConptyOutput-{}-{})", GetCurrentProcessId(), serial.fetch_add(1, std::memory_order_relaxed));
+
+        // The same buffer size that CreatePipe picks by default.
+        static constexpr DWORD bufferSize = 4096;
+        wil::unique_hfile server{ CreateNamedPipeW(name.c_str(),
+                                                   PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                                   PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                                   1,
+                                                   bufferSize,
+                                                   bufferSize,
+                                                   0,
+                                                   nullptr) };
+        RETURN_LAST_ERROR_IF(!server);
+
+        wil::unique_hfile client{ CreateFileW(name.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        RETURN_LAST_ERROR_IF(!client);
+
+        readPipe = std::move(server);
+        writePipe = std::move(client);
+        return S_OK;
+    }
+    CATCH_RETURN()
+
+    // Function Description:
+    // - creates the pipes and passes them to CreatePseudoConsole. The output pipe
+    //   is read with overlapped I/O, see ConptyConnection::Start.
+    // Arguments:
+    // - size: The size of the conpty to create, in characters.
+    // - console: Receives the pipes and the handle of the new pseudoconsole.
+    HRESULT ConptyPool::_Create(const COORD size, PseudoConsole& console) noexcept
+    {
+        wil::unique_hfile outPipeOurSide, outPipePseudoConsoleSide;
+        wil::unique_hfile inPipeOurSide, inPipePseudoConsoleSide;
+        wil::unique_static_pseudoconsole_handle hPC;
+
+        RETURN_IF_WIN32_BOOL_FALSE(CreatePipe(&inPipePseudoConsoleSide, &inPipeOurSide, nullptr, 0));
+        RETURN_IF_FAILED(_CreateOverlappedPipe(outPipeOurSide, outPipePseudoConsoleSide));
+        RETURN_IF_FAILED(ConptyCreatePseudoConsole(size, inPipePseudoConsoleSide.get(), outPipePseudoConsoleSide.get(), _flags, &hPC));
+        console.inPipe = std::move(inPipeOurSide);
+        console.outPipe = std::move(outPipeOurSide);
+        console.hPC = std::move(hPC);
+        return S_OK;
+    }
+
+    // Method Description:
+    // - Hands out an idle pseudoconsole, resized to the given size, or creates
+    //   a new one if there's none. Either way, the pool is refilled afterwards.
+    // Arguments:
+    // - size: The size of the conpty, in characters.
+    // - console: Receives the pipes and the handle of the pseudoconsole.
+    HRESULT ConptyPool::Acquire(const COORD size, PseudoConsole& console) noexcept
+    try
+    {
+        std::optional<IdleConsole> idle;
+        {
+            const std::lock_guard guard{ _mutex };
+            // The next connection most likely has the same size as this one.
+            _size = size;
+            if (!_idle.empty())
+            {
+                idle.emplace(std::move(_idle.back()));
+                _idle.pop_back();
+            }
+        }
+
+        // Resizing goes through the signal pipe, so it also tells whether the
+        // conhost of an idle pseudoconsole is still alive. One that isn't (or
+        // can't be resized) is dropped, and a new one is created instead.
+        if (idle && SUCCEEDED(ConptyResizePseudoConsole(idle->console.hPC.get(), size)))
+        {
+            console = std::move(idle->console);
+        }
+        else
+        {
+            RETURN_IF_FAILED(_Create(size, console));
+        }
+
+        _Refill();
+        return S_OK;
+    }
+    CATCH_RETURN()
+
+    bool ConptyPool::_IsMemoryLow() const noexcept
+    {
+        BOOL low = FALSE;
+        if (_lowMemory)
+        {
+            LOG_IF_WIN32_BOOL_FALSE(QueryMemoryResourceNotification(_lowMemory.get(), &low));
+        }
+        return low != FALSE;
+    }
+
+    // Method Description:
+    // - Closes all the idle pseudoconsoles, once the system runs low on memory.
+    void ConptyPool::_Clear() noexcept
+    {
+        std::vector<IdleConsole> idle;
+        {
+            const std::lock_guard guard{ _mutex };
+            idle.swap(_idle);
+        }
+        // The pseudoconsoles are closed outside of the lock, since closing one waits for its conhost.
+    }
+
+    // Method Description:
+    // - Creates idle pseudoconsoles in the background, until there's enough of them.
+    // - Nothing is created while the system is low on memory. Otherwise, the pool
+    //   waits for the memory to run low, at which point it's cleared. That wait is
+    //   set up again the next time the pool is refilled, since the notification
+    //   stays signaled while the memory is low.
+    winrt::fire_and_forget ConptyPool::_Refill()
+    {
+        COORD size{};
+        {
+            const std::lock_guard guard{ _mutex };
+            if (_refilling || _idle.size() >= _maxIdle || _IsMemoryLow())
+            {
+                co_return;
+            }
+            _refilling = true;
+            size = _size;
+        }
+
+        co_await winrt::resume_background();
+
+        try
+        {
+            for (bool full = false; !full;)
+            {
+                PseudoConsole console;
+                const auto hr = _Create(size, console);
+
+                const std::lock_guard guard{ _mutex };
+                if (FAILED(hr) || _IsMemoryLow())
+                {
+                    LOG_IF_FAILED(hr);
+                    break;
+                }
+                _idle.push_back({ size, std::move(console) });
+                full = _idle.size() >= _maxIdle;
+                size = _size;
+            }
+        }
+        CATCH_LOG();
+
+        const std::lock_guard guard{ _mutex };
+        _refilling = false;
+        if (_lowMemory && _lowMemoryWait && !_IsMemoryLow())
+        {
+            SetThreadpoolWait(_lowMemoryWait.get(), _lowMemory.get(), nullptr);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ConptyPool.h
+
+Abstract:
+- Keeps a few pseudoconsoles started ahead of time, so that a new connection
+  only has to launch its client, instead of waiting for a new conhost to
+  start first.
+- The idle pseudoconsoles are created in the background, at the size of the
+  latest connection, and resized when they're claimed. They're all closed
+  (and no new ones are created) while the system is low on memory.
+- The pool lives until the process exits. Idle pseudoconsoles exit along with
+  it, since their pipes break.
+--*/
+
+#pragma once
+
+#include <conpty-static.h>
+
+namespace wil
+{
+    // These belong in WIL upstream, so when we reingest the change that has them we'll get rid of ours.
+    using unique_static_pseudoconsole_handle = wil::unique_any<HPCON, decltype(&::ConptyClosePseudoConsole), ::ConptyClosePseudoConsole>;
+}
+
+namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
+{
+    class ConptyPool final
+    {
+    public:
+        struct PseudoConsole
+        {
+            wil::unique_hfile inPipe; // The pipe for writing input to
+            wil::unique_hfile outPipe; // The pipe for reading output from, opened for overlapped I/O
+            wil::unique_static_pseudoconsole_handle hPC;
+        };
+
+        static ConptyPool& Instance();
+
+        HRESULT Acquire(const COORD size, PseudoConsole& console) noexcept;
+
+    private:
+        struct IdleConsole
+        {
+            COORD size;
+            PseudoConsole console;
+        };
+
+        // Each idle pseudoconsole is a conhost that's kept running, so there's only a couple of them.
+        static constexpr size_t _maxIdle = 2;
+        static constexpr DWORD _flags = PSEUDOCONSOLE_RESIZE_QUIRK | PSEUDOCONSOLE_WIN32_INPUT_MODE | PSEUDOCONSOLE_REPEAT_CHARACTER;
+
+        ConptyPool();
+
+        static HRESULT _CreateOverlappedPipe(wil::unique_hfile& readPipe, wil::unique_hfile& writePipe) noexcept;
+        static HRESULT _Create(const COORD size, PseudoConsole& console) noexcept;
+        bool _IsMemoryLow() const noexcept;
+        void _Clear() noexcept;
+        winrt::fire_and_forget _Refill();
+
+        std::mutex _mutex;
+        std::vector<IdleConsole> _idle;
+        COORD _size{ 80, 25 };
+        bool _refilling{ false };
+
+        wil::unique_handle _lowMemory;
+        wil::unique_threadpool_wait _lowMemoryWait;
+    };
+}
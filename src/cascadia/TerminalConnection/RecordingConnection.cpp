@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "RecordingConnection.h"
+
+#include "RecordingConnection.g.cpp"
+#include "ReplayConnection.g.cpp"
+
+using namespace ::Microsoft::Terminal::Recording;
+
+namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
+{
+    RecordingConnection::RecordingConnection(const ITerminalConnection& connection, const hstring& path) :
+        _connection{ connection },
+        _writer{ path }
+    {
+        _outputRevoker = _connection.TerminalOutput(winrt::auto_revoke, { this, &RecordingConnection::_OutputHandler });
+        _stateChangedRevoker = _connection.StateChanged(winrt::auto_revoke, [this](auto&& /*s*/, auto&& /*e*/) {
+            _StateChangedHandlers(*this, nullptr);
+        });
+    }
+
+    void RecordingConnection::Start()
+    {
+        _connection.Start();
+    }
+
+    void RecordingConnection::WriteInput(hstring const& data)
+    {
+        _connection.WriteInput(data);
+    }
+
+    void RecordingConnection::Resize(uint32_t rows, uint32_t columns)
+    {
+        try
+        {
+            _writer.WriteResize(rows, columns);
+        }
+        CATCH_LOG();
+        _connection.Resize(rows, columns);
+    }
+
+    void RecordingConnection::Close()
+    {
+        _connection.Close();
+        try
+        {
+            _writer.Flush();
+        }
+        CATCH_LOG();
+    }
+
+    ConnectionState RecordingConnection::State() const
+    {
+        return _connection.State();
+    }
+
+    // Method Description:
+    // - Converts a recording made by a RecordingConnection into an asciicast
+    //   file, the format asciinema records and plays.
+    // Arguments:
+    // - recordingPath - the recording
+    // - asciicastPath - the asciicast file to write
+    void RecordingConnection::ExportAsciicast(const hstring& recordingPath, const hstring& asciicastPath)
+    {
+        ::Microsoft::Terminal::Recording::ExportAsciicast(ReadRecording(recordingPath), asciicastPath);
+    }
+
+    void RecordingConnection::_OutputHandler(const hstring& output)
+    {
+        try
+        {
+            _writer.WriteOutput(output);
+        }
+        CATCH_LOG();
+        _TerminalOutputHandlers(output);
+    }
+
+    ReplayConnection::ReplayConnection(const hstring& path, const bool realTime) :
+        _path{ path },
+        _realTime{ realTime }
+    {
+    }
+
+    void ReplayConnection::Start()
+    {
+        _transitionToState(ConnectionState::Connecting);
+
+        _hOutputThread.reset(CreateThread(
+            nullptr,
+            0,
+            [](LPVOID lpParameter) noexcept {
+                ReplayConnection* const pInstance = static_cast<ReplayConnection*>(lpParameter);
+                if (pInstance)
+                {
+                    return pInstance->_OutputThread();
+                }
+                return gsl::narrow_cast<DWORD>(E_INVALIDARG);
+            },
+            this,
+            0,
+            nullptr));
+        THROW_LAST_ERROR_IF_NULL(_hOutputThread);
+
+        LOG_IF_FAILED(SetThreadDescription(_hOutputThread.get(), L"ReplayConnection Output Thread"));
+    }
+
+    // Method Description:
+    // - The input of a recording isn't part of it, so there's nothing to send it to.
+    void ReplayConnection::WriteInput(hstring const& /*data*/) noexcept
+    {
+    }
+
+    void ReplayConnection::Resize(uint32_t /*rows*/, uint32_t /*columns*/) noexcept
+    {
+    }
+
+    void ReplayConnection::Close() noexcept
+    try
+    {
+        if (_transitionToState(ConnectionState::Closing))
+        {
+            _closing.SetEvent();
+            // The output thread may be the one closing us, after the output made the control close.
+            if (_hOutputThread && GetThreadId(_hOutputThread.get()) != GetCurrentThreadId())
+            {
+                LOG_LAST_ERROR_IF(WAIT_FAILED == WaitForSingleObject(_hOutputThread.get(), INFINITE));
+            }
+            _transitionToState(ConnectionState::Closed);
+        }
+    }
+    CATCH_LOG()
+
+    DWORD ReplayConnection::_OutputThread()
+    {
+        // Keep us alive until the output thread terminates, like ConptyConnection does.
+        auto strongThis{ get_strong() };
+
+        try
+        {
+            const auto records = ReadRecording(_path);
+            _transitionToState(ConnectionState::Connected);
+
+            til::u8state u8State;
+            const auto start = std::chrono::steady_clock::now();
+            for (const auto& record : records)
+            {
+                if (_realTime)
+                {
+                    const auto due = start + record.time;
+                    const auto now = std::chrono::steady_clock::now();
+                    if (due > now && _closing.wait(gsl::narrow_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(due - now).count())))
+                    {
+                        return 0;
+                    }
+                }
+                if (_closing.is_signaled())
+                {
+                    return 0;
+                }
+                if (record.kind == RecordKind::Output)
+                {
+                    THROW_IF_FAILED(til::u8u16(record.output, _u16Output, u8State));
+                    _TerminalOutputHandlers(_u16Output);
+                }
+            }
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION();
+            _transitionToState(ConnectionState::Failed);
+            return gsl::narrow_cast<DWORD>(wil::ResultFromCaughtException());
+        }
+
+        _transitionToState(ConnectionState::Closed);
+        return 0;
+    }
+}
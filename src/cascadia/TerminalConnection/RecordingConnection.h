@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "RecordingConnection.g.h"
+#include "ReplayConnection.g.h"
+#include "ConnectionStateHolder.h"
+#include "SessionRecording.h"
+
+#include "../cascadia/inc/cppwinrt_utils.h"
+
+namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
+{
+    struct RecordingConnection : RecordingConnectionT<RecordingConnection>
+    {
+        RecordingConnection(const ITerminalConnection& connection, const hstring& path);
+
+        void Start();
+        void WriteInput(hstring const& data);
+        void Resize(uint32_t rows, uint32_t columns);
+        void Close();
+
+        ConnectionState State() const;
+
+        static void ExportAsciicast(const hstring& recordingPath, const hstring& asciicastPath);
+
+        WINRT_CALLBACK(TerminalOutput, TerminalOutputHandler);
+        TYPED_EVENT(StateChanged, ITerminalConnection, IInspectable);
+
+    private:
+        void _OutputHandler(const hstring& output);
+
+        ITerminalConnection _connection;
+        ::Microsoft::Terminal::Recording::RecordingWriter _writer;
+        ITerminalConnection::TerminalOutput_revoker _outputRevoker;
+        ITerminalConnection::StateChanged_revoker _stateChangedRevoker;
+    };
+
+    struct ReplayConnection : ReplayConnectionT<ReplayConnection>, ConnectionStateHolder<ReplayConnection>
+    {
+        ReplayConnection(const hstring& path, const bool realTime);
+
+        void Start();
+        void WriteInput(hstring const& data) noexcept;
+        void Resize(uint32_t rows, uint32_t columns) noexcept;
+        void Close() noexcept;
+
+        WINRT_CALLBACK(TerminalOutput, TerminalOutputHandler);
+
+    private:
+        DWORD _OutputThread();
+
+        hstring _path;
+        bool _realTime;
+        wil::unique_event _closing{ wil::EventOptions::ManualReset };
+        wil::unique_handle _hOutputThread;
+        std::wstring _u16Output;
+    };
+}
+
+namespace winrt::Microsoft::Terminal::TerminalConnection::factory_implementation
+{
+    struct RecordingConnection : RecordingConnectionT<RecordingConnection, implementation::RecordingConnection>
+    {
+    };
+
+    struct ReplayConnection : ReplayConnectionT<ReplayConnection, implementation::ReplayConnection>
+    {
+    };
+}
@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "SessionRecording.h"
+
+using namespace ::Microsoft::Terminal::Recording;
+
+static constexpr std::string_view Signature{ "WTREC\x01\r\n" };
+
+// Inherited from the asciicast format: the size of the terminal when a
+// recording doesn't start with a resize.
+static constexpr uint32_t DefaultColumns = 80;
+static constexpr uint32_t DefaultRows = 24;
+
+RecordingWriter::RecordingWriter(const std::wstring_view path) :
+    _file{ CreateFileW(std::wstring{ path }.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) },
+    _start{ std::chrono::steady_clock::now() }
+{
+    THROW_LAST_ERROR_IF(!_file);
+    _buffer.append(Signature);
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    try
+    {
+        Flush();
+    }
+    CATCH_LOG();
+}
+
+// Method Description:
+// - Records the output of the connection. A surrogate pair split across two
+//   chunks is completed by the next one.
+// Arguments:
+// - output - the output of the connection
+void RecordingWriter::WriteOutput(const std::wstring_view output)
+{
+    std::lock_guard guard{ _lock };
+    THROW_IF_FAILED(til::u16u8(output, _u8Output, _u16State));
+    if (_u8Output.empty())
+    {
+        return;
+    }
+    _BeginRecord(RecordKind::Output);
+    _AppendVarint(_u8Output.size());
+    _buffer.append(_u8Output);
+    if (_buffer.size() >= _flushSize)
+    {
+        _FlushUnderLock();
+    }
+}
+
+// Method Description:
+// - Records a resize of the connection.
+void RecordingWriter::WriteResize(const uint32_t rows, const uint32_t columns)
+{
+    std::lock_guard guard{ _lock };
+    _BeginRecord(RecordKind::Resize);
+    _AppendVarint(columns);
+    _AppendVarint(rows);
+}
+
+// Method Description:
+// - Writes the buffered records to the file.
+void RecordingWriter::Flush()
+{
+    std::lock_guard guard{ _lock };
+    _FlushUnderLock();
+}
+
+void RecordingWriter::_BeginRecord(const RecordKind kind)
+{
+    const auto now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start);
+    _buffer.push_back(static_cast<char>(kind));
+    _AppendVarint(gsl::narrow_cast<uint64_t>((now - _last).count()));
+    _last = now;
+}
+
+void RecordingWriter::_AppendVarint(uint64_t value)
+{
+    do
+    {
+        auto byte = gsl::narrow_cast<uint8_t>(value & 0x7F);
+        value >>= 7;
+        if (value != 0)
+        {
+            byte |= 0x80;
+        }
+        _buffer.push_back(static_cast<char>(byte));
+    } while (value != 0);
+}
+
+void RecordingWriter::_FlushUnderLock()
+{
+    if (_buffer.empty())
+    {
+        return;
+    }
+    DWORD written = 0;
+    THROW_IF_WIN32_BOOL_FALSE(WriteFile(_file.get(), _buffer.data(), gsl::narrow<DWORD>(_buffer.size()), &written, nullptr));
+    _buffer.clear();
+}
+
+// Routine Description:
+// - Reads all of the records of a recording.
+// Arguments:
+// - path - the recording
+// Return Value:
+// - the records, with their times relative to the start of the recording
+std::vector<Record> Microsoft::Terminal::Recording::ReadRecording(const std::wstring_view path)
+{
+    wil::unique_hfile file{ CreateFileW(std::wstring{ path }.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+
+    LARGE_INTEGER size{};
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(file.get(), &size));
+    std::string data(gsl::narrow<size_t>(size.QuadPart), '\0');
+    DWORD read = 0;
+    THROW_IF_WIN32_BOOL_FALSE(ReadFile(file.get(), data.data(), gsl::narrow<DWORD>(data.size()), &read, nullptr));
+    data.resize(read);
+
+    constexpr auto invalidData = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    THROW_HR_IF(invalidData, data.compare(0, Signature.size(), Signature) != 0);
+
+    std::string_view remaining{ data };
+    remaining.remove_prefix(Signature.size());
+    const auto readVarint = [&]() {
+        uint64_t value = 0;
+        for (unsigned shift = 0;; shift += 7)
+        {
+            THROW_HR_IF(invalidData, remaining.empty() || shift > 63);
+            const auto byte = static_cast<uint8_t>(remaining.front());
+            remaining.remove_prefix(1);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+    };
+
+    std::vector<Record> records;
+    std::chrono::microseconds time{};
+    while (!remaining.empty())
+    {
+        auto& record = records.emplace_back();
+        record.kind = static_cast<RecordKind>(remaining.front());
+        remaining.remove_prefix(1);
+        time += std::chrono::microseconds{ gsl::narrow<int64_t>(readVarint()) };
+        record.time = time;
+
+        switch (record.kind)
+        {
+        case RecordKind::Output:
+        {
+            const auto length = gsl::narrow<size_t>(readVarint());
+            THROW_HR_IF(invalidData, length > remaining.size());
+            record.output = remaining.substr(0, length);
+            remaining.remove_prefix(length);
+            break;
+        }
+        case RecordKind::Resize:
+            record.columns = gsl::narrow<uint32_t>(readVarint());
+            record.rows = gsl::narrow<uint32_t>(readVarint());
+            break;
+        default:
+            THROW_HR(invalidData);
+        }
+    }
+    return records;
+}
+
+// Routine Description:
+// - Writes the records as an asciicast v2 file, the format of asciinema.
+// Arguments:
+// - records - the records of a recording
+// - path - the asciicast file to write
+void Microsoft::Terminal::Recording::ExportAsciicast(const std::vector<Record>& records, const std::wstring_view path)
+{
+    const auto escape = [](std::string& out, const std::string_view text) {
+        for (const auto ch : text)
+        {
+            if (ch == '"' || ch == '\\')
+            {
+                out.push_back('\\');
+                out.push_back(ch);
+            }
+            else if (static_cast<uint8_t>(ch) < 0x20)
+            {
+                fmt::format_to(std::back_inserter(out), FMT_COMPILE("\\u{:04x}"), static_cast<uint8_t>(ch));
+            }
+            else
+            {
+                out.push_back(ch);
+            }
+        }
+    };
+
+    auto columns = DefaultColumns;
+    auto rows = DefaultRows;
+    auto first = records.begin();
+    if (first != records.end() && first->kind == RecordKind::Resize)
+    {
+        columns = first->columns;
+        rows = first->rows;
+        ++first;
+    }
+
+    std::string cast;
+    fmt::format_to(std::back_inserter(cast), FMT_COMPILE("{{\"version\": 2, \"width\": {}, \"height\": {}}}\n"), columns, rows);
+    for (auto it = first; it != records.end(); ++it)
+    {
+        const auto seconds = std::chrono::duration<double>(it->time).count();
+        if (it->kind == RecordKind::Output)
+        {
+            fmt::format_to(std::back_inserter(cast), FMT_COMPILE("[{:.6f}, \"o\", \""), seconds);
+            escape(cast, it->output);
+            cast.append("\"]\n");
+        }
+        else
+        {
+            fmt::format_to(std::back_inserter(cast), FMT_COMPILE("[{:.6f}, \"r\", \"{}x{}\"]\n"), seconds, it->columns, it->rows);
+        }
+    }
+
+    wil::unique_hfile file{ CreateFileW(std::wstring{ path }.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+    DWORD written = 0;
+    THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), cast.data(), gsl::narrow<DWORD>(cast.size()), &written, nullptr));
+}
@@ -0,0 +1,73 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SessionRecording.h
+
+Abstract:
+- The file format of the session recordings made by RecordingConnection and
+  played back by ReplayConnection. A recording is the output of a connection
+  and its resizes, each with the time it happened at, so that a real session
+  can be replayed as a reproducible workload.
+- The format is an 8 byte signature followed by the records. Each record is
+  a kind byte, the microseconds since the previous record and its payload,
+  with all of the numbers as LEB128 varints:
+  - Output: the length of the text, then the text in UTF-8
+  - Resize: the columns, then the rows
+- Recordings can be exported as asciicast v2 files, too.
+
+--*/
+
+#pragma once
+
+namespace Microsoft::Terminal::Recording
+{
+    enum class RecordKind : uint8_t
+    {
+        Output = 0,
+        Resize = 1,
+    };
+
+    struct Record
+    {
+        RecordKind kind{ RecordKind::Output };
+        std::chrono::microseconds time{}; // since the start of the recording
+        std::string output; // UTF-8
+        uint32_t columns{};
+        uint32_t rows{};
+    };
+
+    class RecordingWriter final
+    {
+    public:
+        explicit RecordingWriter(const std::wstring_view path);
+        ~RecordingWriter();
+
+        RecordingWriter(const RecordingWriter&) = delete;
+        RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+        void WriteOutput(const std::wstring_view output);
+        void WriteResize(const uint32_t rows, const uint32_t columns);
+        void Flush();
+
+    private:
+        void _BeginRecord(const RecordKind kind);
+        void _AppendVarint(uint64_t value);
+        void _FlushUnderLock();
+
+        // The records are buffered and written once this much is together.
+        static constexpr size_t _flushSize = 64 * 1024;
+
+        std::mutex _lock;
+        wil::unique_hfile _file;
+        std::string _buffer;
+        std::string _u8Output;
+        til::u16state _u16State;
+        std::chrono::steady_clock::time_point _start;
+        std::chrono::microseconds _last{};
+    };
+
+    std::vector<Record> ReadRecording(const std::wstring_view path);
+    void ExportAsciicast(const std::vector<Record>& records, const std::wstring_view path);
+}
@@ -10,9 +10,12 @@
 #include <Utils.h>
 #include <WinUser.h>
 #include <LibraryResources.h>
+#include <StartupTracing.h>
 #include "../../types/inc/GlyphWidth.hpp"
 #include "../../types/inc/Utils.hpp"
 #include "../../buffer/out/search.h"
+#include "../../buffer/out/RegexSearch.hpp"
+#include "../../buffer/out/RowSerializer.hpp"
 
 #include "ControlCore.g.cpp"
 
@@ -49,19 +52,36 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _connection{ connection },
         _settings{ settings },
         _desiredFont{ DEFAULT_FONT_FACE, 0, DEFAULT_FONT_WEIGHT, { 0, DEFAULT_FONT_SIZE }, CP_UTF8 },
-        _actualFont{ DEFAULT_FONT_FACE, 0, DEFAULT_FONT_WEIGHT, { 0, DEFAULT_FONT_SIZE }, CP_UTF8, false }
+        _actualFont{ DEFAULT_FONT_FACE, 0, DEFAULT_FONT_WEIGHT, { 0, DEFAULT_FONT_SIZE }, CP_UTF8, false },
+        _settingsFont{ DEFAULT_FONT_FACE, 0, DEFAULT_FONT_WEIGHT, { 0, DEFAULT_FONT_SIZE }, CP_UTF8 }
     {
         _EnsureStaticInitialization();
 
         _terminal = std::make_unique<::Microsoft::Terminal::Core::Terminal>();
 
+        _idleTrimTimer.reset(CreateThreadpoolTimer(
+            [](PTP_CALLBACK_INSTANCE /*instance*/, PVOID context, PTP_TIMER /*timer*/) noexcept {
+                static_cast<ControlCore*>(context)->_idleTrimTimerFired();
+            },
+            this,
+            nullptr));
+        LOG_LAST_ERROR_IF_NULL(_idleTrimTimer);
+
         // Subscribe to the connection's disconnected event and call our connection closed handlers.
         _connectionStateChangedRevoker = _connection.StateChanged(winrt::auto_revoke, [this](auto&& /*s*/, auto&& /*v*/) {
             _ConnectionStateChangedHandlers(*this, nullptr);
         });
 
         // This event is explicitly revoked in the destructor: does not need weak_ref
-        _connectionOutputEventToken = _connection.TerminalOutput({ this, &ControlCore::_connectionOutputHandler });
+        // ConPTY output is parsed as the UTF-8 it was read as, without converting it to UTF-16 and back.
+        if (const auto conpty = _connection.try_as<TerminalConnection::ConptyConnection>())
+        {
+            _connectionOutputUtf8EventToken = conpty.TerminalOutputUtf8({ this, &ControlCore::_connectionOutputUtf8Handler });
+        }
+        else
+        {
+            _connectionOutputEventToken = _connection.TerminalOutput({ this, &ControlCore::_connectionOutputHandler });
+        }
 
         _terminal->SetWriteInputCallback([this](std::wstring& wstr) {
             _sendInputToConnection(wstr);
@@ -111,6 +131,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                  const double actualHeight,
                                  const double compositionScale)
     {
+        TRACE_STARTUP_PHASE(g_hTerminalControlProvider, "ControlCore");
+
         _panelWidth = actualWidth;
         _panelHeight = actualHeight;
         _compositionScale = compositionScale;
@@ -146,11 +168,22 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             _renderer->SetRendererEnteredErrorStateCallback([weakThis = get_weak()]() {
                 if (auto strongThis{ weakThis.get() })
                 {
+                    strongThis->_paintingEnabled = false;
+                    strongThis->_publishUiState();
                     strongThis->_RendererEnteredErrorStateHandlers(*strongThis, nullptr);
                 }
             });
 
+            _renderer->SetFramePaintedCallback([weakThis = get_weak()]() {
+                if (auto strongThis{ weakThis.get() })
+                {
+                    strongThis->_publishUiState();
+                    strongThis->_sampleStatistics();
+                }
+            });
+
             THROW_IF_FAILED(localPointerToThread->Initialize(_renderer.get()));
+            _renderer->SetThreadPriority(_threadPriority);
 
             // Set up the DX Engine
             auto dxEngine = std::make_unique<::Microsoft::Console::Render::DxEngine>();
@@ -198,6 +231,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             dxEngine->SetPixelShaderPath(_settings.PixelShaderPath());
             dxEngine->SetForceFullRepaintRendering(_settings.ForceFullRepaintRendering());
             dxEngine->SetSoftwareRendering(_settings.SoftwareRendering());
+            _frameTimeOverlay = _settings.FrameTimeOverlay();
+            dxEngine->SetFrameTimeOverlay(_frameTimeOverlay);
+            dxEngine->SetGlyphAtlasRendering(_settings.GlyphAtlasRendering());
+            dxEngine->SetSmoothScrolling(_settings.SmoothScrolling());
+            _renderer->SetOverscanRows(_settings.SmoothScrolling() ? 1 : 0);
+            dxEngine->SetPixelShaderFrameRate(_settings.PixelShaderFrameRate());
 
             _updateAntiAliasingMode(dxEngine.get());
 
@@ -210,6 +249,21 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             THROW_IF_FAILED(dxEngine->Enable());
             _renderEngine = std::move(dxEngine);
 
+            // The automatic power preference follows the battery saver,
+            // which may be turned on or off at any time.
+            _energySaverStatusChangedRevoker = winrt::Windows::System::Power::PowerManager::EnergySaverStatusChanged(winrt::auto_revoke, [weakThis = get_weak()](auto&&, auto&&) {
+                if (auto core{ weakThis.get() }; core && !core->_closing)
+                {
+                    try
+                    {
+                        auto lock = core->_terminal->LockForWriting();
+                        core->_applyPowerPreference();
+                    }
+                    CATCH_LOG();
+                }
+            });
+            _applyPowerPreference();
+
             _initializedTerminal = true;
         } // scope for TerminalLock
 
@@ -233,6 +287,189 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         if (_initializedTerminal)
         {
             _renderer->EnablePainting();
+            _paintingEnabled = true;
+        }
+    }
+
+    // Method Description:
+    // - Tell the renderer to stop painting while the control can't be seen.
+    //   It keeps track of what changed and paints it once it's resumed.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void ControlCore::SuspendPainting()
+    {
+        if (_initializedTerminal)
+        {
+            _renderer->SuspendPainting();
+        }
+    }
+
+    // Method Description:
+    // - Tell the renderer to paint again after SuspendPainting.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void ControlCore::ResumePainting()
+    {
+        if (_initializedTerminal)
+        {
+            _renderer->ResumePainting();
+        }
+    }
+
+    // Method Description:
+    // - Puts the control into the background, for while it can't be seen (like
+    //   in a tab that isn't selected). Output is still written to the buffer,
+    //   but painting is suspended and the scroll position, cursor position and
+    //   output events aren't raised, so the UI doesn't update any of the state
+    //   it derives from them.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void ControlCore::EnterBackground()
+    {
+        _inBackground = true;
+        SuspendPainting();
+
+        // No frames are painted from here on, so what's pending would be held back.
+        _publishUiState();
+
+        // Nothing is going to be painted for a while, so the caches can go right away.
+        try
+        {
+            Trim();
+        }
+        CATCH_LOG();
+    }
+
+    // Method Description:
+    // - Brings the control back from the background. The events suppressed in
+    //   the meantime are raised once, with the current state of the terminal.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void ControlCore::LeaveBackground()
+    {
+        const auto wasInBackground = _inBackground.exchange(false);
+        ResumePainting();
+
+        if (wasInBackground && _initializedTerminal)
+        {
+            // Output that arrives from here on raises the events as usual,
+            // so this only needs to catch up on what came before.
+            _ScrollPositionChangedHandlers(*this,
+                                           winrt::make<ScrollPositionChangedArgs>(ScrollOffset(),
+                                                                                  ViewHeight(),
+                                                                                  BufferHeight()));
+            _CursorPositionChangedHandlers(*this, nullptr);
+            _ReceivedOutputHandlers(*this, nullptr);
+        }
+    }
+
+    // Method Description:
+    // - Gives back the memory that the buffer, the renderer and the output
+    //   thread only keep around to go faster, like the caches of the rows and
+    //   of the text layouts, or the capacity that the last burst of output left
+    //   behind. Everything is built again on demand.
+    // - Called once the control was idle for a while, or put in the background.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void ControlCore::Trim()
+    {
+        if (!_initializedTerminal || _closing)
+        {
+            return;
+        }
+
+        {
+            auto lock = _terminal->LockForWriting();
+            _terminal->Trim();
+            _renderer->Trim();
+        }
+
+        std::lock_guard guard{ _outputLock };
+        _outputSpares = {};
+    }
+
+    // Method Description:
+    // - Records that the control was just written to or read from, and arms
+    //   the idle timer, unless it's already waiting.
+    void ControlCore::_noteActivity() noexcept
+    {
+        _lastActivity.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        if (!_idleTrimArmed.exchange(true, std::memory_order_relaxed))
+        {
+            _armIdleTrim(_idleTrimDelay);
+        }
+    }
+
+    void ControlCore::_armIdleTrim(const std::chrono::steady_clock::duration delay) noexcept
+    {
+        if (!_idleTrimTimer)
+        {
+            return;
+        }
+        // Negative due times are relative to now, in units of 100ns.
+        const auto due = -std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(delay).count();
+        FILETIME dueTime{ gsl::narrow_cast<DWORD>(due), gsl::narrow_cast<DWORD>(due >> 32) };
+        SetThreadpoolTimerEx(_idleTrimTimer.get(), &dueTime, 0, 0);
+    }
+
+    // Method Description:
+    // - Trims the caches, if there was no activity since the timer was armed.
+    //   Otherwise the timer is armed again, for when it's been idle long enough.
+    void ControlCore::_idleTrimTimerFired() noexcept
+    {
+        const std::chrono::steady_clock::duration idle{ std::chrono::steady_clock::now().time_since_epoch().count() - _lastActivity.load(std::memory_order_relaxed) };
+        if (idle < _idleTrimDelay)
+        {
+            _armIdleTrim(_idleTrimDelay - idle);
+            return;
+        }
+
+        _idleTrimArmed.store(false, std::memory_order_relaxed);
+        try
+        {
+            Trim();
+        }
+        CATCH_LOG();
+    }
+
+    // Method Description:
+    // - Raises the priority of the output and render threads while the control
+    //   has the focus, and lowers it while it doesn't. When other controls are
+    //   flooded with output, the one the user types into still gets to parse
+    //   and paint its echo first.
+    // Arguments:
+    // - focused: whether the control has the focus
+    // Return Value:
+    // - <none>
+    void ControlCore::SetFocused(const bool focused)
+    {
+        const auto priority = focused ? THREAD_PRIORITY_ABOVE_NORMAL : THREAD_PRIORITY_BELOW_NORMAL;
+        if (_threadPriority.exchange(priority) == priority)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard guard{ _outputLock };
+            if (_outputThread.joinable())
+            {
+                LOG_IF_WIN32_BOOL_FALSE(SetThreadPriority(_outputThread.native_handle(), priority));
+            }
+        }
+
+        if (_renderer)
+        {
+            _renderer->SetThreadPriority(priority);
         }
     }
 
@@ -249,9 +486,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         {
             _raiseReadOnlyWarning();
         }
-        else
+        else if (auto connection{ _connection })
         {
-            _connection.WriteInput(wstr);
+            _noteActivity();
+            // Large pastes are written from a background thread, which may
+            // get here while the connection is being closed.
+            connection.WriteInput(wstr);
         }
     }
 
@@ -270,7 +510,14 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                     const WORD scanCode,
                                     const ::Microsoft::Terminal::Core::ControlKeyStates modifiers)
     {
-        return _terminal->SendCharEvent(ch, scanCode, modifiers);
+        const auto time = std::chrono::steady_clock::now();
+        const auto handled = _terminal->SendCharEvent(ch, scanCode, modifiers, _broadcastInput ? &_sentKeyEvents : nullptr);
+        if (handled)
+        {
+            _terminal->NoteInput(time);
+        }
+        _raiseInputSent();
+        return handled;
     }
 
     // Method Description:
@@ -319,11 +566,126 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // If the terminal translated the key, mark the event as handled.
         // This will prevent the system from trying to get the character out
         // of it and sending us a CharacterReceived event.
-        return vkey ? _terminal->SendKeyEvent(vkey,
-                                              scanCode,
-                                              modifiers,
-                                              keyDown) :
-                      true;
+        if (!vkey)
+        {
+            return true;
+        }
+
+        // The keystroke is timed from here, so that its latency includes translating it.
+        // Modifier keys are sent in win32-input-mode, but nothing echoes them.
+        const auto time = std::chrono::steady_clock::now();
+        const auto handled = _terminal->SendKeyEvent(vkey, scanCode, modifiers, keyDown, _broadcastInput ? &_sentKeyEvents : nullptr);
+        if (handled && keyDown && !KeyEvent::IsModifierKey(vkey))
+        {
+            _terminal->NoteInput(time);
+        }
+        _raiseInputSent();
+        return handled;
+    }
+
+    // Method Description:
+    // - Whether the key events that are sent to this terminal are broadcast to
+    //   others as well. While they are, InputSent is raised for each of them.
+    bool ControlCore::BroadcastInput() const noexcept
+    {
+        return _broadcastInput;
+    }
+
+    void ControlCore::BroadcastInput(const bool broadcastInput)
+    {
+        _broadcastInput = broadcastInput;
+        _sentKeyEvents.clear();
+    }
+
+    // Method Description:
+    // - Gets the modes which change how this terminal encodes keys, without
+    //   locking it. Terminals in the same modes get the same broadcast input.
+    Control::InputModes ControlCore::InputModes() const noexcept
+    {
+        return static_cast<Control::InputModes>(_terminal->GetInputModes());
+    }
+
+    // Method Description:
+    // - Raises InputSent with the key events that were sent to the terminal
+    //   since it was raised last, so that they can be encoded for the terminals
+    //   they're broadcast to, once for each of their input modes.
+    void ControlCore::_raiseInputSent()
+    {
+        // The leading half of a surrogate pair is only encoded with its trailing half.
+        if (_sentKeyEvents.empty() || Utf16Parser::IsLeadingSurrogate(_sentKeyEvents.back().GetCharData()))
+        {
+            return;
+        }
+
+        auto events{ std::move(_sentKeyEvents) };
+        _sentKeyEvents.clear();
+        if (_isReadOnly)
+        {
+            return;
+        }
+
+        _InputSentHandlers(*this, winrt::make<InputSentEventArgs>([events = std::move(events)](const Control::InputModes modes) {
+            return hstring{ ::Microsoft::Terminal::Core::Terminal::EncodeKeyEvents(static_cast<TerminalInput::Mode>(modes), events) };
+        }));
+    }
+
+    // Method Description:
+    // - Writes input that was broadcast from another terminal to the connection.
+    //   Nothing but the connection is touched: the selection, the viewport and
+    //   the cursor stay as they are, and so does the UI thread, because the
+    //   input is written in the background. Each control writes whatever was
+    //   broadcast to it in order, while the controls write theirs in parallel.
+    // Arguments:
+    // - wstr: the already encoded input to write.
+    void ControlCore::SendBroadcastInput(const winrt::hstring& wstr)
+    {
+        // Unlike typing into it, which warns about it, a read-only pane is
+        // just left out of the panes that input is broadcast to.
+        if (_isReadOnly || wstr.empty())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard guard{ _broadcastLock };
+            _broadcastQueue.append(wstr);
+            if (std::exchange(_broadcastBusy, true))
+            {
+                return;
+            }
+        }
+        _asyncWriteBroadcastInput();
+    }
+
+    // Method Description:
+    // - Writes the broadcast input that's queued to the connection, until no more
+    //   is. Input that's queued meanwhile is written all at once, after it.
+    winrt::fire_and_forget ControlCore::_asyncWriteBroadcastInput()
+    {
+        auto strongThis{ get_strong() };
+
+        co_await winrt::resume_background();
+
+        // The queue and this buffer are swapped, so that neither is allocated again.
+        std::wstring text;
+        for (;;)
+        {
+            {
+                std::lock_guard guard{ _broadcastLock };
+                text.clear();
+                text.swap(_broadcastQueue);
+                if (text.empty() || _closing)
+                {
+                    _broadcastBusy = false;
+                    co_return;
+                }
+            }
+
+            if (auto connection{ _connection })
+            {
+                connection.WriteInput(text);
+            }
+        }
     }
 
     bool ControlCore::SendMouseEvent(const til::point viewportPos,
@@ -337,14 +699,45 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     void ControlCore::UserScrollViewport(const int viewTop)
     {
-        // Clear the regex pattern tree so the renderer does not try to render them while scrolling
-        _terminal->ClearPatternTree();
-
         // This is a scroll event that wasn't initiated by the terminal
         //      itself - it was initiated by the mouse wheel, or the scrollbar.
         _terminal->UserScrollViewport(viewTop);
     }
 
+    bool ControlCore::SmoothScrolling() const
+    {
+        return _settings.SmoothScrolling();
+    }
+
+    double ControlCore::SmoothScrollOffset() const noexcept
+    {
+        return _smoothScrollOffset;
+    }
+
+    // Method Description:
+    // - Moves the text up by a fraction of a row, for scrolling in between the
+    //   rows UserScrollViewport scrolls to. The renderer moves what it already
+    //   drew on the GPU, so the text isn't drawn again for it.
+    // - Just like the viewport can't be scrolled past the bottom of the
+    //   buffer, there's no offset when it's at the bottom.
+    // Arguments:
+    // - offset: the fraction of a row to move the text up by, from 0 to 1
+    void ControlCore::SetSmoothScrollOffset(const double offset)
+    {
+        if (!_renderEngine || !_settings.SmoothScrolling())
+        {
+            return;
+        }
+
+        auto lock = _terminal->LockForWriting();
+        const auto atBottom = ScrollOffset() + ViewHeight() >= BufferHeight();
+        _smoothScrollOffset = atBottom ? 0.0 : std::clamp(offset, 0.0, 1.0);
+        if (_renderEngine->SetSmoothScrollOffset(static_cast<float>(_smoothScrollOffset)) == S_OK)
+        {
+            _renderer->TriggerFrame();
+        }
+    }
+
     void ControlCore::AdjustOpacity(const double adjustment)
     {
         if (adjustment == 0)
@@ -511,8 +904,17 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         //      The family is only used to determine if the font is truetype or
         //      not, but DX doesn't use that info at all.
         //      The Codepage is additionally not actually used by the DX engine at all.
-        _actualFont = { fontFace, 0, fontWeight.Weight, { 0, fontHeight }, CP_UTF8, false };
-        _desiredFont = { _actualFont };
+        const FontInfo settingsFont{ fontFace, 0, fontWeight.Weight, { 0, fontHeight }, CP_UTF8, false };
+        // Looking up a font is expensive, so we only do it when the settings
+        // asked for another one. This also keeps the font size the user
+        // zoomed to, when the settings were reloaded for something else.
+        const auto fontChanged = !(FontInfoDesired{ settingsFont } == _settingsFont);
+        if (fontChanged)
+        {
+            _actualFont = settingsFont;
+            _desiredFont = { _actualFont };
+            _settingsFont = { _actualFont };
+        }
 
         // Update the terminal core with its new Core settings
         _terminal->UpdateSettings(_settings);
@@ -526,15 +928,26 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         _renderEngine->SetForceFullRepaintRendering(_settings.ForceFullRepaintRendering());
         _renderEngine->SetSoftwareRendering(_settings.SoftwareRendering());
+        _frameTimeOverlay = _settings.FrameTimeOverlay();
+        _renderEngine->SetFrameTimeOverlay(_frameTimeOverlay);
+        _renderEngine->SetGlyphAtlasRendering(_settings.GlyphAtlasRendering());
+        _renderEngine->SetSmoothScrolling(_settings.SmoothScrolling());
+        _renderer->SetOverscanRows(_settings.SmoothScrolling() ? 1 : 0);
+        _smoothScrollOffset = 0.0;
+        _renderEngine->SetPixelShaderFrameRate(_settings.PixelShaderFrameRate());
         _updateAntiAliasingMode(_renderEngine.get());
+        _applyPowerPreference();
 
         // Refresh our font with the renderer
-        const auto actualFontOldSize = _actualFont.GetSize();
-        _updateFont();
-        const auto actualFontNewSize = _actualFont.GetSize();
-        if (actualFontNewSize != actualFontOldSize)
+        if (fontChanged)
         {
-            _refreshSizeUnderLock();
+            const auto actualFontOldSize = _actualFont.GetSize();
+            _updateFont();
+            const auto actualFontNewSize = _actualFont.GetSize();
+            if (actualFontNewSize != actualFontOldSize)
+            {
+                _refreshSizeUnderLock();
+            }
         }
     }
 
@@ -577,6 +990,51 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
     }
 
+    // Method Description:
+    // - Picks the GPU and the quality of the rendering from the power preference
+    //   of the settings. The power saver tier draws on the GPU that uses the least
+    //   power, without pixel shaders, at no more than 30 frames per second.
+    //   Automatic saves power only while the battery saver is on.
+    // - Must be called with the terminal locked for writing, once the render
+    //   engine was created. Raises PowerSavingChanged when the tier changes, so
+    //   that the control can slow its cursor down and drop its acrylic.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void ControlCore::_applyPowerPreference()
+    {
+        using namespace winrt::Windows::System::Power;
+
+        const auto preference = _settings.PowerPreference();
+        const auto saving = preference == GraphicsPowerPreference::PowerSaver ||
+                            (preference == GraphicsPowerPreference::Automatic && PowerManager::EnergySaverStatus() == EnergySaverStatus::On);
+
+        auto gpuPreference = DXGI_GPU_PREFERENCE_UNSPECIFIED;
+        if (preference == GraphicsPowerPreference::HighPerformance)
+        {
+            gpuPreference = DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE;
+        }
+        else if (saving)
+        {
+            gpuPreference = DXGI_GPU_PREFERENCE_MINIMUM_POWER;
+        }
+
+        _renderEngine->SetGpuPreference(gpuPreference);
+        _renderEngine->SetPowerSaving(saving);
+        _renderer->SetMinimumFrameInterval(std::chrono::milliseconds{ saving ? 33 : 0 });
+
+        if (_powerSaving.exchange(saving) != saving)
+        {
+            _PowerSavingChangedHandlers(*this, nullptr);
+        }
+    }
+
+    bool ControlCore::PowerSaving() const noexcept
+    {
+        return _powerSaving;
+    }
+
     // Method Description:
     // - Update the font with the renderer. This will be called either when the
     //      font changes or the DPI changes, as DPI changes will necessitate a
@@ -689,8 +1147,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // Arguments:
     // - newWidth: the new width of the swapchain, in pixels.
     // - newHeight: the new height of the swapchain, in pixels.
+    // - live: true while the user is still resizing. Reflowing most of the
+    //   scrollback is deferred then, until FinishResize is called.
     void ControlCore::_doResizeUnderLock(const double newWidth,
-                                         const double newHeight)
+                                         const double newHeight,
+                                         const bool live)
     {
         SIZE size;
         size.cx = static_cast<long>(newWidth);
@@ -718,38 +1179,138 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         // If this function succeeds with S_FALSE, then the terminal didn't
         // actually change size. No need to notify the connection of this no-op.
-        const HRESULT hr = _terminal->UserResize({ vp.Width(), vp.Height() });
+        const HRESULT hr = _terminal->UserResize({ vp.Width(), vp.Height() }, live);
         if (SUCCEEDED(hr) && hr != S_FALSE)
         {
             _connection.Resize(vp.Height(), vp.Width());
+            _restartSearch();
         }
     }
 
+    // Method Description:
+    // - Resizes the terminal to the new size of the panel, in the background.
+    //   The UI thread returns right away, while the last frame that was
+    //   presented stays up until the one for the new size replaces it.
+    // Arguments:
+    // - width: the new width of the panel, in DIPs.
+    // - height: the new height of the panel, in DIPs.
     void ControlCore::SizeChanged(const double width,
                                   const double height)
     {
-        _panelWidth = width;
-        _panelHeight = height;
-
-        auto lock = _terminal->LockForWriting();
-        const auto currentEngineScale = _renderEngine->GetScaling();
+        {
+            std::lock_guard guard{ _resizeLock };
+            _pendingSize.emplace(width, height);
+            if (std::exchange(_resizeBusy, true))
+            {
+                return;
+            }
+        }
 
-        auto scaledWidth = width * currentEngineScale;
-        auto scaledHeight = height * currentEngineScale;
-        _doResizeUnderLock(scaledWidth, scaledHeight);
+        _asyncResize();
     }
 
-    void ControlCore::ScaleChanged(const double scale)
+    // Method Description:
+    // - Applies the sizes that SizeChanged queued, until no more are. Only the
+    //   most recent one is applied, if several were queued meanwhile.
+    winrt::fire_and_forget ControlCore::_asyncResize()
     {
-        if (!_renderEngine)
-        {
-            return;
-        }
+        auto strongThis{ get_strong() };
 
-        const auto currentEngineScale = _renderEngine->GetScaling();
-        // If we're getting a notification to change to the DPI we already
-        // have, then we're probably just beginning the DPI change. Since
-        // we'll get _another_ event with the real DPI, do nothing here for
+        co_await winrt::resume_background();
+
+        for (;;)
+        {
+            auto lock = _terminal->LockForWriting();
+            {
+                std::lock_guard guard{ _resizeLock };
+                if (!_pendingSize || _closing)
+                {
+                    _resizeBusy = false;
+                    co_return;
+                }
+            }
+
+            try
+            {
+                _applyPendingSizeUnderLock();
+            }
+            CATCH_LOG();
+        }
+    }
+
+    // Method Description:
+    // - Resizes the terminal to the size that SizeChanged queued last, if
+    //   there's one that wasn't applied yet.
+    // - The write lock should be held when calling this method.
+    void ControlCore::_applyPendingSizeUnderLock()
+    {
+        std::optional<std::pair<double, double>> size;
+        {
+            std::lock_guard guard{ _resizeLock };
+            size = std::exchange(_pendingSize, std::nullopt);
+        }
+
+        if (!size)
+        {
+            return;
+        }
+
+        const auto [width, height] = *size;
+
+        // The panel comes back at the size it had, after it was zoomed and
+        // unzoomed, or moved to a pane of the same size. What's been painted
+        // for that size is still right then.
+        if (width == _panelWidth && height == _panelHeight)
+        {
+            return;
+        }
+
+        _panelWidth = width;
+        _panelHeight = height;
+
+        const auto currentEngineScale = _renderEngine->GetScaling();
+
+        auto scaledWidth = width * currentEngineScale;
+        auto scaledHeight = height * currentEngineScale;
+        _doResizeUnderLock(scaledWidth, scaledHeight, true);
+    }
+
+    // Method Description:
+    // - Reflows the scrollback that SizeChanged left as it was. We should call
+    //   this (through a throttled function) once the size stopped changing.
+    // - A size that's still queued is applied first, so that the reflow
+    //   is for the final size.
+    void ControlCore::FinishResize()
+    {
+        auto lock = _terminal->LockForWriting();
+        _applyPendingSizeUnderLock();
+        LOG_IF_FAILED(_terminal->FinishPendingReflow());
+        _restartSearch();
+    }
+
+    // Method Description:
+    // - Searches again after the text of the buffer moved around, like when
+    //   it's reflowed. The matches found so far are at the wrong places now.
+    void ControlCore::_restartSearch()
+    {
+        if (!_searchText.empty())
+        {
+            _terminal->SetSearchHighlights({});
+            _asyncSearch(_searchText, _searchCaseSensitive, _searchRegex);
+        }
+    }
+
+    void ControlCore::ScaleChanged(const double scale)
+    {
+        if (!_renderEngine)
+        {
+            return;
+        }
+
+        const auto currentEngineScale = _renderEngine->GetScaling();
+        // If we're getting a notification to change to the DPI we already
+        // have, then we're probably just beginning the DPI change. Since
+        // we'll get _another_ event with the real DPI, do nothing here for
         // now. We'll also skip the next resize in _swapChainSizeChanged.
         const bool dpiWasUnchanged = currentEngineScale == scale;
         if (dpiWasUnchanged)
@@ -833,35 +1394,36 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             return false;
         }
 
-        // extract text from buffer
-        // RetrieveSelectedTextFromBuffer will lock while it's reading
-        const auto bufferData = _terminal->RetrieveSelectedTextFromBuffer(singleLine);
-
-        // convert text: vector<string> --> string
-        std::wstring textData;
-        for (const auto& text : bufferData.text)
-        {
-            textData += text;
-        }
-
-        // convert text to HTML format
+        // extract the text from the buffer, along with the HTML and RTF formats if requested
         // GH#5347 - Don't provide a title for the generated HTML, as many
         // web applications will paste the title first, followed by the HTML
         // content, which is unexpected.
-        const auto htmlData = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::HTML) ?
-                                  TextBuffer::GenHTML(bufferData,
-                                                      _actualFont.GetUnscaledSize().Y,
-                                                      _actualFont.GetFaceName(),
-                                                      til::color{ _settings.DefaultBackground() }) :
-                                  "";
-
-        // convert to RTF format
-        const auto rtfData = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::RTF) ?
-                                 TextBuffer::GenRTF(bufferData,
-                                                    _actualFont.GetUnscaledSize().Y,
-                                                    _actualFont.GetFaceName(),
-                                                    til::color{ _settings.DefaultBackground() }) :
-                                 "";
+        TextBuffer::RichTextFormats richText;
+        richText.html = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::HTML);
+        richText.rtf = formats == nullptr || WI_IsFlagSet(formats.Value(), CopyFormat::RTF);
+        richText.fontHeightPoints = _actualFont.GetUnscaledSize().Y;
+        richText.fontFaceName = _actualFont.GetFaceName();
+        richText.backgroundColor = til::color{ _settings.DefaultBackground() };
+
+        // ExportSelectedText will lock while it's reading
+        auto exported = _terminal->ExportSelectedText(singleLine, richText);
+
+        // Only the colors are taken now. HTML and RTF are generated from them if
+        // something asks the clipboard for them, as most pastes only want the text.
+        std::function<winrt::hstring()> html;
+        std::function<winrt::hstring()> rtf;
+        if (!exported.richText.empty())
+        {
+            const auto rich = std::make_shared<const TextBuffer::RichText>(std::move(exported.richText));
+            if (richText.html)
+            {
+                html = [rich]() { return winrt::to_hstring(rich->GenHTML()); };
+            }
+            if (richText.rtf)
+            {
+                rtf = [rich]() { return winrt::to_hstring(rich->GenRTF()); };
+            }
+        }
 
         if (!_settings.CopyOnSelect())
         {
@@ -871,9 +1433,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         // send data up for clipboard
         _CopyToClipboardHandlers(*this,
-                                 winrt::make<CopyToClipboardEventArgs>(winrt::hstring{ textData },
-                                                                       winrt::to_hstring(htmlData),
-                                                                       winrt::to_hstring(rtfData),
+                                 winrt::make<CopyToClipboardEventArgs>(winrt::hstring{ exported.text },
+                                                                       std::move(html),
+                                                                       std::move(rtf),
                                                                        formats));
         return true;
     }
@@ -881,13 +1443,51 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // Method Description:
     // - Pre-process text pasted (presumably from the clipboard)
     //   before sending it over the terminal's connection.
+    // - Large pastes are written from a background thread, see _asyncPasteText.
     void ControlCore::PasteText(const winrt::hstring& hstr)
     {
-        _terminal->WritePastedText(hstr);
+        if (hstr.size() > _asyncPasteThreshold)
+        {
+            _asyncPasteText(hstr);
+        }
+        else
+        {
+            // Cancels a large paste that's still being written.
+            ++_pasteGeneration;
+            std::lock_guard guard{ _pasteLock };
+            _terminal->WritePastedText(hstr);
+        }
         _terminal->ClearSelection();
         _terminal->TrySnapOnInput();
     }
 
+    // Method Description:
+    // - Writes a large paste to the connection on a background thread, so that
+    //   the UI doesn't hang while the client reads its input. A new paste
+    //   cancels the rest of the one before it, and so does closing the control.
+    // Arguments:
+    // - text: the text to paste
+    // Return Value:
+    // - <none>
+    winrt::fire_and_forget ControlCore::_asyncPasteText(const winrt::hstring text)
+    {
+        auto strongThis{ get_strong() };
+        const auto generation = ++_pasteGeneration;
+
+        co_await winrt::resume_background();
+
+        // Pastes are written one after the other, never interleaved.
+        std::lock_guard guard{ _pasteLock };
+        if (_closing || _pasteGeneration != generation)
+        {
+            co_return;
+        }
+
+        _terminal->WritePastedText(text, [&](const size_t) {
+            return !_closing && _pasteGeneration == generation;
+        });
+    }
+
     FontInfo ControlCore::GetFont() const
     {
         return _actualFont;
@@ -966,14 +1566,162 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     // Function Description:
     // - Gets the height of the terminal in lines of text. This includes the
-    //   history AND the viewport.
+    //   history (with the scrollback archive) AND the viewport.
     // Return Value:
     // - The height of the terminal in lines of text
     int ControlCore::BufferHeight() const
     {
-        return _terminal->GetBufferHeight();
+        return _terminal->GetScrollbackHeight();
+    }
+
+    // Method Description:
+    // - Tells where the search matches and the prompts are, for the scrollbar.
+    // Arguments:
+    // - bins: the number of bins the rows of the buffer are split into
+    // Return Value:
+    // - per bin, whether it has matches and prompts. See Terminal::GetScrollMarks.
+    std::vector<uint8_t> ControlCore::ScrollMarks(const size_t bins) const
+    {
+        auto lock = _terminal->LockForReading();
+        return _terminal->GetScrollMarks(bins);
+    }
+
+    // Method Description:
+    // - Estimates the memory used by the buffer of this control, so that
+    //   the memory use of panes can be told apart.
+    // Return Value:
+    // - the breakdown, in bytes
+    BufferMemoryUsage ControlCore::MemoryUsage() const
+    {
+        auto lock = _terminal->LockForReading();
+        return _terminal->GetMemoryUsage();
+    }
+
+    // Method Description:
+    // - Returns how much output this control received so far and how long it
+    //   took to process and to paint it, so that busy panes can be told apart.
+    //   Rates are the difference between two of these over the time in between.
+    // Return Value:
+    // - the totals since the control was created, and the current memory use
+    ControlStatistics ControlCore::Statistics() const
+    {
+        ControlStatistics statistics;
+
+        const auto& output = _terminal->GetOutputStatistics();
+        statistics.characters = output.characters.load(std::memory_order_relaxed);
+        statistics.parseTime = ::Microsoft::Terminal::Core::OutputStatistics::Load(output.parseTime);
+        statistics.writeTime = ::Microsoft::Terminal::Core::OutputStatistics::Load(output.writeTime);
+        statistics.outputLockWait = ::Microsoft::Terminal::Core::OutputStatistics::Load(output.lockWait);
+
+        const auto lock = _terminal->GetLockStatistics();
+        statistics.readerLockWait = lock.shared_wait_time;
+        statistics.writerLockWait = lock.exclusive_wait_time;
+
+        if (_renderer)
+        {
+            const auto render = _renderer->GetStatistics();
+            statistics.frames = render.frames;
+            statistics.coalescedPaints = render.paintRequests > render.frames ? render.paintRequests - render.frames : 0;
+            statistics.frameTime = render.frameTime;
+            statistics.renderLockWait = render.lockWait;
+        }
+
+        statistics.memory = MemoryUsage();
+        return statistics;
     }
 
+    // Method Description:
+    // - Called after each frame. Once per second, writes how busy the control
+    //   was since the last time to ETW, and shows it in the frame time overlay,
+    //   if either of them is enabled.
+    void ControlCore::_sampleStatistics()
+    try
+    {
+        const auto tracing = TraceLoggingProviderEnabled(g_hTerminalControlProvider, WINEVENT_LEVEL_VERBOSE, TIL_KEYWORD_TRACE);
+        const auto overlay = _frameTimeOverlay.load();
+        if (!tracing && !overlay)
+        {
+            // Rates across a gap this long wouldn't tell much.
+            _lastStatisticsSample = {};
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - _lastStatisticsSample < _statisticsInterval)
+        {
+            return;
+        }
+
+        const auto statistics = Statistics();
+        if (_lastStatisticsSample != std::chrono::steady_clock::time_point{})
+        {
+            using std::chrono::duration;
+            const auto elapsed = duration<double>(now - _lastStatisticsSample).count();
+            const auto frames = statistics.frames - _lastStatistics.frames;
+            const auto perSecond = [&](const uint64_t current, const uint64_t last) { return (current - last) / elapsed; };
+            // The share of the time in between, in percent.
+            const auto busy = [&](const std::chrono::nanoseconds current, const std::chrono::nanoseconds last) { return duration<double>(current - last).count() / elapsed * 100; };
+            // The average of the frames in between, in milliseconds.
+            const auto perFrame = [&](const std::chrono::nanoseconds current, const std::chrono::nanoseconds last) { return frames ? duration<double, std::milli>(current - last).count() / frames : 0.0; };
+
+            const auto charactersPerSecond = perSecond(statistics.characters, _lastStatistics.characters);
+            const auto parseBusy = busy(statistics.parseTime, _lastStatistics.parseTime);
+            const auto writeBusy = busy(statistics.writeTime, _lastStatistics.writeTime);
+            const auto outputLockBusy = busy(statistics.outputLockWait, _lastStatistics.outputLockWait);
+            const auto framesPerSecond = perSecond(statistics.frames, _lastStatistics.frames);
+            const auto coalescedPerSecond = perSecond(statistics.coalescedPaints, _lastStatistics.coalescedPaints);
+            const auto frameTime = perFrame(statistics.frameTime, _lastStatistics.frameTime);
+            const auto renderLockWait = perFrame(statistics.renderLockWait, _lastStatistics.renderLockWait);
+            const auto readerLockBusy = busy(statistics.readerLockWait, _lastStatistics.readerLockWait);
+            const auto writerLockBusy = busy(statistics.writerLockWait, _lastStatistics.writerLockWait);
+            const auto memory = statistics.memory.Total();
+
+            if (tracing)
+            {
+                TraceLoggingWrite(g_hTerminalControlProvider,
+                                  "ControlCore_Statistics",
+                                  TraceLoggingDescription("How busy a control was in the last second"),
+                                  TraceLoggingPointer(this, "Control"),
+                                  TraceLoggingFloat64(charactersPerSecond, "CharactersPerSecond"),
+                                  TraceLoggingFloat64(parseBusy, "ParsePercent"),
+                                  TraceLoggingFloat64(writeBusy, "WritePercent"),
+                                  TraceLoggingFloat64(outputLockBusy, "OutputLockWaitPercent"),
+                                  TraceLoggingFloat64(framesPerSecond, "FramesPerSecond"),
+                                  TraceLoggingFloat64(coalescedPerSecond, "CoalescedPaintsPerSecond"),
+                                  TraceLoggingFloat64(frameTime, "FrameTimeMs"),
+                                  TraceLoggingFloat64(renderLockWait, "RenderLockWaitMs"),
+                                  TraceLoggingFloat64(readerLockBusy, "ReaderLockWaitPercent"),
+                                  TraceLoggingFloat64(writerLockBusy, "WriterLockWaitPercent"),
+                                  TraceLoggingUInt64(memory, "BufferMemoryBytes"),
+                                  TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                                  TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+            }
+
+            if (overlay && _renderEngine)
+            {
+                _renderEngine->SetFrameTimeOverlayText(fmt::format(L"in {:.1f}k/s | parse {:.1f}% write {:.1f}% lock {:.1f}%\n"
+                                                                   L"{:.0f} fps, {:.0f} coalesced/s | paint {:.2f} ms\n"
+                                                                   L"render lock {:.2f} ms | buffer {:.1f} MB\n"
+                                                                   L"lock waits: readers {:.1f}% writers {:.1f}%",
+                                                                   charactersPerSecond / 1000,
+                                                                   parseBusy,
+                                                                   writeBusy,
+                                                                   outputLockBusy,
+                                                                   framesPerSecond,
+                                                                   coalescedPerSecond,
+                                                                   frameTime,
+                                                                   renderLockWait,
+                                                                   memory / 1048576.0,
+                                                                   readerLockBusy,
+                                                                   writerLockBusy));
+            }
+        }
+
+        _lastStatisticsSample = now;
+        _lastStatistics = statistics;
+    }
+    CATCH_LOG()
+
     void ControlCore::_terminalWarningBell()
     {
         // Since this can only ever be triggered by output from the connection,
@@ -984,7 +1732,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     // Method Description:
     // - Called for the Terminal's TitleChanged callback. This will re-raise
-    //   a new winrt TypedEvent that can be listened to.
+    //   a new winrt TypedEvent that can be listened to, once the next frame
+    //   was painted (see _publishUiState).
     // - The listeners to this event will re-query the control for the current
     //   value of Title().
     // Arguments:
@@ -996,7 +1745,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // Since this can only ever be triggered by output from the connection,
         // then the Terminal already has the write lock when calling this
         // callback.
-        _TitleChangedHandlers(*this, winrt::make<TitleChangedEventArgs>(winrt::hstring{ wstr }));
+        {
+            std::lock_guard guard{ _uiStateLock };
+            _pendingUiState.title.emplace(wstr);
+        }
+        _requestUiStatePublish();
     }
 
     // Method Description:
@@ -1032,7 +1785,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // Method Description:
     // - Update the position and size of the scrollbar to match the given
     //      viewport top, viewport height, and buffer size.
-    //   Additionally fires a ScrollPositionChanged event for anyone who's
+    //   Additionally fires a ScrollPositionChanged event (once the next frame
+    //      was painted, see _publishUiState) for anyone who's
     //      registered an event handler for us.
     // Arguments:
     // - viewTop: the top of the visible viewport, in rows. 0 indicates the top
@@ -1043,26 +1797,120 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                                      const int viewHeight,
                                                      const int bufferSize)
     {
-        // Clear the regex pattern tree so the renderer does not try to render them while scrolling
-        // We're **NOT** taking the lock here unlike _scrollbarChangeHandler because
-        // we are already under lock (since this usually happens as a result of writing).
-        // TODO GH#9617: refine locking around pattern tree
-        _terminal->ClearPatternTree();
+        // The terminal scrolls by whole rows.
+        if (_smoothScrollOffset != 0.0)
+        {
+            _smoothScrollOffset = 0.0;
+            LOG_IF_FAILED(_renderEngine->SetSmoothScrollOffset(0.0f));
+        }
+
+        if (_inBackground)
+        {
+            return;
+        }
 
-        _ScrollPositionChangedHandlers(*this,
-                                       winrt::make<ScrollPositionChangedArgs>(viewTop,
-                                                                              viewHeight,
-                                                                              bufferSize));
+        // The Terminal moves the pattern matches along with the text while
+        // scrolling, the rows that came into view get theirs once
+        // UpdatePatternLocations runs again.
+        {
+            std::lock_guard guard{ _uiStateLock };
+            _pendingUiState.scrollPosition.emplace(viewTop, viewHeight, bufferSize);
+        }
+        _requestUiStatePublish();
     }
 
     void ControlCore::_terminalCursorPositionChanged()
     {
-        _CursorPositionChangedHandlers(*this, nullptr);
+        if (_inBackground)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard guard{ _uiStateLock };
+            _pendingUiState.cursorPositionChanged = true;
+        }
+        _requestUiStatePublish();
     }
 
     void ControlCore::_terminalTaskbarProgressChanged()
     {
-        _TaskbarProgressChangedHandlers(*this, nullptr);
+        // Like the title, this is only triggered by output, under the write lock.
+        {
+            std::lock_guard guard{ _uiStateLock };
+            _pendingUiState.taskbarProgress.emplace(_terminal->GetTaskbarState(), _terminal->GetTaskbarProgress());
+        }
+        _requestUiStatePublish();
+    }
+
+    // Method Description:
+    // - Asks for the pending changes to the UI's state to be raised. While
+    //   frames are painted, that happens after the next one, so that output
+    //   that moves the cursor or scrolls many times in between only raises
+    //   the events once. Otherwise they're raised at most once per
+    //   _uiStatePublishInterval, since the tab of a control in the background
+    //   still shows its title and progress.
+    void ControlCore::_requestUiStatePublish()
+    {
+        if (_paintingEnabled && !_inBackground)
+        {
+            _renderer->TriggerFrame();
+        }
+        else
+        {
+            _publishUiStateThrottled();
+        }
+    }
+
+    // Method Description:
+    // - Raises the events for the changes to the UI's state since they were
+    //   last raised, each of them once and with the latest values. The title
+    //   and the progress are only raised if they're different from the ones
+    //   that were raised last, so that changing them back and forth within a
+    //   frame doesn't update the tab either.
+    void ControlCore::_publishUiState()
+    {
+        PendingUiState state;
+        {
+            std::lock_guard guard{ _uiStateLock };
+            state = std::exchange(_pendingUiState, {});
+
+            if (state.title && state.title == _publishedTitle)
+            {
+                state.title.reset();
+            }
+            else if (state.title)
+            {
+                _publishedTitle = state.title;
+            }
+
+            if (state.taskbarProgress && *state.taskbarProgress == _publishedTaskbarProgress)
+            {
+                state.taskbarProgress.reset();
+            }
+            else if (state.taskbarProgress)
+            {
+                _publishedTaskbarProgress = *state.taskbarProgress;
+            }
+        }
+
+        if (state.scrollPosition)
+        {
+            const auto [viewTop, viewHeight, bufferSize] = *state.scrollPosition;
+            _ScrollPositionChangedHandlers(*this, winrt::make<ScrollPositionChangedArgs>(viewTop, viewHeight, bufferSize));
+        }
+        if (state.cursorPositionChanged)
+        {
+            _CursorPositionChangedHandlers(*this, nullptr);
+        }
+        if (state.title)
+        {
+            _TitleChangedHandlers(*this, winrt::make<TitleChangedEventArgs>(*state.title));
+        }
+        if (state.taskbarProgress)
+        {
+            _TaskbarProgressChangedHandlers(*this, nullptr);
+        }
     }
 
     bool ControlCore::HasSelection() const
@@ -1093,11 +1941,14 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // - text: the text to search
     // - goForward: boolean that represents if the current search direction is forward
     // - caseSensitive: boolean that represents if the current search is case sensitive
+    // - regex: whether the text is a regular expression, see RegexSearch. One that
+    //   can't be searched for doesn't find anything.
     // Return Value:
     // - <none>
     void ControlCore::Search(const winrt::hstring& text,
                              const bool goForward,
-                             const bool caseSensitive)
+                             const bool caseSensitive,
+                             const bool regex)
     {
         if (text.size() == 0)
         {
@@ -1112,16 +1963,356 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                                     Search::Sensitivity::CaseSensitive :
                                                     Search::Sensitivity::CaseInsensitive;
 
-        ::Search search(*GetUiaData(), text.c_str(), direction, sensitivity);
+        if (regex)
+        {
+            std::optional<RegexSearch> search;
+            try
+            {
+                search.emplace(*GetUiaData(), text, sensitivity);
+            }
+            catch (...)
+            {
+                // The search box already says that the pattern is invalid.
+                return;
+            }
+
+            auto lock = _terminal->LockForWriting();
+            if (search->FindAround(direction))
+            {
+                _terminal->SetBlockSelection(false);
+                search->Select();
+                _renderer->TriggerSelection();
+            }
+            return;
+        }
+
+        std::optional<::Search> search;
+        search.emplace(*GetUiaData(), text.c_str(), direction, sensitivity);
         auto lock = _terminal->LockForWriting();
-        if (search.FindNext())
+        auto found = search->FindNext();
+
+        // Going up past the top of the buffer continues in the scrollback archive,
+        // before the search wraps around to the bottom of the buffer. The rows down
+        // to the match are paged back into the buffer, where that row is searched again.
+        if (direction == Search::Direction::Backward && (!found || search->WrappedAround()))
+        {
+            if (const auto row = _terminal->PageInArchivedText(text, caseSensitive))
+            {
+                search.emplace(*GetUiaData(), text.c_str(), direction, sensitivity, COORD{ 0, gsl::narrow_cast<SHORT>(*row + 1) });
+                found = search->FindNext();
+            }
+        }
+
+        if (found)
         {
             _terminal->SetBlockSelection(false);
-            search.Select();
+            search->Select();
             _renderer->TriggerSelection();
         }
     }
 
+    // Method Description:
+    // - Counts and highlights all of the matches of the text in the search
+    //   box while it's typed. The search runs on a background thread, so the
+    //   UI doesn't wait for it, and it's abandoned once the text changes again.
+    // Arguments:
+    // - text: the text to search for. Without any, nothing is highlighted.
+    // - caseSensitive: whether the case of the text has to match
+    // - regex: whether the text is a regular expression
+    // Return Value:
+    // - <none>
+    void ControlCore::SearchChanged(const winrt::hstring& text, const bool caseSensitive, const bool regex)
+    {
+        _searchText = text;
+        _searchCaseSensitive = caseSensitive;
+        _searchRegex = regex;
+        _asyncSearch(text, caseSensitive, regex);
+    }
+
+    // Method Description:
+    // - Stops highlighting the matches of the search box, once it's closed.
+    void ControlCore::ClearSearch()
+    {
+        SearchChanged({}, false, false);
+    }
+
+    // Method Description:
+    // - Searches the whole buffer for the text on a background thread, taking
+    //   the lock for a batch of matches at a time, so that output and painting
+    //   carry on in between. The number of matches found so far is raised as
+    //   SearchMatchCountChanged every now and then, and once it's done.
+    // - Rows that circle out of the buffer in between move the text up under the
+    //   search, which is moved up along with it, so that it goes on where it left
+    //   off. If the buffer is replaced, like by a resize, the search starts over.
+    // - The search uses the search index of the buffer, so rows that can't
+    //   contain the text are skipped without being looked at. A search that
+    //   started after this one, or closing the control, cancels it.
+    // - A regular expression is matched by RegexSearch instead, a line of
+    //   wrapped rows at a time. One it can't search for is reported as
+    //   invalid right away, without any matches.
+    // Arguments:
+    // - text: the text to search for
+    // - caseSensitive: whether the case of the text has to match
+    // - regex: whether the text is a regular expression
+    // Return Value:
+    // - <none>
+    winrt::fire_and_forget ControlCore::_asyncSearch(const winrt::hstring text, const bool caseSensitive, const bool regex)
+    {
+        auto strongThis{ get_strong() };
+        const auto generation = ++_searchGeneration;
+
+        co_await winrt::resume_background();
+
+        const auto sensitivity = caseSensitive ? Search::Sensitivity::CaseSensitive : Search::Sensitivity::CaseInsensitive;
+        std::optional<::Search> search;
+        std::optional<RegexSearch> regexSearch;
+        std::vector<Terminal::SearchHighlight> highlights;
+        int32_t total = 0;
+        auto complete = text.empty();
+        auto invalidPattern = false;
+
+        if (regex && !complete)
+        {
+            try
+            {
+                regexSearch.emplace(*GetUiaData(), text, sensitivity);
+            }
+            catch (...)
+            {
+                // The pattern is most likely still being typed, so this isn't worth logging.
+                invalidPattern = true;
+                complete = true;
+            }
+        }
+        auto lastReport = std::chrono::steady_clock::now();
+        const TextBuffer* searchedBuffer = nullptr;
+        uint64_t searchedCircledRows = 0;
+
+        do
+        {
+            auto reportNow = complete;
+
+            {
+                // Searching may unpack the rows it reads and index them, which changes them.
+                auto lock = _terminal->LockForWriting();
+                if (_closing || _searchGeneration != generation)
+                {
+                    co_return;
+                }
+
+                if (!complete)
+                {
+                    const auto& buffer = _terminal->GetTextBuffer();
+                    const auto circledRows = buffer.GetCircledRows();
+                    if (&buffer != searchedBuffer)
+                    {
+                        // The positions of the matches found so far mean nothing in another buffer.
+                        if (searchedBuffer)
+                        {
+                            search.reset();
+                            if (regexSearch)
+                            {
+                                regexSearch.emplace(*GetUiaData(), text, sensitivity);
+                            }
+                            highlights.clear();
+                            total = 0;
+                        }
+                        searchedBuffer = &buffer;
+                    }
+                    else if (circledRows != searchedCircledRows)
+                    {
+                        const auto rows = gsl::narrow_cast<size_t>(circledRows - searchedCircledRows);
+                        if (regexSearch)
+                        {
+                            regexSearch->MoveUp(rows);
+                        }
+                        else if (search)
+                        {
+                            search->MoveUp(rows);
+                        }
+                    }
+                    searchedCircledRows = circledRows;
+
+                    if (!search && !regexSearch)
+                    {
+                        search.emplace(*GetUiaData(), std::wstring{ text }, Search::Direction::Forward, sensitivity, COORD{ 0, 0 });
+                    }
+
+                    for (size_t i = 0; i < _searchBatchSize; ++i)
+                    {
+                        if (regexSearch ? !regexSearch->FindNext() : !search->FindNext())
+                        {
+                            complete = true;
+                            break;
+                        }
+
+                        const auto [start, end] = regexSearch ? regexSearch->GetFoundLocation() : search->GetFoundLocation();
+                        ++total;
+                        if (highlights.size() < _maxSearchHighlights)
+                        {
+                            highlights.push_back({ circledRows + start.Y, circledRows + end.Y, start.X, end.X });
+                        }
+                    }
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                reportNow = complete || now - lastReport >= _searchReportInterval;
+                if (reportNow)
+                {
+                    lastReport = now;
+                    if (complete)
+                    {
+                        _terminal->SetSearchHighlights(std::move(highlights));
+                    }
+                    else
+                    {
+                        _terminal->SetSearchHighlights(highlights);
+                    }
+                    if (_renderer)
+                    {
+                        _renderer->TriggerFrame();
+                    }
+                }
+            }
+
+            if (reportNow)
+            {
+                _SearchMatchCountChangedHandlers(*this, winrt::make<SearchMatchCountChangedEventArgs>(total, complete, invalidPattern));
+            }
+        } while (!complete);
+    }
+
+    // Method Description:
+    // - Writes the text of the whole buffer, including its scrollback archive, to a
+    //   file as UTF-8, on a background thread. With attributes, the text comes with
+    //   the SGR sequences that reproduce its colors, so that it can be replayed.
+    // - The rows are copied out of the buffer a batch at a time under the lock, and
+    //   written to the file after it was released, so that output and painting carry
+    //   on in between and only a batch is held in memory, no matter the scrollback.
+    //   The rows written are the ones there were when the export started. The ones
+    //   that scroll into the archive meanwhile are read from there, while the ones a
+    //   buffer without an archive drops before they were written are left out.
+    // - The progress is raised as ExportProgressChanged every now and then, and once
+    //   it's done. Resizing the terminal or closing the control cancels the export.
+    // Arguments:
+    // - path: the file to write. It's replaced if it exists.
+    // - includeAttributes: whether to write the attributes of the text as well
+    // Return Value:
+    // - <none>
+    winrt::fire_and_forget ControlCore::ExportBuffer(const winrt::hstring path, const bool includeAttributes)
+    {
+        auto strongThis{ get_strong() };
+
+        co_await winrt::resume_background();
+
+        uint64_t written = 0;
+        uint64_t total = 0;
+        HRESULT result = S_OK;
+        try
+        {
+            wil::unique_hfile file{ CreateFileW(path.c_str(),
+                                                GENERIC_WRITE,
+                                                FILE_SHARE_READ,
+                                                nullptr,
+                                                CREATE_ALWAYS,
+                                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                                nullptr) };
+            THROW_LAST_ERROR_IF(!file);
+
+            const TextBuffer* buffer = nullptr;
+            uint64_t archived = 0;
+            uint64_t dropped = 0;
+            uint64_t circledRows = 0;
+            {
+                auto lock = _terminal->LockForReading();
+                buffer = &_terminal->GetTextBuffer();
+                const auto archive = buffer->GetScrollbackArchive();
+                archived = archive ? archive->size() : 0;
+                dropped = archive ? archive->GetDroppedRowCount() : 0;
+                circledRows = buffer->GetCircledRows();
+                total = archived + buffer->GetLastNonSpaceCharacter().Y + 1;
+            }
+
+            std::shared_ptr<const TextBufferSnapshot> snapshot;
+            std::wstring text;
+            std::string utf8;
+            RowSerializer serializer{ text, includeAttributes };
+            auto lastReport = std::chrono::steady_clock::now();
+
+            while (written < total)
+            {
+                text.clear();
+                const auto end = std::min<uint64_t>(written + _exportBatchSize, total);
+                SHORT rows = 0;
+                {
+                    // Reading the rows may expand them from cold storage, which changes them.
+                    auto lock = _terminal->LockForWriting();
+                    if (_closing)
+                    {
+                        co_return;
+                    }
+
+                    // A resize reflows the rows into a new buffer, where they can't be found anymore.
+                    const auto& current = _terminal->GetTextBuffer();
+                    THROW_HR_IF(E_CHANGED_STATE, &current != buffer);
+
+                    // The rows that scrolled out of the buffer since the export started were appended
+                    // to the archive in order, right after the ones that were in there already.
+                    // Rows paged back into the buffer are taken out of both, so they don't count.
+                    const auto archive = current.GetScrollbackArchive();
+                    const auto scrolledOut = archived + current.GetCircledRows() - circledRows;
+                    if (archive)
+                    {
+                        // The oldest rows are dropped once the archive is full, and with them the
+                        // rows we didn't get to yet. The index of the rest goes down by as many.
+                        const auto droppedSince = archive->GetDroppedRowCount() - dropped;
+                        written = std::max(written, std::min(droppedSince, scrolledOut));
+                        for (; written < end && written < scrolledOut; ++written)
+                        {
+                            serializer.Write(archive->GetRow(gsl::narrow_cast<size_t>(written - droppedSince)));
+                        }
+                    }
+                    else
+                    {
+                        written = std::clamp(scrolledOut, written, end);
+                    }
+
+                    if (written < end)
+                    {
+                        const auto first = gsl::narrow<SHORT>(written - scrolledOut);
+                        snapshot = current.TakeSnapshot(first, gsl::narrow<SHORT>(end - written), std::move(snapshot));
+                        rows = snapshot->GetBuffer().GetSize().Height();
+                        _terminal->PackColdRows();
+                    }
+                }
+
+                for (SHORT row = 0; row < rows; ++row)
+                {
+                    serializer.Write(snapshot->GetBuffer().GetRowByOffset(row));
+                }
+                written = end;
+
+                THROW_IF_FAILED(til::u16u8(text, utf8));
+                DWORD bytesWritten = 0;
+                THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), utf8.data(), gsl::narrow<DWORD>(utf8.size()), &bytesWritten, nullptr));
+
+                const auto now = std::chrono::steady_clock::now();
+                if (written < total && now - lastReport >= _exportReportInterval)
+                {
+                    lastReport = now;
+                    _ExportProgressChangedHandlers(*this, winrt::make<ExportProgressEventArgs>(path, written, total, false, S_OK));
+                }
+            }
+        }
+        catch (...)
+        {
+            result = wil::ResultFromCaughtException();
+            LOG_HR(result);
+        }
+
+        _ExportProgressChangedHandlers(*this, winrt::make<ExportProgressEventArgs>(path, written, total, true, static_cast<uint64_t>(result)));
+    }
+
     void ControlCore::SetBackgroundOpacity(const float opacity)
     {
         if (_renderEngine)
@@ -1162,8 +2353,17 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         if (!_closing.exchange(true))
         {
             // Stop accepting new output and state changes before we disconnect everything.
-            _connection.TerminalOutput(_connectionOutputEventToken);
+            if (_connectionOutputUtf8EventToken)
+            {
+                _connection.as<TerminalConnection::ConptyConnection>().TerminalOutputUtf8(_connectionOutputUtf8EventToken);
+            }
+            else
+            {
+                _connection.TerminalOutput(_connectionOutputEventToken);
+            }
             _connectionStateChangedRevoker.revoke();
+            _energySaverStatusChangedRevoker.revoke();
+            _stopOutputThread();
 
             // GH#1996 - Close the connection asynchronously on a background
             // thread.
@@ -1201,7 +2401,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         auto& renderTarget = *_renderer;
         auto& blinkingState = _terminal->GetBlinkingState();
-        blinkingState.ToggleBlinkingRendition(renderTarget);
+        blinkingState.ToggleBlinkingRendition(renderTarget, _terminal->GetTextBuffer(), _terminal->GetViewport());
     }
 
     void ControlCore::BlinkCursor()
@@ -1228,6 +2428,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     void ControlCore::ResumeRendering()
     {
         _renderer->ResetErrorStateAndResume();
+        _paintingEnabled = true;
     }
 
     bool ControlCore::IsVtMouseModeEnabled() const
@@ -1334,22 +2535,169 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         auto noticeArgs = winrt::make<NoticeEventArgs>(NoticeLevel::Info, RS_(L"TermControlReadOnly"));
         _RaiseNoticeHandlers(*this, std::move(noticeArgs));
     }
+    // Method Description:
+    // - Queues the output of the connection for the output thread. Whichever
+    //   thread the connection raises its output on, it's never parsed there.
+    // - Blocks while the output in flight exceeds _outputBudget, which holds
+    //   back a connection that produces output faster than the terminal can
+    //   take it. A single chunk is always let through, however large it is.
+    // Arguments:
+    // - utf8: the output of the connection
+    void ControlCore::_queueOutput(const std::string_view utf8)
+    {
+        _noteActivity();
+        {
+            std::unique_lock lock{ _outputLock };
+            _outputDrained.wait(lock, [&]() { return _outputStopped || _outputInFlight == 0 || _outputInFlight + utf8.size() <= _outputBudget; });
+            if (_outputStopped)
+            {
+                return;
+            }
+            // The thread is only started by the first output, which doesn't
+            // come before the control is first shown and the connection started.
+            if (!_outputThread.joinable())
+            {
+                _outputThread = std::thread([this]() { _outputLoop(); });
+                LOG_IF_WIN32_BOOL_FALSE(SetThreadPriority(_outputThread.native_handle(), _threadPriority));
+            }
+            _outputInFlight += utf8.size();
+            if (_outputSpares.empty())
+            {
+                _outputQueue.emplace_back(utf8);
+            }
+            else
+            {
+                auto& chunk = _outputQueue.emplace_back(std::move(_outputSpares.back()));
+                _outputSpares.pop_back();
+                chunk.assign(utf8);
+            }
+        }
+        _outputQueued.notify_one();
+    }
+
+    // Method Description:
+    // - Queues the output of a ConPTY connection, which is still UTF-8.
+    // Arguments:
+    // - output: the output of the connection
+    void ControlCore::_connectionOutputUtf8Handler(const winrt::array_view<const uint8_t>& output)
+    {
+        _queueOutput({ reinterpret_cast<const char*>(output.data()), output.size() });
+    }
+
+    // Method Description:
+    // - Queues the output of any other connection, which only comes as UTF-16.
+    //   It's converted, so that all output is written to the terminal as UTF-8.
+    // Arguments:
+    // - hstr: the output of the connection
     void ControlCore::_connectionOutputHandler(const hstring& hstr)
     {
-        _terminal->Write(hstr);
-
-        // NOTE: We're raising an event here to inform the TermControl that
-        // output has been received, so it can queue up a throttled
-        // UpdatePatternLocations call. In the future, we should have the
-        // _updatePatternLocations ThrottledFunc internal to this class, and
-        // run on this object's dispatcher queue.
-        //
-        // We're not doing that quite yet, because the Core will eventually
-        // be out-of-proc from the UI thread, and won't be able to just use
-        // the UI thread as the dispatcher queue thread.
-        //
-        // See TODO: https://github.com/microsoft/terminal/projects/5#card-50760282
-        _ReceivedOutputHandlers(*this, nullptr);
+        // Connections raise their output one chunk after another, never concurrently.
+        if (SUCCEEDED_LOG(til::u16u8(std::wstring_view{ hstr }, _outputUtf8, _outputU16State)))
+        {
+            _queueOutput(_outputUtf8);
+        }
+    }
+
+    // Method Description:
+    // - The body of the output thread. It writes the queued output to the
+    //   terminal, all of the chunks queued up to that point at once.
+    void ControlCore::_outputLoop()
+    {
+        std::deque<std::string> chunks;
+
+        for (;;)
+        {
+            {
+                std::unique_lock lock{ _outputLock };
+                for (auto& chunk : chunks)
+                {
+                    _outputInFlight -= chunk.size();
+                    if (chunk.capacity() <= _outputSpareCapacity && _outputSpares.size() < _outputSpareCount)
+                    {
+                        _outputSpares.emplace_back(std::move(chunk));
+                    }
+                }
+                chunks.clear();
+                _outputBusy = false;
+                _outputDrained.notify_all();
+                _outputQueued.wait(lock, [this]() { return _outputStopped || !_outputQueue.empty(); });
+                if (_outputStopped)
+                {
+                    return;
+                }
+                chunks.swap(_outputQueue);
+                _outputBusy = true;
+            }
+            _outputDrained.notify_all();
+
+            for (const auto& chunk : chunks)
+            {
+                try
+                {
+                    _terminal->Write(std::string_view{ chunk });
+                }
+                CATCH_LOG();
+            }
+
+            // NOTE: We're raising an event here to inform the TermControl that
+            // output has been received, so it can queue up a throttled
+            // UpdatePatternLocations call. In the future, we should have the
+            // _updatePatternLocations ThrottledFunc internal to this class, and
+            // run on this object's dispatcher queue.
+            //
+            // We're not doing that quite yet, because the Core will eventually
+            // be out-of-proc from the UI thread, and won't be able to just use
+            // the UI thread as the dispatcher queue thread.
+            //
+            // See TODO: https://github.com/microsoft/terminal/projects/5#card-50760282
+            if (!_inBackground)
+            {
+                _ReceivedOutputHandlers(*this, nullptr);
+            }
+        }
+    }
+
+    // Method Description:
+    // - Stops the output thread, dropping the output that's still queued.
+    //   Waits for the thread to finish writing the chunks it's working on.
+    void ControlCore::_stopOutputThread()
+    {
+        std::thread thread;
+        {
+            std::lock_guard guard{ _outputLock };
+            _outputStopped = true;
+            thread = std::move(_outputThread);
+            for (const auto& chunk : _outputQueue)
+            {
+                _outputInFlight -= chunk.size();
+            }
+            _outputQueue.clear();
+            _outputSpares.clear();
+        }
+        _outputQueued.notify_all();
+        _outputDrained.notify_all();
+
+        if (!thread.joinable())
+        {
+            return;
+        }
+        // If the output itself closed the control, the thread exits once it's back in _outputLoop.
+        if (thread.get_id() == std::this_thread::get_id())
+        {
+            thread.detach();
+        }
+        else
+        {
+            thread.join();
+        }
+    }
+
+    // Method Description:
+    // - Blocks until all of the output queued so far was written to the terminal.
+    void ControlCore::_waitForOutputIdle()
+    {
+        std::unique_lock lock{ _outputLock };
+        _outputDrained.wait(lock, [this]() { return _outputStopped || (_outputQueue.empty() && !_outputBusy); });
     }
 
 }
@@ -24,6 +24,8 @@
 #include "../buffer/out/search.h"
 #include "cppwinrt_utils.h"
 
+#include <condition_variable>
+
 namespace ControlUnitTests
 {
     class ControlCoreTests;
@@ -32,6 +34,23 @@ namespace ControlUnitTests
 
 namespace winrt::Microsoft::Terminal::Control::implementation
 {
+    // The totals of what a control has received and painted so far, along with
+    // the memory its buffer uses right now. See ControlCore::Statistics.
+    struct ControlStatistics
+    {
+        uint64_t characters{ 0 }; // the code units of output received
+        std::chrono::nanoseconds parseTime{};
+        std::chrono::nanoseconds writeTime{}; // writing the parsed output into the buffer
+        std::chrono::nanoseconds outputLockWait{};
+        uint64_t frames{ 0 };
+        uint64_t coalescedPaints{ 0 }; // the times a frame was asked for, but painted along with another one
+        std::chrono::nanoseconds frameTime{};
+        std::chrono::nanoseconds renderLockWait{};
+        std::chrono::nanoseconds readerLockWait{}; // any reader of the terminal, the renderer and the UI
+        std::chrono::nanoseconds writerLockWait{}; // the output and anything else changing the terminal
+        BufferMemoryUsage memory;
+    };
+
     struct ControlCore : ControlCoreT<ControlCore>
     {
     public:
@@ -43,10 +62,17 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                         const double actualHeight,
                         const double compositionScale);
         void EnablePainting();
+        void SuspendPainting();
+        void ResumePainting();
+        void EnterBackground();
+        void LeaveBackground();
+        void SetFocused(const bool focused);
+        void Trim();
 
         void UpdateSettings(const IControlSettings& settings);
         void UpdateAppearance(const IControlAppearance& newAppearance);
         void SizeChanged(const double width, const double height);
+        void FinishResize();
         void ScaleChanged(const double scale);
         HANDLE GetSwapChainHandle() const;
 
@@ -89,6 +115,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         int ScrollOffset();
         int ViewHeight() const;
         int BufferHeight() const;
+        std::vector<uint8_t> ScrollMarks(const size_t bins) const;
+        BufferMemoryUsage MemoryUsage() const;
+        ControlStatistics Statistics() const;
 
         bool BracketedPasteEnabled() const noexcept;
 #pragma endregion
@@ -107,8 +136,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                             const short wheelDelta,
                             const ::Microsoft::Console::VirtualTerminal::TerminalInput::MouseButtonState state);
         void UserScrollViewport(const int viewTop);
+        bool SmoothScrolling() const;
+        double SmoothScrollOffset() const noexcept;
+        void SetSmoothScrollOffset(const double offset);
 #pragma endregion
 
+        bool BroadcastInput() const noexcept;
+        void BroadcastInput(const bool broadcastInput);
+        Control::InputModes InputModes() const noexcept;
+        void SendBroadcastInput(const winrt::hstring& wstr);
+
         void BlinkAttributeTick();
         void BlinkCursor();
         bool CursorOn() const;
@@ -125,7 +162,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void Search(const winrt::hstring& text,
                     const bool goForward,
-                    const bool caseSensitive);
+                    const bool caseSensitive,
+                    const bool regex);
+        void SearchChanged(const winrt::hstring& text, const bool caseSensitive, const bool regex);
+        void ClearSearch();
+
+        winrt::fire_and_forget ExportBuffer(const winrt::hstring path, const bool includeAttributes);
 
         void LeftClickOnTerminal(const til::point terminalPosition,
                                  const int numberOfClicks,
@@ -139,6 +181,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         bool IsInReadOnlyMode() const;
         void ToggleReadOnlyMode();
 
+        bool PowerSaving() const noexcept;
+
         // -------------------------------- WinRT Events ---------------------------------
         // clang-format off
         WINRT_CALLBACK(FontSizeChanged, Control::FontSizeChangedEventArgs);
@@ -159,6 +203,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         TYPED_EVENT(RaiseNotice,               IInspectable, Control::NoticeEventArgs);
         TYPED_EVENT(TransparencyChanged,       IInspectable, Control::TransparencyChangedEventArgs);
         TYPED_EVENT(ReceivedOutput,            IInspectable, IInspectable);
+        TYPED_EVENT(SearchMatchCountChanged,   IInspectable, Control::SearchMatchCountChangedEventArgs);
+        TYPED_EVENT(ExportProgressChanged,     IInspectable, Control::ExportProgressEventArgs);
+        TYPED_EVENT(InputSent,                 IInspectable, Control::InputSentEventArgs);
+        TYPED_EVENT(PowerSavingChanged,        IInspectable, IInspectable);
         // clang-format on
 
     private:
@@ -167,6 +215,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         TerminalConnection::ITerminalConnection _connection{ nullptr };
         event_token _connectionOutputEventToken;
+        event_token _connectionOutputUtf8EventToken;
         TerminalConnection::ITerminalConnection::StateChanged_revoker _connectionStateChangedRevoker;
 
         std::unique_ptr<::Microsoft::Terminal::Core::Terminal> _terminal{ nullptr };
@@ -178,11 +227,15 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // (C++ class members are destroyed in reverse order.)
         std::unique_ptr<::Microsoft::Console::Render::DxEngine> _renderEngine{ nullptr };
         std::unique_ptr<::Microsoft::Console::Render::Renderer> _renderer{ nullptr };
+        // The fraction of a row the text is moved up by (see SetSmoothScrollOffset).
+        double _smoothScrollOffset{ 0.0 };
 
         IControlSettings _settings{ nullptr };
 
         FontInfoDesired _desiredFont;
         FontInfo _actualFont;
+        // The font the settings asked for, before the user zoomed in or out.
+        FontInfoDesired _settingsFont;
 
         // storage location for the leading surrogate of a utf-16 surrogate pair
         std::optional<wchar_t> _leadingSurrogate{ std::nullopt };
@@ -193,6 +246,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         bool _isReadOnly{ false };
 
+        // Whether the renderer currently saves power, either because the
+        // settings ask for it, or because the battery saver is on.
+        std::atomic<bool> _powerSaving{ false };
+        winrt::Windows::System::Power::PowerManager::EnergySaverStatusChanged_revoker _energySaverStatusChangedRevoker;
+
         std::optional<interval_tree::IntervalTree<til::point, size_t>::interval> _lastHoveredInterval{ std::nullopt };
 
         // These members represent the size of the surface that we should be
@@ -201,13 +259,115 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         double _panelHeight{ 0 };
         double _compositionScale{ 0 };
 
+        // SizeChanged only queues the new size of the panel. It's applied by
+        // _asyncResize, which runs while _resizeBusy is set, so that the UI
+        // thread doesn't wait for the buffer to be reflowed. Meanwhile the
+        // last frame stays up, cropped or surrounded by the background. Sizes
+        // that are queued before the previous one was applied are dropped.
+        std::mutex _resizeLock;
+        std::optional<std::pair<double, double>> _pendingSize;
+        bool _resizeBusy{ false };
+        winrt::fire_and_forget _asyncResize();
+        void _applyPendingSizeUnderLock();
+
         winrt::fire_and_forget _asyncCloseConnection();
 
+        // Pastes longer than this many characters are written in the background.
+        static constexpr size_t _asyncPasteThreshold = 64 * 1024;
+        std::mutex _pasteLock;
+        std::atomic<uint64_t> _pasteGeneration{ 0 };
+        winrt::fire_and_forget _asyncPasteText(const winrt::hstring text);
+
+        // The matches of the search box are counted and highlighted by a
+        // background search, see _asyncSearch. Only this many are highlighted.
+        static constexpr size_t _searchBatchSize = 256;
+        static constexpr size_t _maxSearchHighlights = 64 * 1024;
+        static constexpr auto _searchReportInterval = std::chrono::milliseconds{ 100 };
+        std::atomic<uint64_t> _searchGeneration{ 0 };
+        winrt::hstring _searchText;
+        bool _searchCaseSensitive{ false };
+        bool _searchRegex{ false };
+        winrt::fire_and_forget _asyncSearch(const winrt::hstring text, const bool caseSensitive, const bool regex);
+        void _restartSearch();
+
+        // ExportBuffer copies this many rows out of the buffer at a time.
+        static constexpr size_t _exportBatchSize = 1024;
+        static constexpr auto _exportReportInterval = std::chrono::milliseconds{ 100 };
+
+        // While input is broadcast, the key events that were sent to the
+        // terminal are collected until InputSent is raised for them.
+        bool _broadcastInput{ false };
+        std::vector<KeyEvent> _sentKeyEvents;
+        void _raiseInputSent();
+        // The input that was broadcast to this control is queued and written
+        // by _asyncWriteBroadcastInput, which runs while _broadcastBusy is set.
+        std::mutex _broadcastLock;
+        std::wstring _broadcastQueue;
+        bool _broadcastBusy{ false };
+        winrt::fire_and_forget _asyncWriteBroadcastInput();
+
+        // The output of the connection is queued and written to the terminal
+        // by a thread of its own, see _outputLoop. Once this much output (in
+        // UTF-8 code units) is queued or being written, the connection is
+        // blocked until the thread catches up. It stops reading from its pipe
+        // meanwhile, which in turn holds back the application that writes to
+        // it, so that the terminal is never more than a few frames behind.
+        static constexpr size_t _outputBudget = 1024 * 1024;
+        size_t _outputInFlight{ 0 };
+        std::mutex _outputLock;
+        std::condition_variable _outputQueued;
+        std::condition_variable _outputDrained;
+        std::deque<std::string> _outputQueue;
+        // The chunks that were written are kept to copy the next ones into, so
+        // that their memory is reused instead of allocated for every chunk.
+        // Chunks larger than this aren't kept around.
+        static constexpr size_t _outputSpareCapacity = 64 * 1024;
+        static constexpr size_t _outputSpareCount = 64;
+        std::vector<std::string> _outputSpares;
+        // The UTF-16 output of connections other than ConPTY, converted to UTF-8.
+        std::string _outputUtf8;
+        til::u16state _outputU16State;
+        bool _outputStopped{ false };
+        bool _outputBusy{ false };
+
+        // While the control can't be seen, output is only written to the
+        // buffer. What the UI derives from it is updated once it's left.
+        std::atomic<bool> _inBackground{ false };
+
+        // The changes to the state the UI shows are collected and raised all
+        // at once after the next frame was painted, see _publishUiState.
+        struct PendingUiState
+        {
+            std::optional<std::tuple<int, int, int>> scrollPosition;
+            std::optional<winrt::hstring> title;
+            std::optional<std::pair<size_t, size_t>> taskbarProgress; // the state and the progress
+            bool cursorPositionChanged{ false };
+        };
+        std::mutex _uiStateLock;
+        PendingUiState _pendingUiState;
+        // What TitleChanged and TaskbarProgressChanged were raised for last. Protected by _uiStateLock.
+        std::optional<winrt::hstring> _publishedTitle;
+        std::pair<size_t, size_t> _publishedTaskbarProgress{ 0, 0 };
+        std::atomic<bool> _paintingEnabled{ false };
+        // About a frame, for when there are no frames to publish the state after.
+        static constexpr std::chrono::milliseconds _uiStatePublishInterval{ 16 };
+        til::throttled_func_trailing<> _publishUiStateThrottled{ _uiStatePublishInterval, [this]() { _publishUiState(); } };
+        void _requestUiStatePublish();
+        void _publishUiState();
+        std::thread _outputThread;
+        // The scheduling priority of the output and render threads. The ones
+        // of the focused control run above the others, see SetFocused.
+        std::atomic<int> _threadPriority{ THREAD_PRIORITY_NORMAL };
+        void _outputLoop();
+        void _stopOutputThread();
+        void _waitForOutputIdle();
+
         void _setFontSize(int fontSize);
         void _updateFont(const bool initialUpdate = false);
         void _refreshSizeUnderLock();
         void _doResizeUnderLock(const double newWidth,
-                                const double newHeight);
+                                const double newHeight,
+                                const bool live = false);
 
         void _sendInputToConnection(std::wstring_view wstr);
 
@@ -231,8 +391,32 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void _raiseReadOnlyWarning();
         void _updateAntiAliasingMode(::Microsoft::Console::Render::DxEngine* const dxEngine);
+        void _applyPowerPreference();
+        void _queueOutput(const std::string_view utf8);
+        void _connectionOutputUtf8Handler(const winrt::array_view<const uint8_t>& output);
         void _connectionOutputHandler(const hstring& hstr);
 
+        // The statistics are sampled on the render thread, after a frame was painted,
+        // but only once per _statisticsInterval and only while someone looks at them.
+        static constexpr std::chrono::seconds _statisticsInterval{ 1 };
+        std::atomic<bool> _frameTimeOverlay{ false };
+        std::chrono::steady_clock::time_point _lastStatisticsSample{};
+        ControlStatistics _lastStatistics;
+        void _sampleStatistics();
+
+        // Once there was neither output nor input for _idleTrimDelay, the caches
+        // are trimmed (see Trim). The timer is only armed by the first activity
+        // after a trim, and pushes itself back until the activity stopped, so
+        // output doesn't have to touch it. It's declared last, so that it's
+        // destroyed (and waits for its callback) before anything it uses.
+        static constexpr std::chrono::seconds _idleTrimDelay{ 30 };
+        std::atomic<std::chrono::steady_clock::rep> _lastActivity{ 0 };
+        std::atomic<bool> _idleTrimArmed{ false };
+        void _noteActivity() noexcept;
+        void _armIdleTrim(const std::chrono::steady_clock::duration delay) noexcept;
+        void _idleTrimTimerFired() noexcept;
+        wil::unique_threadpool_timer _idleTrimTimer;
+
         friend class ControlUnitTests::ControlCoreTests;
         friend class ControlUnitTests::ControlInteractivityTests;
     };
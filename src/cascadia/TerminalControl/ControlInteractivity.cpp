@@ -163,6 +163,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                               const til::point pixelPosition)
     {
         const til::point terminalPosition = _getTerminalPosition(pixelPosition);
+        _lastPointerMove.reset();
 
         const auto altEnabled = modifiers.IsAltPressed();
         const auto shiftEnabled = modifiers.IsShiftPressed();
@@ -246,6 +247,15 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     {
         const til::point terminalPosition = _getTerminalPosition(pixelPosition);
 
+        // The distance from the touchdown point is measured in pixels, so
+        // every move counts until the selection was started.
+        const PointerMove move{ terminalPosition, buttonState, modifiers.Value(), pointerUpdateKind };
+        if (!_singleClickTouchdownPos && _lastPointerMove && _isSamePointerMove(*_lastPointerMove, move))
+        {
+            return;
+        }
+        _lastPointerMove = move;
+
         // Short-circuit isReadOnly check to avoid warning dialog
         if (focused && !_core->IsInReadOnlyMode() && _canSendVTMouseInput(modifiers))
         {
@@ -282,6 +292,19 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _core->UpdateHoveredCell(terminalPosition);
     }
 
+    // Method Description:
+    // - Returns whether two pointer moves are in the same cell, with the same
+    //   buttons and modifiers held, so that the second one changes nothing.
+    bool ControlInteractivity::_isSamePointerMove(const PointerMove& a, const PointerMove& b) noexcept
+    {
+        return a.position == b.position &&
+               a.buttonState.isLeftButtonDown == b.buttonState.isLeftButtonDown &&
+               a.buttonState.isMiddleButtonDown == b.buttonState.isMiddleButtonDown &&
+               a.buttonState.isRightButtonDown == b.buttonState.isRightButtonDown &&
+               a.modifiers == b.modifiers &&
+               a.pointerUpdateKind == b.pointerUpdateKind;
+    }
+
     void ControlInteractivity::TouchMoved(const til::point newTouchPoint,
                                           const bool focused)
     {
@@ -325,6 +348,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                                const til::point pixelPosition)
     {
         const til::point terminalPosition = _getTerminalPosition(pixelPosition);
+        _lastPointerMove.reset();
         // Short-circuit isReadOnly check to avoid warning dialog
         if (!_core->IsInReadOnlyMode() && _canSendVTMouseInput(modifiers))
         {
@@ -447,7 +471,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // underneath us. We wouldn't know - we don't want the overhead of
         // another ScrollPositionChanged handler. If the scrollbar should be
         // somewhere other than where it is currently, then start from that row.
-        const int currentInternalRow = ::base::saturated_cast<int>(::std::round(_internalScrollbarPosition));
+        const int currentInternalRow = _viewTopFromPosition(_internalScrollbarPosition);
         const int currentCoreRow = _core->ScrollOffset();
         const double currentOffset = currentInternalRow == currentCoreRow ?
                                          _internalScrollbarPosition :
@@ -503,7 +527,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // If the new scrollbar position, rounded to an int, is at a different
         // row, then actually update the scroll position in the core, and raise
         // a ScrollPositionChanged to inform the control.
-        int viewTop = ::base::saturated_cast<int>(::std::round(_internalScrollbarPosition));
+        int viewTop = _viewTopFromPosition(_internalScrollbarPosition);
         if (viewTop != _core->ScrollOffset())
         {
             _core->UserScrollViewport(viewTop);
@@ -514,6 +538,28 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                                                                   _core->ViewHeight(),
                                                                                   _core->BufferHeight()));
         }
+
+        // With smooth scrolling, the rest of the way to the next row is
+        // scrolled by moving the text, without scrolling the buffer.
+        if (_core->SmoothScrolling())
+        {
+            _core->SetSmoothScrollOffset(_internalScrollbarPosition - viewTop);
+        }
+    }
+
+    // Method Description:
+    // - Gets the top of the viewport for a position of the scrollbar. With
+    //   smooth scrolling, the viewport stays at the row above the position
+    //   and the text is moved up by the rest (see UpdateScrollbar), otherwise
+    //   it's at the row closest to it.
+    // Arguments:
+    // - position: the position of the scrollbar, in rows
+    // Return Value:
+    // - the row at the top of the viewport
+    int ControlInteractivity::_viewTopFromPosition(const double position) const
+    {
+        const auto row = _core->SmoothScrolling() ? ::std::floor(position) : ::std::round(position);
+        return ::base::saturated_cast<int>(row);
     }
 
     void ControlInteractivity::_hyperlinkHandler(const std::wstring_view uri)
@@ -554,7 +600,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     {
         // Get the size of the font, which is in pixels
         const til::size fontSize{ _core->GetFont().GetSize() };
+        // The text might be moved up by a part of a row while scrolling smoothly.
+        const auto scrolled = pixelPosition + til::point{ 0, ::base::saturated_cast<ptrdiff_t>(_core->SmoothScrollOffset() * fontSize.height()) };
         // Convert the location in pixels to characters within the current viewport.
-        return til::point{ pixelPosition / fontSize };
+        return til::point{ scrolled / fontSize };
     }
 }
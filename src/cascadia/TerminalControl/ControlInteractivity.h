@@ -108,12 +108,26 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // terminal.
         bool _selectionNeedsToBeCopied;
 
+        // The cell of the last pointer move, and the buttons and modifiers that
+        // were held then. Mice may report a thousand moves a second, and one
+        // that doesn't change any of these neither moves the selection nor
+        // reports anything new to the application, so it's dropped.
+        struct PointerMove
+        {
+            til::point position;
+            TerminalInput::MouseButtonState buttonState;
+            DWORD modifiers;
+            unsigned int pointerUpdateKind;
+        };
+        std::optional<PointerMove> _lastPointerMove;
+
         std::optional<COORD> _lastHoveredCell{ std::nullopt };
         // Track the last hyperlink ID we hovered over
         uint16_t _lastHoveredId{ 0 };
 
         std::optional<interval_tree::IntervalTree<til::point, size_t>::interval> _lastHoveredInterval{ std::nullopt };
 
+        static bool _isSamePointerMove(const PointerMove& a, const PointerMove& b) noexcept;
         unsigned int _numberOfClicks(til::point clickPos, Timestamp clickTime);
         void _updateSystemParameterSettings() noexcept;
 
@@ -128,6 +142,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void _sendPastedTextToConnection(std::wstring_view wstr);
         til::point _getTerminalPosition(const til::point& pixelPosition);
+        int _viewTopFromPosition(const double position) const;
 
         TYPED_EVENT(OpenHyperlink, IInspectable, Control::OpenHyperlinkEventArgs);
         TYPED_EVENT(PasteFromClipboard, IInspectable, Control::PasteFromClipboardEventArgs);
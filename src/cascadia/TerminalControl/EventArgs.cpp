@@ -11,3 +11,6 @@
 #include "ScrollPositionChangedArgs.g.cpp"
 #include "RendererWarningArgs.g.cpp"
 #include "TransparencyChangedEventArgs.g.cpp"
+#include "SearchMatchCountChangedEventArgs.g.cpp"
+#include "ExportProgressEventArgs.g.cpp"
+#include "InputSentEventArgs.g.cpp"
@@ -11,6 +11,9 @@
 #include "ScrollPositionChangedArgs.g.h"
 #include "RendererWarningArgs.g.h"
 #include "TransparencyChangedEventArgs.g.h"
+#include "SearchMatchCountChangedEventArgs.g.h"
+#include "ExportProgressEventArgs.g.h"
+#include "InputSentEventArgs.g.h"
 #include "cppwinrt_utils.h"
 
 namespace winrt::Microsoft::Terminal::Control::implementation
@@ -33,21 +36,23 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             _rtf(),
             _formats(static_cast<CopyFormat>(0)) {}
 
-        CopyToClipboardEventArgs(hstring text, hstring html, hstring rtf, Windows::Foundation::IReference<CopyFormat> formats) :
+        CopyToClipboardEventArgs(hstring text, std::function<hstring()> html, std::function<hstring()> rtf, Windows::Foundation::IReference<CopyFormat> formats) :
             _text(text),
             _html(html),
             _rtf(rtf),
             _formats(formats) {}
 
         hstring Text() { return _text; };
-        hstring Html() { return _html; };
-        hstring Rtf() { return _rtf; };
+        // The rich text formats are generated each time they're asked for, from
+        // the colors of the selection that were taken when it was copied.
+        hstring Html() { return _html ? _html() : hstring{}; };
+        hstring Rtf() { return _rtf ? _rtf() : hstring{}; };
         Windows::Foundation::IReference<CopyFormat> Formats() { return _formats; };
 
     private:
         hstring _text;
-        hstring _html;
-        hstring _rtf;
+        std::function<hstring()> _html;
+        std::function<hstring()> _rtf;
         Windows::Foundation::IReference<CopyFormat> _formats;
     };
 
@@ -131,4 +136,52 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         WINRT_PROPERTY(double, Opacity);
     };
+
+    struct SearchMatchCountChangedEventArgs : public SearchMatchCountChangedEventArgsT<SearchMatchCountChangedEventArgs>
+    {
+    public:
+        SearchMatchCountChangedEventArgs(const int32_t totalMatches, const bool complete, const bool invalidPattern) :
+            _TotalMatches(totalMatches),
+            _Complete(complete),
+            _InvalidPattern(invalidPattern)
+        {
+        }
+
+        WINRT_PROPERTY(int32_t, TotalMatches);
+        WINRT_PROPERTY(bool, Complete);
+        WINRT_PROPERTY(bool, InvalidPattern);
+    };
+
+    struct ExportProgressEventArgs : public ExportProgressEventArgsT<ExportProgressEventArgs>
+    {
+    public:
+        ExportProgressEventArgs(const hstring& path, const uint64_t rowsWritten, const uint64_t totalRows, const bool complete, const uint64_t result) :
+            _Path(path),
+            _RowsWritten(rowsWritten),
+            _TotalRows(totalRows),
+            _Complete(complete),
+            _Result(result)
+        {
+        }
+
+        WINRT_PROPERTY(hstring, Path);
+        WINRT_PROPERTY(uint64_t, RowsWritten);
+        WINRT_PROPERTY(uint64_t, TotalRows);
+        WINRT_PROPERTY(bool, Complete);
+        WINRT_PROPERTY(uint64_t, Result);
+    };
+
+    struct InputSentEventArgs : public InputSentEventArgsT<InputSentEventArgs>
+    {
+    public:
+        InputSentEventArgs(std::function<hstring(InputModes)> encode) :
+            _encode(encode) {}
+
+        // The key events are encoded each time they're asked for, so that a
+        // terminal in other input modes gets the sequences it expects.
+        hstring Encode(const InputModes modes) { return _encode(modes); };
+
+    private:
+        std::function<hstring(InputModes)> _encode;
+    };
 }
@@ -5,6 +5,8 @@
 #include "SearchBoxControl.h"
 #include "SearchBoxControl.g.cpp"
 
+#include <LibraryResources.h>
+
 using namespace winrt;
 using namespace winrt::Windows::UI::Xaml;
 using namespace winrt::Windows::UI::Core;
@@ -22,6 +24,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _focusableElements.insert(TextBox());
         _focusableElements.insert(CloseButton());
         _focusableElements.insert(CaseSensitivityButton());
+        _focusableElements.insert(RegexButton());
         _focusableElements.insert(GoForwardButton());
         _focusableElements.insert(GoBackwardButton());
     }
@@ -50,6 +53,17 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         return CaseSensitivityButton().IsChecked().GetBoolean();
     }
 
+    // Method Description:
+    // - Check if the text is searched for as a regular expression
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - bool: whether the regular expression button is checked
+    bool SearchBoxControl::_Regex()
+    {
+        return RegexButton().IsChecked().GetBoolean();
+    }
+
     // Method Description:
     // - Handler for pressing Enter on TextBox, trigger
     //   text search
@@ -65,11 +79,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             auto const state = CoreWindow::GetForCurrentThread().GetKeyState(winrt::Windows::System::VirtualKey::Shift);
             if (WI_IsFlagSet(state, CoreVirtualKeyStates::Down))
             {
-                _SearchHandlers(TextBox().Text(), !_GoForward(), _CaseSensitive());
+                _SearchHandlers(TextBox().Text(), !_GoForward(), _CaseSensitive(), _Regex());
             }
             else
             {
-                _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive());
+                _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
             }
             e.Handled(true);
         }
@@ -142,6 +156,73 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         return false;
     }
 
+    // Method Description:
+    // - Shows how many matches the text has, while they're still being counted
+    //   and once they're all found.
+    // - A regular expression that can't be searched for says so instead.
+    // Arguments:
+    // - totalMatches: the number of matches found so far
+    // - complete: whether all of them were found
+    // - invalidPattern: whether the text isn't a valid regular expression
+    // Return Value:
+    // - <none>
+    void SearchBoxControl::SetStatus(int32_t totalMatches, bool complete, bool invalidPattern)
+    {
+        if (TextBox().Text().empty())
+        {
+            StatusBox().Text({});
+            return;
+        }
+
+        if (invalidPattern)
+        {
+            StatusBox().Text(RS_(L"SearchBox_InvalidPattern"));
+            return;
+        }
+
+        const auto format = complete ? RS_(L"SearchBox_MatchCount") : RS_(L"SearchBox_MatchCountIncomplete");
+        StatusBox().Text(winrt::hstring{ fmt::format(std::wstring_view{ format }, totalMatches) });
+    }
+
+    // Method Description:
+    // - Handler for the text of the TextBox changing. This searches as the
+    //   text is typed, highlighting the matches without moving the selection.
+    // Arguments:
+    // - sender: not used
+    // - e: not used
+    // Return Value:
+    // - <none>
+    void SearchBoxControl::TextBoxTextChanged(winrt::Windows::Foundation::IInspectable const& /*sender*/, Controls::TextChangedEventArgs const& /*e*/)
+    {
+        _SearchChangedHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
+    }
+
+    // Method Description:
+    // - Handler for clicking the case sensitivity button. The matches are
+    //   searched for again, since they might not match anymore.
+    // Arguments:
+    // - sender: not used
+    // - e: not used
+    // Return Value:
+    // - <none>
+    void SearchBoxControl::CaseSensitivityButtonClicked(winrt::Windows::Foundation::IInspectable const& /*sender*/, RoutedEventArgs const& /*e*/)
+    {
+        _SearchChangedHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
+    }
+
+    // Method Description:
+    // - Handler for clicking the regular expression button. The matches are
+    //   searched for again, since the text means something else now.
+    // Arguments:
+    // - sender: not used
+    // - e: not used
+    // Return Value:
+    // - <none>
+    void SearchBoxControl::RegexButtonClicked(winrt::Windows::Foundation::IInspectable const& /*sender*/, RoutedEventArgs const& /*e*/)
+    {
+        _SearchChangedHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
+    }
+
     // Method Description:
     // - Handler for clicking the GoBackward button. This change the value of _goForward,
     //   mark GoBackward button as checked and ensure GoForward button
@@ -160,7 +241,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
 
         // kick off search
-        _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive());
+        _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
     }
 
     // Method Description:
@@ -181,7 +262,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
 
         // kick off search
-        _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive());
+        _SearchHandlers(TextBox().Text(), _GoForward(), _CaseSensitive(), _Regex());
     }
 
     // Method Description:
@@ -31,12 +31,17 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void SetFocusOnTextbox();
         void PopulateTextbox(winrt::hstring const& text);
         bool ContainsFocus();
+        void SetStatus(int32_t totalMatches, bool complete, bool invalidPattern);
 
         void GoBackwardClicked(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::RoutedEventArgs const& /*e*/);
         void GoForwardClicked(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::RoutedEventArgs const& /*e*/);
         void CloseClick(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::RoutedEventArgs const& e);
+        void TextBoxTextChanged(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::Controls::TextChangedEventArgs const& /*e*/);
+        void CaseSensitivityButtonClicked(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::RoutedEventArgs const& /*e*/);
+        void RegexButtonClicked(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::RoutedEventArgs const& /*e*/);
 
         WINRT_CALLBACK(Search, SearchHandler);
+        WINRT_CALLBACK(SearchChanged, SearchHandler);
         TYPED_EVENT(Closed, Control::SearchBoxControl, Windows::UI::Xaml::RoutedEventArgs);
 
     private:
@@ -44,6 +49,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         bool _GoForward();
         bool _CaseSensitive();
+        bool _Regex();
         void _KeyDownHandler(winrt::Windows::Foundation::IInspectable const& sender, winrt::Windows::UI::Xaml::Input::KeyRoutedEventArgs const& e);
         void _CharacterHandler(winrt::Windows::Foundation::IInspectable const& /*sender*/, winrt::Windows::UI::Xaml::Input::CharacterReceivedRoutedEventArgs const& e);
     };
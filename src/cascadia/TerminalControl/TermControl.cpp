@@ -10,6 +10,7 @@
 #include <Utils.h>
 #include <WinUser.h>
 #include <LibraryResources.h>
+#include <StartupTracing.h>
 #include "../../types/inc/GlyphWidth.hpp"
 #include "../../types/inc/Utils.hpp"
 
@@ -33,11 +34,24 @@ using namespace winrt::Windows::ApplicationModel::DataTransfer;
 // The updates are throttled to limit power usage.
 constexpr const auto ScrollBarUpdateInterval = std::chrono::milliseconds(8);
 
+// The minimum delay between drawing the search matches and prompts next to the scroll bar.
+constexpr const auto ScrollMarksUpdateInterval = std::chrono::milliseconds(100);
+
+// The colors of the scroll marks, as premultiplied BGRA.
+constexpr uint32_t ScrollMarkPromptColor = 0xFF9A9A9A;
+constexpr uint32_t ScrollMarkSearchColor = 0xFFFFA500;
+
 // The minimum delay between updating the TSF input control.
 constexpr const auto TsfRedrawInterval = std::chrono::milliseconds(100);
 
-// The minimum delay between updating the locations of regex patterns
-constexpr const auto UpdatePatternLocationsInterval = std::chrono::milliseconds(500);
+// The delay between updating the locations of regex patterns. It's short while the user
+// is typing, so that a URL they typed is recognized right away, and it grows up to the
+// maximum while output keeps streaming in, since every update scans the whole viewport.
+constexpr const auto UpdatePatternLocationsMinInterval = std::chrono::milliseconds(50);
+constexpr const auto UpdatePatternLocationsMaxInterval = std::chrono::milliseconds(800);
+
+// The minimum delay between the last resize and reflowing the rest of the scrollback
+constexpr const auto FinishResizeInterval = std::chrono::milliseconds(250);
 
 // The minimum delay between emitting warning bells
 constexpr const auto TerminalWarningBellInterval = std::chrono::milliseconds(1000);
@@ -60,6 +74,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _blinkTimer{},
         _searchBox{ nullptr }
     {
+        TRACE_STARTUP_PHASE(g_hTerminalControlProvider, "TermControl");
         InitializeComponent();
 
         _interactivity = winrt::make_self<ControlInteractivity>(settings, connection);
@@ -79,6 +94,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // This event is specifically triggered by the renderer thread, a BG thread. Use a weak ref here.
         _core->RendererEnteredErrorState({ get_weak(), &TermControl::_RendererEnteredErrorState });
 
+        // This one is raised by the search in the background.
+        _core->SearchMatchCountChanged({ get_weak(), &TermControl::_coreSearchMatchCountChanged });
+
         // These callbacks can only really be triggered by UI interactions. So
         // they don't need weak refs - they can't be triggered unless we're
         // alive.
@@ -87,9 +105,19 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _core->TransparencyChanged({ this, &TermControl::_coreTransparencyChanged });
         _core->RaiseNotice({ this, &TermControl::_coreRaisedNotice });
         _core->HoveredHyperlinkChanged({ this, &TermControl::_hoveredHyperlinkChanged });
+        _core->PowerSavingChanged({ get_weak(), &TermControl::_corePowerSavingChanged });
         _interactivity->OpenHyperlink({ this, &TermControl::_HyperlinkHandler });
         _interactivity->ScrollPositionChanged({ this, &TermControl::_ScrollPositionChanged });
 
+        // Nothing is painted while we aren't part of the UI (when our tab isn't
+        // selected, for instance). When a control is moved around, Loaded can come
+        // before Unloaded, so both check where we really are.
+        Loaded([this](auto&&, auto&&) {
+            _LoadTSFInputControl();
+            _UpdatePaintingSuspension();
+        });
+        Unloaded([this](auto&&, auto&&) { _UpdatePaintingSuspensionAfterLayout(); });
+
         // Initialize the terminal only once the swapchainpanel is loaded - that
         //      way, we'll be able to query the real pixel size it got on layout
         _layoutUpdatedRevoker = SwapChainPanel().LayoutUpdated(winrt::auto_revoke, [this](auto /*s*/, auto /*e*/) {
@@ -114,15 +142,17 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             Dispatcher(),
             TsfRedrawInterval,
             [weakThis = get_weak()]() {
-                if (auto control{ weakThis.get() })
+                auto control{ weakThis.get() };
+                if (control && control->_tsfInputControl)
                 {
-                    control->TSFInputControl().TryRedrawCanvas();
+                    control->_tsfInputControl.TryRedrawCanvas();
                 }
             });
 
         _updatePatternLocations = std::make_shared<ThrottledFuncTrailing<>>(
             Dispatcher(),
-            UpdatePatternLocationsInterval,
+            UpdatePatternLocationsMinInterval,
+            UpdatePatternLocationsMaxInterval,
             [weakThis = get_weak()]() {
                 if (auto control{ weakThis.get() })
                 {
@@ -130,6 +160,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 }
             });
 
+        _finishResize = std::make_shared<ThrottledFuncTrailing<>>(
+            Dispatcher(),
+            FinishResizeInterval,
+            [weakThis = get_weak()]() {
+                if (auto control{ weakThis.get() })
+                {
+                    control->_core->FinishResize();
+                }
+            });
+
         _playWarningBell = std::make_shared<ThrottledFuncLeading>(
             Dispatcher(),
             TerminalWarningBellInterval,
@@ -163,6 +203,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                 }
             });
 
+        _updateScrollMarks = std::make_shared<ThrottledFuncTrailing<>>(
+            Dispatcher(),
+            ScrollMarksUpdateInterval,
+            [weakThis = get_weak()]() {
+                if (auto control{ weakThis.get() })
+                {
+                    control->_DrawScrollMarks();
+                }
+            });
+
         static constexpr auto AutoScrollUpdateInterval = std::chrono::microseconds(static_cast<int>(1.0 / 30.0 * 1000000));
         _autoScrollTimer.Interval(AutoScrollUpdateInterval);
         _autoScrollTimer.Tick({ this, &TermControl::_UpdateAutoScroll });
@@ -215,10 +265,27 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
         else
         {
-            _core->Search(_searchBox->TextBox().Text(), goForward, false);
+            _core->Search(_searchBox->TextBox().Text(), goForward, false, false);
         }
     }
 
+    // Method Description:
+    // - Writes the whole buffer to a file in the background, see ControlCore::ExportBuffer.
+    //   Its progress is raised as ExportProgressChanged.
+    // Arguments:
+    // - path: the file to write
+    // - includeAttributes: whether to write the attributes of the text as VT sequences
+    // Return Value:
+    // - <none>
+    void TermControl::ExportBuffer(const winrt::hstring& path, const bool includeAttributes)
+    {
+        if (_closing)
+        {
+            return;
+        }
+        _core->ExportBuffer(path, includeAttributes);
+    }
+
     // Method Description:
     // - Search text in text buffer. This is triggered if the user click
     //   search button or press enter.
@@ -226,13 +293,99 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     // - text: the text to search
     // - goForward: boolean that represents if the current search direction is forward
     // - caseSensitive: boolean that represents if the current search is case sensitive
+    // - regex: whether the text is a regular expression
     // Return Value:
     // - <none>
     void TermControl::_Search(const winrt::hstring& text,
                               const bool goForward,
-                              const bool caseSensitive)
+                              const bool caseSensitive,
+                              const bool regex)
+    {
+        _core->Search(text, goForward, caseSensitive, regex);
+    }
+
+    // Method Description:
+    // - Highlights the matches of the text in the search box as it's typed.
+    // Arguments:
+    // - text: the text to search
+    // - goForward: not used, all of the matches are highlighted
+    // - caseSensitive: boolean that represents if the current search is case sensitive
+    // - regex: whether the text is a regular expression
+    // Return Value:
+    // - <none>
+    void TermControl::_SearchChanged(const winrt::hstring& text,
+                                     const bool /*goForward*/,
+                                     const bool caseSensitive,
+                                     const bool regex)
     {
-        _core->Search(text, goForward, caseSensitive);
+        _core->SearchChanged(text, caseSensitive, regex);
+    }
+
+    // Method Description:
+    // - Shows the number of matches the background search found in the search box.
+    // Arguments:
+    // - args: the number of matches, and whether that's all of them
+    // Return Value:
+    // - <none>
+    winrt::fire_and_forget TermControl::_coreSearchMatchCountChanged(IInspectable /*sender*/,
+                                                                     Control::SearchMatchCountChangedEventArgs args)
+    {
+        auto weakThis{ get_weak() };
+        co_await winrt::resume_foreground(Dispatcher());
+
+        if (auto control{ weakThis.get() })
+        {
+            if (control->_searchBox)
+            {
+                control->_searchBox->SetStatus(args.TotalMatches(), args.Complete(), args.InvalidPattern());
+            }
+            if (control->_updateScrollMarks)
+            {
+                control->_updateScrollMarks->Run();
+            }
+        }
+    }
+
+    // Method Description:
+    // - Draws the search matches and the prompts of the buffer next to the scroll
+    //   bar, into a bitmap with a pixel per row of the scroll bar. The prompts are
+    //   in its left column and the matches in its right one.
+    // - The bitmap is drawn as a whole, in one go, so that it takes the same time
+    //   no matter how many matches and prompts there are.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void TermControl::_DrawScrollMarks()
+    {
+        if (_closing)
+        {
+            return;
+        }
+
+        auto image = ScrollMarksImage();
+        const auto height = gsl::narrow_cast<int32_t>(std::lround(ScrollBar().ActualHeight()));
+        const auto marks = height > 0 ? _core->ScrollMarks(gsl::narrow_cast<size_t>(height)) : std::vector<uint8_t>{};
+        if (std::all_of(marks.begin(), marks.end(), [](const auto mark) { return mark == 0; }))
+        {
+            image.Source(nullptr);
+            _scrollMarksBitmap = nullptr;
+            return;
+        }
+
+        if (!_scrollMarksBitmap || _scrollMarksBitmap.PixelHeight() != height)
+        {
+            _scrollMarksBitmap = Media::Imaging::WriteableBitmap{ 2, height };
+        }
+
+        auto pixels = reinterpret_cast<uint32_t*>(_scrollMarksBitmap.PixelBuffer().data());
+        for (const auto mark : marks)
+        {
+            *pixels++ = WI_IsFlagSet(mark, ::Microsoft::Terminal::Core::Terminal::ScrollMarkPrompt) ? ScrollMarkPromptColor : 0;
+            *pixels++ = WI_IsFlagSet(mark, ::Microsoft::Terminal::Core::Terminal::ScrollMarkSearch) ? ScrollMarkSearchColor : 0;
+        }
+        _scrollMarksBitmap.Invalidate();
+        image.Source(_scrollMarksBitmap);
     }
 
     // Method Description:
@@ -247,6 +400,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
                                              RoutedEventArgs const& /*args*/)
     {
         _searchBox->Visibility(Visibility::Collapsed);
+        _core->ClearSearch();
 
         // Set focus back to terminal control
         this->Focus(FocusState::Programmatic);
@@ -356,9 +510,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _changeBackgroundColor(bg);
 
         // Set TSF Foreground
-        Media::SolidColorBrush foregroundBrush{};
-        foregroundBrush.Color(static_cast<til::color>(newAppearance.DefaultForeground()));
-        TSFInputControl().Foreground(foregroundBrush);
+        _tsfForeground = Media::SolidColorBrush{};
+        _tsfForeground.Color(static_cast<til::color>(newAppearance.DefaultForeground()));
+        if (_tsfInputControl)
+        {
+            _tsfInputControl.Foreground(_tsfForeground);
+        }
 
         _core->UpdateAppearance(newAppearance);
     }
@@ -374,6 +531,34 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _core->SendInput(wstr);
     }
 
+    // Method Description:
+    // - Whether the keys that are typed into this control are broadcast. See
+    //   ControlCore::BroadcastInput.
+    bool TermControl::BroadcastInput() const noexcept
+    {
+        return _core->BroadcastInput();
+    }
+
+    void TermControl::BroadcastInput(const bool broadcastInput)
+    {
+        _core->BroadcastInput(broadcastInput);
+    }
+
+    Control::InputModes TermControl::InputModes() const noexcept
+    {
+        return _core->InputModes();
+    }
+
+    // Method Description:
+    // - Writes input that was broadcast from another control to the connection,
+    //   without changing the state of this one. See ControlCore::SendBroadcastInput.
+    // Arguments:
+    // - wstr: the input, encoded for the InputModes of this control.
+    void TermControl::SendBroadcastInput(const winrt::hstring& wstr)
+    {
+        _core->SendBroadcastInput(wstr);
+    }
+
     void TermControl::ToggleShaderEffects()
     {
         _core->ToggleShaderEffects();
@@ -402,7 +587,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         auto newMargin = _ParseThicknessFromPadding(newSettings.Padding());
         SwapChainPanel().Margin(newMargin);
 
-        TSFInputControl().Margin(newMargin);
+        if (_tsfInputControl)
+        {
+            _tsfInputControl.Margin(newMargin);
+        }
 
         // Apply settings for scrollbar
         if (newSettings.ScrollState() == ScrollbarState::Hidden)
@@ -459,6 +647,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             acrylic.FallbackColor(bgColor);
             acrylic.TintColor(bgColor);
 
+            // While the renderer saves power, so does the acrylic, by showing the
+            // fallback color instead of blurring whatever is behind the window.
+            acrylic.AlwaysUseFallback(_core->PowerSaving());
+
             // Apply brush settings
             acrylic.TintOpacity(_settings.TintOpacity());
 
@@ -520,6 +712,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
     // Method Description:
     // - Creates an automation peer for the Terminal Control, enabling accessibility on our control.
+    // - XAML only asks for the peer once an automation client looks at the control,
+    //   so the UiaEngine is created here rather than with the control. Until then,
+    //   the renderer doesn't pay for accessibility at all.
     // Arguments:
     // - None
     // Return Value:
@@ -527,6 +722,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
     Windows::UI::Xaml::Automation::Peers::AutomationPeer TermControl::OnCreateAutomationPeer()
     try
     {
+        if (_automationPeer)
+        {
+            // The renderer holds on to the engine of the existing peer,
+            // so that one has to stay alive and is handed out again.
+            return _automationPeer;
+        }
         if (_initializedTerminal && !_closing) // only set up the automation peer if we're ready to go live
         {
             // create a custom automation peer with this code pattern:
@@ -534,6 +735,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             auto autoPeer = winrt::make_self<implementation::TermControlAutomationPeer>(this);
 
             _uiaEngine = std::make_unique<::Microsoft::Console::Render::UiaEngine>(autoPeer.get());
+            if (!_focused)
+            {
+                // Like on LostFocus, we only notify clients while we're focused.
+                THROW_IF_FAILED(_uiaEngine->Disable());
+            }
             _core->AttachUiaEngine(_uiaEngine.get());
             _automationPeer = *autoPeer;
             return _automationPeer;
@@ -632,6 +838,37 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         nativePanel->SetSwapChainHandle(swapChainHandle);
     }
 
+    // Method Description:
+    // - Loads the TSF input control, the first time the control is shown.
+    //   Controls that are created but never shown, like the ones of the tabs
+    //   that weren't selected yet, don't need it.
+    void TermControl::_LoadTSFInputControl()
+    {
+        if (_tsfInputControl || _closing)
+        {
+            return;
+        }
+
+        if (auto loaded{ FindName(L"TSFInputControl") })
+        {
+            _tsfInputControl = loaded.try_as<Control::TSFInputControl>();
+        }
+        if (!_tsfInputControl)
+        {
+            return;
+        }
+
+        _tsfInputControl.Margin(SwapChainPanel().Margin());
+        if (_tsfForeground)
+        {
+            _tsfInputControl.Foreground(_tsfForeground);
+        }
+        if (_focused)
+        {
+            _tsfInputControl.NotifyFocusEnter();
+        }
+    }
+
     bool TermControl::_InitializeTerminal()
     {
         if (_initializedTerminal)
@@ -683,6 +920,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         // actually attached the swapchain to anything, and the DxEngine is not
         // prepared to handle that.
         _core->EnablePainting();
+        _UpdatePaintingSuspension();
 
         auto bufferHeight = _core->BufferHeight();
 
@@ -693,12 +931,12 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         ScrollBar().LargeChange(std::max(bufferHeight - 1, 0)); // scroll one "screenful" at a time when the scroll bar is clicked
 
         // Set up blinking cursor
-        int blinkTime = GetCaretBlinkTime();
+        const auto blinkTime = GetCaretBlinkTime();
         if (blinkTime != INFINITE)
         {
             // Create a timer
             DispatcherTimer cursorTimer;
-            cursorTimer.Interval(std::chrono::milliseconds(blinkTime));
+            cursorTimer.Interval(_CursorBlinkInterval(blinkTime));
             cursorTimer.Tick({ get_weak(), &TermControl::_CursorTimerTick });
             cursorTimer.Start();
             _cursorTimer.emplace(std::move(cursorTimer));
@@ -984,7 +1222,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         if (vkey == VK_ESCAPE ||
             vkey == VK_RETURN)
         {
-            TSFInputControl().ClearBuffer();
+            if (_tsfInputControl)
+            {
+                _tsfInputControl.ClearBuffer();
+            }
         }
 
         // If the terminal translated the key, mark the event as handled.
@@ -1257,6 +1498,42 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         CATCH_LOG();
     }
 
+    // Method Description:
+    // - Gets how often the cursor blinks. It blinks half as often while the
+    //   renderer saves power, since every blink is a frame.
+    // Arguments:
+    // - blinkTime: the blink time of the system, in milliseconds
+    // Return Value:
+    // - the interval of the cursor timer
+    std::chrono::milliseconds TermControl::_CursorBlinkInterval(const UINT blinkTime) const noexcept
+    {
+        return std::chrono::milliseconds{ _core->PowerSaving() ? blinkTime * 2 : blinkTime };
+    }
+
+    // Method Description:
+    // - Called when the renderer starts or stops saving power. Slows the cursor
+    //   down (or speeds it back up) and turns the acrylic blur off (or on).
+    // Arguments:
+    // - <unused>
+    winrt::fire_and_forget TermControl::_corePowerSavingChanged(IInspectable /*sender*/,
+                                                                IInspectable /*args*/)
+    {
+        co_await resume_foreground(Dispatcher());
+        try
+        {
+            const auto blinkTime = GetCaretBlinkTime();
+            if (_cursorTimer.has_value() && blinkTime != INFINITE)
+            {
+                _cursorTimer.value().Interval(_CursorBlinkInterval(blinkTime));
+            }
+            if (auto acrylic = RootGrid().Background().try_as<Media::AcrylicBrush>())
+            {
+                acrylic.AlwaysUseFallback(_core->PowerSaving());
+            }
+        }
+        CATCH_LOG();
+    }
+
     void TermControl::_coreReceivedOutput(const IInspectable& /*sender*/,
                                           const IInspectable& /*args*/)
     {
@@ -1445,6 +1722,7 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         }
 
         _focused = true;
+        _core->SetFocused(true);
 
         InputPane::GetForCurrentView().TryShow();
 
@@ -1463,9 +1741,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
             return;
         }
 
-        if (TSFInputControl() != nullptr)
+        if (_tsfInputControl)
         {
-            TSFInputControl().NotifyFocusEnter();
+            _tsfInputControl.NotifyFocusEnter();
         }
 
         if (_cursorTimer.has_value())
@@ -1506,15 +1784,16 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _RestorePointerCursorHandlers(*this, nullptr);
 
         _focused = false;
+        _core->SetFocused(false);
 
         if (_uiaEngine.get())
         {
             THROW_IF_FAILED(_uiaEngine->Disable());
         }
 
-        if (TSFInputControl() != nullptr)
+        if (_tsfInputControl)
         {
-            TSFInputControl().NotifyFocusLeave();
+            _tsfInputControl.NotifyFocusLeave();
         }
 
         if (_cursorTimer.has_value())
@@ -1551,6 +1830,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         const auto newSize = e.NewSize();
         _core->SizeChanged(newSize.Width, newSize.Height);
+
+        // SizeChanged only reflows the rows around the viewport. The rest
+        // is reflowed once the user stops resizing for a moment.
+        _finishResize->Run();
     }
 
     // Method Description:
@@ -1654,6 +1937,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         _updateScrollBar->Run(update);
         _updatePatternLocations->Run();
+        // The marks are counted from the top of everything that was ever in the
+        // buffer, so they only move once the buffer grows or circles.
+        _updateScrollMarks->Run();
     }
 
     // Method Description:
@@ -1723,17 +2009,22 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
             _RestorePointerCursorHandlers(*this, nullptr);
 
-            // These four throttled functions are triggered by terminal output and interact with the UI.
+            // These throttled functions are triggered by terminal output (or resizing) and interact with the UI.
             // Since Close() is the point after which we are removed from the UI, but before the destructor
             // has run, we should disconnect them *right now*. If we don't, they may fire between the
             // throttle delay (from the final output) and the dtor.
             _tsfTryRedrawCanvas.reset();
             _updatePatternLocations.reset();
+            _finishResize.reset();
             _updateScrollBar.reset();
+            _updateScrollMarks.reset();
             _playWarningBell.reset();
 
             // Disconnect the TSF input control so it doesn't receive EditContext events.
-            TSFInputControl().Close();
+            if (_tsfInputControl)
+            {
+                _tsfInputControl.Close();
+            }
             _autoScrollTimer.Stop();
 
             _core->Close();
@@ -2446,6 +2737,54 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         _ReadOnlyChangedHandlers(*this, winrt::box_value(_core->IsInReadOnlyMode()));
     }
 
+    // Method Description:
+    // - Tells the control whether the window it's in can be seen, or is minimized.
+    // Arguments:
+    // - visible: whether the window can be seen
+    void TermControl::WindowVisibilityChanged(const bool visible)
+    {
+        _windowVisible = visible;
+        _UpdatePaintingSuspension();
+    }
+
+    // Method Description:
+    // - Puts the core into the background while nothing of the control can be
+    //   seen, which suspends painting and the UI's work on the output, and brings
+    //   it back otherwise. What's output in the meantime is caught up on then.
+    void TermControl::_UpdatePaintingSuspension()
+    {
+        if (_closing)
+        {
+            return;
+        }
+
+        if (_windowVisible && IsLoaded())
+        {
+            _core->LeaveBackground();
+        }
+        else
+        {
+            _core->EnterBackground();
+        }
+    }
+
+    // Method Description:
+    // - Like _UpdatePaintingSuspension, but only once the pending layout is done.
+    // - Zooming a pane, or moving it to another tab, takes the control out of the
+    //   tree and puts it back right away. If it went into the background in
+    //   between, the renderer's caches would be trimmed and the next frame would
+    //   have to build them all again. Instead, the device, the caches and the last
+    //   frame stay, and only what the new size requires is painted.
+    winrt::fire_and_forget TermControl::_UpdatePaintingSuspensionAfterLayout()
+    {
+        auto weakThis{ get_weak() };
+        co_await winrt::resume_foreground(Dispatcher(), CoreDispatcherPriority::Low);
+        if (auto self{ weakThis.get() })
+        {
+            self->_UpdatePaintingSuspension();
+        }
+    }
+
     // Method Description:
     // - Handle a mouse exited event, specifically clearing last hovered cell
     // and removing selection from hyper link if exists
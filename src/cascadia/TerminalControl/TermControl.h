@@ -65,6 +65,11 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void SendInput(const winrt::hstring& input);
         void ToggleShaderEffects();
 
+        bool BroadcastInput() const noexcept;
+        void BroadcastInput(const bool broadcastInput);
+        Control::InputModes InputModes() const noexcept;
+        void SendBroadcastInput(const winrt::hstring& input);
+
         winrt::fire_and_forget RenderEngineSwapChainChanged(IInspectable sender, IInspectable args);
         void _AttachDxgiSwapChainToXaml(HANDLE swapChainHandle);
         winrt::fire_and_forget _RendererEnteredErrorState(IInspectable sender, IInspectable args);
@@ -77,6 +82,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         void SearchMatch(const bool goForward);
 
+        void ExportBuffer(const winrt::hstring& path, const bool includeAttributes);
+
         bool OnDirectKeyEvent(const uint32_t vkey, const uint8_t scanCode, const bool down);
 
         bool OnMouseWheel(const Windows::Foundation::Point location, const int32_t delta, const bool leftButtonDown, const bool midButtonDown, const bool rightButtonDown);
@@ -104,6 +111,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         bool ReadOnly() const noexcept;
         void ToggleReadOnly();
 
+        void WindowVisibilityChanged(const bool visible);
+
         static ::Microsoft::Console::VirtualTerminal::TerminalInput::MouseButtonState GetPressedMouseButtons(const winrt::Windows::UI::Input::PointerPoint point);
         static unsigned int GetPointerUpdateKind(const winrt::Windows::UI::Input::PointerPoint point);
 
@@ -116,6 +125,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         FORWARDED_TYPED_EVENT(TabColorChanged,        IInspectable, IInspectable, _core, TabColorChanged);
         FORWARDED_TYPED_EVENT(SetTaskbarProgress,     IInspectable, IInspectable, _core, TaskbarProgressChanged);
         FORWARDED_TYPED_EVENT(ConnectionStateChanged, IInspectable, IInspectable, _core, ConnectionStateChanged);
+        FORWARDED_TYPED_EVENT(ExportProgressChanged,  IInspectable, Control::ExportProgressEventArgs, _core, ExportProgressChanged);
+        FORWARDED_TYPED_EVENT(InputSent,              IInspectable, Control::InputSentEventArgs, _core, InputSent);
         FORWARDED_TYPED_EVENT(PasteFromClipboard,     IInspectable, Control::PasteFromClipboardEventArgs, _interactivity, PasteFromClipboard);
 
         TYPED_EVENT(OpenHyperlink,             IInspectable, Control::OpenHyperlinkEventArgs);
@@ -148,13 +159,22 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         winrt::com_ptr<ControlInteractivity> _interactivity;
         winrt::com_ptr<SearchBoxControl> _searchBox;
 
+        // The TSF input control creates an edit context of the OS, which isn't
+        // needed before the control is shown, so it's only loaded then. Until
+        // it is, its foreground is stashed here.
+        Control::TSFInputControl _tsfInputControl{ nullptr };
+        winrt::Windows::UI::Xaml::Media::SolidColorBrush _tsfForeground{ nullptr };
+        void _LoadTSFInputControl();
+
         IControlSettings _settings;
         std::atomic<bool> _closing;
         bool _focused;
         bool _initializedTerminal;
+        bool _windowVisible{ true };
 
         std::shared_ptr<ThrottledFuncTrailing<>> _tsfTryRedrawCanvas;
         std::shared_ptr<ThrottledFuncTrailing<>> _updatePatternLocations;
+        std::shared_ptr<ThrottledFuncTrailing<>> _finishResize;
         std::shared_ptr<ThrottledFuncLeading> _playWarningBell;
 
         struct ScrollBarUpdate
@@ -167,6 +187,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         std::shared_ptr<ThrottledFuncTrailing<ScrollBarUpdate>> _updateScrollBar;
         bool _isInternalScrollBarUpdate;
 
+        // The search matches and prompts next to the scroll bar, see _DrawScrollMarks.
+        std::shared_ptr<ThrottledFuncTrailing<>> _updateScrollMarks;
+        Windows::UI::Xaml::Media::Imaging::WriteableBitmap _scrollMarksBitmap{ nullptr };
+
         // Auto scroll occurs when user, while selecting, drags cursor outside viewport. View is then scrolled to 'follow' the cursor.
         double _autoScrollVelocity;
         std::optional<Windows::UI::Input::PointerPoint> _autoScrollingPointerPoint;
@@ -183,6 +207,9 @@ namespace winrt::Microsoft::Terminal::Control::implementation
 
         winrt::Windows::UI::Xaml::Controls::SwapChainPanel::LayoutUpdated_revoker _layoutUpdatedRevoker;
 
+        void _UpdatePaintingSuspension();
+        winrt::fire_and_forget _UpdatePaintingSuspensionAfterLayout();
+
         void _UpdateSettingsFromUIThread(IControlSettings newSettings);
         void _UpdateAppearanceFromUIThread(IControlAppearance newAppearance);
         void _ApplyUISettings(const IControlSettings&);
@@ -244,7 +271,8 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         const til::point _toTerminalOrigin(winrt::Windows::Foundation::Point cursorPosition);
         double _GetAutoScrollSpeed(double cursorDistanceFromBorder) const;
 
-        void _Search(const winrt::hstring& text, const bool goForward, const bool caseSensitive);
+        void _Search(const winrt::hstring& text, const bool goForward, const bool caseSensitive, const bool regex);
+        void _SearchChanged(const winrt::hstring& text, const bool goForward, const bool caseSensitive, const bool regex);
         void _CloseSearchBoxControl(const winrt::Windows::Foundation::IInspectable& sender, Windows::UI::Xaml::RoutedEventArgs const& args);
 
         // TSFInputControl Handlers
@@ -261,6 +289,10 @@ namespace winrt::Microsoft::Terminal::Control::implementation
         void _coreReceivedOutput(const IInspectable& sender, const IInspectable& args);
         void _coreRaisedNotice(const IInspectable& s, const Control::NoticeEventArgs& args);
         void _coreWarningBell(const IInspectable& sender, const IInspectable& args);
+        winrt::fire_and_forget _coreSearchMatchCountChanged(IInspectable sender, Control::SearchMatchCountChangedEventArgs args);
+        void _DrawScrollMarks();
+        winrt::fire_and_forget _corePowerSavingChanged(IInspectable sender, IInspectable args);
+        std::chrono::milliseconds _CursorBlinkInterval(const UINT blinkTime) const noexcept;
     };
 }
 
@@ -3,7 +3,9 @@
 #pragma once
 
 #include "../../terminal/adapter/DispatchTypes.hpp"
+#include "../../terminal/adapter/ITermDispatch.hpp"
 #include "../../buffer/out/TextAttribute.hpp"
+#include "../../buffer/out/PromptMarks.hpp"
 #include "../../types/inc/Viewport.hpp"
 
 namespace Microsoft::Terminal::Core
@@ -59,6 +61,7 @@ namespace Microsoft::Terminal::Core
         virtual bool EnableAlternateScrollMode(const bool enabled) noexcept = 0;
         virtual bool EnableXtermBracketedPasteMode(const bool enabled) noexcept = 0;
         virtual bool IsXtermBracketedPasteModeEnabled() const = 0;
+        virtual bool EnableSynchronizedOutput(const bool enabled) noexcept = 0;
 
         virtual bool IsVtInputEnabled() const = 0;
 
@@ -72,6 +75,10 @@ namespace Microsoft::Terminal::Core
         virtual bool SetWorkingDirectory(std::wstring_view uri) noexcept = 0;
         virtual std::wstring_view GetWorkingDirectory() noexcept = 0;
 
+        virtual bool AddPromptMark(const PromptMarkKind kind) noexcept = 0;
+
+        virtual ::Microsoft::Console::VirtualTerminal::ITermDispatch::StringHandler DefineSixelImage(const bool transparentBackground) noexcept = 0;
+
         virtual bool PushGraphicsRendition(const ::Microsoft::Console::VirtualTerminal::VTParameters options) noexcept = 0;
         virtual bool PopGraphicsRendition() noexcept = 0;
 
@@ -0,0 +1,357 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "OutputPipeline.hpp"
+
+using namespace ::Microsoft::Terminal::Core;
+using namespace ::Microsoft::Console::VirtualTerminal;
+
+// The number of batches that may be in flight before Write() blocks,
+// and the number of batches applied while holding the lock once.
+static constexpr uint32_t s_channelCapacity = 64;
+static constexpr size_t s_batchesPerLock = 8;
+
+// The engine driven by the pipeline's state machine. Instead of dispatching
+// the actions it receives, it appends them to the batch being recorded.
+class OutputPipeline::RecordingEngine final : public IStateMachineEngine
+{
+public:
+    RecordingEngine(const IStateMachineEngine& target, Batch& batch) noexcept :
+        _target{ target },
+        _batch{ batch }
+    {
+    }
+
+    bool ActionExecute(const wchar_t wch) override
+    {
+        _Record(OpKind::Execute, wch);
+        return true;
+    }
+
+    bool ActionExecuteFromEscape(const wchar_t wch) override
+    {
+        _Record(OpKind::ExecuteFromEscape, wch);
+        return true;
+    }
+
+    bool ActionPrint(const wchar_t wch) override
+    {
+        _Record(OpKind::Print, wch);
+        return true;
+    }
+
+    bool ActionPrintString(const std::wstring_view string) override
+    {
+        _RecordString(OpKind::PrintString, string);
+        return true;
+    }
+
+    bool ActionPassThroughString(const std::wstring_view string) override
+    {
+        _RecordString(OpKind::PassThroughString, string);
+        return true;
+    }
+
+    bool ActionEscDispatch(const VTID id) override
+    {
+        _Record(OpKind::EscDispatch, 0, id);
+        return true;
+    }
+
+    bool ActionVt52EscDispatch(const VTID id, const VTParameters parameters) override
+    {
+        _RecordParameters(OpKind::Vt52EscDispatch, 0, id, parameters);
+        return true;
+    }
+
+    bool ActionCsiDispatch(const VTID id, const VTParameters parameters) override
+    {
+        _RecordParameters(OpKind::CsiDispatch, 0, id, parameters);
+        return true;
+    }
+
+    StringHandler ActionDcsDispatch(const VTID id, const VTParameters parameters) override
+    {
+        // Whether the string is consumed is only known once it's replayed.
+        // Until then all of it is recorded and the apply thread drops what isn't wanted.
+        _RecordParameters(OpKind::DcsDispatch, 0, id, parameters);
+        return [this](const wchar_t wch) {
+            _Record(OpKind::DcsData, wch);
+            return true;
+        };
+    }
+
+    bool ActionClear() noexcept override
+    {
+        return true;
+    }
+
+    bool ActionIgnore() noexcept override
+    {
+        return true;
+    }
+
+    bool ActionEndOfString() override
+    {
+        _Record(OpKind::EndOfString, 0);
+        return true;
+    }
+
+    bool ActionOscDispatch(const wchar_t wch, const size_t parameter, const std::wstring_view string) override
+    {
+        _RecordString(OpKind::OscDispatch, string, wch, parameter);
+        return true;
+    }
+
+    bool ActionSs3Dispatch(const wchar_t wch, const VTParameters parameters) override
+    {
+        _RecordParameters(OpKind::Ss3Dispatch, wch, 0, parameters);
+        return true;
+    }
+
+    // The parsing options are those of the engine the actions are replayed into.
+    bool ParseControlSequenceAfterSs3() const override
+    {
+        return _target.ParseControlSequenceAfterSs3();
+    }
+
+    bool FlushAtEndOfString() const override
+    {
+        return _target.FlushAtEndOfString();
+    }
+
+    bool DispatchControlCharsFromEscape() const override
+    {
+        return _target.DispatchControlCharsFromEscape();
+    }
+
+    bool DispatchIntermediatesFromEscape() const override
+    {
+        return _target.DispatchIntermediatesFromEscape();
+    }
+
+private:
+    void _Record(const OpKind kind, const wchar_t wch, const uint64_t id = 0)
+    {
+        _batch.ops.push_back({ kind, wch, id, 0, 0, 0 });
+    }
+
+    void _RecordString(const OpKind kind, const std::wstring_view string, const wchar_t wch = 0, const size_t parameter = 0)
+    {
+        const auto offset = gsl::narrow<uint32_t>(_batch.text.size());
+        _batch.text.append(string);
+        _batch.ops.push_back({ kind, wch, 0, parameter, offset, gsl::narrow<uint32_t>(string.size()) });
+    }
+
+    void _RecordParameters(const OpKind kind, const wchar_t wch, const uint64_t id, const VTParameters parameters)
+    {
+        // VTParameters reports a size of at least 1, so an empty list has to be kept empty explicitly.
+        const auto offset = gsl::narrow<uint32_t>(_batch.parameters.size());
+        const auto count = parameters.empty() ? 0 : parameters.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            _batch.parameters.push_back(parameters.at(i));
+        }
+        _batch.ops.push_back({ kind, wch, id, 0, offset, gsl::narrow<uint32_t>(count) });
+    }
+
+    const IStateMachineEngine& _target;
+    Batch& _batch;
+};
+
+// Routine Description:
+// - Creates the pipeline and starts its apply thread.
+// Arguments:
+// - target - the engine the parsed output is replayed into
+// - writeLock - the lock held while replaying, usually the terminal's read/write lock
+// - statistics - where the time spent parsing and replaying is added up
+OutputPipeline::OutputPipeline(IStateMachineEngine& target, til::fair_shared_mutex& writeLock, const std::unique_ptr<TextBuffer>& buffer, OutputStatistics& statistics) :
+    _target{ target },
+    _writeLock{ writeLock },
+    _buffer{ buffer },
+    _statistics{ statistics }
+{
+    _stateMachine = std::make_unique<StateMachine>(std::make_unique<RecordingEngine>(target, _batch));
+
+    auto [producer, consumer] = til::spsc::channel<Batch>(s_channelCapacity);
+    _producer.emplace(std::move(producer));
+    _applyThread = std::thread([this, consumer = std::move(consumer)]() {
+        _ApplyLoop(consumer);
+    });
+}
+
+// Routine Description:
+// - Waits for the output written so far to be applied and stops the apply thread.
+OutputPipeline::~OutputPipeline()
+{
+    // Dropping the producer lets the apply thread drain the channel and exit.
+    _producer.reset();
+    if (_applyThread.joinable())
+    {
+        _applyThread.join();
+    }
+}
+
+// Routine Description:
+// - Parses the given output and queues the result for the apply thread.
+//   Blocks only if the apply thread is too far behind.
+// - Must always be called from the same thread.
+// Arguments:
+// - string - the output to parse
+void OutputPipeline::Write(const std::wstring_view string)
+{
+    const auto start = std::chrono::steady_clock::now();
+    _stateMachine->ProcessString(string);
+    OutputStatistics::Add(_statistics.parseTime, std::chrono::steady_clock::now() - start);
+    _Submit();
+}
+
+// Routine Description:
+// - Same as above, for UTF-8 output.
+// Arguments:
+// - utf8 - the output to parse
+void OutputPipeline::Write(const std::string_view utf8)
+{
+    const auto start = std::chrono::steady_clock::now();
+    _stateMachine->ProcessString(utf8);
+    OutputStatistics::Add(_statistics.parseTime, std::chrono::steady_clock::now() - start);
+    _Submit();
+}
+
+// Routine Description:
+// - Blocks until everything written so far has been applied.
+// - Must be called from the thread calling Write().
+void OutputPipeline::WaitForIdle()
+{
+    std::unique_lock lock{ _idleMutex };
+    _idleCondition.wait(lock, [this]() { return _applied == _submitted; });
+}
+
+void OutputPipeline::_Submit()
+{
+    if (_batch.ops.empty())
+    {
+        return;
+    }
+
+    // The batch is moved into the channel, which leaves an empty one for the next Write().
+    if (_producer->emplace(std::move(_batch)))
+    {
+        _submitted++;
+    }
+    _batch = {};
+}
+
+void OutputPipeline::_ApplyLoop(const til::spsc::consumer<Batch>& consumer)
+{
+    std::vector<Batch> batches(s_batchesPerLock);
+
+    for (;;)
+    {
+        const auto [count, alive] = consumer.pop_n(til::spsc::block_initially, batches.begin(), batches.size());
+
+        if (count != 0)
+        {
+            {
+                const auto lockStart = std::chrono::steady_clock::now();
+                std::unique_lock lock{ _writeLock };
+                const auto replayStart = std::chrono::steady_clock::now();
+
+                // The buffer can only be replaced while we don't hold the lock.
+                auto& buffer = *_buffer;
+                buffer.StartDeferDrawing();
+                auto endDefer = wil::scope_exit([&]() noexcept { buffer.EndDeferDrawing(); });
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    try
+                    {
+                        _Replay(batches.at(i));
+                    }
+                    CATCH_LOG();
+                }
+                endDefer.reset();
+                OutputStatistics::Add(_statistics.lockWait, replayStart - lockStart);
+                OutputStatistics::Add(_statistics.writeTime, std::chrono::steady_clock::now() - replayStart);
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                batches.at(i) = {};
+            }
+
+            {
+                std::lock_guard guard{ _idleMutex };
+                _applied += count;
+            }
+            _idleCondition.notify_all();
+        }
+
+        if (!alive)
+        {
+            break;
+        }
+    }
+}
+
+// Routine Description:
+// - Feeds the recorded actions of a batch into the target engine.
+// Arguments:
+// - batch - the batch to replay
+void OutputPipeline::_Replay(const Batch& batch)
+{
+    const std::wstring_view text{ batch.text };
+
+    for (const auto& op : batch.ops)
+    {
+        const auto string = [&]() { return text.substr(op.offset, op.length); };
+        const auto parameters = [&]() { return VTParameters{ batch.parameters.data() + op.offset, op.length }; };
+
+        switch (op.kind)
+        {
+        case OpKind::Execute:
+            _target.ActionExecute(op.wch);
+            break;
+        case OpKind::ExecuteFromEscape:
+            _target.ActionExecuteFromEscape(op.wch);
+            break;
+        case OpKind::Print:
+            _target.ActionPrint(op.wch);
+            break;
+        case OpKind::PrintString:
+            _target.ActionPrintString(string());
+            break;
+        case OpKind::PassThroughString:
+            _target.ActionPassThroughString(string());
+            break;
+        case OpKind::EscDispatch:
+            _target.ActionEscDispatch(op.id);
+            break;
+        case OpKind::Vt52EscDispatch:
+            _target.ActionVt52EscDispatch(op.id, parameters());
+            break;
+        case OpKind::CsiDispatch:
+            _target.ActionCsiDispatch(op.id, parameters());
+            break;
+        case OpKind::DcsDispatch:
+            _dcsHandler = _target.ActionDcsDispatch(op.id, parameters());
+            break;
+        case OpKind::DcsData:
+            if (_dcsHandler && !_dcsHandler(op.wch))
+            {
+                _dcsHandler = nullptr;
+            }
+            break;
+        case OpKind::OscDispatch:
+            _target.ActionOscDispatch(op.wch, op.parameter, string());
+            break;
+        case OpKind::Ss3Dispatch:
+            _target.ActionSs3Dispatch(op.wch, parameters());
+            break;
+        case OpKind::EndOfString:
+            _target.ActionEndOfString();
+            break;
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- OutputPipeline.hpp
+
+Abstract:
+- Splits the processing of the terminal's output across two threads.
+  The thread calling Write() runs the VT state machine, which records the
+  engine actions it produces into batches of compact operations. Those are
+  sent through a til::spsc channel to an apply thread, which replays them
+  into the terminal's real engine (and thus its dispatch and buffer) while
+  holding the write lock for just the duration of a batch.
+- Since the parser doesn't touch the buffer, parsing the next chunk of output
+  overlaps with applying the previous one and doesn't contend for the lock.
+- The buffer defers its drawing while the batches are applied, so the renderer
+  is told about the changes once for all of them.
+--*/
+
+#pragma once
+
+#include "OutputStatistics.hpp"
+#include "../../buffer/out/textBuffer.hpp"
+#include "../../terminal/parser/StateMachine.hpp"
+#include <til/mutex.h>
+#include <til/spsc.h>
+
+#include <condition_variable>
+
+namespace Microsoft::Terminal::Core
+{
+    class OutputPipeline final
+    {
+    public:
+        OutputPipeline(::Microsoft::Console::VirtualTerminal::IStateMachineEngine& target, til::fair_shared_mutex& writeLock, const std::unique_ptr<TextBuffer>& buffer, OutputStatistics& statistics);
+        ~OutputPipeline();
+
+        OutputPipeline(const OutputPipeline&) = delete;
+        OutputPipeline(OutputPipeline&&) = delete;
+        OutputPipeline& operator=(const OutputPipeline&) = delete;
+        OutputPipeline& operator=(OutputPipeline&&) = delete;
+
+        void Write(const std::wstring_view string);
+        void Write(const std::string_view utf8);
+        void WaitForIdle();
+
+    private:
+        enum class OpKind : uint8_t
+        {
+            Execute,
+            ExecuteFromEscape,
+            Print,
+            PrintString,
+            PassThroughString,
+            EscDispatch,
+            Vt52EscDispatch,
+            CsiDispatch,
+            DcsDispatch,
+            DcsData,
+            OscDispatch,
+            Ss3Dispatch,
+            EndOfString,
+        };
+
+        // Strings and parameters of an operation are stored in its batch, at [offset, offset + length).
+        struct Op
+        {
+            OpKind kind;
+            wchar_t wch;
+            uint64_t id;
+            size_t parameter;
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        struct Batch
+        {
+            std::vector<Op> ops;
+            std::wstring text;
+            std::vector<::Microsoft::Console::VirtualTerminal::VTParameter> parameters;
+        };
+
+        class RecordingEngine;
+
+        void _ApplyLoop(const til::spsc::consumer<Batch>& consumer);
+        void _Replay(const Batch& batch);
+        void _Submit();
+
+        ::Microsoft::Console::VirtualTerminal::IStateMachineEngine& _target;
+        til::fair_shared_mutex& _writeLock;
+        const std::unique_ptr<TextBuffer>& _buffer; // the terminal's, which is replaced when it's resized
+        OutputStatistics& _statistics;
+
+        // Only touched by the writing thread. The state machine owns the recording engine.
+        Batch _batch;
+        std::unique_ptr<::Microsoft::Console::VirtualTerminal::StateMachine> _stateMachine;
+        std::optional<til::spsc::producer<Batch>> _producer;
+        uint64_t _submitted{ 0 };
+
+        // Only touched by the apply thread.
+        ::Microsoft::Console::VirtualTerminal::IStateMachineEngine::StringHandler _dcsHandler;
+
+        std::mutex _idleMutex;
+        std::condition_variable _idleCondition;
+        uint64_t _applied{ 0 };
+
+        std::thread _applyThread;
+    };
+}
@@ -0,0 +1,41 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- OutputStatistics.hpp
+
+Abstract:
+- The totals of the output a terminal has processed so far: how much of it
+  there was and how long it took to parse it, to write it into the buffer and
+  to wait for the write lock before doing so.
+- The counters are only ever added to, from the thread writing the output and
+  the pipeline's apply thread, and read from any other. Rates are computed by
+  whoever samples them, from the difference between two samples.
+--*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+namespace Microsoft::Terminal::Core
+{
+    struct OutputStatistics
+    {
+        std::atomic<uint64_t> characters{ 0 }; // the code units received, UTF-16 or UTF-8
+        std::atomic<int64_t> parseTime{ 0 }; // in nanoseconds, like the others
+        std::atomic<int64_t> writeTime{ 0 };
+        std::atomic<int64_t> lockWait{ 0 };
+
+        static void Add(std::atomic<int64_t>& counter, const std::chrono::steady_clock::duration duration) noexcept
+        {
+            counter.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), std::memory_order_relaxed);
+        }
+
+        static std::chrono::nanoseconds Load(const std::atomic<int64_t>& counter) noexcept
+        {
+            return std::chrono::nanoseconds{ counter.load(std::memory_order_relaxed) };
+        }
+    };
+}
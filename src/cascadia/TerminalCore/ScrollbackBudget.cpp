@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "ScrollbackBudget.hpp"
+#include "Terminal.hpp"
+
+using namespace Microsoft::Terminal::Core;
+
+// Method Description:
+// - Gets the budget shared by all of the terminals in the process.
+ScrollbackBudget& ScrollbackBudget::Instance() noexcept
+{
+    static ScrollbackBudget budget;
+    return budget;
+}
+
+// Method Description:
+// - Sets the number of bytes the buffers of all terminals may use together.
+// Arguments:
+// - bytes - the limit, or 0 for no limit
+// Return Value:
+// - <none>
+void ScrollbackBudget::SetLimit(const size_t bytes) noexcept
+{
+    _limit.store(bytes, std::memory_order_relaxed);
+}
+
+size_t ScrollbackBudget::GetLimit() const noexcept
+{
+    return _limit.load(std::memory_order_relaxed);
+}
+
+// Method Description:
+// - Adds a terminal to the ones sharing the budget.
+//   The terminal must be unregistered before it's destroyed.
+// Arguments:
+// - terminal - the terminal to add
+// Return Value:
+// - <none>
+void ScrollbackBudget::Register(Terminal& terminal)
+{
+    std::lock_guard guard{ _lock };
+    if (std::none_of(_terminals.begin(), _terminals.end(), [&](const auto& entry) { return entry.terminal == &terminal; }))
+    {
+        _terminals.push_back({ &terminal, GetTickCount64(), 0 });
+    }
+}
+
+// Method Description:
+// - Removes a terminal from the ones sharing the budget.
+//   Waits for a running Enforce() to finish with it.
+// Arguments:
+// - terminal - the terminal to remove
+// Return Value:
+// - <none>
+void ScrollbackBudget::Unregister(Terminal& terminal) noexcept
+{
+    std::lock_guard guard{ _lock };
+    const auto it = std::find_if(_terminals.begin(), _terminals.end(), [&](const auto& entry) { return entry.terminal == &terminal; });
+    if (it != _terminals.end())
+    {
+        _terminals.erase(it);
+    }
+}
+
+// Method Description:
+// - Records that the terminal was written to and enforces the budget, if
+//   it wasn't enforced recently. Must be called without holding the
+//   terminal's lock. Skips both if another thread is busy with the budget,
+//   as the output shouldn't wait for it.
+// Arguments:
+// - terminal - the terminal that was written to
+// Return Value:
+// - <none>
+void ScrollbackBudget::NotifyWrite(Terminal& terminal) noexcept
+{
+    if (GetLimit() == 0)
+    {
+        return;
+    }
+
+    std::unique_lock guard{ _lock, std::try_to_lock };
+    if (!guard)
+    {
+        return;
+    }
+
+    const auto now = GetTickCount64();
+    for (auto& entry : _terminals)
+    {
+        if (entry.terminal == &terminal)
+        {
+            entry.lastWrite = now;
+        }
+    }
+
+    if (now - _lastEnforcement >= s_enforcementInterval)
+    {
+        _Enforce(now);
+    }
+}
+
+// Method Description:
+// - Takes memory from the terminals which were idle the longest
+//   until all of them together are within the limit.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ScrollbackBudget::Enforce() noexcept
+{
+    std::lock_guard guard{ _lock };
+    _Enforce(GetTickCount64());
+}
+
+// Method Description:
+// - See Enforce(). The caller must hold _lock.
+// Arguments:
+// - now - the current tick count
+// Return Value:
+// - <none>
+void ScrollbackBudget::_Enforce(const uint64_t now) noexcept
+try
+{
+    _lastEnforcement = now;
+
+    const auto limit = GetLimit();
+    if (limit == 0)
+    {
+        return;
+    }
+
+    size_t total = 0;
+    for (auto& entry : _terminals)
+    {
+        auto lock = entry.terminal->LockForReading();
+        entry.usage = entry.terminal->GetMemoryUsage().Total();
+        total += entry.usage;
+    }
+
+    if (total <= limit)
+    {
+        return;
+    }
+
+    std::stable_sort(_terminals.begin(), _terminals.end(), [](const auto& lhs, const auto& rhs) { return lhs.lastWrite < rhs.lastWrite; });
+
+    // First pack the scrollback of the idle terminals, and only once that
+    // didn't make room for the busy ones, drop the oldest of it.
+    for (const auto dropOldest : { false, true })
+    {
+        for (auto& entry : _terminals)
+        {
+            auto lock = entry.terminal->LockForWriting();
+            entry.terminal->CompactScrollback(dropOldest);
+            const auto usage = entry.terminal->GetMemoryUsage().Total();
+            total = total - entry.usage + usage;
+            entry.usage = usage;
+
+            if (total <= limit)
+            {
+                return;
+            }
+        }
+    }
+}
+CATCH_LOG()
@@ -0,0 +1,56 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ScrollbackBudget.hpp
+
+Abstract:
+- A limit on the memory used by the buffers of all of the terminals in the
+  process, like all of the panes of a window.
+- Terminals register themselves when they're created and report their output.
+  Once in a while, the budget adds up what they use, and if that's over the
+  limit, it takes memory from the terminals which were idle the longest first:
+  their scrollback is packed into cold storage, and if that's not enough,
+  the oldest of it is dropped. A terminal that is written to again goes back
+  to keeping its usual amount of scrollback expanded.
+--*/
+
+#pragma once
+
+namespace Microsoft::Terminal::Core
+{
+    class Terminal;
+
+    class ScrollbackBudget final
+    {
+    public:
+        static ScrollbackBudget& Instance() noexcept;
+
+        void SetLimit(const size_t bytes) noexcept;
+        size_t GetLimit() const noexcept;
+
+        void Register(Terminal& terminal);
+        void Unregister(Terminal& terminal) noexcept;
+        void NotifyWrite(Terminal& terminal) noexcept;
+        void Enforce() noexcept;
+
+    private:
+        struct Entry
+        {
+            Terminal* terminal;
+            uint64_t lastWrite;
+            size_t usage;
+        };
+
+        // Enforce() runs at most this often from NotifyWrite().
+        static constexpr uint64_t s_enforcementInterval = 1000;
+
+        void _Enforce(const uint64_t now) noexcept;
+
+        std::mutex _lock;
+        std::vector<Entry> _terminals;
+        std::atomic<size_t> _limit{ 0 };
+        uint64_t _lastEnforcement{ 0 };
+    };
+}
@@ -5,6 +5,7 @@
 #include "Terminal.hpp"
 #include "../../terminal/parser/OutputStateMachineEngine.hpp"
 #include "TerminalDispatch.hpp"
+#include "ScrollbackBudget.hpp"
 #include "../../inc/unicode.hpp"
 #include "../../inc/DefaultSettings.h"
 #include "../../inc/argb.h"
@@ -20,7 +21,13 @@ using namespace Microsoft::Console::Render;
 using namespace Microsoft::Console::Types;
 using namespace Microsoft::Console::VirtualTerminal;
 
-using PointTree = interval_tree::IntervalTree<til::point, size_t>;
+// The output is parsed in slices of this many code units, with the write lock
+// released in between, so that the renderer and the UI thread never wait for
+// more than one slice to be parsed.
+static constexpr size_t s_writeSliceLength = 4096;
+
+// Pasted text is filtered and written to the connection in chunks of this many characters.
+static constexpr size_t s_pasteChunkLength = 16 * 1024;
 
 static std::wstring _KeyEventsToText(std::deque<std::unique_ptr<IInputEvent>>& inEventsToWrite)
 {
@@ -70,10 +77,16 @@ Terminal::Terminal() :
     };
 
     _terminalInput = std::make_unique<TerminalInput>(passAlongInput);
+    _UpdateInputModes();
 
     _InitializeColorTable();
 }
 
+Terminal::~Terminal()
+{
+    ScrollbackBudget::Instance().Unregister(*this);
+}
+
 void Terminal::Create(COORD viewportSize, SHORT scrollbackLines, IRenderTarget& renderTarget)
 {
     _mutableViewport = Viewport::FromDimensions({ 0, 0 }, viewportSize);
@@ -83,6 +96,10 @@ void Terminal::Create(COORD viewportSize, SHORT scrollbackLines, IRenderTarget&
     const TextAttribute attr{};
     const UINT cursorSize = 12;
     _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, renderTarget);
+    _buffer->SetHotRowCount(viewportSize.Y * _hotScrollbackScreens);
+    // Logs tend to repeat the same lines over and over, which then share their cells.
+    _buffer->ShareColdRows(true);
+    ScrollbackBudget::Instance().Register(*this);
 }
 
 // Method Description:
@@ -96,8 +113,20 @@ void Terminal::CreateFromSettings(ICoreSettings settings,
     const COORD viewportSize{ Utils::ClampToShortMax(settings.InitialCols(), 1),
                               Utils::ClampToShortMax(settings.InitialRows(), 1) };
 
-    // TODO:MSFT:20642297 - Support infinite scrollback here, if HistorySize is -1
-    Create(viewportSize, Utils::ClampToShortMax(settings.HistorySize(), 0), renderTarget);
+    // A negative HistorySize requests an unlimited scrollback. We keep the
+    // default amount of history in memory and archive everything older to disk.
+    const auto historySize = settings.HistorySize();
+    const auto scrollbackLines = historySize < 0 ? DEFAULT_HISTORY_SIZE : historySize;
+    Create(viewportSize, Utils::ClampToShortMax(scrollbackLines, 0), renderTarget);
+
+    if (historySize < 0)
+    {
+        try
+        {
+            _buffer->EnableScrollbackArchive();
+        }
+        CATCH_LOG();
+    }
 
     UpdateSettings(settings);
 }
@@ -119,6 +148,7 @@ void Terminal::UpdateSettings(ICoreSettings settings)
     _trimBlockSelection = settings.TrimBlockSelection();
 
     _terminalInput->ForceDisableWin32InputMode(settings.ForceVTInput());
+    _UpdateInputModes();
 
     if (settings.TabColor() == nullptr)
     {
@@ -179,6 +209,7 @@ void Terminal::UpdateAppearance(const ICoreAppearance& appearance)
     {
         _colorTable.at(i) = til::color{ appearance.GetColorTableEntry(i) };
     }
+    _UpdateResolvedColors();
 
     CursorType cursorShape = CursorType::VerticalBar;
     switch (appearance.CursorShape())
@@ -224,12 +255,46 @@ void Terminal::UpdateAppearance(const ICoreAppearance& appearance)
 //      appropriate HRESULT for failing to resize.
 [[nodiscard]] HRESULT Terminal::UserResize(const COORD viewportSize) noexcept
 {
+    return UserResize(viewportSize, false);
+}
+
+// Method Description:
+// - Resize the terminal as the result of some user interaction.
+// - While the user keeps resizing the window, reflowing a large scrollback
+//   over and over again would make the resize sluggish. With deferScrollback
+//   only the rows of the viewport and a screen above it are reflowed. The
+//   rest of the scrollback is reflowed by FinishPendingReflow.
+// Arguments:
+// - viewportSize: the new size of the viewport, in chars
+// - deferScrollback: whether to defer reflowing most of the scrollback
+// Return Value:
+// - S_OK if we successfully resized the terminal, S_FALSE if there was
+//      nothing to do (the viewportSize is the same as our current size), or an
+//      appropriate HRESULT for failing to resize.
+[[nodiscard]] HRESULT Terminal::UserResize(const COORD viewportSize, const bool deferScrollback) noexcept
+{
+    // Deferring isn't worth it for buffers with less scrollback than this.
+    static constexpr short minDeferredRows = 1000;
+
     const auto oldDimensions = _mutableViewport.Dimensions();
     if (viewportSize == oldDimensions)
     {
         return S_FALSE;
     }
 
+    // The new buffer only has room for the usual scrollback, so the rows
+    // that were paged in from the scrollback archive go back in there.
+    try
+    {
+        _PageOutArchivedRows();
+    }
+    CATCH_RETURN();
+
+    if (!deferScrollback)
+    {
+        RETURN_IF_FAILED(FinishPendingReflow());
+    }
+
     const auto dx = ::base::ClampSub(viewportSize.X, oldDimensions.X);
 
     const auto oldTop = _mutableViewport.Top();
@@ -271,6 +336,8 @@ void Terminal::UpdateAppearance(const ICoreAppearance& appearance)
                                                      _buffer->GetRenderTarget());
 
         newTextBuffer->GetCursor().StartDeferDrawing();
+        newTextBuffer->SetHotRowCount(viewportSize.Y * _hotScrollbackScreens);
+        newTextBuffer->ShareColdRows(true);
 
         // Build a PositionInformation to track the position of both the top of
         // the mutable viewport and the top of the visible viewport in the new
@@ -287,10 +354,22 @@ void Terminal::UpdateAppearance(const ICoreAppearance& appearance)
         oldRows.visibleViewportTop = newVisibleTop;
 
         const std::optional<short> oldViewStart{ oldViewportTop };
-        RETURN_IF_FAILED(TextBuffer::Reflow(*_buffer.get(),
-                                            *newTextBuffer.get(),
-                                            _mutableViewport,
-                                            { oldRows }));
+        const short firstNeededRow = ::base::ClampSub(std::min(oldViewportTop, newVisibleTop), oldDimensions.Y);
+        if (deferScrollback && (firstNeededRow >= minDeferredRows || _buffer->HasPendingReflow()))
+        {
+            RETURN_IF_FAILED(TextBuffer::ReflowDeferred(*_buffer.get(),
+                                                        *newTextBuffer.get(),
+                                                        firstNeededRow,
+                                                        _mutableViewport,
+                                                        { oldRows }));
+        }
+        else
+        {
+            RETURN_IF_FAILED(TextBuffer::Reflow(*_buffer.get(),
+                                                *newTextBuffer.get(),
+                                                _mutableViewport,
+                                                { oldRows }));
+        }
 
         newViewportTop = oldRows.mutableViewportTop;
         newVisibleTop = oldRows.visibleViewportTop;
@@ -403,8 +482,12 @@ void Terminal::UpdateAppearance(const ICoreAppearance& appearance)
 
     _mutableViewport = Viewport::FromDimensions({ 0, proposedTop }, viewportSize);
 
+    newTextBuffer->TakeScrollbackArchive(*_buffer);
     _buffer.swap(newTextBuffer);
 
+    // The rows which weren't reflowed yet will be reflowed from the old buffer.
+    _buffer->AdoptPendingReflowSource(std::move(newTextBuffer));
+
     // GH#3494: Maintain scrollbar position during resize
     // Make sure that we don't scroll past the mutableViewport at the bottom of the buffer
     newVisibleTop = std::min(newVisibleTop, _mutableViewport.Top());
@@ -415,6 +498,9 @@ void Terminal::UpdateAppearance(const ICoreAppearance& appearance)
     // before, and shouldn't be now either.
     _scrollOffset = originalOffsetWasZero ? 0 : static_cast<int>(::base::ClampSub(_mutableViewport.Top(), newVisibleTop));
 
+    // The text was reflowed, so the pattern matches are somewhere else now.
+    ClearPatternTree();
+
     // GH#5029 - make sure to InvalidateAll here, so that we'll paint the entire visible viewport.
     try
     {
@@ -426,29 +512,293 @@ void Terminal::UpdateAppearance(const ICoreAppearance& appearance)
     return S_OK;
 }
 
+// Method Description:
+// - Reflows the rows of the scrollback that a deferred resize left as they
+//   were, see UserResize. The caller should already have acquired a write lock.
+// Return Value:
+// - S_OK if we successfully reflowed the rows, S_FALSE if there was nothing
+//      to do, or an appropriate HRESULT for failing to reflow.
+[[nodiscard]] HRESULT Terminal::FinishPendingReflow() noexcept
+{
+    if (!_buffer->HasPendingReflow())
+    {
+        return S_FALSE;
+    }
+
+    const bool originalOffsetWasZero = _scrollOffset == 0;
+
+    _buffer->GetCursor().StartDeferDrawing();
+    auto endDefer = wil::scope_exit([&]() noexcept { _buffer->GetCursor().EndDeferDrawing(); });
+
+    std::unique_ptr<TextBuffer> newTextBuffer;
+    TextBuffer::PositionInformation rows{ 0 };
+    try
+    {
+        newTextBuffer = std::make_unique<TextBuffer>(_buffer->GetSize().Dimensions(),
+                                                     TextAttribute{},
+                                                     0, // temporarily set size to 0 so it won't render.
+                                                     _buffer->GetRenderTarget());
+
+        newTextBuffer->GetCursor().StartDeferDrawing();
+        newTextBuffer->SetHotRowCount(_mutableViewport.Height() * _hotScrollbackScreens);
+        newTextBuffer->ShareColdRows(true);
+
+        rows.mutableViewportTop = _mutableViewport.Top();
+        rows.visibleViewportTop = ::base::saturated_cast<short>(_VisibleStartIndex());
+        RETURN_IF_FAILED(TextBuffer::FinishReflow(*_buffer.get(),
+                                                  *newTextBuffer.get(),
+                                                  { rows }));
+
+        newTextBuffer->SetCurrentAttributes(_buffer->GetCurrentAttributes());
+    }
+    CATCH_RETURN();
+
+    // Only the rows above the viewport changed, so the viewport moves along
+    // with its rows. It still has to fit into the buffer and hold the cursor.
+    const auto viewportSize = _mutableViewport.Dimensions();
+    const auto cursorY = newTextBuffer->GetCursor().GetPosition().Y;
+    auto newTop = std::clamp<short>(rows.mutableViewportTop, ::base::ClampSub(::base::ClampAdd(cursorY, 1), viewportSize.Y), cursorY);
+    newTop = std::clamp<short>(newTop, 0, std::max<short>(::base::ClampSub(newTextBuffer->GetSize().Height(), viewportSize.Y), 0));
+    _mutableViewport = Viewport::FromDimensions({ 0, newTop }, viewportSize);
+
+    newTextBuffer->TakeScrollbackArchive(*_buffer);
+    _buffer.swap(newTextBuffer);
+
+    const auto newVisibleTop = std::clamp<short>(rows.visibleViewportTop, 0, _mutableViewport.Top());
+    _scrollOffset = originalOffsetWasZero ? 0 : static_cast<int>(::base::ClampSub(_mutableViewport.Top(), newVisibleTop));
+    ClearPatternTree();
+
+    try
+    {
+        _buffer->GetRenderTarget().TriggerRedrawAll();
+    }
+    CATCH_LOG();
+    _NotifyScrollEvent();
+
+    return S_OK;
+}
+
 void Terminal::Write(std::wstring_view stringView)
 {
-    auto lock = LockForWriting();
+    _RestoreScrollback();
+    _outputStatistics.characters.fetch_add(stringView.size(), std::memory_order_relaxed);
+
+    if (_outputPipeline)
+    {
+        _outputPipeline->Write(stringView);
+    }
+    else
+    {
+        _ProcessStringInSlices(stringView);
+    }
+
+    ScrollbackBudget::Instance().NotifyWrite(*this);
+}
+
+// Method Description:
+// - Writes UTF-8 encoded output to the terminal. This avoids transcoding
+//   the escape sequences, which are parsed on the bytes directly.
+// Arguments:
+// - utf8 - the output to parse
+// Return Value:
+// - <none>
+void Terminal::Write(std::string_view utf8)
+{
+    _RestoreScrollback();
+    _outputStatistics.characters.fetch_add(utf8.size(), std::memory_order_relaxed);
+
+    if (_outputPipeline)
+    {
+        _outputPipeline->Write(utf8);
+    }
+    else
+    {
+        _ProcessStringInSlices(utf8);
+    }
+
+    ScrollbackBudget::Instance().NotifyWrite(*this);
+}
+
+// Method Description:
+// - Goes back to keeping the usual number of rows expanded above the cursor,
+//   once the terminal is written to after CompactScrollback.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Terminal::_RestoreScrollback()
+{
+    if (_scrollbackCompacted.exchange(false, std::memory_order_relaxed))
+    {
+        auto lock = LockForWriting();
+        _buffer->SetHotRowCount(_mutableViewport.Height() * _hotScrollbackScreens);
+    }
+}
+
+// Method Description:
+// - Parses the output a slice at a time, taking the write lock for each slice.
+//   The state machine carries partial sequences and (for UTF-8) partial code
+//   points over from one slice to the next, so this is the same as parsing
+//   all of it at once, except for when others get to look at the buffer.
+// - Parsing and writing into the buffer are interleaved here, so all of the
+//   time spent is counted as writing, see OutputStatistics.
+// Arguments:
+// - string - the output to parse
+// Return Value:
+// - <none>
+template<typename T>
+void Terminal::_ProcessStringInSlices(const std::basic_string_view<T> string)
+{
+    size_t offset = 0;
+    do
+    {
+        auto length = std::min(s_writeSliceLength, string.size() - offset);
+        if constexpr (std::is_same_v<T, wchar_t>)
+        {
+            // Don't tear a surrogate pair apart, the halves would be printed separately.
+            if (offset + length < string.size() && (til::at(string, offset + length) & 0xFC00) == 0xDC00)
+            {
+                --length;
+            }
+        }
+
+        const auto lockStart = std::chrono::steady_clock::now();
+        auto lock = LockForWriting();
+        const auto writeStart = std::chrono::steady_clock::now();
+
+        // The changes of the slice are sent to the renderer at once, when it's done.
+        _buffer->StartDeferDrawing();
+        auto endDefer = wil::scope_exit([buffer = _buffer.get()]() noexcept { buffer->EndDeferDrawing(); });
+        _stateMachine->ProcessString(string.substr(offset, length));
+        endDefer.reset();
+
+        OutputStatistics::Add(_outputStatistics.lockWait, writeStart - lockStart);
+        OutputStatistics::Add(_outputStatistics.writeTime, std::chrono::steady_clock::now() - writeStart);
+        offset += length;
+    } while (offset < string.size());
+}
+
+// Method Description:
+// - Enables or disables parsing the output on the writing thread while the
+//   buffer is updated on a separate apply thread. See OutputPipeline.
+// - The pipeline parses with a state machine of its own, so this should be
+//   called between writes that don't split a sequence. It must not be called
+//   while holding the write lock, as disabling waits for the pending output.
+// Arguments:
+// - enabled - whether output should be pipelined
+// Return Value:
+// - <none>
+void Terminal::SetPipelinedOutput(const bool enabled)
+{
+    if (enabled == static_cast<bool>(_outputPipeline))
+    {
+        return;
+    }
 
-    _stateMachine->ProcessString(stringView);
+    _outputPipeline = enabled ? std::make_unique<OutputPipeline>(_stateMachine->Engine(), _readWriteLock, _buffer, _outputStatistics) : nullptr;
 }
 
-void Terminal::WritePastedText(std::wstring_view stringView)
+// Method Description:
+// - Blocks until all output passed to Write() has been applied to the buffer.
+//   This is a no-op unless the output is pipelined.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Terminal::WaitForPendingOutput()
 {
-    auto option = ::Microsoft::Console::Utils::FilterOption::CarriageReturnNewline |
-                  ::Microsoft::Console::Utils::FilterOption::ControlCodes;
+    if (_outputPipeline)
+    {
+        _outputPipeline->WaitForIdle();
+    }
+}
 
-    std::wstring filtered = ::Microsoft::Console::Utils::FilterStringForPaste(stringView, option);
-    if (IsXtermBracketedPasteModeEnabled())
+// Method Description:
+// - Returns the totals of the output processed so far. They can be read
+//   without holding the lock, while the output is being written.
+// Arguments:
+// - <none>
+// Return Value:
+// - The statistics of this terminal's output
+const OutputStatistics& Terminal::GetOutputStatistics() const noexcept
+{
+    return _outputStatistics;
+}
+
+// Method Description:
+// - Filters the pasted text and writes it to the connection, in chunks of at
+//   most s_pasteChunkLength characters, so that the filtered copy of a large
+//   paste never exists as a whole. The write callback may block while the
+//   client doesn't read its input, which makes this wait for it as well.
+// - The paste is bracketed as a whole if the client asked for it, and the
+//   closing bracket is written even if the paste is cancelled.
+// Arguments:
+// - stringView - the text to paste
+// - onProgress - if given, called after each chunk with the number of
+//   characters of stringView written so far. Returning false cancels the rest.
+// Return Value:
+// - false if the paste was cancelled
+bool Terminal::WritePastedText(std::wstring_view stringView, const std::function<bool(const size_t)>& onProgress)
+{
+    if (!_pfnWriteInput)
     {
-        filtered.insert(0, L"\x1b[200~");
-        filtered.append(L"\x1b[201~");
+        return true;
     }
 
-    if (_pfnWriteInput)
+    const auto option = ::Microsoft::Console::Utils::FilterOption::CarriageReturnNewline |
+                        ::Microsoft::Console::Utils::FilterOption::ControlCodes;
+    const auto bracketed = IsXtermBracketedPasteModeEnabled();
+
+    std::wstring chunk;
+    if (bracketed)
     {
-        _pfnWriteInput(filtered);
+        chunk = L"\x1b[200~";
     }
+
+    bool completed = true;
+    size_t offset = 0;
+    while (offset < stringView.size())
+    {
+        auto length = std::min(s_pasteChunkLength, stringView.size() - offset);
+        if (offset + length < stringView.size())
+        {
+            // A CR LF is filtered as one line ending and a surrogate pair is
+            // converted as one code point, so neither may be torn apart.
+            const auto next = til::at(stringView, offset + length);
+            const auto last = til::at(stringView, offset + length - 1);
+            if ((next == L'\n' && last == L'\r') || (next & 0xFC00) == 0xDC00)
+            {
+                ++length;
+            }
+        }
+
+        chunk.append(::Microsoft::Console::Utils::FilterStringForPaste(stringView.substr(offset, length), option));
+        offset += length;
+
+        // The last chunk is written together with the closing bracket below.
+        if (offset < stringView.size())
+        {
+            _pfnWriteInput(chunk);
+            chunk.clear();
+
+            if (onProgress && !onProgress(offset))
+            {
+                completed = false;
+                break;
+            }
+        }
+    }
+
+    if (bracketed)
+    {
+        chunk.append(L"\x1b[201~");
+    }
+    if (!chunk.empty())
+    {
+        _pfnWriteInput(chunk);
+    }
+
+    return completed;
 }
 
 // Method Description:
@@ -464,7 +814,9 @@ void Terminal::TrySnapOnInput()
     if (_snapOnInput && _scrollOffset != 0)
     {
         auto lock = LockForWriting();
+        const auto oldVisibleTop = _VisibleStartIndex();
         _scrollOffset = 0;
+        _ShiftPatterns(_VisibleStartIndex() - oldVisibleTop);
         _NotifyScrollEvent();
     }
 }
@@ -528,9 +880,9 @@ uint16_t Terminal::GetHyperlinkIdAtPosition(const COORD position)
 // - The position
 // Return value:
 // - The interval representing the start and end coordinates
-std::optional<PointTree::interval> Terminal::GetHyperlinkIntervalFromPosition(const COORD position)
+std::optional<PatternSpans::interval> Terminal::GetHyperlinkIntervalFromPosition(const COORD position)
 {
-    const auto results = _patternIntervalTree.findOverlapping(COORD{ position.X + 1, position.Y }, position);
+    const auto results = _patterns.findOverlapping(COORD{ position.X + 1, position.Y }, position);
     if (results.size() > 0)
     {
         for (const auto& result : results)
@@ -569,6 +921,20 @@ bool Terminal::SendKeyEvent(const WORD vkey,
                             const WORD scanCode,
                             const ControlKeyStates states,
                             const bool keyDown)
+{
+    return SendKeyEvent(vkey, scanCode, states, keyDown, nullptr);
+}
+
+// Method Description:
+// - See SendKeyEvent above.
+// - The key event that's given to the TerminalInput is appended to sentEvents
+//   as well, if it's given, so that it can be encoded again with EncodeKeyEvents
+//   the way other terminals would encode it.
+bool Terminal::SendKeyEvent(const WORD vkey,
+                            const WORD scanCode,
+                            const ControlKeyStates states,
+                            const bool keyDown,
+                            std::vector<KeyEvent>* const sentEvents)
 {
     // GH#6423 - don't snap on this key if the key that was pressed was a
     // modifier key. We'll wait for a real keystroke to snap to the bottom.
@@ -636,6 +1002,10 @@ bool Terminal::SendKeyEvent(const WORD vkey,
     }
 
     KeyEvent keyEv{ keyDown, 1, vkey, sc, ch, states.Value() };
+    if (sentEvents)
+    {
+        sentEvents->push_back(keyEv);
+    }
     return _terminalInput->HandleKey(&keyEv);
 }
 
@@ -678,6 +1048,14 @@ bool Terminal::SendMouseEvent(const COORD viewportPos, const unsigned int uiButt
 // - true if we translated the character event, and it should not be processed any further.
 // - false otherwise.
 bool Terminal::SendCharEvent(const wchar_t ch, const WORD scanCode, const ControlKeyStates states)
+{
+    return SendCharEvent(ch, scanCode, states, nullptr);
+}
+
+// Method Description:
+// - See SendCharEvent above. Like SendKeyEvent, the key events that are given
+//   to the TerminalInput are appended to sentEvents as well, if it's given.
+bool Terminal::SendCharEvent(const wchar_t ch, const WORD scanCode, const ControlKeyStates states, std::vector<KeyEvent>* const sentEvents)
 {
     // DON'T manually handle Alt+Space - the system will use this to bring up
     // the system menu for restore, min/maximize, size, move, close.
@@ -702,54 +1080,132 @@ bool Terminal::SendCharEvent(const wchar_t ch, const WORD scanCode, const Contro
     // ignore the keyup.
     KeyEvent keyDown{ true, 1, vkey, scanCode, ch, states.Value() };
     KeyEvent keyUp{ false, 1, vkey, scanCode, ch, states.Value() };
+    if (sentEvents)
+    {
+        sentEvents->push_back(keyDown);
+        sentEvents->push_back(keyUp);
+    }
     const auto handledDown = _terminalInput->HandleKey(&keyDown);
     const auto handledUp = _terminalInput->HandleKey(&keyUp);
     return handledDown || handledUp;
 }
 
 // Method Description:
-// - Invalidates the regions described in the given pattern tree for the rendering purposes
+// - Gets the modes which change how this terminal encodes keys. They're
+//   mirrored whenever they're changed, so that this doesn't need a lock.
+// Return Value:
+// - The input modes of this terminal.
+TerminalInput::Mode Terminal::GetInputModes() const noexcept
+{
+    return _inputModes.load(std::memory_order_relaxed);
+}
+
+void Terminal::_UpdateInputModes() noexcept
+{
+    _inputModes.store(_terminalInput->GetInputModes(), std::memory_order_relaxed);
+}
+
+// Method Description:
+// - Encodes key events, that SendKeyEvent or SendCharEvent gave to their
+//   TerminalInput, the way a terminal with the given input modes would.
+// Arguments:
+// - modes: The input modes of the terminal to encode the events for.
+// - events: The events to encode, in the order they were sent.
+// Return Value:
+// - The text that the terminal would write to its connection.
+std::wstring Terminal::EncodeKeyEvents(const TerminalInput::Mode modes, const gsl::span<const KeyEvent> events)
+{
+    std::wstring text;
+    TerminalInput input{ [&](std::deque<std::unique_ptr<IInputEvent>>& inEventsToWrite) {
+        text.append(_KeyEventsToText(inEventsToWrite));
+    } };
+    input.SetInputModes(modes);
+    for (const auto& event : events)
+    {
+        input.HandleKey(&event);
+    }
+    return text;
+}
+
+// Method Description:
+// - Invalidates the regions of the given pattern matches for the rendering purposes
 // Arguments:
-// - The interval tree containing regions that need to be invalidated
-void Terminal::_InvalidatePatternTree(interval_tree::IntervalTree<til::point, size_t>& tree)
+// - The pattern matches that need to be invalidated
+void Terminal::_InvalidatePatterns(const PatternSpans& patterns)
 {
     const auto vis = _VisibleStartIndex();
-    auto invalidate = [=](const PointTree::interval& interval) {
-        COORD startCoord{ gsl::narrow<SHORT>(interval.start.x()), gsl::narrow<SHORT>(interval.start.y() + vis) };
-        COORD endCoord{ gsl::narrow<SHORT>(interval.stop.x()), gsl::narrow<SHORT>(interval.stop.y() + vis) };
+    auto invalidate = [=](const PatternSpans::interval& interval) {
+        const til::point startCoord{ interval.start.x(), std::max<ptrdiff_t>(interval.start.y() + vis, 0) };
+        const til::point endCoord{ interval.stop.x(), interval.stop.y() + vis };
         _InvalidateFromCoords(startCoord, endCoord);
     };
-    tree.visit_all(invalidate);
+    patterns.visit_all(invalidate);
+}
+
+// Method Description:
+// - Invalidates the pattern intervals that aren't also present in another set of intervals
+// - The intervals are those of a single row, so there are only a few of them.
+// Arguments:
+// - intervals - the intervals to invalidate
+// - except - the intervals that need no invalidation
+void Terminal::_InvalidatePatternIntervals(const gsl::span<const PatternSpans::interval> intervals, const gsl::span<const PatternSpans::interval> except)
+{
+    const auto vis = _VisibleStartIndex();
+    for (const auto& interval : intervals)
+    {
+        if (std::find(except.begin(), except.end(), interval) == except.end())
+        {
+            const til::point startCoord{ interval.start.x(), std::max<ptrdiff_t>(interval.start.y() + vis, 0) };
+            const til::point endCoord{ interval.stop.x(), interval.stop.y() + vis };
+            _InvalidateFromCoords(startCoord, endCoord);
+        }
+    }
+}
+
+// Method Description:
+// - Moves the pattern matches along with the text when the visible region
+//   scrolls, so that they stay valid until they're updated for the rows that
+//   came into view.
+// Arguments:
+// - rows - the number of rows the text moved up in the visible region
+void Terminal::_ShiftPatterns(const int rows)
+{
+    if (rows != 0 && !_patterns.empty())
+    {
+        _patterns.Shift(rows, gsl::narrow_cast<size_t>(_mutableViewport.Height()));
+        _patternGeneration++;
+    }
 }
 
 // Method Description:
 // - Given start and end coords, invalidates all the regions between them
+// - The coords are only narrowed to a SMALL_RECT for the render target.
 // Arguments:
 // - The start and end coords
-void Terminal::_InvalidateFromCoords(const COORD start, const COORD end)
+void Terminal::_InvalidateFromCoords(const til::point start, const til::point end)
 {
-    if (start.Y == end.Y)
+    if (start.y() == end.y())
     {
-        SMALL_RECT region{ start.X, start.Y, end.X, end.Y };
+        const til::rectangle region{ start.x(), start.y(), end.x(), end.y() };
         _buffer->GetRenderTarget().TriggerRedraw(Viewport::FromInclusive(region));
     }
     else
     {
-        const auto rowSize = gsl::narrow<SHORT>(_buffer->GetRowByOffset(0).size());
+        const auto rowSize = gsl::narrow<ptrdiff_t>(_buffer->GetRowByOffset(0).size());
 
         // invalidate the first line
-        SMALL_RECT region{ start.X, start.Y, rowSize - 1, start.Y };
+        til::rectangle region{ start.x(), start.y(), rowSize - 1, start.y() };
         _buffer->GetRenderTarget().TriggerRedraw(Viewport::FromInclusive(region));
 
-        if ((end.Y - start.Y) > 1)
+        if ((end.y() - start.y()) > 1)
         {
             // invalidate the lines in between the first and last line
-            region = til::rectangle(0, start.Y + 1, rowSize - 1, end.Y - 1);
+            region = til::rectangle{ ptrdiff_t{ 0 }, start.y() + 1, rowSize - 1, end.y() - 1 };
             _buffer->GetRenderTarget().TriggerRedraw(Viewport::FromInclusive(region));
         }
 
         // invalidate the last line
-        region = til::rectangle(0, end.Y, end.X, end.Y);
+        region = til::rectangle{ ptrdiff_t{ 0 }, end.y(), end.x(), end.y() };
         _buffer->GetRenderTarget().TriggerRedraw(Viewport::FromInclusive(region));
     }
 }
@@ -867,9 +1323,9 @@ WORD Terminal::_TakeVirtualKeyFromLastKeyEvent(const WORD scanCode) noexcept
 // Return Value:
 // - a shared_lock which can be used to unlock the terminal. The shared_lock
 //      will release this lock when it's destructed.
-[[nodiscard]] std::shared_lock<std::shared_mutex> Terminal::LockForReading()
+[[nodiscard]] std::shared_lock<til::fair_shared_mutex> Terminal::LockForReading()
 {
-    return std::shared_lock<std::shared_mutex>(_readWriteLock);
+    return std::shared_lock<til::fair_shared_mutex>(_readWriteLock);
 }
 
 // Method Description:
@@ -877,9 +1333,19 @@ WORD Terminal::_TakeVirtualKeyFromLastKeyEvent(const WORD scanCode) noexcept
 // Return Value:
 // - a unique_lock which can be used to unlock the terminal. The unique_lock
 //      will release this lock when it's destructed.
-[[nodiscard]] std::unique_lock<std::shared_mutex> Terminal::LockForWriting()
+[[nodiscard]] std::unique_lock<til::fair_shared_mutex> Terminal::LockForWriting()
 {
-    return std::unique_lock<std::shared_mutex>(_readWriteLock);
+    return std::unique_lock<til::fair_shared_mutex>(_readWriteLock);
+}
+
+// Method Description:
+// - Returns how often and how long the readers and the writers of the
+//   terminal had to wait for its lock so far.
+// Return Value:
+// - the totals since the terminal was created
+til::fair_shared_mutex::wait_statistics Terminal::GetLockStatistics() const noexcept
+{
+    return _readWriteLock.statistics();
 }
 
 Viewport Terminal::_GetMutableViewport() const noexcept
@@ -892,6 +1358,85 @@ short Terminal::GetBufferHeight() const noexcept
     return _mutableViewport.BottomExclusive();
 }
 
+// Method Description:
+// - Gets the number of rows that can be scrolled through, which are the rows
+//   of the buffer and above them, the rows of the scrollback archive that
+//   UserScrollViewport pages back into the buffer. See GetScrollOffset.
+// Return Value:
+// - the number of rows
+int Terminal::GetScrollbackHeight() const noexcept
+{
+    return GetBufferHeight() + _GetArchivedRowCount();
+}
+
+// Method Description:
+// - Estimates the memory used by the buffer and the terminal's pattern tree.
+//   The caller must hold the lock for reading.
+// Return Value:
+// - the breakdown, in bytes
+BufferMemoryUsage Terminal::GetMemoryUsage() const noexcept
+{
+    auto usage = _buffer->GetMemoryUsage();
+    usage.patterns += _patterns.GetMemoryUsage();
+    return usage;
+}
+
+// Method Description:
+// - Gives memory back for the ScrollbackBudget, while the terminal is idle.
+//   Packs all of the scrollback above the viewport into cold storage until
+//   the terminal is written to again, and erases the oldest half of the
+//   scrollback if dropOldest is set. Rows the user scrolled to are kept.
+//   The caller must hold the lock for writing.
+// Arguments:
+// - dropOldest - whether to erase the oldest rows as well
+// Return Value:
+// - <none>
+void Terminal::CompactScrollback(const bool dropOldest) noexcept
+try
+{
+    if (_scrollOffset == 0 && !IsSelectionActive())
+    {
+        _PageOutArchivedRows();
+    }
+
+    _buffer->CompactScrollback(_mutableViewport.Height());
+    _scrollbackCompacted.store(true, std::memory_order_relaxed);
+
+    if (dropOldest)
+    {
+        const auto visibleTop = gsl::narrow_cast<size_t>(std::max(_VisibleStartIndex(), 0));
+        const auto rows = std::min(gsl::narrow_cast<size_t>(_mutableViewport.Top()) / 2, visibleTop);
+        _buffer->EraseRows(0, rows, {});
+    }
+}
+CATCH_LOG()
+
+// Method Description:
+// - Packs the rows of the scrollback which went cold into cold storage again,
+//   after going over the scrollback expanded them. Unlike CompactScrollback,
+//   this keeps the hot region as it is. The caller must hold the lock for writing.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Terminal::PackColdRows() noexcept
+{
+    _buffer->PackColdRows();
+}
+
+// Method Description:
+// - Gives back the memory that the buffer is only holding on to in case it's
+//   needed again, once the terminal went idle. The caller must hold the lock
+//   for writing.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Terminal::Trim() noexcept
+{
+    _buffer->Trim();
+}
+
 // ViewStartIndex is also the length of the scrollback
 int Terminal::ViewStartIndex() const noexcept
 {
@@ -932,59 +1477,50 @@ Viewport Terminal::_GetVisibleViewport() const noexcept
 void Terminal::_WriteBuffer(const std::wstring_view& stringView)
 {
     auto& cursor = _buffer->GetCursor();
+    const auto bufferWidth = _buffer->GetSize().Width();
 
     // Defer the cursor drawing while we are iterating the string, for a better performance.
     // We can not waste time displaying a cursor event when we know more text is coming right behind it.
     cursor.StartDeferDrawing();
 
-    for (size_t i = 0; i < stringView.size(); i++)
-    {
-        const auto wch = stringView.at(i);
-        const COORD cursorPosBefore = cursor.GetPosition();
-        COORD proposedCursorPosition = cursorPosBefore;
-
-        // TODO: MSFT 21006766
-        // This is not great but I need it demoable. Fix by making a buffer stream writer.
-        //
-        // If wch is a surrogate character we need to read 2 code units
-        // from the stringView to form a single code point.
-        const auto isSurrogate = wch >= 0xD800 && wch <= 0xDFFF;
-        const auto view = stringView.substr(i, isSurrogate ? 2 : 1);
-        const OutputCellIterator it{ view, _buffer->GetCurrentAttributes() };
-        const auto end = _buffer->Write(it);
-        const auto cellDistance = end.GetCellDistance(it);
+    // The string is written a row at a time: as much of it as fits into the rest
+    // of the cursor's row goes into the buffer in one go, and the cursor is moved
+    // (and the buffer circled, if need be) once for all of it.
+    auto remaining = stringView;
+    while (!remaining.empty())
+    {
+        COORD proposedCursorPosition = cursor.GetPosition();
+
+        // The last run filled its row. The rest of the string starts on the next one.
+        // TODO: GH#780 - This should really be a _deferred_ newline. If
+        // the next character to come in is a newline or a cursor
+        // movement or anything, then we should _not_ wrap this line
+        // here.
+        if (proposedCursorPosition.X >= bufferWidth)
+        {
+            proposedCursorPosition.X = 0;
+            proposedCursorPosition.Y++;
+            _AdjustCursorPosition(proposedCursorPosition);
+            continue;
+        }
+
+        const OutputCellIterator it{ remaining, _buffer->GetCurrentAttributes() };
+        // Filling the last column of the row marks it as wrapped. If the next
+        // character is a newline, Terminal::CursorLineFeed unmarks it again.
+        const auto end = _buffer->WriteLine(it, proposedCursorPosition, true);
         const auto inputDistance = end.GetInputDistance(it);
 
         if (inputDistance > 0)
         {
-            // If "wch" was a surrogate character, we just consumed 2 code units above.
-            // -> Increment "i" by 1 in that case and thus by 2 in total in this iteration.
-            proposedCursorPosition.X += gsl::narrow<SHORT>(cellDistance);
-            i += inputDistance - 1;
+            proposedCursorPosition.X += gsl::narrow<SHORT>(end.GetCellDistance(it));
+            remaining = remaining.substr(inputDistance);
         }
         else
         {
-            // If _WriteBuffer() is called with a consecutive string longer than the viewport/buffer width
-            // the call to _buffer->Write() will refuse to write anything on the current line.
-            // GetInputDistance() thus returns 0, which would in turn cause i to be
-            // decremented by 1 below and force the outer loop to loop forever.
-            // This if() basically behaves as if "\r\n" had been encountered above and retries the write.
-            // With well behaving shells during normal operation this safeguard should normally not be encountered.
+            // A wide glyph doesn't fit into the last column of the row. The row
+            // was padded for it, and it's tried again at the start of the next one.
             proposedCursorPosition.X = 0;
             proposedCursorPosition.Y++;
-
-            // Try the character again.
-            i--;
-
-            // If we write the last cell of the row here, TextBuffer::Write will
-            // mark this line as wrapped for us. If the next character we
-            // process is a newline, the Terminal::CursorLineFeed will unmark
-            // this line as wrapped.
-
-            // TODO: GH#780 - This should really be a _deferred_ newline. If
-            // the next character to come in is a newline or a cursor
-            // movement or anything, then we should _not_ wrap this line
-            // here.
         }
 
         _AdjustCursorPosition(proposedCursorPosition);
@@ -999,6 +1535,7 @@ void Terminal::_AdjustCursorPosition(const COORD proposedPosition)
     auto proposedCursorPosition = proposedPosition;
     auto& cursor = _buffer->GetCursor();
     const Viewport bufferSize = _buffer->GetSize();
+    const auto oldVisibleTop = _VisibleStartIndex();
 
     // If we're about to scroll past the bottom of the buffer, instead cycle the
     // buffer.
@@ -1013,8 +1550,6 @@ void Terminal::_AdjustCursorPosition(const COORD proposedPosition)
             rowsPushedOffTopOfBuffer++;
         }
 
-        // manually erase our pattern intervals since the locations have changed now
-        _patternIntervalTree = {};
     }
 
     // Update Cursor Position
@@ -1054,6 +1589,10 @@ void Terminal::_AdjustCursorPosition(const COORD proposedPosition)
 
         // If the new scroll offset is different, then we'll still want to raise a scroll event
         updatedViewport = updatedViewport || (oldScrollOffset != _scrollOffset);
+
+        // The text in view moved up by the rows that were circled out of the buffer,
+        // less the rows the visible region moved up with it.
+        _ShiftPatterns(rowsPushedOffTopOfBuffer + _VisibleStartIndex() - oldVisibleTop);
     }
 
     // If the viewport moved, then send a scrolling notification.
@@ -1071,20 +1610,88 @@ void Terminal::_AdjustCursorPosition(const COORD proposedPosition)
         _buffer->GetRenderTarget().TriggerScroll(&delta);
     }
 
+    _NoteInputEcho();
     _NotifyTerminalCursorPositionChanged();
 }
 
+// Method Description:
+// - Notes that a keystroke was sent to the connection. The next time the output
+//   moves the cursor, that's taken to be its echo, and the renderer reports how
+//   long it took from the keystroke until the frame with the echo was presented.
+// - This doesn't need the write lock, as it's called while sending the key.
+// Arguments:
+// - time - when the keystroke was received
+// Return Value:
+// - <none>
+void Terminal::NoteInput(const std::chrono::steady_clock::time_point time) noexcept
+{
+    const std::lock_guard guard{ _pendingInputLock };
+    _pendingInput.sequence++;
+    _pendingInput.time = time;
+    _inputPending.store(true, std::memory_order_relaxed);
+}
+
+// Method Description:
+// - Takes the keystroke that was sent last as the one the cursor moved for, if
+//   the cursor didn't move since it was sent. INVARIANT: the caller holds the write lock.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Terminal::_NoteInputEcho() noexcept
+{
+    if (_inputPending.load(std::memory_order_relaxed))
+    {
+        const std::lock_guard guard{ _pendingInputLock };
+        _inputEcho = _pendingInput;
+        _inputPending.store(false, std::memory_order_relaxed);
+    }
+}
+
 void Terminal::UserScrollViewport(const int viewTop)
 {
     // we're going to modify state here that the renderer could be reading.
     auto lock = LockForWriting();
 
-    const auto clampedNewTop = std::max(0, viewTop);
+    // The scroll position counts the rows of the scrollback archive above the
+    // buffer as well. Once they're scrolled to, they're moved back into the
+    // buffer a page at a time, which moves the viewport down by as many rows.
+    const auto archived = _GetArchivedRowCount();
+    if (viewTop < archived)
+    {
+        LOG_IF_FAILED(FinishPendingReflow());
+        try
+        {
+            _PageInArchivedRows(gsl::narrow_cast<size_t>(std::max(archived - std::max(0, viewTop), _archivePageRows)));
+        }
+        CATCH_LOG();
+    }
+
+    const auto clampedNewTop = std::max(0, viewTop - _GetArchivedRowCount());
+
+    // Rows that a resize left as they were are reflowed before they're scrolled into view.
+    if (clampedNewTop < _buffer->GetPendingReflowRowCount())
+    {
+        LOG_IF_FAILED(FinishPendingReflow());
+    }
+
     const auto realTop = ViewStartIndex();
     const auto newDelta = realTop - clampedNewTop;
     // if viewTop > realTop, we want the offset to be 0.
 
+    const auto oldVisibleTop = _VisibleStartIndex();
     _scrollOffset = std::max(0, newDelta);
+    _ShiftPatterns(_VisibleStartIndex() - oldVisibleTop);
+
+    // Back at the bottom, the rows paged in from the archive aren't needed anymore.
+    if (_scrollOffset == 0 && !IsSelectionActive())
+    {
+        try
+        {
+            _PageOutArchivedRows();
+        }
+        CATCH_LOG();
+    }
 
     // We can use the void variant of TriggerScroll here because
     // we adjusted the viewport so it can detect the difference
@@ -1092,9 +1699,190 @@ void Terminal::UserScrollViewport(const int viewTop)
     _buffer->GetRenderTarget().TriggerScroll();
 }
 
+// Method Description:
+// - Gets the number of rows of the scrollback archive above the buffer that
+//   can be scrolled to, see TextBuffer::GetArchivedRowCount.
+// Return Value:
+// - the number of rows
+int Terminal::_GetArchivedRowCount() const noexcept
+{
+    return gsl::narrow_cast<int>(_buffer->GetArchivedRowCount());
+}
+
+// Method Description:
+// - Moves the newest rows of the scrollback archive back into the buffer, above
+//   its first row. The viewport and the selection move down with the rows that
+//   were already in the buffer, so the same rows stay in view.
+//   The caller must hold the lock for writing.
+// Arguments:
+// - count - the number of rows to move into the buffer
+// Return Value:
+// - the number of rows that were moved
+size_t Terminal::_PageInArchivedRows(const size_t count)
+{
+    const auto rows = _buffer->PageInArchivedRows(count);
+    if (rows != 0)
+    {
+        const auto delta = gsl::narrow_cast<short>(rows);
+        _mutableViewport = Viewport::FromDimensions({ 0, ::base::ClampAdd(_mutableViewport.Top(), delta) },
+                                                    _mutableViewport.Dimensions());
+        _ShiftSelection(delta);
+        ClearPatternTree();
+        _buffer->GetRenderTarget().TriggerRedrawAll();
+    }
+    return rows;
+}
+
+// Method Description:
+// - Moves the rows that _PageInArchivedRows moved into the buffer back into
+//   the scrollback archive, as long as they're above the viewport. The viewport
+//   and the selection move up with the rest of the rows.
+//   The caller must hold the lock for writing.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Terminal::_PageOutArchivedRows()
+{
+    const auto rows = _buffer->PageOutRows(gsl::narrow_cast<size_t>(_mutableViewport.Top()));
+    if (rows != 0)
+    {
+        const auto delta = gsl::narrow_cast<short>(rows);
+        _mutableViewport = Viewport::FromDimensions({ 0, ::base::ClampSub(_mutableViewport.Top(), delta) },
+                                                    _mutableViewport.Dimensions());
+        _scrollOffset = std::min(_scrollOffset, ViewStartIndex());
+        _ShiftSelection(-delta);
+        ClearPatternTree();
+        _buffer->GetRenderTarget().TriggerRedrawAll();
+    }
+}
+
+// Method Description:
+// - Moves the selection along with the rows of the buffer, when rows were added
+//   or removed above them. The selection can't go above the top of the buffer.
+// Arguments:
+// - rows - the number of rows to move the selection down by, or up if negative
+// Return Value:
+// - <none>
+void Terminal::_ShiftSelection(const short rows) noexcept
+{
+    if (_selection.has_value())
+    {
+        for (auto anchor : { &_selection->start, &_selection->end, &_selection->pivot })
+        {
+            anchor->Y = std::max<short>(::base::ClampAdd(anchor->Y, rows), 0);
+        }
+    }
+}
+
+// Method Description:
+// - Moves the rows of the scrollback archive back into the buffer, down to the
+//   newest one that contains the given text, for a search going up past the top
+//   of the buffer. The caller must hold the lock for writing.
+// Arguments:
+// - text - the text to find
+// - caseSensitive - whether the case of the text has to match
+// Return Value:
+// - the row of the buffer that the text is in, if it was found
+std::optional<short> Terminal::PageInArchivedText(const std::wstring_view text, const bool caseSensitive)
+{
+    const auto archive = _buffer->GetScrollbackArchive();
+    if (!archive || text.empty())
+    {
+        return std::nullopt;
+    }
+
+    // Rows that a resize left as they were have to be reflowed before any can be paged in.
+    if (FAILED_LOG(FinishPendingReflow()))
+    {
+        return std::nullopt;
+    }
+
+    const auto first = archive->size() - _buffer->GetArchivedRowCount();
+    const auto found = archive->FindBackward(text, caseSensitive, first);
+    if (!found.has_value())
+    {
+        return std::nullopt;
+    }
+
+    // The row with the text becomes the first row of the buffer.
+    const auto rows = archive->size() - *found;
+    if (_PageInArchivedRows(rows) != rows)
+    {
+        return std::nullopt;
+    }
+    _NotifyScrollEvent();
+    return short{ 0 };
+}
+
+// Method Description:
+// - Scrolls the viewport to the closest prompt above or below its top, as
+//   marked by the shell with FTCS (OSC 133) sequences.
+// Arguments:
+// - next - true to scroll to the prompt below the top of the viewport,
+//   false to scroll to the prompt above it
+// Return Value:
+// - true if there was a prompt to scroll to
+bool Terminal::ScrollToPrompt(const bool next)
+{
+    auto lock = LockForWriting();
+
+    // The marks of rows that a resize left as they were are only placed once they're reflowed.
+    LOG_IF_FAILED(FinishPendingReflow());
+
+    const auto top = gsl::narrow<short>(_VisibleStartIndex());
+    const auto row = next ? _buffer->FindPromptMarkAfter(top, PromptMarkKind::Prompt) :
+                            _buffer->FindPromptMarkBefore(top, PromptMarkKind::Prompt);
+    if (!row.has_value())
+    {
+        return false;
+    }
+
+    const auto oldVisibleTop = _VisibleStartIndex();
+    _scrollOffset = std::max(0, ViewStartIndex() - *row);
+    _ShiftPatterns(_VisibleStartIndex() - oldVisibleTop);
+
+    _buffer->GetRenderTarget().TriggerScroll();
+    _NotifyScrollEvent();
+    return true;
+}
+
+// Method Description:
+// - Selects the output of the last command that finished, from the row the
+//   shell marked as the start of its output up to the end of the row above
+//   the one marked as where it finished.
+// Return Value:
+// - true if there was any output to select
+bool Terminal::SelectLastCommandOutput()
+{
+    auto lock = LockForWriting();
+
+    LOG_IF_FAILED(FinishPendingReflow());
+
+    const auto cursorRow = _buffer->GetCursor().GetPosition().Y;
+    const auto finished = _buffer->FindPromptMarkBefore(cursorRow + 1, PromptMarkKind::Finished);
+    if (!finished.has_value())
+    {
+        return false;
+    }
+
+    // A command without any output is marked as finished on the row its output would've started.
+    const auto output = _buffer->FindPromptMarkBefore(*finished + 1, PromptMarkKind::Output);
+    if (!output.has_value() || *output >= *finished)
+    {
+        return false;
+    }
+
+    const COORD start{ 0, *output };
+    const COORD end{ _buffer->GetSize().RightInclusive(), gsl::narrow_cast<short>(*finished - 1) };
+    _blockSelection = false;
+    SelectNewRegion(start, end);
+    return true;
+}
+
 int Terminal::GetScrollOffset() noexcept
 {
-    return _VisibleStartIndex();
+    return _GetArchivedRowCount() + _VisibleStartIndex();
 }
 
 void Terminal::_NotifyScrollEvent() noexcept
@@ -1103,9 +1891,9 @@ try
     if (_pfnScrollPositionChanged)
     {
         const auto visible = _GetVisibleViewport();
-        const auto top = visible.Top();
+        const auto top = _GetArchivedRowCount() + visible.Top();
         const auto height = visible.Height();
-        const auto bottom = this->GetBufferHeight();
+        const auto bottom = GetScrollbackHeight();
         _pfnScrollPositionChanged(top, height, bottom);
     }
 }
@@ -1187,6 +1975,7 @@ try
     Utils::InitializeCampbellColorTable(tableView);
     // Then make sure all the values have an alpha of 255
     Utils::SetColorTableAlpha(tableView, 0xff);
+    _UpdateResolvedColors();
 }
 CATCH_LOG()
 
@@ -1216,22 +2005,91 @@ bool Terminal::IsCursorBlinkingAllowed() const noexcept
 //   region changes (for example by text entering the buffer or scrolling)
 // - INVARIANT: this function can only be called if the caller has the writing lock on the terminal
 void Terminal::UpdatePatternsUnderLock() noexcept
+try
 {
-    auto oldTree = _patternIntervalTree;
-    _patternIntervalTree = _buffer->GetPatterns(_VisibleStartIndex(), _VisibleEndIndex());
-    _InvalidatePatternTree(oldTree);
-    _InvalidatePatternTree(_patternIntervalTree);
+    auto oldPatterns = std::exchange(_patterns, _buffer->GetPatterns(_VisibleStartIndex(), _VisibleEndIndex()));
+    _patternGeneration++;
+
+    // Most updates leave the majority of the matches where they were, so only
+    // redraw the ones that appeared or disappeared, comparing a row at a time.
+    const auto rows = std::max(oldPatterns.RowCount(), _patterns.RowCount());
+    for (size_t y = 0; y < rows; ++y)
+    {
+        const auto oldRow = oldPatterns.GetRow(y);
+        const auto newRow = _patterns.GetRow(y);
+        if (!std::equal(oldRow.begin(), oldRow.end(), newRow.begin(), newRow.end()))
+        {
+            _InvalidatePatternIntervals(oldRow, newRow);
+            _InvalidatePatternIntervals(newRow, oldRow);
+        }
+    }
 }
+CATCH_LOG()
 
 // Method Description:
 // - Clears and invalidates the interval pattern tree
 // - This is called to prevent the renderer from rendering patterns while the
 //   visible region is changing
 void Terminal::ClearPatternTree() noexcept
+try
+{
+    const auto oldPatterns = std::exchange(_patterns, {});
+    _patternGeneration++;
+    _InvalidatePatterns(oldPatterns);
+}
+CATCH_LOG()
+
+// Method Description:
+// - Sets the search matches the renderer highlights, replacing the previous ones.
+// Arguments:
+// - highlights: the matches, in the order they're in the buffer
+// Return Value:
+// - <none>
+void Terminal::SetSearchHighlights(std::vector<SearchHighlight> highlights) noexcept
+{
+    _searchHighlights = std::move(highlights);
+}
+
+// Method Description:
+// - Tells where the search matches and the prompts are, for the scrollbar to show.
+//   The rows of the buffer are split into the given number of bins (one per pixel
+//   of the scrollbar), and each bin is looked up in the sorted matches and marks.
+// - Both of them count their rows from the top of everything that was ever in the
+//   buffer, so nothing has to be updated while the buffer circles, and it takes the
+//   same time, no matter how many matches and prompts there are.
+// Arguments:
+// - bins: the number of bins
+// Return Value:
+// - per bin, a combination of ScrollMarkSearch and ScrollMarkPrompt
+std::vector<uint8_t> Terminal::GetScrollMarks(const size_t bins) const
 {
-    auto oldTree = _patternIntervalTree;
-    _patternIntervalTree = {};
-    _InvalidatePatternTree(oldTree);
+    std::vector<uint8_t> marks(bins);
+    // The bins cover the rows of the archive that can be scrolled to as well.
+    const auto archived = gsl::narrow_cast<uint64_t>(_GetArchivedRowCount());
+    const auto rows = gsl::narrow_cast<uint64_t>(std::max(GetScrollbackHeight(), 1));
+    const auto top = _buffer->GetCircledRows() - std::min(_buffer->GetCircledRows(), archived);
+    const auto& prompts = _buffer->GetPromptMarks();
+
+    auto match = _searchHighlights.cbegin();
+    for (size_t i = 0; i < bins; ++i)
+    {
+        // With fewer rows than bins, every row gets at least one bin.
+        const auto begin = top + i * rows / bins;
+        const auto end = std::max(top + (i + 1) * rows / bins, begin + 1);
+
+        match = std::lower_bound(match, _searchHighlights.cend(), begin, [](const SearchHighlight& highlight, const uint64_t row) {
+            return highlight.startRow < row;
+        });
+        if (match != _searchHighlights.cend() && match->startRow < end)
+        {
+            til::at(marks, i) |= ScrollMarkSearch;
+        }
+        if (prompts.Contains(begin, end, PromptMarkKind::Prompt))
+        {
+            til::at(marks, i) |= ScrollMarkPrompt;
+        }
+    }
+    return marks;
 }
 
 // Method Description:
@@ -16,6 +16,10 @@
 #include "../../types/IUiaData.h"
 #include "../../cascadia/terminalcore/ITerminalApi.hpp"
 #include "../../cascadia/terminalcore/ITerminalInput.hpp"
+#include "../../cascadia/terminalcore/OutputPipeline.hpp"
+#include "../../cascadia/terminalcore/OutputStatistics.hpp"
+
+#include <til/mutex.h>
 
 static constexpr std::wstring_view linkPattern{ LR"(\b(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|$!:,.;]*[A-Za-z0-9+&@#/%=~_|$])" };
 static constexpr size_t TaskbarMinProgress{ 10 };
@@ -53,7 +57,7 @@ class Microsoft::Terminal::Core::Terminal final :
 {
 public:
     Terminal();
-    ~Terminal(){};
+    ~Terminal();
     Terminal(const Terminal&) = default;
     Terminal(Terminal&&) = default;
     Terminal& operator=(const Terminal&) = default;
@@ -71,14 +75,25 @@ public:
 
     // Write goes through the parser
     void Write(std::wstring_view stringView);
+    void Write(std::string_view utf8);
+
+    void SetPipelinedOutput(const bool enabled);
+    void WaitForPendingOutput();
+    const OutputStatistics& GetOutputStatistics() const noexcept;
 
     // WritePastedText goes directly to the connection
-    void WritePastedText(std::wstring_view stringView);
+    bool WritePastedText(std::wstring_view stringView, const std::function<bool(const size_t)>& onProgress = nullptr);
 
-    [[nodiscard]] std::shared_lock<std::shared_mutex> LockForReading();
-    [[nodiscard]] std::unique_lock<std::shared_mutex> LockForWriting();
+    [[nodiscard]] std::shared_lock<til::fair_shared_mutex> LockForReading();
+    [[nodiscard]] std::unique_lock<til::fair_shared_mutex> LockForWriting();
+    til::fair_shared_mutex::wait_statistics GetLockStatistics() const noexcept;
 
     short GetBufferHeight() const noexcept;
+    int GetScrollbackHeight() const noexcept;
+    BufferMemoryUsage GetMemoryUsage() const noexcept;
+    void CompactScrollback(const bool dropOldest) noexcept;
+    void PackColdRows() noexcept;
+    void Trim() noexcept;
 
     int ViewStartIndex() const noexcept;
     int ViewEndIndex() const noexcept;
@@ -120,6 +135,7 @@ public:
     bool EnableAlternateScrollMode(const bool enabled) noexcept override;
     bool EnableXtermBracketedPasteMode(const bool enabled) noexcept override;
     bool IsXtermBracketedPasteModeEnabled() const noexcept override;
+    bool EnableSynchronizedOutput(const bool enabled) noexcept override;
 
     bool IsVtInputEnabled() const noexcept override;
 
@@ -132,6 +148,10 @@ public:
     bool SetWorkingDirectory(std::wstring_view uri) noexcept override;
     std::wstring_view GetWorkingDirectory() noexcept override;
 
+    bool AddPromptMark(const PromptMarkKind kind) noexcept override;
+
+    ::Microsoft::Console::VirtualTerminal::ITermDispatch::StringHandler DefineSixelImage(const bool transparentBackground) noexcept override;
+
     bool PushGraphicsRendition(const ::Microsoft::Console::VirtualTerminal::VTParameters options) noexcept override;
     bool PopGraphicsRendition() noexcept override;
 
@@ -143,16 +163,27 @@ public:
     bool SendMouseEvent(const COORD viewportPos, const unsigned int uiButton, const ControlKeyStates states, const short wheelDelta, const Microsoft::Console::VirtualTerminal::TerminalInput::MouseButtonState state) override;
     bool SendCharEvent(const wchar_t ch, const WORD scanCode, const ControlKeyStates states) override;
 
+    bool SendKeyEvent(const WORD vkey, const WORD scanCode, const ControlKeyStates states, const bool keyDown, std::vector<KeyEvent>* const sentEvents);
+    bool SendCharEvent(const wchar_t ch, const WORD scanCode, const ControlKeyStates states, std::vector<KeyEvent>* const sentEvents);
+    ::Microsoft::Console::VirtualTerminal::TerminalInput::Mode GetInputModes() const noexcept;
+    static std::wstring EncodeKeyEvents(const ::Microsoft::Console::VirtualTerminal::TerminalInput::Mode modes, const gsl::span<const KeyEvent> events);
+
     [[nodiscard]] HRESULT UserResize(const COORD viewportSize) noexcept override;
+    [[nodiscard]] HRESULT UserResize(const COORD viewportSize, const bool deferScrollback) noexcept;
+    [[nodiscard]] HRESULT FinishPendingReflow() noexcept;
     void UserScrollViewport(const int viewTop) override;
     int GetScrollOffset() noexcept override;
+    bool ScrollToPrompt(const bool next);
+    bool SelectLastCommandOutput();
+    std::optional<short> PageInArchivedText(const std::wstring_view text, const bool caseSensitive);
 
     void TrySnapOnInput() override;
     bool IsTrackingMouseInput() const noexcept;
+    void NoteInput(const std::chrono::steady_clock::time_point time) noexcept;
 
     std::wstring GetHyperlinkAtPosition(const COORD position);
     uint16_t GetHyperlinkIdAtPosition(const COORD position);
-    std::optional<interval_tree::IntervalTree<til::point, size_t>::interval> GetHyperlinkIntervalFromPosition(const COORD position);
+    std::optional<PatternSpans::interval> GetHyperlinkIntervalFromPosition(const COORD position);
 #pragma endregion
 
 #pragma region IBaseData(base to IRenderData and IUiaData)
@@ -183,6 +214,11 @@ public:
     const std::wstring GetHyperlinkUri(uint16_t id) const noexcept override;
     const std::wstring GetHyperlinkCustomId(uint16_t id) const noexcept override;
     const std::vector<size_t> GetPatternId(const COORD location) const noexcept override;
+    uint64_t GetPatternGeneration() const noexcept override;
+    std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlights() const noexcept override;
+    Microsoft::Console::Render::InputEcho GetInputEcho() const noexcept override;
+    void LockConsoleShared() noexcept override;
+    void UnlockConsoleShared() noexcept override;
 #pragma endregion
 
 #pragma region IUiaData
@@ -213,6 +249,23 @@ public:
     void UpdatePatternsUnderLock() noexcept;
     void ClearPatternTree() noexcept;
 
+    // A search match, with its rows counted from the top of everything that was
+    // ever in the buffer (see TextBuffer::GetCircledRows), so that it stays on its
+    // text while the buffer circles.
+    struct SearchHighlight
+    {
+        uint64_t startRow;
+        uint64_t endRow;
+        SHORT startColumn;
+        SHORT endColumn;
+    };
+    void SetSearchHighlights(std::vector<SearchHighlight> highlights) noexcept;
+
+    // The flags of a bin of GetScrollMarks.
+    static constexpr uint8_t ScrollMarkSearch = 0x1;
+    static constexpr uint8_t ScrollMarkPrompt = 0x2;
+    std::vector<uint8_t> GetScrollMarks(const size_t bins) const;
+
     const std::optional<til::color> GetTabColor() const noexcept;
     til::color GetDefaultBackground() const noexcept;
 
@@ -235,6 +288,7 @@ public:
     void SetBlockSelection(const bool isEnabled) noexcept;
 
     const TextBuffer::TextAndColor RetrieveSelectedTextFromBuffer(bool trimTrailingWhitespace);
+    TextBuffer::ExportedText ExportSelectedText(bool singleLine, TextBuffer::RichTextFormats richText);
 #pragma endregion
 
 private:
@@ -250,6 +304,9 @@ private:
 
     std::unique_ptr<::Microsoft::Console::VirtualTerminal::StateMachine> _stateMachine;
     std::unique_ptr<::Microsoft::Console::VirtualTerminal::TerminalInput> _terminalInput;
+    // The modes of _terminalInput, so that they can be read without a lock, see GetInputModes.
+    std::atomic<::Microsoft::Console::VirtualTerminal::TerminalInput::Mode> _inputModes;
+    void _UpdateInputModes() noexcept;
 
     std::optional<std::wstring> _title;
     std::wstring _startingTitle;
@@ -264,6 +321,12 @@ private:
     bool _screenReversed;
     mutable Microsoft::Console::Render::BlinkingState _blinkingState;
 
+    // The default foreground of intense text, which is the bright version of the
+    // default foreground if that's one of the dark colors of the table. It's worked
+    // out by _UpdateResolvedColors whenever the default colors or the color table
+    // change, rather than for every run of text that's drawn.
+    COLORREF _defaultIntenseFg{};
+
     bool _snapOnInput;
     bool _altGrAliasing;
     bool _suppressApplicationTitle;
@@ -289,11 +352,25 @@ private:
     };
     std::optional<SelectionAnchors> _selection;
     bool _blockSelection;
+
+    // The rectangles of the last selection, to be reused while the buffer
+    // doesn't change and updated in part while only the end of the selection moves.
+    struct SelectionRectsCache
+    {
+        const TextBuffer* buffer{ nullptr };
+        uint64_t generation{ 0 };
+        COORD start{};
+        COORD end{};
+        bool blockSelection{ false };
+        std::vector<SMALL_RECT> rects;
+    };
+    mutable SelectionRectsCache _selectionRectsCache;
     std::wstring _wordDelimiters;
     SelectionExpansionMode _multiClickSelectionMode;
 #pragma endregion
 
-    std::shared_mutex _readWriteLock;
+    // Phase-fair, so that the readers (the UI and the renderer) aren't starved by the output.
+    mutable til::fair_shared_mutex _readWriteLock;
 
     // TODO: These members are not shared by an alt-buffer. They should be
     //      encapsulated, such that a Terminal can have both a main and alt buffer.
@@ -301,6 +378,21 @@ private:
     Microsoft::Console::Types::Viewport _mutableViewport;
     SHORT _scrollbackLines;
 
+    // Scrollback more than this many screens above the cursor is packed into
+    // cold storage by the TextBuffer. See TextBuffer::SetHotRowCount.
+    static constexpr size_t _hotScrollbackScreens = 4;
+    // Set by CompactScrollback, until the next write restores the hot region.
+    std::atomic<bool> _scrollbackCompacted{ false };
+    void _RestoreScrollback();
+
+    // Scrolling up past the top of the buffer pages in the rows of the
+    // scrollback archive, at least this many at a time. See UserScrollViewport.
+    static constexpr int _archivePageRows = 1024;
+    int _GetArchivedRowCount() const noexcept;
+    size_t _PageInArchivedRows(const size_t count);
+    void _PageOutArchivedRows();
+    void _ShiftSelection(const short rows) noexcept;
+
     // _scrollOffset is the number of lines above the viewport that are currently visible
     // If _scrollOffset is 0, then the visible region of the buffer is the viewport.
     int _scrollOffset;
@@ -317,9 +409,23 @@ private:
     //      underneath them, while others would prefer to anchor it in place.
     //      Either way, we should make this behavior controlled by a setting.
 
-    interval_tree::IntervalTree<til::point, size_t> _patternIntervalTree;
-    void _InvalidatePatternTree(interval_tree::IntervalTree<til::point, size_t>& tree);
-    void _InvalidateFromCoords(const COORD start, const COORD end);
+    PatternSpans _patterns;
+    uint64_t _patternGeneration{ 0 }; // incremented whenever _patterns changes
+
+    // The last keystroke sent to the connection, which is noted without holding the
+    // write lock, and the last one whose echo moved the cursor. See NoteInput.
+    std::mutex _pendingInputLock;
+    Microsoft::Console::Render::InputEcho _pendingInput;
+    std::atomic<bool> _inputPending{ false };
+    Microsoft::Console::Render::InputEcho _inputEcho;
+    void _NoteInputEcho() noexcept;
+
+    std::vector<SearchHighlight> _searchHighlights; // sorted, and they don't overlap
+    void _InvalidatePatterns(const PatternSpans& patterns);
+    void _InvalidatePatternIntervals(const gsl::span<const PatternSpans::interval> intervals,
+                                     const gsl::span<const PatternSpans::interval> except);
+    void _ShiftPatterns(const int rows);
+    void _InvalidateFromCoords(const til::point start, const til::point end);
 
     // Since virtual keys are non-zero, you assume that this field is empty/invalid if it is.
     struct KeyEventCodes
@@ -344,9 +450,13 @@ private:
     Microsoft::Console::Types::Viewport _GetVisibleViewport() const noexcept;
 
     void _InitializeColorTable();
+    void _UpdateResolvedColors() noexcept;
 
     void _WriteBuffer(const std::wstring_view& stringView);
 
+    template<typename T>
+    void _ProcessStringInSlices(const std::basic_string_view<T> string);
+
     void _AdjustCursorPosition(const COORD proposedPosition);
 
     void _NotifyScrollEvent() noexcept;
@@ -356,6 +466,7 @@ private:
 #pragma region TextSelection
     // These methods are defined in TerminalSelection.cpp
     std::vector<SMALL_RECT> _GetSelectionRects() const noexcept;
+    void _UpdateSelectionRects() const;
     std::pair<COORD, COORD> _PivotSelection(const COORD targetPos, bool& targetStart) const;
     std::pair<COORD, COORD> _ExpandSelectionAnchors(std::pair<COORD, COORD> anchors) const;
     COORD _ConvertToBufferCell(const COORD viewportPos) const;
@@ -363,6 +474,13 @@ private:
 
     Microsoft::Console::VirtualTerminal::SgrStack _sgrStack;
 
+    // Added to by Write() and the pipeline's apply thread, so it has to outlive the pipeline.
+    OutputStatistics _outputStatistics;
+
+    // When set, Write() only parses and the buffer is updated by the pipeline's apply thread.
+    // This is declared last, so that the apply thread is stopped before anything it uses is destroyed.
+    std::unique_ptr<OutputPipeline> _outputPipeline;
+
 #ifdef UNIT_TESTING
     friend class TerminalCoreUnitTests::TerminalBufferTests;
     friend class TerminalCoreUnitTests::TerminalApiTest;
@@ -4,6 +4,8 @@
 #include "pch.h"
 #include "Terminal.hpp"
 #include "../src/inc/unicode.hpp"
+#include "../../buffer/out/SixelDecoder.hpp"
+#include "../../terminal/parser/ascii.hpp"
 
 using namespace Microsoft::Terminal::Core;
 using namespace Microsoft::Console::Types;
@@ -258,6 +260,12 @@ try
         return false;
     }
 
+    // Erasing the whole row is left to the row, which clears its cells once it's looked at again.
+    if (startPos.X == 0 && nlength >= gsl::narrow_cast<DWORD>(_buffer->GetSize().Width()))
+    {
+        return _buffer->EraseRows(startPos.Y, startPos.Y + 1, _buffer->GetCurrentAttributes());
+    }
+
     const auto eraseIter = OutputCellIterator(UNICODE_SPACE, _buffer->GetCurrentAttributes(), nlength);
 
     // Explicitly turn off end-of-line wrap-flag-setting when erasing cells.
@@ -315,6 +323,11 @@ try
     }
     else if (eraseType == DispatchTypes::EraseType::Scrollback)
     {
+        // The rows that a resize left for later are about to be erased anyways,
+        // and so are the rows that scrolled out into the archive.
+        _buffer->DiscardPendingReflow();
+        _buffer->ClearScrollbackArchive();
+
         // We only want to erase the scrollback, and leave everything else on the screen as it is
         // so we grab the text in the viewport and rotate it up to the top of the buffer
         COORD scrollFromPos{ 0, 0 };
@@ -325,9 +338,10 @@ try
         // and we have to make sure we erase that text
         const auto eraseStart = _mutableViewport.Height();
         const auto eraseEnd = _buffer->GetLastNonSpaceCharacter(_mutableViewport).Y;
-        for (SHORT i = eraseStart; i <= eraseEnd; i++)
+        if (eraseStart <= eraseEnd)
         {
-            _buffer->GetRowByOffset(i).Reset(_buffer->GetCurrentAttributes());
+            _buffer->EraseRows(eraseStart, eraseEnd + 1, _buffer->GetCurrentAttributes());
+            _buffer->ResetLineRenditionRange(eraseStart, eraseEnd + 1);
         }
 
         // Reset the scroll offset now because there's nothing for the user to 'scroll' to
@@ -343,6 +357,7 @@ try
 
     // Move the viewport, adjust the scroll bar if needed, and restore the old cursor position
     _mutableViewport = Viewport::FromExclusive(newWin);
+    ClearPatternTree();
     Terminal::_NotifyScrollEvent();
     SetCursorPosition(relativeCursor.X, relativeCursor.Y);
 
@@ -361,7 +376,8 @@ CATCH_LOG_RETURN_FALSE()
 bool Terminal::SetWindowTitle(std::wstring_view title) noexcept
 try
 {
-    if (!_suppressApplicationTitle)
+    // Shells that set the title on every prompt mostly set the same one again.
+    if (!_suppressApplicationTitle && _title != title)
     {
         _title.emplace(title);
         _pfnTitleChanged(_title.value());
@@ -382,6 +398,7 @@ bool Terminal::SetColorTableEntry(const size_t tableIndex, const COLORREF color)
 try
 {
     _colorTable.at(tableIndex) = color;
+    _UpdateResolvedColors();
 
     // Repaint everything - the colors might have changed
     _buffer->GetRenderTarget().TriggerRedrawAll();
@@ -452,6 +469,7 @@ bool Terminal::SetDefaultForeground(const COLORREF color) noexcept
 try
 {
     _defaultFg = color;
+    _UpdateResolvedColors();
 
     // Repaint everything - the colors might have changed
     _buffer->GetRenderTarget().TriggerRedrawAll();
@@ -469,6 +487,7 @@ bool Terminal::SetDefaultBackground(const COLORREF color) noexcept
 try
 {
     _defaultBg = color;
+    _UpdateResolvedColors();
     _pfnBackgroundColorChanged(color);
 
     // Repaint everything - the colors might have changed
@@ -485,18 +504,21 @@ til::color Terminal::GetDefaultBackground() const noexcept
 bool Terminal::EnableWin32InputMode(const bool win32InputMode) noexcept
 {
     _terminalInput->ChangeWin32InputMode(win32InputMode);
+    _UpdateInputModes();
     return true;
 }
 
 bool Terminal::SetCursorKeysMode(const bool applicationMode) noexcept
 {
     _terminalInput->ChangeCursorKeysMode(applicationMode);
+    _UpdateInputModes();
     return true;
 }
 
 bool Terminal::SetKeypadMode(const bool applicationMode) noexcept
 {
     _terminalInput->ChangeKeypadMode(applicationMode);
+    _UpdateInputModes();
     return true;
 }
 
@@ -558,6 +580,21 @@ bool Terminal::IsXtermBracketedPasteModeEnabled() const noexcept
     return _bracketedPasteMode;
 }
 
+// Method Description:
+// - Begins or ends a synchronized update, during which the renderer doesn't
+//   paint the partially updated buffer.
+// Arguments:
+// - enabled - true when the update begins, false when it ends.
+// Return Value:
+// - true if successful. false otherwise.
+bool Terminal::EnableSynchronizedOutput(const bool enabled) noexcept
+try
+{
+    _buffer->GetRenderTarget().SetSynchronizedOutput(enabled);
+    return true;
+}
+CATCH_LOG_RETURN_FALSE()
+
 bool Terminal::IsVtInputEnabled() const noexcept
 {
     // We should never be getting this call in Terminal.
@@ -631,6 +668,8 @@ bool Terminal::EndHyperlink() noexcept
 // - true
 bool Terminal::SetTaskbarProgress(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::TaskbarState state, const size_t progress) noexcept
 {
+    const auto previousState = _taskbarState;
+    const auto previousProgress = _taskbarProgress;
     _taskbarState = static_cast<size_t>(state);
 
     switch (state)
@@ -666,7 +705,8 @@ bool Terminal::SetTaskbarProgress(const ::Microsoft::Console::VirtualTerminal::D
         break;
     }
 
-    if (_pfnTaskbarProgressChanged)
+    // Tools that report their progress with every step mostly report the same percentage again.
+    if (_pfnTaskbarProgressChanged && (_taskbarState != previousState || _taskbarProgress != previousProgress))
     {
         _pfnTaskbarProgressChanged();
     }
@@ -684,6 +724,63 @@ std::wstring_view Terminal::GetWorkingDirectory() noexcept
     return _workingDirectory;
 }
 
+// Method Description:
+// - Marks the row of the cursor as the start of a prompt, a command or its output.
+// Arguments:
+// - kind - what starts at the cursor
+// Return Value:
+// - true
+bool Terminal::AddPromptMark(const PromptMarkKind kind) noexcept
+try
+{
+    _buffer->AddPromptMark(kind);
+    return true;
+}
+CATCH_LOG_RETURN_FALSE()
+
+// Method Description:
+// - Starts a sixel image at the cursor. The image is decoded as its data arrives,
+//   and placed in the buffer once it's complete. Like xterm, the cursor then
+//   moves down to the last row of the image.
+// Arguments:
+// - transparentBackground - whether the pixels without sixels are left transparent
+// Return Value:
+// - the handler of the data of the image, or nullptr if it couldn't be created
+ITermDispatch::StringHandler Terminal::DefineSixelImage(const bool transparentBackground) noexcept
+try
+{
+    auto decoder = std::make_shared<SixelDecoder>(transparentBackground);
+    return [this, decoder = std::move(decoder)](const wchar_t wch) {
+        try
+        {
+            if (wch != AsciiChars::ESC)
+            {
+                decoder->Put(wch);
+                return true;
+            }
+
+            // The string ended, so the image is complete.
+            if (const auto image = decoder->Finish())
+            {
+                const auto height = image->CellSize().height();
+                _buffer->AddImage(image);
+                for (ptrdiff_t row = 1; row < height; ++row)
+                {
+                    CursorLineFeed(false);
+                }
+            }
+            return true;
+        }
+        CATCH_LOG();
+        return false;
+    };
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return nullptr;
+}
+
 // Method Description:
 // - Saves the current text attributes to an internal stack.
 // Arguments:
@@ -452,6 +452,18 @@ bool TerminalDispatch::EnableXtermBracketedPasteMode(const bool enabled) noexcep
     return true;
 }
 
+//Routine Description:
+// Synchronized Output - Holds back painting while an application redraws
+//      the screen, so that the redraw is shown as a single frame.
+//Arguments:
+// - enabled - true when the update begins, false when it ends.
+// Return value:
+// True if handled successfully. False otherwise.
+bool TerminalDispatch::EnableSynchronizedOutput(const bool enabled) noexcept
+{
+    return _terminalApi.EnableSynchronizedOutput(enabled);
+}
+
 bool TerminalDispatch::SetMode(const DispatchTypes::ModeParams param) noexcept
 {
     return _ModeParamsHelper(param, true);
@@ -561,6 +573,53 @@ bool TerminalDispatch::DoConEmuAction(const std::wstring_view string) noexcept
     return false;
 }
 
+// Method Description:
+// - Performs a FinalTerm action, the shell integration marks of FTCS (OSC 133)
+// - Each of them marks where the prompt, the command or its output starts,
+//   or where the command finished. Their parameters (like the exit code) are ignored.
+// Arguments:
+// - string: contains the parameters that define which action we do
+// Return Value:
+// - true if the action was recognized
+bool TerminalDispatch::DoFinalTermAction(const std::wstring_view string) noexcept
+{
+    if (string.empty())
+    {
+        return false;
+    }
+
+    switch (til::at(string, 0))
+    {
+    case L'A':
+        return _terminalApi.AddPromptMark(PromptMarkKind::Prompt);
+    case L'B':
+        return _terminalApi.AddPromptMark(PromptMarkKind::Command);
+    case L'C':
+        return _terminalApi.AddPromptMark(PromptMarkKind::Output);
+    case L'D':
+        return _terminalApi.AddPromptMark(PromptMarkKind::Finished);
+    default:
+        return false;
+    }
+}
+
+// Method Description:
+// - DECSIXEL - Starts a sixel image at the cursor.
+// - The macro parameter selects the aspect ratio of the pixels, which is
+//   ignored like the grid size, as every pixel is drawn as a square.
+// Arguments:
+// - macroParameter - the aspect ratio of the pixels (ignored)
+// - backgroundSelect - whether the pixels without sixels are transparent
+// - gridSize - the horizontal spacing of the pixels (ignored)
+// Return Value:
+// - the handler of the data of the image
+ITermDispatch::StringHandler TerminalDispatch::DefineSixelImage(const size_t /*macroParameter*/,
+                                                                const DispatchTypes::SixelBackground backgroundSelect,
+                                                                const size_t /*gridSize*/) noexcept
+{
+    return _terminalApi.DefineSixelImage(backgroundSelect == DispatchTypes::SixelBackground::Transparent);
+}
+
 // Routine Description:
 // - Support routine for routing private mode parameters to be set/reset as flags
 // Arguments:
@@ -607,6 +666,9 @@ bool TerminalDispatch::_ModeParamsHelper(const DispatchTypes::ModeParams param,
     case DispatchTypes::ModeParams::XTERM_BracketedPasteMode:
         success = EnableXtermBracketedPasteMode(enable);
         break;
+    case DispatchTypes::ModeParams::SO_SynchronizedOutput:
+        success = EnableSynchronizedOutput(enable);
+        break;
     case DispatchTypes::ModeParams::W32IM_Win32InputMode:
         success = EnableWin32InputMode(enable);
         break;
@@ -72,6 +72,7 @@ public:
     bool EnableAnyEventMouseMode(const bool enabled) noexcept override; // ?1003
     bool EnableAlternateScroll(const bool enabled) noexcept override; // ?1007
     bool EnableXtermBracketedPasteMode(const bool enabled) noexcept override; // ?2004
+    bool EnableSynchronizedOutput(const bool enabled) noexcept override; // ?2026
 
     bool SetMode(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::ModeParams /*param*/) noexcept override; // DECSET
     bool ResetMode(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::ModeParams /*param*/) noexcept override; // DECRST
@@ -81,16 +82,18 @@ public:
 
     bool DoConEmuAction(const std::wstring_view string) noexcept override;
 
+    bool DoFinalTermAction(const std::wstring_view string) noexcept override;
+
+    StringHandler DefineSixelImage(const size_t macroParameter,
+                                   const ::Microsoft::Console::VirtualTerminal::DispatchTypes::SixelBackground backgroundSelect,
+                                   const size_t gridSize) noexcept override; // DECSIXEL
+
 private:
     ::Microsoft::Terminal::Core::ITerminalApi& _terminalApi;
 
     std::vector<bool> _tabStopColumns;
     bool _initDefaultTabStops = true;
 
-    size_t _SetRgbColorsHelper(const ::Microsoft::Console::VirtualTerminal::VTParameters options,
-                               TextAttribute& attr,
-                               const bool isForeground) noexcept;
-
     bool _ModeParamsHelper(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::ModeParams param, const bool enable) noexcept;
 
     bool _ClearSingleTabStop() noexcept;
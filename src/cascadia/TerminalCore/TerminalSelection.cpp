@@ -54,12 +54,83 @@ std::vector<SMALL_RECT> Terminal::_GetSelectionRects() const noexcept
 
     try
     {
-        return _buffer->GetTextRects(_selection->start, _selection->end, _blockSelection, false);
+        _UpdateSelectionRects();
+        return _selectionRectsCache.rects;
     }
     CATCH_LOG();
     return result;
 }
 
+// Method Description:
+// - Brings the cached selection rectangles up to date with the current selection.
+// - The renderer asks for the rectangles a few times per frame, and while the
+//   selection is extended by dragging only its end moves. So the rectangles are
+//   only computed again if the buffer changed, and otherwise only for the rows
+//   between the old and the new end of the selection.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Terminal::_UpdateSelectionRects() const
+{
+    auto& cache = _selectionRectsCache;
+    const auto start = _selection->start;
+    const auto end = _selection->end;
+
+    const auto sameBuffer = cache.buffer == _buffer.get() && cache.generation == _buffer->GetGeneration();
+    if (sameBuffer && cache.blockSelection == _blockSelection && cache.start == start)
+    {
+        if (cache.end == end)
+        {
+            return;
+        }
+
+        const auto bufferSize = _buffer->GetSize();
+        const auto wasForward = bufferSize.CompareInBounds(start, cache.end) <= 0;
+        const auto isForward = bufferSize.CompareInBounds(start, end) <= 0;
+
+        // In a block selection, the end decides the width of every row.
+        // If the end moved across the start, all rows change sides as well.
+        if (!_blockSelection && wasForward == isForward && !cache.rects.empty())
+        {
+            if (isForward)
+            {
+                // The rows above both ends still span from the start to the right edge.
+                const auto firstChanged = std::min(cache.end.Y, end.Y);
+                if (firstChanged > start.Y)
+                {
+                    cache.rects.resize(firstChanged - start.Y);
+                    const auto tail = _buffer->GetTextRects({ bufferSize.Left(), firstChanged }, end, false, false);
+                    cache.rects.insert(cache.rects.end(), tail.begin(), tail.end());
+                    cache.end = end;
+                    return;
+                }
+            }
+            else
+            {
+                // The rows below both ends still span from the left edge to the start.
+                const auto lastChanged = std::max(cache.end.Y, end.Y);
+                if (lastChanged < start.Y)
+                {
+                    const auto unchanged = start.Y - lastChanged;
+                    auto rects = _buffer->GetTextRects(end, { bufferSize.RightInclusive(), lastChanged }, false, false);
+                    rects.insert(rects.end(), cache.rects.end() - unchanged, cache.rects.end());
+                    cache.rects = std::move(rects);
+                    cache.end = end;
+                    return;
+                }
+            }
+        }
+    }
+
+    cache.buffer = _buffer.get();
+    cache.generation = _buffer->GetGeneration();
+    cache.start = start;
+    cache.end = end;
+    cache.blockSelection = _blockSelection;
+    cache.rects = _buffer->GetTextRects(start, end, _blockSelection, false);
+}
+
 // Method Description:
 // - Get the current anchor position relative to the whole text buffer
 // Arguments:
@@ -267,6 +338,33 @@ const TextBuffer::TextAndColor Terminal::RetrieveSelectedTextFromBuffer(bool sin
     return _buffer->GetText(includeCRLF, trimTrailingWhitespace, selectionRects, GetAttributeColors, formatWrappedRows);
 }
 
+// Method Description:
+// - Like RetrieveSelectedTextFromBuffer, but also generates the requested rich text
+//   formats in the same pass over the buffer.
+// Arguments:
+// - singleLine: collapse all of the text to one line
+// - richText: which rich text formats to generate, and the font to format them with
+// Return Value:
+// - the selected text in each of the requested formats
+TextBuffer::ExportedText Terminal::ExportSelectedText(bool singleLine, TextBuffer::RichTextFormats richText)
+{
+    auto lock = LockForReading();
+
+    const auto selectionRects = _GetSelectionRects();
+
+    // Colors are only needed if there's a rich text format to put them in.
+    if (richText.html || richText.rtf)
+    {
+        richText.GetAttributeColors = std::bind(&Terminal::GetAttributeColors, this, std::placeholders::_1);
+    }
+
+    // See RetrieveSelectedTextFromBuffer for how block selections are formatted.
+    const auto includeCRLF = !singleLine || _blockSelection;
+    const auto trimTrailingWhitespace = !singleLine && (!_blockSelection || _trimBlockSelection);
+    const auto formatWrappedRows = _blockSelection;
+    return _buffer->ExportText(includeCRLF, trimTrailingWhitespace, selectionRects, richText, formatWrappedRows);
+}
+
 // Method Description:
 // - convert viewport position to the corresponding location on the buffer
 // Arguments:
@@ -50,14 +50,61 @@ const TextAttribute Terminal::GetDefaultBrushColors() noexcept
     return TextAttribute{};
 }
 
+// Method Description:
+// - Works out the intense default foreground that GetAttributeColors uses. This
+//   has to be called whenever the default colors or the color table change.
+void Terminal::_UpdateResolvedColors() noexcept
+{
+    _defaultIntenseFg = TextColor{}.GetColor({ _colorTable.data(), _colorTable.size() }, _defaultFg, true);
+}
+
 std::pair<COLORREF, COLORREF> Terminal::GetAttributeColors(const TextAttribute& attr) const noexcept
 {
     _blinkingState.RecordBlinkingUsage(attr);
-    auto colors = attr.CalculateRgbColors({ _colorTable.data(), _colorTable.size() },
-                                          _defaultFg,
-                                          _defaultBg,
-                                          _screenReversed,
-                                          _blinkingState.IsBlinkingFaint());
+
+    // This does what TextAttribute::CalculateRgbColors does, except that the intense
+    // default foreground was worked out ahead of time. This is called for every run
+    // of text that's drawn and for every cell of rich text that's copied.
+    const auto fgColor = attr.GetForeground();
+    const auto bgColor = attr.GetBackground();
+    const auto intense = attr.IsBold();
+
+    std::pair<COLORREF, COLORREF> colors;
+    if (fgColor.IsDefault())
+    {
+        colors.first = intense ? _defaultIntenseFg : COLORREF{ _defaultFg };
+    }
+    else if (fgColor.IsRgb())
+    {
+        colors.first = fgColor.GetRGB();
+    }
+    else
+    {
+        colors.first = til::at(_colorTable, intense && fgColor.IsIndex16() ? fgColor.GetIndex() | 8 : fgColor.GetIndex());
+    }
+
+    if (bgColor.IsDefault())
+    {
+        colors.second = _defaultBg;
+    }
+    else
+    {
+        colors.second = bgColor.IsRgb() ? bgColor.GetRGB() : til::at(_colorTable, bgColor.GetIndex());
+    }
+
+    if (attr.IsFaint() || (attr.IsBlinking() && _blinkingState.IsBlinkingFaint()))
+    {
+        colors.first = (colors.first >> 1) & 0x7F7F7F; // Divide foreground color components by two.
+    }
+    if (attr.IsReverseVideo() ^ _screenReversed)
+    {
+        std::swap(colors.first, colors.second);
+    }
+    if (attr.IsInvisible())
+    {
+        colors.first = colors.second;
+    }
+
     colors.first |= 0xff000000;
     // We only care about alpha for the default BG (which enables acrylic)
     // If the bg isn't the default bg color, or reverse video is enabled, make it fully opaque.
@@ -142,7 +189,7 @@ const std::wstring Microsoft::Terminal::Core::Terminal::GetHyperlinkCustomId(uin
 const std::vector<size_t> Terminal::GetPatternId(const COORD location) const noexcept
 {
     // Look through our interval tree for this location
-    const auto intervals = _patternIntervalTree.findOverlapping(COORD{ location.X + 1, location.Y }, location);
+    const auto intervals = _patterns.findOverlapping(COORD{ location.X + 1, location.Y }, location);
     if (intervals.size() == 0)
     {
         return {};
@@ -159,6 +206,68 @@ const std::vector<size_t> Terminal::GetPatternId(const COORD location) const noe
     return {};
 }
 
+// Method Description:
+// - Gets a number that changes whenever the regex patterns are updated, so
+//   that the renderer knows when pattern ids it remembered may be stale.
+// Return value:
+// - The generation of the pattern interval tree
+uint64_t Terminal::GetPatternGeneration() const noexcept
+{
+    return _patternGeneration;
+}
+
+// Method Description:
+// - Gets the last keystroke whose echo moved the cursor. See NoteInput.
+// Return value:
+// - The keystroke, or one with a sequence of 0 if there's none yet
+Microsoft::Console::Render::InputEcho Terminal::GetInputEcho() const noexcept
+{
+    return _inputEcho;
+}
+
+// Method Description:
+// - Gets the rectangles of the search matches in the viewport, and in the row
+//   below it, which is painted too while scrolling smoothly.
+// - The matches are sorted, so only the ones that end in the viewport or below
+//   it are looked at, no matter how many there are in the scrollback.
+// Return Value:
+// - The rectangles to highlight, in buffer coordinates
+std::vector<Microsoft::Console::Types::Viewport> Terminal::GetSearchHighlights() const noexcept
+try
+{
+    std::vector<Viewport> result;
+    if (_searchHighlights.empty())
+    {
+        return result;
+    }
+
+    const auto circledRows = _buffer->GetCircledRows();
+    const auto viewport = _GetVisibleViewport();
+    const auto top = circledRows + gsl::narrow_cast<uint64_t>(viewport.Top());
+    const auto bottom = circledRows + gsl::narrow_cast<uint64_t>(viewport.BottomExclusive());
+
+    auto it = std::lower_bound(_searchHighlights.begin(), _searchHighlights.end(), top, [](const SearchHighlight& highlight, const uint64_t row) {
+        return highlight.endRow < row;
+    });
+    for (; it != _searchHighlights.end() && it->startRow <= bottom; ++it)
+    {
+        // The start of a match that spans rows might have scrolled off the top.
+        const auto start = it->startRow < circledRows ? COORD{ 0, 0 } : COORD{ it->startColumn, gsl::narrow_cast<SHORT>(it->startRow - circledRows) };
+        const COORD end{ it->endColumn, gsl::narrow_cast<SHORT>(it->endRow - circledRows) };
+        for (const auto& rect : _buffer->GetTextRects(start, end, false, true))
+        {
+            result.emplace_back(Viewport::FromInclusive(rect));
+        }
+    }
+
+    return result;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return {};
+}
+
 std::vector<Microsoft::Console::Types::Viewport> Terminal::GetSelectionRects() noexcept
 try
 {
@@ -248,6 +357,21 @@ void Terminal::UnlockConsole() noexcept
     _readWriteLock.unlock_shared();
 }
 
+// Method Description:
+// - Locks the terminal for painting. LockConsole already only locks it for
+//      reading, so this is the same.
+void Terminal::LockConsoleShared() noexcept
+{
+    LockConsole();
+}
+
+// Method Description:
+// - Unlocks the terminal after a call to Terminal::LockConsoleShared.
+void Terminal::UnlockConsoleShared() noexcept
+{
+    UnlockConsole();
+}
+
 // Method Description:
 // - Returns whether the screen is inverted;
 // Return Value:
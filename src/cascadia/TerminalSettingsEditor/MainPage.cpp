@@ -52,8 +52,6 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
 
         _InitializeProfilesList();
 
-        _colorSchemesNavState = winrt::make<ColorSchemesPageNavigationState>(_settingsClone);
-
         Automation::AutomationProperties::SetHelpText(SaveButton(), RS_(L"Settings_SaveSettingsButton/[using:Windows.UI.Xaml.Controls]ToolTipService/ToolTip"));
         Automation::AutomationProperties::SetHelpText(ResetButton(), RS_(L"Settings_ResetSettingsButton/[using:Windows.UI.Xaml.Controls]ToolTipService/ToolTip"));
         Automation::AutomationProperties::SetHelpText(OpenJsonNavItem(), RS_(L"Nav_OpenJSON/[using:Windows.UI.Xaml.Controls]ToolTipService/ToolTip"));
@@ -99,7 +97,7 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
                     {
                         if (const auto& tag{ navViewItem.Tag() })
                         {
-                            if (tag.try_as<Editor::ProfileViewModel>())
+                            if (tag.try_as<Model::Profile>())
                             {
                                 // remove NavViewItem pointing to a Profile
                                 return true;
@@ -122,8 +120,11 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
 
         // Repopulate profile-related menu items
         _InitializeProfilesList();
-        // Update the Nav State with the new version of the settings
-        _colorSchemesNavState.Settings(_settingsClone);
+        // Update the Nav State with the new version of the settings, if we ever navigated there
+        if (_colorSchemesNavState)
+        {
+            _colorSchemesNavState.Settings(_settingsClone);
+        }
         // We'll update the profile in the _profilesNavState whenever we actually navigate to one
 
         // now that the menuItems are repopulated,
@@ -149,15 +150,15 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
                                 }
                             }
                         }
-                        else if (const auto& profileTag{ tag.try_as<ProfileViewModel>() })
+                        else if (const auto& profileTag{ tag.try_as<Model::Profile>() })
                         {
-                            if (const auto& selectedItemProfileTag{ selectedItemTag.try_as<ProfileViewModel>() })
+                            if (const auto& selectedItemProfileTag{ selectedItemTag.try_as<Model::Profile>() })
                             {
-                                if (profileTag->OriginalProfileGuid() == selectedItemProfileTag->OriginalProfileGuid())
+                                if (profileTag.Guid() == selectedItemProfileTag.Guid())
                                 {
                                     // found the one that was selected before the refresh
                                     SettingsNav().SelectedItem(item);
-                                    _Navigate(*profileTag);
+                                    _NavigateToProfile(menuItem);
                                     return;
                                 }
                             }
@@ -269,10 +270,10 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
             {
                 _Navigate(*navString);
             }
-            else if (const auto profile = clickedItemContainer.Tag().try_as<Editor::ProfileViewModel>())
+            else if (const auto profileItem = clickedItemContainer.try_as<MUX::Controls::NavigationViewItem>())
             {
                 // Navigate to a page with the given profile
-                _Navigate(profile);
+                _NavigateToProfile(profileItem);
             }
         }
     }
@@ -297,6 +298,10 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
         }
         else if (clickedItemTag == colorSchemesTag)
         {
+            if (!_colorSchemesNavState)
+            {
+                _colorSchemesNavState = winrt::make<ColorSchemesPageNavigationState>(_settingsClone);
+            }
             contentFrame().Navigate(xaml_typename<Editor::ColorSchemes>(), _colorSchemesNavState);
         }
         else if (clickedItemTag == globalAppearanceTag)
@@ -313,11 +318,36 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
 
     // Method Description:
     // - updates the content frame to present a view of the profile page
+    // - The view model of the profile is only created here, since the menu
+    //   items just need the name and icon of their profile. The view model
+    //   keeps the menu item up to date while the profile is edited.
     // - NOTE: this does not update the selected item.
     // Arguments:
-    // - profile - the profile object we are getting a view of
-    void MainPage::_Navigate(const Editor::ProfileViewModel& profile)
+    // - profileItem - the menu item of the profile we are getting a view of
+    void MainPage::_NavigateToProfile(const MUX::Controls::NavigationViewItem& profileItem)
     {
+        const auto profile{ _viewModelForProfile(profileItem.Tag().as<Model::Profile>(), _settingsClone) };
+
+        // Update the menu item when the icon/name changes
+        auto weakMenuItem{ make_weak(profileItem) };
+        profile.PropertyChanged([weakMenuItem](const auto& sender, const WUX::Data::PropertyChangedEventArgs& args) {
+            if (auto menuItem{ weakMenuItem.get() })
+            {
+                const auto& viewModel{ sender.template as<Editor::ProfileViewModel>() };
+                if (args.PropertyName() == L"Icon")
+                {
+                    const auto iconSource{ IconPathConverter::IconSourceWUX(viewModel.Icon()) };
+                    WUX::Controls::IconSourceElement icon;
+                    icon.IconSource(iconSource);
+                    menuItem.Icon(icon);
+                }
+                else if (args.PropertyName() == L"Name")
+                {
+                    menuItem.Content(box_value(viewModel.Name()));
+                }
+            }
+        });
+
         _lastProfilesNavState = winrt::make<ProfilePageNavigationState>(profile,
                                                                         _settingsClone.GlobalSettings().ColorSchemes(),
                                                                         _lastProfilesNavState,
@@ -368,7 +398,7 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
         // profile changes.
         for (const auto& profile : _settingsClone.AllProfiles())
         {
-            auto navItem = _CreateProfileNavViewItem(_viewModelForProfile(profile, _settingsClone));
+            auto navItem = _CreateProfileNavViewItem(profile);
             SettingsNav().MenuItems().Append(navItem);
         }
 
@@ -388,45 +418,25 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
     void MainPage::_CreateAndNavigateToNewProfile(const uint32_t index, const Model::Profile& profile)
     {
         const auto newProfile{ profile ? profile : _settingsClone.CreateNewProfile() };
-        const auto profileViewModel{ _viewModelForProfile(newProfile, _settingsClone) };
-        const auto navItem{ _CreateProfileNavViewItem(profileViewModel) };
+        const auto navItem{ _CreateProfileNavViewItem(newProfile) };
         SettingsNav().MenuItems().InsertAt(index, navItem);
 
         // Select and navigate to the new profile
         SettingsNav().SelectedItem(navItem);
-        _Navigate(profileViewModel);
+        _NavigateToProfile(navItem);
     }
 
-    MUX::Controls::NavigationViewItem MainPage::_CreateProfileNavViewItem(const Editor::ProfileViewModel& profile)
+    MUX::Controls::NavigationViewItem MainPage::_CreateProfileNavViewItem(const Model::Profile& profile)
     {
         MUX::Controls::NavigationViewItem profileNavItem;
         profileNavItem.Content(box_value(profile.Name()));
-        profileNavItem.Tag(box_value<Editor::ProfileViewModel>(profile));
+        profileNavItem.Tag(profile);
 
         const auto iconSource{ IconPathConverter::IconSourceWUX(profile.Icon()) };
         WUX::Controls::IconSourceElement icon;
         icon.IconSource(iconSource);
         profileNavItem.Icon(icon);
 
-        // Update the menu item when the icon/name changes
-        auto weakMenuItem{ make_weak(profileNavItem) };
-        profile.PropertyChanged([weakMenuItem](const auto&, const WUX::Data::PropertyChangedEventArgs& args) {
-            if (auto menuItem{ weakMenuItem.get() })
-            {
-                const auto& tag{ menuItem.Tag().as<Editor::ProfileViewModel>() };
-                if (args.PropertyName() == L"Icon")
-                {
-                    const auto iconSource{ IconPathConverter::IconSourceWUX(tag.Icon()) };
-                    WUX::Controls::IconSourceElement icon;
-                    icon.IconSource(iconSource);
-                    menuItem.Icon(icon);
-                }
-                else if (args.PropertyName() == L"Name")
-                {
-                    menuItem.Content(box_value(tag.Name()));
-                }
-            }
-        });
         return profileNavItem;
     }
 
@@ -452,8 +462,15 @@ namespace winrt::Microsoft::Terminal::Settings::Editor::implementation
         menuItems.RemoveAt(index);
 
         // navigate to the profile next to this one
-        const auto newSelectedItem{ menuItems.GetAt(index < menuItems.Size() - 1 ? index : index - 1) };
+        const auto newSelectedItem{ menuItems.GetAt(index < menuItems.Size() - 1 ? index : index - 1).as<MUX::Controls::NavigationViewItem>() };
         SettingsNav().SelectedItem(newSelectedItem);
-        _Navigate(newSelectedItem.try_as<MUX::Controls::NavigationViewItem>().Tag().try_as<Editor::ProfileViewModel>());
+        if (newSelectedItem.Tag().try_as<Model::Profile>())
+        {
+            _NavigateToProfile(newSelectedItem);
+        }
+        else if (const auto navString = newSelectedItem.Tag().try_as<hstring>())
+        {
+            _Navigate(*navString);
+        }
     }
 }
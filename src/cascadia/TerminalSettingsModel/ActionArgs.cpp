@@ -32,6 +32,7 @@
 #include "RenameWindowArgs.g.cpp"
 #include "GlobalSummonArgs.g.cpp"
 #include "FocusPaneArgs.g.cpp"
+#include "ExportBufferArgs.g.cpp"
 
 #include <LibraryResources.h>
 
@@ -622,4 +623,18 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
                         Id())
         };
     }
+
+    winrt::hstring ExportBufferArgs::GenerateName() const
+    {
+        // "Export buffer"
+        // "Export buffer to {Path}"
+        // "Export buffer with attributes to {Path}"
+        std::wstringstream ss;
+        ss << std::wstring_view(IncludeAttributes() ? RS_(L"ExportBufferWithAttributesCommandKey") : RS_(L"ExportBufferCommandKey"));
+        if (!Path().empty())
+        {
+            ss << L", " << std::wstring_view(RS_(L"ExportBufferPathLabel")) << L": " << std::wstring_view(Path());
+        }
+        return winrt::hstring{ ss.str() };
+    }
 }
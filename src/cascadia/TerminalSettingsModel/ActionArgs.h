@@ -34,6 +34,7 @@
 #include "RenameWindowArgs.g.h"
 #include "GlobalSummonArgs.g.h"
 #include "FocusPaneArgs.g.h"
+#include "ExportBufferArgs.g.h"
 
 #include "../../cascadia/inc/cppwinrt_utils.h"
 #include "JsonUtils.h"
@@ -1638,6 +1639,63 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         }
     };
 
+    struct ExportBufferArgs : public ExportBufferArgsT<ExportBufferArgs>
+    {
+        ExportBufferArgs() = default;
+        ExportBufferArgs(const winrt::hstring& path, const bool includeAttributes) :
+            _Path{ path },
+            _IncludeAttributes{ includeAttributes } {};
+        WINRT_PROPERTY(winrt::hstring, Path);
+        WINRT_PROPERTY(bool, IncludeAttributes, false);
+        static constexpr std::string_view PathKey{ "path" };
+        static constexpr std::string_view IncludeAttributesKey{ "includeAttributes" };
+
+    public:
+        hstring GenerateName() const;
+
+        bool Equals(const IActionArgs& other)
+        {
+            auto otherAsUs = other.try_as<ExportBufferArgs>();
+            if (otherAsUs)
+            {
+                return otherAsUs->_Path == _Path &&
+                       otherAsUs->_IncludeAttributes == _IncludeAttributes;
+            }
+            return false;
+        };
+        static FromJsonResult FromJson(const Json::Value& json)
+        {
+            // LOAD BEARING: Not using make_self here _will_ break you in the future!
+            auto args = winrt::make_self<ExportBufferArgs>();
+            JsonUtils::GetValueForKey(json, PathKey, args->_Path);
+            JsonUtils::GetValueForKey(json, IncludeAttributesKey, args->_IncludeAttributes);
+            return { *args, {} };
+        }
+        static Json::Value ToJson(const IActionArgs& val)
+        {
+            if (!val)
+            {
+                return {};
+            }
+            Json::Value json{ Json::ValueType::objectValue };
+            const auto args{ get_self<ExportBufferArgs>(val) };
+            JsonUtils::SetValueForKey(json, PathKey, args->_Path);
+            JsonUtils::SetValueForKey(json, IncludeAttributesKey, args->_IncludeAttributes);
+            return json;
+        }
+        IActionArgs Copy() const
+        {
+            auto copy{ winrt::make_self<ExportBufferArgs>() };
+            copy->_Path = _Path;
+            copy->_IncludeAttributes = _IncludeAttributes;
+            return *copy;
+        }
+        size_t Hash() const
+        {
+            return ::Microsoft::Terminal::Settings::Model::HashUtils::HashProperty(_Path, _IncludeAttributes);
+        }
+    };
+
 }
 
 namespace winrt::Microsoft::Terminal::Settings::Model::factory_implementation
@@ -1658,4 +1716,5 @@ namespace winrt::Microsoft::Terminal::Settings::Model::factory_implementation
     BASIC_FACTORY(FindMatchArgs);
     BASIC_FACTORY(NewWindowArgs);
     BASIC_FACTORY(FocusPaneArgs);
+    BASIC_FACTORY(ExportBufferArgs);
 }
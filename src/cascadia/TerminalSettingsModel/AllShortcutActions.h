@@ -75,7 +75,9 @@
     ON_ALL_ACTIONS(OpenWindowRenamer)    \
     ON_ALL_ACTIONS(GlobalSummon)         \
     ON_ALL_ACTIONS(QuakeMode)            \
-    ON_ALL_ACTIONS(FocusPane)
+    ON_ALL_ACTIONS(FocusPane)            \
+    ON_ALL_ACTIONS(ExportBuffer)         \
+    ON_ALL_ACTIONS(ToggleBroadcastInput)
 
 #define ALL_SHORTCUT_ACTIONS_WITH_ARGS             \
     ON_ALL_ACTIONS_WITH_ARGS(AdjustFontSize)       \
@@ -104,4 +106,5 @@
     ON_ALL_ACTIONS_WITH_ARGS(SplitPane)            \
     ON_ALL_ACTIONS_WITH_ARGS(SwitchToTab)          \
     ON_ALL_ACTIONS_WITH_ARGS(ToggleCommandPalette) \
-    ON_ALL_ACTIONS_WITH_ARGS(FocusPane)
+    ON_ALL_ACTIONS_WITH_ARGS(FocusPane)            \
+    ON_ALL_ACTIONS_WITH_ARGS(ExportBuffer)
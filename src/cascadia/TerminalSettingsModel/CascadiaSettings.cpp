@@ -319,6 +319,9 @@ winrt::Microsoft::Terminal::Settings::Model::Profile CascadiaSettings::Duplicate
     DUPLICATE_SETTING_MACRO(Commandline);
     DUPLICATE_SETTING_MACRO(StartingDirectory);
     DUPLICATE_SETTING_MACRO(AntialiasingMode);
+    DUPLICATE_SETTING_MACRO(GlyphAtlasRendering);
+    DUPLICATE_SETTING_MACRO(SmoothScrolling);
+    DUPLICATE_SETTING_MACRO(PixelShaderFrameRate);
     DUPLICATE_SETTING_MACRO(ForceFullRepaintRendering);
     DUPLICATE_SETTING_MACRO(SoftwareRendering);
     DUPLICATE_SETTING_MACRO(HistorySize);
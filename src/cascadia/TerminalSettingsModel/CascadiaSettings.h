@@ -44,6 +44,7 @@ namespace TerminalAppUnitTests
 namespace Microsoft::Terminal::Settings::Model
 {
     class SettingsTypedDeserializationException;
+    class JsonCache;
 };
 
 class Microsoft::Terminal::Settings::Model::SettingsTypedDeserializationException final : public std::runtime_error
@@ -80,6 +81,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
 
         static hstring SettingsPath();
         static hstring DefaultSettingsPath();
+        static hstring DynamicProfilesCachePath();
         Model::Profile ProfileDefaults() const;
 
         static winrt::hstring ApplicationDisplayName();
@@ -119,6 +121,10 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
 
         std::vector<std::unique_ptr<::Microsoft::Terminal::Settings::Model::IDynamicProfileGenerator>> _profileGenerators;
 
+        // Only set while LoadAll is running.
+        ::Microsoft::Terminal::Settings::Model::JsonCache* _jsonCache{ nullptr };
+        bool _useDynamicProfilesCache{ false };
+
         std::string _userSettingsString;
         Json::Value _userSettings;
         Json::Value _defaultSettings;
@@ -142,6 +148,11 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         void _ApplyDefaultsFromUserSettings();
 
         void _LoadDynamicProfiles();
+        static std::vector<std::optional<std::vector<Model::Profile>>> _GenerateDynamicProfiles(const std::vector<::Microsoft::Terminal::Settings::Model::IDynamicProfileGenerator*>& generators);
+        static std::string _SerializeDynamicProfiles(const std::vector<::Microsoft::Terminal::Settings::Model::IDynamicProfileGenerator*>& generators,
+                                                     const std::vector<std::optional<std::vector<Model::Profile>>>& results);
+        winrt::fire_and_forget _RefreshDynamicProfilesCache(std::vector<::Microsoft::Terminal::Settings::Model::IDynamicProfileGenerator*> generators, std::string cacheString);
+        static std::optional<std::string> _ReadDynamicProfilesCache();
         void _LoadFragmentExtensions();
         void _ApplyJsonStubsHelper(const std::wstring_view directory, const std::unordered_set<std::wstring>& ignoredNamespaces);
         std::unordered_set<std::string> _AccumulateJsonFilesInDirectory(const std::wstring_view directory);
@@ -150,6 +161,8 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         static void _WriteSettings(std::string_view content, const hstring filepath);
         static std::optional<std::string> _ReadUserSettings();
         static std::optional<std::string> _ReadFile(HANDLE hFile);
+        static std::filesystem::path _JsonCachePath();
+        static Model::CascadiaSettings _LoadDefaults(::Microsoft::Terminal::Settings::Model::JsonCache* jsonCache);
 
         std::optional<guid> _GetProfileGuidByName(const hstring) const;
         std::optional<guid> _GetProfileGuidByIndex(std::optional<int> index) const;
@@ -3,9 +3,11 @@
 
 #include "pch.h"
 #include "CascadiaSettings.h"
+#include "JsonCache.h"
 
 #include <fmt/chrono.h>
 #include <shlobj.h>
+#include <StartupTracing.h>
 
 #include <WtExeUtils.h>
 
@@ -19,12 +21,16 @@
 
 using namespace winrt::Microsoft::Terminal::Settings::Model::implementation;
 using namespace ::Microsoft::Console;
+using ::Microsoft::Terminal::Settings::Model::IDynamicProfileGenerator;
+using ::Microsoft::Terminal::Settings::Model::JsonCache;
 
 static constexpr std::wstring_view SettingsFilename{ L"settings.json" };
 static constexpr std::wstring_view LegacySettingsFilename{ L"profiles.json" };
 static constexpr std::wstring_view UnpackagedSettingsFolderName{ L"Microsoft\\Windows Terminal\\" };
 
 static constexpr std::wstring_view DefaultsFilename{ L"defaults.json" };
+static constexpr std::wstring_view JsonCacheFilename{ L"settings.cache" };
+static constexpr std::wstring_view DynamicProfilesCacheFilename{ L"dynamicProfiles.cache" };
 
 static constexpr std::string_view SchemaKey{ "$schema" };
 static constexpr std::string_view SchemaValue{ "https://aka.ms/terminal-profiles-schema" };
@@ -143,11 +149,20 @@ static void _CatchRethrowSerializationExceptionWithLocationInfo(std::string_view
 // - a unique_ptr containing a new CascadiaSettings object.
 winrt::Microsoft::Terminal::Settings::Model::CascadiaSettings CascadiaSettings::LoadAll()
 {
+    TRACE_STARTUP_PHASE(g_hSettingsModelProvider, "LoadAll");
+
     try
     {
-        auto settings = LoadDefaults();
+        // The documents parsed since the last launch, so that only the files
+        // that changed since are parsed again.
+        JsonCache jsonCache{ _JsonCachePath() };
+
+        auto settings = _LoadDefaults(&jsonCache);
         auto resultPtr = winrt::get_self<CascadiaSettings>(settings);
         resultPtr->ClearWarnings();
+        resultPtr->_jsonCache = &jsonCache;
+        auto clearJsonCache = wil::scope_exit([&]() { resultPtr->_jsonCache = nullptr; });
+        resultPtr->_useDynamicProfilesCache = true;
 
         // GH 3588, we need this below to know if the user chose something that wasn't our default.
         // Collect it up here in case it gets modified by any of the other layers between now and when
@@ -245,6 +260,12 @@ winrt::Microsoft::Terminal::Settings::Model::CascadiaSettings CascadiaSettings::
         // If this throws, the app will catch it and use the default settings
         resultPtr->_ValidateSettings();
 
+        try
+        {
+            jsonCache.Save();
+        }
+        CATCH_LOG();
+
         return *resultPtr;
     }
     catch (const SettingsException& ex)
@@ -309,8 +330,22 @@ winrt::Microsoft::Terminal::Settings::Model::CascadiaSettings CascadiaSettings::
 // Return Value:
 // - a unique_ptr to a CascadiaSettings with the settings from defaults.json
 winrt::Microsoft::Terminal::Settings::Model::CascadiaSettings CascadiaSettings::LoadDefaults()
+{
+    return _LoadDefaults(nullptr);
+}
+
+// Function Description:
+// - Creates a new CascadiaSettings object initialized with settings from the
+//   hardcoded defaults.json, looking up the parsed defaults in the given cache.
+// Arguments:
+// - jsonCache: the cache of parsed documents to use, if any
+// Return Value:
+// - a CascadiaSettings with the settings from defaults.json
+winrt::Microsoft::Terminal::Settings::Model::CascadiaSettings CascadiaSettings::_LoadDefaults(JsonCache* jsonCache)
 {
     auto resultPtr{ winrt::make_self<CascadiaSettings>() };
+    resultPtr->_jsonCache = jsonCache;
+    auto clearJsonCache = wil::scope_exit([&]() { resultPtr->_jsonCache = nullptr; });
 
     // We already have the defaults in memory, because we stamp them into a
     // header as part of the build process. We don't need to bother with reading
@@ -336,6 +371,8 @@ winrt::Microsoft::Terminal::Settings::Model::CascadiaSettings CascadiaSettings::
 // - Uses the Json::Value _userSettings to check which DPGs should not be run.
 //   If the user settings has any namespaces in the "disabledProfileSources"
 //   property, we'll ensure that any DPGs with a matching namespace _don't_ run.
+// - If _useDynamicProfilesCache is set, the profiles the DPGs made last time
+//   are used instead, and the DPGs are run in the background to check them.
 // Arguments:
 // - <none>
 // Return Value:
@@ -352,32 +389,243 @@ void CascadiaSettings::_LoadDynamicProfiles()
         }
     }
 
-    const GUID nullGuid{ 0 };
+    std::vector<IDynamicProfileGenerator*> generators;
     for (auto& generator : _profileGenerators)
     {
         const std::wstring generatorNamespace{ generator->GetNamespace() };
 
-        if (ignoredNamespaces.find(generatorNamespace) != ignoredNamespaces.end())
+        // Skip the generators whose namespace should be ignored
+        if (ignoredNamespaces.find(generatorNamespace) == ignoredNamespaces.end())
+        {
+            generators.emplace_back(generator.get());
+        }
+    }
+
+    // The profiles the generators made last time are used right away, if we
+    // have them, and the generators are run again in the background. If they
+    // make different profiles now, the cache is updated, which makes the app
+    // reload the settings.
+    std::optional<std::string> cacheString;
+    if (_useDynamicProfilesCache)
+    {
+        try
         {
-            // namespace should be ignored
+            cacheString = _ReadDynamicProfilesCache();
+        }
+        CATCH_LOG();
+    }
+
+    std::vector<std::optional<std::vector<Model::Profile>>> results(generators.size());
+    bool usedCache = false;
+    if (cacheString)
+    {
+        try
+        {
+            const auto cache = _ParseUtf8JsonString(*cacheString);
+            for (size_t i = 0; i < generators.size(); ++i)
+            {
+                const auto& profiles = cache[JsonKey(til::u16u8(generators[i]->GetNamespace()))];
+                if (profiles.isArray())
+                {
+                    auto& result = results[i].emplace();
+                    for (const auto& profileJson : profiles)
+                    {
+                        auto profile = Profile::FromJson(profileJson);
+                        profile->Origin(OriginTag::Generated);
+                        result.emplace_back(*profile);
+                    }
+                    usedCache = true;
+                }
+            }
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION();
+            std::fill(results.begin(), results.end(), std::nullopt);
+            usedCache = false;
+        }
+    }
+
+    // Run the generators that weren't cached now.
+    std::vector<IDynamicProfileGenerator*> uncachedGenerators;
+    for (size_t i = 0; i < generators.size(); ++i)
+    {
+        if (!results[i])
+        {
+            uncachedGenerators.emplace_back(generators[i]);
+        }
+    }
+    auto generated = _GenerateDynamicProfiles(uncachedGenerators);
+    for (size_t i = 0, j = 0; i < generators.size(); ++i)
+    {
+        if (!results[i])
+        {
+            results[i] = std::move(generated[j++]);
+        }
+    }
+
+    if (_useDynamicProfilesCache)
+    {
+        if (usedCache)
+        {
+            _RefreshDynamicProfilesCache(std::move(generators), std::move(cacheString.value()));
         }
         else
         {
             try
             {
-                auto profiles = generator->GenerateProfiles();
-                for (auto& profile : profiles)
+                const auto content = _SerializeDynamicProfiles(generators, results);
+                if (content != cacheString)
                 {
-                    profile.Source(generatorNamespace);
-
-                    _allProfiles.Append(profile);
+                    _WriteSettings(content, DynamicProfilesCachePath());
                 }
             }
-            CATCH_LOG_MSG("Dynamic Profile Namespace: \"%ls\"", generatorNamespace.data());
+            CATCH_LOG();
+        }
+    }
+
+    for (size_t i = 0; i < generators.size(); ++i)
+    {
+        if (!results[i])
+        {
+            continue;
+        }
+
+        const std::wstring generatorNamespace{ generators[i]->GetNamespace() };
+        for (auto& profile : *results[i])
+        {
+            profile.Source(generatorNamespace);
+
+            _allProfiles.Append(profile);
         }
     }
 }
 
+// Function Description:
+// - Runs the given dynamic profile generators, all at once, since most of
+//   them spend their time waiting on other processes or services.
+// Arguments:
+// - generators: the generators to run
+// Return Value:
+// - the profiles made by each of the generators, or nullopt for the ones that failed
+std::vector<std::optional<std::vector<winrt::Microsoft::Terminal::Settings::Model::Profile>>> CascadiaSettings::_GenerateDynamicProfiles(const std::vector<IDynamicProfileGenerator*>& generators)
+{
+    TRACE_STARTUP_PHASE(g_hSettingsModelProvider, "DynamicProfiles");
+
+    std::vector<std::optional<std::vector<Model::Profile>>> results(generators.size());
+
+    const auto generate = [&](const size_t i) {
+        try
+        {
+            results[i] = generators[i]->GenerateProfiles();
+        }
+        CATCH_LOG_MSG("Dynamic Profile Namespace: \"%ls\"", std::wstring{ generators[i]->GetNamespace() }.c_str());
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < generators.size(); ++i)
+    {
+        threads.emplace_back([&, i]() {
+            // Some of the generators ask WinRT for the installed packages.
+            auto coInit = wil::CoInitializeEx_failfast(COINIT_MULTITHREADED);
+            generate(i);
+        });
+    }
+
+    if (!generators.empty())
+    {
+        generate(0);
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    return results;
+}
+
+// Function Description:
+// - Serializes the profiles the given generators made, for the dynamic profiles cache.
+// Arguments:
+// - generators: the generators that were run
+// - results: the profiles made by each of the generators
+// Return Value:
+// - the content of the cache file
+std::string CascadiaSettings::_SerializeDynamicProfiles(const std::vector<IDynamicProfileGenerator*>& generators,
+                                                        const std::vector<std::optional<std::vector<Model::Profile>>>& results)
+{
+    Json::Value json{ Json::objectValue };
+    for (size_t i = 0; i < generators.size(); ++i)
+    {
+        // A generator that failed is run again next time.
+        if (!results[i])
+        {
+            continue;
+        }
+
+        auto& profiles = json[JsonKey(til::u16u8(generators[i]->GetNamespace()))];
+        profiles = Json::Value{ Json::arrayValue };
+        for (const auto& profile : *results[i])
+        {
+            profiles.append(winrt::get_self<implementation::Profile>(profile)->ToJson());
+        }
+    }
+
+    Json::StreamWriterBuilder wbuilder;
+    wbuilder.settings_["indentation"] = "";
+    return Json::writeString(wbuilder, json);
+}
+
+// Method Description:
+// - Runs the given dynamic profile generators in the background, and updates
+//   the dynamic profiles cache if they made different profiles than the cached ones.
+// Arguments:
+// - generators: the generators to run, which this object keeps alive
+// - cacheString: the current content of the cache file
+// Return Value:
+// - <none>
+winrt::fire_and_forget CascadiaSettings::_RefreshDynamicProfilesCache(std::vector<IDynamicProfileGenerator*> generators, std::string cacheString)
+{
+    auto strongThis{ get_strong() };
+
+    co_await winrt::resume_background();
+
+    try
+    {
+        const auto results = _GenerateDynamicProfiles(generators);
+        const auto content = _SerializeDynamicProfiles(generators, results);
+        if (content != cacheString)
+        {
+            _WriteSettings(content, DynamicProfilesCachePath());
+        }
+    }
+    CATCH_LOG();
+}
+
+// Method Description:
+// - Reads the dynamic profiles cache, if there's one.
+// Arguments:
+// - <none>
+// Return Value:
+// - the content of the cache file, or nullopt if there's none
+std::optional<std::string> CascadiaSettings::_ReadDynamicProfilesCache()
+{
+    const auto path = DynamicProfilesCachePath();
+    wil::unique_hfile hFile{ CreateFileW(path.c_str(),
+                                         GENERIC_READ,
+                                         FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                         nullptr,
+                                         OPEN_EXISTING,
+                                         FILE_ATTRIBUTE_NORMAL,
+                                         nullptr) };
+    if (!hFile)
+    {
+        return std::nullopt;
+    }
+    return _ReadFile(hFile.get());
+}
+
 // Method Description:
 // - Searches the local app data folder, global app data folder and app
 //   extensions for json stubs we should use to create new profiles,
@@ -636,6 +884,14 @@ void CascadiaSettings::_ParseJsonString(std::string_view fileData, const bool is
 // - the parsed json value
 Json::Value CascadiaSettings::_ParseUtf8JsonString(std::string_view fileData)
 {
+    if (_jsonCache)
+    {
+        if (auto cached = _jsonCache->Find(fileData))
+        {
+            return std::move(*cached);
+        }
+    }
+
     Json::Value result;
     // Ignore UTF-8 BOM
     auto actualDataStart = fileData.data();
@@ -655,6 +911,11 @@ Json::Value CascadiaSettings::_ParseUtf8JsonString(std::string_view fileData)
         // the text to the user.
         throw winrt::hresult_error(WEB_E_INVALID_JSON_STRING, winrt::to_hstring(errs));
     }
+
+    if (_jsonCache)
+    {
+        _jsonCache->Store(fileData, result);
+    }
     return result;
 }
 
@@ -1210,6 +1471,30 @@ winrt::hstring CascadiaSettings::SettingsPath()
     return winrt::hstring{ (parentDirectoryForSettingsFile / SettingsFilename).wstring() };
 }
 
+// function Description:
+// - Returns the full path to the profiles the dynamic profile generators made
+//   last time, which lives next to the settings file.
+// Arguments:
+// - <none>
+// Return Value:
+// - the full path to the dynamic profiles cache
+winrt::hstring CascadiaSettings::DynamicProfilesCachePath()
+{
+    return winrt::hstring{ std::filesystem::path{ std::wstring_view{ CascadiaSettings::SettingsPath() } }.replace_filename(DynamicProfilesCacheFilename).wstring() };
+}
+
+// function Description:
+// - Returns the full path to the cache of the parsed settings files, which
+//   lives next to the settings file.
+// Arguments:
+// - <none>
+// Return Value:
+// - the full path to the cache file
+std::filesystem::path CascadiaSettings::_JsonCachePath()
+{
+    return std::filesystem::path{ std::wstring_view{ CascadiaSettings::SettingsPath() } }.replace_filename(JsonCacheFilename);
+}
+
 winrt::hstring CascadiaSettings::DefaultSettingsPath()
 {
     // Both of these posts suggest getting the path to the exe, then removing
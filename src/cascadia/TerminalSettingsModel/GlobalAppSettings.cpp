@@ -41,6 +41,7 @@ static constexpr std::string_view ConfirmCloseAllKey{ "confirmCloseAllTabs" };
 static constexpr std::string_view SnapToGridOnResizeKey{ "snapToGridOnResize" };
 static constexpr std::string_view EnableStartupTaskKey{ "startOnUserLogin" };
 static constexpr std::string_view AlwaysOnTopKey{ "alwaysOnTop" };
+static constexpr std::string_view TrimWorkingSetWhenMinimizedKey{ "trimWorkingSetWhenMinimized" };
 static constexpr std::string_view LegacyUseTabSwitcherModeKey{ "useTabSwitcher" };
 static constexpr std::string_view TabSwitcherModeKey{ "tabSwitcherMode" };
 static constexpr std::string_view DisableAnimationsKey{ "disableAnimations" };
@@ -53,8 +54,11 @@ static constexpr std::string_view DebugFeaturesKey{ "debugFeatures" };
 
 static constexpr std::string_view ForceFullRepaintRenderingKey{ "experimental.rendering.forceFullRepaint" };
 static constexpr std::string_view SoftwareRenderingKey{ "experimental.rendering.software" };
+static constexpr std::string_view PowerPreferenceKey{ "experimental.rendering.powerPreference" };
+static constexpr std::string_view FrameTimeOverlayKey{ "experimental.rendering.frameTimeOverlay" };
 static constexpr std::string_view ForceVTInputKey{ "experimental.input.forceVT" };
 static constexpr std::string_view DetectURLsKey{ "experimental.detectURLs" };
+static constexpr std::string_view InProcessWindowsKey{ "experimental.inProcessWindows" };
 
 #ifdef _DEBUG
 static constexpr bool debugFeaturesDefault{ true };
@@ -118,10 +122,13 @@ winrt::com_ptr<GlobalAppSettings> GlobalAppSettings::Copy() const
     globals->_SnapToGridOnResize = _SnapToGridOnResize;
     globals->_ForceFullRepaintRendering = _ForceFullRepaintRendering;
     globals->_SoftwareRendering = _SoftwareRendering;
+    globals->_PowerPreference = _PowerPreference;
+    globals->_FrameTimeOverlay = _FrameTimeOverlay;
     globals->_ForceVTInput = _ForceVTInput;
     globals->_DebugFeaturesEnabled = _DebugFeaturesEnabled;
     globals->_StartOnUserLogin = _StartOnUserLogin;
     globals->_AlwaysOnTop = _AlwaysOnTop;
+    globals->_TrimWorkingSetWhenMinimized = _TrimWorkingSetWhenMinimized;
     globals->_TabSwitcherMode = _TabSwitcherMode;
     globals->_DisableAnimations = _DisableAnimations;
     globals->_StartupActions = _StartupActions;
@@ -129,6 +136,7 @@ winrt::com_ptr<GlobalAppSettings> GlobalAppSettings::Copy() const
     globals->_WindowingBehavior = _WindowingBehavior;
     globals->_TrimBlockSelection = _TrimBlockSelection;
     globals->_DetectURLs = _DetectURLs;
+    globals->_InProcessWindows = _InProcessWindows;
 
     globals->_UnparsedDefaultProfile = _UnparsedDefaultProfile;
     globals->_validDefaultProfile = _validDefaultProfile;
@@ -295,12 +303,16 @@ void GlobalAppSettings::LayerJson(const Json::Value& json)
     JsonUtils::GetValueForKey(json, ForceFullRepaintRenderingKey, _ForceFullRepaintRendering);
 
     JsonUtils::GetValueForKey(json, SoftwareRenderingKey, _SoftwareRendering);
+    JsonUtils::GetValueForKey(json, PowerPreferenceKey, _PowerPreference);
+    JsonUtils::GetValueForKey(json, FrameTimeOverlayKey, _FrameTimeOverlay);
     JsonUtils::GetValueForKey(json, ForceVTInputKey, _ForceVTInput);
 
     JsonUtils::GetValueForKey(json, EnableStartupTaskKey, _StartOnUserLogin);
 
     JsonUtils::GetValueForKey(json, AlwaysOnTopKey, _AlwaysOnTop);
 
+    JsonUtils::GetValueForKey(json, TrimWorkingSetWhenMinimizedKey, _TrimWorkingSetWhenMinimized);
+
     // GH#8076 - when adding enum values to this key, we also changed it from
     // "useTabSwitcher" to "tabSwitcherMode". Continue supporting
     // "useTabSwitcher", but prefer "tabSwitcherMode"
@@ -319,6 +331,10 @@ void GlobalAppSettings::LayerJson(const Json::Value& json)
 
     JsonUtils::GetValueForKey(json, DetectURLsKey, _DetectURLs);
 
+    JsonUtils::GetValueForKey(json, InProcessWindowsKey, _InProcessWindows);
+
+    _InvalidateResolvedSettings();
+
     // This is a helper lambda to get the keybindings and commands out of both
     // and array of objects. We'll use this twice, once on the legacy
     // `keybindings` key, and again on the newer `bindings` key.
@@ -404,9 +420,12 @@ Json::Value GlobalAppSettings::ToJson() const
     JsonUtils::SetValueForKey(json, DebugFeaturesKey,               _DebugFeaturesEnabled);
     JsonUtils::SetValueForKey(json, ForceFullRepaintRenderingKey,   _ForceFullRepaintRendering);
     JsonUtils::SetValueForKey(json, SoftwareRenderingKey,           _SoftwareRendering);
+    JsonUtils::SetValueForKey(json, PowerPreferenceKey,             _PowerPreference);
+    JsonUtils::SetValueForKey(json, FrameTimeOverlayKey,            _FrameTimeOverlay);
     JsonUtils::SetValueForKey(json, ForceVTInputKey,                _ForceVTInput);
     JsonUtils::SetValueForKey(json, EnableStartupTaskKey,           _StartOnUserLogin);
     JsonUtils::SetValueForKey(json, AlwaysOnTopKey,                 _AlwaysOnTop);
+    JsonUtils::SetValueForKey(json, TrimWorkingSetWhenMinimizedKey, _TrimWorkingSetWhenMinimized);
     JsonUtils::SetValueForKey(json, TabSwitcherModeKey,             _TabSwitcherMode);
     JsonUtils::SetValueForKey(json, DisableAnimationsKey,           _DisableAnimations);
     JsonUtils::SetValueForKey(json, StartupActionsKey,              _StartupActions);
@@ -414,6 +433,7 @@ Json::Value GlobalAppSettings::ToJson() const
     JsonUtils::SetValueForKey(json, WindowingBehaviorKey,           _WindowingBehavior);
     JsonUtils::SetValueForKey(json, TrimBlockSelectionKey,          _TrimBlockSelection);
     JsonUtils::SetValueForKey(json, DetectURLsKey,                  _DetectURLs);
+    JsonUtils::SetValueForKey(json, InProcessWindowsKey,            _InProcessWindows);
     // clang-format on
 
     json[JsonKey(ActionsKey)] = _actionMap->ToJson();
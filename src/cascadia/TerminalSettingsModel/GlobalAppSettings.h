@@ -81,10 +81,13 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, SnapToGridOnResize, true);
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, ForceFullRepaintRendering, false);
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, SoftwareRendering, false);
+        INHERITABLE_SETTING(Model::GlobalAppSettings, winrt::Microsoft::Terminal::Control::GraphicsPowerPreference, PowerPreference, winrt::Microsoft::Terminal::Control::GraphicsPowerPreference::Automatic);
+        INHERITABLE_SETTING(Model::GlobalAppSettings, bool, FrameTimeOverlay, false);
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, ForceVTInput, false);
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, DebugFeaturesEnabled, _getDefaultDebugFeaturesValue());
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, StartOnUserLogin, false);
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, AlwaysOnTop, false);
+        INHERITABLE_SETTING(Model::GlobalAppSettings, bool, TrimWorkingSetWhenMinimized, false);
         INHERITABLE_SETTING(Model::GlobalAppSettings, Model::TabSwitcherMode, TabSwitcherMode, Model::TabSwitcherMode::InOrder);
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, DisableAnimations, false);
         INHERITABLE_SETTING(Model::GlobalAppSettings, hstring, StartupActions, L"");
@@ -92,6 +95,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         INHERITABLE_SETTING(Model::GlobalAppSettings, Model::WindowingMode, WindowingBehavior, Model::WindowingMode::UseNew);
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, TrimBlockSelection, false);
         INHERITABLE_SETTING(Model::GlobalAppSettings, bool, DetectURLs, true);
+        INHERITABLE_SETTING(Model::GlobalAppSettings, bool, InProcessWindows, false);
 
     private:
         guid _defaultProfile;
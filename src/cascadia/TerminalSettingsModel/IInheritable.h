@@ -44,17 +44,20 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         void ClearParents()
         {
             _parents.clear();
+            _InvalidateResolvedSettings();
         }
 
         void InsertParent(com_ptr<T> parent)
         {
             _parents.push_back(parent);
+            _InvalidateResolvedSettings();
         }
 
         void InsertParent(size_t index, com_ptr<T> parent)
         {
             auto pos{ _parents.begin() + index };
             _parents.insert(pos, parent);
+            _InvalidateResolvedSettings();
         }
 
         const std::vector<com_ptr<T>>& Parents()
@@ -65,6 +68,28 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
     protected:
         std::vector<com_ptr<T>> _parents{};
 
+        // The getters remember the value they resolved from the parents, so that
+        // the chain is only walked the first time a setting is read. Any change
+        // to a setting (or to the parents) of any T starts a new generation,
+        // which makes all of the remembered values stale at once.
+        // Classes whose settings are written directly (and not through the
+        // setters) outside of LayerJson can opt out by hiding this constant.
+        static constexpr bool _cacheResolvedSettings{ true };
+        static inline std::atomic<uint64_t> _resolvedGeneration{ 1 };
+
+        static uint64_t _CurrentResolvedGeneration() noexcept
+        {
+            return _resolvedGeneration.load(std::memory_order_relaxed);
+        }
+
+        // Method Description:
+        // - Makes the getters of every T resolve their values again. Call this
+        //   after writing settings directly, without going through the setters.
+        static void _InvalidateResolvedSettings() noexcept
+        {
+            _resolvedGeneration.fetch_add(1, std::memory_order_relaxed);
+        }
+
         // Method Description:
         // - Actions to be performed after a child was created. Generally used to set
         //   any extraneous data from the parent into the child.
@@ -84,7 +109,7 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
 // inheritable setting property. This is similar to the WINRT_PROPERTY macro, except...
 // - Has(): checks if the user explicitly set a value for this setting
 // - SourceGetter(): return the object that provides the resolved value
-// - Getter(): return the resolved value
+// - Getter(): return the resolved value (remembered until any setting changes)
 // - Setter(): set the value directly
 // - Clear(): clear the user set value
 // - the setting is saved as an optional, where nullopt means
@@ -117,24 +142,40 @@ public:                                                                     \
     /* fallback: user set value --> inherited value --> system set value */ \
     type name() const                                                       \
     {                                                                       \
-        const auto val{ _get##name##Impl() };                               \
-        return val ? *val : type{ __VA_ARGS__ };                            \
+        if constexpr (!_cacheResolvedSettings)                              \
+        {                                                                   \
+            const auto val{ _get##name##Impl() };                           \
+            return val ? *val : type{ __VA_ARGS__ };                        \
+        }                                                                   \
+                                                                            \
+        const auto generation{ _CurrentResolvedGeneration() };              \
+        if (_resolved##name##Generation != generation)                      \
+        {                                                                   \
+            const auto val{ _get##name##Impl() };                           \
+            _resolved##name = val ? *val : type{ __VA_ARGS__ };             \
+            _resolved##name##Generation = generation;                       \
+        }                                                                   \
+        return _resolved##name;                                             \
     }                                                                       \
                                                                             \
     /* Overwrite the user set value */                                      \
     void name(const type& value)                                            \
     {                                                                       \
         _##name = value;                                                    \
+        _InvalidateResolvedSettings();                                      \
     }                                                                       \
                                                                             \
     /* Clear the user set value */                                          \
     void Clear##name()                                                      \
     {                                                                       \
         _##name = std::nullopt;                                             \
+        _InvalidateResolvedSettings();                                      \
     }                                                                       \
                                                                             \
 private:                                                                    \
     std::optional<type> _##name{ std::nullopt };                            \
+    mutable type _resolved##name{};                                         \
+    mutable uint64_t _resolved##name##Generation{ 0 };                      \
     std::optional<type> _get##name##Impl() const                            \
     {                                                                       \
         /*return user set value*/                                           \
@@ -210,16 +251,18 @@ public:                                                                     \
     /* fallback: user set value --> inherited value --> system set value */ \
     winrt::Windows::Foundation::IReference<type> name() const               \
     {                                                                       \
-        const auto val{ _get##name##Impl() };                               \
-        if (val)                                                            \
+        if constexpr (!_cacheResolvedSettings)                              \
         {                                                                   \
-            if (*val)                                                       \
-            {                                                               \
-                return **val;                                               \
-            }                                                               \
-            return nullptr;                                                 \
+            return _resolve##name();                                        \
         }                                                                   \
-        return winrt::Windows::Foundation::IReference<type>{ __VA_ARGS__ }; \
+                                                                            \
+        const auto generation{ _CurrentResolvedGeneration() };              \
+        if (_resolved##name##Generation != generation)                      \
+        {                                                                   \
+            _resolved##name = _resolve##name();                             \
+            _resolved##name##Generation = generation;                       \
+        }                                                                   \
+        return _resolved##name;                                             \
     }                                                                       \
                                                                             \
     /* Overwrite the user set value */                                      \
@@ -234,16 +277,33 @@ public:                                                                     \
             /* note we're setting the _inner_ value */                      \
             _##name = std::optional<type>{ std::nullopt };                  \
         }                                                                   \
+        _InvalidateResolvedSettings();                                      \
     }                                                                       \
                                                                             \
     /* Clear the user set value */                                          \
     void Clear##name()                                                      \
     {                                                                       \
         _##name = std::nullopt;                                             \
+        _InvalidateResolvedSettings();                                      \
     }                                                                       \
                                                                             \
 private:                                                                    \
     NullableSetting<type> _##name{};                                        \
+    mutable winrt::Windows::Foundation::IReference<type> _resolved##name{}; \
+    mutable uint64_t _resolved##name##Generation{ 0 };                      \
+    winrt::Windows::Foundation::IReference<type> _resolve##name() const     \
+    {                                                                       \
+        const auto val{ _get##name##Impl() };                               \
+        if (val)                                                            \
+        {                                                                   \
+            if (*val)                                                       \
+            {                                                               \
+                return **val;                                               \
+            }                                                               \
+            return nullptr;                                                 \
+        }                                                                   \
+        return winrt::Windows::Foundation::IReference<type>{ __VA_ARGS__ }; \
+    }                                                                       \
     NullableSetting<type> _get##name##Impl() const                          \
     {                                                                       \
         /*return user set value*/                                           \
@@ -0,0 +1,397 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "JsonCache.h"
+
+using namespace Microsoft::Terminal::Settings::Model;
+
+// The file starts with the signature and the version, followed by the entries:
+//   hash of the text (8 bytes), size of the text (8 bytes), size of the blob (8 bytes), blob
+// Each value in a blob is its type, its offsets in the text and then its contents.
+// Bump the version whenever any of this changes.
+static constexpr std::string_view CacheSignature{ "WTJSONC" };
+static constexpr uint8_t CacheVersion{ 1 };
+
+// jsoncpp refuses to parse documents nested deeper than that (its stackLimit).
+static constexpr size_t MaxDepth{ 1000 };
+
+namespace
+{
+    class Encoder
+    {
+    public:
+        explicit Encoder(std::string& out) noexcept :
+            _out{ out }
+        {
+        }
+
+        void Encode(const Json::Value& value)
+        {
+            _out.push_back(static_cast<char>(value.type()));
+            _Varint(gsl::narrow_cast<uint64_t>(std::max<ptrdiff_t>(value.getOffsetStart(), 0)));
+            _Varint(gsl::narrow_cast<uint64_t>(std::max<ptrdiff_t>(value.getOffsetLimit(), 0)));
+
+            switch (value.type())
+            {
+            case Json::intValue:
+            {
+                // zig-zag, so that small negative numbers stay small
+                const auto i = value.asLargestInt();
+                _Varint((static_cast<uint64_t>(i) << 1) ^ static_cast<uint64_t>(i >> 63));
+                break;
+            }
+            case Json::uintValue:
+                _Varint(value.asLargestUInt());
+                break;
+            case Json::realValue:
+            {
+                const auto d = value.asDouble();
+                _out.append(reinterpret_cast<const char*>(&d), sizeof(d));
+                break;
+            }
+            case Json::stringValue:
+            {
+                const char* begin = nullptr;
+                const char* end = nullptr;
+                value.getString(&begin, &end);
+                _String(begin, end);
+                break;
+            }
+            case Json::booleanValue:
+                _out.push_back(value.asBool() ? 1 : 0);
+                break;
+            case Json::arrayValue:
+                _Varint(value.size());
+                for (const auto& item : value)
+                {
+                    Encode(item);
+                }
+                break;
+            case Json::objectValue:
+                _Varint(value.size());
+                for (auto it = value.begin(); it != value.end(); ++it)
+                {
+                    const char* end = nullptr;
+                    const auto begin = it.memberName(&end);
+                    _String(begin, end);
+                    Encode(*it);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+    private:
+        void _Varint(uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                _out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+            _out.push_back(static_cast<char>(value));
+        }
+
+        void _String(const char* begin, const char* end)
+        {
+            const auto size = gsl::narrow_cast<size_t>(end - begin);
+            _Varint(size);
+            _out.append(begin, size);
+        }
+
+        std::string& _out;
+    };
+
+    // Every read is bounds checked, so that a damaged file
+    // makes the lookup fail instead of reading out of bounds.
+    class Decoder
+    {
+    public:
+        explicit Decoder(const std::string_view in) noexcept :
+            _it{ in.data() },
+            _end{ in.data() + in.size() }
+        {
+        }
+
+        Json::Value Decode(const size_t depth = 0)
+        {
+            THROW_HR_IF(E_UNEXPECTED, depth > MaxDepth);
+
+            const auto type = static_cast<Json::ValueType>(_Byte());
+            const auto start = _Varint();
+            const auto limit = _Varint();
+
+            Json::Value value;
+            switch (type)
+            {
+            case Json::nullValue:
+                break;
+            case Json::intValue:
+            {
+                const auto zigzag = _Varint();
+                value = Json::Value{ static_cast<Json::Value::LargestInt>((zigzag >> 1) ^ (0 - (zigzag & 1))) };
+                break;
+            }
+            case Json::uintValue:
+                value = Json::Value{ static_cast<Json::Value::LargestUInt>(_Varint()) };
+                break;
+            case Json::realValue:
+            {
+                double d;
+                memcpy(&d, _Bytes(sizeof(d)), sizeof(d));
+                value = Json::Value{ d };
+                break;
+            }
+            case Json::stringValue:
+            {
+                const auto string = _String();
+                value = Json::Value{ string.data(), string.data() + string.size() };
+                break;
+            }
+            case Json::booleanValue:
+                value = Json::Value{ _Byte() != 0 };
+                break;
+            case Json::arrayValue:
+            {
+                value = Json::Value{ Json::arrayValue };
+                for (auto count = _Varint(); count > 0; --count)
+                {
+                    value.append(Decode(depth + 1));
+                }
+                break;
+            }
+            case Json::objectValue:
+            {
+                value = Json::Value{ Json::objectValue };
+                for (auto count = _Varint(); count > 0; --count)
+                {
+                    const auto key = _String();
+                    *value.demand(key.data(), key.data() + key.size()) = Decode(depth + 1);
+                }
+                break;
+            }
+            default:
+                THROW_HR(E_UNEXPECTED);
+            }
+
+            value.setOffsetStart(gsl::narrow_cast<ptrdiff_t>(start));
+            value.setOffsetLimit(gsl::narrow_cast<ptrdiff_t>(limit));
+            return value;
+        }
+
+        bool AtEnd() const noexcept
+        {
+            return _it == _end;
+        }
+
+    private:
+        const char* _Bytes(const size_t count)
+        {
+            THROW_HR_IF(E_UNEXPECTED, gsl::narrow_cast<size_t>(_end - _it) < count);
+            const auto bytes = _it;
+            _it += count;
+            return bytes;
+        }
+
+        uint8_t _Byte()
+        {
+            return static_cast<uint8_t>(*_Bytes(1));
+        }
+
+        uint64_t _Varint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                const auto byte = _Byte();
+                value |= uint64_t{ byte & 0x7fu } << shift;
+                if (byte < 0x80)
+                {
+                    return value;
+                }
+            }
+            THROW_HR(E_UNEXPECTED);
+        }
+
+        std::string_view _String()
+        {
+            const auto size = _Varint();
+            THROW_HR_IF(E_UNEXPECTED, size > gsl::narrow_cast<uint64_t>(_end - _it));
+            const auto length = gsl::narrow_cast<size_t>(size);
+            return { _Bytes(length), length };
+        }
+
+        const char* _it;
+        const char* _end;
+    };
+
+    void AppendUint64(std::string& out, const uint64_t value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    uint64_t ReadUint64(std::string_view& in)
+    {
+        THROW_HR_IF(E_UNEXPECTED, in.size() < sizeof(uint64_t));
+        uint64_t value;
+        memcpy(&value, in.data(), sizeof(value));
+        in.remove_prefix(sizeof(value));
+        return value;
+    }
+}
+
+// Method Description:
+// - Opens the cache stored in the given file, if there's one. A cache that
+//   can't be read is treated as if it was empty, and replaced on Save().
+// Arguments:
+// - path: the path of the cache file
+JsonCache::JsonCache(std::filesystem::path path) noexcept :
+    _path{ std::move(path) }
+{
+    try
+    {
+        _file.reset(CreateFileW(_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!_file)
+        {
+            return;
+        }
+
+        LARGE_INTEGER size{};
+        THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(_file.get(), &size));
+        if (size.QuadPart < gsl::narrow_cast<LONGLONG>(CacheSignature.size() + 1))
+        {
+            _dirty = true;
+            return;
+        }
+
+        _mapping.reset(CreateFileMappingW(_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+        THROW_LAST_ERROR_IF(!_mapping);
+        _view.reset(static_cast<char*>(MapViewOfFile(_mapping.get(), FILE_MAP_READ, 0, 0, 0)));
+        THROW_LAST_ERROR_IF(!_view);
+
+        std::string_view contents{ _view.get(), gsl::narrow_cast<size_t>(size.QuadPart) };
+        if (contents.substr(0, CacheSignature.size()) != CacheSignature ||
+            static_cast<uint8_t>(contents[CacheSignature.size()]) != CacheVersion)
+        {
+            _dirty = true;
+            return;
+        }
+        contents.remove_prefix(CacheSignature.size() + 1);
+
+        while (!contents.empty())
+        {
+            const auto hash = ReadUint64(contents);
+            const auto textSize = ReadUint64(contents);
+            const auto blobSize = ReadUint64(contents);
+            THROW_HR_IF(E_UNEXPECTED, blobSize > contents.size());
+            _entries.emplace(hash, Entry{ textSize, contents.substr(0, gsl::narrow_cast<size_t>(blobSize)) });
+            contents.remove_prefix(gsl::narrow_cast<size_t>(blobSize));
+        }
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        _entries.clear();
+        _dirty = true;
+    }
+}
+
+// Method Description:
+// - Looks up the document that was parsed from the given text.
+// Arguments:
+// - text: the text of the document
+// Return Value:
+// - the document, or nullopt if it isn't in the cache
+std::optional<Json::Value> JsonCache::Find(const std::string_view text)
+{
+    const auto hash = _Hash(text);
+    const auto it = _entries.find(hash);
+    if (it == _entries.end() || it->second.textSize != text.size())
+    {
+        return std::nullopt;
+    }
+
+    try
+    {
+        Decoder decoder{ it->second.blob };
+        auto value = decoder.Decode();
+        THROW_HR_IF(E_UNEXPECTED, !decoder.AtEnd());
+        _used.insert_or_assign(hash, std::pair{ it->second.textSize, std::string{ it->second.blob } });
+        return value;
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        _entries.erase(it);
+        _dirty = true;
+        return std::nullopt;
+    }
+}
+
+// Method Description:
+// - Adds the document that was parsed from the given text.
+// Arguments:
+// - text: the text of the document
+// - value: the document
+void JsonCache::Store(const std::string_view text, const Json::Value& value)
+{
+    std::string blob;
+    Encoder{ blob }.Encode(value);
+    _used.insert_or_assign(_Hash(text), std::pair{ gsl::narrow_cast<uint64_t>(text.size()), std::move(blob) });
+    _dirty = true;
+}
+
+// Method Description:
+// - Writes the documents that were looked up or stored back to the file, if
+//   that changes what the file holds. The cache is empty afterwards.
+void JsonCache::Save()
+{
+    if (!_dirty && _used.size() == _entries.size())
+    {
+        return;
+    }
+
+    std::string contents{ CacheSignature };
+    contents.push_back(static_cast<char>(CacheVersion));
+    for (const auto& [hash, entry] : _used)
+    {
+        AppendUint64(contents, hash);
+        AppendUint64(contents, entry.first);
+        AppendUint64(contents, entry.second.size());
+        contents.append(entry.second);
+    }
+
+    // The file can't be replaced while it's mapped.
+    _entries.clear();
+    _view.reset();
+    _mapping.reset();
+    _file.reset();
+
+    // Write the new cache next to the old one and swap them, so that
+    // a cache that was only partially written is never read.
+    auto tempPath{ _path };
+    tempPath += L".tmp";
+    {
+        wil::unique_hfile file{ CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        THROW_LAST_ERROR_IF(!file);
+        DWORD written = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), contents.data(), gsl::narrow<DWORD>(contents.size()), &written, nullptr));
+    }
+    THROW_IF_WIN32_BOOL_FALSE(MoveFileExW(tempPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING));
+    _used.clear();
+    _dirty = false;
+}
+
+// FNV-1a
+uint64_t JsonCache::_Hash(const std::string_view text) noexcept
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const auto ch : text)
+    {
+        hash ^= static_cast<uint8_t>(ch);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
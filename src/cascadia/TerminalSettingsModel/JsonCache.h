@@ -0,0 +1,53 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- JsonCache.h
+
+Abstract:
+- A cache of parsed JSON documents, so that the settings files that didn't
+  change since the last launch don't have to be parsed again.
+- The documents are stored in a compact binary form next to the settings file,
+  keyed by a hash of the text they were parsed from. The file is mapped into
+  memory when the cache is opened, and a document is only decoded when the
+  same text is looked up again.
+- The offsets of the values in the text are kept (they're used to patch the
+  user's settings file), but the comments aren't.
+
+--*/
+#pragma once
+
+namespace Microsoft::Terminal::Settings::Model
+{
+    class JsonCache
+    {
+    public:
+        explicit JsonCache(std::filesystem::path path) noexcept;
+
+        std::optional<Json::Value> Find(const std::string_view text);
+        void Store(const std::string_view text, const Json::Value& value);
+        void Save();
+
+    private:
+        struct Entry
+        {
+            uint64_t textSize;
+            std::string_view blob;
+        };
+
+        static uint64_t _Hash(const std::string_view text) noexcept;
+
+        std::filesystem::path _path;
+        wil::unique_hfile _file;
+        wil::unique_handle _mapping;
+        wil::unique_mapview_ptr<char> _view;
+
+        // The documents in the file, which are only valid as long as _view is.
+        std::unordered_map<uint64_t, Entry> _entries;
+        // The documents that were looked up or stored since, in their binary form.
+        // These are the ones Save() writes, so that the stale ones are dropped.
+        std::map<uint64_t, std::pair<uint64_t, std::string>> _used;
+        bool _dirty{ false };
+    };
+}
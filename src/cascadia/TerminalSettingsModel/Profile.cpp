@@ -45,6 +45,9 @@ static constexpr std::string_view PaddingKey{ "padding" };
 static constexpr std::string_view StartingDirectoryKey{ "startingDirectory" };
 static constexpr std::string_view IconKey{ "icon" };
 static constexpr std::string_view AntialiasingModeKey{ "antialiasingMode" };
+static constexpr std::string_view GlyphAtlasRenderingKey{ "experimental.rendering.glyphAtlas" };
+static constexpr std::string_view SmoothScrollingKey{ "experimental.rendering.smoothScrolling" };
+static constexpr std::string_view PixelShaderFrameRateKey{ "experimental.pixelShaderFrameRate" };
 static constexpr std::string_view TabColorKey{ "tabColor" };
 static constexpr std::string_view BellStyleKey{ "bellStyle" };
 static constexpr std::string_view UnfocusedAppearanceKey{ "unfocusedAppearance" };
@@ -83,6 +86,9 @@ winrt::com_ptr<Profile> Profile::CopySettings(winrt::com_ptr<Profile> source)
     profile->_Commandline = source->_Commandline;
     profile->_StartingDirectory = source->_StartingDirectory;
     profile->_AntialiasingMode = source->_AntialiasingMode;
+    profile->_GlyphAtlasRendering = source->_GlyphAtlasRendering;
+    profile->_SmoothScrolling = source->_SmoothScrolling;
+    profile->_PixelShaderFrameRate = source->_PixelShaderFrameRate;
     profile->_ForceFullRepaintRendering = source->_ForceFullRepaintRendering;
     profile->_SoftwareRendering = source->_SoftwareRendering;
     profile->_HistorySize = source->_HistorySize;
@@ -348,6 +354,9 @@ void Profile::LayerJson(const Json::Value& json)
 
     JsonUtils::GetValueForKey(json, IconKey, _Icon);
     JsonUtils::GetValueForKey(json, AntialiasingModeKey, _AntialiasingMode);
+    JsonUtils::GetValueForKey(json, GlyphAtlasRenderingKey, _GlyphAtlasRendering);
+    JsonUtils::GetValueForKey(json, SmoothScrollingKey, _SmoothScrolling);
+    JsonUtils::GetValueForKey(json, PixelShaderFrameRateKey, _PixelShaderFrameRate);
     JsonUtils::GetValueForKey(json, TabColorKey, _TabColor);
     JsonUtils::GetValueForKey(json, BellStyleKey, _BellStyle);
 
@@ -364,6 +373,8 @@ void Profile::LayerJson(const Json::Value& json)
         unfocusedAppearance->LayerJson(json[JsonKey(UnfocusedAppearanceKey)]);
         _UnfocusedAppearance = *unfocusedAppearance;
     }
+
+    _InvalidateResolvedSettings();
 }
 
 winrt::hstring Profile::EvaluatedStartingDirectory() const
@@ -527,6 +538,9 @@ Json::Value Profile::ToJson() const
     JsonUtils::SetValueForKey(json, StartingDirectoryKey, _StartingDirectory);
     JsonUtils::SetValueForKey(json, IconKey, _Icon);
     JsonUtils::SetValueForKey(json, AntialiasingModeKey, _AntialiasingMode);
+    JsonUtils::SetValueForKey(json, GlyphAtlasRenderingKey, _GlyphAtlasRendering);
+    JsonUtils::SetValueForKey(json, SmoothScrollingKey, _SmoothScrolling);
+    JsonUtils::SetValueForKey(json, PixelShaderFrameRateKey, _PixelShaderFrameRate);
     JsonUtils::SetValueForKey(json, TabColorKey, _TabColor);
     JsonUtils::SetValueForKey(json, BellStyleKey, _BellStyle);
 
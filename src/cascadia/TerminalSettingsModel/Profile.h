@@ -130,6 +130,9 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         INHERITABLE_SETTING(Model::Profile, hstring, StartingDirectory);
 
         INHERITABLE_SETTING(Model::Profile, Microsoft::Terminal::Control::TextAntialiasingMode, AntialiasingMode, Microsoft::Terminal::Control::TextAntialiasingMode::Grayscale);
+        INHERITABLE_SETTING(Model::Profile, bool, GlyphAtlasRendering, false);
+        INHERITABLE_SETTING(Model::Profile, bool, SmoothScrolling, false);
+        INHERITABLE_SETTING(Model::Profile, int32_t, PixelShaderFrameRate, 0);
         INHERITABLE_SETTING(Model::Profile, bool, ForceFullRepaintRendering, false);
         INHERITABLE_SETTING(Model::Profile, bool, SoftwareRendering, false);
 
@@ -241,6 +241,81 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         return nullptr;
     }
 
+    // Method Description:
+    // - Compares the settings a control would get from us and from the given
+    //   TerminalSettings, so that a control doesn't have to be updated on a
+    //   settings reload that didn't change anything it uses.
+    // - The settings that are only used when a terminal is created (like the
+    //   commandline or the initial size) aren't compared, since they can't
+    //   change the terminals that already exist.
+    // Arguments:
+    // - other: the settings to compare with
+    // Return Value:
+    // - true if a control would behave the same with either
+    bool TerminalSettings::HasSameSettings(const Model::TerminalSettings& other)
+    {
+        if (!other)
+        {
+            return false;
+        }
+
+        const auto otherImpl = get_self<TerminalSettings>(other);
+        if (otherImpl == this)
+        {
+            return true;
+        }
+
+        const auto sameReference = [](const auto& lhs, const auto& rhs) {
+            return static_cast<bool>(lhs) == static_cast<bool>(rhs) && (!lhs || lhs.Value() == rhs.Value());
+        };
+
+#define SAME_SETTING(name) (name() == otherImpl->name())
+        return SAME_SETTING(DefaultForeground) &&
+               SAME_SETTING(DefaultBackground) &&
+               SAME_SETTING(SelectionBackground) &&
+               SAME_SETTING(HistorySize) &&
+               SAME_SETTING(SnapOnInput) &&
+               SAME_SETTING(AltGrAliasing) &&
+               SAME_SETTING(CursorColor) &&
+               SAME_SETTING(CursorShape) &&
+               SAME_SETTING(CursorHeight) &&
+               SAME_SETTING(WordDelimiters) &&
+               SAME_SETTING(CopyOnSelect) &&
+               SAME_SETTING(InputServiceWarning) &&
+               SAME_SETTING(FocusFollowMouse) &&
+               SAME_SETTING(TrimBlockSelection) &&
+               SAME_SETTING(DetectURLs) &&
+               sameReference(TabColor(), otherImpl->TabColor()) &&
+               SAME_SETTING(ProfileName) &&
+               SAME_SETTING(UseAcrylic) &&
+               SAME_SETTING(TintOpacity) &&
+               SAME_SETTING(Padding) &&
+               SAME_SETTING(FontFace) &&
+               SAME_SETTING(FontSize) &&
+               FontWeight().Weight == otherImpl->FontWeight().Weight &&
+               SAME_SETTING(BackgroundImage) &&
+               SAME_SETTING(BackgroundImageOpacity) &&
+               SAME_SETTING(BackgroundImageStretchMode) &&
+               SAME_SETTING(BackgroundImageHorizontalAlignment) &&
+               SAME_SETTING(BackgroundImageVerticalAlignment) &&
+               SAME_SETTING(KeyBindings) &&
+               SAME_SETTING(SuppressApplicationTitle) &&
+               SAME_SETTING(ScrollState) &&
+               SAME_SETTING(AntialiasingMode) &&
+               SAME_SETTING(RetroTerminalEffect) &&
+               SAME_SETTING(ForceFullRepaintRendering) &&
+               SAME_SETTING(SoftwareRendering) &&
+               SAME_SETTING(PowerPreference) &&
+               SAME_SETTING(FrameTimeOverlay) &&
+               SAME_SETTING(GlyphAtlasRendering) &&
+               SAME_SETTING(SmoothScrolling) &&
+               SAME_SETTING(PixelShaderFrameRate) &&
+               SAME_SETTING(ForceVTInput) &&
+               SAME_SETTING(PixelShaderPath) &&
+               SAME_SETTING(ColorTable);
+#undef SAME_SETTING
+    }
+
     // Method Description:
     // - Apply Profile settings, as well as any colors from our color scheme, if we have one.
     // Arguments:
@@ -281,6 +356,9 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         _ScrollState = profile.ScrollState();
 
         _AntialiasingMode = profile.AntialiasingMode();
+        _GlyphAtlasRendering = profile.GlyphAtlasRendering();
+        _SmoothScrolling = profile.SmoothScrolling();
+        _PixelShaderFrameRate = profile.PixelShaderFrameRate();
 
         if (profile.TabColor())
         {
@@ -305,6 +383,8 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         _FocusFollowMouse = globalSettings.FocusFollowMouse();
         _ForceFullRepaintRendering = globalSettings.ForceFullRepaintRendering();
         _SoftwareRendering = globalSettings.SoftwareRendering();
+        _PowerPreference = globalSettings.PowerPreference();
+        _FrameTimeOverlay = globalSettings.FrameTimeOverlay();
         _ForceVTInput = globalSettings.ForceVTInput();
         _TrimBlockSelection = globalSettings.TrimBlockSelection();
         _DetectURLs = globalSettings.DetectURLs();
@@ -69,6 +69,8 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
 
         void ApplyColorScheme(const Model::ColorScheme& scheme);
 
+        bool HasSameSettings(const Model::TerminalSettings& other);
+
         // --------------------------- Core Settings ---------------------------
         //  All of these settings are defined in ICoreSettings.
 
@@ -142,11 +144,20 @@ namespace winrt::Microsoft::Terminal::Settings::Model::implementation
         INHERITABLE_SETTING(Model::TerminalSettings, bool, RetroTerminalEffect, false);
         INHERITABLE_SETTING(Model::TerminalSettings, bool, ForceFullRepaintRendering, false);
         INHERITABLE_SETTING(Model::TerminalSettings, bool, SoftwareRendering, false);
+        INHERITABLE_SETTING(Model::TerminalSettings, Microsoft::Terminal::Control::GraphicsPowerPreference, PowerPreference, Microsoft::Terminal::Control::GraphicsPowerPreference::Automatic);
+        INHERITABLE_SETTING(Model::TerminalSettings, bool, FrameTimeOverlay, false);
+        INHERITABLE_SETTING(Model::TerminalSettings, bool, GlyphAtlasRendering, false);
+        INHERITABLE_SETTING(Model::TerminalSettings, bool, SmoothScrolling, false);
+        INHERITABLE_SETTING(Model::TerminalSettings, int32_t, PixelShaderFrameRate, 0);
         INHERITABLE_SETTING(Model::TerminalSettings, bool, ForceVTInput, false);
 
         INHERITABLE_SETTING(Model::TerminalSettings, hstring, PixelShaderPath);
 
     private:
+        // Our settings are written directly when they're applied from a profile,
+        // and the chains are short (the control's overrides and the profile).
+        static constexpr bool _cacheResolvedSettings{ false };
+
         std::optional<std::array<Microsoft::Terminal::Core::Color, COLOR_TABLE_SIZE>> _ColorTable;
         gsl::span<Microsoft::Terminal::Core::Color> _getColorTableImpl();
         void _ApplyProfileSettings(const Model::Profile& profile);
@@ -104,6 +104,15 @@ JSON_ENUM_MAPPER(::winrt::Microsoft::Terminal::Control::TextAntialiasingMode)
     };
 };
 
+JSON_ENUM_MAPPER(::winrt::Microsoft::Terminal::Control::GraphicsPowerPreference)
+{
+    static constexpr std::array<pair_type, 3> mappings = {
+        pair_type{ "automatic", ValueType::Automatic },
+        pair_type{ "powerSaver", ValueType::PowerSaver },
+        pair_type{ "highPerformance", ValueType::HighPerformance }
+    };
+};
+
 // Type Description:
 // - Helper for converting a user-specified closeOnExit value to its corresponding enum
 JSON_ENUM_MAPPER(::winrt::Microsoft::Terminal::Settings::Model::CloseOnExitMode)
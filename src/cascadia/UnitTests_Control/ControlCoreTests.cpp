@@ -32,6 +32,11 @@ namespace ControlUnitTests
 
         TEST_METHOD(TestFontInitializedInCtor);
 
+        TEST_METHOD(TestOutputWrittenOnOutputThread);
+        TEST_METHOD(TestOutputInFlightIsBounded);
+        TEST_METHOD(TestBackgroundSuppressesEvents);
+        TEST_METHOD(TestUiStateCoalescedPerFrame);
+
         TEST_CLASS_SETUP(ModuleSetup)
         {
             winrt::init_apartment(winrt::apartment_type::single_threaded);
@@ -197,4 +202,150 @@ namespace ControlUnitTests
         VERIFY_ARE_EQUAL(L"Impact", std::wstring_view{ core->_actualFont.GetFaceName() });
     }
 
+    void ControlCoreTests::TestOutputWrittenOnOutputThread()
+    {
+        auto [settings, conn] = _createSettingsAndConnection();
+
+        Log::Comment(L"Create ControlCore object");
+        auto core = winrt::make_self<Control::implementation::ControlCore>(*settings, *conn);
+        VERIFY_IS_NOT_NULL(core);
+        core->Initialize(270, 420, 1.0);
+
+        std::thread::id outputThread;
+        core->ReceivedOutput([&](auto&&, auto&&) {
+            outputThread = std::this_thread::get_id();
+        });
+
+        Log::Comment(L"Write more chunks than fit into the queue at once");
+        for (int i = 0; i < 200; ++i)
+        {
+            conn->WriteInput(L"Foo\r\n");
+        }
+        core->_waitForOutputIdle();
+
+        VERIFY_ARE_NOT_EQUAL(std::this_thread::get_id(), outputThread);
+        VERIFY_ARE_EQUAL(201, core->BufferHeight());
+
+        Log::Comment(L"Output after closing the core is dropped");
+        core->Close();
+        conn->WriteInput(L"Foo\r\n");
+        VERIFY_ARE_EQUAL(201, core->BufferHeight());
+    }
+
+    void ControlCoreTests::TestOutputInFlightIsBounded()
+    {
+        auto [settings, conn] = _createSettingsAndConnection();
+
+        Log::Comment(L"Create ControlCore object");
+        auto core = winrt::make_self<Control::implementation::ControlCore>(*settings, *conn);
+        VERIFY_IS_NOT_NULL(core);
+        core->Initialize(270, 420, 1.0);
+
+        size_t maxInFlight = 0;
+        core->ReceivedOutput([&](auto&&, auto&&) {
+            std::lock_guard guard{ core->_outputLock };
+            maxInFlight = std::max(maxInFlight, core->_outputInFlight);
+        });
+
+        Log::Comment(L"Write more output than the budget allows in flight");
+        const std::wstring chunk(Control::implementation::ControlCore::_outputBudget / 3, L'x');
+        for (int i = 0; i < 8; ++i)
+        {
+            conn->WriteInput(winrt::hstring{ chunk });
+        }
+        core->_waitForOutputIdle();
+
+        VERIFY_IS_LESS_THAN_OR_EQUAL(maxInFlight, Control::implementation::ControlCore::_outputBudget);
+        VERIFY_ARE_EQUAL(0u, core->_outputInFlight);
+
+        Log::Comment(L"A chunk larger than the budget still gets through");
+        conn->WriteInput(winrt::hstring{ std::wstring(Control::implementation::ControlCore::_outputBudget + 1, L'x') });
+        core->_waitForOutputIdle();
+        VERIFY_ARE_EQUAL(0u, core->_outputInFlight);
+    }
+
+    void ControlCoreTests::TestBackgroundSuppressesEvents()
+    {
+        auto [settings, conn] = _createSettingsAndConnection();
+
+        Log::Comment(L"Create ControlCore object");
+        auto core = winrt::make_self<Control::implementation::ControlCore>(*settings, *conn);
+        VERIFY_IS_NOT_NULL(core);
+        core->Initialize(270, 420, 1.0);
+
+        int outputEvents = 0;
+        int scrollEvents = 0;
+        int lastViewTop = -1;
+        core->ReceivedOutput([&](auto&&, auto&&) { ++outputEvents; });
+        core->ScrollPositionChanged([&](auto&&, const Control::ScrollPositionChangedArgs& args) {
+            ++scrollEvents;
+            lastViewTop = args.ViewTop();
+        });
+
+        Log::Comment(L"Output in the background is written to the buffer, without raising any events");
+        core->EnterBackground();
+        for (int i = 0; i < 40; ++i)
+        {
+            conn->WriteInput(L"Foo\r\n");
+        }
+        core->_waitForOutputIdle();
+        VERIFY_ARE_EQUAL(0, outputEvents);
+        VERIFY_ARE_EQUAL(0, scrollEvents);
+        VERIFY_ARE_EQUAL(41, core->BufferHeight());
+
+        Log::Comment(L"Leaving the background raises them once, with the current state");
+        core->LeaveBackground();
+        VERIFY_ARE_EQUAL(1, outputEvents);
+        VERIFY_ARE_EQUAL(1, scrollEvents);
+        VERIFY_ARE_EQUAL(21, lastViewTop);
+
+        Log::Comment(L"Leaving it again doesn't raise anything");
+        core->LeaveBackground();
+        VERIFY_ARE_EQUAL(1, outputEvents);
+        VERIFY_ARE_EQUAL(1, scrollEvents);
+    }
+
+    void ControlCoreTests::TestUiStateCoalescedPerFrame()
+    {
+        auto [settings, conn] = _createSettingsAndConnection();
+
+        Log::Comment(L"Create ControlCore object");
+        auto core = winrt::make_self<Control::implementation::ControlCore>(*settings, *conn);
+        VERIFY_IS_NOT_NULL(core);
+        core->Initialize(270, 420, 1.0);
+
+        int scrollEvents = 0;
+        int lastViewTop = -1;
+        int cursorEvents = 0;
+        int titleEvents = 0;
+        std::wstring lastTitle;
+        core->ScrollPositionChanged([&](auto&&, const Control::ScrollPositionChangedArgs& args) {
+            ++scrollEvents;
+            lastViewTop = args.ViewTop();
+        });
+        core->CursorPositionChanged([&](auto&&, auto&&) { ++cursorEvents; });
+        core->TitleChanged([&](auto&&, const Control::TitleChangedEventArgs& args) {
+            ++titleEvents;
+            lastTitle = std::wstring{ args.Title() };
+        });
+
+        Log::Comment(L"Pretend that frames are painted, without letting the renderer paint any");
+        core->_paintingEnabled = true;
+        for (int i = 0; i < 40; ++i)
+        {
+            conn->WriteInput(winrt::hstring{ fmt::format(L"\x1b]0;title {}\x7" L"Foo\r\n", i) });
+        }
+        core->_waitForOutputIdle();
+        VERIFY_ARE_EQUAL(0, scrollEvents);
+        VERIFY_ARE_EQUAL(0, cursorEvents);
+        VERIFY_ARE_EQUAL(0, titleEvents);
+
+        Log::Comment(L"Once the frame was painted, every event is raised once, with the latest state");
+        core->_publishUiState();
+        VERIFY_ARE_EQUAL(1, scrollEvents);
+        VERIFY_ARE_EQUAL(21, lastViewTop);
+        VERIFY_ARE_EQUAL(1, cursorEvents);
+        VERIFY_ARE_EQUAL(1, titleEvents);
+        VERIFY_ARE_EQUAL(L"title 39", lastTitle);
+    }
 }
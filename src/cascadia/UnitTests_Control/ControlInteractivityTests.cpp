@@ -31,7 +31,9 @@ namespace ControlUnitTests
         TEST_METHOD(CreateSubsequentSelectionWithDragging);
         TEST_METHOD(ScrollWithSelection);
         TEST_METHOD(TestScrollWithTrackpad);
+        TEST_METHOD(TestSmoothScrollWithTrackpad);
         TEST_METHOD(TestQuickDragOnSelect);
+        TEST_METHOD(PointerMovesWithinCellAreDropped);
 
         TEST_CLASS_SETUP(ClassSetup)
         {
@@ -189,6 +191,7 @@ namespace ControlUnitTests
             }
 
             conn->WriteInput(L"Foo\r\n");
+            core->_waitForOutputIdle();
         }
         // We printed that 40 times, but the final \r\n bumped the view down one MORE row.
         VERIFY_ARE_EQUAL(20, core->_terminal->GetViewport().Height());
@@ -349,6 +352,7 @@ namespace ControlUnitTests
         for (int i = 0; i < 40; ++i)
         {
             conn->WriteInput(L"Foo\r\n");
+            core->_waitForOutputIdle();
         }
         // We printed that 40 times, but the final \r\n bumped the view down one MORE row.
         VERIFY_ARE_EQUAL(20, core->_terminal->GetViewport().Height());
@@ -426,6 +430,7 @@ namespace ControlUnitTests
         for (int i = 0; i < 40; ++i)
         {
             conn->WriteInput(L"Foo\r\n");
+            core->_waitForOutputIdle();
         }
         // We printed that 40 times, but the final \r\n bumped the view down one MORE row.
         VERIFY_ARE_EQUAL(20, core->_terminal->GetViewport().Height());
@@ -485,6 +490,7 @@ namespace ControlUnitTests
         VERIFY_ARE_EQUAL(21, core->ScrollOffset());
 
         conn->WriteInput(L"Foo\r\n");
+        core->_waitForOutputIdle();
         VERIFY_ARE_EQUAL(22, core->ScrollOffset());
         interactivity->MouseWheel(modifiers, delta, mousePos, state); // 1/5
         VERIFY_ARE_EQUAL(22, core->ScrollOffset());
@@ -498,6 +504,48 @@ namespace ControlUnitTests
         VERIFY_ARE_EQUAL(21, core->ScrollOffset());
     }
 
+    void ControlInteractivityTests::TestSmoothScrollWithTrackpad()
+    {
+        WEX::TestExecution::DisableVerifyExceptions disableVerifyExceptions{};
+
+        auto [settings, conn] = _createSettingsAndConnection();
+        settings->SmoothScrolling(true);
+        auto [core, interactivity] = _createCoreAndInteractivity(*settings, *conn);
+        _standardInit(core, interactivity);
+        interactivity->_rowsToScroll = 1;
+
+        for (int i = 0; i < 40; ++i)
+        {
+            conn->WriteInput(L"Foo\r\n");
+            core->_waitForOutputIdle();
+        }
+        VERIFY_ARE_EQUAL(21, core->ScrollOffset());
+        VERIFY_ARE_EQUAL(0.0, core->SmoothScrollOffset());
+
+        const auto modifiers = ControlKeyStates();
+        const int delta = WHEEL_DELTA / 4;
+        const til::point mousePos{ 0, 0 };
+        TerminalInput::MouseButtonState state{ false, false, false };
+
+        Log::Comment(L"Scrolling up by a part of a row scrolls the buffer up a row and moves the text down the rest of the way.");
+        interactivity->MouseWheel(modifiers, delta, mousePos, state); // 1/4
+        VERIFY_ARE_EQUAL(20, core->ScrollOffset());
+        VERIFY_ARE_EQUAL(0.75, core->SmoothScrollOffset());
+        interactivity->MouseWheel(modifiers, delta, mousePos, state); // 2/4
+        VERIFY_ARE_EQUAL(20, core->ScrollOffset());
+        VERIFY_ARE_EQUAL(0.5, core->SmoothScrollOffset());
+
+        Log::Comment(L"The text is moved along with the mouse, so selections land on the row under it.");
+        const til::size fontSize{ core->GetFont().GetSize() };
+        const til::point lowerHalfOfFirstRow{ 0, fontSize.height() * 3 / 4 };
+        VERIFY_ARE_EQUAL(1, interactivity->_getTerminalPosition(lowerHalfOfFirstRow).y());
+
+        Log::Comment(L"There's nothing to move the text by at the bottom of the buffer.");
+        interactivity->UpdateScrollbar(21);
+        VERIFY_ARE_EQUAL(21, core->ScrollOffset());
+        VERIFY_ARE_EQUAL(0.0, core->SmoothScrollOffset());
+    }
+
     void ControlInteractivityTests::TestQuickDragOnSelect()
     {
         // This is a test for GH#9955.c
@@ -542,4 +590,53 @@ namespace ControlUnitTests
         COORD expectedAnchor{ 0, 0 };
         VERIFY_ARE_EQUAL(expectedAnchor, core->_terminal->GetSelectionAnchor());
     }
+
+    void ControlInteractivityTests::PointerMovesWithinCellAreDropped()
+    {
+        auto [settings, conn] = _createSettingsAndConnection();
+        auto [core, interactivity] = _createCoreAndInteractivity(*settings, *conn);
+        _standardInit(core, interactivity);
+
+        // For this test, don't use any modifiers
+        const auto modifiers = ControlKeyStates();
+        const TerminalInput::MouseButtonState leftMouseDown{ true, false, false };
+
+        const til::size fontSize{ 9, 21 };
+
+        Log::Comment(L"Click on the terminal and drag just enough to start a selection");
+        interactivity->PointerPressed(leftMouseDown,
+                                      WM_LBUTTONDOWN, //pointerUpdateKind
+                                      0, // timestamp
+                                      modifiers,
+                                      til::point{ 0, 0 });
+        interactivity->PointerMoved(leftMouseDown,
+                                    WM_LBUTTONDOWN, //pointerUpdateKind
+                                    modifiers,
+                                    true, // focused,
+                                    til::point{ 6, 0 });
+        VERIFY_IS_TRUE(core->HasSelection());
+        VERIFY_IS_FALSE(interactivity->_singleClickTouchdownPos.has_value());
+
+        Log::Comment(L"Move the end of the selection behind the back of the interactivity");
+        const COORD movedEnd{ 5, 0 };
+        core->_terminal->SetSelectionEnd(movedEnd);
+
+        Log::Comment(L"A move within the same cell doesn't touch the selection");
+        interactivity->PointerMoved(leftMouseDown,
+                                    WM_LBUTTONDOWN, //pointerUpdateKind
+                                    modifiers,
+                                    true, // focused,
+                                    til::point{ 8, 0 });
+        VERIFY_ARE_EQUAL(movedEnd, core->_terminal->GetSelectionEnd());
+
+        Log::Comment(L"A move into another cell does");
+        const til::point terminalPosition{ 2, 1 };
+        interactivity->PointerMoved(leftMouseDown,
+                                    WM_LBUTTONDOWN, //pointerUpdateKind
+                                    modifiers,
+                                    true, // focused,
+                                    terminalPosition * fontSize);
+        const COORD expectedEnd{ 2, 1 };
+        VERIFY_ARE_EQUAL(expectedEnd, core->_terminal->GetSelectionEnd());
+    }
 }
@@ -76,6 +76,11 @@ namespace ControlUnitTests
         WINRT_PROPERTY(bool, RetroTerminalEffect, false);
         WINRT_PROPERTY(bool, ForceFullRepaintRendering, false);
         WINRT_PROPERTY(bool, SoftwareRendering, false);
+        WINRT_PROPERTY(winrt::Microsoft::Terminal::Control::GraphicsPowerPreference, PowerPreference, winrt::Microsoft::Terminal::Control::GraphicsPowerPreference::Automatic);
+        WINRT_PROPERTY(bool, FrameTimeOverlay, false);
+        WINRT_PROPERTY(bool, GlyphAtlasRendering, false);
+        WINRT_PROPERTY(bool, SmoothScrolling, false);
+        WINRT_PROPERTY(int32_t, PixelShaderFrameRate, 0);
         WINRT_PROPERTY(bool, ForceVTInput, false);
 
         WINRT_PROPERTY(winrt::hstring, PixelShaderPath);
@@ -95,6 +95,7 @@ namespace RemotingUnitTests
         TYPED_EVENT(DisplayWindowIdRequested, winrt::Windows::Foundation::IInspectable, winrt::Windows::Foundation::IInspectable);
         TYPED_EVENT(RenameRequested, winrt::Windows::Foundation::IInspectable, Remoting::RenameRequestArgs);
         TYPED_EVENT(SummonRequested, winrt::Windows::Foundation::IInspectable, Remoting::SummonWindowBehavior);
+        TYPED_EVENT(WindowNameChanged, winrt::Windows::Foundation::IInspectable, winrt::Windows::Foundation::IInspectable);
     };
 
     class RemotingTests
@@ -1303,15 +1304,15 @@ namespace RemotingUnitTests
         Log::Comment(L"Kill peasant 1. Make sure that it gets removed from the monarch.");
         RemotingTests::_killPeasant(m0, p1->GetID());
 
-        // By killing 1, then looking for "two", we happen to iterate over the
-        // corpse of 1 when looking for the peasant named "two". This causes us
-        // to remove 1 while looking for "two". Technically, we shouldn't be
-        // relying on any sort of ordering for an unordered_map iterator, but
-        // this one just so happens to work.
+        // The monarch knows the names of its peasants, so looking for "two"
+        // doesn't need to talk to (the corpse of) 1 at all.
         VERIFY_ARE_EQUAL(p2->GetID(), m0->_lookupPeasantIdForName(L"two"));
+        VERIFY_ARE_EQUAL(2u, m0->_peasants.size());
 
-        Log::Comment(L"Peasant 1 should have been pruned");
+        Log::Comment(L"Peasant 1 should be pruned once we look for it");
+        VERIFY_ARE_EQUAL(0, m0->_lookupPeasantIdForName(L"one"));
         VERIFY_ARE_EQUAL(1u, m0->_peasants.size());
+        VERIFY_ARE_EQUAL(1u, m0->_peasantNames.size());
     }
 
     void RemotingTests::LookupNamedPeasantWhenItDied()
@@ -31,6 +31,7 @@ namespace TerminalCoreUnitTests
         TEST_METHOD(AltShiftKey);
         TEST_METHOD(AltSpace);
         TEST_METHOD(InvalidKeyEvent);
+        TEST_METHOD(EncodeSentKeyEvents);
 
         void _VerifyExpectedInput(std::wstring& actualInput)
         {
@@ -74,4 +75,28 @@ namespace TerminalCoreUnitTests
         VERIFY_IS_FALSE(term.SendKeyEvent(0, 123, {}, true));
         VERIFY_IS_FALSE(term.SendKeyEvent(255, 123, {}, true));
     }
+
+    void InputTest::EncodeSentKeyEvents()
+    {
+        using Mode = Microsoft::Console::VirtualTerminal::TerminalInput::Mode;
+
+        VERIFY_IS_TRUE(term.GetInputModes() == Mode::Ansi);
+
+        // The events that were sent are encoded the way terminals in other modes would encode them.
+        std::vector<KeyEvent> sentEvents;
+        expectedinput = L"\x1b[A";
+        VERIFY_IS_TRUE(term.SendKeyEvent(VK_UP, 0, {}, true, &sentEvents));
+        VERIFY_ARE_EQUAL(1u, sentEvents.size());
+        VERIFY_ARE_EQUAL(std::wstring{ L"\x1b[A" }, Terminal::EncodeKeyEvents(Mode::Ansi, sentEvents));
+        VERIFY_ARE_EQUAL(std::wstring{ L"\x1bOA" }, Terminal::EncodeKeyEvents(Mode::Ansi | Mode::CursorKey, sentEvents));
+        VERIFY_ARE_EQUAL(std::wstring{ L"\x1b" L"A" }, Terminal::EncodeKeyEvents(Mode::None, sentEvents));
+
+        // Both halves of a surrogate pair have to be encoded together.
+        sentEvents.clear();
+        expectedinput = L"\xD83D\xDE00";
+        VERIFY_IS_TRUE(term.SendCharEvent(L'\xD83D', 0, {}, &sentEvents));
+        VERIFY_IS_TRUE(term.SendCharEvent(L'\xDE00', 0, {}, &sentEvents));
+        VERIFY_ARE_EQUAL(4u, sentEvents.size());
+        VERIFY_ARE_EQUAL(expectedinput, Terminal::EncodeKeyEvents(Mode::Ansi, sentEvents));
+    }
 }
@@ -54,6 +54,7 @@ namespace
         };
         virtual void TriggerCircling(){};
         void TriggerTitleChange(){};
+        void SetSynchronizedOutput(const bool){};
 
     private:
         std::optional<COORD> _triggerScrollDelta;
@@ -841,5 +841,41 @@ namespace TerminalCoreUnitTests
                 ValidateSingleRowSelection(term, SMALL_RECT({ 10, 10, 20, 10 }));
             }
         }
+
+        TEST_METHOD(ExtendSelectionIncrementally)
+        {
+            const auto burrito = L"\xD83C\xDF2F";
+            DummyRenderTarget emptyRT;
+            const auto createTerminal = [&](Terminal& term) {
+                term.Create({ 100, 100 }, 0, emptyRT);
+
+                // Wide glyphs on a few rows, so that rows get expanded around them.
+                term.SetCursorPosition(14, 12);
+                term.Write(burrito);
+                term.SetCursorPosition(2, 18);
+                term.Write(burrito);
+            };
+
+            Terminal term;
+            createTerminal(term);
+
+            // Simulate click at (x,y) = (5,10)
+            term.SetSelectionAnchor({ 5, 10 });
+
+            // Simulate dragging the end around, down, back up, and across the anchor.
+            // Every time, the selection must look like one that was made in one go.
+            const COORD ends[]{ { 15, 20 }, { 3, 25 }, { 14, 12 }, { 60, 12 }, { 2, 18 }, { 2, 5 }, { 9, 8 }, { 4, 12 }, { 5, 10 } };
+            for (const auto end : ends)
+            {
+                term.SetSelectionEnd(end);
+
+                Terminal expected;
+                createTerminal(expected);
+                expected.SetSelectionAnchor({ 5, 10 });
+                expected.SetSelectionEnd(end);
+
+                VERIFY_IS_TRUE(expected.GetSelectionRects() == term.GetSelectionRects());
+            }
+        }
     };
 }
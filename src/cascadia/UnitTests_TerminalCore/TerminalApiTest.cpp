@@ -41,6 +41,12 @@ namespace TerminalCoreUnitTests
 
         TEST_METHOD(SetTaskbarProgress);
         TEST_METHOD(SetWorkingDirectory);
+
+        TEST_METHOD(WritePastedTextInChunks);
+
+        TEST_METHOD(PromptMarks);
+
+        TEST_METHOD(InputEchoMovesCursor);
     };
 };
 
@@ -469,3 +475,107 @@ void TerminalCoreUnitTests::TerminalApiTest::SetWorkingDirectory()
     stateMachine.ProcessString(L"\x1b]9;9;\"\"\"\"\x9c");
     VERIFY_ARE_EQUAL(term.GetWorkingDirectory(), L"\"\"");
 }
+
+void TerminalApiTest::WritePastedTextInChunks()
+{
+    Terminal term;
+    DummyRenderTarget emptyRT;
+    term.Create({ 100, 100 }, 0, emptyRT);
+
+    std::vector<std::wstring> chunks;
+    term.SetWriteInputCallback([&](std::wstring& wstr) { chunks.push_back(wstr); });
+    term.Write(L"\x1b[?2004h");
+
+    Log::Comment(L"A CR LF at the end of a chunk is filtered as one line ending.");
+    const auto first = std::wstring(16 * 1024 - 1, L'a') + L"\r\n";
+    VERIFY_IS_TRUE(term.WritePastedText(first + L"b\x01"));
+    VERIFY_ARE_EQUAL(2u, chunks.size());
+    VERIFY_ARE_EQUAL(L"\x1b[200~" + std::wstring(16 * 1024 - 1, L'a') + L"\r", chunks.at(0));
+    VERIFY_ARE_EQUAL(L"b\x1b[201~", chunks.at(1));
+
+    Log::Comment(L"A cancelled paste is still closed with a bracket.");
+    chunks.clear();
+    size_t progress = 0;
+    VERIFY_IS_FALSE(term.WritePastedText(std::wstring(64 * 1024, L'c'), [&](const size_t written) {
+        progress = written;
+        return false;
+    }));
+    VERIFY_ARE_EQUAL(16u * 1024, progress);
+    VERIFY_ARE_EQUAL(2u, chunks.size());
+    VERIFY_ARE_EQUAL(L"\x1b[201~", chunks.at(1));
+}
+
+void TerminalApiTest::PromptMarks()
+{
+    Terminal term;
+    DummyRenderTarget emptyRT;
+    term.Create({ 80, 5 }, 100, emptyRT);
+
+    for (auto i = 0; i < 3; ++i)
+    {
+        term.Write(L"\x1b]133;A\x7$ \x1b]133;B\x7" L"cmd\r\n\x1b]133;C\x7" L"out\r\nout\r\nout\r\n\x1b]133;D;0\x7");
+    }
+    term.Write(L"\x1b]133;A\x7$ ");
+
+    Log::Comment(L"Every command is marked, with its prompt 4 rows below the last one.");
+    const auto& marks = term._buffer->GetPromptMarks();
+    VERIFY_ARE_EQUAL(13u, marks.size());
+    VERIFY_ARE_EQUAL(12, term._buffer->GetCursor().GetPosition().Y);
+    VERIFY_ARE_EQUAL(8, term.GetScrollOffset());
+
+    Log::Comment(L"Jump up the prompts to the first one, and back down.");
+    VERIFY_IS_TRUE(term.ScrollToPrompt(false));
+    VERIFY_ARE_EQUAL(4, term.GetScrollOffset());
+    VERIFY_IS_TRUE(term.ScrollToPrompt(false));
+    VERIFY_ARE_EQUAL(0, term.GetScrollOffset());
+    VERIFY_IS_FALSE(term.ScrollToPrompt(false));
+    VERIFY_ARE_EQUAL(0, term.GetScrollOffset());
+    VERIFY_IS_TRUE(term.ScrollToPrompt(true));
+    VERIFY_ARE_EQUAL(4, term.GetScrollOffset());
+
+    Log::Comment(L"The output of the last command is selected.");
+    VERIFY_IS_TRUE(term.SelectLastCommandOutput());
+    VERIFY_ARE_EQUAL(0, term.GetSelectionAnchor().X);
+    VERIFY_ARE_EQUAL(9, term.GetSelectionAnchor().Y);
+    VERIFY_ARE_EQUAL(11, term.GetSelectionEnd().Y);
+    term.ClearSelection();
+
+    Log::Comment(L"The marks move along with the prompts when they're wrapped onto two rows.");
+    VERIFY_SUCCEEDED(term.UserResize({ 4, 5 }, false));
+    const auto cursorRow = term._buffer->GetCursor().GetPosition().Y;
+    VERIFY_ARE_EQUAL(13u, marks.size());
+    VERIFY_ARE_EQUAL(cursorRow, term._buffer->FindPromptMarkBefore(cursorRow + 1, PromptMarkKind::Prompt).value());
+    VERIFY_ARE_EQUAL(cursorRow - 5, term._buffer->FindPromptMarkBefore(cursorRow, PromptMarkKind::Prompt).value());
+}
+
+void TerminalApiTest::InputEchoMovesCursor()
+{
+    Terminal term;
+    DummyRenderTarget emptyRT;
+    term.Create({ 80, 5 }, 0, emptyRT);
+
+    Log::Comment(L"There's no echo before any input.");
+    term.Write(L"$ ");
+    VERIFY_ARE_EQUAL(0u, term.GetInputEcho().sequence);
+
+    Log::Comment(L"Output that doesn't move the cursor isn't the echo.");
+    const auto time = std::chrono::steady_clock::now();
+    term.NoteInput(time);
+    term.Write(L"\x1b[31m");
+    VERIFY_ARE_EQUAL(0u, term.GetInputEcho().sequence);
+
+    Log::Comment(L"The character that follows is.");
+    term.Write(L"a");
+    VERIFY_ARE_EQUAL(1u, term.GetInputEcho().sequence);
+    VERIFY_IS_TRUE(time == term.GetInputEcho().time);
+
+    Log::Comment(L"Only the last one of several keystrokes is echoed.");
+    term.NoteInput(time);
+    term.NoteInput(time);
+    term.Write(L"bc");
+    VERIFY_ARE_EQUAL(3u, term.GetInputEcho().sequence);
+
+    Log::Comment(L"Later output doesn't change the echo.");
+    term.Write(L"\r\n");
+    VERIFY_ARE_EQUAL(3u, term.GetInputEcho().sequence);
+}
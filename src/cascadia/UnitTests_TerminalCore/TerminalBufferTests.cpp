@@ -6,6 +6,7 @@
 
 #include "../renderer/inc/DummyRenderTarget.hpp"
 #include "../cascadia/TerminalCore/Terminal.hpp"
+#include "../cascadia/TerminalCore/ScrollbackBudget.hpp"
 #include "MockTermSettings.h"
 #include "consoletaeftemplates.hpp"
 #include "TestUtils.h"
@@ -38,6 +39,7 @@ class TerminalCoreUnitTests::TerminalBufferTests final
 
     TEST_METHOD(TestWrappingCharByChar);
     TEST_METHOD(TestWrappingALongString);
+    TEST_METHOD(TestWrappingAWideGlyph);
 
     TEST_METHOD(DontSnapToOutputTest);
 
@@ -51,6 +53,14 @@ class TerminalCoreUnitTests::TerminalBufferTests final
 
     TEST_METHOD(TestGetReverseTab);
 
+    TEST_METHOD(TestPipelinedOutput);
+
+    TEST_METHOD(TestOutputStatistics);
+
+    TEST_METHOD(TestScrollbackBudgetCompactsIdleTerminals);
+
+    TEST_METHOD(TestSearchHighlightsFollowText);
+
     TEST_METHOD_SETUP(MethodSetup)
     {
         // STEP 1: Set up the Terminal
@@ -165,6 +175,33 @@ void TerminalBufferTests::TestWrappingALongString()
     TestUtils::VerifyExpectedString(termTb, TestUtils::Test100CharsString, { 0, 0 });
 }
 
+void TerminalBufferTests::TestWrappingAWideGlyph()
+{
+    auto& termTb = *term->_buffer;
+    auto& termSm = *term->_stateMachine;
+    auto& cursor = termTb.GetCursor();
+
+    // The glyph would start in the last column, so the row is padded and it
+    // goes onto the next one, along with the rest of the string.
+    std::wstring text(TerminalViewWidth - 1, L'a');
+    text.append(L"\x6211b");
+    termSm.ProcessString(text);
+
+    VERIFY_ARE_EQUAL(3, cursor.GetPosition().X);
+    VERIFY_ARE_EQUAL(1, cursor.GetPosition().Y);
+
+    const auto& row0 = termTb.GetRowByOffset(0);
+    VERIFY_IS_TRUE(row0.WasDoubleBytePadded());
+    VERIFY_IS_TRUE(row0.WasWrapForced());
+
+    const auto& row1 = termTb.GetRowByOffset(1);
+    VERIFY_IS_FALSE(row1.WasWrapForced());
+
+    TestUtils::VerifyExpectedString(termTb, std::wstring(TerminalViewWidth - 1, L'a'), { 0, 0 });
+    TestUtils::VerifyExpectedString(termTb, L"\x6211", { 0, 1 });
+    TestUtils::VerifyExpectedString(termTb, L"b", { 2, 1 });
+}
+
 void TerminalBufferTests::DontSnapToOutputTest()
 {
     auto& termTb = *term->_buffer;
@@ -592,3 +629,118 @@ void TerminalBufferTests::TestGetReverseTab()
                          L"Cursor adjusted to last item in the sample list from position beyond end.");
     }
 }
+
+void TerminalBufferTests::TestPipelinedOutput()
+{
+    term->SetPipelinedOutput(true);
+
+    Log::Comment(L"Sequences split across writes are put back together by the pipeline's parser.");
+    term->Write(L"\x1b[3");
+    term->Write(L"1mred\x1b[m\r\n");
+    term->Write(L"\x1b]0;ti");
+    term->Write(L"tle\x07");
+    term->Write(L"\x1b[2;5Hx");
+    term->WaitForPendingOutput();
+
+    auto& termTb = *term->_buffer;
+    TestUtils::VerifyExpectedString(termTb, L"red", { 0, 0 });
+    TestUtils::VerifyExpectedString(termTb, L"x", { 4, 1 });
+    VERIFY_IS_TRUE(TextColor(1, false) == termTb.GetCellDataAt({ 0, 0 })->TextAttr().GetForeground());
+    VERIFY_ARE_EQUAL(COORD({ 5, 1 }), termTb.GetCursor().GetPosition());
+    VERIFY_ARE_EQUAL(L"title", term->GetConsoleTitle());
+
+    Log::Comment(L"Disabling the pipeline applies whatever is still pending.");
+    term->Write(L"\x1b[3;1Hdone");
+    term->SetPipelinedOutput(false);
+    TestUtils::VerifyExpectedString(termTb, L"done", { 0, 2 });
+}
+
+void TerminalBufferTests::TestOutputStatistics()
+{
+    const auto& statistics = term->GetOutputStatistics();
+    const auto characters = statistics.characters.load();
+
+    Log::Comment(L"Without the pipeline, all of the time is counted as writing.");
+    term->Write(L"\x1b[31mred\x1b[m");
+    VERIFY_ARE_EQUAL(characters + 11, statistics.characters.load());
+    VERIFY_ARE_EQUAL(int64_t{ 0 }, statistics.parseTime.load());
+
+    Log::Comment(L"With the pipeline, the parsing on the writing thread is counted separately.");
+    term->SetPipelinedOutput(true);
+    const std::string text(4096, 'a');
+    term->Write(std::string_view{ text });
+    term->WaitForPendingOutput();
+    VERIFY_ARE_EQUAL(characters + 11 + text.size(), statistics.characters.load());
+    VERIFY_IS_GREATER_THAN(OutputStatistics::Load(statistics.parseTime).count(), 0);
+    term->SetPipelinedOutput(false);
+}
+
+void TerminalBufferTests::TestScrollbackBudgetCompactsIdleTerminals()
+{
+    auto& budget = ScrollbackBudget::Instance();
+    auto resetLimit = wil::scope_exit([&]() noexcept { budget.SetLimit(0); });
+    budget.SetLimit(SIZE_MAX);
+
+    auto idle = std::make_unique<Terminal>();
+    idle->Create({ TerminalViewWidth, TerminalViewHeight }, 1000, emptyRT);
+
+    const auto fill = [](Terminal& terminal) {
+        for (auto i = 0; i < 1000; ++i)
+        {
+            terminal.Write(fmt::format(L"line {} of the output\r\n", i));
+        }
+    };
+    fill(*idle);
+    Sleep(50);
+    fill(*term);
+
+    const auto usage = [](Terminal& terminal) {
+        auto lock = terminal.LockForReading();
+        return terminal.GetMemoryUsage().Total();
+    };
+    const auto idleBefore = usage(*idle);
+    const auto busyBefore = usage(*term);
+
+    Log::Comment(L"Going over the budget should take memory from the terminal that was idle the longest.");
+    budget.SetLimit(idleBefore + busyBefore - 1);
+    budget.Enforce();
+    VERIFY_IS_LESS_THAN(usage(*idle), idleBefore);
+    VERIFY_ARE_EQUAL(busyBefore, usage(*term));
+    VERIFY_IS_TRUE(idle->_scrollbackCompacted.load());
+    VERIFY_IS_FALSE(term->_scrollbackCompacted.load());
+
+    Log::Comment(L"The scrollback is packed, not discarded, while there's enough room.");
+    TestUtils::VerifyExpectedString(*idle->_buffer, L"line 500 of the output", { 0, 500 });
+
+    Log::Comment(L"Writing to the idle terminal again restores its hot region.");
+    idle->Write(L"more\r\n");
+    VERIFY_IS_FALSE(idle->_scrollbackCompacted.load());
+}
+
+void TerminalBufferTests::TestSearchHighlightsFollowText()
+{
+    Log::Comment(L"A match on the 21st row, from the 3rd to the 5th column.");
+    const auto circledBefore = term->GetTextBuffer().GetCircledRows();
+    term->SetSearchHighlights({ { circledBefore + 20, circledBefore + 20, 2, 4 } });
+
+    auto highlights = term->GetSearchHighlights();
+    VERIFY_ARE_EQUAL(1u, highlights.size());
+    VERIFY_ARE_EQUAL(20, highlights.at(0).Top());
+    VERIFY_ARE_EQUAL(2, highlights.at(0).Left());
+    VERIFY_ARE_EQUAL(4, highlights.at(0).RightInclusive());
+
+    Log::Comment(L"Once the output made the buffer circle, the match is still on its text, further up.");
+    for (auto i = 0; i < TerminalViewHeight + TerminalHistoryLength + 8; ++i)
+    {
+        term->Write(L"\r\n");
+    }
+    const auto circled = term->GetTextBuffer().GetCircledRows() - circledBefore;
+    VERIFY_IS_GREATER_THAN(circled, 0u);
+    VERIFY_ARE_EQUAL(0u, term->GetSearchHighlights().size());
+
+    term->UserScrollViewport(0);
+    highlights = term->GetSearchHighlights();
+    VERIFY_ARE_EQUAL(1u, highlights.size());
+    VERIFY_ARE_EQUAL(gsl::narrow_cast<SHORT>(20 - circled), highlights.at(0).Top());
+    VERIFY_ARE_EQUAL(2, highlights.at(0).Left());
+}
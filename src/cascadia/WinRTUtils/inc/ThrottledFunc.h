@@ -27,17 +27,22 @@ public:
         winrt::Windows::UI::Core::CoreDispatcher dispatcher,
         filetime_duration delay,
         function func) :
+        ThrottledFunc(std::move(dispatcher), delay, delay, std::move(func))
+    {
+    }
+
+    // Like the above, but the delay adapts to the caller, between `minDelay` and `maxDelay`.
+    // See til::throttled_func.
+    ThrottledFunc(
+        winrt::Windows::UI::Core::CoreDispatcher dispatcher,
+        filetime_duration minDelay,
+        filetime_duration maxDelay,
+        function func) :
+        _delay{ minDelay, maxDelay },
         _dispatcher{ std::move(dispatcher) },
         _func{ std::move(func) },
         _timer{ _create_timer() }
     {
-        const auto d = -delay.count();
-        if (d >= 0)
-        {
-            throw std::invalid_argument("non-positive delay specified");
-        }
-
-        memcpy(&_delay, &d, sizeof(d));
     }
 
     // ThrottledFunc uses its `this` pointer when creating _timer.
@@ -54,12 +59,26 @@ public:
     template<typename... MakeArgs>
     void Run(MakeArgs&&... args)
     {
-        if (!_storage.emplace(std::forward<MakeArgs>(args)...))
+        const auto coalesced = _storage.emplace(std::forward<MakeArgs>(args)...);
+        _delay.record(coalesced);
+        if (!coalesced)
         {
             _leading_edge();
         }
     }
 
+    // How often Run() was called so far, and how many of those calls
+    // were merged into an invocation that was already pending.
+    uint64_t Invocations() const noexcept
+    {
+        return _delay.invocations();
+    }
+
+    uint64_t Coalesced() const noexcept
+    {
+        return _delay.coalesced();
+    }
+
     // Modifies the pending arguments for the next function
     // invocation, if there is one pending currently.
     //
@@ -90,13 +109,15 @@ private:
                     }
                     CATCH_LOG();
 
-                    SetThreadpoolTimerEx(self->_timer.get(), &self->_delay, 0, 0);
+                    auto delay = self->_delay.begin_cycle();
+                    SetThreadpoolTimerEx(self->_timer.get(), &delay, 0, 0);
                 }
             });
         }
         else
         {
-            SetThreadpoolTimerEx(_timer.get(), &_delay, 0, 0);
+            auto delay = _delay.begin_cycle();
+            SetThreadpoolTimerEx(_timer.get(), &delay, 0, 0);
         }
     }
 
@@ -104,6 +125,7 @@ private:
     {
         if constexpr (leading)
         {
+            _delay.end_cycle();
             _storage.reset();
         }
         else
@@ -113,6 +135,7 @@ private:
                 {
                     try
                     {
+                        self->_delay.end_cycle();
                         std::apply(self->_func, self->_storage.take());
                     }
                     CATCH_LOG();
@@ -128,7 +151,7 @@ private:
         return timer;
     }
 
-    FILETIME _delay;
+    til::details::throttled_func_delay _delay;
     winrt::Windows::UI::Core::CoreDispatcher _dispatcher;
     function _func;
 
@@ -9,6 +9,7 @@
 #include "../WinRTUtils/inc/WtExeUtils.h"
 #include "resource.h"
 #include "VirtualDesktopUtils.h"
+#include "WindowThread.h"
 
 using namespace winrt::Windows::UI;
 using namespace winrt::Windows::UI::Composition;
@@ -49,6 +50,59 @@ AppHost::AppHost() noexcept :
         return;
     }
 
+    _CreateWindow();
+
+    _windowManager.BecameMonarch({ this, &AppHost::_BecomeMonarch });
+    _windowManager.WindowRequested({ this, &AppHost::_WindowRequested });
+    if (_windowManager.IsMonarch())
+    {
+        _BecomeMonarch(nullptr, nullptr);
+    }
+}
+
+// Method Description:
+// - Creates the host for a window the monarch hosts in its own process, on
+//   the calling thread. Instead of loading the settings again, and proposing
+//   the commandline to the monarch, this uses the settings the monarch's
+//   window already loaded, and the peasant the WindowManager made for us.
+// !!! IMPORTANT!!!
+// The calling thread must already have called
+// WindowsXamlManager::InitializeForCurrentThread, since constructing the
+// AppLogic constructs its XAML content.
+// Arguments:
+// - hostLogic: the AppLogic of the monarch's window, whose settings we share.
+// - windowManager: the monarch's WindowManager.
+// - peasant: our peasant. Its InitialArgs are the commandline for this window.
+AppHost::AppHost(const winrt::TerminalApp::AppLogic& hostLogic,
+                 const Remoting::WindowManager& windowManager,
+                 const Remoting::Peasant& peasant) noexcept :
+    _app{ nullptr }, // the monarch's window owns the Application
+    _windowManager{ windowManager },
+    _logic{},
+    _window{ nullptr },
+    _isHostedWindow{ true }
+{
+    _logic.UseSettingsFrom(hostLogic);
+
+    _shouldCreateWindow = true;
+    _SetupPeasant(peasant);
+    if (!_shouldCreateWindow)
+    {
+        return;
+    }
+
+    _CreateWindow();
+}
+
+// Method Description:
+// - Creates our IslandWindow and hooks up its callbacks. The settings and the
+//   startup commandline must already be given to the AppLogic.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void AppHost::_CreateWindow()
+{
     _useNonClientArea = _logic.GetShowTabsInTitlebar();
     if (_useNonClientArea)
     {
@@ -76,15 +130,10 @@ AppHost::AppHost() noexcept :
                                                 std::placeholders::_2));
     _window->MouseScrolled({ this, &AppHost::_WindowMouseWheeled });
     _window->WindowActivated({ this, &AppHost::_WindowActivated });
+    _window->WindowVisibilityChanged([this](bool visible) { _logic.WindowVisibilityChanged(visible); });
     _window->HotkeyPressed({ this, &AppHost::_GlobalHotkeyPressed });
     _window->SetAlwaysOnTop(_logic.GetInitialAlwaysOnTop());
     _window->MakeWindow();
-
-    _windowManager.BecameMonarch({ this, &AppHost::_BecomeMonarch });
-    if (_windowManager.IsMonarch())
-    {
-        _BecomeMonarch(nullptr, nullptr);
-    }
 }
 
 AppHost::~AppHost()
@@ -92,8 +141,20 @@ AppHost::~AppHost()
     // destruction order is important for proper teardown here
 
     _window = nullptr;
-    _app.Close();
-    _app = nullptr;
+    if (_app)
+    {
+        _app.Close();
+        _app = nullptr;
+    }
+}
+
+static bool _messageIsF7Keypress(const MSG& message)
+{
+    return (message.message == WM_KEYDOWN || message.message == WM_SYSKEYDOWN) && message.wParam == VK_F7;
+}
+static bool _messageIsAltKeyup(const MSG& message)
+{
+    return (message.message == WM_KEYUP || message.message == WM_SYSKEYUP) && message.wParam == VK_MENU;
 }
 
 bool AppHost::OnDirectKeyEvent(const uint32_t vkey, const uint8_t scanCode, const bool down)
@@ -178,41 +239,72 @@ void AppHost::_HandleCommandlineArgs()
 
     if (auto peasant{ _windowManager.CurrentWindow() })
     {
-        if (auto args{ peasant.InitialArgs() })
+        _SetupPeasant(peasant);
+    }
+}
+
+// Method Description:
+// - Hands the initial commandline of our peasant to the app logic, and hooks
+//   up the callbacks for everything the monarch may ask of our window later.
+// - If the logic determined there's an error while processing that commandline,
+//   display a message box to the user with the text of the error. If we should
+//   exit after that, a window of our own process exits it, while a window
+//   hosted by the monarch sets _shouldCreateWindow to false instead, so that
+//   it doesn't take the monarch's other windows down with it.
+// Arguments:
+// - peasant: our peasant.
+// Return Value:
+// - <none>
+void AppHost::_SetupPeasant(const Remoting::Peasant& peasant)
+{
+    _peasant = peasant;
+
+    if (auto args{ peasant.InitialArgs() })
+    {
+        const auto result = _logic.SetStartupCommandline(args.Commandline());
+        const auto message = _logic.ParseCommandlineMessage();
+        if (!message.empty())
         {
-            const auto result = _logic.SetStartupCommandline(args.Commandline());
-            const auto message = _logic.ParseCommandlineMessage();
-            if (!message.empty())
+            const auto displayHelp = result == 0;
+            const auto messageTitle = displayHelp ? IDS_HELP_DIALOG_TITLE : IDS_ERROR_DIALOG_TITLE;
+            const auto messageIcon = displayHelp ? MB_ICONWARNING : MB_ICONERROR;
+            // TODO:GH#4134: polish this dialog more, to make the text more
+            // like msiexec /?
+            MessageBoxW(nullptr,
+                        message.data(),
+                        GetStringResource(messageTitle).data(),
+                        MB_OK | messageIcon);
+
+            if (_logic.ShouldExitEarly())
             {
-                const auto displayHelp = result == 0;
-                const auto messageTitle = displayHelp ? IDS_HELP_DIALOG_TITLE : IDS_ERROR_DIALOG_TITLE;
-                const auto messageIcon = displayHelp ? MB_ICONWARNING : MB_ICONERROR;
-                // TODO:GH#4134: polish this dialog more, to make the text more
-                // like msiexec /?
-                MessageBoxW(nullptr,
-                            message.data(),
-                            GetStringResource(messageTitle).data(),
-                            MB_OK | messageIcon);
-
-                if (_logic.ShouldExitEarly())
+                if (_isHostedWindow)
                 {
-                    ExitProcess(result);
+                    _shouldCreateWindow = false;
+                    return;
                 }
+                ExitProcess(result);
             }
         }
 
-        // After handling the initial args, hookup the callback for handling
-        // future commandline invocations. When our peasant is told to execute a
-        // commandline (in the future), it'll trigger this callback, that we'll
-        // use to send the actions to the app.
-        peasant.ExecuteCommandlineRequested({ this, &AppHost::_DispatchCommandline });
-        peasant.SummonRequested({ this, &AppHost::_HandleSummon });
+        // The commandline was run in the directory of another process,
+        // which isn't necessarily the directory of the monarch's process.
+        if (_isHostedWindow)
+        {
+            _logic.SetStartupDirectory(args.CurrentDirectory());
+        }
+    }
+
+    // After handling the initial args, hookup the callback for handling
+    // future commandline invocations. When our peasant is told to execute a
+    // commandline (in the future), it'll trigger this callback, that we'll
+    // use to send the actions to the app.
+    peasant.ExecuteCommandlineRequested({ this, &AppHost::_DispatchCommandline });
+    peasant.SummonRequested({ this, &AppHost::_HandleSummon });
 
-        peasant.DisplayWindowIdRequested({ this, &AppHost::_DisplayWindowId });
+    peasant.DisplayWindowIdRequested({ this, &AppHost::_DisplayWindowId });
 
-        _logic.WindowName(peasant.WindowName());
-        _logic.WindowId(peasant.GetID());
-    }
+    _logic.WindowName(peasant.WindowName());
+    _logic.WindowId(peasant.GetID());
 }
 
 // Method Description:
@@ -316,9 +408,88 @@ void AppHost::AppTitleChanged(const winrt::Windows::Foundation::IInspectable& /*
 // - <none>
 void AppHost::LastTabClosed(const winrt::Windows::Foundation::IInspectable& /*sender*/, const winrt::TerminalApp::LastTabClosedEventArgs& /*args*/)
 {
+    // If the monarch's window quit now, the windows it hosts in our process
+    // would go down with it. Retire it until the last of them closes instead.
+    if (!_isHostedWindow && WindowThread::RetireMainThread())
+    {
+        _RetireWindow();
+        return;
+    }
+
     _window->Close();
 }
 
+// Method Description:
+// - Hides the window of the monarch's process, while the windows it hosts in
+//   the process are still open. WindowThread quits our message loop once the
+//   last of them closes. Until then, we stay the monarch, but our own window
+//   shouldn't be given any more commandlines, so we tell the monarch to forget
+//   about its peasant.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+winrt::fire_and_forget AppHost::_RetireWindow()
+{
+    ShowWindow(_window->GetHandle(), SW_HIDE);
+
+    // Switch to the BG thread - anything x-proc must happen on a BG thread
+    co_await winrt::resume_background();
+
+    if (auto peasant{ _peasant })
+    {
+        _windowManager.RemovePeasant(peasant);
+    }
+}
+
+// Method Description:
+// - Runs the message loop of the thread the window was created on, until the
+//   window closes.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void AppHost::RunMessagePump()
+{
+    MSG message;
+
+    while (GetMessage(&message, nullptr, 0, 0))
+    {
+        // GH#638 (Pressing F7 brings up both the history AND a caret browsing message)
+        // The Xaml input stack doesn't allow an application to suppress the "caret browsing"
+        // dialog experience triggered when you press F7. Official recommendation from the Xaml
+        // team is to catch F7 before we hand it off.
+        // AppLogic contains an ad-hoc implementation of event bubbling for a runtime classes
+        // implementing a custom IF7Listener interface.
+        // If the recipient of IF7Listener::OnF7Pressed suggests that the F7 press has, in fact,
+        // been handled we can discard the message before we even translate it.
+        if (_messageIsF7Keypress(message))
+        {
+            if (OnDirectKeyEvent(VK_F7, LOBYTE(HIWORD(message.lParam)), true))
+            {
+                // The application consumed the F7. Don't let Xaml get it.
+                continue;
+            }
+        }
+
+        // GH#6421 - System XAML will never send an Alt KeyUp event. So, similar
+        // to how we'll steal the F7 KeyDown above, we'll steal the Alt KeyUp
+        // here, and plumb it through.
+        if (_messageIsAltKeyup(message))
+        {
+            // Let's pass <Alt> to the application
+            if (OnDirectKeyEvent(VK_MENU, LOBYTE(HIWORD(message.lParam)), false))
+            {
+                // The application consumed the Alt. Don't let Xaml get it.
+                continue;
+            }
+        }
+
+        TranslateMessage(&message);
+        DispatchMessage(&message);
+    }
+}
+
 // Method Description:
 // - Resize the window we're about to create to the appropriate dimensions, as
 //   specified in the settings. This will be called during the handling of
@@ -623,7 +794,7 @@ winrt::fire_and_forget AppHost::_WindowActivated()
 {
     co_await winrt::resume_background();
 
-    if (auto peasant{ _windowManager.CurrentWindow() })
+    if (auto peasant{ _peasant })
     {
         const auto currentDesktopGuid{ _CurrentDesktopGuid() };
 
@@ -647,6 +818,46 @@ void AppHost::_BecomeMonarch(const winrt::Windows::Foundation::IInspectable& /*s
     _listenForInboundConnections();
 }
 
+// Method Description:
+// - Event handler for the WindowManager::WindowRequested event. When we're the
+//   monarch, the manager asks us whether we want to create the window for a
+//   commandline ourselves. If the user opted into hosting windows in-process,
+//   we'll start a thread for the new window, which will share our settings,
+//   and mark the request as handled. Otherwise, the process that proposed the
+//   commandline becomes the new window, as usual.
+// - This is called on a background thread, while the proposing process waits
+//   for the answer.
+// Arguments:
+// - args: the commandline, ID and name for the new window.
+// Return Value:
+// - <none>
+void AppHost::_WindowRequested(const winrt::Windows::Foundation::IInspectable& /*sender*/,
+                               const Remoting::WindowRequestedArgs& args)
+{
+    if (!_logic.GetInProcessWindows())
+    {
+        return;
+    }
+
+    Remoting::Peasant peasant{ nullptr };
+    try
+    {
+        peasant = _windowManager.CreatePeasant(args);
+        WindowThread::Start(_logic, _windowManager, peasant);
+        args.Handled(true);
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+
+        // Let the proposing process become the window instead.
+        if (peasant)
+        {
+            _windowManager.RemovePeasant(peasant);
+        }
+    }
+}
+
 void AppHost::_listenForInboundConnections()
 {
     _logic.SetInboundListener();
@@ -867,7 +1078,7 @@ winrt::fire_and_forget AppHost::_IdentifyWindowsRequested(const winrt::Windows::
     // make sure we're on the background thread, or this will silently fail
     co_await winrt::resume_background();
 
-    if (auto peasant{ _windowManager.CurrentWindow() })
+    if (auto peasant{ _peasant })
     {
         peasant.RequestIdentifyWindows();
     }
@@ -895,7 +1106,7 @@ winrt::fire_and_forget AppHost::_RenameWindowRequested(const winrt::Windows::Fou
     // Switch to the BG thread - anything x-proc must happen on a BG thread
     co_await winrt::resume_background();
 
-    if (auto peasant{ _windowManager.CurrentWindow() })
+    if (auto peasant{ _peasant })
     {
         Remoting::RenameRequestArgs requestArgs{ args.ProposedName() };
 
@@ -9,12 +9,16 @@ class AppHost
 {
 public:
     AppHost() noexcept;
+    AppHost(const winrt::TerminalApp::AppLogic& hostLogic,
+            const winrt::Microsoft::Terminal::Remoting::WindowManager& windowManager,
+            const winrt::Microsoft::Terminal::Remoting::Peasant& peasant) noexcept;
     virtual ~AppHost();
 
     void AppTitleChanged(const winrt::Windows::Foundation::IInspectable& sender, winrt::hstring newTitle);
     void LastTabClosed(const winrt::Windows::Foundation::IInspectable& sender, const winrt::TerminalApp::LastTabClosedEventArgs& args);
     void Initialize();
     bool OnDirectKeyEvent(const uint32_t vkey, const uint8_t scanCode, const bool down);
+    void RunMessagePump();
     void SetTaskbarProgress(const winrt::Windows::Foundation::IInspectable& sender, const winrt::Windows::Foundation::IInspectable& args);
 
     bool HasWindow();
@@ -26,7 +30,9 @@ private:
     winrt::TerminalApp::App _app;
     winrt::TerminalApp::AppLogic _logic;
     bool _shouldCreateWindow{ false };
+    bool _isHostedWindow{ false };
     winrt::Microsoft::Terminal::Remoting::WindowManager _windowManager{ nullptr };
+    winrt::Microsoft::Terminal::Remoting::Peasant _peasant{ nullptr };
 
     std::vector<winrt::Microsoft::Terminal::Control::KeyChord> _hotkeys{};
     winrt::Windows::Foundation::Collections::IMapView<winrt::Microsoft::Terminal::Control::KeyChord, winrt::Microsoft::Terminal::Settings::Model::Command> _hotkeyActions{ nullptr };
@@ -34,6 +40,9 @@ private:
     winrt::com_ptr<IVirtualDesktopManager> _desktopManager{ nullptr };
 
     void _HandleCommandlineArgs();
+    void _SetupPeasant(const winrt::Microsoft::Terminal::Remoting::Peasant& peasant);
+    void _CreateWindow();
+    winrt::fire_and_forget _RetireWindow();
 
     void _HandleCreateWindow(const HWND hwnd, RECT proposedRect, winrt::Microsoft::Terminal::Settings::Model::LaunchMode& launchMode);
     void _UpdateTitleBarContent(const winrt::Windows::Foundation::IInspectable& sender,
@@ -59,6 +68,8 @@ private:
 
     void _BecomeMonarch(const winrt::Windows::Foundation::IInspectable& sender,
                         const winrt::Windows::Foundation::IInspectable& args);
+    void _WindowRequested(const winrt::Windows::Foundation::IInspectable& sender,
+                          const winrt::Microsoft::Terminal::Remoting::WindowRequestedArgs& args);
     void _GlobalHotkeyPressed(const long hotkeyIndex);
     void _HandleSummon(const winrt::Windows::Foundation::IInspectable& sender,
                        const winrt::Microsoft::Terminal::Remoting::SummonWindowBehavior& args);
@@ -450,6 +450,14 @@ long IslandWindow::_calculateTotalSize(const bool isWidth, const long clientSize
     }
     case WM_SIZE:
     {
+        // Nothing of the terminals can be seen while we're minimized, so they stop painting.
+        const auto minimized = wparam == SIZE_MINIMIZED;
+        if ((minimized || wparam == SIZE_RESTORED || wparam == SIZE_MAXIMIZED) && minimized != _isMinimized)
+        {
+            _isMinimized = minimized;
+            _WindowVisibilityChangedHandlers(!minimized);
+        }
+
         if (wparam == SIZE_MINIMIZED && _isQuakeWindow)
         {
             ShowWindow(GetHandle(), SW_HIDE);
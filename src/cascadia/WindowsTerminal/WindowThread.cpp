@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "WindowThread.h"
+#include "AppHost.h"
+
+using namespace winrt::Windows::UI::Xaml::Hosting;
+using namespace winrt::Microsoft::Terminal;
+
+// The number of windows hosted in our process that are still open, and the
+// thread of the monarch's window, once it closed while some of them were.
+static std::mutex s_lock;
+static size_t s_runningWindows{ 0 };
+static DWORD s_retiredMainThreadId{ 0 };
+
+// Method Description:
+// - Called on a hosted window's thread once the window closed. If the
+//   monarch's own window was already closed, and this was the last window
+//   left, quit the message loop of the main thread, which exits the process.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+static void _WindowExited() noexcept
+{
+    const std::lock_guard lock{ s_lock };
+
+    --s_runningWindows;
+    if (s_runningWindows == 0 && s_retiredMainThreadId != 0)
+    {
+        LOG_IF_WIN32_BOOL_FALSE(PostThreadMessageW(s_retiredMainThreadId, WM_QUIT, 0, 0));
+    }
+}
+
+// Method Description:
+// - The body of a hosted window's thread. Creates the window and runs its
+//   message loop until it closes, then tells the monarch to forget about it.
+// Arguments:
+// - hostLogic: the AppLogic of the monarch's window, whose settings we share.
+// - windowManager: the monarch's WindowManager.
+// - peasant: the peasant the WindowManager created for this window.
+// Return Value:
+// - <none>
+static void _Run(const winrt::TerminalApp::AppLogic hostLogic,
+                 const Remoting::WindowManager windowManager,
+                 const Remoting::Peasant peasant) noexcept
+{
+    try
+    {
+        // Like the main thread, this must be a single-threaded apartment
+        // before constructing any Xaml objects. See wWinMain.
+        winrt::init_apartment(winrt::apartment_type::single_threaded);
+
+        // The main thread gets XAML initialized by constructing the
+        // Application. Every other thread has to do that by itself.
+        auto xamlManager = WindowsXamlManager::InitializeForCurrentThread();
+
+        {
+            AppHost host{ hostLogic, windowManager, peasant };
+            if (host.HasWindow())
+            {
+                host.Initialize();
+                host.RunMessagePump();
+            }
+        }
+
+        xamlManager.Close();
+    }
+    CATCH_LOG();
+
+    try
+    {
+        windowManager.RemovePeasant(peasant);
+    }
+    CATCH_LOG();
+
+    _WindowExited();
+}
+
+namespace WindowThread
+{
+    // Method Description:
+    // - Starts a UI thread for a new window in the monarch's process.
+    // Arguments:
+    // - hostLogic: the AppLogic of the monarch's window, whose settings the
+    //   new window will share.
+    // - windowManager: the monarch's WindowManager.
+    // - peasant: the peasant the WindowManager created for the new window.
+    // Return Value:
+    // - <none>
+    void Start(const winrt::TerminalApp::AppLogic& hostLogic,
+               const Remoting::WindowManager& windowManager,
+               const Remoting::Peasant& peasant)
+    {
+        {
+            const std::lock_guard lock{ s_lock };
+            ++s_runningWindows;
+        }
+
+        try
+        {
+            std::thread{ _Run, hostLogic, windowManager, peasant }.detach();
+        }
+        catch (...)
+        {
+            _WindowExited();
+            throw;
+        }
+    }
+
+    // Method Description:
+    // - Called when the monarch's own window wants to close. If windows hosted
+    //   in our process are still open, quitting the main thread would exit
+    //   the process and close them as well. In that case, remember to quit
+    //   the main thread's message loop once the last of them closed instead.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - true if the calling thread should keep running, with its window hidden.
+    bool RetireMainThread() noexcept
+    {
+        const std::lock_guard lock{ s_lock };
+
+        if (s_runningWindows == 0)
+        {
+            return false;
+        }
+
+        s_retiredMainThreadId = GetCurrentThreadId();
+        return true;
+    }
+}
@@ -0,0 +1,15 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// Helpers for hosting additional windows in the monarch's process, each on a
+// UI thread of its own. See the "experimental.inProcessWindows" setting.
+
+#pragma once
+
+namespace WindowThread
+{
+    void Start(const winrt::TerminalApp::AppLogic& hostLogic,
+               const winrt::Microsoft::Terminal::Remoting::WindowManager& windowManager,
+               const winrt::Microsoft::Terminal::Remoting::Peasant& peasant);
+    bool RetireMainThread() noexcept;
+}
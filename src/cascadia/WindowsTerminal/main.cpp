@@ -74,15 +74,6 @@ static void EnsureNativeArchitecture()
     }
 }
 
-static bool _messageIsF7Keypress(const MSG& message)
-{
-    return (message.message == WM_KEYDOWN || message.message == WM_SYSKEYDOWN) && message.wParam == VK_F7;
-}
-static bool _messageIsAltKeyup(const MSG& message)
-{
-    return (message.message == WM_KEYUP || message.message == WM_SYSKEYUP) && message.wParam == VK_MENU;
-}
-
 int __stdcall wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
 {
     TraceLoggingRegister(g_hWindowsTerminalProvider);
@@ -94,6 +85,15 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
         TelemetryPrivacyDataTag(PDT_ProductAndServicePerformance));
     ::Microsoft::Console::ErrorReporting::EnableFallbackFailureReporting(g_hWindowsTerminalProvider);
 
+    // The start of the startup timeline (see StartupTracing.h), which
+    // ends with the DirectX renderer's FirstPresent event.
+    TraceLoggingWrite(
+        g_hWindowsTerminalProvider,
+        "Launch",
+        TraceLoggingOpcode(WINEVENT_OPCODE_START),
+        TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+        TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+
     // If Terminal is spawned by a shortcut that requests that it run in a new process group
     // while attached to a console session, that request is nonsense. That request will, however,
     // cause WT to start with Ctrl-C disabled. This wouldn't matter, because it's a Windows-subsystem
@@ -137,42 +137,6 @@ int __stdcall wWinMain(HINSTANCE, HINSTANCE, LPWSTR, int)
     // WindowsXamlManager is initialized.
     host.Initialize();
 
-    MSG message;
-
-    while (GetMessage(&message, nullptr, 0, 0))
-    {
-        // GH#638 (Pressing F7 brings up both the history AND a caret browsing message)
-        // The Xaml input stack doesn't allow an application to suppress the "caret browsing"
-        // dialog experience triggered when you press F7. Official recommendation from the Xaml
-        // team is to catch F7 before we hand it off.
-        // AppLogic contains an ad-hoc implementation of event bubbling for a runtime classes
-        // implementing a custom IF7Listener interface.
-        // If the recipient of IF7Listener::OnF7Pressed suggests that the F7 press has, in fact,
-        // been handled we can discard the message before we even translate it.
-        if (_messageIsF7Keypress(message))
-        {
-            if (host.OnDirectKeyEvent(VK_F7, LOBYTE(HIWORD(message.lParam)), true))
-            {
-                // The application consumed the F7. Don't let Xaml get it.
-                continue;
-            }
-        }
-
-        // GH#6421 - System XAML will never send an Alt KeyUp event. So, similar
-        // to how we'll steal the F7 KeyDown above, we'll steal the Alt KeyUp
-        // here, and plumb it through.
-        if (_messageIsAltKeyup(message))
-        {
-            // Let's pass <Alt> to the application
-            if (host.OnDirectKeyEvent(VK_MENU, LOBYTE(HIWORD(message.lParam)), false))
-            {
-                // The application consumed the Alt. Don't let Xaml get it.
-                continue;
-            }
-        }
-
-        TranslateMessage(&message);
-        DispatchMessage(&message);
-    }
+    host.RunMessagePump();
     return 0;
 }
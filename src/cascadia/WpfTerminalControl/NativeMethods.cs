@@ -19,6 +19,16 @@ namespace Microsoft.Terminal.Wpf
         [UnmanagedFunctionPointer(CallingConvention.StdCall)]
         public delegate void WriteCallback([In, MarshalAs(UnmanagedType.LPWStr)] string data);
 
+        [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+        public delegate void WriteCallbackEx(IntPtr data, UIntPtr length);
+
+        // Keep in sync with HwndTerminal.hpp
+        public enum OutputEncoding : uint
+        {
+            Utf16 = 0,
+            Utf8 = 1,
+        }
+
         public enum WindowMessage : int
         {
             /// <summary>
@@ -185,6 +195,18 @@ namespace Microsoft.Terminal.Wpf
         [DllImport("PublicTerminalCore.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.StdCall)]
         public static extern void TerminalSendOutput(IntPtr terminal, string lpdata);
 
+        [DllImport("PublicTerminalCore.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.StdCall)]
+        public static extern void TerminalSendOutputEx(IntPtr terminal, string data, UIntPtr length, OutputEncoding encoding);
+
+        [DllImport("PublicTerminalCore.dll", CallingConvention = CallingConvention.StdCall)]
+        public static extern void TerminalSendOutputEx(IntPtr terminal, byte[] data, UIntPtr length, OutputEncoding encoding);
+
+        [DllImport("PublicTerminalCore.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.StdCall)]
+        public static extern void TerminalEnqueueOutput(IntPtr terminal, string data, UIntPtr length, OutputEncoding encoding);
+
+        [DllImport("PublicTerminalCore.dll", CallingConvention = CallingConvention.StdCall)]
+        public static extern void TerminalEnqueueOutput(IntPtr terminal, byte[] data, UIntPtr length, OutputEncoding encoding);
+
         [DllImport("PublicTerminalCore.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.StdCall)]
         public static extern uint TerminalTriggerResize(IntPtr terminal, short width, short height, out COORD dimensions);
 
@@ -203,6 +225,9 @@ namespace Microsoft.Terminal.Wpf
         [DllImport("PublicTerminalCore.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.StdCall)]
         public static extern void TerminalRegisterWriteCallback(IntPtr terminal, [MarshalAs(UnmanagedType.FunctionPtr)]WriteCallback callback);
 
+        [DllImport("PublicTerminalCore.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.StdCall)]
+        public static extern void TerminalRegisterWriteCallbackEx(IntPtr terminal, [MarshalAs(UnmanagedType.FunctionPtr)]WriteCallbackEx callback);
+
         [DllImport("PublicTerminalCore.dll", CharSet = CharSet.Unicode, CallingConvention = CallingConvention.StdCall)]
         public static extern void TerminalUserScroll(IntPtr terminal, int viewTop);
 
@@ -25,7 +25,7 @@ namespace Microsoft.Terminal.Wpf
         private IntPtr terminal;
         private DispatcherTimer blinkTimer;
         private NativeMethods.ScrollCallback scrollCallback;
-        private NativeMethods.WriteCallback writeCallback;
+        private NativeMethods.WriteCallbackEx writeCallback;
 
         /// <summary>
         /// Initializes a new instance of the <see cref="TerminalContainer"/> class.
@@ -265,7 +265,7 @@ namespace Microsoft.Terminal.Wpf
             this.writeCallback = this.OnWrite;
 
             NativeMethods.TerminalRegisterScrollCallback(this.terminal, this.scrollCallback);
-            NativeMethods.TerminalRegisterWriteCallback(this.terminal, this.writeCallback);
+            NativeMethods.TerminalRegisterWriteCallbackEx(this.terminal, this.writeCallback);
 
             // If the saved DPI scale isn't the default scale, we push it to the terminal.
             if (dpiScale.PixelsPerInchX != NativeMethods.USER_DEFAULT_SCREEN_DPI)
@@ -435,7 +435,9 @@ namespace Microsoft.Terminal.Wpf
         {
             if (this.terminal != IntPtr.Zero)
             {
-                NativeMethods.TerminalSendOutput(this.terminal, e.Data);
+                // The output is parsed on the terminal's own ingestion thread,
+                // so that heavy output doesn't block the thread raising the event.
+                NativeMethods.TerminalEnqueueOutput(this.terminal, e.Data, (UIntPtr)e.Data.Length, NativeMethods.OutputEncoding.Utf16);
             }
         }
 
@@ -444,9 +446,9 @@ namespace Microsoft.Terminal.Wpf
             this.TerminalScrolled?.Invoke(this, (viewTop, viewHeight, bufferSize));
         }
 
-        private void OnWrite(string data)
+        private void OnWrite(IntPtr data, UIntPtr length)
         {
-            this.Connection?.WriteInput(data);
+            this.Connection?.WriteInput(Marshal.PtrToStringUni(data, (int)length));
         }
     }
 }
@@ -21,6 +21,9 @@ const std::wstring_view ConsoleArguments::HEIGHT_ARG = L"--height";
 const std::wstring_view ConsoleArguments::INHERIT_CURSOR_ARG = L"--inheritcursor";
 const std::wstring_view ConsoleArguments::RESIZE_QUIRK = L"--resizeQuirk";
 const std::wstring_view ConsoleArguments::WIN32_INPUT_MODE = L"--win32input";
+const std::wstring_view ConsoleArguments::PASSTHROUGH_MODE = L"--passthrough";
+const std::wstring_view ConsoleArguments::RENDERLESS_MODE = L"--renderless";
+const std::wstring_view ConsoleArguments::REPEAT_CHARACTER = L"--repeatCharacter";
 const std::wstring_view ConsoleArguments::FEATURE_ARG = L"--feature";
 const std::wstring_view ConsoleArguments::FEATURE_PTY_ARG = L"pty";
 const std::wstring_view ConsoleArguments::COM_SERVER_ARG = L"-Embedding";
@@ -508,6 +511,24 @@ void ConsoleArguments::s_ConsumeArg(_Inout_ std::vector<std::wstring>& args, _In
             s_ConsumeArg(args, i);
             hr = S_OK;
         }
+        else if (arg == PASSTHROUGH_MODE)
+        {
+            _passthroughMode = true;
+            s_ConsumeArg(args, i);
+            hr = S_OK;
+        }
+        else if (arg == RENDERLESS_MODE)
+        {
+            _renderlessMode = true;
+            s_ConsumeArg(args, i);
+            hr = S_OK;
+        }
+        else if (arg == REPEAT_CHARACTER)
+        {
+            _repeatCharacter = true;
+            s_ConsumeArg(args, i);
+            hr = S_OK;
+        }
         else if (arg == CLIENT_COMMANDLINE_ARG)
         {
             // Everything after this is the explicit commandline
@@ -663,6 +684,18 @@ bool ConsoleArguments::IsWin32InputModeEnabled() const
 {
     return _win32InputMode;
 }
+bool ConsoleArguments::IsPassthroughModeEnabled() const
+{
+    return _passthroughMode;
+}
+bool ConsoleArguments::IsRenderlessModeEnabled() const
+{
+    return _renderlessMode;
+}
+bool ConsoleArguments::IsRepeatCharacterEnabled() const
+{
+    return _repeatCharacter;
+}
 
 #ifdef UNIT_TESTING
 // Method Description:
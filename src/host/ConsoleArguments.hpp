@@ -55,6 +55,9 @@ public:
     bool GetInheritCursor() const;
     bool IsResizeQuirkEnabled() const;
     bool IsWin32InputModeEnabled() const;
+    bool IsPassthroughModeEnabled() const;
+    bool IsRenderlessModeEnabled() const;
+    bool IsRepeatCharacterEnabled() const;
 
 #ifdef UNIT_TESTING
     void EnableConptyModeForTests();
@@ -74,6 +77,9 @@ public:
     static const std::wstring_view INHERIT_CURSOR_ARG;
     static const std::wstring_view RESIZE_QUIRK;
     static const std::wstring_view WIN32_INPUT_MODE;
+    static const std::wstring_view PASSTHROUGH_MODE;
+    static const std::wstring_view RENDERLESS_MODE;
+    static const std::wstring_view REPEAT_CHARACTER;
     static const std::wstring_view FEATURE_ARG;
     static const std::wstring_view FEATURE_PTY_ARG;
     static const std::wstring_view COM_SERVER_ARG;
@@ -140,6 +146,9 @@ private:
     bool _inheritCursor;
     bool _resizeQuirk{ false };
     bool _win32InputMode{ false };
+    bool _passthroughMode{ false };
+    bool _renderlessMode{ false };
+    bool _repeatCharacter{ false };
 
     [[nodiscard]] HRESULT _GetClientCommandline(_Inout_ std::vector<std::wstring>& args,
                                                 const size_t index,
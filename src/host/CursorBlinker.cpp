@@ -138,7 +138,7 @@ void CursorBlinker::TimerRoutine(SCREEN_INFORMATION& ScreenInfo)
     }
 
 DoBlinkingRenditionAndScroll:
-    gci.GetBlinkingState().ToggleBlinkingRendition(ScreenInfo.GetRenderTarget());
+    gci.GetBlinkingState().ToggleBlinkingRendition(ScreenInfo.GetRenderTarget(), ScreenInfo.GetTextBuffer(), ScreenInfo.GetViewport());
 
 DoScroll:
     Scrolling::s_ScrollIfNecessary(ScreenInfo);
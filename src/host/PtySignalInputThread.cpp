@@ -87,6 +87,11 @@ void PtySignalInputThread::ConnectConsole() noexcept
             ResizeWindowData resizeMsg = { 0 };
             _GetData(&resizeMsg, sizeof(resizeMsg));
 
+            // While the terminal is being resized by dragging, the signals come in bursts.
+            // Skip ahead to the last one, so the buffer is only resized (reflowed) and
+            // repainted once for all of them.
+            _CoalesceResizes(resizeMsg);
+
             LockConsole();
             auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
 
@@ -122,12 +127,55 @@ void PtySignalInputThread::ConnectConsole() noexcept
 // - <none>
 void PtySignalInputThread::_DoResizeWindow(const ResizeWindowData& data)
 {
+    // The terminal is authoritative for the reflow of what it shows, so what
+    // ours changes isn't repainted. See VtEngine::BeginTerminalResize.
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    if (gci.IsInVtIoMode())
+    {
+        gci.GetVtIo()->BeginTerminalResize();
+    }
+    auto endResize = wil::scope_exit([&]() noexcept {
+        if (gci.IsInVtIoMode())
+        {
+            gci.GetVtIo()->EndTerminalResize();
+        }
+    });
+
     if (DispatchCommon::s_ResizeWindow(*_pConApi, data.sx, data.sy))
     {
         DispatchCommon::s_SuppressResizeRepaint(*_pConApi);
     }
 }
 
+// Method Description:
+// - Consumes the resize signals that are already waiting in the pipe,
+//   without blocking for more to arrive. Stops at the first signal that
+//   isn't a resize, leaving it for the input thread.
+// Arguments:
+// - data - Receives the size of the last pending resize, if there was one.
+// Return Value:
+// - <none>
+void PtySignalInputThread::_CoalesceResizes(ResizeWindowData& data)
+{
+    for (;;)
+    {
+        PtySignal signalId;
+        DWORD cbRead = 0;
+        DWORD cbAvailable = 0;
+        if (FALSE == PeekNamedPipe(_hFile.get(), &signalId, sizeof(signalId), &cbRead, &cbAvailable, nullptr) ||
+            cbAvailable < sizeof(signalId) + sizeof(data) ||
+            signalId != PtySignal::ResizeWindow)
+        {
+            return;
+        }
+
+        if (!_GetData(&signalId, sizeof(signalId)) || !_GetData(&data, sizeof(data)))
+        {
+            return;
+        }
+    }
+}
+
 // Method Description:
 // - Retrieves bytes from the file stream and exits or throws errors should the pipe state
 //   be compromised.
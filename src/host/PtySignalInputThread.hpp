@@ -46,6 +46,7 @@ namespace Microsoft::Console
 
         [[nodiscard]] HRESULT _InputThread();
         bool _GetData(_Out_writes_bytes_(cbBuffer) void* const pBuffer, const DWORD cbBuffer);
+        void _CoalesceResizes(ResizeWindowData& data);
         void _DoResizeWindow(const ResizeWindowData& data);
         void _Shutdown();
 
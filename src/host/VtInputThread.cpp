@@ -28,6 +28,7 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
                              const bool inheritCursor) :
     _hFile{ std::move(hPipe) },
     _hThread{},
+    _pDispatch{ nullptr },
     _u8State{},
     _dwThreadId{ 0 },
     _exitRequested{ false },
@@ -40,6 +41,7 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
     auto pGetSet = std::make_unique<ConhostInternalGetSet>(gci);
 
     auto dispatch = std::make_unique<InteractDispatch>(std::move(pGetSet));
+    _pDispatch = dispatch.get();
 
     auto engine = std::make_unique<InputStateMachineEngine>(std::move(dispatch), inheritCursor);
 
@@ -72,14 +74,18 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
 
     try
     {
-        std::wstring wstr{};
-        auto hr = til::u8u16(u8Str, wstr, _u8State);
+        auto hr = til::u8u16(u8Str, _wstr, _u8State);
         // If we hit a parsing error, eat it. It's bad utf-8, we can't do anything with it.
         if (FAILED(hr))
         {
             return S_FALSE;
         }
-        _pInputStateMachine->ProcessString(wstr);
+
+        // Everything decoded from this read is written to the input buffer at
+        // once, instead of taking the input buffer's lock for every key.
+        _pDispatch->BeginBatch();
+        _pInputStateMachine->ProcessString(_wstr);
+        _pDispatch->EndBatch();
     }
     CATCH_RETURN();
 
@@ -108,7 +114,9 @@ DWORD WINAPI VtInputThread::StaticVtInputThreadProc(_In_ LPVOID lpParameter)
 // - <none>
 void VtInputThread::DoReadInput(const bool throwOnFail)
 {
-    char buffer[256];
+    // Read as much as a large paste is likely to deliver at once, so that
+    // it's handled in a few reads instead of one per 256 bytes.
+    char buffer[16 * 1024];
     DWORD dwRead = 0;
     bool fSuccess = !!ReadFile(_hFile.get(), buffer, ARRAYSIZE(buffer), &dwRead, nullptr);
 
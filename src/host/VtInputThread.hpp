@@ -16,6 +16,11 @@ Author(s):
 
 #include "../terminal/parser/StateMachine.hpp"
 
+namespace Microsoft::Console::VirtualTerminal
+{
+    class InteractDispatch;
+}
+
 namespace Microsoft::Console
 {
     class VtInputThread
@@ -39,6 +44,8 @@ namespace Microsoft::Console
         HRESULT _exitResult;
 
         std::unique_ptr<Microsoft::Console::VirtualTerminal::StateMachine> _pInputStateMachine;
+        Microsoft::Console::VirtualTerminal::InteractDispatch* _pDispatch;
         til::u8state _u8State;
+        std::wstring _wstr;
     };
 }
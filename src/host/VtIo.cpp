@@ -70,11 +70,18 @@ VtIo::VtIo() :
     _lookingForCursorPosition = pArgs->GetInheritCursor();
     _resizeQuirk = pArgs->IsResizeQuirkEnabled();
     _win32InputMode = pArgs->IsWin32InputModeEnabled();
+    _passthroughMode = pArgs->IsPassthroughModeEnabled();
+    _repeatCharacter = pArgs->IsRepeatCharacterEnabled();
 
     // If we were already given VT handles, set up the VT IO engine to use those.
     if (pArgs->InConptyMode())
     {
-        return _Initialize(pArgs->GetVtInHandle(), pArgs->GetVtOutHandle(), pArgs->GetVtMode(), pArgs->GetSignalHandle());
+        RETURN_IF_FAILED(_Initialize(pArgs->GetVtInHandle(), pArgs->GetVtOutHandle(), pArgs->GetVtMode(), pArgs->GetSignalHandle()));
+
+        // Renderless mode is passthrough mode without the renderer to fall back
+        // on. Like passthrough mode, it's only for the xterm-256color mode.
+        _renderlessMode = pArgs->IsRenderlessModeEnabled() && _IoMode == VtIoMode::XTERM_256;
+        return S_OK;
     }
     // Didn't need to initialize if we didn't have VT stuff. It's still OK, but report we did nothing.
     else
@@ -156,6 +163,16 @@ VtIo::VtIo() :
             case VtIoMode::XTERM_256:
                 _pVtRenderEngine = std::make_unique<Xterm256Engine>(std::move(_hOutput),
                                                                     initialViewport);
+                // Passthrough mode writes the client's output as is, which only
+                // a terminal that understands everything we do can deal with.
+                if (_renderlessMode)
+                {
+                    _pVtRenderEngine->StartPassthrough();
+                }
+                else if (_passthroughMode)
+                {
+                    _pVtRenderEngine->EnablePassthrough();
+                }
                 break;
             case VtIoMode::XTERM:
                 _pVtRenderEngine = std::make_unique<XtermEngine>(std::move(_hOutput),
@@ -174,6 +191,7 @@ VtIo::VtIo() :
             {
                 _pVtRenderEngine->SetTerminalOwner(this);
                 _pVtRenderEngine->SetResizeQuirk(_resizeQuirk);
+                _pVtRenderEngine->SetRepeatCharacter(_repeatCharacter);
             }
         }
     }
@@ -188,6 +206,26 @@ bool VtIo::IsUsingVt() const
     return _objectsCreated;
 }
 
+// Method Description:
+// - Returns true if we were started in renderless mode. The output of the
+//   client is written to the terminal as it's processed, and that's all the
+//   terminal ever gets: the VT renderer isn't given to the renderer, so there's
+//   no render thread, no frames and nothing that tracks what was invalidated.
+//   What's changed in the buffer in any other way (like WriteConsoleOutput)
+//   doesn't reach the terminal. This allows for as many sessions as possible
+//   on a machine, for automation that only cares about the client's output.
+// - Also, the console doesn't create a window in this mode, not even the fake
+//   one of ConPTY, just like for a client started with CREATE_NO_WINDOW.
+// Arguments:
+// - <none>
+// Return Value:
+// - true iff we were started with the `--renderless` flag, in the
+//   xterm-256color mode.
+bool VtIo::IsRenderless() const noexcept
+{
+    return _renderlessMode;
+}
+
 // Routine Description:
 //  Potentially starts this VtIo's input thread and render engine.
 //      If the VtIo hasn't yet been given pipes, then this function will
@@ -211,7 +249,10 @@ bool VtIo::IsUsingVt() const
     {
         try
         {
-            g.pRender->AddRenderEngine(_pVtRenderEngine.get());
+            if (!_renderlessMode)
+            {
+                g.pRender->AddRenderEngine(_pVtRenderEngine.get());
+            }
             g.getConsoleInformation().GetActiveOutputBuffer().SetTerminalConnection(_pVtRenderEngine.get());
             g.getConsoleInformation().GetActiveInputBuffer()->SetTerminalConnection(_pVtRenderEngine.get());
         }
@@ -356,7 +397,8 @@ void VtIo::CloseOutput()
     // owned by the paint.
     // Instead we're releasing the Engine here. A pointer to it has already been
     // given to the Renderer, so we don't want the unique_ptr to delete it. The
-    // Renderer will own its lifetime now.
+    // Renderer will own its lifetime now. In renderless mode it isn't owned by
+    // anyone, but the pipe is gone and we won't be around for much longer.
     _pVtRenderEngine.release();
 
     g.getConsoleInformation().GetActiveOutputBuffer().SetTerminalConnection(nullptr);
@@ -424,6 +466,37 @@ void VtIo::EndResize()
     }
 }
 
+// Method Description:
+// - Tell the vt renderer that the following resize was requested by the
+//   terminal, which has reflowed its contents on its own already.
+//   See VtEngine::BeginTerminalResize for more details.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtIo::BeginTerminalResize() noexcept
+{
+    if (_pVtRenderEngine)
+    {
+        _pVtRenderEngine->BeginTerminalResize();
+    }
+}
+
+// Method Description:
+// - Tell the vt renderer that the resize requested by the terminal is done.
+//   See BeginTerminalResize for more details.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtIo::EndTerminalResize() noexcept
+{
+    if (_pVtRenderEngine)
+    {
+        _pVtRenderEngine->EndTerminalResize();
+    }
+}
+
 #ifdef UNIT_TESTING
 // Method Description:
 // - This is a test helper method. It can be used to trick VtIo into responding
@@ -456,6 +529,39 @@ bool VtIo::IsResizeQuirkEnabled() const
     return _resizeQuirk;
 }
 
+// Method Description:
+// - Brackets the processing of output that the client wrote to the active
+//   buffer. In passthrough mode, the state machine writes it to the terminal
+//   as well, and the renderer ignores what it changes in the buffer.
+// - See also: VtEngine::EnablePassthrough
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtIo::BeginPassthroughWrite() noexcept
+{
+    if (_pVtRenderEngine)
+    {
+        _pVtRenderEngine->BeginPassthroughWrite();
+    }
+}
+
+// Method Description:
+// - Ends the processing of output started with BeginPassthroughWrite, and
+//   sends what was written to the terminal.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK if we wrote the output successfully, otherwise an appropriate HRESULT
+[[nodiscard]] HRESULT VtIo::EndPassthroughWrite() noexcept
+{
+    if (_pVtRenderEngine)
+    {
+        return _pVtRenderEngine->EndPassthroughWrite();
+    }
+    return S_OK;
+}
+
 // Method Description:
 // - Manually tell the renderer that it should emit a "Erase Scrollback"
 //   sequence to the connected terminal. We need to do this in certain cases
@@ -25,6 +25,7 @@ namespace Microsoft::Console::VirtualTerminal
         [[nodiscard]] HRESULT CreateIoHandlers() noexcept;
 
         bool IsUsingVt() const;
+        bool IsRenderless() const noexcept;
 
         [[nodiscard]] HRESULT StartIfNeeded();
 
@@ -38,6 +39,8 @@ namespace Microsoft::Console::VirtualTerminal
 
         void BeginResize();
         void EndResize();
+        void BeginTerminalResize() noexcept;
+        void EndTerminalResize() noexcept;
 
 #ifdef UNIT_TESTING
         void EnableConptyModeForTests(std::unique_ptr<Microsoft::Console::Render::VtEngine> vtRenderEngine);
@@ -45,6 +48,9 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool IsResizeQuirkEnabled() const;
 
+        void BeginPassthroughWrite() noexcept;
+        [[nodiscard]] HRESULT EndPassthroughWrite() noexcept;
+
         [[nodiscard]] HRESULT ManuallyClearScrollback() const noexcept;
 
     private:
@@ -63,6 +69,9 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool _resizeQuirk{ false };
         bool _win32InputMode{ false };
+        bool _passthroughMode{ false };
+        bool _renderlessMode{ false };
+        bool _repeatCharacter{ false };
 
         std::unique_ptr<Microsoft::Console::Render::VtEngine> _pVtRenderEngine;
         std::unique_ptr<Microsoft::Console::VtInputThread> _pVtInputThread;
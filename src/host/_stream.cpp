@@ -30,6 +30,35 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
 
 constexpr unsigned int LOCAL_BUFFER_SIZE = 100;
 
+// Routine Description:
+// - Measures the run of characters at the start of the string which
+//   WriteCharsLegacy would copy as they are, one column each.
+// Arguments:
+// - text - the characters left to write
+// - columns - the number of columns left on the current line
+// - unprocessed - whether ENABLE_PROCESSED_OUTPUT is off, which makes control characters printable
+// Return Value:
+// - the length of the run, at most the number of columns
+static size_t _PrintableRunLength(const std::wstring_view text, const size_t columns, const bool unprocessed) noexcept
+{
+    const auto limit = std::min(text.size(), columns);
+    size_t length = 0;
+    for (; length < limit; ++length)
+    {
+        const auto wch = til::at(text, length);
+        // ASCII is by far the most common, and is always narrow.
+        if (wch >= L' ' && wch < 0x007F)
+        {
+            continue;
+        }
+        if (!(IS_GLYPH_CHAR(wch) || unprocessed) || IsGlyphFullWidth(wch))
+        {
+            break;
+        }
+    }
+    return length;
+}
+
 // Routine Description:
 // - This routine updates the cursor position.  Its input is the non-special
 //   cased new location of the cursor.  For example, if the cursor were being
@@ -384,10 +413,30 @@ constexpr unsigned int LOCAL_BUFFER_SIZE = 100;
             }
         }
 
-        // As an optimization, collect characters in buffer and print out all at once.
         XPosition = cursor.GetPosition().X;
         size_t i = 0;
         wchar_t* LocalBufPtr = LocalBuffer;
+
+        // Plain text is by far the most common output. The longest run of it that
+        // fits on the current line is written straight from the string in one go,
+        // leaving only control characters, wide characters and the end of the
+        // line to the loop below.
+        const wchar_t* const pwchRun = pwchRealUnicode;
+        const size_t cchRun = _PrintableRunLength({ pwchRealUnicode, (BufferSize - *pcb) / sizeof(WCHAR) },
+                                                  gsl::narrow_cast<size_t>(std::max<SHORT>(coordScreenBufferSize.X - XPosition, 0)),
+                                                  fUnprocessed);
+        if (cchRun != 0)
+        {
+            i = cchRun;
+            XPosition += gsl::narrow_cast<SHORT>(cchRun);
+            lpString += cchRun;
+            pwchRealUnicode += cchRun;
+            pwchBuffer += cchRun;
+            *pcb += cchRun * sizeof(WCHAR);
+            goto EndWhile;
+        }
+
+        // As an optimization, collect characters in buffer and print out all at once.
         while (*pcb < BufferSize && i < LOCAL_BUFFER_SIZE && XPosition < coordScreenBufferSize.X)
         {
 #pragma prefast(suppress : 26019, "Buffer is taken in multiples of 2. Validation is ok.")
@@ -553,7 +602,7 @@ constexpr unsigned int LOCAL_BUFFER_SIZE = 100;
             }
 
             // line was wrapped if we're writing up to the end of the current row
-            OutputCellIterator it(std::wstring_view(LocalBuffer, i), Attributes);
+            OutputCellIterator it(std::wstring_view(cchRun != 0 ? pwchRun : LocalBuffer, i), Attributes);
             const auto itEnd = screenInfo.Write(it);
 
             // Notify accessibility
@@ -969,8 +1018,22 @@ constexpr unsigned int LOCAL_BUFFER_SIZE = 100;
                 StateMachine& machine = screenInfo.GetStateMachine();
                 size_t const cch = BufferSize / sizeof(WCHAR);
 
+                // In conpty's passthrough mode, the output is written to the terminal as
+                // it's processed. That's only what the terminal shows for the active buffer.
+                auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+                const bool passthrough = gci.IsInVtIoMode() && screenInfo.IsActiveScreenBuffer();
+                if (passthrough)
+                {
+                    gci.GetVtIo()->BeginPassthroughWrite();
+                }
+
                 machine.ProcessString({ pwchRealUnicode, cch });
                 *pcb += BufferSize;
+
+                if (passthrough)
+                {
+                    LOG_IF_FAILED(gci.GetVtIo()->EndPassthroughWrite());
+                }
             }
         }
 
@@ -26,26 +26,30 @@ using Microsoft::Console::Interactivity::ServiceLocator;
 
 struct case_insensitive_hash
 {
-    std::size_t operator()(const std::wstring& key) const
+    // Hashes the folded characters as they go, so that a lookup doesn't
+    // have to make a lowercase copy of the key first.
+    std::size_t operator()(const std::wstring& key) const noexcept
     {
-        std::wstring lower(key);
-        std::transform(lower.begin(), lower.end(), lower.begin(), ::towlower);
-        std::hash<std::wstring> hash;
-        return hash(lower);
+        std::size_t hash = 0;
+        for (const auto ch : key)
+        {
+            hash = hash * 31 + ::towlower(ch);
+        }
+        return hash;
     }
 };
 
 struct case_insensitive_equality
 {
-    bool operator()(const std::wstring& lhs, const std::wstring& rhs) const
+    bool operator()(const std::wstring& lhs, const std::wstring& rhs) const noexcept
     {
-        return 0 == _wcsicmp(lhs.data(), rhs.data());
+        return lhs.size() == rhs.size() && 0 == _wcsicmp(lhs.data(), rhs.data());
     }
 };
 
 std::unordered_map<std::wstring,
                    std::unordered_map<std::wstring,
-                                      std::wstring,
+                                      Alias::Target,
                                       case_insensitive_hash,
                                       case_insensitive_equality>,
                    case_insensitive_hash,
@@ -117,7 +121,7 @@ std::unordered_map<std::wstring,
         else
         {
             // Map will auto-create each level as necessary
-            g_aliasData[exeNameString][sourceString] = targetString;
+            g_aliasData[exeNameString][sourceString] = Alias::s_CompileTarget(targetString);
         }
     }
     CATCH_RETURN();
@@ -159,10 +163,10 @@ std::unordered_map<std::wstring,
     // We use .find for the iterators then dereference to search without creating entries.
     const auto exeIter = g_aliasData.find(exeNameString);
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), exeIter == g_aliasData.end());
-    const auto exeData = exeIter->second;
+    const auto& exeData = exeIter->second;
     const auto sourceIter = exeData.find(sourceString);
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), sourceIter == exeData.end());
-    const auto targetString = sourceIter->second;
+    const auto& targetString = sourceIter->second.text;
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), targetString.size() == 0);
 
     // TargetLength is a byte count, convert to characters.
@@ -336,18 +340,18 @@ static std::wstring aliasesSeparator(L"=");
         auto exeIter = g_aliasData.find(exeNameString);
         if (exeIter != g_aliasData.end())
         {
-            auto list = exeIter->second;
+            const auto& list = exeIter->second;
             for (auto& pair : list)
             {
                 // Alias stores lengths in bytes.
                 size_t cchSource = pair.first.size();
-                size_t cchTarget = pair.second.size();
+                size_t cchTarget = pair.second.text.size();
 
                 // If we're counting how much multibyte space will be needed, trial convert the source and target strings before we add.
                 if (!countInUnicode)
                 {
                     cchSource = GetALengthFromW(codepage, pair.first);
-                    cchTarget = GetALengthFromW(codepage, pair.second);
+                    cchTarget = GetALengthFromW(codepage, pair.second.text);
                 }
 
                 // Accumulate all sizes to the final string count.
@@ -467,12 +471,12 @@ void Alias::s_ClearCmdExeAliases()
     auto exeIter = g_aliasData.find(exeNameString);
     if (exeIter != g_aliasData.end())
     {
-        auto list = exeIter->second;
+        const auto& list = exeIter->second;
         for (auto& pair : list)
         {
             // Alias stores lengths in bytes.
             size_t const cchSource = pair.first.size();
-            size_t const cchTarget = pair.second.size();
+            size_t const cchTarget = pair.second.text.size();
 
             // Add up how many characters we will need for the full alias data.
             size_t cchNeeded = 0;
@@ -502,7 +506,7 @@ void Alias::s_ClearCmdExeAliases()
                 RETURN_IF_FAILED(SizeTSub(cchAliasBufferRemaining, aliasesSeparator.size(), &cchAliasBufferRemaining));
                 AliasesBufferPtrW += aliasesSeparator.size();
 
-                RETURN_IF_FAILED(StringCchCopyNW(AliasesBufferPtrW, cchAliasBufferRemaining, pair.second.data(), cchTarget));
+                RETURN_IF_FAILED(StringCchCopyNW(AliasesBufferPtrW, cchAliasBufferRemaining, pair.second.text.data(), cchTarget));
                 RETURN_IF_FAILED(SizeTSub(cchAliasBufferRemaining, cchTarget, &cchAliasBufferRemaining));
                 AliasesBufferPtrW += cchTarget;
 
@@ -824,24 +828,24 @@ void Alias::s_ClearCmdExeAliases()
 // - Trims leading spaces off of a string
 // Arguments:
 // - str - String to trim
-void Alias::s_TrimLeadingSpaces(std::wstring& str)
+void Alias::s_TrimLeadingSpaces(std::wstring_view& str)
 {
-    // Erase from the beginning of the string up until the first
+    // Drop from the beginning of the string up until the first
     // character found that is not a space.
-    str.erase(str.begin(),
-              std::find_if(str.begin(), str.end(), [](wchar_t ch) { return !std::iswspace(ch); }));
+    const auto firstNonSpace = std::find_if(str.begin(), str.end(), [](wchar_t ch) { return !std::iswspace(ch); });
+    str.remove_prefix(firstNonSpace - str.begin());
 }
 
 // Routine Description:
 // - Trims trailing \r\n off of a string
 // Arguments:
 // - str - String to trim
-void Alias::s_TrimTrailingCrLf(std::wstring& str)
+void Alias::s_TrimTrailingCrLf(std::wstring_view& str)
 {
     const auto trailingCrLfPos = str.find_last_of(UNICODE_CARRIAGERETURN);
-    if (std::wstring::npos != trailingCrLfPos)
+    if (std::wstring_view::npos != trailingCrLfPos)
     {
-        str.erase(trailingCrLfPos);
+        str = str.substr(0, trailingCrLfPos);
     }
 }
 
@@ -850,14 +854,14 @@ void Alias::s_TrimTrailingCrLf(std::wstring& str)
 // Arguments:
 // - str - String to tokenize
 // Return Value:
-// - Collection of tokenized strings
-std::deque<std::wstring> Alias::s_Tokenize(const std::wstring& str)
+// - Collection of tokenized strings, pointing into str
+std::vector<std::wstring_view> Alias::s_Tokenize(const std::wstring_view str)
 {
-    std::deque<std::wstring> result;
+    std::vector<std::wstring_view> result;
 
     size_t prevIndex = 0;
     auto spaceIndex = str.find(L' ');
-    while (std::wstring::npos != spaceIndex)
+    while (std::wstring_view::npos != spaceIndex)
     {
         const auto length = spaceIndex - prevIndex;
 
@@ -882,11 +886,11 @@ std::deque<std::wstring> Alias::s_Tokenize(const std::wstring& str)
 // - str - String to split into just args
 // Return Value:
 // - Only the arguments part of the string or empty if there are no arguments.
-std::wstring Alias::s_GetArgString(const std::wstring& str)
+std::wstring_view Alias::s_GetArgString(const std::wstring_view str)
 {
-    std::wstring result;
+    std::wstring_view result;
     auto firstSpace = str.find_first_of(L' ');
-    if (std::wstring::npos != firstSpace)
+    if (std::wstring_view::npos != firstSpace)
     {
         firstSpace++;
         if (firstSpace < str.size())
@@ -910,7 +914,7 @@ std::wstring Alias::s_GetArgString(const std::wstring& str)
 // - False if the given character doesn't match this macro.
 bool Alias::s_TryReplaceNumberedArgMacro(const wchar_t ch,
                                          std::wstring& appendToStr,
-                                         const std::deque<std::wstring>& tokens)
+                                         const std::vector<std::wstring_view>& tokens)
 {
     if (ch >= L'1' && ch <= L'9')
     {
@@ -940,7 +944,7 @@ bool Alias::s_TryReplaceNumberedArgMacro(const wchar_t ch,
 // - False if the given character doesn't match this macro.
 bool Alias::s_TryReplaceWildcardArgMacro(const wchar_t ch,
                                          std::wstring& appendToStr,
-                                         const std::wstring fullArgString)
+                                         const std::wstring_view fullArgString)
 {
     if (L'*' == ch)
     {
@@ -1052,36 +1056,41 @@ void Alias::s_AppendCrLf(std::wstring& appendToStr,
 }
 
 // Routine Description:
-// - Searches through the given string for macros and replaces them
-//   with the matching action
+// - Searches through the given target for macros and compiles them into
+//   the target's expansion. The macros for the command line arguments
+//   can only be replaced once the alias is used, so their places are
+//   recorded for that instead.
 // Arguments:
-// - str - On input, the string to search. On output, the string is replaced.
-// - tokens - The tokenized command line input. 0 is the alias, 1-N are arguments.
-// - fullArgString - Shorthand to 1-N argument string in case of wildcard match.
+// - text - The target of an alias.
 // Return Value:
-// - The number of commands in the final string (line feeds, CRLFs)
-size_t Alias::s_ReplaceMacros(std::wstring& str,
-                              const std::deque<std::wstring>& tokens,
-                              const std::wstring& fullArgString)
+// - The target and its compiled expansion.
+Alias::Target Alias::s_CompileTarget(std::wstring text)
 {
-    size_t lineCount = 0;
-    std::wstring finalText;
+    Target target{};
+    target.lineCount = 0;
+
+    auto& finalText = target.expansion;
+    finalText.reserve(text.size() + 2);
 
     // The target text may contain substitution macros indicated by $.
     // Walk through and substitute them as appropriate.
-    for (auto ch = str.cbegin(); ch < str.cend(); ch++)
+    for (auto ch = text.cbegin(); ch < text.cend(); ch++)
     {
         if (L'$' == *ch)
         {
             // Attempt to read ahead by one character.
             const auto chNext = ch + 1;
 
-            if (chNext < str.cend())
+            if (chNext < text.cend())
             {
-                auto isProcessed = s_TryReplaceNumberedArgMacro(*chNext, finalText, tokens);
-                if (!isProcessed)
+                auto isProcessed = false;
+                if ((*chNext >= L'1' && *chNext <= L'9') || L'*' == *chNext)
                 {
-                    isProcessed = s_TryReplaceWildcardArgMacro(*chNext, finalText, fullArgString);
+                    // Numbered and wildcard macros substitute the arguments,
+                    // which s_TryReplaceNumberedArgMacro and
+                    // s_TryReplaceWildcardArgMacro put here later.
+                    target.arguments.emplace_back(finalText.size(), *chNext);
+                    isProcessed = true;
                 }
                 if (!isProcessed)
                 {
@@ -1097,7 +1106,7 @@ size_t Alias::s_ReplaceMacros(std::wstring& str,
                 }
                 if (!isProcessed)
                 {
-                    isProcessed = s_TryReplaceNextCommandMacro(*chNext, finalText, lineCount);
+                    isProcessed = s_TryReplaceNextCommandMacro(*chNext, finalText, target.lineCount);
                 }
                 if (!isProcessed)
                 {
@@ -1124,11 +1133,10 @@ size_t Alias::s_ReplaceMacros(std::wstring& str,
     }
 
     // We always terminate with a CRLF to symbolize end of command.
-    s_AppendCrLf(finalText, lineCount);
+    s_AppendCrLf(finalText, target.lineCount);
 
-    // Give back the final text and count.
-    str.swap(finalText);
-    return lineCount;
+    target.text = std::move(text);
+    return target;
 }
 
 // Routine Description:
@@ -1141,45 +1149,36 @@ size_t Alias::s_ReplaceMacros(std::wstring& str,
 // - If we found a matching alias, this will be the processed data
 //   and lineCount is updated to the new number of lines.
 // - If we didn't match and process an alias, return an empty string.
-std::wstring Alias::s_MatchAndCopyAlias(const std::wstring& sourceText,
+std::wstring Alias::s_MatchAndCopyAlias(std::wstring_view sourceText,
                                         const std::wstring& exeName,
                                         size_t& lineCount)
 {
-    // Copy source text into a local for manipulation.
-    std::wstring sourceCopy(sourceText);
-
-    // Trim trailing \r\n off of sourceCopy if it has one.
-    s_TrimTrailingCrLf(sourceCopy);
+    // Trim trailing \r\n off of sourceText if it has one.
+    s_TrimTrailingCrLf(sourceText);
 
-    // Trim leading spaces off of sourceCopy if it has any.
-    s_TrimLeadingSpaces(sourceCopy);
+    // Trim leading spaces off of sourceText if it has any.
+    s_TrimLeadingSpaces(sourceText);
 
     // Check if we have an EXE in the list that matches the request first.
-    auto exeIter = g_aliasData.find(exeName);
+    const auto exeIter = g_aliasData.find(exeName);
     if (exeIter == g_aliasData.end())
     {
         // We found no data for this exe. Give back an empty string.
         return std::wstring();
     }
 
-    auto exeList = exeIter->second;
+    const auto& exeList = exeIter->second;
     if (exeList.size() == 0)
     {
         // If there's no match, give back an empty string.
         return std::wstring();
     }
 
-    // Tokenize the text by spaces
-    const auto tokens = s_Tokenize(sourceCopy);
-
-    // If there are no tokens, return an empty string
-    if (tokens.size() == 0)
-    {
-        return std::wstring();
-    }
-
-    // Find alias. If there isn't one, return an empty string
-    const auto alias = tokens.front();
+    // Find alias (the text up to the first space). If there isn't one, return an empty string.
+    // The key is kept around between calls, which all hold the console lock,
+    // so that looking up an alias doesn't have to allocate a string for it.
+    static std::wstring alias;
+    alias.assign(sourceText.substr(0, sourceText.find(L' ')));
     const auto aliasIter = exeList.find(alias);
     if (aliasIter == exeList.end())
     {
@@ -1187,19 +1186,47 @@ std::wstring Alias::s_MatchAndCopyAlias(const std::wstring& sourceText,
         return std::wstring();
     }
 
-    const auto target = aliasIter->second;
-    if (target.size() == 0)
+    const auto& target = aliasIter->second;
+    if (target.text.size() == 0)
     {
         return std::wstring();
     }
 
-    // Get the string of all parameters as a shorthand for $* later.
-    const auto allParams = s_GetArgString(sourceCopy);
+    // Aliases without argument macros expand to the same text every time.
+    if (target.arguments.empty())
+    {
+        lineCount = target.lineCount;
+        return target.expansion;
+    }
+
+    // Tokenize the text by spaces. 0 is the alias, 1-N are arguments.
+    // Get the string of all parameters as a shorthand for $* too.
+    const auto tokens = s_Tokenize(sourceText);
+    const auto allParams = s_GetArgString(sourceText);
 
-    // The final text will be the target but with macros replaced.
-    std::wstring finalText(target);
-    lineCount = s_ReplaceMacros(finalText, tokens, allParams);
+    // The final text is the expansion with the arguments put in.
+    std::wstring finalText;
+    size_t finalSize = target.expansion.size();
+    for (const auto& [offset, macro] : target.arguments)
+    {
+        const auto index = gsl::narrow_cast<size_t>(macro - L'0');
+        finalSize += L'*' == macro ? allParams.size() : (index < tokens.size() ? tokens[index].size() : 0);
+    }
+    finalText.reserve(finalSize);
+
+    size_t copied = 0;
+    for (const auto& [offset, macro] : target.arguments)
+    {
+        finalText.append(target.expansion, copied, offset - copied);
+        copied = offset;
+        if (!s_TryReplaceNumberedArgMacro(macro, finalText, tokens))
+        {
+            s_TryReplaceWildcardArgMacro(macro, finalText, allParams);
+        }
+    }
+    finalText.append(target.expansion, copied, std::wstring::npos);
 
+    lineCount = target.lineCount;
     return finalText;
 }
 
@@ -1226,7 +1253,9 @@ void Alias::s_MatchAndCopyAliasLegacy(_In_reads_bytes_(cbSource) PWCHAR pwchSour
 {
     try
     {
-        std::wstring sourceText(pwchSource, cbSource / sizeof(WCHAR));
+        // The source and target may be the same buffer, so the matched
+        // text is produced in full before it's copied over.
+        const std::wstring_view sourceText(pwchSource, cbSource / sizeof(WCHAR));
         size_t lineCount = lines;
 
         const auto targetText = s_MatchAndCopyAlias(sourceText, exeName, lineCount);
@@ -1261,7 +1290,7 @@ void Alias::s_TestAddAlias(std::wstring& exe,
                            std::wstring& alias,
                            std::wstring& target)
 {
-    g_aliasData[exe][alias] = target;
+    g_aliasData[exe][alias] = s_CompileTarget(target);
 }
 
 void Alias::s_TestClearAliases()
@@ -14,6 +14,19 @@ Abstract:
 class Alias
 {
 public:
+    // An alias target along with its expansion, compiled when the alias is set:
+    // the target with all the macros that don't depend on the command line
+    // replaced, and the places in it where the command line arguments go.
+    struct Target
+    {
+        std::wstring text;
+        std::wstring expansion;
+        std::vector<std::pair<size_t, wchar_t>> arguments;
+        size_t lineCount;
+    };
+
+    static Target s_CompileTarget(std::wstring text);
+
     static void s_ClearCmdExeAliases();
 
     static void s_MatchAndCopyAliasLegacy(_In_reads_bytes_(cbSource) PWCHAR pwchSource,
@@ -24,25 +37,22 @@ public:
                                           const std::wstring& exeName,
                                           DWORD& lines);
 
-    static std::wstring s_MatchAndCopyAlias(const std::wstring& sourceText,
+    static std::wstring s_MatchAndCopyAlias(std::wstring_view sourceText,
                                             const std::wstring& exeName,
                                             size_t& lineCount);
 
 private:
-    static void s_TrimLeadingSpaces(std::wstring& str);
-    static void s_TrimTrailingCrLf(std::wstring& str);
-    static std::deque<std::wstring> s_Tokenize(const std::wstring& str);
-    static std::wstring s_GetArgString(const std::wstring& str);
-    static size_t s_ReplaceMacros(std::wstring& str,
-                                  const std::deque<std::wstring>& tokens,
-                                  const std::wstring& fullArgString);
+    static void s_TrimLeadingSpaces(std::wstring_view& str);
+    static void s_TrimTrailingCrLf(std::wstring_view& str);
+    static std::vector<std::wstring_view> s_Tokenize(const std::wstring_view str);
+    static std::wstring_view s_GetArgString(const std::wstring_view str);
 
     static bool s_TryReplaceNumberedArgMacro(const wchar_t ch,
                                              std::wstring& appendToStr,
-                                             const std::deque<std::wstring>& tokens);
+                                             const std::vector<std::wstring_view>& tokens);
     static bool s_TryReplaceWildcardArgMacro(const wchar_t ch,
                                              std::wstring& appendToStr,
-                                             const std::wstring fullArgString);
+                                             const std::wstring_view fullArgString);
 
     static bool s_TryReplaceInputRedirMacro(const wchar_t ch,
                                             std::wstring& appendToStr);
@@ -44,42 +44,112 @@ CONSOLE_INFORMATION::CONSOLE_INFORMATION() :
 {
     ZeroMemory((void*)&CPInfo, sizeof(CPInfo));
     ZeroMemory((void*)&OutputCPInfo, sizeof(OutputCPInfo));
-    InitializeCriticalSection(&_csConsoleLock);
+    InitializeSRWLock(&_consoleLock);
+    _consoleLockOwner = 0;
+    _consoleLockRecursion = 0;
 }
 
-CONSOLE_INFORMATION::~CONSOLE_INFORMATION()
-{
-    DeleteCriticalSection(&_csConsoleLock);
-}
+thread_local ULONG CONSOLE_INFORMATION::s_sharedLockRecursion = 0;
+
+CONSOLE_INFORMATION::~CONSOLE_INFORMATION() = default;
 
+// Routine Description:
+// - Checks whether the current thread holds the console lock, exclusively or shared.
 bool CONSOLE_INFORMATION::IsConsoleLocked() const
 {
-    // The critical section structure's OwningThread field contains the ThreadId despite having the HANDLE type.
-    // This requires us to hard cast the ID to compare.
-    return _csConsoleLock.OwningThread == (HANDLE)GetCurrentThreadId();
+    return _consoleLockOwner.load(std::memory_order_relaxed) == GetCurrentThreadId() || s_sharedLockRecursion != 0;
 }
 
+// Routine Description:
+// - Locks the console exclusively. The lock is recursive, just like the
+//   critical section it used to be.
+// - A thread that holds the lock shared can't lock it exclusively, since it'd
+//   wait for itself to let go of it. That's a bug in the caller.
 #pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
 void CONSOLE_INFORMATION::LockConsole()
 {
-    EnterCriticalSection(&_csConsoleLock);
+    const auto self = GetCurrentThreadId();
+    if (_consoleLockOwner.load(std::memory_order_relaxed) == self)
+    {
+        ++_consoleLockRecursion;
+        return;
+    }
+
+    FAIL_FAST_IF(s_sharedLockRecursion != 0);
+    AcquireSRWLockExclusive(&_consoleLock);
+    _consoleLockOwner.store(self, std::memory_order_relaxed);
+    _consoleLockRecursion = 1;
 }
 
 #pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
 bool CONSOLE_INFORMATION::TryLockConsole()
 {
-    return !!TryEnterCriticalSection(&_csConsoleLock);
+    const auto self = GetCurrentThreadId();
+    if (_consoleLockOwner.load(std::memory_order_relaxed) == self)
+    {
+        ++_consoleLockRecursion;
+        return true;
+    }
+
+    if (s_sharedLockRecursion != 0 || !TryAcquireSRWLockExclusive(&_consoleLock))
+    {
+        return false;
+    }
+    _consoleLockOwner.store(self, std::memory_order_relaxed);
+    _consoleLockRecursion = 1;
+    return true;
 }
 
 #pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
 void CONSOLE_INFORMATION::UnlockConsole()
 {
-    LeaveCriticalSection(&_csConsoleLock);
+    if (--_consoleLockRecursion == 0)
+    {
+        _consoleLockOwner.store(0, std::memory_order_relaxed);
+        ReleaseSRWLockExclusive(&_consoleLock);
+    }
+}
+
+// Routine Description:
+// - Locks the console for reading only, so that other readers aren't held up.
+//   Nothing may be changed while holding the lock this way, not even caches
+//   that would be changed by const methods. If the current thread already
+//   holds the lock exclusively, this just locks it once more.
+#pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
+void CONSOLE_INFORMATION::LockConsoleShared()
+{
+    if (_consoleLockOwner.load(std::memory_order_relaxed) == GetCurrentThreadId())
+    {
+        ++_consoleLockRecursion;
+        return;
+    }
+
+    // Slim reader/writer locks can't be acquired shared recursively: a writer
+    // waiting in between would deadlock us. We only acquire it the first time.
+    if (s_sharedLockRecursion++ == 0)
+    {
+        AcquireSRWLockShared(&_consoleLock);
+    }
+}
+
+#pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
+void CONSOLE_INFORMATION::UnlockConsoleShared()
+{
+    if (_consoleLockOwner.load(std::memory_order_relaxed) == GetCurrentThreadId())
+    {
+        UnlockConsole();
+        return;
+    }
+
+    if (--s_sharedLockRecursion == 0)
+    {
+        ReleaseSRWLockShared(&_consoleLock);
+    }
 }
 
 ULONG CONSOLE_INFORMATION::GetCSRecursionCount()
 {
-    return _csConsoleLock.RecursionCount;
+    return _consoleLockOwner.load(std::memory_order_relaxed) == GetCurrentThreadId() ? _consoleLockRecursion : 0;
 }
 
 // Routine Description:
@@ -132,7 +132,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 //   from the input buffer and in the peek case they are not.
 // Arguments:
 // - pInputBuffer - The input buffer to take records from to return to the client
-// - outEvents - The storage location to fill with input events
+// - outRecords - The storage location to fill with input records
 // - eventReadCount - The number of events to read
 // - pInputReadHandleData - A structure that will help us maintain
 // some input context across various calls on the same input
@@ -152,7 +152,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // block, this will be returned along with context in *ppWaiter.
 // - Or an out of memory/math/string error message in NTSTATUS format.
 [[nodiscard]] static NTSTATUS _DoGetConsoleInput(InputBuffer& inputBuffer,
-                                                 std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+                                                 std::vector<INPUT_RECORD>& outRecords,
                                                  const size_t eventReadCount,
                                                  INPUT_READ_HANDLE_DATA& readHandleState,
                                                  const bool IsUnicode,
@@ -185,8 +185,8 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
         {
             return STATUS_INTEGER_OVERFLOW;
         }
-        std::deque<std::unique_ptr<IInputEvent>> readEvents;
-        NTSTATUS Status = inputBuffer.Read(readEvents,
+        std::vector<INPUT_RECORD> readRecords;
+        NTSTATUS Status = inputBuffer.Read(readRecords,
                                            amountToRead,
                                            IsPeek,
                                            true,
@@ -195,7 +195,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 
         if (CONSOLE_STATUS_WAIT == Status)
         {
-            FAIL_FAST_IF(!(readEvents.empty()));
+            FAIL_FAST_IF(!(readRecords.empty()));
             // If we're told to wait until later, move all of our context
             // to the read data object and send it back up to the server.
             waiter = std::make_unique<DirectReadData>(&inputBuffer,
@@ -203,17 +203,21 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
                                                       eventReadCount,
                                                       std::move(partialEvents));
         }
+        else if (NT_SUCCESS(Status) && IsUnicode)
+        {
+            // Unicode reads have nothing to split or carry over,
+            // so the records go back as they were stored.
+            outRecords = std::move(readRecords);
+        }
         else if (NT_SUCCESS(Status))
         {
             // split key events to oem chars if necessary
-            if (!IsUnicode)
+            std::deque<std::unique_ptr<IInputEvent>> readEvents = IInputEvent::Create(readRecords);
+            try
             {
-                try
-                {
-                    SplitToOem(readEvents);
-                }
-                CATCH_LOG();
+                SplitToOem(readEvents);
             }
+            CATCH_LOG();
 
             // combine partial and readEvents
             while (!partialEvents.empty())
@@ -229,7 +233,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
                 {
                     break;
                 }
-                outEvents.push_back(std::move(readEvents.front()));
+                outRecords.push_back(readEvents.front()->ToInputRecord());
                 readEvents.pop_front();
             }
 
@@ -255,7 +259,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // - The A version will convert to W using the console's current Input codepage (see SetConsoleCP)
 // Arguments:
 // - context - The input buffer to take records from to return to the client
-// - outEvents - storage location for read events
+// - outRecords - storage location for read records
 // - eventsToRead - The number of input events to read
 // - readHandleState - A structure that will help us maintain
 // some input context across various calls on the same input
@@ -266,7 +270,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // buffer), this contains context that will allow the server to
 // restore this call later.
 [[nodiscard]] HRESULT ApiRoutines::PeekConsoleInputAImpl(IConsoleInputObject& context,
-                                                         std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+                                                         std::vector<INPUT_RECORD>& outRecords,
                                                          const size_t eventsToRead,
                                                          INPUT_READ_HANDLE_DATA& readHandleState,
                                                          std::unique_ptr<IWaitRoutine>& waiter) noexcept
@@ -274,7 +278,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
     try
     {
         NTSTATUS Status = _DoGetConsoleInput(context,
-                                             outEvents,
+                                             outRecords,
                                              eventsToRead,
                                              readHandleState,
                                              false,
@@ -295,7 +299,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // - The W version accepts UCS-2 formatted characters (wide characters)
 // Arguments:
 // - context - The input buffer to take records from to return to the client
-// - outEvents - storage location for read events
+// - outRecords - storage location for read records
 // - eventsToRead - The number of input events to read
 // - readHandleState - A structure that will help us maintain
 // some input context across various calls on the same input
@@ -306,7 +310,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // buffer), this contains context that will allow the server to
 // restore this call later.
 [[nodiscard]] HRESULT ApiRoutines::PeekConsoleInputWImpl(IConsoleInputObject& context,
-                                                         std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+                                                         std::vector<INPUT_RECORD>& outRecords,
                                                          const size_t eventsToRead,
                                                          INPUT_READ_HANDLE_DATA& readHandleState,
                                                          std::unique_ptr<IWaitRoutine>& waiter) noexcept
@@ -314,7 +318,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
     try
     {
         NTSTATUS Status = _DoGetConsoleInput(context,
-                                             outEvents,
+                                             outRecords,
                                              eventsToRead,
                                              readHandleState,
                                              true,
@@ -335,7 +339,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // - The A version will convert to W using the console's current Input codepage (see SetConsoleCP)
 // Arguments:
 // - context - The input buffer to take records from to return to the client
-// - outEvents - storage location for read events
+// - outRecords - storage location for read records
 // - eventsToRead - The number of input events to read
 // - readHandleState - A structure that will help us maintain
 // some input context across various calls on the same input
@@ -346,7 +350,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // buffer), this contains context that will allow the server to
 // restore this call later.
 [[nodiscard]] HRESULT ApiRoutines::ReadConsoleInputAImpl(IConsoleInputObject& context,
-                                                         std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+                                                         std::vector<INPUT_RECORD>& outRecords,
                                                          const size_t eventsToRead,
                                                          INPUT_READ_HANDLE_DATA& readHandleState,
                                                          std::unique_ptr<IWaitRoutine>& waiter) noexcept
@@ -354,7 +358,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
     try
     {
         NTSTATUS Status = _DoGetConsoleInput(context,
-                                             outEvents,
+                                             outRecords,
                                              eventsToRead,
                                              readHandleState,
                                              false,
@@ -375,7 +379,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // - The W version accepts UCS-2 formatted characters (wide characters)
 // Arguments:
 // - context - The input buffer to take records from to return to the client
-// - outEvents - storage location for read events
+// - outRecords - storage location for read records
 // - eventsToRead - The number of input events to read
 // - readHandleState - A structure that will help us maintain
 // some input context across various calls on the same input
@@ -386,7 +390,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // buffer), this contains context that will allow the server to
 // restore this call later.
 [[nodiscard]] HRESULT ApiRoutines::ReadConsoleInputWImpl(IConsoleInputObject& context,
-                                                         std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+                                                         std::vector<INPUT_RECORD>& outRecords,
                                                          const size_t eventsToRead,
                                                          INPUT_READ_HANDLE_DATA& readHandleState,
                                                          std::unique_ptr<IWaitRoutine>& waiter) noexcept
@@ -394,7 +398,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
     try
     {
         NTSTATUS Status = _DoGetConsoleInput(context,
-                                             outEvents,
+                                             outRecords,
                                              eventsToRead,
                                              readHandleState,
                                              true,
@@ -786,7 +790,6 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 {
     try
     {
-        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         const auto& storageBuffer = context.GetActiveBuffer();
         const auto storageSize = storageBuffer.GetBufferSize().Dimensions();
 
@@ -825,41 +828,20 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
         // We will start reading the buffer at the point of the top left corner (origin) of the (potentially adjusted) request
         const auto sourcePoint = clippedRequestRectangle.Origin();
 
-        // Get an iterator to the beginning of the return buffer
-        // We might have to seek this forward or skip around if we clipped the request.
-        auto targetIter = targetBuffer.begin();
-        COORD targetPos = { 0 };
-        const auto targetLimit = Viewport::FromDimensions(targetPoint, clippedRequestRectangle.Dimensions());
-
-        // Get an iterator to the beginning of the request inside the screen buffer
-        // This should walk exactly along every cell of the clipped request.
-        auto sourceIter = storageBuffer.GetCellDataAt(sourcePoint, clippedRequestRectangle);
-
-        // Walk through every cell of the target, advancing the buffer.
-        // Validate that we always still have a valid iterator to the backing store,
-        // that we always are writing inside the user's buffer (before the end)
-        // and we're always targeting the user's buffer inside its original bounds.
-        while (sourceIter && targetIter < targetBuffer.end())
+        // Read the clipped request a row at a time into the part of the user's buffer it lines up with.
+        // The user's buffer may be smaller than the request, so stop reading wherever it ends.
+        const auto& textBuffer = storageBuffer.GetTextBuffer();
+        const auto width = gsl::narrow_cast<size_t>(std::max<SHORT>(clippedRequestRectangle.Width(), 0));
+        for (SHORT row = 0; width > 0 && row < clippedRequestRectangle.Height(); row++)
         {
-            // If the point we're trying to write is inside the limited buffer write zone...
-            if (targetLimit.IsInBounds(targetPos))
+            const auto targetOffset = gsl::narrow_cast<size_t>(targetPoint.Y + row) * targetSize.X + targetPoint.X;
+            if (targetOffset >= targetBuffer.size())
             {
-                // Copy the data into position...
-                *targetIter = gci.AsCharInfo(*sourceIter);
-                // ... and advance the read iterator.
-                sourceIter++;
+                break;
             }
 
-            // Always advance the write iterator, we might have skipped it due to clipping.
-            targetIter++;
-
-            // Increment the target
-            targetPos.X++;
-            if (targetPos.X >= targetSize.X)
-            {
-                targetPos.X = 0;
-                targetPos.Y++;
-            }
+            const auto cells = targetBuffer.subspan(targetOffset, std::min(width, targetBuffer.size() - targetOffset));
+            textBuffer.ReadCharInfos({ sourcePoint.X, gsl::narrow_cast<SHORT>(sourcePoint.Y + row) }, cells);
         }
 
         // Reply with the region we read out of the backing buffer (potentially clipped)
@@ -1006,12 +988,9 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
             // Now we make a subspan starting from that offset for as much of the original request as would fit
             const auto subspan = buffer.subspan(totalOffset, writeRectangle.Width());
 
-            // Convert to a CHAR_INFO view to fit into the iterator
+            // Convert to a CHAR_INFO view and write it to the target position in bulk.
             const auto charInfos = gsl::span<const CHAR_INFO>(subspan.data(), subspan.size());
-
-            // Make the iterator and write to the target position.
-            OutputCellIterator it(charInfos);
-            storageBuffer.Write(it, target);
+            storageBuffer.GetTextBuffer().WriteCharInfos(target, charInfos);
         }
 
         // Since we've managed to write part of the request, return the clamped part that we actually used.
@@ -13,6 +13,113 @@
 #include "../getset.h"
 #include <til/u8u16convert.h>
 
+#include <filesystem>
+#include <fstream>
+
+// Besides crashes, the fuzzer can look for inputs that are slow: If the environment variable
+// OPENCONSOLE_FUZZ_SLOW_CORPUS names a directory, every input is measured, and the ones that
+// take too long or allocate too often for their size are saved there. The limits can be changed with
+// OPENCONSOLE_FUZZ_MAX_NS_PER_BYTE and OPENCONSOLE_FUZZ_MAX_ALLOCS_PER_BYTE.
+// Running the fuzzer with that directory as its only argument measures its inputs again,
+// failing if any of them is still slow, so that the saved inputs work as a regression corpus.
+static constexpr double s_defaultMaxNanosecondsPerByte = 20000.0;
+static constexpr double s_defaultMaxAllocationsPerByte = 4.0;
+// Inputs are measured as if they were at least this large, so that the fixed
+// cost of a write doesn't make every tiny input look slow.
+static constexpr size_t s_minimumMeasuredSize = 64;
+
+// Every allocation of the process is counted, like in vtbench, so that the
+// allocations of an input can be told from the difference before and after it.
+static std::atomic<size_t> s_allocations{ 0 };
+
+void* __cdecl operator new(size_t size)
+{
+    ++s_allocations;
+    if (const auto p = malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* __cdecl operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* __cdecl operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    ++s_allocations;
+    return malloc(size ? size : 1);
+}
+
+void* __cdecl operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void __cdecl operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void __cdecl operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void __cdecl operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void __cdecl operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+struct InputCost
+{
+    double nanosecondsPerByte;
+    double allocationsPerByte;
+};
+
+struct CostLimits
+{
+    std::filesystem::path slowCorpus;
+    double maxNanosecondsPerByte{ s_defaultMaxNanosecondsPerByte };
+    double maxAllocationsPerByte{ s_defaultMaxAllocationsPerByte };
+
+    bool IsSlow(const InputCost& cost) const noexcept
+    {
+        return cost.nanosecondsPerByte > maxNanosecondsPerByte || cost.allocationsPerByte > maxAllocationsPerByte;
+    }
+};
+
+static std::wstring s_GetEnvironmentVariable(const wchar_t* name)
+{
+    std::wstring value(MAX_PATH, L'\0');
+    const auto length = GetEnvironmentVariableW(name, value.data(), gsl::narrow_cast<DWORD>(value.size()));
+    value.resize(length < value.size() ? length : 0);
+    return value;
+}
+
+static double s_GetLimit(const wchar_t* name, const double defaultValue)
+{
+    const auto value = s_GetEnvironmentVariable(name);
+    return value.empty() ? defaultValue : std::wcstod(value.c_str(), nullptr);
+}
+
+static const CostLimits& s_GetCostLimits()
+{
+    static const CostLimits limits{
+        s_GetEnvironmentVariable(L"OPENCONSOLE_FUZZ_SLOW_CORPUS"),
+        s_GetLimit(L"OPENCONSOLE_FUZZ_MAX_NS_PER_BYTE", s_defaultMaxNanosecondsPerByte),
+        s_GetLimit(L"OPENCONSOLE_FUZZ_MAX_ALLOCS_PER_BYTE", s_defaultMaxAllocationsPerByte),
+    };
+    return limits;
+}
+
 struct NullDeviceComm : public IDeviceComm
 {
     HRESULT SetServerInformation(CD_IO_SERVER_INFORMATION* const) const override
@@ -100,6 +207,73 @@ struct NullDeviceComm : public IDeviceComm
     return S_OK;
 }
 
+// Routine Description:
+// - Writes the input to the active screen buffer, through the state machine,
+//   and measures how long that takes and how often it allocates.
+// - The state machine is used directly, rather than going through WriteChars, so that
+//   the input is parsed as VT no matter the output mode the fuzzed input left behind.
+// Arguments:
+// - data, size - the input, in UTF-8
+// Return Value:
+// - the cost of the input per byte
+static InputCost MeasureInput(const uint8_t* data, size_t size)
+{
+    auto& gci = Microsoft::Console::Interactivity::ServiceLocator::LocateGlobals().getConsoleInformation();
+
+    const auto u16String{ til::u8u16(std::string_view{ reinterpret_cast<const char*>(data), size }) };
+    gci.LockConsole();
+    auto u = wil::scope_exit([&]() { gci.UnlockConsole(); });
+
+    LARGE_INTEGER frequency, start, end;
+    QueryPerformanceFrequency(&frequency);
+    const auto allocations = s_allocations.load();
+    QueryPerformanceCounter(&start);
+    try
+    {
+        gci.GetActiveOutputBuffer().GetStateMachine().ProcessString(u16String);
+    }
+    CATCH_LOG();
+    QueryPerformanceCounter(&end);
+
+    const auto measuredSize = static_cast<double>(std::max(size, s_minimumMeasuredSize));
+    const auto nanoseconds = static_cast<double>(end.QuadPart - start.QuadPart) * 1e9 / static_cast<double>(frequency.QuadPart);
+    return {
+        nanoseconds / measuredSize,
+        static_cast<double>(s_allocations.load() - allocations) / measuredSize,
+    };
+}
+
+// Routine Description:
+// - Saves an input that was too slow into the slow corpus, named after its contents,
+//   so that finding the same input again doesn't save it twice.
+static void SaveSlowInput(const std::filesystem::path& corpus, const uint8_t* data, size_t size, const InputCost& cost)
+{
+    const auto name = fmt::format(L"slow-{:016x}.bin", std::hash<std::string_view>{}({ reinterpret_cast<const char*>(data), size }));
+    std::ofstream file{ corpus / name, std::ios::binary };
+    file.write(reinterpret_cast<const char*>(data), gsl::narrow_cast<std::streamsize>(size));
+    fwprintf(stderr, L"slow input %s: %.0f ns/byte, %.2f allocations/byte\n", name.c_str(), cost.nanosecondsPerByte, cost.allocationsPerByte);
+}
+
+// Routine Description:
+// - Measures every input in the given corpus again, and reports the ones that are still slow.
+// Return Value:
+// - 0 if none of them is, 1 otherwise.
+static int ReplaySlowCorpus(const std::filesystem::path& corpus)
+{
+    const auto& limits = s_GetCostLimits();
+    int result = 0;
+    for (const auto& entry : std::filesystem::directory_iterator{ corpus })
+    {
+        std::ifstream file{ entry.path(), std::ios::binary };
+        const std::string input{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+        const auto cost = MeasureInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+        const auto slow = limits.IsSlow(cost);
+        wprintf(L"%s %s: %.0f ns/byte, %.2f allocations/byte\n", slow ? L"SLOW" : L"ok  ", entry.path().filename().c_str(), cost.nanosecondsPerByte, cost.allocationsPerByte);
+        result |= slow ? 1 : 0;
+    }
+    return result;
+}
+
 extern "C" __declspec(dllexport) HRESULT RunConhost()
 {
     Microsoft::Console::Interactivity::ServiceLocator::LocateGlobals().hInstance = wil::GetModuleInstanceHandle();
@@ -119,16 +293,34 @@ extern "C" __declspec(dllexport) HRESULT RunConhost()
 
 #ifdef FUZZING_BUILD
 extern "C" __declspec(dllexport) int LLVMFuzzerInitialize(int* /*argc*/, char*** /*argv*/)
+{
+    RETURN_IF_FAILED(RunConhost());
+    return 0;
+}
 #else
-int main(int /*argc*/, char** /*argv*/)
-#endif
+int wmain(int argc, wchar_t** argv)
 {
     RETURN_IF_FAILED(RunConhost());
+    if (argc == 2)
+    {
+        return ReplaySlowCorpus(argv[1]);
+    }
     return 0;
 }
+#endif
 
 extern "C" __declspec(dllexport) int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
 {
+    if (const auto& limits = s_GetCostLimits(); !limits.slowCorpus.empty())
+    {
+        const auto cost = MeasureInput(data, size);
+        if (limits.IsSlow(cost))
+        {
+            SaveSlowInput(limits.slowCorpus, data, size, cost);
+        }
+        return 0;
+    }
+
     auto& gci = Microsoft::Console::Interactivity::ServiceLocator::LocateGlobals().getConsoleInformation();
 
     const auto u16String{ til::u8u16(std::string_view{ reinterpret_cast<const char*>(data), size }) };
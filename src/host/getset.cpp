@@ -43,8 +43,8 @@ void ApiRoutines::GetConsoleInputModeImpl(InputBuffer& context, ULONG& mode) noe
     {
         Telemetry::Instance().LogApiCall(Telemetry::ApiCall::GetConsoleMode);
         const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         mode = context.InputMode;
 
@@ -68,8 +68,8 @@ void ApiRoutines::GetConsoleOutputModeImpl(SCREEN_INFORMATION& context, ULONG& m
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         mode = context.GetActiveBuffer().OutputMode;
     }
@@ -87,8 +87,8 @@ void ApiRoutines::GetConsoleOutputModeImpl(SCREEN_INFORMATION& context, ULONG& m
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         const auto readyEventCount = context.GetNumberOfReadyEvents();
         RETURN_IF_FAILED(SizeTToULong(readyEventCount, &events));
@@ -108,8 +108,8 @@ void ApiRoutines::GetConsoleScreenBufferInfoExImpl(const SCREEN_INFORMATION& con
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         data.bFullscreenSupported = FALSE; // traditional full screen with the driver support is no longer supported.
         // see MSFT: 19918103
@@ -152,8 +152,8 @@ void ApiRoutines::GetConsoleCursorInfoImpl(const SCREEN_INFORMATION& context,
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         size = context.GetActiveBuffer().GetTextBuffer().GetCursor().GetSize();
         isVisible = context.GetTextBuffer().GetCursor().IsVisible();
@@ -169,8 +169,8 @@ void ApiRoutines::GetConsoleSelectionInfoImpl(CONSOLE_SELECTION_INFO& consoleSel
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         const auto& selection = Selection::Instance();
         if (selection.IsInSelectingState())
@@ -1052,8 +1052,8 @@ void ApiRoutines::GetConsoleInputCodePageImpl(ULONG& codepage) noexcept
     try
     {
         const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         codepage = gci.CP;
     }
@@ -1074,8 +1074,8 @@ void ApiRoutines::GetConsoleOutputCodePageImpl(ULONG& codepage) noexcept
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
         unsigned int cp;
         DoSrvGetConsoleOutputCodePage(cp);
         codepage = cp;
@@ -1127,8 +1127,8 @@ void ApiRoutines::GetConsoleHistoryInfoImpl(CONSOLE_HISTORY_INFO& consoleHistory
     try
     {
         const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         consoleHistoryInfo.HistoryBufferSize = gci.GetHistoryBufferSize();
         consoleHistoryInfo.NumberOfHistoryBuffers = gci.GetNumberOfHistoryBuffers();
@@ -1174,8 +1174,8 @@ void ApiRoutines::GetConsoleDisplayModeImpl(ULONG& flags) noexcept
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         // Initialize flags portion of structure
         flags = 0;
@@ -1812,8 +1812,8 @@ void DoSrvPrivateRefreshWindow(_In_ const SCREEN_INFORMATION& screenInfo)
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         return GetConsoleTitleAImplHelper(title, written, needed, false);
     }
@@ -1835,8 +1835,8 @@ void DoSrvPrivateRefreshWindow(_In_ const SCREEN_INFORMATION& screenInfo)
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         return GetConsoleTitleWImplHelper(title, written, needed, false);
     }
@@ -1858,8 +1858,8 @@ void DoSrvPrivateRefreshWindow(_In_ const SCREEN_INFORMATION& screenInfo)
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         return GetConsoleTitleAImplHelper(title, written, needed, true);
     }
@@ -1881,8 +1881,8 @@ void DoSrvPrivateRefreshWindow(_In_ const SCREEN_INFORMATION& screenInfo)
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        LockConsoleShared();
+        auto Unlock = wil::scope_exit([&] { UnlockConsoleShared(); });
 
         return GetConsoleTitleWImplHelper(title, written, needed, true);
     }
@@ -2206,12 +2206,28 @@ void DoSrvPrivateMoveToBottom(SCREEN_INFORMATION& screenInfo)
             fillAttrs.SetStandardErase();
         }
 
-        const auto fillData = OutputCellIterator{ fillChar, fillAttrs, fillLength };
-        screenInfo.Write(fillData, startPosition, false);
+        // Whole rows of spaces (which is what ED and EL erase) are left to the
+        // buffer, which only clears their cells once they're looked at again.
+        const auto bufferSize = screenInfo.GetBufferSize();
+        auto fillPosition = startPosition;
+        auto remainingLength = fillLength;
+        if (fillChar == UNICODE_SPACE && fillPosition.X == 0 && bufferSize.IsInBounds(fillPosition))
+        {
+            const auto width = gsl::narrow_cast<size_t>(bufferSize.Width());
+            const auto rows = std::min(remainingLength / width, gsl::narrow_cast<size_t>(bufferSize.BottomExclusive() - fillPosition.Y));
+            THROW_HR_IF(E_OUTOFMEMORY, !screenInfo.GetTextBuffer().EraseRows(fillPosition.Y, fillPosition.Y + rows, fillAttrs));
+            remainingLength -= rows * width;
+            fillPosition.Y += gsl::narrow_cast<SHORT>(rows);
+        }
+
+        if (remainingLength != 0)
+        {
+            const auto fillData = OutputCellIterator{ fillChar, fillAttrs, remainingLength };
+            screenInfo.Write(fillData, fillPosition, false);
+        }
 
         // Notify accessibility
         auto endPosition = startPosition;
-        const auto bufferSize = screenInfo.GetBufferSize();
         bufferSize.MoveInBounds(fillLength - 1, endPosition);
         screenInfo.NotifyAccessibilityEventing(startPosition.X, startPosition.Y, endPosition.X, endPosition.Y);
         return S_OK;
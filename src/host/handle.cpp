@@ -28,3 +28,15 @@ void UnlockConsole()
         gci.UnlockConsole();
     }
 }
+
+void LockConsoleShared()
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.LockConsoleShared();
+}
+
+void UnlockConsoleShared()
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.UnlockConsoleShared();
+}
@@ -31,6 +31,62 @@ using Microsoft::Console::Interactivity::ServiceLocator;
 // If CommandHistory::s_Allocate and friends stop shuffling elements
 // for maintaining LRU, then this datatype can be changed.
 std::list<CommandHistory> CommandHistory::s_historyLists;
+std::unordered_map<std::wstring, std::vector<CommandHistory::HistoryListIterator>> CommandHistory::s_historyListsByApp;
+
+// Routine Description:
+// - Folds the case of an app name the way IsAppNameMatch compares them,
+//   for use as the key of s_historyListsByApp.
+std::wstring CommandHistory::s_FoldAppName(const std::wstring_view appName)
+{
+    std::wstring folded{ appName };
+    std::transform(folded.begin(), folded.end(), folded.begin(), [](wchar_t ch) {
+        return gsl::narrow_cast<wchar_t>(::towlower(ch));
+    });
+    return folded;
+}
+
+// Routine Description:
+// - Puts a history at the front of the list, as its most recently used
+//   entry, and indexes it by its app name.
+// Arguments:
+// - history - the history to store
+// Return Value:
+// - the stored history
+CommandHistory* CommandHistory::s_PushFront(const CommandHistory& history)
+{
+    auto& entries = s_historyListsByApp[s_FoldAppName(history._appName)];
+    entries.reserve(entries.size() + 1);
+    s_historyLists.push_front(history);
+    entries.insert(entries.begin(), s_historyLists.begin());
+    return &s_historyLists.front();
+}
+
+// Routine Description:
+// - Removes a history from the list and from the app name index.
+void CommandHistory::s_Erase(const HistoryListIterator it)
+{
+    const auto found = s_historyListsByApp.find(s_FoldAppName(it->_appName));
+    if (found != s_historyListsByApp.end())
+    {
+        auto& entries = found->second;
+        entries.erase(std::remove(entries.begin(), entries.end(), it), entries.end());
+        if (entries.empty())
+        {
+            s_historyListsByApp.erase(found);
+        }
+    }
+    s_historyLists.erase(it);
+}
+
+// Routine Description:
+// - Makes a history the most recently used one, without moving it in memory.
+void CommandHistory::s_MoveToFront(const HistoryListIterator it)
+{
+    auto& entries = s_historyListsByApp.at(s_FoldAppName(it->_appName));
+    const auto entry = std::find(entries.begin(), entries.end(), it);
+    std::rotate(entries.begin(), entry, std::next(entry));
+    s_historyLists.splice(s_historyLists.begin(), s_historyLists, it);
+}
 
 CommandHistory* CommandHistory::s_Find(const HANDLE processHandle)
 {
@@ -77,6 +133,13 @@ static bool CaseInsensitiveEquality(wchar_t a, wchar_t b)
     return ::towlower(a) == ::towlower(b);
 }
 
+static bool CaseInsensitiveLess(const std::wstring_view a, const std::wstring_view b)
+{
+    return std::lexicographical_compare(a.cbegin(), a.cend(), b.cbegin(), b.cend(), [](wchar_t a, wchar_t b) {
+        return ::towlower(a) < ::towlower(b);
+    });
+}
+
 bool CommandHistory::IsAppNameMatch(const std::wstring_view other) const
 {
     return std::equal(_appName.cbegin(), _appName.cend(), other.cbegin(), other.cend(), CaseInsensitiveEquality);
@@ -124,6 +187,7 @@ void CommandHistory::_Reset()
             // find free record.  if all records are used, free the lru one.
             if ((SHORT)_commands.size() == _maxCommands)
             {
+                _UnindexCommand(0);
                 _commands.erase(_commands.cbegin());
                 // move LastDisplayed back one in order to stay synced with the
                 // command it referred to before erasing the lru one
@@ -139,6 +203,7 @@ void CommandHistory::_Reset()
             {
                 _commands.emplace_back(newCommand);
             }
+            _IndexCommand(gsl::narrow<SHORT>(_commands.size() - 1));
 
             if (LastDisplayed == -1 ||
                 _commands.at(LastDisplayed).size() != newCommand.size() ||
@@ -249,6 +314,7 @@ std::wstring_view CommandHistory::GetLastCommand() const
 void CommandHistory::Empty()
 {
     _commands.clear();
+    _sortedCommands.clear();
     LastDisplayed = -1;
     WI_SetFlag(Flags, CLE_RESET);
 }
@@ -290,6 +356,7 @@ void CommandHistory::Realloc(const size_t commands)
     {
         _commands.emplace_back(oldCommands[i]);
     }
+    _ReindexCommands();
 
     WI_SetFlag(Flags, CLE_RESET);
     LastDisplayed = gsl::narrow<SHORT>(_commands.size()) - 1;
@@ -298,16 +365,18 @@ void CommandHistory::Realloc(const size_t commands)
 
 void CommandHistory::s_ReallocExeToFront(const std::wstring_view appName, const size_t commands)
 {
-    for (auto it = s_historyLists.begin(); it != s_historyLists.end(); it++)
+    const auto found = s_historyListsByApp.find(s_FoldAppName(appName));
+    if (found == s_historyListsByApp.end())
     {
-        if (WI_IsFlagSet(it->Flags, CLE_ALLOCATED) && it->IsAppNameMatch(appName))
-        {
-            CommandHistory backup = *it;
-            backup.Realloc(commands);
-
-            s_historyLists.erase(it);
-            s_historyLists.push_front(backup);
+        return;
+    }
 
+    for (const auto it : found->second)
+    {
+        if (WI_IsFlagSet(it->Flags, CLE_ALLOCATED))
+        {
+            it->Realloc(commands);
+            s_MoveToFront(it);
             return;
         }
     }
@@ -315,11 +384,15 @@ void CommandHistory::s_ReallocExeToFront(const std::wstring_view appName, const
 
 CommandHistory* CommandHistory::s_FindByExe(const std::wstring_view appName)
 {
-    for (auto& historyList : s_historyLists)
+    const auto found = s_historyListsByApp.find(s_FoldAppName(appName));
+    if (found != s_historyListsByApp.end())
     {
-        if (WI_IsFlagSet(historyList.Flags, CLE_ALLOCATED) && historyList.IsAppNameMatch(appName))
+        for (const auto it : found->second)
         {
-            return &historyList;
+            if (WI_IsFlagSet(it->Flags, CLE_ALLOCATED))
+            {
+                return &*it;
+            }
         }
     }
     return nullptr;
@@ -344,18 +417,19 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
     std::optional<CommandHistory> BestCandidate;
     bool SameApp = false;
 
-    for (auto it = s_historyLists.cbegin(); it != s_historyLists.cend(); it++)
+    if (const auto found = s_historyListsByApp.find(s_FoldAppName(appName)); found != s_historyListsByApp.end())
     {
-        if (WI_IsFlagClear(it->Flags, CLE_ALLOCATED))
+        // use LRU history buffer with same app name
+        const auto& entries = found->second;
+        const auto entry = std::find_if(entries.cbegin(), entries.cend(), [](const auto& it) {
+            return WI_IsFlagClear(it->Flags, CLE_ALLOCATED);
+        });
+        if (entry != entries.cend())
         {
-            // use LRU history buffer with same app name
-            if (it->IsAppNameMatch(appName))
-            {
-                BestCandidate = *it;
-                SameApp = true;
-                s_historyLists.erase(it);
-                break;
-            }
+            const auto it = *entry;
+            BestCandidate = *it;
+            SameApp = true;
+            s_Erase(it);
         }
     }
 
@@ -370,17 +444,17 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
         History.LastDisplayed = -1;
         History._maxCommands = gsl::narrow<SHORT>(gci.GetHistoryBufferSize());
         History._processHandle = processHandle;
-        return &s_historyLists.emplace_front(History);
+        return s_PushFront(History);
     }
     else if (!BestCandidate.has_value() && s_historyLists.size() > 0)
     {
         // If we have no candidate already and we need one, take the LRU (which is the back/last one) which isn't allocated.
-        for (auto it = s_historyLists.crbegin(); it != s_historyLists.crend(); it++)
+        for (auto it = s_historyLists.rbegin(); it != s_historyLists.rend(); it++)
         {
             if (WI_IsFlagClear(it->Flags, CLE_ALLOCATED))
             {
                 BestCandidate = *it;
-                s_historyLists.erase(std::next(it).base()); // trickery to turn reverse iterator into forward iterator for erase.
+                s_Erase(std::next(it).base()); // trickery to turn reverse iterator into forward iterator for erase.
                 break;
             }
         }
@@ -392,6 +466,7 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
         if (!SameApp)
         {
             BestCandidate->_commands.clear();
+            BestCandidate->_sortedCommands.clear();
             BestCandidate->LastDisplayed = -1;
             BestCandidate->_appName = appName;
         }
@@ -399,7 +474,7 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
         BestCandidate->_processHandle = processHandle;
         WI_SetFlag(BestCandidate->Flags, CLE_ALLOCATED);
 
-        return &s_historyLists.emplace_front(BestCandidate.value());
+        return s_PushFront(BestCandidate.value());
     }
 
     return nullptr;
@@ -472,6 +547,7 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
     {
         const auto str = _commands.at(iDel);
 
+        _UnindexCommand(iDel);
         if (iDel < iLast)
         {
             _commands.erase(_commands.cbegin() + iDel);
@@ -499,8 +575,70 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
     return {};
 }
 
+// Routine Description:
+// - Returns whether the command at index a sorts before the one at index b in _sortedCommands.
+bool CommandHistory::_SortsBefore(const SHORT a, const SHORT b) const
+{
+    const std::wstring_view commandA{ _commands.at(a) };
+    const std::wstring_view commandB{ _commands.at(b) };
+    if (CaseInsensitiveLess(commandA, commandB))
+    {
+        return true;
+    }
+    if (CaseInsensitiveLess(commandB, commandA))
+    {
+        return false;
+    }
+    return a < b;
+}
+
+// Routine Description:
+// - Adds the command at the given index to _sortedCommands.
+void CommandHistory::_IndexCommand(const SHORT index)
+{
+    const auto it = std::lower_bound(_sortedCommands.cbegin(), _sortedCommands.cend(), index, [this](const SHORT a, const SHORT b) {
+        return _SortsBefore(a, b);
+    });
+    _sortedCommands.insert(it, index);
+}
+
+// Routine Description:
+// - Removes the command at the given index from _sortedCommands, ahead of
+//   it being erased from _commands, and shifts the indices after it.
+void CommandHistory::_UnindexCommand(const SHORT index)
+{
+    const auto it = std::lower_bound(_sortedCommands.cbegin(), _sortedCommands.cend(), index, [this](const SHORT a, const SHORT b) {
+        return _SortsBefore(a, b);
+    });
+    if (it != _sortedCommands.cend() && *it == index)
+    {
+        _sortedCommands.erase(it);
+    }
+    for (auto& sorted : _sortedCommands)
+    {
+        if (sorted > index)
+        {
+            --sorted;
+        }
+    }
+}
+
+// Routine Description:
+// - Rebuilds _sortedCommands from scratch, after _commands was rearranged.
+void CommandHistory::_ReindexCommands()
+{
+    _sortedCommands.resize(_commands.size());
+    std::iota(_sortedCommands.begin(), _sortedCommands.end(), gsl::narrow_cast<SHORT>(0));
+    std::sort(_sortedCommands.begin(), _sortedCommands.end(), [this](const SHORT a, const SHORT b) {
+        return _SortsBefore(a, b);
+    });
+}
+
 // Routine Description:
 // - this routine finds the most recent command that starts with the letters already in the current command.  it returns the array index (no mod needed).
+// - The candidates are looked up in _sortedCommands. The found one is the
+//   first candidate walking back from the starting index, wrapping around
+//   to the newest command.
 [[nodiscard]] bool CommandHistory::FindMatchingCommand(const std::wstring_view givenCommand,
                                                        const SHORT startingIndex,
                                                        SHORT& indexFound,
@@ -527,24 +665,42 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
         return true;
     }
 
+    if (indexFound < 0 || indexFound >= gsl::narrow<SHORT>(_commands.size()))
+    {
+        return false;
+    }
+
     try
     {
-        for (size_t i = 0; i < _commands.size(); i++)
+        // The commands starting with givenCommand form one run of _sortedCommands.
+        // For an exact match, the run is narrowed down to the commands as long as it.
+        const auto begin = std::lower_bound(_sortedCommands.cbegin(), _sortedCommands.cend(), givenCommand, [this](const SHORT index, const std::wstring_view given) {
+            return CaseInsensitiveLess(_commands.at(index), given);
+        });
+        const auto exactMatch = WI_IsFlagSet(options, MatchOptions::ExactMatch);
+        const auto end = std::upper_bound(begin, _sortedCommands.cend(), givenCommand, [this, exactMatch](const std::wstring_view given, const SHORT index) {
+            const std::wstring_view storedCommand{ _commands.at(index) };
+            return CaseInsensitiveLess(given, exactMatch ? storedCommand : storedCommand.substr(0, given.size()));
+        });
+
+        // Pick the closest candidate at or before the starting index,
+        // or failing that the newest one, as walking back would.
+        SHORT closest = -1;
+        SHORT newest = -1;
+        for (auto it = begin; it != end; ++it)
         {
-            const auto& storedCommand = _commands.at(indexFound);
-            if ((WI_IsFlagClear(options, MatchOptions::ExactMatch) && (givenCommand.size() <= storedCommand.size())) || (givenCommand.size() == storedCommand.size()))
+            const auto index = *it;
+            if (index <= indexFound && index > closest)
             {
-                if (std::equal(storedCommand.begin(),
-                               storedCommand.begin() + givenCommand.size(),
-                               givenCommand.begin(),
-                               givenCommand.end(),
-                               CaseInsensitiveEquality))
-                {
-                    return true;
-                }
+                closest = index;
             }
+            newest = std::max(newest, index);
+        }
 
-            _Prev(indexFound);
+        if (newest != -1)
+        {
+            indexFound = closest != -1 ? closest : newest;
+            return true;
         }
     }
     CATCH_LOG();
@@ -555,6 +711,7 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
 #ifdef UNIT_TESTING
 void CommandHistory::s_ClearHistoryListStorage()
 {
+    s_historyListsByApp.clear();
     s_historyLists.clear();
 }
 #endif
@@ -567,6 +724,7 @@ void CommandHistory::s_ClearHistoryListStorage()
 void CommandHistory::Swap(const short indexA, const short indexB)
 {
     std::swap(_commands.at(indexA), _commands.at(indexB));
+    _ReindexCommands();
 }
 
 // Routine Description:
@@ -83,14 +83,35 @@ private:
     void _Dec(SHORT& ind) const;
     void _Inc(SHORT& ind) const;
 
+    bool _SortsBefore(const SHORT a, const SHORT b) const;
+    void _IndexCommand(const SHORT index);
+    void _UnindexCommand(const SHORT index);
+    void _ReindexCommands();
+
     std::vector<std::wstring> _commands;
     SHORT _maxCommands;
 
+    // The indices of _commands, sorted by command (ignoring case) and then
+    // by index, so that the commands starting with some text are found with
+    // a binary search instead of comparing against every command.
+    std::vector<SHORT> _sortedCommands;
+
     std::wstring _appName;
     HANDLE _processHandle;
 
+    using HistoryListIterator = std::list<CommandHistory>::iterator;
+
     static std::list<CommandHistory> s_historyLists;
 
+    // The entries of s_historyLists by their case-folded app name, each set
+    // in the same most-recently-used-first order as the list itself.
+    static std::unordered_map<std::wstring, std::vector<HistoryListIterator>> s_historyListsByApp;
+
+    static std::wstring s_FoldAppName(const std::wstring_view appName);
+    static CommandHistory* s_PushFront(const CommandHistory& history);
+    static void s_Erase(const HistoryListIterator it);
+    static void s_MoveToFront(const HistoryListIterator it);
+
 public:
     DWORD Flags;
     SHORT LastDisplayed;
@@ -30,6 +30,123 @@ Revision History:
 
 #include <deque>
 
+// A queue of input records kept in one contiguous block, so that reads can
+// copy runs of records out of it at once instead of visiting one event object
+// at a time. Popping only moves the head forward; the space in front of the
+// head is reused by prepends and reclaimed before the block has to grow.
+class InputRecordQueue
+{
+public:
+    using iterator = std::vector<INPUT_RECORD>::iterator;
+    using const_iterator = std::vector<INPUT_RECORD>::const_iterator;
+
+    bool empty() const noexcept
+    {
+        return _head == _records.size();
+    }
+
+    size_t size() const noexcept
+    {
+        return _records.size() - _head;
+    }
+
+    iterator begin() noexcept
+    {
+        return _records.begin() + _head;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return _records.begin() + _head;
+    }
+
+    iterator end() noexcept
+    {
+        return _records.end();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return _records.end();
+    }
+
+    gsl::span<const INPUT_RECORD> span() const noexcept
+    {
+        return { _records.data() + _head, size() };
+    }
+
+    INPUT_RECORD& front() noexcept
+    {
+        return _records[_head];
+    }
+
+    INPUT_RECORD& back() noexcept
+    {
+        return _records.back();
+    }
+
+    INPUT_RECORD& operator[](const size_t index) noexcept
+    {
+        return _records[_head + index];
+    }
+
+    const INPUT_RECORD& operator[](const size_t index) const noexcept
+    {
+        return _records[_head + index];
+    }
+
+    void push_back(const INPUT_RECORD& record)
+    {
+        if (_head != 0 && _records.size() == _records.capacity())
+        {
+            _records.erase(_records.begin(), _records.begin() + _head);
+            _head = 0;
+        }
+        _records.push_back(record);
+    }
+
+    void push_front(const gsl::span<const INPUT_RECORD> records)
+    {
+        if (records.size() <= _head)
+        {
+            _head -= records.size();
+            std::copy(records.begin(), records.end(), begin());
+        }
+        else
+        {
+            _records.insert(begin(), records.begin(), records.end());
+        }
+    }
+
+    void pop_front(const size_t count = 1) noexcept
+    {
+        _head += count;
+        if (_head >= _records.size())
+        {
+            clear();
+        }
+    }
+
+    void erase(const iterator first, const iterator last)
+    {
+        _records.erase(first, last);
+        if (_head >= _records.size())
+        {
+            clear();
+        }
+    }
+
+    void clear() noexcept
+    {
+        _records.clear();
+        _head = 0;
+    }
+
+private:
+    std::vector<INPUT_RECORD> _records;
+    size_t _head{ 0 };
+};
+
 class InputBuffer final : public ConsoleObjectHeader
 {
 public:
@@ -64,6 +181,13 @@ public:
                                 const bool Unicode,
                                 const bool Stream);
 
+    [[nodiscard]] NTSTATUS Read(_Out_ std::vector<INPUT_RECORD>& OutRecords,
+                                const size_t AmountToRead,
+                                const bool Peek,
+                                const bool WaitForData,
+                                const bool Unicode,
+                                const bool Stream);
+
     [[nodiscard]] NTSTATUS Read(_Out_ std::unique_ptr<IInputEvent>& inEvent,
                                 const bool Peek,
                                 const bool WaitForData,
@@ -81,7 +205,7 @@ public:
     void PassThroughWin32MouseRequest(bool enable);
 
 private:
-    std::deque<std::unique_ptr<IInputEvent>> _storage;
+    InputRecordQueue _storage;
     std::unique_ptr<IInputEvent> _readPartialByteSequence;
     std::unique_ptr<IInputEvent> _writePartialByteSequence;
     Microsoft::Console::VirtualTerminal::TerminalInput _termInput;
@@ -93,7 +217,7 @@ private:
     // Otherwise, we should be calling them.
     bool _vtInputShouldSuppress{ false };
 
-    void _ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+    void _ReadBuffer(_Out_ std::vector<INPUT_RECORD>& outRecords,
                      const size_t readCount,
                      _Out_ size_t& eventsRead,
                      const bool peek,
@@ -105,9 +229,9 @@ private:
                       _Out_ size_t& eventsWritten,
                       _Out_ bool& setWaitEvent);
 
-    bool _CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept;
-    bool _CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
-    bool _CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    bool _CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept;
+    bool _CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord) noexcept;
+    bool _CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord) noexcept;
     void _HandleConsoleSuspensionEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
     void _HandleTerminalInputCallback(_In_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
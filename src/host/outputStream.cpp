@@ -268,6 +268,30 @@ bool ConhostInternalGetSet::PrivateEnableWin32InputMode(const bool win32InputMod
     return true;
 }
 
+// Routine Description:
+// - Begins or ends a synchronized update, during which the renderer holds
+//   back its frames.
+//   PrivateSetSynchronizedOutput is an internal-only "API" call that the vt commands can execute,
+//     but it is not represented as a function call on out public API surface.
+// Arguments:
+// - enabled - true when the update begins, false when it ends.
+// Return Value:
+// - true always
+bool ConhostInternalGetSet::PrivateSetSynchronizedOutput(const bool enabled)
+{
+    _io.GetActiveOutputBuffer().GetRenderTarget().SetSynchronizedOutput(enabled);
+
+    // As a conpty, the end of the update is passed through to the terminal
+    // right after this returns. The frame that was held back has to be in
+    // the pipe before that, or the terminal would show it unsynchronized.
+    auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
+    if (!enabled && pRenderer != nullptr && IsConsolePty())
+    {
+        LOG_IF_FAILED(pRenderer->PaintFrame());
+    }
+    return true;
+}
+
 // Routine Description:
 // - Sets the terminal emulation mode to either ANSI-compatible or VT52.
 //   PrivateSetAnsiMode is an internal-only "API" call that the vt commands can execute,
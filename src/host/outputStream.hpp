@@ -75,6 +75,7 @@ public:
     bool PrivateSetCursorKeysMode(const bool applicationMode) override;
     bool PrivateSetKeypadMode(const bool applicationMode) override;
     bool PrivateEnableWin32InputMode(const bool win32InputMode) override;
+    bool PrivateSetSynchronizedOutput(const bool enabled) override;
 
     bool PrivateSetAnsiMode(const bool ansiMode) override;
     bool PrivateSetScreenMode(const bool reverseMode) override;
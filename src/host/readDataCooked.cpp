@@ -922,6 +922,17 @@ void COOKED_READ_DATA::SavePendingInput(const size_t index, const bool multiline
 {
     NTSTATUS Status = STATUS_SUCCESS;
 
+    // Plain characters arriving at the end of the line are stored as they come in,
+    // but echoed together once something else comes along or the input runs out,
+    // so that a paste is drawn in one pass rather than a character at a time.
+    const wchar_t* echoStart = nullptr;
+    auto echoDeferred = wil::scope_exit([&]() noexcept {
+        if (echoStart)
+        {
+            _EchoDeferred(echoStart);
+        }
+    });
+
     while (_bytesRead < _bufferSize)
     {
         wchar_t wch = UNICODE_NULL;
@@ -953,6 +964,27 @@ void COOKED_READ_DATA::SavePendingInput(const size_t index, const bool multiline
             _originalCursorPosition = _screenInfo.GetTextBuffer().GetCursor().GetPosition();
         }
 
+        if (!commandLineEditingKeys && _CanDeferEcho(wch))
+        {
+            if (!echoStart)
+            {
+                echoStart = _bufPtr;
+            }
+
+            *_bufPtr = wch;
+            _bytesRead += sizeof(WCHAR);
+            _bufPtr += 1;
+            _currentPosition += 1;
+            continue;
+        }
+
+        // Anything else may look at the screen, so it has to be up to date first.
+        if (echoStart)
+        {
+            _EchoDeferred(echoStart);
+            echoStart = nullptr;
+        }
+
         if (commandLineEditingKeys)
         {
             // TODO: this is super weird for command line popups only
@@ -991,6 +1023,56 @@ void COOKED_READ_DATA::SavePendingInput(const size_t index, const bool multiline
     return Status;
 }
 
+// Routine Description:
+// - Checks whether the given character can be stored without being echoed right away.
+// - That's the case for printable characters at the end of the line, for which
+//   ProcessInput would do nothing but store and echo them.
+// Arguments:
+// - wch - the character read from the input buffer
+// Return Value:
+// - true if the character can be stored and its echo deferred.
+bool COOKED_READ_DATA::_CanDeferEcho(const wchar_t wch) const noexcept
+{
+    return _echoInput &&
+           AtEol() &&
+           _bytesRead < (_bufferSize - (2 * sizeof(WCHAR))) &&
+           wch >= L' ' &&
+           wch != UNICODE_BACKSPACE2 &&
+           wch != EXTKEY_ERASE_PREV_WORD;
+}
+
+// Routine Description:
+// - Echoes the characters stored since the given position in a single pass, the way
+//   ProcessInput echoes each of them at the end of the line.
+// Arguments:
+// - start - the position in the buffer of the first character that wasn't echoed
+// Return Value:
+// - <none>
+void COOKED_READ_DATA::_EchoDeferred(const wchar_t* const start) noexcept
+{
+    size_t NumToWrite = (_bufPtr - start) * sizeof(WCHAR);
+    size_t NumSpaces = 0;
+    SHORT ScrollY = 0;
+    const auto status = WriteCharsLegacy(_screenInfo,
+                                         _backupLimit,
+                                         start,
+                                         start,
+                                         &NumToWrite,
+                                         &NumSpaces,
+                                         _originalCursorPosition.X,
+                                         WC_DESTRUCTIVE_BACKSPACE | WC_KEEP_CURSOR_VISIBLE | WC_PRINTABLE_CONTROL_CHARS,
+                                         &ScrollY);
+    if (NT_SUCCESS(status))
+    {
+        _originalCursorPosition.Y += ScrollY;
+    }
+    else
+    {
+        RIPMSG1(RIP_WARNING, "WriteCharsLegacy failed %x", status);
+    }
+    _visibleCharCount += NumSpaces;
+}
+
 // Routine Description:
 // - handles any tasks that need to be completed after the read input loop finishes
 // Arguments:
@@ -158,5 +158,8 @@ private:
 
     [[nodiscard]] NTSTATUS _readCharInputLoop(const bool isUnicode, size_t& numBytes) noexcept;
 
+    bool _CanDeferEcho(const wchar_t wch) const noexcept;
+    void _EchoDeferred(const wchar_t* const start) noexcept;
+
     [[nodiscard]] NTSTATUS _handlePostCharInputLoop(const bool isUnicode, size_t& numBytes, ULONG& controlKeyState) noexcept;
 };
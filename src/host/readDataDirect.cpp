@@ -29,7 +29,7 @@ DirectReadData::DirectReadData(_In_ InputBuffer* const pInputBuffer,
     ReadData(pInputBuffer, pInputReadHandleData),
     _eventReadCount{ eventReadCount },
     _partialEvents{ std::move(partialEvents) },
-    _outEvents{}
+    _outRecords{}
 {
 }
 
@@ -58,9 +58,8 @@ DirectReadData::~DirectReadData()
 // - pNumBytes - not used
 // - pControlKeyState - For certain types of reads, this specifies
 // which modifier keys were held.
-// - pOutputData - a pointer to a
-// std::deque<std::unique_ptr<IInputEvent>> that is used to the read
-// input events back to the server
+// - pOutputData - a pointer to a std::vector<INPUT_RECORD> that is
+// used to return the read input records back to the server
 // Return Value:
 // - true if the wait is done and result buffer/status code can be sent back to the client.
 // - false if we need to continue to wait until more data is available.
@@ -82,7 +81,7 @@ bool DirectReadData::Notify(const WaitTerminationReason TerminationReason,
     *pControlKeyState = 0;
     *pNumBytes = 0;
     bool retVal = true;
-    std::deque<std::unique_ptr<IInputEvent>> readEvents;
+    std::vector<INPUT_RECORD> readRecords;
 
     // If ctrl-c or ctrl-break was seen, ignore it.
     if (WI_IsAnyFlagSet(TerminationReason, (WaitTerminationReason::CtrlC | WaitTerminationReason::CtrlBreak)))
@@ -120,7 +119,7 @@ bool DirectReadData::Notify(const WaitTerminationReason TerminationReason,
 
         // calculate how many events we need to read
         size_t amountAlreadyRead;
-        if (FAILED(SizeTAdd(_partialEvents.size(), _outEvents.size(), &amountAlreadyRead)))
+        if (FAILED(SizeTAdd(_partialEvents.size(), _outRecords.size(), &amountAlreadyRead)))
         {
             *pReplyStatus = STATUS_INTEGER_OVERFLOW;
             return retVal;
@@ -132,7 +131,7 @@ bool DirectReadData::Notify(const WaitTerminationReason TerminationReason,
             return retVal;
         }
 
-        *pReplyStatus = _pInputBuffer->Read(readEvents,
+        *pReplyStatus = _pInputBuffer->Read(readRecords,
                                             amountToRead,
                                             false,
                                             false,
@@ -147,46 +146,57 @@ bool DirectReadData::Notify(const WaitTerminationReason TerminationReason,
 
     if (*pReplyStatus != CONSOLE_STATUS_WAIT)
     {
-        // split key events to oem chars if necessary
-        if (*pReplyStatus == STATUS_SUCCESS && !fIsUnicode)
+        if (fIsUnicode && _partialEvents.empty())
         {
-            try
+            // Unicode reads have nothing to split or carry over,
+            // so the records go back as they were stored.
+            _outRecords.insert(_outRecords.end(), readRecords.begin(), readRecords.end());
+        }
+        else
+        {
+            std::deque<std::unique_ptr<IInputEvent>> readEvents = IInputEvent::Create(readRecords);
+
+            // split key events to oem chars if necessary
+            if (*pReplyStatus == STATUS_SUCCESS && !fIsUnicode)
             {
-                SplitToOem(readEvents);
+                try
+                {
+                    SplitToOem(readEvents);
+                }
+                CATCH_LOG();
             }
-            CATCH_LOG();
-        }
 
-        // combine partial and whole events
-        while (!_partialEvents.empty())
-        {
-            readEvents.push_front(std::move(_partialEvents.back()));
-            _partialEvents.pop_back();
-        }
+            // combine partial and whole events
+            while (!_partialEvents.empty())
+            {
+                readEvents.push_front(std::move(_partialEvents.back()));
+                _partialEvents.pop_back();
+            }
 
-        // move read events to out storage
-        for (size_t i = 0; i < _eventReadCount; ++i)
-        {
-            if (readEvents.empty())
+            // move read events to out storage
+            for (size_t i = 0; i < _eventReadCount; ++i)
             {
-                break;
+                if (readEvents.empty())
+                {
+                    break;
+                }
+                _outRecords.push_back(readEvents.front()->ToInputRecord());
+                readEvents.pop_front();
             }
-            _outEvents.push_back(std::move(readEvents.front()));
-            readEvents.pop_front();
-        }
 
-        // store partial event if necessary
-        if (!readEvents.empty())
-        {
-            _pInputBuffer->StoreReadPartialByteSequence(std::move(readEvents.front()));
-            readEvents.pop_front();
-            FAIL_FAST_IF(!(readEvents.empty()));
+            // store partial event if necessary
+            if (!readEvents.empty())
+            {
+                _pInputBuffer->StoreReadPartialByteSequence(std::move(readEvents.front()));
+                readEvents.pop_front();
+                FAIL_FAST_IF(!(readEvents.empty()));
+            }
         }
 
-        // move events to pOutputData
-        std::deque<std::unique_ptr<IInputEvent>>* const pOutputDeque = reinterpret_cast<std::deque<std::unique_ptr<IInputEvent>>* const>(pOutputData);
-        *pNumBytes = _outEvents.size() * sizeof(INPUT_RECORD);
-        pOutputDeque->swap(_outEvents);
+        // move records to pOutputData
+        std::vector<INPUT_RECORD>* const pOutputRecords = reinterpret_cast<std::vector<INPUT_RECORD>* const>(pOutputData);
+        *pNumBytes = _outRecords.size() * sizeof(INPUT_RECORD);
+        pOutputRecords->swap(_outRecords);
     }
     return retVal;
 }
@@ -27,6 +27,7 @@ Revision History:
 #include "../types/inc/IInputEvent.hpp"
 #include <deque>
 #include <memory>
+#include <vector>
 
 class DirectReadData final : public ReadData
 {
@@ -51,5 +52,5 @@ public:
 private:
     const size_t _eventReadCount;
     std::deque<std::unique_ptr<IInputEvent>> _partialEvents;
-    std::deque<std::unique_ptr<IInputEvent>> _outEvents;
+    std::vector<INPUT_RECORD> _outRecords;
 };
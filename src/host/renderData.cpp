@@ -354,6 +354,40 @@ const std::vector<size_t> RenderData::GetPatternId(const COORD /*location*/) con
     return {};
 }
 
+uint64_t RenderData::GetPatternGeneration() const noexcept
+{
+    return 0;
+}
+
+// The find dialog of conhost colors the matches in the buffer instead.
+std::vector<Viewport> RenderData::GetSearchHighlights() const noexcept
+{
+    return {};
+}
+
+// The input of conhost isn't matched up with its output.
+Microsoft::Console::Render::InputEcho RenderData::GetInputEcho() const noexcept
+{
+    return {};
+}
+
+// Method Description:
+// - Locks the console for painting. The console is only read while painting,
+//      so the handlers of read-only APIs don't have to wait for the renderer.
+//   Callers should make sure to also call RenderData::UnlockConsoleShared once
+//      they're done with any querying they need to do.
+void RenderData::LockConsoleShared() noexcept
+{
+    ::LockConsoleShared();
+}
+
+// Method Description:
+// - Unlocks the console after a call to RenderData::LockConsoleShared.
+void RenderData::UnlockConsoleShared() noexcept
+{
+    ::UnlockConsoleShared();
+}
+
 // Routine Description:
 // - Converts a text attribute into the RGB values that should be presented, applying
 //   relevant table translation information and preferences.
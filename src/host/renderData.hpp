@@ -60,6 +60,12 @@ public:
     const std::wstring GetHyperlinkCustomId(uint16_t id) const noexcept override;
 
     const std::vector<size_t> GetPatternId(const COORD location) const noexcept override;
+    uint64_t GetPatternGeneration() const noexcept override;
+    std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlights() const noexcept override;
+    Microsoft::Console::Render::InputEcho GetInputEcho() const noexcept override;
+
+    void LockConsoleShared() noexcept override;
+    void UnlockConsoleShared() noexcept override;
 #pragma endregion
 
 #pragma region IUiaData
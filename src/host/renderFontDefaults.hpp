@@ -24,4 +24,9 @@ public:
 
     [[nodiscard]] HRESULT RetrieveDefaultFontNameForCodepage(const unsigned int codePage,
                                                              std::wstring& outFaceName);
+
+private:
+    // The list of TrueType fonts is read from the registry the first time it's needed,
+    // since pseudoconsole sessions usually never need it.
+    std::once_flag _fontListLoaded;
 };
@@ -97,6 +97,36 @@ SCREEN_INFORMATION::~SCREEN_INFORMATION()
                                                           const TextAttribute popupAttributes,
                                                           const UINT uiCursorSize,
                                                           _Outptr_ SCREEN_INFORMATION** const ppScreen)
+{
+    return _CreateInstance(coordWindowSize,
+                           fontInfo,
+                           coordScreenBufferSize,
+                           defaultAttributes,
+                           popupAttributes,
+                           uiCursorSize,
+                           nullptr,
+                           nullptr,
+                           ppScreen);
+}
+
+// Routine Description:
+// - See CreateInstance. This is how the alternate buffers are created, as they
+//   can reuse the text buffer of a previous alternate buffer and share the
+//   state machine of their main buffer.
+// Arguments:
+// - recycledBuffer - a text buffer of the same size as coordScreenBufferSize, to use
+//   instead of allocating a new one. May be null.
+// - sharedStateMachine - the state machine to use instead of creating one. May be null.
+// Return Value:
+[[nodiscard]] NTSTATUS SCREEN_INFORMATION::_CreateInstance(_In_ COORD coordWindowSize,
+                                                           const FontInfo fontInfo,
+                                                           _In_ COORD coordScreenBufferSize,
+                                                           const TextAttribute defaultAttributes,
+                                                           const TextAttribute popupAttributes,
+                                                           const UINT uiCursorSize,
+                                                           std::unique_ptr<TextBuffer> recycledBuffer,
+                                                           std::shared_ptr<StateMachine> sharedStateMachine,
+                                                           _Outptr_ SCREEN_INFORMATION** const ppScreen)
 {
     *ppScreen = nullptr;
 
@@ -116,16 +146,32 @@ SCREEN_INFORMATION::~SCREEN_INFORMATION()
         pScreen->UpdateBottom();
 
         // Set up text buffer
-        pScreen->_textBuffer = std::make_unique<TextBuffer>(coordScreenBufferSize,
-                                                            defaultAttributes,
-                                                            uiCursorSize,
-                                                            pScreen->_renderTarget);
+        if (recycledBuffer)
+        {
+            recycledBuffer->Recycle(defaultAttributes, uiCursorSize, pScreen->_renderTarget);
+            pScreen->_textBuffer = std::move(recycledBuffer);
+        }
+        else
+        {
+            pScreen->_textBuffer = std::make_unique<TextBuffer>(coordScreenBufferSize,
+                                                                defaultAttributes,
+                                                                uiCursorSize,
+                                                                pScreen->_renderTarget);
+        }
 
         const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         pScreen->_textBuffer->GetCursor().SetColor(gci.GetCursorColor());
         pScreen->_textBuffer->GetCursor().SetType(gci.GetCursorType());
 
-        const NTSTATUS status = pScreen->_InitializeOutputStateMachine();
+        NTSTATUS status = STATUS_SUCCESS;
+        if (sharedStateMachine)
+        {
+            pScreen->_stateMachine = std::move(sharedStateMachine);
+        }
+        else
+        {
+            status = pScreen->_InitializeOutputStateMachine();
+        }
 
         if (NT_SUCCESS(status))
         {
@@ -1870,13 +1916,26 @@ const SCREEN_INFORMATION& SCREEN_INFORMATION::GetMainBuffer() const
     auto initAttributes = GetAttributes();
     initAttributes.SetStandardErase();
 
-    NTSTATUS Status = SCREEN_INFORMATION::CreateInstance(WindowSize,
-                                                         existingFont,
-                                                         WindowSize,
-                                                         initAttributes,
-                                                         GetPopupAttributes(),
-                                                         Cursor::CURSOR_SMALL_SIZE,
-                                                         ppsiNewScreenBuffer);
+    // Apps flip in and out of the alternate buffer all the time, so reuse the
+    // text buffer of the last one, if the window hasn't changed size since.
+    auto& siMain = GetMainBuffer();
+    auto recycledBuffer = std::move(siMain._spareAltTextBuffer);
+    if (recycledBuffer && recycledBuffer->GetSize().Dimensions() != WindowSize)
+    {
+        recycledBuffer.reset();
+    }
+
+    // The alt buffer doesn't get a state machine of its own. It uses
+    // our current state machine, dispatcher, getset, etc.
+    NTSTATUS Status = SCREEN_INFORMATION::_CreateInstance(WindowSize,
+                                                          existingFont,
+                                                          WindowSize,
+                                                          initAttributes,
+                                                          GetPopupAttributes(),
+                                                          Cursor::CURSOR_SMALL_SIZE,
+                                                          std::move(recycledBuffer),
+                                                          _stateMachine,
+                                                          ppsiNewScreenBuffer);
     if (NT_SUCCESS(Status))
     {
         // Update the alt buffer's cursor style to match our own.
@@ -1885,13 +1944,6 @@ const SCREEN_INFORMATION& SCREEN_INFORMATION::GetMainBuffer() const
         createdBuffer->GetTextBuffer().GetCursor().SetStyle(myCursor.GetSize(), myCursor.GetColor(), myCursor.GetType());
 
         s_InsertScreenBuffer(createdBuffer);
-
-        // delete the alt buffer's state machine. We don't want it.
-        createdBuffer->_FreeOutputStateMachine(); // this has to be done before we give it a main buffer
-        // we'll attach the GetSet, etc once we successfully make this buffer the active buffer.
-
-        // Set up the new buffers references to our current state machine, dispatcher, getset, etc.
-        createdBuffer->_stateMachine = _stateMachine;
     }
     return Status;
 }
@@ -1970,6 +2022,8 @@ void SCREEN_INFORMATION::UseMainScreenBuffer()
 
         SCREEN_INFORMATION* psiAlt = psiMain->_psiAlternateBuffer;
         psiMain->_psiAlternateBuffer = nullptr;
+        // Keep the alt's text buffer for the next time we switch to the alternate buffer.
+        psiMain->_spareAltTextBuffer = std::move(psiAlt->_textBuffer);
         s_RemoveScreenBuffer(psiAlt); // this will also delete the alt buffer
         // deleting the alt buffer will give the GetSet back to its main
 
@@ -2226,10 +2280,7 @@ void SCREEN_INFORMATION::SetViewport(const Viewport& newViewport,
     // i.e. the current background color, but with no meta attributes set.
     auto fillAttributes = GetAttributes();
     fillAttributes.SetStandardErase();
-    auto fillPosition = COORD{ 0, _viewport.Top() };
-    auto fillLength = gsl::narrow_cast<size_t>(_viewport.Height() * GetBufferSize().Width());
-    auto fillData = OutputCellIterator{ fillAttributes, fillLength };
-    Write(fillData, fillPosition, false);
+    RETURN_HR_IF(E_OUTOFMEMORY, !_textBuffer->EraseRows(_viewport.Top(), _viewport.BottomExclusive(), fillAttributes));
 
     // Also reset the line rendition for the erased rows.
     _textBuffer->ResetLineRenditionRange(_viewport.Top(), _viewport.BottomExclusive());
@@ -2251,11 +2302,13 @@ void SCREEN_INFORMATION::SetTerminalConnection(_In_ ITerminalOutputConnection* c
     if (pTtyConnection)
     {
         engine.SetTerminalConnection(pTtyConnection,
-                                     std::bind(&StateMachine::FlushToTerminal, _stateMachine.get()));
+                                     std::bind(&StateMachine::FlushToTerminal, _stateMachine.get()),
+                                     std::bind(&StateMachine::FlushExecuteToTerminal, _stateMachine.get()));
     }
     else
     {
         engine.SetTerminalConnection(nullptr,
+                                     nullptr,
                                      nullptr);
     }
 }
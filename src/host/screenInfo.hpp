@@ -269,6 +269,16 @@ private:
     [[nodiscard]] NTSTATUS _InitializeOutputStateMachine();
     void _FreeOutputStateMachine();
 
+    [[nodiscard]] static NTSTATUS _CreateInstance(_In_ COORD coordWindowSize,
+                                                  const FontInfo fontInfo,
+                                                  _In_ COORD coordScreenBufferSize,
+                                                  const TextAttribute defaultAttributes,
+                                                  const TextAttribute popupAttributes,
+                                                  const UINT uiCursorSize,
+                                                  std::unique_ptr<TextBuffer> recycledBuffer,
+                                                  std::shared_ptr<Microsoft::Console::VirtualTerminal::StateMachine> sharedStateMachine,
+                                                  _Outptr_ SCREEN_INFORMATION** const ppScreen);
+
     [[nodiscard]] NTSTATUS _CreateAltBuffer(_Out_ SCREEN_INFORMATION** const ppsiNewScreenBuffer);
 
     bool _IsAltBuffer() const;
@@ -285,6 +295,7 @@ private:
 
     SCREEN_INFORMATION* _psiAlternateBuffer; // The VT "Alternate" screen buffer.
     SCREEN_INFORMATION* _psiMainBuffer; // A pointer to the main buffer, if this is the alternate buffer.
+    std::unique_ptr<TextBuffer> _spareAltTextBuffer; // The text buffer of the last alternate buffer, kept around to be reused by the next one.
 
     RECT _rcAltSavedClientNew;
     RECT _rcAltSavedClientOld;
@@ -107,6 +107,8 @@ public:
     void LockConsole();
     bool TryLockConsole();
     void UnlockConsole();
+    void LockConsoleShared();
+    void UnlockConsoleShared();
     bool IsConsoleLocked() const;
     ULONG GetCSRecursionCount();
 
@@ -150,7 +152,14 @@ public:
     RenderData renderData;
 
 private:
-    CRITICAL_SECTION _csConsoleLock; // serialize input and output using this
+    // Serializes input and output. Anything that changes the console holds it
+    // exclusively (and recursively), while the handlers of read-only APIs and
+    // the renderer only share it with each other, see LockConsoleShared.
+    SRWLOCK _consoleLock;
+    std::atomic<DWORD> _consoleLockOwner;
+    ULONG _consoleLockRecursion;
+    // The number of times the current thread holds _consoleLock shared.
+    static thread_local ULONG s_sharedLockRecursion;
     std::wstring _Title;
     std::wstring _Prefix; // Eg Select, Mark - things that we manually prepend to the title.
     std::wstring _TitleAndPrefix;
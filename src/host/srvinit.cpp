@@ -3,6 +3,8 @@
 
 #include "precomp.h"
 
+#include <condition_variable>
+
 #include "srvinit.h"
 
 #include "dbcs.h"
@@ -56,14 +58,18 @@ try
     Globals.uiOEMCP = GetOEMCP();
     Globals.uiWindowsCP = GetACP();
 
+    // The font list is only read from the registry once a font is actually looked up.
     Globals.pFontDefaultList = new RenderFontDefaults();
 
     FontInfoBase::s_SetFontDefaultList(Globals.pFontDefaultList);
 
     // Check if this conhost is allowed to delegate its activities to another.
     // If so, look up the registered default console handler.
+    // A headless session never hands off (see the IoDispatchers' connect handler),
+    // so don't bother reading the policy and the registry for it.
     bool isEnabled = false;
-    if (SUCCEEDED(Microsoft::Console::Internal::DefaultApp::CheckDefaultAppPolicy(isEnabled)) && isEnabled)
+    if (!args->IsHeadless() &&
+        SUCCEEDED(Microsoft::Console::Internal::DefaultApp::CheckDefaultAppPolicy(isEnabled)) && isEnabled)
     {
         IID delegationClsid;
         if (SUCCEEDED(DelegationConfig::s_GetDefaultConsoleId(delegationClsid)))
@@ -76,6 +82,8 @@ try
         }
     }
 
+    Tracing::s_TraceStartupPhase("ServerInitialization");
+
     // Removed allocation of scroll buffer here.
     return S_OK;
 }
@@ -213,6 +221,8 @@ static bool s_IsOnDesktop()
         settings.SetLaunchFaceName(settings.GetFaceName());
     }
 
+    Tracing::s_TraceStartupPhase("Settings");
+
     // Allocate console will read the global ServiceLocator::LocateGlobals().getConsoleInformation
     // for the settings we just set.
     NTSTATUS Status = CONSOLE_INFORMATION::AllocateConsole({ Title, TitleLength / sizeof(wchar_t) });
@@ -221,6 +231,8 @@ static bool s_IsOnDesktop()
         return Status;
     }
 
+    Tracing::s_TraceStartupPhase("AllocateConsole");
+
     return STATUS_SUCCESS;
 }
 
@@ -330,6 +342,8 @@ HRESULT ConsoleCreateIoThread(_In_ HANDLE Server,
     LOG_IF_FAILED(SetThreadDescription(hThread, L"Console Driver Message IO Thread"));
     LOG_IF_WIN32_BOOL_FALSE(CloseHandle(hThread)); // The thread will run on its own and close itself. Free the associated handle.
 
+    Tracing::s_TraceStartupPhase("IoThread");
+
     // See MSFT:19918626
     // Make sure to always set up the signal thread if we need to.
     // Do this first, because breaking the signal pipe is used by the conpty API
@@ -702,6 +716,11 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
     //  ... not on Desktop, with a visible window only get one if we are headful (not ConPTY).
     //  This prevents pseudoconsole-hosted applications from taking over the screen,
     //  even if they really beg us for a window.
+    //  ... in conpty's renderless mode never get one, not even a fake one.
+    if (g.getConsoleInformation().GetVtIo()->IsRenderless())
+    {
+        return false;
+    }
     return p->WindowVisible && (s_IsOnDesktop() || !g.IsHeadless());
 }
 
@@ -725,7 +744,14 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
     {
         g.pRender = nullptr;
 
-        auto renderThread = std::make_unique<RenderThread>();
+        // In conpty's renderless mode, the renderer doesn't have any engines to
+        // paint frames for, so it doesn't get a thread to do that either.
+        std::unique_ptr<RenderThread> renderThread;
+        if (!gci.GetVtIo()->IsRenderless())
+        {
+            renderThread = std::make_unique<RenderThread>();
+        }
+
         // stash a local pointer to the thread here -
         // We're going to give ownership of the thread to the Renderer,
         //      but the thread also need to be told who its renderer is,
@@ -734,15 +760,20 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
 
         g.pRender = new Renderer(&gci.renderData, nullptr, 0, std::move(renderThread));
 
-        THROW_IF_FAILED(localPointerToThread->Initialize(g.pRender));
+        if (localPointerToThread)
+        {
+            THROW_IF_FAILED(localPointerToThread->Initialize(g.pRender));
 
-        // Allow the renderer to paint.
-        g.pRender->EnablePainting();
+            // Allow the renderer to paint.
+            g.pRender->EnablePainting();
+        }
 
         // Set up the renderer to be used to calculate the width of a glyph,
         //      should we be unable to figure out its width another way.
         auto pfn = std::bind(&Renderer::IsGlyphWideByFont, static_cast<Renderer*>(g.pRender), std::placeholders::_1);
         SetGlyphWidthFallback(pfn);
+
+        Tracing::s_TraceStartupPhase("Renderer");
     }
     catch (...)
     {
@@ -786,6 +817,8 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
                 Status = STATUS_SUCCESS;
             }
 
+            Tracing::s_TraceStartupPhase("InputThread");
+
             // If we're not headless, we'll make a real window.
             // Allow UI Access to the real window but not the little
             // fake window we would make in headless mode.
@@ -836,14 +869,230 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
         {
             Status = NTSTATUS_FROM_HRESULT(hr);
         }
+
+        Tracing::s_TraceStartupPhase("VtIo");
     }
 
     return Status;
 }
 
+// The most requests serviced under a single hold of the console lock, so that
+// the renderer and the input thread still get a turn while a client floods us.
+static constexpr size_t s_maxIoBatchSize = 64;
+
+// The most requests read from the driver that haven't been serviced yet. Once they're
+// all queued up, the reader stops reading and the driver holds on to the rest.
+static constexpr size_t s_maxPendingIo = 2 * s_maxIoBatchSize;
+
+// The requests read from the driver by ConsoleIoReaderThread that ConsoleIoThread didn't service yet.
+// The messages are recycled through a fixed free list, so that their payload buffers are retained
+// from one request to the next, just like when ConsoleIoThread reads into a single message.
+static struct
+{
+    std::mutex lock;
+    std::condition_variable available;
+    std::condition_variable freed;
+    std::array<CONSOLE_API_MSG, s_maxPendingIo> storage;
+    std::vector<PCONSOLE_API_MSG> free;
+    std::vector<PCONSOLE_API_MSG> messages;
+} s_pendingIo;
+
+// Routine Description:
+// - This routine is the main one in the console server IO reader thread.
+// - The driver hands out exactly one message per read and the server handle isn't opened for
+//   overlapped IO, so this thread blocks on reads and queues up the messages in s_pendingIo,
+//   letting ConsoleIoThread see how many are pending and service them in batches.
+// - When no message is free, this thread waits for ConsoleIoThread to return some.
+// Arguments:
+// - <unused>
+// Return Value:
+// - This routine never returns. The process exits when no more references or clients exist.
+static DWORD WINAPI ConsoleIoReaderThread(LPVOID /*lpParameter*/)
+{
+    auto& globals = ServiceLocator::LocateGlobals();
+
+    for (;;)
+    {
+        PCONSOLE_API_MSG message = nullptr;
+        {
+            std::unique_lock lock{ s_pendingIo.lock };
+            s_pendingIo.freed.wait(lock, [] { return !s_pendingIo.free.empty(); });
+            message = s_pendingIo.free.back();
+            s_pendingIo.free.pop_back();
+        }
+
+        // Replies are completed by ConsoleIoThread, so none ride along on the read.
+        const auto hr = globals.pDeviceComm->ReadIo(nullptr, message);
+        if (FAILED(hr))
+        {
+            if (hr == HRESULT_FROM_WIN32(ERROR_PIPE_NOT_CONNECTED))
+            {
+                // This will not return. Terminate immediately when disconnected.
+                ServiceLocator::RundownAndExit(STATUS_SUCCESS);
+            }
+            RIPMSG1(RIP_WARNING, "DeviceIoControl failed with Result 0x%x", hr);
+
+            const std::lock_guard lock{ s_pendingIo.lock };
+            s_pendingIo.free.emplace_back(message);
+            continue;
+        }
+
+        {
+            const std::lock_guard lock{ s_pendingIo.lock };
+            s_pendingIo.messages.emplace_back(message);
+        }
+        s_pendingIo.available.notify_one();
+    }
+}
+
+// Routine Description:
+// - Starts ConsoleIoReaderThread. From then on, ConsoleIoThread must not read from the driver anymore.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if the thread is running, false if ConsoleIoThread needs to keep reading by itself.
+static bool s_StartIoReaderThread() noexcept
+try
+{
+    auto& globals = ServiceLocator::LocateGlobals();
+
+    // Neither list ever holds more than all of the messages, so they never reallocate later on.
+    s_pendingIo.free.reserve(s_maxPendingIo);
+    s_pendingIo.messages.reserve(s_maxPendingIo);
+    for (auto& message : s_pendingIo.storage)
+    {
+        message._pApiRoutines = &globals.api;
+        message._pDeviceComm = globals.pDeviceComm;
+        s_pendingIo.free.emplace_back(&message);
+    }
+
+    wil::unique_handle thread{ CreateThread(nullptr, 0, ConsoleIoReaderThread, nullptr, 0, nullptr) };
+    if (!thread)
+    {
+        LOG_LAST_ERROR();
+        return false;
+    }
+
+    LOG_IF_FAILED(SetThreadDescription(thread.get(), L"Console Driver Message Reader Thread"));
+    return true;
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    return false;
+}
+
+// Routine Description:
+// - Tells whether the given request reads from or writes to an output buffer. Consecutive ones
+//   targeting the same buffer get serviced under a single hold of the console lock.
+// - The console must be locked, since resolving the handle looks it up in the process' handle table.
+// Arguments:
+// - message - The request read from the driver.
+// Return Value:
+// - true if the request can be batched with its neighbours.
+static bool s_IsOutputBufferRequest(const CONSOLE_API_MSG& message) noexcept
+{
+    if (message.Descriptor.Function != CONSOLE_IO_USER_DEFINED &&
+        message.Descriptor.Function != CONSOLE_IO_RAW_WRITE)
+    {
+        return false;
+    }
+
+    const auto handle = message.GetObjectHandle();
+    return handle != nullptr && !handle->IsInputHandle();
+}
+
+// Routine Description:
+// - Takes everything ConsoleIoReaderThread queued up and services it in order. Runs of requests
+//   against the same output buffer are dispatched under a single hold of the console lock
+//   (the dispatchers lock it recursively) and their replies are completed together afterwards,
+//   instead of taking the lock and a driver round trip per request.
+// - Connects, disconnects and handle creation or closing are still serviced one at a time.
+// - Every serviced message goes back to the free list once its reply is completed.
+//   Pending replies are copied into their wait block, so those can be reused right away.
+// Arguments:
+// - <none>
+// Return Value:
+// - This routine never returns. The process exits when no more references or clients exist.
+[[noreturn]] static void s_ServiceIoBatches()
+{
+    auto& globals = ServiceLocator::LocateGlobals();
+    std::vector<PCONSOLE_API_MSG> batch;
+    std::vector<PCONSOLE_API_MSG> replies;
+    batch.reserve(s_maxPendingIo);
+    replies.reserve(s_maxIoBatchSize);
+
+    for (;;)
+    {
+        {
+            std::unique_lock lock{ s_pendingIo.lock };
+            s_pendingIo.available.wait(lock, [] { return !s_pendingIo.messages.empty(); });
+            batch.swap(s_pendingIo.messages);
+        }
+
+        for (size_t begin = 0; begin < batch.size();)
+        {
+            const auto first = begin;
+
+            LockConsole();
+
+            auto end = begin + 1;
+            if (s_IsOutputBufferRequest(*batch[begin]))
+            {
+                while (end < batch.size() &&
+                       end - begin < s_maxIoBatchSize &&
+                       batch[end]->Descriptor.Object == batch[begin]->Descriptor.Object &&
+                       s_IsOutputBufferRequest(*batch[end]))
+                {
+                    ++end;
+                }
+            }
+
+            // A lone request locks the console by itself, if it needs to.
+            const auto holdLock = end - begin > 1;
+            if (!holdLock)
+            {
+                UnlockConsole();
+            }
+
+            for (; begin < end; ++begin)
+            {
+                // Pending replies are copied into their wait block, which completes them later.
+                PCONSOLE_API_MSG reply = nullptr;
+                IoSorter::ServiceIoOperation(batch[begin], &reply);
+                if (reply != nullptr)
+                {
+                    replies.emplace_back(reply);
+                }
+            }
+
+            if (holdLock)
+            {
+                UnlockConsole();
+            }
+
+            for (const auto reply : replies)
+            {
+                LOG_IF_FAILED(reply->ReleaseMessageBuffers());
+                LOG_IF_FAILED(globals.pDeviceComm->CompleteIo(&reply->Complete));
+            }
+            replies.clear();
+
+            {
+                const std::lock_guard lock{ s_pendingIo.lock };
+                s_pendingIo.free.insert(s_pendingIo.free.end(), batch.begin() + first, batch.begin() + end);
+            }
+            s_pendingIo.freed.notify_one();
+        }
+
+        batch.clear();
+    }
+}
+
 // Routine Description:
 // - This routine is the main one in the console server IO thread.
 // - It reads IO requests submitted by clients through the driver, services and completes them in a loop.
+// - Once the console is initialized, reads move to ConsoleIoReaderThread and this thread services them in batches.
 // Arguments:
 // - lpParameter - PCONSOLE_API_MSG being handed off to us from the previous I/O.
 // Return Value:
@@ -875,7 +1124,7 @@ DWORD WINAPI ConsoleIoThread(LPVOID lpParameter)
         }
 
         // TODO: 9115192 correct mixed NTSTATUS/HRESULT
-        HRESULT hr = ServiceLocator::LocateGlobals().pDeviceComm->ReadIo(ReplyMsg, &ReceiveMsg);
+        HRESULT hr = globals.pDeviceComm->ReadIo(ReplyMsg, &ReceiveMsg);
         if (FAILED(hr))
         {
             if (hr == HRESULT_FROM_WIN32(ERROR_PIPE_NOT_CONNECTED))
@@ -891,6 +1140,20 @@ DWORD WINAPI ConsoleIoThread(LPVOID lpParameter)
         }
 
         IoSorter::ServiceIoOperation(&ReceiveMsg, &ReplyMsg);
+
+        // Once the session is set up it can't be handed off to another console host anymore,
+        // so reads can move to a thread of their own and we can service what piles up in batches.
+        if (WI_IsFlagSet(ServiceLocator::LocateGlobals().getConsoleInformation().Flags, CONSOLE_INITIALIZED) &&
+            s_StartIoReaderThread())
+        {
+            if (ReplyMsg != nullptr)
+            {
+                LOG_IF_FAILED(ReplyMsg->ReleaseMessageBuffers());
+                LOG_IF_FAILED(globals.pDeviceComm->CompleteIo(&ReplyMsg->Complete));
+            }
+
+            s_ServiceIoBatches();
+        }
     }
 
     return 0;
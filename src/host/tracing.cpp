@@ -415,6 +415,20 @@ void Tracing::s_TraceCookedRead(_In_z_ const wchar_t* pwszCookedBuffer)
         TraceLoggingKeyword(TraceKeywords::CookedRead));
 }
 
+// Marks the end of a phase of the console's startup. The time between two of
+// these events is how long the phase took.
+void Tracing::s_TraceStartupPhase(_In_z_ const char* const phase)
+{
+    TraceLoggingWrite(
+        g_hConhostV2EventTraceProvider,
+        "Startup",
+        TraceLoggingString(phase, "Phase"),
+        TraceLoggingBool(ServiceLocator::LocateGlobals().launchArgs.InConptyMode(), "InConptyMode"),
+        TraceLoggingBool(ServiceLocator::LocateGlobals().launchArgs.IsHeadless(), "IsHeadless"),
+        TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+        TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+}
+
 void __stdcall Tracing::TraceFailure(const wil::FailureInfo& failure) noexcept
 {
     TraceLoggingWrite(
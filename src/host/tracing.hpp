@@ -64,6 +64,8 @@ public:
 
     static void s_TraceCookedRead(_In_z_ const wchar_t* pwszCookedBuffer);
 
+    static void s_TraceStartupPhase(_In_z_ const char* const phase);
+
     static void __stdcall TraceFailure(const wil::FailureInfo& failure) noexcept;
 
 private:
@@ -389,9 +389,10 @@ class AliasTests
         _ReplacePercentWithCRLF(target);
         _ReplacePercentWithCRLF(expected);
 
-        Alias::s_TrimTrailingCrLf(target);
+        std::wstring_view actual{ target };
+        Alias::s_TrimTrailingCrLf(actual);
 
-        VERIFY_ARE_EQUAL(String(expected.data()), String(target.data()));
+        VERIFY_ARE_EQUAL(String(expected.data()), String(actual.data(), gsl::narrow<int>(actual.size())));
     }
 
     TEST_METHOD(Tokenize)
@@ -408,7 +409,7 @@ class AliasTests
 
         for (size_t i = 0; i < tokensExpected.size(); i++)
         {
-            VERIFY_ARE_EQUAL(String(tokensExpected[i].data()), String(tokensActual[i].data()));
+            VERIFY_ARE_EQUAL(String(tokensExpected[i].data()), String(tokensActual[i].data(), gsl::narrow<int>(tokensActual[i].size())));
         }
     }
 
@@ -424,7 +425,7 @@ class AliasTests
 
         for (size_t i = 0; i < tokensExpected.size(); i++)
         {
-            VERIFY_ARE_EQUAL(String(tokensExpected[i].data()), String(tokensActual[i].data()));
+            VERIFY_ARE_EQUAL(String(tokensExpected[i].data()), String(tokensActual[i].data(), gsl::narrow<int>(tokensActual[i].size())));
         }
     }
 
@@ -442,7 +443,7 @@ class AliasTests
         std::wstring expected;
         _RetrieveTargetExpectedPair(target, expected);
 
-        std::wstring actual = Alias::s_GetArgString(target);
+        const std::wstring actual{ Alias::s_GetArgString(target) };
 
         VERIFY_ARE_EQUAL(String(expected.data()), String(actual.data()));
     }
@@ -470,7 +471,7 @@ class AliasTests
         std::wstring expected;
         _RetrieveTargetExpectedPair(target, expected);
 
-        std::deque<std::wstring> tokens;
+        std::vector<std::wstring_view> tokens;
         tokens.emplace_back(L"alias");
         tokens.emplace_back(L"one");
         tokens.emplace_back(L"two");
@@ -647,4 +648,22 @@ class AliasTests
         VERIFY_ARE_EQUAL(String(expected.data()), String(actual.data()));
         VERIFY_ARE_EQUAL(lineCountExpected, lineCountActual);
     }
+
+    TEST_METHOD(CompileTarget)
+    {
+        const auto target = Alias::s_CompileTarget(L"a$1b$*$$$gc$T$x$");
+
+        const std::wstring expansionExpected(L"ab$$>c\r\n$x$\r\n");
+        VERIFY_ARE_EQUAL(String(expansionExpected.data()), String(target.expansion.data()));
+        VERIFY_ARE_EQUAL(String(L"a$1b$*$$$gc$T$x$"), String(target.text.data()));
+        VERIFY_ARE_EQUAL(size_t{ 2 }, target.lineCount);
+
+        const std::vector<std::pair<size_t, wchar_t>> argumentsExpected{ { 1u, L'1' }, { 2u, L'*' } };
+        VERIFY_ARE_EQUAL(argumentsExpected.size(), target.arguments.size());
+        for (size_t i = 0; i < argumentsExpected.size(); i++)
+        {
+            VERIFY_ARE_EQUAL(argumentsExpected[i].first, target.arguments[i].first);
+            VERIFY_ARE_EQUAL(argumentsExpected[i].second, target.arguments[i].second);
+        }
+    }
 };
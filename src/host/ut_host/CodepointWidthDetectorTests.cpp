@@ -62,6 +62,34 @@ class CodepointWidthDetectorTests
         }
     }
 
+    TEST_METHOD(CanGetColumnsOfText)
+    {
+        CodepointWidthDetector widthDetector;
+
+        // Long enough for the blocks of ASCII and ideographs, followed by everything else.
+        const std::wstring text = L"abcdefgh"
+                                  L"\x4E00\x4E01\x4E02\x4E03\x4E04\x4E05\x4E06\x4E07"
+                                  L"\xD83D\xDC7E" // U+1F47E alien monster
+                                  L"\xD800\x20AC" // unpaired surrogate, U+20AC euro sign
+                                  L"\xD835\xDC00"; // U+1D400 mathematical bold capital a
+        const std::vector<uint8_t> expected{ 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 1, 1, 0 };
+
+        std::vector<uint8_t> columns(text.size());
+        widthDetector.GetColumns(text, columns);
+        VERIFY_IS_TRUE(expected == columns);
+        VERIFY_ARE_EQUAL(29u, widthDetector.CountColumns(text));
+
+        // It has to agree with asking about one glyph at a time.
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (columns.at(i) != 0)
+            {
+                const auto length = i + 1 < text.size() && columns.at(i + 1) == 0 ? 2 : 1;
+                VERIFY_ARE_EQUAL(widthDetector.IsWide(text.substr(i, length)), columns.at(i) == 2);
+            }
+        }
+    }
+
     static bool FallbackMethod(const std::wstring_view glyph)
     {
         if (glyph.size() < 1)
@@ -76,26 +104,59 @@ class CodepointWidthDetectorTests
 
     TEST_METHOD(AmbiguousCache)
     {
-        // Set up a detector with fallback.
+        // Set up a detector with a fallback that counts how often it's asked.
+        size_t fallbackCalls = 0;
         CodepointWidthDetector widthDetector;
-        widthDetector.SetFallbackMethod(std::bind(&FallbackMethod, std::placeholders::_1));
+        widthDetector.SetFallbackMethod([&](const std::wstring_view glyph) {
+            ++fallbackCalls;
+            return FallbackMethod(glyph);
+        });
 
         // Ensure fallback cache is empty.
         VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.size());
 
         // Lookup ambiguous width character.
-        widthDetector.IsWide(ambiguous);
+        const auto wide = widthDetector.IsWide(ambiguous);
+        VERIFY_ARE_EQUAL(FallbackMethod(ambiguous), wide);
+        VERIFY_ARE_EQUAL(1u, fallbackCalls);
 
-        // Cache should hold it.
-        VERIFY_ARE_EQUAL(1u, widthDetector._fallbackCache.size());
-
-        // Cached item should match what we expect
-        const auto it = widthDetector._fallbackCache.begin();
-        VERIFY_ARE_EQUAL(ambiguous, it->first);
-        VERIFY_ARE_EQUAL(FallbackMethod(ambiguous), it->second);
+        // Cache should hold it, so the fallback isn't asked again.
+        VERIFY_ARE_EQUAL(wide, widthDetector.IsWide(ambiguous));
+        VERIFY_ARE_EQUAL(1u, fallbackCalls);
 
         // Cache should empty when font changes.
         widthDetector.NotifyFontChanged();
         VERIFY_ARE_EQUAL(0u, widthDetector._fallbackCache.size());
+        VERIFY_ARE_EQUAL(wide, widthDetector.IsWide(ambiguous));
+        VERIFY_ARE_EQUAL(2u, fallbackCalls);
+    }
+
+    TEST_METHOD(AmbiguousCacheSurrogatePairs)
+    {
+        // U+F0000 and U+F0001 are in the supplementary private use area, which is ambiguous.
+        // Their leading surrogates are the same, so they have to be told apart by codepoint.
+        static constexpr std::wstring_view first = L"\xDB80\xDC00";
+        static constexpr std::wstring_view second = L"\xDB80\xDC01";
+
+        CodepointWidthDetector widthDetector;
+        widthDetector.SetFallbackMethod([](const std::wstring_view glyph) {
+            return glyph.at(1) == 0xDC01;
+        });
+
+        VERIFY_IS_FALSE(widthDetector.IsWide(first));
+        VERIFY_IS_TRUE(widthDetector.IsWide(second));
+        VERIFY_IS_FALSE(widthDetector.IsWide(first));
+    }
+
+    TEST_METHOD(LookUpTableBoundaries)
+    {
+        // The codepoints on either side of the edges of a few ranges, one of which is in the middle of a page of the table.
+        CodepointWidthDetector widthDetector;
+        VERIFY_ARE_EQUAL(CodepointWidth::Narrow, widthDetector._lookupGlyphWidth(L"\x10FF"));
+        VERIFY_ARE_EQUAL(CodepointWidth::Wide, widthDetector._lookupGlyphWidth(L"\x1100"));
+        VERIFY_ARE_EQUAL(CodepointWidth::Wide, widthDetector._lookupGlyphWidth(L"\x115F"));
+        VERIFY_ARE_EQUAL(CodepointWidth::Narrow, widthDetector._lookupGlyphWidth(L"\x1160"));
+        VERIFY_ARE_EQUAL(CodepointWidth::Ambiguous, widthDetector._lookupGlyphWidth(L"\xDBFF\xDFFD")); // U+10FFFD
+        VERIFY_ARE_EQUAL(CodepointWidth::Narrow, widthDetector._lookupGlyphWidth(L"\xDBFF\xDFFE")); // U+10FFFE
     }
 };
@@ -0,0 +1,79 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../../types/inc/GraphemeSegmenter.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+class GraphemeSegmenterTests
+{
+    TEST_CLASS(GraphemeSegmenterTests);
+
+    // Splits the text into clusters, and returns their lengths in code units.
+    static std::vector<size_t> Segment(std::wstring_view text)
+    {
+        std::vector<size_t> lengths;
+        while (!text.empty())
+        {
+            const auto cluster = GraphemeSegmenter::ParseNext(text);
+            lengths.push_back(cluster.size());
+            text.remove_prefix(cluster.size());
+        }
+        return lengths;
+    }
+
+    TEST_METHOD(ParsesAscii)
+    {
+        VERIFY_IS_TRUE(std::vector<size_t>({ 1, 1, 1 }) == Segment(L"abc"));
+        VERIFY_IS_TRUE(std::vector<size_t>({ 1, 2, 1 }) == Segment(L"a\r\nb"));
+        VERIFY_IS_TRUE(std::vector<size_t>({ 1, 1 }) == Segment(L"\n\r"));
+        VERIFY_IS_TRUE(GraphemeSegmenter::ParseNext(L"").empty());
+    }
+
+    TEST_METHOD(KeepsCombiningMarks)
+    {
+        // e, combining acute accent, combining diaeresis
+        VERIFY_IS_TRUE(std::vector<size_t>({ 3, 1 }) == Segment(L"e\x0301\x0308x"));
+        // devanagari ka with the spacing vowel sign i
+        VERIFY_IS_TRUE(std::vector<size_t>({ 2 }) == Segment(L"\x0915\x093F"));
+        // a combining mark can't join a control character
+        VERIFY_IS_TRUE(std::vector<size_t>({ 1, 1 }) == Segment(L"\t\x0301"));
+    }
+
+    TEST_METHOD(JoinsHangulJamo)
+    {
+        // choseong kiyeok, jungseong a, jongseong kiyeok
+        VERIFY_IS_TRUE(std::vector<size_t>({ 3 }) == Segment(L"\x1100\x1161\x11A8"));
+        // the LV syllable ga followed by jongseong kiyeok, and the LVT syllable gag which can't take another vowel
+        VERIFY_IS_TRUE(std::vector<size_t>({ 2, 1, 1 }) == Segment(L"\xAC00\x11A8\xAC01\x1161"));
+    }
+
+    TEST_METHOD(JoinsEmojiSequences)
+    {
+        // man, zwj, woman, zwj, girl
+        VERIFY_IS_TRUE(std::vector<size_t>({ 8, 1 }) == Segment(L"\xD83D\xDC68\x200D\xD83D\xDC69\x200D\xD83D\xDC67!"));
+        // thumbs up with a skin tone modifier
+        VERIFY_IS_TRUE(std::vector<size_t>({ 4 }) == Segment(L"\xD83D\xDC4D\xD83C\xDFFD"));
+        // a zwj only joins pictographs
+        VERIFY_IS_TRUE(std::vector<size_t>({ 2, 2 }) == Segment(L"a\x200D\xD83D\xDC69"));
+    }
+
+    TEST_METHOD(PairsRegionalIndicators)
+    {
+        // US, DE and a lone F
+        const std::wstring flags = L"\xD83C\xDDFA\xD83C\xDDF8\xD83C\xDDE9\xD83C\xDDEA\xD83C\xDDEB";
+        VERIFY_IS_TRUE(std::vector<size_t>({ 4, 4, 2 }) == Segment(flags));
+        VERIFY_ARE_EQUAL(3u, GraphemeSegmenter::CountClusters(flags));
+    }
+
+    TEST_METHOD(SeparatesUnpairedSurrogates)
+    {
+        VERIFY_IS_TRUE(std::vector<size_t>({ 1, 1, 1 }) == Segment(L"\xD800\x0301\xDC00"));
+    }
+};
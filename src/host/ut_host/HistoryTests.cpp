@@ -242,6 +242,65 @@ class HistoryTests
         VERIFY_ARE_EQUAL(2ul, history->GetNumberOfCommands());
     }
 
+    TEST_METHOD(FindMatchingCommandWalksBackFromStart)
+    {
+        auto history = CommandHistory::s_Allocate(_manyApps[0], _MakeHandle(0));
+        VERIFY_IS_NOT_NULL(history);
+
+        VERIFY_SUCCEEDED(history->Add(L"dir", false));
+        VERIFY_SUCCEEDED(history->Add(L"cd ..", false));
+        VERIFY_SUCCEEDED(history->Add(L"dir /w", false));
+        VERIFY_SUCCEEDED(history->Add(L"ping", false));
+        VERIFY_SUCCEEDED(history->Add(L"DIR /p", false));
+
+        const auto options = CommandHistory::MatchOptions::JustLooking;
+        SHORT index;
+
+        Log::Comment(L"The closest match before the starting index is found, ignoring case.");
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir", 3, index, options));
+        VERIFY_ARE_EQUAL(2, index);
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir", 1, index, options));
+        VERIFY_ARE_EQUAL(0, index);
+
+        Log::Comment(L"Walking back from the oldest command wraps around to the newest.");
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir", 0, index, options));
+        VERIFY_ARE_EQUAL(4, index);
+
+        Log::Comment(L"An exact match skips the longer commands.");
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"DIR", 4, index, options | CommandHistory::MatchOptions::ExactMatch));
+        VERIFY_ARE_EQUAL(0, index);
+
+        Log::Comment(L"Nothing is found for text no command starts with.");
+        VERIFY_IS_FALSE(history->FindMatchingCommand(L"git", 4, index, options));
+        VERIFY_ARE_EQUAL(3, index);
+
+        Log::Comment(L"Removing a command shifts the ones after it.");
+        VERIFY_ARE_EQUAL(L"dir", history->Remove(0));
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir", 1, index, options));
+        VERIFY_ARE_EQUAL(3, index);
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir", 2, index, options));
+        VERIFY_ARE_EQUAL(1, index);
+
+        Log::Comment(L"Swapping commands moves them in the lookup too.");
+        history->Swap(0, 1);
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir", 1, index, options));
+        VERIFY_ARE_EQUAL(0, index);
+    }
+
+    TEST_METHOD(ReallocExeToFrontKeepsHistoryInPlace)
+    {
+        auto foo = CommandHistory::s_Allocate(_manyApps[0], _MakeHandle(0));
+        auto bar = CommandHistory::s_Allocate(_manyApps[1], _MakeHandle(1));
+        VERIFY_IS_NOT_NULL(foo);
+        VERIFY_IS_NOT_NULL(bar);
+        VERIFY_ARE_EQUAL(bar, &CommandHistory::s_historyLists.front());
+
+        CommandHistory::s_ReallocExeToFront(L"FOO.exe", 5);
+        VERIFY_ARE_EQUAL(foo, &CommandHistory::s_historyLists.front());
+        VERIFY_ARE_EQUAL(foo, CommandHistory::s_FindByExe(L"foo.EXE"));
+        VERIFY_ARE_EQUAL(bar, CommandHistory::s_FindByExe(_manyApps[1]));
+    }
+
 private:
     const std::array<std::wstring, 5> _manyApps = {
         L"foo.exe",
@@ -140,6 +140,7 @@ class ScreenBufferTests
     TEST_METHOD(TestAltBufferCursorState);
     TEST_METHOD(TestAltBufferVtDispatching);
     TEST_METHOD(TestAltBufferRIS);
+    TEST_METHOD(TestAltBufferIsRecycled);
 
     TEST_METHOD(SetDefaultsIndividuallyBothDefault);
     TEST_METHOD(SetDefaultsTogether);
@@ -148,6 +149,7 @@ class ScreenBufferTests
 
     TEST_METHOD(BackspaceDefaultAttrs);
     TEST_METHOD(BackspaceDefaultAttrsWriteCharsLegacy);
+    TEST_METHOD(WriteCharsLegacyPrintableRuns);
 
     TEST_METHOD(BackspaceDefaultAttrsInPrompt);
 
@@ -2173,6 +2175,40 @@ void ScreenBufferTests::TestAltBufferRIS()
     VERIFY_IS_FALSE(gci.GetActiveOutputBuffer()._IsAltBuffer());
 }
 
+void ScreenBufferTests::TestAltBufferIsRecycled()
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.LockConsole(); // Lock must be taken to manipulate buffer.
+    auto unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+    SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+    StateMachine& stateMachine = si.GetStateMachine();
+
+    Log::Comment(L"Switch to alt buffer and scribble on it");
+    stateMachine.ProcessString(L"\x1b[?1049h");
+    VERIFY_IS_TRUE(gci.GetActiveOutputBuffer()._IsAltBuffer());
+    const auto* const firstTextBuffer = &gci.GetActiveOutputBuffer().GetTextBuffer();
+    stateMachine.ProcessString(L"\x1b[?25l\x1b[3;5H\x1b[31mABC");
+
+    Log::Comment(L"Switch back to the main buffer and to the alt buffer again");
+    stateMachine.ProcessString(L"\x1b[?1049l");
+    VERIFY_IS_FALSE(gci.GetActiveOutputBuffer()._IsAltBuffer());
+    stateMachine.ProcessString(L"\x1b[?1049h");
+    auto& alt = gci.GetActiveOutputBuffer();
+    VERIFY_IS_TRUE(alt._IsAltBuffer());
+
+    Log::Comment(L"The alt buffer reuses the text buffer, but it starts out cleared");
+    auto& textBuffer = alt.GetTextBuffer();
+    VERIFY_ARE_EQUAL(firstTextBuffer, &textBuffer);
+    VERIFY_ARE_EQUAL(COORD({ 0, 0 }), textBuffer.GetCursor().GetPosition());
+    VERIFY_IS_TRUE(textBuffer.GetCursor().IsVisible());
+    VERIFY_ARE_EQUAL(L" ", textBuffer.GetCellDataAt({ 4, 2 })->Chars());
+    VERIFY_ARE_EQUAL(L" ", textBuffer.GetCellDataAt({ 6, 2 })->Chars());
+
+    stateMachine.ProcessString(L"\x1b[?1049l");
+    VERIFY_IS_FALSE(gci.GetActiveOutputBuffer()._IsAltBuffer());
+}
+
 void ScreenBufferTests::SetDefaultsIndividuallyBothDefault()
 {
     // Tests MSFT:19828103
@@ -2468,6 +2504,35 @@ void ScreenBufferTests::BackspaceDefaultAttrs()
     VERIFY_ARE_EQUAL(magenta, gci.LookupAttributeColors(attrB).second);
 }
 
+void ScreenBufferTests::WriteCharsLegacyPrintableRuns()
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer().GetActiveBuffer();
+    const TextBuffer& tbi = si.GetTextBuffer();
+    Cursor& cursor = si.GetTextBuffer().GetCursor();
+    const auto width = si.GetBufferSize().Width();
+
+    VERIFY_SUCCEEDED(si.SetViewportOrigin(true, COORD({ 0, 0 }), true));
+    cursor.SetPosition({ 0, 0 });
+
+    Log::Comment(L"Write a run of plain text up to a wide character at the end of the line, "
+                 L"then a tab in the middle of the next one.");
+    std::wstring content(gsl::narrow_cast<size_t>(width) - 2, L'a');
+    content.append(L"\x3042bc\td");
+    auto numBytes = content.size() * sizeof(wchar_t);
+    VERIFY_SUCCESS_NTSTATUS(WriteCharsLegacy(si, content.data(), content.data(), content.data(), &numBytes, nullptr, 0, 0, nullptr));
+    VERIFY_ARE_EQUAL(content.size() * sizeof(wchar_t), numBytes);
+
+    VERIFY_ARE_EQUAL(L"a", tbi.GetCellDataAt({ 0, 0 })->Chars());
+    VERIFY_ARE_EQUAL(L"a", tbi.GetCellDataAt({ gsl::narrow_cast<SHORT>(width - 3), 0 })->Chars());
+    VERIFY_ARE_EQUAL(L"\x3042", tbi.GetCellDataAt({ gsl::narrow_cast<SHORT>(width - 2), 0 })->Chars());
+    VERIFY_ARE_EQUAL(L"b", tbi.GetCellDataAt({ 0, 1 })->Chars());
+    VERIFY_ARE_EQUAL(L"c", tbi.GetCellDataAt({ 1, 1 })->Chars());
+    VERIFY_ARE_EQUAL(L" ", tbi.GetCellDataAt({ 7, 1 })->Chars());
+    VERIFY_ARE_EQUAL(L"d", tbi.GetCellDataAt({ 8, 1 })->Chars());
+    VERIFY_ARE_EQUAL(COORD({ 9, 1 }), cursor.GetPosition());
+}
+
 void ScreenBufferTests::BackspaceDefaultAttrsWriteCharsLegacy()
 {
     BEGIN_TEST_METHOD_PROPERTIES()
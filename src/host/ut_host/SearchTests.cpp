@@ -8,6 +8,7 @@
 #include "CommonState.hpp"
 
 #include "../buffer/out/search.h"
+#include "../buffer/out/RegexSearch.hpp"
 
 using namespace WEX::Common;
 using namespace WEX::Logging;
@@ -156,4 +157,175 @@ class SearchTests
         Search s(gci.renderData, L"\x304b", Search::Direction::Backward, Search::Sensitivity::CaseInsensitive);
         DoFoundChecks(s, coordStartExpected, -1);
     }
+
+    TEST_METHOD(IndexedForwardAndBackward)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+
+        Log::Comment(L"Needles of 3 or more cells go through the search index.");
+        for (const auto direction : { Search::Direction::Forward, Search::Direction::Backward })
+        {
+            Search s(gci.renderData, L"\x304dde", direction, Search::Sensitivity::CaseInsensitive);
+            VERIFY_IS_FALSE(s._needleTrigrams.empty());
+
+            for (SHORT i = 0; i < 4; ++i)
+            {
+                const SHORT row = direction == Search::Direction::Forward ? i : 3 - i;
+                VERIFY_IS_TRUE(s.FindNext());
+                VERIFY_ARE_EQUAL((COORD{ 5, row }), s._coordSelStart);
+                VERIFY_ARE_EQUAL((COORD{ 8, row }), s._coordSelEnd);
+            }
+            VERIFY_IS_FALSE(s.FindNext());
+        }
+    }
+
+    TEST_METHOD(IndexedSearchSeesChangedRows)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        {
+            Search s(gci.renderData, L"needle", Search::Direction::Forward, Search::Sensitivity::CaseSensitive);
+            VERIFY_IS_FALSE(s.FindNext());
+        }
+
+        Log::Comment(L"Rows written after the index was built have to be indexed again.");
+        textBuffer.WriteLine(OutputCellIterator{ L"a needle in the haystack" }, { 0, 200 });
+
+        Search s(gci.renderData, L"needle", Search::Direction::Forward, Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 2, 200 }), s._coordSelStart);
+        VERIFY_ARE_EQUAL((COORD{ 7, 200 }), s._coordSelEnd);
+        VERIFY_IS_FALSE(s.FindNext());
+    }
+
+    TEST_METHOD(RowScanMatchesPerGlyphComparison)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        Log::Comment(L"Plain rows are scanned as a whole. Rows with wide glyphs aren't, but have to give the same results.");
+        textBuffer.WriteLine(OutputCellIterator{ L"find the Needle, the NEEDLE and the needle" }, { 0, 100 });
+        textBuffer.WriteLine(OutputCellIterator{ L"\x304b nEEdle \x00e9 needle" }, { 0, 101 });
+        textBuffer.WriteLine(OutputCellIterator{ L"\x00e9\x00e9\x00e9 needlf needle" }, { 0, 102 });
+
+        const std::vector<COORD> expected{ { 9, 100 }, { 21, 100 }, { 36, 100 }, { 3, 101 }, { 12, 101 }, { 11, 102 } };
+
+        Search forward(gci.renderData, L"needle", Search::Direction::Forward, Search::Sensitivity::CaseInsensitive);
+        for (const auto start : expected)
+        {
+            VERIFY_IS_TRUE(forward.FindNext());
+            VERIFY_ARE_EQUAL(start, forward._coordSelStart);
+            VERIFY_ARE_EQUAL((COORD{ gsl::narrow_cast<SHORT>(start.X + 5), start.Y }), forward._coordSelEnd);
+        }
+        VERIFY_IS_FALSE(forward.FindNext());
+
+        Search backward(gci.renderData, L"needle", Search::Direction::Backward, Search::Sensitivity::CaseInsensitive);
+        for (auto it = expected.rbegin(); it != expected.rend(); ++it)
+        {
+            VERIFY_IS_TRUE(backward.FindNext());
+            VERIFY_ARE_EQUAL(*it, backward._coordSelStart);
+        }
+        VERIFY_IS_FALSE(backward.FindNext());
+
+        Log::Comment(L"Case sensitive, only the exact spelling is found.");
+        Search sensitive(gci.renderData, L"NEEDLE", Search::Direction::Forward, Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(sensitive.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 21, 100 }), sensitive._coordSelStart);
+        VERIFY_IS_FALSE(sensitive.FindNext());
+    }
+
+    TEST_METHOD(RegexForwardAndAround)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+
+        RegexSearch s(gci.renderData, L"a[b-c]", Search::Sensitivity::CaseInsensitive);
+        for (SHORT row = 0; row < 4; ++row)
+        {
+            VERIFY_IS_TRUE(s.FindNext());
+            VERIFY_ARE_EQUAL((COORD{ 0, row }), s.GetFoundLocation().first);
+            VERIFY_ARE_EQUAL((COORD{ 1, row }), s.GetFoundLocation().second);
+        }
+        VERIFY_IS_FALSE(s.FindNext());
+
+        Log::Comment(L"A match ends at the last cell of a wide glyph.");
+        RegexSearch wide(gci.renderData, L"\\u304dDE", Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(wide.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 5, 0 }), wide.GetFoundLocation().first);
+        VERIFY_ARE_EQUAL((COORD{ 8, 0 }), wide.GetFoundLocation().second);
+
+        Log::Comment(L"Case sensitive, nothing is found.");
+        RegexSearch sensitive(gci.renderData, L"a[b-c]", Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_FALSE(sensitive.FindNext());
+
+        Log::Comment(L"Without a selection, it's the first or the last match.");
+        RegexSearch forward(gci.renderData, L"AB", Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(forward.FindAround(Search::Direction::Forward));
+        VERIFY_ARE_EQUAL((COORD{ 0, 0 }), forward.GetFoundLocation().first);
+        RegexSearch backward(gci.renderData, L"AB", Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(backward.FindAround(Search::Direction::Backward));
+        VERIFY_ARE_EQUAL((COORD{ 0, 3 }), backward.GetFoundLocation().first);
+
+        Log::Comment(L"Patterns that aren't supported are rejected.");
+        VERIFY_THROWS_SPECIFIC(RegexSearch(gci.renderData, L"(a", Search::Sensitivity::CaseSensitive), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+    }
+
+    TEST_METHOD(MoveUpAfterCircling)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        Search s(gci.renderData, L"AB", Search::Direction::Forward, Search::Sensitivity::CaseSensitive, COORD{ 0, 0 });
+        RegexSearch regex(gci.renderData, L"AB", Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 0, 0 }), s.GetFoundLocation().first);
+        VERIFY_IS_TRUE(regex.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 0, 0 }), regex.GetFoundLocation().first);
+
+        Log::Comment(L"The rows move up by one, so the second match is on row 0 now.");
+        VERIFY_IS_TRUE(textBuffer.IncrementCircularBuffer());
+        s.MoveUp(1);
+        regex.MoveUp(1);
+
+        for (SHORT row = 0; row < 3; ++row)
+        {
+            VERIFY_IS_TRUE(s.FindNext());
+            VERIFY_ARE_EQUAL((COORD{ 0, row }), s.GetFoundLocation().first);
+            VERIFY_IS_TRUE(regex.FindNext());
+            VERIFY_ARE_EQUAL((COORD{ 0, row }), regex.GetFoundLocation().first);
+        }
+        VERIFY_IS_FALSE(s.FindNext());
+        VERIFY_IS_FALSE(regex.FindNext());
+
+        Log::Comment(L"Once where the search would go on circled out, it goes on at the top.");
+        Search gone(gci.renderData, L"AB", Search::Direction::Forward, Search::Sensitivity::CaseSensitive, COORD{ 0, 0 });
+        VERIFY_IS_TRUE(gone.FindNext());
+        VERIFY_IS_TRUE(gone.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 0, 1 }), gone.GetFoundLocation().first);
+        VERIFY_IS_TRUE(textBuffer.IncrementCircularBuffer());
+        VERIFY_IS_TRUE(textBuffer.IncrementCircularBuffer());
+        VERIFY_IS_TRUE(textBuffer.IncrementCircularBuffer());
+        gone.MoveUp(3);
+        VERIFY_IS_FALSE(gone.FindNext());
+    }
+
+    TEST_METHOD(RegexMatchesAcrossWrappedRows)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+
+        Log::Comment(L"Odd rows were wrapped into the next one, so a match can continue there.");
+        RegexSearch s(gci.renderData, L"E +AB", Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 8, 1 }), s.GetFoundLocation().first);
+        VERIFY_ARE_EQUAL((COORD{ 1, 2 }), s.GetFoundLocation().second);
+        VERIFY_IS_FALSE(s.FindNext());
+
+        Log::Comment(L"The blanks at the end of a row that wasn't wrapped aren't searched.");
+        RegexSearch blanks(gci.renderData, L"E ", Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(blanks.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 8, 1 }), blanks.GetFoundLocation().first);
+        VERIFY_IS_TRUE(blanks.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 8, 3 }), blanks.GetFoundLocation().first);
+        VERIFY_IS_FALSE(blanks.FindNext());
+    }
 };
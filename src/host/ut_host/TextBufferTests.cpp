@@ -10,6 +10,7 @@
 #include "globals.h"
 #include "../buffer/out/textBuffer.hpp"
 #include "../buffer/out/CharRow.hpp"
+#include "../buffer/out/RowSerializer.hpp"
 
 #include "input.h"
 #include "_stream.h"
@@ -24,6 +25,29 @@ using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
 
+namespace
+{
+    // Records the regions it's asked to redraw, and how many of them came before the buffer circled.
+    class RedrawRecordingTarget final : public Microsoft::Console::Render::IRenderTarget
+    {
+    public:
+        void TriggerRedraw(const Microsoft::Console::Types::Viewport& region) override { redraws.push_back(region.ToExclusive()); }
+        void TriggerRedraw(const COORD* const /*pcoord*/) override {}
+        void TriggerRedrawCursor(const COORD* const /*pcoord*/) override {}
+        void TriggerRedrawAll() override {}
+        void TriggerTeardown() noexcept override {}
+        void TriggerSelection() override {}
+        void TriggerScroll() override {}
+        void TriggerScroll(const COORD* const /*pcoordDelta*/) override {}
+        void TriggerCircling() override { circledAfter = redraws.size(); }
+        void TriggerTitleChange() override {}
+        void SetSynchronizedOutput(const bool /*enabled*/) override {}
+
+        std::vector<SMALL_RECT> redraws;
+        size_t circledAfter = 0;
+    };
+}
+
 class TextBufferTests
 {
     DummyRenderTarget _renderTarget;
@@ -106,6 +130,11 @@ class TextBufferTests
     TEST_METHOD(TestSetWrapOnCurrentRow);
 
     TEST_METHOD(TestIncrementCircularBuffer);
+    TEST_METHOD(TestIncrementCircularBufferClearsLazily);
+    TEST_METHOD(TestEraseRowsClearsLazily);
+    TEST_METHOD(GetRowsChangedSinceReportsModifiedRows);
+    TEST_METHOD(TakeSnapshotCopiesOnlyChangedRows);
+    TEST_METHOD(GetMemoryUsageBreaksDownBuffer);
 
     TEST_METHOD(TestMixedRgbAndLegacyForeground);
     TEST_METHOD(TestMixedRgbAndLegacyBackground);
@@ -140,6 +169,7 @@ class TextBufferTests
 
     TEST_METHOD(ResizeTraditionalRotationPreservesHighUnicode);
     TEST_METHOD(ScrollBufferRotationPreservesHighUnicode);
+    TEST_METHOD(ScrollRowsAcrossEndOfStorage);
 
     TEST_METHOD(ResizeTraditionalHighUnicodeRowRemoval);
     TEST_METHOD(ResizeTraditionalHighUnicodeColumnRemoval);
@@ -149,6 +179,7 @@ class TextBufferTests
     void WriteLinesToBuffer(const std::vector<std::wstring>& text, TextBuffer& buffer);
     TEST_METHOD(GetWordBoundaries);
     TEST_METHOD(MoveByWord);
+    TEST_METHOD(WordBoundariesFollowChanges);
     TEST_METHOD(GetGlyphBoundaries);
 
     TEST_METHOD(GetTextRects);
@@ -156,6 +187,27 @@ class TextBufferTests
 
     TEST_METHOD(HyperlinkTrim);
     TEST_METHOD(NoHyperlinkTrim);
+    TEST_METHOD(HyperlinkIdsAreReused);
+
+    TEST_METHOD(PackColdRows);
+    TEST_METHOD(ShareColdRows);
+
+    TEST_METHOD(ArchiveEvictedRows);
+    TEST_METHOD(ArchiveDropsOldestRows);
+    TEST_METHOD(PageInArchivedRows);
+    TEST_METHOD(SerializeRows);
+
+    TEST_METHOD(GetPatternsRescansChangedLines);
+
+    TEST_METHOD(WriteCellsMixesAsciiRunsAndWideText);
+    TEST_METHOD(WriteCellsFillsRunsUpToTheirLimit);
+
+    TEST_METHOD(CharInfosRoundTripThroughRows);
+
+    TEST_METHOD(ExportTextMatchesGetText);
+    TEST_METHOD(GetRowTextMatchesGetText);
+
+    TEST_METHOD(DeferDrawingMergesRedraws);
 };
 
 void TextBufferTests::TestBufferCreate()
@@ -189,7 +241,7 @@ void TextBufferTests::TestBufferRowByOffset()
     short sId = csBufferHeight / 2 - 5;
 
     const ROW& row = textBuffer.GetRowByOffset(sId);
-    VERIFY_ARE_EQUAL(row.GetId(), sId);
+    VERIFY_ARE_EQUAL(row.GetId(), gsl::narrow_cast<size_t>(sId));
 }
 
 void TextBufferTests::TestWrapFlag()
@@ -555,6 +607,16 @@ void TextBufferTests::TestGetLastNonSpaceCharacter()
 
     Log::Comment(L"Test with cursor way beyond last row of text");
     TestLastNonSpace(14);
+
+    Log::Comment(L"Test that writing past the text moves the end of it, after it was looked up already");
+    TextBuffer& textBuffer = GetTbi();
+    textBuffer.GetRowByOffset(6).WriteCells(OutputCellIterator(L"Z"), 5);
+    TestLastNonSpace(14);
+    VERIFY_ARE_EQUAL((COORD{ 5, 6 }), textBuffer.GetLastNonSpaceCharacter());
+
+    Log::Comment(L"Test that clearing that row again moves it back");
+    textBuffer.GetRowByOffset(6).Reset(textBuffer.GetCurrentAttributes());
+    TestLastNonSpace(14);
 }
 
 void TextBufferTests::TestSetWrapOnCurrentRow()
@@ -629,11 +691,205 @@ void TextBufferTests::TestIncrementCircularBuffer()
         VERIFY_ARE_EQUAL(textBuffer._firstRow, iNextRowIndex); // first row has incremented
         VERIFY_ARE_NOT_EQUAL(textBuffer._GetFirstRow(), FirstRow); // the old first row is no longer the first
 
-        // ensure old first row has been emptied
+        // ensure old first row has been emptied, once it's accessed as the new last row
+        VERIFY_ARE_EQUAL(&textBuffer.GetRowByOffset(sBufferHeight - 1), &FirstRow);
         VERIFY_IS_FALSE(FirstRow.GetCharRow().ContainsText());
     }
 }
 
+void TextBufferTests::TestIncrementCircularBufferClearsLazily()
+{
+    const COORD bufferSize{ 20, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    _buffer->WriteLine(OutputCellIterator{ L"\xD83D\xDE00 old", TextAttribute{ FOREGROUND_RED } }, { 0, 0 });
+    _buffer->GetRowByOffset(0).SetWrapForced(true);
+    const auto generation = _buffer->GetRowByOffset(0).GetCharRow().GetGeneration();
+
+    _buffer->SetCurrentAttributes(TextAttribute{ BACKGROUND_GREEN });
+    _buffer->IncrementCircularBuffer();
+
+    Log::Comment(L"The recycled row only gets marked, but its text is already considered changed.");
+    const auto& recycled = _buffer->_storage.at(0);
+    VERIFY_IS_TRUE(recycled.IsClearPending());
+    VERIFY_ARE_NOT_EQUAL(generation, recycled.GetCharRow().GetGeneration());
+    VERIFY_IS_FALSE(recycled.WasWrapForced());
+    VERIFY_ARE_EQUAL(TextAttribute{ BACKGROUND_GREEN }, recycled.GetAttrRow().GetAttrByColumn(0));
+
+    Log::Comment(L"Reading the row shows it blank, without clearing it.");
+    const auto& readOnly = *_buffer;
+    VERIFY_IS_FALSE(readOnly.GetRowByOffset(bufferSize.Y - 1).GetCharRow().ContainsText());
+    VERIFY_ARE_EQUAL(0u, readOnly.GetRowByOffset(bufferSize.Y - 1).MeasureRight());
+    VERIFY_IS_TRUE(recycled.IsClearPending());
+
+    Log::Comment(L"Accessing the row through the buffer clears it.");
+    const auto& row = _buffer->GetRowByOffset(bufferSize.Y - 1);
+    VERIFY_ARE_EQUAL(&recycled, &row);
+    VERIFY_IS_FALSE(row.IsClearPending());
+    VERIFY_IS_FALSE(row.GetCharRow().ContainsText());
+    VERIFY_IS_TRUE(row.GetUnicodeStorage()._map.empty());
+
+    Log::Comment(L"A packed row is cleared by dropping its packed cells.");
+    _buffer->WriteLine(OutputCellIterator{ L"packed" }, { 0, 0 });
+    auto& packed = _buffer->_storage.at(_buffer->_firstRow);
+    packed.Pack();
+    _buffer->IncrementCircularBuffer();
+    VERIFY_IS_TRUE(packed.IsPacked());
+    VERIFY_IS_FALSE(packed.IsClearPending());
+    VERIFY_IS_FALSE(_buffer->GetRowByOffset(bufferSize.Y - 1).GetCharRow().ContainsText());
+}
+
+void TextBufferTests::TestEraseRowsClearsLazily()
+{
+    const COORD bufferSize{ 20, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    for (SHORT row = 0; row < bufferSize.Y; row++)
+    {
+        _buffer->WriteLine(OutputCellIterator{ L"text", TextAttribute{ FOREGROUND_RED } }, { 0, row });
+    }
+    _buffer->GetRowByOffset(2).SetLineRendition(LineRendition::DoubleWidth);
+
+    _buffer->EraseRows(1, 3, TextAttribute{ BACKGROUND_GREEN });
+
+    Log::Comment(L"The erased rows only get marked, but already have the fill attributes.");
+    for (SHORT row = 1; row < 3; row++)
+    {
+        const auto& erased = _buffer->_storage.at(row);
+        VERIFY_IS_TRUE(erased.IsClearPending());
+        VERIFY_ARE_EQUAL(TextAttribute{ BACKGROUND_GREEN }, erased.GetAttrRow().GetAttrByColumn(bufferSize.X - 1));
+    }
+
+    Log::Comment(L"The line rendition is kept and the other rows are left alone.");
+    VERIFY_IS_TRUE(_buffer->_storage.at(2).GetLineRendition() == LineRendition::DoubleWidth);
+    VERIFY_IS_FALSE(_buffer->_storage.at(0).IsClearPending());
+    VERIFY_IS_FALSE(_buffer->_storage.at(3).IsClearPending());
+
+    Log::Comment(L"Reading the rows shows them blank, without clearing them.");
+    const auto& readOnly = *_buffer;
+    VERIFY_IS_TRUE(readOnly.GetRowByOffset(1).GetText().find_first_not_of(L' ') == std::wstring::npos);
+    VERIFY_IS_TRUE(_buffer->_storage.at(1).IsClearPending());
+
+    Log::Comment(L"Accessing the rows through the buffer clears them.");
+    VERIFY_IS_FALSE(_buffer->GetRowByOffset(1).GetCharRow().ContainsText());
+    VERIFY_IS_FALSE(_buffer->GetRowByOffset(2).GetCharRow().ContainsText());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(3).GetCharRow().ContainsText());
+}
+
+void TextBufferTests::GetRowsChangedSinceReportsModifiedRows()
+{
+    const COORD bufferSize{ 20, 8 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    const auto lastRow = gsl::narrow_cast<size_t>(bufferSize.Y - 1);
+
+    const auto start = _buffer->GetGeneration();
+    VERIFY_IS_TRUE(_buffer->GetRowsChangedSince(start, 0, lastRow).empty());
+
+    Log::Comment(L"Text, attributes and properties of a row all count as changes.");
+    _buffer->WriteLine(OutputCellIterator{ L"text" }, { 0, 2 });
+    _buffer->GetRowByOffset(4).GetAttrRow().Replace(1, 3, TextAttribute{ FOREGROUND_RED });
+    _buffer->GetRowByOffset(6).SetWrapForced(true);
+    VERIFY_IS_TRUE((std::vector<size_t>{ 2, 4, 6 } == _buffer->GetRowsChangedSince(start, 0, lastRow)));
+    VERIFY_IS_TRUE((std::vector<size_t>{ 4 } == _buffer->GetRowsChangedSince(start, 3, 5)));
+    VERIFY_IS_GREATER_THAN(_buffer->GetGeneration(), start);
+    VERIFY_IS_GREATER_THAN(_buffer->GetRowGeneration(2), start);
+    VERIFY_IS_LESS_THAN_OR_EQUAL(_buffer->GetRowGeneration(3), start);
+
+    Log::Comment(L"Setting a property to the value it already has isn't a change.");
+    const auto afterWrites = _buffer->GetGeneration();
+    _buffer->GetRowByOffset(6).SetWrapForced(true);
+    VERIFY_IS_TRUE(_buffer->GetRowsChangedSince(afterWrites, 0, lastRow).empty());
+
+    Log::Comment(L"Reading a packed row expands it without changing it.");
+    _buffer->_storage.at(3).Pack();
+    const auto packedGeneration = _buffer->GetRowGeneration(3);
+    VERIFY_IS_TRUE(_buffer->_storage.at(3).IsPacked());
+    VERIFY_IS_FALSE(_buffer->GetRowByOffset(3).GetCharRow().ContainsText());
+    VERIFY_ARE_EQUAL(packedGeneration, _buffer->GetRowGeneration(3));
+    VERIFY_IS_TRUE(_buffer->GetRowsChangedSince(afterWrites, 0, lastRow).empty());
+
+    Log::Comment(L"After circling, only the recycled row (now the last one) has changed.");
+    _buffer->IncrementCircularBuffer();
+    VERIFY_IS_TRUE((std::vector<size_t>{ lastRow } == _buffer->GetRowsChangedSince(afterWrites, 0, lastRow)));
+}
+
+void TextBufferTests::GetMemoryUsageBreaksDownBuffer()
+{
+    const COORD bufferSize{ 20, 8 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    const auto rowSize = bufferSize.X * sizeof(CharRowCell);
+
+    const auto initial = _buffer->GetMemoryUsage();
+    VERIFY_ARE_EQUAL(bufferSize.Y * rowSize, initial.cells);
+    VERIFY_ARE_EQUAL(0u, initial.packedCells);
+    VERIFY_ARE_EQUAL(0u, initial.unicodeStorage);
+    VERIFY_IS_GREATER_THAN_OR_EQUAL(initial.rows, bufferSize.Y * sizeof(ROW));
+
+    Log::Comment(L"Glyphs outside of the BMP and hyperlinks show up in their own categories.");
+    _buffer->WriteLine(OutputCellIterator{ L"\xD83D\xDE00" }, { 0, 1 });
+    const auto id = _buffer->GetHyperlinkId(L"https://example.com", {});
+    _buffer->AddHyperlinkToMap(L"https://example.com", id);
+    const auto written = _buffer->GetMemoryUsage();
+    VERIFY_IS_GREATER_THAN(written.unicodeStorage, 0u);
+    VERIFY_IS_GREATER_THAN(written.hyperlinks, initial.hyperlinks);
+
+    Log::Comment(L"Packed rows move from the arena into cold storage.");
+    _buffer->_storage.at(1).Pack();
+    const auto packed = _buffer->GetMemoryUsage();
+    VERIFY_ARE_EQUAL(written.cells - rowSize, packed.cells);
+    VERIFY_IS_GREATER_THAN(packed.packedCells, 0u);
+    VERIFY_ARE_EQUAL(packed.rows + packed.cells + packed.packedCells + packed.attributes + packed.unicodeStorage +
+                         packed.hyperlinks + packed.patterns + packed.searchIndex + packed.delimiterClasses + packed.rowTexts + packed.images + packed.scrollbackArchive,
+                     packed.Total());
+}
+
+void TextBufferTests::TakeSnapshotCopiesOnlyChangedRows()
+{
+    const COORD bufferSize{ 20, 8 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->WriteLine(OutputCellIterator{ L"first" }, { 0, 2 });
+    _buffer->WriteLine(OutputCellIterator{ L"second" }, { 0, 3 });
+
+    Log::Comment(L"A snapshot holds copies of the rows it was taken of.");
+    auto snapshot = _buffer->TakeSnapshot(2, 4, nullptr);
+    VERIFY_ARE_EQUAL(2, snapshot->GetFirstRow());
+    VERIFY_ARE_EQUAL(_buffer->GetGeneration(), snapshot->GetGeneration());
+    VERIFY_ARE_EQUAL((COORD{ bufferSize.X, 4 }), snapshot->GetBuffer().GetSize().Dimensions());
+    VERIFY_IS_TRUE(snapshot->GetBuffer().GetRowByOffset(0).GetText().substr(0, 5) == L"first");
+    VERIFY_IS_TRUE(snapshot->GetBuffer().GetRowByOffset(1).GetText().substr(0, 6) == L"second");
+
+    Log::Comment(L"Refreshing an unshared snapshot reuses it and copies only the changed rows.");
+    const auto copiedBefore = snapshot->GetBuffer().GetGeneration();
+    _buffer->WriteLine(OutputCellIterator{ L"changed" }, { 0, 3 });
+    const auto raw = snapshot.get();
+    snapshot = _buffer->TakeSnapshot(2, 4, std::move(snapshot));
+    VERIFY_ARE_EQUAL(raw, snapshot.get());
+    VERIFY_IS_TRUE((std::vector<size_t>{ 1 } == snapshot->GetBuffer().GetRowsChangedSince(copiedBefore, 0, 3)));
+    VERIFY_IS_TRUE(snapshot->GetBuffer().GetRowByOffset(1).GetText().substr(0, 7) == L"changed");
+
+    Log::Comment(L"A snapshot that's still being read is left alone.");
+    const auto reader = snapshot;
+    _buffer->WriteLine(OutputCellIterator{ L"again" }, { 0, 2 });
+    snapshot = _buffer->TakeSnapshot(2, 4, snapshot);
+    VERIFY_ARE_NOT_EQUAL(reader.get(), snapshot.get());
+    VERIFY_IS_TRUE(reader->GetBuffer().GetRowByOffset(0).GetText().substr(0, 5) == L"first");
+    VERIFY_IS_TRUE(snapshot->GetBuffer().GetRowByOffset(0).GetText().substr(0, 5) == L"again");
+
+    Log::Comment(L"The range is clamped to the rows of the buffer.");
+    snapshot = _buffer->TakeSnapshot(6, 4, nullptr);
+    VERIFY_ARE_EQUAL(2, snapshot->GetBuffer().GetSize().Height());
+}
+
 void TextBufferTests::TestMixedRgbAndLegacyForeground()
 {
     CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
@@ -1854,7 +2110,7 @@ void TextBufferTests::ResizeTraditionalRotationPreservesHighUnicode()
     VERIFY_ARE_EQUAL(String(bButton), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
     // Make it the first row in the buffer so it will rotate around when we resize and cause renumbering
-    const SHORT delta = _buffer->GetFirstRowIndex() - pos.Y;
+    const SHORT delta = gsl::narrow<SHORT>(_buffer->GetFirstRowIndex()) - pos.Y;
     const COORD newPos{ pos.X, pos.Y + delta };
 
     _buffer->_SetFirstRowIndex(pos.Y);
@@ -1910,6 +2166,41 @@ void TextBufferTests::ScrollBufferRotationPreservesHighUnicode()
     VERIFY_ARE_EQUAL(String(fire), String(shouldBeFireText.data(), gsl::narrow<int>(shouldBeFireText.size())));
 }
 
+// This tests that scrolling a band of rows that wraps around the end of the
+// circular storage moves the rows without rotating the rest of the buffer.
+void TextBufferTests::ScrollRowsAcrossEndOfStorage()
+{
+    const COORD bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    // The rows at offsets 0 through 4 sit in the slots 7, 8, 9, 0 and 1.
+    _buffer->_SetFirstRowIndex(7);
+    const std::wstring_view digits{ L"0123456789" };
+    for (SHORT row = 0; row < bufferSize.Y; row++)
+    {
+        _buffer->GetRowByOffset(row).GetCharRow().GlyphAt(0) = digits.substr(row, 1);
+    }
+
+    Log::Comment(L"Move the rows 1 through 4 up by one, like a scroll within margins would.");
+    _buffer->ScrollRows(1, 4, -1);
+
+    const std::wstring_view expected{ L"1234056789" };
+    for (SHORT row = 0; row < bufferSize.Y; row++)
+    {
+        const auto text = *_buffer->GetTextDataAt({ 0, row });
+        VERIFY_ARE_EQUAL(String(expected.substr(row, 1).data(), 1), String(text.data(), gsl::narrow<int>(text.size())));
+    }
+
+    Log::Comment(L"The first row didn't change and every row still knows its slot.");
+    VERIFY_ARE_EQUAL(7u, _buffer->GetFirstRowIndex());
+    for (size_t slot = 0; slot < _buffer->_storage.size(); slot++)
+    {
+        VERIFY_ARE_EQUAL(slot, _buffer->_storage.at(slot).GetId());
+    }
+}
+
 // This tests that rows removed from the buffer while resizing traditionally will also drop the high unicode
 // characters from the Unicode Storage buffer
 void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
@@ -1935,14 +2226,17 @@ void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
     const auto readBackText = *readBack;
     VERIFY_ARE_EQUAL(String(emoji), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
-    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
+    VERIFY_ARE_EQUAL(1u, _buffer->_storage[pos.Y].GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
 
     // Perform resize to trim off the row of the buffer that included the emoji
     COORD trimmedBufferSize{ bufferSize.X, bufferSize.Y - 1 };
 
     VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(trimmedBufferSize));
 
-    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    for (const auto& row : _buffer->_storage)
+    {
+        VERIFY_IS_TRUE(row.GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    }
 }
 
 // This tests that columns removed from the buffer while resizing traditionally will also drop the high unicode
@@ -1970,14 +2264,14 @@ void TextBufferTests::ResizeTraditionalHighUnicodeColumnRemoval()
     const auto readBackText = *readBack;
     VERIFY_ARE_EQUAL(String(emoji), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
-    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
+    VERIFY_ARE_EQUAL(1u, _buffer->_storage[pos.Y].GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
 
     // Perform resize to trim off the column of the buffer that included the emoji
     COORD trimmedBufferSize{ bufferSize.X - 1, bufferSize.Y };
 
     VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(trimmedBufferSize));
 
-    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    VERIFY_IS_TRUE(_buffer->_storage[pos.Y].GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
 }
 
 void TextBufferTests::TestBurrito()
@@ -2024,6 +2318,32 @@ void TextBufferTests::WriteLinesToBuffer(const std::vector<std::wstring>& text,
     }
 }
 
+void TextBufferTests::WordBoundariesFollowChanges()
+{
+    const COORD bufferSize{ 80, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->WriteLine(OutputCellIterator{ L"alpha,beta gamma" }, { 0, 1 });
+
+    VERIFY_ARE_EQUAL((COORD{ 9, 1 }), _buffer->GetWordEnd({ 0, 1 }, L" ", false));
+    VERIFY_ARE_EQUAL((COORD{ 0, 1 }), _buffer->GetWordStart({ 8, 1 }, L" ", false));
+
+    Log::Comment(L"Other delimiters don't reuse the cached classes of the row.");
+    VERIFY_ARE_EQUAL((COORD{ 4, 1 }), _buffer->GetWordEnd({ 0, 1 }, L" ,", false));
+    VERIFY_ARE_EQUAL((COORD{ 6, 1 }), _buffer->GetWordStart({ 8, 1 }, L" ,", false));
+
+    Log::Comment(L"Neither do rows that changed since.");
+    _buffer->WriteLine(OutputCellIterator{ L"al" }, { 3, 1 });
+    VERIFY_ARE_EQUAL((COORD{ 4, 1 }), _buffer->GetWordEnd({ 0, 1 }, L" ,", false));
+    _buffer->WriteLine(OutputCellIterator{ L" " }, { 2, 1 });
+    VERIFY_ARE_EQUAL((COORD{ 1, 1 }), _buffer->GetWordEnd({ 0, 1 }, L" ,", false));
+
+    Log::Comment(L"Accessibility mode moves across rows.");
+    VERIFY_ARE_EQUAL((COORD{ 11, 1 }), _buffer->GetWordStart({ 5, 2 }, L" ,", true));
+    VERIFY_ARE_EQUAL((COORD{ 3, 1 }), _buffer->GetWordEnd({ 0, 1 }, L" ,", true));
+}
+
 void TextBufferTests::GetWordBoundaries()
 {
     COORD bufferSize{ 80, 9001 };
@@ -2617,13 +2937,13 @@ void TextBufferTests::HyperlinkTrim()
     const auto finalOtherCustomId = fmt::format(L"{}%{}", otherCustomId, std::hash<std::wstring_view>{}(otherUrl));
 
     // The hyperlink reference that was only in the first row should be deleted from the map
-    VERIFY_ARE_EQUAL(_buffer->_hyperlinkMap.find(id), _buffer->_hyperlinkMap.end());
+    VERIFY_IS_FALSE(_buffer->_hyperlinks.Contains(id));
     // Since there was a custom id, that should be deleted as well
-    VERIFY_ARE_EQUAL(_buffer->_hyperlinkCustomIdMap.find(finalCustomId), _buffer->_hyperlinkCustomIdMap.end());
+    VERIFY_IS_FALSE(_buffer->_hyperlinks.FindCustomId(finalCustomId).has_value());
 
     // The other hyperlink reference should not be deleted
-    VERIFY_ARE_EQUAL(_buffer->_hyperlinkMap[otherId], otherUrl);
-    VERIFY_ARE_EQUAL(_buffer->_hyperlinkCustomIdMap[finalOtherCustomId], otherId);
+    VERIFY_ARE_EQUAL(_buffer->GetHyperlinkUriFromId(otherId), otherUrl);
+    VERIFY_IS_TRUE(_buffer->_hyperlinks.FindCustomId(finalOtherCustomId) == otherId);
 }
 
 // This tests that when we increment the circular buffer, non-obsolete hyperlink references
@@ -2658,5 +2978,593 @@ void TextBufferTests::NoHyperlinkTrim()
 
     // The hyperlink reference should not be deleted from the map since it is still present in the buffer
     VERIFY_ARE_EQUAL(_buffer->GetHyperlinkUriFromId(id), url);
-    VERIFY_ARE_EQUAL(_buffer->_hyperlinkCustomIdMap[finalCustomId], id);
+    VERIFY_IS_TRUE(_buffer->_hyperlinks.FindCustomId(finalCustomId) == id);
+}
+
+// This tests that a stream of distinct hyperlinks, like the output of `ls --hyperlink`,
+// doesn't run out of hyperlink IDs and only keeps the ones still in the buffer
+void TextBufferTests::HyperlinkIdsAreReused()
+{
+    const COORD bufferSize{ 80, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    const auto lastRow = bufferSize.Y - 1;
+
+    // More hyperlinks than there are IDs.
+    for (size_t i = 0; i < 70000; ++i)
+    {
+        const auto url = fmt::format(L"file://host/file{}", i);
+        const auto id = _buffer->GetHyperlinkId(url, {});
+        VERIFY_ARE_NOT_EQUAL(0, id);
+        _buffer->AddHyperlinkToMap(url, id);
+
+        TextAttribute newAttr{ 0x7f };
+        newAttr.SetHyperlinkId(id);
+        _buffer->GetRowByOffset(lastRow).GetAttrRow().SetAttrToEnd(0, newAttr);
+        _buffer->IncrementCircularBuffer();
+    }
+
+    Log::Comment(L"Only the hyperlinks of the rows still in the buffer are left.");
+    VERIFY_IS_LESS_THAN_OR_EQUAL(_buffer->_hyperlinks.size(), static_cast<size_t>(bufferSize.Y));
+    const auto id = _buffer->GetRowByOffset(lastRow - 1).GetAttrRow().GetAttrByColumn(0).GetHyperlinkId();
+    VERIFY_ARE_EQUAL(L"file://host/file69999", _buffer->GetHyperlinkUriFromId(id));
+
+    Log::Comment(L"The space of the strings of removed hyperlinks is reclaimed.");
+    VERIFY_IS_LESS_THAN(_buffer->_hyperlinks._strings.size(), 2 * HyperlinkTable::s_MinCompactionSize);
+}
+
+// This tests that rows packed into cold storage are
+// restored with their original contents once accessed
+void TextBufferTests::PackColdRows()
+{
+    const COORD bufferSize{ 80, 1000 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        _buffer->WriteLine(OutputCellIterator{ fmt::format(L"row {}", y) }, { 0, y });
+    }
+    _buffer->GetCursor().SetPosition({ 0, bufferSize.Y - 1 });
+
+    _buffer->SetHotRowCount(10);
+    _buffer->_PackColdRows();
+
+    Log::Comment(L"Rows outside of the hot region should be packed, the others shouldn't.");
+    VERIFY_IS_TRUE(_buffer->_storage.at(0).IsPacked());
+    VERIFY_IS_TRUE(_buffer->_storage.at(bufferSize.Y - 12).IsPacked());
+    VERIFY_IS_FALSE(_buffer->_storage.at(bufferSize.Y - 5).IsPacked());
+
+    Log::Comment(L"Reading packed rows shouldn't change them.");
+    const auto& readOnly = *_buffer;
+    for (SHORT y = 0; y < bufferSize.Y - 12; ++y)
+    {
+        const auto expected = fmt::format(L"row {}", y);
+        const auto& row = readOnly.GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(expected, row.GetText().substr(0, expected.size()));
+        VERIFY_ARE_EQUAL(bufferSize.X, gsl::narrow_cast<SHORT>(row.GetText().size()));
+        VERIFY_ARE_EQUAL(expected.size(), row.MeasureRight());
+        VERIFY_IS_TRUE(row.IsPacked());
+    }
+
+    Log::Comment(L"Accessing packed rows should restore them.");
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto expected = fmt::format(L"row {}", y);
+        const auto text = _buffer->GetRowByOffset(y).GetText();
+        VERIFY_ARE_EQUAL(expected, text.substr(0, expected.size()));
+        VERIFY_IS_FALSE(_buffer->_storage.at(y).IsPacked());
+    }
+}
+
+// This tests that packed rows with the same glyphs share their
+// cells, until one of them is written to again
+void TextBufferTests::ShareColdRows()
+{
+    const COORD bufferSize{ 80, 100 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->ShareColdRows(true);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        _buffer->WriteLine(OutputCellIterator{ y % 2 ? L"-----" : L"warning: same as ever" }, { 0, y });
+    }
+    _buffer->GetCursor().SetPosition({ 0, bufferSize.Y - 1 });
+    _buffer->SetHotRowCount(10);
+    _buffer->_PackColdRows();
+
+    Log::Comment(L"The rows with the same text share one set of cells.");
+    VERIFY_ARE_EQUAL(2u, _buffer->_packedRowStore->size());
+    VERIFY_ARE_EQUAL(_buffer->_storage.at(1)._packedCells, _buffer->_storage.at(3)._packedCells);
+    VERIFY_ARE_NOT_EQUAL(_buffer->_storage.at(0)._packedCells, _buffer->_storage.at(1)._packedCells);
+
+    Log::Comment(L"Writing to a row expands it, without affecting the rows it shared its cells with.");
+    _buffer->WriteLine(OutputCellIterator{ L"=====" }, { 0, 1 });
+    VERIFY_IS_TRUE(_buffer->_storage.at(3).IsPacked());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(1).GetText().substr(0, 5) == L"=====");
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(3).GetText().substr(0, 5) == L"-----");
+
+    Log::Comment(L"The shared cells are counted once for the memory usage.");
+    auto unshared = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        unshared->WriteLine(OutputCellIterator{ y % 2 ? L"-----" : L"warning: same as ever" }, { 0, y });
+    }
+    unshared->GetCursor().SetPosition({ 0, bufferSize.Y - 1 });
+    unshared->SetHotRowCount(10);
+    unshared->_PackColdRows();
+    VERIFY_IS_LESS_THAN(_buffer->GetMemoryUsage().packedCells, unshared->GetMemoryUsage().packedCells);
+}
+
+// This tests that rows scrolling off the top of the buffer
+// are appended to the scrollback archive, if enabled
+void TextBufferTests::ArchiveEvictedRows()
+{
+    const COORD bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->EnableScrollbackArchive();
+
+    TextAttribute linkAttr{ 0x1f };
+    for (SHORT i = 0; i < 25; ++i)
+    {
+        _buffer->WriteLine(OutputCellIterator{ fmt::format(L"row {}", i), linkAttr }, { 0, 0 });
+        _buffer->IncrementCircularBuffer();
+    }
+
+    const auto archive = _buffer->GetScrollbackArchive();
+    VERIFY_IS_NOT_NULL(archive);
+    VERIFY_ARE_EQUAL(25u, archive->size());
+
+    for (size_t i = 0; i < archive->size(); ++i)
+    {
+        const auto row = archive->GetRow(i);
+        VERIFY_ARE_EQUAL(fmt::format(L"row {}", i), std::wstring{ row.text });
+        VERIFY_IS_FALSE(row.wrapForced);
+
+        Log::Comment(L"The attributes should be run length encoded across the whole row.");
+        VERIFY_ARE_EQUAL(2u, row.attributes.size());
+        VERIFY_ARE_EQUAL(linkAttr, row.attributes[0].attr);
+        VERIFY_ARE_EQUAL(attr, row.attributes[1].attr);
+        VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(bufferSize.X), size_t{ row.attributes[0].length } + row.attributes[1].length);
+    }
+}
+
+// This tests that the archive drops its oldest rows once its file is full,
+// instead of growing without bounds
+void TextBufferTests::ArchiveDropsOldestRows()
+{
+    const COORD bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, TextAttribute{}, cursorSize, _renderTarget);
+    constexpr uint64_t maximumSize = 4096;
+    _buffer->EnableScrollbackArchive(maximumSize);
+
+    constexpr size_t rows = 500;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        _buffer->WriteLine(OutputCellIterator{ fmt::format(L"row {}", i) }, { 0, 0 });
+        _buffer->IncrementCircularBuffer();
+    }
+
+    const auto archive = _buffer->GetScrollbackArchive();
+    VERIFY_IS_LESS_THAN(archive->size(), rows);
+    VERIFY_IS_LESS_THAN_OR_EQUAL(archive->GetFileSize(), maximumSize);
+    VERIFY_ARE_EQUAL(rows, archive->GetDroppedRowCount() + archive->size());
+
+    Log::Comment(L"The rows that are left should be the newest ones, in order.");
+    const auto dropped = gsl::narrow_cast<size_t>(archive->GetDroppedRowCount());
+    for (size_t i = 0; i < archive->size(); ++i)
+    {
+        VERIFY_ARE_EQUAL(fmt::format(L"row {}", dropped + i), std::wstring{ archive->GetRow(i).text });
+    }
+}
+
+// This tests that the rows of the archive can be moved back into the buffer above
+// its first row, for scrolling and searching, and out of it again, in order.
+void TextBufferTests::PageInArchivedRows()
+{
+    const COORD bufferSize{ 20, 5 };
+    const UINT cursorSize = 12;
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, TextAttribute{}, cursorSize, _renderTarget);
+    _buffer->EnableScrollbackArchive();
+
+    TextAttribute red;
+    red.SetIndexedForeground(FOREGROUND_RED);
+    for (SHORT i = 0; i < 15; ++i)
+    {
+        _buffer->WriteLine(OutputCellIterator{ fmt::format(L"row {}", i), red }, { 0, 0 });
+        _buffer->IncrementCircularBuffer();
+    }
+    _buffer->WriteLine(OutputCellIterator{ L"screen" }, { 0, 0 });
+    _buffer->GetCursor().SetPosition({ 0, 2 });
+
+    const auto archive = _buffer->GetScrollbackArchive();
+    VERIFY_ARE_EQUAL(15u, _buffer->GetArchivedRowCount());
+    VERIFY_ARE_EQUAL(12u, archive->FindBackward(L"ROW 12", false, 0).value_or(0));
+    VERIFY_IS_FALSE(archive->FindBackward(L"ROW 12", true, 0).has_value());
+    VERIFY_IS_FALSE(archive->FindBackward(L"row 12", true, 13).has_value());
+
+    Log::Comment(L"The newest archived rows should be above the rows that were in the buffer.");
+    VERIFY_ARE_EQUAL(4u, _buffer->PageInArchivedRows(4));
+    VERIFY_ARE_EQUAL(9, _buffer->GetSize().Height());
+    VERIFY_ARE_EQUAL(11u, archive->size());
+    VERIFY_ARE_EQUAL(4u, _buffer->GetPagedInRowCount());
+    VERIFY_ARE_EQUAL(11u, _buffer->GetCircledRows());
+    VERIFY_ARE_EQUAL(6, _buffer->GetCursor().GetPosition().Y);
+    for (SHORT i = 0; i < 4; ++i)
+    {
+        const auto expected = fmt::format(L"row {}", 11 + i);
+        const auto& row = _buffer->GetRowByOffset(i);
+        VERIFY_ARE_EQUAL(expected, row.GetText().substr(0, expected.size()));
+        VERIFY_ARE_EQUAL(expected.size(), row.MeasureRight());
+        VERIFY_ARE_EQUAL(red, row.GetAttrRow().GetAttrByColumn(0));
+    }
+    VERIFY_ARE_EQUAL(L"screen", _buffer->GetRowByOffset(4).GetText().substr(0, 6));
+
+    Log::Comment(L"Only the rows that were paged in should go back into the archive.");
+    VERIFY_ARE_EQUAL(4u, _buffer->PageOutRows(10));
+    VERIFY_ARE_EQUAL(bufferSize.Y, _buffer->GetSize().Height());
+    VERIFY_ARE_EQUAL(15u, archive->size());
+    VERIFY_ARE_EQUAL(0u, _buffer->GetPagedInRowCount());
+    VERIFY_ARE_EQUAL(15u, _buffer->GetCircledRows());
+    VERIFY_ARE_EQUAL(2, _buffer->GetCursor().GetPosition().Y);
+    VERIFY_ARE_EQUAL(L"screen", _buffer->GetRowByOffset(0).GetText().substr(0, 6));
+    VERIFY_ARE_EQUAL(L"row 14", std::wstring{ archive->GetRow(14).text });
+    VERIFY_ARE_EQUAL(0u, _buffer->PageOutRows(10));
+}
+
+// This tests that RowSerializer writes rows without their trailing blanks, without
+// a line break after the ones that wrapped, and with the SGR sequences of their
+// attributes if asked to, both for the rows of the buffer and of its archive.
+void TextBufferTests::SerializeRows()
+{
+    const COORD bufferSize{ 10, 5 };
+    const UINT cursorSize = 12;
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, TextAttribute{}, cursorSize, _renderTarget);
+    _buffer->EnableScrollbackArchive();
+
+    TextAttribute red;
+    red.SetIndexedForeground(FOREGROUND_RED);
+    TextAttribute bold;
+    bold.SetBold(true);
+
+    _buffer->WriteLine(OutputCellIterator{ L"ab", TextAttribute{} }, { 0, 0 });
+    _buffer->WriteLine(OutputCellIterator{ L"red", red }, { 0, 1 });
+    _buffer->WriteLine(OutputCellIterator{ L"0123456789", TextAttribute{} }, { 0, 2 });
+    _buffer->GetRowByOffset(2).SetWrapForced(true);
+    _buffer->WriteLine(OutputCellIterator{ L"x", bold }, { 0, 3 });
+
+    const auto serialize = [&](const bool includeAttributes) {
+        std::wstring text;
+        RowSerializer serializer{ text, includeAttributes };
+        for (SHORT row = 0; row < 4; ++row)
+        {
+            serializer.Write(_buffer->GetRowByOffset(row));
+        }
+        return text;
+    };
+
+    VERIFY_ARE_EQUAL(L"ab\r\nred\r\n0123456789x\r\n", serialize(false));
+    VERIFY_ARE_EQUAL(L"ab\r\n\x1b[0;31mred\x1b[0m\r\n0123456789\x1b[0;1mx\x1b[0m\r\n", serialize(true));
+
+    Log::Comment(L"The rows that scrolled into the archive should read the same.");
+    _buffer->IncrementCircularBuffer();
+    _buffer->IncrementCircularBuffer();
+    const auto archive = _buffer->GetScrollbackArchive();
+    VERIFY_ARE_EQUAL(2u, archive->size());
+
+    std::wstring text;
+    RowSerializer serializer{ text, true };
+    serializer.Write(archive->GetRow(0));
+    serializer.Write(archive->GetRow(1));
+    VERIFY_ARE_EQUAL(L"ab\r\n\x1b[0;31mred\x1b[0m\r\n", text);
+}
+
+void TextBufferTests::GetPatternsRescansChangedLines()
+{
+    const COORD bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    const auto id = _buffer->AddPatternRecognizer(L"ab+c");
+
+    _buffer->WriteLine(OutputCellIterator{ L"xx abbc" }, { 0, 2 });
+
+    auto patterns = _buffer->GetPatterns(0, bufferSize.Y - 1);
+    auto found = patterns.findOverlapping(til::point{ 0, 0 }, til::point{ 80, 9 });
+    VERIFY_ARE_EQUAL(1u, found.size());
+    VERIFY_ARE_EQUAL(til::point(3, 2), found.at(0).start);
+    VERIFY_ARE_EQUAL(til::point(7, 2), found.at(0).stop);
+    VERIFY_ARE_EQUAL(id, found.at(0).value);
+    VERIFY_ARE_EQUAL(gsl::narrow_cast<size_t>(bufferSize.Y), _buffer->_patternCache.size());
+
+    Log::Comment(L"Rows that didn't change should keep their generation, so their line isn't searched again.");
+    const auto unchangedGeneration = _buffer->GetRowByOffset(2).GetCharRow().GetGeneration();
+    const auto changedGeneration = _buffer->GetRowByOffset(5).GetCharRow().GetGeneration();
+    _buffer->WriteLine(OutputCellIterator{ L"abc" }, { 0, 5 });
+    VERIFY_ARE_EQUAL(unchangedGeneration, _buffer->GetRowByOffset(2).GetCharRow().GetGeneration());
+    VERIFY_ARE_NOT_EQUAL(changedGeneration, _buffer->GetRowByOffset(5).GetCharRow().GetGeneration());
+
+    patterns = _buffer->GetPatterns(0, bufferSize.Y - 1);
+    found = patterns.findOverlapping(til::point{ 0, 0 }, til::point{ 80, 9 });
+    VERIFY_ARE_EQUAL(2u, found.size());
+
+    Log::Comment(L"After the buffer scrolls, the matches should move up with their rows.");
+    _buffer->IncrementCircularBuffer();
+    patterns = _buffer->GetPatterns(0, bufferSize.Y - 1);
+    found = patterns.findOverlapping(til::point{ 0, 1 }, til::point{ 80, 1 });
+    VERIFY_ARE_EQUAL(1u, found.size());
+    VERIFY_ARE_EQUAL(til::point(3, 1), found.at(0).start);
+}
+
+void TextBufferTests::WriteCellsMixesAsciiRunsAndWideText()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ FOREGROUND_RED };
+    const TextAttribute green{ FOREGROUND_GREEN };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    Log::Comment(L"Overwriting a glyph kept in the unicode storage with ASCII text should erase it.");
+    _buffer->WriteLine(OutputCellIterator{ L"\xD83D\xDE00", red }, { 2, 0 });
+    VERIFY_ARE_EQUAL(1u, _buffer->GetRowByOffset(0).GetUnicodeStorage()._map.size());
+    _buffer->WriteLine(OutputCellIterator{ L"xyz", green }, { 2, 0 });
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(0).GetUnicodeStorage()._map.empty());
+
+    const auto& row = _buffer->GetRowByOffset(0);
+    VERIFY_ARE_EQUAL(L"  xyz", row.GetText().substr(0, 5));
+    for (auto i = 2; i < 5; ++i)
+    {
+        VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(i).IsSingle());
+        VERIFY_ARE_EQUAL(green, row.GetAttrRow().GetAttrByColumn(gsl::narrow_cast<uint16_t>(i)));
+    }
+    VERIFY_ARE_EQUAL(attr, row.GetAttrRow().GetAttrByColumn(5));
+
+    Log::Comment(L"Wide text between ASCII runs takes the per cell path and keeps the attribute runs intact.");
+    const auto it = _buffer->WriteLine(OutputCellIterator{ L"ab\x3042cdefghij", red }, { 0, 1 }, true);
+    const auto& wideRow = _buffer->GetRowByOffset(1);
+    VERIFY_ARE_EQUAL(L"ab\x3042cdefgh", wideRow.GetText());
+    VERIFY_IS_TRUE(wideRow.GetCharRow().DbcsAttrAt(2).IsLeading());
+    VERIFY_IS_TRUE(wideRow.GetCharRow().DbcsAttrAt(3).IsTrailing());
+    for (auto i = 0; i < bufferSize.X; ++i)
+    {
+        VERIFY_ARE_EQUAL(red, wideRow.GetAttrRow().GetAttrByColumn(gsl::narrow_cast<uint16_t>(i)));
+    }
+
+    Log::Comment(L"Filling the last column with an ASCII run should set the wrap flag and stop the iterator after it.");
+    VERIFY_IS_TRUE(wideRow.WasWrapForced());
+    VERIFY_ARE_EQUAL(L"i", it->Chars());
+    VERIFY_ARE_EQUAL(10, it.GetCellDistance(OutputCellIterator{ L"ab\x3042cdefghij", red }));
+
+    Log::Comment(L"Text without attributes keeps the ones already in the buffer.");
+    _buffer->WriteLine(OutputCellIterator{ L"zz" }, { 0, 1 });
+    VERIFY_ARE_EQUAL(L"zz", wideRow.GetText().substr(0, 2));
+    VERIFY_ARE_EQUAL(red, wideRow.GetAttrRow().GetAttrByColumn(0));
+}
+
+void TextBufferTests::WriteCellsFillsRunsUpToTheirLimit()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ FOREGROUND_RED };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    const auto& row = _buffer->GetRowByOffset(0);
+
+    _buffer->WriteLine(OutputCellIterator{ L"0123456789" }, { 0, 0 });
+
+    Log::Comment(L"A limited fill should stop at its limit, even though the row has room for more.");
+    auto it = _buffer->WriteLine(OutputCellIterator{ L'x', red, 4 }, { 3, 0 });
+    VERIFY_IS_FALSE(it);
+    VERIFY_ARE_EQUAL(L"012xxxx789", row.GetText());
+    VERIFY_ARE_EQUAL(attr, row.GetAttrRow().GetAttrByColumn(2));
+    VERIFY_ARE_EQUAL(red, row.GetAttrRow().GetAttrByColumn(3));
+    VERIFY_ARE_EQUAL(red, row.GetAttrRow().GetAttrByColumn(6));
+    VERIFY_ARE_EQUAL(attr, row.GetAttrRow().GetAttrByColumn(7));
+
+    Log::Comment(L"An attribute fill should leave the text alone.");
+    it = _buffer->WriteLine(OutputCellIterator{ red }, { 0, 0 });
+    VERIFY_IS_TRUE(it);
+    VERIFY_ARE_EQUAL(10, it.GetCellDistance(OutputCellIterator{ red }));
+    VERIFY_ARE_EQUAL(L"012xxxx789", row.GetText());
+    VERIFY_ARE_EQUAL(red, row.GetAttrRow().GetAttrByColumn(0));
+    VERIFY_ARE_EQUAL(red, row.GetAttrRow().GetAttrByColumn(9));
+
+    Log::Comment(L"A wide fill still alternates between the leading and trailing half.");
+    _buffer->WriteLine(OutputCellIterator{ L'\x3042', 3 }, { 0, 0 });
+    VERIFY_ARE_EQUAL(L"\x3042\x3042\x3042x789", row.GetText());
+    VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(0).IsLeading());
+    VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(5).IsTrailing());
+}
+
+void TextBufferTests::CharInfosRoundTripThroughRows()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+
+    const auto makeCell = [](const wchar_t wch, const WORD attributes) {
+        CHAR_INFO ci;
+        ci.Char.UnicodeChar = wch;
+        ci.Attributes = attributes;
+        return ci;
+    };
+    const std::vector<CHAR_INFO> cells{
+        makeCell(L'a', FOREGROUND_RED),
+        makeCell(L'b', FOREGROUND_RED),
+        makeCell(L'\x3042', FOREGROUND_GREEN | COMMON_LVB_LEADING_BYTE),
+        makeCell(L'\x3042', FOREGROUND_GREEN | COMMON_LVB_TRAILING_BYTE),
+        makeCell(L'c', FOREGROUND_BLUE | COMMON_LVB_UNDERSCORE),
+    };
+
+    Log::Comment(L"Writing in bulk should leave the row the way the per cell path does.");
+    _buffer->WriteLine(OutputCellIterator{ L"\xD83D\xDE00" }, { 3, 0 });
+    _buffer->WriteCharInfos({ 1, 0 }, cells);
+    _buffer->WriteLine(OutputCellIterator{ gsl::span<const CHAR_INFO>{ cells } }, { 1, 1 });
+    const auto& bulkRow = _buffer->GetRowByOffset(0);
+    const auto& cellRow = _buffer->GetRowByOffset(1);
+    VERIFY_IS_TRUE(bulkRow.GetUnicodeStorage()._map.empty());
+    VERIFY_ARE_EQUAL(cellRow.GetText(), bulkRow.GetText());
+    for (uint16_t i = 0; i < bufferSize.X; ++i)
+    {
+        VERIFY_IS_TRUE(cellRow.GetCharRow().DbcsAttrAt(i) == bulkRow.GetCharRow().DbcsAttrAt(i));
+        VERIFY_ARE_EQUAL(cellRow.GetAttrRow().GetAttrByColumn(i), bulkRow.GetAttrRow().GetAttrByColumn(i));
+    }
+
+    Log::Comment(L"Reading in bulk should give the same cells as converting them one at a time.");
+    _buffer->WriteLine(OutputCellIterator{ L"\xD83D\xDE00" }, { 8, 1 });
+    std::vector<CHAR_INFO> read(8);
+    _buffer->ReadCharInfos({ 2, 1 }, read);
+    auto it = _buffer->GetCellDataAt({ 2, 1 });
+    for (const auto& ci : read)
+    {
+        VERIFY_ARE_EQUAL(gci.AsCharInfo(*it), ci);
+        ++it;
+    }
+
+    Log::Comment(L"A trailing half in the first column is left to the per cell path, which pads it.");
+    const std::vector<CHAR_INFO> trailing{ cells.begin() + 3, cells.end() };
+    _buffer->WriteCharInfos({ 0, 2 }, trailing);
+    const auto& paddedRow = _buffer->GetRowByOffset(2);
+    VERIFY_ARE_EQUAL(L' ', paddedRow.GetText().at(0));
+    VERIFY_IS_TRUE(paddedRow.GetCharRow().DbcsAttrAt(1).IsTrailing());
+    VERIFY_ARE_EQUAL(L'c', paddedRow.GetText().at(2));
+}
+
+void TextBufferTests::ExportTextMatchesGetText()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"Data:includeCRLF", L"{false, true}")
+        TEST_METHOD_PROPERTY(L"Data:trimTrailingWhitespace", L"{false, true}")
+    END_TEST_METHOD_PROPERTIES();
+
+    bool includeCRLF;
+    bool trimTrailingWhitespace;
+    VERIFY_SUCCEEDED(TestData::TryGetValue(L"includeCRLF", includeCRLF), L"Get 'includeCRLF' variant");
+    VERIFY_SUCCEEDED(TestData::TryGetValue(L"trimTrailingWhitespace", trimTrailingWhitespace), L"Get 'trimTrailingWhitespace' variant");
+
+    const COORD bufferSize{ 10, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    _buffer->WriteLine(OutputCellIterator{ L"a<b>&", TextAttribute{ FOREGROUND_RED } }, { 0, 0 });
+    _buffer->WriteLine(OutputCellIterator{ L"  x ", TextAttribute{ BACKGROUND_BLUE } }, { 3, 0 });
+    _buffer->WriteLine(OutputCellIterator{ L"\x3042{\\}", TextAttribute{ FOREGROUND_GREEN } }, { 0, 1 });
+    _buffer->WriteLine(OutputCellIterator{ L"0123456789", attr }, { 0, 2 }, true);
+    _buffer->WriteLine(OutputCellIterator{ L"wrapped", TextAttribute{ FOREGROUND_RED } }, { 0, 3 });
+
+    const auto selectionRects = _buffer->GetTextRects({ 1, 0 }, { 8, 4 }, false, true);
+    const auto GetAttributeColors = [](const TextAttribute& cellAttr) {
+        return std::pair<COLORREF, COLORREF>{ cellAttr.GetLegacyAttributes() & FG_ATTRS, cellAttr.GetLegacyAttributes() & BG_ATTRS };
+    };
+
+    const auto expected = _buffer->GetText(includeCRLF, trimTrailingWhitespace, selectionRects, GetAttributeColors);
+    std::wstring expectedText;
+    for (const auto& row : expected.text)
+    {
+        expectedText += row;
+    }
+
+    TextBuffer::RichTextFormats richText;
+    richText.html = true;
+    richText.rtf = true;
+    richText.fontHeightPoints = 12;
+    richText.fontFaceName = L"Cascadia Mono";
+    richText.backgroundColor = RGB(12, 34, 56);
+    richText.GetAttributeColors = GetAttributeColors;
+    const auto exported = _buffer->ExportText(includeCRLF, trimTrailingWhitespace, selectionRects, richText);
+
+    VERIFY_ARE_EQUAL(expectedText, exported.text);
+    VERIFY_IS_TRUE(TextBuffer::GenHTML(expected, 12, L"Cascadia Mono", RGB(12, 34, 56)) == exported.richText.GenHTML());
+    VERIFY_IS_TRUE(TextBuffer::GenRTF(expected, 12, L"Cascadia Mono", RGB(12, 34, 56)) == exported.richText.GenRTF());
+
+    Log::Comment(L"Without a way to compute colors, only the plain text should be generated.");
+    richText.GetAttributeColors = nullptr;
+    const auto plain = _buffer->ExportText(includeCRLF, trimTrailingWhitespace, selectionRects, richText);
+    VERIFY_ARE_EQUAL(expectedText, plain.text);
+    VERIFY_IS_TRUE(plain.richText.empty());
+
+    Log::Comment(L"The colors are kept apart from the buffer, so the rich text formats can be generated after it changed.");
+    _buffer->WriteLine(OutputCellIterator{ L"changed", TextAttribute{ FOREGROUND_BLUE } }, { 0, 0 });
+    VERIFY_IS_TRUE(TextBuffer::GenHTML(expected, 12, L"Cascadia Mono", RGB(12, 34, 56)) == exported.richText.GenHTML());
+}
+
+void TextBufferTests::GetRowTextMatchesGetText()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    _buffer->WriteLine(OutputCellIterator{ L"abc" }, { 0, 0 });
+    _buffer->WriteLine(OutputCellIterator{ L"a\x3042b\xD83D\xDE00c" }, { 0, 1 });
+
+    const auto verifyRow = [&](const SHORT row) {
+        for (SHORT left = 0; left < bufferSize.X; ++left)
+        {
+            for (SHORT right = left; right < bufferSize.X; ++right)
+            {
+                const auto expected = _buffer->GetText(false, false, { SMALL_RECT{ left, row, right, row } });
+                VERIFY_ARE_EQUAL(expected.text.at(0), std::wstring{ _buffer->GetRowText(row, left, right) });
+            }
+        }
+    };
+
+    Log::Comment(L"Rows of narrow glyphs and rows of wide and surrogate glyphs are sliced alike.");
+    verifyRow(0);
+    verifyRow(1);
+    verifyRow(2);
+
+    Log::Comment(L"Changing a row updates the text cached for it.");
+    VERIFY_ARE_EQUAL(L"abc", std::wstring{ _buffer->GetRowText(0, 0, 2) });
+    _buffer->WriteLine(OutputCellIterator{ L"x\x3042" }, { 1, 0 });
+    VERIFY_ARE_EQUAL(L"ax\x3042", std::wstring{ _buffer->GetRowText(0, 0, 3) });
+    verifyRow(0);
+}
+
+void TextBufferTests::DeferDrawingMergesRedraws()
+{
+    const COORD bufferSize{ 10, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    RedrawRecordingTarget target;
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, target);
+
+    Log::Comment(L"Nothing is sent to the render target until the outermost deferral ends.");
+    _buffer->StartDeferDrawing();
+    _buffer->WriteLine(OutputCellIterator{ L"0123456789" }, { 0, 1 });
+    _buffer->StartDeferDrawing();
+    _buffer->WriteLine(OutputCellIterator{ L"abcdefghij" }, { 0, 2 });
+    _buffer->WriteLine(OutputCellIterator{ L"zz" }, { 2, 1 });
+    _buffer->WriteLine(OutputCellIterator{ L"x" }, { 3, 4 });
+    _buffer->EndDeferDrawing();
+    VERIFY_ARE_EQUAL(0u, target.redraws.size());
+    _buffer->EndDeferDrawing();
+
+    Log::Comment(L"The rows with the same columns are sent as one region.");
+    VERIFY_ARE_EQUAL(2u, target.redraws.size());
+    VERIFY_ARE_EQUAL((SMALL_RECT{ 0, 1, 10, 3 }), target.redraws.at(0));
+    VERIFY_ARE_EQUAL((SMALL_RECT{ 3, 4, 4, 5 }), target.redraws.at(1));
+
+    Log::Comment(L"The regions are sent before the rows move, as they refer to where the text was.");
+    target.redraws.clear();
+    _buffer->StartDeferDrawing();
+    _buffer->WriteLine(OutputCellIterator{ L"y" }, { 5, 3 });
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    _buffer->WriteLine(OutputCellIterator{ L"y" }, { 6, 3 });
+    _buffer->EndDeferDrawing();
+    VERIFY_ARE_EQUAL(1u, target.circledAfter);
+    VERIFY_ARE_EQUAL(2u, target.redraws.size());
+    VERIFY_ARE_EQUAL((SMALL_RECT{ 5, 3, 6, 4 }), target.redraws.at(0));
+    VERIFY_ARE_EQUAL((SMALL_RECT{ 6, 3, 7, 4 }), target.redraws.at(1));
 }
@@ -406,6 +406,29 @@ public:
     {
         return {};
     }
+
+    uint64_t GetPatternGeneration() const noexcept
+    {
+        return 0;
+    }
+
+    std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlights() const noexcept
+    {
+        return {};
+    }
+
+    Microsoft::Console::Render::InputEcho GetInputEcho() const noexcept
+    {
+        return {};
+    }
+
+    void LockConsoleShared() noexcept override
+    {
+    }
+
+    void UnlockConsoleShared() noexcept override
+    {
+    }
 };
 
 void VtIoTests::RendererDtorAndThread()
@@ -79,7 +79,14 @@ class Microsoft::Console::Render::VtRendererTest
 
     TEST_METHOD(TestWrapping);
 
+    TEST_METHOD(TestSkipUnchangedCells);
+    TEST_METHOD(TestCirclingScrolls);
+    TEST_METHOD(TestRepeatCharacter);
+    TEST_METHOD(TestPassthrough);
+    TEST_METHOD(TestStartPassthrough);
+
     TEST_METHOD(TestResize);
+    TEST_METHOD(TestTerminalResizeIsntRepainted);
 
     TEST_METHOD(TestCursorVisibility);
 
@@ -416,8 +423,7 @@ void VtRendererTest::Xterm256TestColors()
     Log::Comment(NoThrowString().Format(
         L"Begin by setting some test values - FG,BG = (1,2,3), (4,5,6) to start"
         L"These values were picked for ease of formatting raw COLORREF values."));
-    qExpectedInput.push_back("\x1b[38;2;1;2;3m");
-    qExpectedInput.push_back("\x1b[48;2;5;6;7m");
+    qExpectedInput.push_back("\x1b[38;2;1;2;3;48;2;5;6;7m");
     VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes({ 0x00030201, 0x00070605 },
                                                   &renderData,
                                                   false));
@@ -679,61 +685,65 @@ void VtRendererTest::Xterm256TestExtendedAttributes()
     VERIFY_SUCCEEDED(TestData::TryGetValue(L"crossedOut", crossedOut));
 
     TextAttribute desiredAttrs;
-    std::vector<std::string> onSequences, offSequences;
+    std::vector<std::string> onParameters;
 
-    // Collect up a VT sequence to set the state given the method properties
+    // Collect up the SGR parameters to set the state given the method properties
     if (faint)
     {
         desiredAttrs.SetFaint(true);
-        onSequences.push_back("\x1b[2m");
-        offSequences.push_back("\x1b[22m");
+        onParameters.push_back("2");
     }
     if (underlined)
     {
         desiredAttrs.SetUnderlined(true);
-        onSequences.push_back("\x1b[4m");
-        offSequences.push_back("\x1b[24m");
+        onParameters.push_back("4");
     }
     if (doublyUnderlined)
     {
         desiredAttrs.SetDoublyUnderlined(true);
-        onSequences.push_back("\x1b[21m");
-        // The two underlines share the same off sequence, so we
-        // only add it here if that hasn't already been done.
-        if (!underlined)
-        {
-            offSequences.push_back("\x1b[24m");
-        }
+        onParameters.push_back("21");
     }
     if (italics)
     {
         desiredAttrs.SetItalic(true);
-        onSequences.push_back("\x1b[3m");
-        offSequences.push_back("\x1b[23m");
+        onParameters.push_back("3");
     }
     if (blink)
     {
         desiredAttrs.SetBlinking(true);
-        onSequences.push_back("\x1b[5m");
-        offSequences.push_back("\x1b[25m");
+        onParameters.push_back("5");
     }
     if (invisible)
     {
         desiredAttrs.SetInvisible(true);
-        onSequences.push_back("\x1b[8m");
-        offSequences.push_back("\x1b[28m");
+        onParameters.push_back("8");
     }
     if (crossedOut)
     {
         desiredAttrs.SetCrossedOut(true);
-        onSequences.push_back("\x1b[9m");
-        offSequences.push_back("\x1b[29m");
+        onParameters.push_back("9");
+    }
+
+    // All the changes are combined into a single sequence. Turning them all
+    // off again is shortest with a reset.
+    std::vector<std::string> onSequences, offSequences;
+    if (!onParameters.empty())
+    {
+        std::string onSequence{ "\x1b[" };
+        for (const auto& parameter : onParameters)
+        {
+            onSequence.append(parameter).push_back(';');
+        }
+        onSequence.back() = 'm';
+        onSequences.push_back(onSequence);
+        offSequences.push_back("\x1b[m");
     }
 
     wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
     std::unique_ptr<Xterm256Engine> engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
     auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
     engine->SetTestCallback(pfn);
+    RenderData renderData;
 
     // Verify the first paint emits a clear and go home
     qExpectedInput.push_back("\x1b[2J");
@@ -747,26 +757,33 @@ void VtRendererTest::Xterm256TestExtendedAttributes()
     Log::Comment(NoThrowString().Format(
         L"Test changing the text attributes"));
 
+    Log::Comment(NoThrowString().Format(
+        L"----Start with all attributes reset----"));
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[m");
+        VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes({}, &renderData, false));
+    });
+
     Log::Comment(NoThrowString().Format(
         L"----Turn the extended attributes on----"));
     TestPaint(*engine, [&]() {
         // Merge the "on" sequences into expected input.
         std::copy(onSequences.cbegin(), onSequences.cend(), std::back_inserter(qExpectedInput));
-        VERIFY_SUCCEEDED(engine->_UpdateExtendedAttrs(desiredAttrs));
+        VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(desiredAttrs, &renderData, false));
     });
 
     Log::Comment(NoThrowString().Format(
         L"----Turn the extended attributes off----"));
     TestPaint(*engine, [&]() {
         std::copy(offSequences.cbegin(), offSequences.cend(), std::back_inserter(qExpectedInput));
-        VERIFY_SUCCEEDED(engine->_UpdateExtendedAttrs({}));
+        VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes({}, &renderData, false));
     });
 
     Log::Comment(NoThrowString().Format(
         L"----Turn the extended attributes back on----"));
     TestPaint(*engine, [&]() {
         std::copy(onSequences.cbegin(), onSequences.cend(), std::back_inserter(qExpectedInput));
-        VERIFY_SUCCEEDED(engine->_UpdateExtendedAttrs(desiredAttrs));
+        VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(desiredAttrs, &renderData, false));
     });
 
     VerifyExpectedInputsDrained();
@@ -850,8 +867,7 @@ void VtRendererTest::Xterm256TestAttributesAcrossReset()
 
     Log::Comment(L"----Reset Default Foreground and Retain Rendition----");
     textAttributes.SetDefaultForeground();
-    qExpectedInput.push_back("\x1b[m");
-    qExpectedInput.push_back(renditionSequence.str());
+    qExpectedInput.push_back("\x1b[39m");
     VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, &renderData, false));
 
     Log::Comment(L"----Set Green Background----");
@@ -861,8 +877,7 @@ void VtRendererTest::Xterm256TestAttributesAcrossReset()
 
     Log::Comment(L"----Reset Default Background and Retain Rendition----");
     textAttributes.SetDefaultBackground();
-    qExpectedInput.push_back("\x1b[m");
-    qExpectedInput.push_back(renditionSequence.str());
+    qExpectedInput.push_back("\x1b[49m");
     VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(textAttributes, &renderData, false));
 
     VerifyExpectedInputsDrained();
@@ -1401,6 +1416,243 @@ void VtRendererTest::TestWrapping()
     });
 }
 
+void VtRendererTest::TestSkipUnchangedCells()
+{
+    wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    std::unique_ptr<Xterm256Engine> engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+
+    // Verify the first paint emits a clear and go home
+    qExpectedInput.push_back("\x1b[2J");
+    TestPaint(*engine, [&]() {
+        VERIFY_IS_FALSE(engine->_firstPaint);
+    });
+
+    const auto makeClusters = [](const std::wstring_view text) {
+        std::vector<Cluster> clusters;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            clusters.emplace_back(text.substr(i, 1), static_cast<size_t>(1));
+        }
+        return clusters;
+    };
+
+    const auto line1 = makeClusters(L"0123456789abcdefghijklmnop");
+    const auto line2 = makeClusters(L"0123456789ABCdefghijklmnop");
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(NoThrowString().Format(
+            L"Paint a line for the first time. All of it is sent."));
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("0123456789abcdefghijklmnop");
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line1.data(), line1.size() }, { 0, 0 }, false, false));
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(NoThrowString().Format(
+            L"Paint the same line again. Nothing needs to be sent."));
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line1.data(), line1.size() }, { 0, 0 }, false, false));
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(NoThrowString().Format(
+            L"Change a few characters in the middle. Only those are sent."));
+        qExpectedInput.push_back("\x1b[1;11H");
+        qExpectedInput.push_back("ABC");
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line2.data(), line2.size() }, { 0, 0 }, false, false));
+    });
+
+    Log::Comment(NoThrowString().Format(
+        L"After everything is invalidated, the whole line is sent again."));
+    VERIFY_SUCCEEDED(engine->InvalidateAll());
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("0123456789ABCdefghijklmnop");
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line2.data(), line2.size() }, { 0, 0 }, false, false));
+    });
+
+    VerifyExpectedInputsDrained();
+}
+
+void VtRendererTest::TestCirclingScrolls()
+{
+    wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    std::unique_ptr<Xterm256Engine> engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+
+    // Verify the first paint emits a clear and go home
+    qExpectedInput.push_back("\x1b[2J");
+    TestPaint(*engine, [&]() {
+        VERIFY_IS_FALSE(engine->_firstPaint);
+    });
+
+    const auto makeClusters = [](const std::wstring_view text) {
+        std::vector<Cluster> clusters;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            clusters.emplace_back(text.substr(i, 1), static_cast<size_t>(1));
+        }
+        return clusters;
+    };
+
+    const auto line1 = makeClusters(L"abcdef");
+    const auto line2 = makeClusters(L"ghijkl");
+
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("abcdef");
+        qExpectedInput.push_back("\r\n");
+        qExpectedInput.push_back("ghijkl");
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line1.data(), line1.size() }, { 0, 0 }, false, false));
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line2.data(), line2.size() }, { 0, 1 }, false, false));
+    });
+
+    Log::Comment(NoThrowString().Format(
+        L"Circling with nothing to paint in the top row doesn't force a frame."));
+    bool forcePaint = true;
+    VERIFY_SUCCEEDED(engine->InvalidateCircling(&forcePaint));
+    VERIFY_IS_FALSE(forcePaint);
+    VERIFY_IS_FALSE(engine->_circled);
+
+    Log::Comment(NoThrowString().Format(
+        L"The scroll for it is a newline, and the rows that moved up aren't sent again."));
+    COORD scrollDelta = { 0, -1 };
+    VERIFY_SUCCEEDED(engine->InvalidateScroll(&scrollDelta));
+    TestPaint(*engine, [&]() {
+        qExpectedInput.push_back("\x1b[32;1H"); // Bottom of buffer
+        qExpectedInput.push_back("\n"); // Scroll down once
+        VERIFY_SUCCEEDED(engine->ScrollFrame());
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line2.data(), line2.size() }, { 0, 0 }, false, false));
+    });
+
+    Log::Comment(NoThrowString().Format(
+        L"The top row is painted before it's lost, if it's invalid."));
+    SMALL_RECT invalid = { 0, 0, 1, 1 };
+    VERIFY_SUCCEEDED(engine->Invalidate(&invalid));
+    VERIFY_SUCCEEDED(engine->InvalidateCircling(&forcePaint));
+    VERIFY_IS_TRUE(forcePaint);
+    VERIFY_IS_TRUE(engine->_circled);
+
+    VerifyExpectedInputsDrained();
+}
+
+void VtRendererTest::TestRepeatCharacter()
+{
+    wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    std::unique_ptr<Xterm256Engine> engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+    engine->SetRepeatCharacter(true);
+
+    // Verify the first paint emits a clear and go home
+    qExpectedInput.push_back("\x1b[2J");
+    TestPaint(*engine, [&]() {
+        VERIFY_IS_FALSE(engine->_firstPaint);
+    });
+
+    const auto makeClusters = [](const std::wstring_view text) {
+        std::vector<Cluster> clusters;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            clusters.emplace_back(text.substr(i, 1), static_cast<size_t>(1));
+        }
+        return clusters;
+    };
+
+    const auto line1 = makeClusters(L"a--------------------b");
+    const auto line2 = makeClusters(L"aa---b");
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(NoThrowString().Format(
+            L"A long run of the same character is written once, followed by a REP."));
+        qExpectedInput.push_back("\x1b[H");
+        qExpectedInput.push_back("a-");
+        qExpectedInput.push_back("\x1b[19b");
+        qExpectedInput.push_back("b");
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line1.data(), line1.size() }, { 0, 0 }, false, false));
+    });
+
+    TestPaint(*engine, [&]() {
+        Log::Comment(NoThrowString().Format(
+            L"Short runs are written as they are, since a REP wouldn't be shorter."));
+        qExpectedInput.push_back("\r\n");
+        qExpectedInput.push_back("aa---b");
+        VERIFY_SUCCEEDED(engine->PaintBufferLine({ line2.data(), line2.size() }, { 0, 1 }, false, false));
+    });
+
+    VerifyExpectedInputsDrained();
+}
+
+void VtRendererTest::TestPassthrough()
+{
+    wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    std::unique_ptr<Xterm256Engine> engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+    engine->EnablePassthrough();
+
+    // Verify the first paint emits a clear and go home
+    qExpectedInput.push_back("\x1b[2J");
+    TestPaint(*engine, [&]() {
+        VERIFY_IS_FALSE(engine->_passthrough);
+    });
+
+    Log::Comment(NoThrowString().Format(
+        L"The first frame didn't paint any text, so passthrough mode starts."));
+    VERIFY_IS_TRUE(engine->_passthrough);
+    VERIFY_IS_FALSE(engine->IsPassthroughActive());
+
+    Log::Comment(NoThrowString().Format(
+        L"The client's output is written as is, and what it changes isn't painted."));
+    engine->BeginPassthroughWrite();
+    VERIFY_IS_TRUE(engine->IsPassthroughActive());
+    qExpectedInput.push_back("\x1b[31mabc");
+    VERIFY_SUCCEEDED(engine->WriteTerminalW(L"\x1b[31mabc"));
+    SMALL_RECT invalid = { 0, 0, 3, 1 };
+    VERIFY_SUCCEEDED(engine->Invalidate(&invalid));
+    VERIFY_SUCCEEDED(engine->EndPassthroughWrite());
+    VERIFY_IS_TRUE(engine->_invalidMap.none());
+    VERIFY_ARE_EQUAL(S_FALSE, engine->StartPaint());
+
+    Log::Comment(NoThrowString().Format(
+        L"Any other change ends passthrough mode. The terminal is reset and everything is painted again."));
+    qExpectedInput.push_back("\x1b[r\x1b[?6l\x1b[?7h\x1b(B\x0f\x1b[m");
+    qExpectedInput.push_back("\x1b]8;;\x1b\\");
+    qExpectedInput.push_back("\x1b[?25l");
+    VERIFY_SUCCEEDED(engine->Invalidate(&invalid));
+    VERIFY_IS_FALSE(engine->_passthrough);
+    VERIFY_IS_TRUE(engine->_invalidMap.all());
+
+    VerifyExpectedInputsDrained();
+}
+
+void VtRendererTest::TestStartPassthrough()
+{
+    wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    std::unique_ptr<Xterm256Engine> engine = std::make_unique<Xterm256Engine>(std::move(hFile), SetUpViewport());
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+
+    Log::Comment(NoThrowString().Format(
+        L"Passthrough mode starts without a first frame, which would emit a clear."));
+    engine->StartPassthrough();
+    VERIFY_IS_TRUE(engine->_passthrough);
+    VERIFY_IS_FALSE(engine->IsPassthroughActive());
+    VERIFY_ARE_EQUAL(S_FALSE, engine->StartPaint());
+
+    Log::Comment(NoThrowString().Format(
+        L"The client's output is written as soon as it's been processed."));
+    engine->BeginPassthroughWrite();
+    VERIFY_IS_TRUE(engine->IsPassthroughActive());
+    qExpectedInput.push_back("\x1b[31mabc");
+    VERIFY_SUCCEEDED(engine->WriteTerminalW(L"\x1b[31mabc"));
+    VERIFY_SUCCEEDED(engine->EndPassthroughWrite());
+
+    VerifyExpectedInputsDrained();
+}
+
 void VtRendererTest::TestResize()
 {
     Viewport view = SetUpViewport();
@@ -1438,6 +1690,46 @@ void VtRendererTest::TestResize()
     });
 }
 
+void VtRendererTest::TestTerminalResizeIsntRepainted()
+{
+    Viewport view = SetUpViewport();
+    wil::unique_hfile hFile = wil::unique_hfile(INVALID_HANDLE_VALUE);
+    auto engine = std::make_unique<Xterm256Engine>(std::move(hFile), view);
+    auto pfn = std::bind(&VtRendererTest::WriteCallback, this, std::placeholders::_1, std::placeholders::_2);
+    engine->SetTestCallback(pfn);
+
+    // Verify the first paint emits a clear and go home
+    qExpectedInput.push_back("\x1b[2J");
+    TestPaint(*engine, [&]() {
+        VERIFY_IS_FALSE(engine->_firstPaint);
+    });
+
+    SMALL_RECT invalid = { 1, 1, 2, 2 };
+
+    Log::Comment(NoThrowString().Format(
+        L"Without the resize quirk, the terminal doesn't reflow itself, and our reflow is painted."));
+    engine->BeginTerminalResize();
+    VERIFY_SUCCEEDED(engine->Invalidate(&invalid));
+    engine->EndTerminalResize();
+    VERIFY_IS_TRUE(engine->_invalidMap.one());
+    engine->_invalidMap.reset_all();
+
+    Log::Comment(NoThrowString().Format(
+        L"With it, what the reflow of the terminal's resize changes isn't sent back."));
+    engine->SetResizeQuirk(true);
+    engine->BeginTerminalResize();
+    VERIFY_SUCCEEDED(engine->Invalidate(&invalid));
+    engine->EndTerminalResize();
+    VERIFY_IS_TRUE(engine->_invalidMap.none());
+
+    Log::Comment(NoThrowString().Format(
+        L"Afterwards, changes are painted again."));
+    VERIFY_SUCCEEDED(engine->Invalidate(&invalid));
+    VERIFY_IS_TRUE(engine->_invalidMap.one());
+
+    VerifyExpectedInputsDrained();
+}
+
 void VtRendererTest::TestCursorVisibility()
 {
     Viewport view = SetUpViewport();
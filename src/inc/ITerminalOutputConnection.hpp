@@ -25,6 +25,10 @@ namespace Microsoft::Console
 
         [[nodiscard]] virtual HRESULT WriteTerminalUtf8(const std::string_view str) = 0;
         [[nodiscard]] virtual HRESULT WriteTerminalW(const std::wstring_view wstr) = 0;
+
+        // Returns true if everything the console processes is to be written to the
+        // terminal as well, rather than repainted from the buffer.
+        [[nodiscard]] virtual bool IsPassthroughActive() const noexcept = 0;
     };
 
     inline Microsoft::Console::ITerminalOutputConnection::~ITerminalOutputConnection() {}
@@ -0,0 +1,37 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- StartupTracing.h
+
+Abstract:
+- Start/stop events for the phases of launching Windows Terminal, from the
+  creation of AppLogic to the first frame that's presented.
+- Every component writes them with its own provider, under the same event
+  name, so that ConsolePerf.regions.xml can show them as a timeline in WPA.
+  The phases that run again later (a settings reload, a new pane) write the
+  same events then.
+- The events are written at WINEVENT_LEVEL_INFO with TIL_KEYWORD_TRACE. All
+  of them are collected by Terminal.wprp.
+--*/
+
+#pragma once
+
+// Writes the start event of the given phase, and its stop event when the
+// enclosing scope is left. The phase has to be a string literal.
+#define TRACE_STARTUP_PHASE(provider, phase)                                                \
+    TraceLoggingWrite(provider,                                                             \
+                      "StartupPhase",                                                       \
+                      TraceLoggingString(phase, "Phase"),                                   \
+                      TraceLoggingOpcode(WINEVENT_OPCODE_START),                            \
+                      TraceLoggingLevel(WINEVENT_LEVEL_INFO),                               \
+                      TraceLoggingKeyword(TIL_KEYWORD_TRACE));                              \
+    const auto _startupPhaseStop = wil::scope_exit([&]() noexcept {                         \
+        TraceLoggingWrite(provider,                                                         \
+                          "StartupPhase",                                                   \
+                          TraceLoggingString(phase, "Phase"),                               \
+                          TraceLoggingOpcode(WINEVENT_OPCODE_STOP),                         \
+                          TraceLoggingLevel(WINEVENT_LEVEL_INFO),                           \
+                          TraceLoggingKeyword(TIL_KEYWORD_TRACE));                          \
+    })
@@ -76,6 +76,9 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
 
         private:
             const dynamic_bitset<unsigned long long, Allocator>& _values;
+            // The complement of _values, so that the end of a run can be found with find_next() (a bit scan
+            // over whole blocks) too. It's only made once a run is found and shared by the copies of the iterator.
+            std::shared_ptr<const dynamic_bitset<unsigned long long, Allocator>> _unset;
             const til::rectangle _rc;
             ptrdiff_t _pos;
             ptrdiff_t _nextPos;
@@ -107,16 +110,15 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
                     // a run can be a max of one row tall.
                     const ptrdiff_t rowEndIndex = _rc.index_of(til::point(_rc.right() - 1, runStart.y())) + 1;
 
-                    // Find the length for the rectangle.
-                    ptrdiff_t runLength = 0;
-
-                    // We have at least 1 so start with a do/while.
-                    do
+                    // The run ends at the next off bit (the next set bit of the complement),
+                    // unless it reaches the end of the row first.
+                    if (!_unset)
                     {
-                        ++_nextPos;
-                        ++runLength;
-                    } while (_nextPos < rowEndIndex && _values[_nextPos]);
-                    // Keep going until we reach end of row, end of the buffer, or the next bit is off.
+                        _unset = std::make_shared<const dynamic_bitset<unsigned long long, Allocator>>(~_values);
+                    }
+                    const auto runEnd = std::min(base::saturated_cast<ptrdiff_t>(_unset->find_next(static_cast<size_t>(_nextPos))), rowEndIndex);
+                    const auto runLength = runEnd - _nextPos;
+                    _nextPos = runEnd;
 
                     // Assemble and store that run.
                     _run = til::rectangle{ runStart, til::size{ runLength, static_cast<ptrdiff_t>(1) } };
@@ -285,67 +287,59 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
                     return;
                 }
 
-                // FUTURE: PERF: GH #4015: This could use in-place walk semantics instead of a temporary.
-                bitmap<allocator_type> other{ _sz, _alloc };
+                const auto width = _sz.width();
+                const auto height = _sz.height();
 
-                for (auto run : *this)
+                // If everything slides out of bounds, everything is uncovered.
+                if (std::abs(delta.x()) >= width || std::abs(delta.y()) >= height)
                 {
-                    // Offset by the delta
-                    run += delta;
+                    if (fill)
+                    {
+                        set_all();
+                    }
+                    else
+                    {
+                        reset_all();
+                    }
+                    return;
+                }
 
-                    // Intersect with the bounds of our bitmap area
-                    // as part of it could have slid out of bounds.
-                    run &= _rc;
+                _runs.reset(); // reset cached runs on any non-const method
 
-                    // Set it into the new bitmap.
-                    other.set(run);
+#pragma warning(push)
+                // we can't depend on GSL here, so we use static_cast for explicit narrowing
+#pragma warning(disable : 26472)
+                // Moving every bit by delta.y() rows and delta.x() columns is the same as shifting the
+                // whole bitset by delta.y() * width + delta.x() bits (which happens a block at a time),
+                // except that the bits pushed past the left or right edge wrap around into the adjacent row.
+                const auto bitShift = delta.y() * width + delta.x();
+                if (bitShift > 0)
+                {
+                    _bits <<= static_cast<size_t>(bitShift);
+                }
+                else
+                {
+                    _bits >>= static_cast<size_t>(-bitShift);
                 }
 
-                // If we were asked to fill... find the uncovered region.
-                if (fill)
+                // The wrapped bits are exactly those in the columns the move uncovered. For example,
+                // with a delta of (2, 1) the bits that were in the last 2 columns of a row are now
+                // in the first 2 columns of the row 2 rows below it.
+                const auto columns = static_cast<size_t>(std::abs(delta.x()));
+                const auto firstColumn = delta.x() > 0 ? 0 : width + delta.x();
+                for (ptrdiff_t row = 0; row < height; ++row)
                 {
-                    // Original Rect of As.
-                    //
-                    // X <-- origin
-                    // A A A A
-                    // A A A A
-                    // A A A A
-                    // A A A A
-                    const auto originalRect = _rc;
-
-                    // If Delta = (2, 2)
-                    // Translated Rect of Bs.
-                    //
-                    // X <-- origin
-                    //
-                    //
-                    //     B B B B
-                    //     B B B B
-                    //     B B B B
-                    //     B B B B
-                    const auto translatedRect = _rc + delta;
-
-                    // Subtract the B from the A one to see what wasn't filled by the move.
-                    // C is the overlap of A and B:
-                    //
-                    // X <-- origin
-                    // A A A A                     1 1 1 1
-                    // A A A A                     1 1 1 1
-                    // A A C C B B     subtract    2 2
-                    // A A C C B B    --------->   2 2
-                    //     B B B B      A - B
-                    //     B B B B
-                    //
-                    // 1 and 2 are the spaces to fill that are "uncovered".
-                    const auto fillRects = originalRect - translatedRect;
-                    for (const auto& f : fillRects)
-                    {
-                        other.set(f);
-                    }
+                    _bits.set(static_cast<size_t>(row * width + firstColumn), columns, fill);
                 }
 
-                // Swap us with the temporary one.
-                std::swap(other, *this);
+                // The shift already cleared the rows the move uncovered.
+                if (fill && delta.y() != 0)
+                {
+                    const auto rows = std::abs(delta.y());
+                    const auto firstRow = delta.y() > 0 ? 0 : height - rows;
+                    _bits.set(static_cast<size_t>(firstRow * width), static_cast<size_t>(rows * width), true);
+                }
+#pragma warning(pop)
             }
 
             void set(const til::point pt)
@@ -379,6 +373,16 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
                 _bits.reset();
             }
 
+            // Sets all the bits that are set in the other bitmap, which must be of the same size.
+            bitmap& operator|=(const bitmap& other)
+            {
+                THROW_HR_IF(E_INVALIDARG, _sz != other._sz);
+                _runs.reset(); // reset cached runs on any non-const method
+
+                _bits |= other._bits;
+                return *this;
+            }
+
             // True if we resized. False if it was the same size as before.
             // Set fill if you want the new region (on growing) to be marked dirty.
             bool resize(til::size size, bool fill = false)
@@ -0,0 +1,409 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "spsc.h"
+
+#include <condition_variable>
+
+// til: Terminal Implementation Library. Also: "Today I Learned".
+// mpsc: Multi Producer Single Consumer. A MPSC queue/channel sends data from any number of senders to one receiver.
+namespace til::mpsc
+{
+    using size_type = spsc::size_type;
+
+    // The same wait policies as til::spsc:
+    // block_initially blocks until at least one item has been written into the sender / read from the receiver.
+    // block_forever blocks until all items have been written into the sender / read from the receiver.
+    using spsc::block_forever;
+    using spsc::block_initially;
+
+    namespace details
+    {
+        // Unlike spsc::details::arc, the state is guarded by a mutex, since producers race each other for slots.
+        // To make up for that, push() and pop() move as many items as they can each time they hold the lock,
+        // so that a batch of items costs as much synchronization as a single one.
+        //
+        // The items are stored in a ring buffer: [_head, _head + _size) modulo _capacity.
+        // The state is destroyed once the consumer and every producer have been dropped.
+        template<typename T>
+        struct shared_state
+        {
+            explicit shared_state(size_type capacity) :
+                _data(spsc::details::alloc_raw_memory<T>(size_t(capacity) * sizeof(T))),
+                _capacity(capacity)
+            {
+            }
+
+            ~shared_state()
+            {
+                for (size_type i = 0; i < _size; ++i)
+                {
+                    std::destroy_at(_data + _slot(i));
+                }
+
+                spsc::details::free_raw_memory(_data);
+            }
+
+            void add_producer() noexcept
+            {
+                const std::lock_guard<std::mutex> lock{ _mutex };
+                ++_producers;
+                ++_references;
+            }
+
+            void drop_producer() noexcept
+            {
+                bool last;
+                {
+                    // The notification happens under the lock, as the
+                    // other side may delete us as soon as it's released.
+                    const std::lock_guard<std::mutex> lock{ _mutex };
+                    // Once the last producer is gone, the consumer only drains what's left.
+                    _producers--;
+                    last = --_references == 0;
+                    _notEmpty.notify_one();
+                }
+
+                if (last)
+                {
+                    delete this;
+                }
+            }
+
+            void drop_consumer() noexcept
+            {
+                bool last;
+                {
+                    const std::lock_guard<std::mutex> lock{ _mutex };
+                    _consumerAlive = false;
+                    last = --_references == 0;
+                    _notFull.notify_all();
+                }
+
+                if (last)
+                {
+                    delete this;
+                }
+            }
+
+            // Writes up to count items from first into the queue, and advances first past those that were written.
+            // The amount of written items is returned as the first pair field. The second
+            // pair field will be false if the consumer is gone.
+            template<typename InputIt>
+            std::pair<size_t, bool> push(InputIt& first, size_t count, bool blockForever)
+            {
+                size_t written = 0;
+                auto blocking = true;
+
+                std::unique_lock<std::mutex> lock{ _mutex };
+                while (written != count)
+                {
+                    if (blocking)
+                    {
+                        _notFull.wait(lock, [&]() { return !_consumerAlive || _size != _capacity; });
+                    }
+                    if (!_consumerAlive)
+                    {
+                        return { written, false };
+                    }
+                    if (_size == _capacity)
+                    {
+                        break;
+                    }
+
+                    do
+                    {
+                        new (_data + _slot(_size)) T(*first);
+                        ++first;
+                        ++_size;
+                        ++written;
+                    } while (written != count && _size != _capacity);
+
+                    _notEmpty.notify_one();
+                    blocking = blockForever;
+                }
+
+                return { written, true };
+            }
+
+            template<typename... Args>
+            bool emplace(Args&&... args)
+            {
+                {
+                    std::unique_lock<std::mutex> lock{ _mutex };
+                    _notFull.wait(lock, [&]() { return !_consumerAlive || _size != _capacity; });
+                    if (!_consumerAlive)
+                    {
+                        return false;
+                    }
+
+                    new (_data + _slot(_size)) T(std::forward<Args>(args)...);
+                    ++_size;
+                }
+                _notEmpty.notify_one();
+                return true;
+            }
+
+            // Reads up to count items into first, and advances first past those that were read.
+            // The amount of read items is returned as the first pair field. The second pair
+            // field will be false if all producers are gone and the queue has been drained.
+            template<typename OutputIt>
+            std::pair<size_t, bool> pop(OutputIt& first, size_t count, bool blockForever)
+            {
+                size_t read = 0;
+                auto blocking = true;
+
+                std::unique_lock<std::mutex> lock{ _mutex };
+                while (read != count)
+                {
+                    if (blocking)
+                    {
+                        _notEmpty.wait(lock, [&]() { return _producers == 0 || _size != 0; });
+                    }
+                    if (_size == 0)
+                    {
+                        return { read, _producers != 0 };
+                    }
+
+                    do
+                    {
+                        const auto item = _data + _head;
+                        *first = std::move(*item);
+                        ++first;
+                        std::destroy_at(item);
+                        _head = _head + 1 == _capacity ? 0 : _head + 1;
+                        --_size;
+                        ++read;
+                    } while (read != count && _size != 0);
+
+                    // Any number of producers may be waiting for the room we just made.
+                    _notFull.notify_all();
+                    blocking = blockForever;
+                }
+
+                return { read, true };
+            }
+
+            std::optional<T> pop_one()
+            {
+                std::optional<T> item;
+                {
+                    std::unique_lock<std::mutex> lock{ _mutex };
+                    _notEmpty.wait(lock, [&]() { return _producers == 0 || _size != 0; });
+                    if (_size == 0)
+                    {
+                        return std::nullopt;
+                    }
+
+                    const auto slot = _data + _head;
+                    item.emplace(std::move(*slot));
+                    std::destroy_at(slot);
+                    _head = _head + 1 == _capacity ? 0 : _head + 1;
+                    --_size;
+                }
+                _notFull.notify_one();
+                return item;
+            }
+
+        private:
+            size_type _slot(size_type offset) const noexcept
+            {
+                const auto slot = size_t(_head) + offset;
+                return static_cast<size_type>(slot < _capacity ? slot : slot - _capacity);
+            }
+
+            T* const _data;
+            const size_type _capacity;
+
+            std::mutex _mutex;
+            std::condition_variable _notEmpty;
+            std::condition_variable _notFull;
+            size_type _head = 0;
+            size_type _size = 0;
+            size_t _producers = 1;
+            size_t _references = 2;
+            bool _consumerAlive = true;
+        };
+    }
+
+    template<typename T>
+    struct producer
+    {
+        explicit producer(details::shared_state<T>* state) noexcept :
+            _state(state) {}
+
+        // Unlike spsc::producer, a producer can be copied to get another producer for the same channel.
+        producer(const producer<T>& other) noexcept :
+            _state(other._state)
+        {
+            if (_state)
+            {
+                _state->add_producer();
+            }
+        }
+
+        producer<T>& operator=(const producer<T>& other) noexcept
+        {
+            if (this != &other)
+            {
+                drop();
+                _state = other._state;
+                if (_state)
+                {
+                    _state->add_producer();
+                }
+            }
+            return *this;
+        }
+
+        producer(producer<T>&& other) noexcept :
+            _state(std::exchange(other._state, nullptr))
+        {
+        }
+
+        producer<T>& operator=(producer<T>&& other) noexcept
+        {
+            if (this != &other)
+            {
+                drop();
+                _state = std::exchange(other._state, nullptr);
+            }
+            return *this;
+        }
+
+        ~producer()
+        {
+            drop();
+        }
+
+        // emplace constructs an item in-place at the end of the queue.
+        // It returns true, if the item was successfully placed within the queue.
+        // The return value will be false, if the consumer is gone.
+        template<typename... Args>
+        bool emplace(Args&&... args) const
+        {
+            return _state->emplace(std::forward<Args>(args)...);
+        }
+
+        template<typename InputIt>
+        std::pair<size_t, bool> push(InputIt first, InputIt last) const
+        {
+            return push_n(block_forever, first, std::distance(first, last));
+        }
+
+        // push writes the items between first and last into the queue.
+        // The amount of successfully written items is returned as the first pair field.
+        // The second pair field will be false if the consumer is gone.
+        template<typename WaitPolicy, typename InputIt, spsc::details::enable_if_wait_policy_t<WaitPolicy> = 0>
+        std::pair<size_t, bool> push(WaitPolicy&& policy, InputIt first, InputIt last) const
+        {
+            return push_n(std::forward<WaitPolicy>(policy), first, std::distance(first, last));
+        }
+
+        template<typename InputIt>
+        std::pair<size_t, bool> push_n(InputIt first, size_t count) const
+        {
+            return push_n(block_forever, first, count);
+        }
+
+        // push_n writes count items from first into the queue.
+        // The items of one call are written in order, but may be interleaved with those of other producers.
+        // The amount of successfully written items is returned as the first pair field.
+        // The second pair field will be false if the consumer is gone.
+        template<typename WaitPolicy, typename InputIt, spsc::details::enable_if_wait_policy_t<WaitPolicy> = 0>
+        std::pair<size_t, bool> push_n(WaitPolicy&&, InputIt first, size_t count) const
+        {
+            return _state->push(first, count, std::remove_reference_t<WaitPolicy>::_block_forever);
+        }
+
+    private:
+        void drop() noexcept
+        {
+            if (_state)
+            {
+                std::exchange(_state, nullptr)->drop_producer();
+            }
+        }
+
+        details::shared_state<T>* _state = nullptr;
+    };
+
+    template<typename T>
+    struct consumer
+    {
+        explicit consumer(details::shared_state<T>* state) noexcept :
+            _state(state) {}
+
+        consumer<T>(const consumer<T>&) = delete;
+        consumer<T>& operator=(const consumer<T>&) = delete;
+
+        consumer(consumer<T>&& other) noexcept :
+            _state(std::exchange(other._state, nullptr))
+        {
+        }
+
+        consumer<T>& operator=(consumer<T>&& other) noexcept
+        {
+            if (this != &other)
+            {
+                drop();
+                _state = std::exchange(other._state, nullptr);
+            }
+            return *this;
+        }
+
+        ~consumer()
+        {
+            drop();
+        }
+
+        // pop returns the next item in the queue, or std::nullopt if all producers are gone.
+        std::optional<T> pop() const
+        {
+            return _state->pop_one();
+        }
+
+        template<typename OutputIt>
+        std::pair<size_t, bool> pop_n(OutputIt first, size_t count) const
+        {
+            return pop_n(block_forever, first, count);
+        }
+
+        // pop_n reads up to count items into first.
+        // The amount of successfully read items is returned as the first pair field.
+        // The second pair field will be false if all producers are gone.
+        template<typename WaitPolicy, typename OutputIt, spsc::details::enable_if_wait_policy_t<WaitPolicy> = 0>
+        std::pair<size_t, bool> pop_n(WaitPolicy&&, OutputIt first, size_t count) const
+        {
+            return _state->pop(first, count, std::remove_reference_t<WaitPolicy>::_block_forever);
+        }
+
+    private:
+        void drop() noexcept
+        {
+            if (_state)
+            {
+                std::exchange(_state, nullptr)->drop_consumer();
+            }
+        }
+
+        details::shared_state<T>* _state = nullptr;
+    };
+
+    // channel returns a bounded, multi-producer, single-consumer FIFO queue ("channel") with
+    // the given maximum capacity. Copy the producer to get more producers for the same channel.
+    template<typename T>
+    std::pair<producer<T>, consumer<T>> channel(uint32_t capacity)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument{ "invalid capacity" };
+        }
+
+        spsc::details::validate_size(capacity);
+        const auto state = new details::shared_state<T>(capacity);
+        return { std::piecewise_construct, std::forward_as_tuple(state), std::forward_as_tuple(state) };
+    }
+}
@@ -1,6 +1,14 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT license.
 
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+
 namespace til
 {
     namespace details
@@ -105,4 +113,164 @@ namespace til
         mutable T _data{};
         mutable std::shared_mutex _mutex;
     };
+
+    // fair_shared_mutex is a reader/writer lock that can be used in place of a std::shared_mutex,
+    // but which doesn't let a writer that takes the lock over and over starve the readers.
+    // It's phase-fair: the readers that arrive while a writer holds the lock (or waits for it)
+    // wait for that writer to finish, and then all of them get the lock before the next writer.
+    // Like std::shared_mutex it isn't recursive, not even for readers.
+    //
+    // It also counts how often and for how long its users had to wait for it. Taking the
+    // lock without waiting doesn't touch the clock.
+    class fair_shared_mutex
+    {
+    public:
+        struct wait_statistics
+        {
+            uint64_t shared_waits{ 0 };
+            std::chrono::nanoseconds shared_wait_time{};
+            uint64_t exclusive_waits{ 0 };
+            std::chrono::nanoseconds exclusive_wait_time{};
+        };
+
+        fair_shared_mutex() = default;
+
+        fair_shared_mutex(const fair_shared_mutex&) = delete;
+        fair_shared_mutex& operator=(const fair_shared_mutex&) = delete;
+
+        void lock()
+        {
+            std::unique_lock guard{ _mutex };
+            if (_writer || _readers != 0 || _waitingWriters != 0)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                ++_waitingWriters;
+                _exclusiveWaits.fetch_add(1, std::memory_order_relaxed);
+                _writerCondition.wait(guard, [&]() noexcept { return !_writer && _readers == 0; });
+                --_waitingWriters;
+                _add(_exclusiveWaitTime, start);
+            }
+            _writer = true;
+        }
+
+        [[nodiscard]] bool try_lock()
+        {
+            const std::lock_guard guard{ _mutex };
+            if (_writer || _readers != 0 || _waitingWriters != 0)
+            {
+                return false;
+            }
+            _writer = true;
+            return true;
+        }
+
+        void unlock()
+        {
+            auto wakeReaders = false;
+            auto wakeWriter = false;
+            {
+                const std::lock_guard guard{ _mutex };
+                _writer = false;
+
+                // The waiting readers are let in right here, so that a writer
+                // who's woken up (or just arrives) has to wait for them.
+                if (_waitingReaders != 0)
+                {
+                    _readers += std::exchange(_waitingReaders, 0);
+                    ++_phase;
+                    wakeReaders = true;
+                }
+                else
+                {
+                    wakeWriter = _waitingWriters != 0;
+                }
+            }
+
+            if (wakeReaders)
+            {
+                _readerCondition.notify_all();
+            }
+            else if (wakeWriter)
+            {
+                _writerCondition.notify_one();
+            }
+        }
+
+        void lock_shared()
+        {
+            std::unique_lock guard{ _mutex };
+            if (!_writer && _waitingWriters == 0)
+            {
+                ++_readers;
+                return;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto phase = _phase;
+            ++_waitingReaders;
+            _sharedWaits.fetch_add(1, std::memory_order_relaxed);
+            // The writer that ends the phase counts us among the readers. See unlock().
+            _readerCondition.wait(guard, [&]() noexcept { return _phase != phase; });
+            _add(_sharedWaitTime, start);
+        }
+
+        [[nodiscard]] bool try_lock_shared()
+        {
+            const std::lock_guard guard{ _mutex };
+            if (_writer || _waitingWriters != 0)
+            {
+                return false;
+            }
+            ++_readers;
+            return true;
+        }
+
+        void unlock_shared()
+        {
+            auto wakeWriter = false;
+            {
+                const std::lock_guard guard{ _mutex };
+                wakeWriter = --_readers == 0 && _waitingWriters != 0;
+            }
+
+            if (wakeWriter)
+            {
+                _writerCondition.notify_one();
+            }
+        }
+
+        // Returns the totals since the mutex was created. Can be called while it's locked.
+        [[nodiscard]] wait_statistics statistics() const noexcept
+        {
+            wait_statistics statistics;
+            statistics.shared_waits = _sharedWaits.load(std::memory_order_relaxed);
+            statistics.shared_wait_time = std::chrono::nanoseconds{ _sharedWaitTime.load(std::memory_order_relaxed) };
+            statistics.exclusive_waits = _exclusiveWaits.load(std::memory_order_relaxed);
+            statistics.exclusive_wait_time = std::chrono::nanoseconds{ _exclusiveWaitTime.load(std::memory_order_relaxed) };
+            return statistics;
+        }
+
+    private:
+        static void _add(std::atomic<int64_t>& counter, const std::chrono::steady_clock::time_point start) noexcept
+        {
+            const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            counter.fetch_add(waited.count(), std::memory_order_relaxed);
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _readerCondition;
+        std::condition_variable _writerCondition;
+
+        // These are protected by _mutex.
+        size_t _readers{ 0 }; // the readers holding the lock, including the ones not awake yet
+        size_t _waitingReaders{ 0 };
+        size_t _waitingWriters{ 0 };
+        uint64_t _phase{ 0 }; // counts the writers that let readers in
+        bool _writer{ false };
+
+        std::atomic<uint64_t> _sharedWaits{ 0 };
+        std::atomic<int64_t> _sharedWaitTime{ 0 };
+        std::atomic<uint64_t> _exclusiveWaits{ 0 };
+        std::atomic<int64_t> _exclusiveWaitTime{ 0 };
+    };
 } // namespace til
@@ -70,4 +70,143 @@ namespace til::pmr
         return std::pmr::get_default_resource();
     }
 #endif
+
+    // A monotonic resource for memory that's only needed for a short while, like the
+    // containers used while painting a frame. Deallocating is a no-op and reset()
+    // releases everything at once.
+    //
+    // Unlike std::pmr::monotonic_buffer_resource, reset() doesn't return the memory to
+    // the upstream resource. If more than one block was needed since the last reset(),
+    // they're replaced by a single block as large as all of them, so that once the arena
+    // has seen the largest amount of work, doing it again doesn't allocate anymore.
+    //
+    // It isn't thread-safe.
+    class arena : public std::pmr::memory_resource
+    {
+    public:
+        explicit arena(std::pmr::memory_resource* upstream = get_default_resource()) noexcept :
+            _upstream{ upstream }
+        {
+        }
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        ~arena()
+        {
+            _release();
+        }
+
+        // Releases everything that was allocated since the last reset().
+        // The memory must not be accessed anymore after this.
+        void reset() noexcept
+        {
+            if (_blocks && _blocks->next)
+            {
+                const auto size = capacity();
+                _release();
+
+                // If this fails, the arena will simply grow again.
+                try
+                {
+                    _grow(size);
+                }
+                catch (...)
+                {
+                }
+            }
+            else if (_blocks)
+            {
+                _rewind();
+            }
+        }
+
+        // Gives all of the memory back to the upstream resource. Like reset(),
+        // the memory must not be accessed anymore after this.
+        void release() noexcept
+        {
+            _release();
+        }
+
+        // The amount of memory the arena holds from the upstream resource.
+        size_t capacity() const noexcept
+        {
+            size_t capacity = 0;
+            for (auto block = _blocks; block; block = block->next)
+            {
+                capacity += block->size;
+            }
+            return capacity;
+        }
+
+    private:
+        struct block
+        {
+            block* next;
+            size_t size; // including this header
+        };
+
+        static constexpr size_t _minimumBlockSize = 4096;
+        static constexpr size_t _blockAlignment = alignof(std::max_align_t);
+
+        void* do_allocate(const size_t bytes, const size_t align) override
+        {
+            if (auto ptr = std::align(align, bytes, _ptr, _space))
+            {
+                _ptr = static_cast<char*>(ptr) + bytes;
+                _space -= bytes;
+                return ptr;
+            }
+
+            // Each new block is at least as large as all previous ones together,
+            // so a growing frame only needs a few of them.
+            _grow(std::max(sizeof(block) + bytes + align, capacity()));
+
+            const auto ptr = std::align(align, bytes, _ptr, _space);
+            _ptr = static_cast<char*>(ptr) + bytes;
+            _space -= bytes;
+            return ptr;
+        }
+
+        void do_deallocate(void* const, const size_t, const size_t) noexcept override
+        {
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        void _grow(size_t size)
+        {
+            size = std::max(size, _minimumBlockSize);
+            const auto memory = _upstream->allocate(size, _blockAlignment);
+            _blocks = new (memory) block{ _blocks, size };
+            _rewind();
+        }
+
+        void _rewind() noexcept
+        {
+            _ptr = _blocks + 1;
+            _space = _blocks->size - sizeof(block);
+        }
+
+        void _release() noexcept
+        {
+            while (_blocks)
+            {
+                const auto next = _blocks->next;
+                _upstream->deallocate(_blocks, _blocks->size, _blockAlignment);
+                _blocks = next;
+            }
+
+            _ptr = nullptr;
+            _space = 0;
+        }
+
+        std::pmr::memory_resource* _upstream;
+        block* _blocks = nullptr; // newest first
+        void* _ptr = nullptr;
+        size_t _space = 0;
+    };
 }
@@ -376,6 +376,38 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             }
         }
 
+        // Builds a vector out of the runs in [first, last).
+        // Adjacent runs with the same value are joined and empty runs are skipped.
+        // Unless It is a mere input iterator, the runs are allocated all at once.
+        template<typename It, typename = typename std::iterator_traits<It>::iterator_category>
+        basic_rle(It first, It last) :
+            _total_length(0)
+        {
+            if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>)
+            {
+                _runs.reserve(static_cast<size_t>(std::distance(first, last)));
+            }
+
+            for (; first != last; ++first)
+            {
+                const rle_type& run = *first;
+                if (run.length == 0)
+                {
+                    continue;
+                }
+
+                if (!_runs.empty() && _runs.back().value == run.value)
+                {
+                    _runs.back().length += run.length;
+                }
+                else
+                {
+                    _runs.emplace_back(run.value, run.length);
+                }
+                _total_length += run.length;
+            }
+        }
+
         void swap(basic_rle& other) noexcept
         {
             _runs.swap(other._runs);
@@ -400,6 +432,13 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             return _runs;
         }
 
+        // Gives the capacity of the runs that isn't used back, which for a small_rle
+        // moves the runs back into its inline storage, if they fit there again.
+        void shrink_to_fit()
+        {
+            _runs.shrink_to_fit();
+        }
+
         // Get the value at the position
         const_reference at(size_type position) const
         {
@@ -477,6 +516,80 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             _replace_unchecked(start_index, end_index, replacements);
         }
 
+        // Replace the range [start_index, end_index) with the range [source_start, source_end) of source.
+        // If end_index (or source_end) is larger than size() (or source.size()) it's set to that.
+        // start_index must be smaller or equal to end_index and the same goes for source_start and source_end.
+        // source may be this vector.
+        void replace(size_type start_index, size_type end_index, const basic_rle& source, size_type source_start, size_type source_end)
+        {
+            _check_indices(start_index, end_index);
+            source._check_indices(source_start, source_end);
+
+            if (source_start == source_end)
+            {
+                if (start_index != end_index)
+                {
+                    _replace_unchecked(start_index, end_index, {});
+                }
+                return;
+            }
+
+            rle_scanner scanner(source._runs.begin(), source._runs.end());
+            const auto begin_run = scanner.scan(source_start).first;
+            const auto end_run = scanner.scan(source_end - 1).first;
+
+            // The common case of a range within a single run doesn't need to copy any runs.
+            if (begin_run == end_run)
+            {
+                const rle_type replacement{ begin_run->value, static_cast<size_type>(source_end - source_start) };
+                _replace_unchecked(start_index, end_index, { &replacement, 1 });
+                return;
+            }
+
+            // Otherwise the runs are copied first, as the first and last one need to be cut to size
+            // (and source might be this vector, whose runs are about to be shuffled around).
+            const auto replacements = source.slice(source_start, source_end);
+            _replace_unchecked(start_index, end_index, { replacements._runs.data(), replacements._runs.size() });
+        }
+
+        // Inserts count times value at index, moving the following values back.
+        // index must be smaller or equal to size().
+        void insert(size_type index, size_type count, const value_type& value)
+        {
+            if (count)
+            {
+                replace(index, index, rle_type{ value, count });
+            }
+        }
+
+        // Removes the range [start_index, end_index), moving the following values forward.
+        // If end_index is larger than size() it's set to size().
+        // start_index must be smaller or equal to end_index.
+        void erase(size_type start_index, size_type end_index)
+        {
+            _check_indices(start_index, end_index);
+            if (start_index != end_index)
+            {
+                _replace_unchecked(start_index, end_index, {});
+            }
+        }
+
+        // Adjust the size of the vector.
+        // If the size is being increased, the new space is filled with value.
+        // If the size is being decreased, the trailing runs are cut off to fit.
+        // Together with insert() and erase() this shifts values within a vector of a fixed size.
+        void resize(const size_type new_size, const value_type& value)
+        {
+            if (new_size > _total_length)
+            {
+                insert(_total_length, static_cast<size_type>(new_size - _total_length), value);
+            }
+            else
+            {
+                resize_trailing_extent(new_size);
+            }
+        }
+
         // Replaces every instance of old_value in this vector with new_value.
         void replace_values(const value_type& old_value, const value_type& new_value)
         {
@@ -491,6 +604,18 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             _compact();
         }
 
+        // Replaces every value in this vector with func(value).
+        template<typename F>
+        void transform_values(F&& func)
+        {
+            for (auto& run : _runs)
+            {
+                run.value = func(run.value);
+            }
+
+            _compact();
+        }
+
         // Adjust the size of the vector.
         // If the size is being increased, the last run is extended to fill up the new vector size.
         // If the size is being decreased, the trailing runs are cut off to fit.
@@ -675,7 +800,7 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             }
         }
 
-        inline void _check_indices(size_type start_index, size_type& end_index)
+        inline void _check_indices(size_type start_index, size_type& end_index) const
         {
             if (end_index > _total_length)
             {
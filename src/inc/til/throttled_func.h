@@ -79,6 +79,107 @@ namespace til
         private:
             std::atomic<bool> _isPending;
         };
+
+        // Picks the delay of each cycle of a throttled_func, somewhere between a minimum and a maximum.
+        // While invocations keep arriving during a cycle, the next one waits twice as long.
+        // Once a cycle sees no more than a single invocation, the delay is halved again,
+        // and if the caller was idle for longer than the delay, it's back to the minimum.
+        // With the same minimum and maximum, this is just a fixed delay.
+        class throttled_func_delay
+        {
+        public:
+            using filetime_duration = std::chrono::duration<int64_t, std::ratio<1, 10000000>>;
+
+            throttled_func_delay(filetime_duration minDelay, filetime_duration maxDelay) :
+                _min{ minDelay.count() },
+                _max{ maxDelay.count() },
+                _current{ minDelay.count() }
+            {
+                if (_min <= 0)
+                {
+                    throw std::invalid_argument("non-positive delay specified");
+                }
+                if (_max < _min)
+                {
+                    throw std::invalid_argument("maximum delay is less than the minimum");
+                }
+            }
+
+            // Counts an invocation. coalesced is true if it was merged into one that's still pending.
+            void record(bool coalesced) noexcept
+            {
+                _invocations.fetch_add(1, std::memory_order_relaxed);
+                if (coalesced)
+                {
+                    _coalesced.fetch_add(1, std::memory_order_relaxed);
+                    _cycleCoalesced.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            // Returns the delay of the cycle that's starting now, in the form SetThreadpoolTimerEx expects.
+            // Cycles don't overlap, so this is never called concurrently with itself.
+            FILETIME begin_cycle() noexcept
+            {
+                const auto busy = _cycleCoalesced.exchange(0, std::memory_order_relaxed) != 0;
+                const auto lastEnd = _lastCycleEnd.load(std::memory_order_relaxed);
+                auto current = _current.load(std::memory_order_relaxed);
+
+                if (lastEnd == 0 || _now() - lastEnd >= current)
+                {
+                    current = _min;
+                }
+                else if (busy)
+                {
+                    current = std::min(current * 2, _max);
+                }
+                else
+                {
+                    current = std::max(current / 2, _min);
+                }
+
+                _current.store(current, std::memory_order_relaxed);
+
+                // A negative FILETIME is relative to the current time.
+                const auto d = -current;
+                FILETIME delay;
+                memcpy(&delay, &d, sizeof(d));
+                return delay;
+            }
+
+            void end_cycle() noexcept
+            {
+                _lastCycleEnd.store(_now(), std::memory_order_relaxed);
+            }
+
+            filetime_duration current() const noexcept
+            {
+                return filetime_duration{ _current.load(std::memory_order_relaxed) };
+            }
+
+            uint64_t invocations() const noexcept
+            {
+                return _invocations.load(std::memory_order_relaxed);
+            }
+
+            uint64_t coalesced() const noexcept
+            {
+                return _coalesced.load(std::memory_order_relaxed);
+            }
+
+        private:
+            static int64_t _now() noexcept
+            {
+                return std::chrono::duration_cast<filetime_duration>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+            const int64_t _min;
+            const int64_t _max;
+            std::atomic<int64_t> _current;
+            std::atomic<int64_t> _lastCycleEnd{ 0 };
+            std::atomic<uint64_t> _invocations{ 0 };
+            std::atomic<uint64_t> _coalesced{ 0 };
+            std::atomic<uint64_t> _cycleCoalesced{ 0 };
+        };
     } // namespace details
 
     template<bool leading, typename... Args>
@@ -98,16 +199,19 @@ namespace til
         //
         // After `func` was invoked the state is reset and this cycle is repeated again.
         throttled_func(filetime_duration delay, function func) :
+            throttled_func(delay, delay, std::move(func))
+        {
+        }
+
+        // Like the above, but the delay adapts to the caller, between `minDelay` and `maxDelay`:
+        // While invocations keep arriving, the delay grows, so that a busy caller gets `func`
+        // invoked rarely. Once the caller goes idle, it shrinks back down to `minDelay`,
+        // so that the occasional invocation still gets through quickly.
+        throttled_func(filetime_duration minDelay, filetime_duration maxDelay, function func) :
+            _delay{ minDelay, maxDelay },
             _func{ std::move(func) },
             _timer{ _createTimer() }
         {
-            const auto d = -delay.count();
-            if (d >= 0)
-            {
-                throw std::invalid_argument("non-positive delay specified");
-            }
-
-            memcpy(&_delay, &d, sizeof(d));
         }
 
         // throttled_func uses its `this` pointer when creating _timer.
@@ -124,12 +228,32 @@ namespace til
         template<typename... MakeArgs>
         void operator()(MakeArgs&&... args)
         {
-            if (!_storage.emplace(std::forward<MakeArgs>(args)...))
+            const auto coalesced = _storage.emplace(std::forward<MakeArgs>(args)...);
+            _delay.record(coalesced);
+            if (!coalesced)
             {
                 _leading_edge();
             }
         }
 
+        // How often operator() was called so far, and how many of those
+        // calls were merged into an invocation that was already pending.
+        uint64_t invocations() const noexcept
+        {
+            return _delay.invocations();
+        }
+
+        uint64_t coalesced() const noexcept
+        {
+            return _delay.coalesced();
+        }
+
+        // The delay of the current (or last) cycle.
+        filetime_duration delay() const noexcept
+        {
+            return _delay.current();
+        }
+
         // Modifies the pending arguments for the next function
         // invocation, if there is one pending currently.
         //
@@ -172,11 +296,14 @@ namespace til
                 _func();
             }
 
-            SetThreadpoolTimerEx(_timer.get(), &_delay, 0, 0);
+            auto delay = _delay.begin_cycle();
+            SetThreadpoolTimerEx(_timer.get(), &delay, 0, 0);
         }
 
         void _trailing_edge()
         {
+            _delay.end_cycle();
+
             if constexpr (leading)
             {
                 _storage.reset();
@@ -194,7 +321,7 @@ namespace til
             return timer;
         }
 
-        FILETIME _delay;
+        details::throttled_func_delay _delay;
         function _func;
         wil::unique_threadpool_timer _timer;
         details::throttled_func_storage<Args...> _storage;
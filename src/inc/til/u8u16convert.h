@@ -15,12 +15,24 @@ in PR #4093 and the test algorithms are available in src\tools\U8U16Test.
 Based on the results the decision was made to keep using the platform
 functions MultiByteToWideChar and WideCharToMultiByte.
 
+Later, UTF-8 to UTF-16 got a vectorized fast path for ASCII plus a validated
+decoder for well-formed multi-byte sequences, which covers almost all of the
+output of console applications without any call into the OS. Ill-formed input
+is still passed to MultiByteToWideChar, so that it's replaced with U+FFFD the
+same way as before. U8U16Test compares both.
+
 Author(s):
 - Steffen Illhardt (german-one) 2020
 --*/
 
 #pragma once
 
+#if defined(_M_IX86) || defined(_M_AMD64)
+#include <emmintrin.h>
+#elif defined(_M_ARM64)
+#include <arm64_neon.h>
+#endif
+
 namespace til // Terminal Implementation Library. Also: "Today I Learned"
 {
     template<class charT>
@@ -252,6 +264,142 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
     typedef u8u16state<char> u8state;
     typedef u8u16state<wchar_t> u16state;
 
+    namespace details
+    {
+        // Routine Description:
+        // - Converts the leading ASCII characters of a UTF-8 string, 16 at a time where possible.
+        // Arguments:
+        // - src - the UTF-8 string, advanced past the ASCII characters on return
+        // - end - the end of the UTF-8 string
+        // - dst - the UTF-16 output, advanced past the converted characters on return.
+        //   It must have room for at least as many code units as are left in the input.
+        inline void u8u16_ascii(const uint8_t*& src, const uint8_t* const end, wchar_t*& dst) noexcept
+        {
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+#if defined(_M_IX86) || defined(_M_AMD64)
+            const auto zero = _mm_setzero_si128();
+            while (end - src >= 16)
+            {
+                const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                // All 16 are widened and stored, even if only some of them are ASCII.
+                // That's fine, because the output has room for them either way.
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(bytes, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_unpackhi_epi8(bytes, zero));
+                const auto mask = gsl::narrow_cast<unsigned long>(_mm_movemask_epi8(bytes));
+                if (mask != 0)
+                {
+                    unsigned long ascii;
+                    _BitScanForward(&ascii, mask);
+                    src += ascii;
+                    dst += ascii;
+                    return;
+                }
+                src += 16;
+                dst += 16;
+            }
+#elif defined(_M_ARM64)
+            while (end - src >= 16)
+            {
+                const auto bytes = vld1q_u8(src);
+                vst1q_u16(reinterpret_cast<uint16_t*>(dst), vmovl_u8(vget_low_u8(bytes)));
+                vst1q_u16(reinterpret_cast<uint16_t*>(dst + 8), vmovl_u8(vget_high_u8(bytes)));
+                if (vmaxvq_u8(bytes) >= 0x80)
+                {
+                    break;
+                }
+                src += 16;
+                dst += 16;
+            }
+#endif
+            for (; src != end && *src < 0x80; ++src, ++dst)
+            {
+                *dst = *src;
+            }
+#pragma warning(pop)
+        }
+
+        // Routine Description:
+        // - Converts a UTF-8 string to UTF-16, except for the part of it starting at the
+        //   first ill-formed sequence, which is left to MultiByteToWideChar.
+        //   The well-formed sequences are the ones in table 3-7 of the Unicode standard.
+        // Arguments:
+        // - in - UTF-8 string to be converted
+        // - out - the UTF-16 output, at least as long as the input
+        // Return Value:
+        // - the number of code units written to out, or 0 if MultiByteToWideChar failed
+        inline size_t u8u16_fast(const std::string_view in, wchar_t* const out) noexcept
+        {
+#pragma warning(push)
+#pragma warning(disable : 26481) // Don't use pointer arithmetic. Use span instead (bounds.1).
+#pragma warning(disable : 26490) // Don't use reinterpret_cast (type.1).
+            auto src = reinterpret_cast<const uint8_t*>(in.data());
+            const auto end = src + in.size();
+            auto dst = out;
+            const auto isContinuation = [](const uint8_t byte) noexcept { return (byte & 0b11'000000) == 0b10'000000; };
+
+            for (;;)
+            {
+                u8u16_ascii(src, end, dst);
+                if (src == end)
+                {
+                    break;
+                }
+
+                const auto lead = *src;
+                const auto left = end - src;
+                if (lead >= 0xC2 && lead <= 0xDF && left >= 2 && isContinuation(src[1]))
+                {
+                    *dst++ = gsl::narrow_cast<wchar_t>(((lead & 0x1F) << 6) | (src[1] & 0x3F));
+                    src += 2;
+                    continue;
+                }
+                if (lead >= 0xE0 && lead <= 0xEF && left >= 3 && isContinuation(src[2]))
+                {
+                    // E0 can't be followed by 80..9F (overlong), ED not by A0..BF (surrogates).
+                    const auto second = src[1];
+                    const auto low = lead == 0xE0 ? 0xA0 : 0x80;
+                    const auto high = lead == 0xED ? 0x9F : 0xBF;
+                    if (second >= low && second <= high)
+                    {
+                        *dst++ = gsl::narrow_cast<wchar_t>(((lead & 0x0F) << 12) | ((second & 0x3F) << 6) | (src[2] & 0x3F));
+                        src += 3;
+                        continue;
+                    }
+                }
+                if (lead >= 0xF0 && lead <= 0xF4 && left >= 4 && isContinuation(src[2]) && isContinuation(src[3]))
+                {
+                    // F0 can't be followed by 80..8F (overlong), F4 not by 90..BF (beyond U+10FFFF).
+                    const auto second = src[1];
+                    const auto low = lead == 0xF0 ? 0x90 : 0x80;
+                    const auto high = lead == 0xF4 ? 0x8F : 0xBF;
+                    if (second >= low && second <= high)
+                    {
+                        const auto codepoint = ((lead & 0x07u) << 18) | ((second & 0x3Fu) << 12) | ((src[2] & 0x3Fu) << 6) | (src[3] & 0x3Fu);
+                        *dst++ = gsl::narrow_cast<wchar_t>(0xD7C0 + (codepoint >> 10));
+                        *dst++ = gsl::narrow_cast<wchar_t>(0xDC00 | (codepoint & 0x3FF));
+                        src += 4;
+                        continue;
+                    }
+                }
+
+                // The rest is converted by the OS, which replaces the ill-formed sequences.
+                const auto lengthIn = gsl::narrow_cast<int>(end - src);
+                const auto lengthOut = MultiByteToWideChar(gsl::narrow_cast<UINT>(CP_UTF8), 0ul, reinterpret_cast<const char*>(src), lengthIn, dst, lengthIn);
+                if (lengthOut == 0)
+                {
+                    return 0;
+                }
+                dst += lengthOut;
+                break;
+            }
+
+            return gsl::narrow_cast<size_t>(dst - out);
+#pragma warning(pop)
+        }
+    }
+
     // Routine Description:
     // - Takes a UTF-8 string and performs the conversion to UTF-16. NOTE: The function relies on getting complete UTF-8 characters at the string boundaries.
     // Arguments:
@@ -278,9 +426,9 @@ namespace til // Terminal Implementation Library. Also: "Today I Learned"
             int lengthRequired{};
             // The worst ratio of UTF-8 code units to UTF-16 code units is 1 to 1 if UTF-8 consists of ASCII only.
             RETURN_HR_IF(E_ABORT, !base::MakeCheckedNum(in.length()).AssignIfValid(&lengthRequired));
-            out.resize(in.length()); // avoid to call MultiByteToWideChar twice only to get the required size
-            const int lengthOut = MultiByteToWideChar(gsl::narrow_cast<UINT>(CP_UTF8), 0ul, in.data(), lengthRequired, out.data(), lengthRequired);
-            out.resize(gsl::narrow_cast<size_t>(lengthOut));
+            out.resize(in.length()); // avoid to convert twice only to get the required size
+            const auto lengthOut = details::u8u16_fast(std::string_view{ in }, out.data());
+            out.resize(lengthOut);
 
             return lengthOut == 0 ? E_UNEXPECTED : S_OK;
         }
@@ -17,6 +17,7 @@
 #define DEFAULT_COLOR_ATTRIBUTE (0xC)
 
 using namespace Microsoft::Console::Render;
+using namespace Microsoft::Console::Types;
 using namespace Microsoft::Console::Interactivity;
 using namespace Microsoft::Console::Interactivity::OneCore;
 
@@ -25,6 +26,7 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
     _sharedViewBase((ULONG_PTR)SharedViewBase),
     _displayHeight(DisplayHeight),
     _displayWidth(DisplayWidth),
+    _invalidMap(til::size{ static_cast<ptrdiff_t>(std::max(DisplayWidth, 0L)), static_cast<ptrdiff_t>(std::max(DisplayHeight, 0L)) }, true),
     _currentLegacyColorAttribute(DEFAULT_COLOR_ATTRIBUTE)
 {
     _runLength = sizeof(CD_IO_CHARACTER) * DisplayWidth;
@@ -33,40 +35,56 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
     _fontSize.Y = FontHeight > SHORT_MAX ? SHORT_MAX : (SHORT)FontHeight;
 }
 
-[[nodiscard]] HRESULT BgfxEngine::Invalidate(const SMALL_RECT* const /*psrRegion*/) noexcept
+[[nodiscard]] HRESULT BgfxEngine::Invalidate(const SMALL_RECT* const psrRegion) noexcept
+try
 {
+    RETURN_HR_IF_NULL(E_INVALIDARG, psrRegion);
+    _InvalidateRows(Viewport::FromExclusive(*psrRegion).ToInclusive());
     return S_OK;
 }
+CATCH_RETURN();
 
-[[nodiscard]] HRESULT BgfxEngine::InvalidateCursor(const SMALL_RECT* const /*psrRegion*/) noexcept
+[[nodiscard]] HRESULT BgfxEngine::InvalidateCursor(const SMALL_RECT* const psrRegion) noexcept
 {
-    return S_OK;
+    return Invalidate(psrRegion);
 }
 
 [[nodiscard]] HRESULT BgfxEngine::InvalidateSystem(const RECT* const /*prcDirtyClient*/) noexcept
 {
-    return S_OK;
+    return InvalidateAll();
 }
 
-[[nodiscard]] HRESULT BgfxEngine::InvalidateSelection(const std::vector<SMALL_RECT>& /*rectangles*/) noexcept
+[[nodiscard]] HRESULT BgfxEngine::InvalidateSelection(const std::vector<SMALL_RECT>& rectangles) noexcept
 {
+    for (const auto& rect : rectangles)
+    {
+        RETURN_IF_FAILED(Invalidate(&rect));
+    }
     return S_OK;
 }
 
-[[nodiscard]] HRESULT BgfxEngine::InvalidateScroll(const COORD* const /*pcoordDelta*/) noexcept
+// Routine Description:
+// - The runs can't be moved around in the shared view, so all of the rows
+//   are painted again instead.
+[[nodiscard]] HRESULT BgfxEngine::InvalidateScroll(const COORD* const pcoordDelta) noexcept
 {
+    if (pcoordDelta->X != 0 || pcoordDelta->Y != 0)
+    {
+        return InvalidateAll();
+    }
     return S_OK;
 }
 
 [[nodiscard]] HRESULT BgfxEngine::InvalidateAll() noexcept
 {
+    _invalidMap.set_all();
     return S_OK;
 }
 
 [[nodiscard]] HRESULT BgfxEngine::InvalidateCircling(_Out_ bool* const pForcePaint) noexcept
 {
     *pForcePaint = false;
-    return S_FALSE;
+    return InvalidateAll();
 }
 
 [[nodiscard]] HRESULT BgfxEngine::PrepareForTeardown(_Out_ bool* const pForcePaint) noexcept
@@ -75,28 +93,36 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
     return S_FALSE;
 }
 
+// Routine Description:
+// - Starts a frame, unless nothing was invalidated since the last one.
+// Return Value:
+// - S_FALSE if there's nothing to paint, S_OK otherwise.
 [[nodiscard]] HRESULT BgfxEngine::StartPaint() noexcept
 {
-    return S_OK;
+    return _invalidMap.any() ? S_OK : S_FALSE;
 }
 
+// Routine Description:
+// - Sends the frame to ConIoSrv in a single request, and then copies the
+//   painted runs of the invalidated rows over the ones on the screen.
+// Return Value:
+// - S_OK or the failure of the request.
 [[nodiscard]] HRESULT BgfxEngine::EndPaint() noexcept
 {
-    NTSTATUS Status;
-
-    PVOID OldRunBase;
-    PVOID NewRunBase;
-
-    Status = ServiceLocator::LocateInputServices<ConIoSrvComm>()->RequestUpdateDisplay(0);
+    const auto Status = ServiceLocator::LocateInputServices<ConIoSrvComm>()->RequestUpdateDisplay(0);
 
     if (NT_SUCCESS(Status))
     {
-        for (SHORT i = 0; i < _displayHeight; i++)
+        for (const auto& rect : _invalidMap.runs())
         {
-            OldRunBase = (PVOID)(_sharedViewBase + (i * 2 * _runLength));
-            NewRunBase = (PVOID)(_sharedViewBase + (i * 2 * _runLength) + _runLength);
-            memcpy_s(OldRunBase, _runLength, NewRunBase, _runLength);
+            for (auto row = rect.top(); row < rect.bottom(); row++)
+            {
+                memcpy_s(_OldRun(row), _runLength, _NewRun(row), _runLength);
+            }
         }
+
+        // The rows are left invalid if the request failed, and sent along with the next frame.
+        _invalidMap.reset_all();
     }
 
     return HRESULT_FROM_NT(Status);
@@ -119,26 +145,20 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
     return S_OK;
 }
 
+// Routine Description:
+// - Clears the invalidated rows. The others keep what they show.
 [[nodiscard]] HRESULT BgfxEngine::PaintBackground() noexcept
 {
-    PVOID OldRunBase;
-    PVOID NewRunBase;
-
-    PCD_IO_CHARACTER OldRun;
-    PCD_IO_CHARACTER NewRun;
-
-    for (SHORT i = 0; i < _displayHeight; i++)
+    for (const auto& rect : _invalidMap.runs())
     {
-        OldRunBase = (PVOID)(_sharedViewBase + (i * 2 * _runLength));
-        NewRunBase = (PVOID)(_sharedViewBase + (i * 2 * _runLength) + _runLength);
-
-        OldRun = (PCD_IO_CHARACTER)OldRunBase;
-        NewRun = (PCD_IO_CHARACTER)NewRunBase;
-
-        for (SHORT j = 0; j < _displayWidth; j++)
+        for (auto row = rect.top(); row < rect.bottom(); row++)
         {
-            NewRun[j].Character = L' ';
-            NewRun[j].Attribute = 0;
+            const auto NewRun = _NewRun(row);
+            for (LONG j = 0; j < _displayWidth; j++)
+            {
+                NewRun[j].Character = L' ';
+                NewRun[j].Attribute = 0;
+            }
         }
     }
 
@@ -152,10 +172,15 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
 {
     try
     {
-        PVOID NewRunBase = (PVOID)(_sharedViewBase + (coord.Y * 2 * _runLength) + _runLength);
-        PCD_IO_CHARACTER NewRun = (PCD_IO_CHARACTER)NewRunBase;
+        // Rows outside of the display can't be painted and aren't invalidated.
+        if (coord.Y < 0 || coord.Y >= _displayHeight || coord.X < 0)
+        {
+            return S_OK;
+        }
 
-        for (size_t i = 0; i < clusters.size() && i < (size_t)_displayWidth; i++)
+        const auto NewRun = _NewRun(coord.Y);
+
+        for (size_t i = 0; i < clusters.size() && coord.X + i < (size_t)_displayWidth; i++)
         {
             NewRun[coord.X + i].Character = til::at(clusters, i).GetTextAsSingle();
             NewRun[coord.X + i].Attribute = _currentLegacyColorAttribute;
@@ -230,21 +255,19 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
     return S_OK;
 }
 
+// Routine Description:
+// - Gets the rows that were invalidated since the last frame.
+// Arguments:
+// - area - receives the rectangles of rows, spanning the whole display
+// Return Value:
+// - S_OK or the failure to build them.
 [[nodiscard]] HRESULT BgfxEngine::GetDirtyArea(gsl::span<const til::rectangle>& area) noexcept
+try
 {
-    SMALL_RECT r;
-    r.Bottom = _displayHeight > 0 ? (SHORT)(_displayHeight - 1) : 0;
-    r.Top = 0;
-    r.Left = 0;
-    r.Right = _displayWidth > 0 ? (SHORT)(_displayWidth - 1) : 0;
-
-    _dirtyArea = r;
-
-    area = { &_dirtyArea,
-             1 };
-
+    area = _invalidMap.runs();
     return S_OK;
 }
+CATCH_RETURN();
 
 [[nodiscard]] HRESULT BgfxEngine::GetFontSize(_Out_ COORD* const pFontSize) noexcept
 {
@@ -269,3 +292,31 @@ BgfxEngine::BgfxEngine(PVOID SharedViewBase, LONG DisplayHeight, LONG DisplayWid
 {
     return S_OK;
 }
+
+// Routine Description:
+// - Gets the run of a row that's on the screen. It's followed by the one being painted.
+PCD_IO_CHARACTER BgfxEngine::_OldRun(const ptrdiff_t row) const noexcept
+{
+    return (PCD_IO_CHARACTER)(_sharedViewBase + (row * 2 * _runLength));
+}
+
+// Routine Description:
+// - Gets the run of a row that's being painted.
+PCD_IO_CHARACTER BgfxEngine::_NewRun(const ptrdiff_t row) const noexcept
+{
+    return (PCD_IO_CHARACTER)(_sharedViewBase + (row * 2 * _runLength) + _runLength);
+}
+
+// Routine Description:
+// - Marks the rows a region covers as invalid, across the whole display,
+//   since the runs are copied and sent by the row.
+// Arguments:
+// - rect - the invalidated cells, which may extend beyond the display
+void BgfxEngine::_InvalidateRows(const til::rectangle rect)
+{
+    const auto rows = til::rectangle{ ptrdiff_t{ 0 }, rect.top(), _invalidMap.size().width(), rect.bottom() } & til::rectangle{ _invalidMap.size() };
+    if (!rows.empty())
+    {
+        _invalidMap.set(rows);
+    }
+}
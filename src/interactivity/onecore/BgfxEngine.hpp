@@ -7,6 +7,10 @@ Module Name:
 
 Abstract:
 - OneCore implementation of the IRenderEngine interface.
+- Each row of the display has two runs of characters in the view shared with
+  ConIoSrv: the one on the screen and the one being painted. Only the rows that
+  were invalidated are painted and copied over, and a frame without any is
+  skipped, instead of sending the whole screen every time.
 
 Author(s):
 - Hernan Gatta (HeGatta) 29-Mar-2017
@@ -75,12 +79,17 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _DoUpdateTitle(_In_ const std::wstring_view newTitle) noexcept override;
 
     private:
+        PCD_IO_CHARACTER _OldRun(const ptrdiff_t row) const noexcept;
+        PCD_IO_CHARACTER _NewRun(const ptrdiff_t row) const noexcept;
+        void _InvalidateRows(const til::rectangle rect);
+
         ULONG_PTR _sharedViewBase;
         SIZE_T _runLength;
 
         LONG _displayHeight;
         LONG _displayWidth;
-        til::rectangle _dirtyArea;
+        // The rows that have to be painted, always spanning the whole display.
+        til::bitmap _invalidMap;
 
         COORD _fontSize;
 
@@ -205,10 +205,24 @@ void Clipboard::StoreSelectionToClipboard(bool const copyFormatting)
     // read selection area.
     const auto selectionRects = selection.GetSelectionRects();
 
-    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-    const auto& buffer = gci.GetActiveOutputBuffer().GetTextBuffer();
-
-    const auto GetAttributeColors = std::bind(&CONSOLE_INFORMATION::LookupAttributeColors, &gci, std::placeholders::_1);
+    const auto& g = ServiceLocator::LocateGlobals();
+    const auto& gci = g.getConsoleInformation();
+    const auto& screenInfo = gci.GetActiveOutputBuffer();
+    const auto& buffer = screenInfo.GetTextBuffer();
+
+    // Only the colors are taken here. The HTML and RTF are generated from
+    // them once an application asks the clipboard for them (see RenderFormat).
+    TextBuffer::RichTextFormats richText;
+    if (copyFormatting)
+    {
+        const auto& fontData = screenInfo.GetCurrentFont();
+        richText.html = true;
+        richText.rtf = true;
+        richText.fontHeightPoints = fontData.GetUnscaledSize().Y * 72 / g.dpi;
+        richText.fontFaceName = fontData.GetFaceName();
+        richText.backgroundColor = gci.GetDefaultBackground();
+        richText.GetAttributeColors = std::bind(&CONSOLE_INFORMATION::LookupAttributeColors, &gci, std::placeholders::_1);
+    }
 
     bool includeCRLF, trimTrailingWhitespace;
     if (WI_IsFlagSet(GetKeyState(VK_SHIFT), KEY_PRESSED))
@@ -221,29 +235,23 @@ void Clipboard::StoreSelectionToClipboard(bool const copyFormatting)
         includeCRLF = trimTrailingWhitespace = true;
     }
 
-    const auto text = buffer.GetText(includeCRLF,
-                                     trimTrailingWhitespace,
-                                     selectionRects,
-                                     GetAttributeColors);
+    auto exported = buffer.ExportText(includeCRLF,
+                                      trimTrailingWhitespace,
+                                      selectionRects,
+                                      richText);
 
-    CopyTextToSystemClipboard(text, copyFormatting);
+    CopyTextToSystemClipboard(exported.text, std::move(exported.richText));
 }
 
 // Routine Description:
-// - Copies the text given onto the global system clipboard.
+// - Copies the text given onto the global system clipboard. If there are
+//   colors to go with it, HTML and RTF are put onto it as well, but they're
+//   only generated once something asks for them (see RenderFormat).
 // Arguments:
-// - rows - Rows of text data to copy
-// - fAlsoCopyFormatting - true if the color and formatting should also be copied, false otherwise
-void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, bool const fAlsoCopyFormatting)
+// - finalString - the text to copy
+// - richText - the colors of the text, or empty if they shouldn't be copied
+void Clipboard::CopyTextToSystemClipboard(const std::wstring& finalString, TextBuffer::RichText richText)
 {
-    std::wstring finalString;
-
-    // Concatenate strings into one giant string to put onto the clipboard.
-    for (const auto& str : rows.text)
-    {
-        finalString += str;
-    }
-
     // allocate the final clipboard data
     const size_t cchNeeded = finalString.size() + 1;
     const size_t cbNeeded = sizeof(wchar_t) * cchNeeded;
@@ -267,20 +275,17 @@ void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows,
             THROW_LAST_ERROR_IF(!CloseClipboard());
         });
 
+        // This makes us lose the ownership of the clipboard, which discards
+        // the colors of what was copied before (see DiscardFormats).
         THROW_LAST_ERROR_IF(!EmptyClipboard());
         THROW_LAST_ERROR_IF_NULL(SetClipboardData(CF_UNICODETEXT, globalHandle.get()));
 
-        if (fAlsoCopyFormatting)
+        if (!richText.empty())
         {
-            const auto& fontData = ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetCurrentFont();
-            int const iFontHeightPoints = fontData.GetUnscaledSize().Y * 72 / ServiceLocator::LocateGlobals().dpi;
-            const COLORREF bgColor = ServiceLocator::LocateGlobals().getConsoleInformation().GetDefaultBackground();
-
-            std::string HTMLToPlaceOnClip = TextBuffer::GenHTML(rows, iFontHeightPoints, fontData.GetFaceName(), bgColor);
-            CopyToSystemClipboard(HTMLToPlaceOnClip, L"HTML Format");
-
-            std::string RTFToPlaceOnClip = TextBuffer::GenRTF(rows, iFontHeightPoints, fontData.GetFaceName(), bgColor);
-            CopyToSystemClipboard(RTFToPlaceOnClip, L"Rich Text Format");
+            // Without any data, the formats are rendered on WM_RENDERFORMAT.
+            _pendingRichText = std::move(richText);
+            SetClipboardData(_HtmlFormat(), nullptr);
+            SetClipboardData(_RtfFormat(), nullptr);
         }
     }
 
@@ -294,8 +299,8 @@ void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows,
 // - Copies the given string onto the global system clipboard in the specified format
 // Arguments:
 // - stringToCopy - The string to copy
-// - lpszFormat - the name of the format
-void Clipboard::CopyToSystemClipboard(std::string stringToCopy, LPCWSTR lpszFormat)
+// - format - the registered clipboard format
+void Clipboard::CopyToSystemClipboard(std::string stringToCopy, const UINT format)
 {
     const size_t cbData = stringToCopy.size() + 1; // +1 for '\0'
     if (cbData)
@@ -312,10 +317,7 @@ void Clipboard::CopyToSystemClipboard(std::string stringToCopy, LPCWSTR lpszForm
         GlobalUnlock(globalHandleData.get());
         THROW_IF_FAILED(hr2);
 
-        UINT const CF_FORMAT = RegisterClipboardFormatW(lpszFormat);
-        THROW_LAST_ERROR_IF(0 == CF_FORMAT);
-
-        THROW_LAST_ERROR_IF_NULL(SetClipboardData(CF_FORMAT, globalHandleData.get()));
+        THROW_LAST_ERROR_IF_NULL(SetClipboardData(format, globalHandleData.get()));
 
         // only free if we failed.
         // the memory has to remain allocated if we successfully placed it on the clipboard.
@@ -324,6 +326,83 @@ void Clipboard::CopyToSystemClipboard(std::string stringToCopy, LPCWSTR lpszForm
     }
 }
 
+// Routine Description:
+// - Puts one of the rich text formats of what was copied last onto the
+//   clipboard, on WM_RENDERFORMAT. The clipboard is opened for us already.
+// Arguments:
+// - format - the clipboard format that's asked for
+// Return Value:
+// - <none>
+void Clipboard::RenderFormat(const UINT format)
+{
+    if (_pendingRichText.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        if (format == _HtmlFormat())
+        {
+            CopyToSystemClipboard(_pendingRichText.GenHTML(), format);
+        }
+        else if (format == _RtfFormat())
+        {
+            CopyToSystemClipboard(_pendingRichText.GenRTF(), format);
+        }
+    }
+    CATCH_LOG();
+}
+
+// Routine Description:
+// - Puts all rich text formats that weren't asked for yet onto the clipboard,
+//   on WM_RENDERALLFORMATS, so that they're still there after we exit.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Clipboard::RenderAllFormats()
+{
+    const auto hwnd = ServiceLocator::LocateConsoleWindow()->GetWindowHandle();
+    if (_pendingRichText.empty() || !OpenClipboard(hwnd))
+    {
+        return;
+    }
+
+    // Someone else might have taken the clipboard in the meantime.
+    if (GetClipboardOwner() == hwnd)
+    {
+        RenderFormat(_HtmlFormat());
+        RenderFormat(_RtfFormat());
+    }
+
+    LOG_LAST_ERROR_IF(!CloseClipboard());
+}
+
+// Routine Description:
+// - Forgets the colors of what was copied last, on WM_DESTROYCLIPBOARD,
+//   once the clipboard doesn't need them anymore.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Clipboard::DiscardFormats() noexcept
+{
+    _pendingRichText = {};
+}
+
+UINT Clipboard::_HtmlFormat() noexcept
+{
+    static const auto format = RegisterClipboardFormatW(L"HTML Format");
+    return format;
+}
+
+UINT Clipboard::_RtfFormat() noexcept
+{
+    static const auto format = RegisterClipboardFormatW(L"Rich Text Format");
+    return format;
+}
+
 // Returns true if the character should be emitted to the paste stream
 // -- in some cases, we will change what character should be emitted, as in the case of "smart quotes"
 // Returns false if the character should not be emitted (e.g. <TAB>)
@@ -34,14 +34,25 @@ namespace Microsoft::Console::Interactivity::Win32
                          const size_t cchData);
         void Paste();
 
+        void RenderFormat(const UINT format);
+        void RenderAllFormats();
+        void DiscardFormats() noexcept;
+
     private:
         std::deque<std::unique_ptr<IInputEvent>> TextToKeyEvents(_In_reads_(cchData) const wchar_t* const pData,
                                                                  const size_t cchData);
 
         void StoreSelectionToClipboard(_In_ bool const fAlsoCopyFormatting);
 
-        void CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, _In_ bool const copyFormatting);
-        void CopyToSystemClipboard(std::string stringToPlaceOnClip, LPCWSTR lpszFormat);
+        void CopyTextToSystemClipboard(const std::wstring& finalString, TextBuffer::RichText richText);
+        void CopyToSystemClipboard(std::string stringToPlaceOnClip, const UINT format);
+
+        static UINT _HtmlFormat() noexcept;
+        static UINT _RtfFormat() noexcept;
+
+        // The colors of what was copied last, while we own the clipboard and
+        // its HTML and RTF are rendered only once they're asked for.
+        TextBuffer::RichText _pendingRichText;
 
         bool FilterCharacterOnPaste(_Inout_ WCHAR* const pwch);
 
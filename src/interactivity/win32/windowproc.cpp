@@ -151,6 +151,24 @@ using namespace Microsoft::Console::Types;
         break;
     }
 
+    case WM_RENDERFORMAT:
+    {
+        Clipboard::Instance().RenderFormat(static_cast<UINT>(wParam));
+        break;
+    }
+
+    case WM_RENDERALLFORMATS:
+    {
+        Clipboard::Instance().RenderAllFormats();
+        break;
+    }
+
+    case WM_DESTROYCLIPBOARD:
+    {
+        Clipboard::Instance().DiscardFormats();
+        break;
+    }
+
     case WM_DESTROY:
     {
         // signal to uia that they can disconnect our uia provider
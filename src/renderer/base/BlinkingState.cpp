@@ -4,8 +4,10 @@
 #include "precomp.h"
 
 #include "../inc/BlinkingState.hpp"
+#include "../../buffer/out/textBuffer.hpp"
 
 using namespace Microsoft::Console::Render;
+using namespace Microsoft::Console::Types;
 
 // Method Description:
 // - Updates the flag indicating whether cells with the blinking attribute
@@ -33,7 +35,11 @@ void BlinkingState::SetBlinkingAllowed(const bool blinkingAllowed) noexcept
 // - <none>
 void BlinkingState::RecordBlinkingUsage(const TextAttribute& attr) noexcept
 {
-    _blinkingIsInUse = _blinkingIsInUse || attr.IsBlinking();
+    // The engines may be painting at the same time, so this is recorded atomically.
+    if (attr.IsBlinking())
+    {
+        _blinkingIsInUse.store(true, std::memory_order_relaxed);
+    }
 }
 
 // Method Description:
@@ -51,12 +57,16 @@ bool BlinkingState::IsBlinkingFaint() const noexcept
 // Method Description:
 // - Increments the position in the blinking cycle, toggling the blinking
 //   rendition state on every second call, potentially triggering a redraw of
-//   the given render target if there are blinking cells currently in view.
+//   the rows of the given render target which have blinking cells in view.
 // Arguments:
 // - renderTarget: the render target that will be redrawn.
+// - buffer: the text buffer that's being rendered.
+// - viewport: the part of the buffer that's in view.
 // Return Value:
 // - <none>
-void BlinkingState::ToggleBlinkingRendition(IRenderTarget& renderTarget) noexcept
+void BlinkingState::ToggleBlinkingRendition(IRenderTarget& renderTarget,
+                                            const TextBuffer& buffer,
+                                            const Viewport& viewport) noexcept
 try
 {
     if (_blinkingAllowed)
@@ -69,12 +79,32 @@ try
         _blinkingShouldBeFaint = _blinkingCycle >= 2;
         // Every two cycles (when the state changes), we need to trigger a
         // redraw, but only if there are actually blinking attributes in use.
-        if (_blinkingIsInUse && _blinkingCycle % 2 == 0)
+        if (_blinkingIsInUse.load(std::memory_order_relaxed) && _blinkingCycle % 2 == 0)
         {
             // We reset the _blinkingIsInUse flag before redrawing, so we can
             // get a fresh assessment of the current blinking attribute usage.
-            _blinkingIsInUse = false;
-            renderTarget.TriggerRedrawAll();
+            _blinkingIsInUse.store(false, std::memory_order_relaxed);
+
+            // The rows track whether they have blinking text as they're written
+            // to, so only those are redrawn, each span of adjacent ones at once.
+            const auto width = buffer.GetSize().Width();
+            const auto bottom = std::min(viewport.BottomExclusive(), buffer.GetSize().BottomExclusive());
+            auto y = std::max<SHORT>(viewport.Top(), 0);
+            while (y < bottom)
+            {
+                if (!buffer.GetRowByOffset(y).GetAttrRow().HasBlinking())
+                {
+                    ++y;
+                    continue;
+                }
+
+                const auto top = y;
+                while (y < bottom && buffer.GetRowByOffset(y).GetAttrRow().HasBlinking())
+                {
+                    ++y;
+                }
+                renderTarget.TriggerRedraw(Viewport::FromExclusive({ 0, top, width, y }));
+            }
         }
     }
 }
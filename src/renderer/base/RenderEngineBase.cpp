@@ -41,6 +41,37 @@ HRESULT RenderEngineBase::PrepareRenderInfo(const RenderFrameInfo& /*info*/) noe
     return S_FALSE;
 }
 
+// Method Description:
+// - By default, engines don't draw images. The text under them is all there is.
+// Arguments:
+// - image - the image to draw
+// - origin - the cell of the top left corner of the image, on the screen
+// - clip - the cells of the screen that are drawn in this frame
+// Return Value:
+// - S_FALSE since we do nothing.
+HRESULT RenderEngineBase::PaintImage(const std::shared_ptr<const ImageStore::Image>& /*image*/,
+                                     const til::point /*origin*/,
+                                     const til::rectangle /*clip*/) noexcept
+{
+    return S_FALSE;
+}
+
+// Method Description:
+// - Hands over a line that's about to scroll into view, so that the engine can prepare
+//   for painting it. By default, engines paint every line from scratch.
+// Arguments:
+// - clusters - the text of the line and the columns it takes up
+// - coord - where the line would be painted, relative to the screen
+// - textAttributes - the attributes the line is painted with
+// Return Value:
+// - S_FALSE since we do nothing.
+HRESULT RenderEngineBase::PrefetchBufferLine(gsl::span<const Cluster> const /*clusters*/,
+                                             const COORD /*coord*/,
+                                             const TextAttribute& /*textAttributes*/) noexcept
+{
+    return S_FALSE;
+}
+
 HRESULT RenderEngineBase::ResetLineTransform() noexcept
 {
     return S_FALSE;
@@ -63,9 +94,29 @@ HRESULT RenderEngineBase::PrepareLineTransform(const LineRendition /*lineRenditi
     return false;
 }
 
+// Method Description:
+// - Gets the time to wait between the frames of a continuous redraw.
+// Return Value:
+// - Zero to redraw at the next opportunity, which is the default.
+[[nodiscard]] std::chrono::milliseconds RenderEngineBase::GetContinuousRedrawInterval() noexcept
+{
+    return std::chrono::milliseconds::zero();
+}
+
 // Method Description:
 // - Blocks until the engine is able to render without blocking.
-void RenderEngineBase::WaitUntilCanRender() noexcept
+// Return Value:
+// - True if the wait was paced by the display. False if the engine has no
+//   way to do so, in which case the render thread limits the frame rate itself.
+[[nodiscard]] bool RenderEngineBase::WaitUntilCanRender() noexcept
 {
     // do nothing by default
+    return false;
+}
+
+// Method Description:
+// - Gives back the memory the engine only keeps around to paint the next
+//   frames faster, once the renderer went idle. By default, there's none.
+void RenderEngineBase::Trim() noexcept
+{
 }
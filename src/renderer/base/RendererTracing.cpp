@@ -0,0 +1,118 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "RendererTracing.hpp"
+
+#pragma warning(suppress : 26477) // We don't control tracelogging macros
+TRACELOGGING_DEFINE_PROVIDER(g_hConsoleRendererTraceProvider,
+                             "Microsoft.Windows.Console.Render",
+                             // tl:{41a35baf-cd55-5e23-782b-7323338b5283}
+                             (0x41a35baf, 0xcd55, 0x5e23, 0x78, 0x2b, 0x73, 0x23, 0x33, 0x8b, 0x52, 0x83), );
+
+using namespace Microsoft::Console::Render;
+
+// Every renderer of the process shares the one provider, which may only be registered once.
+std::atomic<size_t> RendererTracing::s_registrations{ 0 };
+
+RendererTracing::RendererTracing() noexcept
+{
+#ifndef UNIT_TESTING
+    if (s_registrations.fetch_add(1) == 0)
+    {
+        TraceLoggingRegister(g_hConsoleRendererTraceProvider);
+    }
+#endif UNIT_TESTING
+}
+
+RendererTracing::~RendererTracing()
+{
+#ifndef UNIT_TESTING
+    if (s_registrations.fetch_sub(1) == 1)
+    {
+        TraceLoggingUnregister(g_hConsoleRendererTraceProvider);
+    }
+#endif UNIT_TESTING
+}
+
+// Routine Description:
+// - Checks whether anyone is listening for the frame events, so that
+//   counting what was painted can be skipped otherwise.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if TracePaintFrame would write an event.
+bool RendererTracing::IsEnabled() const noexcept
+{
+#ifndef UNIT_TESTING
+    return TraceLoggingProviderEnabled(g_hConsoleRendererTraceProvider, WINEVENT_LEVEL_VERBOSE, TIL_KEYWORD_TRACE);
+#else
+    return false;
+#endif UNIT_TESTING
+}
+
+// Routine Description:
+// - Writes how long the stages of a frame took for an engine, in microseconds.
+//   The lock wait and gather times are shared by all engines of the frame.
+// Arguments:
+// - stats - the timings and counts of the frame
+// Return Value:
+// - <none>
+void RendererTracing::TracePaintFrame(const RenderFrameStats& stats) const noexcept
+{
+#ifndef UNIT_TESTING
+    if (IsEnabled())
+    {
+        const auto us = [](const std::chrono::steady_clock::duration d) noexcept {
+            return gsl::narrow_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+        };
+
+#pragma warning(suppress : 26477 26485 26494 26482 26446 26447) // We don't control TraceLoggingWrite
+        TraceLoggingWrite(g_hConsoleRendererTraceProvider,
+                          "Renderer_PaintFrame",
+                          TraceLoggingUInt64(stats.engineIndex, "Engine"),
+                          TraceLoggingUInt64(us(stats.lockWait), "LockWaitUs"),
+                          TraceLoggingUInt64(us(stats.gather), "GatherUs"),
+                          TraceLoggingUInt64(us(stats.background), "BackgroundUs"),
+                          TraceLoggingUInt64(us(stats.bufferOutput), "BufferOutputUs"),
+                          TraceLoggingUInt64(us(stats.selection), "SelectionUs"),
+                          TraceLoggingUInt64(us(stats.cursor), "CursorUs"),
+                          TraceLoggingUInt64(us(stats.present), "PresentUs"),
+                          TraceLoggingUInt64(stats.dirtyRows, "DirtyRows"),
+                          TraceLoggingUInt64(stats.runs, "Runs"),
+                          TraceLoggingUInt64(stats.clusters, "Clusters"),
+                          TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                          TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+    }
+#else
+    UNREFERENCED_PARAMETER(stats);
+#endif UNIT_TESTING
+}
+
+// Routine Description:
+// - Writes how long it took from a keystroke until a frame with its echo was
+//   presented, in microseconds. The sequence numbers count the keystrokes, so
+//   that the ones whose echo was presented along with a later one can be told.
+// Arguments:
+// - sequence - the number of the keystroke
+// - latency - the time from the keystroke until the end of presenting the frame
+// Return Value:
+// - <none>
+void RendererTracing::TraceInputLatency(const uint64_t sequence, const std::chrono::steady_clock::duration latency) const noexcept
+{
+#ifndef UNIT_TESTING
+    if (IsEnabled())
+    {
+#pragma warning(suppress : 26477 26485 26494 26482 26446 26447) // We don't control TraceLoggingWrite
+        TraceLoggingWrite(g_hConsoleRendererTraceProvider,
+                          "Renderer_InputLatency",
+                          TraceLoggingUInt64(sequence, "Sequence"),
+                          TraceLoggingUInt64(gsl::narrow_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count()), "LatencyUs"),
+                          TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                          TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+    }
+#else
+    UNREFERENCED_PARAMETER(sequence);
+    UNREFERENCED_PARAMETER(latency);
+#endif UNIT_TESTING
+}
@@ -0,0 +1,60 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- RendererTracing.hpp
+
+Abstract:
+- This module records how long each stage of painting a frame took to ETW,
+  along with how much there was to paint, so that a slow frame can be pinned
+  on waiting for the console lock, on walking the buffer or on the engine.
+- It also records how long it took from a keystroke until its echo was presented.
+--*/
+
+#pragma once
+
+#include <winmeta.h>
+#include <TraceLoggingProvider.h>
+
+TRACELOGGING_DECLARE_PROVIDER(g_hConsoleRendererTraceProvider);
+
+namespace Microsoft::Console::Render
+{
+    // What painting a frame took for one engine.
+    struct RenderFrameStats
+    {
+        size_t engineIndex = 0;
+
+        std::chrono::steady_clock::duration lockWait{};
+        std::chrono::steady_clock::duration gather{};
+        std::chrono::steady_clock::duration background{};
+        std::chrono::steady_clock::duration bufferOutput{};
+        std::chrono::steady_clock::duration selection{};
+        std::chrono::steady_clock::duration cursor{};
+        std::chrono::steady_clock::duration present{};
+
+        size_t dirtyRows = 0;
+        size_t runs = 0;
+        size_t clusters = 0;
+    };
+
+    class RendererTracing final
+    {
+    public:
+        RendererTracing() noexcept;
+        ~RendererTracing();
+
+        RendererTracing(const RendererTracing&) = delete;
+        RendererTracing(RendererTracing&&) = delete;
+        RendererTracing& operator=(const RendererTracing&) = delete;
+        RendererTracing& operator=(RendererTracing&&) = delete;
+
+        bool IsEnabled() const noexcept;
+        void TracePaintFrame(const RenderFrameStats& stats) const noexcept;
+        void TraceInputLatency(const uint64_t sequence, const std::chrono::steady_clock::duration latency) const noexcept;
+
+    private:
+        static std::atomic<size_t> s_registrations;
+    };
+}
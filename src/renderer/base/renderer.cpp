@@ -31,7 +31,7 @@ Renderer::Renderer(IRenderData* pData,
     _pData(THROW_HR_IF_NULL(E_INVALIDARG, pData)),
     _pThread{ std::move(thread) },
     _destructing{ false },
-    _clusterBuffer{},
+    _clusterBuffers{},
     _viewport{ pData->GetViewport() }
 {
     for (size_t i = 0; i < cEngines; i++)
@@ -67,125 +67,449 @@ Renderer::~Renderer()
         return S_FALSE;
     }
 
-    for (IRenderEngine* const pEngine : _rgpEngines)
+    if (_IsSynchronizedOutputPending())
+    {
+        // Leave the invalidated regions where they are, so that they're all
+        // painted as a single frame once the update is complete. The thread
+        // comes back for another try after its frame delay.
+        _NotifyPaintFrame();
+        return S_FALSE;
+    }
+
+    const std::vector<IRenderEngine*> engines{ _rgpEngines.begin(), _rgpEngines.end() };
+    std::vector<HRESULT> results(engines.size());
+    _PaintFrameForEngines(engines, results);
+
+    // Engines that weren't ready are given a few more tries on their own.
+    for (size_t i = 0; i < engines.size(); i++)
     {
+        auto hr = til::at(results, i);
         auto tries = maxRetriesForRenderEngine;
-        while (tries > 0)
+        while (E_PENDING == hr)
         {
-            if (_destructing)
+            if (--tries == 0)
             {
+                // Stop trying.
+                if (_pThread)
+                {
+                    _pThread->DisablePainting();
+                }
+                if (_pfnRendererEnteredErrorState)
+                {
+                    _pfnRendererEnteredErrorState();
+                }
+                // If there's no callback, we still don't want to FAIL_FAST: the renderer going black
+                // isn't near as bad as the entire application aborting. We're a component. We shouldn't
+                // abort applications that host us.
                 return S_FALSE;
             }
+            // Add a bit of backoff.
+            // Sleep 150ms, 300ms, 450ms before failing out and disabling the renderer.
+            Sleep(renderBackoffBaseTimeMilliseconds * (maxRetriesForRenderEngine - tries));
 
-            const auto hr = _PaintFrameForEngine(pEngine);
-            if (E_PENDING == hr)
+            if (_destructing)
             {
-                if (--tries == 0)
-                {
-                    // Stop trying.
-                    _pThread->DisablePainting();
-                    if (_pfnRendererEnteredErrorState)
-                    {
-                        _pfnRendererEnteredErrorState();
-                    }
-                    // If there's no callback, we still don't want to FAIL_FAST: the renderer going black
-                    // isn't near as bad as the entire application aborting. We're a component. We shouldn't
-                    // abort applications that host us.
-                    return S_FALSE;
-                }
-                // Add a bit of backoff.
-                // Sleep 150ms, 300ms, 450ms before failing out and disabling the renderer.
-                Sleep(renderBackoffBaseTimeMilliseconds * (maxRetriesForRenderEngine - tries));
-                continue;
+                return S_FALSE;
             }
-            LOG_IF_FAILED(hr);
-            break;
+
+            hr = _PaintFrameForEngine(til::at(engines, i));
         }
+        LOG_IF_FAILED(hr);
+    }
+
+    if (_pfnFramePainted)
+    {
+        _pfnFramePainted();
     }
 
     return S_OK;
 }
 
 [[nodiscard]] HRESULT Renderer::_PaintFrameForEngine(_In_ IRenderEngine* const pEngine) noexcept
-try
 {
-    FAIL_FAST_IF_NULL(pEngine); // This is a programming error. Fail fast.
+    HRESULT hr = S_OK;
+    _PaintFrameForEngines({ &pEngine, 1 }, { &hr, 1 });
+    return hr;
+}
 
-    _pData->LockConsole();
-    auto unlock = wil::scope_exit([&]() {
-        _pData->UnlockConsole();
+// Routine Description:
+// - Paints a frame for each of the given engines.
+// - What the engines paint is gathered once while the console is locked: the runs of
+//   the dirty rows, the cursor, the selection and so on. The engines then paint it at
+//   the same time, each on its own worker, so the lock is held for as long as the
+//   slowest engine takes instead of for all of them in turn.
+// - The engines still rely on the lock for their own state and resolve the colors
+//   of the runs through the render data, so it isn't released before they're done.
+//   That's also why the rows aren't read from a TextBufferSnapshot here: releasing
+//   the lock after copying them wouldn't let the engines paint without it.
+// Arguments:
+// - engines - the engines to paint
+// - results - receives the result of each engine
+// Return Value:
+// - <none>
+void Renderer::_PaintFrameForEngines(const gsl::span<IRenderEngine* const> engines, const gsl::span<HRESULT> results) noexcept
+{
+    // The arena is declared before the containers of the frame, so they're gone when it's reset.
+    const auto ownsArena = !_frameArenaInUse.exchange(true, std::memory_order_acquire);
+    const auto resource = ownsArena ? static_cast<std::pmr::memory_resource*>(&_frameArena) : til::pmr::get_default_resource();
+    auto resetArena = wil::scope_exit([&]() noexcept {
+        if (ownsArena)
+        {
+            _frameArena.reset();
+            _frameArenaInUse.store(false, std::memory_order_release);
+        }
     });
 
-    // Last chance check if anything scrolled without an explicit invalidate notification since the last frame.
-    _CheckViewportAndScroll();
-
-    // Try to start painting a frame
-    HRESULT const hr = pEngine->StartPaint();
-    RETURN_IF_FAILED(hr);
+    std::pmr::vector<_EngineFrame> engineFrames{ resource };
 
-    // Return early if there's nothing to paint.
-    // The renderer itself tracks if there's something to do with the title, the
-    //      engine won't know that.
-    if (S_FALSE == hr)
+    try
     {
-        return S_OK;
-    }
+        const auto lockStart = std::chrono::steady_clock::now();
+        _pData->LockConsoleShared();
+        auto unlock = wil::scope_exit([&]() {
+            _pData->UnlockConsoleShared();
+        });
+        const auto gatherStart = std::chrono::steady_clock::now();
 
-    auto endPaint = wil::scope_exit([&]() {
-        LOG_IF_FAILED(pEngine->EndPaint());
+        // An engine that started painting has to end it, even if gathering the frame fails.
+        auto endPaint = wil::scope_exit([&]() {
+            for (auto& engineFrame : engineFrames)
+            {
+                _EndPaint(engineFrame);
+            }
+        });
 
-        // If the engine tells us it really wants to redraw immediately,
-        // tell the thread so it doesn't go to sleep and ticks again
-        // at the next opportunity.
-        if (pEngine->RequiresContinuousRedraw())
+        // Last chance check if anything scrolled without an explicit invalidate notification since the last frame.
+        _CheckViewportAndScroll();
+
+        engineFrames.reserve(engines.size());
+        for (size_t i = 0; i < engines.size(); i++)
         {
-            _NotifyPaintFrame();
+            const auto pEngine = til::at(engines, i);
+            FAIL_FAST_IF_NULL(pEngine); // This is a programming error. Fail fast.
+
+            // Try to start painting a frame
+            const HRESULT hr = pEngine->StartPaint();
+            til::at(results, i) = hr;
+
+            // Skip the engine if there's nothing to paint.
+            // The renderer itself tracks if there's something to do with the title, the
+            //      engine won't know that.
+            if (S_FALSE == hr)
+            {
+                til::at(results, i) = S_OK;
+            }
+            else if (SUCCEEDED(hr))
+            {
+                engineFrames.emplace_back(pEngine, i, &_clusterBuffers[pEngine], resource);
+            }
         }
-    });
 
-    // A. Prep Colors
-    RETURN_IF_FAILED(_UpdateDrawingBrushes(pEngine, _pData->GetDefaultBrushColors(), true));
+        const auto frame = _GatherFrame(resource);
+        for (auto& engineFrame : engineFrames)
+        {
+            auto& result = til::at(results, engineFrame.index);
+            const auto pEngine = engineFrame.engine;
 
-    // B. Perform Scroll Operations
-    RETURN_IF_FAILED(_PerformScrolling(pEngine));
+            // A. Prep Colors
+            result = _UpdateDrawingBrushes(pEngine, frame.defaultBrushColors, true);
+
+            // B. Perform Scroll Operations
+            // This moves the dirty area of the engine along, so it's only known after this.
+            if (SUCCEEDED(result))
+            {
+                result = _PerformScrolling(pEngine);
+            }
+
+            if (SUCCEEDED(result))
+            {
+                _GatherBufferOutput(frame, engineFrame);
+                _GatherOverlays(frame, engineFrame);
+            }
+            else
+            {
+                _EndPaint(engineFrame);
+            }
+        }
+
+        // The frame is painted all the same if this fails.
+        try
+        {
+            _PrefetchRows(frame, engineFrames);
+        }
+        CATCH_LOG();
+
+        const auto gatherEnd = std::chrono::steady_clock::now();
+
+        // The first engine is painted right here, the others on workers.
+        // The futures wait for their task to finish when they go away.
+        std::pmr::vector<std::future<void>> tasks{ resource };
+        for (size_t i = 1; i < engineFrames.size(); i++)
+        {
+            auto& engineFrame = til::at(engineFrames, i);
+            if (!engineFrame.ended)
+            {
+                tasks.emplace_back(std::async(std::launch::async, [&]() noexcept {
+                    til::at(results, engineFrame.index) = _PaintEngineFrame(frame, engineFrame);
+                }));
+            }
+        }
+        if (!engineFrames.empty() && !engineFrames.front().ended)
+        {
+            til::at(results, engineFrames.front().index) = _PaintEngineFrame(frame, engineFrames.front());
+        }
+        for (auto& task : tasks)
+        {
+            task.wait();
+        }
+
+        endPaint.reset();
+
+        // Force scope exit unlock to let go of global lock so other threads can run
+        unlock.reset();
+
+        // Trigger out-of-lock presentation for renderers that can support it
+        for (auto& engineFrame : engineFrames)
+        {
+            auto& result = til::at(results, engineFrame.index);
+            if (SUCCEEDED(result))
+            {
+                const auto presentStart = std::chrono::steady_clock::now();
+                result = engineFrame.engine->Present();
+                engineFrame.stats.present = std::chrono::steady_clock::now() - presentStart;
+            }
+        }
+
+        // The echo of a keystroke is reported with the first frame that presented it.
+        if (frame.inputEcho.sequence > _presentedInputSequence.load(std::memory_order_relaxed) &&
+            std::any_of(engineFrames.begin(), engineFrames.end(), [&](const auto& engineFrame) { return SUCCEEDED(til::at(results, engineFrame.index)); }))
+        {
+            _presentedInputSequence.store(frame.inputEcho.sequence, std::memory_order_relaxed);
+            _tracing.TraceInputLatency(frame.inputEcho.sequence, std::chrono::steady_clock::now() - frame.inputEcho.time);
+        }
+
+        _TraceFrame(engineFrames, gatherStart - lockStart, gatherEnd - gatherStart);
+
+        if (!engineFrames.empty())
+        {
+            using std::chrono::duration_cast;
+            using std::chrono::nanoseconds;
+            _statFrames.fetch_add(1, std::memory_order_relaxed);
+            _statFrameTime.fetch_add(duration_cast<nanoseconds>(std::chrono::steady_clock::now() - lockStart).count(), std::memory_order_relaxed);
+            _statLockWait.fetch_add(duration_cast<nanoseconds>(gatherStart - lockStart).count(), std::memory_order_relaxed);
+        }
+    }
+    catch (...)
+    {
+        const auto hr = wil::ResultFromCaughtException();
+        for (auto& result : results)
+        {
+            if (SUCCEEDED(result))
+            {
+                result = hr;
+            }
+        }
+    }
+}
+
+// Routine Description:
+// - Gathers what all engines paint in this frame, apart from the rows of the buffer.
+// Arguments:
+// - resource - allocates the containers of the frame
+// Return Value:
+// - The frame.
+[[nodiscard]] Renderer::_RenderFrame Renderer::_GatherFrame(std::pmr::memory_resource* resource)
+{
+    _frameCount++;
+
+    _RenderFrame frame{ resource };
+    frame.view = _GetPaintedViewport();
+    frame.defaultBrushColors = _pData->GetDefaultBrushColors();
+    frame.cursorInfo = _GetCursorInfo();
+    frame.selection = _GetSelectionRects(resource);
+    frame.searchHighlights = _ToViewportRects(_pData->GetSearchHighlights(), resource);
+    frame.title = _pData->GetConsoleTitle();
+    frame.gridLinesAllowed = _pData->IsGridLineDrawingAllowed();
+    frame.globalInvert = _pData->IsScreenReversed();
+    frame.patternGeneration = _pData->GetPatternGeneration();
+    frame.inputEcho = _pData->GetInputEcho();
+
+    // The generations of the rows are only meaningful within one buffer. If we're looking at
+    // another buffer now, or the buffer was replaced by one with a younger clock, start over.
+    // The rows of the engines point into the cache, so it must not be resized past this point.
+    const auto& buffer = _pData->GetTextBuffer();
+    if (&buffer != _rowRenderCacheBuffer || buffer.GetGeneration() < _rowRenderCacheGeneration)
+    {
+        _rowRenderCache.clear();
+        _rowRenderCacheBuffer = &buffer;
+    }
+    _rowRenderCacheGeneration = buffer.GetGeneration();
+    _rowRenderCache.resize(std::max<size_t>(_rowRenderCache.size(), frame.view.Height()));
+
+    // The images only hold on to their pixels, which the engines keep their own copies of.
+    const auto& images = buffer.GetImages();
+    if (!images.empty())
+    {
+        const auto circledRows = buffer.GetCircledRows();
+        const auto top = circledRows + gsl::narrow_cast<uint64_t>(std::max<SHORT>(frame.view.Top(), 0));
+        const auto bottom = circledRows + gsl::narrow_cast<uint64_t>(std::max<SHORT>(frame.view.BottomExclusive(), 0));
+        images.ForEach(top, bottom, [&](const ImageStore::Placement& placement) {
+            const til::point origin{ placement.column - frame.view.Left(),
+                                     gsl::narrow_cast<ptrdiff_t>(placement.row - circledRows) - frame.view.Top() };
+            frame.images.push_back({ placement.image, origin });
+        });
+    }
+
+    return frame;
+}
+
+// Routine Description:
+// - Paints everything but the scrolling for an engine, which has already been done.
+// Arguments:
+// - frame - what all engines paint
+// - engineFrame - what this engine paints
+// Return Value:
+// - S_OK or the first error of the engine.
+[[nodiscard]] HRESULT Renderer::_PaintEngineFrame(const _RenderFrame& frame, _EngineFrame& engineFrame) noexcept
+try
+{
+    const auto pEngine = engineFrame.engine;
+
+    auto endPaint = wil::scope_exit([&]() {
+        _EndPaint(engineFrame);
+    });
+
+    auto stageStart = std::chrono::steady_clock::now();
+    const auto endStage = [&](std::chrono::steady_clock::duration& stage) noexcept {
+        const auto now = std::chrono::steady_clock::now();
+        stage = now - stageStart;
+        stageStart = now;
+    };
 
     // C. Prepare the engine with additional information before we start drawing.
-    RETURN_IF_FAILED(_PrepareRenderInfo(pEngine));
+    RETURN_IF_FAILED(_PrepareRenderInfo(pEngine, frame));
 
     // 1. Paint Background
     RETURN_IF_FAILED(_PaintBackground(pEngine));
+    endStage(engineFrame.stats.background);
 
     // 2. Paint Rows of Text
-    _PaintBufferOutput(pEngine);
+    _PaintBufferOutput(frame, engineFrame);
 
-    // 3. Paint overlays that reside above the text buffer
-    _PaintOverlays(pEngine);
+    // 3. Paint the images over the text, and the overlays that reside above both
+    _PaintImages(frame, engineFrame);
+    _PaintOverlays(frame, engineFrame);
+    endStage(engineFrame.stats.bufferOutput);
 
     // 4. Paint Selection
-    _PaintSelection(pEngine);
+    _PaintSelection(pEngine, frame);
+    endStage(engineFrame.stats.selection);
 
     // 5. Paint Cursor
-    _PaintCursor(pEngine);
+    _PaintCursor(pEngine, frame);
+    endStage(engineFrame.stats.cursor);
 
     // 6. Paint window title
-    RETURN_IF_FAILED(_PaintTitle(pEngine));
+    RETURN_IF_FAILED(_PaintTitle(pEngine, frame));
 
-    // Force scope exit end paint to finish up collecting information and possibly painting
-    endPaint.reset();
+    return S_OK;
+}
+CATCH_RETURN()
 
-    // Force scope exit unlock to let go of global lock so other threads can run
-    unlock.reset();
+// Routine Description:
+// - Finishes the frame of an engine, unless that already happened.
+// Arguments:
+// - engineFrame - the frame to finish
+// Return Value:
+// - <none>
+void Renderer::_EndPaint(_EngineFrame& engineFrame) noexcept
+{
+    if (engineFrame.ended)
+    {
+        return;
+    }
+    engineFrame.ended = true;
 
-    // Trigger out-of-lock presentation for renderers that can support it
-    RETURN_IF_FAILED(pEngine->Present());
+    LOG_IF_FAILED(engineFrame.engine->EndPaint());
 
-    // As we leave the scope, EndPaint will be called (declared above)
-    return S_OK;
+    // If the engine tells us it really wants to redraw immediately,
+    // tell the thread so it doesn't go to sleep and ticks again
+    // at the next opportunity, or once the engine's interval has passed.
+    if (engineFrame.engine->RequiresContinuousRedraw())
+    {
+        const auto interval = engineFrame.engine->GetContinuousRedrawInterval();
+        if (interval > std::chrono::milliseconds::zero())
+        {
+            // If we're running in the unittests, we might not have a render thread.
+            if (_pThread)
+            {
+                _pThread->NotifyPaintAfter(interval);
+            }
+        }
+        else
+        {
+            _NotifyPaintFrame();
+        }
+    }
+}
+
+// Routine Description:
+// - Writes the timings of the frame of each engine to ETW, if anyone's listening.
+// Arguments:
+// - engineFrames - the frames of the engines that were painted
+// - lockWait - how long it took to acquire the console lock
+// - gather - how long it took to gather the frame, including the scrolling of the engines
+// Return Value:
+// - <none>
+void Renderer::_TraceFrame(gsl::span<_EngineFrame> engineFrames,
+                           const std::chrono::steady_clock::duration lockWait,
+                           const std::chrono::steady_clock::duration gather) const noexcept
+{
+    if (!_tracing.IsEnabled())
+    {
+        return;
+    }
+
+    for (auto& engineFrame : engineFrames)
+    {
+        auto& stats = engineFrame.stats;
+        stats.engineIndex = engineFrame.index;
+        stats.lockWait = lockWait;
+        stats.gather = gather;
+        stats.dirtyRows = engineFrame.rows.size();
+        for (const auto& row : engineFrame.rows)
+        {
+            stats.runs += row.runs->runs.size();
+            for (const auto& run : row.runs->runs)
+            {
+                stats.clusters += run.clusterCount;
+            }
+        }
+        _tracing.TracePaintFrame(stats);
+    }
+}
+
+// Routine Description:
+// - Returns how many frames were painted so far and how long they took, along
+//   with how often one was asked for. Can be called from any thread.
+// Arguments:
+// - <none>
+// Return Value:
+// - The totals since the renderer was created.
+RenderStatistics Renderer::GetStatistics() const noexcept
+{
+    RenderStatistics statistics;
+    statistics.frames = _statFrames.load(std::memory_order_relaxed);
+    statistics.paintRequests = _statPaintRequests.load(std::memory_order_relaxed);
+    statistics.frameTime = std::chrono::nanoseconds{ _statFrameTime.load(std::memory_order_relaxed) };
+    statistics.lockWait = std::chrono::nanoseconds{ _statLockWait.load(std::memory_order_relaxed) };
+    return statistics;
 }
-CATCH_RETURN()
 
 void Renderer::_NotifyPaintFrame()
 {
+    _statPaintRequests.fetch_add(1, std::memory_order_relaxed);
+
     // If we're running in the unittests, we might not have a render thread.
     if (_pThread)
     {
@@ -280,7 +604,7 @@ void Renderer::TriggerRedrawCursor(const COORD* const pcoord)
 
         // The region is clamped within the viewport boundaries and we only
         // trigger a redraw if the region is not empty.
-        Viewport view = _pData->GetViewport();
+        Viewport view = _GetPaintedViewport();
         cursorView = view.Clamp(cursorView);
 
         if (cursorView.IsValid())
@@ -322,7 +646,11 @@ void Renderer::TriggerRedrawAll()
 void Renderer::TriggerTeardown() noexcept
 {
     // We need to shut down the paint thread on teardown.
-    _pThread->WaitForPaintCompletionAndDisable(INFINITE);
+    // There's none in the unittests and in conpty's renderless mode.
+    if (_pThread)
+    {
+        _pThread->WaitForPaintCompletionAndDisable(INFINITE);
+    }
 
     // Then walk through and do one final paint on the caller's thread.
     for (IRenderEngine* const pEngine : _rgpEngines)
@@ -349,29 +677,46 @@ void Renderer::TriggerSelection()
     try
     {
         // Get selection rectangles
-        const auto rects = _GetSelectionRects();
-
-        // Restrict all previous selection rectangles to inside the current viewport bounds
-        for (auto& sr : _previousSelection)
+        const auto resource = til::pmr::get_default_resource();
+        const auto rects = _GetSelectionRects(resource);
+
+        // Only the rows whose part of the selection changed need to be redrawn.
+        // While dragging out a selection, that's usually just the last one or two.
+        // The rectangles are one per row, so sorted by row nearly everything matches up.
+        std::pmr::vector<SMALL_RECT> previous{ _previousSelection, resource };
+        std::pmr::vector<SMALL_RECT> current{ rects, resource };
+        std::sort(previous.begin(), previous.end(), s_IsSmallRectBefore);
+        std::sort(current.begin(), current.end(), s_IsSmallRectBefore);
+        std::vector<SMALL_RECT> changed;
+        std::set_symmetric_difference(previous.begin(), previous.end(), current.begin(), current.end(), std::back_inserter(changed), s_IsSmallRectBefore);
+
+        if (!changed.empty())
         {
-            // Make the exclusive SMALL_RECT into a til::rectangle.
-            til::rectangle rc{ Viewport::FromExclusive(sr).ToInclusive() };
-
             // Make a viewport representing the coordinates that are currently presentable.
-            const til::rectangle viewport{ til::size{ _pData->GetViewport().Dimensions() } };
+            const til::rectangle viewport{ til::size{ _GetPaintedViewport().Dimensions() } };
 
-            // Intersect them so we only invalidate things that are still visible.
-            rc &= viewport;
+            // Restrict the changed rectangles to inside the current viewport bounds,
+            // so we only invalidate things that are still visible.
+            std::vector<SMALL_RECT> visible;
+            for (const auto& sr : changed)
+            {
+                // Make the exclusive SMALL_RECT into a til::rectangle and intersect it with the viewport.
+                til::rectangle rc{ Viewport::FromExclusive(sr).ToInclusive() };
+                rc &= viewport;
+                if (!rc.empty())
+                {
+                    // Convert back into the exclusive SMALL_RECT and store in the vector.
+                    visible.emplace_back(Viewport::FromInclusive(rc).ToExclusive());
+                }
+            }
 
-            // Convert back into the exclusive SMALL_RECT and store in the vector.
-            sr = Viewport::FromInclusive(rc).ToExclusive();
+            // The engines are told even if none of the change is visible, as the
+            // selection still changed for anyone who's not just painting it.
+            std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+                LOG_IF_FAILED(pEngine->InvalidateSelection(visible));
+            });
         }
 
-        std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
-            LOG_IF_FAILED(pEngine->InvalidateSelection(_previousSelection));
-            LOG_IF_FAILED(pEngine->InvalidateSelection(rects));
-        });
-
         _previousSelection = rects;
 
         _NotifyPaintFrame();
@@ -379,6 +724,17 @@ void Renderer::TriggerSelection()
     CATCH_LOG();
 }
 
+// Routine Description:
+// - Orders selection rectangles by row, then by column.
+// Arguments:
+// - a, b - the rectangles to compare
+// Return Value:
+// - true if a comes before b
+bool Renderer::s_IsSmallRectBefore(const SMALL_RECT& a, const SMALL_RECT& b) noexcept
+{
+    return std::tie(a.Top, a.Left, a.Bottom, a.Right) < std::tie(b.Top, b.Left, b.Bottom, b.Right);
+}
+
 // Routine Description:
 // - Called when we want to check if the viewport has moved and scroll accordingly if so.
 // Arguments:
@@ -388,7 +744,7 @@ void Renderer::TriggerSelection()
 bool Renderer::_CheckViewportAndScroll()
 {
     SMALL_RECT const srOldViewport = _viewport.ToInclusive();
-    SMALL_RECT const srNewViewport = _pData->GetViewport().ToInclusive();
+    SMALL_RECT const srNewViewport = _GetPaintedViewport().ToInclusive();
 
     COORD coordDelta;
     coordDelta.X = srOldViewport.Left - srNewViewport.Left;
@@ -405,7 +761,10 @@ bool Renderer::_CheckViewportAndScroll()
     // so they can prepare the buffers for changes to either preallocate memory at once
     // (instead of growing naturally) or shrink down to reduce usage as appropriate.
     const size_t lineLength = gsl::narrow_cast<size_t>(til::rectangle{ srNewViewport }.width());
-    til::manage_vector(_clusterBuffer, lineLength, _shrinkThreshold);
+    for (auto& entry : _clusterBuffers)
+    {
+        til::manage_vector(entry.second, lineLength, _shrinkThreshold);
+    }
 
     if (coordDelta.X != 0 || coordDelta.Y != 0)
     {
@@ -414,6 +773,8 @@ bool Renderer::_CheckViewportAndScroll()
             LOG_IF_FAILED(engine->InvalidateScroll(&coordDelta));
         }
 
+        _prefetchScroll += coordDelta.Y;
+
         _ScrollPreviousSelection(coordDelta);
 
         return true;
@@ -496,16 +857,63 @@ void Renderer::TriggerTitleChange()
     _NotifyPaintFrame();
 }
 
+// Routine Description:
+// - Called when an application begins or ends a synchronized update
+//   (DECSET/DECRST 2026). While it's in progress, frames aren't painted, so
+//   that the intermediate states of a redraw never make it to the screen.
+// Arguments:
+// - enabled - true when the update begins, false when it ends
+// Return Value:
+// - <none>
+void Renderer::SetSynchronizedOutput(const bool enabled)
+{
+    if (enabled)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + _synchronizedOutputTimeout;
+        _synchronizedOutputDeadline.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+        _synchronizedOutput.store(true, std::memory_order_release);
+    }
+    else if (_synchronizedOutput.exchange(false, std::memory_order_acq_rel))
+    {
+        // Paint everything that was held back as one frame.
+        _NotifyPaintFrame();
+    }
+}
+
+// Routine Description:
+// - Checks whether painting should be held back for a synchronized update.
+//   An update that takes longer than _synchronizedOutputTimeout is considered
+//   abandoned, and painting resumes as usual.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if the current frame shouldn't be painted.
+bool Renderer::_IsSynchronizedOutputPending() noexcept
+{
+    if (!_synchronizedOutput.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    if (std::chrono::steady_clock::now().time_since_epoch().count() < _synchronizedOutputDeadline.load(std::memory_order_relaxed))
+    {
+        return true;
+    }
+
+    _synchronizedOutput.store(false, std::memory_order_relaxed);
+    return false;
+}
+
 // Routine Description:
 // - Update the title for a particular engine.
 // Arguments:
 // - pEngine: the engine to update the title for.
+// - frame: the frame holding the title.
 // Return Value:
 // - the HRESULT of the underlying engine's UpdateTitle call.
-HRESULT Renderer::_PaintTitle(IRenderEngine* const pEngine)
+HRESULT Renderer::_PaintTitle(IRenderEngine* const pEngine, const _RenderFrame& frame)
 {
-    const auto newTitle = _pData->GetConsoleTitle();
-    return pEngine->UpdateTitle(newTitle);
+    return pEngine->UpdateTitle(frame.title);
 }
 
 // Routine Description:
@@ -620,6 +1028,83 @@ void Renderer::WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs)
     _pThread->WaitForPaintCompletionAndDisable(dwTimeoutMs);
 }
 
+// Routine Description:
+// - Stops painting frames while nothing of them could be seen, like when the
+//   window is minimized or the control isn't part of the UI.
+// - The engines keep collecting what's invalidated in the meantime,
+//   so it's all painted in one frame once painting is resumed.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::SuspendPainting()
+{
+    _pThread->SuspendPainting();
+}
+
+// Routine Description:
+// - Resumes painting after SuspendPainting. If anything was invalidated
+//   while painting was suspended, a frame is painted right away.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::ResumePainting()
+{
+    _pThread->ResumePainting();
+}
+
+// Routine Description:
+// - Lowers the frame rate to at most one frame per the given interval, to save power.
+// Arguments:
+// - interval - the time between frames, or zero to paint as often as the engines can
+// Return Value:
+// - <none>
+void Renderer::SetMinimumFrameInterval(const std::chrono::milliseconds interval)
+{
+    _pThread->SetMinimumFrameInterval(interval);
+}
+
+// Routine Description:
+// - Sets the scheduling priority of the thread that paints the frames.
+// Arguments:
+// - priority - one of the THREAD_PRIORITY_* values
+// Return Value:
+// - <none>
+void Renderer::SetThreadPriority(const int priority)
+{
+    _pThread->SetPriority(priority);
+}
+
+// Routine Description:
+// - Gives back the memory the renderer and its engines keep around to paint
+//   the next frames faster, once nothing was painted for a while.
+// - The caller must hold the console lock exclusively, which keeps frames
+//   from being painted meanwhile.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::Trim() noexcept
+{
+    for (auto& entry : _clusterBuffers)
+    {
+        entry.second = {};
+    }
+
+    // The arena is reset after the console lock is released, so it may still be in use.
+    if (!_frameArenaInUse.exchange(true, std::memory_order_acquire))
+    {
+        _frameArena.release();
+        _frameArenaInUse.store(false, std::memory_order_release);
+    }
+
+    for (const auto engine : _rgpEngines)
+    {
+        engine->Trim();
+    }
+}
+
 // Routine Description:
 // - Paint helper to fill in the background color of the invalid area within the frame.
 // Arguments:
@@ -632,29 +1117,28 @@ void Renderer::WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs)
 }
 
 // Routine Description:
-// - Paint helper to copy the primary console buffer text onto the screen.
+// - Gathers the rows of the primary console buffer an engine has to paint.
 // - This portion primarily handles figuring the current viewport, comparing it/trimming it versus the invalid portion of the frame, and queuing up, row by row, which pieces of text need to be further processed.
 // - See also: Helper functions that separate out each complexity of text rendering.
 // Arguments:
-// - <none>
+// - frame - what all engines paint
+// - engineFrame - receives the rows this engine paints
 // Return Value:
 // - <none>
-void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
+void Renderer::_GatherBufferOutput(const _RenderFrame& frame, _EngineFrame& engineFrame)
 {
     // This is the subsection of the entire screen buffer that is currently being presented.
     // It can move left/right or top/bottom depending on how the viewport is scrolled
     // relative to the entire buffer.
-    const auto view = _pData->GetViewport();
+    const auto& view = frame.view;
 
     // This is effectively the number of cells on the visible screen that need to be redrawn.
     // The origin is always 0, 0 because it represents the screen itself, not the underlying buffer.
     gsl::span<const til::rectangle> dirtyAreas;
-    LOG_IF_FAILED(pEngine->GetDirtyArea(dirtyAreas));
+    LOG_IF_FAILED(engineFrame.engine->GetDirtyArea(dirtyAreas));
 
-    // This is to make sure any transforms are reset when this paint is finished.
-    auto resetLineTransform = wil::scope_exit([&]() {
-        LOG_IF_FAILED(pEngine->ResetLineTransform());
-    });
+    // Retrieve the text buffer so we can read information out of it.
+    const auto& buffer = _pData->GetTextBuffer();
 
     for (const auto& dirtyRect : dirtyAreas)
     {
@@ -672,9 +1156,6 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
         // Shortcut: don't bother redrawing if the width is 0.
         if (redraw.Width() > 0)
         {
-            // Retrieve the text buffer so we can read information out of it.
-            const auto& buffer = _pData->GetTextBuffer();
-
             // Now walk through each row of text that we need to redraw.
             for (auto row = redraw.Top(); row < redraw.BottomExclusive(); row++)
             {
@@ -694,46 +1175,201 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
                 // of the backing buffer to fill in line 1 of the screen.
                 const auto screenPosition = bufferLine.Origin() - COORD{ 0, view.Top() };
 
-                // Retrieve the cell information iterator limited to just this line we want to redraw.
-                auto it = buffer.GetCellDataAt(bufferLine.Origin(), bufferLine);
+                const auto& runs = _GetRowRuns(buffer, bufferLine, screenPosition, frame, engineFrame);
 
                 // Calculate if two things are true:
                 // 1. this row wrapped
                 // 2. We're painting the last col of the row.
                 // In that case, set lineWrapped=true for the _PaintBufferOutputHelper call.
-                const auto lineWrapped = (buffer.GetRowByOffset(bufferLine.Origin().Y).WasWrapForced()) &&
+                const auto lineWrapped = runs.wrapForced &&
                                          (bufferLine.RightExclusive() == buffer.GetSize().Width());
 
-                // Prepare the appropriate line transform for the current row and viewport offset.
-                LOG_IF_FAILED(pEngine->PrepareLineTransform(lineRendition, screenPosition.Y, view.Left()));
+                engineFrame.rows.push_back({ &runs, screenPosition, lineRendition, lineWrapped });
+            }
+        }
+    }
+}
 
-                // Ask the helper to paint through this specific line.
-                _PaintBufferOutputHelper(pEngine, it, screenPosition, lineWrapped);
+// Routine Description:
+// - Gets the runs a line of the buffer is split into.
+// - Repainting a row that hasn't changed since the last time (for the blinking
+//   text, the cursor, the selection and so on) reuses the runs it was split into.
+//   Only if the row or anything else the runs depend on changed do we walk through
+//   the buffer again.
+// Arguments:
+// - buffer - the buffer to read from
+// - bufferLine - the cells of the line
+// - target - the screen position of the first cell of the line
+// - frame - what all engines paint
+// - engineFrame - the frame of the engine asking, which holds on to the runs when
+//   another engine already painted other columns of the same row in this frame
+// Return Value:
+// - The runs, which stay put until the next frame is gathered.
+const Renderer::_RowRenderCache& Renderer::_GetRowRuns(const TextBuffer& buffer,
+                                                       const Viewport& bufferLine,
+                                                       const COORD target,
+                                                       const _RenderFrame& frame,
+                                                       _EngineFrame& engineFrame)
+{
+    const auto generation = buffer.GetRowGeneration(bufferLine.Origin().Y);
+
+    auto* cache = &til::at(_rowRenderCache, target.Y);
+    if (cache->valid &&
+        cache->bufferRow == bufferLine.Top() &&
+        cache->left == bufferLine.Left() &&
+        cache->right == bufferLine.RightExclusive() &&
+        cache->generation == generation &&
+        cache->patternGeneration == frame.patternGeneration &&
+        cache->globalInvert == frame.globalInvert)
+    {
+        cache->frame = _frameCount;
+        return *cache;
+    }
+
+    // Another engine is painting these runs in this frame, so they have to stay as they are.
+    if (cache->valid && cache->frame == _frameCount)
+    {
+        cache = &engineFrame.extraRuns.emplace_back();
+    }
+
+    cache->valid = false;
+
+    // Retrieve the cell information iterator limited to just this line we want to redraw.
+    auto it = buffer.GetCellDataAt(bufferLine.Origin(), bufferLine);
+    _BuildRowRenderCache(it, target, frame.globalInvert, *cache);
+
+    cache->wrapForced = buffer.GetRowByOffset(bufferLine.Origin().Y).WasWrapForced();
+    cache->bufferRow = bufferLine.Top();
+    cache->left = bufferLine.Left();
+    cache->right = bufferLine.RightExclusive();
+    cache->generation = generation;
+    cache->patternGeneration = frame.patternGeneration;
+    cache->globalInvert = frame.globalInvert;
+    cache->frame = _frameCount;
+    cache->valid = true;
+    return *cache;
+}
+
+// Routine Description:
+// - Hands the rows just outside of the viewport, in the direction it's scrolling in, to the
+//   engines, so that they can prepare them while this frame is painted. The rows are then
+//   quicker to paint once they scroll into view. See IRenderEngine::PrefetchBufferLine.
+// - As many rows are handed over as the viewport moved by since the last frame, since the next
+//   scroll likely goes as far, but at least _minPrefetchRows and at most a screenful. Below the
+//   viewport, they end at the row of the cursor, since there's usually nothing below it.
+// Arguments:
+// - frame - what all engines paint
+// - engineFrames - the engines painting this frame
+// Return Value:
+// - <none>
+void Renderer::_PrefetchRows(const _RenderFrame& frame, const gsl::span<_EngineFrame> engineFrames)
+{
+    const auto scroll = std::exchange(_prefetchScroll, 0);
+    if (scroll == 0 || engineFrames.empty())
+    {
+        return;
+    }
+
+    const auto& view = frame.view;
+    const auto& buffer = _pData->GetTextBuffer();
+    const auto count = std::clamp<int>(std::abs(scroll), _minPrefetchRows, std::max<int>(view.Height(), _minPrefetchRows));
+
+    // The rows closest to the viewport come first.
+    const auto up = scroll > 0;
+    const auto step = up ? -1 : 1;
+    const auto first = up ? view.Top() - 1 : int{ view.BottomExclusive() };
+    const auto last = up ? std::max(view.Top() - count, 0) :
+                           std::min({ view.BottomInclusive() + count,
+                                      int{ buffer.GetSize().BottomInclusive() },
+                                      int{ buffer.GetCursor().GetPosition().Y } });
+
+    for (auto row = first; step > 0 ? row <= last : row >= last; row += step)
+    {
+        const auto y = gsl::narrow_cast<SHORT>(row);
+        const auto screenLine = SMALL_RECT{ view.Left(), y, view.RightInclusive(), y };
+        const auto bufferLine = Viewport::FromInclusive(ScreenToBufferLine(screenLine, buffer.GetLineRendition(y)));
+        const auto target = bufferLine.Origin() - COORD{ 0, view.Top() };
+
+        _BuildRowRenderCache(buffer.GetCellDataAt(bufferLine.Origin(), bufferLine), target, frame.globalInvert, _prefetchRuns);
+
+        const std::wstring_view text{ _prefetchRuns.text };
+        for (auto& engineFrame : engineFrames)
+        {
+            if (engineFrame.ended)
+            {
+                continue;
+            }
+
+            auto& clusterBuffer = *engineFrame.clusterBuffer;
+            for (const auto& run : _prefetchRuns.runs)
+            {
+                clusterBuffer.clear();
+                for (size_t i = 0; i < run.clusterCount; i++)
+                {
+                    const auto& cluster = til::at(_prefetchRuns.clusters, run.firstCluster + i);
+                    clusterBuffer.emplace_back(text.substr(cluster.offset, cluster.length), cluster.columns);
+                }
+
+                const COORD screenPoint{ target.X + run.x, target.Y };
+                LOG_IF_FAILED(engineFrame.engine->PrefetchBufferLine({ clusterBuffer.data(), clusterBuffer.size() }, screenPoint, run.attr));
             }
         }
     }
 }
 
+// Routine Description:
+// - Paint helper to copy the rows of the primary console buffer gathered for an engine onto the screen.
+// Arguments:
+// - frame - what all engines paint
+// - engineFrame - what this engine paints
+// Return Value:
+// - <none>
+void Renderer::_PaintBufferOutput(const _RenderFrame& frame, _EngineFrame& engineFrame)
+{
+    const auto pEngine = engineFrame.engine;
+
+    // This is to make sure any transforms are reset when this paint is finished.
+    auto resetLineTransform = wil::scope_exit([&]() {
+        LOG_IF_FAILED(pEngine->ResetLineTransform());
+    });
+
+    for (const auto& row : engineFrame.rows)
+    {
+        // Prepare the appropriate line transform for the current row and viewport offset.
+        LOG_IF_FAILED(pEngine->PrepareLineTransform(row.lineRendition, row.target.Y, frame.view.Left()));
+
+        // Ask the helper to paint through this specific line.
+        _PaintBufferOutputHelper(pEngine, *row.runs, row.target, row.lineWrapped, frame, *engineFrame.clusterBuffer);
+    }
+}
+
 static bool _IsAllSpaces(const std::wstring_view v)
 {
     // first non-space char is not found (is npos)
     return v.find_first_not_of(L" ") == decltype(v)::npos;
 }
 
-void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
-                                        TextBufferCellIterator it,
-                                        const COORD target,
-                                        const bool lineWrapped)
+// Routine Description:
+// - Walks through a line of the buffer and splits it into the runs of clusters
+//   that are painted with the same attributes, remembering them in the cache.
+// Arguments:
+// - it - the iterator over the cells of the line
+// - target - the screen position of the first cell of the line
+// - globalInvert - whether the screen is reversed
+// - cache - receives the runs of the line
+void Renderer::_BuildRowRenderCache(TextBufferCellIterator it,
+                                    const COORD target,
+                                    const bool globalInvert,
+                                    _RowRenderCache& cache)
 {
-    auto globalInvert{ _pData->IsScreenReversed() };
+    cache.text.clear();
+    cache.clusters.clear();
+    cache.runs.clear();
+    cache.columnAttrs.clear();
 
     // If we have valid data, let's figure out how to draw it.
     if (it)
     {
-        // TODO: MSFT: 20961091 -  This is a perf issue. Instead of rebuilding this and allocing memory to hold the reinterpretation,
-        // we should have an iterator/view adapter for the rendering.
-        // That would probably also eliminate the RenderData needing to give us the entire TextBuffer as well...
-        // Retrieve the iterator for one line of information.
         size_t cols = 0;
 
         // Retrieve the first color.
@@ -747,44 +1383,31 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
         // This outer loop will continue until we reach the end of the text we are trying to draw.
         while (it)
         {
+            _RowRenderCache::Run run{};
+
             // Hold onto the current run color right here for the length of the outer loop.
             // We'll be changing the persistent one as we run through the inner loops to detect
             // when a run changes, but we will still need to know this color at the bottom
             // when we go to draw gridlines for the length of the run.
-            const auto currentRunColor = color;
-
-            // Hold onto the current pattern id as well
-            const auto currentPatternId = patternIds;
-
-            // Update the drawing brushes with our color.
-            THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, false));
+            run.attr = color;
 
             // Advance the point by however many columns we've just outputted and reset the accumulator.
-            screenPoint.X += gsl::narrow<SHORT>(cols);
+            // The columns never add up to more than the width of the line, which is a SHORT.
+            screenPoint.X += gsl::narrow_cast<SHORT>(cols);
             cols = 0;
 
             // Hold onto the start of this run iterator and the target location where we started
             // in case we need to do some special work to paint the line drawing characters.
             const auto currentRunItStart = it;
-            const auto currentRunTargetStart = screenPoint;
-
-            // Ensure that our cluster vector is clear.
-            _clusterBuffer.clear();
-
-            // Reset our flag to know when we're in the special circumstance
-            // of attempting to draw only the right-half of a two-column character
-            // as the first item in our run.
-            bool trimLeft = false;
-
-            // Run contains wide character (>1 columns)
-            bool containsWideCharacter = false;
+            run.lineX = screenPoint.X - target.X;
+            run.firstCluster = cache.clusters.size();
 
             // This inner loop will accumulate clusters until the color changes.
             // When the color changes, it will save the new color off and break.
             // We also accumulate clusters according to regex patterns
             do
             {
-                COORD thisPoint{ screenPoint.X + gsl::narrow<SHORT>(cols), screenPoint.Y };
+                COORD thisPoint{ screenPoint.X + gsl::narrow_cast<SHORT>(cols), screenPoint.Y };
                 const auto thisPointPatterns = _pData->GetPatternId(thisPoint);
                 if (color != it->TextAttr() || patternIds != thisPointPatterns)
                 {
@@ -801,30 +1424,28 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
 
                 // Walk through the text data and turn it into rendering clusters.
                 // Keep the columnCount as we go to improve performance over digging it out of the vector at the end.
-                size_t columnCount = 0;
+                size_t columnCount = it->Columns();
 
                 // If we're on the first cluster to be added and it's marked as "trailing"
                 // (a.k.a. the right half of a two column character), then we need some special handling.
-                if (_clusterBuffer.empty() && it->DbcsAttr().IsTrailing())
+                if (cache.clusters.size() == run.firstCluster && it->DbcsAttr().IsTrailing())
                 {
                     // Move left to the one so the whole character can be struck correctly.
                     --screenPoint.X;
-                    // And tell the next function to trim off the left half of it.
-                    trimLeft = true;
+                    // And tell the paint to trim off the left half of it.
+                    run.trimLeft = true;
                     // And add one to the number of columns we expect it to take as we insert it.
-                    columnCount = it->Columns() + 1;
-                    _clusterBuffer.emplace_back(it->Chars(), columnCount);
-                }
-                // Otherwise if it's not a special case, just insert it as is.
-                else
-                {
-                    columnCount = it->Columns();
-                    _clusterBuffer.emplace_back(it->Chars(), columnCount);
+                    columnCount++;
                 }
 
+                // The text is copied, since the cells of the row may move around before we paint it again.
+                const auto chars = it->Chars();
+                cache.clusters.push_back({ cache.text.size(), chars.size(), columnCount });
+                cache.text.append(chars);
+
                 if (columnCount > 1)
                 {
-                    containsWideCharacter = true;
+                    run.containsWideCharacter = true;
                 }
 
                 // Advance the cluster and column counts.
@@ -833,42 +1454,78 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
 
             } while (it);
 
-            // Do the painting.
-            THROW_IF_FAILED(pEngine->PaintBufferLine({ _clusterBuffer.data(), _clusterBuffer.size() }, screenPoint, trimLeft, lineWrapped));
+            run.x = screenPoint.X - target.X;
+            run.cols = cols;
+            run.clusterCount = cache.clusters.size() - run.firstCluster;
 
-            // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
-            // We're only allowed to draw the grid lines under certain circumstances.
-            if (_pData->IsGridLineDrawingAllowed())
+            // See GH: 803
+            // If we found a wide character while we looped above, it's possible we skipped over the right half
+            // attribute that could have contained different line information than the left half.
+            // Remember the attributes of each column, so the grid lines can be drawn for the exact column.
+            if (run.containsWideCharacter)
             {
-                // See GH: 803
-                // If we found a wide character while we looped above, it's possible we skipped over the right half
-                // attribute that could have contained different line information than the left half.
-                if (containsWideCharacter)
+                run.firstColumnAttr = cache.columnAttrs.size();
+                auto lineIt = currentRunItStart;
+                for (auto colsRecorded = 0u; colsRecorded < cols; ++colsRecorded, ++lineIt)
                 {
-                    // Start from the original position in this run.
-                    auto lineIt = currentRunItStart;
-                    // Start from the original target in this run.
-                    auto lineTarget = currentRunTargetStart;
-
-                    // We need to go through the iterators again to ensure we get the lines associated with each
-                    // exact column. The code above will condense two-column characters into one, but it is possible
-                    // (like with the IME) that the line drawing characters will vary from the left to right half
-                    // of a wider character.
-                    // We could theoretically pre-pass for this in the loop above to be more efficient about walking
-                    // the iterator, but I fear it would make the code even more confusing than it already is.
-                    // Do that in the future if some WPR trace points you to this spot as super bad.
-                    for (auto colsPainted = 0u; colsPainted < cols; ++colsPainted, ++lineIt, ++lineTarget.X)
-                    {
-                        auto lines = lineIt->TextAttr();
-                        _PaintBufferOutputGridLineHelper(pEngine, lines, 1, lineTarget);
-                    }
+                    cache.columnAttrs.push_back(lineIt->TextAttr());
                 }
-                else
+            }
+
+            cache.runs.push_back(run);
+        }
+    }
+}
+
+void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
+                                        const _RowRenderCache& cache,
+                                        const COORD target,
+                                        const bool lineWrapped,
+                                        const _RenderFrame& frame,
+                                        std::vector<Cluster>& clusterBuffer)
+{
+    const std::wstring_view text{ cache.text };
+
+    for (const auto& run : cache.runs)
+    {
+        // Update the drawing brushes with our color.
+        THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, run.attr, false));
+
+        // Views into the text of the cache are only valid until the row is walked again,
+        // so the clusters are rebuilt for each paint.
+        clusterBuffer.clear();
+        for (size_t i = 0; i < run.clusterCount; i++)
+        {
+            const auto& cluster = til::at(cache.clusters, run.firstCluster + i);
+            clusterBuffer.emplace_back(text.substr(cluster.offset, cluster.length), cluster.columns);
+        }
+
+        const COORD screenPoint{ target.X + run.x, target.Y };
+
+        // Do the painting.
+        THROW_IF_FAILED(pEngine->PaintBufferLine({ clusterBuffer.data(), clusterBuffer.size() }, screenPoint, run.trimLeft, lineWrapped));
+
+        // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
+        // We're only allowed to draw the grid lines under certain circumstances.
+        if (frame.gridLinesAllowed)
+        {
+            if (run.containsWideCharacter)
+            {
+                // The code above condenses two-column characters into one, but it is possible
+                // (like with the IME) that the line drawing characters will vary from the left to right half
+                // of a wider character. So draw the lines of each exact column.
+                COORD lineTarget{ target.X + run.lineX, target.Y };
+                for (auto colsPainted = 0u; colsPainted < run.cols; ++colsPainted, ++lineTarget.X)
                 {
-                    // If nothing exciting is going on, draw the lines in bulk.
-                    _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
+                    const auto& lines = til::at(cache.columnAttrs, run.firstColumnAttr + colsPainted);
+                    _PaintBufferOutputGridLineHelper(pEngine, lines, 1, lineTarget);
                 }
             }
+            else
+            {
+                // If nothing exciting is going on, draw the lines in bulk.
+                _PaintBufferOutputGridLineHelper(pEngine, run.attr, run.cols, screenPoint);
+            }
         }
     }
 }
@@ -1001,7 +1658,7 @@ void Renderer::_PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngin
 
         // We need to convert the screen coordinates of the viewport to an
         // equivalent range of buffer cells, taking line rendition into account.
-        const auto view = ScreenToBufferLine(_pData->GetViewport().ToInclusive(), lineRendition);
+        const auto view = ScreenToBufferLine(_GetPaintedViewport().ToInclusive(), lineRendition);
 
         // Note that we allow the X coordinate to be outside the left border by 1 position,
         // because the cursor could still be visible if the focused character is double width.
@@ -1019,7 +1676,7 @@ void Renderer::_PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngin
             // Build up the cursor parameters including position, color, and drawing options
             CursorOptions options;
             options.coordCursor = coordCursor;
-            options.viewportLeft = _pData->GetViewport().Left();
+            options.viewportLeft = _GetPaintedViewport().Left();
             options.lineRendition = lineRendition;
             options.ulCursorHeightPercent = _pData->GetCursorHeight();
             options.cursorPixelWidth = _pData->GetCursorPixelWidth();
@@ -1039,14 +1696,14 @@ void Renderer::_PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngin
 // - Paint helper to draw the cursor within the buffer.
 // Arguments:
 // - engine - The render engine that we're targeting.
+// - frame - The frame holding the cursor.
 // Return Value:
 // - <none>
-void Renderer::_PaintCursor(_In_ IRenderEngine* const pEngine)
+void Renderer::_PaintCursor(_In_ IRenderEngine* const pEngine, const _RenderFrame& frame)
 {
-    const auto cursorInfo = _GetCursorInfo();
-    if (cursorInfo.has_value())
+    if (frame.cursorInfo.has_value())
     {
-        LOG_IF_FAILED(pEngine->PaintCursor(cursorInfo.value()));
+        LOG_IF_FAILED(pEngine->PaintCursor(frame.cursorInfo.value()));
     }
 }
 
@@ -1056,34 +1713,35 @@ void Renderer::_PaintCursor(_In_ IRenderEngine* const pEngine)
 //   later drawing decisions.
 //   * Namely, the DX renderer uses this to know the cursor position and state
 //     before PaintCursor is called, so it can draw the cursor underneath the
-//     text.
+//     text. It also draws the cursor and the selection over the cached text
+//     on its own, which needs all of the selection, not just its dirty parts.
 // Arguments:
 // - engine - The render engine that we're targeting.
+// - frame - The frame holding the information.
 // Return Value:
 // - S_OK if the engine prepared successfully, or a relevant error via HRESULT.
-[[nodiscard]] HRESULT Renderer::_PrepareRenderInfo(_In_ IRenderEngine* const pEngine)
+[[nodiscard]] HRESULT Renderer::_PrepareRenderInfo(_In_ IRenderEngine* const pEngine, const _RenderFrame& frame)
 {
     RenderFrameInfo info;
-    info.cursorInfo = _GetCursorInfo();
+    info.cursorInfo = frame.cursorInfo;
+    info.selection = frame.selection;
+    info.searchHighlights = frame.searchHighlights;
     return pEngine->PrepareRenderInfo(info);
 }
 
 // Routine Description:
-// - Paint helper to draw text that overlays the main buffer to provide user interactivity regions
+// - Gathers the rows of text that overlay the main buffer to provide user interactivity regions
 // - This supports IME composition.
 // Arguments:
-// - engine - The render engine that we're targeting.
 // - overlay - The overlay to draw.
+// - globalInvert - Whether the screen is reversed.
+// - engineFrame - Receives the rows of the overlay the engine paints.
 // Return Value:
 // - <none>
-void Renderer::_PaintOverlay(IRenderEngine& engine,
-                             const RenderOverlay& overlay)
+void Renderer::_GatherOverlay(const RenderOverlay& overlay, const bool globalInvert, _EngineFrame& engineFrame)
 {
     try
     {
-        // First get the screen buffer's viewport.
-        Viewport view = _pData->GetViewport();
-
         // Now get the overlay's viewport and adjust it to where it is supposed to be relative to the window.
 
         SMALL_RECT srCaView = overlay.region.ToInclusive();
@@ -1096,7 +1754,7 @@ void Renderer::_PaintOverlay(IRenderEngine& engine,
         Viewport viewConv = Viewport::FromInclusive(srCaView);
 
         gsl::span<const til::rectangle> dirtyAreas;
-        LOG_IF_FAILED(engine.GetDirtyArea(dirtyAreas));
+        LOG_IF_FAILED(engineFrame.engine->GetDirtyArea(dirtyAreas));
 
         for (SMALL_RECT srDirty : dirtyAreas)
         {
@@ -1115,7 +1773,10 @@ void Renderer::_PaintOverlay(IRenderEngine& engine,
 
                     auto it = overlay.buffer.GetCellLineDataAt(source);
 
-                    _PaintBufferOutputHelper(&engine, it, target, false);
+                    // Overlays are small and change with every keystroke, so they aren't cached.
+                    auto& row = engineFrame.overlayRows.emplace_back();
+                    row.target = target;
+                    _BuildRowRenderCache(it, target, globalInvert, row.runs);
                 }
             }
         }
@@ -1124,14 +1785,15 @@ void Renderer::_PaintOverlay(IRenderEngine& engine,
 }
 
 // Routine Description:
-// - Paint helper to draw the composition string portion of the IME.
+// - Gathers the composition string portion of the IME.
 // - This specifically is the string that appears at the cursor on the input line showing what the user is currently typing.
-// - See also: Generic Paint IME helper method.
+// - See also: Generic Gather IME helper method.
 // Arguments:
-// - <none>
+// - frame - What all engines paint.
+// - engineFrame - Receives the rows of the overlays the engine paints.
 // Return Value:
 // - <none>
-void Renderer::_PaintOverlays(_In_ IRenderEngine* const pEngine)
+void Renderer::_GatherOverlays(const _RenderFrame& frame, _EngineFrame& engineFrame)
 {
     try
     {
@@ -1139,19 +1801,69 @@ void Renderer::_PaintOverlays(_In_ IRenderEngine* const pEngine)
 
         for (const auto& overlay : overlays)
         {
-            _PaintOverlay(*pEngine, overlay);
+            _GatherOverlay(overlay, frame.globalInvert, engineFrame);
         }
     }
     CATCH_LOG();
 }
 
 // Routine Description:
-// - Paint helper to draw the selected area of the window.
+// - Paint helper to draw the images of the buffer in the parts of the screen the engine redraws.
 // Arguments:
+// - frame - What all engines paint.
+// - engineFrame - What this engine paints.
+// Return Value:
 // - <none>
+void Renderer::_PaintImages(const _RenderFrame& frame, _EngineFrame& engineFrame)
+{
+    if (frame.images.empty())
+    {
+        return;
+    }
+
+    gsl::span<const til::rectangle> dirtyAreas;
+    LOG_IF_FAILED(engineFrame.engine->GetDirtyArea(dirtyAreas));
+
+    for (const auto& paint : frame.images)
+    {
+        const til::rectangle bounds{ paint.origin, paint.image->CellSize() };
+        for (const auto& dirtyRect : dirtyAreas)
+        {
+            const auto clip = bounds & dirtyRect;
+            if (!clip.empty())
+            {
+                LOG_IF_FAILED(engineFrame.engine->PaintImage(paint.image, paint.origin, clip));
+            }
+        }
+    }
+}
+
+// Routine Description:
+// - Paint helper to draw the overlays gathered for an engine.
+// Arguments:
+// - frame - What all engines paint.
+// - engineFrame - What this engine paints.
+// Return Value:
+// - <none>
+void Renderer::_PaintOverlays(const _RenderFrame& frame, _EngineFrame& engineFrame)
+{
+    try
+    {
+        for (const auto& row : engineFrame.overlayRows)
+        {
+            _PaintBufferOutputHelper(engineFrame.engine, row.runs, row.target, false, frame, *engineFrame.clusterBuffer);
+        }
+    }
+    CATCH_LOG();
+}
+
+// Routine Description:
+// - Paint helper to draw the selected area of the window.
+// Arguments:
+// - frame - The frame holding the selection.
 // Return Value:
 // - <none>
-void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
+void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine, const _RenderFrame& frame)
 {
     try
     {
@@ -1159,8 +1871,7 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
         LOG_IF_FAILED(pEngine->GetDirtyArea(dirtyAreas));
 
         // Get selection rectangles
-        const auto rectangles = _GetSelectionRects();
-        for (auto rect : rectangles)
+        for (auto rect : frame.selection)
         {
             for (auto& dirtyRect : dirtyAreas)
             {
@@ -1211,16 +1922,31 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 
 // Routine Description:
 // - Helper to determine the selected region of the buffer.
+// Arguments:
+// - resource - allocates the result
 // Return Value:
 // - A vector of rectangles representing the regions to select, line by line.
-std::vector<SMALL_RECT> Renderer::_GetSelectionRects() const
+std::pmr::vector<SMALL_RECT> Renderer::_GetSelectionRects(std::pmr::memory_resource* resource) const
+{
+    return _ToViewportRects(_pData->GetSelectionRects(), resource);
+}
+
+// Routine Description:
+// - Converts rectangles of the buffer, one per row, to the cells of the
+//   viewport they cover, the way the engines expect the selection.
+// Arguments:
+// - rects - the rectangles, in buffer coordinates
+// - resource - allocates the result
+// Return Value:
+// - The rectangles relative to the viewport, with exclusive right and bottom edges.
+std::pmr::vector<SMALL_RECT> Renderer::_ToViewportRects(const std::vector<Viewport>& rects, std::pmr::memory_resource* resource) const
 {
     const auto& buffer = _pData->GetTextBuffer();
-    auto rects = _pData->GetSelectionRects();
     // Adjust rectangles to viewport
-    Viewport view = _pData->GetViewport();
+    Viewport view = _GetPaintedViewport();
 
-    std::vector<SMALL_RECT> result;
+    std::pmr::vector<SMALL_RECT> result{ resource };
+    result.reserve(rects.size());
 
     for (auto rect : rects)
     {
@@ -1295,6 +2021,67 @@ void Renderer::SetRendererEnteredErrorStateCallback(std::function<void()> pfn)
     _pfnRendererEnteredErrorState = std::move(pfn);
 }
 
+// Method Description:
+// - Sets a callback for when a frame was painted. It's called on the render
+//   thread, after the console lock was released again.
+// Arguments:
+// - pfn: the callback
+// Return Value:
+// - <none>
+void Renderer::SetFramePaintedCallback(std::function<void()> pfn)
+{
+    _pfnFramePainted = std::move(pfn);
+}
+
+// Routine Description:
+// - Asks the render thread for a frame, even if nothing was invalidated, so
+//   that the frame painted callback is called soon.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::TriggerFrame()
+{
+    _NotifyPaintFrame();
+}
+
+// Routine Description:
+// - Sets how many rows below the viewport are painted along with it, for
+//   engines that can show a part of them, like when scrolling smoothly.
+// Arguments:
+// - rows - the number of rows to paint below the viewport
+// Return Value:
+// - <none>
+void Renderer::SetOverscanRows(const SHORT rows)
+{
+    if (_overscanRows != rows)
+    {
+        _overscanRows = rows;
+        TriggerRedrawAll();
+    }
+}
+
+// Routine Description:
+// - Gets the region of the buffer that's painted: the viewport and the
+//   overscan rows below it, as far as the buffer goes.
+// Arguments:
+// - <none>
+// Return Value:
+// - The painted region, in buffer coordinates
+Viewport Renderer::_GetPaintedViewport() const
+{
+    const auto view = _pData->GetViewport();
+    if (_overscanRows <= 0)
+    {
+        return view;
+    }
+
+    auto rect = view.ToInclusive();
+    const auto lastRow = _pData->GetTextBuffer().GetSize().BottomInclusive();
+    rect.Bottom = std::max(rect.Bottom, std::min(gsl::narrow_cast<SHORT>(rect.Bottom + _overscanRows), lastRow));
+    return Viewport::FromInclusive(rect);
+}
+
 // Method Description:
 // - Attempts to restart the renderer.
 void Renderer::ResetErrorStateAndResume()
@@ -1310,10 +2097,14 @@ void Renderer::UpdateLastHoveredInterval(const std::optional<PointTree::interval
 
 // Method Description:
 // - Blocks until the engines are able to render without blocking.
-void Renderer::WaitUntilCanRender()
+// Return Value:
+// - True if any of the engines paced the wait by the display.
+[[nodiscard]] bool Renderer::WaitUntilCanRender()
 {
+    bool paced = false;
     for (const auto pEngine : _rgpEngines)
     {
-        pEngine->WaitUntilCanRender();
+        paced |= pEngine->WaitUntilCanRender();
     }
+    return paced;
 }
@@ -21,12 +21,22 @@ Author(s):
 #include "../inc/IRenderData.hpp"
 
 #include "thread.hpp"
+#include "RendererTracing.hpp"
 
 #include "../../buffer/out/textBuffer.hpp"
 #include "../../buffer/out/CharRow.hpp"
 
 namespace Microsoft::Console::Render
 {
+    // The totals of everything the renderer painted so far, see Renderer::GetStatistics.
+    struct RenderStatistics
+    {
+        uint64_t frames = 0; // the frames that painted anything
+        uint64_t paintRequests = 0; // the times a frame was asked for, the ones beyond the frames were coalesced
+        std::chrono::nanoseconds frameTime{}; // from waiting for the console lock until the frames were presented
+        std::chrono::nanoseconds lockWait{};
+    };
+
     class Renderer sealed : public IRenderer
     {
     public:
@@ -60,6 +70,7 @@ namespace Microsoft::Console::Render
 
         void TriggerCircling() override;
         void TriggerTitleChange() override;
+        void SetSynchronizedOutput(const bool enabled) override;
 
         void TriggerFontChange(const int iDpi,
                                const FontInfoDesired& FontInfoDesired,
@@ -73,13 +84,23 @@ namespace Microsoft::Console::Render
 
         void EnablePainting() override;
         void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) override;
-        void WaitUntilCanRender() override;
+        void SuspendPainting() override;
+        void ResumePainting() override;
+        void SetMinimumFrameInterval(const std::chrono::milliseconds interval);
+        void SetThreadPriority(const int priority);
+        void Trim() noexcept;
+        [[nodiscard]] bool WaitUntilCanRender() override;
 
         void AddRenderEngine(_In_ IRenderEngine* const pEngine) override;
 
         void SetRendererEnteredErrorStateCallback(std::function<void()> pfn);
+        void SetFramePaintedCallback(std::function<void()> pfn);
+        void TriggerFrame();
+        void SetOverscanRows(const SHORT rows);
         void ResetErrorStateAndResume();
 
+        RenderStatistics GetStatistics() const noexcept;
+
         void UpdateLastHoveredInterval(const std::optional<interval_tree::IntervalTree<til::point, size_t>::interval>& newInterval);
 
     private:
@@ -90,22 +111,163 @@ namespace Microsoft::Console::Render
         std::unique_ptr<IRenderThread> _pThread;
         bool _destructing = false;
 
+        // While an application is in the middle of a synchronized update (DECSET 2026),
+        // painting is held back until it ends, or until the deadline has passed.
+        static constexpr std::chrono::milliseconds _synchronizedOutputTimeout{ 150 };
+        std::atomic<bool> _synchronizedOutput{ false };
+        std::atomic<std::chrono::steady_clock::rep> _synchronizedOutputDeadline{ 0 };
+        bool _IsSynchronizedOutputPending() noexcept;
+
         std::optional<interval_tree::IntervalTree<til::point, size_t>::interval> _hoveredInterval;
 
         void _NotifyPaintFrame();
 
+        // The runs a row was split into the last time it was painted, along with what they
+        // depend on. Repainting an unchanged row then doesn't walk through the buffer again.
+        struct _RowRenderCache
+        {
+            struct CachedCluster
+            {
+                size_t offset; // into text
+                size_t length;
+                size_t columns;
+            };
+
+            struct Run
+            {
+                TextAttribute attr;
+                SHORT x; // where the run is painted, relative to the start of the line
+                SHORT lineX; // where its grid lines start, which differs if trimLeft is set
+                bool trimLeft;
+                bool containsWideCharacter;
+                size_t cols;
+                size_t firstCluster;
+                size_t clusterCount;
+                size_t firstColumnAttr; // into columnAttrs, if the run contains a wide character
+            };
+
+            bool valid = false;
+            SHORT bufferRow = 0;
+            SHORT left = 0;
+            SHORT right = 0;
+            uint64_t generation = 0;
+            uint64_t patternGeneration = 0;
+            bool globalInvert = false;
+            bool wrapForced = false;
+            uint64_t frame = 0; // the last frame the runs were painted in
+
+            std::wstring text;
+            std::vector<CachedCluster> clusters;
+            std::vector<Run> runs;
+            std::vector<TextAttribute> columnAttrs;
+        };
+
+        // An image of the buffer that's (at least partly) in the viewport.
+        struct _ImagePaint
+        {
+            std::shared_ptr<const ImageStore::Image> image;
+            til::point origin; // the cell of its top left corner, on the screen
+        };
+
+        // What every engine paints in a frame, gathered once while the console is locked.
+        // It's only read while the engines paint.
+        struct _RenderFrame
+        {
+            explicit _RenderFrame(std::pmr::memory_resource* resource) :
+                selection{ resource },
+                searchHighlights{ resource },
+                title{ resource },
+                images{ resource }
+            {
+            }
+
+            Microsoft::Console::Types::Viewport view;
+            TextAttribute defaultBrushColors;
+            std::optional<CursorOptions> cursorInfo;
+            std::pmr::vector<SMALL_RECT> selection;
+            std::pmr::vector<SMALL_RECT> searchHighlights;
+            std::pmr::wstring title;
+            std::pmr::vector<_ImagePaint> images;
+            bool gridLinesAllowed = false;
+            bool globalInvert = false;
+            uint64_t patternGeneration = 0;
+            InputEcho inputEcho;
+        };
+
+        // A row of the buffer an engine has to paint, along with the runs it was split into.
+        struct _RowPaint
+        {
+            const _RowRenderCache* runs;
+            COORD target;
+            LineRendition lineRendition;
+            bool lineWrapped;
+        };
+
+        // A row of an overlay an engine has to paint. Overlays aren't cached.
+        struct _OverlayRowPaint
+        {
+            _RowRenderCache runs;
+            COORD target;
+        };
+
+        // What a single engine paints in a frame.
+        struct _EngineFrame
+        {
+            _EngineFrame(IRenderEngine* engine, size_t index, std::vector<Cluster>* clusterBuffer, std::pmr::memory_resource* resource) :
+                engine{ engine },
+                index{ index },
+                clusterBuffer{ clusterBuffer },
+                rows{ resource },
+                overlayRows{ resource }
+            {
+            }
+
+            IRenderEngine* engine;
+            size_t index; // into the results of _PaintFrameForEngines
+            std::vector<Cluster>* clusterBuffer;
+            std::pmr::vector<_RowPaint> rows;
+            std::pmr::vector<_OverlayRowPaint> overlayRows;
+            // Rows this engine paints with other columns than another engine did in the same frame.
+            std::deque<_RowRenderCache> extraRuns;
+            bool ended = false;
+            RenderFrameStats stats;
+        };
+
         [[nodiscard]] HRESULT _PaintFrameForEngine(_In_ IRenderEngine* const pEngine) noexcept;
+        void _PaintFrameForEngines(const gsl::span<IRenderEngine* const> engines, const gsl::span<HRESULT> results) noexcept;
 
         bool _CheckViewportAndScroll();
+        Microsoft::Console::Types::Viewport _GetPaintedViewport() const;
+
+        [[nodiscard]] _RenderFrame _GatherFrame(std::pmr::memory_resource* resource);
+        void _GatherBufferOutput(const _RenderFrame& frame, _EngineFrame& engineFrame);
+        const _RowRenderCache& _GetRowRuns(const TextBuffer& buffer,
+                                           const Microsoft::Console::Types::Viewport& bufferLine,
+                                           const COORD target,
+                                           const _RenderFrame& frame,
+                                           _EngineFrame& engineFrame);
+        void _PrefetchRows(const _RenderFrame& frame, const gsl::span<_EngineFrame> engineFrames);
+        void _GatherOverlays(const _RenderFrame& frame, _EngineFrame& engineFrame);
+        void _GatherOverlay(const RenderOverlay& overlay, const bool globalInvert, _EngineFrame& engineFrame);
+
+        [[nodiscard]] HRESULT _PaintEngineFrame(const _RenderFrame& frame, _EngineFrame& engineFrame) noexcept;
+        void _EndPaint(_EngineFrame& engineFrame) noexcept;
 
         [[nodiscard]] HRESULT _PaintBackground(_In_ IRenderEngine* const pEngine);
 
-        void _PaintBufferOutput(_In_ IRenderEngine* const pEngine);
+        void _PaintBufferOutput(const _RenderFrame& frame, _EngineFrame& engineFrame);
+
+        void _BuildRowRenderCache(TextBufferCellIterator it,
+                                  const COORD target,
+                                  const bool globalInvert,
+                                  _RowRenderCache& cache);
 
         void _PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
-                                      TextBufferCellIterator it,
+                                      const _RowRenderCache& cache,
                                       const COORD target,
-                                      const bool lineWrapped);
+                                      const bool lineWrapped,
+                                      const _RenderFrame& frame,
+                                      std::vector<Cluster>& clusterBuffer);
 
         static IRenderEngine::GridLines s_GetGridlines(const TextAttribute& textAttribute) noexcept;
 
@@ -114,35 +276,71 @@ namespace Microsoft::Console::Render
                                               const size_t cchLine,
                                               const COORD coordTarget);
 
-        void _PaintSelection(_In_ IRenderEngine* const pEngine);
-        void _PaintCursor(_In_ IRenderEngine* const pEngine);
+        void _PaintSelection(_In_ IRenderEngine* const pEngine, const _RenderFrame& frame);
+        void _PaintCursor(_In_ IRenderEngine* const pEngine, const _RenderFrame& frame);
 
-        void _PaintOverlays(_In_ IRenderEngine* const pEngine);
-        void _PaintOverlay(IRenderEngine& engine, const RenderOverlay& overlay);
+        void _PaintOverlays(const _RenderFrame& frame, _EngineFrame& engineFrame);
+        void _PaintImages(const _RenderFrame& frame, _EngineFrame& engineFrame);
 
         [[nodiscard]] HRESULT _UpdateDrawingBrushes(_In_ IRenderEngine* const pEngine, const TextAttribute attr, const bool isSettingDefaultBrushes);
 
         [[nodiscard]] HRESULT _PerformScrolling(_In_ IRenderEngine* const pEngine);
 
         Microsoft::Console::Types::Viewport _viewport;
+        // The rows below the viewport that are painted as well (see SetOverscanRows).
+        SHORT _overscanRows{ 0 };
 
         static constexpr float _shrinkThreshold = 0.8f;
-        std::vector<Cluster> _clusterBuffer;
-
-        std::vector<SMALL_RECT> _GetSelectionRects() const;
+        // One for each engine, since the engines paint in parallel.
+        std::unordered_map<IRenderEngine*, std::vector<Cluster>> _clusterBuffers;
+
+        // Indexed by the row on the screen.
+        std::vector<_RowRenderCache> _rowRenderCache;
+        const TextBuffer* _rowRenderCacheBuffer = nullptr;
+        uint64_t _rowRenderCacheGeneration = 0;
+        uint64_t _frameCount = 0;
+
+        // How far the viewport moved since the rows next to it were last prefetched, positive
+        // while scrolling up into the history. See _PrefetchRows, which walks them into _prefetchRuns.
+        static constexpr int _minPrefetchRows = 4;
+        int _prefetchScroll = 0;
+        _RowRenderCache _prefetchRuns;
+
+        // Holds the containers of a frame, so that painting doesn't allocate once it has warmed up.
+        // It's reset after the frame was presented. Nested frames (a final paint on teardown
+        // racing the paint thread) allocate from the heap instead, since the arena isn't thread-safe.
+        til::pmr::arena _frameArena;
+        std::atomic<bool> _frameArenaInUse{ false };
+
+        RendererTracing _tracing;
+        // The last keystroke whose echo was presented, so that each one is only reported once.
+        std::atomic<uint64_t> _presentedInputSequence{ 0 };
+        // See GetStatistics. They're read by other threads, while the frames are being painted.
+        std::atomic<uint64_t> _statFrames{ 0 };
+        std::atomic<uint64_t> _statPaintRequests{ 0 };
+        std::atomic<int64_t> _statFrameTime{ 0 };
+        std::atomic<int64_t> _statLockWait{ 0 };
+        void _TraceFrame(gsl::span<_EngineFrame> engineFrames,
+                         const std::chrono::steady_clock::duration lockWait,
+                         const std::chrono::steady_clock::duration gather) const noexcept;
+
+        std::pmr::vector<SMALL_RECT> _GetSelectionRects(std::pmr::memory_resource* resource) const;
+        std::pmr::vector<SMALL_RECT> _ToViewportRects(const std::vector<Microsoft::Console::Types::Viewport>& rects, std::pmr::memory_resource* resource) const;
+        static bool s_IsSmallRectBefore(const SMALL_RECT& a, const SMALL_RECT& b) noexcept;
         void _ScrollPreviousSelection(const til::point delta);
-        std::vector<SMALL_RECT> _previousSelection;
+        std::pmr::vector<SMALL_RECT> _previousSelection{ til::pmr::get_default_resource() };
 
-        [[nodiscard]] HRESULT _PaintTitle(IRenderEngine* const pEngine);
+        [[nodiscard]] HRESULT _PaintTitle(IRenderEngine* const pEngine, const _RenderFrame& frame);
 
         [[nodiscard]] std::optional<CursorOptions> _GetCursorInfo();
-        [[nodiscard]] HRESULT _PrepareRenderInfo(_In_ IRenderEngine* const pEngine);
+        [[nodiscard]] HRESULT _PrepareRenderInfo(_In_ IRenderEngine* const pEngine, const _RenderFrame& frame);
 
         // Helper functions to diagnose issues with painting and layout.
         // These are only actually effective/on in Debug builds when the flag is set using an attached debugger.
         bool _fDebug = false;
 
         std::function<void()> _pfnRendererEnteredErrorState;
+        std::function<void()> _pfnFramePainted;
 
 #ifdef UNIT_TESTING
         friend class ConptyOutputTests;
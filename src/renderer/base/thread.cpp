@@ -16,8 +16,12 @@ RenderThread::RenderThread() :
     _hPaintCompletedEvent(nullptr),
     _fKeepRunning(true),
     _hPaintEnabledEvent(nullptr),
+    _hPaintResumedEvent(nullptr),
     _fNextFrameRequested(false),
-    _fWaiting(false)
+    _fWaiting(false),
+    _delayedFrameDue(0),
+    _lastFrameStart(),
+    _fPacedByDisplay(false)
 {
 }
 
@@ -27,6 +31,7 @@ RenderThread::~RenderThread()
     {
         _fKeepRunning = false; // stop loop after final run
         EnablePainting(); // if we want to get the last frame out, we need to make sure it's enabled
+        ResumePainting();
         SignalObjectAndWait(_hEvent, _hThread, INFINITE, FALSE); // signal final paint and wait for thread to finish.
 
         CloseHandle(_hThread);
@@ -45,6 +50,12 @@ RenderThread::~RenderThread()
         _hPaintEnabledEvent = nullptr;
     }
 
+    if (_hPaintResumedEvent)
+    {
+        CloseHandle(_hPaintResumedEvent);
+        _hPaintResumedEvent = nullptr;
+    }
+
     if (_hPaintCompletedEvent)
     {
         CloseHandle(_hPaintCompletedEvent);
@@ -102,6 +113,23 @@ RenderThread::~RenderThread()
         }
     }
 
+    if (SUCCEEDED(hr))
+    {
+        HANDLE hPaintResumedEvent = CreateEventW(nullptr,
+                                                 TRUE, // manual reset event
+                                                 TRUE, // initially signaled
+                                                 nullptr);
+
+        if (hPaintResumedEvent == nullptr)
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+        }
+        else
+        {
+            _hPaintResumedEvent = hPaintResumedEvent;
+        }
+    }
+
     if (SUCCEEDED(hr))
     {
         HANDLE hPaintCompletedEvent = CreateEventW(nullptr,
@@ -161,7 +189,7 @@ DWORD WINAPI RenderThread::_ThreadProc()
 {
     while (_fKeepRunning)
     {
-        WaitForSingleObject(_hPaintEnabledEvent, INFINITE);
+        _WaitUntilPaintingAllowed();
 
         if (!_fNextFrameRequested.exchange(false, std::memory_order_acq_rel))
         {
@@ -175,8 +203,8 @@ DWORD WINAPI RenderThread::_ThreadProc()
             // check again now (see comment above)
             if (!_fNextFrameRequested.exchange(false, std::memory_order_acq_rel))
             {
-                // Wait until a next frame is requested.
-                WaitForSingleObject(_hEvent, INFINITE);
+                // Wait until a next frame is requested, or a delayed one is due.
+                WaitForSingleObject(_hEvent, _TimeUntilDelayedFrame());
             }
 
             // <--
@@ -200,23 +228,56 @@ DWORD WINAPI RenderThread::_ThreadProc()
             ResetEvent(_hEvent);
         }
 
+        // A request that comes in after a pause, like the echo of a keypress,
+        // is painted right away. Requests that keep coming while output is
+        // streaming in are coalesced into one frame per refresh of the display.
+        // If the engines pace themselves by the display, WaitUntilCanRender
+        // already blocks until the next refresh. Otherwise we hold off until
+        // the frame limit has passed since the start of the last frame.
+        // The minimum frame interval holds off every engine, if it's set.
+        const std::chrono::milliseconds minimumFrameInterval{ _minimumFrameInterval.load(std::memory_order_relaxed) };
+        const auto frameLimit = _fPacedByDisplay ? minimumFrameInterval : std::max(s_FrameLimit, minimumFrameInterval);
+        if (frameLimit > std::chrono::milliseconds::zero() && _fKeepRunning)
+        {
+            const auto elapsed = std::chrono::steady_clock::now() - _lastFrameStart;
+            if (elapsed < frameLimit)
+            {
+                const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(frameLimit - elapsed);
+                Sleep(gsl::narrow_cast<DWORD>(remaining.count()));
+            }
+        }
+
+        // Whatever woke us up, the frame we're about to paint takes care of the delayed one.
+        _delayedFrameDue.store(0, std::memory_order_relaxed);
+
+        // Painting may have been suspended while we were waiting for the request.
+        // The request is kept until it's resumed, which is when we paint the frame for it.
+        _WaitUntilPaintingAllowed();
+
         ResetEvent(_hPaintCompletedEvent);
 
-        _pRenderer->WaitUntilCanRender();
+        _fPacedByDisplay = _pRenderer->WaitUntilCanRender();
+        _lastFrameStart = std::chrono::steady_clock::now();
         LOG_IF_FAILED(_pRenderer->PaintFrame());
 
         SetEvent(_hPaintCompletedEvent);
-
-        // extra check before we sleep since it's a "long" activity, relatively speaking.
-        if (_fKeepRunning)
-        {
-            Sleep(s_FrameLimitMilliseconds);
-        }
     }
 
     return S_OK;
 }
 
+// Method Description:
+// - Blocks until painting is both enabled and not suspended.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void RenderThread::_WaitUntilPaintingAllowed() noexcept
+{
+    const std::array<HANDLE, 2> events{ _hPaintEnabledEvent, _hPaintResumedEvent };
+    WaitForMultipleObjects(gsl::narrow_cast<DWORD>(events.size()), events.data(), TRUE, INFINITE);
+}
+
 void RenderThread::NotifyPaint()
 {
     if (_fWaiting.load(std::memory_order_acquire))
@@ -229,6 +290,73 @@ void RenderThread::NotifyPaint()
     }
 }
 
+// Method Description:
+// - Sets the shortest time between the start of two frames, which lowers the
+//   frame rate below the refresh rate of the display, to save power.
+// Arguments:
+// - interval - the time between frames, or zero to paint at the display's rate
+// Return Value:
+// - <none>
+void RenderThread::SetMinimumFrameInterval(const std::chrono::milliseconds interval)
+{
+    _minimumFrameInterval.store(interval.count(), std::memory_order_relaxed);
+}
+
+// Method Description:
+// - Sets the scheduling priority of the render thread, so that the renderers
+//   sharing the CPU can paint what the user is looking at first.
+// Arguments:
+// - priority - one of the THREAD_PRIORITY_* values
+// Return Value:
+// - <none>
+void RenderThread::SetPriority(const int priority)
+{
+    if (_hThread)
+    {
+        LOG_IF_WIN32_BOOL_FALSE(SetThreadPriority(_hThread, priority));
+    }
+}
+
+// Method Description:
+// - Requests a frame once the given delay has passed, unless another one is
+//   painted before that. Meant for engines that keep redrawing at a lower rate,
+//   so it's called by the render thread at the end of a frame.
+// Arguments:
+// - delay - how long from now the frame should be painted
+// Return Value:
+// - <none>
+void RenderThread::NotifyPaintAfter(const std::chrono::milliseconds delay)
+{
+    const auto due = (std::chrono::steady_clock::now() + delay).time_since_epoch().count();
+    auto current = _delayedFrameDue.load(std::memory_order_relaxed);
+    while ((current == 0 || due < current) &&
+           !_delayedFrameDue.compare_exchange_weak(current, due, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Method Description:
+// - Gets how long to wait for a request before painting the delayed frame.
+// Arguments:
+// - <none>
+// Return Value:
+// - The time in milliseconds, or INFINITE if no frame was requested with NotifyPaintAfter.
+DWORD RenderThread::_TimeUntilDelayedFrame() const noexcept
+{
+    const auto due = _delayedFrameDue.load(std::memory_order_relaxed);
+    if (due == 0)
+    {
+        return INFINITE;
+    }
+
+    const auto remaining = std::chrono::steady_clock::time_point{ std::chrono::steady_clock::duration{ due } } - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero())
+    {
+        return 0;
+    }
+    return gsl::narrow_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+}
+
 void RenderThread::EnablePainting()
 {
     SetEvent(_hPaintEnabledEvent);
@@ -239,6 +367,24 @@ void RenderThread::DisablePainting()
     ResetEvent(_hPaintEnabledEvent);
 }
 
+// Method Description:
+// - Stops the thread from painting until ResumePainting is called. Unlike
+//   DisablePainting, which is used when the renderer failed, this is meant to
+//   be undone whenever the output can be seen again.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void RenderThread::SuspendPainting()
+{
+    ResetEvent(_hPaintResumedEvent);
+}
+
+void RenderThread::ResumePainting()
+{
+    SetEvent(_hPaintResumedEvent);
+}
+
 void RenderThread::WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs)
 {
     // When rendering takes place via DirectX, and a console application
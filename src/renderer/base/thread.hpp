@@ -28,21 +28,35 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT Initialize(_In_ IRenderer* const pRendererParent) noexcept;
 
         void NotifyPaint() override;
+        void NotifyPaintAfter(const std::chrono::milliseconds delay) override;
 
         void EnablePainting() override;
         void DisablePainting() override;
         void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) override;
+        void SuspendPainting() override;
+        void ResumePainting() override;
+        void SetMinimumFrameInterval(const std::chrono::milliseconds interval) override;
+        void SetPriority(const int priority) override;
 
     private:
         static DWORD WINAPI s_ThreadProc(_In_ LPVOID lpParameter);
         DWORD WINAPI _ThreadProc();
+        void _WaitUntilPaintingAllowed() noexcept;
+        DWORD _TimeUntilDelayedFrame() const noexcept;
 
-        static DWORD const s_FrameLimitMilliseconds = 8;
+        // The shortest time between the start of two frames for engines
+        // that can't pace themselves by the display.
+        static constexpr std::chrono::milliseconds s_FrameLimit{ 8 };
+
+        // The shortest time between the start of two frames for all engines,
+        // even those paced by the display. Zero unless power is to be saved.
+        std::atomic<std::chrono::milliseconds::rep> _minimumFrameInterval{ 0 };
 
         HANDLE _hThread;
         HANDLE _hEvent;
 
         HANDLE _hPaintEnabledEvent;
+        HANDLE _hPaintResumedEvent;
         HANDLE _hPaintCompletedEvent;
 
         IRenderer* _pRenderer; // Non-ownership pointer
@@ -50,5 +64,12 @@ namespace Microsoft::Console::Render
         bool _fKeepRunning;
         std::atomic<bool> _fNextFrameRequested;
         std::atomic<bool> _fWaiting;
+
+        // When the frame requested by NotifyPaintAfter is due, in ticks of the steady clock. Zero if there's none.
+        std::atomic<std::chrono::steady_clock::rep> _delayedFrameDue;
+
+        // Only touched by the render thread.
+        std::chrono::steady_clock::time_point _lastFrameStart;
+        bool _fPacedByDisplay;
     };
 }
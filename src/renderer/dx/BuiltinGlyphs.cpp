@@ -0,0 +1,438 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "BuiltinGlyphs.h"
+
+using namespace Microsoft::Console::Render;
+
+namespace
+{
+    // The weight of each of the four arms of a box drawing character, which reach
+    // from the center of the cell to the middle of one of its edges.
+    enum Weight : uint8_t
+    {
+        None,
+        Light,
+        Heavy,
+        Double,
+    };
+
+    struct Lines
+    {
+        Weight left;
+        Weight up;
+        Weight right;
+        Weight down;
+        // Dashed lines are split into this many dashes.
+        uint8_t dashes;
+    };
+
+    // Builds the table of U+2500-U+257F from strings of the arms in the order left, up, right, down.
+    // ' ' is no arm, 'l' a light, 'h' a heavy and 'd' a double one. A trailing digit is the number of dashes.
+    constexpr Lines s_ParseLines(const std::string_view arms) noexcept
+    {
+        const auto weight = [](const char ch) noexcept {
+            switch (ch)
+            {
+            case 'l':
+                return Light;
+            case 'h':
+                return Heavy;
+            case 'd':
+                return Double;
+            default:
+                return None;
+            }
+        };
+
+        return Lines{
+            weight(arms[0]),
+            weight(arms[1]),
+            weight(arms[2]),
+            weight(arms[3]),
+            gsl::narrow_cast<uint8_t>(arms.size() > 4 ? arms[4] - '0' : 0),
+        };
+    }
+
+    // clang-format off
+    constexpr std::array<std::string_view, 0x80> s_lineArms{
+        // 2500
+        "l l ", "h h ", " l l", " h h", "l l 3", "h h 3", " l l3", " h h3",
+        "l l 4", "h h 4", " l l4", " h h4", "  ll", "  hl", "  lh", "  hh",
+        // 2510
+        "l  l", "h  l", "l  h", "h  h", " ll ", " lh ", " hl ", " hh ",
+        "ll  ", "hl  ", "lh  ", "hh  ", " lll", " lhl", " hll", " llh",
+        // 2520
+        " hlh", " hhl", " lhh", " hhh", "ll l", "hl l", "lh l", "ll h",
+        "lh h", "hh l", "hl h", "hh h", "l ll", "h ll", "l hl", "h hl",
+        // 2530
+        "l lh", "h lh", "l hh", "h hh", "lll ", "hll ", "llh ", "hlh ",
+        "lhl ", "hhl ", "lhh ", "hhh ", "llll", "hlll", "llhl", "hlhl",
+        // 2540
+        "lhll", "lllh", "lhlh", "hhll", "lhhl", "hllh", "llhh", "hhhl",
+        "hlhh", "hhlh", "lhhh", "hhhh", "l l 2", "h h 2", " l l2", " h h2",
+        // 2550
+        "d d ", " d d", "  dl", "  ld", "  dd", "d  l", "l  d", "d  d",
+        " ld ", " dl ", " dd ", "dl  ", "ld  ", "dd  ", " ldl", " dld",
+        // 2560
+        " ddd", "dl l", "ld d", "dd d", "d dl", "l ld", "d dd", "dld ",
+        "ldl ", "ddd ", "dldl", "ldld", "dddd", "    ", "    ", "    ",
+        // 2570
+        "    ", "    ", "    ", "    ", "l   ", " l  ", "  l ", "   l",
+        "h   ", " h  ", "  h ", "   h", "l h ", " l h", "h l ", " h l",
+    };
+    // clang-format on
+
+    struct Span
+    {
+        int lo;
+        int hi;
+    };
+
+    // The pixels covered by a line of the given width, centered at the given position.
+    constexpr Span s_Line(const int center, const int width) noexcept
+    {
+        return { center - width / 2, center - width / 2 + width };
+    }
+}
+
+// Routine Description:
+// - Checks whether the character is drawn by this class instead of the font.
+// Arguments:
+// - ch - the character
+// Return Value:
+// - true if the character can be drawn with GetPrimitives
+[[nodiscard]] bool BuiltinGlyphs::IsBuiltinGlyph(const wchar_t ch) noexcept
+{
+    return ch >= s_first && ch <= s_last && (ch < 0x256D || ch > 0x2573);
+}
+
+// Routine Description:
+// - Sets the size of the cells the characters are drawn into,
+//   which drops the rectangles built for the previous size.
+// Arguments:
+// - cellSize - the size of a cell in pixels
+// - lineWidth - the width of a light line in pixels, like that of an underline
+// Return Value:
+// - <none>
+void BuiltinGlyphs::SetCellSize(const til::size cellSize, const float lineWidth) noexcept
+{
+    _cellWidth = cellSize.width<int>();
+    _cellHeight = cellSize.height<int>();
+    _light = std::max(1, gsl::narrow_cast<int>(std::lround(lineWidth)));
+    _heavy = _light * 2;
+    _built.reset();
+}
+
+// Routine Description:
+// - Gets the rectangles that make up the given character.
+// Arguments:
+// - ch - a character for which IsBuiltinGlyph is true
+// Return Value:
+// - The rectangles, filled with the foreground color (times their opacity).
+[[nodiscard]] gsl::span<const BuiltinGlyphs::Primitive> BuiltinGlyphs::GetPrimitives(const wchar_t ch)
+{
+    if (!IsBuiltinGlyph(ch))
+    {
+        return {};
+    }
+
+    const size_t index = ch - s_first;
+    auto& primitives = til::at(_primitives, index);
+    if (!_built.test(index))
+    {
+        primitives.clear();
+        if (ch < 0x2580)
+        {
+            _BuildLines(ch, primitives);
+        }
+        else
+        {
+            _BuildBlocks(ch, primitives);
+        }
+        _built.set(index);
+    }
+
+    return primitives;
+}
+
+// Routine Description:
+// - Builds the rectangles of a box drawing character.
+// - Every arm runs from the middle of its edge to the center. Where it ends there
+//   depends on the arms it meets, so that joints look like those of a typical font:
+//   light and heavy arms run across the arms they meet, while each line of a double
+//   arm stops at the line of the meeting arm on its side, or turns the corner into it.
+// Arguments:
+// - ch - a character from U+2500 to U+257F
+// - primitives - receives the rectangles
+// Return Value:
+// - <none>
+void BuiltinGlyphs::_BuildLines(const wchar_t ch, std::vector<Primitive>& primitives) const
+{
+    const auto lines = s_ParseLines(til::at(s_lineArms, ch - s_first));
+    const auto cx = _cellWidth / 2;
+    const auto cy = _cellHeight / 2;
+    // The lines of a double arm are this far from the center, leaving a light line's width between them.
+    const auto gap = _light;
+
+    const auto span = [&](const Weight weight, const int center) noexcept {
+        switch (weight)
+        {
+        case Light:
+            return s_Line(center, _light);
+        case Heavy:
+            return s_Line(center, _heavy);
+        default:
+            return Span{ s_Line(center - gap, _light).lo, s_Line(center + gap, _light).hi };
+        }
+    };
+
+    if (lines.dashes != 0)
+    {
+        // Dashed lines run straight across the cell, with half a gap at either end.
+        const auto horizontal = lines.left != None;
+        const auto weight = horizontal ? lines.left : lines.up;
+        const auto size = horizontal ? _cellWidth : _cellHeight;
+        const auto across = span(weight, horizontal ? cy : cx);
+        const auto dashGap = std::max(1, size / (lines.dashes * 2));
+        for (int i = 0; i < lines.dashes; ++i)
+        {
+            const auto lo = i * size / lines.dashes + dashGap / 2;
+            const auto hi = std::max(lo + 1, (i + 1) * size / lines.dashes - (dashGap - dashGap / 2));
+            if (horizontal)
+            {
+                _AddRect(primitives, lo, across.lo, hi, across.hi);
+            }
+            else
+            {
+                _AddRect(primitives, across.lo, lo, across.hi, hi);
+            }
+        }
+        return;
+    }
+
+    // Adds one arm. For horizontal arms, "before" is the arm above and "after" the arm below, for
+    // vertical ones they're the arms to the left and right. "opposite" is the arm on the other side.
+    const auto addArm = [&](const Weight weight, const bool horizontal, const bool positive, const Weight before, const Weight after, const Weight opposite) {
+        if (weight == None)
+        {
+            return;
+        }
+
+        // The center along the arm, the center across it, and how far the arm reaches.
+        const auto c = horizontal ? cx : cy;
+        const auto c2 = horizontal ? cy : cx;
+        const auto size = horizontal ? _cellWidth : _cellHeight;
+
+        const auto add = [&](const int from, const Span across) {
+            const auto lo = positive ? from : 0;
+            const auto hi = positive ? size : from;
+            if (horizontal)
+            {
+                _AddRect(primitives, lo, across.lo, hi, across.hi);
+            }
+            else
+            {
+                _AddRect(primitives, across.lo, lo, across.hi, hi);
+            }
+        };
+
+        if (weight != Double)
+        {
+            int from;
+            if (before != None || after != None)
+            {
+                // Run across everything the arm meets.
+                from = positive ? INT_MAX : INT_MIN;
+                for (const auto meeting : { before, after })
+                {
+                    if (meeting != None)
+                    {
+                        const auto meetingSpan = span(meeting, c);
+                        from = positive ? std::min(from, meetingSpan.lo) : std::max(from, meetingSpan.hi);
+                    }
+                }
+            }
+            else if (opposite != None)
+            {
+                from = c;
+            }
+            else
+            {
+                const auto own = span(weight, c);
+                from = positive ? own.lo : own.hi;
+            }
+
+            add(from, span(weight, c2));
+            return;
+        }
+
+        // The two lines of a double arm, on the side of the "before" arm and on that of the "after" one.
+        for (const auto beforeSide : { true, false })
+        {
+            const auto side = beforeSide ? before : after;
+            const auto otherSide = beforeSide ? after : before;
+            const auto lineCenter = beforeSide ? c2 - gap : c2 + gap;
+
+            // "near" is the line of a double arm that's closer to this arm, "far" the other one.
+            const auto nearLine = s_Line(positive ? c + gap : c - gap, _light);
+            const auto farLine = s_Line(positive ? c - gap : c + gap, _light);
+
+            int from;
+            if (side != None)
+            {
+                // Stop at the arm on this side: join its near line, or touch a single line.
+                from = side == Double ? (positive ? nearLine.lo : nearLine.hi) : (positive ? span(side, c).hi : span(side, c).lo);
+            }
+            else if (otherSide != None)
+            {
+                // Turn the outer corner into the arm on the other side.
+                from = otherSide == Double ? (positive ? farLine.lo : farLine.hi) : (positive ? span(otherSide, c).lo : span(otherSide, c).hi);
+            }
+            else if (opposite != None)
+            {
+                from = c;
+            }
+            else
+            {
+                from = positive ? farLine.lo : farLine.hi;
+            }
+
+            add(from, s_Line(lineCenter, _light));
+        }
+    };
+
+    addArm(lines.left, true, false, lines.up, lines.down, lines.right);
+    addArm(lines.right, true, true, lines.up, lines.down, lines.left);
+    addArm(lines.up, false, false, lines.left, lines.right, lines.down);
+    addArm(lines.down, false, true, lines.left, lines.right, lines.up);
+}
+
+// Routine Description:
+// - Builds the rectangles of a block element.
+// Arguments:
+// - ch - a character from U+2580 to U+259F
+// - primitives - receives the rectangles
+// Return Value:
+// - <none>
+void BuiltinGlyphs::_BuildBlocks(const wchar_t ch, std::vector<Primitive>& primitives) const
+{
+    const auto w = _cellWidth;
+    const auto h = _cellHeight;
+    const auto cx = w / 2;
+    const auto cy = h / 2;
+    const auto eighths = [](const int size, const int count) noexcept {
+        return (size * count + 4) / 8;
+    };
+
+    enum Quadrant : uint8_t
+    {
+        UpperLeft = 0x1,
+        UpperRight = 0x2,
+        LowerLeft = 0x4,
+        LowerRight = 0x8,
+    };
+    const auto addQuadrants = [&](const uint8_t quadrants) {
+        if (quadrants & UpperLeft)
+        {
+            _AddRect(primitives, 0, 0, cx, cy);
+        }
+        if (quadrants & UpperRight)
+        {
+            _AddRect(primitives, cx, 0, w, cy);
+        }
+        if (quadrants & LowerLeft)
+        {
+            _AddRect(primitives, 0, cy, cx, h);
+        }
+        if (quadrants & LowerRight)
+        {
+            _AddRect(primitives, cx, cy, w, h);
+        }
+    };
+
+    switch (ch)
+    {
+    case 0x2580: // upper half block
+        _AddRect(primitives, 0, 0, w, cy);
+        break;
+    case 0x2588: // full block
+        _AddRect(primitives, 0, 0, w, h);
+        break;
+    case 0x2590: // right half block
+        _AddRect(primitives, cx, 0, w, h);
+        break;
+    case 0x2591: // light shade
+        _AddRect(primitives, 0, 0, w, h, 0.25f);
+        break;
+    case 0x2592: // medium shade
+        _AddRect(primitives, 0, 0, w, h, 0.5f);
+        break;
+    case 0x2593: // dark shade
+        _AddRect(primitives, 0, 0, w, h, 0.75f);
+        break;
+    case 0x2594: // upper one eighth block
+        _AddRect(primitives, 0, 0, w, eighths(h, 1));
+        break;
+    case 0x2595: // right one eighth block
+        _AddRect(primitives, w - eighths(w, 1), 0, w, h);
+        break;
+    case 0x2596:
+        addQuadrants(LowerLeft);
+        break;
+    case 0x2597:
+        addQuadrants(LowerRight);
+        break;
+    case 0x2598:
+        addQuadrants(UpperLeft);
+        break;
+    case 0x2599:
+        addQuadrants(UpperLeft | LowerLeft | LowerRight);
+        break;
+    case 0x259A:
+        addQuadrants(UpperLeft | LowerRight);
+        break;
+    case 0x259B:
+        addQuadrants(UpperLeft | UpperRight | LowerLeft);
+        break;
+    case 0x259C:
+        addQuadrants(UpperLeft | UpperRight | LowerRight);
+        break;
+    case 0x259D:
+        addQuadrants(UpperRight);
+        break;
+    case 0x259E:
+        addQuadrants(UpperRight | LowerLeft);
+        break;
+    case 0x259F:
+        addQuadrants(UpperRight | LowerLeft | LowerRight);
+        break;
+    default:
+        if (ch >= 0x2581 && ch <= 0x2587)
+        {
+            // lower one eighth block to lower seven eighths block
+            _AddRect(primitives, 0, h - eighths(h, ch - 0x2580), w, h);
+        }
+        else if (ch >= 0x2589 && ch <= 0x258F)
+        {
+            // left seven eighths block to left one eighth block
+            _AddRect(primitives, 0, 0, eighths(w, 0x2590 - ch), h);
+        }
+        break;
+    }
+}
+
+void BuiltinGlyphs::_AddRect(std::vector<Primitive>& primitives, const int left, const int top, const int right, const int bottom, const float opacity) const
+{
+    // Clamp to the cell, since heavy or double lines may not fit into small ones.
+    const auto l = std::clamp(left, 0, _cellWidth);
+    const auto t = std::clamp(top, 0, _cellHeight);
+    const auto r = std::clamp(right, 0, _cellWidth);
+    const auto b = std::clamp(bottom, 0, _cellHeight);
+    if (l < r && t < b)
+    {
+        primitives.push_back({ D2D1::RectF(gsl::narrow_cast<float>(l), gsl::narrow_cast<float>(t), gsl::narrow_cast<float>(r), gsl::narrow_cast<float>(b)), opacity });
+    }
+}
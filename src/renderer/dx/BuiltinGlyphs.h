@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <d2d1.h>
+
+#include <bitset>
+
+namespace Microsoft::Console::Render
+{
+    // Draws box drawing (U+2500-U+257F) and block element (U+2580-U+259F) characters
+    // out of rectangles instead of the font. The rectangles are snapped to whole pixels
+    // and fill their cell up to its edges, so lines and blocks in neighboring cells join
+    // without seams, whatever the font's glyphs look like.
+    // - The rounded corners and diagonals (U+256D-U+2573) are left to the font.
+    // - The rectangles of each character are built on first use and kept until the cell size changes.
+    class BuiltinGlyphs
+    {
+    public:
+        struct Primitive
+        {
+            // The rectangle in pixels, relative to the top left corner of the cell.
+            D2D1_RECT_F rect;
+            // How much of the foreground color to use. Only the shades are partially opaque.
+            float opacity;
+        };
+
+        [[nodiscard]] static bool IsBuiltinGlyph(const wchar_t ch) noexcept;
+
+        void SetCellSize(const til::size cellSize, const float lineWidth) noexcept;
+
+        [[nodiscard]] gsl::span<const Primitive> GetPrimitives(const wchar_t ch);
+
+    private:
+        static constexpr wchar_t s_first = 0x2500;
+        static constexpr wchar_t s_last = 0x259F;
+        static constexpr size_t s_count = s_last - s_first + 1;
+
+        void _BuildLines(const wchar_t ch, std::vector<Primitive>& primitives) const;
+        void _BuildBlocks(const wchar_t ch, std::vector<Primitive>& primitives) const;
+        void _AddRect(std::vector<Primitive>& primitives, const int left, const int top, const int right, const int bottom, const float opacity = 1.0f) const;
+
+        int _cellWidth{ 0 };
+        int _cellHeight{ 0 };
+        int _light{ 1 };
+        int _heavy{ 2 };
+
+        std::array<std::vector<Primitive>, s_count> _primitives;
+        std::bitset<s_count> _built;
+    };
+}
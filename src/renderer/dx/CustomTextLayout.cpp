@@ -11,9 +11,14 @@
 #include <VersionHelpers.h>
 
 #include "BoxDrawingEffect.h"
+#include "FontCache.h"
 
 using namespace Microsoft::Console::Render;
 
+// How much memory the cached layouts of a CustomTextLayout may take up.
+// That's enough for the rows of a few large windows.
+static constexpr size_t s_layoutCacheBudget = 4 * 1024 * 1024;
+
 // Routine Description:
 // - Creates a CustomTextLayout object for calculating which glyphs should be placed and where
 // Arguments:
@@ -59,6 +64,33 @@ try
 }
 CATCH_RETURN()
 
+// Routine Description:
+// - Drops the cached layouts, and the capacity of the buffers that text is
+//   analyzed and shaped in. Anything that was appended is dropped as well.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void CustomTextLayout::Trim() noexcept
+{
+    _layoutCacheIndex = {};
+    _layoutCache = {};
+    _layoutCacheBytes = 0;
+
+    _runs = {};
+    _breakpoints = {};
+    _runIndex = 0;
+    _isEntireTextSimple = false;
+    _textClusterColumns = {};
+    _text = {};
+    _glyphScaleCorrections = {};
+    _glyphClusters = {};
+    _glyphIndices = {};
+    _glyphDesignUnitAdvances = {};
+    _glyphAdvances = {};
+    _glyphOffsets = {};
+}
+
 // Routine Description:
 // - Appends text to this layout for analysis/processing.
 // Arguments:
@@ -137,28 +169,67 @@ try
 {
     const auto drawingContext = static_cast<const DrawingContext*>(clientDrawingContext);
 
+    _SelectFont(drawingContext->useItalicFont);
+    RETURN_IF_FAILED(_LayOut());
+    RETURN_IF_FAILED(_DrawGlyphRuns(clientDrawingContext, renderer, { originX, originY }));
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Lays out the text appended since the last Reset() without drawing it, so that
+//   its layout is cached. See AdoptCachedLayouts.
+// Arguments:
+// - useItalicFont - Whether the text is going to be drawn in the italic font
+// Return Value:
+// - S_OK or suitable DirectX/DirectWrite/Direct2D result code.
+[[nodiscard]] HRESULT CustomTextLayout::Prefetch(const bool useItalicFont) noexcept
+try
+{
+    _SelectFont(useItalicFont);
+    return _LayOut();
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Picks the format and the font face of the font the text is drawn in.
+// Arguments:
+// - useItalicFont - Whether to use the italic font
+// Return Value:
+// - <none>
+void CustomTextLayout::_SelectFont(const bool useItalicFont)
+{
     const DWRITE_FONT_WEIGHT weight = _fontRenderData->DefaultFontWeight();
-    DWRITE_FONT_STYLE style = _fontRenderData->DefaultFontStyle();
+    const DWRITE_FONT_STYLE style = useItalicFont ? DWRITE_FONT_STYLE_ITALIC : _fontRenderData->DefaultFontStyle();
     const DWRITE_FONT_STRETCH stretch = _fontRenderData->DefaultFontStretch();
 
-    if (drawingContext->useItalicFont)
-    {
-        style = DWRITE_FONT_STYLE_ITALIC;
-    }
-
     _formatInUse = _fontRenderData->TextFormatWithAttribute(weight, style, stretch).Get();
     _fontInUse = _fontRenderData->FontFaceWithAttribute(weight, style, stretch).Get();
+}
 
-    RETURN_IF_FAILED(_AnalyzeTextComplexity());
-    RETURN_IF_FAILED(_AnalyzeRuns());
-    RETURN_IF_FAILED(_ShapeGlyphRuns());
-    RETURN_IF_FAILED(_CorrectGlyphRuns());
-    // Correcting box drawing has to come after both font fallback and
-    // the glyph run advance correction (which will apply a font size scaling factor).
-    // We need to know all the proposed X and Y dimension metrics to get this right.
-    RETURN_IF_FAILED(_CorrectBoxDrawing());
-
-    RETURN_IF_FAILED(_DrawGlyphRuns(clientDrawingContext, renderer, { originX, originY }));
+// Routine Description:
+// - Lays out the text in the selected font, unless it's ASCII or its layout is cached.
+// Arguments:
+// - <none> - Uses internal state
+// Return Value:
+// - S_OK or suitable DirectX/DirectWrite/Direct2D result code.
+[[nodiscard]] HRESULT CustomTextLayout::_LayOut() noexcept
+try
+{
+    if (!_LayOutAscii() && !_RestoreCachedLayout())
+    {
+        RETURN_IF_FAILED(_AnalyzeTextComplexity());
+        RETURN_IF_FAILED(_AnalyzeRuns());
+        RETURN_IF_FAILED(_ShapeGlyphRuns());
+        RETURN_IF_FAILED(_CorrectGlyphRuns());
+        // Correcting box drawing has to come after both font fallback and
+        // the glyph run advance correction (which will apply a font size scaling factor).
+        // We need to know all the proposed X and Y dimension metrics to get this right.
+        RETURN_IF_FAILED(_CorrectBoxDrawing());
+
+        _CacheLayout();
+    }
 
     return S_OK;
 }
@@ -981,6 +1052,210 @@ CATCH_RETURN();
     return 3 * textLength / 2 + 16;
 }
 
+// Routine Description:
+// - Lays out the text directly if it's made up of printable ASCII only, each character
+//   taking up one column, and the font allows drawing ASCII without shaping it.
+//   The glyphs are then looked up in a table and put into a single run, one per cell.
+//   That skips the text analyzer (script, bidi and font fallback analysis) entirely.
+// Arguments:
+// - <none> - Uses internal state
+// Return Value:
+// - true if the text was laid out and can be drawn right away.
+[[nodiscard]] bool CustomTextLayout::_LayOutAscii()
+{
+    if (_text.empty())
+    {
+        return false;
+    }
+
+    const auto asciiGlyphs = _fontRenderData->AsciiGlyphIndices(_fontInUse);
+    if (!asciiGlyphs)
+    {
+        return false;
+    }
+
+    const auto textLength = gsl::narrow<UINT32>(_text.size());
+    for (UINT32 i = 0; i < textLength; ++i)
+    {
+        const auto ch = til::at(_text, i);
+        if (ch < L' ' || ch > L'~' || til::at(_textClusterColumns, i) != 1)
+        {
+            return false;
+        }
+    }
+
+    _glyphIndices.resize(textLength);
+    std::transform(_text.begin(), _text.end(), _glyphIndices.begin(), [&](const wchar_t ch) {
+        return til::at(*asciiGlyphs, ch - L' ');
+    });
+
+    _glyphAdvances.assign(textLength, gsl::narrow_cast<float>(_width));
+    _glyphOffsets.assign(textLength, DWRITE_GLYPH_OFFSET{});
+    _glyphClusters.resize(textLength);
+    std::iota(_glyphClusters.begin(), _glyphClusters.end(), gsl::narrow_cast<UINT16>(0));
+
+    _runs.resize(1);
+    auto& run = _runs.front();
+    run = LinkedRun{};
+    run.textLength = textLength;
+    run.glyphCount = textLength;
+    run.fontFace = _fontInUse;
+
+    return true;
+}
+
+#pragma region layout cache
+
+// Routine Description:
+// - Hashes what the layout of the text depends on: the text, the columns of its clusters and the font.
+// Arguments:
+// - <none> - Uses internal state
+// Return Value:
+// - The hash
+[[nodiscard]] size_t CustomTextLayout::_LayoutHash() const noexcept
+{
+    // The cluster columns are hashed as if they were a string of the same length,
+    // since UINT16 and wchar_t are the same size.
+    static_assert(sizeof(UINT16) == sizeof(wchar_t));
+    const std::wstring_view columns{ reinterpret_cast<const wchar_t*>(_textClusterColumns.data()), _textClusterColumns.size() };
+
+    auto hash = std::hash<std::wstring_view>{}(_text);
+    hash ^= std::hash<std::wstring_view>{}(columns) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<const void*>{}(_fontInUse) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+// Routine Description:
+// - Looks for a cached layout of the text appended since the last Reset(),
+//   and if there is one, restores the runs and glyphs from it.
+// Arguments:
+// - <none> - Uses internal state
+// Return Value:
+// - true if the layout was restored and the text can be drawn right away.
+[[nodiscard]] bool CustomTextLayout::_RestoreCachedLayout()
+{
+    const auto hash = _LayoutHash();
+    const auto [begin, end] = _layoutCacheIndex.equal_range(hash);
+    for (auto it = begin; it != end; ++it)
+    {
+        const auto& entry = *it->second;
+        if (entry.font == _fontInUse && entry.text == _text && entry.textClusterColumns == _textClusterColumns)
+        {
+            _runs = entry.runs;
+            _glyphIndices = entry.glyphIndices;
+            _glyphClusters = entry.glyphClusters;
+            _glyphAdvances = entry.glyphAdvances;
+            _glyphOffsets = entry.glyphOffsets;
+
+            // Mark it as the most recently used one.
+            _layoutCache.splice(_layoutCache.begin(), _layoutCache, it->second);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Routine Description:
+// - Stores the layout of the text appended since the last Reset(), so that
+//   the same text can be drawn again later without laying it out again.
+// - Drops the least recently used layouts if the cache grows too large.
+// Arguments:
+// - <none> - Uses internal state
+// Return Value:
+// - <none>
+void CustomTextLayout::_CacheLayout()
+{
+    CachedLayout entry{ _LayoutHash(),
+                        0,
+                        _fontInUse,
+                        _text,
+                        _textClusterColumns,
+                        _runs,
+                        _glyphIndices,
+                        _glyphClusters,
+                        _glyphAdvances,
+                        _glyphOffsets };
+
+    entry.bytes = sizeof(CachedLayout) +
+                  entry.text.size() * sizeof(wchar_t) +
+                  entry.textClusterColumns.size() * sizeof(UINT16) +
+                  entry.runs.size() * sizeof(LinkedRun) +
+                  entry.glyphIndices.size() * sizeof(UINT16) +
+                  entry.glyphClusters.size() * sizeof(UINT16) +
+                  entry.glyphAdvances.size() * sizeof(float) +
+                  entry.glyphOffsets.size() * sizeof(DWRITE_GLYPH_OFFSET);
+
+    _layoutCacheBytes += entry.bytes;
+    _layoutCache.emplace_front(std::move(entry));
+    _layoutCacheIndex.emplace(_layoutCache.front().hash, _layoutCache.begin());
+
+    _TrimLayoutCache();
+}
+
+// Routine Description:
+// - Moves the cached layouts of another layout, which lays out text with the
+//   same font render data, into this one's cache as the most recently used ones.
+//   Those this one has cached already are dropped. The other one's cache is empty afterwards.
+// Arguments:
+// - other - the layout to take the cached layouts of
+// Return Value:
+// - <none>
+void CustomTextLayout::AdoptCachedLayouts(CustomTextLayout& other)
+{
+    other._layoutCacheIndex.clear();
+    other._layoutCacheBytes = 0;
+
+    // From the least recently used one on, so that they keep their order at the front.
+    while (!other._layoutCache.empty())
+    {
+        const auto last = std::prev(other._layoutCache.end());
+        const auto [begin, end] = _layoutCacheIndex.equal_range(last->hash);
+        const auto cached = std::any_of(begin, end, [&](const auto& pair) {
+            const auto& entry = *pair.second;
+            return entry.font == last->font && entry.text == last->text && entry.textClusterColumns == last->textClusterColumns;
+        });
+
+        if (cached)
+        {
+            other._layoutCache.erase(last);
+            continue;
+        }
+
+        _layoutCacheBytes += last->bytes;
+        _layoutCache.splice(_layoutCache.begin(), other._layoutCache, last);
+        _layoutCacheIndex.emplace(last->hash, last);
+    }
+
+    _TrimLayoutCache();
+}
+
+// Routine Description:
+// - Drops the least recently used layouts while the cache is larger than its budget.
+// Arguments:
+// - <none> - Uses internal state
+// Return Value:
+// - <none>
+void CustomTextLayout::_TrimLayoutCache() noexcept
+{
+    // Never drop the most recently used layout, even if it's larger than the budget on its own.
+    while (_layoutCacheBytes > s_layoutCacheBudget && _layoutCache.size() > 1)
+    {
+        const auto last = std::prev(_layoutCache.end());
+        const auto [begin, end] = _layoutCacheIndex.equal_range(last->hash);
+        const auto it = std::find_if(begin, end, [&](const auto& pair) { return pair.second == last; });
+        if (it != end)
+        {
+            _layoutCacheIndex.erase(it);
+        }
+
+        _layoutCacheBytes -= last->bytes;
+        _layoutCache.erase(last);
+    }
+}
+
+#pragma endregion
+
 #pragma region IDWriteTextAnalysisSource methods
 // Routine Description:
 // - Implementation of IDWriteTextAnalysisSource::GetTextAtPosition
@@ -1258,49 +1533,169 @@ CATCH_RETURN();
             fallback = _fontRenderData->SystemFontFallback();
         }
 
+        // A code point that forms a cluster by itself maps to the same font wherever
+        // it appears, so its mapping is shared by all layouts of the process.
+        // Only clusters of several code points are mapped along with their neighbors.
+        auto& fallbacks = FontCache::Instance().Fallbacks({ std::wstring_view{ familyName.c_str() }, weight, style, stretch });
+
+        // Consecutive code points mapped to the same font end up in the same run.
+        UINT32 pendingPosition = textPosition;
+        UINT32 pendingLength = 0;
+        FontCache::MappedFont pending{ nullptr, 0.0f };
+        const auto setMappedFont = [&](const UINT32 position, const UINT32 length, const FontCache::MappedFont& font) {
+            if (pendingLength != 0 && (font.face != pending.face || font.scale != pending.scale))
+            {
+                RETURN_IF_FAILED(_SetMappedFont(pendingPosition, pendingLength, pending.face.Get(), pending.scale));
+                pendingLength = 0;
+            }
+            if (pendingLength == 0)
+            {
+                pendingPosition = position;
+                pending = font;
+            }
+            pendingLength += length;
+            return S_OK;
+        };
+
+        const auto mapCharacters = [&](const UINT32 position, const UINT32 length, UINT32& mappedLength, FontCache::MappedFont& font) {
+            ::Microsoft::WRL::ComPtr<IDWriteFont> mappedFont;
+            RETURN_IF_FAILED(fallback->MapCharacters(source,
+                                                     position,
+                                                     length,
+                                                     collection.Get(),
+                                                     familyName.data(),
+                                                     weight,
+                                                     style,
+                                                     stretch,
+                                                     &mappedLength,
+                                                     &mappedFont,
+                                                     &font.scale));
+
+            font.face.Reset();
+            if (mappedFont)
+            {
+                // Get font face from font metadata
+                ::Microsoft::WRL::ComPtr<IDWriteFontFace> face;
+                RETURN_IF_FAILED(mappedFont->CreateFontFace(&face));
+                RETURN_IF_FAILED(face.As(&font.face));
+            }
+            return S_OK;
+        };
+
         // Walk through and analyze the entire string
         while (textLength > 0)
         {
+            FontCache::MappedFont font{ nullptr, 0.0f };
             UINT32 mappedLength = 0;
-            ::Microsoft::WRL::ComPtr<IDWriteFont> mappedFont;
-            FLOAT scale = 0.0f;
-
-            fallback->MapCharacters(source,
-                                    textPosition,
-                                    textLength,
-                                    collection.Get(),
-                                    familyName.data(),
-                                    weight,
-                                    style,
-                                    stretch,
-                                    &mappedLength,
-                                    &mappedFont,
-                                    &scale);
-
-            RETURN_IF_FAILED(_SetMappedFont(textPosition, mappedLength, mappedFont.Get(), scale));
+
+            const auto [codepoint, length] = _StandaloneCodepointAt(textPosition, textLength);
+            if (length != 0)
+            {
+                if (auto cached = fallbacks.Lookup(codepoint))
+                {
+                    font = std::move(*cached);
+                    mappedLength = length;
+                }
+                else
+                {
+                    RETURN_IF_FAILED(mapCharacters(textPosition, length, mappedLength, font));
+                    if (mappedLength == length)
+                    {
+                        fallbacks.Store(codepoint, font);
+                    }
+                }
+            }
+            else
+            {
+                RETURN_IF_FAILED(mapCharacters(textPosition, textLength, mappedLength, font));
+            }
+
+            // MapCharacters always maps at least one character, but let's not loop forever if it doesn't.
+            mappedLength = std::clamp<UINT32>(mappedLength, 1, textLength);
+            RETURN_IF_FAILED(setMappedFont(textPosition, mappedLength, font));
 
             textPosition += mappedLength;
             textLength -= mappedLength;
         }
+
+        if (pendingLength != 0)
+        {
+            RETURN_IF_FAILED(_SetMappedFont(pendingPosition, pendingLength, pending.face.Get(), pending.scale));
+        }
     }
     CATCH_RETURN();
 
     return S_OK;
 }
 
+// Routine Description:
+// - Checks whether the code point at the given position forms a cluster of its own.
+//   That's the case unless it or the code point after it is a combining mark, a
+//   joiner, a variation selector or some other character that extends a cluster.
+// - Regional indicators, which form flags in pairs, and Hangul jamo, which form
+//   syllables, are never considered to be on their own.
+// Arguments:
+// - textPosition - the index of the code point in the text
+// - textLength - the length of the text from there
+// Return Value:
+// - The code point and its length in UTF-16 code units, or a length of 0 if it isn't on its own.
+std::pair<char32_t, UINT32> CustomTextLayout::_StandaloneCodepointAt(const UINT32 textPosition, const UINT32 textLength) const
+{
+    const auto read = [&](const UINT32 position, const UINT32 length) noexcept -> std::pair<char32_t, UINT32> {
+        const auto lead = til::at(_text, position);
+        if (IS_HIGH_SURROGATE(lead) && length >= 2 && IS_LOW_SURROGATE(til::at(_text, position + 1)))
+        {
+            const auto trail = til::at(_text, position + 1);
+            return { 0x10000 + ((static_cast<char32_t>(lead) - 0xD800) << 10) + (static_cast<char32_t>(trail) - 0xDC00), 2 };
+        }
+        return { lead, 1 };
+    };
+
+    const auto joins = [](const char32_t ch) noexcept {
+        if (ch < 0x10000)
+        {
+            // Cover ZWNJ/ZWJ, variation selectors, Hangul jamo and surrogates that aren't in a pair.
+            if ((ch >= 0x200C && ch <= 0x200D) || (ch >= 0xFE00 && ch <= 0xFE0F) ||
+                (ch >= 0x1100 && ch <= 0x11FF) || (ch >= 0xA960 && ch <= 0xA97F) || (ch >= 0xD7B0 && ch <= 0xDFFF))
+            {
+                return true;
+            }
+
+            const auto wch = gsl::narrow_cast<wchar_t>(ch);
+            WORD type = 0;
+            return GetStringTypeW(CT_CTYPE3, &wch, 1, &type) && WI_IsAnyFlagSet(type, C3_NONSPACING | C3_DIACRITIC | C3_VOWELMARK);
+        }
+
+        // Regional indicators, emoji modifiers, tags and variation selectors supplement.
+        return (ch >= 0x1F1E6 && ch <= 0x1F1FF) || (ch >= 0x1F3FB && ch <= 0x1F3FF) ||
+               (ch >= 0xE0000 && ch <= 0xE01EF);
+    };
+
+    const auto [codepoint, length] = read(textPosition, textLength);
+    if (joins(codepoint))
+    {
+        return { codepoint, 0 };
+    }
+    if (length < textLength && joins(read(textPosition + length, textLength - length).first))
+    {
+        return { codepoint, 0 };
+    }
+    return { codepoint, length };
+}
+
 // Routine Description:
 // - Mimics an IDWriteTextAnalysisSink but for font fallback calculations with our
 //   Analyzer mimic method above.
 // Arguments:
 // - textPosition - the index to start the substring operation
 // - textLength - the length of the substring operation
-// - font - the font that applies to the substring range
+// - face - the face of the font that applies to the substring range, or null for the primary font
 // - scale - the scale of the font to apply
 // Return Value:
 // - S_OK or appropriate STL/GSL failure code.
 [[nodiscard]] HRESULT STDMETHODCALLTYPE CustomTextLayout::_SetMappedFont(UINT32 textPosition,
                                                                          UINT32 textLength,
-                                                                         _In_ IDWriteFont* const font,
+                                                                         _In_opt_ IDWriteFontFace1* const face,
                                                                          FLOAT const scale)
 {
     try
@@ -1311,19 +1706,7 @@ CATCH_RETURN();
         {
             auto& run = _FetchNextRun(textLength);
 
-            if (font != nullptr)
-            {
-                // Get font face from font metadata
-                ::Microsoft::WRL::ComPtr<IDWriteFontFace> face;
-                RETURN_IF_FAILED(font->CreateFontFace(&face));
-
-                // QI for Face5 interface from base face interface, store into run
-                RETURN_IF_FAILED(face.As(&run.fontFace));
-            }
-            else
-            {
-                run.fontFace = _fontInUse;
-            }
+            run.fontFace = face != nullptr ? face : _fontInUse;
 
             // Store the font scale as well.
             run.fontScale = scale;
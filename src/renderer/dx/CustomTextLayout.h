@@ -26,6 +26,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT STDMETHODCALLTYPE AppendClusters(const gsl::span<const ::Microsoft::Console::Render::Cluster> clusters);
 
         [[nodiscard]] HRESULT STDMETHODCALLTYPE Reset() noexcept;
+        void Trim() noexcept;
 
         [[nodiscard]] HRESULT STDMETHODCALLTYPE GetColumns(_Out_ UINT32* columns);
 
@@ -35,6 +36,9 @@ namespace Microsoft::Console::Render
                                                      FLOAT originX,
                                                      FLOAT originY) noexcept;
 
+        [[nodiscard]] HRESULT Prefetch(const bool useItalicFont) noexcept;
+        void AdoptCachedLayouts(CustomTextLayout& other);
+
         // IDWriteTextAnalysisSource methods
         [[nodiscard]] HRESULT STDMETHODCALLTYPE GetTextAtPosition(UINT32 textPosition,
                                                                   _Outptr_result_buffer_(*textLength) WCHAR const** textString,
@@ -126,7 +130,8 @@ namespace Microsoft::Console::Render
         void _OrderRuns();
 
         [[nodiscard]] HRESULT STDMETHODCALLTYPE _AnalyzeFontFallback(IDWriteTextAnalysisSource* const source, UINT32 textPosition, UINT32 textLength);
-        [[nodiscard]] HRESULT STDMETHODCALLTYPE _SetMappedFont(UINT32 textPosition, UINT32 textLength, IDWriteFont* const font, FLOAT const scale);
+        [[nodiscard]] HRESULT STDMETHODCALLTYPE _SetMappedFont(UINT32 textPosition, UINT32 textLength, _In_opt_ IDWriteFontFace1* const face, FLOAT const scale);
+        [[nodiscard]] std::pair<char32_t, UINT32> _StandaloneCodepointAt(const UINT32 textPosition, const UINT32 textLength) const;
 
         [[nodiscard]] HRESULT STDMETHODCALLTYPE _AnalyzeBoxDrawing(gsl::not_null<IDWriteTextAnalysisSource*> const source, UINT32 textPosition, UINT32 textLength);
         [[nodiscard]] HRESULT STDMETHODCALLTYPE _SetBoxEffect(UINT32 textPosition, UINT32 textLength);
@@ -148,6 +153,12 @@ namespace Microsoft::Console::Render
 
         [[nodiscard]] static constexpr UINT32 _EstimateGlyphCount(const UINT32 textLength) noexcept;
 
+        void _SelectFont(const bool useItalicFont);
+        [[nodiscard]] HRESULT _LayOut() noexcept;
+        [[nodiscard]] bool _LayOutAscii();
+        [[nodiscard]] bool _RestoreCachedLayout();
+        void _CacheLayout();
+
     private:
         // DirectWrite font render data
         DxFontRenderData* _fontRenderData;
@@ -206,6 +217,34 @@ namespace Microsoft::Console::Render
         // These are used to further break the runs apart and adjust the font size so glyphs fit inside the cells.
         std::vector<ScaleCorrection> _glyphScaleCorrections;
 
+        // The results of laying out text that was drawn before. Rows that didn't change are
+        // drawn again whenever the cursor blinks or the selection changes, and reusing their
+        // layout saves analyzing and shaping them again.
+        // The glyph scale corrections and box drawing effects have already been applied to
+        // the runs and glyphs, so those are all that's needed to draw.
+        struct CachedLayout
+        {
+            size_t hash;
+            size_t bytes;
+            IDWriteFontFace1* font;
+            std::wstring text;
+            std::vector<UINT16> textClusterColumns;
+            std::vector<LinkedRun> runs;
+            std::vector<UINT16> glyphIndices;
+            std::vector<UINT16> glyphClusters;
+            std::vector<float> glyphAdvances;
+            std::vector<DWRITE_GLYPH_OFFSET> glyphOffsets;
+        };
+
+        // Most recently used first. The least recently used layouts are dropped
+        // once they take up more than s_layoutCacheBudget bytes.
+        std::list<CachedLayout> _layoutCache;
+        std::unordered_multimap<size_t, std::list<CachedLayout>::iterator> _layoutCacheIndex;
+        size_t _layoutCacheBytes{ 0 };
+
+        [[nodiscard]] size_t _LayoutHash() const noexcept;
+        void _TrimLayoutCache() noexcept;
+
 #ifdef UNIT_TESTING
     public:
         CustomTextLayout() = default;
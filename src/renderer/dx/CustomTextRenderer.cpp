@@ -550,7 +550,10 @@ CATCH_RETURN()
     }
     rect.right = rect.left + totalSpan;
 
-    d2dContext->FillRectangle(rect, drawingContext->backgroundBrush);
+    if (drawingContext->paintBackground)
+    {
+        d2dContext->FillRectangle(rect, drawingContext->backgroundBrush);
+    }
 
     RETURN_IF_FAILED(_drawCursor(d2dContext.Get(), rect, *drawingContext, true));
 
@@ -764,6 +767,27 @@ try
 }
 CATCH_RETURN()
 
+// Routine Description:
+// - Draws the cursor of the drawing context on top of what's on the target,
+//   apart from any text. Cursors that go underneath the text aren't drawn.
+// Arguments:
+// - clientDrawingContext - Pointer to structure of information required to draw
+// Return Value:
+// - S_OK, S_FALSE if there's nothing to draw, or relevant DirectX error.
+[[nodiscard]] HRESULT CustomTextRenderer::DrawCursor(void* clientDrawingContext) noexcept
+try
+{
+    DrawingContext* drawingContext = static_cast<DrawingContext*>(clientDrawingContext);
+    RETURN_HR_IF(E_INVALIDARG, !drawingContext);
+
+    ::Microsoft::WRL::ComPtr<ID2D1DeviceContext> d2dContext;
+    RETURN_IF_FAILED(drawingContext->renderTarget->QueryInterface(d2dContext.GetAddressOf()));
+
+    const D2D1_RECT_F everywhere{ 0, 0, drawingContext->targetSize.width, drawingContext->targetSize.height };
+    return _drawCursor(d2dContext.Get(), everywhere, *drawingContext, false);
+}
+CATCH_RETURN()
+
 [[nodiscard]] HRESULT CustomTextRenderer::_DrawBasicGlyphRun(DrawingContext* clientDrawingContext,
                                                              D2D1_POINT_2F baselineOrigin,
                                                              DWRITE_MEASURING_MODE measuringMode,
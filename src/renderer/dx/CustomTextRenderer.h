@@ -31,7 +31,8 @@ namespace Microsoft::Console::Render
             cellSize(cellSize),
             targetSize(targetSize),
             cursorInfo(cursorInfo),
-            options(options)
+            options(options),
+            paintBackground(true)
         {
         }
 
@@ -46,6 +47,8 @@ namespace Microsoft::Console::Render
         D2D_SIZE_F targetSize;
         std::optional<CursorOptions> cursorInfo;
         D2D1_DRAW_TEXT_OPTIONS options;
+        // Whether each glyph run fills its background. DxEngine fills them on its own ahead of the text.
+        bool paintBackground;
     };
 
     // Helper to choose which Direct2D method to use when drawing the cursor rectangle
@@ -106,6 +109,8 @@ namespace Microsoft::Console::Render
 
         [[nodiscard]] HRESULT STDMETHODCALLTYPE EndClip(void* clientDrawingContext) noexcept;
 
+        [[nodiscard]] HRESULT DrawCursor(void* clientDrawingContext) noexcept;
+
     private:
         [[nodiscard]] HRESULT _FillRectangle(void* clientDrawingContext,
                                              IUnknown* clientDrawingEffect,
@@ -4,6 +4,7 @@
 #include "precomp.h"
 
 #include "DxFontRenderData.h"
+#include "FontCache.h"
 
 #include "unicode.hpp"
 
@@ -12,6 +13,7 @@
 static constexpr float POINTS_PER_INCH = 72.0f;
 static constexpr std::wstring_view FALLBACK_FONT_FACES[] = { L"Consolas", L"Lucida Console", L"Courier New" };
 static constexpr std::wstring_view FALLBACK_LOCALE = L"en-us";
+static constexpr size_t MAX_RECENT_FONTS = 4;
 
 using namespace Microsoft::Console::Render;
 
@@ -20,7 +22,8 @@ DxFontRenderData::DxFontRenderData(::Microsoft::WRL::ComPtr<IDWriteFactory1> dwr
     _fontSize{},
     _glyphCell{},
     _lineMetrics{},
-    _lineSpacing{}
+    _lineSpacing{},
+    _dpi{}
 {
 }
 
@@ -158,8 +161,9 @@ DxFontRenderData::DxFontRenderData(::Microsoft::WRL::ComPtr<IDWriteFactory1> dwr
     const auto fontFaceIt = _fontFaceMap.find(fontInfo);
     if (fontFaceIt == _fontFaceMap.end())
     {
+        // Other engines of the process have likely looked up the same font already.
         std::wstring fontLocaleName = UserLocaleName();
-        Microsoft::WRL::ComPtr<IDWriteFontFace1> fontFace = fontInfo.ResolveFontFaceWithFallback(_dwriteFactory.Get(), fontLocaleName);
+        Microsoft::WRL::ComPtr<IDWriteFontFace1> fontFace = FontCache::Instance().FontFace(fontInfo, _dwriteFactory.Get(), fontLocaleName);
 
         _fontFaceMap.insert({ fontInfo, fontFace });
         return fontFace;
@@ -170,8 +174,78 @@ DxFontRenderData::DxFontRenderData(::Microsoft::WRL::ComPtr<IDWriteFactory1> dwr
     }
 }
 
+// Routine Description:
+// - Gets the glyphs of the printable ASCII characters in the given font face.
+//   They're looked up once per face.
+// - The table is only handed out if DirectWrite considers all of ASCII to be simple text in
+//   the face. That isn't the case for fonts whose default OpenType features, like ligatures,
+//   may replace the glyphs, and text in those has to be shaped.
+// Arguments:
+// - face - a font face of this font, like the one returned by FontFaceWithAttribute
+// Return Value:
+// - The glyph of each character from ' ' to '~', or nullptr if the face doesn't allow that.
+[[nodiscard]] const DxFontRenderData::AsciiGlyphs* DxFontRenderData::AsciiGlyphIndices(IDWriteFontFace1* face)
+{
+    auto it = _asciiGlyphMap.find(face);
+    if (it == _asciiGlyphMap.end())
+    {
+        std::array<wchar_t, std::tuple_size_v<AsciiGlyphs>> ascii{};
+        std::iota(ascii.begin(), ascii.end(), L' ');
+
+        AsciiGlyphs glyphs{};
+        BOOL isTextSimple = FALSE;
+        UINT32 lengthRead = 0;
+        THROW_IF_FAILED(Analyzer()->GetTextComplexity(ascii.data(),
+                                                      gsl::narrow_cast<UINT32>(ascii.size()),
+                                                      face,
+                                                      &isTextSimple,
+                                                      &lengthRead,
+                                                      glyphs.data()));
+
+        // Glyph 0 means that the face doesn't have the character, which then needs font fallback.
+        std::optional<AsciiGlyphs> entry;
+        if (isTextSimple && lengthRead == ascii.size() && std::find(glyphs.begin(), glyphs.end(), UINT16{ 0 }) == glyphs.end())
+        {
+            entry = glyphs;
+        }
+
+        it = _asciiGlyphMap.emplace(face, entry).first;
+    }
+
+    return it->second ? &*it->second : nullptr;
+}
+
+// Routine Description:
+// - Builds everything that's otherwise built on demand, the first time text is laid out
+//   in the regular or the italic variant of the font.
+// - Laying out text in those only reads this afterwards, so that another thread may lay
+//   out text at the same time as the render thread, until the font is updated.
+void DxFontRenderData::PrepareForConcurrentLayout()
+{
+    (void)Analyzer();
+    (void)SystemFontFallback();
+    (void)DefaultBoxDrawingEffect();
+
+    for (const auto style : { DefaultFontStyle(), DWRITE_FONT_STYLE_ITALIC })
+    {
+        (void)TextFormatWithAttribute(DefaultFontWeight(), style, DefaultFontStretch());
+        const auto face = FontFaceWithAttribute(DefaultFontWeight(), style, DefaultFontStretch());
+        (void)AsciiGlyphIndices(face.Get());
+    }
+}
+
+// Routine Description:
+// - Drops what was built for the fonts that were used before the current one.
+void DxFontRenderData::Trim() noexcept
+{
+    _recentFonts.clear();
+}
+
 // Routine Description:
 // - Updates the font used for drawing
+// - What was built for the previous font is kept with the few fonts that were used
+//   before it. If the new font is one of them, it's taken from there instead of being
+//   built again, which makes stepping back and forth between font sizes cheap.
 // Arguments:
 // - desired - Information specifying the font that is requested
 // - actual - Filled with the nearest font actually chosen for drawing
@@ -182,24 +256,101 @@ DxFontRenderData::DxFontRenderData(::Microsoft::WRL::ComPtr<IDWriteFactory1> dwr
 {
     try
     {
+        if (_desired)
+        {
+            FontState previous;
+            previous.desired = std::exchange(_desired, std::nullopt);
+            previous.dpi = _dpi;
+            previous.localeName = _userLocaleName;
+            _SwapFontState(previous);
+            _recentFonts.push_front(std::move(previous));
+        }
+
         _userLocaleName.clear();
-        _textFormatMap.clear();
-        _fontFaceMap.clear();
-        _boxDrawingEffect.Reset();
+        const auto localeName = UserLocaleName();
 
-        // Initialize the default font info and build everything from here.
-        _defaultFontInfo = DxFontInfo(desired.GetFaceName(),
-                                      desired.GetWeight(),
-                                      DWRITE_FONT_STYLE_NORMAL,
-                                      DWRITE_FONT_STRETCH_NORMAL);
+        const auto recent = std::find_if(_recentFonts.begin(), _recentFonts.end(), [&](const FontState& state) {
+            return *state.desired == desired && state.dpi == dpi && state.localeName == localeName;
+        });
+        if (recent != _recentFonts.end())
+        {
+            _SwapFontState(*recent);
+            _recentFonts.erase(recent);
+            _SetActualFont(desired, actual, _glyphCell);
+        }
+        else
+        {
+            if (_recentFonts.size() > MAX_RECENT_FONTS)
+            {
+                _recentFonts.pop_back();
+            }
+
+            _textFormatMap.clear();
+            _fontFaceMap.clear();
+            _asciiGlyphMap.clear();
+            _boxDrawingEffect.Reset();
+
+            // Initialize the default font info and build everything from here.
+            _defaultFontInfo = DxFontInfo(desired.GetFaceName(),
+                                          desired.GetWeight(),
+                                          DWRITE_FONT_STYLE_NORMAL,
+                                          DWRITE_FONT_STRETCH_NORMAL);
+
+            _BuildFontRenderData(desired, actual, dpi);
+        }
 
-        _BuildFontRenderData(desired, actual, dpi);
+        _desired = desired;
+        _dpi = dpi;
     }
     CATCH_RETURN();
 
     return S_OK;
 }
 
+// Routine Description:
+// - Exchanges what's built for the current font with the given state.
+// Arguments:
+// - state - what was built for another font, or an empty state to take the current one out
+// Return Value:
+// - None
+void DxFontRenderData::_SwapFontState(FontState& state) noexcept
+{
+    std::swap(_textFormatMap, state.textFormatMap);
+    std::swap(_fontFaceMap, state.fontFaceMap);
+    std::swap(_asciiGlyphMap, state.asciiGlyphMap);
+    std::swap(_boxDrawingEffect, state.boxDrawingEffect);
+    std::swap(_defaultFontInfo, state.defaultFontInfo);
+    std::swap(_fontSize, state.fontSize);
+    std::swap(_glyphCell, state.glyphCell);
+    std::swap(_lineSpacing, state.lineSpacing);
+    std::swap(_lineMetrics, state.lineMetrics);
+}
+
+// Routine Description:
+// - Fills in the font that was actually chosen, from what's been built for it.
+// Arguments:
+// - desired - Information specifying the font that is requested
+// - actual - Filled with the nearest font actually chosen for drawing
+// - scaled - The size of a cell in pixels
+// Return Value:
+// - None
+void DxFontRenderData::_SetActualFont(const FontInfoDesired& desired, FontInfo& actual, const COORD scaled)
+{
+    // Unscaled is for the purposes of re-communicating this font back to the renderer again later.
+    // As such, we need to give the same original size parameter back here without padding
+    // or rounding or scaling manipulation.
+    const COORD unscaled = desired.GetEngineSize();
+
+    actual.SetFromEngine(_defaultFontInfo.GetFamilyName(),
+                         desired.GetFamily(),
+                         DefaultTextFormat()->GetFontWeight(),
+                         false,
+                         scaled,
+                         unscaled);
+
+    actual.SetFallback(_defaultFontInfo.GetFallback());
+}
+
 // Routine Description:
 // - Calculates the box drawing scale/translate matrix values to fit a box glyph into the cell as perfectly as possible.
 // Arguments:
@@ -569,21 +720,7 @@ void DxFontRenderData::_BuildFontRenderData(const FontInfoDesired& desired, Font
     coordSize.X = gsl::narrow<SHORT>(widthExact);
     coordSize.Y = gsl::narrow_cast<SHORT>(lineSpacing.height);
 
-    // Unscaled is for the purposes of re-communicating this font back to the renderer again later.
-    // As such, we need to give the same original size parameter back here without padding
-    // or rounding or scaling manipulation.
-    const COORD unscaled = desired.GetEngineSize();
-
-    const COORD scaled = coordSize;
-
-    actual.SetFromEngine(_defaultFontInfo.GetFamilyName(),
-                         desired.GetFamily(),
-                         DefaultTextFormat()->GetFontWeight(),
-                         false,
-                         scaled,
-                         unscaled);
-
-    actual.SetFallback(_defaultFontInfo.GetFallback());
+    _SetActualFont(desired, actual, coordSize);
 
     LineMetrics lineMetrics;
     // There is no font metric for the grid line width, so we use a small
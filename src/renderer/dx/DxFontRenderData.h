@@ -29,6 +29,9 @@ namespace Microsoft::Console::Render
             float strikethroughWidth;
         };
 
+        // The glyphs of the printable ASCII characters, from ' ' to '~'.
+        using AsciiGlyphs = std::array<UINT16, 95>;
+
         DxFontRenderData(::Microsoft::WRL::ComPtr<IDWriteFactory1> dwriteFactory) noexcept;
 
         // DirectWrite text analyzer from the factory
@@ -70,11 +73,37 @@ namespace Microsoft::Console::Render
                                                                                      DWRITE_FONT_STYLE style,
                                                                                      DWRITE_FONT_STRETCH stretch);
 
+        // The ASCII glyphs of a font face, if ASCII text can be drawn with them without being shaped
+        [[nodiscard]] const AsciiGlyphs* AsciiGlyphIndices(IDWriteFontFace1* face);
+
+        // Builds what laying out text in the regular and the italic font builds on demand
+        void PrepareForConcurrentLayout();
+
         [[nodiscard]] HRESULT UpdateFont(const FontInfoDesired& desired, FontInfo& fiFontInfo, const int dpi) noexcept;
+        void Trim() noexcept;
 
         [[nodiscard]] static HRESULT STDMETHODCALLTYPE s_CalculateBoxEffect(IDWriteTextFormat* format, size_t widthPixels, IDWriteFontFace1* face, float fontScale, IBoxDrawingEffect** effect) noexcept;
 
     private:
+        // What's built for a font, kept for the fonts that were used last.
+        struct FontState
+        {
+            std::optional<FontInfoDesired> desired;
+            int dpi{};
+            std::wstring localeName;
+            std::unordered_map<DxFontInfo, ::Microsoft::WRL::ComPtr<IDWriteTextFormat>> textFormatMap;
+            std::unordered_map<DxFontInfo, ::Microsoft::WRL::ComPtr<IDWriteFontFace1>> fontFaceMap;
+            std::unordered_map<IDWriteFontFace1*, std::optional<AsciiGlyphs>> asciiGlyphMap;
+            ::Microsoft::WRL::ComPtr<IBoxDrawingEffect> boxDrawingEffect;
+            DxFontInfo defaultFontInfo;
+            float fontSize{};
+            til::size glyphCell;
+            DWRITE_LINE_SPACING lineSpacing{};
+            LineMetrics lineMetrics{};
+        };
+
+        void _SwapFontState(FontState& state) noexcept;
+        void _SetActualFont(const FontInfoDesired& desired, FontInfo& actual, const COORD scaled);
         void _BuildFontRenderData(const FontInfoDesired& desired, FontInfo& actual, const int dpi);
         Microsoft::WRL::ComPtr<IDWriteTextFormat> _BuildTextFormat(const DxFontInfo fontInfo, const std::wstring_view localeName);
 
@@ -84,6 +113,7 @@ namespace Microsoft::Console::Render
 
         std::unordered_map<DxFontInfo, ::Microsoft::WRL::ComPtr<IDWriteTextFormat>> _textFormatMap;
         std::unordered_map<DxFontInfo, ::Microsoft::WRL::ComPtr<IDWriteFontFace1>> _fontFaceMap;
+        std::unordered_map<IDWriteFontFace1*, std::optional<AsciiGlyphs>> _asciiGlyphMap;
 
         ::Microsoft::WRL::ComPtr<IBoxDrawingEffect> _boxDrawingEffect;
 
@@ -96,5 +126,14 @@ namespace Microsoft::Console::Render
         til::size _glyphCell;
         DWRITE_LINE_SPACING _lineSpacing;
         LineMetrics _lineMetrics;
+
+        // The font the above was built for, which is kept in _recentFonts when another one is used.
+        std::optional<FontInfoDesired> _desired;
+        int _dpi;
+
+        // The fonts that were used before the current one, the most recent first.
+        // Zooming in and out steps back and forth between a few sizes, which then don't
+        // need their formats, faces and box drawing effects to be built again.
+        std::list<FontState> _recentFonts;
     };
 }
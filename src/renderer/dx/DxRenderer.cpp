@@ -10,17 +10,20 @@
 #include "../../types/inc/Viewport.hpp"
 #include "../../inc/unicode.hpp"
 #include "../../inc/DefaultSettings.h"
+#include "../../inc/StartupTracing.h"
 #include <VersionHelpers.h>
 
 #include "ScreenPixelShader.h"
 #include "ScreenVertexShader.h"
 #include <DirectXMath.h>
 #include <d3dcompiler.h>
+#include <d3d11shader.h>
 #include <DirectXColors.h>
 
 using namespace DirectX;
 
 std::atomic<size_t> Microsoft::Console::Render::DxEngine::_tracelogCount{ 0 };
+std::atomic<bool> Microsoft::Console::Render::DxEngine::_presentedFirstFrame{ false };
 #pragma warning(suppress : 26477) // We don't control tracelogging macros
 TRACELOGGING_DEFINE_PROVIDER(g_hDxRenderProvider,
                              "Microsoft.Windows.Terminal.Renderer.DirectX",
@@ -67,11 +70,13 @@ DxEngine::DxEngine() :
     _invalidScroll{},
     _allInvalid{ false },
     _firstFrame{ true },
+    _occluded{ false },
     _presentParams{ 0 },
     _presentReady{ false },
     _presentScroll{ 0 },
     _presentDirty{ 0 },
     _presentOffset{ 0 },
+    _staleAll{ false },
     _isEnabled{ false },
     _isPainting{ false },
     _displaySizePixels{},
@@ -86,8 +91,16 @@ DxEngine::DxEngine() :
     _terminalEffectsEnabled{ false },
     _retroTerminalEffect{ false },
     _pixelShaderPath{},
+    _pixelShaderFrameRate{ 0 },
     _forceFullRepaintRendering{ false },
     _softwareRendering{ false },
+    _gpuPreference{ DXGI_GPU_PREFERENCE_UNSPECIFIED },
+    _powerSaving{ false },
+    _frameTimeOverlay{ false },
+    _glyphAtlasRendering{ false },
+    _smoothScrolling{ false },
+    _smoothScrollOffset{ 0.0f },
+    _swapChainTransformChanged{ false },
     _antialiasingMode{ D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE },
     _defaultTextBackgroundOpacity{ 1.0f },
     _hwndTarget{ static_cast<HWND>(INVALID_HANDLE_VALUE) },
@@ -106,7 +119,7 @@ DxEngine::DxEngine() :
         TraceLoggingRegister(g_hDxRenderProvider);
     }
 
-    THROW_IF_FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, IID_PPV_ARGS(&_d2dFactory)));
+    _d2dFactory = SharedDevice::Factory();
 
     THROW_IF_FAILED(DWriteCreateFactory(
         DWRITE_FACTORY_TYPE_SHARED,
@@ -124,6 +137,7 @@ DxEngine::DxEngine() :
 // - Destroys an instance of the DirectX rendering engine
 DxEngine::~DxEngine()
 {
+    _CancelPrefetch();
     _ReleaseDeviceResources();
 
     const auto was = _tracelogCount.fetch_sub(1);
@@ -229,6 +243,35 @@ _CompileShader(
 #endif
 }
 
+// Routine Description:
+// - Checks whether a compiled pixel shader reads the Time of its settings,
+//   which is how a shader tells us that it's animated.
+// Arguments:
+// - code - the compiled shader
+// Return Value:
+// - True if the shader uses the time, or if we can't tell.
+static bool _UsesTime(ID3DBlob* const code) noexcept
+{
+#if !TIL_FEATURE_DXENGINESHADERSUPPORT_ENABLED
+    UNREFERENCED_PARAMETER(code);
+    return true;
+#else
+    Microsoft::WRL::ComPtr<ID3D11ShaderReflection> reflection;
+    if (FAILED(D3DReflect(code->GetBufferPointer(), code->GetBufferSize(), IID_PPV_ARGS(&reflection))))
+    {
+        return true;
+    }
+
+    // GetVariableByName returns a placeholder that fails GetDesc if there's no such variable.
+    D3D11_SHADER_VARIABLE_DESC desc{};
+    if (FAILED(reflection->GetVariableByName("Time")->GetDesc(&desc)))
+    {
+        return false;
+    }
+    return WI_IsFlagSet(desc.uFlags, D3D_SVF_USED);
+#endif
+}
+
 // Routine Description:
 // - Checks if terminal effects are enabled.
 // Arguments:
@@ -236,7 +279,7 @@ _CompileShader(
 // - True if terminal effects are enabled
 bool DxEngine::_HasTerminalEffects() const noexcept
 {
-    return _terminalEffectsEnabled && (_retroTerminalEffect || !_pixelShaderPath.empty());
+    return _terminalEffectsEnabled && !_powerSaving && (_retroTerminalEffect || !_pixelShaderPath.empty());
 }
 
 // Routine Description:
@@ -340,16 +383,6 @@ HRESULT DxEngine::_SetupTerminalEffects()
     WI_SetFlag(framebufferCaptureDesc.BindFlags, D3D11_BIND_SHADER_RESOURCE);
     RETURN_IF_FAILED(_d3dDevice->CreateTexture2D(&framebufferCaptureDesc, nullptr, &_framebufferCapture));
 
-    // Setup the viewport.
-    D3D11_VIEWPORT vp;
-    vp.Width = _displaySizePixels.width<float>();
-    vp.Height = _displaySizePixels.height<float>();
-    vp.MinDepth = 0.0f;
-    vp.MaxDepth = 1.0f;
-    vp.TopLeftX = 0;
-    vp.TopLeftY = 0;
-    _d3dDeviceContext->RSSetViewports(1, &vp);
-
     // Prepare shaders.
     auto vertexBlob = _CompileShader(screenVertexShaderString, "vs_5_0");
     Microsoft::WRL::ComPtr<ID3DBlob> pixelBlob;
@@ -385,6 +418,8 @@ HRESULT DxEngine::_SetupTerminalEffects()
         nullptr,
         &_pixelShader));
 
+    _pixelShaderAnimated = _UsesTime(pixelBlob.Get());
+
     RETURN_IF_FAILED(_d3dDevice->CreateInputLayout(
         static_cast<const D3D11_INPUT_ELEMENT_DESC*>(_shaderInputLayout),
         ARRAYSIZE(_shaderInputLayout),
@@ -473,6 +508,7 @@ void DxEngine::_ComputePixelShaderSettings() noexcept
             background.w = _backgroundColor.a;
             _pixelShaderSettings.Background = background;
 
+            const auto lock = _sharedDevice->Lock();
             _d3dDeviceContext->UpdateSubresource(_pixelShaderSettingsBuffer.Get(), 0, nullptr, &_pixelShaderSettings, 0, 0);
         }
         CATCH_LOG();
@@ -522,72 +558,21 @@ try
         _ReleaseDeviceResources();
     }
 
-    auto freeOnFail = wil::scope_exit([&]() noexcept { _ReleaseDeviceResources(); });
+    TRACE_STARTUP_PHASE(g_hDxRenderProvider, "DxDevice");
 
-    RETURN_IF_FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&_dxgiFactory2)));
-
-    const DWORD DeviceFlags = D3D11_CREATE_DEVICE_BGRA_SUPPORT |
-                              // clang-format off
-// This causes problems for folks who do not have the whole DirectX SDK installed
-// when they try to run the rest of the project in debug mode.
-// As such, I'm leaving this flag here for people doing DX-specific work to toggle it
-// only when they need it and shutting it off otherwise.
-// Find out more about the debug layer here:
-// https://docs.microsoft.com/en-us/windows/desktop/direct3d11/overviews-direct3d-11-devices-layers
-// You can find out how to install it here:
-// https://docs.microsoft.com/en-us/windows/uwp/gaming/use-the-directx-runtime-and-visual-studio-graphics-diagnostic-features
-                              // clang-format on
-                              // D3D11_CREATE_DEVICE_DEBUG |
-                              D3D11_CREATE_DEVICE_SINGLETHREADED;
-
-    const std::array<D3D_FEATURE_LEVEL, 5> FeatureLevels{ D3D_FEATURE_LEVEL_11_1,
-                                                          D3D_FEATURE_LEVEL_11_0,
-                                                          D3D_FEATURE_LEVEL_10_1,
-                                                          D3D_FEATURE_LEVEL_10_0,
-                                                          D3D_FEATURE_LEVEL_9_1 };
-
-    // Trying hardware first for maximum performance, then trying WARP (software) renderer second
-    // in case we're running inside a downlevel VM where hardware passthrough isn't enabled like
-    // for Windows 7 in a VM.
-    HRESULT hardwareResult = E_NOT_SET;
-
-    // If we're not forcing software rendering, try hardware first.
-    // Otherwise, let the error state fall down and create with the software renderer directly.
-    if (!_softwareRendering)
-    {
-        hardwareResult = D3D11CreateDevice(nullptr,
-                                           D3D_DRIVER_TYPE_HARDWARE,
-                                           nullptr,
-                                           DeviceFlags,
-                                           FeatureLevels.data(),
-                                           gsl::narrow_cast<UINT>(FeatureLevels.size()),
-                                           D3D11_SDK_VERSION,
-                                           &_d3dDevice,
-                                           nullptr,
-                                           &_d3dDeviceContext);
-    }
-
-    if (FAILED(hardwareResult))
-    {
-        RETURN_IF_FAILED(D3D11CreateDevice(nullptr,
-                                           D3D_DRIVER_TYPE_WARP,
-                                           nullptr,
-                                           DeviceFlags,
-                                           FeatureLevels.data(),
-                                           gsl::narrow_cast<UINT>(FeatureLevels.size()),
-                                           D3D11_SDK_VERSION,
-                                           &_d3dDevice,
-                                           nullptr,
-                                           &_d3dDeviceContext));
-    }
+    auto freeOnFail = wil::scope_exit([&]() noexcept { _ReleaseDeviceResources(); });
 
-    _displaySizePixels = _GetClientSize();
+    // The devices are shared with all other engines of the process. Only the
+    // swap chain and what's drawn on it with the device context is our own.
+    RETURN_IF_FAILED(SharedDevice::Acquire(_softwareRendering, _gpuPreference, _sharedDevice));
 
-    // Get the other device types so we have deeper access to more functionality
-    // in our pipeline than by just walking straight from the D3D device.
+    _dxgiFactory2 = _sharedDevice->DxgiFactory();
+    _d3dDevice = _sharedDevice->D3DDevice();
+    _d3dDeviceContext = _sharedDevice->D3DDeviceContext();
+    _dxgiDevice = _sharedDevice->DxgiDevice();
+    _d2dDevice = _sharedDevice->D2DDevice();
 
-    RETURN_IF_FAILED(_d3dDevice.As(&_dxgiDevice));
-    RETURN_IF_FAILED(_d2dFactory->CreateDevice(_dxgiDevice.Get(), _d2dDevice.ReleaseAndGetAddressOf()));
+    _displaySizePixels = _GetClientSize();
 
     // Create a device context out of it (supercedes render targets)
     RETURN_IF_FAILED(_d2dDevice->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &_d2dDeviceContext));
@@ -769,6 +754,9 @@ static constexpr D2D1_ALPHA_MODE _dxgiAlphaToD2d1Alpha(DXGI_ALPHA_MODE mode) noe
 
         _d2dDeviceContext->SetTarget(_d2dBitmap.Get());
 
+        // The text goes into a layer of its own though, which is then composited onto the bitmap.
+        RETURN_IF_FAILED(_CreateTextLayers());
+
         // We need the AntialiasMode for non-text object to be Aliased to ensure
         //  that background boxes line up with each other and don't leave behind
         //  stray colors.
@@ -809,17 +797,7 @@ static constexpr D2D1_ALPHA_MODE _dxgiAlphaToD2d1Alpha(DXGI_ALPHA_MODE mode) noe
         RETURN_IF_FAILED(_d2dFactory->CreateStrokeStyle(&_dashStrokeStyleProperties, hyperlinkDashes.data(), gsl::narrow_cast<UINT32>(hyperlinkDashes.size()), &_dashStrokeStyle));
         _hyperlinkStrokeStyle = _dashStrokeStyle;
 
-        // If in composition mode, apply scaling factor matrix
-        if (_chainMode == SwapChainMode::ForComposition)
-        {
-            DXGI_MATRIX_3X2_F inverseScale = { 0 };
-            inverseScale._11 = 1.0f / _scale;
-            inverseScale._22 = inverseScale._11;
-
-            ::Microsoft::WRL::ComPtr<IDXGISwapChain2> sc2;
-            RETURN_IF_FAILED(_dxgiSwapChain.As(&sc2));
-            RETURN_IF_FAILED(sc2->SetMatrixTransform(&inverseScale));
-        }
+        RETURN_IF_FAILED(_ApplySwapChainTransform());
 
         _prevScale = _scale;
         return S_OK;
@@ -827,6 +805,34 @@ static constexpr D2D1_ALPHA_MODE _dxgiAlphaToD2d1Alpha(DXGI_ALPHA_MODE mode) noe
     CATCH_RETURN();
 }
 
+// Routine Description:
+// - In composition mode, scales the swap chain by the inverse of the scaling
+//   factor and moves it up by the smooth scroll offset. Moving it is done by
+//   the compositor, so the text doesn't have to be drawn again for it.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error.
+[[nodiscard]] HRESULT DxEngine::_ApplySwapChainTransform() noexcept
+try
+{
+    if (_chainMode == SwapChainMode::ForComposition)
+    {
+        DXGI_MATRIX_3X2_F transform = { 0 };
+        transform._11 = 1.0f / _scale;
+        transform._22 = transform._11;
+        transform._32 = -_smoothScrollOffset * _fontRenderData->GlyphCell().height<float>() / _scale;
+
+        ::Microsoft::WRL::ComPtr<IDXGISwapChain2> sc2;
+        RETURN_IF_FAILED(_dxgiSwapChain.As(&sc2));
+        RETURN_IF_FAILED(sc2->SetMatrixTransform(&transform));
+    }
+
+    _swapChainTransformChanged = false;
+    return S_OK;
+}
+CATCH_RETURN();
+
 // Routine Description:
 // - Releases device-specific resources (typically held on the GPU)
 // Arguments:
@@ -854,6 +860,21 @@ void DxEngine::_ReleaseDeviceResources() noexcept
 
         _d2dBitmap.Reset();
 
+        for (auto& layer : _textLayers)
+        {
+            layer.Reset();
+        }
+        _drawnOverlays = {};
+
+        _glyphAtlas.ReleaseDeviceResources();
+        _imageBitmaps.clear();
+
+        // Whatever was queued for the frame won't be drawn anymore.
+        _deferredBackgrounds.clear();
+        _deferredText.clear();
+        _deferredClusters.clear();
+        _deferredLines.clear();
+
         if (nullptr != _d2dDeviceContext.Get() && _isPainting)
         {
             _d2dDeviceContext->EndDraw();
@@ -871,14 +892,19 @@ void DxEngine::_ReleaseDeviceResources() noexcept
         if (nullptr != _d3dDeviceContext.Get())
         {
             // To ensure the swap chain goes away we must unbind any views from the
-            // D3D pipeline
+            // D3D pipeline. The other engines bind their own again for every frame.
+            ID3D11ShaderResourceView* const noShaderResources[1]{};
+            const auto lock = _sharedDevice->Lock();
             _d3dDeviceContext->OMSetRenderTargets(0, nullptr, nullptr);
+            _d3dDeviceContext->PSSetShaderResources(0, 1, noShaderResources);
         }
         _d3dDeviceContext.Reset();
 
         _d3dDevice.Reset();
 
         _dxgiFactory2.Reset();
+
+        _sharedDevice.reset();
     }
     CATCH_LOG();
 }
@@ -964,7 +990,7 @@ try
 {
     _sizeTarget = Pixels;
 
-    _invalidMap.resize(_sizeTarget / _fontRenderData->GlyphCell(), true);
+    _invalidMap.resize((_sizeTarget + _GetOverscanSize()) / _fontRenderData->GlyphCell(), true);
     return S_OK;
 }
 CATCH_RETURN();
@@ -1012,6 +1038,18 @@ try
 }
 CATCH_LOG()
 
+// Routine Description:
+// - Sets the frame rate animated pixel shaders are limited to. Shaders that
+//   don't use the time are only run when the contents change anyways.
+// Arguments:
+// - framesPerSecond - the frame rate, or 0 to run them at every refresh of the display.
+// Return Value:
+// - <none>
+void DxEngine::SetPixelShaderFrameRate(const int framesPerSecond) noexcept
+{
+    _pixelShaderFrameRate = std::max(0, framesPerSecond);
+}
+
 void DxEngine::SetForceFullRepaintRendering(bool enable) noexcept
 try
 {
@@ -1035,6 +1073,149 @@ try
 }
 CATCH_LOG()
 
+// Routine Description:
+// - Chooses the adapter the device is created on, on machines with more than
+//   one GPU, like an integrated and a discrete one. With the default, DXGI
+//   goes by what the user picked for the app in the graphics settings.
+// Arguments:
+// - preference - whether to prefer the adapter that draws the least power,
+//   the fastest one, or neither
+// Return Value:
+// - <none>
+void DxEngine::SetGpuPreference(const DXGI_GPU_PREFERENCE preference) noexcept
+try
+{
+    if (_gpuPreference != preference)
+    {
+        _gpuPreference = preference;
+        _recreateDeviceRequested = true;
+        LOG_IF_FAILED(InvalidateAll());
+    }
+}
+CATCH_LOG()
+
+// Routine Description:
+// - Turns the pixel shaders off while power is to be saved, like while the
+//   battery saver is on. They're often animated, and they make every frame
+//   a full one. They're set up again with the device once this is turned off.
+// Arguments:
+// - enable - whether to save power
+// Return Value:
+// - <none>
+void DxEngine::SetPowerSaving(const bool enable) noexcept
+try
+{
+    if (_powerSaving != enable)
+    {
+        _powerSaving = enable;
+        _recreateDeviceRequested = true;
+        LOG_IF_FAILED(InvalidateAll());
+    }
+}
+CATCH_LOG()
+
+// Routine Description:
+// - Enables or disables drawing how long the last frame took in the top right corner.
+//   It's only updated when something else causes a frame to be painted.
+// Arguments:
+// - enable - whether to draw the frame times
+// Return Value:
+// - <none>
+void DxEngine::SetFrameTimeOverlay(bool enable) noexcept
+try
+{
+    if (_frameTimeOverlay != enable)
+    {
+        _frameTimeOverlay = enable;
+        LOG_IF_FAILED(InvalidateAll());
+    }
+}
+CATCH_LOG()
+
+// Routine Description:
+// - Sets the lines drawn below the frame times in the overlay, like the
+//   statistics of the terminal. They're painted with the next frame.
+// - Must be called on the render thread, like from the renderer's frame
+//   painted callback, since it's read while painting.
+// Arguments:
+// - text - the lines to draw, separated by \n
+// Return Value:
+// - <none>
+void DxEngine::SetFrameTimeOverlayText(const std::wstring_view text)
+{
+    // The overlay changes its size along with the number of lines,
+    // and the cells its larger self was drawn over have to be repainted.
+    const auto resized = std::count(text.begin(), text.end(), L'\n') != std::count(_frameTimeOverlayText.begin(), _frameTimeOverlayText.end(), L'\n') ||
+                         text.empty() != _frameTimeOverlayText.empty();
+    _frameTimeOverlayText = text;
+    if (_frameTimeOverlay && resized)
+    {
+        LOG_IF_FAILED(InvalidateAll());
+    }
+}
+
+// Routine Description:
+// - Enables or disables drawing simple text out of a texture of glyphs,
+//   each of which is rasterized only once, instead of laying it out every frame.
+// Arguments:
+// - enable - whether to draw text with the glyph atlas
+// Return Value:
+// - <none>
+void DxEngine::SetGlyphAtlasRendering(bool enable) noexcept
+try
+{
+    if (_glyphAtlasRendering != enable)
+    {
+        _glyphAtlasRendering = enable;
+        LOG_IF_FAILED(InvalidateAll());
+    }
+}
+CATCH_LOG()
+
+// Routine Description:
+// - Enables or disables smooth scrolling. The swap chain of a composition
+//   target gets one more row at the bottom, so that it can be moved up by
+//   less than a row (see SetSmoothScrollOffset) without a gap showing
+//   below the text. The renderer has to paint that row as well.
+// Arguments:
+// - enable - whether to make room for smooth scrolling
+// Return Value:
+// - <none>
+void DxEngine::SetSmoothScrolling(bool enable) noexcept
+try
+{
+    if (_smoothScrolling != enable)
+    {
+        _smoothScrolling = enable;
+        _smoothScrollOffset = 0.0f;
+        _swapChainTransformChanged = true;
+        LOG_IF_FAILED(SetWindowSize(_sizeTarget));
+    }
+}
+CATCH_LOG()
+
+// Routine Description:
+// - Moves the contents of the swap chain up by a fraction of a row, on the
+//   GPU. The text itself stays where it is and isn't drawn again, which
+//   makes scrolling by less than a row as cheap as it gets.
+// - It's only used with smooth scrolling, which makes room for it.
+// Arguments:
+// - offset - the fraction of a row to move up by, from 0 to 1
+// Return Value:
+// - S_OK, or S_FALSE if there's nothing to move
+[[nodiscard]] HRESULT DxEngine::SetSmoothScrollOffset(const float offset) noexcept
+{
+    const auto clamped = _smoothScrolling ? std::clamp(offset, 0.0f, 1.0f) : 0.0f;
+    if (_smoothScrollOffset == clamped)
+    {
+        return S_FALSE;
+    }
+
+    _smoothScrollOffset = clamped;
+    _swapChainTransformChanged = true;
+    return S_OK;
+}
+
 HANDLE DxEngine::GetSwapChainHandle()
 {
     if (!_swapChainHandle)
@@ -1083,13 +1264,18 @@ try
 CATCH_RETURN()
 
 // Routine Description:
-// - Invalidates the cells of the cursor
+// - Invalidates the cells of the cursor, unless it's drawn over the text layer.
+//   Those cells are composited again on their own once the cursor changes.
 // Arguments:
 // - psrRegion - the region covered by the cursor
 // Return Value:
 // - S_OK
 [[nodiscard]] HRESULT DxEngine::InvalidateCursor(const SMALL_RECT* const psrRegion) noexcept
 {
+    if (_textLayers[0] && _cursorInOverlay)
+    {
+        return S_OK;
+    }
     return Invalidate(psrRegion);
 }
 
@@ -1116,14 +1302,15 @@ try
 CATCH_RETURN();
 
 // Routine Description:
-// - Invalidates a series of character rectangles
+// - Invalidates a series of character rectangles, unless the selection is drawn over the
+//   text layer. The cells beneath it are composited again on their own once it changes.
 // Arguments:
 // - rectangles - One or more rectangles describing character positions on the grid
 // Return Value:
 // - S_OK
 [[nodiscard]] HRESULT DxEngine::InvalidateSelection(const std::vector<SMALL_RECT>& rectangles) noexcept
 {
-    if (!_allInvalid)
+    if (!_allInvalid && !_textLayers[0])
     {
         for (const auto& rect : rectangles)
         {
@@ -1221,13 +1408,26 @@ CATCH_RETURN();
     }
     case SwapChainMode::ForComposition:
     {
-        return _sizeTarget;
+        return _sizeTarget + _GetOverscanSize();
     }
     default:
         FAIL_FAST_HR(E_NOTIMPL);
     }
 }
 
+// Routine Description:
+// - Gets how much larger than the target the swap chain is. With smooth
+//   scrolling, it has one more row at the bottom, which moves into view
+//   as the swap chain is moved up by the smooth scroll offset.
+// Arguments:
+// - <none>
+// Return Value:
+// - The additional size in pixels
+[[nodiscard]] til::size DxEngine::_GetOverscanSize() const noexcept
+{
+    return { 0, _smoothScrolling ? _fontRenderData->GlyphCell().height() : 0 };
+}
+
 // Routine Description:
 // - Helper to multiply all parameters of a rectangle by the font size
 //   to convert from characters to pixels.
@@ -1269,6 +1469,32 @@ try
 {
     RETURN_HR_IF(E_NOT_VALID_STATE, _isPainting); // invalid to start a paint while painting.
 
+    // While the window is occluded, nothing we'd paint could be seen. The invalid
+    // regions are left as they are and painted in one go once it's visible again.
+    if (_occluded && _haveDeviceResources && !_recreateDeviceRequested)
+    {
+        const auto lock = _sharedDevice->Lock();
+        if (_dxgiSwapChain->Present(0, DXGI_PRESENT_TEST) == DXGI_STATUS_OCCLUDED)
+        {
+            return S_FALSE;
+        }
+
+        // The frames presented while occluded were never shown, so
+        // presenting only what changed since then isn't enough.
+        _occluded = false;
+        _firstFrame = true;
+    }
+
+    _frameStartTime = std::chrono::steady_clock::now();
+
+    _AdoptPrefetchedLayouts();
+
+    // The frame times change with every frame, so the cells beneath them always need to be repainted.
+    if (_frameTimeOverlay && _invalidMap.any())
+    {
+        _InvalidateRectangle(_FrameTimeOverlayRect());
+    }
+
     // If full repaints are needed then we need to invalidate everything
     // so the entire frame is repainted.
     if (_FullRepaintNeeded())
@@ -1293,11 +1519,19 @@ try
     {
         const auto clientSize = _GetClientSize();
 
+        // If another engine found the shared device lost, we need to move on to the new one as well.
+        if (_haveDeviceResources && _sharedDevice->IsLost())
+        {
+            _recreateDeviceRequested = true;
+        }
+
         // If we don't have device resources or if someone has requested that we
         // recreate the device... then make new resources. (Create will dump the old ones.)
         if (!_haveDeviceResources || _recreateDeviceRequested)
         {
             RETURN_IF_FAILED(_CreateDeviceResources(true));
+            _staleRects.clear();
+            _staleAll = false;
         }
         else if (_displaySizePixels != clientSize || _prevScale != _scale)
         {
@@ -1313,6 +1547,7 @@ try
             _d2dBitmap.Reset();
 
             // Change the buffer size and recreate the render target (and surface)
+            const auto lock = _sharedDevice->Lock();
             RETURN_IF_FAILED(_dxgiSwapChain->ResizeBuffers(2, clientSize.width<UINT>(), clientSize.height<UINT>(), _swapChainDesc.Format, _swapChainDesc.Flags));
             RETURN_IF_FAILED(_PrepareRenderTarget());
 
@@ -1324,11 +1559,31 @@ try
 
             // Mark this as the first frame on the new target. We can't use incremental drawing on the first frame.
             _firstFrame = true;
+
+            // The buffers were resized, so there's nothing to catch up on either.
+            _staleRects.clear();
+            _staleAll = false;
+        }
+        else if (_swapChainTransformChanged)
+        {
+            RETURN_IF_FAILED(_ApplySwapChainTransform());
         }
 
+        RETURN_IF_FAILED(_CatchUpBackBuffer());
+
         _d2dDeviceContext->BeginDraw();
         _isPainting = true;
 
+        if (_textLayers[0])
+        {
+            // DXGI scrolls what's on the swap chain as it presents, but the text layer needs to be scrolled by us.
+            if (_invalidScroll != til::point{ 0, 0 } && !_allInvalid)
+            {
+                RETURN_IF_FAILED(_ScrollTextLayer());
+            }
+            _d2dDeviceContext->SetTarget(til::at(_textLayers, _textLayerIndex).Get());
+        }
+
         {
             // Get the baseline for this font as that's where we draw from
             DWRITE_LINE_SPACING spacing;
@@ -1345,6 +1600,24 @@ try
                                                                _d2dDeviceContext->GetSize(),
                                                                std::nullopt,
                                                                D2D1_DRAW_TEXT_OPTIONS_ENABLE_COLOR_FONT);
+
+            if (_glyphAtlasRendering)
+            {
+                if (!_glyphAtlas.HasDeviceResources())
+                {
+                    const HRESULT hr = _glyphAtlas.CreateDeviceResources(_d2dDeviceContext.Get(), _dwriteFactory.Get());
+                    if (FAILED(hr))
+                    {
+                        LOG_HR_MSG(hr, "Failed to set up the glyph atlas. Disabling.");
+                        _glyphAtlasRendering = false;
+                    }
+                }
+
+                _glyphAtlas.SetRasterization(_fontRenderData->DefaultTextFormat()->GetFontSize(),
+                                             spacing.baseline,
+                                             _fontRenderData->GlyphCell().height<float>(),
+                                             _antialiasingMode == D2D1_TEXT_ANTIALIAS_MODE_ALIASED);
+            }
         }
     }
 
@@ -1372,11 +1645,28 @@ try
         // If there's still a clip hanging around, remove it. We're all done.
         LOG_IF_FAILED(_customRenderer->EndClip(_drawingContext.get()));
 
+        _FlushDeferredPainting();
+
+        if (_textLayers[0])
+        {
+            LOG_IF_FAILED(_CompositeOverlays());
+        }
+
+        if (_frameTimeOverlay)
+        {
+            LOG_IF_FAILED(_PaintFrameTimeOverlay());
+        }
+
         hr = _d2dDeviceContext->EndDraw();
 
         if (SUCCEEDED(hr))
         {
-            if (_invalidScroll != til::point{ 0, 0 })
+            const auto scrolled = _invalidScroll != til::point{ 0, 0 };
+            const auto allInvalid = _invalidMap.all();
+
+            // Nothing outside of the invalid cells changed, since the back buffer was caught
+            // up with the front buffer, so DWM only has to compose those.
+            if (scrolled || !allInvalid)
             {
                 // Copy `til::rectangles` into RECT map.
                 _presentDirty.assign(_invalidMap.begin(), _invalidMap.end());
@@ -1386,6 +1676,23 @@ try
                     return rc.scale_up(_fontRenderData->GlyphCell());
                 });
 
+                _presentParams.DirtyRectsCount = gsl::narrow<UINT>(_presentDirty.size());
+                _presentParams.pDirtyRects = _presentDirty.data();
+            }
+
+            // The next back buffer lacks what this frame changed. All of it, if it scrolled,
+            // but then the next frame is likely to scroll as well, which catches up with all
+            // of it by moving the front buffer anyway. Painting everything clears the margins
+            // beyond the cells as well, which aren't part of the dirty rectangles.
+            _staleAll = scrolled || allInvalid;
+            _staleRects.clear();
+            if (!_staleAll)
+            {
+                _staleRects.assign(_presentDirty.begin(), _presentDirty.end());
+            }
+
+            if (scrolled)
+            {
                 // Invalid scroll is in characters, convert it to pixels.
                 const auto scrollPixels = (_invalidScroll * _fontRenderData->GlyphCell());
 
@@ -1402,9 +1709,6 @@ try
                 _presentOffset = scrollPixels;
 
                 // Now fill up the parameters structure from the member variables.
-                _presentParams.DirtyRectsCount = gsl::narrow<UINT>(_presentDirty.size());
-                _presentParams.pDirtyRects = _presentDirty.data();
-
                 _presentParams.pScrollOffset = &_presentOffset;
                 _presentParams.pScrollRect = &_presentScroll;
 
@@ -1460,72 +1764,453 @@ CATCH_RETURN()
     return S_OK;
 }
 
-// Method Description:
-// - When the shaders are on, say that we need to keep redrawing every
-//   possible frame in case they have some smooth action on every frame tick.
-//   It is presumed that if you're using shaders, you're not about performance...
-//   You're instead about OOH SHINY. And that's OK. But returning true here is 100%
-//   a perf detriment.
-[[nodiscard]] bool DxEngine::RequiresContinuousRedraw() noexcept
+// Routine Description:
+// - Brings the back surface of the swap chain up to date with the front surface
+//   before a frame is painted, so that only the differences have to be drawn.
+// - Only what the last frame changed is copied. If this frame scrolls, the front
+//   surface is copied moved by the scroll instead, which is all of it apart from
+//   the revealed rows. They're painted anyway, like everything else that's invalid.
+//   This is what DXGI is told with the scroll rectangle when presenting.
+// Arguments:
+// - <none>
+// Return Value:
+// - Any DirectX error, a memory error, etc.
+[[nodiscard]] HRESULT DxEngine::_CatchUpBackBuffer() noexcept
+try
 {
-    // We're only going to request continuous redraw if someone is using
-    // a pixel shader from a path because we cannot tell if those are using the
-    // time parameter or not.
-    // And if they are using time, they probably need it to tick continuously.
-    //
-    // By contrast, the in-built retro effect does NOT need it,
-    // so let's not tick for it and save some amount of performance.
-    //
-    // Finally... if we're not using effects at all... let the render thread
-    // go to sleep. It deserves it. That thread works hard. Also it sleeping
-    // saves battery power and all sorts of related perf things.
-    return _terminalEffectsEnabled && !_pixelShaderPath.empty();
-}
+    const auto resetStale = wil::scope_exit([&]() noexcept {
+        _staleRects.clear();
+        _staleAll = false;
+    });
 
-// Method Description:
-// - Blocks until the engine is able to render without blocking.
-// - See https://docs.microsoft.com/en-us/windows/uwp/gaming/reduce-latency-with-dxgi-1-3-swap-chains.
-void DxEngine::WaitUntilCanRender() noexcept
-{
-    if (!_swapChainFrameLatencyWaitableObject)
+    // If everything is painted over, there's nothing worth copying.
+    if (_FullRepaintNeeded() || _invalidMap.all() || (!_staleAll && _staleRects.empty()))
     {
-        return;
+        return S_OK;
     }
 
-    const auto ret = WaitForSingleObjectEx(
-        _swapChainFrameLatencyWaitableObject.get(),
-        1000, // 1 second timeout (shouldn't ever occur)
-        true);
-    if (ret != WAIT_OBJECT_0)
+    // Like Present(), this goes straight to the immediate context.
+    const auto device = _sharedDevice;
+    const auto lock = device->Lock();
+
+    const auto scrolled = _invalidScroll != til::point{ 0, 0 };
+    if (_staleAll && !scrolled)
     {
-        LOG_WIN32_MSG(ret, "Waiting for swap chain frame latency waitable object returned error or timeout.");
+        return _CopyFrontToBack();
     }
-}
 
-// Routine Description:
-// - Takes queued drawing information and presents it to the screen.
-// - This is separated out so it can be done outside the lock as it's expensive.
-// Arguments:
-// - <none>
-// Return Value:
-// - S_OK on success, E_PENDING to indicate a retry or a relevant DirectX error
-[[nodiscard]] HRESULT DxEngine::Present() noexcept
-{
-    if (_presentReady)
+    Microsoft::WRL::ComPtr<ID3D11Resource> backBuffer;
+    Microsoft::WRL::ComPtr<ID3D11Resource> frontBuffer;
+    RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)));
+    RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(1, IID_PPV_ARGS(&frontBuffer)));
+
+    const til::rectangle area{ _displaySizePixels };
+    if (!scrolled)
     {
-        if (_HasTerminalEffects() && _pixelShaderLoaded)
+        for (const auto& stale : _staleRects)
         {
-            const HRESULT hr2 = _PaintTerminalEffects();
-            if (FAILED(hr2))
+            const auto rect = stale & area;
+            if (!rect.empty())
             {
-                _pixelShaderLoaded = false;
-                LOG_HR_MSG(hr2, "Failed to paint terminal effects. Disabling.");
+                const D3D11_BOX box{ rect.left<UINT>(), rect.top<UINT>(), 0, rect.right<UINT>(), rect.bottom<UINT>(), 1 };
+                _d3dDeviceContext->CopySubresourceRegion(backBuffer.Get(), 0, box.left, box.top, 0, frontBuffer.Get(), 0, &box);
             }
         }
+        return S_OK;
+    }
 
-        try
-        {
-            HRESULT hr = S_OK;
+    const auto offset = _invalidScroll * _fontRenderData->GlyphCell();
+    const auto kept = (area - offset) & area;
+    if (!kept.empty())
+    {
+        const auto moved = kept + offset;
+        const D3D11_BOX box{ kept.left<UINT>(), kept.top<UINT>(), 0, kept.right<UINT>(), kept.bottom<UINT>(), 1 };
+        _d3dDeviceContext->CopySubresourceRegion(backBuffer.Get(), 0, moved.left<UINT>(), moved.top<UINT>(), 0, frontBuffer.Get(), 0, &box);
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Method Description:
+// - Copies the frame that was presented last into memory. This is meant for
+//   tools like RenderBench, which compare what's drawn to reference images.
+// Arguments:
+// - pixels - receives the frame as rows of BGRA pixels, top to bottom
+// - size - receives the size of the frame in pixels
+// Return Value:
+// - S_OK, E_PENDING if no frame was presented yet, or any DirectX error.
+[[nodiscard]] HRESULT DxEngine::CaptureFrame(std::vector<uint32_t>& pixels, til::size& size) noexcept
+try
+{
+    RETURN_HR_IF(E_PENDING, !_haveDeviceResources || _firstFrame);
+
+    // Like Present(), this goes straight to the immediate context.
+    const auto device = _sharedDevice;
+    const auto lock = device->Lock();
+
+    // Just like in _CopyFrontToBack, the second buffer is the one being presented.
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> frontBuffer;
+    RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(1, IID_PPV_ARGS(&frontBuffer)));
+
+    D3D11_TEXTURE2D_DESC desc{};
+    frontBuffer->GetDesc(&desc);
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    desc.MiscFlags = 0;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> staging;
+    RETURN_IF_FAILED(_d3dDevice->CreateTexture2D(&desc, nullptr, &staging));
+    _d3dDeviceContext->CopyResource(staging.Get(), frontBuffer.Get());
+
+    D3D11_MAPPED_SUBRESOURCE mapped{};
+    RETURN_IF_FAILED(_d3dDeviceContext->Map(staging.Get(), 0, D3D11_MAP_READ, 0, &mapped));
+    const auto unmap = wil::scope_exit([&]() noexcept { _d3dDeviceContext->Unmap(staging.Get(), 0); });
+
+    size = { gsl::narrow<ptrdiff_t>(desc.Width), gsl::narrow<ptrdiff_t>(desc.Height) };
+    pixels.resize(static_cast<size_t>(desc.Width) * desc.Height);
+
+    const auto source = static_cast<const std::byte*>(mapped.pData);
+    for (UINT y = 0; y < desc.Height; ++y)
+    {
+        memcpy(pixels.data() + static_cast<size_t>(y) * desc.Width, source + static_cast<size_t>(y) * mapped.RowPitch, desc.Width * sizeof(uint32_t));
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Creates the layers the text is drawn into, as large as the swap chain, and makes the
+//   first one the target. Nothing has been drawn into them yet, so everything is invalidated.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error.
+[[nodiscard]] HRESULT DxEngine::_CreateTextLayers() noexcept
+try
+{
+    const auto bitmapProperties = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_TARGET,
+        D2D1::PixelFormat(_swapChainDesc.Format, _dxgiAlphaToD2d1Alpha(_swapChainDesc.AlphaMode)));
+    const auto size = _d2dBitmap->GetPixelSize();
+
+    for (auto& layer : _textLayers)
+    {
+        RETURN_IF_FAILED(_d2dDeviceContext->CreateBitmap(size, nullptr, 0, bitmapProperties, layer.ReleaseAndGetAddressOf()));
+    }
+
+    _textLayerIndex = 0;
+    _d2dDeviceContext->SetTarget(_textLayers[0].Get());
+
+    _drawnOverlays = {};
+    _invalidMap.set_all();
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Moves the text layer along with the scroll of the frame, like DXGI does with the
+//   swap chain as it presents. The text is copied onto the other layer, which is then
+//   drawn into instead. What's revealed by the scroll is invalid and drawn anew.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error.
+[[nodiscard]] HRESULT DxEngine::_ScrollTextLayer() noexcept
+try
+{
+    const auto& source = til::at(_textLayers, _textLayerIndex);
+    const auto& target = til::at(_textLayers, _textLayerIndex ^ 1);
+
+    const til::rectangle area{ _displaySizePixels };
+    const auto offset = _invalidScroll * _fontRenderData->GlyphCell();
+    const auto kept = (area - offset) & area;
+
+    if (!kept.empty())
+    {
+        const auto moved = kept + offset;
+        const D2D1_POINT_2U point{ moved.left<UINT32>(), moved.top<UINT32>() };
+        const D2D1_RECT_U rect{ kept.left<UINT32>(), kept.top<UINT32>(), kept.right<UINT32>(), kept.bottom<UINT32>() };
+        RETURN_IF_FAILED(target->CopyFromBitmap(&point, source.Get(), &rect));
+    }
+
+    _textLayerIndex ^= 1;
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Copies the invalid cells of the text layer onto the swap chain and draws the cursor
+//   and the selection over them. If either changed since the last frame, the cells they
+//   covered then and cover now are composited again as well, without drawing their text.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error.
+[[nodiscard]] HRESULT DxEngine::_CompositeOverlays() noexcept
+try
+{
+    // The overlays of the last frame are on the swap chain, which DXGI scrolled along with the rest of it.
+    if (_invalidScroll != til::point{ 0, 0 } || !_SameOverlays(_overlays, _drawnOverlays))
+    {
+        _InvalidateOverlays(_drawnOverlays, _invalidScroll);
+        _InvalidateOverlays(_overlays, {});
+    }
+
+    _d2dDeviceContext->SetTarget(_d2dBitmap.Get());
+    _d2dDeviceContext->SetTransform(D2D1::Matrix3x2F::Identity());
+
+    const auto& textLayer = til::at(_textLayers, _textLayerIndex);
+    const auto cellSize = _fontRenderData->GlyphCell();
+    const til::rectangle area{ _displaySizePixels };
+
+    for (const auto& run : _invalidMap.runs())
+    {
+        const auto pixels = run.scale_up(cellSize) & area;
+        if (!pixels.empty())
+        {
+            const D2D1_POINT_2U point{ pixels.left<UINT32>(), pixels.top<UINT32>() };
+            const D2D1_RECT_U rect{ pixels.left<UINT32>(), pixels.top<UINT32>(), pixels.right<UINT32>(), pixels.bottom<UINT32>() };
+            RETURN_IF_FAILED(_d2dBitmap->CopyFromBitmap(&point, textLayer.Get(), &rect));
+        }
+    }
+
+    _drawnOverlays = _overlays;
+    if (!_overlays.cursor.has_value() && _overlays.selection.empty() && _overlays.searchHighlights.empty())
+    {
+        return S_OK;
+    }
+
+    auto cursorContext = *_drawingContext;
+    cursorContext.cursorInfo = _overlays.cursor;
+
+    const auto existingColor = _d2dBrushForeground->GetColor();
+    const auto resetColorOnExit = wil::scope_exit([&]() noexcept { _d2dBrushForeground->SetColor(existingColor); });
+
+    // The search matches are highlighted in a fainter version of the selection color,
+    // so that the one that's selected stands out among them.
+    auto searchHighlightColor = _selectionBackground;
+    searchHighlightColor.a *= 0.5f;
+
+    // The cursor goes beneath the selection, like it does when it's drawn along with the text.
+    for (const auto& run : _invalidMap.runs())
+    {
+        _d2dDeviceContext->PushAxisAlignedClip(run.scale_up(cellSize), D2D1_ANTIALIAS_MODE_ALIASED);
+
+        LOG_IF_FAILED(_customRenderer->DrawCursor(&cursorContext));
+        _d2dBrushForeground->SetColor(searchHighlightColor);
+        for (const auto& highlight : _overlays.searchHighlights)
+        {
+            _d2dDeviceContext->FillRectangle(highlight.scale_up(cellSize), _d2dBrushForeground.Get());
+        }
+        _d2dBrushForeground->SetColor(_selectionBackground);
+        for (const auto& selection : _overlays.selection)
+        {
+            _d2dDeviceContext->FillRectangle(selection.scale_up(cellSize), _d2dBrushForeground.Get());
+        }
+
+        _d2dDeviceContext->PopAxisAlignedClip();
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Marks the cells covered by the given overlays as invalid, so that they're composited again.
+// Arguments:
+// - overlays - the cursor, selection and search highlights
+// - offset - how far to move the cells, in cells
+// Return Value:
+// - <none>
+void DxEngine::_InvalidateOverlays(const Overlays& overlays, const til::point offset)
+{
+    const til::rectangle bounds{ _invalidMap.size() };
+    const auto invalidate = [&](const til::rectangle& cells) {
+        const auto visible = (cells + offset) & bounds;
+        if (!visible.empty())
+        {
+            _invalidMap.set(visible);
+        }
+    };
+
+    if (overlays.cursor.has_value())
+    {
+        invalidate(_CursorCells(*overlays.cursor));
+    }
+    for (const auto& rect : overlays.selection)
+    {
+        invalidate(rect);
+    }
+    for (const auto& rect : overlays.searchHighlights)
+    {
+        invalidate(rect);
+    }
+}
+
+[[nodiscard]] bool DxEngine::_SameOverlays(const Overlays& a, const Overlays& b) noexcept
+{
+    if (a.cursor.has_value() != b.cursor.has_value() || a.selection != b.selection || a.searchHighlights != b.searchHighlights)
+    {
+        return false;
+    }
+    if (!a.cursor.has_value())
+    {
+        return true;
+    }
+
+    const auto& x = *a.cursor;
+    const auto& y = *b.cursor;
+    return x.coordCursor.X == y.coordCursor.X &&
+           x.coordCursor.Y == y.coordCursor.Y &&
+           x.ulCursorHeightPercent == y.ulCursorHeightPercent &&
+           x.cursorPixelWidth == y.cursorPixelWidth &&
+           x.fIsDoubleWidth == y.fIsDoubleWidth &&
+           x.cursorType == y.cursorType &&
+           x.fUseColor == y.fUseColor &&
+           x.cursorColor == y.cursorColor &&
+           x.isOn == y.isOn;
+}
+
+// Routine Description:
+// - Whether the cursor is drawn over the text layer. Those are the colored cursors that go above
+//   the text. The colored full box goes beneath it and the inverted ones need a backplate beneath it.
+[[nodiscard]] bool DxEngine::_IsOverlayCursor(const CursorOptions& options) noexcept
+{
+    return options.fUseColor && options.cursorType != CursorType::FullBox;
+}
+
+[[nodiscard]] til::rectangle DxEngine::_CursorCells(const CursorOptions& options) noexcept
+{
+    return til::rectangle{ til::point{ options.coordCursor }, til::size{ options.fIsDoubleWidth ? 2 : 1, 1 } };
+}
+
+// Method Description:
+// - When an animated shader is on, say that we need to keep redrawing
+//   in case it has some smooth action on every frame tick.
+//   It is presumed that if you're using shaders, you're not about performance...
+//   You're instead about OOH SHINY. And that's OK. But returning true here is 100%
+//   a perf detriment.
+[[nodiscard]] bool DxEngine::RequiresContinuousRedraw() noexcept
+{
+    // We're only going to request continuous redraw if the shader reads
+    // the time parameter, which is what it needs to tick continuously.
+    // Shaders that don't, like the in-built retro effect, only change
+    // along with the contents, so let's not tick for them and save
+    // some amount of performance.
+    //
+    // Finally... if we're not using effects at all... let the render thread
+    // go to sleep. It deserves it. That thread works hard. Also it sleeping
+    // saves battery power and all sorts of related perf things.
+    return _HasTerminalEffects() && _pixelShaderLoaded && _pixelShaderAnimated;
+}
+
+// Method Description:
+// - Gets the time between the frames of an animated shader, as limited by its frame rate.
+// Return Value:
+// - The time between frames, or zero if the frame rate isn't limited.
+[[nodiscard]] std::chrono::milliseconds DxEngine::GetContinuousRedrawInterval() noexcept
+{
+    if (_pixelShaderFrameRate <= 0)
+    {
+        return std::chrono::milliseconds::zero();
+    }
+    return std::chrono::milliseconds{ 1000 / _pixelShaderFrameRate };
+}
+
+// Method Description:
+// - Gives back what the engine keeps to paint the next frames faster: the
+//   glyphs of the previous font sizes and DPIs, the cached text layouts, the
+//   bitmaps of the images and the capacity of the containers a frame reuses.
+//   All of it is built again on demand.
+// - Must be called while the renderer doesn't paint.
+void DxEngine::Trim() noexcept
+{
+    _CancelPrefetch();
+
+    _glyphAtlas.Trim();
+    _fontRenderData->Trim();
+    if (_customLayout)
+    {
+        _customLayout->Trim();
+    }
+    if (_prefetchLayout)
+    {
+        _prefetchLayout->Trim();
+    }
+    _prefetchQueue = {};
+    _prefetchBatch = {};
+    _prefetchClusters = {};
+    _imageBitmaps = {};
+    _atlasText = {};
+    _atlasGlyphIndices = {};
+    _layoutClusters = {};
+    _deferredBackgrounds = {};
+    _deferredBackgroundIndex = {};
+    _deferredText = {};
+    _deferredClusters = {};
+    _deferredLines = {};
+    _deferredLineClusters = {};
+}
+
+// Method Description:
+// - Blocks until the engine is able to render without blocking.
+// - See https://docs.microsoft.com/en-us/windows/uwp/gaming/reduce-latency-with-dxgi-1-3-swap-chains.
+// Return Value:
+// - True if we waited on the frame latency waitable object, which is signaled
+//   once per refresh of the display while frames are being presented.
+[[nodiscard]] bool DxEngine::WaitUntilCanRender() noexcept
+{
+    if (!_swapChainFrameLatencyWaitableObject)
+    {
+        return false;
+    }
+
+    const auto ret = WaitForSingleObjectEx(
+        _swapChainFrameLatencyWaitableObject.get(),
+        1000, // 1 second timeout (shouldn't ever occur)
+        true);
+    if (ret != WAIT_OBJECT_0)
+    {
+        LOG_WIN32_MSG(ret, "Waiting for swap chain frame latency waitable object returned error or timeout.");
+        return false;
+    }
+    return true;
+}
+
+// Routine Description:
+// - Takes queued drawing information and presents it to the screen.
+// - This is separated out so it can be done outside the lock as it's expensive.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK on success, E_PENDING to indicate a retry or a relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::Present() noexcept
+{
+    if (_presentReady)
+    {
+        // Presenting and the effects go straight to the immediate context, which is shared
+        // with the render threads of all other engines. The device is held on to, as it's
+        // released along with the other device resources if it turns out to be lost.
+        const auto device = _sharedDevice;
+        const auto lock = device->Lock();
+
+        if (_HasTerminalEffects() && _pixelShaderLoaded)
+        {
+            const HRESULT hr2 = _PaintTerminalEffects();
+            if (FAILED(hr2))
+            {
+                _pixelShaderLoaded = false;
+                LOG_HR_MSG(hr2, "Failed to paint terminal effects. Disabling.");
+            }
+        }
+
+        try
+        {
+            HRESULT hr = S_OK;
 
             bool recreate = false;
 
@@ -1535,155 +2220,768 @@ void DxEngine::WaitUntilCanRender() noexcept
             {
                 hr = _dxgiSwapChain->Present1(1, 0, &_presentParams);
 
-                // These two error codes are indicated for destroy-and-recreate
-                // If we were told to destroy-and-recreate, we're going to skip straight into doing that
-                // and not try again with full presentation.
-                recreate = hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET;
+                // These two error codes are indicated for destroy-and-recreate
+                // If we were told to destroy-and-recreate, we're going to skip straight into doing that
+                // and not try again with full presentation.
+                recreate = hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET;
+
+                // Log this as we actually don't expect it to happen, we just will try again
+                // below for robustness of our drawing.
+                if (FAILED(hr) && !recreate)
+                {
+                    LOG_HR(hr);
+                }
+            }
+
+            // If it's the first frame through, we cannot do partial presentation.
+            // Also if partial presentation failed above and we weren't told to skip straight to
+            // device recreation.
+            // In both of these circumstances, do a full presentation.
+            if (_firstFrame || (FAILED(hr) && !recreate))
+            {
+                hr = _dxgiSwapChain->Present(1, 0);
+                _firstFrame = false;
+
+                // These two error codes are indicated for destroy-and-recreate
+                recreate = hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET;
+            }
+
+            // Now check for failure cases from either presentation mode.
+            if (FAILED(hr))
+            {
+                // If we were told to recreate the device surface, do that.
+                if (recreate)
+                {
+                    // The other engines find out about it on their next frame and all of them
+                    // move on to the same new device, instead of each one creating its own.
+                    device->MarkLost();
+
+                    // We don't need to end painting here, as the renderer has done it for us.
+                    _ReleaseDeviceResources();
+                    FAIL_FAST_IF_FAILED(InvalidateAll());
+                    return E_PENDING; // Indicate a retry to the renderer.
+                }
+                // Otherwise, we don't know what to do with this error. Report it.
+                else
+                {
+                    FAIL_FAST_HR(hr);
+                }
+            }
+
+            // The front image (being presented now) is copied onto the backing buffer (where
+            // we are about to draw the next frame) once that frame starts, and only where
+            // it isn't drawn over anyway. See _CatchUpBackBuffer.
+
+            _presentReady = false;
+            _occluded = hr == DXGI_STATUS_OCCLUDED;
+
+            if (!_presentedFirstFrame.exchange(true, std::memory_order_relaxed))
+            {
+#pragma warning(suppress : 26477 26485 26494 26482 26446 26447) // We don't control TraceLoggingWrite
+                TraceLoggingWrite(g_hDxRenderProvider,
+                                  "FirstPresent",
+                                  TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+                                  TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            _lastFrameTime = now - _frameStartTime;
+            _lastFrameInterval = now - _lastPresentTime;
+            _lastPresentTime = now;
+
+            _presentDirty.clear();
+            _presentOffset = { 0 };
+            _presentScroll = { 0 };
+            _presentParams = { 0 };
+        }
+        CATCH_RETURN();
+    }
+
+    return S_OK;
+}
+
+// Routine Description:
+// - This is currently unused.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK
+[[nodiscard]] HRESULT DxEngine::ScrollFrame() noexcept
+{
+    return S_OK;
+}
+
+// Routine Description:
+// - This paints in the back most layer of the frame with the background color.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK
+[[nodiscard]] HRESULT DxEngine::PaintBackground() noexcept
+try
+{
+    D2D1_COLOR_F nothing{ 0 };
+    if (_chainMode == SwapChainMode::ForHwnd)
+    {
+        // When we're drawing over an HWND target, we need to fully paint the background color.
+        nothing = _backgroundColor;
+    }
+
+    // If the entire thing is invalid, just use one big clear operation.
+    if (_invalidMap.all())
+    {
+        _d2dDeviceContext->Clear(nothing);
+    }
+    else
+    {
+        // Runs are counts of cells.
+        // Use a transform by the size of one cell to convert cells-to-pixels
+        // as we clear.
+        _d2dDeviceContext->SetTransform(D2D1::Matrix3x2F::Scale(_fontRenderData->GlyphCell()));
+        for (const auto& rect : _invalidMap.runs())
+        {
+            // Use aliased.
+            // For graphics reasons, it'll look better because it will ensure that
+            // the edges are cut nice and sharp (not blended by anti-aliasing).
+            // For performance reasons, it takes a lot less work to not
+            // do anti-alias blending.
+            _d2dDeviceContext->PushAxisAlignedClip(rect, D2D1_ANTIALIAS_MODE_ALIASED);
+            _d2dDeviceContext->Clear(nothing);
+            _d2dDeviceContext->PopAxisAlignedClip();
+        }
+        _d2dDeviceContext->SetTransform(D2D1::Matrix3x2F::Identity());
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Places one line of text onto the screen at the given position
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - coord - Character coordinate position in the cell grid
+// - fTrimLeft - Whether or not to trim off the left half of a double wide character
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::PaintBufferLine(gsl::span<const Cluster> const clusters,
+                                                COORD const coord,
+                                                const bool /*trimLeft*/,
+                                                const bool /*lineWrapped*/) noexcept
+try
+{
+    if (!_glyphAtlasRendering || !_PaintBufferLineWithAtlas(clusters, coord))
+    {
+        _DeferBufferLine(clusters, coord);
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Queues a line that's about to scroll into view to be laid out on the threadpool, so that
+//   its layout is cached by the time it's drawn. Lines of printable ASCII are skipped, since
+//   they're laid out without being shaped. The builtin glyphs are replaced with spaces, like
+//   _DrawBufferLineWithLayout does.
+// - The first line prepares the font render data for the work to only read it, see
+//   DxFontRenderData::PrepareForConcurrentLayout. Updating the font cancels the work.
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - coord - Character coordinate position in the cell grid, outside of the screen
+// - textAttributes - The attributes the line is drawn with
+// Return Value:
+// - S_OK, S_FALSE if the line doesn't need to be laid out, or a suitable error
+[[nodiscard]] HRESULT DxEngine::PrefetchBufferLine(gsl::span<const Cluster> const clusters,
+                                                   COORD const coord,
+                                                   const TextAttribute& textAttributes) noexcept
+try
+{
+    RETURN_HR_IF(E_NOT_VALID_STATE, !_isPainting);
+
+    const auto isAscii = std::all_of(clusters.begin(), clusters.end(), [](const Cluster& cluster) {
+        const auto& text = cluster.GetText();
+        return cluster.GetColumns() == 1 && text.size() == 1 && text.front() >= L' ' && text.front() <= L'~';
+    });
+    if (!_customLayout || isAscii)
+    {
+        return S_FALSE;
+    }
+
+    if (!_prefetchWork)
+    {
+        _prefetchWork.reset(CreateThreadpoolWork(&s_PrefetchCallback, this, nullptr));
+        THROW_LAST_ERROR_IF_NULL(_prefetchWork.get());
+    }
+
+    if (!_prefetchLayout)
+    {
+        _fontRenderData->PrepareForConcurrentLayout();
+        _prefetchLayout = WRL::Make<CustomTextLayout>(_fontRenderData.get());
+    }
+
+    const std::lock_guard lock{ _prefetchLock };
+
+    auto& queue = _prefetchQueue;
+    const auto firstCluster = queue.clusters.size();
+    auto cell = coord;
+    for (const auto& cluster : clusters)
+    {
+        const auto text = _IsBuiltinGlyph(cluster, cell) ? std::wstring_view{ L" " } : cluster.GetText();
+        queue.clusters.push_back({ queue.text.size(), text.size(), cluster.GetColumns() });
+        queue.text.append(text);
+        cell.X += gsl::narrow_cast<SHORT>(cluster.GetColumns());
+    }
+    queue.lines.push_back({ firstCluster, clusters.size(), textAttributes.IsItalic() });
+
+    if (!_prefetchScheduled)
+    {
+        _prefetchScheduled = true;
+        SubmitThreadpoolWork(_prefetchWork.get());
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Runs the prefetch work on the threadpool.
+// Arguments:
+// - instance - <unused>
+// - context - the engine
+// - work - <unused>
+// Return Value:
+// - <none>
+void CALLBACK DxEngine::s_PrefetchCallback(PTP_CALLBACK_INSTANCE /*instance*/, PVOID context, PTP_WORK /*work*/) noexcept
+{
+    static_cast<DxEngine*>(context)->_PrefetchLayouts();
+}
+
+// Routine Description:
+// - Lays out the queued lines with _prefetchLayout, which caches their layouts,
+//   until there are no more.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::_PrefetchLayouts() noexcept
+{
+    for (;;)
+    {
+        {
+            const std::lock_guard lock{ _prefetchLock };
+            _prefetchBatch.text.clear();
+            _prefetchBatch.clusters.clear();
+            _prefetchBatch.lines.clear();
+
+            if (_prefetchQueue.lines.empty())
+            {
+                _prefetchScheduled = false;
+                return;
+            }
+
+            std::swap(_prefetchQueue, _prefetchBatch);
+        }
+
+        try
+        {
+            const std::wstring_view text{ _prefetchBatch.text };
+            for (const auto& line : _prefetchBatch.lines)
+            {
+                _prefetchClusters.clear();
+                for (size_t i = 0; i < line.clusterCount; i++)
+                {
+                    const auto& cluster = til::at(_prefetchBatch.clusters, line.firstCluster + i);
+                    _prefetchClusters.emplace_back(text.substr(cluster.offset, cluster.length), cluster.columns);
+                }
+
+                LOG_IF_FAILED(_prefetchLayout->Reset());
+                LOG_IF_FAILED(_prefetchLayout->AppendClusters(_prefetchClusters));
+                LOG_IF_FAILED(_prefetchLayout->Prefetch(line.useItalicFont));
+            }
+        }
+        CATCH_LOG();
+    }
+}
+
+// Routine Description:
+// - Moves the layouts the prefetch work cached into the cache of _customLayout. If it's
+//   still at work, they're left for a later frame to pick up.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::_AdoptPrefetchedLayouts()
+{
+    if (!_prefetchLayout || !_customLayout)
+    {
+        return;
+    }
+
+    const std::lock_guard lock{ _prefetchLock };
+    if (!_prefetchScheduled)
+    {
+        _customLayout->AdoptCachedLayouts(*_prefetchLayout.Get());
+    }
+}
+
+// Routine Description:
+// - Drops the lines queued for the prefetch work and waits for it to be done,
+//   so that the layouts and the font render data may be changed.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::_CancelPrefetch() noexcept
+{
+    if (!_prefetchWork)
+    {
+        return;
+    }
+
+    {
+        const std::lock_guard lock{ _prefetchLock };
+        _prefetchQueue.text.clear();
+        _prefetchQueue.clusters.clear();
+        _prefetchQueue.lines.clear();
+    }
+
+    // The work is canceled if it hasn't started yet, which leaves it scheduled.
+    WaitForThreadpoolWorkCallbacks(_prefetchWork.get(), TRUE);
+
+    const std::lock_guard lock{ _prefetchLock };
+    _prefetchScheduled = false;
+}
+
+// Routine Description:
+// - Queues one line of text to be drawn with the text layout by _FlushDeferredPainting,
+//   along with its background.
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - coord - Character coordinate position in the cell grid
+// Return Value:
+// - <none>
+void DxEngine::_DeferBufferLine(gsl::span<const Cluster> const clusters, COORD const coord)
+{
+    const auto firstCluster = _deferredClusters.size();
+    size_t columns = 0;
+    for (const auto& cluster : clusters)
+    {
+        const auto& text = cluster.GetText();
+        _deferredClusters.push_back({ _deferredText.size(), text.size(), cluster.GetColumns() });
+        _deferredText.append(text);
+        columns += cluster.GetColumns();
+    }
+
+    _deferredLines.push_back({ firstCluster,
+                               clusters.size(),
+                               coord,
+                               _foregroundColor,
+                               _backgroundColor,
+                               _drawingContext->forceGrayscaleAA,
+                               _drawingContext->useItalicFont });
+
+    // Like the glyph runs did, a transparent background leaves what PaintBackground drew.
+    if (_backgroundColor.a == 0.0f || columns == 0)
+    {
+        return;
+    }
+
+    const til::rectangle cells{ til::point{ coord }, til::size{ columns, size_t{ 1 } } };
+
+    // Runs of the same color next to each other on a row become one.
+    if (!_deferredBackgrounds.empty())
+    {
+        auto& last = _deferredBackgrounds.back();
+        if (last.cells.top() == cells.top() && last.cells.right() == cells.left() && last.color == til::color{ _backgroundColor })
+        {
+            last.cells = til::rectangle{ last.cells.left(), last.cells.top(), cells.right(), cells.bottom() };
+            return;
+        }
+    }
+
+    _deferredBackgrounds.push_back({ cells, til::color{ _backgroundColor } });
+}
+
+// Routine Description:
+// - Draws one line of text with the text layout.
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - coord - Character coordinate position in the cell grid
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::_DrawBufferLineWithLayout(gsl::span<const Cluster> const clusters, COORD const coord)
+{
+    // Calculate positioning of our origin.
+    const D2D1_POINT_2F origin = til::point{ coord } * _fontRenderData->GlyphCell();
+
+    // Box drawing and block element characters are drawn out of rectangles after the layout.
+    // It gets spaces in their place, so that it still paints their background.
+    auto layoutClusters = clusters;
+    bool hasBuiltinGlyphs = false;
+    auto cell = coord;
+    for (const auto& cluster : clusters)
+    {
+        if (_IsBuiltinGlyph(cluster, cell))
+        {
+            if (!hasBuiltinGlyphs)
+            {
+                _layoutClusters.clear();
+                _layoutClusters.reserve(clusters.size());
+                for (auto it = clusters.begin(); it != clusters.end() && &*it != &cluster; ++it)
+                {
+                    _layoutClusters.emplace_back(it->GetText(), it->GetColumns());
+                }
+                hasBuiltinGlyphs = true;
+            }
+            _layoutClusters.emplace_back(std::wstring_view{ L" " }, 1);
+        }
+        else if (hasBuiltinGlyphs)
+        {
+            _layoutClusters.emplace_back(cluster.GetText(), cluster.GetColumns());
+        }
+        cell.X += gsl::narrow_cast<SHORT>(cluster.GetColumns());
+    }
+    if (hasBuiltinGlyphs)
+    {
+        layoutClusters = _layoutClusters;
+    }
+
+    // Create the text layout
+    RETURN_IF_FAILED(_customLayout->Reset());
+    RETURN_IF_FAILED(_customLayout->AppendClusters(layoutClusters));
+
+    // Layout then render the text
+    RETURN_IF_FAILED(_customLayout->Draw(_drawingContext.get(), _customRenderer.Get(), origin.x, origin.y));
+
+    if (hasBuiltinGlyphs)
+    {
+        _PaintBuiltinGlyphs(clusters, coord);
+    }
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Queues one line of text as sprites of the glyph atlas, if it can be drawn that way.
+//   That's the case for simple text in which every cluster is one column wide and maps
+//   to a single glyph of the font, and which needs neither the cursor nor box drawing
+//   corrections of the text layout. The builtin box drawing glyphs are queued as rectangles.
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - coord - Character coordinate position in the cell grid
+// Return Value:
+// - true if the line was queued, false if it has to be drawn with the text layout
+bool DxEngine::_PaintBufferLineWithAtlas(gsl::span<const Cluster> const clusters, COORD const coord)
+{
+    if (!_glyphAtlas.HasDeviceResources() || clusters.empty())
+    {
+        return false;
+    }
+
+    // The cursor is drawn along with the text it's on.
+    if (const auto& cursor = _drawingContext->cursorInfo; cursor && cursor->isOn && cursor->coordCursor.Y == coord.Y)
+    {
+        return false;
+    }
+
+    _atlasText.clear();
+    for (const auto& cluster : clusters)
+    {
+        const auto& text = cluster.GetText();
+        if (cluster.GetColumns() != 1 || text.size() != 1)
+        {
+            return false;
+        }
+        // The rounded corners and diagonals, which aren't builtin glyphs, need the layout's corrections.
+        if (BuiltinGlyphs::IsBuiltinGlyph(text.front()))
+        {
+            _atlasText.push_back(L' ');
+            continue;
+        }
+        if (text.front() >= 0x2500 && text.front() <= 0x259F)
+        {
+            return false;
+        }
+        _atlasText.push_back(text.front());
+    }
+
+    const auto fontFace = _fontRenderData->FontFaceWithAttribute(_fontRenderData->DefaultFontWeight(),
+                                                                 _drawingContext->useItalicFont ? DWRITE_FONT_STYLE_ITALIC : _fontRenderData->DefaultFontStyle(),
+                                                                 _fontRenderData->DefaultFontStretch());
+
+    const auto textLength = gsl::narrow<UINT32>(_atlasText.size());
+    BOOL isTextSimple = FALSE;
+    UINT32 lengthRead = 0;
+    _atlasGlyphIndices.resize(textLength);
+    THROW_IF_FAILED(_fontRenderData->Analyzer()->GetTextComplexity(_atlasText.data(),
+                                                                   textLength,
+                                                                   fontFace.Get(),
+                                                                   &isTextSimple,
+                                                                   &lengthRead,
+                                                                   _atlasGlyphIndices.data()));
+
+    // Glyph 0 means that the font doesn't have the character and the layout would fall back to another font.
+    if (!isTextSimple || lengthRead != textLength ||
+        std::find(_atlasGlyphIndices.begin(), _atlasGlyphIndices.end(), UINT16{ 0 }) != _atlasGlyphIndices.end())
+    {
+        return false;
+    }
 
-                // Log this as we actually don't expect it to happen, we just will try again
-                // below for robustness of our drawing.
-                if (FAILED(hr) && !recreate)
-                {
-                    LOG_HR(hr);
-                }
-            }
+    auto hr = _glyphAtlas.PrepareGlyphs(fontFace.Get(), _atlasGlyphIndices);
+    if (hr == S_FALSE)
+    {
+        // The atlas is full. Draw what refers to it and start over with the glyphs of this line.
+        _FlushDeferredPainting();
+        _glyphAtlas.Reset();
+        hr = _glyphAtlas.PrepareGlyphs(fontFace.Get(), _atlasGlyphIndices);
+    }
+    THROW_IF_FAILED(hr);
+    if (hr == S_FALSE)
+    {
+        return false;
+    }
 
-            // If it's the first frame through, we cannot do partial presentation.
-            // Also if partial presentation failed above and we weren't told to skip straight to
-            // device recreation.
-            // In both of these circumstances, do a full presentation.
-            if (_firstFrame || (FAILED(hr) && !recreate))
-            {
-                hr = _dxgiSwapChain->Present(1, 0);
-                _firstFrame = false;
+    const auto cellSize = _fontRenderData->GlyphCell();
+    const D2D1_POINT_2F origin = til::point{ coord } * cellSize;
 
-                // These two error codes are indicated for destroy-and-recreate
-                recreate = hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET;
-            }
+    // Like the layout, a transparent background leaves what PaintBackground drew.
+    if (_backgroundColor.a != 0.0f)
+    {
+        _glyphAtlas.AddBackground(D2D1::RectF(origin.x,
+                                              origin.y,
+                                              origin.x + cellSize.width<float>() * textLength,
+                                              origin.y + cellSize.height<float>()),
+                                  _backgroundColor);
+    }
 
-            // Now check for failure cases from either presentation mode.
-            if (FAILED(hr))
+    auto cellOrigin = origin;
+    for (size_t i = 0; i < _atlasGlyphIndices.size(); ++i)
+    {
+        const auto ch = til::at(clusters, i).GetText().front();
+        if (BuiltinGlyphs::IsBuiltinGlyph(ch))
+        {
+            for (const auto& primitive : _builtinGlyphs.GetPrimitives(ch))
             {
-                // If we were told to recreate the device surface, do that.
-                if (recreate)
-                {
-                    // We don't need to end painting here, as the renderer has done it for us.
-                    _ReleaseDeviceResources();
-                    FAIL_FAST_IF_FAILED(InvalidateAll());
-                    return E_PENDING; // Indicate a retry to the renderer.
-                }
-                // Otherwise, we don't know what to do with this error. Report it.
-                else
-                {
-                    FAIL_FAST_HR(hr);
-                }
+                auto color = _foregroundColor;
+                color.a *= primitive.opacity;
+                _glyphAtlas.AddRectangle(D2D1::RectF(cellOrigin.x + primitive.rect.left,
+                                                     cellOrigin.y + primitive.rect.top,
+                                                     cellOrigin.x + primitive.rect.right,
+                                                     cellOrigin.y + primitive.rect.bottom),
+                                         color);
             }
+        }
+        else
+        {
+            _glyphAtlas.AddGlyph(fontFace.Get(), til::at(_atlasGlyphIndices, i), cellOrigin, _foregroundColor);
+        }
+        cellOrigin.x += cellSize.width<float>();
+    }
 
-            // If we are doing full repaints we don't need to copy front buffer to back buffer
-            if (!_FullRepaintNeeded())
-            {
-                // Finally copy the front image (being presented now) onto the backing buffer
-                // (where we are about to draw the next frame) so we can draw only the differences
-                // next frame.
-                RETURN_IF_FAILED(_CopyFrontToBack());
-            }
+    return true;
+}
 
-            _presentReady = false;
+// Routine Description:
+// - Checks whether the cluster is drawn out of the rectangles of _builtinGlyphs instead of the font.
+// - The cell with the cursor is left to the layout, which draws the cursor along with the text.
+// Arguments:
+// - cluster - the cluster
+// - coord - the cell the cluster starts in
+// Return Value:
+// - true if the cluster is a builtin glyph
+[[nodiscard]] bool DxEngine::_IsBuiltinGlyph(const Cluster& cluster, const COORD coord) const noexcept
+{
+    const auto& text = cluster.GetText();
+    if (cluster.GetColumns() != 1 || text.size() != 1 || !BuiltinGlyphs::IsBuiltinGlyph(text.front()))
+    {
+        return false;
+    }
 
-            _presentDirty.clear();
-            _presentOffset = { 0 };
-            _presentScroll = { 0 };
-            _presentParams = { 0 };
+    const auto& cursor = _drawingContext->cursorInfo;
+    return !(cursor && cursor->isOn && cursor->coordCursor.X == coord.X && cursor->coordCursor.Y == coord.Y);
+}
+
+// Routine Description:
+// - Draws the builtin glyphs of a line, on top of what the layout drew for it.
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - coord - Character coordinate position in the cell grid
+// Return Value:
+// - <none>
+void DxEngine::_PaintBuiltinGlyphs(gsl::span<const Cluster> const clusters, COORD const coord)
+{
+    const auto cellSize = _fontRenderData->GlyphCell();
+    const auto restoreOpacityOnExit = wil::scope_exit([&]() noexcept { _d2dBrushForeground->SetOpacity(1.0f); });
+
+    auto cell = coord;
+    for (const auto& cluster : clusters)
+    {
+        if (_IsBuiltinGlyph(cluster, cell))
+        {
+            const D2D1_POINT_2F origin = til::point{ cell } * cellSize;
+            for (const auto& primitive : _builtinGlyphs.GetPrimitives(cluster.GetText().front()))
+            {
+                _d2dBrushForeground->SetOpacity(primitive.opacity);
+                _d2dDeviceContext->FillRectangle(D2D1::RectF(origin.x + primitive.rect.left,
+                                                             origin.y + primitive.rect.top,
+                                                             origin.x + primitive.rect.right,
+                                                             origin.y + primitive.rect.bottom),
+                                                 _d2dBrushForeground.Get());
+            }
         }
-        CATCH_RETURN();
+        cell.X += gsl::narrow_cast<SHORT>(cluster.GetColumns());
     }
-
-    return S_OK;
 }
 
 // Routine Description:
-// - This is currently unused.
+// - Draws everything queued since the last flush, so that whatever is drawn next ends up above it:
+//   First the backgrounds of the deferred lines, then the sprites of the glyph atlas and
+//   last the text of the deferred lines.
 // Arguments:
 // - <none>
 // Return Value:
-// - S_OK
-[[nodiscard]] HRESULT DxEngine::ScrollFrame() noexcept
+// - <none>
+void DxEngine::_FlushDeferredPainting() noexcept
+try
 {
-    return S_OK;
+    if (_deferredLines.empty() && !_glyphAtlas.HasPendingSprites())
+    {
+        return;
+    }
+
+    // The clip of the last row drawn by the layout would cut what's drawn below.
+    LOG_IF_FAILED(_customRenderer->EndClip(_drawingContext.get()));
+
+    // Only lines drawn with the layout queue their backgrounds here.
+    // If the glyph atlas is in use they go into its batch of backgrounds.
+    _PaintDeferredBackgrounds();
+
+    if (_glyphAtlas.HasPendingSprites())
+    {
+        LOG_IF_FAILED(_glyphAtlas.Flush());
+    }
+
+    _DrawDeferredLines();
+
+    LOG_IF_FAILED(_customRenderer->EndClip(_drawingContext.get()));
 }
+CATCH_LOG()
 
 // Routine Description:
-// - This paints in the back most layer of the frame with the background color.
+// - Fills the backgrounds of the deferred lines. Those of the same color and columns on consecutive
+//   rows are merged first, so that a screen of colored blocks takes a fill per block instead of per run.
+// - The backgrounds are filled one after the other without any other drawing in between,
+//   either as one sprite batch of the glyph atlas or as aliased rectangles.
 // Arguments:
 // - <none>
 // Return Value:
-// - S_OK
-[[nodiscard]] HRESULT DxEngine::PaintBackground() noexcept
-try
+// - <none>
+void DxEngine::_PaintDeferredBackgrounds()
 {
-    D2D1_COLOR_F nothing{ 0 };
-    if (_chainMode == SwapChainMode::ForHwnd)
+    if (_deferredBackgrounds.empty())
     {
-        // When we're drawing over an HWND target, we need to fully paint the background color.
-        nothing = _backgroundColor;
+        return;
     }
 
-    // If the entire thing is invalid, just use one big clear operation.
-    if (_invalidMap.all())
+    _deferredBackgroundIndex.clear();
+    size_t count = 0;
+    for (const auto& background : _deferredBackgrounds)
     {
-        _d2dDeviceContext->Clear(nothing);
+        const auto key = (static_cast<uint64_t>(background.color.abgr) << 32) |
+                         (static_cast<uint64_t>(background.cells.left() & 0xFFFF) << 16) |
+                         static_cast<uint64_t>(background.cells.right() & 0xFFFF);
+        const auto [it, inserted] = _deferredBackgroundIndex.emplace(key, count);
+        if (!inserted)
+        {
+            auto& above = til::at(_deferredBackgrounds, it->second);
+            if (above.cells.bottom() == background.cells.top())
+            {
+                above.cells = til::rectangle{ above.cells.left(), above.cells.top(), above.cells.right(), background.cells.bottom() };
+                continue;
+            }
+            it->second = count;
+        }
+        til::at(_deferredBackgrounds, count++) = background;
+    }
+    _deferredBackgrounds.resize(count);
+
+    const auto cellSize = _fontRenderData->GlyphCell();
+    if (_glyphAtlas.HasDeviceResources())
+    {
+        for (const auto& background : _deferredBackgrounds)
+        {
+            _glyphAtlas.AddBackground(background.cells.scale_up(cellSize), background.color);
+        }
     }
     else
     {
-        // Runs are counts of cells.
-        // Use a transform by the size of one cell to convert cells-to-pixels
-        // as we clear.
-        _d2dDeviceContext->SetTransform(D2D1::Matrix3x2F::Scale(_fontRenderData->GlyphCell()));
-        for (const auto& rect : _invalidMap.runs())
+        const auto existingColor = _d2dBrushBackground->GetColor();
+        const auto existingMode = _d2dDeviceContext->GetAntialiasMode();
+        const auto restoreOnExit = wil::scope_exit([&]() noexcept {
+            _d2dBrushBackground->SetColor(existingColor);
+            _d2dDeviceContext->SetAntialiasMode(existingMode);
+        });
+
+        // Aliased, so that the edges of neighboring backgrounds line up, like the glyph runs' clips do.
+        _d2dDeviceContext->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+        for (const auto& background : _deferredBackgrounds)
         {
-            // Use aliased.
-            // For graphics reasons, it'll look better because it will ensure that
-            // the edges are cut nice and sharp (not blended by anti-aliasing).
-            // For performance reasons, it takes a lot less work to not
-            // do anti-alias blending.
-            _d2dDeviceContext->PushAxisAlignedClip(rect, D2D1_ANTIALIAS_MODE_ALIASED);
-            _d2dDeviceContext->Clear(nothing);
-            _d2dDeviceContext->PopAxisAlignedClip();
+            _d2dBrushBackground->SetColor(background.color);
+            _d2dDeviceContext->FillRectangle(background.cells.scale_up(cellSize), _d2dBrushBackground.Get());
         }
-        _d2dDeviceContext->SetTransform(D2D1::Matrix3x2F::Identity());
     }
 
-    return S_OK;
+    _deferredBackgrounds.clear();
 }
-CATCH_RETURN()
 
 // Routine Description:
-// - Places one line of text onto the screen at the given position
+// - Draws the text of the deferred lines with the text layout, in the colors they were queued with.
 // Arguments:
-// - clusters - Iterable collection of cluster information (text and columns it should consume)
-// - coord - Character coordinate position in the cell grid
-// - fTrimLeft - Whether or not to trim off the left half of a double wide character
+// - <none>
 // Return Value:
-// - S_OK or relevant DirectX error
-[[nodiscard]] HRESULT DxEngine::PaintBufferLine(gsl::span<const Cluster> const clusters,
-                                                COORD const coord,
-                                                const bool /*trimLeft*/,
-                                                const bool /*lineWrapped*/) noexcept
-try
-{
-    // Calculate positioning of our origin.
-    const D2D1_POINT_2F origin = til::point{ coord } * _fontRenderData->GlyphCell();
-
-    // Create the text layout
-    RETURN_IF_FAILED(_customLayout->Reset());
-    RETURN_IF_FAILED(_customLayout->AppendClusters(clusters));
-
-    // Layout then render the text
-    RETURN_IF_FAILED(_customLayout->Draw(_drawingContext.get(), _customRenderer.Get(), origin.x, origin.y));
+// - <none>
+void DxEngine::_DrawDeferredLines()
+{
+    const auto foreground = _foregroundColor;
+    const auto background = _backgroundColor;
+    const auto forceGrayscaleAA = _drawingContext->forceGrayscaleAA;
+    const auto useItalicFont = _drawingContext->useItalicFont;
+    const auto restoreOnExit = wil::scope_exit([&]() noexcept {
+        _foregroundColor = foreground;
+        _backgroundColor = background;
+        _d2dBrushForeground->SetColor(foreground);
+        _d2dBrushBackground->SetColor(background);
+        _drawingContext->forceGrayscaleAA = forceGrayscaleAA;
+        _drawingContext->useItalicFont = useItalicFont;
+        _drawingContext->paintBackground = true;
+
+        _deferredText.clear();
+        _deferredClusters.clear();
+        _deferredLines.clear();
+    });
+
+    const std::wstring_view text{ _deferredText };
+    _drawingContext->paintBackground = false;
+    for (const auto& line : _deferredLines)
+    {
+        _foregroundColor = line.foreground;
+        _backgroundColor = line.background;
+        _d2dBrushForeground->SetColor(line.foreground);
+        _d2dBrushBackground->SetColor(line.background);
+        _drawingContext->forceGrayscaleAA = line.forceGrayscaleAA;
+        _drawingContext->useItalicFont = line.useItalicFont;
+
+        _deferredLineClusters.clear();
+        for (size_t i = 0; i < line.clusterCount; ++i)
+        {
+            const auto& cluster = til::at(_deferredClusters, line.firstCluster + i);
+            _deferredLineClusters.emplace_back(text.substr(cluster.offset, cluster.length), cluster.columns);
+        }
 
-    return S_OK;
+        LOG_IF_FAILED(_DrawBufferLineWithLayout(_deferredLineClusters, line.coord));
+    }
 }
-CATCH_RETURN()
 
 // Routine Description:
 // - Paints lines around cells (draws in pieces of the grid)
@@ -1701,6 +2999,9 @@ CATCH_RETURN()
                                                      COORD const coordTarget) noexcept
 try
 {
+    // The lines go above the text, which may still be queued.
+    _FlushDeferredPainting();
+
     const auto existingColor = _d2dBrushForeground->GetColor();
     const auto restoreBrushOnExit = wil::scope_exit([&]() noexcept { _d2dBrushForeground->SetColor(existingColor); });
 
@@ -1817,8 +3118,15 @@ CATCH_RETURN()
 [[nodiscard]] HRESULT DxEngine::PaintSelection(const SMALL_RECT rect) noexcept
 try
 {
+    // With a text layer, the whole selection is drawn over it by _CompositeOverlays.
+    if (_textLayers[0])
+    {
+        return S_OK;
+    }
+
     // If a clip rectangle is in place from drawing the text layer, remove it here.
     LOG_IF_FAILED(_customRenderer->EndClip(_drawingContext.get()));
+    _FlushDeferredPainting();
 
     const auto existingColor = _d2dBrushForeground->GetColor();
 
@@ -1833,6 +3141,64 @@ try
 }
 CATCH_RETURN()
 
+// Routine Description:
+// - Draws the part of an image that's within the given cells, scaled from the
+//   cells sixels are laid out in to ours.
+// - The pixels of the image are uploaded into a bitmap the first time it's drawn,
+//   which is kept for as long as the image is around, so that images which are
+//   scrolled or redrawn don't have to be uploaded again.
+// Arguments:
+// - image - the image to draw
+// - origin - the cell of the top left corner of the image, on the screen
+// - clip - the cells to draw the image in
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::PaintImage(const std::shared_ptr<const ImageStore::Image>& image,
+                                           const til::point origin,
+                                           const til::rectangle clip) noexcept
+try
+{
+    // If a clip rectangle is in place from drawing the text, remove it here.
+    LOG_IF_FAILED(_customRenderer->EndClip(_drawingContext.get()));
+    _FlushDeferredPainting();
+
+    auto it = _imageBitmaps.find(image->id);
+    if (it == _imageBitmaps.end())
+    {
+        // The bitmaps of the images that went away are dropped whenever another one is made.
+        for (auto old = _imageBitmaps.begin(); old != _imageBitmaps.end();)
+        {
+            old = old->second.image.expired() ? _imageBitmaps.erase(old) : std::next(old);
+        }
+
+        ImageBitmap entry;
+        const auto properties = D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_NONE,
+                                                        D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+        const auto width = image->size.width<UINT32>();
+        RETURN_IF_FAILED(_d2dDeviceContext->CreateBitmap(D2D1::SizeU(width, image->size.height<UINT32>()),
+                                                         image->pixels.data(),
+                                                         gsl::narrow_cast<UINT32>(width * sizeof(uint32_t)),
+                                                         &properties,
+                                                         &entry.bitmap));
+        entry.image = image;
+        it = _imageBitmaps.emplace(image->id, std::move(entry)).first;
+    }
+
+    const auto cellSize = _fontRenderData->GlyphCell();
+    const auto scaleX = static_cast<float>(cellSize.width()) / ImageStore::VirtualCellSize.width();
+    const auto scaleY = static_cast<float>(cellSize.height()) / ImageStore::VirtualCellSize.height();
+    const auto left = static_cast<float>(origin.x() * cellSize.width());
+    const auto top = static_cast<float>(origin.y() * cellSize.height());
+    const D2D1_RECT_F destination{ left, top, left + image->size.width() * scaleX, top + image->size.height() * scaleY };
+
+    _d2dDeviceContext->PushAxisAlignedClip(clip.scale_up(cellSize), D2D1_ANTIALIAS_MODE_ALIASED);
+    _d2dDeviceContext->DrawBitmap(it->second.bitmap.Get(), destination, 1.0f, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR);
+    _d2dDeviceContext->PopAxisAlignedClip();
+
+    return S_OK;
+}
+CATCH_RETURN()
+
 // Routine Description:
 // - Does nothing. Our cursor is drawn in CustomTextRenderer::DrawGlyphRun,
 //   either above or below the text.
@@ -1878,6 +3244,17 @@ try
     const UINT stride = sizeof(ShaderInput);
     const UINT offset = 0;
 
+    // The state of the immediate context is shared with the other
+    // engines, so the viewport needs to be set up for every frame.
+    D3D11_VIEWPORT vp;
+    vp.Width = _displaySizePixels.width<float>();
+    vp.Height = _displaySizePixels.height<float>();
+    vp.MinDepth = 0.0f;
+    vp.MaxDepth = 1.0f;
+    vp.TopLeftX = 0;
+    vp.TopLeftY = 0;
+    _d3dDeviceContext->RSSetViewports(1, &vp);
+
     _d3dDeviceContext->OMSetRenderTargets(1, _renderTargetView.GetAddressOf(), nullptr);
     _d3dDeviceContext->IASetVertexBuffers(0, 1, _screenQuadVertexBuffer.GetAddressOf(), &stride, &offset);
     _d3dDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
@@ -1905,6 +3282,64 @@ CATCH_RETURN()
     return _forceFullRepaintRendering || _HasTerminalEffects();
 }
 
+// Routine Description:
+// - Gets the cells in the top right corner the frame time overlay is drawn over.
+// Arguments:
+// - <none>
+// Return Value:
+// - The cells, clipped to the size of the invalid map.
+til::rectangle DxEngine::_FrameTimeOverlayRect() const noexcept
+{
+    static constexpr ptrdiff_t overlayColumns = 32;
+    static constexpr ptrdiff_t textColumns = 48;
+
+    const auto lines = _frameTimeOverlayText.empty() ? 1 : 2 + std::count(_frameTimeOverlayText.begin(), _frameTimeOverlayText.end(), L'\n');
+    const auto size = _invalidMap.size();
+    const auto columns = std::min(lines > 1 ? textColumns : overlayColumns, size.width());
+    const auto rows = std::min<ptrdiff_t>(lines, size.height());
+    return til::rectangle{ til::point{ size.width() - columns, 0 }, til::size{ columns, rows } };
+}
+
+// Routine Description:
+// - Draws how long the last frame took and how long ago the one before it was presented,
+//   followed by the lines given to SetFrameTimeOverlayText.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error.
+[[nodiscard]] HRESULT DxEngine::_PaintFrameTimeOverlay() noexcept
+try
+{
+    const D2D1_RECT_F draw = _FrameTimeOverlayRect().scale_up(_fontRenderData->GlyphCell());
+
+    const auto existingForeground = _d2dBrushForeground->GetColor();
+    const auto existingBackground = _d2dBrushBackground->GetColor();
+    const auto resetColorsOnExit = wil::scope_exit([&]() noexcept {
+        _d2dBrushForeground->SetColor(existingForeground);
+        _d2dBrushBackground->SetColor(existingBackground);
+    });
+
+    _d2dBrushBackground->SetColor(D2D1::ColorF(D2D1::ColorF::Black, 0.75f));
+    _d2dBrushForeground->SetColor(D2D1::ColorF(D2D1::ColorF::White));
+    _d2dDeviceContext->FillRectangle(draw, _d2dBrushBackground.Get());
+
+    auto text = fmt::format(L"frame {:.2f} ms | interval {:.2f} ms", _lastFrameTime.count(), _lastFrameInterval.count());
+    if (!_frameTimeOverlayText.empty())
+    {
+        text.push_back(L'\n');
+        text.append(_frameTimeOverlayText);
+    }
+    _d2dDeviceContext->DrawTextW(text.data(),
+                                 gsl::narrow<UINT32>(text.size()),
+                                 _fontRenderData->DefaultTextFormat().Get(),
+                                 draw,
+                                 _d2dBrushForeground.Get(),
+                                 D2D1_DRAW_TEXT_OPTIONS_CLIP);
+
+    return S_OK;
+}
+CATCH_RETURN()
+
 // Routine Description:
 // - Updates the default brush colors used for drawing
 // Arguments:
@@ -1985,11 +3420,20 @@ CATCH_RETURN()
 [[nodiscard]] HRESULT DxEngine::UpdateFont(const FontInfoDesired& pfiFontInfoDesired, FontInfo& fiFontInfo) noexcept
 try
 {
+    // The prefetched layouts are of the old font, and prefetching it again starts over.
+    _CancelPrefetch();
+    _prefetchLayout.Reset();
+
     RETURN_IF_FAILED(_fontRenderData->UpdateFont(pfiFontInfoDesired, fiFontInfo, _dpi));
 
     // Prepare the text layout.
     _customLayout = WRL::Make<CustomTextLayout>(_fontRenderData.get());
 
+    // The glyph atlas doesn't need to be reset for the new font. It's picked by
+    // the size of the font the next time a frame starts, and glyphs are told
+    // apart by their font faces, which it keeps alive.
+    _builtinGlyphs.SetCellSize(_fontRenderData->GlyphCell(), _fontRenderData->GetLineMetrics().underlineWidth);
+
     return S_OK;
 }
 CATCH_RETURN();
@@ -2242,6 +3686,8 @@ void DxEngine::UpdateHyperlinkHoveredId(const uint16_t hoveredId) noexcept
 //   beginning of this frame. We'll use it to get information about the cursor
 //   before PaintCursor is called. This enables the DX renderer to draw the
 //   cursor underneath the text.
+// - With a text layer, the cursors that go above the text and the selection
+//   are drawn over it instead, once the text of the frame is done.
 // - This is called every frame. When the cursor is Off or out of frame, the
 //   info's cursorInfo will be set to std::nullopt;
 // Arguments:
@@ -2249,7 +3695,44 @@ void DxEngine::UpdateHyperlinkHoveredId(const uint16_t hoveredId) noexcept
 // Return Value:
 // - S_OK
 [[nodiscard]] HRESULT DxEngine::PrepareRenderInfo(const RenderFrameInfo& info) noexcept
+try
 {
     _drawingContext->cursorInfo = info.cursorInfo;
+
+    const auto wasInOverlay = _cursorInOverlay;
+    _cursorInOverlay = info.cursorInfo.has_value() && _IsOverlayCursor(*info.cursorInfo);
+
+    if (_textLayers[0])
+    {
+        _overlays.cursor.reset();
+        if (_cursorInOverlay)
+        {
+            _overlays.cursor = info.cursorInfo;
+            _drawingContext->cursorInfo.reset();
+        }
+        else if (info.cursorInfo.has_value() && wasInOverlay)
+        {
+            // The cursor was drawn over the text until now, so its cells weren't invalidated when it changed.
+            const auto visible = _CursorCells(*info.cursorInfo) & til::rectangle{ _invalidMap.size() };
+            if (!visible.empty())
+            {
+                _InvalidateRectangle(visible);
+            }
+        }
+
+        _overlays.selection.clear();
+        for (const auto& rect : info.selection)
+        {
+            _overlays.selection.emplace_back(Viewport::FromExclusive(rect).ToInclusive());
+        }
+
+        _overlays.searchHighlights.clear();
+        for (const auto& rect : info.searchHighlights)
+        {
+            _overlays.searchHighlights.emplace_back(Viewport::FromExclusive(rect).ToInclusive());
+        }
+    }
+
     return S_OK;
 }
+CATCH_RETURN()
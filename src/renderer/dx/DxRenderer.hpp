@@ -10,6 +10,7 @@
 #include <dxgi.h>
 #include <dxgi1_2.h>
 #include <dxgi1_3.h>
+#include <dxgi1_6.h>
 
 #include <d3d11.h>
 #include <d2d1.h>
@@ -27,6 +28,9 @@
 #include "CustomTextLayout.h"
 #include "CustomTextRenderer.h"
 #include "DxFontRenderData.h"
+#include "BuiltinGlyphs.h"
+#include "GlyphAtlas.h"
+#include "SharedDevice.h"
 
 #include "../../types/inc/Viewport.hpp"
 
@@ -65,13 +69,27 @@ namespace Microsoft::Console::Render
         void SetRetroTerminalEffect(bool enable) noexcept;
 
         void SetPixelShaderPath(std::wstring_view value) noexcept;
+        void SetPixelShaderFrameRate(const int framesPerSecond) noexcept;
 
         void SetForceFullRepaintRendering(bool enable) noexcept;
 
         void SetSoftwareRendering(bool enable) noexcept;
 
+        void SetGpuPreference(const DXGI_GPU_PREFERENCE preference) noexcept;
+        void SetPowerSaving(const bool enable) noexcept;
+
+        void SetFrameTimeOverlay(bool enable) noexcept;
+        void SetFrameTimeOverlayText(const std::wstring_view text);
+
+        void SetGlyphAtlasRendering(bool enable) noexcept;
+
+        void SetSmoothScrolling(bool enable) noexcept;
+        [[nodiscard]] HRESULT SetSmoothScrollOffset(const float offset) noexcept;
+
         HANDLE GetSwapChainHandle();
 
+        [[nodiscard]] HRESULT CaptureFrame(std::vector<uint32_t>& pixels, til::size& size) noexcept;
+
         // IRenderEngine Members
         [[nodiscard]] HRESULT Invalidate(const SMALL_RECT* const psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateCursor(const SMALL_RECT* const psrRegion) noexcept override;
@@ -86,8 +104,10 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT EndPaint() noexcept override;
 
         [[nodiscard]] bool RequiresContinuousRedraw() noexcept override;
+        [[nodiscard]] std::chrono::milliseconds GetContinuousRedrawInterval() noexcept override;
+        void Trim() noexcept override;
 
-        void WaitUntilCanRender() noexcept override;
+        [[nodiscard]] bool WaitUntilCanRender() noexcept override;
         [[nodiscard]] HRESULT Present() noexcept override;
 
         [[nodiscard]] HRESULT ScrollFrame() noexcept override;
@@ -99,9 +119,15 @@ namespace Microsoft::Console::Render
                                               COORD const coord,
                                               bool const fTrimLeft,
                                               const bool lineWrapped) noexcept override;
+        [[nodiscard]] HRESULT PrefetchBufferLine(gsl::span<const Cluster> const clusters,
+                                                 COORD const coord,
+                                                 const TextAttribute& textAttributes) noexcept override;
 
         [[nodiscard]] HRESULT PaintBufferGridLines(GridLines const lines, COLORREF const color, size_t const cchLine, COORD const coordTarget) noexcept override;
         [[nodiscard]] HRESULT PaintSelection(const SMALL_RECT rect) noexcept override;
+        [[nodiscard]] HRESULT PaintImage(const std::shared_ptr<const ImageStore::Image>& image,
+                                         const til::point origin,
+                                         const til::rectangle clip) noexcept override;
 
         [[nodiscard]] HRESULT PaintCursor(const CursorOptions& options) noexcept override;
 
@@ -135,6 +161,29 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _PaintTerminalEffects() noexcept;
         [[nodiscard]] bool _FullRepaintNeeded() const noexcept;
 
+        bool _PaintBufferLineWithAtlas(gsl::span<const Cluster> const clusters, COORD const coord);
+        void _DeferBufferLine(gsl::span<const Cluster> const clusters, COORD const coord);
+        [[nodiscard]] HRESULT _DrawBufferLineWithLayout(gsl::span<const Cluster> const clusters, COORD const coord);
+        [[nodiscard]] bool _IsBuiltinGlyph(const Cluster& cluster, const COORD coord) const noexcept;
+        void _PaintBuiltinGlyphs(gsl::span<const Cluster> const clusters, COORD const coord);
+        void _FlushDeferredPainting() noexcept;
+        void _PaintDeferredBackgrounds();
+        void _DrawDeferredLines();
+
+        static void CALLBACK s_PrefetchCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) noexcept;
+        void _PrefetchLayouts() noexcept;
+        void _AdoptPrefetchedLayouts();
+        void _CancelPrefetch() noexcept;
+
+        til::rectangle _FrameTimeOverlayRect() const noexcept;
+        [[nodiscard]] HRESULT _PaintFrameTimeOverlay() noexcept;
+
+        [[nodiscard]] HRESULT _CreateTextLayers() noexcept;
+        [[nodiscard]] HRESULT _ScrollTextLayer() noexcept;
+        [[nodiscard]] HRESULT _CompositeOverlays() noexcept;
+        [[nodiscard]] static bool _IsOverlayCursor(const CursorOptions& options) noexcept;
+        [[nodiscard]] static til::rectangle _CursorCells(const CursorOptions& options) noexcept;
+
     private:
         enum class SwapChainMode
         {
@@ -168,6 +217,8 @@ namespace Microsoft::Console::Render
         uint16_t _hyperlinkHoveredId;
 
         bool _firstFrame;
+        // Set when the last present reported that nothing of the window can be seen.
+        bool _occluded;
         bool _invalidateFullRows;
         std::pmr::unsynchronized_pool_resource _pool;
         til::pmr::bitmap _invalidMap;
@@ -180,7 +231,15 @@ namespace Microsoft::Console::Render
         POINT _presentOffset;
         DXGI_PRESENT_PARAMETERS _presentParams;
 
+        // Once a frame was presented, the back buffer still holds the one before it. It's
+        // caught up with the front buffer before the next frame is painted, but only where
+        // the presented frame changed something, in pixels. See _CatchUpBackBuffer.
+        std::vector<til::rectangle> _staleRects;
+        bool _staleAll;
+
         static std::atomic<size_t> _tracelogCount;
+        // Set once any engine of the process presented a frame, the end of the startup timeline.
+        static std::atomic<bool> _presentedFirstFrame;
 
         wil::unique_handle _swapChainHandle;
 
@@ -202,6 +261,7 @@ namespace Microsoft::Console::Render
         // Device-Dependent Resources
         bool _recreateDeviceRequested;
         bool _haveDeviceResources;
+        std::shared_ptr<SharedDevice> _sharedDevice;
         ::Microsoft::WRL::ComPtr<ID3D11Device> _d3dDevice;
         ::Microsoft::WRL::ComPtr<ID3D11DeviceContext> _d3dDeviceContext;
 
@@ -236,6 +296,9 @@ namespace Microsoft::Console::Render
         //  Allows user to load a pixel shader from a few presets or from a file path
         std::wstring _pixelShaderPath;
         bool _pixelShaderLoaded{ false };
+        // Whether the shader reads the time. Only those are redrawn continuously, at most _pixelShaderFrameRate times a second.
+        bool _pixelShaderAnimated{ false };
+        int _pixelShaderFrameRate;
 
         std::chrono::steady_clock::time_point _shaderStartTime;
 
@@ -251,7 +314,130 @@ namespace Microsoft::Console::Render
 
         // Preferences and overrides
         bool _softwareRendering;
+        DXGI_GPU_PREFERENCE _gpuPreference;
+        // Shaders aren't run while saving power, see SetPowerSaving.
+        bool _powerSaving;
         bool _forceFullRepaintRendering;
+        bool _frameTimeOverlay;
+        std::wstring _frameTimeOverlayText; // drawn below the frame times, see SetFrameTimeOverlayText
+        bool _glyphAtlasRendering;
+
+        // The swap chain is one row taller with smooth scrolling, and moved up by
+        // _smoothScrollOffset rows with its matrix transform.
+        bool _smoothScrolling;
+        float _smoothScrollOffset;
+        bool _swapChainTransformChanged;
+
+        // Draws simple text out of a texture of glyphs when _glyphAtlasRendering is set.
+        GlyphAtlas _glyphAtlas;
+        std::wstring _atlasText;
+        std::vector<UINT16> _atlasGlyphIndices;
+
+        // The bitmaps of the images of the buffer, by the IDs of the images. Every image
+        // is uploaded the first time it's drawn and reused after that, until it went away.
+        struct ImageBitmap
+        {
+            ::Microsoft::WRL::ComPtr<ID2D1Bitmap1> bitmap;
+            std::weak_ptr<const ImageStore::Image> image;
+        };
+        std::unordered_map<uint64_t, ImageBitmap> _imageBitmaps;
+
+        // Draws box drawing and block element characters out of rectangles. The layout gets
+        // the clusters of a line with spaces in their place, which are kept in _layoutClusters.
+        BuiltinGlyphs _builtinGlyphs;
+        std::vector<Cluster> _layoutClusters;
+
+        // The lines drawn with the text layout are collected until something has to go above them.
+        // Then their backgrounds are filled all at once, merged with those of the same color next to
+        // them, before their text is drawn. The text is copied, since the clusters only point into
+        // buffers of the renderer that are reused for the next line.
+        struct DeferredBackground
+        {
+            til::rectangle cells;
+            til::color color;
+        };
+
+        struct DeferredCluster
+        {
+            size_t offset;
+            size_t length;
+            size_t columns;
+        };
+
+        struct DeferredLine
+        {
+            size_t firstCluster;
+            size_t clusterCount;
+            COORD coord;
+            D2D1_COLOR_F foreground;
+            D2D1_COLOR_F background;
+            bool forceGrayscaleAA;
+            bool useItalicFont;
+        };
+
+        std::vector<DeferredBackground> _deferredBackgrounds;
+        std::unordered_map<uint64_t, size_t> _deferredBackgroundIndex;
+        std::wstring _deferredText;
+        std::vector<DeferredCluster> _deferredClusters;
+        std::vector<DeferredLine> _deferredLines;
+        std::vector<Cluster> _deferredLineClusters;
+
+        // The rows next to the viewport are laid out on the threadpool while scrolling through the
+        // history (see PrefetchBufferLine), with a layout of their own. Its cached layouts are moved
+        // into those of _customLayout when the next frame starts, if the work is done by then.
+        // The lines are queued like the deferred ones. The work swaps the queue for its batch
+        // under _prefetchLock, which also guards _prefetchScheduled. That's set from the time
+        // the work is submitted until it ran out of lines, and it only ever runs once at a time.
+        struct PrefetchLine
+        {
+            size_t firstCluster;
+            size_t clusterCount;
+            bool useItalicFont;
+        };
+
+        struct PrefetchQueue
+        {
+            std::wstring text;
+            std::vector<DeferredCluster> clusters;
+            std::vector<PrefetchLine> lines;
+        };
+
+        ::Microsoft::WRL::ComPtr<CustomTextLayout> _prefetchLayout;
+        std::mutex _prefetchLock;
+        PrefetchQueue _prefetchQueue;
+        PrefetchQueue _prefetchBatch;
+        std::vector<Cluster> _prefetchClusters;
+        bool _prefetchScheduled{ false };
+        wil::unique_threadpool_work _prefetchWork;
+
+        // The text is drawn into a layer of its own, which is copied onto the swap chain along with
+        // the cursor and the selection on top of it. Blinking the cursor or changing the selection thus
+        // only composites the cells beneath them again, without drawing their text. The second layer
+        // takes the text when the frame scrolls, as a bitmap can't be copied onto itself.
+        std::array<::Microsoft::WRL::ComPtr<ID2D1Bitmap1>, 2> _textLayers;
+        size_t _textLayerIndex{ 0 };
+
+        // Cursors that go underneath the text, or invert it, are still drawn along with the text.
+        struct Overlays
+        {
+            std::optional<CursorOptions> cursor;
+            std::vector<til::rectangle> selection;
+            std::vector<til::rectangle> searchHighlights;
+        };
+
+        Overlays _overlays;
+        Overlays _drawnOverlays;
+        bool _cursorInOverlay{ false };
+
+        void _InvalidateOverlays(const Overlays& overlays, const til::point offset);
+        [[nodiscard]] static bool _SameOverlays(const Overlays& a, const Overlays& b) noexcept;
+
+        // How long the last frame took from StartPaint to the end of Present,
+        // and the time between the last two presented frames.
+        std::chrono::steady_clock::time_point _frameStartTime;
+        std::chrono::steady_clock::time_point _lastPresentTime;
+        std::chrono::duration<float, std::milli> _lastFrameTime{};
+        std::chrono::duration<float, std::milli> _lastFrameInterval{};
 
         D2D1_TEXT_ANTIALIAS_MODE _antialiasingMode;
 
@@ -279,6 +465,7 @@ namespace Microsoft::Console::Render
         void _ComputePixelShaderSettings() noexcept;
 
         [[nodiscard]] HRESULT _PrepareRenderTarget() noexcept;
+        [[nodiscard]] HRESULT _ApplySwapChainTransform() noexcept;
 
         void _ReleaseDeviceResources() noexcept;
 
@@ -290,10 +477,12 @@ namespace Microsoft::Console::Render
             _Out_ IDWriteTextLayout** ppTextLayout) noexcept;
 
         [[nodiscard]] HRESULT _CopyFrontToBack() noexcept;
+        [[nodiscard]] HRESULT _CatchUpBackBuffer() noexcept;
 
         [[nodiscard]] HRESULT _EnableDisplayAccess(const bool outputEnabled) noexcept;
 
         [[nodiscard]] til::size _GetClientSize() const;
+        [[nodiscard]] til::size _GetOverscanSize() const noexcept;
 
         void _InvalidateRectangle(const til::rectangle& rc);
         bool _IsAllInvalid() const noexcept;
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "FontCache.h"
+
+using namespace Microsoft::Console::Render;
+
+// Routine Description:
+// - Gets the cache shared by all engines of the process.
+// Arguments:
+// - <none>
+// Return Value:
+// - The cache.
+[[nodiscard]] FontCache& FontCache::Instance()
+{
+    static FontCache instance;
+    return instance;
+}
+
+// Routine Description:
+// - Gets the face of the font that's closest to what the font info asks for, like
+//   DxFontInfo::ResolveFontFaceWithFallback does. It's looked up once per process.
+// Arguments:
+// - fontInfo - the font to look for
+// - dwriteFactory - the shared DirectWrite factory
+// - localeName - the locale to use for the names of the fonts
+// Return Value:
+// - The font face.
+[[nodiscard]] Microsoft::WRL::ComPtr<IDWriteFontFace1> FontCache::FontFace(const DxFontInfo& fontInfo,
+                                                                           gsl::not_null<IDWriteFactory1*> dwriteFactory,
+                                                                           std::wstring& localeName)
+{
+    {
+        std::shared_lock lock{ _lock };
+        if (const auto it = _fontFaces.find(fontInfo); it != _fontFaces.end())
+        {
+            return it->second;
+        }
+    }
+
+    // Two threads may resolve the same font at once. That ends up with the same face, so whichever comes first wins.
+    auto resolved = fontInfo;
+    auto face = resolved.ResolveFontFaceWithFallback(dwriteFactory, localeName);
+
+    std::unique_lock lock{ _lock };
+    return _fontFaces.emplace(fontInfo, std::move(face)).first->second;
+}
+
+// Routine Description:
+// - Gets the table of fallback fonts for the code points drawn with the given primary font.
+// Arguments:
+// - primary - the primary font
+// Return Value:
+// - The table, which stays valid for the lifetime of the process.
+[[nodiscard]] FontCache::FallbackTable& FontCache::Fallbacks(const DxFontInfo& primary)
+{
+    {
+        std::shared_lock lock{ _lock };
+        if (const auto it = _fallbacks.find(primary); it != _fallbacks.end())
+        {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock{ _lock };
+    return _fallbacks[primary];
+}
+
+[[nodiscard]] std::optional<FontCache::MappedFont> FontCache::FallbackTable::Lookup(const char32_t codepoint) const
+{
+    std::shared_lock lock{ _lock };
+    if (const auto it = _fonts.find(codepoint); it != _fonts.end())
+    {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+void FontCache::FallbackTable::Store(const char32_t codepoint, const MappedFont& font)
+{
+    std::unique_lock lock{ _lock };
+    _fonts.emplace(codepoint, font);
+}
@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "DxFontInfo.h"
+
+#include <shared_mutex>
+
+namespace Microsoft::Console::Render
+{
+    // Keeps what's expensive to find out about fonts for all DxEngines of the process,
+    // so that a new pane doesn't have to look up its font faces and discover the
+    // fallback fonts of each script it shows all over again.
+    // - All engines use the shared DirectWrite factory, whose objects are free threaded,
+    //   so the cached faces may be used by any number of render threads at once.
+    // - Nothing is ever evicted. A font installed while the process runs isn't picked
+    //   up as a fallback for characters that were already mapped to another font.
+    class FontCache
+    {
+    public:
+        // The font a code point is drawn with when it isn't in the primary font.
+        struct MappedFont
+        {
+            // The face of the fallback font, or null if no font has the code point.
+            ::Microsoft::WRL::ComPtr<IDWriteFontFace1> face;
+            float scale;
+        };
+
+        // The fallback fonts of the code points drawn with one primary font.
+        class FallbackTable
+        {
+        public:
+            [[nodiscard]] std::optional<MappedFont> Lookup(const char32_t codepoint) const;
+            void Store(const char32_t codepoint, const MappedFont& font);
+
+        private:
+            mutable std::shared_mutex _lock;
+            std::unordered_map<char32_t, MappedFont> _fonts;
+        };
+
+        [[nodiscard]] static FontCache& Instance();
+
+        [[nodiscard]] ::Microsoft::WRL::ComPtr<IDWriteFontFace1> FontFace(const DxFontInfo& fontInfo,
+                                                                          gsl::not_null<IDWriteFactory1*> dwriteFactory,
+                                                                          std::wstring& localeName);
+
+        [[nodiscard]] FallbackTable& Fallbacks(const DxFontInfo& primary);
+
+    private:
+        FontCache() = default;
+
+        std::shared_mutex _lock;
+        std::unordered_map<DxFontInfo, ::Microsoft::WRL::ComPtr<IDWriteFontFace1>> _fontFaces;
+        // The tables are handed out by reference, which stays valid as the map grows.
+        std::unordered_map<DxFontInfo, FallbackTable> _fallbacks;
+    };
+}
@@ -0,0 +1,484 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "GlyphAtlas.h"
+
+using namespace Microsoft::Console::Render;
+using namespace Microsoft::WRL;
+
+// The width and height of the atlas texture. At 4K a cell is about 20x40 pixels,
+// which leaves room for a few thousand glyphs before the atlas has to be reset.
+static constexpr UINT32 s_atlasSize = 2048;
+
+// Glyphs are kept apart by a pixel so that stretching one never picks up its neighbor.
+static constexpr UINT32 s_glyphPadding = 1;
+
+// The number of atlases kept besides the current one. Each of them takes 16MB
+// of video memory, but they're only made when the rasterization changes.
+static constexpr size_t s_maxRecentPages = 2;
+
+// Routine Description:
+// - Creates the atlas texture and the sprite batches drawn from it.
+//   Sprite batches need Windows 10 Creators Update. Where they aren't available,
+//   this fails and the atlas is left without device resources.
+// Arguments:
+// - deviceContext - the device context the sprites will be drawn into
+// - dwriteFactory - the factory used to rasterize the glyphs
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT GlyphAtlas::CreateDeviceResources(ID2D1DeviceContext* deviceContext, IDWriteFactory1* dwriteFactory) noexcept
+try
+{
+    ReleaseDeviceResources();
+
+    auto releaseOnFailure = wil::scope_exit([&]() noexcept {
+        ReleaseDeviceResources();
+    });
+
+    RETURN_IF_FAILED(deviceContext->QueryInterface(IID_PPV_ARGS(&_deviceContext)));
+    RETURN_IF_FAILED(dwriteFactory->QueryInterface(IID_PPV_ARGS(&_dwriteFactory)));
+    RETURN_IF_FAILED(_CreateAtlas());
+    RETURN_IF_FAILED(_deviceContext->CreateSpriteBatch(&_backgroundBatch));
+    RETURN_IF_FAILED(_deviceContext->CreateSpriteBatch(&_glyphBatch));
+
+    Reset();
+
+    releaseOnFailure.release();
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Releases the texture and sprite batches, along with everything that refers to them.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void GlyphAtlas::ReleaseDeviceResources() noexcept
+{
+    _glyphBatch.Reset();
+    _backgroundBatch.Reset();
+    _atlas.Reset();
+    _recentPages.clear();
+    _deviceContext.Reset();
+    Reset();
+}
+
+[[nodiscard]] bool GlyphAtlas::HasDeviceResources() const noexcept
+{
+    return _glyphBatch != nullptr;
+}
+
+// Routine Description:
+// - Sets how glyphs are rasterized. If anything changed, the glyphs in the
+//   atlas no longer match, so it's put aside with the recent ones. The atlas
+//   of the new rasterization is taken from there if it was used before,
+//   or else started empty.
+// Arguments:
+// - emSize - the size of the font in pixels
+// - baseline - the distance from the top of a cell to the baseline
+// - cellHeight - the height of a cell. Glyphs are cropped to it.
+// - aliased - whether glyphs are rasterized without antialiasing
+// Return Value:
+// - <none>
+void GlyphAtlas::SetRasterization(const float emSize,
+                                  const float baseline,
+                                  const float cellHeight,
+                                  const bool aliased) noexcept
+{
+    // Sprites are positioned in whole pixels, so a fractional baseline would shift the
+    // glyphs differently than they were rasterized.
+    const auto roundedBaseline = std::roundf(baseline);
+
+    if (_emSize == emSize && _baseline == roundedBaseline && _cellHeight == cellHeight && _aliased == aliased)
+    {
+        return;
+    }
+
+    // Any sprites that are still queued refer to the current atlas.
+    _ClearSprites();
+
+    if (_atlas && !_glyphs.empty())
+    {
+        Page previous;
+        _SwapPage(previous);
+        _recentPages.push_front(std::move(previous));
+    }
+
+    const auto recent = std::find_if(_recentPages.begin(), _recentPages.end(), [&](const Page& page) noexcept {
+        return page.emSize == emSize && page.baseline == roundedBaseline && page.cellHeight == cellHeight && page.aliased == aliased;
+    });
+    if (recent != _recentPages.end())
+    {
+        _SwapPage(*recent);
+        _recentPages.erase(recent);
+        return;
+    }
+
+    if (_recentPages.size() > s_maxRecentPages)
+    {
+        // The texture of the oldest page is reused, instead of making another one.
+        if (!_atlas)
+        {
+            _atlas = std::move(_recentPages.back().atlas);
+        }
+        _recentPages.pop_back();
+    }
+
+    if (!_atlas && _deviceContext)
+    {
+        if (FAILED_LOG(_CreateAtlas()))
+        {
+            // Without an atlas there's nothing to draw sprites out of. The
+            // engine sets the device resources up again on the next frame.
+            ReleaseDeviceResources();
+            return;
+        }
+    }
+
+    _emSize = emSize;
+    _baseline = roundedBaseline;
+    _cellHeight = cellHeight;
+    _aliased = aliased;
+    Reset();
+}
+
+// Routine Description:
+// - Forgets all glyphs in the atlas, for instance because the font changed.
+//   Sprites that haven't been drawn yet are dropped, so flush them first if they're wanted.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void GlyphAtlas::Reset() noexcept
+{
+    _glyphs.clear();
+    _fontFaces.clear();
+
+    // The first shelf starts right after the white pixel.
+    _shelfX = 1 + s_glyphPadding;
+    _shelfY = 0;
+    _shelfHeight = 1 + s_glyphPadding;
+
+    _ClearSprites();
+}
+
+// Routine Description:
+// - Creates an empty atlas texture, with the white pixel in its top left corner
+//   which the backgrounds are stretched out of.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT GlyphAtlas::_CreateAtlas() noexcept
+{
+    const auto properties = D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_NONE,
+                                                    D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+    RETURN_IF_FAILED(_deviceContext->CreateBitmap(D2D1::SizeU(s_atlasSize, s_atlasSize), nullptr, 0, properties, &_atlas));
+
+    static constexpr UINT32 white = 0xffffffff;
+    const auto whiteRect = D2D1::RectU(0, 0, 1, 1);
+    RETURN_IF_FAILED(_atlas->CopyFromMemory(&whiteRect, &white, sizeof(white)));
+    return S_OK;
+}
+
+// Routine Description:
+// - Exchanges the current atlas and its glyphs with the given page.
+// Arguments:
+// - page - the page of another rasterization, or an empty page to take the current one out
+// Return Value:
+// - <none>
+void GlyphAtlas::_SwapPage(Page& page) noexcept
+{
+    std::swap(_atlas, page.atlas);
+    std::swap(_emSize, page.emSize);
+    std::swap(_baseline, page.baseline);
+    std::swap(_cellHeight, page.cellHeight);
+    std::swap(_aliased, page.aliased);
+    std::swap(_glyphs, page.glyphs);
+    std::swap(_fontFaces, page.fontFaces);
+    std::swap(_shelfX, page.shelfX);
+    std::swap(_shelfY, page.shelfY);
+    std::swap(_shelfHeight, page.shelfHeight);
+}
+
+void GlyphAtlas::_ClearSprites() noexcept
+{
+    for (auto sprites : { &_backgrounds, &_glyphSprites })
+    {
+        sprites->destinations.clear();
+        sprites->sources.clear();
+        sprites->colors.clear();
+    }
+}
+
+// Routine Description:
+// - Makes sure the given glyphs are in the atlas, rasterizing those that aren't yet.
+// Arguments:
+// - fontFace - the font face the glyphs belong to
+// - glyphIndices - the glyphs
+// Return Value:
+// - S_OK if all of the glyphs can be drawn, S_FALSE if the atlas is full,
+//   or relevant DirectWrite error
+[[nodiscard]] HRESULT GlyphAtlas::PrepareGlyphs(IDWriteFontFace* fontFace, gsl::span<const UINT16> glyphIndices) noexcept
+try
+{
+    for (const auto glyphIndex : glyphIndices)
+    {
+        const GlyphKey key{ fontFace, glyphIndex };
+        if (_glyphs.find(key) != _glyphs.end())
+        {
+            continue;
+        }
+
+        GlyphEntry entry{};
+        const auto hr = _Rasterize(key, entry);
+        RETURN_IF_FAILED(hr);
+        if (hr == S_FALSE)
+        {
+            return S_FALSE;
+        }
+
+        if (std::none_of(_fontFaces.begin(), _fontFaces.end(), [&](const auto& face) noexcept { return face.Get() == fontFace; }))
+        {
+            _fontFaces.emplace_back(fontFace);
+        }
+        _glyphs.emplace(key, entry);
+    }
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Queues a rectangle filled with the given color, drawn beneath all glyphs.
+// Arguments:
+// - rect - the rectangle in pixels
+// - color - the color to fill it with
+// Return Value:
+// - <none>
+void GlyphAtlas::AddBackground(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color)
+{
+    _backgrounds.destinations.emplace_back(rect);
+    _backgrounds.sources.emplace_back(D2D1::RectU(0, 0, 1, 1));
+    _backgrounds.colors.emplace_back(color);
+}
+
+// Routine Description:
+// - Queues a glyph, which must have been prepared with PrepareGlyphs.
+// Arguments:
+// - fontFace - the font face the glyph belongs to
+// - glyphIndex - the glyph
+// - cellOrigin - the top left corner of the cell the glyph is drawn in
+// - color - the color of the glyph
+// Return Value:
+// - <none>
+void GlyphAtlas::AddGlyph(IDWriteFontFace* fontFace, const UINT16 glyphIndex, const D2D1_POINT_2F cellOrigin, const D2D1_COLOR_F& color)
+{
+    const auto& entry = _glyphs.at({ fontFace, glyphIndex });
+    if (entry.source.right == entry.source.left)
+    {
+        return;
+    }
+
+    const auto left = cellOrigin.x + entry.offset.x;
+    const auto top = cellOrigin.y + entry.offset.y;
+    _glyphSprites.destinations.emplace_back(D2D1::RectF(left,
+                                                        top,
+                                                        left + (entry.source.right - entry.source.left),
+                                                        top + (entry.source.bottom - entry.source.top)));
+    _glyphSprites.sources.emplace_back(entry.source);
+    _glyphSprites.colors.emplace_back(color);
+}
+
+// Routine Description:
+// - Queues a rectangle filled with the given color, drawn along with the glyphs
+//   and thus above all backgrounds. Used for the builtin box drawing glyphs.
+// Arguments:
+// - rect - the rectangle in pixels
+// - color - the color to fill it with
+// Return Value:
+// - <none>
+void GlyphAtlas::AddRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color)
+{
+    _glyphSprites.destinations.emplace_back(rect);
+    _glyphSprites.sources.emplace_back(D2D1::RectU(0, 0, 1, 1));
+    _glyphSprites.colors.emplace_back(color);
+}
+
+// Routine Description:
+// - Drops the pages of the previous rasterizations, and the capacity of the
+//   buffers that glyphs are rasterized and queued in. The glyphs of the
+//   current rasterization are kept, as they're drawn with the next frame.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void GlyphAtlas::Trim() noexcept
+{
+    _recentPages.clear();
+    _alpha = {};
+    _pixels = {};
+    if (!HasPendingSprites())
+    {
+        _backgrounds = {};
+        _glyphSprites = {};
+    }
+}
+
+[[nodiscard]] bool GlyphAtlas::HasPendingSprites() const noexcept
+{
+    return !_backgrounds.destinations.empty() || !_glyphSprites.destinations.empty();
+}
+
+// Routine Description:
+// - Draws the queued backgrounds with one call and then the queued glyphs with another.
+// - The device context must be drawing and must not have any clip pushed
+//   that the sprites aren't supposed to be cut by.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT GlyphAtlas::Flush() noexcept
+{
+    RETURN_IF_FAILED(_DrawSprites(_backgroundBatch.Get(), _backgrounds));
+    RETURN_IF_FAILED(_DrawSprites(_glyphBatch.Get(), _glyphSprites));
+    return S_OK;
+}
+
+// Routine Description:
+// - Rasterizes a glyph and copies it into the atlas.
+// Arguments:
+// - key - the glyph
+// - entry - filled with where the glyph was put
+// Return Value:
+// - S_OK, S_FALSE if there's no room left in the atlas, or relevant DirectWrite error
+[[nodiscard]] HRESULT GlyphAtlas::_Rasterize(const GlyphKey& key, GlyphEntry& entry)
+{
+    DWRITE_GLYPH_RUN glyphRun{};
+    glyphRun.fontFace = key.fontFace;
+    glyphRun.fontEmSize = _emSize;
+    glyphRun.glyphCount = 1;
+    glyphRun.glyphIndices = &key.glyphIndex;
+
+    ComPtr<IDWriteGlyphRunAnalysis> analysis;
+    RETURN_IF_FAILED(_dwriteFactory->CreateGlyphRunAnalysis(&glyphRun,
+                                                            nullptr,
+                                                            _aliased ? DWRITE_RENDERING_MODE_ALIASED : DWRITE_RENDERING_MODE_NATURAL_SYMMETRIC,
+                                                            DWRITE_MEASURING_MODE_NATURAL,
+                                                            DWRITE_GRID_FIT_MODE_DEFAULT,
+                                                            DWRITE_TEXT_ANTIALIAS_MODE_GRAYSCALE,
+                                                            0.0f,
+                                                            0.0f,
+                                                            &analysis));
+
+    RECT bounds{};
+    RETURN_IF_FAILED(analysis->GetAlphaTextureBounds(DWRITE_TEXTURE_ALIASED_1x1, &bounds));
+
+    // The bounds are relative to the baseline origin. Keep only the part within the row,
+    // like the text layout path, which clips every row to its cells.
+    const auto rowTop = gsl::narrow_cast<LONG>(-_baseline);
+    const auto rowBottom = gsl::narrow_cast<LONG>(_cellHeight - _baseline);
+    const auto top = std::max(bounds.top, rowTop);
+    const auto bottom = std::min(bounds.bottom, rowBottom);
+
+    if (bounds.left >= bounds.right || top >= bottom)
+    {
+        // Nothing to draw, like for a space.
+        return S_OK;
+    }
+
+    const auto fullWidth = gsl::narrow<UINT32>(bounds.right - bounds.left);
+    const auto fullHeight = gsl::narrow<UINT32>(bounds.bottom - bounds.top);
+    const auto height = gsl::narrow<UINT32>(bottom - top);
+
+    D2D1_POINT_2U position{};
+    if (!_Allocate(fullWidth, height, position))
+    {
+        return S_FALSE;
+    }
+
+    _alpha.resize(static_cast<size_t>(fullWidth) * fullHeight);
+    RETURN_IF_FAILED(analysis->CreateAlphaTexture(DWRITE_TEXTURE_ALIASED_1x1, &bounds, _alpha.data(), gsl::narrow<UINT32>(_alpha.size())));
+
+    // Turn the coverage into white with premultiplied alpha, so that
+    // the color of a sprite is all that decides the color of its glyph.
+    const auto firstRow = gsl::narrow_cast<size_t>(top - bounds.top);
+    _pixels.resize(static_cast<size_t>(fullWidth) * height);
+    std::transform(_alpha.begin() + firstRow * fullWidth,
+                   _alpha.begin() + (firstRow + height) * fullWidth,
+                   _pixels.begin(),
+                   [](const BYTE alpha) noexcept {
+                       return UINT32{ alpha } * 0x01010101u;
+                   });
+
+    entry.source = D2D1::RectU(position.x, position.y, position.x + fullWidth, position.y + height);
+    entry.offset = D2D1::Point2F(gsl::narrow_cast<float>(bounds.left), gsl::narrow_cast<float>(top) + _baseline);
+
+    RETURN_IF_FAILED(_atlas->CopyFromMemory(&entry.source, _pixels.data(), fullWidth * sizeof(UINT32)));
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Finds room for a glyph of the given size, filling the atlas shelf by shelf.
+// Arguments:
+// - width - the width of the glyph
+// - height - the height of the glyph
+// - position - filled with the top left corner of the room for the glyph
+// Return Value:
+// - false if there's no room left
+[[nodiscard]] bool GlyphAtlas::_Allocate(const UINT32 width, const UINT32 height, D2D1_POINT_2U& position) noexcept
+{
+    const auto paddedWidth = width + s_glyphPadding;
+    const auto paddedHeight = height + s_glyphPadding;
+
+    if (_shelfX + paddedWidth > s_atlasSize)
+    {
+        _shelfY += _shelfHeight;
+        _shelfX = 0;
+        _shelfHeight = 0;
+    }
+
+    if (paddedWidth > s_atlasSize || _shelfY + paddedHeight > s_atlasSize)
+    {
+        return false;
+    }
+
+    position = D2D1::Point2U(_shelfX, _shelfY);
+    _shelfX += paddedWidth;
+    _shelfHeight = std::max(_shelfHeight, paddedHeight);
+    return true;
+}
+
+[[nodiscard]] HRESULT GlyphAtlas::_DrawSprites(ID2D1SpriteBatch* batch, SpriteList& sprites) noexcept
+{
+    if (sprites.destinations.empty())
+    {
+        return S_OK;
+    }
+
+    auto clearOnExit = wil::scope_exit([&]() noexcept {
+        batch->Clear();
+        sprites.destinations.clear();
+        sprites.sources.clear();
+        sprites.colors.clear();
+    });
+
+    RETURN_IF_FAILED(batch->AddSprites(gsl::narrow_cast<UINT32>(sprites.destinations.size()),
+                                       sprites.destinations.data(),
+                                       sprites.sources.data(),
+                                       sprites.colors.data(),
+                                       nullptr,
+                                       sizeof(D2D1_RECT_F),
+                                       sizeof(D2D1_RECT_U),
+                                       sizeof(D2D1_COLOR_F),
+                                       0));
+
+    // Sprites are only drawn with aliased antialiasing, which the engine always uses outside of text.
+    _deviceContext->DrawSpriteBatch(batch, _atlas.Get(), D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR, D2D1_SPRITE_OPTIONS_NONE);
+
+    return S_OK;
+}
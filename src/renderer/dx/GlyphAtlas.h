@@ -0,0 +1,134 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <d2d1_3.h>
+#include <dwrite_2.h>
+
+#include <wrl.h>
+
+namespace Microsoft::Console::Render
+{
+    // Rasterizes each glyph once into a texture and draws the cells of the
+    // grid as sprites out of it. All backgrounds queued since the last flush are
+    // drawn with one call, followed by all glyphs with another, so the cost of
+    // a frame depends on the number of cells instead of the text in them.
+    // - Glyphs are rasterized with grayscale antialiasing, or aliased if the
+    //   engine is set up for that, and cropped to the height of their row.
+    // - The atlases of the last few rasterizations are kept, so that moving
+    //   a window back to a monitor with a DPI it was on before (or zooming
+    //   back to a font size) doesn't rasterize all of its glyphs again.
+    class GlyphAtlas
+    {
+    public:
+        GlyphAtlas() = default;
+
+        [[nodiscard]] HRESULT CreateDeviceResources(ID2D1DeviceContext* deviceContext, IDWriteFactory1* dwriteFactory) noexcept;
+        void ReleaseDeviceResources() noexcept;
+        [[nodiscard]] bool HasDeviceResources() const noexcept;
+
+        void SetRasterization(const float emSize,
+                              const float baseline,
+                              const float cellHeight,
+                              const bool aliased) noexcept;
+        void Reset() noexcept;
+        void Trim() noexcept;
+
+        [[nodiscard]] HRESULT PrepareGlyphs(IDWriteFontFace* fontFace, gsl::span<const UINT16> glyphIndices) noexcept;
+
+        void AddBackground(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color);
+        void AddGlyph(IDWriteFontFace* fontFace, const UINT16 glyphIndex, const D2D1_POINT_2F cellOrigin, const D2D1_COLOR_F& color);
+        void AddRectangle(const D2D1_RECT_F& rect, const D2D1_COLOR_F& color);
+
+        [[nodiscard]] bool HasPendingSprites() const noexcept;
+        [[nodiscard]] HRESULT Flush() noexcept;
+
+    private:
+        struct GlyphKey
+        {
+            IDWriteFontFace* fontFace;
+            UINT16 glyphIndex;
+
+            bool operator==(const GlyphKey& other) const noexcept
+            {
+                return fontFace == other.fontFace && glyphIndex == other.glyphIndex;
+            }
+        };
+
+        struct GlyphKeyHash
+        {
+            size_t operator()(const GlyphKey& key) const noexcept
+            {
+                return std::hash<IDWriteFontFace*>{}(key.fontFace) ^ (static_cast<size_t>(key.glyphIndex) * 0x9E3779B9);
+            }
+        };
+
+        // Where a glyph lives in the atlas and where its top left corner
+        // is drawn relative to the top left corner of its cell. Empty glyphs have no sprite.
+        struct GlyphEntry
+        {
+            D2D1_RECT_U source;
+            D2D1_POINT_2F offset;
+        };
+
+        struct SpriteList
+        {
+            std::vector<D2D1_RECT_F> destinations;
+            std::vector<D2D1_RECT_U> sources;
+            std::vector<D2D1_COLOR_F> colors;
+        };
+
+        // The atlas of a rasterization that was used before the current one.
+        struct Page
+        {
+            ::Microsoft::WRL::ComPtr<ID2D1Bitmap1> atlas;
+            float emSize{ 0 };
+            float baseline{ 0 };
+            float cellHeight{ 0 };
+            bool aliased{ false };
+            std::unordered_map<GlyphKey, GlyphEntry, GlyphKeyHash> glyphs;
+            std::vector<::Microsoft::WRL::ComPtr<IDWriteFontFace>> fontFaces;
+            UINT32 shelfX{ 0 };
+            UINT32 shelfY{ 0 };
+            UINT32 shelfHeight{ 0 };
+        };
+
+        [[nodiscard]] HRESULT _CreateAtlas() noexcept;
+        void _SwapPage(Page& page) noexcept;
+        void _ClearSprites() noexcept;
+        [[nodiscard]] HRESULT _Rasterize(const GlyphKey& key, GlyphEntry& entry);
+        [[nodiscard]] bool _Allocate(const UINT32 width, const UINT32 height, D2D1_POINT_2U& position) noexcept;
+        [[nodiscard]] HRESULT _DrawSprites(ID2D1SpriteBatch* batch, SpriteList& sprites) noexcept;
+
+        ::Microsoft::WRL::ComPtr<ID2D1DeviceContext3> _deviceContext;
+        ::Microsoft::WRL::ComPtr<ID2D1Bitmap1> _atlas;
+        ::Microsoft::WRL::ComPtr<ID2D1SpriteBatch> _backgroundBatch;
+        ::Microsoft::WRL::ComPtr<ID2D1SpriteBatch> _glyphBatch;
+
+        ::Microsoft::WRL::ComPtr<IDWriteFactory2> _dwriteFactory;
+        float _emSize{ 0 };
+        float _baseline{ 0 };
+        float _cellHeight{ 0 };
+        bool _aliased{ false };
+
+        std::unordered_map<GlyphKey, GlyphEntry, GlyphKeyHash> _glyphs;
+        // The font faces of the glyphs, which are kept alive so that another
+        // face can't show up at the same address while the glyphs are around.
+        std::vector<::Microsoft::WRL::ComPtr<IDWriteFontFace>> _fontFaces;
+        std::vector<BYTE> _alpha;
+        std::vector<UINT32> _pixels;
+
+        // The atlas is filled in rows ("shelves") from the top. The first one starts with a white pixel
+        // which is stretched across the backgrounds.
+        UINT32 _shelfX{ 0 };
+        UINT32 _shelfY{ 0 };
+        UINT32 _shelfHeight{ 0 };
+
+        SpriteList _backgrounds;
+        SpriteList _glyphSprites;
+
+        // The pages of the rasterizations used before the current one, the most recent first.
+        std::list<Page> _recentPages;
+    };
+}
@@ -0,0 +1,197 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "SharedDevice.h"
+
+using namespace Microsoft::Console::Render;
+
+namespace
+{
+    // The devices in use: the hardware ones for each DXGI_GPU_PREFERENCE first,
+    // and WARP last. They're only held weakly, so that they go away with the
+    // last engine using them.
+    std::mutex s_devicesLock;
+    std::array<std::weak_ptr<SharedDevice>, 4> s_devices;
+    constexpr size_t s_warpDeviceSlot = 3;
+}
+
+// Routine Description:
+// - Gets the Direct2D factory of the process. Everything that's used along
+//   with the shared devices, like stroke styles, must come from this factory.
+// Arguments:
+// - <none>
+// Return Value:
+// - The multithreaded factory.
+[[nodiscard]] Microsoft::WRL::ComPtr<ID2D1Factory1> SharedDevice::Factory()
+{
+    static const auto factory = [] {
+        ::Microsoft::WRL::ComPtr<ID2D1Factory1> f;
+        THROW_IF_FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_MULTI_THREADED, IID_PPV_ARGS(&f)));
+        return f;
+    }();
+    return factory;
+}
+
+// Routine Description:
+// - Gets the devices shared by the engines of the process, creating them if
+//   no engine uses them yet, or if the ones in use have been lost.
+// Arguments:
+// - softwareRendering - whether to use the WARP (software) devices
+// - gpuPreference - which adapter the hardware devices are created on
+// - device - receives the devices
+// Return Value:
+// - S_OK or the failure to create the devices.
+[[nodiscard]] HRESULT SharedDevice::Acquire(const bool softwareRendering, const DXGI_GPU_PREFERENCE gpuPreference, std::shared_ptr<SharedDevice>& device) noexcept
+try
+{
+    std::scoped_lock lock{ s_devicesLock };
+
+    const auto preference = std::clamp(gpuPreference, DXGI_GPU_PREFERENCE_UNSPECIFIED, DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE);
+    auto& slot = til::at(s_devices, softwareRendering ? s_warpDeviceSlot : static_cast<size_t>(preference));
+    auto current = slot.lock();
+    if (!current || current->IsLost())
+    {
+        current.reset(new SharedDevice());
+        RETURN_IF_FAILED(current->_Create(softwareRendering, preference));
+        slot = current;
+    }
+
+    device = std::move(current);
+    return S_OK;
+}
+CATCH_RETURN()
+
+// Routine Description:
+// - Finds the adapter that best fits the given preference, on machines with more than one GPU.
+// Arguments:
+// - gpuPreference - whether to prefer the adapter that draws the least power, or the fastest one
+// Return Value:
+// - The adapter, or nullptr to leave the choice to Direct3D, which is
+//   what happens without a preference or before Windows 10 1803.
+[[nodiscard]] Microsoft::WRL::ComPtr<IDXGIAdapter1> SharedDevice::_FindAdapter(const DXGI_GPU_PREFERENCE gpuPreference) const noexcept
+{
+    ::Microsoft::WRL::ComPtr<IDXGIAdapter1> adapter;
+    ::Microsoft::WRL::ComPtr<IDXGIFactory6> factory6;
+    if (gpuPreference != DXGI_GPU_PREFERENCE_UNSPECIFIED && SUCCEEDED(_dxgiFactory.As(&factory6)))
+    {
+        LOG_IF_FAILED(factory6->EnumAdapterByGpuPreference(0, gpuPreference, IID_PPV_ARGS(&adapter)));
+    }
+    return adapter;
+}
+
+[[nodiscard]] HRESULT SharedDevice::_Create(const bool softwareRendering, const DXGI_GPU_PREFERENCE gpuPreference) noexcept
+try
+{
+    RETURN_IF_FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&_dxgiFactory)));
+
+    // The device is used by the render threads of all engines,
+    // so it can't be created with D3D11_CREATE_DEVICE_SINGLETHREADED.
+    const DWORD DeviceFlags = D3D11_CREATE_DEVICE_BGRA_SUPPORT |
+                              // clang-format off
+// This causes problems for folks who do not have the whole DirectX SDK installed
+// when they try to run the rest of the project in debug mode.
+// As such, I'm leaving this flag here for people doing DX-specific work to toggle it
+// only when they need it and shutting it off otherwise.
+// Find out more about the debug layer here:
+// https://docs.microsoft.com/en-us/windows/desktop/direct3d11/overviews-direct3d-11-devices-layers
+// You can find out how to install it here:
+// https://docs.microsoft.com/en-us/windows/uwp/gaming/use-the-directx-runtime-and-visual-studio-graphics-diagnostic-features
+                              // clang-format on
+                              // D3D11_CREATE_DEVICE_DEBUG |
+                              0;
+
+    const std::array<D3D_FEATURE_LEVEL, 5> FeatureLevels{ D3D_FEATURE_LEVEL_11_1,
+                                                          D3D_FEATURE_LEVEL_11_0,
+                                                          D3D_FEATURE_LEVEL_10_1,
+                                                          D3D_FEATURE_LEVEL_10_0,
+                                                          D3D_FEATURE_LEVEL_9_1 };
+
+    // Trying hardware first for maximum performance, then trying WARP (software) renderer second
+    // in case we're running inside a downlevel VM where hardware passthrough isn't enabled like
+    // for Windows 7 in a VM.
+    HRESULT hardwareResult = E_NOT_SET;
+
+    // If we're not forcing software rendering, try hardware first.
+    // Otherwise, let the error state fall down and create with the software renderer directly.
+    if (!softwareRendering)
+    {
+        // A device on a given adapter has to be created with the unknown driver type.
+        const auto adapter = _FindAdapter(gpuPreference);
+        hardwareResult = D3D11CreateDevice(adapter.Get(),
+                                           adapter ? D3D_DRIVER_TYPE_UNKNOWN : D3D_DRIVER_TYPE_HARDWARE,
+                                           nullptr,
+                                           DeviceFlags,
+                                           FeatureLevels.data(),
+                                           gsl::narrow_cast<UINT>(FeatureLevels.size()),
+                                           D3D11_SDK_VERSION,
+                                           &_d3dDevice,
+                                           nullptr,
+                                           &_d3dDeviceContext);
+    }
+
+    if (FAILED(hardwareResult))
+    {
+        RETURN_IF_FAILED(D3D11CreateDevice(nullptr,
+                                           D3D_DRIVER_TYPE_WARP,
+                                           nullptr,
+                                           DeviceFlags,
+                                           FeatureLevels.data(),
+                                           gsl::narrow_cast<UINT>(FeatureLevels.size()),
+                                           D3D11_SDK_VERSION,
+                                           &_d3dDevice,
+                                           nullptr,
+                                           &_d3dDeviceContext));
+    }
+
+    const auto factory = Factory();
+    RETURN_IF_FAILED(_d3dDevice.As(&_dxgiDevice));
+    RETURN_IF_FAILED(factory->CreateDevice(_dxgiDevice.Get(), &_d2dDevice));
+    RETURN_IF_FAILED(factory.As(&_multithread));
+
+    return S_OK;
+}
+CATCH_RETURN()
+
+[[nodiscard]] ID3D11Device* SharedDevice::D3DDevice() const noexcept
+{
+    return _d3dDevice.Get();
+}
+
+[[nodiscard]] ID3D11DeviceContext* SharedDevice::D3DDeviceContext() const noexcept
+{
+    return _d3dDeviceContext.Get();
+}
+
+[[nodiscard]] IDXGIDevice* SharedDevice::DxgiDevice() const noexcept
+{
+    return _dxgiDevice.Get();
+}
+
+[[nodiscard]] IDXGIFactory2* SharedDevice::DxgiFactory() const noexcept
+{
+    return _dxgiFactory.Get();
+}
+
+[[nodiscard]] ID2D1Device* SharedDevice::D2DDevice() const noexcept
+{
+    return _d2dDevice.Get();
+}
+
+// Routine Description:
+// - Marks the devices as lost, for instance after the GPU was reset or
+//   its driver updated. The next engine to acquire devices gets new ones.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void SharedDevice::MarkLost() noexcept
+{
+    _lost.store(true, std::memory_order_relaxed);
+}
+
+[[nodiscard]] bool SharedDevice::IsLost() const noexcept
+{
+    return _lost.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <d2d1_1.h>
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#include <dxgi1_6.h>
+
+#include <wrl.h>
+
+namespace Microsoft::Console::Render
+{
+    // The Direct3D and Direct2D devices that all DxEngines of the process draw with,
+    // so that a new pane only creates its swap chain and its Direct2D device context
+    // instead of a whole device with its own copy of every GPU resource.
+    // - The devices are created by the first engine that asks for them and released along
+    //   with the last engine using them. Software rendering gets its own WARP devices,
+    //   and each GPU preference its own hardware devices.
+    // - Direct2D is multithreaded, so the render threads of all engines may draw at once.
+    //   Whatever goes to the immediate Direct3D context directly must be done while
+    //   holding Lock(), which is the same lock Direct2D takes for its own work.
+    // - The first engine to find the device lost marks it as such. All engines then get
+    //   the same new device for their next frame, so it's only recreated once.
+    class SharedDevice
+    {
+    public:
+        [[nodiscard]] static ::Microsoft::WRL::ComPtr<ID2D1Factory1> Factory();
+        [[nodiscard]] static HRESULT Acquire(const bool softwareRendering, const DXGI_GPU_PREFERENCE gpuPreference, std::shared_ptr<SharedDevice>& device) noexcept;
+
+        [[nodiscard]] ID3D11Device* D3DDevice() const noexcept;
+        [[nodiscard]] ID3D11DeviceContext* D3DDeviceContext() const noexcept;
+        [[nodiscard]] IDXGIDevice* DxgiDevice() const noexcept;
+        [[nodiscard]] IDXGIFactory2* DxgiFactory() const noexcept;
+        [[nodiscard]] ID2D1Device* D2DDevice() const noexcept;
+
+        [[nodiscard]] auto Lock() const noexcept
+        {
+            _multithread->Enter();
+            return wil::scope_exit([this]() noexcept { _multithread->Leave(); });
+        }
+
+        void MarkLost() noexcept;
+        [[nodiscard]] bool IsLost() const noexcept;
+
+    private:
+        SharedDevice() = default;
+
+        [[nodiscard]] HRESULT _Create(const bool softwareRendering, const DXGI_GPU_PREFERENCE gpuPreference) noexcept;
+        [[nodiscard]] ::Microsoft::WRL::ComPtr<IDXGIAdapter1> _FindAdapter(const DXGI_GPU_PREFERENCE gpuPreference) const noexcept;
+
+        ::Microsoft::WRL::ComPtr<ID3D11Device> _d3dDevice;
+        ::Microsoft::WRL::ComPtr<ID3D11DeviceContext> _d3dDeviceContext;
+        ::Microsoft::WRL::ComPtr<IDXGIDevice> _dxgiDevice;
+        ::Microsoft::WRL::ComPtr<IDXGIFactory2> _dxgiFactory;
+        ::Microsoft::WRL::ComPtr<ID2D1Device> _d2dDevice;
+        ::Microsoft::WRL::ComPtr<ID2D1Multithread> _multithread;
+        std::atomic<bool> _lost{ false };
+    };
+}
@@ -97,4 +97,91 @@ class Microsoft::Console::Render::CustomTextLayoutTests
         VERIFY_ARE_EQUAL(1u, layout._runs.at(1).glyphStart);
         VERIFY_ARE_EQUAL(3u, layout._runs.at(1).glyphCount);
     }
+
+    TEST_METHOD(CachedLayoutIsReused)
+    {
+        CustomTextLayout layout;
+        layout._fontInUse = nullptr;
+
+        // Lay out "ab" as if it had gone through analysis and cache it.
+        layout._text = L"ab";
+        layout._textClusterColumns = { 1, 1 };
+        layout._glyphIndices = { 68, 69 };
+        layout._glyphClusters = { 0, 1 };
+        layout._glyphAdvances = { 8.0f, 8.0f };
+        layout._glyphOffsets.resize(2);
+
+        CustomTextLayout::LinkedRun run;
+        run.textLength = 2;
+        run.glyphCount = 2;
+        layout._runs.push_back(run);
+
+        layout._CacheLayout();
+
+        // The same text is restored from the cache.
+        VERIFY_SUCCEEDED(layout.Reset());
+        layout._text = L"ab";
+        layout._textClusterColumns = { 1, 1 };
+        VERIFY_IS_TRUE(layout._RestoreCachedLayout());
+        VERIFY_ARE_EQUAL(1u, layout._runs.size());
+        VERIFY_ARE_EQUAL(2u, layout._runs.at(0).glyphCount);
+        VERIFY_ARE_EQUAL(2u, layout._glyphIndices.size());
+        VERIFY_ARE_EQUAL(69u, layout._glyphIndices.at(1));
+
+        // The same text taking up different columns isn't.
+        VERIFY_SUCCEEDED(layout.Reset());
+        layout._text = L"ab";
+        layout._textClusterColumns = { 2, 1 };
+        VERIFY_IS_FALSE(layout._RestoreCachedLayout());
+        VERIFY_ARE_EQUAL(0u, layout._runs.size());
+
+        // Neither is other text.
+        VERIFY_SUCCEEDED(layout.Reset());
+        layout._text = L"ac";
+        layout._textClusterColumns = { 1, 1 };
+        VERIFY_IS_FALSE(layout._RestoreCachedLayout());
+    }
+
+    TEST_METHOD(AdoptedLayoutsAreReused)
+    {
+        const auto cache = [](CustomTextLayout& layout, const wchar_t* text) {
+            VERIFY_SUCCEEDED(layout.Reset());
+            layout._text = text;
+            layout._textClusterColumns = { 1, 1 };
+            layout._glyphIndices = { 68, 69 };
+            layout._glyphClusters = { 0, 1 };
+            layout._glyphAdvances = { 8.0f, 8.0f };
+            layout._glyphOffsets.resize(2);
+            layout._CacheLayout();
+        };
+
+        CustomTextLayout layout;
+        layout._fontInUse = nullptr;
+        cache(layout, L"ab");
+
+        CustomTextLayout prefetched;
+        prefetched._fontInUse = nullptr;
+        cache(prefetched, L"ab");
+        cache(prefetched, L"cd");
+
+        layout.AdoptCachedLayouts(prefetched);
+
+        // The layout that was cached already isn't there twice, and nothing is left behind.
+        VERIFY_ARE_EQUAL(2u, layout._layoutCache.size());
+        VERIFY_ARE_EQUAL(2u, layout._layoutCacheIndex.size());
+        VERIFY_ARE_EQUAL(0u, prefetched._layoutCache.size());
+        VERIFY_ARE_EQUAL(0u, prefetched._layoutCacheIndex.size());
+        VERIFY_ARE_EQUAL(0u, prefetched._layoutCacheBytes);
+
+        VERIFY_SUCCEEDED(layout.Reset());
+        layout._text = L"cd";
+        layout._textClusterColumns = { 1, 1 };
+        VERIFY_IS_TRUE(layout._RestoreCachedLayout());
+        VERIFY_ARE_EQUAL(2u, layout._glyphIndices.size());
+
+        VERIFY_SUCCEEDED(layout.Reset());
+        layout._text = L"ab";
+        layout._textClusterColumns = { 1, 1 };
+        VERIFY_IS_TRUE(layout._RestoreCachedLayout());
+    }
 };
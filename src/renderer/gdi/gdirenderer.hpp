@@ -96,10 +96,20 @@ namespace Microsoft::Console::Render
         HFONT _hfontItalic;
         TEXTMETRICW _tmFontMetrics;
 
-        static const size_t s_cPolyTextCache = 80;
-        POLYTEXTW _pPolyText[s_cPolyTextCache];
-        size_t _cPolyText;
+        // The lines queued for drawing remember the colors and font they were queued with,
+        // so that changing those doesn't have to flush the queue. The queue is drawn grouped
+        // by color, which changes the DC's state once per color instead of once per line.
+        struct PolyTextLine
+        {
+            POLYTEXTW polyText;
+            COLORREF foreground;
+            COLORREF background;
+            bool italic;
+        };
+
+        static const size_t s_cPolyTextCache = 1024;
         [[nodiscard]] HRESULT _FlushBufferLines() noexcept;
+        [[nodiscard]] HRESULT _FillBufferLineBackgrounds();
 
         std::vector<RECT> cursorInvertRects;
         XFORM cursorInvertTransform;
@@ -141,6 +151,7 @@ namespace Microsoft::Console::Render
         std::pmr::unsynchronized_pool_resource _pool;
         std::pmr::vector<std::pmr::wstring> _polyStrings;
         std::pmr::vector<std::pmr::basic_string<int>> _polyWidths;
+        std::pmr::vector<PolyTextLine> _polyLines;
 
         [[nodiscard]] HRESULT _InvalidCombine(const RECT* const prc) noexcept;
         [[nodiscard]] HRESULT _InvalidOffset(const POINT* const ppt) noexcept;
@@ -31,7 +31,9 @@ using namespace Microsoft::Console::Render;
     RETURN_HR_IF(S_FALSE, (!IsWindowVisible(_hwndTargetWindow) && !_titleChanged));
 
     // At the beginning of a new frame, we have 0 lines ready for painting in PolyTextOut
-    _cPolyText = 0;
+    _polyLines.clear();
+    _polyStrings.clear();
+    _polyWidths.clear();
 
     // Prepare our in-memory bitmap for double-buffered composition.
     RETURN_IF_FAILED(_PrepareMemoryBitmap(_hwndTargetWindow));
@@ -326,8 +328,6 @@ using namespace Microsoft::Console::Render;
         POINT ptDraw = { 0 };
         RETURN_IF_FAILED(_ScaleByFont(&coord, &ptDraw));
 
-        const auto pPolyTextLine = &_pPolyText[_cPolyText];
-
         auto& polyString = _polyStrings.emplace_back(cchLine, UNICODE_NULL);
 
         COORD const coordFontSize = _GetFontSize();
@@ -395,25 +395,30 @@ using namespace Microsoft::Console::Render;
         const auto topOffset = _currentLineRendition == LineRendition::DoubleHeightBottom ? halfHeight : 0;
         const auto bottomOffset = _currentLineRendition == LineRendition::DoubleHeightTop ? halfHeight : 0;
 
-        pPolyTextLine->lpstr = polyString.data();
+        auto& line = _polyLines.emplace_back();
+        line.foreground = _lastFg;
+        line.background = _lastBg;
+        line.italic = _lastFontItalic;
+
+        // The string and widths are pointed to when the line is drawn, because
+        // the short ones live inside their vector's elements and move when it grows.
+        // The background is filled separately, hence no ETO_OPAQUE.
+        const auto pPolyTextLine = &line.polyText;
         pPolyTextLine->n = gsl::narrow<UINT>(clusters.size());
         pPolyTextLine->x = ptDraw.x;
         pPolyTextLine->y = ptDraw.y;
-        pPolyTextLine->uiFlags = ETO_OPAQUE | ETO_CLIPPED;
+        pPolyTextLine->uiFlags = ETO_CLIPPED;
         pPolyTextLine->rcl.left = pPolyTextLine->x;
         pPolyTextLine->rcl.top = pPolyTextLine->y + topOffset;
         pPolyTextLine->rcl.right = pPolyTextLine->rcl.left + (SHORT)cchCharWidths;
         pPolyTextLine->rcl.bottom = pPolyTextLine->y + coordFontSize.Y - bottomOffset;
-        pPolyTextLine->pdx = polyWidth.data();
 
         if (trimLeft)
         {
             pPolyTextLine->rcl.left += coordFontSize.X;
         }
 
-        _cPolyText++;
-
-        if (_cPolyText >= s_cPolyTextCache)
+        if (_polyLines.size() >= s_cPolyTextCache)
         {
             LOG_IF_FAILED(_FlushBufferLines());
         }
@@ -425,6 +430,9 @@ using namespace Microsoft::Console::Render;
 
 // Routine Description:
 // - Flushes any buffer lines in the PolyTextOut cache by drawing them and freeing the strings.
+// - The backgrounds are filled first, merged into as few rectangles as possible. The text
+//   is then drawn transparently over them, grouped by font and color, so that the DC's
+//   state changes once per group instead of once per line.
 // - See also: PaintBufferLine
 // Arguments:
 // - <none>
@@ -434,26 +442,152 @@ using namespace Microsoft::Console::Render;
 {
     HRESULT hr = S_OK;
 
-    if (_cPolyText > 0)
+    if (!_polyLines.empty())
     {
-        for (size_t i = 0; i != _cPolyText; ++i)
+        try
         {
-            const auto& t = _pPolyText[i];
-            if (!ExtTextOutW(_hdcMemoryContext, t.x, t.y, t.uiFlags, &t.rcl, t.lpstr, t.n, t.pdx))
+            hr = _FillBufferLineBackgrounds();
+
+            // The strings and widths are matched to their lines by index, so it's the indices that are sorted.
+            // The sort is stable to keep lines of the same group in the order they were queued in.
+            std::pmr::vector<size_t> order(_polyLines.size(), &_pool);
+            std::iota(order.begin(), order.end(), size_t{ 0 });
+            std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) noexcept {
+                const auto& lineA = til::at(_polyLines, a);
+                const auto& lineB = til::at(_polyLines, b);
+                return std::tie(lineA.italic, lineA.foreground) < std::tie(lineB.italic, lineB.foreground);
+            });
+
+            const auto previousMode = SetBkMode(_hdcMemoryContext, TRANSPARENT);
+            const PolyTextLine* previous = nullptr;
+
+            for (const auto i : order)
             {
-                hr = E_FAIL;
-                break;
+                if (FAILED(hr))
+                {
+                    break;
+                }
+
+                const auto& line = til::at(_polyLines, i);
+                if (!previous || previous->italic != line.italic)
+                {
+                    SelectFont(_hdcMemoryContext, line.italic ? _hfontItalic : _hfont);
+                }
+                if ((!previous || previous->foreground != line.foreground) &&
+                    CLR_INVALID == SetTextColor(_hdcMemoryContext, line.foreground))
+                {
+                    hr = E_FAIL;
+                    break;
+                }
+                previous = &line;
+
+                const auto& t = line.polyText;
+                if (!ExtTextOutW(_hdcMemoryContext, t.x, t.y, t.uiFlags, &t.rcl, til::at(_polyStrings, i).data(), t.n, til::at(_polyWidths, i).data()))
+                {
+                    hr = E_FAIL;
+                }
             }
+
+            // Leave the regular font selected, which is what the metrics are measured with.
+            if (previous && previous->italic)
+            {
+                SelectFont(_hdcMemoryContext, _hfont);
+            }
+            SetBkMode(_hdcMemoryContext, previousMode);
         }
+        CATCH_RETURN();
 
+        _polyLines.clear();
         _polyStrings.clear();
         _polyWidths.clear();
+    }
 
-        ZeroMemory(_pPolyText, sizeof(_pPolyText));
+    RETURN_HR(hr);
+}
 
-        _cPolyText = 0;
+// Routine Description:
+// - Fills the backgrounds of the queued buffer lines. The runs of a color that touch
+//   each other on a row are merged, and so are the merged runs of consecutive rows that
+//   line up, so a block of color takes a single FillRect no matter how many lines it spans.
+// - See also: _FlushBufferLines
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or E_FAIL if GDI failed.
+[[nodiscard]] HRESULT GdiEngine::_FillBufferLineBackgrounds()
+{
+    struct Fill
+    {
+        COLORREF color;
+        RECT rect;
+    };
+
+    std::pmr::vector<Fill> fills{ &_pool };
+    fills.reserve(_polyLines.size());
+    for (const auto& line : _polyLines)
+    {
+        fills.push_back({ line.background, line.polyText.rcl });
+    }
+
+    // Merges each fill into the previous one if the given function says they can be,
+    // which only ever looks at neighbors, so the fills have to be sorted to line them up.
+    const auto merge = [&](auto&& tryMerge) {
+        size_t count = 0;
+        for (const auto& fill : fills)
+        {
+            if (count == 0 || !tryMerge(til::at(fills, count - 1), fill))
+            {
+                til::at(fills, count++) = fill;
+            }
+        }
+        fills.resize(count);
+    };
+
+    // Merge along the rows first...
+    std::sort(fills.begin(), fills.end(), [](const Fill& a, const Fill& b) noexcept {
+        return std::tie(a.color, a.rect.top, a.rect.bottom, a.rect.left) < std::tie(b.color, b.rect.top, b.rect.bottom, b.rect.left);
+    });
+    merge([](Fill& a, const Fill& b) noexcept {
+        if (a.color == b.color && a.rect.top == b.rect.top && a.rect.bottom == b.rect.bottom && a.rect.right >= b.rect.left)
+        {
+            a.rect.right = std::max(a.rect.right, b.rect.right);
+            return true;
+        }
+        return false;
+    });
+
+    // ...then across them.
+    std::sort(fills.begin(), fills.end(), [](const Fill& a, const Fill& b) noexcept {
+        return std::tie(a.color, a.rect.left, a.rect.right, a.rect.top) < std::tie(b.color, b.rect.left, b.rect.right, b.rect.top);
+    });
+    merge([](Fill& a, const Fill& b) noexcept {
+        if (a.color == b.color && a.rect.left == b.rect.left && a.rect.right == b.rect.right && a.rect.bottom >= b.rect.top)
+        {
+            a.rect.bottom = std::max(a.rect.bottom, b.rect.bottom);
+            return true;
+        }
+        return false;
+    });
+
+    // The DC brush is also used for the default background, so it's restored afterwards.
+    const auto brush = GetStockBrush(DC_BRUSH);
+    const auto previousColor = GetDCBrushColor(_hdcMemoryContext);
+    auto hr = S_OK;
+
+    for (auto it = fills.begin(); it != fills.end(); ++it)
+    {
+        if (it == fills.begin() || std::prev(it)->color != it->color)
+        {
+            SetDCBrushColor(_hdcMemoryContext, it->color);
+        }
+        if (!FillRect(_hdcMemoryContext, &it->rect, brush))
+        {
+            hr = E_FAIL;
+            break;
+        }
     }
 
+    SetDCBrushColor(_hdcMemoryContext, previousColor);
     RETURN_HR(hr);
 }
 
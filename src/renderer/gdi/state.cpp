@@ -25,7 +25,6 @@ GdiEngine::GdiEngine() :
 #endif
     _iCurrentDpi(s_iBaseDpi),
     _hbitmapMemorySurface(nullptr),
-    _cPolyText(0),
     _fInvalidRectUsed(false),
     _lastFg(INVALID_COLOR),
     _lastBg(INVALID_COLOR),
@@ -38,9 +37,9 @@ GdiEngine::GdiEngine() :
     _hfontItalic(nullptr),
     _pool{ til::pmr::get_default_resource() }, // It's important the pool is first so it can be given to the others on construction.
     _polyStrings{ &_pool },
-    _polyWidths{ &_pool }
+    _polyWidths{ &_pool },
+    _polyLines{ &_pool }
 {
-    ZeroMemory(_pPolyText, sizeof(POLYTEXTW) * s_cPolyTextCache);
     _rcInvalid = { 0 };
     _szInvalidScroll = { 0 };
     _szMemorySurface = { 0 };
@@ -79,14 +78,6 @@ GdiEngine::GdiEngine() :
 // - <none>
 GdiEngine::~GdiEngine()
 {
-    for (size_t iPoly = 0; iPoly < _cPolyText; iPoly++)
-    {
-        if (_pPolyText[iPoly].lpstr != nullptr)
-        {
-            delete[] _pPolyText[iPoly].lpstr;
-        }
-    }
-
     if (_hbitmapMemorySurface != nullptr)
     {
         LOG_HR_IF(E_FAIL, !(DeleteObject(_hbitmapMemorySurface)));
@@ -277,23 +268,14 @@ GdiEngine::~GdiEngine()
                                                       const gsl::not_null<IRenderData*> pData,
                                                       const bool isSettingDefaultBrushes) noexcept
 {
-    RETURN_IF_FAILED(_FlushBufferLines());
-
     RETURN_HR_IF_NULL(HRESULT_FROM_WIN32(ERROR_INVALID_STATE), _hdcMemoryContext);
 
-    // Set the colors for painting text
+    // Remember the colors and font for the lines queued from now on. They're only
+    // selected into the DC when the queue is drawn, see _FlushBufferLines.
     const auto [colorForeground, colorBackground] = pData->GetAttributeColors(textAttributes);
-
-    if (colorForeground != _lastFg)
-    {
-        RETURN_HR_IF(E_FAIL, CLR_INVALID == SetTextColor(_hdcMemoryContext, colorForeground));
-        _lastFg = colorForeground;
-    }
-    if (colorBackground != _lastBg)
-    {
-        RETURN_HR_IF(E_FAIL, CLR_INVALID == SetBkColor(_hdcMemoryContext, colorBackground));
-        _lastBg = colorBackground;
-    }
+    _lastFg = colorForeground;
+    _lastBg = colorBackground;
+    _lastFontItalic = textAttributes.IsItalic();
 
     if (isSettingDefaultBrushes)
     {
@@ -304,14 +286,6 @@ GdiEngine::~GdiEngine()
         RETURN_IF_FAILED(s_SetWindowLongWHelper(_hwndTargetWindow, GWL_CONSOLE_BKCOLOR, colorBackground));
     }
 
-    // If the italic attribute has changed, select an appropriate font variant.
-    const auto fontItalic = textAttributes.IsItalic();
-    if (fontItalic != _lastFontItalic)
-    {
-        SelectFont(_hdcMemoryContext, fontItalic ? _hfontItalic : _hfont);
-        _lastFontItalic = fontItalic;
-    }
-
     return S_OK;
 }
 
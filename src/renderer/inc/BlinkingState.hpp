@@ -11,13 +11,16 @@ Abstract:
 - It tracks the position in the blinking cycle, which determines whether any
   blinking cells should be rendered as on or off/faint. It also records whether
   blinking attributes are actually in use or not, so we can decide whether the
-  screen needs to be refreshed when the blinking cycle changes.
+  screen needs to be refreshed when the blinking cycle changes. Only the rows
+  of the viewport that have blinking text are refreshed then.
 --*/
 
 #pragma once
 
 #include "IRenderTarget.hpp"
 
+class TextBuffer;
+
 namespace Microsoft::Console::Render
 {
     class BlinkingState
@@ -26,12 +29,14 @@ namespace Microsoft::Console::Render
         void SetBlinkingAllowed(const bool blinkingAllowed) noexcept;
         void RecordBlinkingUsage(const TextAttribute& attr) noexcept;
         bool IsBlinkingFaint() const noexcept;
-        void ToggleBlinkingRendition(IRenderTarget& renderTarget) noexcept;
+        void ToggleBlinkingRendition(IRenderTarget& renderTarget,
+                                     const TextBuffer& buffer,
+                                     const Microsoft::Console::Types::Viewport& viewport) noexcept;
 
     private:
         bool _blinkingAllowed = true;
         size_t _blinkingCycle = 0;
-        bool _blinkingIsInUse = false;
+        std::atomic<bool> _blinkingIsInUse{ false };
         bool _blinkingShouldBeFaint = false;
     };
 }
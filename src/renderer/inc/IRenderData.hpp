@@ -37,6 +37,14 @@ namespace Microsoft::Console::Render
         const Microsoft::Console::Types::Viewport region;
     };
 
+    // A keystroke whose echo reached the buffer: its sequence number (counting up from 1)
+    // and when it was sent. The renderer reports how long it took until it was presented.
+    struct InputEcho final
+    {
+        uint64_t sequence = 0;
+        std::chrono::steady_clock::time_point time{};
+    };
+
     class IRenderData : public Microsoft::Console::Types::IBaseData
     {
     public:
@@ -70,6 +78,18 @@ namespace Microsoft::Console::Render
         virtual const std::wstring GetHyperlinkCustomId(uint16_t id) const noexcept = 0;
 
         virtual const std::vector<size_t> GetPatternId(const COORD location) const noexcept = 0;
+        virtual uint64_t GetPatternGeneration() const noexcept = 0;
+
+        // The search matches to highlight in the viewport, in buffer coordinates, one rectangle per row.
+        virtual std::vector<Microsoft::Console::Types::Viewport> GetSearchHighlights() const noexcept = 0;
+
+        // The last keystroke whose echo is in the buffer, or a sequence of 0 if there's none.
+        virtual InputEcho GetInputEcho() const noexcept = 0;
+
+        // Like LockConsole, but only for reading the data to paint it,
+        // which others that only read may do at the same time.
+        virtual void LockConsoleShared() noexcept = 0;
+        virtual void UnlockConsoleShared() noexcept = 0;
 
     protected:
         IRenderData() = default;
@@ -18,6 +18,7 @@ Author(s):
 #include "Cluster.hpp"
 #include "FontInfoDesired.hpp"
 #include "IRenderData.hpp"
+#include "../../buffer/out/ImageStore.hpp"
 #include "../../buffer/out/LineRendition.hpp"
 
 namespace Microsoft::Console::Render
@@ -25,6 +26,10 @@ namespace Microsoft::Console::Render
     struct RenderFrameInfo
     {
         std::optional<CursorOptions> cursorInfo;
+        // The selected cells, relative to the viewport, with exclusive right and bottom edges.
+        gsl::span<const SMALL_RECT> selection;
+        // The cells of the search matches to highlight, in the same form as the selection.
+        gsl::span<const SMALL_RECT> searchHighlights;
     };
 
     class IRenderEngine
@@ -57,7 +62,8 @@ namespace Microsoft::Console::Render
         [[nodiscard]] virtual HRESULT EndPaint() noexcept = 0;
 
         [[nodiscard]] virtual bool RequiresContinuousRedraw() noexcept = 0;
-        virtual void WaitUntilCanRender() noexcept = 0;
+        [[nodiscard]] virtual std::chrono::milliseconds GetContinuousRedrawInterval() noexcept = 0;
+        [[nodiscard]] virtual bool WaitUntilCanRender() noexcept = 0;
         [[nodiscard]] virtual HRESULT Present() noexcept = 0;
 
         [[nodiscard]] virtual HRESULT PrepareForTeardown(_Out_ bool* const pForcePaint) noexcept = 0;
@@ -86,11 +92,17 @@ namespace Microsoft::Console::Render
                                                       const COORD coord,
                                                       const bool fTrimLeft,
                                                       const bool lineWrapped) noexcept = 0;
+        [[nodiscard]] virtual HRESULT PrefetchBufferLine(gsl::span<const Cluster> const clusters,
+                                                         const COORD coord,
+                                                         const TextAttribute& textAttributes) noexcept = 0;
         [[nodiscard]] virtual HRESULT PaintBufferGridLines(const GridLines lines,
                                                            const COLORREF color,
                                                            const size_t cchLine,
                                                            const COORD coordTarget) noexcept = 0;
         [[nodiscard]] virtual HRESULT PaintSelection(const SMALL_RECT rect) noexcept = 0;
+        [[nodiscard]] virtual HRESULT PaintImage(const std::shared_ptr<const ImageStore::Image>& image,
+                                                 const til::point origin,
+                                                 const til::rectangle clip) noexcept = 0;
 
         [[nodiscard]] virtual HRESULT PaintCursor(const CursorOptions& options) noexcept = 0;
 
@@ -110,6 +122,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] virtual HRESULT GetFontSize(_Out_ COORD* const pFontSize) noexcept = 0;
         [[nodiscard]] virtual HRESULT IsGlyphWideByFont(const std::wstring_view glyph, _Out_ bool* const pResult) noexcept = 0;
         [[nodiscard]] virtual HRESULT UpdateTitle(const std::wstring_view newTitle) noexcept = 0;
+        virtual void Trim() noexcept = 0;
     };
 
     inline Microsoft::Console::Render::IRenderEngine::~IRenderEngine() {}
@@ -25,9 +25,14 @@ namespace Microsoft::Console::Render
         IRenderThread& operator=(IRenderThread&&) = default;
 
         virtual void NotifyPaint() = 0;
+        virtual void NotifyPaintAfter(const std::chrono::milliseconds delay) = 0;
         virtual void EnablePainting() = 0;
         virtual void DisablePainting() = 0;
         virtual void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) = 0;
+        virtual void SuspendPainting() = 0;
+        virtual void ResumePainting() = 0;
+        virtual void SetMinimumFrameInterval(const std::chrono::milliseconds interval) = 0;
+        virtual void SetPriority(const int priority) = 0;
 
     protected:
         IRenderThread() = default;
@@ -46,6 +46,7 @@ namespace Microsoft::Console::Render
         virtual void TriggerScroll(const COORD* const pcoordDelta) = 0;
         virtual void TriggerCircling() = 0;
         virtual void TriggerTitleChange() = 0;
+        virtual void SetSynchronizedOutput(const bool enabled) = 0;
         virtual void TriggerFontChange(const int iDpi,
                                        const FontInfoDesired& FontInfoDesired,
                                        _Out_ FontInfo& FontInfo) = 0;
@@ -58,7 +59,9 @@ namespace Microsoft::Console::Render
 
         virtual void EnablePainting() = 0;
         virtual void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) = 0;
-        virtual void WaitUntilCanRender() = 0;
+        virtual void SuspendPainting() = 0;
+        virtual void ResumePainting() = 0;
+        [[nodiscard]] virtual bool WaitUntilCanRender() = 0;
 
         virtual void AddRenderEngine(_In_ IRenderEngine* const pEngine) = 0;
 
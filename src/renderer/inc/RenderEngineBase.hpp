@@ -40,14 +40,25 @@ namespace Microsoft::Console::Render
 
         [[nodiscard]] HRESULT PrepareRenderInfo(const RenderFrameInfo& info) noexcept override;
 
+        [[nodiscard]] HRESULT PaintImage(const std::shared_ptr<const ImageStore::Image>& image,
+                                         const til::point origin,
+                                         const til::rectangle clip) noexcept override;
+
+        [[nodiscard]] HRESULT PrefetchBufferLine(gsl::span<const Cluster> const clusters,
+                                                 const COORD coord,
+                                                 const TextAttribute& textAttributes) noexcept override;
+
         [[nodiscard]] HRESULT ResetLineTransform() noexcept override;
         [[nodiscard]] HRESULT PrepareLineTransform(const LineRendition lineRendition,
                                                    const size_t targetRow,
                                                    const size_t viewportLeft) noexcept override;
 
         [[nodiscard]] virtual bool RequiresContinuousRedraw() noexcept override;
+        [[nodiscard]] virtual std::chrono::milliseconds GetContinuousRedrawInterval() noexcept override;
+
+        [[nodiscard]] bool WaitUntilCanRender() noexcept override;
 
-        void WaitUntilCanRender() noexcept override;
+        void Trim() noexcept override;
 
     protected:
         [[nodiscard]] virtual HRESULT _DoUpdateTitle(const std::wstring_view newTitle) noexcept = 0;
@@ -20,7 +20,6 @@ UiaEngine::UiaEngine(IUiaEventDispatcher* dispatcher) :
     _textBufferChanged{ false },
     _cursorChanged{ false },
     _isEnabled{ true },
-    _prevSelection{},
     _prevCursorRegion{},
     RenderEngineBase()
 {
@@ -40,6 +39,8 @@ UiaEngine::UiaEngine(IUiaEventDispatcher* dispatcher) :
 
 // Routine Description:
 // - Sets this engine to disabled to prevent presentation from occurring
+// - Changes that weren't signaled yet are dropped, since they're
+//   only of interest to clients listening while we're enabled.
 // Arguments:
 // - <none>
 // Return Value:
@@ -47,9 +48,26 @@ UiaEngine::UiaEngine(IUiaEventDispatcher* dispatcher) :
 [[nodiscard]] HRESULT UiaEngine::Disable() noexcept
 {
     _isEnabled = false;
+    _DropChanges();
     return S_OK;
 }
 
+// Routine Description:
+// - Forgets about the changes that weren't signaled yet.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void UiaEngine::_DropChanges() noexcept
+{
+    _selectionChanged = false;
+    _textBufferChanged = false;
+    _cursorChanged = false;
+    _textBufferQueued = false;
+    _cursorQueued = false;
+    _held = false;
+}
+
 // Routine Description:
 // - Notifies us that the console has changed the character region specified.
 // - NOTE: This typically triggers on cursor or text buffer changes
@@ -59,6 +77,7 @@ UiaEngine::UiaEngine(IUiaEventDispatcher* dispatcher) :
 // - S_OK, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT UiaEngine::Invalidate(const SMALL_RECT* const /*psrRegion*/) noexcept
 {
+    RETURN_HR_IF(S_FALSE, !_isEnabled);
     _textBufferChanged = true;
     return S_OK;
 }
@@ -74,6 +93,7 @@ UiaEngine::UiaEngine(IUiaEventDispatcher* dispatcher) :
 try
 {
     RETURN_HR_IF_NULL(E_INVALIDARG, psrRegion);
+    RETURN_HR_IF(S_FALSE, !_isEnabled);
 
     // check if cursor moved
     if (*psrRegion != _prevCursorRegion)
@@ -104,40 +124,13 @@ CATCH_RETURN();
 // - rectangles - One or more rectangles describing character positions on the grid
 // Return Value:
 // - S_OK
-[[nodiscard]] HRESULT UiaEngine::InvalidateSelection(const std::vector<SMALL_RECT>& rectangles) noexcept
+[[nodiscard]] HRESULT UiaEngine::InvalidateSelection(const std::vector<SMALL_RECT>& /*rectangles*/) noexcept
 {
-    // early exit: different number of rows
-    if (_prevSelection.size() != rectangles.size())
-    {
-        try
-        {
-            _selectionChanged = true;
-            _prevSelection = rectangles;
-        }
-        CATCH_LOG_RETURN_HR(E_FAIL);
-        return S_OK;
-    }
-
-    for (size_t i = 0; i < rectangles.size(); i++)
-    {
-        try
-        {
-            const auto prevRect = _prevSelection.at(i);
-            const auto newRect = rectangles.at(i);
-
-            // if any value is different, selection has changed
-            if (prevRect.Top != newRect.Top || prevRect.Right != newRect.Right || prevRect.Left != newRect.Left || prevRect.Bottom != newRect.Bottom)
-            {
-                _selectionChanged = true;
-                _prevSelection = rectangles;
-                return S_OK;
-            }
-        }
-        CATCH_LOG_RETURN_HR(E_FAIL);
-    }
+    RETURN_HR_IF(S_FALSE, !_isEnabled);
 
-    // assume selection has not changed
-    _selectionChanged = false;
+    // The renderer only calls this when the selection changed, with the visible parts
+    // that changed. Those may be none at all, if the change is scrolled out of view.
+    _selectionChanged = true;
     return S_OK;
 }
 
@@ -164,6 +157,7 @@ CATCH_RETURN();
 // - S_OK, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT UiaEngine::InvalidateAll() noexcept
 {
+    RETURN_HR_IF(S_FALSE, !_isEnabled);
     _textBufferChanged = true;
     return S_OK;
 }
@@ -206,8 +200,17 @@ CATCH_RETURN();
 {
     RETURN_HR_IF(S_FALSE, !_isEnabled);
 
+    // Without any automation clients there's nobody to signal, so we stay out
+    // of the frame entirely. Clients that come along later ask for the
+    // current state anyways, which is why the changes can be dropped.
+    if (!UiaClientsAreListening())
+    {
+        _DropChanges();
+        return S_FALSE;
+    }
+
     // add more events here
-    const bool somethingToDo = _selectionChanged || _textBufferChanged || _cursorChanged;
+    const bool somethingToDo = _selectionChanged || _textBufferChanged || _cursorChanged || _textBufferQueued || _cursorQueued;
 
     // If there's nothing to do, quick return
     RETURN_HR_IF(S_FALSE, !somethingToDo);
@@ -217,7 +220,11 @@ CATCH_RETURN();
 }
 
 // Routine Description:
-// - Ends batch drawing and notifies automation clients of updated regions
+// - Ends batch drawing and decides which events to notify automation clients
+//   of. Selection changes are signaled with every frame. Text and cursor changes
+//   are coalesced: they're signaled right away if the last ones were signaled
+//   at least an interval ago, and are held back until then otherwise.
+// - The events are signaled by Present, outside of the lock.
 // Arguments:
 // - <none>
 // Return Value:
@@ -227,8 +234,89 @@ CATCH_RETURN();
     RETURN_HR_IF(S_FALSE, !_isEnabled);
     RETURN_HR_IF(E_INVALIDARG, !_isPainting); // invalid to end paint when we're not painting
 
+    _signalSelection = _signalSelection || _selectionChanged;
+    _textBufferQueued = _textBufferQueued || _textBufferChanged;
+    _cursorQueued = _cursorQueued || _cursorChanged;
+
+    if (_textBufferQueued || _cursorQueued)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - _lastSignal >= _CurrentInterval())
+        {
+            // A change after a quiet interval ends sustained output. One that
+            // had to be held back continues it.
+            _heldSignals = _held ? _heldSignals + 1 : 0;
+            _held = false;
+            _lastSignal = now;
+
+            _signalTextBuffer = _signalTextBuffer || _textBufferQueued;
+            _signalCursor = _signalCursor || _cursorQueued;
+            _textBufferQueued = false;
+            _cursorQueued = false;
+        }
+        else
+        {
+            _held = true;
+        }
+    }
+
+    _selectionChanged = false;
+    _textBufferChanged = false;
+    _cursorChanged = false;
+    _isPainting = false;
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Gets how long text and cursor changes are coalesced for.
+// Arguments:
+// - <none>
+// Return Value:
+// - The minimum time between two signals of text or cursor changes.
+std::chrono::milliseconds UiaEngine::_CurrentInterval() const noexcept
+{
+    return _heldSignals >= s_sustainedSignals ? s_sustainedInterval : s_minimumInterval;
+}
+
+// Routine Description:
+// - Held back changes have to be signaled once their interval is over, even if
+//   nothing else changes by then, so that clients end up with the final state.
+// Arguments:
+// - <none>
+// Return Value:
+// - True if changes are held back.
+[[nodiscard]] bool UiaEngine::RequiresContinuousRedraw() noexcept
+{
+    return _isEnabled && (_textBufferQueued || _cursorQueued);
+}
+
+// Routine Description:
+// - Gets the time until the interval of the held back changes is over.
+// Arguments:
+// - <none>
+// Return Value:
+// - The time to wait before the next frame.
+[[nodiscard]] std::chrono::milliseconds UiaEngine::GetContinuousRedrawInterval() noexcept
+{
+    const auto remaining = _lastSignal + _CurrentInterval() - std::chrono::steady_clock::now();
+    return std::max(std::chrono::ceil<std::chrono::milliseconds>(remaining), std::chrono::milliseconds{ 1 });
+}
+
+// Routine Description:
+// - Used to perform longer running presentation steps outside the lock so the
+//      other threads can continue.
+// - Notifies automation clients of the events EndPaint decided on.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK if we signaled anything, S_FALSE otherwise.
+[[nodiscard]] HRESULT UiaEngine::Present() noexcept
+{
+    const auto signaled = _signalSelection || _signalTextBuffer || _signalCursor;
+
     // Fire UIA Events here
-    if (_selectionChanged)
+    if (_signalSelection)
     {
         try
         {
@@ -236,7 +324,7 @@ CATCH_RETURN();
         }
         CATCH_LOG();
     }
-    if (_textBufferChanged)
+    if (_signalTextBuffer)
     {
         try
         {
@@ -244,7 +332,7 @@ CATCH_RETURN();
         }
         CATCH_LOG();
     }
-    if (_cursorChanged)
+    if (_signalCursor)
     {
         try
         {
@@ -253,25 +341,11 @@ CATCH_RETURN();
         CATCH_LOG();
     }
 
-    _selectionChanged = false;
-    _textBufferChanged = false;
-    _cursorChanged = false;
-    _isPainting = false;
+    _signalSelection = false;
+    _signalTextBuffer = false;
+    _signalCursor = false;
 
-    return S_OK;
-}
-
-// Routine Description:
-// - Used to perform longer running presentation steps outside the lock so the
-//      other threads can continue.
-// - Not currently used by UiaEngine.
-// Arguments:
-// - <none>
-// Return Value:
-// - S_FALSE since we do nothing.
-[[nodiscard]] HRESULT UiaEngine::Present() noexcept
-{
-    return S_FALSE;
+    return signaled ? S_OK : S_FALSE;
 }
 
 // Routine Description:
@@ -36,6 +36,8 @@ namespace Microsoft::Console::Render
         // IRenderEngine Members
         [[nodiscard]] HRESULT StartPaint() noexcept override;
         [[nodiscard]] HRESULT EndPaint() noexcept override;
+        [[nodiscard]] bool RequiresContinuousRedraw() noexcept override;
+        [[nodiscard]] std::chrono::milliseconds GetContinuousRedrawInterval() noexcept override;
         [[nodiscard]] HRESULT Present() noexcept override;
 
         [[nodiscard]] HRESULT PrepareForTeardown(_Out_ bool* const pForcePaint) noexcept override;
@@ -83,9 +85,30 @@ namespace Microsoft::Console::Render
         bool _textBufferChanged;
         bool _cursorChanged;
 
+        // Text and cursor changes are signaled at most once per interval, so that
+        // heavy output doesn't flood the automation clients. Changes that come in
+        // during the interval are held back and signaled together once it's over.
+        // If that keeps happening, the output is sustained and the interval grows.
+        static constexpr std::chrono::milliseconds s_minimumInterval{ 50 };
+        static constexpr std::chrono::milliseconds s_sustainedInterval{ 500 };
+        static constexpr size_t s_sustainedSignals{ 20 };
+
+        bool _textBufferQueued{ false };
+        bool _cursorQueued{ false };
+        bool _held{ false };
+        size_t _heldSignals{ 0 };
+        std::chrono::steady_clock::time_point _lastSignal{};
+
+        // The events EndPaint decided on, which Present signals outside the lock.
+        bool _signalSelection{ false };
+        bool _signalTextBuffer{ false };
+        bool _signalCursor{ false };
+
+        std::chrono::milliseconds _CurrentInterval() const noexcept;
+        void _DropChanges() noexcept;
+
         Microsoft::Console::Types::IUiaEventDispatcher* _dispatcher;
 
-        std::vector<SMALL_RECT> _prevSelection;
         SMALL_RECT _prevCursorRegion;
     };
 }
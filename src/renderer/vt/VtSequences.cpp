@@ -475,3 +475,15 @@ using namespace Microsoft::Console::Render;
     // Closing OSC8 sequence
     return _Write("\x1b]8;;\x1b\\");
 }
+
+// Method Description:
+// - Formats and writes a sequence to repeat the last character written to the
+//   terminal the given number of times (REP).
+// Arguments:
+// - count: the number of times to repeat the character
+// Return Value:
+// - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
+[[nodiscard]] HRESULT VtEngine::_RepeatCharacter(const size_t count) noexcept
+{
+    return _WriteFormatted(FMT_COMPILE("\x1b[{}b"), count);
+}
@@ -28,107 +28,184 @@ Xterm256Engine::Xterm256Engine(_In_ wil::unique_hfile hPipe,
                                                            const gsl::not_null<IRenderData*> pData,
                                                            const bool /*isSettingDefaultBrushes*/) noexcept
 {
-    RETURN_IF_FAILED(VtEngine::_RgbUpdateDrawingBrushes(textAttributes));
-
-    RETURN_IF_FAILED(_UpdateHyperlinkAttr(textAttributes, pData));
-
     // Only do extended attributes in xterm-256color, as to not break telnet.exe.
-    return _UpdateExtendedAttrs(textAttributes);
+    RETURN_IF_FAILED(_UpdateGraphicsRendition(textAttributes));
+
+    return _UpdateHyperlinkAttr(textAttributes, pData);
 }
 
 // Routine Description:
-// - Write a VT sequence to update the character rendition attributes.
+// - Write a VT sequence to update the colors and the character rendition
+//   attributes. All the changes are combined into a single SGR sequence, which
+//   is either the changes relative to what the terminal uses now, or a reset
+//   followed by the changes relative to the defaults, whichever is shorter.
 // Arguments:
-// - textAttributes - text attributes (bold, italic, underline, etc.) to use.
+// - textAttributes - text attributes (colors, bold, italic, underline, etc.) to use.
 // Return Value:
 // - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
-[[nodiscard]] HRESULT Xterm256Engine::_UpdateExtendedAttrs(const TextAttribute& textAttributes) noexcept
+[[nodiscard]] HRESULT Xterm256Engine::_UpdateGraphicsRendition(const TextAttribute& textAttributes) noexcept
+try
 {
-    // Turning off Bold and Faint must be handled at the same time,
-    // since there is only one sequence that resets both of them.
-    const auto boldTurnedOff = !textAttributes.IsBold() && _lastTextAttributes.IsBold();
-    const auto faintTurnedOff = !textAttributes.IsFaint() && _lastTextAttributes.IsFaint();
-    if (boldTurnedOff || faintTurnedOff)
+    SgrParameters changes;
+    _AppendColorChanges(changes, _lastTextAttributes, textAttributes);
+    _AppendRenditionChanges(changes, _lastTextAttributes, textAttributes);
+    if (changes.size() == 0)
     {
-        RETURN_IF_FAILED(_SetBold(false));
-        _lastTextAttributes.SetBold(false);
-        _lastTextAttributes.SetFaint(false);
+        return S_OK;
     }
 
-    // Once we've handled the cases where they need to be turned off,
-    // we can then check if either should be turned back on again.
-    if (textAttributes.IsBold() && !_lastTextAttributes.IsBold())
+    // SGR 0 resets everything but the hyperlink, which is handled separately.
+    auto defaults = _lastTextAttributes;
+    defaults.SetDefaultForeground();
+    defaults.SetDefaultBackground();
+    defaults.SetDefaultMetaAttrs();
+
+    SgrParameters changesAfterReset;
+    _AppendColorChanges(changesAfterReset, defaults, textAttributes);
+    _AppendRenditionChanges(changesAfterReset, defaults, textAttributes);
+
+    // Each list starts with a separator, which is dropped from the changes when
+    // they're written out, and follows the 0 of the reset. A lone reset is just "\x1b[m".
+    const auto resetLength = changesAfterReset.size() == 0 ? 0 : changesAfterReset.size() + 1;
+    if (resetLength < changes.size() - 1)
     {
-        RETURN_IF_FAILED(_SetBold(true));
-        _lastTextAttributes.SetBold(true);
+        RETURN_IF_FAILED(_WriteFormatted(FMT_COMPILE("\x1b[{}{}m"), resetLength == 0 ? "" : "0", std::string_view{ changesAfterReset.data(), changesAfterReset.size() }));
     }
-    if (textAttributes.IsFaint() && !_lastTextAttributes.IsFaint())
+    else
     {
-        RETURN_IF_FAILED(_SetFaint(true));
-        _lastTextAttributes.SetFaint(true);
+        RETURN_IF_FAILED(_WriteFormatted(FMT_COMPILE("\x1b[{}m"), std::string_view{ changes.data() + 1, changes.size() - 1 }));
     }
 
-    // Turning off the underline styles must be handled at the same time,
-    // since there is only one sequence that resets both of them.
-    const auto singleTurnedOff = !textAttributes.IsUnderlined() && _lastTextAttributes.IsUnderlined();
-    const auto doubleTurnedOff = !textAttributes.IsDoublyUnderlined() && _lastTextAttributes.IsDoublyUnderlined();
-    if (singleTurnedOff || doubleTurnedOff)
+    // Keep the hyperlink of the terminal, that's _UpdateHyperlinkAttr's job.
+    const auto hyperlinkId = _lastTextAttributes.GetHyperlinkId();
+    _lastTextAttributes = textAttributes;
+    _lastTextAttributes.SetHyperlinkId(hyperlinkId);
+    return S_OK;
+}
+CATCH_RETURN();
+
+// Routine Description:
+// - Appends the SGR parameters that change the colors from the given ones to
+//   the wanted ones, each preceded by a separator.
+// Arguments:
+// - parameters - the list to append to
+// - from - the attributes whose colors the terminal uses
+// - to - the attributes whose colors we want
+// Return Value:
+// - <none>
+void Xterm256Engine::_AppendColorChanges(SgrParameters& parameters, const TextAttribute& from, const TextAttribute& to)
+{
+    const auto appendColor = [&](const TextColor& color, const char type) {
+        if (color.IsDefault())
+        {
+            fmt::format_to(std::back_inserter(parameters), FMT_COMPILE(";{}9"), type);
+        }
+        else if (color.IsIndex16())
+        {
+            // See _SetGraphicsRendition16Color for how the legacy index maps to VT.
+            const auto index = color.GetIndex();
+            const int vtIndex = (type == '3' ? 30 : 40) +
+                                (WI_IsFlagSet(index, FOREGROUND_INTENSITY) ? 60 : 0) +
+                                (WI_IsFlagSet(index, FOREGROUND_RED) ? 1 : 0) +
+                                (WI_IsFlagSet(index, FOREGROUND_GREEN) ? 2 : 0) +
+                                (WI_IsFlagSet(index, FOREGROUND_BLUE) ? 4 : 0);
+            fmt::format_to(std::back_inserter(parameters), FMT_COMPILE(";{}"), vtIndex);
+        }
+        else if (color.IsIndex256())
+        {
+            fmt::format_to(std::back_inserter(parameters), FMT_COMPILE(";{}8;5;{}"), type, ::Xterm256ToWindowsIndex(color.GetIndex()));
+        }
+        else if (color.IsRgb())
+        {
+            const auto rgb = color.GetRGB();
+            fmt::format_to(std::back_inserter(parameters), FMT_COMPILE(";{}8;2;{};{};{}"), type, GetRValue(rgb), GetGValue(rgb), GetBValue(rgb));
+        }
+    };
+
+    if (to.GetForeground() != from.GetForeground())
     {
-        RETURN_IF_FAILED(_SetUnderlined(false));
-        _lastTextAttributes.SetUnderlined(false);
-        _lastTextAttributes.SetDoublyUnderlined(false);
+        appendColor(to.GetForeground(), '3');
     }
+    if (to.GetBackground() != from.GetBackground())
+    {
+        appendColor(to.GetBackground(), '4');
+    }
+}
 
-    // Once we've handled the cases where they need to be turned off,
-    // we can then check if either should be turned back on again.
-    if (textAttributes.IsUnderlined() && !_lastTextAttributes.IsUnderlined())
+// Routine Description:
+// - Appends the SGR parameters that change the character rendition attributes
+//   from the given ones to the wanted ones, each preceded by a separator.
+// Arguments:
+// - parameters - the list to append to
+// - from - the attributes whose rendition the terminal uses
+// - to - the attributes whose rendition we want
+// Return Value:
+// - <none>
+void Xterm256Engine::_AppendRenditionChanges(SgrParameters& parameters, TextAttribute from, const TextAttribute& to)
+{
+    const auto append = [&](const std::string_view parameter) {
+        parameters.push_back(';');
+        parameters.append(parameter.data(), parameter.data() + parameter.size());
+    };
+
+    // Turning off Bold and Faint must be handled at the same time,
+    // since there is only one sequence that resets both of them.
+    // Once that's done, we can check if either should be turned back on again.
+    if ((from.IsBold() && !to.IsBold()) || (from.IsFaint() && !to.IsFaint()))
     {
-        RETURN_IF_FAILED(_SetUnderlined(true));
-        _lastTextAttributes.SetUnderlined(true);
+        append("22");
+        from.SetBold(false);
+        from.SetFaint(false);
     }
-    if (textAttributes.IsDoublyUnderlined() && !_lastTextAttributes.IsDoublyUnderlined())
+    if (to.IsBold() && !from.IsBold())
     {
-        RETURN_IF_FAILED(_SetDoublyUnderlined(true));
-        _lastTextAttributes.SetDoublyUnderlined(true);
+        append("1");
     }
-
-    if (textAttributes.IsOverlined() != _lastTextAttributes.IsOverlined())
+    if (to.IsFaint() && !from.IsFaint())
     {
-        RETURN_IF_FAILED(_SetOverlined(textAttributes.IsOverlined()));
-        _lastTextAttributes.SetOverlined(textAttributes.IsOverlined());
+        append("2");
     }
 
-    if (textAttributes.IsItalic() != _lastTextAttributes.IsItalic())
+    // The same goes for the single and double underline.
+    if ((from.IsUnderlined() && !to.IsUnderlined()) || (from.IsDoublyUnderlined() && !to.IsDoublyUnderlined()))
     {
-        RETURN_IF_FAILED(_SetItalic(textAttributes.IsItalic()));
-        _lastTextAttributes.SetItalic(textAttributes.IsItalic());
+        append("24");
+        from.SetUnderlined(false);
+        from.SetDoublyUnderlined(false);
     }
-
-    if (textAttributes.IsBlinking() != _lastTextAttributes.IsBlinking())
+    if (to.IsUnderlined() && !from.IsUnderlined())
     {
-        RETURN_IF_FAILED(_SetBlinking(textAttributes.IsBlinking()));
-        _lastTextAttributes.SetBlinking(textAttributes.IsBlinking());
+        append("4");
     }
-
-    if (textAttributes.IsInvisible() != _lastTextAttributes.IsInvisible())
+    if (to.IsDoublyUnderlined() && !from.IsDoublyUnderlined())
     {
-        RETURN_IF_FAILED(_SetInvisible(textAttributes.IsInvisible()));
-        _lastTextAttributes.SetInvisible(textAttributes.IsInvisible());
+        append("21");
     }
 
-    if (textAttributes.IsCrossedOut() != _lastTextAttributes.IsCrossedOut())
+    if (to.IsOverlined() != from.IsOverlined())
     {
-        RETURN_IF_FAILED(_SetCrossedOut(textAttributes.IsCrossedOut()));
-        _lastTextAttributes.SetCrossedOut(textAttributes.IsCrossedOut());
+        append(to.IsOverlined() ? "53" : "55");
     }
-
-    if (textAttributes.IsReverseVideo() != _lastTextAttributes.IsReverseVideo())
+    if (to.IsItalic() != from.IsItalic())
     {
-        RETURN_IF_FAILED(_SetReverseVideo(textAttributes.IsReverseVideo()));
-        _lastTextAttributes.SetReverseVideo(textAttributes.IsReverseVideo());
+        append(to.IsItalic() ? "3" : "23");
+    }
+    if (to.IsBlinking() != from.IsBlinking())
+    {
+        append(to.IsBlinking() ? "5" : "25");
+    }
+    if (to.IsInvisible() != from.IsInvisible())
+    {
+        append(to.IsInvisible() ? "8" : "28");
+    }
+    if (to.IsCrossedOut() != from.IsCrossedOut())
+    {
+        append(to.IsCrossedOut() ? "9" : "29");
+    }
+    if (to.IsReverseVideo() != from.IsReverseVideo())
+    {
+        append(to.IsReverseVideo() ? "7" : "27");
     }
-
-    return S_OK;
 }
 
 // Routine Description:
@@ -170,5 +247,6 @@ HRESULT Microsoft::Console::Render::Xterm256Engine::_UpdateHyperlinkAttr(const T
 // - S_OK if we wrote the sequences successfully, otherwise an appropriate HRESULT
 [[nodiscard]] HRESULT Xterm256Engine::ManuallyClearScrollback() noexcept
 {
+    _ResetShadow();
     return _ClearScrollback();
 }
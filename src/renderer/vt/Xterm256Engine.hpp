@@ -35,7 +35,12 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT ManuallyClearScrollback() noexcept override;
 
     private:
-        [[nodiscard]] HRESULT _UpdateExtendedAttrs(const TextAttribute& textAttributes) noexcept;
+        // The parameters of an SGR sequence, each preceded by a separator.
+        using SgrParameters = fmt::basic_memory_buffer<char, 64>;
+
+        [[nodiscard]] HRESULT _UpdateGraphicsRendition(const TextAttribute& textAttributes) noexcept;
+        static void _AppendColorChanges(SgrParameters& parameters, const TextAttribute& from, const TextAttribute& to);
+        static void _AppendRenditionChanges(SgrParameters& parameters, TextAttribute from, const TextAttribute& to);
         [[nodiscard]] HRESULT _UpdateHyperlinkAttr(const TextAttribute& textAttributes,
                                                    const gsl::not_null<IRenderData*> pData) noexcept;
 
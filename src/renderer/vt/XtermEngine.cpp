@@ -35,6 +35,11 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
 //      the pipe.
 [[nodiscard]] HRESULT XtermEngine::StartPaint() noexcept
 {
+    if (_passthrough)
+    {
+        return S_FALSE;
+    }
+
     RETURN_IF_FAILED(VtEngine::StartPaint());
 
     _trace.TraceLastText(_lastText);
@@ -52,6 +57,7 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
         //      the screen on the first paint, just to make sure that the
         //      terminal's state is consistent with what we'll be rendering.
         RETURN_IF_FAILED(_ClearScreen());
+        _ResetShadow();
         _clearedAllThisFrame = true;
         _firstPaint = false;
     }
@@ -384,6 +390,7 @@ try
         RETURN_IF_FAILED(_MoveCursor({ 0, bottom }));
         // Emit some number of newlines to create space in the buffer.
         RETURN_IF_FAILED(_Write(std::string(absDy, '\n')));
+        _ScrollShadow(dy);
     }
     else if (dy > 0)
     {
@@ -391,6 +398,7 @@ try
         // buffer, and insert some newlines using the InsertLines VT sequence
         RETURN_IF_FAILED(_MoveCursor({ 0, 0 }));
         RETURN_IF_FAILED(_InsertLine(absDy));
+        _ScrollShadow(dy);
     }
 
     // Restore our wrap state.
@@ -470,7 +478,7 @@ try
 {
     const til::point delta{ *pcoordDelta };
 
-    if (delta != til::point{ 0, 0 })
+    if (delta != til::point{ 0, 0 } && !_IgnoreInPassthrough())
     {
         _trace.TraceInvalidateScroll(delta);
 
@@ -478,6 +486,12 @@ try
         _invalidMap.translate(delta, true);
 
         _scrollDelta += delta;
+
+        // Any circling is followed by scrolling up for it, which moves the shadow in ScrollFrame.
+        if (delta.y() < 0)
+        {
+            _pendingCircles -= std::min(_pendingCircles, gsl::narrow_cast<size_t>(-delta.y()));
+        }
     }
 
     return S_OK;
@@ -504,9 +518,17 @@ CATCH_RETURN();
                                                    const bool /*trimLeft*/,
                                                    const bool lineWrapped) noexcept
 {
-    return _fUseAsciiOnly ?
-               VtEngine::_PaintAsciiBufferLine(clusters, coord) :
-               VtEngine::_PaintUtf8BufferLine(clusters, coord, lineWrapped);
+    if (_fUseAsciiOnly)
+    {
+        return VtEngine::_PaintAsciiBufferLine(clusters, coord);
+    }
+
+    // Only send the part of the run that the terminal doesn't already show.
+    auto run = clusters;
+    auto runCoord = coord;
+    _TrimUnchangedCells(run, runCoord, lineWrapped);
+
+    return run.empty() ? S_OK : VtEngine::_PaintUtf8BufferLine(run, runCoord, lineWrapped);
 }
 
 // Method Description:
@@ -518,6 +540,9 @@ CATCH_RETURN();
 // - S_OK or suitable HRESULT error from either conversion or writing pipe.
 [[nodiscard]] HRESULT XtermEngine::WriteTerminalW(const std::wstring_view wstr) noexcept
 {
+    // We can't tell what the string does to the terminal's contents.
+    _ResetShadow();
+
     RETURN_IF_FAILED(_fUseAsciiOnly ?
                          VtEngine::_WriteTerminalAscii(wstr) :
                          VtEngine::_WriteTerminalUtf8(wstr));
@@ -530,9 +555,25 @@ CATCH_RETURN();
     // actual frame is triggered.
     //
     // To fix this, flush here, so this string is sent to the connected terminal
-    // application.
+    // application. In passthrough mode, EndPassthroughWrite flushes everything
+    // the client wrote at once instead.
 
-    return _Flush();
+    return _forwarding && _passthrough ? S_OK : _Flush();
+}
+
+// Method Description:
+// - Ends passthrough mode. See VtEngine::_EndPassthrough. The client might have
+//      hidden the cursor as well, so it's hidden for sure, and the next frame
+//      shows it again if it's visible.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void XtermEngine::_EndPassthrough() noexcept
+{
+    VtEngine::_EndPassthrough();
+    LOG_IF_FAILED(_HideCursor());
+    _lastCursorIsVisible = false;
 }
 
 // Method Description:
@@ -61,6 +61,8 @@ namespace Microsoft::Console::Render
 
         [[nodiscard]] HRESULT _DoUpdateTitle(const std::wstring_view newTitle) noexcept override;
 
+        void _EndPassthrough() noexcept override;
+
 #ifdef UNIT_TESTING
         friend class VtRendererTest;
         friend class ConptyOutputTests;
@@ -49,6 +49,12 @@ using namespace Microsoft::Console::Render;
 [[nodiscard]] HRESULT VtEngine::Invalidate(const SMALL_RECT* const psrRegion) noexcept
 try
 {
+    // The terminal reflows itself on its resizes. See BeginTerminalResize.
+    if (_IgnoreInPassthrough() || _inTerminalResize)
+    {
+        return S_OK;
+    }
+
     const til::rectangle rect{ Viewport::FromExclusive(*psrRegion).ToInclusive() };
     _trace.TraceInvalidate(rect);
     _invalidMap.set(rect);
@@ -64,6 +70,11 @@ CATCH_RETURN();
 // - S_OK
 [[nodiscard]] HRESULT VtEngine::InvalidateCursor(const SMALL_RECT* const psrRegion) noexcept
 {
+    if (_IgnoreInPassthrough())
+    {
+        return S_OK;
+    }
+
     // If we just inherited the cursor, we're going to get an InvalidateCursor
     //      for both where the old cursor was, and where the new cursor is
     //      (the inherited location). (See Cursor.cpp:Cursor::SetPosition)
@@ -91,40 +102,88 @@ CATCH_RETURN();
 [[nodiscard]] HRESULT VtEngine::InvalidateAll() noexcept
 try
 {
+    if (_IgnoreInPassthrough())
+    {
+        return S_OK;
+    }
+
     _trace.TraceInvalidateAll(_lastViewport.ToOrigin().ToInclusive());
     _invalidMap.set_all();
+    // Repainting everything is also how the terminal is brought back in sync
+    // with us, so everything is sent again, whatever we think it shows.
+    _ResetShadow();
     return S_OK;
 }
 CATCH_RETURN();
 
 // Method Description:
 // - Notifies us that we're about to circle the buffer, giving us a chance to
-//      force a repaint before the buffer contents are lost. The VT renderer
-//      needs to be able to render all text before it's lost, so we return true.
+//      force a repaint before the buffer contents are lost.
+// - Circling is sent to the terminal like any other scroll: the InvalidateScroll
+//      that follows it has ScrollFrame emit a newline, which moves what the
+//      terminal shows (and our shadow of it) up. Only the text of the top row
+//      is lost, so we only need to paint right away if some of it is invalid.
 // Arguments:
 // - Receives a bool indicating if we should force the repaint.
 // Return Value:
 // - S_OK
 [[nodiscard]] HRESULT VtEngine::InvalidateCircling(_Out_ bool* const pForcePaint) noexcept
+try
 {
     // If we're in the middle of a resize request, don't try to immediately start a frame.
-    if (_inResizeRequest)
+    // In passthrough mode, the terminal circles its own buffer, there's nothing to paint.
+    if (_inResizeRequest || _IgnoreInPassthrough())
     {
         *pForcePaint = false;
     }
     else
     {
-        *pForcePaint = true;
-
-        // Keep track of the fact that we circled, we'll need to do some work on
-        //      end paint to specifically handle this.
-        _circled = true;
+        const auto runs = _invalidMap.runs();
+        *pForcePaint = !runs.empty() && runs.front().top() == 0;
+
+        if (*pForcePaint)
+        {
+            // Keep track of the fact that we circled, we'll need to do some work on
+            //      end paint to specifically handle this.
+            _circled = true;
+        }
+        else if (_virtualTop > 0)
+        {
+            _virtualTop--;
+        }
+
+        // Until the scroll for it arrives, the shadow is a row off. See StartPaint.
+        _pendingCircles++;
     }
 
     _trace.TraceTriggerCircling(*pForcePaint);
 
     return S_OK;
 }
+CATCH_RETURN();
+
+// Method Description:
+// - Notifies us that the console has changed the title. In passthrough mode,
+//      the client's sequence that changed it has already been written to the
+//      terminal, so there's no need to paint it.
+// Arguments:
+// - proposedTitle - the new title
+// Return Value:
+// - S_OK
+[[nodiscard]] HRESULT VtEngine::InvalidateTitle(const std::wstring_view proposedTitle) noexcept
+{
+    if (proposedTitle != _lastFrameTitle && _IgnoreInPassthrough())
+    {
+        try
+        {
+            _lastFrameTitle = proposedTitle;
+        }
+        CATCH_LOG();
+        return S_OK;
+    }
+
+    return RenderEngineBase::InvalidateTitle(proposedTitle);
+}
 
 // Method Description:
 // - Notifies us that we're about to be torn down. This gives us a last chance
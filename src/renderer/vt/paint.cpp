@@ -20,11 +20,20 @@ using namespace Microsoft::Console::Types;
 //      HRESULT error code if painting didn't start successfully.
 [[nodiscard]] HRESULT VtEngine::StartPaint() noexcept
 {
-    if (_pipeBroken)
+    // In passthrough mode, the terminal already shows everything.
+    if (_pipeBroken || _passthrough)
     {
         return S_FALSE;
     }
 
+    // A circling whose scroll never arrived moved the contents without us
+    // moving the shadow along. Unless it's the one we're forced to paint for.
+    if (_pendingCircles > 0 && !_circled)
+    {
+        _pendingCircles = 0;
+        _ResetShadow();
+    }
+
     // If there's nothing to do, quick return
     bool somethingToDo = _invalidMap.any() ||
                          _scrollDelta != til::point{ 0, 0 } ||
@@ -60,18 +69,24 @@ using namespace Microsoft::Console::Types;
     _scrollDelta = { 0, 0 };
     _clearedAllThisFrame = false;
     _cursorMoved = false;
+    // The terminal starts out like our buffer if the first frame didn't need
+    // any text to make it so, and left the cursor at the origin.
+    if (_passthroughPending)
+    {
+        _passthroughPending = false;
+        _passthrough = !_paintedText && _lastText.X == 0 && _lastText.Y == 0;
+    }
+
     _firstPaint = false;
     _skipCursor = false;
     _resized = false;
     // If we've circled the buffer this frame, move our virtual top upwards.
     // We do this at the END of the frame, so that during the paint, we still
-    //      use the original virtual top.
-    if (_circled)
+    //      use the original virtual top. The shadow is moved by the scroll
+    //      that follows the circling.
+    if (_circled && _virtualTop > 0)
     {
-        if (_virtualTop > 0)
-        {
-            _virtualTop--;
-        }
+        _virtualTop--;
     }
     _circled = false;
 
@@ -181,80 +196,6 @@ using namespace Microsoft::Console::Types;
     return S_OK;
 }
 
-// Routine Description:
-// - Write a VT sequence to change the current colors of text. Writes true RGB
-//      color sequences.
-// Arguments:
-// - textAttributes: Text attributes to use for the colors.
-// Return Value:
-// - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
-[[nodiscard]] HRESULT VtEngine::_RgbUpdateDrawingBrushes(const TextAttribute& textAttributes) noexcept
-{
-    const auto fg = textAttributes.GetForeground();
-    const auto bg = textAttributes.GetBackground();
-    auto lastFg = _lastTextAttributes.GetForeground();
-    auto lastBg = _lastTextAttributes.GetBackground();
-
-    // If both the FG and BG should be the defaults, emit a SGR reset.
-    if (fg.IsDefault() && bg.IsDefault() && !(lastFg.IsDefault() && lastBg.IsDefault()))
-    {
-        // SGR Reset will clear all attributes (except hyperlink ID) - which means
-        // we cannot reset _lastTextAttributes by simply doing
-        // _lastTextAttributes = {};
-        // because we want to retain the last hyperlink ID
-        RETURN_IF_FAILED(_SetGraphicsDefault());
-        _lastTextAttributes.SetDefaultBackground();
-        _lastTextAttributes.SetDefaultForeground();
-        _lastTextAttributes.SetDefaultMetaAttrs();
-        lastFg = {};
-        lastBg = {};
-    }
-
-    if (fg != lastFg)
-    {
-        if (fg.IsDefault())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRenditionDefaultColor(true));
-        }
-        else if (fg.IsIndex16())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRendition16Color(fg.GetIndex(), true));
-        }
-        else if (fg.IsIndex256())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRendition256Color(fg.GetIndex(), true));
-        }
-        else if (fg.IsRgb())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRenditionRGBColor(fg.GetRGB(), true));
-        }
-        _lastTextAttributes.SetForeground(fg);
-    }
-
-    if (bg != lastBg)
-    {
-        if (bg.IsDefault())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRenditionDefaultColor(false));
-        }
-        else if (bg.IsIndex16())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRendition16Color(bg.GetIndex(), false));
-        }
-        else if (bg.IsIndex256())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRendition256Color(bg.GetIndex(), false));
-        }
-        else if (bg.IsRgb())
-        {
-            RETURN_IF_FAILED(_SetGraphicsRenditionRGBColor(bg.GetRGB(), false));
-        }
-        _lastTextAttributes.SetBackground(bg);
-    }
-
-    return S_OK;
-}
-
 // Routine Description:
 // - Write a VT sequence to change the current colors of text. It will try to
 //      find ANSI colors that are nearest to the input colors, and write those
@@ -364,6 +305,81 @@ using namespace Microsoft::Console::Types;
     CATCH_RETURN();
 }
 
+// Routine Description:
+// - Writes the start of _bufferLine, which holds the text of the given clusters,
+//      to the pipe as UTF-8. If the terminal supports REP (see
+//      SetRepeatCharacter), a run of the same narrow character is written as
+//      the first character of the run followed by a REP for the rest, whenever
+//      that's shorter.
+// Arguments:
+// - clusters - the clusters whose text is in _bufferLine
+// - cch - the number of characters of _bufferLine to write
+// Return Value:
+// - S_OK or suitable HRESULT error from writing pipe.
+[[nodiscard]] HRESULT VtEngine::_WriteBufferLineUtf8(gsl::span<const Cluster> const clusters, const size_t cch) noexcept
+{
+    const std::wstring_view text{ _bufferLine.data(), cch };
+    if (!_repeatCharacter)
+    {
+        return _WriteTerminalUtf8(text);
+    }
+
+    // REP repeats the last graphic character, so it's only used for characters
+    // that are a cell of their own.
+    const auto isRepeatable = [](const Cluster& cluster) noexcept {
+        const auto ch = cluster.GetTextAsSingle();
+        return cluster.GetText().size() == 1 && cluster.GetColumns() == 1 &&
+               ch >= L' ' && ch != L'\x7f' && !IS_HIGH_SURROGATE(ch) && !IS_LOW_SURROGATE(ch);
+    };
+
+    size_t written = 0;
+    size_t offset = 0;
+    auto it = clusters.begin();
+    while (it != clusters.end() && offset < cch)
+    {
+        if (!isRepeatable(*it))
+        {
+            offset += it->GetText().size();
+            ++it;
+            continue;
+        }
+
+        const auto ch = it->GetTextAsSingle();
+        auto end = it + 1;
+        size_t count = 1;
+        while (end != clusters.end() && offset + count < cch && isRepeatable(*end) && end->GetTextAsSingle() == ch)
+        {
+            ++end;
+            ++count;
+        }
+
+        // ESC [ Pn b replaces all but the first character of the run.
+        const auto repeats = count - 1;
+        const size_t charBytes = ch < 0x80 ? 1 : (ch < 0x800 ? 2 : 3);
+        size_t sequenceLength = 3;
+        for (auto n = repeats; n > 0; n /= 10)
+        {
+            ++sequenceLength;
+        }
+        if (repeats * charBytes > sequenceLength)
+        {
+            RETURN_IF_FAILED(_WriteTerminalUtf8(text.substr(written, offset + 1 - written)));
+            RETURN_IF_FAILED(_RepeatCharacter(repeats));
+            written = offset + count;
+        }
+
+        offset += count;
+        it = end;
+    }
+
+    // Write whatever is left, which is the whole text if we didn't repeat anything.
+    if (written == 0 || written < cch)
+    {
+        RETURN_IF_FAILED(_WriteTerminalUtf8(text.substr(written)));
+    }
+    return S_OK;
+}
+
 // Routine Description:
 // - Draws one line of the buffer to the screen. Writes the characters to the
 //      pipe, encoded in UTF-8.
@@ -489,7 +505,12 @@ using namespace Microsoft::Console::Types;
     RETURN_IF_FAILED(_MoveCursor(coord));
 
     // Write the actual text string
-    RETURN_IF_FAILED(VtEngine::_WriteTerminalUtf8({ _bufferLine.data(), cchActual }));
+    RETURN_IF_FAILED(_WriteBufferLineUtf8(clusters, cchActual));
+    _paintedText = _paintedText || cchActual > 0;
+
+    // Remember what the terminal shows now. The spaces we removed are erased
+    // (or left erased) with the background color only, so we can't be sure of those.
+    _UpdateShadow(clusters, coord, columnsActual);
 
     // GH#4415, GH#5181
     // If the renderer told us that this was a wrapped line, then mark
@@ -589,6 +610,261 @@ using namespace Microsoft::Console::Types;
     return S_OK;
 }
 
+// Routine Description:
+// - Forgets the cells we've sent to the terminal, because something other than
+//      painting them changed what it shows (or made us unsure of what it shows).
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::_ResetShadow() noexcept
+{
+    _shadow.clear();
+    _shadowSize = {};
+}
+
+// Routine Description:
+// - Moves the cells we've sent to the terminal along with a scroll of its
+//      contents. The rows that are scrolled in are blank, in whatever the
+//      background color was at the time, so they're unknown.
+// Arguments:
+// - dy - the number of rows the contents moved down, or up if negative.
+// Return Value:
+// - <none>
+void VtEngine::_ScrollShadow(const short dy) noexcept
+{
+    const auto width = _shadowSize.width<size_t>();
+    const auto height = _shadowSize.height<size_t>();
+    const auto rows = gsl::narrow_cast<size_t>(std::abs(dy));
+    if (_shadow.empty() || rows == 0)
+    {
+        return;
+    }
+    if (rows >= height)
+    {
+        _ResetShadow();
+        return;
+    }
+
+    const auto shift = rows * width;
+    if (dy < 0)
+    {
+        std::move(_shadow.begin() + shift, _shadow.end(), _shadow.begin());
+        std::fill(_shadow.end() - shift, _shadow.end(), ShadowCell{});
+    }
+    else
+    {
+        std::move_backward(_shadow.begin(), _shadow.end() - shift, _shadow.end());
+        std::fill(_shadow.begin(), _shadow.begin() + shift, ShadowCell{});
+    }
+}
+
+// Routine Description:
+// - Records the cells of a run we've just sent to the terminal.
+// Arguments:
+// - clusters - the text and column widths of the run
+// - coord - where the run starts
+// - columnsSent - how many of the run's columns were written out. The
+//      remaining ones were erased instead, or not sent at all.
+// Return Value:
+// - <none>
+void VtEngine::_UpdateShadow(gsl::span<const Cluster> const clusters,
+                             const COORD coord,
+                             const size_t columnsSent) noexcept
+try
+{
+    if (_shadowSize != _invalidMap.size())
+    {
+        _shadowSize = _invalidMap.size();
+        _shadow.assign(_shadowSize.area<size_t>(), ShadowCell{});
+    }
+
+    const auto width = _shadowSize.width<ptrdiff_t>();
+    if (coord.Y < 0 || coord.Y >= _shadowSize.height<ptrdiff_t>() || coord.X < 0 || coord.X >= width)
+    {
+        return;
+    }
+
+    const auto rowStart = gsl::narrow_cast<size_t>(coord.Y * width);
+    const auto cellAt = [&](const ptrdiff_t column) -> ShadowCell& {
+        return til::at(_shadow, rowStart + gsl::narrow_cast<size_t>(column));
+    };
+    const auto lastSent = coord.X + gsl::narrow_cast<ptrdiff_t>(columnsSent);
+    ptrdiff_t x = coord.X;
+
+    // A wide glyph that's partially overwritten is gone, so if the run starts
+    // on its right half, its left half isn't what the terminal shows anymore.
+    if (x > 0 && cellAt(x).known && cellAt(x).columns == 0)
+    {
+        cellAt(x - 1).known = false;
+    }
+
+    for (const auto& cluster : clusters)
+    {
+        const auto text = cluster.GetText();
+        const auto columns = gsl::narrow_cast<ptrdiff_t>(cluster.GetColumns());
+        if (columns == 0)
+        {
+            continue;
+        }
+
+        const auto known = x + columns <= lastSent && !text.empty() && text.size() <= 2;
+        for (auto column = x; column < x + columns && column < width; ++column)
+        {
+            auto& cell = cellAt(column);
+            cell.attributes = _lastTextAttributes;
+            cell.text = {};
+            cell.columns = 0;
+            cell.known = known;
+        }
+
+        if (known && x < width)
+        {
+            auto& cell = cellAt(x);
+            std::copy(text.begin(), text.end(), cell.text.begin());
+            cell.columns = gsl::narrow_cast<uint8_t>(columns);
+        }
+
+        x += columns;
+    }
+
+    // Likewise, if the run ends on the left half of a wide glyph, its right half is gone.
+    if (x < width && cellAt(x).known && cellAt(x).columns == 0)
+    {
+        cellAt(x).known = false;
+    }
+}
+catch (...)
+{
+    LOG_CAUGHT_EXCEPTION();
+    _ResetShadow();
+}
+
+// Routine Description:
+// - Returns true if the terminal already shows the given glyph at the given
+//      cell, in the attributes we're currently painting with.
+// Arguments:
+// - cluster - the glyph to paint
+// - cell - the cell it's painted in
+// Return Value:
+// - true if the glyph doesn't need to be sent again.
+bool VtEngine::_MatchesShadow(const Cluster& cluster, const til::point cell) const noexcept
+{
+    const auto text = cluster.GetText();
+    const auto columns = gsl::narrow_cast<ptrdiff_t>(cluster.GetColumns());
+    const auto width = _shadowSize.width<ptrdiff_t>();
+
+    if (_shadow.empty() ||
+        text.empty() || text.size() > 2 || columns < 1 || columns > 2 ||
+        cell.y() < 0 || cell.y() >= _shadowSize.height<ptrdiff_t>() ||
+        cell.x() < 0 || cell.x() + columns > width)
+    {
+        return false;
+    }
+
+    const auto index = gsl::narrow_cast<size_t>(cell.y() * width + cell.x());
+    const auto& shadow = til::at(_shadow, index);
+    if (!shadow.known ||
+        shadow.columns != columns ||
+        shadow.attributes != _lastTextAttributes ||
+        shadow.text[0] != text[0] ||
+        shadow.text[1] != (text.size() > 1 ? text[1] : UNICODE_NULL))
+    {
+        return false;
+    }
+
+    return columns == 1 || til::at(_shadow, index + 1).known;
+}
+
+// Routine Description:
+// - Cuts off the start and end of a run that the terminal already shows, so
+//      that a row that's repainted with the same contents (like a TUI redrawing
+//      its whole screen) only sends the part that actually changed, if any.
+// - Skipping cells at the start costs a cursor movement, unless we need to
+//      move the cursor anyways. Skipping cells at the end may cost the next run
+//      one. So unless we're moving anyways, we only skip more characters than a
+//      CUF sequence ("\x1b[%dC", usually up to 5 characters) would take.
+// - The end of a wrapped line is always sent again, because that's what puts
+//      the terminal into the delayed EOL wrap state the next row relies on.
+// Arguments:
+// - clusters - the run to trim. Trimmed in place, and might end up empty.
+// - coord - where the run starts. Moved along with the start of the run.
+// - lineWrapped - true if the run is the end of a line that wrapped
+// Return Value:
+// - <none>
+void VtEngine::_TrimUnchangedCells(gsl::span<const Cluster>& clusters,
+                                   COORD& coord,
+                                   const bool lineWrapped) const noexcept
+{
+    if (_shadow.empty() || clusters.empty())
+    {
+        return;
+    }
+
+    const auto columnsOf = [](const Cluster& cluster) noexcept {
+        return gsl::narrow_cast<ptrdiff_t>(cluster.GetColumns());
+    };
+
+    // How far the unchanged start reaches...
+    const auto lastSkippable = clusters.size() - (lineWrapped ? 1 : 0);
+    size_t first = 0;
+    size_t firstChars = 0;
+    ptrdiff_t firstColumn = coord.X;
+    while (first < lastSkippable && _MatchesShadow(til::at(clusters, first), { firstColumn, coord.Y }))
+    {
+        firstChars += til::at(clusters, first).GetText().size();
+        firstColumn += columnsOf(til::at(clusters, first));
+        ++first;
+    }
+
+    // ...and the unchanged end, which stops where the start left off.
+    auto last = clusters.size();
+    size_t lastChars = 0;
+    if (!lineWrapped)
+    {
+        ptrdiff_t endColumn = coord.X;
+        for (const auto& cluster : clusters)
+        {
+            endColumn += columnsOf(cluster);
+        }
+
+        while (last > first)
+        {
+            const auto& cluster = til::at(clusters, last - 1);
+            const auto column = endColumn - columnsOf(cluster);
+            if (!_MatchesShadow(cluster, { column, coord.Y }))
+            {
+                break;
+            }
+            lastChars += cluster.GetText().size();
+            endColumn = column;
+            --last;
+        }
+    }
+
+    const auto mustMove = coord.X != _lastText.X || coord.Y != _lastText.Y;
+    if (first == clusters.size())
+    {
+        // Nothing changed at all. This skips the cursor movement too.
+        clusters = {};
+        return;
+    }
+    if (mustMove || firstChars > CURSOR_FORWARD_STRING_LENGTH)
+    {
+        coord.X = gsl::narrow_cast<SHORT>(firstColumn);
+    }
+    else
+    {
+        first = 0;
+    }
+    if (lastChars <= CURSOR_FORWARD_STRING_LENGTH)
+    {
+        last = clusters.size();
+    }
+
+    clusters = clusters.subspan(first, last - first);
+}
+
 // Method Description:
 // - Updates the window's title string. Emits the VT sequence to SetWindowTitle.
 //      Because wintelnet does not understand these sequences by default, we
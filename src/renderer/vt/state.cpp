@@ -42,6 +42,7 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
     _suppressResizeRepaint(true),
     _virtualTop(0),
     _circled(false),
+    _pendingCircles(0),
     _firstPaint(true),
     _skipCursor(false),
     _pipeBroken(false),
@@ -103,6 +104,31 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
     CATCH_RETURN();
 }
 
+// Routine Description:
+// - Destroys the engine. Whatever is still queued for the pipe is written
+//      before the writer thread exits.
+VtEngine::~VtEngine()
+{
+    if (_writerThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock{ _writerMutex };
+            _writerExit = true;
+        }
+        _writerQueued.notify_one();
+        _writerThread.join();
+    }
+}
+
+// Routine Description:
+// - Hands the buffer to the writer thread. Only if the terminal has fallen so far
+//      behind that the queue is full, this waits for the writer to catch up.
+//      If the writer failed to write to the pipe, that's reported here, on the
+//      next flush after it happened.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK, or the error the pipe failed with.
 [[nodiscard]] HRESULT VtEngine::_Flush() noexcept
 {
 #ifdef UNIT_TESTING
@@ -115,11 +141,42 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
 
     if (!_pipeBroken)
     {
-        bool fSuccess = !!WriteFile(_hFile.get(), _buffer.data(), gsl::narrow_cast<DWORD>(_buffer.size()), nullptr, nullptr);
+        HRESULT hr = S_OK;
+        try
+        {
+            std::unique_lock<std::mutex> lock{ _writerMutex };
+            if (!_writerThread.joinable())
+            {
+                _writerThread = std::thread{ [this]() { _WriterLoop(); } };
+            }
+
+            _writerDequeued.wait(lock, [this]() {
+                return _writerQueue.size() < WRITER_QUEUE_LIMIT || FAILED(_writerResult);
+            });
+
+            hr = _writerResult;
+            if (SUCCEEDED(hr) && !_buffer.empty())
+            {
+                // The buffers are swapped rather than copied whenever the writer has taken
+                // everything. The three of them are passed around without reallocating.
+                if (_writerQueue.empty())
+                {
+                    _writerQueue.swap(_buffer);
+                }
+                else
+                {
+                    _writerQueue.append(_buffer);
+                }
+                lock.unlock();
+                _writerQueued.notify_one();
+            }
+        }
+        CATCH_LOG();
         _buffer.clear();
-        if (!fSuccess)
+
+        if (FAILED(hr))
         {
-            _exitResult = HRESULT_FROM_WIN32(GetLastError());
+            _exitResult = hr;
             _pipeBroken = true;
             if (_terminalOwner)
             {
@@ -132,10 +189,50 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
     return S_OK;
 }
 
+// Routine Description:
+// - The writer thread. Writes whatever _Flush queued to the pipe, until the
+//      engine is destroyed or the pipe breaks.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::_WriterLoop() noexcept
+{
+    std::string writing;
+    std::unique_lock<std::mutex> lock{ _writerMutex };
+
+    for (;;)
+    {
+        _writerQueued.wait(lock, [this]() { return !_writerQueue.empty() || _writerExit; });
+        if (_writerQueue.empty())
+        {
+            break;
+        }
+
+        writing.clear();
+        writing.swap(_writerQueue);
+        lock.unlock();
+        _writerDequeued.notify_one();
+
+        const bool fSuccess = !!WriteFile(_hFile.get(), writing.data(), gsl::narrow_cast<DWORD>(writing.size()), nullptr, nullptr);
+
+        lock.lock();
+        if (!fSuccess)
+        {
+            const auto err = ::GetLastError();
+            _writerResult = err == ERROR_SUCCESS ? E_FAIL : HRESULT_FROM_WIN32(err);
+            _writerQueue.clear();
+            _writerDequeued.notify_one();
+            break;
+        }
+    }
+}
+
 // Method Description:
 // - Wrapper for ITerminalOutputConnection. See _Write.
 [[nodiscard]] HRESULT VtEngine::WriteTerminalUtf8(const std::string_view str) noexcept
 {
+    _ResetShadow();
     return _Write(str);
 }
 
@@ -229,6 +326,8 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
             hr = _ResizeWindow(newView.Width(), newView.Height());
         }
         _resized = true;
+        // The terminal might reflow its contents to the new size.
+        _ResetShadow();
     }
 
     // See MSFT:19408543
@@ -263,6 +362,12 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
         }
     }
 
+    // The terminal might not reflow its contents the way we do.
+    if (_resized && _passthrough)
+    {
+        _EndPassthrough();
+    }
+
     return hr;
 }
 
@@ -358,6 +463,8 @@ bool VtEngine::_AllIsInvalid() const
     _skipCursor = true;
     // Prevent us from clearing the entire viewport on the first paint
     _firstPaint = false;
+    // The terminal shows more than our buffer does, passthrough mode can't start.
+    _passthroughPending = false;
     return S_OK;
 }
 
@@ -409,6 +516,33 @@ void VtEngine::EndResizeRequest()
     _inResizeRequest = false;
 }
 
+// Method Description:
+// - Tell the vt renderer that the terminal resized itself, and that the buffer
+//   is about to be resized (and reflowed) to match it. A terminal that asked
+//   for the resize quirk has already reflowed its own contents, so the regions
+//   our reflow invalidates are already correct there and aren't sent again.
+//   Only the rows our invalidation map gains (and whatever changes afterwards)
+//   are painted. Call EndTerminalResize once the buffer was resized.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::BeginTerminalResize() noexcept
+{
+    _inTerminalResize = _resizeQuirk;
+}
+
+// Method Description:
+// - Tell the vt renderer that the resize that BeginTerminalResize announced is done.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::EndTerminalResize() noexcept
+{
+    _inTerminalResize = false;
+}
+
 // Method Description:
 // - Configure the renderer for the resize quirk. This changes the behavior of
 //   conpty to _not_ InvalidateAll the entire viewport on a resize operation.
@@ -425,6 +559,141 @@ void VtEngine::SetResizeQuirk(const bool resizeQuirk)
     _resizeQuirk = resizeQuirk;
 }
 
+// Method Description:
+// - Tells the engine that the terminal supports REP (CSI Pn b), which repeats
+//   the last character written. Runs of the same character in a line are then
+//   written once, followed by a REP. We can't ask the terminal whether it
+//   supports it, so this is only set with the `--repeatCharacter` flag.
+// Arguments:
+// - repeatCharacter: true if the terminal supports REP.
+// Return Value:
+// - <none>
+void VtEngine::SetRepeatCharacter(const bool repeatCharacter) noexcept
+{
+    _repeatCharacter = repeatCharacter;
+}
+
+// Method Description:
+// - Enables passthrough mode. Instead of painting what the client changed in the
+//   buffer, the output of the client is written to the terminal as it's processed
+//   (see BeginPassthroughWrite). The buffer is still kept up to date, so that
+//   the client can read it back. This starts once the first frame has set up
+//   the terminal, and only if that left it just like a fresh client expects.
+// - It ends for good when the buffer changes in any other way, like through
+//   the console APIs that write to the buffer directly. The terminal's state
+//   is reset then, and the whole viewport is painted again.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::EnablePassthrough() noexcept
+{
+    _passthroughPending = true;
+}
+
+// Method Description:
+// - Starts passthrough mode right away, for a terminal that no frame is ever
+//   painted for (see VtIo::IsRenderless). Nothing sets up the terminal first,
+//   so it has to start out like a fresh client expects it to. Since we aren't
+//   given to the renderer, nothing can end passthrough mode either.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::StartPassthrough() noexcept
+{
+    _passthroughPending = false;
+    _passthrough = true;
+    _firstPaint = false;
+}
+
+// Method Description:
+// - Returns true if we're in passthrough mode, and the state machine should
+//   write the output of the client to us as it processes it.
+// Arguments:
+// - <none>
+// Return Value:
+// - true iff we're in passthrough mode.
+[[nodiscard]] bool VtEngine::IsPassthroughActive() const noexcept
+{
+    return _passthrough && _forwarding;
+}
+
+// Method Description:
+// - Notifies us that the output of the client is about to be processed. Whatever
+//   it changes in the buffer is written to the terminal by the state machine in
+//   passthrough mode, so the invalidations until EndPassthroughWrite are ignored.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::BeginPassthroughWrite() noexcept
+{
+    _forwarding = true;
+}
+
+// Method Description:
+// - Notifies us that the output of the client has been processed. What the
+//   state machine wrote to the terminal is sent in one go.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or suitable HRESULT error from writing pipe.
+[[nodiscard]] HRESULT VtEngine::EndPassthroughWrite() noexcept
+{
+    _forwarding = false;
+    return _passthrough ? _Flush() : S_OK;
+}
+
+// Method Description:
+// - Checks a change of the buffer against passthrough mode. If it comes from the
+//   output of the client, the terminal already got it and we can ignore it.
+//   Any other change ends passthrough mode.
+// Arguments:
+// - <none>
+// Return Value:
+// - true iff the change should be ignored.
+[[nodiscard]] bool VtEngine::_IgnoreInPassthrough() noexcept
+{
+    if (!_passthrough)
+    {
+        return false;
+    }
+    if (_forwarding)
+    {
+        return true;
+    }
+    _EndPassthrough();
+    return false;
+}
+
+// Method Description:
+// - Ends passthrough mode. The client might have left the terminal in any state,
+//   so it's reset to what our painting relies on, and everything we thought we
+//   knew about it is forgotten, before the whole viewport is painted again.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::_EndPassthrough() noexcept
+{
+    _passthrough = false;
+
+    // Reset the margins (which homes the cursor), origin mode, autowrap, the
+    // character sets, the rendition and any hyperlink.
+    LOG_IF_FAILED(_Write("\x1b[r\x1b[?6l\x1b[?7h\x1b(B\x0f\x1b[m"));
+    LOG_IF_FAILED(_EndHyperlink());
+    _lastTextAttributes = TextAttribute{ INVALID_COLOR, INVALID_COLOR };
+
+    _lastText = INVALID_COORDS;
+    _wrappedRow = std::nullopt;
+    _delayedEolWrap = false;
+    _newBottomLine = false;
+    _deferredCursorPos = INVALID_COORDS;
+    _cursorMoved = true;
+    LOG_IF_FAILED(InvalidateAll());
+}
+
 // Method Description:
 // - Manually emit a "Erase Scrollback" sequence to the connected terminal. We
 //   need to do this in certain cases that we've identified where we believe the
@@ -22,6 +22,7 @@ Author(s):
 #include "tracing.hpp"
 #include <string>
 #include <functional>
+#include <condition_variable>
 
 // fwdecl unittest classes
 #ifdef UNIT_TESTING
@@ -38,12 +39,14 @@ namespace Microsoft::Console::Render
     public:
         // See _PaintUtf8BufferLine for explanation of this value.
         static const size_t ERASE_CHARACTER_STRING_LENGTH = 8;
+        // See _TrimUnchangedCells for explanation of this value.
+        static const size_t CURSOR_FORWARD_STRING_LENGTH = 5;
         static const COORD INVALID_COORDS;
 
         VtEngine(_In_ wil::unique_hfile hPipe,
                  const Microsoft::Console::Types::Viewport initialViewport);
 
-        virtual ~VtEngine() override = default;
+        virtual ~VtEngine() override;
 
         [[nodiscard]] HRESULT InvalidateSelection(const std::vector<SMALL_RECT>& rectangles) noexcept override;
         [[nodiscard]] virtual HRESULT InvalidateScroll(const COORD* const pcoordDelta) noexcept = 0;
@@ -52,6 +55,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT InvalidateCursor(const SMALL_RECT* const psrRegion) noexcept override;
         [[nodiscard]] HRESULT InvalidateAll() noexcept override;
         [[nodiscard]] HRESULT InvalidateCircling(_Out_ bool* const pForcePaint) noexcept override;
+        [[nodiscard]] HRESULT InvalidateTitle(const std::wstring_view proposedTitle) noexcept override;
         [[nodiscard]] HRESULT PrepareForTeardown(_Out_ bool* const pForcePaint) noexcept override;
 
         [[nodiscard]] virtual HRESULT StartPaint() noexcept override;
@@ -101,8 +105,17 @@ namespace Microsoft::Console::Render
         void SetTerminalOwner(Microsoft::Console::ITerminalOwner* const terminalOwner);
         void BeginResizeRequest();
         void EndResizeRequest();
+        void BeginTerminalResize() noexcept;
+        void EndTerminalResize() noexcept;
 
         void SetResizeQuirk(const bool resizeQuirk);
+        void SetRepeatCharacter(const bool repeatCharacter) noexcept;
+
+        void EnablePassthrough() noexcept;
+        void StartPassthrough() noexcept;
+        [[nodiscard]] bool IsPassthroughActive() const noexcept override;
+        void BeginPassthroughWrite() noexcept;
+        [[nodiscard]] HRESULT EndPassthroughWrite() noexcept;
 
         [[nodiscard]] virtual HRESULT ManuallyClearScrollback() noexcept;
 
@@ -134,6 +147,7 @@ namespace Microsoft::Console::Render
 
         SHORT _virtualTop;
         bool _circled;
+        size_t _pendingCircles;
         bool _firstPaint;
         bool _skipCursor;
         bool _newBottomLine;
@@ -145,17 +159,45 @@ namespace Microsoft::Console::Render
 
         Microsoft::Console::VirtualTerminal::RenderTracing _trace;
         bool _inResizeRequest{ false };
+        bool _inTerminalResize{ false };
 
         std::optional<short> _wrappedRow{ std::nullopt };
 
         bool _delayedEolWrap{ false };
 
         bool _resizeQuirk{ false };
+        bool _repeatCharacter{ false };
+
+        // In passthrough mode, the terminal is sent what the client writes, as it's
+        // written, and nothing is painted. It's pending until the first frame shows
+        // that the terminal starts out the same as our buffer. _forwarding is set
+        // while the client's output is processed, and thus written to the terminal.
+        bool _passthroughPending{ false };
+        bool _passthrough{ false };
+        bool _forwarding{ false };
+        bool _paintedText{ false };
         std::optional<TextColor> _newBottomLineBG{ std::nullopt };
 
+        [[nodiscard]] bool _IgnoreInPassthrough() noexcept;
+        virtual void _EndPassthrough() noexcept;
+
         [[nodiscard]] HRESULT _Write(std::string_view const str) noexcept;
         [[nodiscard]] HRESULT _Flush() noexcept;
 
+        // The pipe is written on a thread of its own, so that a terminal that's slow
+        // to read doesn't hold up the console while we hold its lock. _Flush queues
+        // the buffer and returns, unless WRITER_QUEUE_LIMIT bytes are queued already.
+        static constexpr size_t WRITER_QUEUE_LIMIT = 1024 * 1024;
+        std::thread _writerThread;
+        std::mutex _writerMutex;
+        std::condition_variable _writerQueued;
+        std::condition_variable _writerDequeued;
+        std::string _writerQueue;
+        HRESULT _writerResult{ S_OK };
+        bool _writerExit{ false };
+
+        void _WriterLoop() noexcept;
+
         template<typename S, typename... Args>
         [[nodiscard]] HRESULT _WriteFormatted(S&& format, Args&&... args)
         try
@@ -210,12 +252,13 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _SetHyperlink(const std::wstring_view& uri, const std::wstring_view& customId, const uint16_t& numberId) noexcept;
         [[nodiscard]] HRESULT _EndHyperlink() noexcept;
 
+        [[nodiscard]] HRESULT _RepeatCharacter(const size_t count) noexcept;
+
         [[nodiscard]] HRESULT _RequestCursor() noexcept;
 
         [[nodiscard]] HRESULT _RequestWin32Input() noexcept;
 
         [[nodiscard]] virtual HRESULT _MoveCursor(const COORD coord) noexcept = 0;
-        [[nodiscard]] HRESULT _RgbUpdateDrawingBrushes(const TextAttribute& textAttributes) noexcept;
         [[nodiscard]] HRESULT _16ColorUpdateDrawingBrushes(const TextAttribute& textAttributes) noexcept;
 
         bool _WillWriteSingleChar() const;
@@ -230,7 +273,33 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _PaintAsciiBufferLine(gsl::span<const Cluster> const clusters,
                                                     const COORD coord) noexcept;
 
+        // The cells as we've last sent them to the terminal, so that cells which are
+        // painted again with the same text and attributes don't need to be sent again.
+        // Cells we can't be sure about (never sent, erased, or scrolled in) are unknown
+        // and never match. The copy is only kept for the UTF-8 path.
+        struct ShadowCell
+        {
+            TextAttribute attributes;
+            std::array<wchar_t, 2> text{};
+            // The columns of the glyph that starts in this cell, 0 for the right half of a wide one.
+            uint8_t columns{ 0 };
+            bool known{ false };
+        };
+        std::vector<ShadowCell> _shadow;
+        til::size _shadowSize;
+
+        void _ResetShadow() noexcept;
+        void _ScrollShadow(const short dy) noexcept;
+        void _UpdateShadow(gsl::span<const Cluster> const clusters,
+                           const COORD coord,
+                           const size_t columnsSent) noexcept;
+        bool _MatchesShadow(const Cluster& cluster, const til::point cell) const noexcept;
+        void _TrimUnchangedCells(gsl::span<const Cluster>& clusters,
+                                 COORD& coord,
+                                 const bool lineWrapped) const noexcept;
+
         [[nodiscard]] HRESULT _WriteTerminalUtf8(const std::wstring_view str) noexcept;
+        [[nodiscard]] HRESULT _WriteBufferLineUtf8(gsl::span<const Cluster> const clusters, const size_t cch) noexcept;
         [[nodiscard]] HRESULT _WriteTerminalAscii(const std::wstring_view str) noexcept;
 
         [[nodiscard]] virtual HRESULT _DoUpdateTitle(const std::wstring_view newTitle) noexcept override;
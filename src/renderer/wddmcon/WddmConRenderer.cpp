@@ -25,6 +25,7 @@ WddmConEngine::WddmConEngine() :
     _hWddmConCtx(INVALID_HANDLE_VALUE),
     _displayHeight(0),
     _displayWidth(0),
+    _invalidateDisplay(false),
     _displayState(nullptr),
     _currentLegacyColorAttribute(DEFAULT_COLOR_ATTRIBUTE)
 {
@@ -117,6 +118,8 @@ WddmConEngine::~WddmConEngine()
                     {
                         _displayHeight = DisplaySize.bottom;
                         _displayWidth = DisplaySize.right;
+                        _invalidMap.resize(til::size{ static_cast<ptrdiff_t>(DisplaySize.right), static_cast<ptrdiff_t>(DisplaySize.bottom) }, true);
+                        _invalidateDisplay = true;
                     }
                     else
                     {
@@ -161,39 +164,60 @@ bool WddmConEngine::IsInitialized()
     return WDDMConEnableDisplayAccess((PHANDLE)_hWddmConCtx, FALSE);
 }
 
-[[nodiscard]] HRESULT WddmConEngine::Invalidate(const SMALL_RECT* const /*psrRegion*/) noexcept
+[[nodiscard]] HRESULT WddmConEngine::Invalidate(const SMALL_RECT* const psrRegion) noexcept
+try
 {
+    RETURN_HR_IF_NULL(E_INVALIDARG, psrRegion);
+    _InvalidateRows(Microsoft::Console::Types::Viewport::FromExclusive(*psrRegion).ToInclusive());
     return S_OK;
 }
+CATCH_RETURN();
 
-[[nodiscard]] HRESULT WddmConEngine::InvalidateCursor(const SMALL_RECT* const /*psrRegion*/) noexcept
+[[nodiscard]] HRESULT WddmConEngine::InvalidateCursor(const SMALL_RECT* const psrRegion) noexcept
 {
-    return S_OK;
+    return Invalidate(psrRegion);
 }
 
 [[nodiscard]] HRESULT WddmConEngine::InvalidateSystem(const RECT* const /*prcDirtyClient*/) noexcept
 {
-    return S_OK;
+    return InvalidateAll();
 }
 
-[[nodiscard]] HRESULT WddmConEngine::InvalidateSelection(const std::vector<SMALL_RECT>& /*rectangles*/) noexcept
+[[nodiscard]] HRESULT WddmConEngine::InvalidateSelection(const std::vector<SMALL_RECT>& rectangles) noexcept
 {
+    for (const auto& rect : rectangles)
+    {
+        RETURN_IF_FAILED(Invalidate(&rect));
+    }
     return S_OK;
 }
 
-[[nodiscard]] HRESULT WddmConEngine::InvalidateScroll(const COORD* const /*pcoordDelta*/) noexcept
+// Routine Description:
+// - The rows can't be moved around on the display, so all of them are painted again instead.
+[[nodiscard]] HRESULT WddmConEngine::InvalidateScroll(const COORD* const pcoordDelta) noexcept
 {
+    if (pcoordDelta->X != 0 || pcoordDelta->Y != 0)
+    {
+        _invalidMap.set_all();
+    }
     return S_OK;
 }
 
+// Routine Description:
+// - Paints all of the rows again, and has the display redraw them, even the
+//   cells that seem unchanged. It's how the screen is restored after another
+//   instance of conhost controlled it.
 [[nodiscard]] HRESULT WddmConEngine::InvalidateAll() noexcept
 {
+    _invalidMap.set_all();
+    _invalidateDisplay = true;
     return S_OK;
 }
 
 [[nodiscard]] HRESULT WddmConEngine::InvalidateCircling(_Out_ bool* const pForcePaint) noexcept
 {
     *pForcePaint = false;
+    _invalidMap.set_all();
     return S_FALSE;
 }
 
@@ -203,17 +227,62 @@ bool WddmConEngine::IsInitialized()
     return S_FALSE;
 }
 
+// Routine Description:
+// - Starts the batch of the frame, unless nothing was invalidated since the last one.
+// Return Value:
+// - S_FALSE if there's nothing to paint, S_OK or the failure to start the batch otherwise.
 [[nodiscard]] HRESULT WddmConEngine::StartPaint() noexcept
 {
     RETURN_IF_HANDLE_INVALID(_hWddmConCtx);
+    if (_invalidMap.none())
+    {
+        return S_FALSE;
+    }
     return WDDMConBeginUpdateDisplayBatch(_hWddmConCtx);
 }
 
+// Routine Description:
+// - Sends each of the invalidated rows once, in the batch of the frame, and
+//   then keeps what they show around to tell the display what changed next time.
+// Return Value:
+// - S_OK or the failure to update the display.
 [[nodiscard]] HRESULT WddmConEngine::EndPaint() noexcept
+try
 {
     RETURN_IF_HANDLE_INVALID(_hWddmConCtx);
-    return WDDMConEndUpdateDisplayBatch(_hWddmConCtx);
+
+    auto hr = S_OK;
+    for (const auto& rect : _invalidMap.runs())
+    {
+        for (auto row = rect.top(); row < rect.bottom() && SUCCEEDED(hr); row++)
+        {
+            const auto rowState = _displayState[row];
+            hr = WDDMConUpdateDisplay(_hWddmConCtx, rowState, _invalidateDisplay);
+            memcpy_s(rowState->Old, _displayWidth * sizeof(CD_IO_CHARACTER), rowState->New, _displayWidth * sizeof(CD_IO_CHARACTER));
+        }
+    }
+
+    const auto hrEnd = WDDMConEndUpdateDisplayBatch(_hWddmConCtx);
+    if (SUCCEEDED(hr))
+    {
+        hr = hrEnd;
+    }
+
+    // Whatever wasn't shown is painted and sent again with the next frame.
+    if (SUCCEEDED(hr))
+    {
+        _invalidMap.reset_all();
+        _invalidateDisplay = false;
+    }
+    else
+    {
+        _invalidMap.set_all();
+        _invalidateDisplay = true;
+    }
+
+    return hr;
 }
+CATCH_RETURN();
 
 // Routine Description:
 // - Used to perform longer running presentation steps outside the lock so the other threads can continue.
@@ -237,21 +306,17 @@ bool WddmConEngine::IsInitialized()
 {
     RETURN_IF_HANDLE_INVALID(_hWddmConCtx);
 
-    PCD_IO_CHARACTER OldChar;
-    PCD_IO_CHARACTER NewChar;
-
-    for (LONG rowIndex = 0; rowIndex < _displayHeight; rowIndex++)
+    // Only the invalidated rows are painted, the others keep what they show.
+    for (const auto& rect : _invalidMap.runs())
     {
-        for (LONG colIndex = 0; colIndex < _displayWidth; colIndex++)
+        for (auto rowIndex = rect.top(); rowIndex < rect.bottom(); rowIndex++)
         {
-            OldChar = &_displayState[rowIndex]->Old[colIndex];
-            NewChar = &_displayState[rowIndex]->New[colIndex];
-
-            OldChar->Character = NewChar->Character;
-            OldChar->Attribute = NewChar->Attribute;
-
-            NewChar->Character = L' ';
-            NewChar->Attribute = 0x0;
+            for (LONG colIndex = 0; colIndex < _displayWidth; colIndex++)
+            {
+                const auto NewChar = &_displayState[rowIndex]->New[colIndex];
+                NewChar->Character = L' ';
+                NewChar->Attribute = 0x0;
+            }
         }
     }
 
@@ -267,22 +332,21 @@ bool WddmConEngine::IsInitialized()
     {
         RETURN_IF_HANDLE_INVALID(_hWddmConCtx);
 
-        PCD_IO_CHARACTER OldChar;
-        PCD_IO_CHARACTER NewChar;
-
-        for (size_t i = 0; i < clusters.size() && i < (size_t)_displayWidth; i++)
+        // Rows outside of the display can't be painted and aren't invalidated.
+        if (coord.Y < 0 || coord.Y >= _displayHeight || coord.X < 0)
         {
-            OldChar = &_displayState[coord.Y]->Old[coord.X + i];
-            NewChar = &_displayState[coord.Y]->New[coord.X + i];
-
-            OldChar->Character = NewChar->Character;
-            OldChar->Attribute = NewChar->Attribute;
+            return S_OK;
+        }
 
+        // The row is sent to the display once the frame ends, see EndPaint.
+        for (size_t i = 0; i < clusters.size() && coord.X + i < (size_t)_displayWidth; i++)
+        {
+            const auto NewChar = &_displayState[coord.Y]->New[coord.X + i];
             NewChar->Character = til::at(clusters, i).GetTextAsSingle();
             NewChar->Attribute = _currentLegacyColorAttribute;
         }
 
-        return WDDMConUpdateDisplay(_hWddmConCtx, _displayState[coord.Y], FALSE);
+        return S_OK;
     }
     CATCH_RETURN();
 }
@@ -353,21 +417,19 @@ bool WddmConEngine::IsInitialized()
     return S_OK;
 }
 
+// Routine Description:
+// - Gets the rows that were invalidated since the last frame.
+// Arguments:
+// - area - receives the rectangles of rows, spanning the whole display
+// Return Value:
+// - S_OK or the failure to build them.
 [[nodiscard]] HRESULT WddmConEngine::GetDirtyArea(gsl::span<const til::rectangle>& area) noexcept
+try
 {
-    SMALL_RECT r;
-    r.Bottom = _displayHeight > 0 ? (SHORT)(_displayHeight - 1) : 0;
-    r.Top = 0;
-    r.Left = 0;
-    r.Right = _displayWidth > 0 ? (SHORT)(_displayWidth - 1) : 0;
-
-    _dirtyArea = r;
-
-    area = { &_dirtyArea,
-             1 };
-
+    area = _invalidMap.runs();
     return S_OK;
 }
+CATCH_RETURN();
 
 RECT WddmConEngine::GetDisplaySize()
 {
@@ -418,3 +480,17 @@ RECT WddmConEngine::GetDisplaySize()
 {
     return S_OK;
 }
+
+// Routine Description:
+// - Marks the rows a region covers as invalid, across the whole display,
+//   since the display is updated by the row.
+// Arguments:
+// - rect - the invalidated cells, which may extend beyond the display
+void WddmConEngine::_InvalidateRows(const til::rectangle rect)
+{
+    const auto rows = til::rectangle{ ptrdiff_t{ 0 }, rect.top(), _invalidMap.size().width(), rect.bottom() } & til::rectangle{ _invalidMap.size() };
+    if (!rows.empty())
+    {
+        _invalidMap.set(rows);
+    }
+}
@@ -71,11 +71,17 @@ namespace Microsoft::Console::Render
 
         // Helpers
         void FreeResources(ULONG displayHeight);
+        void _InvalidateRows(const til::rectangle rect);
 
         // Variables
         LONG _displayHeight;
         LONG _displayWidth;
-        til::rectangle _dirtyArea;
+
+        // The rows that have to be painted, always spanning the whole display. They're
+        // sent to WddmCon once each, when the frame ends, instead of once per paint call.
+        til::bitmap _invalidMap;
+        // Set when the display has to redraw the rows it's sent even where they seem unchanged.
+        bool _invalidateDisplay;
 
         PCD_IO_ROW_INFORMATION* _displayState;
 
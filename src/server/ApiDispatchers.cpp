@@ -152,14 +152,14 @@
 
     std::unique_ptr<IWaitRoutine> waiter;
     HRESULT hr;
-    std::deque<std::unique_ptr<IInputEvent>> outEvents;
+    std::vector<INPUT_RECORD> outRecords;
     size_t const eventsToRead = cRecords;
     if (a->Unicode)
     {
         if (fIsPeek)
         {
             hr = m->_pApiRoutines->PeekConsoleInputWImpl(*pInputBuffer,
-                                                         outEvents,
+                                                         outRecords,
                                                          eventsToRead,
                                                          *pInputReadHandleData,
                                                          waiter);
@@ -167,7 +167,7 @@
         else
         {
             hr = m->_pApiRoutines->ReadConsoleInputWImpl(*pInputBuffer,
-                                                         outEvents,
+                                                         outRecords,
                                                          eventsToRead,
                                                          *pInputReadHandleData,
                                                          waiter);
@@ -178,7 +178,7 @@
         if (fIsPeek)
         {
             hr = m->_pApiRoutines->PeekConsoleInputAImpl(*pInputBuffer,
-                                                         outEvents,
+                                                         outRecords,
                                                          eventsToRead,
                                                          *pInputReadHandleData,
                                                          waiter);
@@ -186,7 +186,7 @@
         else
         {
             hr = m->_pApiRoutines->ReadConsoleInputAImpl(*pInputBuffer,
-                                                         outEvents,
+                                                         outRecords,
                                                          eventsToRead,
                                                          *pInputReadHandleData,
                                                          waiter);
@@ -195,10 +195,10 @@
 
     // We must return the number of records in the message payload (to alert the client)
     // as well as in the message headers (below in SetReplyInformation) to alert the driver.
-    LOG_IF_FAILED(SizeTToULong(outEvents.size(), &a->NumRecords));
+    LOG_IF_FAILED(SizeTToULong(outRecords.size(), &a->NumRecords));
 
     size_t cbWritten;
-    LOG_IF_FAILED(SizeTMult(outEvents.size(), sizeof(INPUT_RECORD), &cbWritten));
+    LOG_IF_FAILED(SizeTMult(outRecords.size(), sizeof(INPUT_RECORD), &cbWritten));
 
     if (nullptr != waiter.get())
     {
@@ -228,19 +228,8 @@
     }
     else
     {
-        try
-        {
-            for (size_t i = 0; i < cRecords; ++i)
-            {
-                if (outEvents.empty())
-                {
-                    break;
-                }
-                rgRecords[i] = outEvents.front()->ToInputRecord();
-                outEvents.pop_front();
-            }
-        }
-        CATCH_RETURN();
+        // The records are already laid out the way the client expects them.
+        std::copy_n(outRecords.begin(), std::min(outRecords.size(), cRecords), rgRecords);
     }
 
     if (SUCCEEDED(hr))
@@ -10,6 +10,47 @@
 
 constexpr size_t structPacketDataSize = sizeof(_CONSOLE_API_MSG) - offsetof(_CONSOLE_API_MSG, Descriptor);
 
+// Buffers grow in powers of two from here on, so that payloads of varying sizes
+// don't reallocate every time one is a little larger than the one before it.
+constexpr size_t minimumHeapBufferSize = 1024;
+// Buffers up to this size are kept for the next message after they're released.
+// Larger ones go back to the heap, so that a single huge payload doesn't keep
+// its memory around for as long as the message lives.
+constexpr size_t maximumRetainedBufferSize = 1024 * 1024;
+
+// Routine Description:
+// - Resizes a payload buffer without initializing its contents, since they're
+//   about to be overwritten anyways.
+// Arguments:
+// - buffer - The buffer to resize.
+// - size - The size in bytes the buffer needs to have.
+static void _ResizeMessageBuffer(boost::container::small_vector<BYTE, 128>& buffer, const size_t size)
+{
+    if (size > buffer.capacity())
+    {
+        auto capacity = minimumHeapBufferSize;
+        while (capacity < size)
+        {
+            capacity *= 2;
+        }
+        buffer.reserve(capacity);
+    }
+    buffer.resize(size, boost::container::default_init);
+}
+
+// Routine Description:
+// - Empties a payload buffer, keeping its memory for the next message unless it's very large.
+// Arguments:
+// - buffer - The buffer to empty.
+static void _ReleaseMessageBuffer(boost::container::small_vector<BYTE, 128>& buffer)
+{
+    buffer.clear();
+    if (buffer.capacity() > maximumRetainedBufferSize)
+    {
+        buffer.shrink_to_fit();
+    }
+}
+
 _CONSOLE_API_MSG::_CONSOLE_API_MSG()
 {
     // A union cannot have more than one initializer,
@@ -106,7 +147,8 @@ try
 
         ULONG const cbReadSize = Descriptor.InputSize - State.ReadOffset;
 
-        _inputBuffer.resize(cbReadSize);
+        // The payload is read straight into the buffer, so there's no need to zero it first.
+        _ResizeMessageBuffer(_inputBuffer, cbReadSize);
 
         RETURN_IF_FAILED(ReadMessageInput(0, _inputBuffer.data(), cbReadSize));
 
@@ -145,7 +187,7 @@ try
         ULONG cbWriteSize = Descriptor.OutputSize - State.WriteOffset;
         RETURN_IF_FAILED(ULongMult(cbWriteSize, cbFactor, &cbWriteSize));
 
-        _outputBuffer.resize(cbWriteSize);
+        _ResizeMessageBuffer(_outputBuffer, cbWriteSize);
 
         // 0 it out.
         std::fill(_outputBuffer.begin(), _outputBuffer.end(), (BYTE)0);
@@ -192,7 +234,7 @@ CATCH_RETURN();
 
     if (State.InputBuffer != nullptr)
     {
-        _inputBuffer.clear();
+        _ReleaseMessageBuffer(_inputBuffer);
         State.InputBuffer = nullptr;
         State.InputBufferSize = 0;
     }
@@ -210,7 +252,7 @@ CATCH_RETURN();
             LOG_IF_FAILED(_pDeviceComm->WriteOutput(&IoOperation));
         }
 
-        _outputBuffer.clear();
+        _ReleaseMessageBuffer(_outputBuffer);
         State.OutputBuffer = nullptr;
         State.OutputBufferSize = 0;
     }
@@ -233,10 +233,11 @@ INPUT_READ_HANDLE_DATA* ConsoleHandleData::GetClientInput() const
     // see if there are any reads waiting for data via this handle.  if
     // there are, wake them up.  there aren't any other outstanding i/o
     // operations via this handle because the console lock is held.
+    // reads waiting via other handles to the same input buffer keep waiting.
 
     if (pReadHandleData->GetReadCount() != 0)
     {
-        pInputBuffer->WaitQueue.NotifyWaiters(true, WaitTerminationReason::HandleClosing);
+        pInputBuffer->WaitQueue.NotifyHandleWaiters(this, WaitTerminationReason::HandleClosing);
     }
 
     FAIL_FAST_IF(pReadHandleData->GetReadCount() > 0);
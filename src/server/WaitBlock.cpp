@@ -120,6 +120,17 @@ ConsoleWaitBlock::~ConsoleWaitBlock()
     return S_OK;
 }
 
+// Routine Description:
+// - Gets the handle of the console object that the waiting request was made on.
+// Arguments:
+// - <none>
+// Return Value:
+// - The handle data of the object.
+ConsoleHandleData* ConsoleWaitBlock::GetObjectHandle() const
+{
+    return _WaitReplyMessage.GetObjectHandle();
+}
+
 // Routine Description:
 // - Used to trigger the callback routine inside this wait block.
 // Arguments:
@@ -135,7 +146,7 @@ bool ConsoleWaitBlock::Notify(const WaitTerminationReason TerminationReason)
     DWORD dwControlKeyState;
     bool fIsUnicode = true;
 
-    std::deque<std::unique_ptr<IInputEvent>> outEvents;
+    std::vector<INPUT_RECORD> outRecords;
     // TODO: MSFT 14104228 - get rid of this void* and get the data
     // out of the read wait object properly.
     void* pOutputData = nullptr;
@@ -148,7 +159,7 @@ bool ConsoleWaitBlock::Notify(const WaitTerminationReason TerminationReason)
     {
         CONSOLE_GETCONSOLEINPUT_MSG* a = &(_WaitReplyMessage.u.consoleMsgL1.GetConsoleInput);
         fIsUnicode = !!a->Unicode;
-        pOutputData = &outEvents;
+        pOutputData = &outRecords;
         break;
     }
     case API_NUMBER_READCONSOLE:
@@ -192,16 +203,8 @@ bool ConsoleWaitBlock::Notify(const WaitTerminationReason TerminationReason)
             }
 
             INPUT_RECORD* const pRecordBuffer = static_cast<INPUT_RECORD* const>(buffer);
-            a->NumRecords = static_cast<ULONG>(outEvents.size());
-            for (size_t i = 0; i < a->NumRecords; ++i)
-            {
-                if (outEvents.empty())
-                {
-                    break;
-                }
-                pRecordBuffer[i] = outEvents.front()->ToInputRecord();
-                outEvents.pop_front();
-            }
+            a->NumRecords = static_cast<ULONG>(outRecords.size());
+            std::copy(outRecords.begin(), outRecords.end(), pRecordBuffer);
         }
         else if (API_NUMBER_READCONSOLE == _WaitReplyMessage.msgHeader.ApiNumber)
         {
@@ -32,6 +32,8 @@ public:
 
     bool Notify(const WaitTerminationReason TerminationReason);
 
+    ConsoleHandleData* GetObjectHandle() const;
+
     [[nodiscard]] static HRESULT s_CreateWait(_Inout_ CONSOLE_API_MSG* const pWaitReplymessage,
                                               _In_ IWaitRoutine* const pWaiter);
 
@@ -103,6 +103,36 @@ bool ConsoleWaitQueue::NotifyWaiters(const bool fNotifyAll,
     return fResult;
 }
 
+// Routine Description:
+// - Instructs this queue to callback only the waiting requests that were made on the given handle.
+// - Requests made on other handles to the same object are left waiting, rather than being retried.
+// Arguments:
+// - pHandleData - The handle whose requests should be called back.
+// - TerminationReason - A reason/message to pass to each waiter signaling it should terminate appropriately.
+// Return Value:
+// - True if any block was successfully notified. False if no blocks were successful.
+bool ConsoleWaitQueue::NotifyHandleWaiters(const ConsoleHandleData* const pHandleData,
+                                           const WaitTerminationReason TerminationReason)
+{
+    bool fResult = false;
+
+    auto it = _blocks.cbegin();
+    while (it != _blocks.cend())
+    {
+        ConsoleWaitBlock* const WaitBlock = (*it);
+        auto const nextIt = std::next(it); // we have to capture next before it is potentially erased
+
+        if (WaitBlock->GetObjectHandle() == pHandleData && _NotifyBlock(WaitBlock, TerminationReason))
+        {
+            fResult = true;
+        }
+
+        it = nextIt;
+    }
+
+    return fResult;
+}
+
 // Routine Description:
 // - A helper to delete successfully notified callbacks
 // Arguments:
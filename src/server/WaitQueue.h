@@ -37,6 +37,9 @@ public:
     bool NotifyWaiters(const bool fNotifyAll,
                        const WaitTerminationReason TerminationReason);
 
+    bool NotifyHandleWaiters(const ConsoleHandleData* const pHandleData,
+                             const WaitTerminationReason TerminationReason);
+
     [[nodiscard]] static HRESULT s_CreateWait(_Inout_ CONSOLE_API_MSG* const pWaitReplyMessage,
                                               _In_ IWaitRoutine* const pWaiter);
 
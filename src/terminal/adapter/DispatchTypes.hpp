@@ -382,6 +382,7 @@ namespace Microsoft::Console::VirtualTerminal::DispatchTypes
         ALTERNATE_SCROLL = DECPrivateMode(1007),
         ASB_AlternateScreenBuffer = DECPrivateMode(1049),
         XTERM_BracketedPasteMode = DECPrivateMode(2004),
+        SO_SynchronizedOutput = DECPrivateMode(2026),
         W32IM_Win32InputMode = DECPrivateMode(9001),
     };
 
@@ -427,6 +428,13 @@ namespace Microsoft::Console::VirtualTerminal::DispatchTypes
         Solicited = 1
     };
 
+    enum class SixelBackground : size_t
+    {
+        Default = 0, // the same as BackgroundColor
+        Transparent = 1,
+        BackgroundColor = 2 // filled with the color of register 0
+    };
+
     enum class LineFeedType : unsigned int
     {
         WithReturn,
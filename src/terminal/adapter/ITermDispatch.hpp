@@ -23,6 +23,8 @@ namespace Microsoft::Console::VirtualTerminal
 class Microsoft::Console::VirtualTerminal::ITermDispatch
 {
 public:
+    using StringHandler = std::function<bool(const wchar_t)>;
+
 #pragma warning(push)
 #pragma warning(disable : 26432) // suppress rule of 5 violation on interface because tampering with this is fraught with peril
     virtual ~ITermDispatch() = 0;
@@ -30,6 +32,7 @@ public:
     virtual void Execute(const wchar_t wchControl) = 0;
     virtual void Print(const wchar_t wchPrintable) = 0;
     virtual void PrintString(const std::wstring_view string) = 0;
+    virtual void FlushPendingPrint() = 0;
 
     virtual bool CursorUp(const size_t distance) = 0; // CUU
     virtual bool CursorDown(const size_t distance) = 0; // CUD
@@ -80,6 +83,7 @@ public:
     virtual bool EnableAnyEventMouseMode(const bool enabled) = 0; // ?1003
     virtual bool EnableAlternateScroll(const bool enabled) = 0; // ?1007
     virtual bool EnableXtermBracketedPasteMode(const bool enabled) = 0; // ?2004
+    virtual bool EnableSynchronizedOutput(const bool enabled) = 0; // ?2026
     virtual bool SetColorTableEntry(const size_t tableIndex, const DWORD color) = 0; // OSCColorTable
     virtual bool SetDefaultForeground(const DWORD color) = 0; // OSCDefaultForeground
     virtual bool SetDefaultBackground(const DWORD color) = 0; // OSCDefaultBackground
@@ -130,6 +134,11 @@ public:
     virtual bool EndHyperlink() = 0;
 
     virtual bool DoConEmuAction(const std::wstring_view string) = 0;
+    virtual bool DoFinalTermAction(const std::wstring_view string) = 0;
+
+    virtual StringHandler DefineSixelImage(const size_t macroParameter,
+                                           const DispatchTypes::SixelBackground backgroundSelect,
+                                           const size_t gridSize) = 0; // DECSIXEL
 };
 inline Microsoft::Console::VirtualTerminal::ITermDispatch::~ITermDispatch() {}
 #pragma warning(pop)
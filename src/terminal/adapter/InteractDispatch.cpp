@@ -32,10 +32,62 @@ InteractDispatch::InteractDispatch(std::unique_ptr<ConGetSet> pConApi) :
 // True if handled successfully. False otherwise.
 bool InteractDispatch::WriteInput(std::deque<std::unique_ptr<IInputEvent>>& inputEvents)
 {
+    if (_batching)
+    {
+        std::move(inputEvents.begin(), inputEvents.end(), std::back_inserter(_batch));
+        inputEvents.clear();
+        return true;
+    }
+
     size_t written = 0;
     return _pConApi->PrivateWriteConsoleInputW(inputEvents, written);
 }
 
+// Method Description:
+// - Starts collecting the events passed to WriteInput, so that they're written
+//      to the input buffer all at once by EndBatch. WriteCtrlKey flushes the
+//      events collected so far first, which keeps the input in order.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void InteractDispatch::BeginBatch() noexcept
+{
+    _batching = true;
+}
+
+// Method Description:
+// - Writes the events collected since BeginBatch to the input buffer and
+//      returns to writing each event as it's received.
+// Arguments:
+// - <none>
+// Return Value:
+// True if handled successfully. False otherwise.
+bool InteractDispatch::EndBatch()
+{
+    _batching = false;
+    return _FlushBatch();
+}
+
+// Method Description:
+// - Writes the events collected so far to the input buffer.
+// Arguments:
+// - <none>
+// Return Value:
+// True if handled successfully. False otherwise.
+bool InteractDispatch::_FlushBatch()
+{
+    if (_batch.empty())
+    {
+        return true;
+    }
+
+    size_t written = 0;
+    const bool success = _pConApi->PrivateWriteConsoleInputW(_batch, written);
+    _batch.clear();
+    return success;
+}
+
 // Method Description:
 // - Writes a key event to the host in a fashion that will enable the host to
 //   process special keys such as Ctrl-C or Ctrl+Break. The host will then
@@ -47,6 +99,8 @@ bool InteractDispatch::WriteInput(std::deque<std::unique_ptr<IInputEvent>>& inpu
 // True if handled successfully. False otherwise.
 bool InteractDispatch::WriteCtrlKey(const KeyEvent& event)
 {
+    // The control key has to come after the input preceding it.
+    _FlushBatch();
     return _pConApi->PrivateWriteConsoleControlInput(event);
 }
 
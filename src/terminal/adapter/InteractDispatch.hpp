@@ -35,7 +35,15 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool IsVtInputEnabled() const override;
 
+        void BeginBatch() noexcept;
+        bool EndBatch();
+
     private:
+        bool _FlushBatch();
+
         std::unique_ptr<ConGetSet> _pConApi;
+
+        bool _batching{ false };
+        std::deque<std::unique_ptr<IInputEvent>> _batch;
     };
 }
@@ -54,7 +54,7 @@ void AdaptDispatch::Print(const wchar_t wchPrintable)
     // a character is only output if the DEL is translated to something else.
     if (wchTranslated != AsciiChars::DEL)
     {
-        _pDefaults->Print(wchTranslated);
+        _pendingPrint.push_back(wchTranslated);
     }
 }
 
@@ -71,22 +71,70 @@ void AdaptDispatch::PrintString(const std::wstring_view string)
     {
         if (_termOutput.NeedToTranslate())
         {
-            std::wstring buffer;
-            buffer.reserve(string.size());
+            _pendingPrint.reserve(_pendingPrint.size() + string.size());
             for (auto& wch : string)
             {
-                buffer.push_back(_termOutput.TranslateKey(wch));
+                _pendingPrint.push_back(_termOutput.TranslateKey(wch));
             }
-            _pDefaults->PrintString(buffer);
         }
         else
         {
-            _pDefaults->PrintString(string);
+            _pendingPrint.append(string);
         }
     }
     CATCH_LOG();
 }
 
+// Routine Description:
+// - Writes the text collected by Print and PrintString to the buffer. A run of
+//   prints, only interrupted by SGRs that don't change the attributes, thus
+//   takes a single write, with a single cursor update and invalidation.
+// - This has to be called at the end of the output that was passed to the
+//   state machine, before anything else gets to modify the buffer.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void AdaptDispatch::FlushPendingPrint()
+{
+    _WritePendingPrint();
+}
+
+// Routine Description:
+// - Returns the console API, after writing any pending printed text. Every
+//   operation besides printing goes through here, which ensures that it's
+//   carried out in the order it was received.
+// Arguments:
+// - <none>
+// Return Value:
+// - The console API.
+ConGetSet& AdaptDispatch::_ConApi() const
+{
+    _WritePendingPrint();
+    return *_pConApi;
+}
+
+// Routine Description:
+// - Writes the pending printed text to the buffer, if there is any.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void AdaptDispatch::_WritePendingPrint() const
+{
+    if (_pendingPrint.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        _pDefaults->PrintString(_pendingPrint);
+    }
+    CATCH_LOG();
+    _pendingPrint.clear();
+}
+
 // Routine Description:
 // - CUU - Handles cursor upward movement by given distance.
 // CUU and CUD are handled separately from other CUP sequences, because they are
@@ -182,7 +230,7 @@ bool AdaptDispatch::_CursorMovePosition(const Offset rowOffset, const Offset col
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    success = (_ConApi().MoveToBottom() && _ConApi().GetConsoleScreenBufferInfoEx(csbiex));
 
     if (success)
     {
@@ -246,7 +294,7 @@ bool AdaptDispatch::_CursorMovePosition(const Offset rowOffset, const Offset col
 
         // Finally, attempt to set the adjusted cursor position back into the console.
         const COORD newPos = { gsl::narrow_cast<SHORT>(col), gsl::narrow_cast<SHORT>(row) };
-        success = _pConApi->SetConsoleCursorPosition(newPos);
+        success = _ConApi().SetConsoleCursorPosition(newPos);
     }
 
     return success;
@@ -325,10 +373,10 @@ bool AdaptDispatch::CursorSaveState()
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    bool success = (_ConApi().MoveToBottom() && _ConApi().GetConsoleScreenBufferInfoEx(csbiex));
 
     TextAttribute attributes;
-    success = success && (_pConApi->PrivateGetTextAttributes(attributes));
+    success = success && (_ConApi().PrivateGetTextAttributes(attributes));
 
     if (success)
     {
@@ -344,7 +392,7 @@ bool AdaptDispatch::CursorSaveState()
         savedCursorState.IsOriginModeRelative = _isOriginModeRelative;
         savedCursorState.Attributes = attributes;
         savedCursorState.TermOutput = _termOutput;
-        _pConApi->GetConsoleOutputCP(savedCursorState.CodePage);
+        _ConApi().GetConsoleOutputCP(savedCursorState.CodePage);
     }
 
     return success;
@@ -381,7 +429,7 @@ bool AdaptDispatch::CursorRestoreState()
     _isOriginModeRelative = savedCursorState.IsOriginModeRelative;
 
     // Restore text attributes.
-    success = (_pConApi->PrivateSetTextAttributes(savedCursorState.Attributes)) && success;
+    success = (_ConApi().PrivateSetTextAttributes(savedCursorState.Attributes)) && success;
 
     // Restore designated character set.
     _termOutput = savedCursorState.TermOutput;
@@ -389,7 +437,7 @@ bool AdaptDispatch::CursorRestoreState()
     // Restore the code page if it was previously saved.
     if (savedCursorState.CodePage != 0)
     {
-        success = _pConApi->SetConsoleOutputCP(savedCursorState.CodePage);
+        success = _ConApi().SetConsoleOutputCP(savedCursorState.CodePage);
     }
 
     return success;
@@ -405,7 +453,7 @@ bool AdaptDispatch::CursorVisibility(const bool fIsVisible)
 {
     // This uses a private API instead of the public one, because the public API
     //      will set the cursor shape back to legacy.
-    return _pConApi->PrivateShowCursor(fIsVisible);
+    return _ConApi().PrivateShowCursor(fIsVisible);
 }
 
 // Routine Description:
@@ -427,14 +475,14 @@ bool AdaptDispatch::_InsertDeleteHelper(const size_t count, const bool isInsert)
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    RETURN_BOOL_IF_FALSE(_pConApi->MoveToBottom());
-    RETURN_BOOL_IF_FALSE(_pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    RETURN_BOOL_IF_FALSE(_ConApi().MoveToBottom());
+    RETURN_BOOL_IF_FALSE(_ConApi().GetConsoleScreenBufferInfoEx(csbiex));
 
     const auto cursor = csbiex.dwCursorPosition;
     // Rectangle to cut out of the existing buffer. This is inclusive.
     SMALL_RECT srScroll;
     srScroll.Left = cursor.X;
-    srScroll.Right = _pConApi->PrivateGetLineWidth(cursor.Y) - 1;
+    srScroll.Right = _ConApi().PrivateGetLineWidth(cursor.Y) - 1;
     srScroll.Top = cursor.Y;
     srScroll.Bottom = srScroll.Top;
 
@@ -458,7 +506,7 @@ bool AdaptDispatch::_InsertDeleteHelper(const size_t count, const bool isInsert)
     if (success)
     {
         // Note the revealed characters are filled with the standard erase attributes.
-        success = _pConApi->PrivateScrollRegion(srScroll, srScroll, coordDestination, true);
+        success = _ConApi().PrivateScrollRegion(srScroll, srScroll, coordDestination, true);
     }
 
     return success;
@@ -533,12 +581,12 @@ bool AdaptDispatch::_EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX& c
     case DispatchTypes::EraseType::ToEnd:
     case DispatchTypes::EraseType::All:
         // Remember the .X value is 1 farther than the right most column in the buffer. Therefore no +1.
-        nLength = _pConApi->PrivateGetLineWidth(lineId) - coordStartPosition.X;
+        nLength = _ConApi().PrivateGetLineWidth(lineId) - coordStartPosition.X;
         break;
     }
 
     // Note that the region is filled with the standard erase attributes.
-    return _pConApi->PrivateFillRegion(coordStartPosition, nLength, L' ', true);
+    return _ConApi().PrivateFillRegion(coordStartPosition, nLength, L' ', true);
 }
 
 // Routine Description:
@@ -554,7 +602,7 @@ bool AdaptDispatch::EraseCharacters(const size_t numChars)
 {
     CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    bool success = _ConApi().GetConsoleScreenBufferInfoEx(csbiex);
 
     if (success)
     {
@@ -566,7 +614,7 @@ bool AdaptDispatch::EraseCharacters(const size_t numChars)
         const auto eraseLength = (numChars <= actualRemaining) ? numChars : actualRemaining;
 
         // Note that the region is filled with the standard erase attributes.
-        success = _pConApi->PrivateFillRegion(startPosition, eraseLength, L' ', true);
+        success = _ConApi().PrivateFillRegion(startPosition, eraseLength, L' ', true);
     }
     return success;
 }
@@ -597,7 +645,7 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
         // make the state machine propagate this ED sequence to the connected
         // terminal application. While we're in conpty mode, we don't really
         // have a scrollback, but the attached terminal might.
-        const bool isPty = _pConApi->IsConsolePty();
+        const bool isPty = _ConApi().IsConsolePty();
         return eraseScrollbackResult && (!isPty);
     }
     else if (eraseType == DispatchTypes::EraseType::All)
@@ -609,7 +657,7 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
         // connected terminal to do the same thing, so that the terminal will
         // move it's own buffer contents into the scrollback.
         const bool eraseAllResult = _EraseAll();
-        const bool isPty = _pConApi->IsConsolePty();
+        const bool isPty = _ConApi().IsConsolePty();
         return eraseAllResult && (!isPty);
     }
 
@@ -617,7 +665,7 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    bool success = (_ConApi().MoveToBottom() && _ConApi().GetConsoleScreenBufferInfoEx(csbiex));
 
     if (success)
     {
@@ -630,12 +678,12 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
         if (eraseType == DispatchTypes::EraseType::FromBeginning)
         {
             const auto endRow = csbiex.dwCursorPosition.Y;
-            _pConApi->PrivateResetLineRenditionRange(csbiex.srWindow.Top, endRow);
+            _ConApi().PrivateResetLineRenditionRange(csbiex.srWindow.Top, endRow);
         }
         if (eraseType == DispatchTypes::EraseType::ToEnd)
         {
             const auto startRow = csbiex.dwCursorPosition.Y + (csbiex.dwCursorPosition.X > 0 ? 1 : 0);
-            _pConApi->PrivateResetLineRenditionRange(startRow, csbiex.srWindow.Bottom);
+            _ConApi().PrivateResetLineRenditionRange(startRow, csbiex.srWindow.Bottom);
         }
 
         // What we need to erase is grouped into 3 types:
@@ -703,7 +751,7 @@ bool AdaptDispatch::EraseInLine(const DispatchTypes::EraseType eraseType)
 
     CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    bool success = _ConApi().GetConsoleScreenBufferInfoEx(csbiex);
 
     if (success)
     {
@@ -722,7 +770,7 @@ bool AdaptDispatch::EraseInLine(const DispatchTypes::EraseType eraseType)
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::SetLineRendition(const LineRendition rendition)
 {
-    return _pConApi->PrivateSetCurrentLineRendition(rendition);
+    return _ConApi().PrivateSetCurrentLineRendition(rendition);
 }
 
 // Routine Description:
@@ -859,7 +907,7 @@ bool AdaptDispatch::_CursorPositionReport() const
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    bool success = (_ConApi().MoveToBottom() && _ConApi().GetConsoleScreenBufferInfoEx(csbiex));
 
     if (success)
     {
@@ -925,7 +973,7 @@ bool AdaptDispatch::_WriteResponse(const std::wstring_view reply) const
     // to make sure that "response" input is spooled directly into the application.
     // We switched this to an append (vs. a prepend) to fix GH#1637, a bug where two CPR
     // could collide with eachother.
-    success = _pConApi->PrivateWriteConsoleInputW(inEvents, eventsWritten);
+    success = _ConApi().PrivateWriteConsoleInputW(inEvents, eventsWritten);
 
     return success;
 }
@@ -950,7 +998,7 @@ bool AdaptDispatch::_ScrollMovement(const ScrollDirection scrollDirection, const
         csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
         // Make sure to reset the viewport (with MoveToBottom )to where it was
         //      before the user scrolled the console output
-        success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+        success = (_ConApi().MoveToBottom() && _ConApi().GetConsoleScreenBufferInfoEx(csbiex));
 
         if (success)
         {
@@ -974,7 +1022,7 @@ bool AdaptDispatch::_ScrollMovement(const ScrollDirection scrollDirection, const
             coordDestination.Y = srScreen.Top + dist * (scrollDirection == ScrollDirection::Up ? -1 : 1);
 
             // Note the revealed lines are filled with the standard erase attributes.
-            success = _pConApi->PrivateScrollRegion(srScreen, srScreen, coordDestination, true);
+            success = _ConApi().PrivateScrollRegion(srScreen, srScreen, coordDestination, true);
         }
     }
 
@@ -1019,12 +1067,12 @@ bool AdaptDispatch::SetColumns(const size_t columns)
     {
         CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
         csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-        success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+        success = _ConApi().GetConsoleScreenBufferInfoEx(csbiex);
 
         if (success)
         {
             csbiex.dwSize.X = col;
-            success = _pConApi->SetConsoleScreenBufferInfoEx(csbiex);
+            success = _ConApi().SetConsoleScreenBufferInfoEx(csbiex);
         }
     }
     return success;
@@ -1127,6 +1175,9 @@ bool AdaptDispatch::_ModeParamsHelper(const DispatchTypes::ModeParams param, con
     case DispatchTypes::ModeParams::ASB_AlternateScreenBuffer:
         success = enable ? UseAlternateScreenBuffer() : UseMainScreenBuffer();
         break;
+    case DispatchTypes::ModeParams::SO_SynchronizedOutput:
+        success = EnableSynchronizedOutput(enable);
+        break;
     case DispatchTypes::ModeParams::W32IM_Win32InputMode:
         success = EnableWin32InputMode(enable);
         break;
@@ -1168,7 +1219,7 @@ bool AdaptDispatch::ResetMode(const DispatchTypes::ModeParams param)
 bool AdaptDispatch::SetKeypadMode(const bool fApplicationMode)
 {
     bool success = true;
-    success = _pConApi->PrivateSetKeypadMode(fApplicationMode);
+    success = _ConApi().PrivateSetKeypadMode(fApplicationMode);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -1188,7 +1239,7 @@ bool AdaptDispatch::SetKeypadMode(const bool fApplicationMode)
 bool AdaptDispatch::EnableWin32InputMode(const bool win32InputMode)
 {
     bool success = true;
-    success = _pConApi->PrivateEnableWin32InputMode(win32InputMode);
+    success = _ConApi().PrivateEnableWin32InputMode(win32InputMode);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -1206,7 +1257,7 @@ bool AdaptDispatch::EnableWin32InputMode(const bool win32InputMode)
 bool AdaptDispatch::SetCursorKeysMode(const bool applicationMode)
 {
     bool success = true;
-    success = _pConApi->PrivateSetCursorKeysMode(applicationMode);
+    success = _ConApi().PrivateSetCursorKeysMode(applicationMode);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -1223,7 +1274,7 @@ bool AdaptDispatch::SetCursorKeysMode(const bool applicationMode)
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::EnableCursorBlinking(const bool enable)
 {
-    return _pConApi->PrivateAllowCursorBlinking(enable);
+    return _ConApi().PrivateAllowCursorBlinking(enable);
 }
 
 // Routine Description:
@@ -1236,7 +1287,7 @@ bool AdaptDispatch::EnableCursorBlinking(const bool enable)
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::InsertLine(const size_t distance)
 {
-    return _pConApi->InsertLines(distance);
+    return _ConApi().InsertLines(distance);
 }
 
 // Routine Description:
@@ -1253,7 +1304,7 @@ bool AdaptDispatch::InsertLine(const size_t distance)
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::DeleteLine(const size_t distance)
 {
-    return _pConApi->DeleteLines(distance);
+    return _ConApi().DeleteLines(distance);
 }
 
 // - DECANM - Sets the terminal emulation mode to either ANSI-compatible or VT52.
@@ -1267,7 +1318,7 @@ bool AdaptDispatch::SetAnsiMode(const bool ansiMode)
     // need to be reset to defaults, even if the mode doesn't actually change.
     _termOutput = {};
 
-    return _pConApi->PrivateSetAnsiMode(ansiMode);
+    return _ConApi().PrivateSetAnsiMode(ansiMode);
 }
 
 // Routine Description:
@@ -1280,12 +1331,12 @@ bool AdaptDispatch::SetAnsiMode(const bool ansiMode)
 bool AdaptDispatch::SetScreenMode(const bool reverseMode)
 {
     // If we're a conpty, always return false
-    if (_pConApi->IsConsolePty())
+    if (_ConApi().IsConsolePty())
     {
         return false;
     }
 
-    return _pConApi->PrivateSetScreenMode(reverseMode);
+    return _ConApi().PrivateSetScreenMode(reverseMode);
 }
 
 // Routine Description:
@@ -1312,7 +1363,7 @@ bool AdaptDispatch::SetOriginMode(const bool relativeMode) noexcept
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::SetAutoWrapMode(const bool wrapAtEOL)
 {
-    return _pConApi->PrivateSetAutoWrapMode(wrapAtEOL);
+    return _ConApi().PrivateSetAutoWrapMode(wrapAtEOL);
 }
 
 // Routine Description:
@@ -1332,7 +1383,7 @@ bool AdaptDispatch::_DoSetTopBottomScrollingMargins(const size_t topMargin,
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex));
+    bool success = (_ConApi().MoveToBottom() && _ConApi().GetConsoleScreenBufferInfoEx(csbiex));
 
     // so notes time: (input -> state machine out -> adapter out -> conhost internal)
     // having only a top param is legal         ([3;r   -> 3,0   -> 3,h  -> 3,h,true)
@@ -1379,7 +1430,7 @@ bool AdaptDispatch::_DoSetTopBottomScrollingMargins(const size_t topMargin,
                 }
                 _scrollMargins.Top = actualTop;
                 _scrollMargins.Bottom = actualBottom;
-                success = _pConApi->PrivateSetScrollingRegion(_scrollMargins);
+                success = _ConApi().PrivateSetScrollingRegion(_scrollMargins);
             }
         }
     }
@@ -1413,7 +1464,7 @@ bool AdaptDispatch::SetTopBottomScrollingMargins(const size_t topMargin,
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::WarningBell()
 {
-    return _pConApi->PrivateWarningBell();
+    return _ConApi().PrivateWarningBell();
 }
 
 // Routine Description:
@@ -1440,11 +1491,11 @@ bool AdaptDispatch::LineFeed(const DispatchTypes::LineFeedType lineFeedType)
     switch (lineFeedType)
     {
     case DispatchTypes::LineFeedType::DependsOnMode:
-        return _pConApi->PrivateLineFeed(_pConApi->PrivateGetLineFeedMode());
+        return _ConApi().PrivateLineFeed(_ConApi().PrivateGetLineFeedMode());
     case DispatchTypes::LineFeedType::WithoutReturn:
-        return _pConApi->PrivateLineFeed(false);
+        return _ConApi().PrivateLineFeed(false);
     case DispatchTypes::LineFeedType::WithReturn:
-        return _pConApi->PrivateLineFeed(true);
+        return _ConApi().PrivateLineFeed(true);
     default:
         return false;
     }
@@ -1459,7 +1510,7 @@ bool AdaptDispatch::LineFeed(const DispatchTypes::LineFeedType lineFeedType)
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::ReverseLineFeed()
 {
-    return _pConApi->PrivateReverseLineFeed();
+    return _ConApi().PrivateReverseLineFeed();
 }
 
 // Routine Description:
@@ -1470,7 +1521,7 @@ bool AdaptDispatch::ReverseLineFeed()
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::SetWindowTitle(std::wstring_view title)
 {
-    return _pConApi->SetConsoleTitleW(title);
+    return _ConApi().SetConsoleTitleW(title);
 }
 
 // - ASBSET - Creates and swaps to the alternate screen buffer. In virtual terminals, there exists both a "main"
@@ -1485,7 +1536,7 @@ bool AdaptDispatch::UseAlternateScreenBuffer()
     bool success = CursorSaveState();
     if (success)
     {
-        success = _pConApi->PrivateUseAlternateScreenBuffer();
+        success = _ConApi().PrivateUseAlternateScreenBuffer();
         if (success)
         {
             _usingAltBuffer = true;
@@ -1503,7 +1554,7 @@ bool AdaptDispatch::UseAlternateScreenBuffer()
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::UseMainScreenBuffer()
 {
-    bool success = _pConApi->PrivateUseMainScreenBuffer();
+    bool success = _ConApi().PrivateUseMainScreenBuffer();
     if (success)
     {
         _usingAltBuffer = false;
@@ -1525,7 +1576,7 @@ bool AdaptDispatch::HorizontalTabSet()
 {
     CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    const bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    const bool success = _ConApi().GetConsoleScreenBufferInfoEx(csbiex);
     if (success)
     {
         const auto width = csbiex.dwSize.X;
@@ -1550,7 +1601,7 @@ bool AdaptDispatch::ForwardTab(const size_t numTabs)
 {
     CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    bool success = _ConApi().GetConsoleScreenBufferInfoEx(csbiex);
     if (success)
     {
         const auto width = csbiex.dwSize.X;
@@ -1568,7 +1619,7 @@ bool AdaptDispatch::ForwardTab(const size_t numTabs)
             }
         }
 
-        success = _pConApi->SetConsoleCursorPosition({ column, row });
+        success = _ConApi().SetConsoleCursorPosition({ column, row });
     }
     return success;
 }
@@ -1584,7 +1635,7 @@ bool AdaptDispatch::BackwardsTab(const size_t numTabs)
 {
     CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    bool success = _ConApi().GetConsoleScreenBufferInfoEx(csbiex);
     if (success)
     {
         const auto width = csbiex.dwSize.X;
@@ -1602,7 +1653,7 @@ bool AdaptDispatch::BackwardsTab(const size_t numTabs)
             }
         }
 
-        success = _pConApi->SetConsoleCursorPosition({ column, row });
+        success = _ConApi().SetConsoleCursorPosition({ column, row });
     }
     return success;
 }
@@ -1643,7 +1694,7 @@ bool AdaptDispatch::_ClearSingleTabStop()
 {
     CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-    const bool success = _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    const bool success = _ConApi().GetConsoleScreenBufferInfoEx(csbiex);
     if (success)
     {
         const auto width = csbiex.dwSize.X;
@@ -1725,7 +1776,7 @@ bool AdaptDispatch::DesignateCodingSystem(const VTID codingSystem)
     if (!_initialCodePage.has_value())
     {
         unsigned int currentCodePage;
-        _pConApi->GetConsoleOutputCP(currentCodePage);
+        _ConApi().GetConsoleOutputCP(currentCodePage);
         _initialCodePage = currentCodePage;
     }
 
@@ -1733,14 +1784,14 @@ bool AdaptDispatch::DesignateCodingSystem(const VTID codingSystem)
     switch (codingSystem)
     {
     case DispatchTypes::CodingSystem::ISO2022:
-        success = _pConApi->SetConsoleOutputCP(28591);
+        success = _ConApi().SetConsoleOutputCP(28591);
         if (success)
         {
             _termOutput.EnableGrTranslation(true);
         }
         break;
     case DispatchTypes::CodingSystem::UTF8:
-        success = _pConApi->SetConsoleOutputCP(CP_UTF8);
+        success = _ConApi().SetConsoleOutputCP(CP_UTF8);
         if (success)
         {
             _termOutput.EnableGrTranslation(false);
@@ -1862,7 +1913,7 @@ bool AdaptDispatch::SoftReset()
     if (_initialCodePage.has_value())
     {
         // Restore initial code page if previously changed by a DOCS sequence.
-        success = _pConApi->SetConsoleOutputCP(_initialCodePage.value()) && success;
+        success = _ConApi().SetConsoleOutputCP(_initialCodePage.value()) && success;
     }
 
     success = SetGraphicsRendition({}) && success; // Normal rendition.
@@ -1904,7 +1955,7 @@ bool AdaptDispatch::HardReset()
     // If in the alt buffer, switch back to main before doing anything else.
     if (_usingAltBuffer)
     {
-        success = _pConApi->PrivateUseMainScreenBuffer();
+        success = _ConApi().PrivateUseMainScreenBuffer();
         _usingAltBuffer = !success;
     }
 
@@ -1929,7 +1980,7 @@ bool AdaptDispatch::HardReset()
     // make the state machine propagate this RIS sequence to the connected
     // terminal application. We've reset our state, but the connected terminal
     // might need to do more.
-    if (_pConApi->IsConsolePty())
+    if (_ConApi().IsConsolePty())
     {
         return false;
     }
@@ -1951,22 +2002,22 @@ bool AdaptDispatch::ScreenAlignmentPattern()
     csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = _pConApi->MoveToBottom() && _pConApi->GetConsoleScreenBufferInfoEx(csbiex);
+    bool success = _ConApi().MoveToBottom() && _ConApi().GetConsoleScreenBufferInfoEx(csbiex);
 
     if (success)
     {
         // Fill the screen with the letter E using the default attributes.
         auto fillPosition = COORD{ 0, csbiex.srWindow.Top };
         const auto fillLength = (csbiex.srWindow.Bottom - csbiex.srWindow.Top) * csbiex.dwSize.X;
-        success = _pConApi->PrivateFillRegion(fillPosition, fillLength, L'E', false);
+        success = _ConApi().PrivateFillRegion(fillPosition, fillLength, L'E', false);
         // Reset the line rendition for all of these rows.
-        success = success && _pConApi->PrivateResetLineRenditionRange(csbiex.srWindow.Top, csbiex.srWindow.Bottom);
+        success = success && _ConApi().PrivateResetLineRenditionRange(csbiex.srWindow.Top, csbiex.srWindow.Bottom);
         // Reset the meta/extended attributes (but leave the colors unchanged).
         TextAttribute attr;
-        if (_pConApi->PrivateGetTextAttributes(attr))
+        if (_ConApi().PrivateGetTextAttributes(attr))
         {
             attr.SetStandardErase();
-            success = success && _pConApi->PrivateSetTextAttributes(attr);
+            success = success && _ConApi().PrivateSetTextAttributes(attr);
         }
         // Reset the origin mode to absolute.
         success = success && SetOriginMode(false);
@@ -1997,7 +2048,7 @@ bool AdaptDispatch::_EraseScrollback()
     csbiex.cbSize = sizeof(csbiex);
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool success = (_pConApi->GetConsoleScreenBufferInfoEx(csbiex) && _pConApi->MoveToBottom());
+    bool success = (_ConApi().GetConsoleScreenBufferInfoEx(csbiex) && _ConApi().MoveToBottom());
     if (success)
     {
         const SMALL_RECT screen = csbiex.srWindow;
@@ -2017,16 +2068,16 @@ bool AdaptDispatch::_EraseScrollback()
 
         // Typically a scroll operation should fill with standard erase attributes, but in
         // this case we need to use the default attributes, hence standardFillAttrs is false.
-        success = _pConApi->PrivateScrollRegion(scroll, std::nullopt, destination, false);
+        success = _ConApi().PrivateScrollRegion(scroll, std::nullopt, destination, false);
         if (success)
         {
             // Clear everything after the viewport.
             const DWORD totalAreaBelow = csbiex.dwSize.X * (csbiex.dwSize.Y - height);
             const COORD coordBelowStartPosition = { 0, height };
             // Again we need to use the default attributes, hence standardFillAttrs is false.
-            success = _pConApi->PrivateFillRegion(coordBelowStartPosition, totalAreaBelow, L' ', false);
+            success = _ConApi().PrivateFillRegion(coordBelowStartPosition, totalAreaBelow, L' ', false);
             // Also reset the line rendition for all of the cleared rows.
-            success = success && _pConApi->PrivateResetLineRenditionRange(height, csbiex.dwSize.Y);
+            success = success && _ConApi().PrivateResetLineRenditionRange(height, csbiex.dwSize.Y);
 
             if (success)
             {
@@ -2037,13 +2088,13 @@ bool AdaptDispatch::_EraseScrollback()
                 // SetConsoleWindowInfo uses an inclusive rect, while GetConsolescreenBufferInfo is exclusive
                 newViewport.Right = screen.Right - 1;
                 newViewport.Bottom = height - 1;
-                success = _pConApi->SetConsoleWindowInfo(true, newViewport);
+                success = _ConApi().SetConsoleWindowInfo(true, newViewport);
 
                 if (success)
                 {
                     // Move the cursor to the same relative location.
                     const COORD newcursor = { cursor.X, cursor.Y - screen.Top };
-                    success = _pConApi->SetConsoleCursorPosition(newcursor);
+                    success = _ConApi().SetConsoleCursorPosition(newcursor);
                 }
             }
         }
@@ -2064,7 +2115,7 @@ bool AdaptDispatch::_EraseScrollback()
 // True if handled successfully. False otherwise.
 bool AdaptDispatch::_EraseAll()
 {
-    return _pConApi->PrivateEraseAll();
+    return _ConApi().PrivateEraseAll();
 }
 
 // Routine Description:
@@ -2088,7 +2139,7 @@ bool AdaptDispatch::EnableDECCOLMSupport(const bool enabled) noexcept
 bool AdaptDispatch::EnableVT200MouseMode(const bool enabled)
 {
     bool success = true;
-    success = _pConApi->PrivateEnableVT200MouseMode(enabled);
+    success = _ConApi().PrivateEnableVT200MouseMode(enabled);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -2108,7 +2159,7 @@ bool AdaptDispatch::EnableVT200MouseMode(const bool enabled)
 bool AdaptDispatch::EnableUTF8ExtendedMouseMode(const bool enabled)
 {
     bool success = true;
-    success = _pConApi->PrivateEnableUTF8ExtendedMouseMode(enabled);
+    success = _ConApi().PrivateEnableUTF8ExtendedMouseMode(enabled);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -2128,7 +2179,7 @@ bool AdaptDispatch::EnableUTF8ExtendedMouseMode(const bool enabled)
 bool AdaptDispatch::EnableSGRExtendedMouseMode(const bool enabled)
 {
     bool success = true;
-    success = _pConApi->PrivateEnableSGRExtendedMouseMode(enabled);
+    success = _ConApi().PrivateEnableSGRExtendedMouseMode(enabled);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -2147,7 +2198,7 @@ bool AdaptDispatch::EnableSGRExtendedMouseMode(const bool enabled)
 bool AdaptDispatch::EnableButtonEventMouseMode(const bool enabled)
 {
     bool success = true;
-    success = _pConApi->PrivateEnableButtonEventMouseMode(enabled);
+    success = _ConApi().PrivateEnableButtonEventMouseMode(enabled);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -2167,7 +2218,7 @@ bool AdaptDispatch::EnableButtonEventMouseMode(const bool enabled)
 bool AdaptDispatch::EnableAnyEventMouseMode(const bool enabled)
 {
     bool success = true;
-    success = _pConApi->PrivateEnableAnyEventMouseMode(enabled);
+    success = _ConApi().PrivateEnableAnyEventMouseMode(enabled);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -2187,7 +2238,7 @@ bool AdaptDispatch::EnableAnyEventMouseMode(const bool enabled)
 bool AdaptDispatch::EnableAlternateScroll(const bool enabled)
 {
     bool success = true;
-    success = _pConApi->PrivateEnableAlternateScroll(enabled);
+    success = _ConApi().PrivateEnableAlternateScroll(enabled);
 
     if (_ShouldPassThroughInputModeChange())
     {
@@ -2208,6 +2259,28 @@ bool AdaptDispatch::EnableXtermBracketedPasteMode(const bool /*enabled*/) noexce
     return NoOp();
 }
 
+//Routine Description:
+// Synchronized Output - While enabled, the screen isn't repainted, so that
+//      an application can redraw it in as many writes as it likes without
+//      the intermediate states showing.
+//Arguments:
+// - enabled - true when the update begins, false when it ends.
+// Return value:
+// True if handled successfully. False otherwise.
+bool AdaptDispatch::EnableSynchronizedOutput(const bool enabled)
+{
+    const bool success = _ConApi().PrivateSetSynchronizedOutput(enabled);
+
+    // If we're a conpty, always return false, so that the connected terminal
+    // also presents the frames we send it as a whole.
+    if (_ConApi().IsConsolePty())
+    {
+        return false;
+    }
+
+    return success;
+}
+
 //Routine Description:
 // Set Cursor Style - Changes the cursor's style to match the given Dispatch
 //      cursor style. Unix styles are a combination of the shape and the blinking state.
@@ -2223,7 +2296,7 @@ bool AdaptDispatch::SetCursorStyle(const DispatchTypes::CursorStyle cursorStyle)
     switch (cursorStyle)
     {
     case DispatchTypes::CursorStyle::UserDefault:
-        _pConApi->GetUserDefaultCursorStyle(actualType);
+        _ConApi().GetUserDefaultCursorStyle(actualType);
         fEnableBlinking = true;
         break;
     case DispatchTypes::CursorStyle::BlinkingBlock:
@@ -2258,15 +2331,15 @@ bool AdaptDispatch::SetCursorStyle(const DispatchTypes::CursorStyle cursorStyle)
         return false;
     }
 
-    bool success = _pConApi->SetCursorStyle(actualType);
+    bool success = _ConApi().SetCursorStyle(actualType);
     if (success)
     {
-        success = _pConApi->PrivateAllowCursorBlinking(fEnableBlinking);
+        success = _ConApi().PrivateAllowCursorBlinking(fEnableBlinking);
     }
 
     // If we're a conpty, always return false, so that this cursor state will be
     // sent to the connected terminal
-    if (_pConApi->IsConsolePty())
+    if (_ConApi().IsConsolePty())
     {
         return false;
     }
@@ -2283,12 +2356,12 @@ bool AdaptDispatch::SetCursorStyle(const DispatchTypes::CursorStyle cursorStyle)
 // True if handled successfully. False otherwise.
 bool AdaptDispatch::SetCursorColor(const COLORREF cursorColor)
 {
-    if (_pConApi->IsConsolePty())
+    if (_ConApi().IsConsolePty())
     {
         return false;
     }
 
-    return _pConApi->SetCursorColor(cursorColor);
+    return _ConApi().SetCursorColor(cursorColor);
 }
 
 // Routine Description:
@@ -2311,13 +2384,13 @@ bool AdaptDispatch::SetClipboard(const std::wstring_view /*content*/) noexcept
 // True if handled successfully. False otherwise.
 bool AdaptDispatch::SetColorTableEntry(const size_t tableIndex, const DWORD dwColor)
 {
-    const bool success = _pConApi->PrivateSetColorTableEntry(tableIndex, dwColor);
+    const bool success = _ConApi().PrivateSetColorTableEntry(tableIndex, dwColor);
 
     // If we're a conpty, always return false, so that we send the updated color
     //      value to the terminal. Still handle the sequence so apps that use
     //      the API or VT to query the values of the color table still read the
     //      correct color.
-    if (_pConApi->IsConsolePty())
+    if (_ConApi().IsConsolePty())
     {
         return false;
     }
@@ -2334,13 +2407,13 @@ bool AdaptDispatch::SetColorTableEntry(const size_t tableIndex, const DWORD dwCo
 bool Microsoft::Console::VirtualTerminal::AdaptDispatch::SetDefaultForeground(const DWORD dwColor)
 {
     bool success = true;
-    success = _pConApi->PrivateSetDefaultForeground(dwColor);
+    success = _ConApi().PrivateSetDefaultForeground(dwColor);
 
     // If we're a conpty, always return false, so that we send the updated color
     //      value to the terminal. Still handle the sequence so apps that use
     //      the API or VT to query the values of the color table still read the
     //      correct color.
-    if (_pConApi->IsConsolePty())
+    if (_ConApi().IsConsolePty())
     {
         return false;
     }
@@ -2357,13 +2430,13 @@ bool Microsoft::Console::VirtualTerminal::AdaptDispatch::SetDefaultForeground(co
 bool Microsoft::Console::VirtualTerminal::AdaptDispatch::SetDefaultBackground(const DWORD dwColor)
 {
     bool success = true;
-    success = _pConApi->PrivateSetDefaultBackground(dwColor);
+    success = _ConApi().PrivateSetDefaultBackground(dwColor);
 
     // If we're a conpty, always return false, so that we send the updated color
     //      value to the terminal. Still handle the sequence so apps that use
     //      the API or VT to query the values of the color table still read the
     //      correct color.
-    if (_pConApi->IsConsolePty())
+    if (_ConApi().IsConsolePty())
     {
         return false;
     }
@@ -2394,10 +2467,10 @@ bool AdaptDispatch::WindowManipulation(const DispatchTypes::WindowManipulationTy
     switch (function)
     {
     case DispatchTypes::WindowManipulationType::RefreshWindow:
-        success = DispatchCommon::s_RefreshWindow(*_pConApi);
+        success = DispatchCommon::s_RefreshWindow(_ConApi());
         break;
     case DispatchTypes::WindowManipulationType::ResizeWindowInCharacters:
-        success = DispatchCommon::s_ResizeWindow(*_pConApi, parameter2.value_or(0), parameter1.value_or(0));
+        success = DispatchCommon::s_ResizeWindow(_ConApi(), parameter2.value_or(0), parameter1.value_or(0));
         break;
     default:
         success = false;
@@ -2414,7 +2487,7 @@ bool AdaptDispatch::WindowManipulation(const DispatchTypes::WindowManipulationTy
 // - true
 bool AdaptDispatch::AddHyperlink(const std::wstring_view uri, const std::wstring_view params)
 {
-    return _pConApi->PrivateAddHyperlink(uri, params);
+    return _ConApi().PrivateAddHyperlink(uri, params);
 }
 
 // Method Description:
@@ -2423,7 +2496,7 @@ bool AdaptDispatch::AddHyperlink(const std::wstring_view uri, const std::wstring
 // - true
 bool AdaptDispatch::EndHyperlink()
 {
-    return _pConApi->PrivateEndHyperlink();
+    return _ConApi().PrivateEndHyperlink();
 }
 
 // Method Description:
@@ -2436,6 +2509,28 @@ bool AdaptDispatch::DoConEmuAction(const std::wstring_view /*string*/) noexcept
     return false;
 }
 
+// Method Description:
+// - Ascribes to the ITermDispatch interface
+// - Not actually used in conhost
+// Return Value:
+// - false (so that the command gets flushed to terminal)
+bool AdaptDispatch::DoFinalTermAction(const std::wstring_view /*string*/) noexcept
+{
+    return false;
+}
+
+// Method Description:
+// - DECSIXEL - Ascribes to the ITermDispatch interface
+// - Not actually used in conhost, which doesn't draw images
+// Return Value:
+// - nullptr (so that the image gets streamed to the terminal)
+ITermDispatch::StringHandler AdaptDispatch::DefineSixelImage(const size_t /*macroParameter*/,
+                                                             const DispatchTypes::SixelBackground /*backgroundSelect*/,
+                                                             const size_t /*gridSize*/) noexcept
+{
+    return nullptr;
+}
+
 // Routine Description:
 // - Determines whether we should pass any sequence that manipulates
 //   TerminalInput's input generator through the PTY. It encapsulates
@@ -2452,5 +2547,5 @@ bool AdaptDispatch::_ShouldPassThroughInputModeChange() const
     // us that SSH 7.7 _also_ requests mouse input and that can have a user interface
     // impact on the actual connected terminal. We can't remove this check,
     // because SSH <=7.7 is out in the wild on all versions of Windows <=2004.
-    return _pConApi->IsConsolePty() && _pConApi->PrivateIsVtInputEnabled();
+    return _ConApi().IsConsolePty() && _ConApi().PrivateIsVtInputEnabled();
 }
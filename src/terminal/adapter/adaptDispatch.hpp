@@ -31,11 +31,13 @@ namespace Microsoft::Console::VirtualTerminal
 
         void Execute(const wchar_t wchControl) override
         {
+            FlushPendingPrint();
             _pDefaults->Execute(wchControl);
         }
 
         void PrintString(const std::wstring_view string) override;
         void Print(const wchar_t wchPrintable) override;
+        void FlushPendingPrint() override;
 
         bool CursorUp(const size_t distance) override; // CUU
         bool CursorDown(const size_t distance) override; // CUD
@@ -111,6 +113,7 @@ namespace Microsoft::Console::VirtualTerminal
         bool EnableAnyEventMouseMode(const bool enabled) override; // ?1003
         bool EnableAlternateScroll(const bool enabled) override; // ?1007
         bool EnableXtermBracketedPasteMode(const bool enabled) noexcept override; // ?2004
+        bool EnableSynchronizedOutput(const bool enabled) override; // ?2026
         bool SetCursorStyle(const DispatchTypes::CursorStyle cursorStyle) override; // DECSCUSR
         bool SetCursorColor(const COLORREF cursorColor) override;
 
@@ -130,6 +133,12 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool DoConEmuAction(const std::wstring_view string) noexcept override;
 
+        bool DoFinalTermAction(const std::wstring_view string) noexcept override;
+
+        StringHandler DefineSixelImage(const size_t macroParameter,
+                                       const DispatchTypes::SixelBackground backgroundSelect,
+                                       const size_t gridSize) noexcept override; // DECSIXEL
+
     private:
         enum class ScrollDirection
         {
@@ -181,11 +190,19 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool _ShouldPassThroughInputModeChange() const;
 
+        ConGetSet& _ConApi() const;
+        void _WritePendingPrint() const;
+
         std::vector<bool> _tabStopColumns;
         bool _initDefaultTabStops = true;
 
         std::unique_ptr<ConGetSet> _pConApi;
         std::unique_ptr<AdaptDefaults> _pDefaults;
+
+        // Printed text that hasn't been written to the buffer yet. Consecutive
+        // prints are collected here and written all at once, as soon as
+        // anything else is done through _ConApi() or the dispatch is flushed.
+        mutable std::wstring _pendingPrint;
         TerminalOutput _termOutput;
         std::optional<unsigned int> _initialCodePage;
 
@@ -204,9 +221,5 @@ namespace Microsoft::Console::VirtualTerminal
         bool _isDECCOLMAllowed;
 
         SgrStack _sgrStack;
-
-        size_t _SetRgbColorsHelper(const VTParameters options,
-                                   TextAttribute& attr,
-                                   const bool isForeground) noexcept;
     };
 }
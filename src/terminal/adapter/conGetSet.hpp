@@ -49,6 +49,7 @@ namespace Microsoft::Console::VirtualTerminal
         virtual bool PrivateSetCursorKeysMode(const bool applicationMode) = 0;
         virtual bool PrivateSetKeypadMode(const bool applicationMode) = 0;
         virtual bool PrivateEnableWin32InputMode(const bool win32InputMode) = 0;
+        virtual bool PrivateSetSynchronizedOutput(const bool enabled) = 0;
 
         virtual bool PrivateSetAnsiMode(const bool ansiMode) = 0;
         virtual bool PrivateSetScreenMode(const bool reverseMode) = 0;
@@ -23,6 +23,7 @@ public:
     void Execute(const wchar_t wchControl) override = 0;
     void Print(const wchar_t wchPrintable) override = 0;
     void PrintString(const std::wstring_view string) override = 0;
+    void FlushPendingPrint() noexcept override {}
 
     bool CursorUp(const size_t /*distance*/) noexcept override { return false; } // CUU
     bool CursorDown(const size_t /*distance*/) noexcept override { return false; } // CUD
@@ -73,6 +74,7 @@ public:
     bool EnableAnyEventMouseMode(const bool /*enabled*/) noexcept override { return false; } // ?1003
     bool EnableAlternateScroll(const bool /*enabled*/) noexcept override { return false; } // ?1007
     bool EnableXtermBracketedPasteMode(const bool /*enabled*/) noexcept override { return false; } // ?2004
+    bool EnableSynchronizedOutput(const bool /*enabled*/) noexcept override { return false; } // ?2026
     bool SetColorTableEntry(const size_t /*tableIndex*/, const DWORD /*color*/) noexcept override { return false; } // OSCColorTable
     bool SetDefaultForeground(const DWORD /*color*/) noexcept override { return false; } // OSCDefaultForeground
     bool SetDefaultBackground(const DWORD /*color*/) noexcept override { return false; } // OSCDefaultBackground
@@ -123,4 +125,9 @@ public:
     bool EndHyperlink() noexcept override { return false; }
 
     bool DoConEmuAction(const std::wstring_view /*string*/) noexcept override { return false; }
+    bool DoFinalTermAction(const std::wstring_view /*string*/) noexcept override { return false; }
+
+    StringHandler DefineSixelImage(const size_t /*macroParameter*/,
+                                   const DispatchTypes::SixelBackground /*backgroundSelect*/,
+                                   const size_t /*gridSize*/) noexcept override { return nullptr; } // DECSIXEL
 };
@@ -143,6 +143,18 @@ public:
         return true;
     }
 
+    bool PrivateSetSynchronizedOutput(const bool enabled) override
+    {
+        Log::Comment(L"PrivateSetSynchronizedOutput MOCK called...");
+
+        if (_privateSetSynchronizedOutputResult)
+        {
+            VERIFY_ARE_EQUAL(_expectedSynchronizedOutput, enabled);
+        }
+
+        return _privateSetSynchronizedOutputResult;
+    }
+
     bool PrivateSetAnsiMode(const bool ansiMode) override
     {
         Log::Comment(L"PrivateSetAnsiMode MOCK called...");
@@ -774,6 +786,8 @@ public:
     bool _keypadApplicationMode = false;
     bool _privateSetAnsiModeResult = false;
     bool _expectedAnsiMode = false;
+    bool _privateSetSynchronizedOutputResult = false;
+    bool _expectedSynchronizedOutput = false;
     bool _privateAllowCursorBlinkingResult = false;
     bool _enable = false; // for cursor blinking
     bool _privateSetScrollingRegionResult = false;
@@ -816,17 +830,22 @@ private:
 
 class DummyAdapter : public AdaptDefaults
 {
-    void Print(const wchar_t /*wch*/) override
+public:
+    void Print(const wchar_t wch) override
     {
+        _printed.emplace_back(1, wch);
     }
 
-    void PrintString(const std::wstring_view /*string*/) override
+    void PrintString(const std::wstring_view string) override
     {
+        _printed.emplace_back(string);
     }
 
     void Execute(const wchar_t /*wch*/) override
     {
     }
+
+    std::vector<std::wstring> _printed;
 };
 
 class AdapterTest
@@ -846,6 +865,7 @@ public:
 
             // give AdaptDispatch ownership of _testGetSet
             _testGetSet = api.get(); // keep a copy for us but don't manage its lifetime anymore.
+            _testAdapter = adapter.get();
             _pDispatch = std::make_unique<AdaptDispatch>(std::move(api), std::move(adapter));
             fSuccess = _pDispatch != nullptr;
         }
@@ -1583,6 +1603,33 @@ public:
         VERIFY_IS_TRUE(_pDispatch.get()->SetGraphicsRendition({ rgOptions, cOptions }));
     }
 
+    TEST_METHOD(GraphicsOptionsFoldInOrderTest)
+    {
+        Log::Comment(L"Starting test...");
+
+        _testGetSet->PrepData();
+        _testGetSet->_attribute = {};
+
+        Log::Comment(L"Later options win over earlier ones, and a reset drops everything before it.");
+        VTParameter rgOptions[] = {
+            DispatchTypes::GraphicsOptions::BoldBright,
+            DispatchTypes::GraphicsOptions::ForegroundRed,
+            DispatchTypes::GraphicsOptions::Off,
+            DispatchTypes::GraphicsOptions::Negative,
+            DispatchTypes::GraphicsOptions::Underline,
+            DispatchTypes::GraphicsOptions::Positive,
+            DispatchTypes::GraphicsOptions::BackgroundExtended,
+            DispatchTypes::GraphicsOptions::BlinkOrXterm256Index,
+            1,
+            DispatchTypes::GraphicsOptions::BrightForegroundBlue,
+        };
+        _testGetSet->_expectedAttribute = {};
+        _testGetSet->_expectedAttribute.SetUnderlined(true);
+        _testGetSet->_expectedAttribute.SetIndexedBackground256(FOREGROUND_RED);
+        _testGetSet->_expectedAttribute.SetIndexedForeground(FOREGROUND_BLUE | FOREGROUND_INTENSITY);
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition({ rgOptions, ARRAYSIZE(rgOptions) }));
+    }
+
     TEST_METHOD(GraphicsPushPopTests)
     {
         Log::Comment(L"Starting test...");
@@ -2029,6 +2076,69 @@ public:
         VERIFY_IS_TRUE(_pDispatch.get()->SetAnsiMode(false));
     }
 
+    TEST_METHOD(CoalescedPrintTest)
+    {
+        Log::Comment(L"Starting test...");
+
+        _testGetSet->PrepData();
+        _testGetSet->_privateSetTextAttributesResult = TRUE;
+
+        Log::Comment(L"Test 1: consecutive prints are written at once, when the dispatch is flushed.");
+        _pDispatch->Print(L'a');
+        _pDispatch->PrintString(L"bc");
+        VERIFY_ARE_EQUAL(0u, _testAdapter->_printed.size());
+        _pDispatch->FlushPendingPrint();
+        VERIFY_ARE_EQUAL(1u, _testAdapter->_printed.size());
+        VERIFY_ARE_EQUAL(L"abc", std::wstring_view{ _testAdapter->_printed.back() });
+
+        Log::Comment(L"Test 2: an SGR that doesn't change the attributes doesn't interrupt the run.");
+        _testAdapter->_printed.clear();
+        _testGetSet->_attribute = {};
+        VTParameter reset[] = { DispatchTypes::GraphicsOptions::Off };
+        _pDispatch->PrintString(L"de");
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition({ reset, 1 }));
+        _pDispatch->PrintString(L"f");
+        VERIFY_ARE_EQUAL(0u, _testAdapter->_printed.size());
+
+        Log::Comment(L"Test 3: an SGR that changes them writes the run first.");
+        VTParameter bold[] = { DispatchTypes::GraphicsOptions::BoldBright };
+        _testGetSet->_expectedAttribute = {};
+        _testGetSet->_expectedAttribute.SetBold(true);
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition({ bold, 1 }));
+        VERIFY_ARE_EQUAL(1u, _testAdapter->_printed.size());
+        VERIFY_ARE_EQUAL(L"def", std::wstring_view{ _testAdapter->_printed.back() });
+
+        Log::Comment(L"Test 4: any other operation writes the run first.");
+        _pDispatch->PrintString(L"g");
+        _testGetSet->_expectedCursorPos.X = 0;
+        _testGetSet->_expectedCursorPos.Y = _testGetSet->_viewport.Top;
+        VERIFY_IS_TRUE(_pDispatch->CursorPosition(1, 1));
+        VERIFY_ARE_EQUAL(2u, _testAdapter->_printed.size());
+        VERIFY_ARE_EQUAL(L"g", std::wstring_view{ _testAdapter->_printed.back() });
+    }
+
+    TEST_METHOD(SynchronizedOutputTest)
+    {
+        Log::Comment(L"Starting test...");
+
+        Log::Comment(L"Test 1: begin a synchronized update");
+        _testGetSet->_privateSetSynchronizedOutputResult = true;
+        _testGetSet->_expectedSynchronizedOutput = true;
+
+        VERIFY_IS_TRUE(_pDispatch.get()->SetMode(DispatchTypes::ModeParams::SO_SynchronizedOutput));
+
+        Log::Comment(L"Test 2: end the synchronized update");
+        _testGetSet->_expectedSynchronizedOutput = false;
+
+        VERIFY_IS_TRUE(_pDispatch.get()->ResetMode(DispatchTypes::ModeParams::SO_SynchronizedOutput));
+
+        Log::Comment(L"Test 3: in pty mode the update is passed through, but still applied");
+        _testGetSet->_isPty = true;
+        _testGetSet->_expectedSynchronizedOutput = true;
+
+        VERIFY_IS_FALSE(_pDispatch.get()->SetMode(DispatchTypes::ModeParams::SO_SynchronizedOutput));
+    }
+
     TEST_METHOD(AllowBlinkingTest)
     {
         Log::Comment(L"Starting test...");
@@ -2355,5 +2465,6 @@ public:
 
 private:
     TestGetSet* _testGetSet; // non-ownership pointer
+    DummyAdapter* _testAdapter; // non-ownership pointer
     std::unique_ptr<AdaptDispatch> _pDispatch;
 };
@@ -19,12 +19,6 @@
 
 using namespace Microsoft::Console::VirtualTerminal;
 
-TerminalInput::TerminalInput(_In_ std::function<void(std::deque<std::unique_ptr<IInputEvent>>&)> pfn) :
-    _leadingSurrogate{}
-{
-    _pfnWriteEvents = pfn;
-}
-
 struct TermKeyMap
 {
     const WORD vkey;
@@ -245,24 +239,149 @@ static constexpr std::array<TermKeyMap, 14> s_simpleModifiedKeyMapping{
     // TermKeyMap{ VK_ESCAPE, ALT_PRESSED, L""}, This is another Windows system shortcut for switching windows.
 };
 
+// The index of a set of modifiers in the lookup tables below: 1 for Shift, 2 for Alt
+// and 4 for Ctrl. One more than that is what xterm encodes in modified sequences.
+static constexpr size_t s_modifierIndex(const bool shift, const bool alt, const bool ctrl) noexcept
+{
+    return (shift ? 1 : 0) + (alt ? 2 : 0) + (ctrl ? 4 : 0);
+}
+
+// The number of virtual key codes, which are all less than 256.
+static constexpr size_t s_virtualKeyCount = 256;
+
+// The mappings of the keys, indexed by their virtual key code, for a set of modes.
+// They're used without regard to the modifiers being pressed.
+struct TerminalInput::KeyMapTable
+{
+    std::array<const TermKeyMap*, s_virtualKeyCount> keys;
+
+    const TermKeyMap* Find(const WORD vkey) const noexcept
+    {
+        return vkey < keys.size() ? til::at(keys, vkey) : nullptr;
+    }
+
+    template<size_t CursorKeyCount, size_t KeypadCount>
+    static constexpr KeyMapTable Build(const std::array<TermKeyMap, CursorKeyCount>& cursorKeys,
+                                       const std::array<TermKeyMap, KeypadCount>& keypad) noexcept
+    {
+        KeyMapTable table{};
+        // The cursor keys come from the first mapping and every other key from the
+        // second one. Where a key is in a mapping twice, its first entry is used.
+        for (size_t i = 0; i < CursorKeyCount; ++i)
+        {
+            auto& entry = table.keys[cursorKeys[i].vkey];
+            if (!entry && cursorKeys[i].vkey >= VK_END && cursorKeys[i].vkey <= VK_DOWN)
+            {
+                entry = &cursorKeys[i];
+            }
+        }
+        for (size_t i = 0; i < KeypadCount; ++i)
+        {
+            auto& entry = table.keys[keypad[i].vkey];
+            if (!entry && (keypad[i].vkey < VK_END || keypad[i].vkey > VK_DOWN))
+            {
+                entry = &keypad[i];
+            }
+        }
+        return table;
+    }
+};
+
+// The mappings of the keys that are pressed with modifiers, indexed by the virtual key
+// code and s_modifierIndex. The sequences of s_modifierKeyMapping still need the
+// modifiers to be encoded into them.
+struct ModifiedKeyMap
+{
+    const TermKeyMap* map;
+    bool encodesModifiers;
+};
+
+static constexpr std::array<ModifiedKeyMap, s_virtualKeyCount * 8> s_buildModifiedKeyMapTable() noexcept
+{
+    std::array<ModifiedKeyMap, s_virtualKeyCount * 8> table{};
+    // s_modifierKeyMapping takes precedence, and matches any modifiers.
+    for (const auto& map : s_modifierKeyMapping)
+    {
+        // Index 0 is left out, since these are only looked up while a modifier is pressed.
+        for (size_t modifiers = 1; modifiers < 8; ++modifiers)
+        {
+            auto& entry = table[map.vkey * 8 + modifiers];
+            if (!entry.map)
+            {
+                entry = { &map, true };
+            }
+        }
+    }
+    // s_simpleModifiedKeyMapping only matches the exact modifiers it's given.
+    for (const auto& map : s_simpleModifiedKeyMapping)
+    {
+        const auto modifiers = s_modifierIndex((map.modifiers & SHIFT_PRESSED) != 0,
+                                               (map.modifiers & ALT_PRESSED) != 0,
+                                               (map.modifiers & CTRL_PRESSED) != 0);
+        auto& entry = table[map.vkey * 8 + modifiers];
+        if (!entry.map)
+        {
+            entry = { &map, false };
+        }
+    }
+    return table;
+}
+
+static constexpr auto s_modifiedKeyMap = s_buildModifiedKeyMapTable();
+
 const wchar_t* const CTRL_SLASH_SEQUENCE = L"\x1f";
 const wchar_t* const CTRL_QUESTIONMARK_SEQUENCE = L"\x7F";
 const wchar_t* const CTRL_ALT_SLASH_SEQUENCE = L"\x1b\x1f";
 const wchar_t* const CTRL_ALT_QUESTIONMARK_SEQUENCE = L"\x1b\x7F";
 
+TerminalInput::TerminalInput(_In_ std::function<void(std::deque<std::unique_ptr<IInputEvent>>&)> pfn) :
+    _leadingSurrogate{}
+{
+    _pfnWriteEvents = pfn;
+    _UpdateKeyMap();
+}
+
 void TerminalInput::ChangeAnsiMode(const bool ansiMode) noexcept
 {
     _ansiMode = ansiMode;
+    _UpdateKeyMap();
 }
 
 void TerminalInput::ChangeKeypadMode(const bool applicationMode) noexcept
 {
     _keypadApplicationMode = applicationMode;
+    _UpdateKeyMap();
 }
 
 void TerminalInput::ChangeCursorKeysMode(const bool applicationMode) noexcept
 {
     _cursorApplicationMode = applicationMode;
+    _UpdateKeyMap();
+}
+
+// Routine Description:
+// - Picks the mappings of the keys for the current modes, so that a key press
+//   is a single lookup no matter which modes are set.
+void TerminalInput::_UpdateKeyMap() noexcept
+{
+    static constexpr auto normal = KeyMapTable::Build(s_cursorKeysNormalMapping, s_keypadNumericMapping);
+    static constexpr auto keypadApplication = KeyMapTable::Build(s_cursorKeysNormalMapping, s_keypadApplicationMapping);
+    static constexpr auto cursorApplication = KeyMapTable::Build(s_cursorKeysApplicationMapping, s_keypadNumericMapping);
+    static constexpr auto application = KeyMapTable::Build(s_cursorKeysApplicationMapping, s_keypadApplicationMapping);
+    static constexpr auto vt52 = KeyMapTable::Build(s_cursorKeysVt52Mapping, s_keypadVt52Mapping);
+
+    if (!_ansiMode)
+    {
+        _keyMap = &vt52;
+    }
+    else if (_cursorApplicationMode)
+    {
+        _keyMap = _keypadApplicationMode ? &application : &cursorApplication;
+    }
+    else
+    {
+        _keyMap = _keypadApplicationMode ? &keypadApplication : &normal;
+    }
 }
 
 void TerminalInput::ChangeWin32InputMode(const bool win32InputMode) noexcept
@@ -274,131 +393,73 @@ void TerminalInput::ForceDisableWin32InputMode(const bool win32InputMode) noexce
     _forceDisableWin32InputMode = win32InputMode;
 }
 
-static const gsl::span<const TermKeyMap> _getKeyMapping(const KeyEvent& keyEvent,
-                                                        const bool ansiMode,
-                                                        const bool cursorApplicationMode,
-                                                        const bool keypadApplicationMode) noexcept
+// Routine Description:
+// - Gets the modes which change how keys are encoded. win32-input-mode is
+//   only reported while it isn't disabled by ForceDisableWin32InputMode.
+// Return Value:
+// - The modes that are currently set.
+TerminalInput::Mode TerminalInput::GetInputModes() const noexcept
 {
-    if (ansiMode)
-    {
-        if (keyEvent.IsCursorKey())
-        {
-            if (cursorApplicationMode)
-            {
-                return { s_cursorKeysApplicationMapping.data(), s_cursorKeysApplicationMapping.size() };
-            }
-            else
-            {
-                return { s_cursorKeysNormalMapping.data(), s_cursorKeysNormalMapping.size() };
-            }
-        }
-        else
-        {
-            if (keypadApplicationMode)
-            {
-                return { s_keypadApplicationMapping.data(), s_keypadApplicationMapping.size() };
-            }
-            else
-            {
-                return { s_keypadNumericMapping.data(), s_keypadNumericMapping.size() };
-            }
-        }
-    }
-    else
-    {
-        if (keyEvent.IsCursorKey())
-        {
-            return { s_cursorKeysVt52Mapping.data(), s_cursorKeysVt52Mapping.size() };
-        }
-        else
-        {
-            return { s_keypadVt52Mapping.data(), s_keypadVt52Mapping.size() };
-        }
-    }
+    auto modes = Mode::None;
+    WI_SetFlagIf(modes, Mode::Ansi, _ansiMode);
+    WI_SetFlagIf(modes, Mode::Keypad, _keypadApplicationMode);
+    WI_SetFlagIf(modes, Mode::CursorKey, _cursorApplicationMode);
+    WI_SetFlagIf(modes, Mode::Win32, _win32InputMode && !_forceDisableWin32InputMode);
+    return modes;
 }
 
 // Routine Description:
-// - Searches the keyMapping for a entry corresponding to this key event, and returns it.
+// - Sets all the modes which change how keys are encoded at once, so that
+//   keys can be encoded the way another terminal would encode them.
 // Arguments:
-// - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
-// Return Value:
-// - Has value if there was a match to a key translation.
-static std::optional<const TermKeyMap> _searchKeyMapping(const KeyEvent& keyEvent,
-                                                         gsl::span<const TermKeyMap> keyMapping) noexcept
+// - modes: The modes to set. Those that aren't given are reset.
+void TerminalInput::SetInputModes(const Mode modes) noexcept
 {
-    for (auto& map : keyMapping)
-    {
-        if (map.vkey == keyEvent.GetVirtualKeyCode())
-        {
-            // If the mapping has no modifiers set, then it doesn't really care
-            //      what the modifiers are on the key. The caller will likely do
-            //      something with them.
-            // However, if there are modifiers set, then we only want to match
-            //      if the key's modifiers are the same as the modifiers in the
-            //      mapping.
-            bool modifiersMatch = WI_AreAllFlagsClear(map.modifiers, MOD_PRESSED);
-            if (!modifiersMatch)
-            {
-                // The modifier mapping expects certain modifier keys to be
-                //      pressed. Check those as well.
-                modifiersMatch =
-                    (WI_IsFlagSet(map.modifiers, SHIFT_PRESSED) == keyEvent.IsShiftPressed()) &&
-                    (WI_IsAnyFlagSet(map.modifiers, ALT_PRESSED) == keyEvent.IsAltPressed()) &&
-                    (WI_IsAnyFlagSet(map.modifiers, CTRL_PRESSED) == keyEvent.IsCtrlPressed());
-            }
-
-            if (modifiersMatch)
-            {
-                return map;
-            }
-        }
-    }
-    return std::nullopt;
+    _ansiMode = WI_IsFlagSet(modes, Mode::Ansi);
+    _keypadApplicationMode = WI_IsFlagSet(modes, Mode::Keypad);
+    _cursorApplicationMode = WI_IsFlagSet(modes, Mode::CursorKey);
+    _win32InputMode = WI_IsFlagSet(modes, Mode::Win32);
+    _forceDisableWin32InputMode = false;
+    _UpdateKeyMap();
 }
 
 typedef std::function<void(const std::wstring_view)> InputSender;
 
 // Routine Description:
-// - Searches the s_modifierKeyMapping for a entry corresponding to this key event.
-//      Changes the second to last byte to correspond to the currently pressed modifier keys
-//      before sending to the input.
+// - Looks up the modified sequence of this key event in s_modifiedKeyMap. Sequences from
+//      s_modifierKeyMapping get their second to last character changed to correspond to
+//      the currently pressed modifier keys before they're sent to the input.
 // Arguments:
 // - keyEvent - Key event to translate
+// - buffer - Storage for the modified sequence, which is reused between key events
 // - sender - Function to use to dispatch translated event
 // Return Value:
 // - True if there was a match to a key translation, and we successfully modified and sent it to the input
-static bool _searchWithModifier(const KeyEvent& keyEvent, InputSender sender)
+static bool _searchWithModifier(const KeyEvent& keyEvent, std::wstring& buffer, InputSender sender)
 {
     bool success = false;
 
-    const auto match = _searchKeyMapping(keyEvent,
-                                         { s_modifierKeyMapping.data(), s_modifierKeyMapping.size() });
-    if (match)
+    const bool shift = keyEvent.IsShiftPressed();
+    const bool alt = keyEvent.IsAltPressed();
+    const bool ctrl = keyEvent.IsCtrlPressed();
+    const auto vkey = keyEvent.GetVirtualKeyCode();
+    const auto match = vkey < s_virtualKeyCount ? til::at(s_modifiedKeyMap, vkey * 8 + s_modifierIndex(shift, alt, ctrl)) : ModifiedKeyMap{};
+    if (match.map && match.encodesModifiers)
     {
-        const auto& v = match.value();
-        if (!v.sequence.empty())
+        if (!match.map->sequence.empty())
         {
-            std::wstring modified{ v.sequence }; // Make a copy so we can modify it.
-            const bool shift = keyEvent.IsShiftPressed();
-            const bool alt = keyEvent.IsAltPressed();
-            const bool ctrl = keyEvent.IsCtrlPressed();
-            modified.at(modified.size() - 2) = L'1' + (shift ? 1 : 0) + (alt ? 2 : 0) + (ctrl ? 4 : 0);
-            sender(modified);
+            buffer.assign(match.map->sequence);
+            til::at(buffer, buffer.size() - 2) = gsl::narrow_cast<wchar_t>(L'1' + s_modifierIndex(shift, alt, ctrl));
+            sender(buffer);
             success = true;
         }
     }
     else
     {
-        // We didn't find the key in the map of modified keys that need editing,
-        //      maybe it's in the other map of modified keys with sequences that
-        //      don't need editing before sending.
-        const auto match2 = _searchKeyMapping(keyEvent,
-                                              { s_simpleModifiedKeyMapping.data(), s_simpleModifiedKeyMapping.size() });
-        if (match2)
+        if (match.map)
         {
             // This mapping doesn't need to be changed at all.
-            sender(match2.value().sequence);
+            sender(match.map->sequence);
             success = true;
         }
         else
@@ -431,12 +492,7 @@ static bool _searchWithModifier(const KeyEvent& keyEvent, InputSender sender)
             const auto slashVkey = LOBYTE(slashKeyScan);
             const auto questionMarkVkey = LOBYTE(questionMarkKeyScan);
 
-            const auto ctrl = keyEvent.IsCtrlPressed();
-            const auto alt = keyEvent.IsAltPressed();
-            const bool shift = keyEvent.IsShiftPressed();
-
             // From the KeyEvent we're translating, synthesize the equivalent VkKeyScan result
-            const auto vkey = keyEvent.GetVirtualKeyCode();
             const short keyScanFromEvent = vkey |
                                            (shift ? 0x100 : 0) |
                                            (ctrl ? 0x200 : 0) |
@@ -479,26 +535,6 @@ static bool _searchWithModifier(const KeyEvent& keyEvent, InputSender sender)
     return success;
 }
 
-// Routine Description:
-// - Searches the input array of mappings, and sends it to the input if a match was found.
-// Arguments:
-// - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
-// - sender - Function to use to dispatch translated event
-// Return Value:
-// - True if there was a match to a key translation, and we successfully sent it to the input
-static bool _translateDefaultMapping(const KeyEvent& keyEvent,
-                                     const gsl::span<const TermKeyMap> keyMapping,
-                                     InputSender sender)
-{
-    const auto match = _searchKeyMapping(keyEvent, keyMapping);
-    if (match)
-    {
-        sender(match->sequence);
-    }
-    return match.has_value();
-}
-
 // Routine Description:
 // - Sends the given input event to the shell.
 // - The caller should attempt to fill the char data in pInEvent if possible.
@@ -532,8 +568,8 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent)
     // Only do this if win32-input-mode support isn't manually disabled.
     if (_win32InputMode && !_forceDisableWin32InputMode)
     {
-        const auto seq = _GenerateWin32KeySequence(keyEvent);
-        _SendInputSequence(seq);
+        _GenerateWin32KeySequence(keyEvent);
+        _SendInputSequence(_sequenceBuffer);
         return true;
     }
 
@@ -599,7 +635,7 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent)
     };
 
     // If a modifier key was pressed, then we need to try and send the modified sequence.
-    if (keyEvent.IsModifierPressed() && _searchWithModifier(keyEvent, senderFunc))
+    if (keyEvent.IsModifierPressed() && _searchWithModifier(keyEvent, _sequenceBuffer, senderFunc))
     {
         return true;
     }
@@ -655,9 +691,10 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent)
     // Check any other key mappings (like those for the F1-F12 keys).
     // These mappings will kick in no matter which modifiers are pressed and as such
     // must be checked last, or otherwise we'd override more complex key combinations.
-    const auto mapping = _getKeyMapping(keyEvent, _ansiMode, _cursorApplicationMode, _keypadApplicationMode);
-    if (_translateDefaultMapping(keyEvent, mapping, senderFunc))
+    // The mappings for the current modes were picked by _UpdateKeyMap.
+    if (const auto match = _keyMap->Find(keyEvent.GetVirtualKeyCode()))
     {
+        _SendInputSequence(match->sequence);
         return true;
     }
 
@@ -764,12 +801,11 @@ void TerminalInput::_SendInputSequence(const std::wstring_view sequence) const n
 }
 
 // Method Description:
-// - Synthesize a win32-input-mode sequence for the given keyevent.
+// - Synthesize a win32-input-mode sequence for the given keyevent into
+//   _sequenceBuffer, which is reused so that a key press doesn't allocate.
 // Arguments:
 // - key: the KeyEvent to serialize.
-// Return Value:
-// - the formatted string representation of this key
-std::wstring TerminalInput::_GenerateWin32KeySequence(const KeyEvent& key)
+void TerminalInput::_GenerateWin32KeySequence(const KeyEvent& key)
 {
     // Sequences are formatted as follows:
     //
@@ -782,11 +818,13 @@ std::wstring TerminalInput::_GenerateWin32KeySequence(const KeyEvent& key)
     //      Kd: the value of bKeyDown - either a '0' or '1'. If omitted, defaults to '0'.
     //      Cs: the value of dwControlKeyState - any number. If omitted, defaults to '0'.
     //      Rc: the value of wRepeatCount - any number. If omitted, defaults to '1'.
-    return fmt::format(FMT_COMPILE(L"\x1b[{};{};{};{};{};{}_"),
-                       key.GetVirtualKeyCode(),
-                       key.GetVirtualScanCode(),
-                       static_cast<int>(key.GetCharData()),
-                       key.IsKeyDown() ? 1 : 0,
-                       key.GetActiveModifierKeys(),
-                       key.GetRepeatCount());
+    _sequenceBuffer.clear();
+    fmt::format_to(std::back_inserter(_sequenceBuffer),
+                   FMT_COMPILE(L"\x1b[{};{};{};{};{};{}_"),
+                   key.GetVirtualKeyCode(),
+                   key.GetVirtualScanCode(),
+                   static_cast<int>(key.GetCharData()),
+                   key.IsKeyDown() ? 1 : 0,
+                   key.GetActiveModifierKeys(),
+                   key.GetRepeatCount());
 }
@@ -41,6 +41,20 @@ namespace Microsoft::Console::VirtualTerminal
         void ChangeWin32InputMode(const bool win32InputMode) noexcept;
         void ForceDisableWin32InputMode(const bool win32InputMode) noexcept;
 
+        // The modes which change how keys are encoded. Terminals in the same
+        // modes send the same sequences for the same key events.
+        enum class Mode : uint32_t
+        {
+            None = 0x0,
+            Ansi = 0x1,
+            Keypad = 0x2,
+            CursorKey = 0x4,
+            Win32 = 0x8
+        };
+
+        Mode GetInputModes() const noexcept;
+        void SetInputModes(const Mode modes) noexcept;
+
 #pragma region MouseInput
         // These methods are defined in mouseInput.cpp
 
@@ -86,11 +100,19 @@ namespace Microsoft::Console::VirtualTerminal
         bool _win32InputMode{ false };
         bool _forceDisableWin32InputMode{ false };
 
+        // The mappings of the keys for the current modes. They're defined in terminalInput.cpp.
+        struct KeyMapTable;
+        const KeyMapTable* _keyMap{ nullptr };
+        // storage for the sequences that are put together for a key press
+        std::wstring _sequenceBuffer;
+
+        void _UpdateKeyMap() noexcept;
+
         void _SendChar(const wchar_t ch);
         void _SendNullInputSequence(const DWORD dwControlKeyState) const;
         void _SendInputSequence(const std::wstring_view sequence) const noexcept;
         void _SendEscapedInputSequence(const wchar_t wch) const;
-        static std::wstring _GenerateWin32KeySequence(const KeyEvent& key);
+        void _GenerateWin32KeySequence(const KeyEvent& key);
 
 #pragma region MouseInputState Management
         // These methods are defined in mouseInputState.cpp
@@ -148,4 +170,6 @@ namespace Microsoft::Console::VirtualTerminal
         static constexpr unsigned int s_GetPressedButton(const MouseButtonState state) noexcept;
 #pragma endregion
     };
+
+    DEFINE_ENUM_FLAG_OPERATORS(TerminalInput::Mode);
 }
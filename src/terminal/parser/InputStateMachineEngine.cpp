@@ -519,6 +519,18 @@ bool InputStateMachineEngine::ActionIgnore() noexcept
     return true;
 }
 
+// Method Description:
+// - Triggers the EndOfString action to indicate that all of the input passed
+//      to the state machine has been processed. Nothing is held back here.
+// Arguments:
+// - <none>
+// Return Value:
+// - true always.
+bool InputStateMachineEngine::ActionEndOfString() noexcept
+{
+    return true;
+}
+
 // Method Description:
 // - Triggers the OscDispatch action to indicate that the listener should handle a control sequence.
 //   These sequences perform various API-type commands that can include many parameters.
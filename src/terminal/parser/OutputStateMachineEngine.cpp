@@ -20,6 +20,7 @@ constexpr COLORREF INVALID_COLOR = 0xffffffff;
 OutputStateMachineEngine::OutputStateMachineEngine(std::unique_ptr<ITermDispatch> pDispatch) :
     _dispatch(std::move(pDispatch)),
     _pfnFlushToTerminal(nullptr),
+    _pfnFlushExecuteToTerminal(nullptr),
     _pTtyConnection(nullptr),
     _lastPrintedChar(AsciiChars::NUL)
 {
@@ -56,7 +57,8 @@ bool OutputStateMachineEngine::ActionExecute(const wchar_t wch)
         _dispatch->WarningBell();
         // microsoft/terminal#2952
         // If we're attached to a terminal, let's also pass the BEL through.
-        if (_pfnFlushToTerminal != nullptr)
+        // In passthrough mode, that's done below along with the other controls.
+        if (_pfnFlushToTerminal != nullptr && !_IsPassthroughActive())
         {
             _pfnFlushToTerminal();
         }
@@ -87,6 +89,13 @@ bool OutputStateMachineEngine::ActionExecute(const wchar_t wch)
         break;
     }
 
+    // In passthrough mode, the terminal executes the control characters as well,
+    //      so it stays in sync with our buffer without us repainting it.
+    if (wch != AsciiChars::NUL && _IsPassthroughActive())
+    {
+        _pfnFlushExecuteToTerminal();
+    }
+
     _ClearLastChar();
 
     return true;
@@ -124,6 +133,11 @@ bool OutputStateMachineEngine::ActionPrint(const wchar_t wch)
 
     _dispatch->Print(wch); // call print
 
+    if (_IsPassthroughActive())
+    {
+        ActionPassThroughString({ &wch, 1 });
+    }
+
     return true;
 }
 
@@ -150,6 +164,11 @@ bool OutputStateMachineEngine::ActionPrintString(const std::wstring_view string)
 
     _dispatch->PrintString(string); // call print
 
+    if (_IsPassthroughActive())
+    {
+        ActionPassThroughString(string);
+    }
+
     return true;
 }
 
@@ -329,12 +348,7 @@ bool OutputStateMachineEngine::ActionEscDispatch(const VTID id)
         }
     }
 
-    // If we were unable to process the string, and there's a TTY attached to us,
-    //      trigger the state machine to flush the string to the terminal.
-    if (_pfnFlushToTerminal != nullptr && !success)
-    {
-        success = _pfnFlushToTerminal();
-    }
+    success = _PassThroughSequence(success, id == EscActionCodes::DECID_IdentifyDevice);
 
     _ClearLastChar();
 
@@ -409,6 +423,13 @@ bool OutputStateMachineEngine::ActionVt52EscDispatch(const VTID id, const VTPara
         break;
     }
 
+    // Unlike the other sequences, the ones we don't understand aren't flushed
+    //      to the terminal, as it isn't in VT52 mode unless we've told it to be.
+    if (success && id != Vt52ActionCodes::Identify)
+    {
+        success = _PassThroughSequence(success, false);
+    }
+
     _ClearLastChar();
 
     return success;
@@ -624,12 +645,7 @@ bool OutputStateMachineEngine::ActionCsiDispatch(const VTID id, const VTParamete
         break;
     }
 
-    // If we were unable to process the string, and there's a TTY attached to us,
-    //      trigger the state machine to flush the string to the terminal.
-    if (_pfnFlushToTerminal != nullptr && !success)
-    {
-        success = _pfnFlushToTerminal();
-    }
+    success = _PassThroughSequence(success, _IsQuery(id));
 
     _ClearLastChar();
 
@@ -645,10 +661,27 @@ bool OutputStateMachineEngine::ActionCsiDispatch(const VTID id, const VTParamete
 // - parameters - set of numeric parameters collected while parsing the sequence.
 // Return Value:
 // - the data string handler function or nullptr if the sequence is not supported
-IStateMachineEngine::StringHandler OutputStateMachineEngine::ActionDcsDispatch(const VTID /*id*/, const VTParameters /*parameters*/) noexcept
+IStateMachineEngine::StringHandler OutputStateMachineEngine::ActionDcsDispatch(const VTID id, const VTParameters parameters)
 {
     StringHandler handler = nullptr;
 
+    switch (id)
+    {
+    case DcsActionCodes::DECSIXEL_DefineImage:
+        handler = _dispatch->DefineSixelImage(parameters.at(0).value_or(0),
+                                              parameters.at(1),
+                                              parameters.at(2).value_or(0));
+        break;
+    default:
+        break;
+    }
+
+    // Like the other sequences we don't handle, the string goes to the terminal if there is one.
+    if (!handler && _pfnFlushToTerminal != nullptr)
+    {
+        handler = _PassThroughDcsString();
+    }
+
     _ClearLastChar();
 
     return handler;
@@ -680,6 +713,20 @@ bool OutputStateMachineEngine::ActionIgnore() noexcept
     return true;
 }
 
+// Routine Description:
+// - Triggers the EndOfString action to indicate that all of the output passed
+//      to the state machine has been processed. The dispatch may have held
+//      back printed text, to write it all at once, which has to happen now.
+// Arguments:
+// - <none>
+// Return Value:
+// - true always.
+bool OutputStateMachineEngine::ActionEndOfString()
+{
+    _dispatch->FlushPendingPrint();
+    return true;
+}
+
 // Routine Description:
 // - Triggers the OscDispatch action to indicate that the listener should handle a control sequence.
 //   These sequences perform various API-type commands that can include many parameters.
@@ -808,18 +855,18 @@ bool OutputStateMachineEngine::ActionOscDispatch(const wchar_t /*wch*/,
         success = _dispatch->DoConEmuAction(string);
         break;
     }
+    case OscActionCodes::FinalTermAction:
+    {
+        success = _dispatch->DoFinalTermAction(string);
+        break;
+    }
     default:
         // If no functions to call, overall dispatch was a failure.
         success = false;
         break;
     }
 
-    // If we were unable to process the string, and there's a TTY attached to us,
-    //      trigger the state machine to flush the string to the terminal.
-    if (_pfnFlushToTerminal != nullptr && !success)
-    {
-        success = _pfnFlushToTerminal();
-    }
+    success = _PassThroughSequence(success, false);
 
     _ClearLastChar();
 
@@ -1059,13 +1106,123 @@ CATCH_LOG_RETURN_FALSE()
 // - pfnFlushToTerminal: This is a callback to the underlying state machine to
 //      trigger it to call ActionPassThroughString with whatever sequence it's
 //      currently processing.
+// - pfnFlushExecuteToTerminal: The same for the control character that's
+//      currently being executed. It's only used in passthrough mode.
 // Return Value:
 // - <none>
 void OutputStateMachineEngine::SetTerminalConnection(ITerminalOutputConnection* const pTtyConnection,
-                                                     std::function<bool()> pfnFlushToTerminal)
+                                                     std::function<bool()> pfnFlushToTerminal,
+                                                     std::function<bool()> pfnFlushExecuteToTerminal)
 {
     this->_pTtyConnection = pTtyConnection;
     this->_pfnFlushToTerminal = pfnFlushToTerminal;
+    this->_pfnFlushExecuteToTerminal = pfnFlushExecuteToTerminal;
+}
+
+// Routine Description:
+// - Returns true if the terminal we're attached to is in passthrough mode: it's
+//      sent what we process as well, instead of us repainting what changed.
+// Arguments:
+// - <none>
+// Return Value:
+// - true iff everything we process should be passed through to the terminal.
+bool OutputStateMachineEngine::_IsPassthroughActive() const noexcept
+{
+    return _pTtyConnection != nullptr &&
+           _pfnFlushToTerminal != nullptr &&
+           _pfnFlushExecuteToTerminal != nullptr &&
+           _pTtyConnection->IsPassthroughActive();
+}
+
+// Routine Description:
+// - Finishes a dispatch by passing the sequence through to the terminal if needed.
+//      If we were unable to process the sequence and there's a TTY attached to us,
+//      it's flushed to the terminal to deal with. In passthrough mode, it's flushed
+//      even if we did process it, so that the terminal does the same. Queries
+//      are the exception, as we've already answered them ourselves.
+// Arguments:
+// - success - whether we processed the sequence
+// - isQuery - whether the sequence asked for a response
+// Return Value:
+// - true iff we or the terminal successfully handled the sequence.
+bool OutputStateMachineEngine::_PassThroughSequence(const bool success, const bool isQuery)
+{
+    if (_pfnFlushToTerminal != nullptr && !success)
+    {
+        return _pfnFlushToTerminal();
+    }
+
+    if (success && !isQuery && _IsPassthroughActive())
+    {
+        // The sequence is ours either way, so failing to pass it on isn't a failure to dispatch it.
+        _pfnFlushToTerminal();
+    }
+
+    return success;
+}
+
+// Routine Description:
+// - Passes the DCS sequence that was just dispatched through to the terminal,
+//      and returns the handler that streams its data string after it. The data
+//      is sent in chunks as it arrives, rather than collected until the end of
+//      the string, so a large string (like an image) isn't held in memory.
+// Arguments:
+// - <none>
+// Return Value:
+// - the data string handler function
+IStateMachineEngine::StringHandler OutputStateMachineEngine::_PassThroughDcsString()
+{
+    // This sends the introducer of the sequence, which is all of it so far.
+    _pfnFlushToTerminal();
+    _dcsPassThroughBuffer.clear();
+
+    return [this](const auto wch) {
+        static constexpr size_t chunkSize = 4096;
+
+        // The string ends with an ESC, due to an ST or another sequence that cancels it.
+        if (wch == AsciiChars::ESC)
+        {
+            // In passthrough mode, whatever ended the string is passed through on its own.
+            if (!_IsPassthroughActive())
+            {
+                _dcsPassThroughBuffer.append(L"\x1b\\");
+            }
+            ActionPassThroughString(_dcsPassThroughBuffer);
+            _dcsPassThroughBuffer.clear();
+            return true;
+        }
+
+        _dcsPassThroughBuffer.push_back(wch);
+        if (_dcsPassThroughBuffer.size() >= chunkSize)
+        {
+            ActionPassThroughString(_dcsPassThroughBuffer);
+            _dcsPassThroughBuffer.clear();
+        }
+        return true;
+    };
+}
+
+// Routine Description:
+// - Returns true for the control sequences that ask for a response, which
+//      we've sent already, so the terminal mustn't send another one.
+// Arguments:
+// - id - Identifier of the control sequence.
+// Return Value:
+// - true iff the sequence is a query.
+bool OutputStateMachineEngine::_IsQuery(const VTID id) noexcept
+{
+    switch (id)
+    {
+    case CsiActionCodes::DSR_DeviceStatusReport:
+    case CsiActionCodes::DA_DeviceAttributes:
+    case CsiActionCodes::DA2_SecondaryDeviceAttributes:
+    case CsiActionCodes::DA3_TertiaryDeviceAttributes:
+    case CsiActionCodes::DECREQTPARM_RequestTerminalParameters:
+    case CsiActionCodes::DTTERM_WindowManipulation:
+        return true;
+    default:
+        return false;
+    }
 }
 
 // Routine Description:
@@ -39,12 +39,14 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool ActionCsiDispatch(const VTID id, const VTParameters parameters) override;
 
-        StringHandler ActionDcsDispatch(const VTID id, const VTParameters parameters) noexcept override;
+        StringHandler ActionDcsDispatch(const VTID id, const VTParameters parameters) override;
 
         bool ActionClear() noexcept override;
 
         bool ActionIgnore() noexcept override;
 
+        bool ActionEndOfString() override;
+
         bool ActionOscDispatch(const wchar_t wch,
                                const size_t parameter,
                                const std::wstring_view string) override;
@@ -57,7 +59,8 @@ namespace Microsoft::Console::VirtualTerminal
         bool DispatchIntermediatesFromEscape() const noexcept override;
 
         void SetTerminalConnection(Microsoft::Console::ITerminalOutputConnection* const pTtyConnection,
-                                   std::function<bool()> pfnFlushToTerminal);
+                                   std::function<bool()> pfnFlushToTerminal,
+                                   std::function<bool()> pfnFlushExecuteToTerminal);
 
         const ITermDispatch& Dispatch() const noexcept;
         ITermDispatch& Dispatch() noexcept;
@@ -66,7 +69,9 @@ namespace Microsoft::Console::VirtualTerminal
         std::unique_ptr<ITermDispatch> _dispatch;
         Microsoft::Console::ITerminalOutputConnection* _pTtyConnection;
         std::function<bool()> _pfnFlushToTerminal;
+        std::function<bool()> _pfnFlushExecuteToTerminal;
         wchar_t _lastPrintedChar;
+        std::wstring _dcsPassThroughBuffer;
 
         enum EscActionCodes : uint64_t
         {
@@ -144,6 +149,11 @@ namespace Microsoft::Console::VirtualTerminal
             DECSCPP_SetColumnsPerPage = VTID("$|"),
         };
 
+        enum DcsActionCodes : uint64_t
+        {
+            DECSIXEL_DefineImage = VTID("q"),
+        };
+
         enum Vt52ActionCodes : uint64_t
         {
             CursorUp = VTID("A"),
@@ -176,6 +186,7 @@ namespace Microsoft::Console::VirtualTerminal
             SetBackgroundColor = 11,
             SetCursorColor = 12,
             SetClipboard = 52,
+            FinalTermAction = 133,
             ResetForegroundColor = 110, // Not implemented
             ResetBackgroundColor = 111, // Not implemented
             ResetCursorColor = 112
@@ -201,5 +212,10 @@ namespace Microsoft::Console::VirtualTerminal
                              std::wstring& uri) const;
 
         void _ClearLastChar() noexcept;
+
+        bool _IsPassthroughActive() const noexcept;
+        bool _PassThroughSequence(const bool success, const bool isQuery);
+        StringHandler _PassThroughDcsString();
+        static bool _IsQuery(const VTID id) noexcept;
     };
 }
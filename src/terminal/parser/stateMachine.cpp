@@ -7,6 +7,10 @@
 
 #include "ascii.hpp"
 
+#if defined(_M_IX86) || defined(_M_AMD64)
+#include <emmintrin.h>
+#endif
+
 using namespace Microsoft::Console::VirtualTerminal;
 
 //Takes ownership of the pEngine.
@@ -18,6 +22,9 @@ StateMachine::StateMachine(std::unique_ptr<IStateMachineEngine> engine) :
     _parameters{},
     _parameterLimitReached(false),
     _oscString{},
+    _maxStringLength(MAX_STRING_LENGTH),
+    _stringLength(0),
+    _stringLimitReached(false),
     _cachedSequence{ std::nullopt },
     _processingIndividually(false)
 {
@@ -29,6 +36,19 @@ void StateMachine::SetAnsiMode(bool ansiMode) noexcept
     _isInAnsiMode = ansiMode;
 }
 
+// Routine Description:
+// - Sets the maximum length of OSC strings. An OSC string that exceeds it
+//   isn't dispatched. DCS strings aren't limited, as they are streamed to their
+//   handlers instead of being collected, and the handlers bound what they keep.
+// Arguments:
+// - length - The maximum number of characters in a string
+// Return Value:
+// - <none>
+void StateMachine::SetMaxStringLength(const size_t length) noexcept
+{
+    _maxStringLength = length;
+}
+
 const IStateMachineEngine& StateMachine::Engine() const noexcept
 {
     return *_engine;
@@ -188,30 +208,6 @@ static constexpr bool _isCsiInvalid(const wchar_t wch) noexcept
     return wch == L':'; // 0x3A
 }
 
-// Routine Description:
-// - Determines if a character is an invalid intermediate.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-static constexpr bool _isIntermediateInvalid(const wchar_t wch) noexcept
-{
-    // 0x30 - 0x3F
-    return _isNumericParamValue(wch) || _isCsiInvalid(wch) || _isParameterDelimiter(wch) || _isCsiPrivateMarker(wch);
-}
-
-// Routine Description:
-// - Determines if a character is an invalid parameter.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-static constexpr bool _isParameterInvalid(const wchar_t wch) noexcept
-{
-    // 0x3A, 0x3C - 0x3F
-    return _isCsiInvalid(wch) || _isCsiPrivateMarker(wch);
-}
-
 // Routine Description:
 // - Determines if a character is a string terminator indicator.
 // Arguments:
@@ -262,32 +258,6 @@ static constexpr bool _isOscIndicator(const wchar_t wch) noexcept
     return wch == L']'; // 0x5D
 }
 
-// Routine Description:
-// - Determines if a character is a delimiter between two parameters in a "operating system control sequence"
-//   This occurs in the middle of a control sequence after escape and OscIndicator have been recognized,
-//   after the parameter indicating which OSC action to take.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-static constexpr bool _isOscDelimiter(const wchar_t wch) noexcept
-{
-    return wch == L';'; // 0x3B
-}
-
-// Routine Description:
-// - Determines if a character should be ignored in a operating system control sequence
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-static constexpr bool _isOscInvalid(const wchar_t wch) noexcept
-{
-    return wch <= L'\x17' ||
-           wch == L'\x19' ||
-           (wch >= L'\x1c' && wch <= L'\x1f');
-}
-
 // Routine Description:
 // - Determines if a character is "operating system control string" termination indicator.
 //   This signals the end of an OSC string collection.
@@ -312,18 +282,6 @@ static constexpr bool _isDcsIndicator(const wchar_t wch) noexcept
     return wch == L'P'; // 0x50
 }
 
-// Routine Description:
-// - Determines if a character is valid for a DCS pass through sequence.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-static constexpr bool _isDcsPassThroughValid(const wchar_t wch) noexcept
-{
-    // 0x20 - 0x7E
-    return wch >= AsciiChars::SPC && wch < AsciiChars::DEL;
-}
-
 // Routine Description:
 // - Determines if a character is "start of string" beginning
 //      indicator.
@@ -372,8 +330,440 @@ static constexpr bool _isActionableFromGround(const wchar_t wch) noexcept
     return (wch <= AsciiChars::US) || _isC1ControlCharacter(wch) || _isDelete(wch);
 }
 
+// Routine Description:
+// - Finds the next character that is actionable from the ground state, see _isActionableFromGround.
+// - Looks at 8 characters at a time where SSE2 is available, as most of the
+//   text in ground state is long runs of printable characters.
+// Arguments:
+// - string - the text to search
+// - offset - where to start searching
+// Return Value:
+// - The offset of the next actionable character, or the size of the string if there is none.
+static size_t _findActionableFromGround(const std::wstring_view string, size_t offset) noexcept
+{
+#if defined(_M_IX86) || defined(_M_AMD64)
+    // A character is actionable if it's <= US, or if it's DEL or a C1 control character,
+    // both of which are in [DEL, DEL + 0x20]. SSE2 only offers signed 16-bit comparisons,
+    // so these are done by checking whether the saturated difference is 0.
+    const auto lastC0 = _mm_set1_epi16(AsciiChars::US);
+    const auto del = _mm_set1_epi16(AsciiChars::DEL);
+    const auto c1Range = _mm_set1_epi16(L'\x9F' - AsciiChars::DEL);
+    const auto zero = _mm_setzero_si128();
+    for (; offset + 8 <= string.size(); offset += 8)
+    {
+        const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(string.data() + offset));
+        const auto c0 = _mm_cmpeq_epi16(_mm_subs_epu16(chars, lastC0), zero);
+        const auto c1 = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(chars, del), c1Range), zero);
+        const auto mask = gsl::narrow_cast<unsigned long>(_mm_movemask_epi8(_mm_or_si128(c0, c1)));
+        if (mask != 0)
+        {
+            // Every character has two bits in the mask.
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            return offset + bit / 2;
+        }
+    }
+#endif
+    for (; offset < string.size(); ++offset)
+    {
+        if (_isActionableFromGround(til::at(string, offset)))
+        {
+            break;
+        }
+    }
+    return offset;
+}
+
+// Routine Description:
+// - Finds the next byte of a UTF-8 string that might be actionable from the ground
+//   state. These are the C0 control characters, DEL, and the lead byte 0xC2 of the
+//   C1 control characters. The latter is shared with some printable characters,
+//   which are simply printed one by one.
+// Arguments:
+// - string - The string to search.
+// - offset - The offset to start searching at.
+// Return Value:
+// - The offset of the next actionable byte, or the size of the string if there isn't any.
+static size_t _findActionableFromGroundUtf8(const std::string_view string, size_t offset) noexcept
+{
+#if defined(_M_IX86) || defined(_M_AMD64)
+    // SSE2 only offers signed 8-bit comparisons, so the C0 range is
+    // found by checking whether the saturated difference is 0.
+    const auto lastC0 = _mm_set1_epi8(static_cast<char>(AsciiChars::US));
+    const auto del = _mm_set1_epi8(static_cast<char>(AsciiChars::DEL));
+    const auto c1Lead = _mm_set1_epi8(static_cast<char>(0xC2));
+    const auto zero = _mm_setzero_si128();
+    for (; offset + 16 <= string.size(); offset += 16)
+    {
+        const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(string.data() + offset));
+        const auto c0 = _mm_cmpeq_epi8(_mm_subs_epu8(bytes, lastC0), zero);
+        const auto other = _mm_or_si128(_mm_cmpeq_epi8(bytes, del), _mm_cmpeq_epi8(bytes, c1Lead));
+        const auto mask = gsl::narrow_cast<unsigned long>(_mm_movemask_epi8(_mm_or_si128(c0, other)));
+        if (mask != 0)
+        {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            return offset + bit;
+        }
+    }
+#endif
+    for (; offset < string.size(); ++offset)
+    {
+        const auto byte = static_cast<unsigned char>(til::at(string, offset));
+        if (byte <= AsciiChars::US || byte == AsciiChars::DEL || byte == 0xC2)
+        {
+            break;
+        }
+    }
+    return offset;
+}
+
 #pragma warning(pop)
 
+// Routine Description:
+// - Builds the table of the classes of the ASCII characters, see CharClass.
+// Arguments:
+// - <none>
+// Return Value:
+// - The class of every character from NUL to DEL.
+constexpr StateMachine::CharClassTable StateMachine::_BuildCharClasses() noexcept
+{
+    CharClassTable classes{};
+    for (size_t i = 0; i < classes.size(); ++i)
+    {
+        const auto wch = static_cast<wchar_t>(i);
+        auto& cls = classes[i];
+        if (_isOscTerminator(wch))
+        {
+            cls = CharClass::Bell;
+        }
+        else if (wch == AsciiChars::CAN || wch == AsciiChars::SUB)
+        {
+            cls = CharClass::CancelOrSubstitute;
+        }
+        else if (_isEscape(wch))
+        {
+            cls = CharClass::Escape;
+        }
+        else if (_isC0Code(wch))
+        {
+            cls = CharClass::C0;
+        }
+        else if (_isIntermediate(wch))
+        {
+            cls = CharClass::Intermediate;
+        }
+        else if (_isNumericParamValue(wch))
+        {
+            cls = CharClass::Digit;
+        }
+        else if (_isCsiInvalid(wch))
+        {
+            cls = CharClass::Colon;
+        }
+        else if (_isParameterDelimiter(wch))
+        {
+            cls = CharClass::Semicolon;
+        }
+        else if (_isCsiPrivateMarker(wch))
+        {
+            cls = CharClass::PrivateMarker;
+        }
+        else if (_isCsiIndicator(wch))
+        {
+            cls = CharClass::CsiIndicator;
+        }
+        else if (_isOscIndicator(wch))
+        {
+            cls = CharClass::OscIndicator;
+        }
+        else if (_isSs3Indicator(wch))
+        {
+            cls = CharClass::Ss3Indicator;
+        }
+        else if (_isDcsIndicator(wch))
+        {
+            cls = CharClass::DcsIndicator;
+        }
+        else if (_isSosIndicator(wch) || _isPmIndicator(wch) || _isApcIndicator(wch))
+        {
+            cls = CharClass::SosPmApcIndicator;
+        }
+        else if (_isVt52CursorAddress(wch))
+        {
+            cls = CharClass::Vt52CursorAddress;
+        }
+        else if (_isStringTerminatorIndicator(wch))
+        {
+            cls = CharClass::StringTerminator;
+        }
+        else if (_isDelete(wch))
+        {
+            cls = CharClass::Delete;
+        }
+        else
+        {
+            cls = CharClass::Final;
+        }
+    }
+    return classes;
+}
+
+// Routine Description:
+// - Builds the transition table of the state machine: the action and the next
+//   state for every state and every character class. This follows the DEC ANSI
+//   parser model at http://vt100.net/emu/dec_ansi_parser, with the differences
+//   noted for the states that have them.
+// Arguments:
+// - <none>
+// Return Value:
+// - The transitions, indexed by the row of the state and the character class.
+constexpr StateMachine::TransitionTable StateMachine::_BuildTransitions() noexcept
+{
+    TransitionTable table{};
+
+    // Every row starts out with the transition of the characters that aren't
+    // mentioned specifically, which the other ones then overwrite.
+    const auto fill = [&](const size_t row, const Action action, const VTStates next) {
+        for (auto& transition : table[row])
+        {
+            transition = { action, next };
+        }
+    };
+    const auto set = [&](const size_t row, const std::initializer_list<CharClass> classes, const Action action, const VTStates next) {
+        for (const auto cls : classes)
+        {
+            table[row][static_cast<size_t>(cls)] = { action, next };
+        }
+    };
+    const auto rowOf = [](const VTStates state) {
+        return static_cast<size_t>(state);
+    };
+
+    const std::initializer_list<CharClass> c0{ CharClass::C0, CharClass::Bell };
+    const std::initializer_list<CharClass> param{ CharClass::Digit, CharClass::Semicolon };
+    const std::initializer_list<CharClass> intermediateInvalid{ CharClass::Digit, CharClass::Colon, CharClass::Semicolon, CharClass::PrivateMarker };
+    const std::initializer_list<CharClass> parameterInvalid{ CharClass::Colon, CharClass::PrivateMarker };
+
+    // Ground: execute C0 control characters and DEL, print everything else.
+    {
+        const auto row = rowOf(VTStates::Ground);
+        fill(row, Action::Print, VTStates::Ground);
+        set(row, c0, Action::Execute, VTStates::Ground);
+        set(row, { CharClass::Delete }, Action::Execute, VTStates::Ground);
+    }
+
+    // Escape: C0 control characters and intermediates depend on the engine.
+    // In ANSI mode, the indicators start their sequences and anything else is
+    // an escape sequence. In VT52 mode, Y starts a cursor address and anything
+    // else is a VT52 escape sequence.
+    for (const auto row : { rowOf(VTStates::Escape), s_vt52EscapeRow })
+    {
+        if (row == s_vt52EscapeRow)
+        {
+            fill(row, Action::Vt52EscDispatch, VTStates::Ground);
+            set(row, { CharClass::Vt52CursorAddress }, Action::None, VTStates::Vt52Param);
+        }
+        else
+        {
+            fill(row, Action::EscDispatch, VTStates::Ground);
+            set(row, { CharClass::CsiIndicator }, Action::None, VTStates::CsiEntry);
+            set(row, { CharClass::OscIndicator }, Action::None, VTStates::OscParam);
+            set(row, { CharClass::Ss3Indicator }, Action::EscapeSs3, VTStates::Escape);
+            set(row, { CharClass::DcsIndicator }, Action::None, VTStates::DcsEntry);
+            set(row, { CharClass::SosPmApcIndicator }, Action::None, VTStates::SosPmApcString);
+        }
+        set(row, c0, Action::EscapeControl, VTStates::Escape);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::Escape);
+        set(row, { CharClass::Intermediate }, Action::EscapeIntermediate, VTStates::Escape);
+    }
+
+    // EscapeIntermediate: collect intermediates until the final character.
+    for (const auto row : { rowOf(VTStates::EscapeIntermediate), s_vt52EscapeIntermediateRow })
+    {
+        if (row == s_vt52EscapeIntermediateRow)
+        {
+            fill(row, Action::Vt52EscDispatch, VTStates::Ground);
+            set(row, { CharClass::Vt52CursorAddress }, Action::None, VTStates::Vt52Param);
+        }
+        else
+        {
+            fill(row, Action::EscDispatch, VTStates::Ground);
+        }
+        set(row, c0, Action::Execute, VTStates::EscapeIntermediate);
+        set(row, { CharClass::Intermediate }, Action::Collect, VTStates::EscapeIntermediate);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::EscapeIntermediate);
+    }
+
+    // CsiEntry: the first character after the CSI may be a private marker.
+    {
+        const auto row = rowOf(VTStates::CsiEntry);
+        fill(row, Action::CsiDispatch, VTStates::Ground);
+        set(row, c0, Action::Execute, VTStates::CsiEntry);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::CsiEntry);
+        set(row, { CharClass::Intermediate }, Action::Collect, VTStates::CsiIntermediate);
+        set(row, { CharClass::Colon }, Action::None, VTStates::CsiIgnore);
+        set(row, param, Action::Param, VTStates::CsiParam);
+        set(row, { CharClass::PrivateMarker }, Action::Collect, VTStates::CsiParam);
+    }
+
+    // CsiIntermediate: parameters can't follow intermediates.
+    {
+        const auto row = rowOf(VTStates::CsiIntermediate);
+        fill(row, Action::CsiDispatch, VTStates::Ground);
+        set(row, c0, Action::Execute, VTStates::CsiIntermediate);
+        set(row, { CharClass::Intermediate }, Action::Collect, VTStates::CsiIntermediate);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::CsiIntermediate);
+        set(row, intermediateInvalid, Action::None, VTStates::CsiIgnore);
+    }
+
+    // CsiIgnore: ignore everything up to the final character.
+    {
+        const auto row = rowOf(VTStates::CsiIgnore);
+        fill(row, Action::None, VTStates::Ground);
+        set(row, c0, Action::Execute, VTStates::CsiIgnore);
+        set(row, { CharClass::Delete, CharClass::Intermediate }, Action::Ignore, VTStates::CsiIgnore);
+        set(row, intermediateInvalid, Action::Ignore, VTStates::CsiIgnore);
+    }
+
+    // CsiParam: collect the parameters.
+    {
+        const auto row = rowOf(VTStates::CsiParam);
+        fill(row, Action::CsiDispatch, VTStates::Ground);
+        set(row, c0, Action::Execute, VTStates::CsiParam);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::CsiParam);
+        set(row, param, Action::Param, VTStates::CsiParam);
+        set(row, { CharClass::Intermediate }, Action::Collect, VTStates::CsiIntermediate);
+        set(row, parameterInvalid, Action::None, VTStates::CsiIgnore);
+    }
+
+    // OscParam: collect the numeric parameter up to the semicolon.
+    // A BEL without a string aborts the sequence.
+    {
+        const auto row = rowOf(VTStates::OscParam);
+        fill(row, Action::Ignore, VTStates::OscParam);
+        set(row, { CharClass::Bell }, Action::None, VTStates::Ground);
+        set(row, { CharClass::Digit }, Action::OscParam, VTStates::OscParam);
+        set(row, { CharClass::Semicolon }, Action::None, VTStates::OscString);
+    }
+
+    // OscString: collect the string up to BEL or ST. ESC reaches this state
+    // (see ProcessCharacter), as the start of ST.
+    {
+        const auto row = rowOf(VTStates::OscString);
+        fill(row, Action::OscPut, VTStates::OscString);
+        set(row, { CharClass::Bell }, Action::OscDispatch, VTStates::Ground);
+        set(row, { CharClass::Escape }, Action::None, VTStates::OscTermination);
+        set(row, { CharClass::C0 }, Action::Ignore, VTStates::OscString);
+    }
+
+    // OscTermination: an ESC that isn't followed by a backslash starts an escape sequence.
+    {
+        const auto row = rowOf(VTStates::OscTermination);
+        fill(row, Action::ReprocessAsEscape, VTStates::OscTermination);
+        set(row, { CharClass::StringTerminator }, Action::OscDispatch, VTStates::Ground);
+    }
+
+    // Ss3Entry and Ss3Param: these follow CSI, but without intermediates.
+    // Invalid characters go to CsiIgnore, which ignores characters the same way.
+    {
+        const auto row = rowOf(VTStates::Ss3Entry);
+        fill(row, Action::Ss3Dispatch, VTStates::Ground);
+        set(row, c0, Action::Execute, VTStates::Ss3Entry);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::Ss3Entry);
+        set(row, { CharClass::Colon }, Action::None, VTStates::CsiIgnore);
+        set(row, param, Action::Param, VTStates::Ss3Param);
+    }
+    {
+        const auto row = rowOf(VTStates::Ss3Param);
+        fill(row, Action::Ss3Dispatch, VTStates::Ground);
+        set(row, c0, Action::Execute, VTStates::Ss3Param);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::Ss3Param);
+        set(row, param, Action::Param, VTStates::Ss3Param);
+        set(row, parameterInvalid, Action::None, VTStates::CsiIgnore);
+    }
+
+    // Vt52Param: the two characters after ESC Y are the parameters.
+    {
+        const auto row = rowOf(VTStates::Vt52Param);
+        fill(row, Action::Vt52Param, VTStates::Vt52Param);
+        set(row, c0, Action::Execute, VTStates::Vt52Param);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::Vt52Param);
+    }
+
+    // DcsEntry, DcsIntermediate and DcsParam: like their CSI counterparts,
+    // except that C0 control characters are ignored. The DcsDispatch action
+    // enters DcsPassThrough or DcsIgnore itself.
+    {
+        const auto row = rowOf(VTStates::DcsEntry);
+        fill(row, Action::DcsDispatch, VTStates::DcsEntry);
+        set(row, c0, Action::Ignore, VTStates::DcsEntry);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::DcsEntry);
+        set(row, { CharClass::Colon }, Action::None, VTStates::DcsIgnore);
+        set(row, param, Action::Param, VTStates::DcsParam);
+        set(row, { CharClass::Intermediate }, Action::Collect, VTStates::DcsIntermediate);
+    }
+    {
+        const auto row = rowOf(VTStates::DcsIntermediate);
+        fill(row, Action::DcsDispatch, VTStates::DcsIntermediate);
+        set(row, c0, Action::Ignore, VTStates::DcsIntermediate);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::DcsIntermediate);
+        set(row, { CharClass::Intermediate }, Action::Collect, VTStates::DcsIntermediate);
+        set(row, intermediateInvalid, Action::None, VTStates::DcsIgnore);
+    }
+    {
+        const auto row = rowOf(VTStates::DcsParam);
+        fill(row, Action::DcsDispatch, VTStates::DcsParam);
+        set(row, c0, Action::Ignore, VTStates::DcsParam);
+        set(row, { CharClass::Delete }, Action::Ignore, VTStates::DcsParam);
+        set(row, param, Action::Param, VTStates::DcsParam);
+        set(row, { CharClass::Intermediate }, Action::Collect, VTStates::DcsIntermediate);
+        set(row, parameterInvalid, Action::None, VTStates::DcsIgnore);
+    }
+
+    // DcsIgnore: the whole data string is ignored.
+    fill(rowOf(VTStates::DcsIgnore), Action::Ignore, VTStates::DcsIgnore);
+
+    // DcsPassThrough: C0 control characters and printable ASCII are passed to the
+    // string handler. The termination is handled by ProcessCharacter when an ESC is seen.
+    {
+        const auto row = rowOf(VTStates::DcsPassThrough);
+        fill(row, Action::DcsPassThrough, VTStates::DcsPassThrough);
+        set(row, { CharClass::CancelOrSubstitute, CharClass::Escape, CharClass::Delete, CharClass::NonAscii }, Action::Ignore, VTStates::DcsPassThrough);
+    }
+
+    // SosPmApcString: the whole string is ignored.
+    // The termination is handled by ProcessCharacter when an ESC is seen.
+    fill(rowOf(VTStates::SosPmApcString), Action::Ignore, VTStates::SosPmApcString);
+
+    return table;
+}
+
+constexpr StateMachine::CharClassTable StateMachine::s_charClasses = StateMachine::_BuildCharClasses();
+constexpr StateMachine::TransitionTable StateMachine::s_transitions = StateMachine::_BuildTransitions();
+
+static constexpr std::array<std::wstring_view, 19> s_stateNames{
+    L"Ground",
+    L"Escape",
+    L"EscapeIntermediate",
+    L"CsiEntry",
+    L"CsiIntermediate",
+    L"CsiIgnore",
+    L"CsiParam",
+    L"OscParam",
+    L"OscString",
+    L"OscTermination",
+    L"Ss3Entry",
+    L"Ss3Param",
+    L"Vt52Param",
+    L"DcsEntry",
+    L"DcsIgnore",
+    L"DcsIntermediate",
+    L"DcsParam",
+    L"DcsPassThrough",
+    L"SosPmApcString",
+};
+
 // Routine Description:
 // - Triggers the Execute action to indicate that the listener should immediately respond to a C0 control character.
 // Arguments:
@@ -457,8 +847,7 @@ void StateMachine::_ActionVt52EscDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"Vt52EscDispatch");
 
-    const bool success = _engine->ActionVt52EscDispatch(_identifier.Finalize(wch),
-                                                        { _parameters.data(), _parameters.size() });
+    const bool success = _engine->ActionVt52EscDispatch(_identifier.Finalize(wch), _parameters);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -481,8 +870,7 @@ void StateMachine::_ActionCsiDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"CsiDispatch");
 
-    const bool success = _engine->ActionCsiDispatch(_identifier.Finalize(wch),
-                                                    { _parameters.data(), _parameters.size() });
+    const bool success = _engine->ActionCsiDispatch(_identifier.Finalize(wch), _parameters);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -574,8 +962,12 @@ void StateMachine::_ActionClear()
     _parameterLimitReached = false;
 
     _oscString.clear();
+    _oscSlice = {};
     _oscParameter = 0;
 
+    _stringLength = 0;
+    _stringLimitReached = false;
+
     _dcsStringHandler = nullptr;
 
     _engine->ActionClear();
@@ -634,7 +1026,61 @@ void StateMachine::_ActionOscPut(const wchar_t wch)
 {
     _trace.TraceOnAction(L"OscPut");
 
-    _oscString.push_back(wch);
+    _stringLimitReached = _stringLimitReached || ++_stringLength > _maxStringLength;
+    if (!_stringLimitReached)
+    {
+        _RetainOscString();
+        _oscString.push_back(wch);
+    }
+}
+
+// Routine Description:
+// - Adds a run of characters of the string passed to ProcessString to the OSC string.
+//   As long as the runs are adjacent, the OSC string stays a slice of that string.
+// Arguments:
+// - run - The characters to add
+// Return Value:
+// - <none>
+void StateMachine::_ActionOscPutRun(const std::wstring_view run)
+{
+    _trace.TraceOnAction(L"OscPut");
+
+    _stringLength += run.size();
+    _stringLimitReached = _stringLimitReached || _stringLength > _maxStringLength;
+    if (_stringLimitReached)
+    {
+        return;
+    }
+
+    if (_oscString.empty() && _oscSlice.empty())
+    {
+        _oscSlice = run;
+    }
+    else if (!_oscSlice.empty() && _oscSlice.data() + _oscSlice.size() == run.data())
+    {
+        _oscSlice = { _oscSlice.data(), _oscSlice.size() + run.size() };
+    }
+    else
+    {
+        _RetainOscString();
+        _oscString.append(run);
+    }
+}
+
+// Routine Description:
+// - Copies the OSC string into _oscString if it's a slice of the string passed
+//   to ProcessString, because it's about to be added to or that string is about to go away.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void StateMachine::_RetainOscString()
+{
+    if (!_oscSlice.empty())
+    {
+        _oscString.assign(_oscSlice);
+        _oscSlice = {};
+    }
 }
 
 // Routine Description:
@@ -648,7 +1094,14 @@ void StateMachine::_ActionOscDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"OscDispatch");
 
-    const bool success = _engine->ActionOscDispatch(wch, _oscParameter, _oscString);
+    // Strings that exceeded the limit were only partially collected.
+    if (_stringLimitReached)
+    {
+        _trace.DispatchSequenceTrace(false);
+        return;
+    }
+
+    const bool success = _engine->ActionOscDispatch(wch, _oscParameter, _oscSlice.empty() ? std::wstring_view{ _oscString } : _oscSlice);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -671,7 +1124,7 @@ void StateMachine::_ActionSs3Dispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"Ss3Dispatch");
 
-    const bool success = _engine->ActionSs3Dispatch(wch, { _parameters.data(), _parameters.size() });
+    const bool success = _engine->ActionSs3Dispatch(wch, _parameters);
 
     // Trace the result.
     _trace.DispatchSequenceTrace(success);
@@ -694,8 +1147,7 @@ void StateMachine::_ActionDcsDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"DcsDispatch");
 
-    _dcsStringHandler = _engine->ActionDcsDispatch(_identifier.Finalize(wch),
-                                                   { _parameters.data(), _parameters.size() });
+    _dcsStringHandler = _engine->ActionDcsDispatch(_identifier.Finalize(wch), _parameters);
 
     // If the returned handler is null, the sequence is not supported.
     const bool success = _dcsStringHandler != nullptr;
@@ -999,45 +1451,115 @@ void StateMachine::_EnterSosPmApcString() noexcept
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the Ground state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Print all other characters
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventGround(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ground");
-    if (_isC0Code(wch) || _isDelete(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else
-    {
-        _ActionPrint(wch);
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the Escape state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Enter Control Sequence state
-//   5. Dispatch an Escape action.
-// Arguments:
+// - Sets the state machine to the given state, with whatever entering that state entails.
+// Arguments:
+// - state - The state to enter
+// Return Value:
+// - <none>
+void StateMachine::_EnterState(const VTStates state)
+{
+    switch (state)
+    {
+    case VTStates::Ground:
+        return _EnterGround();
+    case VTStates::Escape:
+        return _EnterEscape();
+    case VTStates::EscapeIntermediate:
+        return _EnterEscapeIntermediate();
+    case VTStates::CsiEntry:
+        return _EnterCsiEntry();
+    case VTStates::CsiIntermediate:
+        return _EnterCsiIntermediate();
+    case VTStates::CsiIgnore:
+        return _EnterCsiIgnore();
+    case VTStates::CsiParam:
+        return _EnterCsiParam();
+    case VTStates::OscParam:
+        return _EnterOscParam();
+    case VTStates::OscString:
+        return _EnterOscString();
+    case VTStates::OscTermination:
+        return _EnterOscTermination();
+    case VTStates::Ss3Entry:
+        return _EnterSs3Entry();
+    case VTStates::Ss3Param:
+        return _EnterSs3Param();
+    case VTStates::Vt52Param:
+        return _EnterVt52Param();
+    case VTStates::DcsEntry:
+        return _EnterDcsEntry();
+    case VTStates::DcsIgnore:
+        return _EnterDcsIgnore();
+    case VTStates::DcsIntermediate:
+        return _EnterDcsIntermediate();
+    case VTStates::DcsParam:
+        return _EnterDcsParam();
+    case VTStates::DcsPassThrough:
+        return _EnterDcsPassThrough();
+    case VTStates::SosPmApcString:
+        return _EnterSosPmApcString();
+    default:
+        return;
+    }
+}
+
+// Routine Description:
+// - Performs an action of the transition table for the given character.
+// Arguments:
+// - action - The action to perform
 // - wch - Character that triggered the event
 // Return Value:
 // - <none>
-void StateMachine::_EventEscape(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Escape");
-    if (_isC0Code(wch))
-    {
-        if (_engine->DispatchControlCharsFromEscape())
+void StateMachine::_PerformAction(const Action action, const wchar_t wch)
+{
+    switch (action)
+    {
+    case Action::None:
+        return;
+    case Action::Ignore:
+        return _ActionIgnore();
+    case Action::Execute:
+        return _ActionExecute(wch);
+    case Action::Print:
+        return _ActionPrint(wch);
+    case Action::Collect:
+        return _ActionCollect(wch);
+    case Action::Param:
+        return _ActionParam(wch);
+    case Action::EscDispatch:
+        return _ActionEscDispatch(wch);
+    case Action::Vt52EscDispatch:
+        return _ActionVt52EscDispatch(wch);
+    case Action::CsiDispatch:
+        return _ActionCsiDispatch(wch);
+    case Action::OscParam:
+        return _ActionOscParam(wch);
+    case Action::OscPut:
+        return _ActionOscPut(wch);
+    case Action::OscDispatch:
+        return _ActionOscDispatch(wch);
+    case Action::Ss3Dispatch:
+        return _ActionSs3Dispatch(wch);
+    case Action::DcsDispatch:
+        return _ActionDcsDispatch(wch);
+    case Action::DcsPassThrough:
+        if (!_dcsStringHandler(wch))
+        {
+            _EnterDcsIgnore();
+        }
+        return;
+    case Action::Vt52Param:
+        _parameters.push_back(wch);
+        if (_parameters.size() == 2)
+        {
+            // The command character is processed before the parameter values,
+            // but it will always be 'Y', the Direct Cursor Address command.
+            _ActionVt52EscDispatch(L'Y');
+            _EnterGround();
+        }
+        return;
+    case Action::EscapeControl:
+        if (_engine->DispatchControlCharsFromEscape())
         {
             _ActionExecuteFromEscape(wch);
             _EnterGround();
@@ -1046,13 +1568,8 @@ void StateMachine::_EventEscape(const wchar_t wch)
         {
             _ActionExecute(wch);
         }
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
+        return;
+    case Action::EscapeIntermediate:
         if (_engine->DispatchIntermediatesFromEscape())
         {
             _ActionEscDispatch(wch);
@@ -1063,646 +1580,60 @@ void StateMachine::_EventEscape(const wchar_t wch)
             _ActionCollect(wch);
             _EnterEscapeIntermediate();
         }
-    }
-    else if (_isInAnsiMode)
-    {
-        if (_isCsiIndicator(wch))
-        {
-            _EnterCsiEntry();
-        }
-        else if (_isOscIndicator(wch))
-        {
-            _EnterOscParam();
-        }
-        else if (_isSs3Indicator(wch) && _engine->ParseControlSequenceAfterSs3())
+        return;
+    case Action::EscapeSs3:
+        if (_engine->ParseControlSequenceAfterSs3())
         {
             _EnterSs3Entry();
         }
-        else if (_isDcsIndicator(wch))
-        {
-            _EnterDcsEntry();
-        }
-        else if (_isSosIndicator(wch) || _isPmIndicator(wch) || _isApcIndicator(wch))
-        {
-            _EnterSosPmApcString();
-        }
         else
         {
             _ActionEscDispatch(wch);
             _EnterGround();
         }
-    }
-    else if (_isVt52CursorAddress(wch))
-    {
-        _EnterVt52Param();
-    }
-    else
-    {
-        _ActionVt52EscDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the EscapeIntermediate state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Dispatch an Escape action.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventEscapeIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"EscapeIntermediate");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isInAnsiMode)
-    {
-        _ActionEscDispatch(wch);
-        _EnterGround();
-    }
-    else if (_isVt52CursorAddress(wch))
-    {
-        _EnterVt52Param();
-    }
-    else
-    {
-        _ActionVt52EscDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiEntry state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Store parameter data
-//   6. Collect Control Sequence Private markers
-//   7. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiEntry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiEntry");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiIntermediate();
-    }
-    else if (_isCsiInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterCsiParam();
-    }
-    else if (_isCsiPrivateMarker(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiParam();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiIntermediate state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiIntermediate");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiIgnore state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Return to Ground
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiIgnore(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiIgnore");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiParam state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Store parameter data
-//   6. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiParam(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiParam");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiIntermediate();
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the OscParam state.
-//   Events in this state will:
-//   1. Collect numeric values into an Osc Param
-//   2. Move to the OscString state on a delimiter
-//   3. Ignore everything else.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventOscParam(const wchar_t wch) noexcept
-{
-    _trace.TraceOnEvent(L"OscParam");
-    if (_isOscTerminator(wch))
-    {
-        _EnterGround();
-    }
-    else if (_isNumericParamValue(wch))
-    {
-        _ActionOscParam(wch);
-    }
-    else if (_isOscDelimiter(wch))
-    {
-        _EnterOscString();
-    }
-    else
-    {
-        _ActionIgnore();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into a Action that occurs while in the OscParam state.
-//   Events in this state will:
-//   1. Trigger the OSC action associated with the param on an OscTerminator
-//   2. If we see a ESC, enter the OscTermination state. We'll wait for one
-//      more character before we dispatch the string.
-//   3. Ignore OscInvalid characters.
-//   4. Collect everything else into the OscString
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventOscString(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"OscString");
-    if (_isOscTerminator(wch))
-    {
-        _ActionOscDispatch(wch);
-        _EnterGround();
-    }
-    else if (_isEscape(wch))
-    {
-        _EnterOscTermination();
-    }
-    else if (_isOscInvalid(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        // add this character to our OSC string
-        _ActionOscPut(wch);
-    }
-}
-
-// Routine Description:
-// - Handle the two-character termination of a OSC sequence.
-//   Events in this state will:
-//   1. Trigger the OSC action associated with the param on an OscTerminator
-//   2. Otherwise treat this as a normal escape character event.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventOscTermination(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"OscTermination");
-    if (_isStringTerminatorIndicator(wch))
-    {
-        _ActionOscDispatch(wch);
-        _EnterGround();
-    }
-    else
-    {
+        return;
+    case Action::ReprocessAsEscape:
         _EnterEscape();
-        _EventEscape(wch);
+        return _ProcessEvent(wch);
+    default:
+        return;
     }
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the Ss3Entry state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   4. Store parameter data
-//   5. Dispatch a control sequence with parameters for action
-//  SS3 sequences are structurally the same as CSI sequences, just with a
-//      different initiation. It's safe to reuse CSI's functions for
-//      determining if a character is a parameter, delimiter, or invalid.
+// - Processes a character event in the current state, by looking up its
+//   action and next state in the transition table (see _BuildTransitions).
 // Arguments:
 // - wch - Character that triggered the event
 // Return Value:
 // - <none>
-void StateMachine::_EventSs3Entry(const wchar_t wch)
+void StateMachine::_ProcessEvent(const wchar_t wch)
 {
-    _trace.TraceOnEvent(L"Ss3Entry");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isCsiInvalid(wch))
-    {
-        // It's safe for us to go into the CSI ignore here, because both SS3 and
-        //      CSI sequences ignore characters the same way.
-        _EnterCsiIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterSs3Param();
-    }
-    else
+    const auto state = _state;
+    auto row = static_cast<size_t>(state);
+    if (!_isInAnsiMode)
     {
-        _ActionSs3Dispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiParam state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   4. Store parameter data
-//   5. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventSs3Param(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ss3Param");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionSs3Dispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the Vt52Param state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Store exactly two parameter characters
-//   4. Dispatch a control sequence with parameters for action (always Direct Cursor Address)
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventVt52Param(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Vt52Param");
-    if (_isC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        _parameters.push_back(wch);
-        if (_parameters.size() == 2)
+        if (state == VTStates::Escape)
         {
-            // The command character is processed before the parameter values,
-            // but it will always be 'Y', the Direct Cursor Address command.
-            _ActionVt52EscDispatch(L'Y');
-            _EnterGround();
+            row = s_vt52EscapeRow;
         }
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsEntry state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining characters when an invalid character is detected (DcsIgnore)
-//   4. Store parameter data
-//   5. Collect Intermediate characters
-//   6. Dispatch the Final character in preparation for parsing the data string
-//  DCS sequences are structurally almost the same as CSI sequences, just with an
-//      extra data string. It's safe to reuse CSI functions for
-//      determining if a character is a parameter, delimiter, or invalid.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsEntry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsEntry");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isCsiInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterDcsParam();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterDcsIntermediate();
-    }
-    else
-    {
-        _ActionDcsDispatch(wch);
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsIgnore state.
-//   In this state the entire DCS string is considered invalid and we will ignore everything.
-//   The termination state is handled outside when an ESC is seen.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsIgnore() noexcept
-{
-    _trace.TraceOnEvent(L"DcsIgnore");
-    _ActionIgnore();
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsIntermediate state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect intermediate data.
-//   4. Begin to ignore all remaining intermediates when an invalid character is detected (DcsIgnore)
-//   5. Dispatch the Final character in preparation for parsing the data string
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsIntermediate");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-    }
-    else if (_isIntermediateInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else
-    {
-        _ActionDcsDispatch(wch);
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsParam state.
-//   Events in this state will:
-//   1. Ignore C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect DCS parameter data
-//   4. Enter DcsIntermediate if we see an intermediate
-//   5. Begin to ignore all remaining parameters when an invalid character is detected (DcsIgnore)
-//   6. Dispatch the Final character in preparation for parsing the data string
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsParam(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsParam");
-    if (_isC0Code(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (_isDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    if (_isNumericParamValue(wch) || _isParameterDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (_isIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterDcsIntermediate();
-    }
-    else if (_isParameterInvalid(wch))
-    {
-        _EnterDcsIgnore();
-    }
-    else
-    {
-        _ActionDcsDispatch(wch);
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the DcsPassThrough state.
-//   Events in this state will:
-//   1. Pass through if character is valid.
-//   2. Ignore everything else.
-//   The termination state is handled outside when an ESC is seen.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventDcsPassThrough(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"DcsPassThrough");
-    if (_isC0Code(wch) || _isDcsPassThroughValid(wch))
-    {
-        if (!_dcsStringHandler(wch))
+        else if (state == VTStates::EscapeIntermediate)
         {
-            _EnterDcsIgnore();
+            row = s_vt52EscapeIntermediateRow;
         }
     }
-    else
+    _trace.TraceOnEvent(til::at(s_stateNames, static_cast<size_t>(state)));
+
+    const auto cls = wch < s_charClasses.size() ? til::at(s_charClasses, wch) : CharClass::NonAscii;
+    const auto transition = til::at(til::at(s_transitions, row), static_cast<size_t>(cls));
+
+    _PerformAction(transition.action, wch);
+    if (transition.next != state)
     {
-        _ActionIgnore();
+        _EnterState(transition.next);
     }
 }
 
-// Routine Description:
-// - Handle SOS/PM/APC string.
-//   In this state the entire string is ignored.
-//   The termination state is handled outside when an ESC is seen.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventSosPmApcString(const wchar_t /*wch*/) noexcept
-{
-    _trace.TraceOnEvent(L"SosPmApcString");
-    _ActionIgnore();
-}
-
 // Routine Description:
 // - Entry to the state machine. Takes characters one by one and processes them according to the state machine rules.
 // Arguments:
@@ -1741,49 +1672,7 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
     else
     {
         // Then pass to the current state as an event
-        switch (_state)
-        {
-        case VTStates::Ground:
-            return _EventGround(wch);
-        case VTStates::Escape:
-            return _EventEscape(wch);
-        case VTStates::EscapeIntermediate:
-            return _EventEscapeIntermediate(wch);
-        case VTStates::CsiEntry:
-            return _EventCsiEntry(wch);
-        case VTStates::CsiIntermediate:
-            return _EventCsiIntermediate(wch);
-        case VTStates::CsiIgnore:
-            return _EventCsiIgnore(wch);
-        case VTStates::CsiParam:
-            return _EventCsiParam(wch);
-        case VTStates::OscParam:
-            return _EventOscParam(wch);
-        case VTStates::OscString:
-            return _EventOscString(wch);
-        case VTStates::OscTermination:
-            return _EventOscTermination(wch);
-        case VTStates::Ss3Entry:
-            return _EventSs3Entry(wch);
-        case VTStates::Ss3Param:
-            return _EventSs3Param(wch);
-        case VTStates::Vt52Param:
-            return _EventVt52Param(wch);
-        case VTStates::DcsEntry:
-            return _EventDcsEntry(wch);
-        case VTStates::DcsIgnore:
-            return _EventDcsIgnore();
-        case VTStates::DcsIntermediate:
-            return _EventDcsIntermediate(wch);
-        case VTStates::DcsParam:
-            return _EventDcsParam(wch);
-        case VTStates::DcsPassThrough:
-            return _EventDcsPassThrough(wch);
-        case VTStates::SosPmApcString:
-            return _EventSosPmApcString(wch);
-        default:
-            return;
-        }
+        _ProcessEvent(wch);
     }
 }
 // Method Description:
@@ -1793,8 +1682,8 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
 //      get handed to the OutputStateMachineEngine, so that it can write strings
 //      it doesn't understand to the tty.
 //  This does not modify the state of the state machine. Callers should be in
-//      the Action*Dispatch state, and upon completion, the state's handler (eg
-//      _EventCsiParam) should move us into the ground state.
+//      the Action*Dispatch state, and upon completion, the state's transition (eg
+//      CsiParam on a final character) should move us into the ground state.
 // Arguments:
 // - <none>
 // Return Value:
@@ -1824,6 +1713,20 @@ bool StateMachine::FlushToTerminal()
     return success;
 }
 
+// Routine Description:
+// - Like FlushToTerminal, but for the control character that's currently being
+//      executed. Outside of a sequence, that's all the _run is. A control
+//      character inside of a sequence is left alone, as it's part of the _run
+//      that FlushToTerminal passes through once the sequence is dispatched.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if the engine successfully handled the character, or if it was left alone.
+bool StateMachine::FlushExecuteToTerminal()
+{
+    return _state == VTStates::Ground ? FlushToTerminal() : true;
+}
+
 // Routine Description:
 // - Helper for entry to the state machine. Will take an array of characters
 //     and print as many as it can without encountering a character indicating
@@ -1847,6 +1750,20 @@ void StateMachine::ProcessString(const std::wstring_view string)
 
         if (_processingIndividually)
         {
+            // The characters of an OSC string are added as a run, which avoids copying
+            // them if the string is complete. Anything that isn't simply added to it
+            // (including DEL, which is) goes through ProcessCharacter.
+            if (_state == VTStates::OscString)
+            {
+                const auto end = _findActionableFromGround(string, current);
+                if (end > current)
+                {
+                    _ActionOscPutRun(string.substr(current, end - current));
+                    current = end;
+                    continue;
+                }
+            }
+
             // If we're processing characters individually, send it to the state machine.
             ProcessCharacter(string.at(current));
             ++current;
@@ -1855,17 +1772,23 @@ void StateMachine::ProcessString(const std::wstring_view string)
                 _processingIndividually = false;
                 start = current;
             }
+            else if (_state == VTStates::DcsPassThrough)
+            {
+                // The data of a DCS string went to its handler already, so it isn't part of
+                // the sequence that would be passed through or cached at the end of the string.
+                start = current;
+            }
         }
         else
         {
-            if (_isActionableFromGround(string.at(current))) // If the current char is the start of an escape sequence, or should be executed in ground state...
+            // Add all the printable chars to the current run, up to the start of an escape sequence
+            // or anything else that should be executed in ground state.
+            current = _findActionableFromGround(string, current);
+            if (current < string.size())
             {
-                if (!_run.empty())
+                if (current > start)
                 {
-                    // Because the _run above is composed INCLUDING current, we must
-                    // trim it off here since we just determined it's actionable
-                    // and only pass through everything before it.
-                    const auto allLeadingUpTo = _run.substr(0, _run.size() - 1);
+                    const auto allLeadingUpTo = string.substr(start, current - start);
 
                     _engine->ActionPrintString(allLeadingUpTo); // ... print all the chars leading up to it as part of the run...
                     _trace.DispatchPrintRunTrace(allLeadingUpTo);
@@ -1873,11 +1796,6 @@ void StateMachine::ProcessString(const std::wstring_view string)
 
                 _processingIndividually = true; // begin processing future characters individually...
                 start = current;
-                continue;
-            }
-            else
-            {
-                ++current; // Otherwise, add this char to the current run to be printed.
             }
         }
     }
@@ -1896,74 +1814,175 @@ void StateMachine::ProcessString(const std::wstring_view string)
     }
     else if (_processingIndividually)
     {
-        // One of the "weird things" in VT input is the case of something like
-        // <kbd>alt+[</kbd>. In VT, that's encoded as `\x1b[`. However, that's
-        // also the start of a CSI, and could be the start of a longer sequence,
-        // there's no way to know for sure. For an <kbd>alt+[</kbd> keypress,
-        // the parser originally would just sit in the `CsiEntry` state after
-        // processing it, which would pollute the following keypress (e.g.
-        // <kbd>alt+[</kbd>, <kbd>A</kbd> would be processed like `\x1b[A`,
-        // which is _wrong_).
-        //
-        // Fortunately, for VT input, each keystroke comes in as an individual
-        // write operation. So, if at the end of processing a string for the
-        // InputEngine, we find that we're not in the Ground state, that implies
-        // that we've processed some input, but not dispatched it yet. This
-        // block at the end of `ProcessString` will then re-process the
-        // undispatched string, but it will ensure that it dispatches on the
-        // last character of the string. For our previous `\x1b[` scenario, that
-        // means we'll make sure to call `_ActionEscDispatch('[')`., which will
-        // properly decode the string as <kbd>alt+[</kbd>.
-
-        if (_engine->FlushAtEndOfString())
+        // The string is about to go away, so the OSC string can't be a slice of it anymore.
+        _RetainOscString();
+        _EndStringWithinSequence();
+    }
+
+    _engine->ActionEndOfString();
+}
+
+// Routine Description:
+// - Helper for entry to the state machine, like the UTF-16 overload above.
+//   Escape sequences and control characters are parsed on the bytes directly,
+//   and only the runs of printable text are transcoded to UTF-16.
+//   A code point that is split between two calls is completed by the second one.
+// Arguments:
+// - string - UTF-8 encoded characters to operate upon
+// Return Value:
+// - <none>
+void StateMachine::ProcessString(const std::string_view string)
+{
+    // The sequence is accumulated as UTF-16 from its start, as the _run that
+    // FlushToTerminal would pass through. Like in the UTF-16 overload, the part
+    // of a sequence that was processed by a previous call isn't part of it.
+    _utf8Sequence.clear();
+
+    size_t offset = 0;
+    while (offset < string.size())
+    {
+        if (!_processingIndividually)
+        {
+            const auto end = _findActionableFromGroundUtf8(string, offset);
+            if (end > offset && SUCCEEDED(til::u8u16(string.substr(offset, end - offset), _utf16Buffer, _utf8State)) && !_utf16Buffer.empty())
+            {
+                _engine->ActionPrintString(_utf16Buffer);
+                _trace.DispatchPrintRunTrace(_utf16Buffer);
+            }
+            offset = end;
+            _processingIndividually = end < string.size();
+            continue;
+        }
+
+        const auto lead = til::at(string, offset);
+        if (static_cast<unsigned char>(lead) < 0x80)
         {
-            // Reset our state, and put all but the last char in again.
-            ResetState();
-            // Chars to flush are [pwchSequenceStart, pwchCurr)
-            auto wchIter = _run.cbegin();
-            while (wchIter < _run.cend() - 1)
+            _utf16Buffer.assign(1, static_cast<wchar_t>(lead));
+            ++offset;
+        }
+        else
+        {
+            // Transcode the lead byte together with its continuation bytes. If the code point
+            // is cut off at the end of the string, til::u8u16 keeps it in _utf8State until
+            // the continuation bytes of the next call complete it.
+            auto end = offset + 1;
+            while (end < string.size() && end - offset < 4 && (static_cast<unsigned char>(til::at(string, end)) & 0xC0) == 0x80)
             {
-                ProcessCharacter(*wchIter);
-                wchIter++;
+                ++end;
             }
-            // Manually execute the last char [pwchCurr]
-            switch (_state)
+            if (FAILED(til::u8u16(string.substr(offset, end - offset), _utf16Buffer, _utf8State)))
             {
-            case VTStates::Ground:
-                _ActionExecute(*wchIter);
-                break;
-            case VTStates::Escape:
-            case VTStates::EscapeIntermediate:
-                _ActionEscDispatch(*wchIter);
-                break;
-            case VTStates::CsiEntry:
-            case VTStates::CsiIntermediate:
-            case VTStates::CsiIgnore:
-            case VTStates::CsiParam:
-                _ActionCsiDispatch(*wchIter);
-                break;
-            case VTStates::OscParam:
-            case VTStates::OscString:
-            case VTStates::OscTermination:
-                _ActionOscDispatch(*wchIter);
-                break;
-            case VTStates::Ss3Entry:
-            case VTStates::Ss3Param:
-                _ActionSs3Dispatch(*wchIter);
-                break;
+                _utf16Buffer.clear();
             }
-            // microsoft/terminal#2746: Make sure to return to the ground state
-            // after dispatching the characters
-            _EnterGround();
+            offset = end;
         }
-        else
+
+        for (const auto wch : _utf16Buffer)
         {
-            // If the engine doesn't require flushing at the end of the string, we
-            // want to cache the partial sequence in case we have to flush the whole
-            // thing to the terminal later.
-            _cachedSequence = _cachedSequence.value_or(std::wstring{}) + std::wstring{ _run };
+            _utf8Sequence.push_back(wch);
+            _run = _utf8Sequence;
+            ProcessCharacter(wch);
+            if (_state == VTStates::Ground)
+            {
+                _processingIndividually = false;
+                _utf8Sequence.clear();
+            }
+            else if (_state == VTStates::DcsPassThrough)
+            {
+                // As above, the data of a DCS string is streamed to its handler instead.
+                _utf8Sequence.clear();
+            }
         }
     }
+
+    // The printable runs have all been printed already. A sequence that's still
+    // in progress is handled like at the end of the UTF-16 overload, unless nothing
+    // but the start of a code point has been seen since the last one.
+    _run = _utf8Sequence;
+    if (_processingIndividually && !_run.empty())
+    {
+        _EndStringWithinSequence();
+    }
+
+    _engine->ActionEndOfString();
+}
+
+// Routine Description:
+// - Handles the end of a string that ended within a sequence: the sequence is
+//   either dispatched right away or cached, depending on the engine.
+// Arguments:
+// - <none> - The sequence so far is the current _run.
+// Return Value:
+// - <none>
+void StateMachine::_EndStringWithinSequence()
+{
+    // One of the "weird things" in VT input is the case of something like
+    // <kbd>alt+[</kbd>. In VT, that's encoded as `\x1b[`. However, that's
+    // also the start of a CSI, and could be the start of a longer sequence,
+    // there's no way to know for sure. For an <kbd>alt+[</kbd> keypress,
+    // the parser originally would just sit in the `CsiEntry` state after
+    // processing it, which would pollute the following keypress (e.g.
+    // <kbd>alt+[</kbd>, <kbd>A</kbd> would be processed like `\x1b[A`,
+    // which is _wrong_).
+    //
+    // Fortunately, for VT input, each keystroke comes in as an individual
+    // write operation. So, if at the end of processing a string for the
+    // InputEngine, we find that we're not in the Ground state, that implies
+    // that we've processed some input, but not dispatched it yet. This
+    // block at the end of `ProcessString` will then re-process the
+    // undispatched string, but it will ensure that it dispatches on the
+    // last character of the string. For our previous `\x1b[` scenario, that
+    // means we'll make sure to call `_ActionEscDispatch('[')`., which will
+    // properly decode the string as <kbd>alt+[</kbd>.
+
+    if (_engine->FlushAtEndOfString())
+    {
+        // Reset our state, and put all but the last char in again.
+        ResetState();
+        // Chars to flush are [pwchSequenceStart, pwchCurr)
+        auto wchIter = _run.cbegin();
+        while (wchIter < _run.cend() - 1)
+        {
+            ProcessCharacter(*wchIter);
+            wchIter++;
+        }
+        // Manually execute the last char [pwchCurr]
+        switch (_state)
+        {
+        case VTStates::Ground:
+            _ActionExecute(*wchIter);
+            break;
+        case VTStates::Escape:
+        case VTStates::EscapeIntermediate:
+            _ActionEscDispatch(*wchIter);
+            break;
+        case VTStates::CsiEntry:
+        case VTStates::CsiIntermediate:
+        case VTStates::CsiIgnore:
+        case VTStates::CsiParam:
+            _ActionCsiDispatch(*wchIter);
+            break;
+        case VTStates::OscParam:
+        case VTStates::OscString:
+        case VTStates::OscTermination:
+            _ActionOscDispatch(*wchIter);
+            break;
+        case VTStates::Ss3Entry:
+        case VTStates::Ss3Param:
+            _ActionSs3Dispatch(*wchIter);
+            break;
+        }
+        // microsoft/terminal#2746: Make sure to return to the ground state
+        // after dispatching the characters
+        _EnterGround();
+    }
+    else
+    {
+        // If the engine doesn't require flushing at the end of the string, we
+        // want to cache the partial sequence in case we have to flush the whole
+        // thing to the terminal later.
+        _cachedSequence = _cachedSequence.value_or(std::wstring{}) + std::wstring{ _run };
+    }
 }
 
 // Routine Description:
@@ -17,6 +17,7 @@ Abstract:
 #include "IStateMachineEngine.hpp"
 #include "telemetry.hpp"
 #include "tracing.hpp"
+#include <array>
 #include <memory>
 
 namespace Microsoft::Console::VirtualTerminal
@@ -32,6 +33,73 @@ namespace Microsoft::Console::VirtualTerminal
     // that number.
     constexpr size_t MAX_PARAMETER_COUNT = 32;
 
+    // The default limit on the length of OSC strings. The longest ones
+    // in practice are OSC 52 clipboard writes, where this allows for roughly
+    // 190 KB of base64 encoded data. Longer strings are dropped.
+    constexpr size_t MAX_STRING_LENGTH = 256 * 1024;
+
+    // The parameters of the sequence that's being parsed. They are limited to
+    // MAX_PARAMETER_COUNT, so they are stored inline, and collecting them never
+    // allocates. They are passed on to the engine as VTParameters, a span.
+    class VTParameterStorage final
+    {
+    public:
+        constexpr bool empty() const noexcept
+        {
+            return _size == 0;
+        }
+
+        constexpr size_t size() const noexcept
+        {
+            return _size;
+        }
+
+        constexpr const VTParameter* data() const noexcept
+        {
+            return _values.data();
+        }
+
+        constexpr VTParameter& back() noexcept
+        {
+            return til::at(_values, _size - 1);
+        }
+
+        constexpr const VTParameter& back() const noexcept
+        {
+            return til::at(_values, _size - 1);
+        }
+
+        const VTParameter& at(const size_t index) const
+        {
+            THROW_HR_IF(E_BOUNDS, index >= _size);
+            return til::at(_values, index);
+        }
+
+        // Parameters past the capacity are dropped. The state machine
+        // stops adding them before that, once it reaches the limit.
+        constexpr void push_back(const VTParameter value) noexcept
+        {
+            if (_size < _values.size())
+            {
+                til::at(_values, _size++) = value;
+            }
+        }
+
+        constexpr void clear() noexcept
+        {
+            _size = 0;
+        }
+
+        operator VTParameters() const noexcept
+        {
+            return { _values.data(), _size };
+        }
+
+    private:
+        std::array<VTParameter, MAX_PARAMETER_COUNT> _values{};
+        size_t _size = 0;
+    };
+
     class StateMachine final
     {
 #ifdef UNIT_TESTING
@@ -43,13 +111,16 @@ namespace Microsoft::Console::VirtualTerminal
         StateMachine(std::unique_ptr<IStateMachineEngine> engine);
 
         void SetAnsiMode(bool ansiMode) noexcept;
+        void SetMaxStringLength(const size_t length) noexcept;
 
         void ProcessCharacter(const wchar_t wch);
         void ProcessString(const std::wstring_view string);
+        void ProcessString(const std::string_view string);
 
         void ResetState() noexcept;
 
         bool FlushToTerminal();
+        bool FlushExecuteToTerminal();
 
         const IStateMachineEngine& Engine() const noexcept;
         IStateMachineEngine& Engine() noexcept;
@@ -65,6 +136,8 @@ namespace Microsoft::Console::VirtualTerminal
         void _ActionCsiDispatch(const wchar_t wch);
         void _ActionOscParam(const wchar_t wch) noexcept;
         void _ActionOscPut(const wchar_t wch);
+        void _ActionOscPutRun(const std::wstring_view run);
+        void _RetainOscString();
         void _ActionOscDispatch(const wchar_t wch);
         void _ActionSs3Dispatch(const wchar_t wch);
         void _ActionDcsDispatch(const wchar_t wch);
@@ -93,29 +166,11 @@ namespace Microsoft::Console::VirtualTerminal
         void _EnterDcsPassThrough() noexcept;
         void _EnterSosPmApcString() noexcept;
 
-        void _EventGround(const wchar_t wch);
-        void _EventEscape(const wchar_t wch);
-        void _EventEscapeIntermediate(const wchar_t wch);
-        void _EventCsiEntry(const wchar_t wch);
-        void _EventCsiIntermediate(const wchar_t wch);
-        void _EventCsiIgnore(const wchar_t wch);
-        void _EventCsiParam(const wchar_t wch);
-        void _EventOscParam(const wchar_t wch) noexcept;
-        void _EventOscString(const wchar_t wch);
-        void _EventOscTermination(const wchar_t wch);
-        void _EventSs3Entry(const wchar_t wch);
-        void _EventSs3Param(const wchar_t wch);
-        void _EventVt52Param(const wchar_t wch);
-        void _EventDcsEntry(const wchar_t wch);
-        void _EventDcsIgnore() noexcept;
-        void _EventDcsIntermediate(const wchar_t wch);
-        void _EventDcsParam(const wchar_t wch);
-        void _EventDcsPassThrough(const wchar_t wch);
-        void _EventSosPmApcString(const wchar_t wch) noexcept;
+        void _EndStringWithinSequence();
 
         void _AccumulateTo(const wchar_t wch, size_t& value) noexcept;
 
-        enum class VTStates
+        enum class VTStates : uint8_t
         {
             Ground,
             Escape,
@@ -138,6 +193,87 @@ namespace Microsoft::Console::VirtualTerminal
             SosPmApcString
         };
 
+        // The characters are looked at in terms of the classes that the
+        // DEC ANSI parser model tells apart (see http://vt100.net/emu/dec_ansi_parser).
+        // C1 control characters, ESC, CAN and SUB are mostly handled before the
+        // tables are consulted, by ProcessCharacter.
+        enum class CharClass : uint8_t
+        {
+            C0, // C0 control characters other than the ones below
+            Bell, // BEL, which terminates OSC strings
+            CancelOrSubstitute, // CAN and SUB
+            Escape, // ESC
+            Intermediate, // 0x20 - 0x2F
+            Digit, // 0x30 - 0x39
+            Colon, // 0x3A
+            Semicolon, // 0x3B
+            PrivateMarker, // 0x3C - 0x3F
+            Final, // 0x40 - 0x7E, other than the indicators below
+            CsiIndicator, // [
+            OscIndicator, // ]
+            Ss3Indicator, // O
+            DcsIndicator, // P
+            SosPmApcIndicator, // X ^ _
+            Vt52CursorAddress, // Y
+            StringTerminator, // backslash
+            Delete, // DEL
+            NonAscii // anything past DEL
+        };
+
+        enum class Action : uint8_t
+        {
+            None,
+            Ignore,
+            Execute,
+            Print,
+            Collect,
+            Param,
+            EscDispatch,
+            Vt52EscDispatch,
+            CsiDispatch,
+            OscParam,
+            OscPut,
+            OscDispatch,
+            Ss3Dispatch,
+            DcsDispatch,
+            DcsPassThrough,
+            Vt52Param,
+            // These depend on the engine, and change the state themselves.
+            EscapeControl,
+            EscapeIntermediate,
+            EscapeSs3,
+            // Enter the Escape state and process the character again from there.
+            ReprocessAsEscape
+        };
+
+        // The action to perform for a character, and the state to enter afterwards.
+        // If the state is the current one, it isn't entered again.
+        struct Transition
+        {
+            Action action;
+            VTStates next;
+        };
+
+        static constexpr size_t s_charClassCount = static_cast<size_t>(CharClass::NonAscii) + 1;
+        static constexpr size_t s_stateCount = static_cast<size_t>(VTStates::SosPmApcString) + 1;
+        // The Escape and EscapeIntermediate states behave differently in VT52 mode,
+        // so they have another row each after the rows of all the states.
+        static constexpr size_t s_vt52EscapeRow = s_stateCount;
+        static constexpr size_t s_vt52EscapeIntermediateRow = s_stateCount + 1;
+
+        using CharClassTable = std::array<CharClass, 128>;
+        using TransitionTable = std::array<std::array<Transition, s_charClassCount>, s_stateCount + 2>;
+
+        static constexpr CharClassTable _BuildCharClasses() noexcept;
+        static constexpr TransitionTable _BuildTransitions() noexcept;
+
+        static const CharClassTable s_charClasses;
+        static const TransitionTable s_transitions;
+
+        void _ProcessEvent(const wchar_t wch);
+        void _PerformAction(const Action action, const wchar_t wch);
+        void _EnterState(const VTStates state);
+
         Microsoft::Console::VirtualTerminal::ParserTracing _trace;
 
         std::unique_ptr<IStateMachineEngine> _engine;
@@ -149,12 +285,20 @@ namespace Microsoft::Console::VirtualTerminal
         std::wstring_view _run;
 
         VTIDBuilder _identifier;
-        std::vector<VTParameter> _parameters;
+        VTParameterStorage _parameters;
         bool _parameterLimitReached;
 
+        // The OSC string is a slice of the string passed to ProcessString as long
+        // as it can be, and only copied into _oscString when it can't.
         std::wstring _oscString;
+        std::wstring_view _oscSlice;
         size_t _oscParameter;
 
+        // The length of the current OSC string, and whether it exceeded the limit.
+        size_t _maxStringLength;
+        size_t _stringLength;
+        bool _stringLimitReached;
+
         IStateMachineEngine::StringHandler _dcsStringHandler;
 
         std::optional<std::wstring> _cachedSequence;
@@ -162,5 +306,12 @@ namespace Microsoft::Console::VirtualTerminal
         // This is tracked per state machine instance so that separate calls to Process*
         //   can start and finish a sequence.
         bool _processingIndividually;
+
+        // The state of the UTF-8 overload of ProcessString: a code point that
+        // was cut off at the end of the last string, the transcoded characters,
+        // and the sequence in progress.
+        til::u8state _utf8State;
+        std::wstring _utf16Buffer;
+        std::wstring _utf8Sequence;
     };
 }
@@ -4,19 +4,83 @@
 #include "precomp.h"
 #include "tracing.hpp"
 
+#ifndef PARSER_TRACING_DISABLED
+
 using namespace Microsoft::Console::VirtualTerminal;
 
 #pragma warning(push)
 #pragma warning(disable : 26447) // The function is declared 'noexcept' but calls function '_tlgWrapBinary<wchar_t>()' which may throw exceptions
 #pragma warning(disable : 26477) // Use 'nullptr' rather than 0 or NULL
 
+// The counters are checked for a flush every this many counts, so that the
+// clock isn't read for every character.
+static constexpr uint32_t s_countsPerFlushCheck = 1024;
+static constexpr ULONGLONG s_flushIntervalMs = 1000;
+
 ParserTracing::ParserTracing() noexcept
 {
     ClearSequenceTrace();
 }
 
-void ParserTracing::TraceStateChange(const std::wstring_view name) const noexcept
+ParserTracing::~ParserTracing()
+{
+    _FlushCounters();
+}
+
+// Routine Description:
+// - Adds to one of the counters, if anyone is listening for them, and writes
+//   them out once they haven't been for a while.
+// Arguments:
+// - counter - The counter to add to.
+// - count - How much to add.
+// Return Value:
+// - <none>
+void ParserTracing::_Count(uint32_t Counters::*counter, const uint32_t count) noexcept
+{
+    if (!TraceLoggingProviderEnabled(g_hConsoleVirtTermParserEventTraceProvider, WINEVENT_LEVEL_INFO, TIL_KEYWORD_TRACE))
+    {
+        return;
+    }
+
+    _counters.*counter += count;
+
+    if (++_countsSinceFlush >= s_countsPerFlushCheck)
+    {
+        _countsSinceFlush = 0;
+        const auto now = GetTickCount64();
+        if (now - _lastFlush >= s_flushIntervalMs)
+        {
+            _lastFlush = now;
+            _FlushCounters();
+        }
+    }
+}
+
+void ParserTracing::_FlushCounters() noexcept
 {
+    if (_counters.characters == 0 && _counters.printed == 0)
+    {
+        return;
+    }
+
+    TraceLoggingWrite(g_hConsoleVirtTermParserEventTraceProvider,
+                      "StateMachine_Counters",
+                      TraceLoggingValue(_counters.characters, "Characters"),
+                      TraceLoggingValue(_counters.printed, "Printed"),
+                      TraceLoggingValue(_counters.executed, "Executed"),
+                      TraceLoggingValue(_counters.actions, "Actions"),
+                      TraceLoggingValue(_counters.stateChanges, "StateChanges"),
+                      TraceLoggingValue(_counters.sequences, "Sequences"),
+                      TraceLoggingValue(_counters.failedSequences, "FailedSequences"),
+                      TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+                      TraceLoggingKeyword(TIL_KEYWORD_TRACE));
+
+    _counters = {};
+}
+
+void ParserTracing::TraceStateChange(const std::wstring_view name) noexcept
+{
+    _Count(&Counters::stateChanges);
     TraceLoggingWrite(g_hConsoleVirtTermParserEventTraceProvider,
                       "StateMachine_EnterState",
                       TraceLoggingCountedWideString(name.data(), gsl::narrow_cast<ULONG>(name.size())),
@@ -24,8 +88,9 @@ void ParserTracing::TraceStateChange(const std::wstring_view name) const noexcep
                       TraceLoggingKeyword(TIL_KEYWORD_TRACE));
 }
 
-void ParserTracing::TraceOnAction(const std::wstring_view name) const noexcept
+void ParserTracing::TraceOnAction(const std::wstring_view name) noexcept
 {
+    _Count(&Counters::actions);
     TraceLoggingWrite(g_hConsoleVirtTermParserEventTraceProvider,
                       "StateMachine_Action",
                       TraceLoggingCountedWideString(name.data(), gsl::narrow_cast<ULONG>(name.size())),
@@ -33,8 +98,9 @@ void ParserTracing::TraceOnAction(const std::wstring_view name) const noexcept
                       TraceLoggingKeyword(TIL_KEYWORD_TRACE));
 }
 
-void ParserTracing::TraceOnExecute(const wchar_t wch) const noexcept
+void ParserTracing::TraceOnExecute(const wchar_t wch) noexcept
 {
+    _Count(&Counters::executed);
     const auto sch = gsl::narrow_cast<INT16>(wch);
     TraceLoggingWrite(g_hConsoleVirtTermParserEventTraceProvider,
                       "StateMachine_Execute",
@@ -44,8 +110,9 @@ void ParserTracing::TraceOnExecute(const wchar_t wch) const noexcept
                       TraceLoggingKeyword(TIL_KEYWORD_TRACE));
 }
 
-void ParserTracing::TraceOnExecuteFromEscape(const wchar_t wch) const noexcept
+void ParserTracing::TraceOnExecuteFromEscape(const wchar_t wch) noexcept
 {
+    _Count(&Counters::executed);
     const auto sch = gsl::narrow_cast<INT16>(wch);
     TraceLoggingWrite(g_hConsoleVirtTermParserEventTraceProvider,
                       "StateMachine_ExecuteFromEscape",
@@ -66,6 +133,7 @@ void ParserTracing::TraceOnEvent(const std::wstring_view name) const noexcept
 
 void ParserTracing::TraceCharInput(const wchar_t wch)
 {
+    _Count(&Counters::characters);
     AddSequenceTrace(wch);
     const auto sch = gsl::narrow_cast<INT16>(wch);
 
@@ -88,6 +156,8 @@ void ParserTracing::AddSequenceTrace(const wchar_t wch)
 
 void ParserTracing::DispatchSequenceTrace(const bool fSuccess) noexcept
 {
+    _Count(fSuccess ? &Counters::sequences : &Counters::failedSequences);
+
     if (fSuccess)
     {
         TraceLoggingWrite(g_hConsoleVirtTermParserEventTraceProvider,
@@ -114,8 +184,10 @@ void ParserTracing::ClearSequenceTrace() noexcept
 }
 
 // NOTE: I'm expecting this to not be null terminated
-void ParserTracing::DispatchPrintRunTrace(const std::wstring_view string) const
+void ParserTracing::DispatchPrintRunTrace(const std::wstring_view string)
 {
+    _Count(&Counters::printed, gsl::narrow_cast<uint32_t>(string.size()));
+
     if (string.size() == 1)
     {
         const auto wch = til::at(string, 0);
@@ -141,3 +213,5 @@ void ParserTracing::DispatchPrintRunTrace(const std::wstring_view string) const
 }
 
 #pragma warning(pop)
+
+#endif
@@ -10,6 +10,10 @@ Abstract:
 - The data is not automatically broadcast to telemetry backends.
 - NOTE: Many functions in this file appear to be copy/pastes. This is because the TraceLog documentation warns
         to not be "cute" in trying to reduce its macro usages with variables as it can cause unexpected behavior.
+- A listener at the verbose level gets an event for every character, state and action.
+  A listener at the info level only gets the counts of those, about once a second,
+  which is cheap enough to leave on.
+- Define PARSER_TRACING_DISABLED to compile the tracing out of the parser entirely.
 */
 
 #pragma once
@@ -18,24 +22,67 @@ Abstract:
 
 namespace Microsoft::Console::VirtualTerminal
 {
+#ifdef PARSER_TRACING_DISABLED
+    class ParserTracing sealed
+    {
+    public:
+        void TraceStateChange(const std::wstring_view /*name*/) noexcept {}
+        void TraceOnAction(const std::wstring_view /*name*/) noexcept {}
+        void TraceOnExecute(const wchar_t /*wch*/) noexcept {}
+        void TraceOnExecuteFromEscape(const wchar_t /*wch*/) noexcept {}
+        void TraceOnEvent(const std::wstring_view /*name*/) const noexcept {}
+        void TraceCharInput(const wchar_t /*wch*/) noexcept {}
+
+        void AddSequenceTrace(const wchar_t /*wch*/) noexcept {}
+        void DispatchSequenceTrace(const bool /*fSuccess*/) noexcept {}
+        void ClearSequenceTrace() noexcept {}
+        void DispatchPrintRunTrace(const std::wstring_view /*string*/) noexcept {}
+    };
+#else
     class ParserTracing sealed
     {
     public:
         ParserTracing() noexcept;
+        ~ParserTracing();
+
+        ParserTracing(const ParserTracing&) = default;
+        ParserTracing(ParserTracing&&) = default;
+        ParserTracing& operator=(const ParserTracing&) = default;
+        ParserTracing& operator=(ParserTracing&&) = default;
 
-        void TraceStateChange(const std::wstring_view name) const noexcept;
-        void TraceOnAction(const std::wstring_view name) const noexcept;
-        void TraceOnExecute(const wchar_t wch) const noexcept;
-        void TraceOnExecuteFromEscape(const wchar_t wch) const noexcept;
+        void TraceStateChange(const std::wstring_view name) noexcept;
+        void TraceOnAction(const std::wstring_view name) noexcept;
+        void TraceOnExecute(const wchar_t wch) noexcept;
+        void TraceOnExecuteFromEscape(const wchar_t wch) noexcept;
         void TraceOnEvent(const std::wstring_view name) const noexcept;
         void TraceCharInput(const wchar_t wch);
 
         void AddSequenceTrace(const wchar_t wch);
         void DispatchSequenceTrace(const bool fSuccess) noexcept;
         void ClearSequenceTrace() noexcept;
-        void DispatchPrintRunTrace(const std::wstring_view string) const;
+        void DispatchPrintRunTrace(const std::wstring_view string);
 
     private:
+        // A state machine is only ever driven by one thread at a time,
+        // so these don't need to be atomic to be counted per thread.
+        struct Counters
+        {
+            uint32_t characters;
+            uint32_t printed;
+            uint32_t executed;
+            uint32_t actions;
+            uint32_t stateChanges;
+            uint32_t sequences;
+            uint32_t failedSequences;
+        };
+
+        void _Count(uint32_t Counters::*counter, const uint32_t count = 1) noexcept;
+        void _FlushCounters() noexcept;
+
         std::wstring _sequenceTrace;
+        Counters _counters{};
+        uint32_t _countsSinceFlush{ 0 };
+        ULONGLONG _lastFlush{ 0 };
     };
+#endif
 }
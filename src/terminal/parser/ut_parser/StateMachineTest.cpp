@@ -38,6 +38,9 @@ public:
         dcsId = 0;
         dcsParams.clear();
         dcsDataString.clear();
+        oscString.clear();
+        oscStringData = nullptr;
+        oscCount = 0;
     }
 
     bool ActionExecute(const wchar_t wch) override
@@ -47,7 +50,11 @@ public:
     };
 
     bool ActionExecuteFromEscape(const wchar_t /* wch */) override { return true; };
-    bool ActionPrint(const wchar_t /* wch */) override { return true; };
+    bool ActionPrint(const wchar_t wch) override
+    {
+        printed += wch;
+        return true;
+    };
     bool ActionPrintString(const std::wstring_view string) override
     {
         printed += string;
@@ -68,10 +75,15 @@ public:
 
     bool ActionIgnore() override { return true; };
 
+    bool ActionEndOfString() override { return true; };
+
     bool ActionOscDispatch(const wchar_t /* wch */,
                            const size_t /* parameter */,
-                           const std::wstring_view /* string */) override
+                           const std::wstring_view string) override
     {
+        oscString = string;
+        oscStringData = string.data();
+        ++oscCount;
         if (pfnFlushToTerminal)
         {
             pfnFlushToTerminal();
@@ -138,6 +150,11 @@ public:
     uint64_t dcsId = 0;
     std::vector<size_t> dcsParams;
     std::wstring dcsDataString;
+
+    // These will only be populated if ActionOscDispatch is called.
+    std::wstring oscString;
+    const wchar_t* oscStringData = nullptr;
+    size_t oscCount = 0;
 };
 
 class Microsoft::Console::VirtualTerminal::StateMachineTest
@@ -159,9 +176,13 @@ class Microsoft::Console::VirtualTerminal::StateMachineTest
     TEST_METHOD(PassThroughUnhandled);
     TEST_METHOD(RunStorageBeforeEscape);
     TEST_METHOD(BulkTextPrint);
+    TEST_METHOD(BulkTextPrintStopsAtControls);
     TEST_METHOD(PassThroughUnhandledSplitAcrossWrites);
 
     TEST_METHOD(DcsDataStringsReceivedByHandler);
+    TEST_METHOD(ControlCharactersWithinParameters);
+    TEST_METHOD(Utf8StringsAreParsedLikeUtf16);
+    TEST_METHOD(OscStringsAreSlicesOfTheInput);
 };
 
 void StateMachineTest::TwoStateMachinesDoNotInterfereWithEachother()
@@ -234,6 +255,28 @@ void StateMachineTest::BulkTextPrint()
     VERIFY_ARE_EQUAL(String(L"12345 Hello World"), String(engine.printed.c_str()));
 }
 
+void StateMachineTest::BulkTextPrintStopsAtControls()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    // The characters right next to the actionable ranges, and ones that look
+    // negative to signed comparisons, are all printable.
+    const std::wstring printable{ L"\x20~\xA0\xFF\x8000\xE000\xFFFF" };
+    for (size_t offset = 0; offset < 20; ++offset)
+    {
+        engine.ResetTestState();
+        const auto before = std::wstring(offset, L'a') + printable;
+        const auto after = printable + L"bbbbbbbbbbbbbbbbbbbb";
+        machine.ProcessString(before + L"\x07" + after + L"\x7f" + printable);
+
+        VERIFY_ARE_EQUAL(String((before + after + printable).c_str()), String(engine.printed.c_str()));
+        VERIFY_ARE_EQUAL(String(L"\x07\x7f"), String(engine.executed.c_str()));
+    }
+}
+
 void StateMachineTest::PassThroughUnhandledSplitAcrossWrites()
 {
     auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
@@ -342,3 +385,90 @@ void StateMachineTest::DcsDataStringsReceivedByHandler()
     // Verify the control characters were executed (if expected).
     VERIFY_ARE_EQUAL(expectedExecuted, engine.executed);
 }
+
+void StateMachineTest::ControlCharactersWithinParameters()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    Log::Comment(L"C0 control characters are executed in the middle of a CSI sequence.");
+    machine.ProcessString(L"\033[1\b;2\aH");
+    VERIFY_ARE_EQUAL(VTID("H"), engine.csiId);
+    VERIFY_ARE_EQUAL(std::vector<size_t>({ 1, 2 }), engine.csiParams);
+    VERIFY_ARE_EQUAL(L"\b\a", engine.executed);
+
+    Log::Comment(L"C0 control characters and DEL are ignored in the parameters of a DCS sequence.");
+    engine.ResetTestState();
+    machine.ProcessString(L"\033P1;\a2\x7f|data\033\\");
+    VERIFY_ARE_EQUAL(VTID("|"), engine.dcsId);
+    VERIFY_ARE_EQUAL(std::vector<size_t>({ 1, 2 }), engine.dcsParams);
+    VERIFY_ARE_EQUAL(L"data\033", engine.dcsDataString);
+    VERIFY_ARE_EQUAL(L"", engine.executed);
+    VERIFY_ARE_EQUAL(L"", engine.printed);
+}
+
+void StateMachineTest::Utf8StringsAreParsedLikeUtf16()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    Log::Comment(L"Text is printed in runs around the sequences and control characters.");
+    machine.ProcessString(std::string_view{ "caf\xC3\xA9 \xF0\x9F\x98\x80\x1b[1;2Hnext\r\n" });
+    VERIFY_ARE_EQUAL(L"caf\u00E9 \U0001F600next", engine.printed);
+    VERIFY_ARE_EQUAL(VTID("H"), engine.csiId);
+    VERIFY_ARE_EQUAL(std::vector<size_t>({ 1, 2 }), engine.csiParams);
+    VERIFY_ARE_EQUAL(L"\r\n", engine.executed);
+
+    Log::Comment(L"C1 control characters are encoded as two bytes.");
+    engine.ResetTestState();
+    machine.ProcessString(std::string_view{ "a\xC2\x9B" "3Jb" });
+    VERIFY_ARE_EQUAL(L"ab", engine.printed);
+    VERIFY_ARE_EQUAL(VTID("J"), engine.csiId);
+    VERIFY_ARE_EQUAL(std::vector<size_t>({ 3 }), engine.csiParams);
+
+    Log::Comment(L"Code points and sequences may be split between writes.");
+    engine.ResetTestState();
+    for (const auto part : { "\xE2\x82", "\xAC\x1b[", "4", "m\xC2", "\x9B", "5m\xC2", "\xA0" })
+    {
+        machine.ProcessString(std::string_view{ part });
+    }
+    VERIFY_ARE_EQUAL(L"\u20AC\u00A0", engine.printed);
+    VERIFY_ARE_EQUAL(VTID("m"), engine.csiId);
+    VERIFY_ARE_EQUAL(std::vector<size_t>({ 4, 5 }), engine.csiParams);
+}
+
+void StateMachineTest::OscStringsAreSlicesOfTheInput()
+{
+    auto enginePtr{ std::make_unique<TestStateMachineEngine>() };
+    // this dance is required because StateMachine presumes to take ownership of its engine.
+    auto& engine{ *enginePtr.get() };
+    StateMachine machine{ std::move(enginePtr) };
+
+    Log::Comment(L"A string that's complete is passed on without copying it.");
+    const std::wstring_view complete{ L"\x1b]8;;https://example.com\x1b\\text" };
+    machine.ProcessString(complete);
+    VERIFY_ARE_EQUAL(1u, engine.oscCount);
+    VERIFY_ARE_EQUAL(L";https://example.com", engine.oscString);
+    VERIFY_IS_TRUE(engine.oscStringData == complete.data() + 4);
+    VERIFY_ARE_EQUAL(L"text", engine.printed);
+
+    Log::Comment(L"A string that spans writes, or has characters removed from it, is copied.");
+    engine.ResetTestState();
+    const std::wstring first{ L"\x1b]2;split" };
+    machine.ProcessString(first);
+    machine.ProcessString(L" ti\x01tle\x07");
+    VERIFY_ARE_EQUAL(1u, engine.oscCount);
+    VERIFY_ARE_EQUAL(L"split title", engine.oscString);
+
+    Log::Comment(L"A string that exceeds the limit isn't dispatched.");
+    engine.ResetTestState();
+    machine.SetMaxStringLength(10);
+    machine.ProcessString(L"\x1b]2;0123456789\x07\x1b]2;01234");
+    machine.ProcessString(L"56789A\x07");
+    VERIFY_ARE_EQUAL(1u, engine.oscCount);
+    VERIFY_ARE_EQUAL(L"0123456789", engine.oscString);
+}
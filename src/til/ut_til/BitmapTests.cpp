@@ -632,6 +632,38 @@ class BitmapTests
         _checkBits(expectedSet, bitmap);
     }
 
+    TEST_METHOD(Union)
+    {
+        // 1 1 0 0     0 0 0 0     1 1 0 0
+        // 1 1 0 0  |  0 0 1 1  =  1 1 1 1
+        // 0 0 0 0     0 0 1 1     0 0 1 1
+        // 0 0 0 0     0 0 0 0     0 0 0 0
+        til::bitmap actual{ til::size{ 4, 4 } };
+        actual.set(til::rectangle{ til::point{ 0, 0 }, til::size{ 2, 2 } });
+
+        til::bitmap other{ til::size{ 4, 4 } };
+        other.set(til::rectangle{ til::point{ 2, 1 }, til::size{ 2, 2 } });
+
+        til::bitmap expected{ til::size{ 4, 4 } };
+        expected.set(til::rectangle{ til::point{ 0, 0 }, til::size{ 2, 2 } });
+        expected.set(til::rectangle{ til::point{ 2, 1 }, til::size{ 2, 2 } });
+
+        // Fill the cached runs, so that we can check they're updated.
+        VERIFY_ARE_EQUAL(2u, actual.runs().size());
+
+        actual |= other;
+
+        VERIFY_ARE_EQUAL(expected, actual);
+        VERIFY_ARE_EQUAL(4u, actual.runs().size());
+
+        Log::Comment(L"Bitmaps of different sizes can't be combined.");
+        auto fn = [&]() {
+            actual |= til::bitmap{ til::size{ 5, 4 } };
+        };
+
+        VERIFY_THROWS_SPECIFIC(fn(), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+    }
+
     TEST_METHOD(SetResetExceptions)
     {
         til::bitmap map{ til::size{ 4, 4 } };
@@ -966,6 +998,80 @@ class BitmapTests
         VERIFY_ARE_EQUAL(expected, actual);
     }
 
+    TEST_METHOD(RunsAcrossBlocks)
+    {
+        // The bits are stored 64 to a block, so rows this wide have runs
+        // that start, end and span blocks in every which way.
+        til::bitmap map{ til::size{ 150, 3 } };
+
+        til::some<til::rectangle, 6> expected;
+        expected.push_back(til::rectangle{ til::point{ 0, 0 }, til::size{ 150, 1 } });
+        expected.push_back(til::rectangle{ til::point{ 10, 1 }, til::size{ 54, 1 } });
+        expected.push_back(til::rectangle{ til::point{ 65, 1 }, til::size{ 70, 1 } });
+        expected.push_back(til::rectangle{ til::point{ 149, 1 }, til::size{ 1, 1 } });
+        expected.push_back(til::rectangle{ til::point{ 0, 2 }, til::size{ 1, 1 } });
+        expected.push_back(til::rectangle{ til::point{ 100, 2 }, til::size{ 50, 1 } });
+
+        for (const auto& run : expected)
+        {
+            map.set(run);
+        }
+
+        til::some<til::rectangle, 6> actual;
+        for (auto run : map.runs())
+        {
+            actual.push_back(run);
+        }
+
+        VERIFY_ARE_EQUAL(expected, actual);
+    }
+
+    TEST_METHOD(TranslateAcrossBlocks)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"Data:fill", L"{true, false}")
+        END_TEST_METHOD_PROPERTIES()
+
+        bool fill;
+        VERIFY_SUCCEEDED(TestData::TryGetValue(L"fill", fill));
+
+        // Compare the translation of a wide bitmap with the one of its runs.
+        const til::size size{ 150, 6 };
+        const til::rectangle bounds{ size };
+        const std::array<til::rectangle, 3> rects{
+            til::rectangle{ til::point{ 0, 0 }, til::size{ 150, 1 } },
+            til::rectangle{ til::point{ 60, 1 }, til::size{ 30, 3 } },
+            til::rectangle{ til::point{ 140, 4 }, til::size{ 10, 2 } },
+        };
+
+        for (const auto delta : { til::point{ 3, 0 }, til::point{ -70, 0 }, til::point{ 5, 2 }, til::point{ -64, 1 }, til::point{ 64, -3 }, til::point{ -1, -1 } })
+        {
+            Log::Comment(NoThrowString().Format(L"Translate by %s", delta.to_string().c_str()));
+
+            til::bitmap expected{ size };
+            for (const auto& rect : rects)
+            {
+                expected.set((rect + delta) & bounds);
+            }
+            if (fill)
+            {
+                for (const auto& uncovered : bounds - (bounds + delta))
+                {
+                    expected.set(uncovered);
+                }
+            }
+
+            til::bitmap actual{ size };
+            for (const auto& rect : rects)
+            {
+                actual.set(rect);
+            }
+            actual.translate(delta, fill);
+
+            VERIFY_ARE_EQUAL(expected, actual);
+        }
+    }
+
     TEST_METHOD(RunsWithPmr)
     {
         // This is a copy of the above test, but with a pmr::bitmap.
@@ -0,0 +1,227 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+namespace
+{
+    struct drop_indicator
+    {
+        explicit drop_indicator(int& counter) noexcept :
+            _counter(&counter) {}
+
+        drop_indicator(const drop_indicator&) = delete;
+        drop_indicator& operator=(const drop_indicator&) = delete;
+
+        drop_indicator(drop_indicator&& other) noexcept
+        {
+            _counter = std::exchange(other._counter, nullptr);
+        }
+
+        drop_indicator& operator=(drop_indicator&& other) noexcept
+        {
+            _counter = std::exchange(other._counter, nullptr);
+            return *this;
+        }
+
+        ~drop_indicator()
+        {
+            if (_counter)
+            {
+                ++*_counter;
+            }
+        }
+
+    private:
+        int* _counter = nullptr;
+    };
+
+    template<typename T>
+    void drop(T&& val)
+    {
+        auto _ = std::move(val);
+    }
+}
+
+class MPSCTests
+{
+    BEGIN_TEST_CLASS(MPSCTests)
+        TEST_CLASS_PROPERTY(L"TestTimeout", L"0:0:10") // 10s timeout
+    END_TEST_CLASS()
+
+    TEST_METHOD(SmokeTest);
+    TEST_METHOD(DropTest);
+    TEST_METHOD(DropConsumerTest);
+    TEST_METHOD(WrapAroundTest);
+    TEST_METHOD(IntegrationTest);
+};
+
+void MPSCTests::SmokeTest()
+{
+    // This test mostly ensures that the API wasn't broken.
+
+    // construction
+    auto [tx, rx] = til::mpsc::channel<int>(32);
+    std::array<int, 3> data{};
+
+    // copy and move constructor
+    til::mpsc::producer tx2(tx);
+    til::mpsc::producer tx3(std::move(tx2));
+    til::mpsc::consumer rx2(std::move(rx));
+
+    // copy and move assignment operator
+    tx2 = tx3;
+    tx = std::move(tx3);
+    rx = std::move(rx2);
+
+    // push
+    tx.emplace(0);
+    tx.push(data.begin(), data.end());
+    tx.push(til::mpsc::block_initially, data.begin(), data.end());
+    tx.push(til::mpsc::block_forever, data.begin(), data.end());
+    tx2.push_n(data.begin(), data.size());
+    tx2.push_n(til::mpsc::block_initially, data.begin(), data.size());
+    tx2.push_n(til::mpsc::block_forever, data.begin(), data.size());
+
+    // pop
+    std::optional<int> x = rx.pop();
+    rx.pop_n(til::mpsc::block_initially, data.begin(), data.size());
+    rx.pop_n(til::mpsc::block_forever, data.begin(), data.size());
+}
+
+void MPSCTests::DropTest()
+{
+    auto [tx, rx] = til::mpsc::channel<drop_indicator>(5);
+    auto tx2 = tx;
+    int counter = 0;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        tx.emplace(counter);
+        tx2.emplace(counter);
+    }
+    VERIFY_ARE_EQUAL(counter, 0);
+
+    rx.pop();
+    VERIFY_ARE_EQUAL(counter, 1);
+
+    Log::Comment(L"The channel stays open as long as any producer is around.");
+    drop(tx);
+    std::array<std::optional<drop_indicator>, 2> items;
+    const auto [count, alive] = rx.pop_n(til::mpsc::block_initially, items.begin(), items.size());
+    VERIFY_ARE_EQUAL(2u, count);
+    VERIFY_IS_TRUE(alive);
+    items = {};
+    VERIFY_ARE_EQUAL(counter, 3);
+
+    Log::Comment(L"The remaining items are destroyed once both sides are gone.");
+    drop(tx2);
+    VERIFY_ARE_EQUAL(counter, 3);
+    drop(rx);
+    VERIFY_ARE_EQUAL(counter, 4);
+}
+
+void MPSCTests::DropConsumerTest()
+{
+    auto [tx, rx] = til::mpsc::channel<int>(2);
+
+    drop(rx);
+
+    Log::Comment(L"Producers fail right away instead of blocking.");
+    std::array<int, 3> data{};
+    VERIFY_IS_FALSE(tx.emplace(0));
+    const auto [count, alive] = tx.push(data.begin(), data.end());
+    VERIFY_ARE_EQUAL(0u, count);
+    VERIFY_IS_FALSE(alive);
+
+    Log::Comment(L"The consumer sees the end of the channel after draining it.");
+    auto [tx2, rx2] = til::mpsc::channel<int>(4);
+    tx2.push(data.begin(), data.end());
+    drop(tx2);
+
+    std::array<int, 4> buffer{};
+    const auto [count2, alive2] = rx2.pop_n(til::mpsc::block_forever, buffer.begin(), buffer.size());
+    VERIFY_ARE_EQUAL(3u, count2);
+    VERIFY_IS_FALSE(alive2);
+    VERIFY_IS_FALSE(rx2.pop().has_value());
+}
+
+void MPSCTests::WrapAroundTest()
+{
+    auto [tx, rx] = til::mpsc::channel<int>(5);
+    std::array<int, 4> buffer{};
+
+    // Every round starts at a different position of the ring buffer.
+    for (int round = 0; round < 7; ++round)
+    {
+        std::array<int, 4> data{ round, round + 1, round + 2, round + 3 };
+        VERIFY_ARE_EQUAL(4u, tx.push(data.begin(), data.end()).first);
+        VERIFY_ARE_EQUAL(4u, rx.pop_n(buffer.begin(), buffer.size()).first);
+        VERIFY_IS_TRUE(data == buffer);
+    }
+
+    Log::Comment(L"block_initially writes as much as fits without waiting.");
+    std::array<int, 7> data{};
+    VERIFY_ARE_EQUAL(5u, tx.push(til::mpsc::block_initially, data.begin(), data.end()).first);
+}
+
+void MPSCTests::IntegrationTest()
+{
+    static constexpr int producers = 4;
+    static constexpr int itemsPerProducer = 3 * 11 + 37;
+
+    auto [tx, rx] = til::mpsc::channel<int>(7);
+
+    // Each producer sends producer * 1000 + i for i in [0, itemsPerProducer),
+    // partially one at a time and partially in batches.
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([p, tx = tx]() {
+            std::array<int, 11> buffer{};
+            for (int i = 0; i < 37; ++i)
+            {
+                tx.emplace(p * 1000 + i);
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                std::generate(buffer.begin(), buffer.end(), [v = 37 + i * 11 + p * 1000]() mutable { return v++; });
+                tx.push(buffer.begin(), buffer.end());
+            }
+        });
+    }
+    drop(tx);
+
+    // The items of different producers are interleaved, but each producer's are in order.
+    std::array<int, producers> next{};
+    std::array<int, 13> buffer{};
+    size_t total = 0;
+    for (;;)
+    {
+        const auto [count, alive] = rx.pop_n(til::mpsc::block_initially, buffer.begin(), buffer.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto p = buffer[i] / 1000;
+            VERIFY_ARE_EQUAL(p * 1000 + next[p], buffer[i]);
+            ++next[p];
+        }
+        total += count;
+
+        if (!alive)
+        {
+            break;
+        }
+    }
+
+    VERIFY_ARE_EQUAL(static_cast<size_t>(producers * itemsPerProducer), total);
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
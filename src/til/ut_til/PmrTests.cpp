@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+namespace
+{
+    // Counts the allocations that reach it, so that the tests can tell when the arena allocates.
+    struct counting_resource : std::pmr::memory_resource
+    {
+        size_t allocations = 0;
+        size_t outstanding = 0;
+
+    private:
+        void* do_allocate(const size_t bytes, const size_t align) override
+        {
+            ++allocations;
+            ++outstanding;
+            return til::pmr::get_default_resource()->allocate(bytes, align);
+        }
+
+        void do_deallocate(void* const ptr, const size_t bytes, const size_t align) noexcept override
+        {
+            --outstanding;
+            til::pmr::get_default_resource()->deallocate(ptr, bytes, align);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+class PmrTests
+{
+    TEST_CLASS(PmrTests);
+
+    TEST_METHOD(ArenaAlignment)
+    {
+        counting_resource upstream;
+        til::pmr::arena arena{ &upstream };
+
+        for (const size_t align : { 1, 2, 4, 8, 16, 32, 64 })
+        {
+            const auto ptr = arena.allocate(3, align);
+            VERIFY_ARE_EQUAL(0u, reinterpret_cast<uintptr_t>(ptr) % align);
+        }
+    }
+
+    TEST_METHOD(ArenaLargeAllocation)
+    {
+        counting_resource upstream;
+        til::pmr::arena arena{ &upstream };
+
+        const auto small = arena.allocate(16);
+        const auto large = static_cast<char*>(arena.allocate(100000));
+        VERIFY_IS_TRUE(arena.capacity() >= 100000);
+        VERIFY_ARE_EQUAL(2u, upstream.allocations);
+
+        // The memory has to be usable, not just handed out.
+        std::fill_n(large, 100000, 'a');
+        VERIFY_ARE_NOT_EQUAL(small, static_cast<void*>(large));
+    }
+
+    TEST_METHOD(ArenaSteadyState)
+    {
+        counting_resource upstream;
+        til::pmr::arena arena{ &upstream };
+
+        const auto fill = [&]() {
+            std::pmr::vector<int> numbers{ &arena };
+            std::pmr::wstring text{ &arena };
+            for (int i = 0; i < 10000; ++i)
+            {
+                numbers.push_back(i);
+                text.push_back(L'a');
+            }
+        };
+
+        Log::Comment(L"The first round grows the arena a few times.");
+        fill();
+        VERIFY_IS_TRUE(upstream.allocations > 1);
+
+        Log::Comment(L"Resetting it replaces the blocks with a single one.");
+        arena.reset();
+        VERIFY_ARE_EQUAL(1u, upstream.outstanding);
+        const auto allocations = upstream.allocations;
+
+        Log::Comment(L"After that, the same work doesn't allocate anymore.");
+        for (int round = 0; round < 3; ++round)
+        {
+            fill();
+            arena.reset();
+        }
+        VERIFY_ARE_EQUAL(allocations, upstream.allocations);
+        VERIFY_ARE_EQUAL(1u, upstream.outstanding);
+    }
+
+    TEST_METHOD(ArenaReleasesOnDestruction)
+    {
+        counting_resource upstream;
+        {
+            til::pmr::arena arena{ &upstream };
+            arena.allocate(100);
+            arena.allocate(10000);
+        }
+        VERIFY_ARE_EQUAL(0u, upstream.outstanding);
+    }
+
+    TEST_METHOD(ArenaRelease)
+    {
+        counting_resource upstream;
+        til::pmr::arena arena{ &upstream };
+        arena.allocate(100);
+        arena.allocate(10000);
+
+        Log::Comment(L"Releasing the arena gives all of its blocks back.");
+        arena.release();
+        VERIFY_ARE_EQUAL(0u, upstream.outstanding);
+        VERIFY_ARE_EQUAL(0u, arena.capacity());
+
+        Log::Comment(L"It grows again when it's used afterwards.");
+        const auto ptr = static_cast<char*>(arena.allocate(100));
+        std::fill_n(ptr, 100, 'a');
+        VERIFY_ARE_EQUAL(1u, upstream.outstanding);
+    }
+};
@@ -207,6 +207,18 @@ class RunLengthEncodingTests
         VERIFY_ARE_EQUAL("1 1 1 1 1"sv, rle);
     }
 
+    TEST_METHOD(ConstructWithRuns)
+    {
+        const std::array<rle_type, 6> runs{ { { 1, 3 }, { 2, 0 }, { 1, 1 }, { 2, 2 }, { 3, 1 }, { 3, 2 } } };
+        rle_vector rle(runs.begin(), runs.end());
+        VERIFY_ARE_EQUAL(9u, rle.size());
+        VERIFY_ARE_EQUAL(3u, rle.runs().size());
+        VERIFY_ARE_EQUAL(std::string_view{ "1 1 1 1|2 2|3 3 3" }, rle);
+
+        rle_vector empty(runs.begin(), runs.begin());
+        VERIFY_IS_TRUE(empty.empty());
+    }
+
     TEST_METHOD(CopyAndMove)
     {
         constexpr auto expected_full = "1 1 1|2 2|1 1 1"sv;
@@ -378,6 +390,102 @@ class RunLengthEncodingTests
         }
     }
 
+    TEST_METHOD(ReplaceWithRange)
+    {
+        struct TestCase
+        {
+            std::string_view source;
+
+            size_type start_index;
+            size_type end_index;
+            size_type source_start;
+            size_type source_end;
+
+            std::string_view expected;
+        };
+
+        // The range of the other vector is taken out of "6|7 7|8 8 8|9".
+        std::array<TestCase, 9> test_cases{
+            {
+                { "1|3 3|2|1 1 1|5 5", 0, 9, 0, 7, "6|7 7|8 8 8|9" }, // all
+                { "1|3 3|2|1 1 1|5 5", 3, 7, 0, 0, "1|3 3|5 5" }, // empty range
+                { "1|3 3|2|1 1 1|5 5", 4, 4, 0, 7, "1|3 3|2|6|7 7|8 8 8|9|1 1 1|5 5" }, // insert
+                { "1|3 3|2|1 1 1|5 5", 2, 6, 4, 6, "1|3|8 8|1|5 5" }, // within a single run
+                { "1|3 3|2|1 1 1|5 5", 2, 6, 2, 5, "1|3|7|8 8|1|5 5" }, // across runs
+                { "1|3 3|2|1 1 1|5 5", 0, 3, 1, 5, "7 7|8 8|2|1 1 1|5 5" }, // beginning
+                { "1|3 3|2|1 1 1|5 5", 7, 9, 5, 9, "1|3 3|2|1 1 1|8|9" }, // end, source_end past the end
+                { "1|3 3|8|1 1 1|5 5", 4, 6, 3, 7, "1|3 3|8 8 8 8|9|1|5 5" }, // join with predecessor
+                { "6 6|2|7 7|5", 2, 3, 0, 2, "6 6 6|7 7 7|5" }, // join with both
+            }
+        };
+
+        const rle_vector other{ rle_encode("6|7 7|8 8 8|9") };
+        int idx = 0;
+
+        for (const auto& test_case : test_cases)
+        {
+            rle_vector rle{ rle_encode(test_case.source) };
+            rle.replace(test_case.start_index, test_case.end_index, other, test_case.source_start, test_case.source_end);
+
+            VERIFY_ARE_EQUAL(
+                test_case.expected,
+                rle,
+                NoThrowString().Format(
+                    L"test case:    %d\nsource:       %hs\nstart_index:  %u\nend_index:    %u\nsource_start: %u\nsource_end:   %u\nexpected:     %hs\nactual:       %s",
+                    idx,
+                    test_case.source.data(),
+                    test_case.start_index,
+                    test_case.end_index,
+                    test_case.source_start,
+                    test_case.source_end,
+                    test_case.expected.data(),
+                    rle.to_string().c_str()));
+
+            ++idx;
+        }
+
+        Log::Comment(L"The range may come from the vector itself.");
+        rle_vector rle{ rle_encode("1|2 2|3 3 3") };
+        rle.replace(0, 1, rle, 1, 6);
+        VERIFY_ARE_EQUAL(std::string_view{ "2 2|3 3 3|2 2|3 3 3" }, rle);
+    }
+
+    TEST_METHOD(InsertAndErase)
+    {
+        // Inserting characters into a row of a fixed width, the way ICH does.
+        rle_vector rle{ rle_encode("1|3 3|2|1 1 1|5 5") };
+        rle.insert(2, 3, 4);
+        VERIFY_ARE_EQUAL(std::string_view{ "1|3|4 4 4|3|2|1 1 1|5 5" }, rle);
+        rle.resize(9, 0);
+        VERIFY_ARE_EQUAL(std::string_view{ "1|3|4 4 4|3|2|1 1" }, rle);
+
+        // Deleting them again, the way DCH does.
+        rle.erase(2, 5);
+        VERIFY_ARE_EQUAL(std::string_view{ "1|3 3|2|1 1" }, rle);
+        rle.resize(9, 0);
+        VERIFY_ARE_EQUAL(std::string_view{ "1|3 3|2|1 1|0 0 0" }, rle);
+
+        // Joining with the neighbors.
+        rle.insert(1, 2, 3);
+        VERIFY_ARE_EQUAL(std::string_view{ "1|3 3 3 3|2|1 1|0 0 0" }, rle);
+        rle.erase(1, 5);
+        VERIFY_ARE_EQUAL(std::string_view{ "1|2|1 1|0 0 0" }, rle);
+        rle.erase(1, 2);
+        VERIFY_ARE_EQUAL(std::string_view{ "1 1 1|0 0 0" }, rle);
+        rle.resize(8, 0);
+        VERIFY_ARE_EQUAL(std::string_view{ "1 1 1|0 0 0 0 0" }, rle);
+
+        // Nothing to do.
+        rle.insert(3, 0, 7);
+        rle.erase(3, 3);
+        VERIFY_ARE_EQUAL(std::string_view{ "1 1 1|0 0 0 0 0" }, rle);
+
+        // Growing an empty vector.
+        rle_vector empty;
+        empty.resize(3, 4);
+        VERIFY_ARE_EQUAL(std::string_view{ "444" }, empty);
+    }
+
     TEST_METHOD(ReplaceValues)
     {
         struct TestCase
@@ -43,4 +43,75 @@ class MutexTests
         // .lock_shared() properly unlocked the mutex.
         auto lock = mutex.lock();
     }
+
+    TEST_METHOD(FairSharedMutexTryLock)
+    {
+        til::fair_shared_mutex mutex;
+
+        VERIFY_IS_TRUE(mutex.try_lock_shared());
+        VERIFY_IS_TRUE(mutex.try_lock_shared());
+        VERIFY_IS_FALSE(mutex.try_lock());
+        mutex.unlock_shared();
+        mutex.unlock_shared();
+
+        VERIFY_IS_TRUE(mutex.try_lock());
+        VERIFY_IS_FALSE(mutex.try_lock());
+        VERIFY_IS_FALSE(mutex.try_lock_shared());
+        mutex.unlock();
+
+        // Nobody had to wait for any of these.
+        const auto statistics = mutex.statistics();
+        VERIFY_ARE_EQUAL(uint64_t{ 0 }, statistics.shared_waits);
+        VERIFY_ARE_EQUAL(uint64_t{ 0 }, statistics.exclusive_waits);
+    }
+
+    TEST_METHOD(FairSharedMutexLetsWaitingReadersInFirst)
+    {
+        til::fair_shared_mutex mutex;
+        std::mutex orderMutex;
+        std::wstring order;
+        const auto record = [&](const wchar_t what) {
+            const std::lock_guard guard{ orderMutex };
+            order.push_back(what);
+        };
+
+        mutex.lock();
+
+        // A reader starts waiting for the writer that holds the lock...
+        std::thread reader{ [&]() {
+            mutex.lock_shared();
+            record(L'R');
+            mutex.unlock_shared();
+        } };
+        while (mutex.statistics().shared_waits != 1)
+        {
+            std::this_thread::yield();
+        }
+
+        // ...followed by another writer.
+        std::thread writer{ [&]() {
+            mutex.lock();
+            record(L'W');
+            mutex.unlock();
+        } };
+        while (mutex.statistics().exclusive_waits != 1)
+        {
+            std::this_thread::yield();
+        }
+
+        // While a writer is waiting, new readers don't get in either.
+        VERIFY_IS_FALSE(mutex.try_lock_shared());
+
+        // The reader that waited goes before the writer, even though
+        // the writer would've been able to take the lock just as well.
+        mutex.unlock();
+        reader.join();
+        writer.join();
+
+        VERIFY_ARE_EQUAL(std::wstring{ L"RW" }, order);
+
+        const auto statistics = mutex.statistics();
+        VERIFY_ARE_EQUAL(uint64_t{ 1 }, statistics.shared_waits);
+        VERIFY_ARE_EQUAL(uint64_t{ 1 }, statistics.exclusive_waits);
+    }
 };
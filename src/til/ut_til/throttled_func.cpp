@@ -39,4 +39,43 @@ class ThrottledFuncTests
 
         latch.wait();
     }
+
+    TEST_METHOD(Coalesced)
+    {
+        using namespace std::chrono_literals;
+        using throttled_func = til::throttled_func_trailing<int>;
+
+        til::latch latch{ 1 };
+        std::atomic<int> last{ 0 };
+
+        throttled_func tf{ 50ms, 400ms, [&](int value) {
+                              last = value;
+                              latch.count_down();
+                          } };
+        VERIFY_IS_TRUE(tf.delay() == 50ms);
+
+        // All but the first of these calls arrive while the first one is pending,
+        // so they only replace its arguments.
+        for (int i = 1; i <= 10; ++i)
+        {
+            tf(i);
+        }
+
+        latch.wait();
+        tf.flush();
+
+        VERIFY_ARE_EQUAL(10, last.load());
+        VERIFY_ARE_EQUAL(10u, tf.invocations());
+        VERIFY_ARE_EQUAL(9u, tf.coalesced());
+        VERIFY_IS_TRUE(tf.delay() >= 50ms && tf.delay() <= 400ms);
+    }
+
+    TEST_METHOD(InvalidDelay)
+    {
+        using namespace std::chrono_literals;
+        using throttled_func = til::throttled_func_trailing<>;
+
+        VERIFY_THROWS(throttled_func(0ms, [] {}), std::invalid_argument);
+        VERIFY_THROWS(throttled_func(50ms, 10ms, [] {}), std::invalid_argument);
+    }
 };
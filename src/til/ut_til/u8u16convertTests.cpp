@@ -17,6 +17,7 @@ class Utf8Utf16ConvertTests
     TEST_METHOD(TestU8ToU16Partials);
     TEST_METHOD(TestU16ToU8Partials);
     TEST_METHOD(TestU8ToU16OneByOne);
+    TEST_METHOD(TestU8ToU16LongAndIllFormed);
 };
 
 void Utf8Utf16ConvertTests::TestU8ToU16()
@@ -191,3 +192,40 @@ void Utf8Utf16ConvertTests::TestU8ToU16OneByOne()
     VERIFY_SUCCEEDED(til::u8u16(u8String1_4, u16Out1, state));
     VERIFY_ARE_EQUAL(u16StringComp1, u16Out1);
 }
+
+void Utf8Utf16ConvertTests::TestU8ToU16LongAndIllFormed()
+{
+    // Long enough for the vectorized ASCII path, with the multi-byte sequences
+    // (and the ill-formed ones) at every offset into the 16 byte blocks.
+    static constexpr std::string_view sequences[]{
+        "\xC3\xB6", // LATIN SMALL LETTER O WITH DIAERESIS
+        "\xE2\x82\xAC", // EURO SIGN
+        "\xF0\xA4\xBD\x9C", // CJK UNIFIED IDEOGRAPH-24F5C
+        "\xED\x9F\xBF", // U+D7FF, the last one before the surrogates
+        "\xF4\x8F\xBF\xBF", // U+10FFFF
+        "\x80", // lone continuation byte
+        "\xC0\xAF", // overlong SOLIDUS
+        "\xE0\x80\xAF", // overlong SOLIDUS
+        "\xED\xA0\x80", // encoded high surrogate
+        "\xF4\x90\x80\x80", // beyond U+10FFFF
+        "\xE2\x82", // truncated EURO SIGN
+        "\xFF",
+    };
+
+    for (const auto sequence : sequences)
+    {
+        for (size_t offset = 0; offset < 40; ++offset)
+        {
+            std::string u8String(offset, 'a');
+            u8String.append(sequence);
+            u8String.append(40, 'z');
+
+            std::wstring u16Expected(u8String.size(), L'\0');
+            u16Expected.resize(gsl::narrow_cast<size_t>(MultiByteToWideChar(CP_UTF8, 0, u8String.data(), gsl::narrow_cast<int>(u8String.size()), u16Expected.data(), gsl::narrow_cast<int>(u16Expected.size()))));
+
+            std::wstring u16Out{};
+            VERIFY_SUCCEEDED(til::u8u16(u8String, u16Out));
+            VERIFY_ARE_EQUAL(u16Expected, u16Out);
+        }
+    }
+}
@@ -13,6 +13,12 @@
 
 #include "U8U16Test.hpp"
 
+// til::u8u16 is measured against MultiByteToWideChar, which it used to call for all of its input
+#include <gsl/gsl>
+#include <wil/result_macros.h>
+#include <base/numerics/safe_math.h>
+#include <til/u8u16convert.h>
+
 typedef NTSTATUS(WINAPI* t_RtlUTF8ToUnicodeN)(PWSTR, ULONG, PULONG, PCCH, ULONG);
 typedef NTSTATUS(WINAPI* t_RtlUnicodeToUTF8N)(PCHAR, ULONG, PULONG, PCWSTR, ULONG);
 NTSTATUS(WINAPI* p_RtlUTF8ToUnicodeN)
@@ -233,6 +239,18 @@ void u8u16_ptr_WholeString(std::string_view u8Str)
               << "\n HRESULT " << hRes << "\n length " << u16Str.length() << "\n elapsed " << duration << std::endl;
 }
 
+void til_u8u16_WholeString(std::string_view u8Str)
+{
+    PrintHeader(__func__);
+    GetDuration();
+    std::wstring u16Str{};
+    const HRESULT hRes = til::u8u16(u8Str, u16Str);
+    const double duration = GetDuration();
+    const wchar_t randElem16 = u16Str.at(RandomIndex(static_cast<ptrdiff_t>(u16Str.length())));
+    std::cout << " ignore me " << static_cast<int>(randElem16)
+              << "\n HRESULT " << hRes << "\n length " << u16Str.length() << "\n elapsed " << duration << std::endl;
+}
+
 void MultiByteToWideChar_Chunks(std::string_view u8Str, size_t u8CharLen, size_t u16ChunkLen)
 {
     PrintHeader(__func__);
@@ -330,6 +348,61 @@ void u8u16_ptr_Chunks(std::string_view u8Str, size_t u8CharLen, size_t u16ChunkL
               << "\n HRESULT " << hRes << "\n length " << length << "\n elapsed " << duration << std::endl;
 }
 
+void til_u8u16_Chunks(std::string_view u8Str, size_t u8CharLen, size_t u16ChunkLen)
+{
+    PrintHeader(__func__);
+    const size_t endLoop{ u8Str.length() / u16ChunkLen };
+    double duration{};
+    size_t length{};
+    HRESULT hRes{};
+    std::wstring u16Str{};
+
+    for (size_t i{}; i < endLoop; i += u8CharLen)
+    {
+        const std::string_view sv{ &u8Str.at(i), u16ChunkLen * u8CharLen };
+        GetDuration();
+        hRes = til::u8u16(sv, u16Str);
+        duration += GetDuration();
+        length += u16Str.length();
+    }
+
+    const wchar_t randElem16 = u16Str.at(RandomIndex(static_cast<ptrdiff_t>(u16Str.length())));
+    std::cout << " ignore me " << static_cast<int>(randElem16)
+              << "\n HRESULT " << hRes << "\n length " << length << "\n elapsed " << duration << std::endl;
+}
+
+// converts random bytes, most of them ill-formed UTF-8, and checks that til::u8u16 replaces them the same way as MultiByteToWideChar
+void CompIllFormed()
+{
+    PrintHeader(__func__);
+    std::default_random_engine generator{ 0x13371337u };
+    std::uniform_int_distribution<int> byteDistribution{ 0, 255 };
+    std::uniform_int_distribution<size_t> lengthDistribution{ 1u, 64u };
+    std::string u8Str{};
+    std::wstring u16Str{};
+    size_t mismatches{};
+
+    for (int i{}; i < 100000; ++i)
+    {
+        u8Str.resize(lengthDistribution(generator));
+        // mostly ASCII, so that the ill-formed sequences are found in between the fast paths
+        for (auto& ch : u8Str)
+        {
+            const int byte = byteDistribution(generator);
+            ch = static_cast<char>(byte < 128 || byteDistribution(generator) < 64 ? byte : byte & 0x7F);
+        }
+
+        std::unique_ptr<wchar_t[]> u16Buffer{ std::make_unique<wchar_t[]>(u8Str.length()) };
+        const int length = MultiByteToWideChar(65001, 0, u8Str.data(), static_cast<int>(u8Str.length()), u16Buffer.get(), static_cast<int>(u8Str.length()));
+        if (FAILED(til::u8u16(u8Str, u16Str)) || std::wstring_view{ u16Buffer.get(), static_cast<size_t>(length) } != u16Str)
+        {
+            ++mismatches;
+        }
+    }
+
+    std::cout << " mismatches " << mismatches << std::endl;
+}
+
 void CompNaturalLang_WholeString(const std::string& fileName)
 {
     std::string head{ __func__ };
@@ -354,6 +427,12 @@ void CompNaturalLang_WholeString(const std::string& fileName)
     duration = GetDuration();
     std::cout << " u8u16_ptr           length " << u16Str.length() << " elapsed " << duration << std::endl;
 
+    GetDuration();
+    std::wstring tilU16Str{};
+    hRes = til::u8u16(u8Str, tilU16Str);
+    duration = GetDuration();
+    std::cout << " til::u8u16          length " << tilU16Str.length() << " elapsed " << duration << (tilU16Str == u16Str ? "" : " MISMATCH") << std::endl;
+
     GetDuration();
     std::unique_ptr<char[]> u8Buffer{ std::make_unique<char[]>(u16Str.length() * 3) };
     length = WideCharToMultiByte(65001, 0, u16Str.data(), static_cast<int>(u16Str.length()), u8Buffer.get(), static_cast<int>(u16Str.length()) * 3, nullptr, nullptr);
@@ -501,11 +580,17 @@ int main()
     RtlUTF8ToUnicodeN_WholeString(u8Str);
     u8u16_WholeString(u8Str);
     u8u16_ptr_WholeString(u8Str);
+    til_u8u16_WholeString(u8Str);
 
     MultiByteToWideChar_Chunks(u8Str, u8CharLen, chunkLen);
     RtlUTF8ToUnicodeN_Chunks(u8Str, u8CharLen, chunkLen);
     u8u16_Chunks(u8Str, u8CharLen, chunkLen);
     u8u16_ptr_Chunks(u8Str, u8CharLen, chunkLen);
+    til_u8u16_Chunks(u8Str, u8CharLen, chunkLen);
+
+    std::cout << "\n\n### Ill-Formed UTF-8 ###" << std::endl;
+
+    CompIllFormed();
 
     std::cout << "\n\n### Natural Languages ###" << std::endl;
 
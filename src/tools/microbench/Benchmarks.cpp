@@ -0,0 +1,339 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "Benchmarks.hpp"
+
+#include "til/static_map.h"
+
+#include "../../buffer/out/textBuffer.hpp"
+#include "../../renderer/inc/DummyRenderTarget.hpp"
+
+using namespace MicroBench;
+using namespace std::string_view_literals;
+
+volatile size_t MicroBench::Sink = 0;
+
+// Wide enough for most terminals, and one of the sizes the tests use as well.
+static constexpr COORD s_size{ 120, 30 };
+
+static DummyRenderTarget s_renderTarget;
+
+// The attributes of a row an application colored here and there, as runs of 4 to 11 cells.
+static til::small_rle<TextAttribute, uint16_t, 1> _coloredRow()
+{
+    til::small_rle<TextAttribute, uint16_t, 1> row{ static_cast<uint16_t>(s_size.X), TextAttribute{} };
+    for (uint16_t column = 0, i = 0; column < s_size.X; ++i)
+    {
+        const auto end = static_cast<uint16_t>(std::min(column + 4 + i % 8, static_cast<int>(s_size.X)));
+        row.replace(column, end, TextAttribute{ static_cast<WORD>(i % 16) });
+        column = end;
+    }
+    return row;
+}
+
+static Body _rleReplace()
+{
+    return [](const size_t iterations) {
+        auto row = _coloredRow();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            const auto start = static_cast<uint16_t>(i * 7 % (s_size.X - 8));
+            row.replace(start, static_cast<uint16_t>(start + 8), TextAttribute{ static_cast<WORD>(i % 16) });
+        }
+        Sink = row.runs().size();
+    };
+}
+
+static Body _rleIterate()
+{
+    return [](const size_t iterations) {
+        const auto row = _coloredRow();
+        size_t sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            for (const auto& attr : row)
+            {
+                sum += attr.GetLegacyAttributes();
+            }
+        }
+        Sink = sum;
+    };
+}
+
+static Body _bitmapSet()
+{
+    return [](const size_t iterations) {
+        til::bitmap map{ til::size{ s_size } };
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            // A write of a few cells, the most common kind of invalidation.
+            const auto x = static_cast<ptrdiff_t>(i * 13 % (s_size.X - 10));
+            const auto y = static_cast<ptrdiff_t>(i % s_size.Y);
+            map.set(til::rectangle{ til::point{ x, y }, til::size{ 10, 1 } });
+        }
+        Sink = map.one();
+    };
+}
+
+static Body _bitmapTranslate()
+{
+    return [](const size_t iterations) {
+        til::bitmap map{ til::size{ s_size } };
+        map.set(til::rectangle{ til::point{ 0, 0 }, til::size{ s_size.X / 2, s_size.Y } });
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            // Scrolling by a row, which makes the row revealed at the bottom dirty.
+            map.translate(til::point{ 0, -1 }, true);
+        }
+        Sink = map.any();
+    };
+}
+
+static Body _bitmapRuns()
+{
+    return [](const size_t iterations) {
+        til::bitmap map{ til::size{ s_size } };
+        size_t sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            // The runs are cached until the map changes, which it does before every frame.
+            map.reset_all();
+            for (ptrdiff_t y = 0; y < s_size.Y; y += 3)
+            {
+                map.set(til::rectangle{ til::point{ static_cast<ptrdiff_t>((i + y) % 60), y }, til::size{ 40, 2 } });
+            }
+            sum += map.runs().size();
+        }
+        Sink = sum;
+    };
+}
+
+static Body _spscThroughput()
+{
+    return [](const size_t iterations) {
+        auto [tx, rx] = til::spsc::channel<size_t>(4096);
+        std::thread consumer{ [rx = std::move(rx)]() {
+            std::array<size_t, 256> buffer{};
+            size_t sum = 0;
+            for (;;)
+            {
+                const auto [count, ok] = rx.pop_n(til::spsc::block_initially, buffer.begin(), buffer.size());
+                sum = std::accumulate(buffer.begin(), buffer.begin() + count, sum);
+                if (!ok)
+                {
+                    break;
+                }
+            }
+            Sink = sum;
+        } };
+
+        std::array<size_t, 256> batch{};
+        for (size_t i = 0; i < iterations; i += batch.size())
+        {
+            std::iota(batch.begin(), batch.end(), i);
+            tx.push_n(batch.begin(), std::min(batch.size(), iterations - i));
+        }
+
+        // Dropping the producer ends the channel, once the consumer has read everything.
+        {
+            const auto drop = std::move(tx);
+        }
+        consumer.join();
+    };
+}
+
+// 4 KiB of output, the size of a read from ConPTY.
+static constexpr size_t s_textSize = 4096;
+
+static std::string _utf8Text(const std::string_view piece)
+{
+    std::string text;
+    while (text.size() + piece.size() <= s_textSize)
+    {
+        text.append(piece);
+    }
+    return text;
+}
+
+static Body _u8u16Ascii()
+{
+    return [](const size_t iterations) {
+        const auto text = _utf8Text("The quick brown fox jumps over the lazy dog.\r\n"sv);
+        std::wstring out;
+        size_t sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            THROW_IF_FAILED(til::u8u16(text, out));
+            sum += out.size();
+        }
+        Sink = sum;
+    };
+}
+
+static Body _u8u16Cjk()
+{
+    return [](const size_t iterations) {
+        const auto text = _utf8Text("\xe4\xb8\xad\xe6\x96\x87\xe6\xb5\x8b\xe8\xaf\x95 \xf0\x9f\x98\x80 caf\xc3\xa9 "sv);
+        std::wstring out;
+        size_t sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            THROW_IF_FAILED(til::u8u16(text, out));
+            sum += out.size();
+        }
+        Sink = sum;
+    };
+}
+
+static Body _u16u8()
+{
+    return [](const size_t iterations) {
+        const auto text = til::u8u16(_utf8Text("The quick brown fox jumps over the lazy dog.\r\n"sv));
+        std::string out;
+        size_t sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            THROW_IF_FAILED(til::u16u8(text, out));
+            sum += out.size();
+        }
+        Sink = sum;
+    };
+}
+
+static Body _staticMapAt()
+{
+    return [](const size_t iterations) {
+        // Like the tables of color names and settings keys, looked up by a string.
+        static constexpr til::static_map map{
+            std::pair{ "black"sv, 0 },
+            std::pair{ "red"sv, 1 },
+            std::pair{ "green"sv, 2 },
+            std::pair{ "yellow"sv, 3 },
+            std::pair{ "blue"sv, 4 },
+            std::pair{ "purple"sv, 5 },
+            std::pair{ "cyan"sv, 6 },
+            std::pair{ "white"sv, 7 },
+            std::pair{ "brightBlack"sv, 8 },
+            std::pair{ "brightRed"sv, 9 },
+            std::pair{ "brightGreen"sv, 10 },
+            std::pair{ "brightYellow"sv, 11 },
+            std::pair{ "brightBlue"sv, 12 },
+            std::pair{ "brightPurple"sv, 13 },
+            std::pair{ "brightCyan"sv, 14 },
+            std::pair{ "brightWhite"sv, 15 },
+        };
+        static constexpr std::array keys{
+            "cyan"sv, "brightWhite"sv, "black"sv, "brightRed"sv, "yellow"sv, "brightPurple"sv, "green"sv, "white"sv
+        };
+
+        size_t sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            sum += map.at(til::at(keys, i % keys.size()));
+        }
+        Sink = sum;
+    };
+}
+
+static std::wstring _rowText(const size_t length)
+{
+    std::wstring text;
+    for (size_t i = 0; i < length; ++i)
+    {
+        text.push_back(static_cast<wchar_t>(L'!' + i % 94));
+    }
+    return text;
+}
+
+static Body _rowWriteCells()
+{
+    return [](const size_t iterations) {
+        TextBuffer buffer{ s_size, TextAttribute{}, 0, s_renderTarget };
+        auto& row = buffer.GetRowByOffset(0);
+        const auto text = _rowText(s_size.X);
+        const TextAttribute attr{ FOREGROUND_GREEN };
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            row.WriteCells(OutputCellIterator{ text, attr }, 0);
+        }
+        Sink = row.GetCharRow().MeasureRight();
+    };
+}
+
+static Body _charRowMeasureRight()
+{
+    return [](const size_t iterations) {
+        TextBuffer buffer{ s_size, TextAttribute{}, 0, s_renderTarget };
+        auto& row = buffer.GetRowByOffset(0);
+        row.WriteCells(OutputCellIterator{ _rowText(s_size.X * 2 / 3) }, 0);
+        const auto& charRow = row.GetCharRow();
+        size_t sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            sum += charRow.MeasureRight();
+        }
+        Sink = sum;
+    };
+}
+
+static Body _textBufferIncrementCircularBuffer()
+{
+    return [](const size_t iterations) {
+        // The default scrollback of Windows Terminal.
+        TextBuffer buffer{ COORD{ s_size.X, 9001 }, TextAttribute{}, 0, s_renderTarget };
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            buffer.IncrementCircularBuffer();
+        }
+        Sink = buffer.GetFirstRowIndex();
+    };
+}
+
+static Body _textBufferReflow()
+{
+    return [](const size_t iterations) {
+        // Lines of all kinds of lengths, some of which wrap, in a buffer narrowed to two thirds of its width.
+        static constexpr COORD oldSize{ s_size.X, 1000 };
+        static constexpr COORD newSize{ s_size.X * 2 / 3, 1000 };
+
+        TextBuffer oldBuffer{ oldSize, TextAttribute{}, 0, s_renderTarget };
+        for (SHORT y = 0, line = 0; y < oldSize.Y - 2; ++line)
+        {
+            // The lines longer than the buffer is wide wrap into the next row.
+            const auto length = static_cast<size_t>(line * 37 % (oldSize.X * 3 / 2));
+            oldBuffer.Write(OutputCellIterator{ _rowText(length) }, COORD{ 0, y });
+            y += length > static_cast<size_t>(oldSize.X) ? 2 : 1;
+        }
+
+        size_t sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            TextBuffer newBuffer{ newSize, TextAttribute{}, 0, s_renderTarget };
+            THROW_IF_FAILED(TextBuffer::Reflow(oldBuffer, newBuffer, std::nullopt, std::nullopt));
+            sum += static_cast<size_t>(newBuffer.GetCursor().GetPosition().Y);
+        }
+        Sink = sum;
+    };
+}
+
+const std::vector<Benchmark>& MicroBench::GetBenchmarks()
+{
+    static const std::vector<Benchmark> benchmarks{
+        { L"til::small_rle/replace", L"replacing 8 cells of a row with 20 runs", &_rleReplace },
+        { L"til::small_rle/iterate", L"iterating a row of 120 cells in 20 runs", &_rleIterate },
+        { L"til::bitmap/set", L"setting a rectangle of 10x1 cells", &_bitmapSet },
+        { L"til::bitmap/translate", L"scrolling a 120x30 map by a row", &_bitmapTranslate },
+        { L"til::bitmap/runs", L"setting 10 rectangles and getting the runs", &_bitmapRuns },
+        { L"til::spsc/throughput", L"sending an item to another thread in batches of 256", &_spscThroughput },
+        { L"til::u8u16/ascii", L"converting 4 KiB of ASCII to UTF-16", &_u8u16Ascii },
+        { L"til::u8u16/cjk", L"converting 4 KiB of CJK, emoji and Latin-1 to UTF-16", &_u8u16Cjk },
+        { L"til::u16u8/ascii", L"converting 4 KiB of ASCII to UTF-8", &_u16u8 },
+        { L"til::static_map/at", L"looking up a string in a map of 16", &_staticMapAt },
+        { L"ROW::WriteCells", L"writing 120 colored cells into a row", &_rowWriteCells },
+        { L"CharRow::MeasureRight", L"measuring a row with 80 cells of text", &_charRowMeasureRight },
+        { L"TextBuffer::IncrementCircularBuffer", L"advancing a buffer with 9001 rows by a row", &_textBufferIncrementCircularBuffer },
+        { L"TextBuffer::Reflow", L"reflowing 1000 rows from 120 to 80 columns", &_textBufferReflow },
+    };
+    return benchmarks;
+}
@@ -0,0 +1,35 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Benchmarks.hpp
+
+Abstract:
+- The benchmarks MicroBench runs: til's containers and string conversions, and
+  the primitives of the text buffer that everything else is built from.
+- Each benchmark prepares its data once and then returns the function that's
+  measured. That function is given a number of iterations and repeats one
+  operation as often, for instance a single replace of a run, or a whole reflow.
+--*/
+
+#pragma once
+
+namespace MicroBench
+{
+    using Body = std::function<void(const size_t iterations)>;
+
+    struct Benchmark
+    {
+        // The names are what the results are compared by, so they better not change.
+        const wchar_t* name;
+        const wchar_t* operation;
+        Body (*setup)();
+    };
+
+    const std::vector<Benchmark>& GetBenchmarks();
+
+    // Benchmarks store what they computed into this once they're done,
+    // so that the compiler can't drop the computation.
+    extern volatile size_t Sink;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "Benchmarks.hpp"
+
+using namespace MicroBench;
+
+// Each measurement repeats the operation for about this long, so
+// that the resolution of the clock doesn't matter.
+static constexpr std::chrono::milliseconds s_minimumDuration{ 100 };
+
+static double Measure(const Body& body, const size_t iterations)
+{
+    const auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+struct Result
+{
+    size_t iterations{ 0 };
+    // Nanoseconds per operation, of the fastest and the median repetition.
+    double fastest{ 0 };
+    double median{ 0 };
+};
+
+static Result Run(const Benchmark& benchmark, const size_t repetitions)
+{
+    const auto body = benchmark.setup();
+
+    // The number of iterations is doubled until they take long enough. This warms up the caches as well.
+    Result result;
+    result.iterations = 1;
+    while (Measure(body, result.iterations) < std::chrono::duration<double, std::nano>{ s_minimumDuration }.count())
+    {
+        result.iterations *= 2;
+    }
+
+    std::vector<double> times;
+    for (size_t i = 0; i < repetitions; ++i)
+    {
+        times.push_back(Measure(body, result.iterations) / result.iterations);
+    }
+    std::sort(times.begin(), times.end());
+
+    result.fastest = times.front();
+    result.median = times[times.size() / 2];
+    return result;
+}
+
+static void PrintUsage()
+{
+    wprintf(L"Usage: MicroBench.exe [-r <repetitions>] [<filter>...]\r\n");
+    wprintf(L"Measures the primitives of til and the text buffer. Without any filters, all\r\n");
+    wprintf(L"benchmarks are run, otherwise those whose names contain one of the filters.\r\n\r\n");
+    wprintf(L"The results are printed as tab separated values, one line per benchmark in\r\n");
+    wprintf(L"the order below: the name, the number of iterations of each repetition and the\r\n");
+    wprintf(L"nanoseconds per iteration of the fastest and of the median repetition.\r\n\r\n");
+    wprintf(L"Benchmarks:\r\n");
+    for (const auto& benchmark : GetBenchmarks())
+    {
+        wprintf(L"  %-38s %s\r\n", benchmark.name, benchmark.operation);
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    size_t repetitions = 5;
+    std::vector<std::wstring_view> filters;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-r" && i + 1 < argc)
+        {
+            repetitions = std::max<size_t>(wcstoul(argv[++i], nullptr, 10), 1);
+        }
+        else if (arg.empty() || arg[0] == L'-')
+        {
+            PrintUsage();
+            return E_INVALIDARG;
+        }
+        else
+        {
+            filters.push_back(arg);
+        }
+    }
+
+    wprintf(L"benchmark\titerations\tfastest ns/op\tmedian ns/op\r\n");
+    for (const auto& benchmark : GetBenchmarks())
+    {
+        const std::wstring_view name{ benchmark.name };
+        if (!filters.empty() && std::none_of(filters.begin(), filters.end(), [&](const auto& filter) { return name.find(filter) != std::wstring_view::npos; }))
+        {
+            continue;
+        }
+
+        const auto result = Run(benchmark, repetitions);
+        wprintf(L"%s\t%zu\t%.2f\t%.2f\r\n", benchmark.name, result.iterations, result.fastest, result.median);
+    }
+
+    return 0;
+}
+CATCH_RETURN()
@@ -0,0 +1,17 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- precomp.h
+
+Abstract:
+- Contains external headers to include in the precompile phase of console build
+  process.
+- MicroBench measures til and the text buffer, so it shares the text buffer's
+  headers.
+--*/
+
+#pragma once
+
+#include "../../buffer/out/precomp.h"
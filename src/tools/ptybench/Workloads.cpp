@@ -0,0 +1,263 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "Workloads.hpp"
+
+using namespace PtyBench;
+
+namespace
+{
+    // The workloads are generated with a fixed seed, so that every run writes the same output.
+    class Random
+    {
+    public:
+        uint32_t Next(const uint32_t range) noexcept
+        {
+            _state = _state * 1664525 + 1013904223;
+            return (_state >> 8) % range;
+        }
+
+    private:
+        uint32_t _state{ 0x13371337 };
+    };
+
+    // Makes the probes of a workload. The progress probes are rate limited, so
+    // that the titles don't become a workload of their own.
+    class Prober
+    {
+    public:
+        Prober(const HANDLE output) :
+            _output{ output }
+        {
+            DWORD mode = 0;
+            GetConsoleMode(_output, &mode);
+            _vt = WI_IsFlagSet(mode, ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+            QueryPerformanceFrequency(&_frequency);
+        }
+
+        void Begin()
+        {
+            _Send(ProbeBegin, _Now());
+        }
+
+        void Progress()
+        {
+            const auto now = _Now();
+            if (now - _last >= _frequency.QuadPart / 100)
+            {
+                _Send(ProbeProgress, now);
+            }
+        }
+
+        void End()
+        {
+            _Send(ProbeEnd, _Now());
+        }
+
+    private:
+        static int64_t _Now() noexcept
+        {
+            LARGE_INTEGER now;
+            QueryPerformanceCounter(&now);
+            return now.QuadPart;
+        }
+
+        // With VT processing enabled, the title is set the way a VT application
+        // would, so that it goes through the same path as the rest of the output.
+        void _Send(const wchar_t kind, const int64_t now)
+        {
+            const auto title = fmt::format(L"{}{};{}", ProbePrefix, kind, now);
+            if (_vt)
+            {
+                const auto sequence = fmt::format(L"\x1b]0;{}\x7", title);
+                WriteConsoleW(_output, sequence.data(), gsl::narrow_cast<DWORD>(sequence.size()), nullptr, nullptr);
+            }
+            else
+            {
+                SetConsoleTitleW(title.c_str());
+            }
+            _last = now;
+        }
+
+        HANDLE _output;
+        bool _vt{ false };
+        LARGE_INTEGER _frequency{};
+        int64_t _last{ 0 };
+    };
+
+    HANDLE PrepareOutput(const bool vt)
+    {
+        const auto output = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        GetConsoleMode(output, &mode);
+        WI_UpdateFlag(mode, ENABLE_VIRTUAL_TERMINAL_PROCESSING, vt);
+        SetConsoleMode(output, mode);
+        return output;
+    }
+
+    void Write(const HANDLE output, const std::wstring_view text)
+    {
+        WriteConsoleW(output, text.data(), gsl::narrow_cast<DWORD>(text.size()), nullptr, nullptr);
+    }
+
+    COORD GetWindowSize(const HANDLE output)
+    {
+        CONSOLE_SCREEN_BUFFER_INFO info{};
+        GetConsoleScreenBufferInfo(output, &info);
+        return { gsl::narrow_cast<SHORT>(info.srWindow.Right - info.srWindow.Left + 1),
+                 gsl::narrow_cast<SHORT>(info.srWindow.Bottom - info.srWindow.Top + 1) };
+    }
+
+    // Plain text, the way a build or a log scrolls by, written in large chunks
+    // and without VT processing.
+    void RunBulkWrite(const size_t size)
+    {
+        static constexpr std::wstring_view words[]{ L"the", L"quick", L"brown", L"fox", L"jumps", L"over", L"lazy", L"dog", L"compiling", L"linking", L"src\\host\\output.cpp", L"warning", L"0x80070005" };
+
+        const auto output = PrepareOutput(false);
+        Prober prober{ output };
+        Random random;
+        std::wstring chunk;
+        size_t written = 0;
+
+        prober.Begin();
+        while (written < size)
+        {
+            chunk.clear();
+            while (chunk.size() < 16 * 1024)
+            {
+                const auto length = 20 + random.Next(80);
+                for (size_t start = chunk.size(); chunk.size() - start < length;)
+                {
+                    chunk.append(words[random.Next(ARRAYSIZE(words))]);
+                    chunk.push_back(L' ');
+                }
+                chunk.append(L"\r\n");
+            }
+            Write(output, chunk);
+            written += chunk.size();
+            prober.Progress();
+        }
+        prober.End();
+    }
+
+    // Colored text with the occasional redraw of the status line, the way
+    // syntax highlighting and progress bars look.
+    void RunVtWrite(const size_t size)
+    {
+        const auto output = PrepareOutput(true);
+        Prober prober{ output };
+        Random random;
+        std::wstring chunk;
+        size_t written = 0;
+        size_t line = 0;
+
+        prober.Begin();
+        while (written < size)
+        {
+            chunk.clear();
+            while (chunk.size() < 16 * 1024)
+            {
+                const auto words = 4 + random.Next(12);
+                for (uint32_t i = 0; i < words; ++i)
+                {
+                    fmt::format_to(std::back_inserter(chunk),
+                                   FMT_COMPILE(L"\x1b[38;2;{};{};{}m{}word{}\x1b[m "),
+                                   random.Next(256),
+                                   random.Next(256),
+                                   random.Next(256),
+                                   random.Next(2) ? L"\x1b[1m" : L"",
+                                   random.Next(1000));
+                }
+                chunk.append(L"\r\n");
+
+                if (++line % 32 == 0)
+                {
+                    fmt::format_to(std::back_inserter(chunk), FMT_COMPILE(L"\x1b[s\x1b[1;1H\x1b[7m progress {:>6} \x1b[m\x1b[K\x1b[u"), line);
+                }
+            }
+            Write(output, chunk);
+            written += chunk.size();
+            prober.Progress();
+        }
+        prober.End();
+    }
+
+    // WriteConsoleOutputW of the whole window, over and over, the way full
+    // screen applications written against the console API draw.
+    void RunLegacyOutput(const size_t size)
+    {
+        const auto output = PrepareOutput(false);
+        Prober prober{ output };
+        Random random;
+        const auto windowSize = GetWindowSize(output);
+        const auto cells = static_cast<size_t>(windowSize.X) * windowSize.Y;
+        std::vector<CHAR_INFO> buffer(cells);
+        size_t written = 0;
+
+        prober.Begin();
+        while (written < size)
+        {
+            for (auto& cell : buffer)
+            {
+                cell.Char.UnicodeChar = gsl::narrow_cast<wchar_t>(L'!' + random.Next(94));
+                cell.Attributes = gsl::narrow_cast<WORD>(random.Next(256));
+            }
+            SMALL_RECT region{ 0, 0, gsl::narrow_cast<SHORT>(windowSize.X - 1), gsl::narrow_cast<SHORT>(windowSize.Y - 1) };
+            WriteConsoleOutputW(output, buffer.data(), windowSize, {}, &region);
+            written += cells;
+            prober.Progress();
+        }
+        prober.End();
+    }
+
+    // Short strings all over the window, each with its own cursor position and
+    // attributes, the way a TUI updates its widgets.
+    void RunCursorHeavy(const size_t size)
+    {
+        static constexpr std::wstring_view labels[]{ L"[ok]", L"47%", L"x", L"CPU", L"12:00:01", L"|", L"--", L"MEM 1.2G" };
+
+        const auto output = PrepareOutput(false);
+        Prober prober{ output };
+        Random random;
+        const auto windowSize = GetWindowSize(output);
+        size_t written = 0;
+
+        prober.Begin();
+        while (written < size)
+        {
+            for (auto i = 0; i < 256; ++i)
+            {
+                const auto& label = labels[random.Next(ARRAYSIZE(labels))];
+                const COORD position{ gsl::narrow_cast<SHORT>(random.Next(std::max(windowSize.X - 8, 1))), gsl::narrow_cast<SHORT>(random.Next(windowSize.Y)) };
+                SetConsoleCursorPosition(output, position);
+                SetConsoleTextAttribute(output, gsl::narrow_cast<WORD>(random.Next(256)));
+                Write(output, label);
+                written += label.size();
+            }
+            prober.Progress();
+        }
+        prober.End();
+    }
+
+    const std::vector<Workload> s_workloads{
+        { L"write", L"Bulk plain text through WriteConsoleW", RunBulkWrite, false },
+        { L"vt", L"Colored text and cursor movement through VT sequences", RunVtWrite, false },
+        { L"legacy", L"Full window updates through WriteConsoleOutputW", RunLegacyOutput, false },
+        { L"tui", L"Short strings at random positions with SetConsoleCursorPosition", RunCursorHeavy, false },
+        { L"resize", L"Bulk plain text while the pseudoconsole is resized", RunBulkWrite, true },
+    };
+}
+
+const std::vector<Workload>& PtyBench::GetWorkloads()
+{
+    return s_workloads;
+}
+
+const Workload* PtyBench::FindWorkload(const std::wstring_view name) noexcept
+{
+    const auto it = std::find_if(s_workloads.begin(), s_workloads.end(), [&](const auto& workload) { return workload.name == name; });
+    return it == s_workloads.end() ? nullptr : &*it;
+}
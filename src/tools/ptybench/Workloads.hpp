@@ -0,0 +1,39 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Workloads.hpp
+
+Abstract:
+- The workloads PtyBench runs in its client, attached to the pseudoconsole.
+- Each workload brackets its output with probes, title changes which carry the
+  time they were made. The host finds them in the output of the pseudoconsole
+  to tell when the workload started and ended, and how long its output took to
+  come through.
+--*/
+
+#pragma once
+
+namespace PtyBench
+{
+    // The title of a probe is the prefix, the kind of probe, a separator and
+    // the QueryPerformanceCounter value when the client made it.
+    inline constexpr std::wstring_view ProbePrefix{ L"ptybench;" };
+    inline constexpr wchar_t ProbeBegin = L'b';
+    inline constexpr wchar_t ProbeProgress = L'p';
+    inline constexpr wchar_t ProbeEnd = L'e';
+
+    struct Workload
+    {
+        const wchar_t* name;
+        const wchar_t* description;
+        // Writes about the given number of characters (or cells) to the console.
+        void (*run)(const size_t size);
+        // Whether the host keeps resizing the pseudoconsole while the workload runs.
+        bool resizes;
+    };
+
+    const std::vector<Workload>& GetWorkloads();
+    const Workload* FindWorkload(const std::wstring_view name) noexcept;
+}
@@ -0,0 +1,469 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "../../winconpty/winconpty.h"
+#include "Workloads.hpp"
+
+using namespace PtyBench;
+
+static constexpr COORD s_size{ 120, 30 };
+static constexpr COORD s_resizedSize{ 100, 40 };
+static constexpr std::wstring_view s_clientArg{ L"--client" };
+
+// How long a workload may take, from its start until its last output has come through.
+static constexpr DWORD s_workloadTimeout = 5 * 60 * 1000;
+
+static int64_t Now() noexcept
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+static double Seconds(const int64_t ticks) noexcept
+{
+    static const auto frequency = [] {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        return static_cast<double>(frequency.QuadPart);
+    }();
+    return ticks / frequency;
+}
+
+static double Seconds(const FILETIME& time) noexcept
+{
+    return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+}
+
+struct CpuTime
+{
+    double user{ 0 };
+    double kernel{ 0 };
+};
+
+static CpuTime GetCpuTime(const HANDLE process) noexcept
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(process, &creation, &exit, &kernel, &user))
+    {
+        return {};
+    }
+    return { Seconds(user), Seconds(kernel) };
+}
+
+// What the host measured of one workload.
+struct Result
+{
+    const Workload* workload{ nullptr };
+    bool completed{ false };
+    size_t outputBytes{ 0 };
+    double seconds{ 0 };
+    std::vector<double> latencies;
+    CpuTime conhostCpuTime;
+};
+
+// Reads the output of the pseudoconsole until it closes, and finds the probes
+// of the client in it. Everything the reader measures is only accessed by the
+// host once the reader is done, except for the event it sets at the end probe.
+class OutputReader
+{
+public:
+    OutputReader(wil::unique_hfile pipe, const HANDLE conhost) :
+        _pipe{ std::move(pipe) },
+        _conhost{ conhost }
+    {
+        _ended.create(wil::EventOptions::ManualReset);
+        _thread = std::thread{ [this] { _Read(); } };
+    }
+
+    ~OutputReader()
+    {
+        // If the workload failed before the pipe was closed, the read is stuck.
+        if (_thread.joinable())
+        {
+            CancelSynchronousIo(_thread.native_handle());
+            _thread.join();
+        }
+    }
+
+    HANDLE Ended() const noexcept
+    {
+        return _ended.get();
+    }
+
+    void Finish(Result& result)
+    {
+        _thread.join();
+
+        result.latencies = std::move(_latencies);
+        result.completed = _ended.is_signaled() && _beginTime != 0;
+        if (result.completed)
+        {
+            result.outputBytes = _endBytes - _beginBytes;
+            result.seconds = Seconds(_endTime - _beginTime);
+            result.conhostCpuTime = { _endCpuTime.user - _beginCpuTime.user, _endCpuTime.kernel - _beginCpuTime.kernel };
+        }
+    }
+
+private:
+    // The probes are titles, which conhost sends to the terminal as an OSC 0.
+    static constexpr std::string_view s_probeStart{ "\x1b]0;ptybench;" };
+    static constexpr size_t s_maxProbeLength = 64;
+
+    void _Read()
+    {
+        std::vector<char> buffer(64 * 1024);
+        std::string text;
+        DWORD read = 0;
+        while (ReadFile(_pipe.get(), buffer.data(), gsl::narrow_cast<DWORD>(buffer.size()), &read, nullptr) && read > 0)
+        {
+            const auto now = Now();
+            _bytes += read;
+
+            // A probe may be split across reads, so the end of the previous read is kept around.
+            text.append(buffer.data(), read);
+            const auto scanned = _Scan(text, now);
+            text.erase(0, std::max(scanned, text.size() > s_maxProbeLength ? text.size() - s_maxProbeLength : 0));
+        }
+    }
+
+    // Returns how much of the text has been handled.
+    size_t _Scan(const std::string_view text, const int64_t now)
+    {
+        size_t scanned = 0;
+        for (auto start = text.find(s_probeStart); start != std::string_view::npos; start = text.find(s_probeStart, scanned))
+        {
+            const auto end = text.find('\x7', start);
+            if (end == std::string_view::npos)
+            {
+                break;
+            }
+
+            // The probe is the kind, a separator and the time it was made.
+            const auto probe = text.substr(start + s_probeStart.size(), end - start - s_probeStart.size());
+            if (probe.size() > 2 && probe[1] == ';')
+            {
+                _Probe(static_cast<wchar_t>(probe[0]), std::strtoll(std::string{ probe.substr(2) }.c_str(), nullptr, 10), now);
+            }
+            scanned = end + 1;
+        }
+        return scanned;
+    }
+
+    void _Probe(const wchar_t kind, const int64_t time, const int64_t now)
+    {
+        switch (kind)
+        {
+        case ProbeBegin:
+            _beginTime = time;
+            _beginBytes = _bytes;
+            _beginCpuTime = GetCpuTime(_conhost);
+            break;
+        case ProbeProgress:
+            _latencies.push_back(Seconds(now - time) * 1000);
+            break;
+        case ProbeEnd:
+            _latencies.push_back(Seconds(now - time) * 1000);
+            _endTime = now;
+            _endBytes = _bytes;
+            _endCpuTime = GetCpuTime(_conhost);
+            _ended.SetEvent();
+            break;
+        default:
+            break;
+        }
+    }
+
+    wil::unique_hfile _pipe;
+    HANDLE _conhost;
+    wil::unique_event _ended;
+    std::thread _thread;
+
+    size_t _bytes{ 0 };
+    size_t _beginBytes{ 0 };
+    size_t _endBytes{ 0 };
+    int64_t _beginTime{ 0 };
+    int64_t _endTime{ 0 };
+    CpuTime _beginCpuTime;
+    CpuTime _endCpuTime;
+    std::vector<double> _latencies;
+};
+
+static std::wstring GetModulePath()
+{
+    return wil::GetModuleFileNameW<std::wstring>(nullptr);
+}
+
+static std::wstring GetProcessPath(const HANDLE process)
+{
+    wchar_t path[MAX_PATH];
+    DWORD length = ARRAYSIZE(path);
+    return QueryFullProcessImageNameW(process, 0, path, &length) ? std::wstring{ path, length } : std::wstring{};
+}
+
+// Runs one workload in a client attached to a fresh pseudoconsole.
+static Result RunWorkload(const Workload& workload, const size_t size, const DWORD flags, std::wstring& conhostPath)
+{
+    Result result;
+    result.workload = &workload;
+
+    wil::unique_hfile inputRead, inputWrite, outputRead, outputWrite;
+    THROW_IF_WIN32_BOOL_FALSE(CreatePipe(inputRead.addressof(), inputWrite.addressof(), nullptr, 0));
+    THROW_IF_WIN32_BOOL_FALSE(CreatePipe(outputRead.addressof(), outputWrite.addressof(), nullptr, 0));
+
+    PseudoConsole pty{};
+    THROW_IF_FAILED(_CreatePseudoConsole(INVALID_HANDLE_VALUE, s_size, inputRead.get(), outputWrite.get(), flags, &pty));
+    auto closePty = wil::scope_exit([&] { _ClosePseudoConsoleMembers(&pty); });
+    inputRead.reset();
+    outputWrite.reset();
+    conhostPath = GetProcessPath(pty.hConPtyProcess);
+
+    OutputReader reader{ std::move(outputRead), pty.hConPtyProcess };
+
+    SIZE_T attributeListSize = 0;
+    InitializeProcThreadAttributeList(nullptr, 1, 0, &attributeListSize);
+    auto attributeList = std::make_unique<std::byte[]>(attributeListSize);
+    STARTUPINFOEXW siEx{};
+    siEx.StartupInfo.cb = sizeof(siEx);
+    siEx.lpAttributeList = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeList.get());
+    THROW_IF_WIN32_BOOL_FALSE(InitializeProcThreadAttributeList(siEx.lpAttributeList, 1, 0, &attributeListSize));
+    auto deleteAttributeList = wil::scope_exit([&] { DeleteProcThreadAttributeList(siEx.lpAttributeList); });
+    HPCON hpcon = reinterpret_cast<HPCON>(&pty);
+    THROW_IF_WIN32_BOOL_FALSE(UpdateProcThreadAttribute(siEx.lpAttributeList, 0, PROC_THREAD_ATTRIBUTE_PSEUDOCONSOLE, hpcon, sizeof(hpcon), nullptr, nullptr));
+
+    auto commandline = fmt::format(L"\"{}\" {} {} {}", GetModulePath(), s_clientArg, workload.name, size);
+    wil::unique_process_information client;
+    THROW_IF_WIN32_BOOL_FALSE(CreateProcessW(nullptr, commandline.data(), nullptr, nullptr, FALSE, EXTENDED_STARTUPINFO_PRESENT, nullptr, nullptr, &siEx.StartupInfo, &client));
+
+    // A resize storm alternates between two sizes for as long as the workload runs.
+    std::thread resizer;
+    if (workload.resizes)
+    {
+        resizer = std::thread{ [&] {
+            for (auto resized = true; WaitForSingleObject(reader.Ended(), 10) == WAIT_TIMEOUT; resized = !resized)
+            {
+                if (FAILED(_ResizePseudoConsole(&pty, resized ? s_resizedSize : s_size)))
+                {
+                    break;
+                }
+            }
+        } };
+    }
+
+    // The client waits for a key once it's done, so that the pseudoconsole is
+    // kept alive until its last output has come through.
+    const HANDLE handles[]{ reader.Ended(), client.hProcess };
+    if (WaitForMultipleObjects(ARRAYSIZE(handles), handles, FALSE, s_workloadTimeout) == WAIT_OBJECT_0)
+    {
+        DWORD written = 0;
+        WriteFile(inputWrite.get(), "\r", 1, &written, nullptr);
+    }
+    if (WaitForSingleObject(client.hProcess, 10 * 1000) != WAIT_OBJECT_0)
+    {
+        TerminateProcess(client.hProcess, 1);
+    }
+    if (resizer.joinable())
+    {
+        resizer.join();
+    }
+
+    // Closing the pseudoconsole waits for conhost to exit, which closes the pipe and ends the reader.
+    closePty.reset();
+    reader.Finish(result);
+    return result;
+}
+
+static int RunClient(const std::wstring_view name, const size_t size)
+{
+    const auto workload = FindWorkload(name);
+    if (!workload)
+    {
+        return E_INVALIDARG;
+    }
+
+    workload->run(size);
+
+    // Wait for the host to tell us that it has seen all of our output.
+    const auto input = GetStdHandle(STD_INPUT_HANDLE);
+    SetConsoleMode(input, 0);
+    WaitForSingleObject(input, s_workloadTimeout);
+    return 0;
+}
+
+static std::string JsonString(const std::wstring_view text)
+{
+    std::string json{ "\"" };
+    for (const auto ch : til::u16u8(text))
+    {
+        if (ch == '"' || ch == '\\')
+        {
+            json.push_back('\\');
+            json.push_back(ch);
+        }
+        else if (static_cast<unsigned char>(ch) < 0x20)
+        {
+            fmt::format_to(std::back_inserter(json), FMT_COMPILE("\\u{:04x}"), static_cast<int>(ch));
+        }
+        else
+        {
+            json.push_back(ch);
+        }
+    }
+    json.push_back('"');
+    return json;
+}
+
+static double Percentile(const std::vector<double>& sorted, const double percentile) noexcept
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    const auto index = static_cast<size_t>(percentile * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static std::string FormatResults(const std::vector<Result>& results, const std::wstring_view conhostPath, const std::vector<std::wstring_view>& flagNames, const size_t size)
+{
+    std::string json;
+    const auto out = std::back_inserter(json);
+    fmt::format_to(out, "{{\n  \"conhost\": {},\n", JsonString(conhostPath));
+    fmt::format_to(out, "  \"columns\": {},\n  \"rows\": {},\n  \"size\": {},\n", s_size.X, s_size.Y, size);
+
+    json.append("  \"flags\": [");
+    for (size_t i = 0; i < flagNames.size(); ++i)
+    {
+        fmt::format_to(out, "{}{}", i ? ", " : "", JsonString(flagNames[i]));
+    }
+    json.append("],\n  \"workloads\": [");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& result = results[i];
+        auto latencies = result.latencies;
+        std::sort(latencies.begin(), latencies.end());
+
+        fmt::format_to(out, "{}\n    {{\n      \"name\": {},\n", i ? "," : "", JsonString(result.workload->name));
+        fmt::format_to(out, "      \"completed\": {},\n", result.completed);
+        fmt::format_to(out, "      \"outputBytes\": {},\n", result.outputBytes);
+        fmt::format_to(out, "      \"seconds\": {:.6f},\n", result.seconds);
+        fmt::format_to(out, "      \"bytesPerSecond\": {:.0f},\n", result.seconds > 0 ? result.outputBytes / result.seconds : 0.0);
+        fmt::format_to(out,
+                       "      \"latencyMs\": {{ \"samples\": {}, \"min\": {:.3f}, \"median\": {:.3f}, \"p95\": {:.3f}, \"max\": {:.3f} }},\n",
+                       latencies.size(),
+                       Percentile(latencies, 0),
+                       Percentile(latencies, 0.5),
+                       Percentile(latencies, 0.95),
+                       Percentile(latencies, 1));
+        fmt::format_to(out,
+                       "      \"conhostCpuSeconds\": {{ \"user\": {:.6f}, \"kernel\": {:.6f} }}\n    }}",
+                       result.conhostCpuTime.user,
+                       result.conhostCpuTime.kernel);
+    }
+
+    json.append("\n  ]\n}\n");
+    return json;
+}
+
+static void PrintUsage()
+{
+    wprintf(L"Usage: PtyBench.exe [-s <size in MB>] [-w <workload>]... [-o <file>] [--passthrough] [--repeatCharacter]\r\n");
+    wprintf(L"Runs workloads in a client attached to a pseudoconsole and measures the output\r\n");
+    wprintf(L"that comes through, its latency and the CPU time of conhost. The results are\r\n");
+    wprintf(L"written as JSON. OpenConsole.exe is used if it's next to PtyBench.exe.\r\n\r\n");
+    wprintf(L"Workloads:\r\n");
+    for (const auto& workload : GetWorkloads())
+    {
+        wprintf(L"  %-8s %s\r\n", workload.name, workload.description);
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    if (argc == 4 && argv[1] == s_clientArg)
+    {
+        return RunClient(argv[2], wcstoul(argv[3], nullptr, 10));
+    }
+
+    size_t size = 4;
+    DWORD flags = 0;
+    std::vector<std::wstring_view> flagNames;
+    std::vector<const Workload*> workloads;
+    const wchar_t* outputPath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-s" && i + 1 < argc)
+        {
+            size = std::max<size_t>(wcstoul(argv[++i], nullptr, 10), 1);
+        }
+        else if (arg == L"-w" && i + 1 < argc)
+        {
+            const auto workload = FindWorkload(argv[++i]);
+            if (!workload)
+            {
+                wprintf(L"Unknown workload '%s'.\r\n", argv[i]);
+                return E_INVALIDARG;
+            }
+            workloads.push_back(workload);
+        }
+        else if (arg == L"-o" && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (arg == L"--passthrough")
+        {
+            flags |= PSEUDOCONSOLE_PASSTHROUGH_MODE;
+            flagNames.push_back(L"passthrough");
+        }
+        else if (arg == L"--repeatCharacter")
+        {
+            flags |= PSEUDOCONSOLE_REPEAT_CHARACTER;
+            flagNames.push_back(L"repeatCharacter");
+        }
+        else
+        {
+            PrintUsage();
+            return E_INVALIDARG;
+        }
+    }
+
+    if (workloads.empty())
+    {
+        for (const auto& workload : GetWorkloads())
+        {
+            workloads.push_back(&workload);
+        }
+    }
+
+    std::vector<Result> results;
+    std::wstring conhostPath;
+    for (const auto workload : workloads)
+    {
+        fwprintf(stderr, L"Running %s...\r\n", workload->name);
+        results.push_back(RunWorkload(*workload, size * 1024 * 1024, flags, conhostPath));
+    }
+
+    const auto json = FormatResults(results, conhostPath, flagNames, size * 1024 * 1024);
+    if (outputPath)
+    {
+        std::ofstream file{ outputPath, std::ios::binary };
+        file << json;
+        if (!file)
+        {
+            wprintf(L"Couldn't write '%s'.\r\n", outputPath);
+            return E_FAIL;
+        }
+    }
+    else
+    {
+        fwrite(json.data(), 1, json.size(), stdout);
+    }
+
+    return 0;
+}
+CATCH_RETURN()
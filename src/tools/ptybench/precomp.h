@@ -0,0 +1,17 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- precomp.h
+
+Abstract:
+- Contains external headers to include in the precompile phase of console build
+  process.
+- PtyBench creates its pseudoconsoles with winconpty directly, so it shares
+  winconpty's headers.
+--*/
+
+#pragma once
+
+#include "../../winconpty/precomp.h"
@@ -0,0 +1,112 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "Golden.hpp"
+
+#include <wincodec.h>
+
+using namespace RenderBench;
+using Microsoft::WRL::ComPtr;
+
+static ComPtr<IWICImagingFactory> _factory()
+{
+    ComPtr<IWICImagingFactory> factory;
+    THROW_IF_FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory)));
+    return factory;
+}
+
+std::optional<Image> RenderBench::ReadImage(const std::filesystem::path& path)
+{
+    const auto factory = _factory();
+
+    ComPtr<IWICBitmapDecoder> decoder;
+    if (FAILED(factory->CreateDecoderFromFilename(path.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder)))
+    {
+        return std::nullopt;
+    }
+
+    ComPtr<IWICBitmapFrameDecode> frame;
+    THROW_IF_FAILED(decoder->GetFrame(0, &frame));
+
+    // The PNGs are written as BGRA, but one that was edited by hand may have been saved as anything.
+    ComPtr<IWICFormatConverter> converter;
+    THROW_IF_FAILED(factory->CreateFormatConverter(&converter));
+    THROW_IF_FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppBGRA, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeCustom));
+
+    UINT width = 0;
+    UINT height = 0;
+    THROW_IF_FAILED(converter->GetSize(&width, &height));
+
+    Image image;
+    image.size = { gsl::narrow<ptrdiff_t>(width), gsl::narrow<ptrdiff_t>(height) };
+    image.pixels.resize(static_cast<size_t>(width) * height);
+    THROW_IF_FAILED(converter->CopyPixels(nullptr,
+                                          width * sizeof(uint32_t),
+                                          gsl::narrow<UINT>(image.pixels.size() * sizeof(uint32_t)),
+                                          reinterpret_cast<BYTE*>(image.pixels.data())));
+    return image;
+}
+
+void RenderBench::WriteImage(const std::filesystem::path& path, const Image& image)
+{
+    const auto factory = _factory();
+    const auto width = image.size.width<UINT>();
+    const auto height = image.size.height<UINT>();
+
+    ComPtr<IWICStream> stream;
+    THROW_IF_FAILED(factory->CreateStream(&stream));
+    THROW_IF_FAILED(stream->InitializeFromFilename(path.c_str(), GENERIC_WRITE));
+
+    ComPtr<IWICBitmapEncoder> encoder;
+    THROW_IF_FAILED(factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &encoder));
+    THROW_IF_FAILED(encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache));
+
+    ComPtr<IWICBitmapFrameEncode> frame;
+    THROW_IF_FAILED(encoder->CreateNewFrame(&frame, nullptr));
+    THROW_IF_FAILED(frame->Initialize(nullptr));
+    THROW_IF_FAILED(frame->SetSize(width, height));
+
+    auto format = GUID_WICPixelFormat32bppBGRA;
+    THROW_IF_FAILED(frame->SetPixelFormat(&format));
+    THROW_HR_IF(E_UNEXPECTED, format != GUID_WICPixelFormat32bppBGRA);
+
+    // WritePixels doesn't modify the pixels, it just isn't const correct.
+    THROW_IF_FAILED(frame->WritePixels(height,
+                                       width * sizeof(uint32_t),
+                                       gsl::narrow<UINT>(image.pixels.size() * sizeof(uint32_t)),
+                                       reinterpret_cast<BYTE*>(const_cast<uint32_t*>(image.pixels.data()))));
+    THROW_IF_FAILED(frame->Commit());
+    THROW_IF_FAILED(encoder->Commit());
+}
+
+size_t RenderBench::CountDifferences(const Image& a, const Image& b, const uint8_t tolerance) noexcept
+{
+    if (a.size != b.size)
+    {
+        return std::max(a.pixels.size(), b.pixels.size());
+    }
+
+    size_t differences = 0;
+    for (size_t i = 0; i < a.pixels.size(); ++i)
+    {
+        const auto pa = til::at(a.pixels, i);
+        const auto pb = til::at(b.pixels, i);
+        if (pa == pb)
+        {
+            continue;
+        }
+
+        for (auto shift = 0; shift < 32; shift += 8)
+        {
+            const auto ca = static_cast<int>((pa >> shift) & 0xff);
+            const auto cb = static_cast<int>((pb >> shift) & 0xff);
+            if (std::abs(ca - cb) > tolerance)
+            {
+                ++differences;
+                break;
+            }
+        }
+    }
+    return differences;
+}
@@ -0,0 +1,32 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Golden.hpp
+
+Abstract:
+- The golden frames RenderBench compares its frames to, stored as PNG files.
+- Frames are compared with a tolerance for each color channel, since the
+  antialiasing of text isn't quite the same on every GPU and driver. WARP
+  draws the same pixels everywhere, which is why it's the default adapter.
+--*/
+
+#pragma once
+
+namespace RenderBench
+{
+    struct Image
+    {
+        til::size size;
+        // Rows of BGRA pixels, top to bottom, the way DxEngine::CaptureFrame returns them.
+        std::vector<uint32_t> pixels;
+    };
+
+    std::optional<Image> ReadImage(const std::filesystem::path& path);
+    void WriteImage(const std::filesystem::path& path, const Image& image);
+
+    // Returns the number of pixels that differ in any channel by more than the tolerance.
+    // Images of different sizes differ in every pixel of the larger one.
+    size_t CountDifferences(const Image& a, const Image& b, const uint8_t tolerance) noexcept;
+}
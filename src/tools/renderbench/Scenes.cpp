@@ -0,0 +1,281 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "Scenes.hpp"
+
+#include <random>
+
+using namespace RenderBench;
+
+// The same seed is used for every scene, so that their golden frames never change.
+static constexpr std::mt19937::result_type s_seed = 20211014;
+
+static void _appendCsi(std::string& out, const std::string_view parameters, const char final)
+{
+    out.append("\x1b[");
+    out.append(parameters);
+    out.push_back(final);
+}
+
+static void _appendCursorPosition(std::string& out, const int row, const int column)
+{
+    _appendCsi(out, std::to_string(row) + ";" + std::to_string(column), 'H');
+}
+
+// Every scene starts from a cleared screen with the cursor hidden, so that
+// neither what was painted before nor the cursor blinking changes the frame.
+static std::string _begin()
+{
+    return "\x1b[0m\x1b[2J\x1b[H\x1b[?25l";
+}
+
+// Rewrites a ten column counter that moves down a row every frame, which
+// invalidates a single short run of cells, the way a clock or a spinner does.
+static std::string _counter(const int columns, const int rows, const size_t frame, const std::string_view sgr)
+{
+    std::string out;
+    _appendCursorPosition(out, static_cast<int>(frame % rows) + 1, std::max(columns - 10, 0) + 1);
+    _appendCsi(out, sgr, 'm');
+    out.append(fmt::format("{:>10}", frame));
+    _appendCsi(out, "0", 'm');
+    return out;
+}
+
+// Printable ASCII on every cell, in the default colors.
+static std::string _asciiWall(const int columns, const int rows)
+{
+    auto out = _begin();
+    for (int row = 0; row < rows; ++row)
+    {
+        _appendCursorPosition(out, row + 1, 1);
+        for (int column = 0; column < columns; ++column)
+        {
+            out.push_back(static_cast<char>('!' + (row * 7 + column) % 94));
+        }
+    }
+    return out;
+}
+
+static std::string _asciiWallUpdate(const int columns, const int rows, const size_t frame)
+{
+    return _counter(columns, rows, frame, "0");
+}
+
+// Every cell in a different truecolor foreground and background, so that
+// nothing can be merged into one run by its attributes.
+static std::string _sgrRainbow(const int columns, const int rows)
+{
+    std::mt19937 rng{ s_seed };
+    auto out = _begin();
+    for (int row = 0; row < rows; ++row)
+    {
+        _appendCursorPosition(out, row + 1, 1);
+        for (int column = 0; column < columns; ++column)
+        {
+            const auto hue = (row * 11 + column * 3) % 256;
+            _appendCsi(out, fmt::format("38;2;{};{};{};48;2;{};{};{}", 255 - hue, hue, rng() % 256, hue / 4, 64 - hue / 4, rng() % 64), 'm');
+            out.push_back(static_cast<char>('a' + rng() % 26));
+        }
+        _appendCsi(out, "0", 'm');
+    }
+    return out;
+}
+
+static std::string _sgrRainbowUpdate(const int columns, const int rows, const size_t frame)
+{
+    const auto hue = frame * 37 % 256;
+    return _counter(columns, rows, frame, fmt::format("38;2;{};{};255;48;2;0;0;{}", hue, 255 - hue, hue / 2));
+}
+
+// Wide CJK characters and emoji, some of them with modifiers, between ASCII words.
+static std::string _cjkEmoji(const int columns, const int rows)
+{
+    static constexpr std::pair<std::string_view, int> pieces[]{
+        { "\xe6\xbc\xa2\xe5\xad\x97", 4 },
+        { "\xe3\x81\x8b\xe3\x81\xaa", 4 },
+        { "\xed\x95\x9c\xea\xb8\x80", 4 },
+        { "\xe4\xb8\xad\xe6\x96\x87\xe6\xb5\x8b\xe8\xaf\x95", 8 },
+        { "\xf0\x9f\x98\x80", 2 },
+        { "\xf0\x9f\x91\x8d\xf0\x9f\x8f\xbd", 2 },
+        { "\xf0\x9f\x8e\x89", 2 },
+        { "caf\xc3\xa9", 4 },
+        { "hello", 5 },
+    };
+
+    std::mt19937 rng{ s_seed };
+    auto out = _begin();
+    for (int row = 0; row < rows; ++row)
+    {
+        _appendCursorPosition(out, row + 1, 1);
+        for (auto column = 0;;)
+        {
+            const auto& [text, width] = pieces[rng() % std::size(pieces)];
+            if (column + width + 1 > columns)
+            {
+                break;
+            }
+            out.append(text);
+            out.push_back(' ');
+            column += width + 1;
+        }
+    }
+    return out;
+}
+
+static std::string _cjkEmojiUpdate(const int columns, const int rows, const size_t frame)
+{
+    auto out = _counter(columns, rows, frame, "33");
+    out.append(frame % 2 ? "\xe2\x8f\xb3" : "\xe2\x8c\x9b");
+    return out;
+}
+
+static void _appendBox(std::string& out, const int top, const int left, const int width, const int height, const std::string_view title)
+{
+    _appendCursorPosition(out, top, left);
+    out.append("\xe2\x94\x8c\xe2\x94\x80");
+    out.append(title);
+    for (auto column = gsl::narrow_cast<int>(title.size()) + 3; column < width; ++column)
+    {
+        out.append("\xe2\x94\x80");
+    }
+    out.append("\xe2\x94\x90");
+    for (int row = 1; row < height - 1; ++row)
+    {
+        _appendCursorPosition(out, top + row, left);
+        out.append("\xe2\x94\x82");
+        _appendCursorPosition(out, top + row, left + width - 1);
+        out.append("\xe2\x94\x82");
+    }
+    _appendCursorPosition(out, top + height - 1, left);
+    out.append("\xe2\x94\x94");
+    for (int column = 2; column < width; ++column)
+    {
+        out.append("\xe2\x94\x80");
+    }
+    out.append("\xe2\x94\x98");
+}
+
+// A dashboard like htop or a file manager: boxes around panels, meters made
+// of block elements, and a reverse video status line.
+static std::string _boxTui(const int columns, const int rows)
+{
+    std::mt19937 rng{ s_seed };
+    auto out = _begin();
+    const auto half = columns / 2;
+
+    _appendCsi(out, "36", 'm');
+    _appendBox(out, 1, 1, half, rows - 1, "cpu");
+    _appendBox(out, 1, half + 1, columns - half, rows - 1, "processes");
+    _appendCsi(out, "0", 'm');
+
+    for (int row = 2; row < rows - 1; ++row)
+    {
+        const auto fill = static_cast<int>(rng() % std::max(half - 12, 1));
+        _appendCursorPosition(out, row, 3);
+        out.append(fmt::format("{:>3} ", row - 2));
+        _appendCsi(out, fill > half / 2 ? "31" : "32", 'm');
+        for (int column = 0; column < half - 12; ++column)
+        {
+            out.append(column < fill ? "\xe2\x96\x88" : "\xe2\x96\x91");
+        }
+        _appendCsi(out, "0", 'm');
+
+        _appendCursorPosition(out, row, half + 3);
+        _appendCsi(out, row % 2 ? "1;34" : "0", 'm');
+        out.append(fmt::format("{:>6} {:<8} {:>5.1f}%", rng() % 65536, "worker", (rng() % 1000) / 10.0));
+        _appendCsi(out, "0", 'm');
+    }
+
+    _appendCursorPosition(out, rows, 1);
+    _appendCsi(out, "7", 'm');
+    out.append(fmt::format("{:<{}}", " F1 Help  F2 Setup  F3 Search  F9 Kill  F10 Quit", columns));
+    _appendCsi(out, "0", 'm');
+    return out;
+}
+
+static std::string _boxTuiUpdate(const int columns, const int rows, const size_t frame)
+{
+    // The meters of the CPU panel change one at a time, like they do on every refresh.
+    const auto half = columns / 2;
+    const auto width = std::max(half - 12, 1);
+    const auto row = static_cast<int>(frame % std::max(rows - 3, 1)) + 2;
+    const auto fill = static_cast<int>(frame * 7 % width);
+
+    std::string out;
+    _appendCursorPosition(out, row, 7);
+    _appendCsi(out, fill > half / 2 ? "31" : "32", 'm');
+    for (int column = 0; column < width; ++column)
+    {
+        out.append(column < fill ? "\xe2\x96\x88" : "\xe2\x96\x91");
+    }
+    _appendCsi(out, "0", 'm');
+    return out;
+}
+
+// Source code full of the operators that the font draws as ligatures.
+static std::string _ligatures(const int columns, const int rows)
+{
+    static constexpr std::string_view lines[]{
+        "if (a != b && c >= d || e <= f) { return x->y; }",
+        "auto f = [](auto&& v) -> bool { return v == 0; };",
+        "let g = x => x |> map(y => y ** 2) <|> none;",
+        "while (i++ < n) { sum += i; total -= i / 2; } // ok",
+        "assert(a === b); assert(c !== d); /* <!-- --> */",
+        "p ::= q <=> r; s :: t ==> u; www.example.com ...",
+    };
+
+    std::mt19937 rng{ s_seed };
+    auto out = _begin();
+    for (int row = 0; row < rows; ++row)
+    {
+        _appendCursorPosition(out, row + 1, 1);
+        _appendCsi(out, fmt::format("38;5;{}", 244 + row % 8), 'm');
+        out.append(fmt::format("{:>4} ", row + 1));
+        _appendCsi(out, fmt::format("38;5;{}", 150 + rng() % 80), 'm');
+        std::string line;
+        while (gsl::narrow_cast<int>(line.size()) < columns - 5)
+        {
+            line.append(lines[rng() % std::size(lines)]);
+            line.push_back(' ');
+        }
+        line.resize(std::max(columns - 5, 0));
+        out.append(line);
+        _appendCsi(out, "0", 'm');
+    }
+    return out;
+}
+
+static std::string _ligaturesUpdate(const int columns, const int rows, const size_t frame)
+{
+    std::string out;
+    _appendCursorPosition(out, static_cast<int>(frame % rows) + 1, std::max(columns - 12, 0) + 1);
+    _appendCsi(out, "38;5;214", 'm');
+    out.append(frame % 2 ? "x => y != z" : "a <= b == c");
+    _appendCsi(out, "0", 'm');
+    return out;
+}
+
+const std::vector<Scene>& RenderBench::GetScenes()
+{
+    static const std::vector<Scene> scenes{
+        { L"ascii", L"printable ASCII on every cell, in the default colors", nullptr, &_asciiWall, &_asciiWallUpdate },
+        { L"sgr", L"a different truecolor foreground and background on every cell", nullptr, &_sgrRainbow, &_sgrRainbowUpdate },
+        { L"cjk", L"wide CJK characters and emoji between ASCII words", nullptr, &_cjkEmoji, &_cjkEmojiUpdate },
+        { L"tui", L"boxes, block element meters and a status line", nullptr, &_boxTui, &_boxTuiUpdate },
+        { L"ligatures", L"source code in Cascadia Code, which draws ligatures", L"Cascadia Code", &_ligatures, &_ligaturesUpdate },
+    };
+    return scenes;
+}
+
+const Scene* RenderBench::FindScene(const std::wstring_view name) noexcept
+{
+    for (const auto& scene : GetScenes())
+    {
+        if (name == scene.name)
+        {
+            return &scene;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,34 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Scenes.hpp
+
+Abstract:
+- The buffer states RenderBench paints: a wall of ASCII, an SGR rainbow, CJK
+  and emoji text, a box drawing TUI, and source code in a font with ligatures.
+- Each scene is written to the terminal as VT output, generated with a fixed
+  seed so that it's the same on every run and every machine. Its updates
+  change a few cells per frame, to measure partial invalidation.
+--*/
+
+#pragma once
+
+namespace RenderBench
+{
+    struct Scene
+    {
+        const wchar_t* name;
+        const wchar_t* description;
+        // The font the scene is painted with, or nullptr for the default one.
+        const wchar_t* fontFace;
+        // Returns the VT output that fills a viewport of the given size.
+        std::string (*generate)(const int columns, const int rows);
+        // Returns the VT output that changes a few cells for the given frame.
+        std::string (*update)(const int columns, const int rows, const size_t frame);
+    };
+
+    const std::vector<Scene>& GetScenes();
+    const Scene* FindScene(const std::wstring_view name) noexcept;
+}
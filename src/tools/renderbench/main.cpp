@@ -0,0 +1,436 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+
+#include "Golden.hpp"
+#include "Scenes.hpp"
+
+#include "../../cascadia/TerminalCore/Terminal.hpp"
+#include "../../inc/DefaultSettings.h"
+#include "../../renderer/base/renderer.hpp"
+#include "../../renderer/dx/DxRenderer.hpp"
+
+using namespace Microsoft::Console::Render;
+using namespace RenderBench;
+
+static constexpr COORD s_size{ 120, 30 };
+
+// The frames are painted one at a time with Renderer::PaintFrame, so the
+// renderer gets a thread that never paints anything on its own.
+class ManualRenderThread final : public IRenderThread
+{
+public:
+    void NotifyPaint() override {}
+    void NotifyPaintAfter(const std::chrono::milliseconds /*delay*/) override {}
+    void EnablePainting() override {}
+    void DisablePainting() override {}
+    void WaitForPaintCompletionAndDisable(const DWORD /*dwTimeoutMs*/) override {}
+    void SuspendPainting() override {}
+    void ResumePainting() override {}
+    void SetMinimumFrameInterval(const std::chrono::milliseconds /*interval*/) override {}
+    void SetPriority(const int /*priority*/) override {}
+};
+
+struct Options
+{
+    size_t frames{ 200 };
+    bool hardware{ false };
+    bool atlas{ false };
+    std::filesystem::path goldenDirectory;
+    bool updateGolden{ false };
+    uint8_t tolerance{ 16 };
+};
+
+// Measures how long the GPU takes for a frame with timestamp queries on the
+// immediate context, which DxEngine shares with everything else in the process.
+// Reading the result waits for the GPU to finish the frame, so that the next
+// one starts on an idle GPU and frames don't overlap.
+class GpuTimer
+{
+public:
+    explicit GpuTimer(const bool softwareRendering)
+    {
+        THROW_IF_FAILED(SharedDevice::Acquire(softwareRendering, DXGI_GPU_PREFERENCE_UNSPECIFIED, _device));
+
+        D3D11_QUERY_DESC desc{ D3D11_QUERY_TIMESTAMP_DISJOINT };
+        THROW_IF_FAILED(_device->D3DDevice()->CreateQuery(&desc, &_disjoint));
+        desc.Query = D3D11_QUERY_TIMESTAMP;
+        THROW_IF_FAILED(_device->D3DDevice()->CreateQuery(&desc, &_begin));
+        THROW_IF_FAILED(_device->D3DDevice()->CreateQuery(&desc, &_end));
+    }
+
+    void Begin() const noexcept
+    {
+        const auto lock = _device->Lock();
+        _device->D3DDeviceContext()->Begin(_disjoint.Get());
+        _device->D3DDeviceContext()->End(_begin.Get());
+    }
+
+    void End() const noexcept
+    {
+        const auto lock = _device->Lock();
+        _device->D3DDeviceContext()->End(_end.Get());
+        _device->D3DDeviceContext()->End(_disjoint.Get());
+    }
+
+    // Returns the milliseconds between Begin() and End(), or nothing if the
+    // GPU's clock changed its frequency in between.
+    std::optional<double> Read() const noexcept
+    {
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
+        UINT64 begin = 0;
+        UINT64 end = 0;
+        if (!_GetData(_disjoint.Get(), disjoint) || !_GetData(_begin.Get(), begin) || !_GetData(_end.Get(), end) || disjoint.Disjoint)
+        {
+            return std::nullopt;
+        }
+        return static_cast<double>(end - begin) * 1000.0 / static_cast<double>(disjoint.Frequency);
+    }
+
+private:
+    template<typename T>
+    bool _GetData(ID3D11Query* const query, T& data) const noexcept
+    {
+        for (;;)
+        {
+            HRESULT hr;
+            {
+                const auto lock = _device->Lock();
+                hr = _device->D3DDeviceContext()->GetData(query, &data, sizeof(data), 0);
+            }
+            if (hr != S_FALSE)
+            {
+                return hr == S_OK;
+            }
+            Sleep(0);
+        }
+    }
+
+    std::shared_ptr<SharedDevice> _device;
+    Microsoft::WRL::ComPtr<ID3D11Query> _disjoint;
+    Microsoft::WRL::ComPtr<ID3D11Query> _begin;
+    Microsoft::WRL::ComPtr<ID3D11Query> _end;
+};
+
+// What was measured of one scene with the whole frame invalidated, or just the cells of its updates.
+struct Result
+{
+    const Scene* scene{ nullptr };
+    const wchar_t* mode{ nullptr };
+    size_t frames{ 0 };
+    double cpuMsPerFrame{ 0 };
+    std::vector<double> wallMs;
+    std::vector<double> gpuMs;
+};
+
+static double Seconds(const FILETIME& time) noexcept
+{
+    return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+}
+
+// The CPU time of the calling thread, which unlike the wall clock time of a
+// frame doesn't include waiting for the GPU or for the swap chain to present.
+static double ThreadCpuSeconds() noexcept
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    {
+        return 0;
+    }
+    return Seconds(kernel) + Seconds(user);
+}
+
+// A Terminal holding a scene, painted by a DxEngine into a swap chain that's
+// never shown. DxEngine makes a composition swap chain when it isn't given a
+// window, which works just as well without anything to compose it into.
+class Bench
+{
+public:
+    Bench(const Scene& scene, const Options& options) :
+        _scene{ scene }
+    {
+        _renderer = std::make_unique<Renderer>(&_terminal, nullptr, 0, std::make_unique<ManualRenderThread>());
+
+        _engine.SetSoftwareRendering(!options.hardware);
+        _engine.SetGlyphAtlasRendering(options.atlas);
+        _renderer->AddRenderEngine(&_engine);
+
+        const std::wstring_view faceName{ scene.fontFace ? scene.fontFace : DEFAULT_FONT_FACE.c_str() };
+        const FontInfoDesired desired{ faceName, 0, DEFAULT_FONT_WEIGHT, { 0, DEFAULT_FONT_SIZE }, CP_UTF8 };
+        FontInfo actual{ faceName, 0, DEFAULT_FONT_WEIGHT, { 0, DEFAULT_FONT_SIZE }, CP_UTF8, false };
+        _renderer->TriggerFontChange(USER_DEFAULT_SCREEN_DPI, desired, actual);
+        if (actual.GetFaceName() != faceName)
+        {
+            wprintf(L"warning: %s is painted with %s, as %s isn't installed.\r\n", scene.name, actual.GetFaceName().data(), faceName.data());
+        }
+
+        COORD cell{};
+        THROW_IF_FAILED(_engine.GetFontSize(&cell));
+        THROW_IF_FAILED(_engine.SetWindowSize({ s_size.X * cell.X, s_size.Y * cell.Y }));
+
+        _terminal.Create(s_size, 0, *_renderer);
+        THROW_IF_FAILED(_engine.Enable());
+
+        _terminal.Write(std::string_view{ scene.generate(s_size.X, s_size.Y) });
+
+        // The first frames create the swap chain, the font caches and the glyph atlas.
+        for (int i = 0; i < 3; ++i)
+        {
+            _renderer->TriggerRedrawAll();
+            _Paint();
+        }
+
+        _gpuTimer.emplace(!options.hardware);
+    }
+
+    Result Run(const bool partial, const size_t frames)
+    {
+        Result result;
+        result.scene = &_scene;
+        result.mode = partial ? L"partial" : L"full";
+        result.frames = frames;
+        result.wallMs.reserve(frames);
+        result.gpuMs.reserve(frames);
+
+        const auto cpuStart = ThreadCpuSeconds();
+        for (size_t frame = 0; frame < frames; ++frame)
+        {
+            // Only the painting is measured, not how long the terminal takes to parse the update.
+            if (partial)
+            {
+                _terminal.Write(std::string_view{ _scene.update(s_size.X, s_size.Y, _updates++) });
+            }
+            else
+            {
+                _renderer->TriggerRedrawAll();
+            }
+
+            _gpuTimer->Begin();
+            const auto start = std::chrono::steady_clock::now();
+            _Paint();
+            const std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - start;
+            _gpuTimer->End();
+
+            result.wallMs.push_back(wall.count());
+            if (const auto gpu = _gpuTimer->Read())
+            {
+                result.gpuMs.push_back(*gpu);
+            }
+        }
+        result.cpuMsPerFrame = (ThreadCpuSeconds() - cpuStart) * 1000 / std::max<size_t>(frames, 1);
+        return result;
+    }
+
+    // Paints the whole frame anew and returns it.
+    Image Capture()
+    {
+        _renderer->TriggerRedrawAll();
+        _Paint();
+        return _CaptureLastFrame();
+    }
+
+    // Returns the frame as the partial updates left it, and the number of pixels that
+    // differ from it when the whole frame is painted again. They ought to be the same.
+    std::pair<Image, size_t> CheckPartialFrame()
+    {
+        auto partial = _CaptureLastFrame();
+        const auto full = Capture();
+        const auto differences = CountDifferences(partial, full, 0);
+        return { std::move(partial), differences };
+    }
+
+private:
+    void _Paint()
+    {
+        THROW_IF_FAILED(_renderer->PaintFrame());
+    }
+
+    Image _CaptureLastFrame()
+    {
+        Image image;
+        THROW_IF_FAILED(_engine.CaptureFrame(image.pixels, image.size));
+        return image;
+    }
+
+    const Scene& _scene;
+    Microsoft::Terminal::Core::Terminal _terminal;
+    DxEngine _engine;
+    std::unique_ptr<Renderer> _renderer;
+    std::optional<GpuTimer> _gpuTimer;
+    size_t _updates{ 0 };
+};
+
+static double Percentile(std::vector<double> values, const double percentile)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    const auto index = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+static void PrintResult(const Result& result)
+{
+    wprintf(L"%-10s %-8s %10.3f %10.3f %10.3f %10.3f %10.3f\r\n",
+            result.scene->name,
+            result.mode,
+            result.cpuMsPerFrame,
+            Percentile(result.wallMs, 0.5),
+            Percentile(result.wallMs, 0.95),
+            Percentile(result.gpuMs, 0.5),
+            Percentile(result.gpuMs, 0.95));
+}
+
+// Compares the frame to the golden one, or replaces the golden one with it. Returns false if they differ.
+static bool CheckGolden(const Options& options, const std::wstring& name, const Image& frame)
+{
+    const auto path = options.goldenDirectory / (name + L".png");
+    if (options.updateGolden)
+    {
+        WriteImage(path, frame);
+        return true;
+    }
+
+    const auto golden = ReadImage(path);
+    if (!golden)
+    {
+        wprintf(L"%-19s no golden frame at %s\r\n", name.c_str(), path.c_str());
+        return false;
+    }
+
+    const auto differences = CountDifferences(frame, *golden, options.tolerance);
+    if (differences != 0)
+    {
+        // The frame is kept next to the golden one, so that the two can be compared by eye.
+        const auto actualPath = options.goldenDirectory / (name + L".actual.png");
+        WriteImage(actualPath, frame);
+        wprintf(L"%-19s %zu pixels differ from the golden frame, see %s\r\n", name.c_str(), differences, actualPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void PrintUsage()
+{
+    wprintf(L"Usage: RenderBench.exe [-n <frames>] [-s <scene>]... [--hardware] [--atlas]\r\n");
+    wprintf(L"                       [-g <golden directory> [--update-golden] [-t <tolerance>]]\r\n");
+    wprintf(L"Paints buffer states with a DxEngine into a swap chain that's never shown, with\r\n");
+    wprintf(L"the whole frame invalidated and with just a few cells changing per frame. It\r\n");
+    wprintf(L"measures the CPU time per frame, the wall clock time per frame (which includes\r\n");
+    wprintf(L"waiting for the swap chain) and the GPU time per frame. WARP is used unless\r\n");
+    wprintf(L"--hardware is given. With -g, the frames are compared to the golden frames in\r\n");
+    wprintf(L"the directory, allowing each color channel to differ by the tolerance (16 by\r\n");
+    wprintf(L"default), or replace them with --update-golden.\r\n\r\n");
+    wprintf(L"Scenes:\r\n");
+    for (const auto& scene : GetScenes())
+    {
+        wprintf(L"  %-10s %s\r\n", scene.name, scene.description);
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    Options options;
+    std::vector<const Scene*> scenes;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-n" && i + 1 < argc)
+        {
+            options.frames = std::max<size_t>(wcstoul(argv[++i], nullptr, 10), 1);
+        }
+        else if (arg == L"-t" && i + 1 < argc)
+        {
+            options.tolerance = static_cast<uint8_t>(std::min(wcstoul(argv[++i], nullptr, 10), 255ul));
+        }
+        else if (arg == L"-g" && i + 1 < argc)
+        {
+            options.goldenDirectory = argv[++i];
+        }
+        else if (arg == L"-s" && i + 1 < argc)
+        {
+            const auto scene = FindScene(argv[++i]);
+            if (!scene)
+            {
+                PrintUsage();
+                return E_INVALIDARG;
+            }
+            scenes.push_back(scene);
+        }
+        else if (arg == L"--hardware")
+        {
+            options.hardware = true;
+        }
+        else if (arg == L"--atlas")
+        {
+            options.atlas = true;
+        }
+        else if (arg == L"--update-golden")
+        {
+            options.updateGolden = true;
+        }
+        else
+        {
+            PrintUsage();
+            return E_INVALIDARG;
+        }
+    }
+
+    if (options.updateGolden && options.goldenDirectory.empty())
+    {
+        PrintUsage();
+        return E_INVALIDARG;
+    }
+    if (scenes.empty())
+    {
+        for (const auto& scene : GetScenes())
+        {
+            scenes.push_back(&scene);
+        }
+    }
+    if (!options.goldenDirectory.empty())
+    {
+        std::filesystem::create_directories(options.goldenDirectory);
+    }
+
+    const auto coInit = wil::CoInitializeEx(COINIT_MULTITHREADED);
+
+    wprintf(L"%-10s %-8s %10s %10s %10s %10s %10s\r\n", L"scene", L"mode", L"cpu ms", L"wall p50", L"wall p95", L"gpu p50", L"gpu p95");
+
+    auto matches = true;
+    for (const auto scene : scenes)
+    {
+        Bench bench{ *scene, options };
+
+        // The golden frames of the glyph atlas are kept apart, as it draws the text itself.
+        const std::wstring name{ std::wstring{ scene->name } + (options.atlas ? L"-atlas" : L"") };
+        if (!options.goldenDirectory.empty())
+        {
+            matches &= CheckGolden(options, name, bench.Capture());
+        }
+
+        PrintResult(bench.Run(false, options.frames));
+        PrintResult(bench.Run(true, options.frames));
+
+        // Painting just the updates must leave the same frame as painting all of it,
+        // which doesn't depend on the adapter, so it's checked without any tolerance.
+        const auto [partial, differences] = bench.CheckPartialFrame();
+        if (differences != 0)
+        {
+            wprintf(L"%-19s %zu pixels differ between the partial and the full frame\r\n", name.c_str(), differences);
+            matches = false;
+        }
+        if (!options.goldenDirectory.empty())
+        {
+            matches &= CheckGolden(options, name + L"-partial", partial);
+        }
+    }
+
+    return matches ? 0 : 1;
+}
+CATCH_RETURN()
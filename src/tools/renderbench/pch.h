@@ -0,0 +1,41 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- pch.h
+
+Abstract:
+- Contains external headers to include in the precompile phase of console build
+  process.
+- Avoid including internal project headers. Instead include them only in the
+  classes that need them (helps with test project building).
+--*/
+
+#pragma once
+
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS 1
+#endif
+
+#define BLOCK_TIL
+#include "LibraryIncludes.h"
+#ifdef GetCurrentTime
+#undef GetCurrentTime
+#endif
+
+#include <wil/cppwinrt.h>
+#include <unknwn.h>
+#include <hstring.h>
+
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+
+#include <winrt/Microsoft.Terminal.Core.h>
+
+#include <wil/com.h>
+#include <wrl/client.h>
+
+#include "til.h"
+
+#include <chrono>
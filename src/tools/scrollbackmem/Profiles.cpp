@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "Profiles.hpp"
+
+using namespace ScrollbackMem;
+
+static constexpr std::array<std::string_view, 16> s_words{
+    "build", "warning", "error", "info", "src", "main.cpp", "linking", "compiled",
+    "0x7ffe", "ms", "tests", "passed", "failed", "done", "retry", "cache",
+};
+
+// Lines are between a quarter and all of the columns long, the way log output is.
+static int _lineLength(std::mt19937& rng, const int columns)
+{
+    const auto minimum = std::max(columns / 4, 1);
+    return minimum + static_cast<int>(rng() % static_cast<unsigned>(columns - minimum + 1));
+}
+
+// Appends words until the line would be longer than the given length, with
+// append called for each word. Returns the number of columns that were used.
+template<typename Append>
+static int _appendWords(std::mt19937& rng, const int length, Append&& append)
+{
+    auto used = 0;
+    for (;;)
+    {
+        const auto word = s_words[rng() % s_words.size()];
+        const auto width = static_cast<int>(word.size()) + (used != 0);
+        if (used + width > length)
+        {
+            return used;
+        }
+        append(word, used != 0);
+        used += width;
+    }
+}
+
+// A build log: words and numbers in the default colors.
+static void _ascii(std::string& out, std::mt19937& rng, const int columns, const size_t /*line*/)
+{
+    _appendWords(rng, _lineLength(rng, columns), [&](const std::string_view word, const bool space) {
+        if (space)
+        {
+            out.push_back(' ');
+        }
+        out.append(word);
+    });
+    out.append("\r\n");
+}
+
+// Every word in its own color, half of them indexed and half truecolor, some
+// bold or underlined, so that every row has dozens of attribute runs.
+static void _colored(std::string& out, std::mt19937& rng, const int columns, const size_t /*line*/)
+{
+    _appendWords(rng, _lineLength(rng, columns), [&](const std::string_view word, const bool space) {
+        if (space)
+        {
+            out.push_back(' ');
+        }
+        if (rng() % 2)
+        {
+            out.append(fmt::format("\x1b[38;5;{}m", rng() % 256));
+        }
+        else
+        {
+            out.append(fmt::format("\x1b[38;2;{};{};{};48;2;{};{};{}m", rng() % 256, rng() % 256, rng() % 256, rng() % 64, rng() % 64, rng() % 64));
+        }
+        if (rng() % 8 == 0)
+        {
+            out.append(rng() % 2 ? "\x1b[1m" : "\x1b[4m");
+        }
+        out.append(word);
+        out.append("\x1b[0m");
+    });
+    out.append("\r\n");
+}
+
+// A link with a URI of its own on every line (as ls --hyperlink and compilers
+// print them), every fourth one with an id, and a plain URL for the patterns.
+static void _hyperlinks(std::string& out, std::mt19937& rng, const int columns, const size_t line)
+{
+    const auto id = line % 4 == 0 ? fmt::format("id=diag{}", line) : std::string{};
+    const auto text = fmt::format("src/file{}.cpp({})", rng() % 1000, line);
+    out.append(fmt::format("\x1b]8;{};file:///C:/src/file{}.cpp#{}\x1b\\{}\x1b]8;;\x1b\\", id, line % 1000, line, text));
+
+    const auto url = fmt::format(" see https://example.com/errors/{}", rng() % 100000);
+    if (static_cast<int>(text.size() + url.size()) <= columns)
+    {
+        out.append(url);
+    }
+    out.append("\r\n");
+}
+
+// Emoji (some of them ZWJ sequences) and CJK text, as UTF-8. None of the emoji
+// fit into a single UTF-16 code unit, so all of them end up in the UnicodeStorage.
+static void _emoji(std::string& out, std::mt19937& rng, const int columns, const size_t /*line*/)
+{
+    static constexpr std::array<std::string_view, 8> glyphs{
+        "\xF0\x9F\x98\x80", // grinning face
+        "\xF0\x9F\x9A\x80", // rocket
+        "\xF0\x9F\x94\xA5", // fire
+        "\xE2\x9C\x85", // check mark button
+        "\xF0\x9F\x91\xA9\xE2\x80\x8D\xF0\x9F\x92\xBB", // woman technologist
+        "\xE4\xBD\xA0", // CJK ni
+        "\xE5\xA5\xBD", // CJK hao
+        "\xE6\x96\x87", // CJK wen
+    };
+
+    const auto length = _lineLength(rng, columns);
+    for (auto used = 0; used + 3 <= length; used += 3)
+    {
+        out.append(glyphs[rng() % glyphs.size()]);
+        out.push_back(' ');
+    }
+    out.append("\r\n");
+}
+
+const std::vector<Profile>& ScrollbackMem::GetProfiles()
+{
+    static const std::vector<Profile> profiles{
+        { L"ascii", L"build log output in the default colors", _ascii },
+        { L"colored", L"every word in its own indexed or truecolor color", _colored },
+        { L"hyperlinks", L"an OSC 8 hyperlink and a plain URL on every line", _hyperlinks },
+        { L"emoji", L"emoji, ZWJ sequences and CJK text", _emoji },
+    };
+    return profiles;
+}
@@ -0,0 +1,28 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Profiles.hpp
+
+Abstract:
+- The kinds of output ScrollbackMem fills a buffer with: plain ASCII logs,
+  heavily colored text, hyperlinks and emoji.
+- Each profile is generated as VT output a line at a time, with a fixed seed,
+  so that the same buffer (and the same numbers) come out on every run.
+--*/
+
+#pragma once
+
+namespace ScrollbackMem
+{
+    struct Profile
+    {
+        const wchar_t* name;
+        const wchar_t* description;
+        // Appends the VT output of the given line, including the newline that ends it.
+        void (*appendLine)(std::string& out, std::mt19937& rng, const int columns, const size_t line);
+    };
+
+    const std::vector<Profile>& GetProfiles();
+}
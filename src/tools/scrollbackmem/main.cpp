@@ -0,0 +1,183 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "Profiles.hpp"
+
+#include "../../cascadia/TerminalCore/Terminal.hpp"
+#include "../../inc/DefaultSettings.h"
+#include "../../renderer/inc/DummyRenderTarget.hpp"
+
+using namespace ScrollbackMem;
+
+// The same seed is used for every profile, so that the buffers are the same on every run.
+static constexpr std::mt19937::result_type s_seed = 20211014;
+
+// The output is written this many lines at a time, so that it doesn't have to be held all at once.
+static constexpr size_t s_linesPerWrite = 1000;
+
+struct Options
+{
+    size_t rows{ DEFAULT_HISTORY_SIZE };
+    int columns{ DEFAULT_COLS };
+};
+
+// The private bytes of the process: everything it allocated on the heap or
+// committed with VirtualAlloc, which includes the TextBuffer's cell arena.
+static size_t PrivateBytes()
+{
+    PROCESS_MEMORY_COUNTERS_EX counters{};
+    counters.cb = sizeof(counters);
+    THROW_IF_WIN32_BOOL_FALSE(GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)));
+    return counters.PrivateUsage;
+}
+
+static void PrintHeader()
+{
+    wprintf(L"profile\tstate\trows\trow objects\tcells\tpacked cells\tattributes\tunicode storage\thyperlinks\tpatterns\tsearch index\tdelimiter classes\trow texts\timages\ttotal\tbytes/row\tprivate bytes\r\n");
+}
+
+static void PrintUsage(const Profile& profile, const wchar_t* state, const size_t rows, const BufferMemoryUsage& usage, const size_t privateBytes)
+{
+    wprintf(L"%s\t%s\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\t%zu\t%.1f\t%zu\r\n",
+            profile.name,
+            state,
+            rows,
+            usage.rows,
+            usage.cells,
+            usage.packedCells,
+            usage.attributes,
+            usage.unicodeStorage,
+            usage.hyperlinks,
+            usage.patterns,
+            usage.searchIndex,
+            usage.delimiterClasses,
+            usage.rowTexts,
+            usage.images,
+            usage.Total(),
+            static_cast<double>(usage.Total()) / std::max<size_t>(rows, 1),
+            privateBytes);
+}
+
+// Fills a terminal with the given profile until its scrollback is full, and prints what
+// its buffer uses while all of it is hot, and again after it was packed into cold storage.
+static void Run(const Profile& profile, const Options& options)
+{
+    const auto before = PrivateBytes();
+    const auto privateBytes = [&]() {
+        const auto now = PrivateBytes();
+        return now > before ? now - before : 0;
+    };
+
+    DummyRenderTarget renderTarget;
+    const auto terminal = std::make_unique<Microsoft::Terminal::Core::Terminal>();
+    const COORD viewport{ gsl::narrow_cast<SHORT>(options.columns), DEFAULT_ROWS };
+    terminal->Create(viewport, gsl::narrow_cast<SHORT>(options.rows), renderTarget);
+
+    // The viewport is filled as well, so that every row of the scrollback has been written to.
+    const auto lines = options.rows + DEFAULT_ROWS;
+    std::mt19937 rng{ s_seed };
+    std::string out;
+    for (size_t line = 0; line < lines;)
+    {
+        out.clear();
+        for (const auto end = std::min(line + s_linesPerWrite, lines); line < end; ++line)
+        {
+            profile.appendLine(out, rng, options.columns, line);
+        }
+        terminal->Write(std::string_view{ out });
+    }
+
+    // The pattern tree is only built when the control asks for it, after the output settled.
+    {
+        const auto lock = terminal->LockForWriting();
+        terminal->UpdatePatternsUnderLock();
+    }
+
+    const auto print = [&](const wchar_t* state) {
+        BufferMemoryUsage usage;
+        {
+            const auto lock = terminal->LockForReading();
+            usage = terminal->GetMemoryUsage();
+        }
+        PrintUsage(profile, state, lines, usage, privateBytes());
+    };
+
+    print(L"hot");
+    {
+        const auto lock = terminal->LockForWriting();
+        terminal->CompactScrollback(false);
+    }
+    print(L"packed");
+}
+
+static void PrintHelp()
+{
+    wprintf(L"Usage: ScrollbackMem.exe [-n <rows>] [-w <columns>] [<profile>...]\r\n");
+    wprintf(L"Fills a terminal's scrollback with each of the profiles below (or those that\r\n");
+    wprintf(L"are given) and reports the memory used by its buffer, in bytes, broken down by\r\n");
+    wprintf(L"what it's used for. Each profile is reported while the whole buffer is hot and\r\n");
+    wprintf(L"again after the scrollback was packed into cold storage.\r\n\r\n");
+    wprintf(L"The output is generated with a fixed seed and printed as tab separated values,\r\n");
+    wprintf(L"so that it can be compared between builds to track changes of the buffer\r\n");
+    wprintf(L"layout. The private bytes are measured by the OS, as a check of the estimates.\r\n\r\n");
+    wprintf(L"  -n <rows>     the number of scrollback rows (default: %d, at most 32767)\r\n", DEFAULT_HISTORY_SIZE);
+    wprintf(L"  -w <columns>  the width of the buffer (default: %d)\r\n\r\n", DEFAULT_COLS);
+    wprintf(L"Profiles:\r\n");
+    for (const auto& profile : GetProfiles())
+    {
+        wprintf(L"  %-12s  %s\r\n", profile.name, profile.description);
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    Options options;
+    std::vector<std::wstring_view> names;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-n" && i + 1 < argc)
+        {
+            options.rows = std::min<size_t>(wcstoul(argv[++i], nullptr, 10), SHRT_MAX - DEFAULT_ROWS);
+        }
+        else if (arg == L"-w" && i + 1 < argc)
+        {
+            options.columns = std::clamp(_wtoi(argv[++i]), 10, static_cast<int>(SHRT_MAX));
+        }
+        else if (arg.empty() || arg[0] == L'-')
+        {
+            PrintHelp();
+            return E_INVALIDARG;
+        }
+        else
+        {
+            names.push_back(arg);
+        }
+    }
+
+    const auto& profiles = GetProfiles();
+    for (const auto& name : names)
+    {
+        if (std::none_of(profiles.begin(), profiles.end(), [&](const auto& profile) { return name == profile.name; }))
+        {
+            wprintf(L"unknown profile: %.*s\r\n", gsl::narrow_cast<int>(name.size()), name.data());
+            PrintHelp();
+            return E_INVALIDARG;
+        }
+    }
+
+    PrintHeader();
+    for (const auto& profile : profiles)
+    {
+        if (names.empty() || std::find(names.begin(), names.end(), profile.name) != names.end())
+        {
+            Run(profile, options);
+        }
+    }
+
+    return 0;
+}
+CATCH_RETURN()
@@ -0,0 +1,184 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- BenchGetSet.hpp
+
+Abstract:
+- A ConGetSet and AdaptDefaults for driving AdaptDispatch without a console.
+- Only the state that AdaptDispatch reads back (the cursor, the attributes
+  and the buffer info) is kept, everything else is accepted and discarded.
+  This measures the parser and the adapter, not the buffer, which is what
+  the Terminal target of the benchmark is for.
+--*/
+
+#pragma once
+
+#include "../../terminal/adapter/adaptDefaults.hpp"
+#include "../../terminal/adapter/conGetSet.hpp"
+
+namespace Microsoft::Console::VirtualTerminal
+{
+    class BenchDefaults final : public AdaptDefaults
+    {
+    public:
+        void Print(const wchar_t /*wch*/) override
+        {
+        }
+
+        void PrintString(const std::wstring_view /*string*/) override
+        {
+        }
+
+        void Execute(const wchar_t /*wch*/) override
+        {
+        }
+    };
+
+    class BenchGetSet final : public ConGetSet
+    {
+    public:
+        BenchGetSet(const COORD size) noexcept
+        {
+            _info.cbSize = sizeof(_info);
+            _info.dwSize = size;
+            _info.srWindow = { 0, 0, gsl::narrow_cast<SHORT>(size.X - 1), gsl::narrow_cast<SHORT>(size.Y - 1) };
+            _info.dwMaximumWindowSize = size;
+            _info.wAttributes = 7;
+        }
+
+        bool GetConsoleScreenBufferInfoEx(CONSOLE_SCREEN_BUFFER_INFOEX& screenBufferInfo) const override
+        {
+            screenBufferInfo = _info;
+            return true;
+        }
+        bool SetConsoleScreenBufferInfoEx(const CONSOLE_SCREEN_BUFFER_INFOEX& screenBufferInfo) override
+        {
+            _info = screenBufferInfo;
+            return true;
+        }
+        bool SetConsoleCursorPosition(const COORD position) override
+        {
+            _info.dwCursorPosition.X = std::clamp<SHORT>(position.X, 0, _info.dwSize.X - 1);
+            _info.dwCursorPosition.Y = std::clamp<SHORT>(position.Y, 0, _info.dwSize.Y - 1);
+            return true;
+        }
+
+        bool PrivateIsVtInputEnabled() const override { return false; }
+
+        bool PrivateGetTextAttributes(TextAttribute& attrs) const override
+        {
+            attrs = _attributes;
+            return true;
+        }
+        bool PrivateSetTextAttributes(const TextAttribute& attrs) override
+        {
+            _attributes = attrs;
+            return true;
+        }
+
+        bool PrivateSetCurrentLineRendition(const LineRendition /*lineRendition*/) override { return true; }
+        bool PrivateResetLineRenditionRange(const size_t /*startRow*/, const size_t /*endRow*/) override { return true; }
+        SHORT PrivateGetLineWidth(const size_t /*row*/) const override { return _info.dwSize.X; }
+
+        bool PrivateWriteConsoleInputW(std::deque<std::unique_ptr<IInputEvent>>& events,
+                                       size_t& eventsWritten) override
+        {
+            eventsWritten = events.size();
+            return true;
+        }
+        bool SetConsoleWindowInfo(const bool /*absolute*/,
+                                  const SMALL_RECT& /*window*/) override { return true; }
+        bool PrivateSetCursorKeysMode(const bool /*applicationMode*/) override { return true; }
+        bool PrivateSetKeypadMode(const bool /*applicationMode*/) override { return true; }
+        bool PrivateEnableWin32InputMode(const bool /*win32InputMode*/) override { return true; }
+        bool PrivateSetSynchronizedOutput(const bool /*enabled*/) override { return true; }
+
+        bool PrivateSetAnsiMode(const bool /*ansiMode*/) override { return true; }
+        bool PrivateSetScreenMode(const bool /*reverseMode*/) override { return true; }
+        bool PrivateSetAutoWrapMode(const bool /*wrapAtEOL*/) override { return true; }
+
+        bool PrivateShowCursor(const bool /*show*/) override { return true; }
+        bool PrivateAllowCursorBlinking(const bool /*enable*/) override { return true; }
+
+        bool PrivateSetScrollingRegion(const SMALL_RECT& /*scrollMargins*/) override { return true; }
+        bool PrivateWarningBell() override { return true; }
+        bool PrivateGetLineFeedMode() const override { return false; }
+        bool PrivateLineFeed(const bool withReturn) override
+        {
+            if (withReturn)
+            {
+                _info.dwCursorPosition.X = 0;
+            }
+            _info.dwCursorPosition.Y = std::min<SHORT>(_info.dwCursorPosition.Y + 1, _info.dwSize.Y - 1);
+            return true;
+        }
+        bool PrivateReverseLineFeed() override
+        {
+            _info.dwCursorPosition.Y = std::max<SHORT>(_info.dwCursorPosition.Y - 1, 0);
+            return true;
+        }
+        bool SetConsoleTitleW(const std::wstring_view /*title*/) override { return true; }
+        bool PrivateUseAlternateScreenBuffer() override { return true; }
+        bool PrivateUseMainScreenBuffer() override { return true; }
+
+        bool PrivateEnableVT200MouseMode(const bool /*enabled*/) override { return true; }
+        bool PrivateEnableUTF8ExtendedMouseMode(const bool /*enabled*/) override { return true; }
+        bool PrivateEnableSGRExtendedMouseMode(const bool /*enabled*/) override { return true; }
+        bool PrivateEnableButtonEventMouseMode(const bool /*enabled*/) override { return true; }
+        bool PrivateEnableAnyEventMouseMode(const bool /*enabled*/) override { return true; }
+        bool PrivateEnableAlternateScroll(const bool /*enabled*/) override { return true; }
+        bool PrivateEraseAll() override { return true; }
+        bool GetUserDefaultCursorStyle(CursorType& style) override
+        {
+            style = CursorType::Legacy;
+            return true;
+        }
+        bool SetCursorStyle(const CursorType /*style*/) override { return true; }
+        bool SetCursorColor(const COLORREF /*color*/) override { return true; }
+        bool PrivateWriteConsoleControlInput(const KeyEvent /*key*/) override { return true; }
+        bool PrivateRefreshWindow() override { return true; }
+
+        bool SetConsoleOutputCP(const unsigned int /*codepage*/) override { return true; }
+        bool GetConsoleOutputCP(unsigned int& codepage) override
+        {
+            codepage = CP_UTF8;
+            return true;
+        }
+
+        bool PrivateSuppressResizeRepaint() override { return true; }
+        bool IsConsolePty() const override { return false; }
+
+        bool DeleteLines(const size_t /*count*/) override { return true; }
+        bool InsertLines(const size_t /*count*/) override { return true; }
+
+        bool MoveToBottom() const override { return true; }
+
+        bool PrivateGetColorTableEntry(const size_t /*index*/, COLORREF& value) const override
+        {
+            value = 0;
+            return true;
+        }
+        bool PrivateSetColorTableEntry(const size_t /*index*/, const COLORREF /*value*/) const override { return true; }
+        bool PrivateSetDefaultForeground(const COLORREF /*value*/) const override { return true; }
+        bool PrivateSetDefaultBackground(const COLORREF /*value*/) const override { return true; }
+
+        bool PrivateFillRegion(const COORD /*startPosition*/,
+                               const size_t /*fillLength*/,
+                               const wchar_t /*fillChar*/,
+                               const bool /*standardFillAttrs*/) override { return true; }
+
+        bool PrivateScrollRegion(const SMALL_RECT /*scrollRect*/,
+                                 const std::optional<SMALL_RECT> /*clipRect*/,
+                                 const COORD /*destinationOrigin*/,
+                                 const bool /*standardFillAttrs*/) override { return true; }
+
+        bool PrivateAddHyperlink(const std::wstring_view /*uri*/, const std::wstring_view /*params*/) const override { return true; }
+        bool PrivateEndHyperlink() const override { return true; }
+
+    private:
+        CONSOLE_SCREEN_BUFFER_INFOEX _info{};
+        TextAttribute _attributes{};
+    };
+}
@@ -0,0 +1,215 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "Corpora.hpp"
+
+#include <random>
+
+using namespace VtBench;
+
+static constexpr int s_width = 120;
+static constexpr int s_height = 30;
+
+// The same seed is used for every corpus, so that they never change.
+static constexpr std::mt19937::result_type s_seed = 20210614;
+
+static void _appendCsi(std::string& out, const std::string_view parameters, const char final)
+{
+    out.append("\x1b[");
+    out.append(parameters);
+    out.push_back(final);
+}
+
+static void _appendCursorPosition(std::string& out, const int row, const int column)
+{
+    _appendCsi(out, std::to_string(row) + ";" + std::to_string(column), 'H');
+}
+
+static std::string _word(std::mt19937& rng)
+{
+    static constexpr std::string_view words[]{
+        "request", "worker", "connection", "timeout", "buffer", "render", "parser", "cache",
+        "handler", "session", "config", "update", "thread", "socket", "queue", "retry"
+    };
+    return std::string{ words[rng() % std::size(words)] };
+}
+
+// Lines of build or server logs, without any escape sequences.
+static std::string _asciiLog(const size_t targetSize)
+{
+    std::mt19937 rng{ s_seed };
+    std::string out;
+    static constexpr std::string_view levels[]{ "INFO", "WARN", "DEBUG", "ERROR" };
+    for (unsigned int line = 0; out.size() < targetSize; ++line)
+    {
+        out.append("2021-06-14 12:");
+        out.append(std::to_string(10 + line / 6000 % 50) + ":" + std::to_string(10 + line / 100 % 50));
+        out.append(" [");
+        out.append(levels[rng() % std::size(levels)]);
+        out.append("] ");
+        out.append(_word(rng) + " " + std::to_string(rng() % 64) + ": processed " + _word(rng));
+        out.append(" /api/items/" + std::to_string(rng() % 100000) + " in " + std::to_string(rng() % 500) + "ms\r\n");
+    }
+    return out;
+}
+
+// Syntax highlighted source the way bat or delta print it: a truecolor SGR for
+// almost every token, and reset at the end of every line.
+static std::string _sgrDense(const size_t targetSize)
+{
+    std::mt19937 rng{ s_seed };
+    std::string out;
+    while (out.size() < targetSize)
+    {
+        int column = 0;
+        while (column < s_width - 12)
+        {
+            std::string parameters{ "38;2;" + std::to_string(rng() % 256) + ";" + std::to_string(rng() % 256) + ";" + std::to_string(rng() % 256) };
+            if (rng() % 8 == 0)
+            {
+                parameters.append(";48;2;40;44;52");
+            }
+            _appendCsi(out, parameters, 'm');
+            const auto token = _word(rng);
+            out.append(token);
+            column += gsl::narrow_cast<int>(token.size());
+            if (rng() % 3 == 0)
+            {
+                _appendCsi(out, "39", 'm');
+                out.append(" ");
+                ++column;
+            }
+        }
+        _appendCsi(out, "0", 'm');
+        out.append("\r\n");
+    }
+    return out;
+}
+
+// Full screen redraws like vim or tmux do them: scrolling regions, hidden
+// cursor, a status line, and every line positioned, colored and erased.
+static std::string _editorRedraw(const size_t targetSize)
+{
+    std::mt19937 rng{ s_seed };
+    std::string out;
+    while (out.size() < targetSize)
+    {
+        _appendCsi(out, "?25", 'l');
+        _appendCsi(out, "1;" + std::to_string(s_height - 1), 'r');
+        for (int row = 1; row < s_height; ++row)
+        {
+            _appendCursorPosition(out, row, 1);
+            _appendCsi(out, "38;5;243", 'm');
+            out.append(std::to_string(100 + row) + " ");
+            _appendCsi(out, "0", 'm');
+            int column = 4;
+            while (column < s_width / 2 + static_cast<int>(rng() % (s_width / 2 - 16)))
+            {
+                _appendCsi(out, "38;5;" + std::to_string(rng() % 256), 'm');
+                const auto token = _word(rng);
+                out.append(token + " ");
+                column += gsl::narrow_cast<int>(token.size()) + 1;
+            }
+            _appendCsi(out, "0", 'm');
+            _appendCsi(out, "", 'K');
+        }
+        _appendCsi(out, "", 'r');
+        _appendCursorPosition(out, s_height, 1);
+        _appendCsi(out, "7", 'm');
+        out.append(" NORMAL  src/main.cpp  [+]  utf-8  " + std::to_string(rng() % 1000) + ":" + std::to_string(rng() % 120));
+        _appendCsi(out, "0", 'm');
+        _appendCsi(out, "", 'K');
+        _appendCursorPosition(out, static_cast<int>(rng() % (s_height - 1)) + 1, static_cast<int>(rng() % s_width) + 1);
+        _appendCsi(out, "?25", 'h');
+        // Scroll the region up a line now and then, the way they do on j/k.
+        _appendCsi(out, "1;" + std::to_string(s_height - 1), 'r');
+        _appendCsi(out, "1", 'S');
+        _appendCsi(out, "", 'r');
+    }
+    return out;
+}
+
+// Chat or document text that mixes CJK, emoji (some with modifiers) and ASCII.
+static std::string _emojiCjk(const size_t targetSize)
+{
+    std::mt19937 rng{ s_seed };
+    std::string out;
+    static constexpr std::string_view pieces[]{
+        "\xe6\xbc\xa2\xe5\xad\x97",
+        "\xe3\x81\x8b\xe3\x81\xaa",
+        "\xed\x95\x9c\xea\xb8\x80",
+        "\xe4\xb8\xad\xe6\x96\x87\xe6\xb5\x8b\xe8\xaf\x95",
+        "\xf0\x9f\x98\x80",
+        "\xf0\x9f\x91\x8d\xf0\x9f\x8f\xbd",
+        "\xf0\x9f\x8e\x89",
+        "caf\xc3\xa9",
+        "hello",
+        "\xe2\x94\x80\xe2\x94\x80",
+    };
+    while (out.size() < targetSize)
+    {
+        for (int i = 0; i < 24; ++i)
+        {
+            out.append(pieces[rng() % std::size(pieces)]);
+            out.push_back(' ');
+        }
+        out.append("\r\n");
+    }
+    return out;
+}
+
+// Dashboards like htop: many small writes at absolute positions, reverse video
+// highlights and box drawing, with few characters per sequence.
+static std::string _cursorTui(const size_t targetSize)
+{
+    std::mt19937 rng{ s_seed };
+    std::string out;
+    while (out.size() < targetSize)
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            _appendCursorPosition(out, static_cast<int>(rng() % s_height) + 1, static_cast<int>(rng() % (s_width - 8)) + 1);
+            switch (rng() % 4)
+            {
+            case 0:
+                _appendCsi(out, "7", 'm');
+                out.append(std::to_string(rng() % 100) + "%");
+                _appendCsi(out, "27", 'm');
+                break;
+            case 1:
+                _appendCsi(out, "32", 'm');
+                out.append("||||");
+                _appendCsi(out, "0", 'm');
+                break;
+            case 2:
+                out.append("\xe2\x94\x82");
+                break;
+            default:
+                _appendCsi(out, "1;34", 'm');
+                out.append(std::to_string(rng() % 65536));
+                _appendCsi(out, "0", 'm');
+                _appendCsi(out, "", 'K');
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+// Routine Description:
+// - Generates all the synthetic corpora.
+// Arguments:
+// - targetSize - The approximate size of each corpus in bytes.
+// Return Value:
+// - The corpora, as UTF-8.
+std::vector<Corpus> VtBench::GenerateCorpora(const size_t targetSize)
+{
+    std::vector<Corpus> corpora;
+    corpora.push_back({ L"ascii-log", _asciiLog(targetSize) });
+    corpora.push_back({ L"sgr-dense", _sgrDense(targetSize) });
+    corpora.push_back({ L"editor-redraw", _editorRedraw(targetSize) });
+    corpora.push_back({ L"emoji-cjk", _emojiCjk(targetSize) });
+    corpora.push_back({ L"cursor-tui", _cursorTui(targetSize) });
+    return corpora;
+}
@@ -0,0 +1,28 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Corpora.hpp
+
+Abstract:
+- Synthetic corpora for the VT benchmark, each resembling the output of a
+  class of programs: plain logs, truecolor highlighters, full screen editors,
+  CJK and emoji text, and cursor positioning heavy TUIs.
+- They are generated deterministically, so that results are comparable between
+  runs and machines. Recorded output can be benchmarked as well, by passing
+  the files on the command line.
+--*/
+
+#pragma once
+
+namespace VtBench
+{
+    struct Corpus
+    {
+        std::wstring name;
+        std::string utf8;
+    };
+
+    std::vector<Corpus> GenerateCorpora(const size_t targetSize);
+}
@@ -0,0 +1,279 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+
+#include "BenchGetSet.hpp"
+#include "Corpora.hpp"
+
+#include "../../terminal/parser/stateMachine.hpp"
+#include "../../terminal/parser/OutputStateMachineEngine.hpp"
+#include "../../terminal/adapter/adaptDispatch.hpp"
+#include "../../terminal/adapter/termDispatch.hpp"
+#include "../../cascadia/TerminalCore/Terminal.hpp"
+#include "../../renderer/inc/DummyRenderTarget.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+using namespace VtBench;
+
+// Every allocation of the process is counted, so that the allocations
+// of a target can be told from the difference before and after it ran.
+static std::atomic<size_t> s_allocations{ 0 };
+
+void* __cdecl operator new(size_t size)
+{
+    ++s_allocations;
+    if (const auto p = malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void* __cdecl operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* __cdecl operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    ++s_allocations;
+    return malloc(size ? size : 1);
+}
+
+void* __cdecl operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void __cdecl operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void __cdecl operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void __cdecl operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void __cdecl operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+static constexpr COORD s_size{ 120, 30 };
+
+// A dispatch that handles nothing, to measure the parser on its own.
+class NullDispatch final : public TermDispatch
+{
+public:
+    void Execute(const wchar_t /*wchControl*/) noexcept override
+    {
+    }
+    void Print(const wchar_t /*wchPrintable*/) noexcept override
+    {
+    }
+    void PrintString(const std::wstring_view /*string*/) noexcept override
+    {
+    }
+};
+
+// A target is something that consumes a corpus. It's set up once per corpus,
+// outside of the measurements, and then fed the corpus over and over.
+class Target
+{
+public:
+    virtual ~Target() = default;
+    virtual void Write(const Corpus& corpus, const std::wstring_view utf16) = 0;
+};
+
+// StateMachine and OutputStateMachineEngine, with a dispatch that does nothing.
+class ParserTarget final : public Target
+{
+public:
+    ParserTarget() :
+        _machine{ std::make_unique<OutputStateMachineEngine>(std::make_unique<NullDispatch>()) }
+    {
+    }
+
+    void Write(const Corpus& /*corpus*/, const std::wstring_view utf16) override
+    {
+        _machine.ProcessString(utf16);
+    }
+
+private:
+    StateMachine _machine;
+};
+
+// StateMachine, OutputStateMachineEngine and AdaptDispatch, the way conhost
+// parses output, but without its buffer.
+class AdapterTarget final : public Target
+{
+public:
+    AdapterTarget() :
+        _machine{ std::make_unique<OutputStateMachineEngine>(std::make_unique<AdaptDispatch>(std::make_unique<BenchGetSet>(s_size), std::make_unique<BenchDefaults>())) }
+    {
+    }
+
+    void Write(const Corpus& /*corpus*/, const std::wstring_view utf16) override
+    {
+        _machine.ProcessString(utf16);
+    }
+
+private:
+    StateMachine _machine;
+};
+
+// Terminal, with its TerminalDispatch and TextBuffer, the way Windows Terminal
+// parses output. It's fed either UTF-16 or the UTF-8 as it comes from ConPTY,
+// in chunks the size of ConPTY's reads. With the output pipelined, the time
+// includes waiting for the apply thread to catch up.
+class TerminalTarget final : public Target
+{
+public:
+    TerminalTarget(const bool utf8, const bool pipelined) :
+        _utf8{ utf8 }
+    {
+        _terminal.Create(s_size, 9001, _renderTarget);
+        _terminal.SetPipelinedOutput(pipelined);
+    }
+
+    void Write(const Corpus& corpus, const std::wstring_view utf16) override
+    {
+        if (_utf8)
+        {
+            _WriteChunked(std::string_view{ corpus.utf8 });
+        }
+        else
+        {
+            _WriteChunked(utf16);
+        }
+        _terminal.WaitForPendingOutput();
+    }
+
+private:
+    static constexpr size_t s_chunkSize = 4096;
+
+    template<typename T>
+    void _WriteChunked(const std::basic_string_view<T> text)
+    {
+        for (size_t offset = 0; offset < text.size(); offset += s_chunkSize)
+        {
+            _terminal.Write(text.substr(offset, s_chunkSize));
+        }
+    }
+
+    Microsoft::Console::Render::DummyRenderTarget _renderTarget;
+    Microsoft::Terminal::Core::Terminal _terminal;
+    bool _utf8;
+};
+
+struct TargetInfo
+{
+    const wchar_t* name;
+    std::function<std::unique_ptr<Target>()> create;
+};
+
+static const TargetInfo s_targets[]{
+    { L"parser", [] { return std::make_unique<ParserTarget>(); } },
+    { L"adapter", [] { return std::make_unique<AdapterTarget>(); } },
+    { L"terminal", [] { return std::make_unique<TerminalTarget>(false, false); } },
+    { L"terminal-utf8", [] { return std::make_unique<TerminalTarget>(true, false); } },
+    { L"terminal-pipelined", [] { return std::make_unique<TerminalTarget>(false, true); } },
+    { L"terminal-utf8-pipelined", [] { return std::make_unique<TerminalTarget>(true, true); } },
+};
+
+static void PrintUsage()
+{
+    wprintf(L"Usage: VtBench.exe [-n <iterations>] [-s <corpus size in MB>] [<recorded output>...]\r\n");
+    wprintf(L"Measures the throughput of the VT parser and the dispatches behind it.\r\n");
+    wprintf(L"Without any files, synthetic corpora are generated. Files are read as UTF-8.\r\n");
+}
+
+static std::optional<std::string> ReadFile(const wchar_t* path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    if (!file)
+    {
+        return std::nullopt;
+    }
+    return std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+}
+
+static void Run(const Corpus& corpus, const size_t iterations)
+{
+    const auto utf16 = til::u8u16(corpus.utf8);
+    const auto megabytes = static_cast<double>(corpus.utf8.size()) * iterations / (1024 * 1024);
+
+    for (const auto& info : s_targets)
+    {
+        auto target = info.create();
+
+        // The first pass warms up the caches and grows the buffers to their steady size.
+        target->Write(corpus, utf16);
+
+        const auto allocationsBefore = s_allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            target->Write(corpus, utf16);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const auto allocations = s_allocations.load() - allocationsBefore;
+
+        wprintf(L"%-16s %-14s %10.1f MB/s %12.1f allocs/MB\r\n",
+                corpus.name.c_str(),
+                info.name,
+                megabytes / elapsed.count(),
+                allocations / megabytes);
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+{
+    size_t iterations = 10;
+    size_t corpusSize = 4;
+    std::vector<Corpus> corpora;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if ((arg == L"-n" || arg == L"-s") && i + 1 < argc)
+        {
+            const auto value = wcstoul(argv[++i], nullptr, 10);
+            (arg == L"-n" ? iterations : corpusSize) = std::max<size_t>(value, 1);
+        }
+        else if (arg == L"-?" || arg == L"-h" || arg == L"-n" || arg == L"-s")
+        {
+            PrintUsage();
+            return E_INVALIDARG;
+        }
+        else if (auto content = ReadFile(argv[i]))
+        {
+            corpora.push_back({ std::filesystem::path{ arg }.filename().wstring(), std::move(*content) });
+        }
+        else
+        {
+            wprintf(L"Couldn't read '%s'.\r\n", argv[i]);
+            return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+        }
+    }
+
+    if (corpora.empty())
+    {
+        corpora = GenerateCorpora(corpusSize * 1024 * 1024);
+    }
+
+    wprintf(L"%-16s %-14s %15s %22s\r\n", L"corpus", L"target", L"throughput", L"allocations");
+    for (const auto& corpus : corpora)
+    {
+        Run(corpus, iterations);
+    }
+
+    return 0;
+}
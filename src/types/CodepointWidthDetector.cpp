@@ -14,11 +14,6 @@ namespace
         CodepointWidth width;
     };
 
-    static bool operator<(const UnicodeRange& range, const unsigned int searchTerm) noexcept
-    {
-        return range.upperBound < searchTerm;
-    }
-
     // Generated by Generate-CodepointWidthsFromUCD.ps1 -Pack:True -Full:False -NoOverrides:False
     // on 10/25/2020 7:32:04 AM (UTC) from Unicode 13.0.0.
     // 321205 (0x4E6B5) codepoints covered.
@@ -321,6 +316,105 @@ namespace
         UnicodeRange{ 0xf0000, 0xffffd, CodepointWidth::Ambiguous },
         UnicodeRange{ 0x100000, 0x10fffd, CodepointWidth::Ambiguous },
     };
+
+    // The ranges above are turned into a two-stage table at compile time, so that looking up
+    // a codepoint is just two array accesses: s_widthTable.pages maps the upper bits of the
+    // codepoint to one of the leaves, which hold the widths of 256 codepoints each.
+    // Pages whose codepoints all have the same width share one of the first three leaves,
+    // the others (those with range boundaries in them) get a leaf of their own.
+    static constexpr unsigned int s_pageShift = 8;
+    static constexpr size_t s_pageSize = size_t{ 1 } << s_pageShift;
+    static constexpr size_t s_pageCount = 0x110000 >> s_pageShift;
+    static constexpr size_t s_uniformLeaves = 3; // Narrow, Wide, Ambiguous
+
+    template<size_t MixedPages>
+    struct TwoStageTable final
+    {
+        std::array<uint16_t, s_pageCount> pages{};
+        std::array<std::array<CodepointWidth, s_pageSize>, s_uniformLeaves + MixedPages> leaves{};
+    };
+
+    // Returns the width of all codepoints in [first, last], or CodepointWidth::Invalid if they differ.
+    // range is the first range that might overlap with them. The pages have to be passed in order.
+    static constexpr CodepointWidth s_uniformWidth(size_t& range, const unsigned int first, const unsigned int last) noexcept
+    {
+        while (range < s_wideAndAmbiguousTable.size() && s_wideAndAmbiguousTable[range].upperBound < first)
+        {
+            ++range;
+        }
+
+        if (range == s_wideAndAmbiguousTable.size() || s_wideAndAmbiguousTable[range].lowerBound > last)
+        {
+            return CodepointWidth::Narrow;
+        }
+        if (s_wideAndAmbiguousTable[range].lowerBound <= first && s_wideAndAmbiguousTable[range].upperBound >= last)
+        {
+            return s_wideAndAmbiguousTable[range].width;
+        }
+        return CodepointWidth::Invalid;
+    }
+
+    static constexpr size_t s_countMixedPages() noexcept
+    {
+        size_t range = 0;
+        size_t count = 0;
+        for (size_t page = 0; page < s_pageCount; ++page)
+        {
+            const auto first = static_cast<unsigned int>(page << s_pageShift);
+            if (s_uniformWidth(range, first, first + s_pageSize - 1) == CodepointWidth::Invalid)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    static constexpr auto s_buildWidthTable() noexcept
+    {
+        TwoStageTable<s_countMixedPages()> table;
+
+        for (size_t i = 0; i < s_pageSize; ++i)
+        {
+            table.leaves[static_cast<size_t>(CodepointWidth::Narrow)][i] = CodepointWidth::Narrow;
+            table.leaves[static_cast<size_t>(CodepointWidth::Wide)][i] = CodepointWidth::Wide;
+            table.leaves[static_cast<size_t>(CodepointWidth::Ambiguous)][i] = CodepointWidth::Ambiguous;
+        }
+
+        size_t range = 0;
+        size_t leaf = s_uniformLeaves;
+        for (size_t page = 0; page < s_pageCount; ++page)
+        {
+            const auto first = static_cast<unsigned int>(page << s_pageShift);
+            const auto width = s_uniformWidth(range, first, first + s_pageSize - 1);
+            if (width != CodepointWidth::Invalid)
+            {
+                table.pages[page] = static_cast<uint16_t>(width);
+                continue;
+            }
+
+            // The codepoints of this page are walked with their own cursor,
+            // since the ranges in it may be needed for the next page again.
+            auto cursor = range;
+            for (size_t i = 0; i < s_pageSize; ++i)
+            {
+                const auto codepoint = static_cast<unsigned int>(first + i);
+                while (cursor < s_wideAndAmbiguousTable.size() && s_wideAndAmbiguousTable[cursor].upperBound < codepoint)
+                {
+                    ++cursor;
+                }
+
+                const auto inRange = cursor < s_wideAndAmbiguousTable.size() && s_wideAndAmbiguousTable[cursor].lowerBound <= codepoint;
+                table.leaves[leaf][i] = inRange ? s_wideAndAmbiguousTable[cursor].width : CodepointWidth::Narrow;
+            }
+
+            table.pages[page] = static_cast<uint16_t>(leaf);
+            ++leaf;
+        }
+
+        return table;
+    }
+
+    static constexpr auto s_widthTable = s_buildWidthTable();
 }
 
 // Routine Description:
@@ -404,7 +498,114 @@ bool CodepointWidthDetector::IsWide(const std::wstring_view glyph) const
 }
 
 // Routine Description:
-// - returns the width type of codepoint by searching the map generated from the unicode spec
+// - Determines how many columns each code unit of text takes up, the way IsWide would for
+//   each glyph in it: 1 or 2 for the first code unit of a glyph, and 0 for the
+//   trailing half of a surrogate pair. Unpaired surrogates take up 1 column.
+// Arguments:
+// - text - the utf16 encoded text
+// - columns - receives the columns of each code unit. Must be as long as text.
+// Return Value:
+// - <none>
+void CodepointWidthDetector::GetColumns(const std::wstring_view text, const gsl::span<uint8_t> columns) const noexcept
+{
+    FAIL_FAST_IF(columns.size() < text.size());
+
+    auto out = columns.begin();
+    _forEachColumns(text, [&](const size_t count, const uint8_t width) noexcept {
+        out = std::fill_n(out, count, width);
+    });
+}
+
+// Routine Description:
+// - Determines how many columns the text takes up. See GetColumns.
+// Arguments:
+// - text - the utf16 encoded text
+// Return Value:
+// - the sum of the columns of all glyphs in text
+size_t CodepointWidthDetector::CountColumns(const std::wstring_view text) const noexcept
+{
+    size_t total = 0;
+    _forEachColumns(text, [&](const size_t count, const uint8_t width) noexcept {
+        total += count * width;
+    });
+    return total;
+}
+
+// Routine Description:
+// - Splits text into runs of code units that take up the same columns each.
+// - Runs of ASCII and of CJK ideographs, which make up most text, are checked 8 code units
+//   at a time without branches, which the compiler turns into vector instructions.
+//   Everything else is looked up one glyph at a time.
+// Arguments:
+// - text - the utf16 encoded text
+// - sink - called in order with the number of code units and the columns each of them takes up.
+// Return Value:
+// - <none>
+template<typename Sink>
+void CodepointWidthDetector::_forEachColumns(const std::wstring_view text, Sink&& sink) const noexcept
+{
+    static constexpr size_t block = 8;
+    // The ideographs of U+4E00 to U+A48C are all wide, no matter what the font says.
+    static constexpr wchar_t ideographsBegin = 0x4e00;
+    static constexpr wchar_t ideographsEnd = 0xa48c;
+
+    const auto size = text.size();
+    size_t i = 0;
+
+    while (i < size)
+    {
+        if (size - i >= block)
+        {
+            wchar_t bits = 0;
+            wchar_t lo = 0xffff;
+            wchar_t hi = 0;
+            for (size_t k = 0; k < block; ++k)
+            {
+                const auto wch = til::at(text, i + k);
+                bits |= wch;
+                lo = std::min(lo, wch);
+                hi = std::max(hi, wch);
+            }
+
+            // ASCII is narrow, including the C0 controls.
+            if (bits < 0x80)
+            {
+                sink(block, uint8_t{ 1 });
+                i += block;
+                continue;
+            }
+            if (lo >= ideographsBegin && hi <= ideographsEnd)
+            {
+                sink(block, uint8_t{ 2 });
+                i += block;
+                continue;
+            }
+        }
+
+        const auto wch = til::at(text, i);
+        if (wch < 0x80)
+        {
+            sink(1, uint8_t{ 1 });
+            ++i;
+        }
+        else if (IS_HIGH_SURROGATE(wch) && i + 1 < size && IS_LOW_SURROGATE(til::at(text, i + 1)))
+        {
+            const auto wide = _lookupGlyphWidthWithCache(text.substr(i, 2)) == CodepointWidth::Wide;
+            sink(1, static_cast<uint8_t>(wide ? 2 : 1));
+            sink(1, uint8_t{ 0 });
+            i += 2;
+        }
+        else
+        {
+            const auto wide = _lookupGlyphWidthWithCache(text.substr(i, 1)) == CodepointWidth::Wide;
+            sink(1, static_cast<uint8_t>(wide ? 2 : 1));
+            ++i;
+        }
+    }
+}
+
+// Routine Description:
+// - returns the width type of codepoint by looking it up in the table generated from the unicode spec
 // Arguments:
 // - glyph - the utf16 encoded codepoint to search for
 // Return Value:
@@ -416,17 +617,10 @@ CodepointWidth CodepointWidthDetector::_lookupGlyphWidth(const std::wstring_view
         return CodepointWidth::Invalid;
     }
 
+    // _extractCodepoint can't return anything past U+10FFFF, so this stays within the table.
     const auto codepoint = _extractCodepoint(glyph);
-    const auto it = std::lower_bound(s_wideAndAmbiguousTable.begin(), s_wideAndAmbiguousTable.end(), codepoint);
-
-    // For characters that are not _in_ the table, lower_bound will return the nearest item that is.
-    // We must check its bounds to make sure that our hit was a true hit.
-    if (it != s_wideAndAmbiguousTable.end() && codepoint >= it->lowerBound && codepoint <= it->upperBound)
-    {
-        return it->width;
-    }
-
-    return CodepointWidth::Narrow;
+    const auto leaf = til::at(s_widthTable.pages, codepoint >> s_pageShift);
+    return til::at(til::at(s_widthTable.leaves, leaf), codepoint & (s_pageSize - 1));
 }
 
 // Routine Description:
@@ -471,25 +665,39 @@ CodepointWidth CodepointWidthDetector::_lookupGlyphWidthWithCache(const std::wst
 // - Checks the fallback function but caches the results until the font changes
 //   because the lookup function is usually very expensive and will return the same results
 //   for the same inputs.
+// - The results are cached by codepoint in pages of _fallbackPageSize, which are allocated
+//   the first time one of their codepoints is asked for. Glyphs made of more than one
+//   codepoint aren't cached.
 // Arguments:
 // - glyph - the utf16 encoded codepoint to check width of
 // - true if codepoint is wide or false if it is narrow
 bool CodepointWidthDetector::_checkFallbackViaCache(const std::wstring_view glyph) const
 {
-    const std::wstring findMe{ glyph };
+    const auto isSingleCodepoint = glyph.size() == 1 || (glyph.size() == 2 && IS_HIGH_SURROGATE(glyph.front()) && IS_LOW_SURROGATE(glyph.back()));
+    if (!isSingleCodepoint)
+    {
+        return _pfnFallbackMethod(glyph);
+    }
 
-    // TODO: Cache needs to be emptied when font changes.
-    const auto it = _fallbackCache.find(findMe);
-    if (it == _fallbackCache.end())
+    const auto codepoint = _extractCodepoint(glyph);
+    const size_t page = codepoint / _fallbackPageSize;
+    if (page >= _fallbackCache.size())
     {
-        auto result = _pfnFallbackMethod(glyph);
-        _fallbackCache.insert_or_assign(findMe, result);
-        return result;
+        _fallbackCache.resize(page + 1);
     }
-    else
+
+    auto& entries = til::at(_fallbackCache, page);
+    if (!entries)
+    {
+        entries = std::make_unique<std::array<FallbackWidth, _fallbackPageSize>>();
+    }
+
+    auto& entry = til::at(*entries, codepoint % _fallbackPageSize);
+    if (entry == FallbackWidth::Unknown)
     {
-        return it->second;
+        entry = _pfnFallbackMethod(glyph) ? FallbackWidth::Wide : FallbackWidth::Narrow;
     }
+    return entry == FallbackWidth::Wide;
 }
 
 // Routine Description:
@@ -25,6 +25,22 @@ bool IsGlyphFullWidth(const wchar_t wch) noexcept
     return widthDetector.IsWide(wch);
 }
 
+// Function Description:
+// - determines how many columns each code unit of the text takes up, all at
+//      once. See CodepointWidthDetector::GetColumns
+void GetGlyphColumns(const std::wstring_view text, const gsl::span<uint8_t> columns) noexcept
+{
+    widthDetector.GetColumns(text, columns);
+}
+
+// Function Description:
+// - determines how many columns the text takes up.
+//      See CodepointWidthDetector::CountColumns
+size_t CountGlyphColumns(const std::wstring_view text) noexcept
+{
+    return widthDetector.CountColumns(text);
+}
+
 // Function Description:
 // - Sets a function that should be used by the global CodepointWidthDetector
 //      as the fallback mechanism for determining a particular glyph's width,
@@ -0,0 +1,473 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "inc/GraphemeSegmenter.hpp"
+#include "inc/Utf16Parser.hpp"
+
+using Property = GraphemeSegmenter::Property;
+
+namespace
+{
+    struct PropertyRange final
+    {
+        unsigned int lowerBound;
+        unsigned int upperBound;
+        Property property;
+    };
+
+    // The ranges of the Grapheme_Cluster_Break property (GraphemeBreakProperty.txt) and of
+    // Extended_Pictographic (emoji-data.txt) that text in a terminal runs into, from Unicode 13.0.0.
+    // Hangul syllables (U+AC00 to U+D7A3) aren't listed, since whether they're LV or LVT
+    // follows from their codepoint. Everything else is Other.
+    static constexpr PropertyRange s_propertyTable[]{
+        { 0x0000, 0x0009, Property::Control },
+        { 0x000a, 0x000a, Property::LF },
+        { 0x000b, 0x000c, Property::Control },
+        { 0x000d, 0x000d, Property::CR },
+        { 0x000e, 0x001f, Property::Control },
+        { 0x007f, 0x009f, Property::Control },
+        { 0x00a9, 0x00a9, Property::ExtendedPictographic },
+        { 0x00ad, 0x00ad, Property::Control },
+        { 0x00ae, 0x00ae, Property::ExtendedPictographic },
+        { 0x0300, 0x036f, Property::Extend },
+        { 0x0483, 0x0489, Property::Extend },
+        { 0x0591, 0x05bd, Property::Extend },
+        { 0x05bf, 0x05bf, Property::Extend },
+        { 0x05c1, 0x05c2, Property::Extend },
+        { 0x05c4, 0x05c5, Property::Extend },
+        { 0x05c7, 0x05c7, Property::Extend },
+        { 0x0600, 0x0605, Property::Prepend },
+        { 0x0610, 0x061a, Property::Extend },
+        { 0x061c, 0x061c, Property::Control },
+        { 0x064b, 0x065f, Property::Extend },
+        { 0x0670, 0x0670, Property::Extend },
+        { 0x06d6, 0x06dc, Property::Extend },
+        { 0x06dd, 0x06dd, Property::Prepend },
+        { 0x06df, 0x06e4, Property::Extend },
+        { 0x06e7, 0x06e8, Property::Extend },
+        { 0x06ea, 0x06ed, Property::Extend },
+        { 0x070f, 0x070f, Property::Prepend },
+        { 0x0711, 0x0711, Property::Extend },
+        { 0x0730, 0x074a, Property::Extend },
+        { 0x07a6, 0x07b0, Property::Extend },
+        { 0x07eb, 0x07f3, Property::Extend },
+        { 0x07fd, 0x07fd, Property::Extend },
+        { 0x0816, 0x0819, Property::Extend },
+        { 0x081b, 0x0823, Property::Extend },
+        { 0x0825, 0x0827, Property::Extend },
+        { 0x0829, 0x082d, Property::Extend },
+        { 0x0859, 0x085b, Property::Extend },
+        { 0x08d3, 0x08e1, Property::Extend },
+        { 0x08e2, 0x08e2, Property::Prepend },
+        { 0x08e3, 0x0902, Property::Extend },
+        { 0x0903, 0x0903, Property::SpacingMark },
+        { 0x093a, 0x093a, Property::Extend },
+        { 0x093b, 0x093b, Property::SpacingMark },
+        { 0x093c, 0x093c, Property::Extend },
+        { 0x093e, 0x0940, Property::SpacingMark },
+        { 0x0941, 0x0948, Property::Extend },
+        { 0x0949, 0x094c, Property::SpacingMark },
+        { 0x094d, 0x094d, Property::Extend },
+        { 0x094e, 0x094f, Property::SpacingMark },
+        { 0x0951, 0x0957, Property::Extend },
+        { 0x0962, 0x0963, Property::Extend },
+        { 0x0981, 0x0981, Property::Extend },
+        { 0x0982, 0x0983, Property::SpacingMark },
+        { 0x09bc, 0x09bc, Property::Extend },
+        { 0x09be, 0x09be, Property::Extend },
+        { 0x09bf, 0x09c0, Property::SpacingMark },
+        { 0x09c1, 0x09c4, Property::Extend },
+        { 0x09c7, 0x09c8, Property::SpacingMark },
+        { 0x09cb, 0x09cc, Property::SpacingMark },
+        { 0x09cd, 0x09cd, Property::Extend },
+        { 0x09d7, 0x09d7, Property::Extend },
+        { 0x09e2, 0x09e3, Property::Extend },
+        { 0x0a01, 0x0a02, Property::Extend },
+        { 0x0a03, 0x0a03, Property::SpacingMark },
+        { 0x0a3c, 0x0a3c, Property::Extend },
+        { 0x0a3e, 0x0a40, Property::SpacingMark },
+        { 0x0a41, 0x0a51, Property::Extend },
+        { 0x0a70, 0x0a71, Property::Extend },
+        { 0x0a75, 0x0a75, Property::Extend },
+        { 0x0a81, 0x0a82, Property::Extend },
+        { 0x0a83, 0x0a83, Property::SpacingMark },
+        { 0x0abc, 0x0abc, Property::Extend },
+        { 0x0abe, 0x0ac0, Property::SpacingMark },
+        { 0x0ac1, 0x0ac8, Property::Extend },
+        { 0x0ac9, 0x0acc, Property::SpacingMark },
+        { 0x0acd, 0x0acd, Property::Extend },
+        { 0x0b01, 0x0b01, Property::Extend },
+        { 0x0b02, 0x0b03, Property::SpacingMark },
+        { 0x0b3c, 0x0b3c, Property::Extend },
+        { 0x0b3e, 0x0b3f, Property::Extend },
+        { 0x0b40, 0x0b40, Property::SpacingMark },
+        { 0x0b41, 0x0b44, Property::Extend },
+        { 0x0b47, 0x0b4c, Property::SpacingMark },
+        { 0x0b4d, 0x0b4d, Property::Extend },
+        { 0x0bbe, 0x0bbe, Property::Extend },
+        { 0x0bbf, 0x0bbf, Property::SpacingMark },
+        { 0x0bc0, 0x0bc0, Property::Extend },
+        { 0x0bc1, 0x0bcc, Property::SpacingMark },
+        { 0x0bcd, 0x0bcd, Property::Extend },
+        { 0x0bd7, 0x0bd7, Property::Extend },
+        { 0x0c00, 0x0c00, Property::Extend },
+        { 0x0c01, 0x0c03, Property::SpacingMark },
+        { 0x0c3e, 0x0c40, Property::Extend },
+        { 0x0c41, 0x0c44, Property::SpacingMark },
+        { 0x0c46, 0x0c56, Property::Extend },
+        { 0x0d00, 0x0d01, Property::Extend },
+        { 0x0d02, 0x0d03, Property::SpacingMark },
+        { 0x0d3b, 0x0d3c, Property::Extend },
+        { 0x0d3e, 0x0d3e, Property::Extend },
+        { 0x0d3f, 0x0d40, Property::SpacingMark },
+        { 0x0d41, 0x0d44, Property::Extend },
+        { 0x0d46, 0x0d4c, Property::SpacingMark },
+        { 0x0d4d, 0x0d4d, Property::Extend },
+        { 0x0d4e, 0x0d4e, Property::Prepend },
+        { 0x0d57, 0x0d57, Property::Extend },
+        { 0x0e31, 0x0e31, Property::Extend },
+        { 0x0e33, 0x0e33, Property::SpacingMark },
+        { 0x0e34, 0x0e3a, Property::Extend },
+        { 0x0e47, 0x0e4e, Property::Extend },
+        { 0x0eb1, 0x0eb1, Property::Extend },
+        { 0x0eb3, 0x0eb3, Property::SpacingMark },
+        { 0x0eb4, 0x0ebc, Property::Extend },
+        { 0x0ec8, 0x0ecd, Property::Extend },
+        { 0x0f18, 0x0f19, Property::Extend },
+        { 0x0f35, 0x0f35, Property::Extend },
+        { 0x0f37, 0x0f37, Property::Extend },
+        { 0x0f39, 0x0f39, Property::Extend },
+        { 0x0f71, 0x0f7e, Property::Extend },
+        { 0x0f7f, 0x0f7f, Property::SpacingMark },
+        { 0x0f80, 0x0f84, Property::Extend },
+        { 0x0f86, 0x0f87, Property::Extend },
+        { 0x0f8d, 0x0fbc, Property::Extend },
+        { 0x0fc6, 0x0fc6, Property::Extend },
+        { 0x102d, 0x1030, Property::Extend },
+        { 0x1031, 0x1031, Property::SpacingMark },
+        { 0x1032, 0x1037, Property::Extend },
+        { 0x1039, 0x103a, Property::Extend },
+        { 0x103b, 0x103c, Property::SpacingMark },
+        { 0x103d, 0x103e, Property::Extend },
+        { 0x1100, 0x115f, Property::L },
+        { 0x1160, 0x11a7, Property::V },
+        { 0x11a8, 0x11ff, Property::T },
+        { 0x135d, 0x135f, Property::Extend },
+        { 0x1712, 0x1714, Property::Extend },
+        { 0x17b4, 0x17b5, Property::Extend },
+        { 0x17b6, 0x17b6, Property::SpacingMark },
+        { 0x17b7, 0x17bd, Property::Extend },
+        { 0x17be, 0x17c5, Property::SpacingMark },
+        { 0x17c6, 0x17c6, Property::Extend },
+        { 0x17c7, 0x17c8, Property::SpacingMark },
+        { 0x17c9, 0x17d3, Property::Extend },
+        { 0x17dd, 0x17dd, Property::Extend },
+        { 0x180b, 0x180d, Property::Extend },
+        { 0x180e, 0x180e, Property::Control },
+        { 0x1885, 0x1886, Property::Extend },
+        { 0x18a9, 0x18a9, Property::Extend },
+        { 0x1ab0, 0x1aff, Property::Extend },
+        { 0x1dc0, 0x1dff, Property::Extend },
+        { 0x200b, 0x200b, Property::Control },
+        { 0x200c, 0x200c, Property::Extend },
+        { 0x200d, 0x200d, Property::ZWJ },
+        { 0x200e, 0x200f, Property::Control },
+        { 0x2028, 0x202e, Property::Control },
+        { 0x203c, 0x203c, Property::ExtendedPictographic },
+        { 0x2049, 0x2049, Property::ExtendedPictographic },
+        { 0x2060, 0x206f, Property::Control },
+        { 0x20d0, 0x20f0, Property::Extend },
+        { 0x2122, 0x2122, Property::ExtendedPictographic },
+        { 0x2139, 0x2139, Property::ExtendedPictographic },
+        { 0x2194, 0x2199, Property::ExtendedPictographic },
+        { 0x21a9, 0x21aa, Property::ExtendedPictographic },
+        { 0x231a, 0x231b, Property::ExtendedPictographic },
+        { 0x2328, 0x2328, Property::ExtendedPictographic },
+        { 0x2388, 0x2388, Property::ExtendedPictographic },
+        { 0x23cf, 0x23cf, Property::ExtendedPictographic },
+        { 0x23e9, 0x23f3, Property::ExtendedPictographic },
+        { 0x23f8, 0x23fa, Property::ExtendedPictographic },
+        { 0x24c2, 0x24c2, Property::ExtendedPictographic },
+        { 0x25aa, 0x25ab, Property::ExtendedPictographic },
+        { 0x25b6, 0x25b6, Property::ExtendedPictographic },
+        { 0x25c0, 0x25c0, Property::ExtendedPictographic },
+        { 0x25fb, 0x25fe, Property::ExtendedPictographic },
+        { 0x2600, 0x2605, Property::ExtendedPictographic },
+        { 0x2607, 0x2612, Property::ExtendedPictographic },
+        { 0x2614, 0x2685, Property::ExtendedPictographic },
+        { 0x2690, 0x2705, Property::ExtendedPictographic },
+        { 0x2708, 0x2712, Property::ExtendedPictographic },
+        { 0x2714, 0x2714, Property::ExtendedPictographic },
+        { 0x2716, 0x2716, Property::ExtendedPictographic },
+        { 0x271d, 0x271d, Property::ExtendedPictographic },
+        { 0x2721, 0x2721, Property::ExtendedPictographic },
+        { 0x2728, 0x2728, Property::ExtendedPictographic },
+        { 0x2733, 0x2734, Property::ExtendedPictographic },
+        { 0x2744, 0x2744, Property::ExtendedPictographic },
+        { 0x2747, 0x2747, Property::ExtendedPictographic },
+        { 0x274c, 0x274c, Property::ExtendedPictographic },
+        { 0x274e, 0x274e, Property::ExtendedPictographic },
+        { 0x2753, 0x2755, Property::ExtendedPictographic },
+        { 0x2757, 0x2757, Property::ExtendedPictographic },
+        { 0x2763, 0x2767, Property::ExtendedPictographic },
+        { 0x2795, 0x2797, Property::ExtendedPictographic },
+        { 0x27a1, 0x27a1, Property::ExtendedPictographic },
+        { 0x27b0, 0x27b0, Property::ExtendedPictographic },
+        { 0x27bf, 0x27bf, Property::ExtendedPictographic },
+        { 0x2934, 0x2935, Property::ExtendedPictographic },
+        { 0x2b05, 0x2b07, Property::ExtendedPictographic },
+        { 0x2b1b, 0x2b1c, Property::ExtendedPictographic },
+        { 0x2b50, 0x2b50, Property::ExtendedPictographic },
+        { 0x2b55, 0x2b55, Property::ExtendedPictographic },
+        { 0x2cef, 0x2cf1, Property::Extend },
+        { 0x2d7f, 0x2d7f, Property::Extend },
+        { 0x2de0, 0x2dff, Property::Extend },
+        { 0x302a, 0x302f, Property::Extend },
+        { 0x3030, 0x3030, Property::ExtendedPictographic },
+        { 0x303d, 0x303d, Property::ExtendedPictographic },
+        { 0x3099, 0x309a, Property::Extend },
+        { 0x3297, 0x3297, Property::ExtendedPictographic },
+        { 0x3299, 0x3299, Property::ExtendedPictographic },
+        { 0xa66f, 0xa672, Property::Extend },
+        { 0xa674, 0xa67d, Property::Extend },
+        { 0xa69e, 0xa69f, Property::Extend },
+        { 0xa6f0, 0xa6f1, Property::Extend },
+        { 0xa960, 0xa97c, Property::L },
+        { 0xd7b0, 0xd7c6, Property::V },
+        { 0xd7cb, 0xd7fb, Property::T },
+        { 0xd800, 0xdfff, Property::Control }, // unpaired surrogates
+        { 0xfb1e, 0xfb1e, Property::Extend },
+        { 0xfe00, 0xfe0f, Property::Extend },
+        { 0xfe20, 0xfe2f, Property::Extend },
+        { 0xfeff, 0xfeff, Property::Control },
+        { 0xff9e, 0xff9f, Property::Extend },
+        { 0xfff0, 0xfffb, Property::Control },
+        { 0x101fd, 0x101fd, Property::Extend },
+        { 0x110bd, 0x110bd, Property::Prepend },
+        { 0x110cd, 0x110cd, Property::Prepend },
+        { 0x1d165, 0x1d165, Property::Extend },
+        { 0x1d167, 0x1d169, Property::Extend },
+        { 0x1d16e, 0x1d172, Property::Extend },
+        { 0x1d173, 0x1d17a, Property::Control },
+        { 0x1d17b, 0x1d182, Property::Extend },
+        { 0x1f000, 0x1f0ff, Property::ExtendedPictographic },
+        { 0x1f10d, 0x1f10f, Property::ExtendedPictographic },
+        { 0x1f12f, 0x1f12f, Property::ExtendedPictographic },
+        { 0x1f16c, 0x1f171, Property::ExtendedPictographic },
+        { 0x1f17e, 0x1f17f, Property::ExtendedPictographic },
+        { 0x1f18e, 0x1f18e, Property::ExtendedPictographic },
+        { 0x1f191, 0x1f19a, Property::ExtendedPictographic },
+        { 0x1f1ad, 0x1f1e5, Property::ExtendedPictographic },
+        { 0x1f1e6, 0x1f1ff, Property::RegionalIndicator },
+        { 0x1f201, 0x1f20f, Property::ExtendedPictographic },
+        { 0x1f21a, 0x1f21a, Property::ExtendedPictographic },
+        { 0x1f22f, 0x1f22f, Property::ExtendedPictographic },
+        { 0x1f232, 0x1f23a, Property::ExtendedPictographic },
+        { 0x1f23c, 0x1f23f, Property::ExtendedPictographic },
+        { 0x1f249, 0x1f3fa, Property::ExtendedPictographic },
+        { 0x1f3fb, 0x1f3ff, Property::Extend }, // skin tone modifiers
+        { 0x1f400, 0x1f53d, Property::ExtendedPictographic },
+        { 0x1f546, 0x1f64f, Property::ExtendedPictographic },
+        { 0x1f680, 0x1f6ff, Property::ExtendedPictographic },
+        { 0x1f774, 0x1f77f, Property::ExtendedPictographic },
+        { 0x1f7d5, 0x1f7ff, Property::ExtendedPictographic },
+        { 0x1f80c, 0x1f80f, Property::ExtendedPictographic },
+        { 0x1f848, 0x1f84f, Property::ExtendedPictographic },
+        { 0x1f85a, 0x1f85f, Property::ExtendedPictographic },
+        { 0x1f888, 0x1f88f, Property::ExtendedPictographic },
+        { 0x1f8ae, 0x1f8ff, Property::ExtendedPictographic },
+        { 0x1f90c, 0x1f93a, Property::ExtendedPictographic },
+        { 0x1f93c, 0x1f945, Property::ExtendedPictographic },
+        { 0x1f947, 0x1faff, Property::ExtendedPictographic },
+        { 0x1fc00, 0x1fffd, Property::ExtendedPictographic },
+        { 0xe0000, 0xe001f, Property::Control },
+        { 0xe0020, 0xe007f, Property::Extend }, // emoji tag sequences
+        { 0xe0080, 0xe00ff, Property::Control },
+        { 0xe0100, 0xe01ef, Property::Extend },
+        { 0xe01f0, 0xe0fff, Property::Control },
+    };
+
+    static constexpr bool s_isSorted() noexcept
+    {
+        for (size_t i = 1; i < std::size(s_propertyTable); ++i)
+        {
+            if (s_propertyTable[i - 1].upperBound >= s_propertyTable[i].lowerBound)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(s_isSorted(), "s_propertyTable has to be sorted and free of overlaps for the binary search");
+
+    // Returns the codepoint at pos and the number of code units it takes up.
+    // Unpaired surrogates are returned as they are, which makes them Control, as they should be.
+    static std::pair<unsigned int, size_t> s_decode(const std::wstring_view wstr, const size_t pos) noexcept
+    {
+        const auto lead = til::at(wstr, pos);
+        if (Utf16Parser::IsLeadingSurrogate(lead) && pos + 1 < wstr.size())
+        {
+            const auto trail = til::at(wstr, pos + 1);
+            if (Utf16Parser::IsTrailingSurrogate(trail))
+            {
+                return { (((lead & 0x3FFu) << 10) | (trail & 0x3FFu)) + 0x10000, 2 };
+            }
+        }
+        return { lead, 1 };
+    }
+
+    // The state of the rules that look further back than the previous codepoint.
+    struct BreakState final
+    {
+        // GB11: we're after an Extended_Pictographic followed by any number of Extend.
+        bool pictographic = false;
+        // GB11: ..., followed by a ZWJ.
+        bool pictographicZwj = false;
+        // GB12/GB13: the number of regional indicators in a row before the current codepoint.
+        size_t regionalIndicators = 0;
+    };
+
+    // Returns whether the codepoints with the properties prev and next belong to the same cluster.
+    static bool s_joins(const Property prev, const Property next, const BreakState& state) noexcept
+    {
+        switch (prev)
+        {
+        case Property::CR:
+            return next == Property::LF; // GB3, GB4
+        case Property::LF:
+        case Property::Control:
+            return false; // GB4
+        default:
+            break;
+        }
+
+        switch (next)
+        {
+        case Property::CR:
+        case Property::LF:
+        case Property::Control:
+            return false; // GB5
+        case Property::Extend:
+        case Property::ZWJ:
+        case Property::SpacingMark:
+            return true; // GB9, GB9a
+        default:
+            break;
+        }
+
+        switch (prev)
+        {
+        case Property::Prepend:
+            return true; // GB9b
+        case Property::L:
+            return next == Property::L || next == Property::V || next == Property::LV || next == Property::LVT; // GB6
+        case Property::LV:
+        case Property::V:
+            return next == Property::V || next == Property::T; // GB7
+        case Property::LVT:
+        case Property::T:
+            return next == Property::T; // GB8
+        case Property::ZWJ:
+            return next == Property::ExtendedPictographic && state.pictographicZwj; // GB11
+        case Property::RegionalIndicator:
+            return next == Property::RegionalIndicator && (state.regionalIndicators % 2) == 1; // GB12, GB13
+        default:
+            return false; // GB999
+        }
+    }
+}
+
+// Routine Description:
+// - Looks up the Grapheme_Cluster_Break property of a codepoint.
+// Arguments:
+// - codepoint - the codepoint to look up
+// Return Value:
+// - the property, which is Extended_Pictographic for the codepoints that have it.
+Property GraphemeSegmenter::GetProperty(const unsigned int codepoint) noexcept
+{
+    if (codepoint >= 0x20 && codepoint < 0x7f)
+    {
+        return Property::Other;
+    }
+
+    if (codepoint >= 0xac00 && codepoint <= 0xd7a3)
+    {
+        // Every 28th syllable has no trailing consonant.
+        return (codepoint - 0xac00) % 28 == 0 ? Property::LV : Property::LVT;
+    }
+
+    const auto it = std::lower_bound(std::begin(s_propertyTable), std::end(s_propertyTable), codepoint, [](const PropertyRange& range, const unsigned int searchTerm) noexcept {
+        return range.upperBound < searchTerm;
+    });
+    if (it != std::end(s_propertyTable) && codepoint >= it->lowerBound)
+    {
+        return it->property;
+    }
+    return Property::Other;
+}
+
+// Routine Description:
+// - Finds the first grapheme cluster of the given UTF-16 string.
+// - Most text is made of printable ASCII, which can only be joined by something that
+//   isn't ASCII, so a printable ASCII character followed by ASCII is returned right away.
+// Arguments:
+// - wstr - The UTF-16 string to parse.
+// Return Value:
+// - A view into the string given of just the first cluster. Empty if the string is.
+std::wstring_view GraphemeSegmenter::ParseNext(const std::wstring_view wstr) noexcept
+{
+    if (wstr.empty())
+    {
+        return {};
+    }
+
+    const auto first = til::at(wstr, 0);
+    if (first >= 0x20 && first < 0x7f && (wstr.size() == 1 || til::at(wstr, 1) < 0x80))
+    {
+        return wstr.substr(0, 1);
+    }
+
+    auto [codepoint, pos] = s_decode(wstr, 0);
+    auto prev = GetProperty(codepoint);
+
+    BreakState state;
+    state.pictographic = prev == Property::ExtendedPictographic;
+    state.regionalIndicators = prev == Property::RegionalIndicator ? 1 : 0;
+
+    while (pos < wstr.size())
+    {
+        const auto [nextCodepoint, length] = s_decode(wstr, pos);
+        const auto next = GetProperty(nextCodepoint);
+        if (!s_joins(prev, next, state))
+        {
+            break;
+        }
+
+        state.pictographicZwj = state.pictographic && next == Property::ZWJ;
+        state.pictographic = next == Property::ExtendedPictographic || (state.pictographic && next == Property::Extend);
+        state.regionalIndicators = next == Property::RegionalIndicator ? state.regionalIndicators + 1 : 0;
+
+        prev = next;
+        pos += length;
+    }
+
+    return wstr.substr(0, pos);
+}
+
+// Routine Description:
+// - Counts the grapheme clusters in the given UTF-16 string.
+// Arguments:
+// - wstr - The UTF-16 string to count the clusters of.
+// Return Value:
+// - The number of clusters.
+size_t GraphemeSegmenter::CountClusters(const std::wstring_view wstr) noexcept
+{
+    size_t count = 0;
+    for (auto rest = wstr; !rest.empty(); ++count)
+    {
+        rest.remove_prefix(ParseNext(rest).size());
+    }
+    return count;
+}
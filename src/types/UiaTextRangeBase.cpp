@@ -451,6 +451,13 @@ IFACEMETHODIMP UiaTextRangeBase::GetBoundingRectangles(_Outptr_result_maybenull_
         {
             const auto textRects = buffer.GetTextRects(startAnchor, endAnchor, _blockRange, true);
 
+            // The font size and the position of the window are the same for
+            // every row, so they're retrieved once rather than once per row.
+            const til::size fontSize{ _getScreenFontSize() };
+            POINT screenOrigin{ 0 };
+            _TranslatePointToScreen(&screenOrigin);
+
+            coords.reserve(textRects.size() * 4);
             for (const auto& rect : textRects)
             {
                 // Convert the buffer coordinates to an equivalent range of
@@ -458,7 +465,7 @@ IFACEMETHODIMP UiaTextRangeBase::GetBoundingRectangles(_Outptr_result_maybenull_
                 const auto lineRendition = buffer.GetLineRendition(rect.Top);
                 til::rectangle r{ BufferToScreenLine(rect, lineRendition) };
                 r -= viewportOrigin;
-                _getBoundingRect(r, coords);
+                _getBoundingRect(r, fontSize, screenOrigin, coords);
             }
         }
 
@@ -468,16 +475,18 @@ IFACEMETHODIMP UiaTextRangeBase::GetBoundingRectangles(_Outptr_result_maybenull_
         {
             return E_OUTOFMEMORY;
         }
-        HRESULT hr = E_UNEXPECTED;
-        for (LONG i = 0; i < gsl::narrow<LONG>(coords.size()); ++i)
+        if (!coords.empty())
         {
-            hr = SafeArrayPutElement(*ppRetVal, &i, &coords.at(i));
+            double* data = nullptr;
+            const auto hr = SafeArrayAccessData(*ppRetVal, reinterpret_cast<void**>(&data));
             if (FAILED(hr))
             {
                 SafeArrayDestroy(*ppRetVal);
                 *ppRetVal = nullptr;
                 return hr;
             }
+            std::copy(coords.begin(), coords.end(), data);
+            LOG_IF_FAILED(SafeArrayUnaccessData(*ppRetVal));
         }
     }
     CATCH_RETURN();
@@ -555,20 +564,26 @@ std::wstring UiaTextRangeBase::_getTextValue(std::optional<unsigned int> maxLeng
         auto inclusiveEnd = _end;
         bufferSize.DecrementInBounds(inclusiveEnd, true);
 
+        // The text is sliced out of the text the buffer caches for every row
+        // and gathered only up to maxLength, since clients tend to ask for the
+        // text of the whole document over and over.
+        const auto limit = maxLength.value_or(std::numeric_limits<unsigned int>::max());
         const auto textRects = buffer.GetTextRects(_start, inclusiveEnd, _blockRange, true);
-        const auto bufferData = buffer.GetText(true,
-                                               false,
-                                               textRects);
-
-        const size_t textDataSize = base::ClampMul(bufferData.text.size(), bufferSize.Width());
-        textData.reserve(textDataSize);
-        for (const auto& text : bufferData.text)
+        textData.reserve(std::min<size_t>(limit, base::ClampMul(textRects.size(), base::ClampAdd(bufferSize.Width(), 2))));
+        for (size_t i = 0; i < textRects.size() && textData.size() < limit; ++i)
         {
-            textData += text;
+            const auto& rect = til::at(textRects, i);
+            textData.append(buffer.GetRowText(rect.Top, rect.Left, rect.Right));
+
+            // Like GetText, the rows are separated by a CR/LF, unless they were wrapped.
+            if (i + 1 < textRects.size() && !buffer.GetRowByOffset(rect.Top).WasWrapForced())
+            {
+                textData.append(L"\r\n");
+            }
         }
     }
 
-    if (maxLength.has_value())
+    if (maxLength.has_value() && textData.size() > *maxLength)
     {
         textData.resize(*maxLength);
     }
@@ -895,33 +910,34 @@ const Viewport UiaTextRangeBase::_getBufferSize() const noexcept
 
 // Routine Description:
 // - adds the relevant coordinate points from the row to coords.
-// - it is assumed that startAnchor and endAnchor are within the same row
+// - it is assumed that the rectangle is within a single row
 //    and NOT DEGENERATE
 // Arguments:
-// - startAnchor - the start anchor of interested data within the viewport. In text buffer coordinate space. Inclusive.
-// - endAnchor - the end anchor of interested data within the viewport. In text buffer coordinate space. Inclusive
+// - textRect - the screen cells of interested data within the viewport. Exclusive.
+// - fontSize - the size of a cell in pixels, see _getScreenFontSize
+// - screenOrigin - the origin of the client window, relative to the screen
 // - coords - vector to add the calculated coords to
 // Return Value:
 // - <none>
-void UiaTextRangeBase::_getBoundingRect(const til::rectangle textRect, _Inout_ std::vector<double>& coords) const
+void UiaTextRangeBase::_getBoundingRect(const til::rectangle textRect, const til::size fontSize, const POINT screenOrigin, _Inout_ std::vector<double>& coords) const
 {
-    const til::size currentFontSize = _getScreenFontSize();
-
     POINT topLeft{ 0 };
     POINT bottomRight{ 0 };
 
     // we want to clamp to a long (output type), not a short (input type)
     // so we need to explicitly say <long,long>
-    topLeft.x = base::ClampMul(textRect.left(), currentFontSize.width());
-    topLeft.y = base::ClampMul(textRect.top(), currentFontSize.height());
+    topLeft.x = base::ClampMul(textRect.left(), fontSize.width());
+    topLeft.y = base::ClampMul(textRect.top(), fontSize.height());
 
-    bottomRight.x = base::ClampMul(textRect.right(), currentFontSize.width());
-    bottomRight.y = base::ClampMul(textRect.bottom(), currentFontSize.height());
+    bottomRight.x = base::ClampMul(textRect.right(), fontSize.width());
+    bottomRight.y = base::ClampMul(textRect.bottom(), fontSize.height());
 
     // convert the coords to be relative to the screen instead of
     // the client window
-    _TranslatePointToScreen(&topLeft);
-    _TranslatePointToScreen(&bottomRight);
+    topLeft.x = base::ClampAdd(topLeft.x, screenOrigin.x);
+    topLeft.y = base::ClampAdd(topLeft.y, screenOrigin.y);
+    bottomRight.x = base::ClampAdd(bottomRight.x, screenOrigin.x);
+    bottomRight.y = base::ClampAdd(bottomRight.y, screenOrigin.y);
 
     const long width = base::ClampSub(bottomRight.x, topLeft.x);
     const long height = base::ClampSub(bottomRight.y, topLeft.y);
@@ -33,6 +33,8 @@ public:
     CodepointWidth GetWidth(const std::wstring_view glyph) const;
     bool IsWide(const std::wstring_view glyph) const;
     bool IsWide(const wchar_t wch) const noexcept;
+    void GetColumns(const std::wstring_view text, const gsl::span<uint8_t> columns) const noexcept;
+    size_t CountColumns(const std::wstring_view text) const noexcept;
     void SetFallbackMethod(std::function<bool(const std::wstring_view)> pfnFallback);
     void NotifyFontChanged() const noexcept;
 
@@ -43,9 +45,21 @@ public:
 private:
     CodepointWidth _lookupGlyphWidth(const std::wstring_view glyph) const;
     CodepointWidth _lookupGlyphWidthWithCache(const std::wstring_view glyph) const noexcept;
+    template<typename Sink>
+    void _forEachColumns(const std::wstring_view text, Sink&& sink) const noexcept;
     bool _checkFallbackViaCache(const std::wstring_view glyph) const;
     static unsigned int _extractCodepoint(const std::wstring_view glyph) noexcept;
 
-    mutable std::unordered_map<std::wstring, bool> _fallbackCache;
+    enum class FallbackWidth : uint8_t
+    {
+        Unknown, // the fallback method wasn't asked yet
+        Narrow,
+        Wide
+    };
+
+    static constexpr size_t _fallbackPageSize = 256;
+
+    // Indexed by codepoint / _fallbackPageSize, and then by codepoint % _fallbackPageSize.
+    mutable std::vector<std::unique_ptr<std::array<FallbackWidth, _fallbackPageSize>>> _fallbackCache;
     std::function<bool(std::wstring_view)> _pfnFallbackMethod;
 };
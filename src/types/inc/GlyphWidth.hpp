@@ -14,5 +14,7 @@ Abstract:
 
 bool IsGlyphFullWidth(const std::wstring_view glyph);
 bool IsGlyphFullWidth(const wchar_t wch) noexcept;
+void GetGlyphColumns(const std::wstring_view text, const gsl::span<uint8_t> columns) noexcept;
+size_t CountGlyphColumns(const std::wstring_view text) noexcept;
 void SetGlyphWidthFallback(std::function<bool(std::wstring_view)> pfnFallback);
 void NotifyGlyphWidthFontChanged() noexcept;
@@ -0,0 +1,45 @@
+/*++
+Copyright (c) Microsoft Corporation
+
+Module Name:
+- GraphemeSegmenter.hpp
+
+Abstract:
+- Splits UTF-16 text into extended grapheme clusters, following the rules of UAX #29.
+- A cluster is what the user perceives as a single character: a base character with its
+  combining marks, a Hangul syllable made of jamo, an emoji ZWJ sequence, a flag made of
+  two regional indicators, and so on. The text buffer stores one cluster per cell.
+
+--*/
+
+#pragma once
+
+#include <string_view>
+
+class GraphemeSegmenter final
+{
+public:
+    // The Grapheme_Cluster_Break property of a codepoint, along with Extended_Pictographic.
+    enum class Property : uint8_t
+    {
+        Other,
+        CR,
+        LF,
+        Control,
+        Extend,
+        ZWJ,
+        RegionalIndicator,
+        Prepend,
+        SpacingMark,
+        L,
+        V,
+        T,
+        LV,
+        LVT,
+        ExtendedPictographic,
+    };
+
+    static std::wstring_view ParseNext(const std::wstring_view wstr) noexcept;
+    static size_t CountClusters(const std::wstring_view wstr) noexcept;
+    static Property GetProperty(const unsigned int codepoint) noexcept;
+};
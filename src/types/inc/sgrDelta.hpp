@@ -0,0 +1,66 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- sgrDelta.hpp
+
+Abstract:
+- Folds the parameters of an SGR sequence into a single change of text attributes,
+  which is then applied in one step. Every option either sets or clears some
+  flags or replaces a color, so the combined effect of any number of them
+  comes down to a set mask, a clear mask and the final colors.
+- The options are looked up in a table built at compile time, which is shared
+  by the conhost and Terminal dispatchers.
+
+--*/
+
+#pragma once
+
+#include "..\..\buffer\out\TextAttribute.hpp"
+#include "..\..\terminal\adapter\DispatchTypes.hpp"
+
+namespace Microsoft::Console::VirtualTerminal
+{
+    class SgrDelta final
+    {
+    public:
+        // The order of the 16 indexed colors in the color table of the caller.
+        enum class ColorIndices : uint8_t
+        {
+            Xterm, // red is 1, blue is 4
+            Windows, // blue is 1, red is 4
+        };
+
+        constexpr SgrDelta() noexcept = default;
+
+        // Method Description:
+        // - Folds the given SGR options into the change they make, in order.
+        // Arguments:
+        // - options - the parameters of the SGR sequence
+        // - colorIndices - the order of the indexed colors the change should use
+        // Return Value:
+        // - The combined change.
+        static SgrDelta Fold(const VTParameters options, const ColorIndices colorIndices) noexcept;
+
+        // Method Description:
+        // - Applies the change to the given attributes.
+        // Arguments:
+        // - attr - the attributes to change
+        // Return Value:
+        // - <none>
+        void ApplyTo(TextAttribute& attr) const noexcept;
+
+    private:
+        size_t _FoldExtendedColor(const VTParameters options, const bool isForeground, const ColorIndices colorIndices) noexcept;
+        void _Set(const ExtendedAttributes extended, const WORD legacy) noexcept;
+        void _Clear(const ExtendedAttributes extended, const WORD legacy) noexcept;
+
+        ExtendedAttributes _setExtended{ ExtendedAttributes::Normal };
+        ExtendedAttributes _clearExtended{ ExtendedAttributes::Normal };
+        WORD _setLegacy{ 0 };
+        WORD _clearLegacy{ 0 };
+        std::optional<TextColor> _foreground;
+        std::optional<TextColor> _background;
+    };
+}
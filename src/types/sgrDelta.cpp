@@ -0,0 +1,216 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "inc/sgrDelta.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+using namespace Microsoft::Console::VirtualTerminal::DispatchTypes;
+
+namespace
+{
+    // What a single SGR option does. The indexed colors are stored in xterm order.
+    struct SgrAction
+    {
+        enum class Kind : uint8_t
+        {
+            None,
+            Reset,
+            Set,
+            Clear,
+            Foreground,
+            Background,
+            DefaultForeground,
+            DefaultBackground,
+            ExtendedForeground,
+            ExtendedBackground,
+        };
+
+        Kind kind{ Kind::None };
+        ExtendedAttributes extended{ ExtendedAttributes::Normal };
+        WORD legacy{ 0 };
+        BYTE index{ 0 };
+    };
+
+    constexpr size_t s_actionCount = BrightBackgroundWhite + 1;
+
+    constexpr std::array<SgrAction, s_actionCount> s_BuildActions() noexcept
+    {
+        using Kind = SgrAction::Kind;
+        std::array<SgrAction, s_actionCount> actions{};
+
+        actions[Off] = { Kind::Reset };
+        actions[BoldBright] = { Kind::Set, ExtendedAttributes::Bold };
+        actions[RGBColorOrFaint] = { Kind::Set, ExtendedAttributes::Faint };
+        actions[Italics] = { Kind::Set, ExtendedAttributes::Italics };
+        actions[Underline] = { Kind::Set, ExtendedAttributes::Underlined };
+        actions[BlinkOrXterm256Index] = { Kind::Set, ExtendedAttributes::Blinking };
+        // We just interpret rapid blink as an alias of blink.
+        actions[RapidBlink] = { Kind::Set, ExtendedAttributes::Blinking };
+        actions[Negative] = { Kind::Set, ExtendedAttributes::Normal, COMMON_LVB_REVERSE_VIDEO };
+        actions[Invisible] = { Kind::Set, ExtendedAttributes::Invisible };
+        actions[CrossedOut] = { Kind::Set, ExtendedAttributes::CrossedOut };
+        actions[DoublyUnderlined] = { Kind::Set, ExtendedAttributes::DoublyUnderlined };
+        actions[NotBoldOrFaint] = { Kind::Clear, ExtendedAttributes::Bold | ExtendedAttributes::Faint };
+        actions[NotItalics] = { Kind::Clear, ExtendedAttributes::Italics };
+        actions[NoUnderline] = { Kind::Clear, ExtendedAttributes::Underlined | ExtendedAttributes::DoublyUnderlined };
+        actions[Steady] = { Kind::Clear, ExtendedAttributes::Blinking };
+        actions[Positive] = { Kind::Clear, ExtendedAttributes::Normal, COMMON_LVB_REVERSE_VIDEO };
+        actions[Visible] = { Kind::Clear, ExtendedAttributes::Invisible };
+        actions[NotCrossedOut] = { Kind::Clear, ExtendedAttributes::CrossedOut };
+        actions[ForegroundExtended] = { Kind::ExtendedForeground };
+        actions[ForegroundDefault] = { Kind::DefaultForeground };
+        actions[BackgroundExtended] = { Kind::ExtendedBackground };
+        actions[BackgroundDefault] = { Kind::DefaultBackground };
+        actions[Overline] = { Kind::Set, ExtendedAttributes::Normal, COMMON_LVB_GRID_HORIZONTAL };
+        actions[NoOverline] = { Kind::Clear, ExtendedAttributes::Normal, COMMON_LVB_GRID_HORIZONTAL };
+
+        for (BYTE i = 0; i < 8; i++)
+        {
+            actions[ForegroundBlack + i] = { Kind::Foreground, ExtendedAttributes::Normal, 0, i };
+            actions[BackgroundBlack + i] = { Kind::Background, ExtendedAttributes::Normal, 0, i };
+            actions[BrightForegroundBlack + i] = { Kind::Foreground, ExtendedAttributes::Normal, 0, gsl::narrow_cast<BYTE>(i + 8) };
+            actions[BrightBackgroundBlack + i] = { Kind::Background, ExtendedAttributes::Normal, 0, gsl::narrow_cast<BYTE>(i + 8) };
+        }
+
+        return actions;
+    }
+
+    constexpr auto s_actions = s_BuildActions();
+
+    // Same as Xterm256ToWindowsIndex, which lives in the host and isn't available to the Terminal.
+    BYTE s_ToColorIndex(const size_t xtermIndex, const SgrDelta::ColorIndices colorIndices) noexcept
+    {
+        if (colorIndices == SgrDelta::ColorIndices::Xterm || xtermIndex >= 16)
+        {
+            return gsl::narrow_cast<BYTE>(xtermIndex);
+        }
+
+        return gsl::narrow_cast<BYTE>((WI_IsFlagSet(xtermIndex, XTERM_RED_ATTR) ? WINDOWS_RED_ATTR : 0) |
+                                      (WI_IsFlagSet(xtermIndex, XTERM_GREEN_ATTR) ? WINDOWS_GREEN_ATTR : 0) |
+                                      (WI_IsFlagSet(xtermIndex, XTERM_BLUE_ATTR) ? WINDOWS_BLUE_ATTR : 0) |
+                                      (WI_IsFlagSet(xtermIndex, XTERM_BRIGHT_ATTR) ? WINDOWS_BRIGHT_ATTR : 0));
+    }
+}
+
+SgrDelta SgrDelta::Fold(const VTParameters options, const ColorIndices colorIndices) noexcept
+{
+    using Kind = SgrAction::Kind;
+    SgrDelta delta;
+
+    for (size_t i = 0; i < options.size(); i++)
+    {
+        const GraphicsOptions opt = options.at(i);
+        if (opt >= s_actionCount)
+        {
+            continue;
+        }
+
+        const auto& action = til::at(s_actions, opt);
+        switch (action.kind)
+        {
+        case Kind::Reset:
+            delta._Clear(static_cast<ExtendedAttributes>(0xff), 0xffff);
+            delta._foreground = TextColor{};
+            delta._background = TextColor{};
+            break;
+        case Kind::Set:
+            delta._Set(action.extended, action.legacy);
+            break;
+        case Kind::Clear:
+            delta._Clear(action.extended, action.legacy);
+            break;
+        case Kind::Foreground:
+            delta._foreground = TextColor{ s_ToColorIndex(action.index, colorIndices), false };
+            break;
+        case Kind::Background:
+            delta._background = TextColor{ s_ToColorIndex(action.index, colorIndices), false };
+            break;
+        case Kind::DefaultForeground:
+            delta._foreground = TextColor{};
+            break;
+        case Kind::DefaultBackground:
+            delta._background = TextColor{};
+            break;
+        case Kind::ExtendedForeground:
+            i += delta._FoldExtendedColor(options.subspan(i + 1), true, colorIndices);
+            break;
+        case Kind::ExtendedBackground:
+            i += delta._FoldExtendedColor(options.subspan(i + 1), false, colorIndices);
+            break;
+        case Kind::None:
+            break;
+        }
+    }
+
+    return delta;
+}
+
+void SgrDelta::ApplyTo(TextAttribute& attr) const noexcept
+{
+    attr.UpdateMetaAttrs(_setExtended, _clearExtended, _setLegacy, _clearLegacy);
+    if (_foreground)
+    {
+        attr.SetForeground(*_foreground);
+    }
+    if (_background)
+    {
+        attr.SetBackground(*_background);
+    }
+}
+
+// Routine Description:
+// - Folds in the extended color options, which follow a 38 (FG) or 48 (BG).
+//   These are either a 2 (RGB) followed by the R, G and B parts of the color,
+//   or a 5 (xterm index) followed by an index into the 256 color xterm color table.
+// Arguments:
+// - options - the options following the 38 or 48
+// - isForeground - whether the color is for the foreground
+// - colorIndices - the order of the indexed colors
+// Return Value:
+// - The number of options consumed, not including the initial 38/48.
+size_t SgrDelta::_FoldExtendedColor(const VTParameters options, const bool isForeground, const ColorIndices colorIndices) noexcept
+{
+    auto& color = isForeground ? _foreground : _background;
+    size_t optionsConsumed = 1;
+    const GraphicsOptions typeOpt = options.at(0);
+    if (typeOpt == RGBColorOrFaint)
+    {
+        optionsConsumed = 4;
+        const size_t red = options.at(1).value_or(0);
+        const size_t green = options.at(2).value_or(0);
+        const size_t blue = options.at(3).value_or(0);
+        // ensure that each value fits in a byte
+        if (red <= 255 && green <= 255 && blue <= 255)
+        {
+            color = TextColor{ RGB(red, green, blue) };
+        }
+    }
+    else if (typeOpt == BlinkOrXterm256Index)
+    {
+        optionsConsumed = 2;
+        const size_t tableIndex = options.at(1).value_or(0);
+        if (tableIndex <= 255)
+        {
+            color = TextColor{ s_ToColorIndex(tableIndex, colorIndices), true };
+        }
+    }
+    return optionsConsumed;
+}
+
+// A later option wins over an earlier one, so setting a flag undoes clearing it and vice versa.
+void SgrDelta::_Set(const ExtendedAttributes extended, const WORD legacy) noexcept
+{
+    _setExtended |= extended;
+    WI_ClearAllFlags(_clearExtended, extended);
+    _setLegacy |= legacy;
+    WI_ClearAllFlags(_clearLegacy, legacy);
+}
+
+void SgrDelta::_Clear(const ExtendedAttributes extended, const WORD legacy) noexcept
+{
+    _clearExtended |= extended;
+    WI_ClearAllFlags(_setExtended, extended);
+    _clearLegacy |= legacy;
+    WI_ClearAllFlags(_setLegacy, legacy);
+}
@@ -0,0 +1,159 @@
+# Copyright (c) Microsoft Corporation.
+# Licensed under the MIT license.
+
+################################
+# This script launches Windows Terminal a number of times while recording
+# a trace with src\Terminal.wprp, and reports the percentiles of the time
+# from launch to the first frame, and of each of the startup phases (see
+# src\inc\StartupTracing.h). The same traces can be opened in WPA with
+# src\ConsolePerf.regions.xml to see the timeline of a single launch.
+#
+# The cold launches come first. Each of them starts with no Terminal running,
+# after the optional -FlushCommand (something like "RAMMap.exe -Et", to empty
+# the standby list, so that the binaries have to be read from disk again).
+# The warm launches follow right after, after one that isn't counted.
+#
+# wpr.exe needs to run elevated.
+
+[CmdletBinding()]
+Param(
+    [int]$Cold = 5,
+    [int]$Warm = 10,
+    [string]$Terminal = "wt.exe",
+    [string[]]$ArgumentList = @(),
+    [string]$FlushCommand,
+    [int]$SettleSeconds = 5,
+    [string]$OutputDirectory = (Join-Path ([System.IO.Path]::GetTempPath()) "TerminalStartup")
+)
+
+$ErrorActionPreference = "Stop"
+
+$WprProfile = Join-Path (& git rev-parse --show-toplevel) "src\Terminal.wprp"
+
+$Win32HostProvider = [guid]"56c06166-2e2e-5f4d-7ff3-74f4b78c87d6"
+$DirectXProvider = [guid]"c93e739e-ae50-5a14-78e7-f171e947535d"
+$OpcodeInfo = 0
+$OpcodeStart = 1
+$OpcodeStop = 2
+$LevelInfo = 4
+
+Function Stop-Terminal() {
+    Get-Process WindowsTerminal -ErrorAction SilentlyContinue | Stop-Process -Force
+    While (Get-Process WindowsTerminal -ErrorAction SilentlyContinue) {
+        Start-Sleep -Milliseconds 100
+    }
+}
+
+# Launches the Terminal once while recording a trace, and returns the path of the trace.
+Function Invoke-TracedLaunch([string]$Name) {
+    $Trace = Join-Path $OutputDirectory "$Name.etl"
+    & wpr.exe -start "$WprProfile!Terminal.Light" -filemode
+    If ($LASTEXITCODE -Ne 0) {
+        Throw "wpr.exe failed to start a trace ($LASTEXITCODE)"
+    }
+
+    Try {
+        If ($ArgumentList.Count -Gt 0) {
+            Start-Process $Terminal -ArgumentList $ArgumentList | Out-Null
+        } Else {
+            Start-Process $Terminal | Out-Null
+        }
+        Start-Sleep -Seconds $SettleSeconds
+    } Finally {
+        & wpr.exe -stop $Trace | Out-Null
+    }
+
+    Stop-Terminal
+    $Trace
+}
+
+# Returns the milliseconds from launch to the first frame, and of the first time
+# each phase ran, keyed by their names. A launch that didn't present a frame
+# within -SettleSeconds has no "Launch" entry.
+Function Get-StartupTimes([string]$Trace) {
+    $Times = @{}
+    $Starts = @{}
+    $Launch = $Null
+
+    ForEach ($Record in Get-WinEvent -Path $Trace -Oldest -ErrorAction SilentlyContinue) {
+        If ($Record.ProviderId -Eq $Win32HostProvider -And $Record.Opcode -Eq $OpcodeStart) {
+            $Launch = $Record.TimeCreated
+        } ElseIf ($Record.ProviderId -Eq $DirectXProvider -And $Record.Opcode -Eq $OpcodeInfo -And $Record.Level -Eq $LevelInfo) {
+            # FirstPresent is the only event of the renderer at this level without an opcode.
+            If ($Launch -And -Not $Times.ContainsKey("Launch")) {
+                $Times["Launch"] = ($Record.TimeCreated - $Launch).TotalMilliseconds
+            }
+        } ElseIf ($Record.Opcode -Eq $OpcodeStart -Or $Record.Opcode -Eq $OpcodeStop) {
+            If ($Record.Properties.Count -Lt 1) {
+                Continue
+            }
+
+            $Phase = [string]$Record.Properties[0].Value
+            $Key = "$Phase/$($Record.ThreadId)"
+            If ($Record.Opcode -Eq $OpcodeStart) {
+                $Starts[$Key] = $Record.TimeCreated
+            } ElseIf ($Starts.ContainsKey($Key) -And -Not $Times.ContainsKey($Phase)) {
+                $Times[$Phase] = ($Record.TimeCreated - $Starts[$Key]).TotalMilliseconds
+            }
+        }
+    }
+
+    $Times
+}
+
+Function Get-Percentile([double[]]$Values, [double]$Percentile) {
+    $Sorted = $Values | Sort-Object
+    $Index = [Math]::Max([Math]::Ceiling($Percentile / 100 * $Sorted.Count) - 1, 0)
+    $Sorted[$Index]
+}
+
+Function Measure-Launches([string]$Kind, [int]$Count) {
+    $Results = @()
+    For ($i = 0; $i -Lt $Count; $i++) {
+        If ($Kind -Eq "cold") {
+            Stop-Terminal
+            If ($FlushCommand) {
+                Invoke-Expression $FlushCommand | Out-Null
+            }
+        }
+
+        $Times = Get-StartupTimes (Invoke-TracedLaunch "$Kind-$i")
+        If (-Not $Times.ContainsKey("Launch")) {
+            Write-Warning "$Kind launch $i didn't present a frame within $SettleSeconds seconds"
+        }
+        $Results += $Times
+    }
+    $Results
+}
+
+# Prints one line per phase and kind of launch, with the percentiles in milliseconds.
+Function Write-Percentiles([string]$Kind, [hashtable[]]$Results) {
+    $Phases = $Results | ForEach-Object { $_.Keys } | Sort-Object -Unique
+    ForEach ($Phase in $Phases) {
+        $Values = [double[]]($Results | Where-Object { $_.ContainsKey($Phase) } | ForEach-Object { $_[$Phase] })
+        [PSCustomObject]@{
+            Kind = $Kind
+            Phase = $Phase
+            Count = $Values.Count
+            P50 = [Math]::Round((Get-Percentile $Values 50), 1)
+            P90 = [Math]::Round((Get-Percentile $Values 90), 1)
+            P95 = [Math]::Round((Get-Percentile $Values 95), 1)
+            Max = [Math]::Round(($Values | Measure-Object -Maximum).Maximum, 1)
+        }
+    }
+}
+
+New-Item -ItemType Directory -Force $OutputDirectory | Out-Null
+
+$ColdResults = Measure-Launches "cold" $Cold
+
+# The first warm launch only brings everything back into memory.
+Get-StartupTimes (Invoke-TracedLaunch "warmup") | Out-Null
+$WarmResults = Measure-Launches "warm" $Warm
+
+@(
+    Write-Percentiles "cold" $ColdResults
+    Write-Percentiles "warm" $WarmResults
+) | Format-Table -AutoSize
+
+Write-Host "The traces are in $OutputDirectory."